@@ -40,7 +40,7 @@ namespace exotica
 /// StateVector X ∈ R^4 = [x, theta, x_dot, theta_dot]
 /// Refer to http://underactuated.mit.edu/acrobot.html#cart_pole
 ///     for a derivation of the cartpole dynamics.
-class CartpoleDynamicsSolver : public DynamicsSolver, public Instantiable<CartpoleDynamicsSolverInitializer>
+class CartpoleDynamicsSolver : public FixedSizeDynamicsSolver<CartpoleDynamicsSolver, 2, 1>, public Instantiable<CartpoleDynamicsSolverInitializer>
 {
 public:
     CartpoleDynamicsSolver();
@@ -49,25 +49,40 @@ public:
     /// \brief Computes the forward dynamics of the system.
     /// @param x The state vector.
     /// @param u The control input.
-    /// @return The dynamics transition function.
-    StateVector f(const StateVector& x, const ControlVector& u) override;
+    /// @param x_dot The dynamics transition function.
+    void f_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateVector& x_dot) const;
+
+    /// \brief Computes the forward dynamics for a batch of states (one per column) with row-wise array expressions,
+    /// in double or float.
+    template <typename Scalar>
+    void f_batch_fixed(const FixedStateBatchT<Scalar>& X, const FixedControlBatchT<Scalar>& U, FixedStateBatchT<Scalar>& X_dot) const;
 
     /// \brief Computes the dynamics derivative w.r.t .the state x.
     /// @param x The state vector.
     /// @param u The control input.
-    /// @return The derivative of the dynamics function w.r.t. x evaluated at (x, u).
-    Eigen::MatrixXd fx(const StateVector& x, const ControlVector& u) override;
+    /// @param fx The derivative of the dynamics function w.r.t. x evaluated at (x, u).
+    void fx_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateDerivative& fx) const;
     /// \brief Computes the dynamics derivative w.r.t .the control input u.
     /// @param x The state vector.
     /// @param u The control input
-    /// @return The derivative of the dynamics function w.r.t. u evaluated at (x, u).
-    Eigen::MatrixXd fu(const StateVector& x, const ControlVector& u) override;
+    /// @param fu The derivative of the dynamics function w.r.t. u evaluated at (x, u).
+    void fu_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedControlDerivative& fu) const;
 
     // NOTE: fuu is always zero, so we don't override it
     Eigen::Tensor<double, 3> fxx(const StateVector& x, const ControlVector& u) override;
     Eigen::Tensor<double, 3> fxu(const StateVector& x, const ControlVector& u) override;
 
+    // Only the accelerations depend non-linearly on theta, theta_dot and u, so the contractions only need lambda(2), lambda(3).
+    Eigen::MatrixXd ContractFxx(const StateVector& x, const ControlVector& u, const StateVector& lambda) override;
+    Eigen::MatrixXd ContractFuu(const StateVector& x, const ControlVector& u, const StateVector& lambda) override;
+    Eigen::MatrixXd ContractFxu(const StateVector& x, const ControlVector& u, const StateVector& lambda) override;
+
 private:
+    /// \brief Non-zero second order derivatives of the accelerations (x_ddot, theta_ddot) in the rows.
+    /// @param ddx Columns: d²/dtheta², d²/dtheta dtheta_dot, d²/dtheta_dot².
+    /// @param dxdu d²/dtheta du.
+    void AccelerationSecondOrderDerivatives(const StateVector& x, const ControlVector& u, Eigen::Matrix<double, 2, 3>& ddx, Eigen::Vector2d& dxdu) const;
+
     double g_ = 9.81;  ///!< Gravity (m/s^2)
     double m_c_ = 1;   ///!< Cart mass (kg)
     double m_p_ = 1;   ///!< Pole mass (kg)
@@ -35,9 +35,6 @@ namespace exotica
 {
 CartpoleDynamicsSolver::CartpoleDynamicsSolver()
 {
-    num_positions_ = 2;
-    num_velocities_ = 2;
-    num_controls_ = 1;
     has_second_order_derivatives_ = true;
 }
 
@@ -49,7 +46,7 @@ void CartpoleDynamicsSolver::AssignScene(ScenePtr scene_in)
         ThrowPretty("Robot model may not be a Cartpole.");
 }
 
-Eigen::VectorXd CartpoleDynamicsSolver::f(const StateVector& x, const ControlVector& u)
+void CartpoleDynamicsSolver::f_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateVector& x_dot) const
 {
     const double& theta = x(1);
     const double& xdot = x(2);
@@ -59,19 +56,37 @@ Eigen::VectorXd CartpoleDynamicsSolver::f(const StateVector& x, const ControlVec
     auto cos_theta = std::cos(theta);
     auto theta_dot_squared = thetadot * thetadot;
 
-    auto x_dot = StateVector(4);
     x_dot << xdot, thetadot,
         (u(0) + m_p_ * sin_theta * (l_ * theta_dot_squared + g_ * cos_theta)) /
             (m_c_ + m_p_ * sin_theta * sin_theta),
         -(l_ * m_p_ * cos_theta * sin_theta * theta_dot_squared + u(0) * cos_theta +
           (m_c_ + m_p_) * g_ * sin_theta) /
             (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta);
+}
 
-    return x_dot;
+template <typename Scalar>
+void CartpoleDynamicsSolver::f_batch_fixed(const FixedStateBatchT<Scalar>& X, const FixedControlBatchT<Scalar>& U, FixedStateBatchT<Scalar>& X_dot) const
+{
+    const Scalar g = static_cast<Scalar>(g_), m_c = static_cast<Scalar>(m_c_), m_p = static_cast<Scalar>(m_p_), l = static_cast<Scalar>(l_);
+    const FixedBatchRowT<Scalar> sin_theta = X.row(1).sin();
+    const FixedBatchRowT<Scalar> cos_theta = X.row(1).cos();
+    const FixedBatchRowT<Scalar> sin_theta_squared = sin_theta.square();
+    const FixedBatchRowT<Scalar> theta_dot_squared = X.row(3).square();
+
+    X_dot.row(0) = X.row(2);
+    X_dot.row(1) = X.row(3);
+    X_dot.row(2) = (U.row(0) + m_p * sin_theta * (l * theta_dot_squared + g * cos_theta)) /
+                   (m_c + m_p * sin_theta_squared);
+    X_dot.row(3) = -(l * m_p * cos_theta * sin_theta * theta_dot_squared + U.row(0) * cos_theta +
+                     (m_c + m_p) * g * sin_theta) /
+                   (l * m_c + l * m_p * sin_theta_squared);
 }
 
+template void CartpoleDynamicsSolver::f_batch_fixed<double>(const FixedStateBatchT<double>&, const FixedControlBatchT<double>&, FixedStateBatchT<double>&) const;
+template void CartpoleDynamicsSolver::f_batch_fixed<float>(const FixedStateBatchT<float>&, const FixedControlBatchT<float>&, FixedStateBatchT<float>&) const;
+
 // NOTE: tested in test/test_cartpole_diff.py in this package
-Eigen::MatrixXd CartpoleDynamicsSolver::fx(const StateVector& x, const ControlVector& u)
+void CartpoleDynamicsSolver::fx_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateDerivative& fx) const
 {
     const double& theta = x(1);
     const double& tdot = x(3);
@@ -79,7 +94,6 @@ Eigen::MatrixXd CartpoleDynamicsSolver::fx(const StateVector& x, const ControlVe
     auto sin_theta = std::sin(theta);
     auto cos_theta = std::cos(theta);
 
-    Eigen::Matrix4d fx;
     fx << 0, 0, 1, 0,
         0, 0, 0, 1,
         //
@@ -92,29 +106,21 @@ Eigen::MatrixXd CartpoleDynamicsSolver::fx(const StateVector& x, const ControlVe
         -2 * l_ * m_p_ * (-g_ * (m_c_ + m_p_) * sin_theta - l_ * m_p_ * tdot * tdot * sin_theta * cos_theta - u(0) * cos_theta) * sin_theta * cos_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 2) + (-g_ * (m_c_ + m_p_) * cos_theta + l_ * m_p_ * tdot * tdot * sin_theta * sin_theta - l_ * m_p_ * tdot * tdot * cos_theta * cos_theta + u(0) * sin_theta) / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta),
         0,
         -2 * l_ * m_p_ * tdot * sin_theta * cos_theta / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta);
-
-    return fx;
 }
 
 // NOTE: tested in test/test_cartpole_diff.py in this package
-Eigen::MatrixXd CartpoleDynamicsSolver::fu(const StateVector& x, const ControlVector& u)
+void CartpoleDynamicsSolver::fu_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedControlDerivative& fu) const
 {
     const double& theta = x(1);
 
     auto sin_theta = std::sin(theta);
     auto cos_theta = std::cos(theta);
 
-    Eigen::Vector4d fu;
     fu << 0, 0, 1 / (m_c_ + m_p_ * sin_theta * sin_theta), -cos_theta / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta);
-    return fu;
 }
 
 // NOTE: Code to generate 2nd order dynamics is in scripts/gen_second_order_dynamics.py
-// fxx -> NX x NX x NX
-//  middle dimension is always NX
-// NX = 4
-// NU = 1
-Eigen::Tensor<double, 3> CartpoleDynamicsSolver::fxx(const StateVector& x, const ControlVector& u)
+void CartpoleDynamicsSolver::AccelerationSecondOrderDerivatives(const StateVector& x, const ControlVector& u, Eigen::Matrix<double, 2, 3>& ddx, Eigen::Vector2d& dxdu) const
 {
     const double& theta = x(1);
     const double& tdot = x(3);
@@ -122,54 +128,89 @@ Eigen::Tensor<double, 3> CartpoleDynamicsSolver::fxx(const StateVector& x, const
     auto sin_theta = std::sin(theta);
     auto cos_theta = std::cos(theta);
 
-    Eigen::Tensor<double, 3> fxx(num_positions_ + num_velocities_, num_positions_ + num_velocities_, num_positions_ + num_velocities_);
-    fxx.setValues({{{0, 0, 0, 0},
-                    {0, 0, 0, 0},
-                    {0, 0, 0, 0},
-                    {0, 0, 0, 0}},
-                   {{0, 0, 0, 0},
-                    {0, 0, 0, 0},
-                    {0,
-                     8 * m_p_ * m_p_ * (m_p_ * (g_ * cos_theta + l_ * tdot * tdot) * sin_theta + u(0)) * sin_theta * sin_theta * cos_theta * cos_theta /
-                             std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 3) -
-                         4 * m_p_ * (-g_ * m_p_ * sin_theta * sin_theta + m_p_ * (g_ * cos_theta + l_ * tdot * tdot) * cos_theta) * sin_theta * cos_theta / std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 2) +
-                         2 * m_p_ * (m_p_ * (g_ * cos_theta + l_ * tdot * tdot) * sin_theta + u(0)) * sin_theta * sin_theta / std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 2) - 2 * m_p_ * (m_p_ * (g_ * cos_theta + l_ * tdot * tdot) * sin_theta + u(0)) * cos_theta * cos_theta / std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 2) + (-3 * g_ * m_p_ * sin_theta * cos_theta - m_p_ * (g_ * cos_theta + l_ * tdot * tdot) * sin_theta) / (m_c_ + m_p_ * sin_theta * sin_theta),
-                     0,
-                     -4 * l_ * m_p_ * m_p_ * tdot * sin_theta * sin_theta * cos_theta / std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 2) + 2 * l_ * m_p_ * tdot * cos_theta / (m_c_ + m_p_ * sin_theta * sin_theta)},
-                    {0,
-                     8 * l_ * l_ * m_p_ * m_p_ * (-g_ * (m_c_ + m_p_) * sin_theta - l_ * m_p_ * tdot * tdot * sin_theta * cos_theta - u(0) * cos_theta) * sin_theta * sin_theta * cos_theta * cos_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 3) + 2 * l_ * m_p_ * (-g_ * (m_c_ + m_p_) * sin_theta - l_ * m_p_ * tdot * tdot * sin_theta * cos_theta - u(0) * cos_theta) * sin_theta * sin_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 2) - 2 * l_ * m_p_ * (-g_ * (m_c_ + m_p_) * sin_theta - l_ * m_p_ * tdot * tdot * sin_theta * cos_theta - u(0) * cos_theta) * cos_theta * cos_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 2) - 4 * l_ * m_p_ * (-g_ * (m_c_ + m_p_) * cos_theta + l_ * m_p_ * tdot * tdot * sin_theta * sin_theta - l_ * m_p_ * tdot * tdot * cos_theta * cos_theta + u(0) * sin_theta) * sin_theta * cos_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 2) + (g_ * (m_c_ + m_p_) * sin_theta + 4 * l_ * m_p_ * tdot * tdot * sin_theta * cos_theta + u(0) * cos_theta) / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta),
-                     0,
-                     4 * l_ * l_ * m_p_ * m_p_ * tdot * sin_theta * sin_theta * cos_theta * cos_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 2) + 2 * l_ * m_p_ * tdot * sin_theta * sin_theta / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta) - 2 * l_ * m_p_ * tdot * cos_theta * cos_theta / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta)}},
-                   {{0, 0, 0, 0},
-                    {0, 0, 0, 0},
-                    {0, 0, 0, 0},
-                    {0, 0, 0, 0}},
-                   {{0, 0, 0, 0},
-                    {0, 0, 0, 0},
-                    {0,
-                     -4 * l_ * m_p_ * m_p_ * tdot * sin_theta * sin_theta * cos_theta / std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 2) + 2 * l_ * m_p_ * tdot * cos_theta / (m_c_ + m_p_ * sin_theta * sin_theta),
-                     0, 2 * l_ * m_p_ * sin_theta / (m_c_ + m_p_ * sin_theta * sin_theta)},
-                    {0,
-                     4 * l_ * l_ * m_p_ * m_p_ * tdot * sin_theta * sin_theta * cos_theta * cos_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 2) +
-                         (2 * l_ * m_p_ * tdot * sin_theta * sin_theta - 2 * l_ * m_p_ * tdot * cos_theta * cos_theta) / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta),
-                     0, -2 * l_ * m_p_ * sin_theta * cos_theta / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta)}}});
+    // x_ddot
+    ddx(0, 0) = 8 * m_p_ * m_p_ * (m_p_ * (g_ * cos_theta + l_ * tdot * tdot) * sin_theta + u(0)) * sin_theta * sin_theta * cos_theta * cos_theta /
+                    std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 3) -
+                4 * m_p_ * (-g_ * m_p_ * sin_theta * sin_theta + m_p_ * (g_ * cos_theta + l_ * tdot * tdot) * cos_theta) * sin_theta * cos_theta / std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 2) +
+                2 * m_p_ * (m_p_ * (g_ * cos_theta + l_ * tdot * tdot) * sin_theta + u(0)) * sin_theta * sin_theta / std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 2) - 2 * m_p_ * (m_p_ * (g_ * cos_theta + l_ * tdot * tdot) * sin_theta + u(0)) * cos_theta * cos_theta / std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 2) + (-3 * g_ * m_p_ * sin_theta * cos_theta - m_p_ * (g_ * cos_theta + l_ * tdot * tdot) * sin_theta) / (m_c_ + m_p_ * sin_theta * sin_theta);
+    ddx(0, 1) = -4 * l_ * m_p_ * m_p_ * tdot * sin_theta * sin_theta * cos_theta / std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 2) + 2 * l_ * m_p_ * tdot * cos_theta / (m_c_ + m_p_ * sin_theta * sin_theta);
+    ddx(0, 2) = 2 * l_ * m_p_ * sin_theta / (m_c_ + m_p_ * sin_theta * sin_theta);
+    dxdu(0) = -2 * m_p_ * sin_theta * cos_theta / std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 2);
+
+    // theta_ddot
+    ddx(1, 0) = 8 * l_ * l_ * m_p_ * m_p_ * (-g_ * (m_c_ + m_p_) * sin_theta - l_ * m_p_ * tdot * tdot * sin_theta * cos_theta - u(0) * cos_theta) * sin_theta * sin_theta * cos_theta * cos_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 3) + 2 * l_ * m_p_ * (-g_ * (m_c_ + m_p_) * sin_theta - l_ * m_p_ * tdot * tdot * sin_theta * cos_theta - u(0) * cos_theta) * sin_theta * sin_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 2) - 2 * l_ * m_p_ * (-g_ * (m_c_ + m_p_) * sin_theta - l_ * m_p_ * tdot * tdot * sin_theta * cos_theta - u(0) * cos_theta) * cos_theta * cos_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 2) - 4 * l_ * m_p_ * (-g_ * (m_c_ + m_p_) * cos_theta + l_ * m_p_ * tdot * tdot * sin_theta * sin_theta - l_ * m_p_ * tdot * tdot * cos_theta * cos_theta + u(0) * sin_theta) * sin_theta * cos_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 2) + (g_ * (m_c_ + m_p_) * sin_theta + 4 * l_ * m_p_ * tdot * tdot * sin_theta * cos_theta + u(0) * cos_theta) / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta);
+    ddx(1, 1) = 4 * l_ * l_ * m_p_ * m_p_ * tdot * sin_theta * sin_theta * cos_theta * cos_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 2) + 2 * l_ * m_p_ * tdot * sin_theta * sin_theta / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta) - 2 * l_ * m_p_ * tdot * cos_theta * cos_theta / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta);
+    ddx(1, 2) = -2 * l_ * m_p_ * sin_theta * cos_theta / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta);
+    dxdu(1) = 2 * l_ * m_p_ * sin_theta * cos_theta * cos_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 2) + sin_theta / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta);
+}
+
+// fxx -> NX x NX x NX
+//  middle dimension is always NX
+// NX = 4
+// NU = 1
+Eigen::Tensor<double, 3> CartpoleDynamicsSolver::fxx(const StateVector& x, const ControlVector& u)
+{
+    Eigen::Matrix<double, 2, 3> ddx;
+    Eigen::Vector2d dxdu;
+    AccelerationSecondOrderDerivatives(x, u, ddx, dxdu);
+
+    const int ndx = num_positions_ + num_velocities_;
+    Eigen::Tensor<double, 3> fxx(ndx, ndx, ndx);
+    fxx.setZero();
+    for (int i = 0; i < 2; ++i)
+    {
+        fxx(1, 2 + i, 1) = ddx(i, 0);
+        fxx(1, 2 + i, 3) = ddx(i, 1);
+        fxx(3, 2 + i, 1) = ddx(i, 1);
+        fxx(3, 2 + i, 3) = ddx(i, 2);
+    }
     return fxx;
 }
 
+// fxu -> NU x NX x NX
 Eigen::Tensor<double, 3> CartpoleDynamicsSolver::fxu(const StateVector& x, const ControlVector& u)
 {
-    const double& theta = x(1);
+    Eigen::Matrix<double, 2, 3> ddx;
+    Eigen::Vector2d dxdu;
+    AccelerationSecondOrderDerivatives(x, u, ddx, dxdu);
+
+    const int ndx = num_positions_ + num_velocities_;
+    Eigen::Tensor<double, 3> fxu(num_controls_, ndx, ndx);
+    fxu.setZero();
+    fxu(0, 2, 1) = dxdu(0);
+    fxu(0, 3, 1) = dxdu(1);
+    return fxu;
+}
 
-    auto sin_theta = std::sin(theta);
-    auto cos_theta = std::cos(theta);
+Eigen::MatrixXd CartpoleDynamicsSolver::ContractFxx(const StateVector& x, const ControlVector& u, const StateVector& lambda)
+{
+    Eigen::Matrix<double, 2, 3> ddx;
+    Eigen::Vector2d dxdu;
+    AccelerationSecondOrderDerivatives(x, u, ddx, dxdu);
+
+    const Eigen::Vector3d lambda_ddx = ddx.transpose() * lambda.tail<2>();
+    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(4, 4);
+    result(1, 1) = lambda_ddx(0);
+    result(1, 3) = lambda_ddx(1);
+    result(3, 1) = lambda_ddx(1);
+    result(3, 3) = lambda_ddx(2);
+    return result;
+}
 
-    Eigen::Tensor<double, 3> fxu(num_positions_ + num_velocities_, num_positions_ + num_velocities_, num_controls_);
-    fxu.setValues({{{0, 0, 0, 0},
-                    {0, 0, 0, 0},
-                    {0, -2 * m_p_ * sin_theta * cos_theta / std::pow(m_c_ + m_p_ * sin_theta * sin_theta, 2), 0, 0},
-                    {0, 2 * l_ * m_p_ * sin_theta * cos_theta * cos_theta / std::pow(l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta, 2) + sin_theta / (l_ * m_c_ + l_ * m_p_ * sin_theta * sin_theta),
-                     0, 0}}});
-    return fxu;
+Eigen::MatrixXd CartpoleDynamicsSolver::ContractFuu(const StateVector& x, const ControlVector& u, const StateVector& lambda)
+{
+    return Eigen::MatrixXd::Zero(1, 1);
+}
+
+Eigen::MatrixXd CartpoleDynamicsSolver::ContractFxu(const StateVector& x, const ControlVector& u, const StateVector& lambda)
+{
+    Eigen::Matrix<double, 2, 3> ddx;
+    Eigen::Vector2d dxdu;
+    AccelerationSecondOrderDerivatives(x, u, ddx, dxdu);
+
+    Eigen::MatrixXd result = Eigen::MatrixXd::Zero(1, 4);
+    result(0, 1) = dxdu.dot(lambda.tail<2>());
+    return result;
 }
 
 }  // namespace exotica
\ No newline at end of file
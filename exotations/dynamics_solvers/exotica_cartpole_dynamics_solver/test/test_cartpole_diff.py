@@ -88,6 +88,29 @@ class TestCartpoleDiff(unittest.TestCase):
             fu_solver = self.dynamics_solver.fu(x, u)
             nptest.assert_allclose(fu_fd, fu_solver, err_msg="Derivative w.r.t. controls test failed")
 
+    def test_second_order_contractions_finite_differences(self):
+        np.random.seed(42)
+        eps = 1e-6
+
+        for _ in range(20):
+            x = np.random.uniform(size=(1, 4))[0]
+            u = np.array([np.random.uniform()])
+            lam = np.random.uniform(size=(4,))
+
+            # sum_i lambda_i * d2f_i/dx_k dx_j = d/dx_k (lambda^T fx)_j
+            fxx_fd = np.zeros((4, 4))
+            for k in range(4):
+                x_low, x_high = np.copy(x), np.copy(x)
+                x_low[k] -= eps/2
+                x_high[k] += eps/2
+                fxx_fd[k,:] = lam.dot(self.dynamics_solver.fx(x_high, u) - self.dynamics_solver.fx(x_low, u)) / eps
+            nptest.assert_allclose(self.dynamics_solver.contract_fxx(x, u, lam), fxx_fd, rtol=1e-4, atol=1e-5)
+
+            u_low, u_high = u - eps/2, u + eps/2
+            fxu_fd = lam.dot(self.dynamics_solver.fx(x, u_high) - self.dynamics_solver.fx(x, u_low)) / eps
+            nptest.assert_allclose(self.dynamics_solver.contract_fxu(x, u, lam), fxu_fd.reshape(1, 4), rtol=1e-4, atol=1e-5)
+            nptest.assert_allclose(self.dynamics_solver.contract_fuu(x, u, lam), np.zeros((1, 1)))
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -43,6 +43,7 @@ public:
     void AssignScene(ScenePtr scene_in) override;
 
     StateVector f(const StateVector& x, const ControlVector& u) override;
+    void f_batch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, Eigen::MatrixXdRef Xdot) override;
     void ComputeDerivatives(const StateVector& x, const ControlVector& u) override;
     StateDerivative fx(const StateVector& x, const ControlVector& u) override;
     ControlDerivative fu(const StateVector& x, const ControlVector& u) override;
@@ -61,6 +61,13 @@ Eigen::VectorXd DoubleIntegratorDynamicsSolver::f(const StateVector& x, const Co
     return A_ * x + B_ * u;
 }
 
+void DoubleIntegratorDynamicsSolver::f_batch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, Eigen::MatrixXdRef Xdot)
+{
+    if (X.rows() != A_.cols() || U.rows() != B_.cols() || X.cols() != U.cols()) ThrowPretty("Wrong size of states or controls: " << X.rows() << "x" << X.cols() << " and " << U.rows() << "x" << U.cols());
+    Xdot.noalias() = A_ * X;
+    Xdot.noalias() += B_ * U;
+}
+
 void DoubleIntegratorDynamicsSolver::ComputeDerivatives(const StateVector& x, const ControlVector& u)
 {
     // If the integrator changed, set up state transition derivatives again:
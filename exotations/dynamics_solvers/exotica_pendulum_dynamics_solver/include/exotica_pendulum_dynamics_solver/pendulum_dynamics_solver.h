@@ -39,28 +39,32 @@ namespace exotica
 {
 /// Refer to http://underactuated.mit.edu/underactuated.html?chapter=pend
 ///     for a derivation of the pendulum dynamics.
-class PendulumDynamicsSolver : public DynamicsSolver, public Instantiable<PendulumDynamicsSolverInitializer>
+class PendulumDynamicsSolver : public FixedSizeDynamicsSolver<PendulumDynamicsSolver, 1, 1>, public Instantiable<PendulumDynamicsSolverInitializer>
 {
 public:
-    PendulumDynamicsSolver();
     void AssignScene(ScenePtr scene_in) override;
 
     /// \brief Computes the forward dynamics of the system.
     /// @param x The state vector.
     /// @param u The control input.
-    /// @return The dynamics transition function.
-    StateVector f(const StateVector& x, const ControlVector& u) override;
+    /// @param x_dot The dynamics transition function.
+    void f_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateVector& x_dot) const;
+
+    /// \brief Computes the forward dynamics for a batch of states (one per column) with row-wise array expressions,
+    /// in double or float.
+    template <typename Scalar>
+    void f_batch_fixed(const FixedStateBatchT<Scalar>& X, const FixedControlBatchT<Scalar>& U, FixedStateBatchT<Scalar>& X_dot) const;
 
     /// \brief Computes the dynamics derivative w.r.t .the state x.
     /// @param x The state vector.
     /// @param u The control input.
-    /// @return The derivative of the dynamics function w.r.t. x evaluated at (x, u).
-    Eigen::MatrixXd fx(const StateVector& x, const ControlVector& u) override;
+    /// @param fx The derivative of the dynamics function w.r.t. x evaluated at (x, u).
+    void fx_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateDerivative& fx) const;
     /// \brief Computes the dynamics derivative w.r.t .the control input u.
     /// @param x The state vector.
     /// @param u The control input
-    /// @return The derivative of the dynamics function w.r.t. u evaluated at (x, u).
-    Eigen::MatrixXd fu(const StateVector& x, const ControlVector& u) override;
+    /// @param fu The derivative of the dynamics function w.r.t. u evaluated at (x, u).
+    void fu_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedControlDerivative& fu) const;
 
 private:
     double g_ = 9.81;  ///!< Gravity (m/s^2)
@@ -33,13 +33,6 @@ REGISTER_DYNAMICS_SOLVER_TYPE("PendulumDynamicsSolver", exotica::PendulumDynamic
 
 namespace exotica
 {
-PendulumDynamicsSolver::PendulumDynamicsSolver()
-{
-    num_positions_ = 1;
-    num_velocities_ = 1;
-    num_controls_ = 1;
-}
-
 void PendulumDynamicsSolver::AssignScene(ScenePtr scene_in)
 {
     const int num_positions_in = scene_in->GetKinematicTree().GetNumControlledJoints();
@@ -54,35 +47,38 @@ void PendulumDynamicsSolver::AssignScene(ScenePtr scene_in)
     b_ = parameters_.FrictionCoefficient;
 }
 
-Eigen::VectorXd PendulumDynamicsSolver::f(const StateVector& x, const ControlVector& u)
+void PendulumDynamicsSolver::f_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateVector& x_dot) const
 {
     auto theta = x(0);
     auto thetadot = x(1);
 
-    auto x_dot = StateVector(2);
     x_dot << thetadot,
         (u(0) - m_ * g_ * l_ * std::sin(theta) - b_ * thetadot) / (m_ * l_ * l_);
+}
 
-    return x_dot;
+template <typename Scalar>
+void PendulumDynamicsSolver::f_batch_fixed(const FixedStateBatchT<Scalar>& X, const FixedControlBatchT<Scalar>& U, FixedStateBatchT<Scalar>& X_dot) const
+{
+    const Scalar m = static_cast<Scalar>(m_), g = static_cast<Scalar>(g_), l = static_cast<Scalar>(l_), b = static_cast<Scalar>(b_);
+    X_dot.row(0) = X.row(1);
+    X_dot.row(1) = (U.row(0) - m * g * l * X.row(0).sin() - b * X.row(1)) / (m * l * l);
 }
 
+template void PendulumDynamicsSolver::f_batch_fixed<double>(const FixedStateBatchT<double>&, const FixedControlBatchT<double>&, FixedStateBatchT<double>&) const;
+template void PendulumDynamicsSolver::f_batch_fixed<float>(const FixedStateBatchT<float>&, const FixedControlBatchT<float>&, FixedStateBatchT<float>&) const;
+
 // NOTE: tested in test/test_pendulum_diff.py in this package
-Eigen::MatrixXd PendulumDynamicsSolver::fx(const StateVector& x, const ControlVector& u)
+void PendulumDynamicsSolver::fx_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateDerivative& fx) const
 {
     auto theta = x(0);
 
-    Eigen::Matrix2d fx;
     fx << 0, 1,
         -g_ * std::cos(theta) / l_, -b_ / (l_ * l_ * m_);
-
-    return fx;
 }
 
 // NOTE: tested in test/test_pendulum_diff.py in this package
-Eigen::MatrixXd PendulumDynamicsSolver::fu(const StateVector& x, const ControlVector& u)
+void PendulumDynamicsSolver::fu_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedControlDerivative& fu) const
 {
-    Eigen::Vector2d fu;
     fu << 0, 1.0 / (l_ * l_ * m_);
-    return fu;
 }
 }  // namespace exotica
@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2020, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_PINOCCHIO_DYNAMICS_SOLVER_EVALUATION_POINT_H_
+#define EXOTICA_PINOCCHIO_DYNAMICS_SOLVER_EVALUATION_POINT_H_
+
+#include <exotica_core/dynamics_solver.h>
+
+namespace exotica
+{
+///
+/// \brief Remembers the arguments of the last evaluation of a dynamics quantity, so that repeated calls at the same
+/// point (e.g. f, fx and fu at (x, u), or f after ComputeDerivatives) are served from the stored results instead of
+/// running the Pinocchio algorithms again.
+///
+class PinocchioEvaluationPoint
+{
+public:
+    /// \brief Whether the results were evaluated at (x, u) with the given integrator and time step.
+    bool Matches(const Eigen::VectorXd& x, const Eigen::VectorXd& u, Integrator integrator, double dt) const
+    {
+        return Matches(x, u) && integrator == integrator_ && dt == dt_;
+    }
+
+    /// \brief Whether the results were evaluated at (x, u), regardless of the integration scheme.
+    bool Matches(const Eigen::VectorXd& x, const Eigen::VectorXd& u) const
+    {
+        return valid_ && x.size() == x_.size() && u.size() == u_.size() && x == x_ && u == u_;
+    }
+
+    void Set(const Eigen::VectorXd& x, const Eigen::VectorXd& u, Integrator integrator = Integrator::RK1, double dt = 0.0)
+    {
+        x_ = x;
+        u_ = u;
+        integrator_ = integrator;
+        dt_ = dt;
+        valid_ = true;
+    }
+
+    void Invalidate() { valid_ = false; }
+
+private:
+    Eigen::VectorXd x_;
+    Eigen::VectorXd u_;
+    Integrator integrator_ = Integrator::RK1;
+    double dt_ = 0.0;
+    bool valid_ = false;
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_PINOCCHIO_DYNAMICS_SOLVER_EVALUATION_POINT_H_
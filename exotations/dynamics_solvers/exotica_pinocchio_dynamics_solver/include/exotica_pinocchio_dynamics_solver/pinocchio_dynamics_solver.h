@@ -35,6 +35,11 @@
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
 
+/// The CppAD scalar types have to be declared before any other Pinocchio header.
+#ifdef PINOCCHIO_WITH_CPPADCG_SUPPORT
+#include <pinocchio/codegen/cppadcg.hpp>
+#endif
+
 /// fwd.hpp needs to be included first (before Boost, which comes with ROS),
 /// else everything breaks for Pinocchio >=2.1.5
 #include <pinocchio/fwd.hpp>
@@ -42,11 +47,16 @@
 #include <exotica_core/dynamics_solver.h>
 #include <exotica_core/scene.h>
 
+#include <exotica_pinocchio_dynamics_solver/evaluation_point.h>
 #include <exotica_pinocchio_dynamics_solver/pinocchio_dynamics_solver_initializer.h>
 
 #include <pinocchio/multibody/data.hpp>
 #include <pinocchio/multibody/model.hpp>
 
+#ifdef PINOCCHIO_WITH_CPPADCG_SUPPORT
+#include <pinocchio/codegen/code-generator-algo.hpp>
+#endif
+
 #pragma GCC diagnostic pop
 
 namespace exotica
@@ -57,6 +67,8 @@ public:
     void AssignScene(ScenePtr scene_in) override;
 
     StateVector f(const StateVector& x, const ControlVector& u) override;
+    /// \brief Evaluates the forward dynamics of the columns in parallel, each thread using its own pinocchio::Data.
+    void f_batch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, Eigen::MatrixXdRef Xdot) override;
     StateDerivative fx(const StateVector& x, const ControlVector& u) override;
     ControlDerivative fu(const StateVector& x, const ControlVector& u) override;
     void ComputeDerivatives(const StateVector& x, const ControlVector& u) override;
@@ -68,8 +80,22 @@ public:
 private:
     pinocchio::Model model_;
     std::unique_ptr<pinocchio::Data> pinocchio_data_;
+    std::vector<std::unique_ptr<pinocchio::Data>> batch_data_;  ///< One pinocchio::Data per thread of f_batch
 
     Eigen::VectorXd xdot_analytic_;
+    Eigen::VectorXd u_inverse_dynamics_;
+
+    // Points of the last evaluations: f and the derivatives at the same (x, u) share one ABA pass.
+    PinocchioEvaluationPoint f_point_;
+    PinocchioEvaluationPoint derivatives_point_;
+    PinocchioEvaluationPoint inverse_dynamics_point_;
+
+    /// \brief Loads the generated ABA derivatives for the model from the cache, generating and compiling them if needed.
+    void LoadCodeGeneratedDerivatives();
+
+#ifdef PINOCCHIO_WITH_CPPADCG_SUPPORT
+    std::unique_ptr<pinocchio::CodeGenABADerivatives<double>> aba_derivatives_codegen_;
+#endif
 };
 }  // namespace exotica
 
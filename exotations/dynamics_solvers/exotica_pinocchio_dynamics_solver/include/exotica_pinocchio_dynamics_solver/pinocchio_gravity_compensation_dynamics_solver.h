@@ -42,6 +42,7 @@
 #include <exotica_core/dynamics_solver.h>
 #include <exotica_core/scene.h>
 
+#include <exotica_pinocchio_dynamics_solver/evaluation_point.h>
 #include <exotica_pinocchio_dynamics_solver/pinocchio_gravity_compensation_dynamics_solver_initializer.h>
 
 #include <pinocchio/multibody/data.hpp>
@@ -74,6 +75,14 @@ private:
     Eigen::VectorXd a_;
     Eigen::MatrixXd du_command_dq_;
     Eigen::MatrixXd du_nle_dq_;
+
+    // Points of the last evaluations: f and the derivatives at the same (x, u) share one pass, u_nle_ depends on x only.
+    PinocchioEvaluationPoint f_point_;
+    PinocchioEvaluationPoint derivatives_point_;
+    PinocchioEvaluationPoint nle_point_;
+
+    /// \brief Updates u_nle_ for the state x unless it was computed for x already.
+    void UpdateNonLinearEffects(const StateVector& x);
 };
 }  // namespace exotica
 
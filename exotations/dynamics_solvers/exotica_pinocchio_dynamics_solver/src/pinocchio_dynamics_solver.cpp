@@ -27,6 +27,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <exotica_core/tools/parallel_loop.h>
 #include <exotica_pinocchio_dynamics_solver/pinocchio_dynamics_solver.h>
 
 #include <pinocchio/algorithm/aba.hpp>
@@ -38,13 +39,34 @@ namespace exotica
 {
 Eigen::VectorXd PinocchioDynamicsSolver::f(const StateVector& x, const ControlVector& u)
 {
+    // The accelerations are also computed by ComputeDerivatives, reuse them if evaluated at (x, u) already.
+    if (f_point_.Matches(x, u)) return xdot_analytic_;
+
     // TODO: THIS DOES NOT WORK FOR A FLOATING BASE YET!!
     pinocchio::aba(model_, *pinocchio_data_.get(), x.head(num_positions_), x.tail(num_velocities_), u);
     xdot_analytic_.head(num_velocities_) = x.tail(num_velocities_);
     xdot_analytic_.tail(num_velocities_) = pinocchio_data_->ddq;
+    f_point_.Set(x, u);
     return xdot_analytic_;
 }
 
+void PinocchioDynamicsSolver::f_batch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, Eigen::MatrixXdRef Xdot)
+{
+    const int num_samples = static_cast<int>(X.cols());
+    if (X.rows() != num_positions_ + num_velocities_ || U.rows() != num_controls_ || U.cols() != num_samples) ThrowPretty("Wrong size of states or controls: " << X.rows() << "x" << X.cols() << " and " << U.rows() << "x" << U.cols());
+    if (Xdot.rows() != 2 * num_velocities_ || Xdot.cols() != num_samples) ThrowPretty("Wrong size of Xdot: " << Xdot.rows() << "x" << Xdot.cols() << ", expected " << 2 * num_velocities_ << "x" << num_samples);
+
+    const int num_threads = derivatives_num_threads_;
+    while (static_cast<int>(batch_data_.size()) < num_threads) batch_data_.emplace_back(new pinocchio::Data(model_));
+
+    ParallelLoop(num_threads, num_samples, [&](int thread, int k) {
+        pinocchio::Data& data = *batch_data_[thread];
+        pinocchio::aba(model_, data, X.col(k).head(num_positions_), X.col(k).tail(num_velocities_), U.col(k));
+        Xdot.col(k).head(num_velocities_) = X.col(k).tail(num_velocities_);
+        Xdot.col(k).tail(num_velocities_) = data.ddq;
+    });
+}
+
 Eigen::VectorXd PinocchioDynamicsSolver::StateDelta(const StateVector& x_1, const StateVector& x_2)
 {
     if (x_1.size() != num_positions_ + num_velocities_ || x_2.size() != num_positions_ + num_velocities_)
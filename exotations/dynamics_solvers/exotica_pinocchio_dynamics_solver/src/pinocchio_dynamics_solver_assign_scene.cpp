@@ -58,6 +58,10 @@ void PinocchioDynamicsSolver::AssignScene(ScenePtr scene_in)
     num_controls_ = model_.nv;
 
     pinocchio_data_.reset(new pinocchio::Data(model_));
+    batch_data_.clear();
+    f_point_.Invalidate();
+    derivatives_point_.Invalidate();
+    inverse_dynamics_point_.Invalidate();
 
     // Pre-allocate data for f, fx, fu
     const int ndx = get_num_state_derivative();
@@ -67,5 +71,7 @@ void PinocchioDynamicsSolver::AssignScene(ScenePtr scene_in)
     fu_.setZero(ndx, num_controls_);
     Fx_.setZero(ndx, ndx);
     Fu_.setZero(ndx, num_controls_);
+
+    if (parameters_.UseCodeGeneration) LoadCodeGeneratedDerivatives();
 }
 }  // namespace exotica
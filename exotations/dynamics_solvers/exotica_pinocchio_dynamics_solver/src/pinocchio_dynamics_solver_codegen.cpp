@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2019, Wolfgang Merkt
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_pinocchio_dynamics_solver/pinocchio_dynamics_solver.h>
+
+#include <pinocchio/config.hpp>
+
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace exotica
+{
+namespace
+{
+// FNV-1a, stable across runs and platforms so that it can be used as the key of the on-disk cache.
+class ModelHash
+{
+public:
+    void Add(const void* data, std::size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash_ ^= bytes[i];
+            hash_ *= 1099511628211ull;
+        }
+    }
+
+    void Add(const std::string& value) { Add(value.data(), value.size() + 1); }
+
+    template <typename Derived>
+    void Add(const Eigen::MatrixBase<Derived>& value)
+    {
+        const Eigen::Matrix<double, Derived::RowsAtCompileTime, Derived::ColsAtCompileTime> evaluated = value;
+        Add(evaluated.data(), sizeof(double) * evaluated.size());
+    }
+
+    std::string ToString() const
+    {
+        std::ostringstream ss;
+        ss << std::hex << std::setw(16) << std::setfill('0') << hash_;
+        return ss.str();
+    }
+
+private:
+    uint64_t hash_ = 14695981039346656037ull;
+};
+
+/// \brief Hash of everything the generated dynamics depend on: the joint types, placements, inertias and gravity.
+std::string HashModel(const pinocchio::Model& model)
+{
+    ModelHash hash;
+    hash.Add(std::to_string(model.nq) + "/" + std::to_string(model.nv) + "/" + PINOCCHIO_VERSION);
+    for (pinocchio::JointIndex i = 1; i < static_cast<pinocchio::JointIndex>(model.njoints); ++i)
+    {
+        hash.Add(model.joints[i].shortname());
+        hash.Add(std::to_string(model.parents[i]));
+        hash.Add(model.jointPlacements[i].toHomogeneousMatrix());
+        const double mass = model.inertias[i].mass();
+        hash.Add(&mass, sizeof(mass));
+        hash.Add(model.inertias[i].lever());
+        hash.Add(model.inertias[i].inertia().matrix());
+    }
+    hash.Add(model.gravity.toVector());
+    return hash.ToString();
+}
+}  // namespace
+
+void PinocchioDynamicsSolver::LoadCodeGeneratedDerivatives()
+{
+#ifdef PINOCCHIO_WITH_CPPADCG_SUPPORT
+    const std::string directory = ParsePath(parameters_.CodeGenerationCacheDirectory);
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) ThrowPretty("Can't create the code generation cache directory '" << directory << "': " << std::strerror(errno));
+
+    const std::string library_name = directory + "/aba_derivatives_" + HashModel(model_);
+    aba_derivatives_codegen_.reset(new pinocchio::CodeGenABADerivatives<double>(model_, "aba_derivatives", library_name));
+    if (!aba_derivatives_codegen_->existLib())
+    {
+        if (debug_) HIGHLIGHT_NAMED(object_name_, "Generating the ABA derivatives in " << library_name);
+        aba_derivatives_codegen_->initLib();
+        aba_derivatives_codegen_->compileLib();
+    }
+    aba_derivatives_codegen_->loadLib(false);
+    if (debug_) HIGHLIGHT_NAMED(object_name_, "Loaded the generated ABA derivatives from " << library_name);
+#else
+    WARNING_NAMED(object_name_, "Pinocchio has been built without CppADCodeGen support, the derivatives are computed with computeABADerivatives.");
+#endif
+}
+}  // namespace exotica
@@ -30,13 +30,36 @@
 #include <exotica_pinocchio_dynamics_solver/pinocchio_dynamics_solver.h>
 
 #include <pinocchio/algorithm/aba-derivatives.hpp>
+#include <pinocchio/algorithm/aba.hpp>
 #include <pinocchio/algorithm/joint-configuration.hpp>
 
 namespace exotica
 {
 void PinocchioDynamicsSolver::ComputeDerivatives(const StateVector& x, const ControlVector& u)
 {
-    pinocchio::computeABADerivatives(model_, *pinocchio_data_.get(), x.head(num_positions_), x.tail(num_velocities_), u, fx_.block(num_velocities_, 0, num_velocities_, num_velocities_), fx_.block(num_velocities_, num_velocities_, num_velocities_, num_velocities_), fu_.bottomRightCorner(num_velocities_, num_velocities_));
+    // fx, fu and ComputeAll evaluate the derivatives at the same point one after another.
+    if (derivatives_point_.Matches(x, u, integrator_, dt_)) return;
+
+#ifdef PINOCCHIO_WITH_CPPADCG_SUPPORT
+    if (aba_derivatives_codegen_)
+    {
+        aba_derivatives_codegen_->evalFunction(x.head(num_positions_), x.tail(num_velocities_), u);
+        fx_.block(num_velocities_, 0, num_velocities_, num_velocities_) = aba_derivatives_codegen_->dddq_dq;
+        fx_.block(num_velocities_, num_velocities_, num_velocities_, num_velocities_) = aba_derivatives_codegen_->dddq_dv;
+        fu_.bottomRightCorner(num_velocities_, num_velocities_) = aba_derivatives_codegen_->dddq_dtau;
+        // The semi-implicit Euler step below needs the accelerations as well
+        if (integrator_ == Integrator::SymplecticEuler) f(x, u);
+    }
+    else
+#endif
+    {
+        pinocchio::computeABADerivatives(model_, *pinocchio_data_.get(), x.head(num_positions_), x.tail(num_velocities_), u, fx_.block(num_velocities_, 0, num_velocities_, num_velocities_), fx_.block(num_velocities_, num_velocities_, num_velocities_, num_velocities_), fu_.bottomRightCorner(num_velocities_, num_velocities_));
+
+        // computeABADerivatives evaluates the forward dynamics on the way, i.e., f(x, u) comes for free.
+        xdot_analytic_.head(num_velocities_) = x.tail(num_velocities_);
+        xdot_analytic_.tail(num_velocities_) = pinocchio_data_->ddq;
+        f_point_.Set(x, u);
+    }
 
     Eigen::Block<Eigen::MatrixXd> da_dx = fx_.block(num_velocities_, 0, num_velocities_, get_num_state_derivative());
     Eigen::Block<Eigen::MatrixXd> da_du = fu_.block(num_velocities_, 0, num_velocities_, num_controls_);
@@ -61,7 +84,7 @@ void PinocchioDynamicsSolver::ComputeDerivatives(const StateVector& x, const Con
         // Semi-implicit Euler
         case Integrator::SymplecticEuler:
         {
-            Eigen::VectorXd dx_v = dt_ * x.tail(num_velocities_) + dt_ * dt_ * pinocchio_data_->ddq;
+            Eigen::VectorXd dx_v = dt_ * x.tail(num_velocities_) + dt_ * dt_ * xdot_analytic_.tail(num_velocities_);
 
             Fx_.topRows(num_velocities_).noalias() = dt_ * dt_ * da_dx;
             Fx_.bottomRows(num_velocities_).noalias() = dt_ * da_dx;
@@ -78,15 +101,14 @@ void PinocchioDynamicsSolver::ComputeDerivatives(const StateVector& x, const Con
         default:
             ThrowPretty("Not implemented!");
     };
+
+    derivatives_point_.Set(x, u, integrator_, dt_);
 }
 
 Eigen::MatrixXd PinocchioDynamicsSolver::fx(const StateVector& x, const ControlVector& u)
 {
     // Four quadrants should be: 0, Identity, ddq_dq, ddq_dv
-    // 0 and Identity are set during initialisation. Here, we pass references to ddq_dq, ddq_dv to the algorithm.
-    // pinocchio::computeABADerivatives(model_, *pinocchio_data_.get(), x.head(num_positions_), x.tail(num_velocities_), u, fx_.block(num_velocities_, 0, num_velocities_, num_velocities_), fx_.block(num_velocities_, num_velocities_, num_velocities_, num_velocities_), fu_.bottomRightCorner(num_velocities_, num_velocities_));
-
-    // This causes redundant computations but this method is no longer called in solvers.
+    // 0 and Identity are set during initialisation. The derivatives are only evaluated if not yet done at (x, u).
     ComputeDerivatives(x, u);
 
     return fx_;
@@ -94,10 +116,7 @@ Eigen::MatrixXd PinocchioDynamicsSolver::fx(const StateVector& x, const ControlV
 
 Eigen::MatrixXd PinocchioDynamicsSolver::fu(const StateVector& x, const ControlVector& u)
 {
-    // NB: ddq_dtau is computed with the same call - i.e., we are duplicating computation.
-    // pinocchio::computeABADerivatives(model_, *pinocchio_data_.get(), x.head(num_positions_), x.tail(num_velocities_), u, fx_.block(num_velocities_, 0, num_velocities_, num_velocities_), fx_.block(num_velocities_, num_velocities_, num_velocities_, num_velocities_), fu_.bottomRightCorner(num_velocities_, num_velocities_));
-
-    // This causes redundant computations but this method is no longer called in solvers.
+    // NB: ddq_dtau is computed with the same call as fx, i.e., fx and fu at the same point share one evaluation.
     ComputeDerivatives(x, u);
 
     return fu_;
@@ -35,10 +35,13 @@ namespace exotica
 {
 Eigen::VectorXd PinocchioDynamicsSolver::InverseDynamics(const StateVector& x)
 {
+    if (inverse_dynamics_point_.Matches(x, Eigen::VectorXd())) return u_inverse_dynamics_;
+
     // compute dynamic drift -- Coriolis, centrifugal, gravity
     // Assume 0 acceleration
-    Eigen::VectorXd u = pinocchio::rnea(model_, *pinocchio_data_.get(), x.head(num_positions_), x.tail(num_velocities_), Eigen::VectorXd::Zero(num_velocities_));
+    u_inverse_dynamics_ = pinocchio::rnea(model_, *pinocchio_data_.get(), x.head(num_positions_), x.tail(num_velocities_), Eigen::VectorXd::Zero(num_velocities_));
+    inverse_dynamics_point_.Set(x, Eigen::VectorXd());
 
-    return u;
+    return u_inverse_dynamics_;
 }
 }  // namespace exotica
@@ -37,8 +37,11 @@ namespace exotica
 {
 Eigen::VectorXd PinocchioDynamicsSolverWithGravityCompensation::f(const StateVector& x, const ControlVector& u)
 {
+    // The accelerations are also computed by ComputeDerivatives, reuse them if evaluated at (x, u) already.
+    if (f_point_.Matches(x, u)) return xdot_analytic_;
+
     // Obtain torque to compensate gravity and dynamic effects (Coriolis)
-    u_nle_ = pinocchio::nonLinearEffects(model_, *pinocchio_data_.get(), x.head(num_positions_), x.tail(num_velocities_));
+    UpdateNonLinearEffects(x);
 
     // Commanded torque is u_nle_ + u
     u_command_.noalias() = u_nle_ + u;
@@ -46,9 +49,17 @@ Eigen::VectorXd PinocchioDynamicsSolverWithGravityCompensation::f(const StateVec
     pinocchio::aba(model_, *pinocchio_data_.get(), x.head(num_positions_), x.tail(num_velocities_), u_command_);
     xdot_analytic_.head(num_velocities_) = x.tail(num_velocities_);
     xdot_analytic_.tail(num_velocities_) = pinocchio_data_->ddq;
+    f_point_.Set(x, u);
     return xdot_analytic_;
 }
 
+void PinocchioDynamicsSolverWithGravityCompensation::UpdateNonLinearEffects(const StateVector& x)
+{
+    if (nle_point_.Matches(x, Eigen::VectorXd())) return;
+    u_nle_ = pinocchio::nonLinearEffects(model_, *pinocchio_data_.get(), x.head(num_positions_), x.tail(num_velocities_));
+    nle_point_.Set(x, Eigen::VectorXd());
+}
+
 Eigen::VectorXd PinocchioDynamicsSolverWithGravityCompensation::StateDelta(const StateVector& x_1, const StateVector& x_2)
 {
     if (x_1.size() != num_positions_ + num_velocities_ || x_2.size() != num_positions_ + num_velocities_)
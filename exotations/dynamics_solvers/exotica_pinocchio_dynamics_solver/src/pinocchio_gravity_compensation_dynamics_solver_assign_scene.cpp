@@ -50,6 +50,9 @@ void PinocchioDynamicsSolverWithGravityCompensation::AssignScene(ScenePtr scene_
     num_controls_ = model_.nv;
 
     pinocchio_data_.reset(new pinocchio::Data(model_));
+    f_point_.Invalidate();
+    derivatives_point_.Invalidate();
+    nle_point_.Invalidate();
 
     // Pre-allocate data for f, fx, fu
     const int ndx = get_num_state_derivative();
@@ -41,22 +41,30 @@ namespace exotica
 {
 void PinocchioDynamicsSolverWithGravityCompensation::ComputeDerivatives(const StateVector& x, const ControlVector& u)
 {
+    // fx, fu and ComputeAll evaluate the derivatives at the same point one after another.
+    if (derivatives_point_.Matches(x, u, integrator_, dt_)) return;
+
     Eigen::VectorBlock<const Eigen::VectorXd> q = x.head(num_positions_);
     Eigen::VectorBlock<const Eigen::VectorXd> v = x.tail(num_velocities_);
 
-    // Obtain torque to compensate gravity and dynamic effects (Coriolis)
-    u_nle_ = pinocchio::nonLinearEffects(model_, *pinocchio_data_.get(), q, v);
-
-    // Commanded torque is u_nle_ + u
-    u_command_.noalias() = u_nle_ + u;
-
+    // computeAllTerms also yields the torque to compensate gravity and dynamic effects (Coriolis)
     pinocchio_data_->Minv.setZero();
     pinocchio::computeAllTerms(model_, *pinocchio_data_.get(), q, v);
+    u_nle_ = pinocchio_data_->nle;
+    nle_point_.Set(x, Eigen::VectorXd());
     pinocchio::cholesky::decompose(model_, *pinocchio_data_.get());
     pinocchio::cholesky::computeMinv(model_, *pinocchio_data_.get(), pinocchio_data_->Minv);
 
-    // du_command_dq_
+    // Commanded torque is u_nle_ + u
+    u_command_.noalias() = u_nle_ + u;
+
+    // The forward dynamics, a = Minv * u_command_, come for free
     a_.noalias() = pinocchio_data_->Minv * u_command_;
+    xdot_analytic_.head(num_velocities_) = v;
+    xdot_analytic_.tail(num_velocities_) = a_;
+    f_point_.Set(x, u);
+
+    // du_command_dq_
     pinocchio::computeRNEADerivatives(model_, *pinocchio_data_.get(), q, v, a_);
     du_command_dq_.noalias() = pinocchio_data_->Minv * pinocchio_data_->dtau_dq;
 
@@ -94,8 +102,7 @@ void PinocchioDynamicsSolverWithGravityCompensation::ComputeDerivatives(const St
         // Semi-implicit Euler
         case Integrator::SymplecticEuler:
         {
-            a_.noalias() = pinocchio_data_->Minv * u_command_;
-            Eigen::VectorXd dx_v = dt_ * x.tail(num_velocities_) + dt_ * dt_ * a_;
+            Eigen::VectorXd dx_v = dt_ * x.tail(num_velocities_) + dt_ * dt_ * xdot_analytic_.tail(num_velocities_);
 
             Fx_.topRows(num_velocities_).noalias() = dt_ * dt_ * da_dx;
             Fx_.bottomRows(num_velocities_).noalias() = dt_ * da_dx;
@@ -112,11 +119,13 @@ void PinocchioDynamicsSolverWithGravityCompensation::ComputeDerivatives(const St
         default:
             ThrowPretty("Not implemented!");
     };
+
+    derivatives_point_.Set(x, u, integrator_, dt_);
 }
 
 Eigen::MatrixXd PinocchioDynamicsSolverWithGravityCompensation::fx(const StateVector& x, const ControlVector& u)
 {
-    // This causes redundant computations but this method is no longer called in solvers.
+    // The derivatives are only evaluated if not yet done at (x, u).
     ComputeDerivatives(x, u);
 
     /*Eigen::VectorBlock<const Eigen::VectorXd> q = x.head(num_positions_);
@@ -151,7 +160,7 @@ Eigen::MatrixXd PinocchioDynamicsSolverWithGravityCompensation::fx(const StateVe
 
 Eigen::MatrixXd PinocchioDynamicsSolverWithGravityCompensation::fu(const StateVector& x, const ControlVector& u)
 {
-    // This causes redundant computations but this method is no longer called in solvers.
+    // The derivatives are only evaluated if not yet done at (x, u).
     ComputeDerivatives(x, u);
 
     /*Eigen::VectorBlock<const Eigen::VectorXd> q = x.head(num_positions_);
@@ -44,16 +44,18 @@ namespace exotica
 /// Cf. https://journals.sagepub.com/doi/abs/10.1177/0278364911434236
 ///
 /// StateVector X ∈ R^12 = [x, y, z, r, p, y, xdot, ydot, zdot, omega1, omega2, omega3]
-class QuadrotorDynamicsSolver : public DynamicsSolver, public Instantiable<QuadrotorDynamicsSolverInitializer>
+class QuadrotorDynamicsSolver : public FixedSizeDynamicsSolver<QuadrotorDynamicsSolver, 6, 4>, public Instantiable<QuadrotorDynamicsSolverInitializer>
 {
 public:
     QuadrotorDynamicsSolver();
 
     void AssignScene(ScenePtr scene_in) override;
 
-    StateVector f(const StateVector& x, const ControlVector& u) override;
-    Eigen::MatrixXd fx(const StateVector& x, const ControlVector& u) override;
-    Eigen::MatrixXd fu(const StateVector& x, const ControlVector& u) override;
+    void f_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateVector& state_dot) const;
+    template <typename Scalar>
+    void f_batch_fixed(const FixedStateBatchT<Scalar>& X, const FixedControlBatchT<Scalar>& U, FixedStateBatchT<Scalar>& state_dot) const;
+    void fx_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateDerivative& fx) const;
+    void fu_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedControlDerivative& fu) const;
 
 private:
     Eigen::Matrix3d J_;      ///< Inertia matrix
@@ -35,10 +35,6 @@ namespace exotica
 {
 QuadrotorDynamicsSolver::QuadrotorDynamicsSolver()
 {
-    num_positions_ = 6;
-    num_velocities_ = 6;
-    num_controls_ = 4;
-
     J_.setZero();
     J_.diagonal() = Eigen::Vector3d(0.0023, 0.0023, 0.004);
 
@@ -54,7 +50,7 @@ void QuadrotorDynamicsSolver::AssignScene(ScenePtr scene_in)
         ThrowPretty("Robot model may not be a quadrotor.");
 }
 
-Eigen::VectorXd QuadrotorDynamicsSolver::f(const StateVector& x, const ControlVector& u)
+void QuadrotorDynamicsSolver::f_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateVector& state_dot) const
 {
     double phi = x(3),
            theta = x(4),
@@ -82,7 +78,7 @@ Eigen::VectorXd QuadrotorDynamicsSolver::f(const StateVector& x, const ControlVe
            sin_psi = std::sin(psi),     cos_psi = std::cos(psi);
     // clang-format on
 
-    Eigen::MatrixXd Rx(3, 3), Ry(3, 3), Rz(3, 3), R;
+    Eigen::Matrix3d Rx, Ry, Rz, R;
     Rx << 1, 0, 0, 0, cos_phi, -sin_phi, 0, sin_phi, cos_phi;
     Ry << cos_theta, 0, sin_theta, 0, 1, 0, -sin_theta, 0, cos_theta;
     Rz << cos_psi, -sin_psi, 0, sin_psi, cos_psi, 0, 0, 0, 1;
@@ -113,16 +109,42 @@ Eigen::VectorXd QuadrotorDynamicsSolver::f(const StateVector& x, const ControlVe
 
     omega_dot = Iinv * (tau - omega.cross(I * omega));
 
-    Eigen::VectorXd state_dot(12);
     state_dot << x_dot, y_dot, z_dot,
         phi_dot, theta_dot, psi_dot,
         pos_ddot(0), pos_ddot(1), pos_ddot(2),
         omega_dot(0), omega_dot(1), omega_dot(2);
+}
 
-    return state_dot;
+template <typename Scalar>
+void QuadrotorDynamicsSolver::f_batch_fixed(const FixedStateBatchT<Scalar>& X, const FixedControlBatchT<Scalar>& U, FixedStateBatchT<Scalar>& state_dot) const
+{
+    // clang-format off
+    const FixedBatchRowT<Scalar> sin_phi = X.row(3).sin(),   cos_phi = X.row(3).cos(),
+                                 sin_theta = X.row(4).sin(), cos_theta = X.row(4).cos(),
+                                 sin_psi = X.row(5).sin(),   cos_psi = X.row(5).cos();
+    // clang-format on
+
+    // x,y,z dynamics: only the thrust along the body z-axis, i.e., the last column of R = Rz * Rx * Ry, acts
+    const FixedBatchRowT<Scalar> thrust_over_mass = static_cast<Scalar>(k_f_ / mass_) * U.colwise().sum();
+    state_dot.template topRows<6>() = X.template bottomRows<6>();
+    state_dot.row(6) = thrust_over_mass * (cos_psi * sin_theta + sin_psi * sin_phi * cos_theta);
+    state_dot.row(7) = thrust_over_mass * (sin_psi * sin_theta - cos_psi * sin_phi * cos_theta);
+    state_dot.row(8) = thrust_over_mass * cos_phi * cos_theta - static_cast<Scalar>(g_);
+
+    // phi, theta, psi dynamics with the diagonal inertia of f_fixed
+    const double radius = L_ / 2.0;
+    const double Ix = 2 * mass_ * (radius * radius) / 5.0 + 2 * radius * radius * mass_,
+                 Iy = 2 * mass_ * (radius * radius) / 5.0 + 2 * radius * radius * mass_,
+                 Iz = 2 * mass_ * (radius * radius) / 5.0 + 4 * radius * radius * mass_;
+    state_dot.row(9) = (static_cast<Scalar>(L_ * k_f_) * (U.row(0) - U.row(1)) - static_cast<Scalar>(Iz - Iy) * X.row(10) * X.row(11)) / static_cast<Scalar>(Ix);
+    state_dot.row(10) = (static_cast<Scalar>(L_ * k_f_) * (U.row(0) - U.row(2)) - static_cast<Scalar>(Ix - Iz) * X.row(9) * X.row(11)) / static_cast<Scalar>(Iy);
+    state_dot.row(11) = (static_cast<Scalar>(k_m_) * (U.row(0) - U.row(1) + U.row(2) - U.row(3)) - static_cast<Scalar>(Iy - Ix) * X.row(9) * X.row(10)) / static_cast<Scalar>(Iz);
 }
 
-Eigen::MatrixXd QuadrotorDynamicsSolver::fx(const StateVector& x, const ControlVector& u)
+template void QuadrotorDynamicsSolver::f_batch_fixed<double>(const FixedStateBatchT<double>&, const FixedControlBatchT<double>&, FixedStateBatchT<double>&) const;
+template void QuadrotorDynamicsSolver::f_batch_fixed<float>(const FixedStateBatchT<float>&, const FixedControlBatchT<float>&, FixedStateBatchT<float>&) const;
+
+void QuadrotorDynamicsSolver::fx_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateDerivative& fx) const
 {
     double phi = x(3),
            theta = x(4),
@@ -136,7 +158,6 @@ Eigen::MatrixXd QuadrotorDynamicsSolver::fx(const StateVector& x, const ControlV
            sin_theta = std::sin(theta), cos_theta = std::cos(theta),
            sin_psi = std::sin(psi),     cos_psi = std::cos(psi);
 
-    Eigen::MatrixXd fx(num_positions_ + num_velocities_, num_positions_ + num_velocities_);
     fx <<
         0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0,
         0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0,
@@ -152,10 +173,9 @@ Eigen::MatrixXd QuadrotorDynamicsSolver::fx(const StateVector& x, const ControlV
         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0;
 
     // clang-format on
-    return fx;
 }
 
-Eigen::MatrixXd QuadrotorDynamicsSolver::fu(const StateVector& x, const ControlVector& u)
+void QuadrotorDynamicsSolver::fu_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedControlDerivative& fu) const
 {
     double phi = x(3),
            theta = x(4),
@@ -166,7 +186,6 @@ Eigen::MatrixXd QuadrotorDynamicsSolver::fu(const StateVector& x, const ControlV
            sin_theta = std::sin(theta), cos_theta = std::cos(theta),
            sin_psi = std::sin(psi),     cos_psi = std::cos(psi);
 
-    Eigen::MatrixXd fu(num_positions_ + num_velocities_, num_controls_);
     fu << 
         0, 0, 0, 0,
         0, 0, 0, 0,
@@ -182,7 +201,6 @@ Eigen::MatrixXd QuadrotorDynamicsSolver::fu(const StateVector& x, const ControlV
         0.909090909090909*k_m_/(L_*L_*2*mass_), -0.909090909090909*k_m_/(L_*L_*2*mass_), 0.909090909090909*k_m_/(L_*L_*mass_), -0.909090909090909*k_m_/(L_*L_*mass_);
 
     // clang-format on
-    return fu;
 }
 
 }  // namespace exotica
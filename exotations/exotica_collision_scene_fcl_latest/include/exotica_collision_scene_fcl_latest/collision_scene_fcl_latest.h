@@ -30,7 +30,9 @@
 #ifndef EXOTICA_COLLISION_SCENE_FCL_LATEST_COLLISION_SCENE_FCL_LATEST_H_
 #define EXOTICA_COLLISION_SCENE_FCL_LATEST_COLLISION_SCENE_FCL_LATEST_H_
 
+#include <cstdint>
 #include <iostream>
+#include <unordered_map>
 
 #include <exotica_core/collision_scene.h>
 #include <exotica_core/tools/conversions.h>
@@ -44,27 +46,59 @@ namespace exotica
 class CollisionSceneFCLLatest : public CollisionScene, public Instantiable<CollisionSceneFCLLatestInitializer>
 {
 public:
+    /// \brief Statistics of a single query (or of the part of a query computed by one thread), see CollectStatistics.
+    struct QueryStatistics
+    {
+        void Add(const QueryStatistics& other);
+
+        bool enabled = false;
+        std::size_t num_broadphase_candidates = 0;
+        std::size_t num_collision_checks = 0;
+        std::size_t num_distance_computations = 0;
+        std::size_t num_fallbacks = 0;
+        std::unordered_map<std::uint64_t, std::pair<std::size_t, double>> pairs;  ///< Number of narrowphase queries and their cumulative time, keyed by the object indices
+    };
+
     struct CollisionData
     {
-        CollisionData(CollisionSceneFCLLatest* scene_in) : scene(scene_in) {}
+        CollisionData(CollisionSceneFCLLatest* scene_in) : scene(scene_in) { statistics.enabled = scene_in->collect_statistics_; }
         fcl::CollisionRequestd request;
         fcl::CollisionResultd result;
         CollisionSceneFCLLatest* scene;
         bool self = true;
         double safe_distance;
+        QueryStatistics statistics;
     };
 
     struct DistanceData
     {
-        DistanceData(CollisionSceneFCLLatest* scene_in) : scene(scene_in) {}
+        DistanceData(CollisionSceneFCLLatest* scene_in) : scene(scene_in) { statistics.enabled = scene_in->collect_statistics_; }
         fcl::DistanceRequestd request;
         fcl::DistanceResultd result;
         CollisionSceneFCLLatest* scene;
         std::vector<CollisionProxy> proxies;
+        CollisionProxyBuffer* buffer = nullptr;  ///< If set, the proxies are appended to this buffer instead of proxies
+        QueryStatistics statistics;
         double Distance = 1e300;
+        double check_margin = std::numeric_limits<double>::infinity();  ///< Pairs whose AABBs are at least this far apart are skipped
         bool self = true;
     };
 
+    /// \brief Distance of a pair of objects and their poses at the last distance query (see UseDistanceCache).
+    struct DistanceCacheEntry
+    {
+        /// \brief Lower bound on the current distance, given how far the objects can have moved since the last query.
+        double LowerBound(const fcl::CollisionObjectd* o1, const fcl::CollisionObjectd* o2) const;
+        void Update(const fcl::CollisionObjectd* o1, const fcl::CollisionObjectd* o2, double distance_in);
+
+        bool valid = false;
+        double distance = 0.0;
+        Eigen::Vector3d translation1;
+        Eigen::Vector3d translation2;
+        Eigen::Matrix3d rotation1;
+        Eigen::Matrix3d rotation2;
+    };
+
     void Setup() override;
 
     bool IsAllowedToCollide(const std::string& o1, const std::string& o2, const bool& self) override;
@@ -81,16 +115,21 @@ public:
 
     /// \brief Computes collision distances.
     /// \param self Indicate if self collision check is required.
+    /// \param check_margin Pairs of objects whose AABBs are further apart than this margin are culled in the broadphase.
     /// \return Collision proximity objects for all colliding pairs of objects.
-    std::vector<CollisionProxy> GetCollisionDistance(bool self) override;
-    std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const std::string& o2) override;
+    std::vector<CollisionProxy> GetCollisionDistance(bool self, double check_margin = std::numeric_limits<double>::infinity()) override;
+    std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const std::string& o2, double check_margin = std::numeric_limits<double>::infinity()) override;
     std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const bool& self = true) override;
-    std::vector<CollisionProxy> GetCollisionDistance(const std::vector<std::string>& objects, const bool& self = true) override;
-    std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const bool& self = true, const bool& disable_collision_scene_update = false) override;
+    std::vector<CollisionProxy> GetCollisionDistance(const std::vector<std::string>& objects, const bool& self = true, double check_margin = std::numeric_limits<double>::infinity()) override;
+    std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const bool& self = true, const bool& disable_collision_scene_update = false, double check_margin = std::numeric_limits<double>::infinity()) override;
 
     std::vector<CollisionProxy> GetRobotToRobotCollisionDistance(double check_margin) override;
     std::vector<CollisionProxy> GetRobotToWorldCollisionDistance(double check_margin) override;
 
+    void GetCollisionDistance(bool self, double check_margin, CollisionProxyBuffer& proxies) override;
+    void GetRobotToRobotCollisionDistance(double check_margin, CollisionProxyBuffer& proxies) override;
+    void GetRobotToWorldCollisionDistance(double check_margin, CollisionProxyBuffer& proxies) override;
+
     /// @brief      Performs a continuous collision check between two objects with a linear interpolation between two given
     /// @param[in]  o1       The first collision object, by name.
     /// @param[in]  tf1_beg  The beginning transform for o1.
@@ -101,6 +140,19 @@ public:
     /// @return     ContinuousCollisionProxy.
     ContinuousCollisionProxy ContinuousCollisionCheck(const std::string& o1, const KDL::Frame& tf1_beg, const KDL::Frame& tf1_end, const std::string& o2, const KDL::Frame& tf2_beg, const KDL::Frame& tf2_end) override;
 
+    /// @brief      Performs a continuous collision check of the robot along a whole trajectory.
+    ///             The frames of all states are computed in one batch and the segments are checked in parallel if NumThreads > 1.
+    ///             Pairs whose bounding spheres do not meet during a segment are skipped.
+    /// @param[in]  trajectory  Controlled states, one per row.
+    /// @param[in]  self        Indicate if self collision check is required.
+    /// @return     One ContinuousCollisionProxy per robot collision object (in the order of GetCollisionRobotLinks) with its earliest contact.
+    std::vector<ContinuousCollisionProxy> ContinuousCollisionCheckTrajectory(Eigen::MatrixXdRefConst trajectory, bool self = true) override;
+
+    /// \brief Casts rays against the world objects. Primitive shapes are intersected exactly, meshes by traversing their BVHs
+    /// and octrees by traversing their occupied nodes. The rays are intersected with the surface of meshes, i.e., a ray starting
+    /// inside a mesh hits it where it leaves the mesh.
+    Eigen::VectorXd RayCast(const Eigen::Ref<const Eigen::Matrix3Xd>& origins, const Eigen::Ref<const Eigen::Matrix3Xd>& directions, double max_distance = std::numeric_limits<double>::infinity()) override;
+
     /// @brief      Gets the collision world links.
     /// @return     The collision world links.
     std::vector<std::string> GetCollisionWorldLinks() override;
@@ -115,19 +167,104 @@ public:
     /// \param objects Vector kinematic element pointers of collision objects.
     void UpdateCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects) override;
 
+    /// \brief Recreates only the collision objects of re-attached elements, keeping all other objects intact.
+    /// \param objects Kinematic elements of the re-attached collision objects.
+    void UpdateReattachedCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects) override;
+
+    /// \brief Keeps the collision objects of elements with modified octrees, which share the octree with the scene.
+    /// \param objects Kinematic elements with modified octrees.
+    void UpdateOctreeCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects) override;
+
+    /// \brief Creates only the collision objects of added elements, keeping all other objects intact.
+    /// \param objects Kinematic elements of the added collision objects.
+    void AddCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects) override;
+
+    /// \brief Destroys only the collision objects of removed elements, keeping all other objects intact.
+    /// \param names Names of the removed kinematic elements.
+    void RemoveCollisionObjects(const std::vector<std::string>& names) override;
+
     /// \brief Updates collision object transformations from the kinematic tree.
     void UpdateCollisionObjectTransforms() override;
 
+    /// \brief Sets the allowed collision matrix and recompiles the collision filter.
+    void SetACM(const AllowedCollisionMatrix& acm) override;
+
+    /// \brief Returns the statistics of the discrete collision and distance queries since the last reset (see CollectStatistics).
+    CollisionStatistics GetCollisionStatistics() const override;
+    void ResetCollisionStatistics() override;
+
+    /// \brief Selects the distance cache of the following distance queries with UseDistanceCache. Slots are created on first use.
+    void SetDistanceCacheSlot(int slot) override;
+    int GetDistanceCacheSlot() const override { return distance_cache_slot_; }
+
 private:
-    std::shared_ptr<fcl::BroadPhaseCollisionManagerd> broad_phase_collision_manager_;
+    // Robot and world objects are kept in separate persistent trees. Only objects whose transforms
+    // changed are refitted, the world tree is usually static between calls to UpdateCollisionObjects.
+    std::shared_ptr<fcl::BroadPhaseCollisionManagerd> robot_broad_phase_collision_manager_;
+    std::shared_ptr<fcl::BroadPhaseCollisionManagerd> world_broad_phase_collision_manager_;
+    std::vector<fcl::CollisionObjectd*> updated_robot_objects_;
+    std::vector<fcl::CollisionObjectd*> updated_world_objects_;
+    std::uint64_t transform_update_stamp_ = 0;  ///< KinematicTree update stamp of the last UpdateCollisionObjectTransforms, 0 refreshes all objects
 
     std::shared_ptr<fcl::CollisionObjectd> ConstructFclCollisionObject(long i, std::shared_ptr<KinematicElement> element);
+    std::shared_ptr<fcl::CollisionGeometryd> ConstructFclCollisionGeometry(const shapes::Shape& shape, double scale, double padding);
+    /// \brief Constructs the BVH (or the convex hull, see UseConvexHulls) of a mesh, cached by the geometry of the mesh (see GeometryCacheDirectory).
+    std::shared_ptr<fcl::CollisionGeometryd> ConstructFclMeshGeometry(const shapes::Mesh& mesh, double scale, double padding);
+    bool use_convex_hulls_ = false;
+    std::string geometry_cache_directory_;
+    AllowedCollisionMatrix disabled_collision_pairs_;  ///< Robot link pairs from DisabledCollisionPairsFile, combined with the ACM in the collision filter
     static void CheckCollision(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, CollisionData* data);
-    static void ComputeDistance(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, DistanceData* data);
+    static void ComputeDistance(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, DistanceData* data, DistanceCacheEntry* cache = nullptr);
+    /// \brief Stores the proxy of the objects with the given indices in data->buffer if set, in data->proxies otherwise.
+    static void StoreProxy(DistanceData* data, long index1, long index2, CollisionProxy& proxy);
+    static fcl::ContinuousCollisionRequestd GetContinuousCollisionRequest(const fcl::CollisionObjectd* o1, const fcl::CollisionObjectd* o2);
+
+    struct DistanceQuery
+    {
+        fcl::CollisionObjectd* o1;
+        fcl::CollisionObjectd* o2;
+        DistanceCacheEntry* cache;
+    };
+
+    /// \brief Collects the pair for a distance query unless its AABBs or its cached distance are farther apart than the check margin.
+    void AddDistanceQuery(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, double check_margin, std::vector<DistanceQuery>& queries);
+
+    void AddRobotToRobotDistanceQueries(double check_margin, std::vector<DistanceQuery>& queries);
+    void AddRobotToWorldDistanceQueries(double check_margin, std::vector<DistanceQuery>& queries);
+
+    /// \brief Computes the distances of the given pairs, in parallel if NumThreads > 1 and there are at least ParallelThreshold pairs.
+    /// The proxies are stored in buffer if set, in proxies otherwise.
+    void ComputeDistances(const std::vector<DistanceQuery>& queries, bool self, std::vector<CollisionProxy>* proxies, CollisionProxyBuffer* buffer = nullptr);
+    std::vector<DistanceQuery> distance_queries_;                ///< Reused by the buffer queries
+    std::vector<CollisionProxyBuffer> thread_proxy_buffers_;  ///< Reused by the parallel buffer queries
+    int num_threads_ = 1;
+    int parallel_threshold_ = 16;
+
+    /// Per-pair distances of GetRobotToRobotCollisionDistance and GetRobotToWorldCollisionDistance, keyed by the object indices,
+    /// one cache per slot (see SetDistanceCacheSlot)
+    bool use_distance_cache_ = false;
+    std::vector<std::unordered_map<std::uint64_t, DistanceCacheEntry>> distance_caches_ = std::vector<std::unordered_map<std::uint64_t, DistanceCacheEntry>>(1);
+    int distance_cache_slot_ = 0;
+    void ClearDistanceCaches();
+
+    /// Statistics accumulated over all queries since the last reset
+    bool collect_statistics_ = false;
+    QueryStatistics statistics_;
+    void AddStatistics(const QueryStatistics& statistics);
+
+    /// \brief Compiles which pairs of collision objects are checked (robot/world objects, shapes of the same object, ACM)
+    /// into a bit matrix indexed by the kinematic element ids stored on the FCL objects.
+    void UpdateCollisionFilter();
+    std::vector<bool> collision_filter_;  ///< Row-major, whether a pair of objects is checked when self collisions are requested
+    std::vector<bool> is_robot_object_;
 
     std::vector<fcl::CollisionObjectd*> fcl_objects_;
     std::vector<std::shared_ptr<fcl::CollisionObjectd>> fcl_cache_;  // to avoid shared_ptr from going stale, to be refactored
     std::vector<std::weak_ptr<KinematicElement>> kinematic_elements_;
+    std::vector<const KinematicElement*> kinematic_element_pointers_;  ///< Unlocked kinematic_elements_, owned by the KinematicTree
+    std::vector<int> kinematic_element_handles_;                       ///< Frame handles of kinematic_elements_ (KinematicTree::GetFrameHandle)
+    /// \brief Updates kinematic_element_handles_ from the tree, e.g., after elements have been removed from it.
+    void UpdateKinematicElementHandles();
     std::map<std::string, std::weak_ptr<KinematicElement>> kinematic_elements_map_;
 
     // The following maps are stored by the name of the *frame*, e.g., base_link_collision_0
@@ -29,11 +29,27 @@
 
 #include <exotica_collision_scene_fcl_latest/collision_scene_fcl_latest.h>
 #include <exotica_core/factory.h>
+#include <exotica_core/loaders/initializer_serialization.h>
 #include <exotica_core/scene.h>
+#include <exotica_core/server.h>
+#include <exotica_core/tools/parallel_loop.h>
+#include <exotica_core/tools/timer.h>
 
+#include <geometric_shapes/bodies.h>
 #include <geometric_shapes/mesh_operations.h>
 #include <geometric_shapes/shape_operations.h>
 
+#include <unistd.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
 REGISTER_COLLISION_SCENE_TYPE("CollisionSceneFCLLatest", exotica::CollisionSceneFCLLatest)
 
 #define CONTINUOUS_COLLISION_USE_ADVANCED_SETTINGS
@@ -63,11 +79,341 @@ inline bool IsRobotLink(std::shared_ptr<KinematicElement> e)
     return e->is_robot_link || e->closest_robot_link.lock();
 }
 
+namespace
+{
+std::uint64_t GetDistanceCacheKey(const fcl::CollisionObjectd* o1, const fcl::CollisionObjectd* o2)
+{
+    return (static_cast<std::uint64_t>(reinterpret_cast<long>(o1->getUserData())) << 32) | static_cast<std::uint64_t>(reinterpret_cast<long>(o2->getUserData()));
+}
+
+// Adds the time until it goes out of scope to the narrowphase queries of the pair
+class PairTimer
+{
+public:
+    PairTimer(CollisionSceneFCLLatest::QueryStatistics& statistics, const fcl::CollisionObjectd* o1, const fcl::CollisionObjectd* o2) : statistics_(statistics), o1_(o1), o2_(o2) {}
+
+    ~PairTimer()
+    {
+        if (!statistics_.enabled) return;
+        std::pair<std::size_t, double>& pair = statistics_.pairs[GetDistanceCacheKey(o1_, o2_)];
+        ++pair.first;
+        pair.second += timer_.GetDuration();
+    }
+
+private:
+    CollisionSceneFCLLatest::QueryStatistics& statistics_;
+    const fcl::CollisionObjectd* o1_;
+    const fcl::CollisionObjectd* o2_;
+    Timer timer_;
+};
+}  // namespace
+
+void CollisionSceneFCLLatest::QueryStatistics::Add(const QueryStatistics& other)
+{
+    num_broadphase_candidates += other.num_broadphase_candidates;
+    num_collision_checks += other.num_collision_checks;
+    num_distance_computations += other.num_distance_computations;
+    num_fallbacks += other.num_fallbacks;
+    for (const auto& pair : other.pairs)
+    {
+        std::pair<std::size_t, double>& total = pairs[pair.first];
+        total.first += pair.second.first;
+        total.second += pair.second.second;
+    }
+}
+
+void CollisionSceneFCLLatest::AddStatistics(const QueryStatistics& statistics)
+{
+    if (collect_statistics_) statistics_.Add(statistics);
+}
+
+CollisionStatistics CollisionSceneFCLLatest::GetCollisionStatistics() const
+{
+    if (!collect_statistics_) WARNING_NAMED("CollisionSceneFCLLatest", "Statistics are not collected, set CollectStatistics to enable them.");
+
+    CollisionStatistics ret;
+    ret.num_broadphase_candidates = statistics_.num_broadphase_candidates;
+    ret.num_collision_checks = statistics_.num_collision_checks;
+    ret.num_distance_computations = statistics_.num_distance_computations;
+    ret.num_fallbacks = statistics_.num_fallbacks;
+    ret.pairs.reserve(statistics_.pairs.size());
+    for (const auto& pair : statistics_.pairs)
+    {
+        // The objects may have been recreated since, the indices refer to the current objects
+        CollisionPairStatistics pair_statistics;
+        const std::size_t i = pair.first >> 32;
+        const std::size_t j = pair.first & 0xffffffff;
+        std::shared_ptr<KinematicElement> e1 = i < kinematic_elements_.size() ? kinematic_elements_[i].lock() : nullptr;
+        std::shared_ptr<KinematicElement> e2 = j < kinematic_elements_.size() ? kinematic_elements_[j].lock() : nullptr;
+        if (e1) pair_statistics.object1 = e1->segment.getName();
+        if (e2) pair_statistics.object2 = e2->segment.getName();
+        pair_statistics.num_queries = pair.second.first;
+        pair_statistics.time = pair.second.second;
+        ret.pairs.push_back(pair_statistics);
+    }
+    std::sort(ret.pairs.begin(), ret.pairs.end(), [](const CollisionPairStatistics& a, const CollisionPairStatistics& b) { return a.time > b.time; });
+    return ret;
+}
+
+void CollisionSceneFCLLatest::ResetCollisionStatistics()
+{
+    statistics_ = QueryStatistics();
+}
+
+void CollisionSceneFCLLatest::SetDistanceCacheSlot(int slot)
+{
+    if (slot < 0) ThrowPretty("The distance cache slot has to be non-negative, given: " << slot);
+    if (slot >= static_cast<int>(distance_caches_.size())) distance_caches_.resize(slot + 1);
+    distance_cache_slot_ = slot;
+}
+
+void CollisionSceneFCLLatest::ClearDistanceCaches()
+{
+    for (auto& distance_cache : distance_caches_) distance_cache.clear();
+}
+
+// Collision geometries do not change once constructed. They are therefore shared between all collision scenes
+// built from the same shapes (e.g. scenes created with Scene::Clone) instead of rebuilding the BVHs for each.
+struct CachedGeometry
+{
+    std::weak_ptr<const shapes::Shape> shape;
+    double scale;
+    double padding;
+    bool replace_primitive_shapes_with_meshes;
+    bool replace_cylinders_with_capsules;
+    bool use_convex_hulls;
+    std::weak_ptr<fcl::CollisionGeometryd> geometry;
+};
+
+static std::mutex geometry_cache_mutex;
+static std::multimap<const shapes::Shape*, CachedGeometry> geometry_cache;
+
+static std::shared_ptr<fcl::CollisionGeometryd> GetCachedGeometry(const shapes::ShapeConstPtr& shape, double scale, double padding, bool replace_primitive_shapes_with_meshes, bool replace_cylinders_with_capsules, bool use_convex_hulls)
+{
+    std::lock_guard<std::mutex> lock(geometry_cache_mutex);
+    auto range = geometry_cache.equal_range(shape.get());
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const CachedGeometry& entry = it->second;
+        if (entry.shape.lock() == shape && entry.scale == scale && entry.padding == padding &&
+            entry.replace_primitive_shapes_with_meshes == replace_primitive_shapes_with_meshes &&
+            entry.replace_cylinders_with_capsules == replace_cylinders_with_capsules && entry.use_convex_hulls == use_convex_hulls)
+        {
+            return entry.geometry.lock();
+        }
+    }
+    return nullptr;
+}
+
+static void AddCachedGeometry(const shapes::ShapeConstPtr& shape, double scale, double padding, bool replace_primitive_shapes_with_meshes, bool replace_cylinders_with_capsules, bool use_convex_hulls, const std::shared_ptr<fcl::CollisionGeometryd>& geometry)
+{
+    std::lock_guard<std::mutex> lock(geometry_cache_mutex);
+
+    // Drop entries whose shape or geometry is gone
+    for (auto it = geometry_cache.begin(); it != geometry_cache.end();)
+    {
+        if (it->second.shape.expired() || it->second.geometry.expired())
+        {
+            it = geometry_cache.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    geometry_cache.emplace(shape.get(), CachedGeometry{shape, scale, padding, replace_primitive_shapes_with_meshes, replace_cylinders_with_capsules, use_convex_hulls, geometry});
+}
+
+// The cache above only finds shapes that are shared, meshes loaded again (e.g. when the scene is loaded again) are new shapes.
+// Processed meshes are therefore additionally cached by their geometry, the most recently used ones in memory and, if a cache
+// directory is set, all of them on disk. FCL does not support loading its BVHs, the files hold the vertices and triangles after scaling,
+// padding and computing the convex hull, i.e., the BVHs are fitted again when the meshes are loaded from disk.
+struct MeshData
+{
+    bool convex = false;
+    std::vector<fcl::Vector3d> vertices;
+    std::vector<int> triangles;
+};
+
+// Least recently used first, the map points into the list
+static const std::size_t mesh_geometry_cache_capacity = 256;
+static std::mutex mesh_geometry_cache_mutex;
+static std::list<std::pair<std::string, std::shared_ptr<fcl::CollisionGeometryd>>> mesh_geometry_cache;
+static std::unordered_map<std::string, decltype(mesh_geometry_cache)::iterator> mesh_geometry_cache_index;
+
+static std::shared_ptr<fcl::CollisionGeometryd> GetCachedMeshGeometry(const std::string& key)
+{
+    auto it = mesh_geometry_cache_index.find(key);
+    if (it == mesh_geometry_cache_index.end()) return nullptr;
+    mesh_geometry_cache.splice(mesh_geometry_cache.end(), mesh_geometry_cache, it->second);
+    return it->second->second;
+}
+
+static void AddCachedMeshGeometry(const std::string& key, const std::shared_ptr<fcl::CollisionGeometryd>& geometry)
+{
+    mesh_geometry_cache_index[key] = mesh_geometry_cache.emplace(mesh_geometry_cache.end(), key, geometry);
+    while (mesh_geometry_cache.size() > mesh_geometry_cache_capacity)
+    {
+        mesh_geometry_cache_index.erase(mesh_geometry_cache.front().first);
+        mesh_geometry_cache.pop_front();
+    }
+}
+
+// The source vertices, triangles, scale and padding, whose length is stored in the files to detect collisions of the key
+static std::string GetMeshGeometrySource(const shapes::Mesh& mesh, double scale, double padding)
+{
+    std::string source(reinterpret_cast<const char*>(mesh.vertices), 3 * mesh.vertex_count * sizeof(double));
+    source.append(reinterpret_cast<const char*>(mesh.triangles), 3 * mesh.triangle_count * sizeof(unsigned int));
+    source.append(reinterpret_cast<const char*>(&scale), sizeof(double));
+    source.append(reinterpret_cast<const char*>(&padding), sizeof(double));
+    return source;
+}
+
+// Two FNV-1a hashes with different seeds, i.e., a 128-bit key which, unlike std::hash, is the same for all builds
+static std::string GetMeshGeometryKey(const shapes::Mesh& mesh, const std::string& source, bool use_convex_hull)
+{
+    static const std::uint64_t second_seed = HashContent("exotica_collision_scene_fcl_latest");
+    std::stringstream ss;
+    ss << "fcl_mesh_" << mesh.vertex_count << "_" << mesh.triangle_count << (use_convex_hull ? "_convex_" : "_") << std::hex << std::setfill('0')
+       << std::setw(16) << HashContent(source) << std::setw(16) << HashContent(source, second_seed);
+    return ss.str();
+}
+
+static const std::uint64_t mesh_data_file_version = 2;
+
+static void SaveMeshData(const MeshData& data, std::uint64_t source_size, const std::string& file_name)
+{
+    // Written to a temporary file first, such that concurrently running or interrupted processes never leave partial files
+    const std::string temporary_file = file_name + "." + std::to_string(getpid());
+    {
+        std::ofstream file(temporary_file, std::ios::binary);
+        if (!file.good()) ThrowPretty("Can't write mesh to '" << temporary_file << "'!");
+        const std::uint64_t header[5] = {mesh_data_file_version, data.convex, data.vertices.size(), data.triangles.size(), source_size};
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(data.vertices.data()), data.vertices.size() * sizeof(fcl::Vector3d));
+        file.write(reinterpret_cast<const char*>(data.triangles.data()), data.triangles.size() * sizeof(int));
+        file.close();
+        if (file.fail())
+        {
+            std::remove(temporary_file.c_str());
+            ThrowPretty("Can't write mesh to '" << temporary_file << "'!");
+        }
+    }
+    if (std::rename(temporary_file.c_str(), file_name.c_str()) != 0)
+    {
+        std::remove(temporary_file.c_str());
+        ThrowPretty("Can't move mesh to '" << file_name << "'!");
+    }
+}
+
+static bool LoadMeshData(const std::string& file_name, std::uint64_t source_size, MeshData& data)
+{
+    std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+    if (!file.good()) return false;
+    const std::uint64_t file_size = static_cast<std::uint64_t>(file.tellg());
+    file.seekg(0);
+    std::uint64_t header[5];
+    if (file_size < sizeof(header)) return false;
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file.good() || header[0] != mesh_data_file_version || header[1] > 1 || header[3] % 3 != 0 || header[4] != source_size) return false;
+
+    // The counts have to match the size of the file, they are compared without overflowing before allocating the buffers
+    const std::uint64_t data_size = file_size - sizeof(header);
+    if (header[2] > data_size / sizeof(fcl::Vector3d) || header[3] > data_size / sizeof(int) || header[2] * sizeof(fcl::Vector3d) + header[3] * sizeof(int) != data_size) return false;
+    data.convex = header[1];
+    data.vertices.resize(header[2]);
+    data.triangles.resize(header[3]);
+    file.read(reinterpret_cast<char*>(data.vertices.data()), data.vertices.size() * sizeof(fcl::Vector3d));
+    file.read(reinterpret_cast<char*>(data.triangles.data()), data.triangles.size() * sizeof(int));
+    if (!file.good()) return false;
+    for (const int index : data.triangles)
+    {
+        if (index < 0 || index >= static_cast<int>(data.vertices.size())) return false;
+    }
+    return true;
+}
+
+static MeshData GetMeshData(const shapes::Mesh& mesh)
+{
+    MeshData data;
+    data.vertices.resize(mesh.vertex_count);
+    for (unsigned int i = 0; i < mesh.vertex_count; ++i) data.vertices[i] = fcl::Vector3d(mesh.vertices[3 * i], mesh.vertices[3 * i + 1], mesh.vertices[3 * i + 2]);
+    data.triangles.assign(mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
+    return data;
+}
+
+static std::shared_ptr<fcl::CollisionGeometryd> ConstructMeshGeometry(const MeshData& data)
+{
+    std::shared_ptr<fcl::CollisionGeometryd> geometry;
+    const int num_triangles = static_cast<int>(data.triangles.size() / 3);
+    if (data.convex && num_triangles > 0)
+    {
+        // Faces are stored as the number of vertices followed by their indices
+        std::shared_ptr<std::vector<int>> faces = std::make_shared<std::vector<int>>();
+        faces->reserve(4 * num_triangles);
+        for (int i = 0; i < num_triangles; ++i)
+        {
+            faces->push_back(3);
+            faces->insert(faces->end(), data.triangles.begin() + 3 * i, data.triangles.begin() + 3 * i + 3);
+        }
+        geometry.reset(new fcl::Convexd(std::make_shared<const std::vector<fcl::Vector3d>>(data.vertices), num_triangles, faces));
+    }
+    else
+    {
+        auto g = new fcl::BVHModel<fcl::OBBRSSd>();
+        if (!data.vertices.empty() && num_triangles > 0)
+        {
+            std::vector<fcl::Triangle> tri_indices(num_triangles);
+            for (int i = 0; i < num_triangles; ++i) tri_indices[i] = fcl::Triangle(data.triangles[3 * i], data.triangles[3 * i + 1], data.triangles[3 * i + 2]);
+
+            g->beginModel();
+            g->addSubModel(data.vertices, tri_indices);
+            g->endModel();
+        }
+        geometry.reset(g);
+    }
+    geometry->computeLocalAABB();
+    return geometry;
+}
+
 void CollisionSceneFCLLatest::Setup()
 {
     if (debug_) HIGHLIGHT_NAMED("CollisionSceneFCLLatest", "FCL version: " << FCL_VERSION);
 
-    broad_phase_collision_manager_.reset(new fcl::DynamicAABBTreeCollisionManagerd());
+    robot_broad_phase_collision_manager_.reset(new fcl::DynamicAABBTreeCollisionManagerd());
+    world_broad_phase_collision_manager_.reset(new fcl::DynamicAABBTreeCollisionManagerd());
+
+    if (parameters_.NumThreads < 0) ThrowPretty("Invalid number of threads: " << parameters_.NumThreads);
+    num_threads_ = Server::ResolveNumThreads(parameters_.NumThreads);
+    parallel_threshold_ = parameters_.ParallelThreshold;
+    use_distance_cache_ = parameters_.UseDistanceCache;
+    ClearDistanceCaches();
+    use_convex_hulls_ = parameters_.UseConvexHulls;
+    geometry_cache_directory_ = parameters_.GeometryCacheDirectory.empty() ? "" : ParsePath(parameters_.GeometryCacheDirectory);
+    collect_statistics_ = parameters_.CollectStatistics;
+    statistics_ = QueryStatistics();
+
+    disabled_collision_pairs_.clear();
+    if (!parameters_.DisabledCollisionPairsFile.empty())
+    {
+        const std::string file_name = ParsePath(parameters_.DisabledCollisionPairsFile);
+        std::ifstream file(file_name);
+        if (!file.is_open()) ThrowPretty("Can't open disabled collision pairs file '" << file_name << "'!");
+        std::string line;
+        int num_pairs = 0;
+        while (std::getline(file, line))
+        {
+            std::istringstream iss(line);
+            std::string link1, link2;
+            if (!(iss >> link1) || link1[0] == '#') continue;
+            if (!(iss >> link2)) ThrowPretty("Invalid line in disabled collision pairs file '" << file_name << "': " << line);
+            disabled_collision_pairs_.setEntry(link1, link2);
+            disabled_collision_pairs_.setEntry(link2, link1);
+            ++num_pairs;
+        }
+        if (debug_) HIGHLIGHT_NAMED("CollisionSceneFCLLatest", "Loaded " << num_pairs << " disabled collision pairs from " << file_name);
+    }
 }
 
 void CollisionSceneFCLLatest::UpdateCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects)
@@ -76,6 +422,8 @@ void CollisionSceneFCLLatest::UpdateCollisionObjects(const std::map<std::string,
 
     kinematic_elements_.clear();
     kinematic_elements_.reserve(objects.size());
+    kinematic_element_pointers_.clear();
+    kinematic_element_pointers_.reserve(objects.size());
 
     fcl_cache_.clear();
     fcl_cache_.reserve(objects.size());
@@ -87,6 +435,9 @@ void CollisionSceneFCLLatest::UpdateCollisionObjects(const std::map<std::string,
     fcl_robot_objects_map_.clear();
     fcl_world_objects_map_.clear();
 
+    std::vector<fcl::CollisionObjectd*> robot_objects;
+    std::vector<fcl::CollisionObjectd*> world_objects;
+
     long i = 0;
 
     auto world_links_to_exclude_from_collision_scene = scene_.lock()->get_world_links_to_exclude_from_collision_scene();
@@ -107,30 +458,306 @@ void CollisionSceneFCLLatest::UpdateCollisionObjects(const std::map<std::string,
             fcl_cache_.emplace_back(new_object);
             fcl_objects_.emplace_back(new_object.get());
             kinematic_elements_.emplace_back(object.second);
+            kinematic_element_pointers_.emplace_back(object.second.lock().get());
 
             fcl_objects_map_[object.first].emplace_back(new_object.get());
             // Check whether this is a robot or environment link:
             if (IsRobotLink(object.second.lock()))
             {
                 fcl_robot_objects_map_[object.first].emplace_back(new_object.get());
+                robot_objects.emplace_back(new_object.get());
             }
             else
             {
                 fcl_world_objects_map_[object.first].emplace_back(new_object.get());
+                world_objects.emplace_back(new_object.get());
             }
 
             ++i;
         }
     }
 
-    // Register objects with the BroadPhaseCollisionManager
-    broad_phase_collision_manager_->clear();
-    broad_phase_collision_manager_->registerObjects(fcl_objects_);
+    UpdateKinematicElementHandles();
+
+    // Register objects with the BroadPhaseCollisionManagers
+    robot_broad_phase_collision_manager_->clear();
+    robot_broad_phase_collision_manager_->registerObjects(robot_objects);
+    world_broad_phase_collision_manager_->clear();
+    world_broad_phase_collision_manager_->registerObjects(world_objects);
+    updated_robot_objects_.reserve(robot_objects.size());
+    updated_world_objects_.reserve(world_objects.size());
+    ClearDistanceCaches();
+    // The pairs are keyed by the object indices, which refer to the new objects now
+    statistics_.pairs.clear();
+    UpdateCollisionFilter();
+    transform_update_stamp_ = 0;
     needs_update_of_collision_objects_ = false;
 }
 
+void CollisionSceneFCLLatest::UpdateReattachedCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects)
+{
+    // Fall back to recreating all objects if the collision scene is out of date, e.g., because elements have been added since
+    for (const auto& object : objects)
+    {
+        const auto& it = kinematic_elements_map_.find(object.first);
+        if (needs_update_of_collision_objects_ || it == kinematic_elements_map_.end() || object.second.expired() || it->second.lock() != object.second.lock())
+        {
+            CollisionScene::UpdateReattachedCollisionObjects(objects);
+            return;
+        }
+    }
+
+    for (const auto& object : objects)
+    {
+        // Excluded objects do not have any collision objects
+        const auto& it = fcl_objects_map_.find(object.first);
+        if (it == fcl_objects_map_.end()) continue;
+
+        // Re-attaching may change whether the object belongs to the robot and thus its scaling and padding.
+        // The geometry cache keeps this cheap if the geometry stays the same.
+        std::shared_ptr<KinematicElement> element = object.second.lock();
+        const bool was_robot_link = fcl_robot_objects_map_.count(object.first) > 0;
+        const bool is_robot_link = IsRobotLink(element);
+        for (fcl::CollisionObjectd*& collision_object : it->second)
+        {
+            const long i = reinterpret_cast<long>(collision_object->getUserData());
+            std::shared_ptr<fcl::CollisionObjectd> new_object = ConstructFclCollisionObject(i, element);
+            new_object->setTransform(collision_object->getTransform());
+            new_object->computeAABB();
+
+            (was_robot_link ? robot_broad_phase_collision_manager_ : world_broad_phase_collision_manager_)->unregisterObject(collision_object);
+            (is_robot_link ? robot_broad_phase_collision_manager_ : world_broad_phase_collision_manager_)->registerObject(new_object.get());
+            fcl_objects_[i] = new_object.get();
+            fcl_cache_[i] = new_object;
+            collision_object = new_object.get();
+        }
+
+        // Cached distances may refer to the old geometry
+        ClearDistanceCaches();
+
+        fcl_robot_objects_map_.erase(object.first);
+        fcl_world_objects_map_.erase(object.first);
+        if (is_robot_link)
+        {
+            fcl_robot_objects_map_[object.first] = it->second;
+        }
+        else
+        {
+            fcl_world_objects_map_[object.first] = it->second;
+        }
+    }
+
+    // Re-attaching changes the parent and whether the object belongs to the robot
+    UpdateCollisionFilter();
+    transform_update_stamp_ = 0;
+}
+
+void CollisionSceneFCLLatest::UpdateOctreeCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects)
+{
+    for (const auto& object : objects)
+    {
+        const auto& it = kinematic_elements_map_.find(object.first);
+        if (needs_update_of_collision_objects_ || it == kinematic_elements_map_.end() || object.second.expired() || it->second.lock() != object.second.lock())
+        {
+            CollisionScene::UpdateOctreeCollisionObjects(objects);
+            return;
+        }
+    }
+
+    // fcl::OcTree queries the shared octomap directly and its bounding volume spans the whole octree regardless of
+    // the occupancy, so neither the collision objects nor their broadphase entries need to be updated.
+    // Cached distances may refer to leaves that changed though.
+    ClearDistanceCaches();
+}
+
+void CollisionSceneFCLLatest::AddCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects)
+{
+    // Fall back to recreating all objects if the collision scene is out of date
+    for (const auto& object : objects)
+    {
+        if (needs_update_of_collision_objects_ || kinematic_elements_map_.count(object.first) > 0 || object.second.expired())
+        {
+            CollisionScene::AddCollisionObjects(objects);
+            return;
+        }
+    }
+
+    const auto world_links_to_exclude_from_collision_scene = scene_.lock()->get_world_links_to_exclude_from_collision_scene();
+    for (const auto& object : objects)
+    {
+        kinematic_elements_map_.insert(object);
+        if (world_links_to_exclude_from_collision_scene.count(object.first) > 0) continue;
+
+        // The frames of the added elements are up to date, they are not necessarily recomputed by the next update
+        std::shared_ptr<KinematicElement> element = object.second.lock();
+        const long i = static_cast<long>(fcl_objects_.size());
+        std::shared_ptr<fcl::CollisionObjectd> new_object = ConstructFclCollisionObject(i, element);
+        new_object->setTransform(transformKDLToFCL(element->frame));
+        new_object->computeAABB();
+
+        fcl_cache_.emplace_back(new_object);
+        fcl_objects_.emplace_back(new_object.get());
+        kinematic_elements_.emplace_back(object.second);
+        kinematic_element_pointers_.emplace_back(element.get());
+
+        fcl_objects_map_[object.first].emplace_back(new_object.get());
+        if (IsRobotLink(element))
+        {
+            fcl_robot_objects_map_[object.first].emplace_back(new_object.get());
+            robot_broad_phase_collision_manager_->registerObject(new_object.get());
+        }
+        else
+        {
+            fcl_world_objects_map_[object.first].emplace_back(new_object.get());
+            world_broad_phase_collision_manager_->registerObject(new_object.get());
+        }
+    }
+
+    // The indices of the existing objects are unchanged, so are their cached distances
+    UpdateKinematicElementHandles();
+    UpdateCollisionFilter();
+}
+
+void CollisionSceneFCLLatest::RemoveCollisionObjects(const std::vector<std::string>& names)
+{
+    if (needs_update_of_collision_objects_)
+    {
+        CollisionScene::RemoveCollisionObjects(names);
+        return;
+    }
+
+    std::vector<bool> is_removed(fcl_objects_.size(), false);
+    for (const std::string& name : names)
+    {
+        kinematic_elements_map_.erase(name);
+
+        // Excluded objects do not have any collision objects
+        const auto& it = fcl_objects_map_.find(name);
+        if (it == fcl_objects_map_.end()) continue;
+        const bool is_robot_link = fcl_robot_objects_map_.count(name) > 0;
+        for (fcl::CollisionObjectd* collision_object : it->second)
+        {
+            is_removed[reinterpret_cast<long>(collision_object->getUserData())] = true;
+            (is_robot_link ? robot_broad_phase_collision_manager_ : world_broad_phase_collision_manager_)->unregisterObject(collision_object);
+        }
+        fcl_objects_map_.erase(it);
+        fcl_robot_objects_map_.erase(name);
+        fcl_world_objects_map_.erase(name);
+    }
+
+    // Compact the remaining objects, the indices stored on the FCL objects are updated accordingly.
+    // The removed elements have been destroyed already, so their pointers are not dereferenced.
+    long num_objects = 0;
+    for (std::size_t i = 0; i < fcl_objects_.size(); ++i)
+    {
+        if (is_removed[i]) continue;
+        fcl_objects_[num_objects] = fcl_objects_[i];
+        fcl_cache_[num_objects] = std::move(fcl_cache_[i]);
+        kinematic_elements_[num_objects] = kinematic_elements_[i];
+        kinematic_element_pointers_[num_objects] = kinematic_element_pointers_[i];
+        fcl_objects_[num_objects]->setUserData(reinterpret_cast<void*>(num_objects));
+        ++num_objects;
+    }
+    fcl_objects_.resize(num_objects);
+    fcl_cache_.resize(num_objects);
+    kinematic_elements_.resize(num_objects);
+    kinematic_element_pointers_.resize(num_objects);
+
+    // The ids of the elements added after the removed ones have changed, and the caches are keyed by the object indices
+    UpdateKinematicElementHandles();
+    ClearDistanceCaches();
+    statistics_.pairs.clear();
+    UpdateCollisionFilter();
+}
+
+void CollisionSceneFCLLatest::UpdateKinematicElementHandles()
+{
+    // Frame handles are the indices into the tree
+    std::unordered_map<const KinematicElement*, int> frame_handles;
+    const auto& tree = scene_.lock()->GetKinematicTree().GetTree();
+    for (std::size_t k = 0; k < tree.size(); ++k) frame_handles[tree[k].lock().get()] = static_cast<int>(k);
+
+    kinematic_element_handles_.resize(kinematic_element_pointers_.size());
+    for (std::size_t i = 0; i < kinematic_element_pointers_.size(); ++i)
+    {
+        const auto& handle = frame_handles.find(kinematic_element_pointers_[i]);
+        kinematic_element_handles_[i] = handle != frame_handles.end() ? handle->second : -1;
+    }
+}
+
+void CollisionSceneFCLLatest::SetACM(const AllowedCollisionMatrix& acm)
+{
+    CollisionScene::SetACM(acm);
+    UpdateCollisionFilter();
+}
+
+void CollisionSceneFCLLatest::UpdateCollisionFilter()
+{
+    const std::size_t num_objects = kinematic_elements_.size();
+    is_robot_object_.assign(num_objects, false);
+    std::vector<const KinematicElement*> parents(num_objects, nullptr);
+    std::vector<const KinematicElement*> closest_robot_links(num_objects, nullptr);
+
+    // The ACM is defined between robot links, the entries are looked up once per pair of links
+    std::vector<std::string> acm_names;
+    std::unordered_map<std::string, std::size_t> acm_name_to_index;
+    std::vector<std::size_t> acm_index(num_objects, 0);
+    for (std::size_t i = 0; i < num_objects; ++i)
+    {
+        std::shared_ptr<KinematicElement> element = kinematic_elements_[i].lock();
+        // The objects are out of date (e.g., the ACM is set in between UpdateSceneFrames and UpdateCollisionObjects),
+        // the filter is compiled again when they are recreated
+        if (!element) continue;
+        std::shared_ptr<KinematicElement> closest_robot_link = element->closest_robot_link.lock();
+        is_robot_object_[i] = IsRobotLink(element);
+        parents[i] = element->parent.lock().get();
+        closest_robot_links[i] = closest_robot_link.get();
+        if (is_robot_object_[i])
+        {
+            const std::string& name = closest_robot_link ? closest_robot_link->segment.getName() : element->parent.lock()->segment.getName();
+            auto it = acm_name_to_index.emplace(name, acm_names.size());
+            if (it.second) acm_names.push_back(name);
+            acm_index[i] = it.first->second;
+        }
+    }
+
+    const std::size_t num_acm_names = acm_names.size();
+    std::vector<bool> allowed_collisions(num_acm_names * num_acm_names);
+    for (std::size_t a = 0; a < num_acm_names; ++a)
+    {
+        for (std::size_t b = 0; b < num_acm_names; ++b)
+        {
+            allowed_collisions[a * num_acm_names + b] = acm_.getAllowedCollision(acm_names[a], acm_names[b]) && disabled_collision_pairs_.getAllowedCollision(acm_names[a], acm_names[b]);
+        }
+    }
+
+    collision_filter_.assign(num_objects * num_objects, false);
+    for (std::size_t i = 0; i < num_objects; ++i)
+    {
+        for (std::size_t j = 0; j < num_objects; ++j)
+        {
+            // Don't check collisions between world objects
+            if (!is_robot_object_[i] && !is_robot_object_[j]) continue;
+            // Skip collisions between shapes within the same objects
+            if (parents[i] == parents[j]) continue;
+            // Skip collisions between bodies attached to the same object
+            if (closest_robot_links[i] && closest_robot_links[i] == closest_robot_links[j]) continue;
+
+            collision_filter_[i * num_objects + j] = (is_robot_object_[i] && is_robot_object_[j]) ? allowed_collisions[acm_index[i] * num_acm_names + acm_index[j]] : true;
+        }
+    }
+}
+
 void CollisionSceneFCLLatest::UpdateCollisionObjectTransforms()
 {
+    EXOTICA_PROFILE_SCOPE("CollisionSceneFCLLatest::UpdateCollisionObjectTransforms");
+    updated_robot_objects_.clear();
+    updated_world_objects_.clear();
+
+    // Only the elements whose frames were recomputed by the KinematicTree since the last call may have moved,
+    // the stamp restarts from 0 if the tree has been replaced.
+    const std::uint64_t update_stamp = scene_.lock()->GetKinematicTree().GetUpdateStamp();
+    const std::uint64_t last_update_stamp = update_stamp < transform_update_stamp_ ? 0 : transform_update_stamp_;
     for (fcl::CollisionObjectd* collision_object : fcl_objects_)
     {
         if (!collision_object)
@@ -142,6 +769,7 @@ void CollisionSceneFCLLatest::UpdateCollisionObjectTransforms()
         {
             ThrowPretty("Expired pointer, this should not happen - make sure to call UpdateCollisionObjects() after UpdateSceneFrames()");
         }
+        if (last_update_stamp > 0 && element->frame_stamp <= last_update_stamp) continue;
 
         // Check for NaNs
         if (std::isnan(element->frame.p.data[0]) || std::isnan(element->frame.p.data[1]) || std::isnan(element->frame.p.data[2]))
@@ -149,9 +777,17 @@ void CollisionSceneFCLLatest::UpdateCollisionObjectTransforms()
             ThrowPretty("Transform for " << element->segment.getName() << " contains NaNs.");
         }
 
-        collision_object->setTransform(transformKDLToFCL(element->frame));
+        // Only refit objects that moved
+        const fcl::Transform3d transform = transformKDLToFCL(element->frame);
+        if (transform.matrix() == collision_object->getTransform().matrix()) continue;
+        collision_object->setTransform(transform);
         collision_object->computeAABB();
+        (IsRobotLink(element) ? updated_robot_objects_ : updated_world_objects_).emplace_back(collision_object);
     }
+
+    if (!updated_robot_objects_.empty()) robot_broad_phase_collision_manager_->update(updated_robot_objects_);
+    if (!updated_world_objects_.empty()) world_broad_phase_collision_manager_->update(updated_world_objects_);
+    transform_update_stamp_ = update_stamp;
 }
 
 // This function was originally copied from 'moveit_core/collision_detection_fcl/src/collision_common.cpp'
@@ -159,22 +795,79 @@ void CollisionSceneFCLLatest::UpdateCollisionObjectTransforms()
 // and then modified for use in EXOTica.
 std::shared_ptr<fcl::CollisionObjectd> CollisionSceneFCLLatest::ConstructFclCollisionObject(long kinematic_element_id, std::shared_ptr<KinematicElement> element)
 {
-    shapes::ShapePtr shape(element->shape->clone());
+    const bool is_robot_link = IsRobotLink(element);
+    const double scale = is_robot_link ? robot_link_scale_ : world_link_scale_;
+    const double padding = is_robot_link ? robot_link_padding_ : world_link_padding_;
 
-    // Apply scaling and padding
-    if (IsRobotLink(element))
+    std::shared_ptr<fcl::CollisionGeometryd> geometry = GetCachedGeometry(element->shape, scale, padding, replace_primitive_shapes_with_meshes_, replace_cylinders_with_capsules_, use_convex_hulls_);
+    if (geometry == nullptr)
     {
-        if (robot_link_scale_ != 1.0 || robot_link_padding_ > 0.0)
-        {
-            shape->scaleAndPadd(robot_link_scale_, robot_link_padding_);
-        }
+        geometry = ConstructFclCollisionGeometry(*element->shape, scale, padding);
+        AddCachedGeometry(element->shape, scale, padding, replace_primitive_shapes_with_meshes_, replace_cylinders_with_capsules_, use_convex_hulls_, geometry);
     }
-    else
+
+    std::shared_ptr<fcl::CollisionObjectd> ret(new fcl::CollisionObjectd(geometry));
+    ret->setUserData(reinterpret_cast<void*>(kinematic_element_id));
+
+    return ret;
+}
+
+std::shared_ptr<fcl::CollisionGeometryd> CollisionSceneFCLLatest::ConstructFclMeshGeometry(const shapes::Mesh& source_mesh, double scale, double padding)
+{
+    const std::string source = GetMeshGeometrySource(source_mesh, scale, padding);
+    const std::string key = GetMeshGeometryKey(source_mesh, source, use_convex_hulls_);
+    std::lock_guard<std::mutex> lock(mesh_geometry_cache_mutex);
+    std::shared_ptr<fcl::CollisionGeometryd> cached_geometry = GetCachedMeshGeometry(key);
+    if (cached_geometry) return cached_geometry;
+
+    MeshData data;
+    const std::string file_name = geometry_cache_directory_.empty() ? "" : geometry_cache_directory_ + "/" + key + ".bin";
+    if (file_name.empty() || !LoadMeshData(file_name, source.size(), data))
     {
-        if (world_link_scale_ != 1.0 || world_link_padding_ > 0.0)
+        std::unique_ptr<shapes::Mesh> mesh(source_mesh.clone());
+        if (scale != 1.0 || padding > 0.0) mesh->scaleAndPadd(scale, padding);
+
+        if (use_convex_hulls_ && mesh->vertex_count > 0)
         {
-            shape->scaleAndPadd(world_link_scale_, world_link_padding_);
+            // Degenerate meshes (e.g. planar) do not have a hull and are kept as they are
+            bodies::ConvexMesh hull(mesh.get());
+            if (!hull.getTriangles().empty())
+            {
+                data.convex = true;
+                data.vertices.assign(hull.getVertices().begin(), hull.getVertices().end());
+                data.triangles.assign(hull.getTriangles().begin(), hull.getTriangles().end());
+            }
         }
+        if (!data.convex) data = GetMeshData(*mesh);
+
+        if (!file_name.empty())
+        {
+            try
+            {
+                SaveMeshData(data, source.size(), file_name);
+            }
+            catch (const std::exception& e)
+            {
+                WARNING_NAMED("CollisionSceneFCLLatest", e.what());
+            }
+        }
+    }
+
+    std::shared_ptr<fcl::CollisionGeometryd> geometry = ConstructMeshGeometry(data);
+    AddCachedMeshGeometry(key, geometry);
+    return geometry;
+}
+
+std::shared_ptr<fcl::CollisionGeometryd> CollisionSceneFCLLatest::ConstructFclCollisionGeometry(const shapes::Shape& source_shape, double scale, double padding)
+{
+    if (source_shape.type == shapes::MESH) return ConstructFclMeshGeometry(static_cast<const shapes::Mesh&>(source_shape), scale, padding);
+
+    shapes::ShapePtr shape(source_shape.clone());
+
+    // Apply scaling and padding
+    if (scale != 1.0 || padding > 0.0)
+    {
+        shape->scaleAndPadd(scale, padding);
     }
 
     // Replace primitive shapes with meshes if desired (e.g. if primitives are unstable)
@@ -230,24 +923,8 @@ std::shared_ptr<fcl::CollisionObjectd> CollisionSceneFCLLatest::ConstructFclColl
         break;
         case shapes::MESH:
         {
-            auto g = new fcl::BVHModel<fcl::OBBRSSd>();
-            auto mesh = dynamic_cast<const shapes::Mesh*>(shape.get());
-            if (mesh->vertex_count > 0 && mesh->triangle_count > 0)
-            {
-                std::vector<fcl::Triangle> tri_indices(mesh->triangle_count);
-                for (unsigned int i = 0; i < mesh->triangle_count; ++i)
-                    tri_indices[i] =
-                        fcl::Triangle(mesh->triangles[3 * i], mesh->triangles[3 * i + 1], mesh->triangles[3 * i + 2]);
-
-                std::vector<fcl::Vector3d> points(mesh->vertex_count);
-                for (unsigned int i = 0; i < mesh->vertex_count; ++i)
-                    points[i] = fcl::Vector3d(mesh->vertices[3 * i], mesh->vertices[3 * i + 1], mesh->vertices[3 * i + 2]);
-
-                g->beginModel();
-                g->addSubModel(points, tri_indices);
-                g->endModel();
-            }
-            geometry.reset(g);
+            // Primitive shapes replaced with meshes, these are convex already
+            geometry = ConstructMeshGeometry(GetMeshData(*dynamic_cast<const shapes::Mesh*>(shape.get())));
         }
         break;
         case shapes::OCTREE:
@@ -260,11 +937,7 @@ std::shared_ptr<fcl::CollisionObjectd> CollisionSceneFCLLatest::ConstructFclColl
             ThrowPretty("This shape type (" << ((int)shape->type) << ") is not supported using FCL yet");
     }
     geometry->computeLocalAABB();
-    geometry->setUserData(reinterpret_cast<void*>(kinematic_element_id));
-    std::shared_ptr<fcl::CollisionObjectd> ret(new fcl::CollisionObjectd(geometry));
-    ret->setUserData(reinterpret_cast<void*>(kinematic_element_id));
-
-    return ret;
+    return geometry;
 }
 
 bool CollisionSceneFCLLatest::IsAllowedToCollide(const std::string& o1, const std::string& o2, const bool& self)
@@ -287,44 +960,33 @@ bool CollisionSceneFCLLatest::IsAllowedToCollide(const std::string& o1, const st
     {
         const std::string& name1 = e1->closest_robot_link.lock() ? e1->closest_robot_link.lock()->segment.getName() : e1->parent.lock()->segment.getName();
         const std::string& name2 = e2->closest_robot_link.lock() ? e2->closest_robot_link.lock()->segment.getName() : e2->parent.lock()->segment.getName();
-        return acm_.getAllowedCollision(name1, name2);
+        return acm_.getAllowedCollision(name1, name2) && disabled_collision_pairs_.getAllowedCollision(name1, name2);
     }
     return true;
 }
 
 bool CollisionSceneFCLLatest::IsAllowedToCollide(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, bool self, CollisionSceneFCLLatest* scene)
 {
-    std::shared_ptr<KinematicElement> e1 = scene->kinematic_elements_[reinterpret_cast<long>(o1->getUserData())].lock();
-    std::shared_ptr<KinematicElement> e2 = scene->kinematic_elements_[reinterpret_cast<long>(o2->getUserData())].lock();
+    // The filter is compiled in UpdateCollisionFilter, see IsAllowedToCollide(const std::string&, const std::string&, const bool&) for the rules
+    const std::size_t i = reinterpret_cast<std::size_t>(o1->getUserData());
+    const std::size_t j = reinterpret_cast<std::size_t>(o2->getUserData());
 
-    bool isRobot1 = IsRobotLink(e1);
-    bool isRobot2 = IsRobotLink(e2);
-    // Don't check collisions between world objects
-    if (!isRobot1 && !isRobot2) return false;
     // Skip self collisions if requested
-    if (isRobot1 && isRobot2 && !self) return false;
-    // Skip collisions between shapes within the same objects
-    if (e1->parent.lock() == e2->parent.lock()) return false;
-    // Skip collisions between bodies attached to the same object
-    if (e1->closest_robot_link.lock() && e2->closest_robot_link.lock() && e1->closest_robot_link.lock() == e2->closest_robot_link.lock()) return false;
-
-    if (isRobot1 && isRobot2)
-    {
-        const std::string& name1 = e1->closest_robot_link.lock() ? e1->closest_robot_link.lock()->segment.getName() : e1->parent.lock()->segment.getName();
-        const std::string& name2 = e2->closest_robot_link.lock() ? e2->closest_robot_link.lock()->segment.getName() : e2->parent.lock()->segment.getName();
-        return scene->acm_.getAllowedCollision(name1, name2);
-    }
-    return true;
+    if (!self && scene->is_robot_object_[i] && scene->is_robot_object_[j]) return false;
+    return scene->collision_filter_[i * scene->is_robot_object_.size() + j];
 }
 
 void CollisionSceneFCLLatest::CheckCollision(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, CollisionData* data)
 {
+    PairTimer timer(data->statistics, o1, o2);
     data->request.num_max_contacts = 1000;
     data->request.gjk_solver_type = fcl::GST_LIBCCD;
     data->result.clear();
+    ++data->statistics.num_collision_checks;
     fcl::collide(o1, o2, data->request, data->result);
     if (data->safe_distance > 0.0 && o1->getAABB().distance(o2->getAABB()) < data->safe_distance)
     {
+        ++data->statistics.num_distance_computations;
         fcl::DistanceRequestd req;
         fcl::DistanceResultd res;
         req.enable_nearest_points = false;
@@ -338,18 +1000,222 @@ bool CollisionSceneFCLLatest::CollisionCallback(fcl::CollisionObjectd* o1, fcl::
 {
     CollisionData* data_ = reinterpret_cast<CollisionData*>(data);
 
+    ++data_->statistics.num_broadphase_candidates;
     if (!IsAllowedToCollide(o1, o2, data_->self, data_->scene)) return false;
 
     CheckCollision(o1, o2, data_);
     return data_->result.isCollision();
 }
 
-void CollisionSceneFCLLatest::ComputeDistance(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, DistanceData* data)
+namespace
+{
+// Upper bound on how far any point of the object moved since it had the given pose: the translation of the
+// origin plus the displacement due to the rotation (2 sin(angle/2) |x|) at the farthest point of the geometry.
+double GetMotionBound(const fcl::CollisionObjectd* o, const Eigen::Vector3d& translation, const Eigen::Matrix3d& rotation)
+{
+    const fcl::Transform3d& transform = o->getTransform();
+    const double angle = Eigen::AngleAxisd(rotation.transpose() * transform.linear()).angle();
+    const double radius = o->collisionGeometry()->aabb_center.norm() + o->collisionGeometry()->aabb_radius;
+    return (transform.translation() - translation).norm() + 2.0 * std::sin(0.5 * angle) * radius;
+}
+
+// Closed-form distances and witness points of sphere, capsule and box pairs. Spheres and capsules are swept spheres,
+// i.e., all points within radius of the segment (a, b). The conventions follow the generic path in ComputeDistance:
+// contact1/contact2 are the closest (or, if penetrating, deepest) points on the first/second object and normal1 points
+// from the first to the second object if apart, and the other way around if touching or penetrating.
+struct SweptSphere
+{
+    Eigen::Vector3d a;
+    Eigen::Vector3d b;
+    double radius;
+};
+
+// Distances below this threshold are reported as touching contacts, as in ComputeDistance
+constexpr double kTouchingDistance = 1e-9;
+
+void SetPrimitiveProxy(const Eigen::Vector3d& contact1, const Eigen::Vector3d& contact2, const Eigen::Vector3d& direction, double distance, CollisionProxy& proxy)
+{
+    const bool touching = std::abs(distance) < kTouchingDistance;
+    proxy.distance = touching ? 0.0 : distance;
+    proxy.contact1 = contact1;
+    proxy.contact2 = contact2;
+    proxy.normal1 = distance > kTouchingDistance ? direction : Eigen::Vector3d(-direction);
+    proxy.normal2 = -proxy.normal1;
+}
+
+// Closest points of the segments (p1, q1) and (p2, q2), cf. Ericson, Real-Time Collision Detection, Section 5.1.9
+void ClosestPointsSegmentSegment(const Eigen::Vector3d& p1, const Eigen::Vector3d& q1, const Eigen::Vector3d& p2, const Eigen::Vector3d& q2, Eigen::Vector3d& c1, Eigen::Vector3d& c2)
+{
+    constexpr double eps = 1e-12;
+    const Eigen::Vector3d d1 = q1 - p1;
+    const Eigen::Vector3d d2 = q2 - p2;
+    const Eigen::Vector3d r = p1 - p2;
+    const double a = d1.squaredNorm();
+    const double e = d2.squaredNorm();
+    const double f = d2.dot(r);
+    double s = 0.0;
+    double t = 0.0;
+    if (a <= eps && e > eps)
+    {
+        t = std::min(std::max(f / e, 0.0), 1.0);
+    }
+    else if (a > eps)
+    {
+        const double c = d1.dot(r);
+        if (e <= eps)
+        {
+            s = std::min(std::max(-c / a, 0.0), 1.0);
+        }
+        else
+        {
+            // Parallel segments (denominator zero) use an arbitrary s, here 0
+            const double b = d1.dot(d2);
+            const double denominator = a * e - b * b;
+            if (denominator > eps * a * e) s = std::min(std::max((b * f - c * e) / denominator, 0.0), 1.0);
+            t = (b * s + f) / e;
+            if (t < 0.0)
+            {
+                t = 0.0;
+                s = std::min(std::max(-c / a, 0.0), 1.0);
+            }
+            else if (t > 1.0)
+            {
+                t = 1.0;
+                s = std::min(std::max((b - c) / a, 0.0), 1.0);
+            }
+        }
+    }
+    c1 = p1 + s * d1;
+    c2 = p2 + t * d2;
+}
+
+void ComputeSweptSphereDistance(const SweptSphere& s1, const SweptSphere& s2, CollisionProxy& proxy)
+{
+    Eigen::Vector3d x1, x2;
+    ClosestPointsSegmentSegment(s1.a, s1.b, s2.a, s2.b, x1, x2);
+    const double axis_distance = (x2 - x1).norm();
+    const Eigen::Vector3d direction = axis_distance > 1e-12 ? Eigen::Vector3d((x2 - x1) / axis_distance) : Eigen::Vector3d::UnitZ();
+    SetPrimitiveProxy(x1 + s1.radius * direction, x2 - s2.radius * direction, direction, axis_distance - s1.radius - s2.radius, proxy);
+}
+
+// Box with the given half extents and pose as the first object, sphere as the second.
+void ComputeBoxSphereDistance(const Eigen::Vector3d& half_extents, const Eigen::Isometry3d& box_pose, const Eigen::Vector3d& centre, double radius, CollisionProxy& proxy)
 {
-    // Setup proxy.
+    const Eigen::Vector3d local_centre = box_pose.linear().transpose() * (centre - box_pose.translation());
+    Eigen::Vector3d surface = local_centre.cwiseMax(-half_extents).cwiseMin(half_extents);
+    Eigen::Vector3d local_direction;
+    double distance;
+    if (surface != local_centre)
+    {
+        local_direction = local_centre - surface;
+        const double centre_distance = local_direction.norm();
+        local_direction /= centre_distance;
+        distance = centre_distance - radius;
+    }
+    else
+    {
+        // The centre is inside the box, the sphere is pushed out through the closest face
+        int axis;
+        const double depth = (half_extents - local_centre.cwiseAbs()).minCoeff(&axis);
+        local_direction.setZero();
+        local_direction(axis) = local_centre(axis) >= 0.0 ? 1.0 : -1.0;
+        surface(axis) = local_direction(axis) * half_extents(axis);
+        distance = -depth - radius;
+    }
+    const Eigen::Vector3d direction = box_pose.linear() * local_direction;
+    SetPrimitiveProxy(box_pose * surface, centre - radius * direction, direction, distance, proxy);
+}
+
+bool GetSweptSphere(const fcl::CollisionObjectd* o, SweptSphere& swept_sphere)
+{
+    const fcl::CollisionGeometryd* geometry = o->collisionGeometry().get();
+    const fcl::Transform3d& transform = o->getTransform();
+    switch (geometry->getNodeType())
+    {
+        case fcl::GEOM_SPHERE:
+            swept_sphere.a = swept_sphere.b = transform.translation();
+            swept_sphere.radius = static_cast<const fcl::Sphered*>(geometry)->radius;
+            return true;
+        case fcl::GEOM_CAPSULE:
+        {
+            const fcl::Capsuled* capsule = static_cast<const fcl::Capsuled*>(geometry);
+            const Eigen::Vector3d half_axis = 0.5 * capsule->lz * transform.linear().col(2);
+            swept_sphere.a = transform.translation() - half_axis;
+            swept_sphere.b = transform.translation() + half_axis;
+            swept_sphere.radius = capsule->radius;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Computes the distance of sphere-sphere, sphere-capsule, capsule-capsule and sphere-box pairs in closed form.
+// Returns false for all other pairs, which use the generic path.
+bool ComputePrimitiveDistance(const fcl::CollisionObjectd* o1, const fcl::CollisionObjectd* o2, CollisionProxy& proxy)
+{
+    SweptSphere s1, s2;
+    const bool is_swept_sphere1 = GetSweptSphere(o1, s1);
+    const bool is_swept_sphere2 = GetSweptSphere(o2, s2);
+    if (is_swept_sphere1 && is_swept_sphere2)
+    {
+        ComputeSweptSphereDistance(s1, s2, proxy);
+        return true;
+    }
+
+    const bool is_sphere1 = is_swept_sphere1 && o1->collisionGeometry()->getNodeType() == fcl::GEOM_SPHERE;
+    const bool is_sphere2 = is_swept_sphere2 && o2->collisionGeometry()->getNodeType() == fcl::GEOM_SPHERE;
+    if (is_sphere2 && o1->collisionGeometry()->getNodeType() == fcl::GEOM_BOX)
+    {
+        ComputeBoxSphereDistance(0.5 * static_cast<const fcl::Boxd*>(o1->collisionGeometry().get())->side, o1->getTransform(), s2.a, s2.radius, proxy);
+        return true;
+    }
+    if (is_sphere1 && o2->collisionGeometry()->getNodeType() == fcl::GEOM_BOX)
+    {
+        ComputeBoxSphereDistance(0.5 * static_cast<const fcl::Boxd*>(o2->collisionGeometry().get())->side, o2->getTransform(), s1.a, s1.radius, proxy);
+        std::swap(proxy.contact1, proxy.contact2);
+        std::swap(proxy.normal1, proxy.normal2);
+        return true;
+    }
+    return false;
+}
+}  // namespace
+
+double CollisionSceneFCLLatest::DistanceCacheEntry::LowerBound(const fcl::CollisionObjectd* o1, const fcl::CollisionObjectd* o2) const
+{
+    return distance - GetMotionBound(o1, translation1, rotation1) - GetMotionBound(o2, translation2, rotation2);
+}
+
+void CollisionSceneFCLLatest::DistanceCacheEntry::Update(const fcl::CollisionObjectd* o1, const fcl::CollisionObjectd* o2, double distance_in)
+{
+    valid = true;
+    distance = distance_in;
+    translation1 = o1->getTransform().translation();
+    translation2 = o2->getTransform().translation();
+    rotation1 = o1->getTransform().linear();
+    rotation2 = o2->getTransform().linear();
+}
+
+void CollisionSceneFCLLatest::ComputeDistance(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, DistanceData* data, DistanceCacheEntry* cache)
+{
+    PairTimer timer(data->statistics, o1, o2);
+
+    // Setup proxy. The elements are only locked when storing the proxy in data->proxies.
+    const long index1 = reinterpret_cast<long>(o1->getUserData());
+    const long index2 = reinterpret_cast<long>(o2->getUserData());
+    const KinematicElement* e1 = data->scene->kinematic_element_pointers_[index1];
+    const KinematicElement* e2 = data->scene->kinematic_element_pointers_[index2];
     CollisionProxy p;
-    p.e1 = data->scene->kinematic_elements_[reinterpret_cast<long>(o1->getUserData())].lock();
-    p.e2 = data->scene->kinematic_elements_[reinterpret_cast<long>(o2->getUserData())].lock();
+
+    // Closed-form distances of sphere, capsule and box pairs
+    if (ComputePrimitiveDistance(o1, o2, p))
+    {
+        ++data->statistics.num_distance_computations;
+        data->Distance = std::min(data->Distance, p.distance);
+        StoreProxy(data, index1, index2, p);
+        if (cache) cache->Update(o1, o2, p.distance);
+        return;
+    }
 
     // New logic as of August 2018:
     //  - Use LIBCCD as comment in Drake suggests it is more reliable now.
@@ -372,7 +1238,12 @@ void CollisionSceneFCLLatest::ComputeDistance(fcl::CollisionObjectd* o1, fcl::Co
     tmp_req.gjk_tolerance = 2e-12;
     tmp_req.gjk_solver_type = fcl::GJKSolverType::GST_LIBCCD;
 
-    fcl::collide(o1, o2, tmp_req, tmp_res);
+    // The collision check can be skipped if the cached distance shows that the objects are still apart.
+    if (cache == nullptr || !cache->valid || cache->LowerBound(o1, o2) <= 0.0)
+    {
+        ++data->statistics.num_collision_checks;
+        fcl::collide(o1, o2, tmp_req, tmp_res);
+    }
 
     // Step 1: If in collision, extract contact point.
     if (tmp_res.isCollision())
@@ -427,7 +1298,8 @@ void CollisionSceneFCLLatest::ComputeDistance(fcl::CollisionObjectd* o1, fcl::Co
             p.contact2 = p_WBc;
 
             data->Distance = std::min(data->Distance, p.distance);
-            data->proxies.push_back(p);
+            StoreProxy(data, index1, index2, p);
+            if (cache) cache->Update(o1, o2, p.distance);
 
             return;
         }
@@ -444,6 +1316,7 @@ void CollisionSceneFCLLatest::ComputeDistance(fcl::CollisionObjectd* o1, fcl::Co
     data->request.gjk_solver_type = fcl::GST_LIBCCD;
     data->result.clear();
 
+    ++data->statistics.num_distance_computations;
     double min_dist = fcl::distance(o1, o2, data->request, data->result);
 
     // If -1 is returned, the returned query is a touching contact (or not implemented).
@@ -481,6 +1354,7 @@ void CollisionSceneFCLLatest::ComputeDistance(fcl::CollisionObjectd* o1, fcl::Co
     // Check if NaN
     if (std::isnan(c1(0)) || std::isnan(c1(1)) || std::isnan(c1(2)) || std::isnan(c2(0)) || std::isnan(c2(1)) || std::isnan(c2(2)))
     {
+        ++data->statistics.num_fallbacks;
         // LIBCCD queries require unreasonably high tolerances, i.e. we may not
         // be able to compute contacts because one of those borderline cases.
         // Hence, when we encounter a NaN for a _sphere_, we will replace it
@@ -488,18 +1362,18 @@ void CollisionSceneFCLLatest::ComputeDistance(fcl::CollisionObjectd* o1, fcl::Co
         if (data->request.gjk_solver_type == fcl::GST_LIBCCD)
         {
             HIGHLIGHT_NAMED("computeDistanceLibCCD",
-                            "Contact1 between " << p.e1->segment.getName() << " and " << p.e2->segment.getName() << " contains NaN"
-                                                << ", where ShapeType1: " << p.e1->shape->type << " and ShapeType2: " << p.e2->shape->type << " and distance: " << p.distance << " and solver: " << data->request.gjk_solver_type);
+                            "Contact1 between " << e1->segment.getName() << " and " << e2->segment.getName() << " contains NaN"
+                                                << ", where ShapeType1: " << e1->shape->type << " and ShapeType2: " << e2->shape->type << " and distance: " << p.distance << " and solver: " << data->request.gjk_solver_type);
             // To avoid downstream issues, replace contact point with shape centre
-            if ((std::isnan(c1(0)) || std::isnan(c1(1)) || std::isnan(c1(2))) && p.e1->shape->type == shapes::ShapeType::SPHERE) c1 = p.e1->frame.p;
-            if ((std::isnan(c2(0)) || std::isnan(c2(1)) || std::isnan(c2(2))) && p.e2->shape->type == shapes::ShapeType::SPHERE) c2 = p.e1->frame.p;
+            if ((std::isnan(c1(0)) || std::isnan(c1(1)) || std::isnan(c1(2))) && e1->shape->type == shapes::ShapeType::SPHERE) c1 = e1->frame.p;
+            if ((std::isnan(c2(0)) || std::isnan(c2(1)) || std::isnan(c2(2))) && e2->shape->type == shapes::ShapeType::SPHERE) c2 = e1->frame.p;
         }
         else
         {
             // TODO(#277): Any other NaN is a serious issue which we should investigate separately, so display helpful error message:
             HIGHLIGHT_NAMED("ComputeDistance",
-                            "Contact1 between " << p.e1->segment.getName() << " and " << p.e2->segment.getName() << " contains NaN"
-                                                << ", where ShapeType1: " << p.e1->shape->type << " and ShapeType2: " << p.e2->shape->type << " and distance: " << p.distance << " and solver: " << data->request.gjk_solver_type);
+                            "Contact1 between " << e1->segment.getName() << " and " << e2->segment.getName() << " contains NaN"
+                                                << ", where ShapeType1: " << e1->shape->type << " and ShapeType2: " << e2->shape->type << " and distance: " << p.distance << " and solver: " << data->request.gjk_solver_type);
             HIGHLIGHT("c1:" << data->result.nearest_points[0](0) << "," << data->result.nearest_points[0](1) << "," << data->result.nearest_points[0](2));
             HIGHLIGHT("c2:" << data->result.nearest_points[1](0) << "," << data->result.nearest_points[1](1) << "," << data->result.nearest_points[1](2));
         }
@@ -511,8 +1385,8 @@ void CollisionSceneFCLLatest::ComputeDistance(fcl::CollisionObjectd* o1, fcl::Co
     // On touching contact, the normal would be ill-defined. Thus, use the shape centre of the opposite shape as a proxy contact.
     if (touching_contact)
     {
-        c1 = p.e2->frame.p;
-        c2 = p.e1->frame.p;
+        c1 = e2->frame.p;
+        c2 = e1->frame.p;
     }
 
     KDL::Vector n1 = c2 - c1;
@@ -523,31 +1397,55 @@ void CollisionSceneFCLLatest::ComputeDistance(fcl::CollisionObjectd* o1, fcl::Co
     p.normal2 = Eigen::Map<Eigen::Vector3d>(n2.data);
 
     data->Distance = std::min(data->Distance, p.distance);
-    data->proxies.push_back(p);
+    StoreProxy(data, index1, index2, p);
+    if (cache) cache->Update(o1, o2, p.distance);
+}
+
+void CollisionSceneFCLLatest::StoreProxy(DistanceData* data, long index1, long index2, CollisionProxy& proxy)
+{
+    if (data->buffer)
+    {
+        const CollisionSceneFCLLatest* scene = data->scene;
+        data->buffer->Append(scene->kinematic_element_handles_[index1], scene->kinematic_element_handles_[index2], proxy.contact1, proxy.normal1, proxy.contact2, proxy.normal2, proxy.distance);
+        return;
+    }
+    proxy.e1 = data->scene->kinematic_elements_[index1].lock();
+    proxy.e2 = data->scene->kinematic_elements_[index2].lock();
+    data->proxies.push_back(proxy);
 }
 
 bool CollisionSceneFCLLatest::CollisionCallbackDistance(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data, double& dist)
 {
     DistanceData* data_ = reinterpret_cast<DistanceData*>(data);
 
+    ++data_->statistics.num_broadphase_candidates;
     if (!IsAllowedToCollide(o1, o2, data_->self, data_->scene)) return false;
+
+    // The broadphase only descends into pairs of nodes whose AABBs are closer than dist
+    dist = std::min(dist, data_->check_margin);
+    if (o1->getAABB().distance(o2->getAABB()) >= data_->check_margin) return false;
+
     ComputeDistance(o1, o2, data_);
     return false;
 }
 
 bool CollisionSceneFCLLatest::IsStateValid(bool self, double safe_distance)
 {
+    EXOTICA_PROFILE_SCOPE("CollisionSceneFCLLatest::IsStateValid");
     if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
 
     CollisionData data(this);
     data.self = self;
     data.safe_distance = safe_distance;
-    broad_phase_collision_manager_->collide(&data, &CollisionSceneFCLLatest::CollisionCallback);
+    if (self) robot_broad_phase_collision_manager_->collide(&data, &CollisionSceneFCLLatest::CollisionCallback);
+    if (!data.result.isCollision()) robot_broad_phase_collision_manager_->collide(world_broad_phase_collision_manager_.get(), &data, &CollisionSceneFCLLatest::CollisionCallback);
+    AddStatistics(data.statistics);
     return !data.result.isCollision();
 }
 
 bool CollisionSceneFCLLatest::IsCollisionFree(const std::string& o1, const std::string& o2, double safe_distance)
 {
+    EXOTICA_PROFILE_SCOPE("CollisionSceneFCLLatest::IsCollisionFree");
     if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
 
     // TODO: Redo this logic using prior built maps
@@ -570,23 +1468,31 @@ bool CollisionSceneFCLLatest::IsCollisionFree(const std::string& o1, const std::
         for (fcl::CollisionObjectd* s2 : shapes2)
         {
             CheckCollision(s1, s2, &data);
-            if (data.result.isCollision()) return false;
+            if (data.result.isCollision())
+            {
+                AddStatistics(data.statistics);
+                return false;
+            }
         }
     }
+    AddStatistics(data.statistics);
     return true;
 }
 
-std::vector<CollisionProxy> CollisionSceneFCLLatest::GetCollisionDistance(bool self)
+std::vector<CollisionProxy> CollisionSceneFCLLatest::GetCollisionDistance(bool self, double check_margin)
 {
     if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
 
     DistanceData data(this);
     data.self = self;
-    broad_phase_collision_manager_->distance(&data, &CollisionSceneFCLLatest::CollisionCallbackDistance);
+    data.check_margin = check_margin;
+    if (self) robot_broad_phase_collision_manager_->distance(&data, &CollisionSceneFCLLatest::CollisionCallbackDistance);
+    robot_broad_phase_collision_manager_->distance(world_broad_phase_collision_manager_.get(), &data, &CollisionSceneFCLLatest::CollisionCallbackDistance);
+    AddStatistics(data.statistics);
     return data.proxies;
 }
 
-std::vector<CollisionProxy> CollisionSceneFCLLatest::GetCollisionDistance(const std::string& o1, const std::string& o2)
+std::vector<CollisionProxy> CollisionSceneFCLLatest::GetCollisionDistance(const std::string& o1, const std::string& o2, double check_margin)
 {
     if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
 
@@ -608,9 +1514,12 @@ std::vector<CollisionProxy> CollisionSceneFCLLatest::GetCollisionDistance(const
     {
         for (fcl::CollisionObjectd* s2 : shapes2)
         {
+            if (s1->getAABB().distance(s2->getAABB()) >= check_margin) continue;
+            ++data.statistics.num_broadphase_candidates;
             ComputeDistance(s1, s2, &data);
         }
     }
+    AddStatistics(data.statistics);
     return data.proxies;
 }
 
@@ -620,7 +1529,7 @@ std::vector<CollisionProxy> CollisionSceneFCLLatest::GetCollisionDistance(const
 }
 
 std::vector<CollisionProxy> CollisionSceneFCLLatest::GetCollisionDistance(
-    const std::string& o1, const bool& self, const bool& disable_collision_scene_update)
+    const std::string& o1, const bool& self, const bool& disable_collision_scene_update, double check_margin)
 {
     if (!always_externally_updated_collision_scene_ && !disable_collision_scene_update) UpdateCollisionObjectTransforms();
 
@@ -668,32 +1577,80 @@ std::vector<CollisionProxy> CollisionSceneFCLLatest::GetCollisionDistance(
     {
         for (fcl::CollisionObjectd* s2 : shapes2)
         {
+            if (s1->getAABB().distance(s2->getAABB()) >= check_margin) continue;
+            ++data.statistics.num_broadphase_candidates;
             ComputeDistance(s1, s2, &data);
         }
     }
+    AddStatistics(data.statistics);
     return data.proxies;
 }
 
-std::vector<CollisionProxy> CollisionSceneFCLLatest::GetCollisionDistance(const std::vector<std::string>& objects, const bool& self)
+std::vector<CollisionProxy> CollisionSceneFCLLatest::GetCollisionDistance(const std::vector<std::string>& objects, const bool& self, double check_margin)
+{
+    if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
+
+    std::vector<CollisionProxy> proxies;
+    for (const auto& o1 : objects)
+        AppendVector(proxies, GetCollisionDistance(o1, self, true, check_margin));
+
+    return proxies;
+}
+
+std::vector<CollisionProxy> CollisionSceneFCLLatest::GetRobotToRobotCollisionDistance(double check_margin)
+{
+    std::vector<DistanceQuery> queries;
+    AddRobotToRobotDistanceQueries(check_margin, queries);
+    std::vector<CollisionProxy> proxies;
+    ComputeDistances(queries, true, &proxies);
+    return proxies;
+}
+
+std::vector<CollisionProxy> CollisionSceneFCLLatest::GetRobotToWorldCollisionDistance(double check_margin)
+{
+    std::vector<DistanceQuery> queries;
+    AddRobotToWorldDistanceQueries(check_margin, queries);
+    std::vector<CollisionProxy> proxies;
+    ComputeDistances(queries, false, &proxies);
+    return proxies;
+}
+
+void CollisionSceneFCLLatest::GetCollisionDistance(bool self, double check_margin, CollisionProxyBuffer& proxies)
 {
     if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
 
-    std::vector<CollisionProxy> proxies;
-    for (const auto& o1 : objects)
-        AppendVector(proxies, GetCollisionDistance(o1, self, true));
+    proxies.Clear();
+    DistanceData data(this);
+    data.self = self;
+    data.check_margin = check_margin;
+    data.buffer = &proxies;
+    if (self) robot_broad_phase_collision_manager_->distance(&data, &CollisionSceneFCLLatest::CollisionCallbackDistance);
+    robot_broad_phase_collision_manager_->distance(world_broad_phase_collision_manager_.get(), &data, &CollisionSceneFCLLatest::CollisionCallbackDistance);
+    AddStatistics(data.statistics);
+}
 
-    return proxies;
+void CollisionSceneFCLLatest::GetRobotToRobotCollisionDistance(double check_margin, CollisionProxyBuffer& proxies)
+{
+    proxies.Clear();
+    distance_queries_.clear();
+    AddRobotToRobotDistanceQueries(check_margin, distance_queries_);
+    ComputeDistances(distance_queries_, true, nullptr, &proxies);
 }
 
-std::vector<CollisionProxy> CollisionSceneFCLLatest::GetRobotToRobotCollisionDistance(double check_margin)
+void CollisionSceneFCLLatest::GetRobotToWorldCollisionDistance(double check_margin, CollisionProxyBuffer& proxies)
 {
-    DistanceData data(this);
-    data.self = true;
+    proxies.Clear();
+    distance_queries_.clear();
+    AddRobotToWorldDistanceQueries(check_margin, distance_queries_);
+    ComputeDistances(distance_queries_, false, nullptr, &proxies);
+}
 
+void CollisionSceneFCLLatest::AddRobotToRobotDistanceQueries(double check_margin, std::vector<DistanceQuery>& queries)
+{
     // For each robot collision object to each robot collision object
-    for (auto it1 : fcl_robot_objects_map_)
+    for (const auto& it1 : fcl_robot_objects_map_)
     {
-        for (auto it2 : fcl_robot_objects_map_)
+        for (const auto& it2 : fcl_robot_objects_map_)
         {
             if (IsAllowedToCollide(it1.first, it2.first, true))
             {
@@ -702,28 +1659,20 @@ std::vector<CollisionProxy> CollisionSceneFCLLatest::GetRobotToRobotCollisionDis
                 {
                     for (auto o2 : it2.second)
                     {
-                        // Check whether the AABB is less than the check_margin, if so, perform a collision distance call
-                        if (o1->getAABB().distance(o2->getAABB()) < check_margin)
-                        {
-                            ComputeDistance(o1, o2, &data);
-                        }
+                        AddDistanceQuery(o1, o2, check_margin, queries);
                     }
                 }
             }
         }
     }
-    return data.proxies;
 }
 
-std::vector<CollisionProxy> CollisionSceneFCLLatest::GetRobotToWorldCollisionDistance(double check_margin)
+void CollisionSceneFCLLatest::AddRobotToWorldDistanceQueries(double check_margin, std::vector<DistanceQuery>& queries)
 {
-    DistanceData data(this);
-    data.self = false;
-
-    // For each robot collision object to each robot collision object
-    for (auto it1 : fcl_robot_objects_map_)
+    // For each robot collision object to each world collision object
+    for (const auto& it1 : fcl_robot_objects_map_)
     {
-        for (auto it2 : fcl_world_objects_map_)
+        for (const auto& it2 : fcl_world_objects_map_)
         {
             if (IsAllowedToCollide(it1.first, it2.first, false))
             {
@@ -732,17 +1681,74 @@ std::vector<CollisionProxy> CollisionSceneFCLLatest::GetRobotToWorldCollisionDis
                 {
                     for (auto o2 : it2.second)
                     {
-                        // Check whether the AABB is less than the check_margin, if so, perform a collision distance call
-                        if (o1->getAABB().distance(o2->getAABB()) < check_margin)
-                        {
-                            ComputeDistance(o1, o2, &data);
-                        }
+                        AddDistanceQuery(o1, o2, check_margin, queries);
                     }
                 }
             }
         }
     }
-    return data.proxies;
+}
+
+void CollisionSceneFCLLatest::AddDistanceQuery(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, double check_margin, std::vector<DistanceQuery>& queries)
+{
+    // Check whether the AABB is less than the check_margin, if so, perform a collision distance call
+    if (o1->getAABB().distance(o2->getAABB()) >= check_margin) return;
+    if (collect_statistics_) ++statistics_.num_broadphase_candidates;
+
+    DistanceCacheEntry* cache = nullptr;
+    if (use_distance_cache_)
+    {
+        // The entries are created here, so that the distance queries (possibly in parallel) only write to their own entry
+        cache = &distance_caches_[distance_cache_slot_][GetDistanceCacheKey(o1, o2)];
+        if (cache->valid && cache->LowerBound(o1, o2) >= check_margin) return;
+    }
+    queries.push_back({o1, o2, cache});
+}
+
+// The pairs are independent. Each thread works on a contiguous block of pairs with its own DistanceData,
+// and the blocks are merged in order, hence the proxies are the same as when computed serially.
+void CollisionSceneFCLLatest::ComputeDistances(const std::vector<DistanceQuery>& queries, bool self, std::vector<CollisionProxy>* proxies, CollisionProxyBuffer* buffer)
+{
+    EXOTICA_PROFILE_SCOPE("CollisionSceneFCLLatest::ComputeDistances");
+    const int num_pairs = static_cast<int>(queries.size());
+    const int num_threads = std::max(1, std::min(num_threads_, num_pairs));
+    if (num_threads == 1 || num_pairs < parallel_threshold_)
+    {
+        DistanceData data(this);
+        data.self = self;
+        data.buffer = buffer;
+        for (const DistanceQuery& query : queries) ComputeDistance(query.o1, query.o2, &data, query.cache);
+        AddStatistics(data.statistics);
+        if (proxies) *proxies = std::move(data.proxies);
+        return;
+    }
+
+    std::vector<DistanceData> thread_data(num_threads, DistanceData(this));
+    if (buffer && static_cast<int>(thread_proxy_buffers_.size()) < num_threads) thread_proxy_buffers_.resize(num_threads);
+    for (int thread = 0; thread < num_threads; ++thread)
+    {
+        thread_data[thread].self = self;
+        if (buffer)
+        {
+            thread_data[thread].buffer = &thread_proxy_buffers_[thread];
+            thread_data[thread].buffer->Clear();
+        }
+    }
+    ParallelLoop(num_threads, num_pairs, [&](int thread, int i) { ComputeDistance(queries[i].o1, queries[i].o2, &thread_data[thread], queries[i].cache); });
+
+    if (proxies)
+    {
+        proxies->clear();
+        proxies->reserve(num_pairs);
+    }
+    for (int i = 0; i < num_threads; ++i)
+    {
+        if (buffer)
+            buffer->Append(thread_proxy_buffers_[i]);
+        else if (proxies)
+            proxies->insert(proxies->end(), thread_data[i].proxies.begin(), thread_data[i].proxies.end());
+        AddStatistics(thread_data[i].statistics);
+    }
 }
 
 Eigen::Vector3d CollisionSceneFCLLatest::GetTranslation(const std::string& name)
@@ -761,10 +1767,39 @@ std::vector<std::string> CollisionSceneFCLLatest::GetCollisionRobotLinks()
     return GetKeysFromMap(fcl_robot_objects_map_);
 }
 
+fcl::ContinuousCollisionRequestd CollisionSceneFCLLatest::GetContinuousCollisionRequest(const fcl::CollisionObjectd* o1, const fcl::CollisionObjectd* o2)
+{
+    fcl::ContinuousCollisionRequestd request = fcl::ContinuousCollisionRequestd();
+
+#ifdef CONTINUOUS_COLLISION_USE_ADVANCED_SETTINGS
+    request.num_max_iterations = 100;  // default 10
+    request.toc_err = 1e-5;            // default 1e-4
+
+    // GST_LIBCCD, GST_INDEP
+    // request.gjk_solver_type = fcl::GST_INDEP;
+
+    // CCDM_TRANS, CCDM_LINEAR, CCDM_SCREW, CCDM_SPLINE
+    request.ccd_motion_type = fcl::CCDMotionType::CCDM_SCREW;
+
+    // CCDC_NAIVE, CCDC_CONSERVATIVE_ADVANCEMENT, CCDC_RAY_SHOOTING, CCDC_POLYNOMIAL_SOLVER
+    // As of 2018-06-27, only CCDC_NAIVE appears to work reliably on both primitives and meshes.
+    // Cf. https://github.com/flexible-collision-library/fcl/issues/120
+    request.ccd_solver_type = fcl::CCDC_NAIVE;
+
+    // If both are primitives, let's use conservative advancement
+    if (o1->getObjectType() == fcl::OBJECT_TYPE::OT_GEOM && o2->getObjectType() == fcl::OBJECT_TYPE::OT_GEOM)
+    {
+        request.ccd_solver_type = fcl::CCDC_CONSERVATIVE_ADVANCEMENT;
+    }
+#endif
+    return request;
+}
+
 ContinuousCollisionProxy CollisionSceneFCLLatest::ContinuousCollisionCheck(
     const std::string& o1, const KDL::Frame& tf1_beg, const KDL::Frame& tf1_end,
     const std::string& o2, const KDL::Frame& tf2_beg, const KDL::Frame& tf2_end)
 {
+    EXOTICA_PROFILE_SCOPE("CollisionSceneFCLLatest::ContinuousCollisionCheck");
     ContinuousCollisionProxy ret;
 
     if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
@@ -853,29 +1888,7 @@ ContinuousCollisionProxy CollisionSceneFCLLatest::ContinuousCollisionCheck(
     //     HIGHLIGHT("Yeah, no motion here.");
     // }
 
-    fcl::ContinuousCollisionRequestd request = fcl::ContinuousCollisionRequestd();
-
-#ifdef CONTINUOUS_COLLISION_USE_ADVANCED_SETTINGS
-    request.num_max_iterations = 100;  // default 10
-    request.toc_err = 1e-5;            // default 1e-4
-
-    // GST_LIBCCD, GST_INDEP
-    // request.gjk_solver_type = fcl::GST_INDEP;
-
-    // CCDM_TRANS, CCDM_LINEAR, CCDM_SCREW, CCDM_SPLINE
-    request.ccd_motion_type = fcl::CCDMotionType::CCDM_SCREW;
-
-    // CCDC_NAIVE, CCDC_CONSERVATIVE_ADVANCEMENT, CCDC_RAY_SHOOTING, CCDC_POLYNOMIAL_SOLVER
-    // As of 2018-06-27, only CCDC_NAIVE appears to work reliably on both primitives and meshes.
-    // Cf. https://github.com/flexible-collision-library/fcl/issues/120
-    request.ccd_solver_type = fcl::CCDC_NAIVE;
-
-    // If both are primitives, let's use conservative advancement
-    if (shape1->getObjectType() == fcl::OBJECT_TYPE::OT_GEOM && shape2->getObjectType() == fcl::OBJECT_TYPE::OT_GEOM)
-    {
-        request.ccd_solver_type = fcl::CCDC_CONSERVATIVE_ADVANCEMENT;
-    }
-#endif
+    const fcl::ContinuousCollisionRequestd request = GetContinuousCollisionRequest(shape1, shape2);
 
     fcl::ContinuousCollisionResultd result;
     double time_of_contact = fcl::continuousCollide(
@@ -989,4 +2002,507 @@ ContinuousCollisionProxy CollisionSceneFCLLatest::ContinuousCollisionCheck(
 
     return ret;
 }
+
+std::vector<ContinuousCollisionProxy> CollisionSceneFCLLatest::ContinuousCollisionCheckTrajectory(Eigen::MatrixXdRefConst trajectory, bool self)
+{
+    EXOTICA_PROFILE_SCOPE("CollisionSceneFCLLatest::ContinuousCollisionCheckTrajectory");
+    if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
+
+    const int num_states = static_cast<int>(trajectory.rows());
+    const int num_segments = std::max(0, num_states - 1);
+
+    // World frames of all elements for all states, computed in one pass over the tree
+    KinematicWorkspace workspace;
+    scene_.lock()->GetKinematicTree().UpdateBatchFrames(trajectory.transpose(), workspace);
+
+    // The motion of an object during a segment is bounded by a sphere around the midpoint of the path of its origin,
+    // see the bounding sphere of each pair below
+    struct TrajectoryObject
+    {
+        fcl::CollisionObjectd* object;
+        std::shared_ptr<KinematicElement> element;
+        int output;                ///< Index of the robot collision object in the result, -1 for world objects
+        const KDL::Frame* frames;  ///< Frames of the element for each state, nullptr for world objects
+        double extent;             ///< Upper bound on the distance of any point of the object from its origin
+    };
+
+    const std::vector<std::string> robot_links = GetCollisionRobotLinks();
+    std::vector<TrajectoryObject> robot_objects, world_objects;
+    for (std::size_t i = 0; i < robot_links.size(); ++i)
+    {
+        for (fcl::CollisionObjectd* object : fcl_robot_objects_map_[robot_links[i]])
+        {
+            std::shared_ptr<KinematicElement> element = kinematic_elements_[reinterpret_cast<long>(object->getUserData())].lock();
+            if (!element) ThrowPretty("Expired pointer, this should not happen - make sure to call UpdateCollisionObjects() after UpdateSceneFrames()");
+            const int index = workspace.index[element->id + 1];
+            if (index < 0) ThrowPretty("Robot collision object " << robot_links[i] << " is not part of the kinematic tree.");
+            const fcl::CollisionGeometryd& geometry = *object->collisionGeometry();
+            robot_objects.push_back({object, element, static_cast<int>(i), &workspace.frames[index * num_states], geometry.aabb_center.norm() + geometry.aabb_radius});
+        }
+    }
+    for (const auto& world_object : fcl_world_objects_map_)
+    {
+        for (fcl::CollisionObjectd* object : world_object.second)
+        {
+            const fcl::CollisionGeometryd& geometry = *object->collisionGeometry();
+            world_objects.push_back({object, kinematic_elements_[reinterpret_cast<long>(object->getUserData())].lock(), -1, nullptr, geometry.aabb_center.norm() + geometry.aabb_radius});
+        }
+    }
+
+    // Pairs of a robot object and a world object, or of two robot objects
+    std::vector<std::pair<const TrajectoryObject*, const TrajectoryObject*>> pairs;
+    for (const TrajectoryObject& robot_object : robot_objects)
+    {
+        for (const TrajectoryObject& world_object : world_objects)
+        {
+            if (IsAllowedToCollide(robot_object.object, world_object.object, false, this)) pairs.emplace_back(&robot_object, &world_object);
+        }
+    }
+    if (self)
+    {
+        for (std::size_t i = 0; i < robot_objects.size(); ++i)
+        {
+            for (std::size_t j = i + 1; j < robot_objects.size(); ++j)
+            {
+                if (IsAllowedToCollide(robot_objects[i].object, robot_objects[j].object, true, this)) pairs.emplace_back(&robot_objects[i], &robot_objects[j]);
+            }
+        }
+    }
+
+    std::vector<ContinuousCollisionProxy> initial(robot_links.size());
+    for (const TrajectoryObject& robot_object : robot_objects)
+    {
+        // Links without contact report their first shape, links with contact the shape that hit first
+        if (!initial[robot_object.output].e1) initial[robot_object.output].e1 = robot_object.element;
+        initial[robot_object.output].time_of_contact = std::max(0, num_states - 1);
+    }
+
+    // Checks the segments [begin, end) in order and records the earliest contact of each robot object in ret.
+    const auto check_segments = [&](int begin, int end, std::vector<ContinuousCollisionProxy>& ret) {
+        for (int t = begin; t < end; ++t)
+        {
+            for (const auto& pair : pairs)
+            {
+                const TrajectoryObject& o1 = *pair.first;
+                const TrajectoryObject& o2 = *pair.second;
+                ContinuousCollisionProxy& proxy1 = ret[o1.output];
+                // Skip pairs whose objects already have an earlier contact
+                if (proxy1.time_of_contact <= t && (o2.output == -1 || ret[o2.output].time_of_contact <= t)) continue;
+
+                const fcl::Transform3d tf1_beg = transformKDLToFCL(o1.frames[t]);
+                const fcl::Transform3d tf1_end = transformKDLToFCL(o1.frames[t + 1]);
+                const fcl::Transform3d tf2_beg = o2.frames ? transformKDLToFCL(o2.frames[t]) : o2.object->getTransform();
+                const fcl::Transform3d tf2_end = o2.frames ? transformKDLToFCL(o2.frames[t + 1]) : o2.object->getTransform();
+
+                // Every point of an object stays within half the distance travelled by its origin plus twice its extent of the midpoint of that path
+                const double radius1 = 0.5 * (tf1_end.translation() - tf1_beg.translation()).norm() + 2.0 * o1.extent;
+                const double radius2 = 0.5 * (tf2_end.translation() - tf2_beg.translation()).norm() + 2.0 * o2.extent;
+                if ((tf1_beg.translation() + tf1_end.translation() - tf2_beg.translation() - tf2_end.translation()).norm() * 0.5 > radius1 + radius2) continue;
+
+                fcl::ContinuousCollisionResultd result;
+                fcl::continuousCollide(o1.object->collisionGeometry().get(), tf1_beg, tf1_end, o2.object->collisionGeometry().get(), tf2_beg, tf2_end, GetContinuousCollisionRequest(o1.object, o2.object), result);
+                if (!result.is_collide) continue;
+
+                const double time_of_contact = t + result.time_of_contact;
+                if (time_of_contact < proxy1.time_of_contact || !proxy1.in_collision)
+                {
+                    proxy1.e1 = o1.element;
+                    proxy1.e2 = o2.element;
+                    proxy1.in_collision = true;
+                    proxy1.time_of_contact = time_of_contact;
+                    transformFCLToKDL(result.contact_tf1, proxy1.contact_tf1);
+                    transformFCLToKDL(result.contact_tf2, proxy1.contact_tf2);
+                }
+                if (o2.output != -1)
+                {
+                    ContinuousCollisionProxy& proxy2 = ret[o2.output];
+                    if (time_of_contact < proxy2.time_of_contact || !proxy2.in_collision)
+                    {
+                        proxy2.e1 = o2.element;
+                        proxy2.e2 = o1.element;
+                        proxy2.in_collision = true;
+                        proxy2.time_of_contact = time_of_contact;
+                        transformFCLToKDL(result.contact_tf2, proxy2.contact_tf1);
+                        transformFCLToKDL(result.contact_tf1, proxy2.contact_tf2);
+                    }
+                }
+            }
+        }
+    };
+
+    const int num_threads = std::max(1, std::min(num_threads_, num_segments));
+    if (num_threads == 1 || static_cast<long>(num_segments) * pairs.size() < static_cast<std::size_t>(parallel_threshold_))
+    {
+        std::vector<ContinuousCollisionProxy> ret = initial;
+        check_segments(0, num_segments, ret);
+        return ret;
+    }
+
+    // Each thread checks a contiguous block of segments, the earliest contacts are merged afterwards
+    std::vector<std::vector<ContinuousCollisionProxy>> thread_results(num_threads, initial);
+    ParallelLoop(num_threads, num_segments, [&](int thread, int t) { check_segments(t, t + 1, thread_results[thread]); });
+
+    std::vector<ContinuousCollisionProxy> ret = initial;
+    for (int i = 0; i < num_threads; ++i)
+    {
+        for (std::size_t j = 0; j < ret.size(); ++j)
+        {
+            if (thread_results[i][j].in_collision && (!ret[j].in_collision || thread_results[i][j].time_of_contact < ret[j].time_of_contact)) ret[j] = thread_results[i][j];
+        }
+    }
+    return ret;
+}
+namespace
+{
+constexpr double kNoHit = std::numeric_limits<double>::infinity();
+
+// Ray queries in the frame of a shape. The ray is o + t * d with t in [0, t_max], d normalised.
+// Each function returns the smallest such t at which the ray is inside or on the shape, kNoHit if there is none.
+
+// Smallest root in [0, t_max] of a * t^2 + b * t + c whose point satisfies accept
+template <typename Accept>
+double SmallestRoot(double a, double b, double c, double t_max, const Accept& accept)
+{
+    double roots[2];
+    int num_roots = 0;
+    if (std::abs(a) < 1e-12)
+    {
+        if (std::abs(b) < 1e-12) return kNoHit;
+        roots[num_roots++] = -c / b;
+    }
+    else
+    {
+        const double discriminant = b * b - 4.0 * a * c;
+        if (discriminant < 0.0) return kNoHit;
+        const double sqrt_discriminant = std::sqrt(discriminant);
+        roots[num_roots++] = (-b - std::copysign(sqrt_discriminant, a)) / (2.0 * a);
+        roots[num_roots++] = (-b + std::copysign(sqrt_discriminant, a)) / (2.0 * a);
+    }
+    for (int i = 0; i < num_roots; ++i)
+    {
+        if (roots[i] >= 0.0 && roots[i] <= t_max && accept(roots[i])) return roots[i];
+    }
+    return kNoHit;
+}
+
+double RayCastSphere(const Eigen::Vector3d& o, const Eigen::Vector3d& d, double radius, double t_max)
+{
+    const double c = o.squaredNorm() - radius * radius;
+    if (c <= 0.0) return 0.0;
+    return SmallestRoot(1.0, 2.0 * o.dot(d), c, t_max, [](double) { return true; });
+}
+
+// Slab test against the axis-aligned box [lower, upper], optionally returns where the ray leaves the box in t_exit_out
+double RayCastBox(const Eigen::Vector3d& o, const Eigen::Vector3d& d, const Eigen::Vector3d& lower, const Eigen::Vector3d& upper, double t_max, double* t_exit_out = nullptr)
+{
+    double t_enter = 0.0;
+    double t_exit = t_max;
+    for (int i = 0; i < 3; ++i)
+    {
+        if (std::abs(d(i)) < 1e-12)
+        {
+            if (o(i) < lower(i) || o(i) > upper(i)) return kNoHit;
+            continue;
+        }
+        double t1 = (lower(i) - o(i)) / d(i);
+        double t2 = (upper(i) - o(i)) / d(i);
+        if (t1 > t2) std::swap(t1, t2);
+        t_enter = std::max(t_enter, t1);
+        t_exit = std::min(t_exit, t2);
+        if (t_enter > t_exit) return kNoHit;
+    }
+    if (t_exit_out != nullptr) *t_exit_out = t_exit;
+    return t_enter;
+}
+
+// Cylinder of the given radius along the z-axis, from -half_length to half_length
+double RayCastCylinder(const Eigen::Vector3d& o, const Eigen::Vector3d& d, double radius, double half_length, double t_max)
+{
+    const double r2 = radius * radius;
+    if (std::abs(o.z()) <= half_length && o.x() * o.x() + o.y() * o.y() <= r2) return 0.0;
+
+    double t = SmallestRoot(d.x() * d.x() + d.y() * d.y(), 2.0 * (o.x() * d.x() + o.y() * d.y()), o.x() * o.x() + o.y() * o.y() - r2, t_max,
+                            [&](double t) { return std::abs(o.z() + t * d.z()) <= half_length; });
+    if (std::abs(d.z()) > 1e-12)
+    {
+        for (const double z : {-half_length, half_length})
+        {
+            const double t_cap = (z - o.z()) / d.z();
+            if (t_cap < 0.0 || t_cap > t_max || t_cap >= t) continue;
+            const Eigen::Vector3d p = o + t_cap * d;
+            if (p.x() * p.x() + p.y() * p.y() <= r2) t = t_cap;
+        }
+    }
+    return t;
+}
+
+// Capsule of the given radius around the segment along the z-axis from -half_length to half_length
+double RayCastCapsule(const Eigen::Vector3d& o, const Eigen::Vector3d& d, double radius, double half_length, double t_max)
+{
+    double t = SmallestRoot(d.x() * d.x() + d.y() * d.y(), 2.0 * (o.x() * d.x() + o.y() * d.y()), o.x() * o.x() + o.y() * o.y() - radius * radius, t_max,
+                            [&](double t) { return std::abs(o.z() + t * d.z()) <= half_length; });
+    for (const double z : {-half_length, half_length})
+    {
+        t = std::min(t, RayCastSphere(o - Eigen::Vector3d(0.0, 0.0, z), d, radius, t_max));
+    }
+    // Inside the cylindrical part
+    if (std::abs(o.z()) <= half_length && o.x() * o.x() + o.y() * o.y() <= radius * radius) return 0.0;
+    return t;
+}
+
+// Cone with the given base radius along the z-axis, with its base at -half_length and its apex at half_length
+double RayCastCone(const Eigen::Vector3d& o, const Eigen::Vector3d& d, double radius, double half_length, double t_max)
+{
+    // The radius at height z is k * (half_length - z)
+    const double k = radius / (2.0 * half_length);
+    const auto radius_at = [&](double z) { return k * (half_length - z); };
+    if (std::abs(o.z()) <= half_length && std::sqrt(o.x() * o.x() + o.y() * o.y()) <= radius_at(o.z())) return 0.0;
+
+    const double h = half_length - o.z();
+    double t = SmallestRoot(d.x() * d.x() + d.y() * d.y() - k * k * d.z() * d.z(), 2.0 * (o.x() * d.x() + o.y() * d.y() + k * k * h * d.z()), o.x() * o.x() + o.y() * o.y() - k * k * h * h, t_max,
+                            [&](double t) { return std::abs(o.z() + t * d.z()) <= half_length; });
+    if (std::abs(d.z()) > 1e-12)
+    {
+        const double t_base = (-half_length - o.z()) / d.z();
+        if (t_base >= 0.0 && t_base <= t_max && t_base < t)
+        {
+            const Eigen::Vector3d p = o + t_base * d;
+            if (p.x() * p.x() + p.y() * p.y() <= radius * radius) t = t_base;
+        }
+    }
+    return t;
+}
+
+// Möller-Trumbore intersection with a triangle, from either side
+double RayCastTriangle(const Eigen::Vector3d& o, const Eigen::Vector3d& d, const Eigen::Vector3d& a, const Eigen::Vector3d& b, const Eigen::Vector3d& c, double t_max)
+{
+    const Eigen::Vector3d edge1 = b - a;
+    const Eigen::Vector3d edge2 = c - a;
+    const Eigen::Vector3d p = d.cross(edge2);
+    const double det = edge1.dot(p);
+    if (std::abs(det) < 1e-12) return kNoHit;
+    const Eigen::Vector3d s = o - a;
+    const double u = s.dot(p) / det;
+    if (u < 0.0 || u > 1.0) return kNoHit;
+    const Eigen::Vector3d q = s.cross(edge1);
+    const double v = d.dot(q) / det;
+    if (v < 0.0 || u + v > 1.0) return kNoHit;
+    const double t = edge2.dot(q) / det;
+    return (t >= 0.0 && t <= t_max) ? t : kNoHit;
+}
+
+// Traverses the OBBs of the BVH and intersects the triangles of the leaves it reaches
+double RayCastMesh(const fcl::BVHModel<fcl::OBBRSSd>& model, const Eigen::Vector3d& o, const Eigen::Vector3d& d, double t_max)
+{
+    if (model.getModelType() != fcl::BVH_MODEL_TRIANGLES || model.getNumBVs() == 0) return kNoHit;
+    double t = kNoHit;
+    std::vector<int> stack(1, 0);
+    while (!stack.empty())
+    {
+        const fcl::BVNode<fcl::OBBRSSd>& node = model.getBV(stack.back());
+        stack.pop_back();
+        const fcl::OBBd& obb = node.bv.obb;
+        if (RayCastBox(obb.axis.transpose() * (o - obb.To), obb.axis.transpose() * d, -obb.extent, obb.extent, std::min(t, t_max)) == kNoHit) continue;
+
+        if (node.isLeaf())
+        {
+            const fcl::Triangle& triangle = model.tri_indices[node.primitiveId()];
+            t = std::min(t, RayCastTriangle(o, d, model.vertices[triangle[0]], model.vertices[triangle[1]], model.vertices[triangle[2]], std::min(t, t_max)));
+        }
+        else
+        {
+            stack.push_back(node.leftChild());
+            stack.push_back(node.rightChild());
+        }
+    }
+    return t;
+}
+
+// Intersects the faces of the convex hull, each face is stored as its number of vertices followed by their indices
+double RayCastConvex(const fcl::Convexd& convex, const Eigen::Vector3d& o, const Eigen::Vector3d& d, double t_max)
+{
+    const std::vector<fcl::Vector3d>& vertices = *convex.getVertices();
+    const std::vector<int>& faces = *convex.getFaces();
+    double t = kNoHit;
+    for (std::size_t i = 0; i < faces.size(); i += faces[i] + 1)
+    {
+        for (int j = 2; j < faces[i]; ++j)
+        {
+            t = std::min(t, RayCastTriangle(o, d, vertices[faces[i + 1]], vertices[faces[i + j]], vertices[faces[i + j + 1]], std::min(t, t_max)));
+        }
+    }
+    return t;
+}
+
+// Traverses the occupied nodes of the octree, whose leaves are treated as boxes
+double RayCastOcTree(const fcl::OcTreed& tree, const Eigen::Vector3d& o, const Eigen::Vector3d& d, double t_max)
+{
+    if (tree.getRoot() == nullptr) return kNoHit;
+    double t = kNoHit;
+    std::vector<std::pair<const fcl::OcTreed::OcTreeNode*, fcl::AABBd>> stack(1, std::make_pair(tree.getRoot(), tree.getRootBV()));
+    while (!stack.empty())
+    {
+        const fcl::OcTreed::OcTreeNode* node = stack.back().first;
+        const fcl::AABBd bv = stack.back().second;
+        stack.pop_back();
+        if (!tree.isNodeOccupied(node)) continue;
+        const double t_node = RayCastBox(o, d, bv.min_, bv.max_, std::min(t, t_max));
+        if (t_node == kNoHit) continue;
+
+        if (!tree.nodeHasChildren(node))
+        {
+            t = std::min(t, t_node);
+            continue;
+        }
+
+        // Children are ordered by the bits x, y, z of their index as in octomap
+        const Eigen::Vector3d center = bv.center();
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            if (!tree.nodeChildExists(node, i)) continue;
+            fcl::AABBd child_bv;
+            for (int k = 0; k < 3; ++k)
+            {
+                child_bv.min_(k) = (i & (1 << k)) ? center(k) : bv.min_(k);
+                child_bv.max_(k) = (i & (1 << k)) ? bv.max_(k) : center(k);
+            }
+            stack.emplace_back(tree.getNodeChild(node, i), child_bv);
+        }
+    }
+    return t;
+}
+
+// Casts the ray, given in the world frame, against the geometry of the object
+double RayCastObject(const fcl::CollisionObjectd* object, const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, double t_max)
+{
+    const fcl::Transform3d& transform = object->getTransform();
+    const Eigen::Matrix3d rotation_transpose = transform.linear().transpose();
+    const Eigen::Vector3d o = rotation_transpose * (origin - transform.translation());
+    const Eigen::Vector3d d = rotation_transpose * direction;
+    const fcl::CollisionGeometryd* geometry = object->collisionGeometry().get();
+    switch (geometry->getNodeType())
+    {
+        case fcl::GEOM_SPHERE:
+            return RayCastSphere(o, d, static_cast<const fcl::Sphered*>(geometry)->radius, t_max);
+        case fcl::GEOM_BOX:
+        {
+            const Eigen::Vector3d half_side = 0.5 * static_cast<const fcl::Boxd*>(geometry)->side;
+            return RayCastBox(o, d, -half_side, half_side, t_max);
+        }
+        case fcl::GEOM_CYLINDER:
+        {
+            const fcl::Cylinderd* cylinder = static_cast<const fcl::Cylinderd*>(geometry);
+            return RayCastCylinder(o, d, cylinder->radius, 0.5 * cylinder->lz, t_max);
+        }
+        case fcl::GEOM_CAPSULE:
+        {
+            const fcl::Capsuled* capsule = static_cast<const fcl::Capsuled*>(geometry);
+            return RayCastCapsule(o, d, capsule->radius, 0.5 * capsule->lz, t_max);
+        }
+        case fcl::GEOM_CONE:
+        {
+            const fcl::Coned* cone = static_cast<const fcl::Coned*>(geometry);
+            return RayCastCone(o, d, cone->radius, 0.5 * cone->lz, t_max);
+        }
+        case fcl::GEOM_PLANE:
+        {
+            const fcl::Planed* plane = static_cast<const fcl::Planed*>(geometry);
+            const double signed_distance = plane->n.dot(o) - plane->d;
+            if (std::abs(signed_distance) < 1e-12) return 0.0;
+            if (std::abs(plane->n.dot(d)) < 1e-12) return kNoHit;
+            const double t = -signed_distance / plane->n.dot(d);
+            return (t >= 0.0 && t <= t_max) ? t : kNoHit;
+        }
+        case fcl::GEOM_CONVEX:
+            return RayCastConvex(*static_cast<const fcl::Convexd*>(geometry), o, d, t_max);
+        case fcl::BV_OBBRSS:
+            return RayCastMesh(*static_cast<const fcl::BVHModel<fcl::OBBRSSd>*>(geometry), o, d, t_max);
+        case fcl::GEOM_OCTREE:
+            return RayCastOcTree(*static_cast<const fcl::OcTreed*>(geometry), o, d, t_max);
+        default:
+            // Conservative for any other geometry
+            return RayCastBox(origin, direction, object->getAABB().min_, object->getAABB().max_, t_max);
+    }
+}
+
+struct RayCastData
+{
+    const fcl::CollisionObjectd* query;
+    Eigen::Vector3d origin;
+    Eigen::Vector3d direction;
+    double max_distance;
+    double distance;
+};
+
+// Called by the broadphase for every world object whose AABB overlaps the AABB of the ray
+bool RayCastCallback(fcl::CollisionObjectd* o1, fcl::CollisionObjectd* o2, void* data)
+{
+    RayCastData* ray = reinterpret_cast<RayCastData*>(data);
+    const fcl::CollisionObjectd* object = o1 == ray->query ? o2 : o1;
+    ray->distance = std::min(ray->distance, RayCastObject(object, ray->origin, ray->direction, std::min(ray->distance, ray->max_distance)));
+    return ray->distance == 0.0;
+}
+}  // namespace
+
+Eigen::VectorXd CollisionSceneFCLLatest::RayCast(const Eigen::Ref<const Eigen::Matrix3Xd>& origins, const Eigen::Ref<const Eigen::Matrix3Xd>& directions, double max_distance)
+{
+    EXOTICA_PROFILE_SCOPE("CollisionSceneFCLLatest::RayCast");
+    if (origins.cols() != directions.cols()) ThrowPretty("Number of ray origins (" << origins.cols() << ") and directions (" << directions.cols() << ") do not match!");
+    if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
+
+    // Objects with unbounded AABBs (i.e., planes) are checked against every ray. The broadphase then only visits
+    // objects whose AABBs overlap the AABB of the ray, clipped to the bounds of the remaining world objects.
+    std::vector<fcl::CollisionObjectd*> world_objects;
+    world_broad_phase_collision_manager_->getObjects(world_objects);
+    std::vector<const fcl::CollisionObjectd*> unbounded_objects;
+    fcl::AABBd world_bounds;
+    bool has_bounded_objects = false;
+    for (const fcl::CollisionObjectd* object : world_objects)
+    {
+        const fcl::AABBd& aabb = object->getAABB();
+        if (!aabb.min_.allFinite() || !aabb.max_.allFinite())
+        {
+            unbounded_objects.emplace_back(object);
+        }
+        else
+        {
+            world_bounds = has_bounded_objects ? world_bounds + aabb : aabb;
+            has_bounded_objects = true;
+        }
+    }
+
+    Eigen::VectorXd distances = Eigen::VectorXd::Constant(origins.cols(), std::numeric_limits<double>::infinity());
+    std::shared_ptr<fcl::Boxd> box = std::make_shared<fcl::Boxd>(0.0, 0.0, 0.0);
+    fcl::CollisionObjectd query(box);
+    RayCastData data;
+    data.query = &query;
+    data.max_distance = max_distance;
+    for (int i = 0; i < origins.cols(); ++i)
+    {
+        const double norm = directions.col(i).norm();
+        if (norm == 0.0) ThrowPretty("Direction of ray " << i << " is zero!");
+        data.origin = origins.col(i);
+        data.direction = directions.col(i) / norm;
+        data.distance = std::numeric_limits<double>::infinity();
+        for (const fcl::CollisionObjectd* object : unbounded_objects)
+        {
+            data.distance = std::min(data.distance, RayCastObject(object, data.origin, data.direction, max_distance));
+        }
+
+        double t_exit;
+        const double t_enter = has_bounded_objects ? RayCastBox(data.origin, data.direction, world_bounds.min_, world_bounds.max_, std::min(data.distance, max_distance), &t_exit) : kNoHit;
+        if (t_enter != kNoHit)
+        {
+            const Eigen::Vector3d start = data.origin + t_enter * data.direction;
+            const Eigen::Vector3d end = data.origin + t_exit * data.direction;
+            box->side = (end - start).cwiseAbs();
+            box->computeLocalAABB();
+            query.setTransform(fcl::Transform3d(Eigen::Translation3d(0.5 * (start + end))));
+            query.computeAABB();
+            world_broad_phase_collision_manager_->collide(&query, &data, &RayCastCallback);
+        }
+        distances(i) = data.distance;
+    }
+    return distances;
+}
 }  // namespace exotica
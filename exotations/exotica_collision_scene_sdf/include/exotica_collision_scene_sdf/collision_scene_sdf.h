@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_COLLISION_SCENE_SDF_COLLISION_SCENE_SDF_H_
+#define EXOTICA_COLLISION_SCENE_SDF_COLLISION_SCENE_SDF_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <exotica_core/collision_scene.h>
+
+#include <exotica_collision_scene_sdf/collision_scene_sdf_initializer.h>
+
+namespace exotica
+{
+///
+/// \brief Collision scene for quasi-static environments based on a signed distance field.
+/// The world objects (primitives, meshes and octrees) are voxelised into a signed distance field when the collision objects are created.
+/// Robot collision shapes are approximated by spheres, so that the distance of a robot link to the world is a lookup and trilinear
+/// interpolation in the field, which also provides a smooth gradient. Self collisions are computed between the robot spheres.
+///
+/// Meshes are voxelised as their convex hull. The field is rebuilt whenever a world object moves, which is expensive and meant for
+/// occasional changes only. Distances are accurate up to about the voxel resolution.
+///
+class CollisionSceneSDF : public CollisionScene, public Instantiable<CollisionSceneSDFInitializer>
+{
+public:
+    void Setup() override;
+
+    /// \brief Check if the whole robot is valid (collision only).
+    /// @param self Indicate if self collision check is required.
+    /// @return True, if the state is collision free.
+    bool IsStateValid(bool self = true, double safe_distance = 0.0) override;
+    bool IsCollisionFree(const std::string& o1, const std::string& o2, double safe_distance = 0.0) override;
+
+    /// \brief Computes collision distances.
+    /// \param self Indicate if self collision check is required.
+    /// \return One collision proxy per robot object and its closest world object, and per pair of robot objects if self is set.
+    std::vector<CollisionProxy> GetCollisionDistance(bool self, double check_margin = std::numeric_limits<double>::infinity()) override;
+    std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const std::string& o2, double check_margin = std::numeric_limits<double>::infinity()) override;
+    std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const bool& self) override;
+    std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const bool& self, const bool& disable_collision_scene_update, double check_margin = std::numeric_limits<double>::infinity()) override;
+    std::vector<CollisionProxy> GetCollisionDistance(const std::vector<std::string>& objects, const bool& self, double check_margin = std::numeric_limits<double>::infinity()) override;
+
+    std::vector<CollisionProxy> GetRobotToRobotCollisionDistance(double check_margin) override;
+    std::vector<CollisionProxy> GetRobotToWorldCollisionDistance(double check_margin) override;
+
+    /// @brief      Gets the collision world links.
+    /// @return     The collision world links.
+    std::vector<std::string> GetCollisionWorldLinks() override;
+
+    /// @brief      Gets the collision robot links.
+    /// @return     The collision robot links.
+    std::vector<std::string> GetCollisionRobotLinks() override;
+
+    Eigen::Vector3d GetTranslation(const std::string& name) override;
+
+    /// \brief Creates the robot spheres and the distance field of the world from kinematic elements.
+    /// \param objects Vector kinematic element pointers of collision objects.
+    void UpdateCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects) override;
+
+    /// \brief Moves re-attached objects between the robot and the world. Only their spheres are recreated, the distance field is
+    /// rebuilt if the world objects changed.
+    /// \param objects Kinematic elements of the re-attached collision objects.
+    void UpdateReattachedCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects) override;
+
+    /// \brief Updates the robot spheres from the kinematic tree. The distance field is rebuilt if a world object moved.
+    void UpdateCollisionObjectTransforms() override;
+
+    void SetACM(const AllowedCollisionMatrix& acm) override;
+
+    /// \brief Signed distance of a point (in the world frame) to the world objects.
+    /// \param point Query point.
+    /// \param gradient If set, receives the gradient of the distance at the point.
+    /// \param object If set, receives the index of the closest world object (-1 if there are no world objects).
+    /// \return Signed distance, negative inside world objects.
+    double GetWorldDistance(const Eigen::Vector3d& point, Eigen::Vector3d* gradient = nullptr, int* object = nullptr) const;
+
+private:
+    struct RobotObject
+    {
+        std::string name;
+        std::weak_ptr<KinematicElement> element;
+        std::vector<Eigen::Vector3d> local_centres;  ///< Sphere centres in the frame of the element
+        std::vector<Eigen::Vector3d> centres;        ///< Sphere centres in the world frame
+        double radius;
+    };
+
+    struct WorldObject
+    {
+        std::string name;
+        std::weak_ptr<KinematicElement> element;
+        KDL::Frame pose;  ///< Pose the distance field was built for
+    };
+
+    void BuildDistanceField();
+    void UpdateSelfCollisionFilter();
+
+    /// \brief Adds an object to the robot or the world objects, depending on whether it is attached to the robot. Returns whether it is a world object.
+    bool AddCollisionObject(const std::string& name, const std::shared_ptr<KinematicElement>& element);
+
+    /// \brief Distance of a robot object to its closest world object.
+    CollisionProxy ComputeWorldProxy(const RobotObject& robot) const;
+
+    /// \brief Distance between two robot objects, i.e., between their closest spheres.
+    CollisionProxy ComputeRobotProxy(const RobotObject& robot1, const RobotObject& robot2) const;
+
+    /// \brief Returns the indices of the robot objects of a link (e.g., base_link) or collision object (e.g., base_link_collision_0).
+    std::vector<std::size_t> GetRobotObjectsByName(const std::string& name) const;
+
+    std::vector<RobotObject> robot_objects_;
+    std::vector<WorldObject> world_objects_;
+    std::vector<bool> self_collision_filter_;  ///< Row-major, whether a pair of robot objects is checked for self collisions
+    std::map<std::string, std::weak_ptr<KinematicElement>> kinematic_elements_map_;
+
+    // Signed distance field, sampled at the voxel centres
+    Eigen::Vector3d field_origin_ = Eigen::Vector3d::Zero();  ///< Minimum corner of the field
+    Eigen::Vector3i field_size_ = Eigen::Vector3i::Zero();    ///< Number of voxels along each axis
+    double resolution_ = 0.02;
+    std::vector<float> distances_;
+    std::vector<int> closest_objects_;  ///< Index of the closest world object of each voxel
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_COLLISION_SCENE_SDF_COLLISION_SCENE_SDF_H_
@@ -0,0 +1,779 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_collision_scene_sdf/collision_scene_sdf.h>
+#include <exotica_core/factory.h>
+#include <exotica_core/scene.h>
+
+#include <geometric_shapes/bodies.h>
+#include <octomap/octomap.h>
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+REGISTER_COLLISION_SCENE_TYPE("CollisionSceneSDF", exotica::CollisionSceneSDF)
+
+namespace exotica
+{
+namespace
+{
+constexpr double kFar = 1e20;  // Squared distance of voxels without a source, finite to keep the distance transform free of NaNs
+
+inline bool IsRobotLink(std::shared_ptr<KinematicElement> e)
+{
+    return e->is_robot_link || e->closest_robot_link.lock();
+}
+
+inline Eigen::Vector3d TransformPoint(const KDL::Frame& frame, const Eigen::Vector3d& point)
+{
+    const KDL::Vector p = frame * KDL::Vector(point.x(), point.y(), point.z());
+    return Eigen::Vector3d(p.x(), p.y(), p.z());
+}
+
+// Bounding box of a shape in its local frame. Returns false for unbounded or empty shapes.
+bool GetLocalBoundingBox(const shapes::Shape& shape, Eigen::Vector3d& centre, Eigen::Vector3d& half_extents)
+{
+    centre.setZero();
+    switch (shape.type)
+    {
+        case shapes::SPHERE:
+            half_extents.setConstant(static_cast<const shapes::Sphere&>(shape).radius);
+            return true;
+        case shapes::BOX:
+            half_extents = 0.5 * Eigen::Map<const Eigen::Vector3d>(static_cast<const shapes::Box&>(shape).size);
+            return true;
+        case shapes::CYLINDER:
+        {
+            const shapes::Cylinder& cylinder = static_cast<const shapes::Cylinder&>(shape);
+            half_extents = Eigen::Vector3d(cylinder.radius, cylinder.radius, 0.5 * cylinder.length);
+            return true;
+        }
+        case shapes::CONE:
+        {
+            const shapes::Cone& cone = static_cast<const shapes::Cone&>(shape);
+            half_extents = Eigen::Vector3d(cone.radius, cone.radius, 0.5 * cone.length);
+            return true;
+        }
+        case shapes::MESH:
+        {
+            const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(shape);
+            if (mesh.vertex_count == 0) return false;
+            Eigen::Vector3d min = Eigen::Map<const Eigen::Vector3d>(mesh.vertices);
+            Eigen::Vector3d max = min;
+            for (unsigned int i = 1; i < mesh.vertex_count; ++i)
+            {
+                const Eigen::Map<const Eigen::Vector3d> vertex(mesh.vertices + 3 * i);
+                min = min.cwiseMin(vertex);
+                max = max.cwiseMax(vertex);
+            }
+            centre = 0.5 * (min + max);
+            half_extents = 0.5 * (max - min);
+            return true;
+        }
+        case shapes::OCTREE:
+        {
+            const shapes::OcTree& octree = static_cast<const shapes::OcTree&>(shape);
+            if (!octree.octree || octree.octree->size() == 0) return false;
+            Eigen::Vector3d min, max;
+            octree.octree->getMetricMin(min.x(), min.y(), min.z());
+            octree.octree->getMetricMax(max.x(), max.y(), max.z());
+            centre = 0.5 * (min + max);
+            half_extents = 0.5 * (max - min);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Covers a shape with spheres placed along the longest axis of its bounding box, each covering one slice of the box.
+// Spheres are represented exactly.
+void ApproximateWithSpheres(const shapes::Shape& shape, double scale, double padding, int max_spheres, std::vector<Eigen::Vector3d>& centres, double& radius)
+{
+    centres.clear();
+    if (shape.type == shapes::SPHERE)
+    {
+        centres.emplace_back(Eigen::Vector3d::Zero());
+        radius = static_cast<const shapes::Sphere&>(shape).radius * scale + padding;
+        return;
+    }
+
+    Eigen::Vector3d centre, half_extents;
+    if (shape.type == shapes::OCTREE || !GetLocalBoundingBox(shape, centre, half_extents)) ThrowPretty("Shape type " << shape.type << " is not supported for robot links.");
+    centre *= scale;
+    half_extents = half_extents * scale + Eigen::Vector3d::Constant(padding);
+
+    int axes[3] = {0, 1, 2};
+    std::sort(axes, axes + 3, [&half_extents](int a, int b) { return half_extents(a) > half_extents(b); });
+    const int num_spheres = half_extents(axes[1]) > 0.0 ? std::max(1, std::min(max_spheres, static_cast<int>(std::ceil(half_extents(axes[0]) / half_extents(axes[1]))))) : 1;
+    const double half_length = half_extents(axes[0]) / num_spheres;
+    radius = std::sqrt(half_length * half_length + half_extents(axes[1]) * half_extents(axes[1]) + half_extents(axes[2]) * half_extents(axes[2]));
+    for (int i = 0; i < num_spheres; ++i)
+    {
+        Eigen::Vector3d sphere_centre = centre;
+        sphere_centre(axes[0]) += (2 * i + 1) * half_length - half_extents(axes[0]);
+        centres.push_back(sphere_centre);
+    }
+}
+
+// Squared Euclidean distance transform of a sampled function along one dimension (Felzenszwalb and Huttenlocher, 2012).
+// arg receives the index of the sample each minimum is attained at. v and z are work buffers of size n and n + 1.
+void DistanceTransform1D(const std::vector<double>& f, int n, std::vector<double>& d, std::vector<int>& arg, std::vector<int>& v, std::vector<double>& z)
+{
+    int k = 0;
+    v[0] = 0;
+    z[0] = -std::numeric_limits<double>::infinity();
+    z[1] = std::numeric_limits<double>::infinity();
+    for (int q = 1; q < n; ++q)
+    {
+        double s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0 * q - 2.0 * v[k]);
+        while (s <= z[k])
+        {
+            --k;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0 * q - 2.0 * v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = std::numeric_limits<double>::infinity();
+    }
+
+    k = 0;
+    for (int q = 0; q < n; ++q)
+    {
+        while (z[k + 1] < q) ++k;
+        d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+        arg[q] = v[k];
+    }
+}
+
+// Squared distance (in voxels) of every voxel to the closest source voxel, and the index of that voxel (-1 if there is none)
+void DistanceTransform3D(const std::vector<char>& is_source, const Eigen::Vector3i& size, std::vector<double>& squared_distances, std::vector<int>& sources)
+{
+    const std::size_t num_voxels = is_source.size();
+    squared_distances.resize(num_voxels);
+    sources.resize(num_voxels);
+    for (std::size_t i = 0; i < num_voxels; ++i)
+    {
+        squared_distances[i] = is_source[i] ? 0.0 : kFar;
+        sources[i] = is_source[i] ? static_cast<int>(i) : -1;
+    }
+
+    // The transform is separable: transform along x, then the result along y, then along z
+    const int max_size = size.maxCoeff();
+    std::vector<double> f(max_size), d(max_size), z(max_size + 1);
+    std::vector<int> arg(max_size), v(max_size), line_sources(max_size);
+    const int strides[3] = {1, size(0), size(0) * size(1)};
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        const int axis1 = (axis + 1) % 3;
+        const int axis2 = (axis + 2) % 3;
+        for (int i1 = 0; i1 < size(axis1); ++i1)
+        {
+            for (int i2 = 0; i2 < size(axis2); ++i2)
+            {
+                const int start = i1 * strides[axis1] + i2 * strides[axis2];
+                for (int q = 0; q < size(axis); ++q)
+                {
+                    f[q] = squared_distances[start + q * strides[axis]];
+                    line_sources[q] = sources[start + q * strides[axis]];
+                }
+                DistanceTransform1D(f, size(axis), d, arg, v, z);
+                for (int q = 0; q < size(axis); ++q)
+                {
+                    squared_distances[start + q * strides[axis]] = d[q];
+                    sources[start + q * strides[axis]] = line_sources[arg[q]];
+                }
+            }
+        }
+    }
+}
+}  // namespace
+
+void CollisionSceneSDF::Setup()
+{
+    if (parameters_.Resolution <= 0.0) ThrowNamed("Resolution has to be positive: " << parameters_.Resolution);
+    if (parameters_.MaxDistance < 0.0) ThrowNamed("MaxDistance must not be negative: " << parameters_.MaxDistance);
+    if (parameters_.MaxSpheresPerShape < 1) ThrowNamed("MaxSpheresPerShape has to be at least 1: " << parameters_.MaxSpheresPerShape);
+    resolution_ = parameters_.Resolution;
+}
+
+void CollisionSceneSDF::UpdateCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects)
+{
+    kinematic_elements_map_ = objects;
+    robot_objects_.clear();
+    world_objects_.clear();
+
+    auto world_links_to_exclude_from_collision_scene = scene_.lock()->get_world_links_to_exclude_from_collision_scene();
+    for (const auto& object : objects)
+    {
+        // Check whether object is excluded as a world collision object:
+        if (world_links_to_exclude_from_collision_scene.count(object.first) > 0)
+        {
+            if (debug_) HIGHLIGHT_NAMED("CollisionSceneSDF::UpdateCollisionObject", object.first << " is excluded, skipping.");
+            continue;
+        }
+
+        std::shared_ptr<KinematicElement> element = object.second.lock();
+        if (!element || !element->shape) continue;
+        AddCollisionObject(object.first, element);
+    }
+
+    BuildDistanceField();
+    UpdateSelfCollisionFilter();
+    UpdateCollisionObjectTransforms();
+    needs_update_of_collision_objects_ = false;
+}
+
+void CollisionSceneSDF::UpdateReattachedCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects)
+{
+    // Fall back to recreating all objects if the collision scene is out of date, e.g., because elements have been added since
+    for (const auto& object : objects)
+    {
+        const auto& it = kinematic_elements_map_.find(object.first);
+        if (needs_update_of_collision_objects_ || it == kinematic_elements_map_.end() || object.second.expired() || it->second.lock() != object.second.lock())
+        {
+            CollisionScene::UpdateReattachedCollisionObjects(objects);
+            return;
+        }
+    }
+
+    // The spheres of the other robot objects are kept, the distance field only depends on the world objects
+    const auto reattached = [&objects](const std::string& name) { return objects.find(name) != objects.end(); };
+    const std::size_t num_world_objects = world_objects_.size();
+    robot_objects_.erase(std::remove_if(robot_objects_.begin(), robot_objects_.end(), [&reattached](const RobotObject& object) { return reattached(object.name); }), robot_objects_.end());
+    world_objects_.erase(std::remove_if(world_objects_.begin(), world_objects_.end(), [&reattached](const WorldObject& object) { return reattached(object.name); }), world_objects_.end());
+    bool world_changed = world_objects_.size() != num_world_objects;
+
+    auto world_links_to_exclude_from_collision_scene = scene_.lock()->get_world_links_to_exclude_from_collision_scene();
+    for (const auto& object : objects)
+    {
+        if (world_links_to_exclude_from_collision_scene.count(object.first) > 0) continue;
+        std::shared_ptr<KinematicElement> element = object.second.lock();
+        if (!element->shape) continue;
+        if (AddCollisionObject(object.first, element)) world_changed = true;
+    }
+
+    if (world_changed) BuildDistanceField();
+    UpdateSelfCollisionFilter();
+    UpdateCollisionObjectTransforms();
+}
+
+bool CollisionSceneSDF::AddCollisionObject(const std::string& name, const std::shared_ptr<KinematicElement>& element)
+{
+    if (IsRobotLink(element))
+    {
+        RobotObject robot_object;
+        robot_object.name = name;
+        robot_object.element = element;
+        ApproximateWithSpheres(*element->shape, robot_link_scale_, robot_link_padding_, parameters_.MaxSpheresPerShape, robot_object.local_centres, robot_object.radius);
+        robot_object.centres.resize(robot_object.local_centres.size());
+        robot_objects_.push_back(robot_object);
+        return false;
+    }
+
+    WorldObject world_object;
+    world_object.name = name;
+    world_object.element = element;
+    world_objects_.push_back(world_object);
+    return true;
+}
+
+void CollisionSceneSDF::UpdateCollisionObjectTransforms()
+{
+    for (RobotObject& robot_object : robot_objects_)
+    {
+        std::shared_ptr<KinematicElement> element = robot_object.element.lock();
+        if (!element) ThrowPretty("Expired pointer, this should not happen - make sure to call UpdateCollisionObjects() after UpdateSceneFrames()");
+        for (std::size_t i = 0; i < robot_object.local_centres.size(); ++i)
+        {
+            robot_object.centres[i] = TransformPoint(element->frame, robot_object.local_centres[i]);
+        }
+    }
+
+    // The field assumes a quasi-static world and is rebuilt if any world object moved
+    for (const WorldObject& world_object : world_objects_)
+    {
+        std::shared_ptr<KinematicElement> element = world_object.element.lock();
+        if (!element) ThrowPretty("Expired pointer, this should not happen - make sure to call UpdateCollisionObjects() after UpdateSceneFrames()");
+        if (!KDL::Equal(element->frame, world_object.pose, 1e-9))
+        {
+            if (debug_) HIGHLIGHT_NAMED("CollisionSceneSDF", "World object " << world_object.name << " moved, rebuilding the distance field.");
+            BuildDistanceField();
+            break;
+        }
+    }
+}
+
+void CollisionSceneSDF::BuildDistanceField()
+{
+    distances_.clear();
+    closest_objects_.clear();
+    field_size_.setZero();
+
+    // Bounds of the world objects in the world frame
+    std::vector<std::shared_ptr<bodies::Body>> bodies(world_objects_.size());
+    std::vector<Eigen::AlignedBox3d> object_bounds(world_objects_.size());
+    Eigen::AlignedBox3d bounds;
+    for (std::size_t i = 0; i < world_objects_.size(); ++i)
+    {
+        std::shared_ptr<KinematicElement> element = world_objects_[i].element.lock();
+        world_objects_[i].pose = element->frame;
+
+        Eigen::Vector3d centre, half_extents;
+        if (!GetLocalBoundingBox(*element->shape, centre, half_extents))
+        {
+            WARNING_NAMED("CollisionSceneSDF", "World object " << world_objects_[i].name << " of shape type " << element->shape->type << " is unbounded or empty and thus ignored.");
+            continue;
+        }
+        centre *= world_link_scale_;
+        half_extents = half_extents * world_link_scale_ + Eigen::Vector3d::Constant(world_link_padding_);
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            const Eigen::Vector3d sign((corner & 1) ? 1.0 : -1.0, (corner & 2) ? 1.0 : -1.0, (corner & 4) ? 1.0 : -1.0);
+            object_bounds[i].extend(TransformPoint(element->frame, centre + sign.cwiseProduct(half_extents)));
+        }
+
+        // Octrees are voxelised leaf by leaf below
+        if (element->shape->type != shapes::OCTREE)
+        {
+            bodies[i].reset(bodies::createBodyFromShape(element->shape.get()));
+            if (!bodies[i])
+            {
+                WARNING_NAMED("CollisionSceneSDF", "World object " << world_objects_[i].name << " of shape type " << element->shape->type << " can't be voxelised and is thus ignored.");
+                object_bounds[i].setEmpty();
+                continue;
+            }
+            bodies[i]->setScale(world_link_scale_);
+            bodies[i]->setPadding(world_link_padding_);
+            Eigen::Isometry3d pose;
+            pose.matrix() = GetFrame(element->frame);
+            bodies[i]->setPose(pose);
+        }
+        bounds.extend(object_bounds[i]);
+    }
+    if (bounds.isEmpty()) return;
+
+    // The field extends MaxDistance beyond the world objects
+    field_origin_ = bounds.min() - Eigen::Vector3d::Constant(parameters_.MaxDistance);
+    const Eigen::Vector3d extents = bounds.sizes() + Eigen::Vector3d::Constant(2.0 * parameters_.MaxDistance);
+    for (int k = 0; k < 3; ++k) field_size_(k) = std::max(2, static_cast<int>(std::ceil(extents(k) / resolution_)));
+    const long num_voxels = static_cast<long>(field_size_(0)) * field_size_(1) * field_size_(2);
+    if (num_voxels > parameters_.MaxVoxels) ThrowNamed("The distance field would have " << num_voxels << " voxels (" << field_size_.transpose() << "), more than MaxVoxels (" << parameters_.MaxVoxels << "). Increase the Resolution or reduce MaxDistance.");
+
+    const auto voxel_index = [this](int x, int y, int z) { return x + field_size_(0) * (y + field_size_(1) * z); };
+    const auto voxel_coordinates = [this](const Eigen::Vector3d& point) { return ((point - field_origin_) / resolution_).array().floor().cast<int>().matrix().eval(); };
+
+    // Voxels whose centres are inside of a world object
+    std::vector<int> occupancy(num_voxels, -1);
+    for (std::size_t i = 0; i < world_objects_.size(); ++i)
+    {
+        if (object_bounds[i].isEmpty()) continue;
+        std::shared_ptr<KinematicElement> element = world_objects_[i].element.lock();
+        if (bodies[i])
+        {
+            // Only the voxels within the bounds of the object need to be tested
+            const Eigen::Vector3i min = voxel_coordinates(object_bounds[i].min()).cwiseMax(Eigen::Vector3i::Zero());
+            const Eigen::Vector3i max = voxel_coordinates(object_bounds[i].max()).cwiseMin(field_size_ - Eigen::Vector3i::Ones());
+            for (int z = min.z(); z <= max.z(); ++z)
+            {
+                for (int y = min.y(); y <= max.y(); ++y)
+                {
+                    for (int x = min.x(); x <= max.x(); ++x)
+                    {
+                        const int index = voxel_index(x, y, z);
+                        if (occupancy[index] != -1) continue;
+                        const Eigen::Vector3d centre = field_origin_ + (Eigen::Vector3d(x, y, z) + Eigen::Vector3d::Constant(0.5)) * resolution_;
+                        if (bodies[i]->containsPoint(centre)) occupancy[index] = static_cast<int>(i);
+                    }
+                }
+            }
+        }
+        else
+        {
+            const octomap::OcTree& octree = *static_cast<const shapes::OcTree&>(*element->shape).octree;
+            for (auto it = octree.begin_leafs(); it != octree.end_leafs(); ++it)
+            {
+                if (!octree.isNodeOccupied(*it)) continue;
+
+                // Sample the leaf at the resolution of the field
+                const double size = it.getSize();
+                const int samples = std::max(1, static_cast<int>(std::ceil(size / resolution_)));
+                const Eigen::Vector3d leaf_centre(it.getX(), it.getY(), it.getZ());
+                for (int a = 0; a < samples; ++a)
+                {
+                    for (int b = 0; b < samples; ++b)
+                    {
+                        for (int c = 0; c < samples; ++c)
+                        {
+                            const Eigen::Vector3d offset = (Eigen::Vector3d(a, b, c) + Eigen::Vector3d::Constant(0.5)) / samples - Eigen::Vector3d::Constant(0.5);
+                            const Eigen::Vector3i voxel = voxel_coordinates(TransformPoint(element->frame, world_link_scale_ * (leaf_centre + size * offset)));
+                            if ((voxel.array() < 0).any() || (voxel.array() >= field_size_.array()).any()) continue;
+                            const int index = voxel_index(voxel.x(), voxel.y(), voxel.z());
+                            if (occupancy[index] == -1) occupancy[index] = static_cast<int>(i);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Free voxels store the distance to the closest occupied voxel, occupied voxels the negative distance to the closest free voxel.
+    // The surface is assumed half way between the voxel centres.
+    distances_.assign(num_voxels, 0.0f);
+    closest_objects_.assign(num_voxels, -1);
+    std::vector<char> is_source(num_voxels);
+    std::vector<double> squared_distances;
+    std::vector<int> sources;
+
+    for (long i = 0; i < num_voxels; ++i) is_source[i] = occupancy[i] != -1;
+    DistanceTransform3D(is_source, field_size_, squared_distances, sources);
+    for (long i = 0; i < num_voxels; ++i)
+    {
+        if (occupancy[i] != -1) continue;
+        distances_[i] = static_cast<float>((std::sqrt(squared_distances[i]) - 0.5) * resolution_);
+        closest_objects_[i] = sources[i] >= 0 ? occupancy[sources[i]] : -1;
+    }
+
+    for (long i = 0; i < num_voxels; ++i) is_source[i] = occupancy[i] == -1;
+    DistanceTransform3D(is_source, field_size_, squared_distances, sources);
+    for (long i = 0; i < num_voxels; ++i)
+    {
+        if (occupancy[i] == -1) continue;
+        distances_[i] = -static_cast<float>((std::sqrt(squared_distances[i]) - 0.5) * resolution_);
+        closest_objects_[i] = occupancy[i];
+    }
+
+    if (debug_) HIGHLIGHT_NAMED("CollisionSceneSDF", "Built distance field with " << field_size_.transpose() << " voxels for " << world_objects_.size() << " world objects.");
+}
+
+double CollisionSceneSDF::GetWorldDistance(const Eigen::Vector3d& point, Eigen::Vector3d* gradient, int* object) const
+{
+    if (distances_.empty())
+    {
+        if (gradient) gradient->setZero();
+        if (object) *object = -1;
+        return std::numeric_limits<double>::infinity();
+    }
+
+    // Continuous voxel coordinates, the distances are sampled at the voxel centres
+    const Eigen::Vector3d u = (point - field_origin_) / resolution_ - Eigen::Vector3d::Constant(0.5);
+    const Eigen::Vector3d clamped = u.cwiseMax(Eigen::Vector3d::Zero()).cwiseMin((field_size_ - Eigen::Vector3i::Ones()).cast<double>());
+
+    int i[3];
+    double t[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        i[k] = std::min(static_cast<int>(std::floor(clamped(k))), field_size_(k) - 2);
+        t[k] = clamped(k) - i[k];
+    }
+
+    // Trilinear interpolation and its gradient
+    double distance = 0.0;
+    Eigen::Vector3d g = Eigen::Vector3d::Zero();
+    for (int a = 0; a < 2; ++a)
+    {
+        const double wa = a ? t[0] : 1.0 - t[0];
+        for (int b = 0; b < 2; ++b)
+        {
+            const double wb = b ? t[1] : 1.0 - t[1];
+            for (int c = 0; c < 2; ++c)
+            {
+                const double wc = c ? t[2] : 1.0 - t[2];
+                const double value = distances_[(i[0] + a) + field_size_(0) * ((i[1] + b) + field_size_(1) * (i[2] + c))];
+                distance += wa * wb * wc * value;
+                g(0) += (a ? 1.0 : -1.0) * wb * wc * value;
+                g(1) += wa * (b ? 1.0 : -1.0) * wc * value;
+                g(2) += wa * wb * (c ? 1.0 : -1.0) * value;
+            }
+        }
+    }
+    g /= resolution_;
+
+    // Outside of the field, extrapolate from the closest surface point estimated at the boundary
+    const Eigen::Vector3d outside = (u - clamped) * resolution_;
+    if (outside.squaredNorm() > 0.0)
+    {
+        const Eigen::Vector3d to_point = (g.norm() > 1e-9) ? Eigen::Vector3d(outside + distance * g.normalized()) : Eigen::Vector3d(outside.normalized() * (outside.norm() + distance));
+        distance = to_point.norm();
+        g = distance > 0.0 ? Eigen::Vector3d(to_point / distance) : Eigen::Vector3d::Zero();
+    }
+
+    if (gradient) *gradient = g;
+    if (object)
+    {
+        int voxel[3];
+        for (int k = 0; k < 3; ++k) voxel[k] = static_cast<int>(std::round(clamped(k)));
+        *object = closest_objects_[voxel[0] + field_size_(0) * (voxel[1] + field_size_(1) * voxel[2])];
+    }
+    return distance;
+}
+
+CollisionProxy CollisionSceneSDF::ComputeWorldProxy(const RobotObject& robot) const
+{
+    CollisionProxy proxy;
+    proxy.e1 = robot.element.lock();
+    proxy.distance = std::numeric_limits<double>::infinity();
+    for (const Eigen::Vector3d& centre : robot.centres)
+    {
+        Eigen::Vector3d gradient;
+        int object;
+        const double distance = GetWorldDistance(centre, &gradient, &object) - robot.radius;
+        if (distance >= proxy.distance) continue;
+
+        // The gradient points away from the closest world object
+        const Eigen::Vector3d normal = gradient.norm() > 1e-9 ? Eigen::Vector3d(gradient.normalized()) : Eigen::Vector3d::UnitZ();
+        proxy.e2 = object >= 0 ? world_objects_[object].element.lock() : nullptr;
+        proxy.distance = distance;
+        proxy.normal1 = -normal;
+        proxy.normal2 = normal;
+        proxy.contact1 = centre - robot.radius * normal;
+        proxy.contact2 = centre - (distance + robot.radius) * normal;
+    }
+    return proxy;
+}
+
+CollisionProxy CollisionSceneSDF::ComputeRobotProxy(const RobotObject& robot1, const RobotObject& robot2) const
+{
+    CollisionProxy proxy;
+    proxy.e1 = robot1.element.lock();
+    proxy.e2 = robot2.element.lock();
+    proxy.distance = std::numeric_limits<double>::infinity();
+    for (const Eigen::Vector3d& centre1 : robot1.centres)
+    {
+        for (const Eigen::Vector3d& centre2 : robot2.centres)
+        {
+            const double centre_distance = (centre2 - centre1).norm();
+            const double distance = centre_distance - robot1.radius - robot2.radius;
+            if (distance >= proxy.distance) continue;
+
+            const Eigen::Vector3d normal = centre_distance > 1e-9 ? Eigen::Vector3d((centre2 - centre1) / centre_distance) : Eigen::Vector3d::UnitZ();
+            proxy.distance = distance;
+            proxy.normal1 = normal;
+            proxy.normal2 = -normal;
+            proxy.contact1 = centre1 + robot1.radius * normal;
+            proxy.contact2 = centre2 - robot2.radius * normal;
+        }
+    }
+    return proxy;
+}
+
+void CollisionSceneSDF::SetACM(const AllowedCollisionMatrix& acm)
+{
+    CollisionScene::SetACM(acm);
+    UpdateSelfCollisionFilter();
+}
+
+void CollisionSceneSDF::UpdateSelfCollisionFilter()
+{
+    const std::size_t num_objects = robot_objects_.size();
+    self_collision_filter_.assign(num_objects * num_objects, false);
+    for (std::size_t i = 0; i < num_objects; ++i)
+    {
+        for (std::size_t j = 0; j < num_objects; ++j)
+        {
+            if (robot_objects_[i].element.expired() || robot_objects_[j].element.expired()) continue;
+            self_collision_filter_[i * num_objects + j] = IsAllowedToCollide(robot_objects_[i].name, robot_objects_[j].name, true);
+        }
+    }
+}
+
+std::vector<std::size_t> CollisionSceneSDF::GetRobotObjectsByName(const std::string& name) const
+{
+    std::vector<std::size_t> ret;
+    for (std::size_t i = 0; i < robot_objects_.size(); ++i)
+    {
+        std::shared_ptr<KinematicElement> element = robot_objects_[i].element.lock();
+        // As in CollisionSceneFCLLatest, the name can either be the link (e.g., base_link) or the collision object (e.g., base_link_collision_0)
+        if (robot_objects_[i].name == name || element->parent.lock()->segment.getName() == name) ret.push_back(i);
+    }
+    return ret;
+}
+
+bool CollisionSceneSDF::IsStateValid(bool self, double safe_distance)
+{
+    if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
+
+    const auto is_valid = [safe_distance](double distance) { return distance > 0.0 && distance >= safe_distance; };
+    for (const RobotObject& robot_object : robot_objects_)
+    {
+        for (const Eigen::Vector3d& centre : robot_object.centres)
+        {
+            if (!is_valid(GetWorldDistance(centre) - robot_object.radius)) return false;
+        }
+    }
+
+    if (self)
+    {
+        const std::size_t num_objects = robot_objects_.size();
+        for (std::size_t i = 0; i < num_objects; ++i)
+        {
+            for (std::size_t j = i + 1; j < num_objects; ++j)
+            {
+                if (self_collision_filter_[i * num_objects + j] && !is_valid(ComputeRobotProxy(robot_objects_[i], robot_objects_[j]).distance)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool CollisionSceneSDF::IsCollisionFree(const std::string& o1, const std::string& o2, double safe_distance)
+{
+    for (const CollisionProxy& proxy : GetCollisionDistance(o1, o2))
+    {
+        if (proxy.distance <= 0.0 || proxy.distance < safe_distance) return false;
+    }
+    return true;
+}
+
+std::vector<CollisionProxy> CollisionSceneSDF::GetCollisionDistance(bool self, double check_margin)
+{
+    if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
+
+    std::vector<CollisionProxy> proxies;
+    if (self) AppendVector(proxies, GetRobotToRobotCollisionDistance(check_margin));
+    AppendVector(proxies, GetRobotToWorldCollisionDistance(check_margin));
+    return proxies;
+}
+
+std::vector<CollisionProxy> CollisionSceneSDF::GetCollisionDistance(const std::string& o1, const std::string& o2, double check_margin)
+{
+    if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
+
+    const std::vector<std::size_t> objects1 = GetRobotObjectsByName(o1);
+    const std::vector<std::size_t> objects2 = GetRobotObjectsByName(o2);
+    if (objects1.empty()) ThrowPretty("Can't find robot object '" << o1 << "'! Distances between two objects are only supported between robot objects.");
+    if (objects2.empty()) ThrowPretty("Can't find robot object '" << o2 << "'! Distances between two objects are only supported between robot objects.");
+
+    std::vector<CollisionProxy> proxies;
+    for (std::size_t i : objects1)
+    {
+        for (std::size_t j : objects2)
+        {
+            CollisionProxy proxy = ComputeRobotProxy(robot_objects_[i], robot_objects_[j]);
+            if (proxy.distance < check_margin) proxies.push_back(proxy);
+        }
+    }
+    return proxies;
+}
+
+std::vector<CollisionProxy> CollisionSceneSDF::GetCollisionDistance(const std::string& o1, const bool& self)
+{
+    return GetCollisionDistance(o1, self, false);
+}
+
+std::vector<CollisionProxy> CollisionSceneSDF::GetCollisionDistance(const std::string& o1, const bool& self, const bool& disable_collision_scene_update, double check_margin)
+{
+    if (!always_externally_updated_collision_scene_ && !disable_collision_scene_update) UpdateCollisionObjectTransforms();
+
+    std::vector<CollisionProxy> proxies;
+    const std::size_t num_objects = robot_objects_.size();
+    for (std::size_t i : GetRobotObjectsByName(o1))
+    {
+        if (!world_objects_.empty())
+        {
+            CollisionProxy proxy = ComputeWorldProxy(robot_objects_[i]);
+            if (proxy.distance < check_margin) proxies.push_back(proxy);
+        }
+        if (!self) continue;
+        for (std::size_t j = 0; j < num_objects; ++j)
+        {
+            if (!self_collision_filter_[i * num_objects + j]) continue;
+            CollisionProxy proxy = ComputeRobotProxy(robot_objects_[i], robot_objects_[j]);
+            if (proxy.distance < check_margin) proxies.push_back(proxy);
+        }
+    }
+    return proxies;
+}
+
+std::vector<CollisionProxy> CollisionSceneSDF::GetCollisionDistance(const std::vector<std::string>& objects, const bool& self, double check_margin)
+{
+    if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
+
+    std::vector<CollisionProxy> proxies;
+    for (const auto& o1 : objects)
+        AppendVector(proxies, GetCollisionDistance(o1, self, true, check_margin));
+
+    return proxies;
+}
+
+std::vector<CollisionProxy> CollisionSceneSDF::GetRobotToRobotCollisionDistance(double check_margin)
+{
+    // For each robot collision object to each robot collision object
+    std::vector<CollisionProxy> proxies;
+    const std::size_t num_objects = robot_objects_.size();
+    for (std::size_t i = 0; i < num_objects; ++i)
+    {
+        for (std::size_t j = 0; j < num_objects; ++j)
+        {
+            if (!self_collision_filter_[i * num_objects + j]) continue;
+            CollisionProxy proxy = ComputeRobotProxy(robot_objects_[i], robot_objects_[j]);
+            if (proxy.distance < check_margin) proxies.push_back(proxy);
+        }
+    }
+    return proxies;
+}
+
+std::vector<CollisionProxy> CollisionSceneSDF::GetRobotToWorldCollisionDistance(double check_margin)
+{
+    // For each robot collision object to the closest world collision object
+    std::vector<CollisionProxy> proxies;
+    if (world_objects_.empty()) return proxies;
+    for (const RobotObject& robot_object : robot_objects_)
+    {
+        CollisionProxy proxy = ComputeWorldProxy(robot_object);
+        if (proxy.distance < check_margin) proxies.push_back(proxy);
+    }
+    return proxies;
+}
+
+Eigen::Vector3d CollisionSceneSDF::GetTranslation(const std::string& name)
+{
+    auto it = kinematic_elements_map_.find(name);
+    if (it == kinematic_elements_map_.end() || it->second.expired()) ThrowPretty("KinematicElement is not a valid collision link:" << name);
+    return Eigen::Map<Eigen::Vector3d>(it->second.lock()->frame.p.data);
+}
+
+std::vector<std::string> CollisionSceneSDF::GetCollisionWorldLinks()
+{
+    std::vector<std::string> ret;
+    for (const WorldObject& world_object : world_objects_) ret.push_back(world_object.name);
+    return ret;
+}
+
+std::vector<std::string> CollisionSceneSDF::GetCollisionRobotLinks()
+{
+    std::vector<std::string> ret;
+    for (const RobotObject& robot_object : robot_objects_) ret.push_back(robot_object.name);
+    return ret;
+}
+}  // namespace exotica
@@ -0,0 +1,162 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_COLLISION_SCENE_SPHERE_TREE_COLLISION_SCENE_SPHERE_TREE_H_
+#define EXOTICA_COLLISION_SCENE_SPHERE_TREE_COLLISION_SCENE_SPHERE_TREE_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <exotica_core/collision_scene.h>
+#include <exotica_core/kinematic_tree.h>
+
+#include <exotica_collision_scene_sphere_tree/collision_scene_sphere_tree_initializer.h>
+#include <exotica_collision_scene_sphere_tree/sphere_tree.h>
+
+namespace exotica
+{
+///
+/// \brief Collision scene approximating every collision shape with an automatically generated sphere tree (see SphereTree).
+/// Queries between objects traverse their trees, pruning pairs of spheres that are farther apart than the closest pair found so far.
+/// The spheres cover the shapes, so distances are conservative, i.e., underestimated by up to about the size of the leaves.
+/// The Depth of the trees trades accuracy for speed. With UseExactFallback, pairs closer than ExactFallbackMargin are recomputed
+/// exactly by an internal CollisionSceneFCLLatest.
+///
+class CollisionSceneSphereTree : public CollisionScene, public Instantiable<CollisionSceneSphereTreeInitializer>
+{
+public:
+    void Setup() override;
+
+    /// \brief Check if the whole robot is valid (collision only).
+    /// @param self Indicate if self collision check is required.
+    /// @return True, if the state is collision free.
+    bool IsStateValid(bool self = true, double safe_distance = 0.0) override;
+
+    /// \brief Checks a batch of states without updating the scene. The frames of all states of a batch (see BatchSize) are
+    /// computed at once with KinematicTree::UpdateBatchFrames and the states are checked in parallel (see NumThreads).
+    /// With UseExactFallback, the scene is updated to each state in turn instead (see CollisionScene::AreStatesValid).
+    std::vector<bool> AreStatesValid(Eigen::MatrixXdRefConst states, bool self = true, double safe_distance = 0.0, bool stop_at_first_invalid = false) override;
+    bool IsCollisionFree(const std::string& o1, const std::string& o2, double safe_distance = 0.0) override;
+
+    /// \brief Computes collision distances.
+    /// \param self Indicate if self collision check is required.
+    /// \return Collision proximity objects for all pairs of robot and world objects, and pairs of robot objects if self is set.
+    std::vector<CollisionProxy> GetCollisionDistance(bool self, double check_margin = std::numeric_limits<double>::infinity()) override;
+    std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const std::string& o2, double check_margin = std::numeric_limits<double>::infinity()) override;
+    std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const bool& self) override;
+    std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const bool& self, const bool& disable_collision_scene_update, double check_margin = std::numeric_limits<double>::infinity()) override;
+    std::vector<CollisionProxy> GetCollisionDistance(const std::vector<std::string>& objects, const bool& self, double check_margin = std::numeric_limits<double>::infinity()) override;
+
+    std::vector<CollisionProxy> GetRobotToRobotCollisionDistance(double check_margin) override;
+    std::vector<CollisionProxy> GetRobotToWorldCollisionDistance(double check_margin) override;
+
+    /// @brief      Gets the collision world links.
+    /// @return     The collision world links.
+    std::vector<std::string> GetCollisionWorldLinks() override;
+
+    /// @brief      Gets the collision robot links.
+    /// @return     The collision robot links.
+    std::vector<std::string> GetCollisionRobotLinks() override;
+
+    Eigen::Vector3d GetTranslation(const std::string& name) override;
+
+    /// \brief Creates (or loads from the cache) the sphere trees of the kinematic elements.
+    /// \param objects Vector kinematic element pointers of collision objects.
+    void UpdateCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects) override;
+
+    /// \brief Updates whether re-attached objects belong to the robot and their sphere trees, keeping all other objects intact.
+    /// \param objects Kinematic elements of the re-attached collision objects.
+    void UpdateReattachedCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects) override;
+
+    /// \brief Updates collision object transformations from the kinematic tree.
+    void UpdateCollisionObjectTransforms() override;
+
+    void SetACM(const AllowedCollisionMatrix& acm) override;
+
+private:
+    struct CollisionObject
+    {
+        std::string name;
+        std::weak_ptr<KinematicElement> element;
+        std::shared_ptr<const SphereTree> tree;  ///< Scaled and padded
+        bool is_robot;
+        Eigen::Matrix3d rotation;  ///< Pose of the element in the world frame
+        Eigen::Vector3d translation;
+    };
+
+    /// \brief State of a traversal of the sphere trees of two objects.
+    struct Traversal
+    {
+        const CollisionObject* o1;
+        const CollisionObject* o2;
+        double distance;     ///< Closest pair of leaves found so far, initialised with the bound on the distances of interest
+        bool stop_at_first;  ///< Stop at the first pair of leaves closer than the bound
+        int leaf1 = -1;
+        int leaf2 = -1;
+    };
+
+    void Traverse(Traversal& traversal, int node1, int node2) const;
+
+    /// \brief Distance between two objects via their sphere trees, falling back to FCL for close pairs if enabled.
+    /// \return False if the objects are farther apart than check_margin.
+    bool ComputeDistance(std::size_t i, std::size_t j, double check_margin, CollisionProxy& proxy);
+
+    /// \brief Whether two objects are closer than the safe distance (or touching).
+    bool InCollision(std::size_t i, std::size_t j, double safe_distance);
+    /// \brief Whether the sphere trees of two objects are closer than the safe distance (or touching), without the exact fallback.
+    bool InCollision(const CollisionObject& o1, const CollisionObject& o2, double safe_distance) const;
+    /// \brief Whether all pairs of objects that pass the collision filter are collision free, using the poses stored in objects.
+    bool AreObjectsCollisionFree(const std::vector<CollisionObject>& objects, bool self, double safe_distance) const;
+
+    /// \brief Returns the indices of the objects of a link (e.g., base_link) or collision object (e.g., base_link_collision_0).
+    std::vector<std::size_t> GetObjectsByName(const std::string& name) const;
+
+    void UpdateCollisionFilter();
+
+    /// \brief Sets whether the object belongs to the robot and its scaled and padded sphere tree accordingly.
+    void SetCollisionObjectTree(CollisionObject& object, const std::shared_ptr<KinematicElement>& element);
+    void UpdateExactScene();
+
+    std::vector<CollisionObject> objects_;
+    std::vector<std::size_t> robot_objects_;
+    std::vector<std::size_t> world_objects_;
+    std::vector<bool> collision_filter_;  ///< Row-major, whether a pair of objects is checked when self collisions are requested
+    std::map<std::string, std::weak_ptr<KinematicElement>> kinematic_elements_map_;
+
+    std::shared_ptr<CollisionScene> exact_scene_;  ///< CollisionSceneFCLLatest used for the exact fallback
+    bool exact_scene_needs_update_ = true;
+
+    int num_threads_ = 1;
+    KinematicWorkspace batch_workspace_;  ///< Frames of a batch of states in AreStatesValid
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_COLLISION_SCENE_SPHERE_TREE_COLLISION_SCENE_SPHERE_TREE_H_
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_COLLISION_SCENE_SPHERE_TREE_SPHERE_TREE_H_
+#define EXOTICA_COLLISION_SCENE_SPHERE_TREE_SPHERE_TREE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <geometric_shapes/shapes.h>
+
+namespace exotica
+{
+///
+/// \brief Hierarchy of bounding spheres of a collision shape, in the frame of the shape.
+/// The leaves cover the shape and every node encloses the spheres of its children, so that the distance between two nodes
+/// is a lower bound on the distance between the shapes they cover.
+///
+struct SphereTree
+{
+    struct Node
+    {
+        Eigen::Vector3d centre;
+        double radius;
+        int first_child;   ///< Index of the first child, the children of a node are stored contiguously
+        int num_children;  ///< Zero for leaves
+    };
+
+    /// \brief Returns a copy of the tree scaled about the origin of the shape, with the spheres inflated by padding.
+    SphereTree Scaled(double scale, double padding) const;
+
+    std::size_t NumLeaves() const;
+
+    std::vector<Node> nodes;  ///< nodes[0] is the root
+};
+
+/// \brief Generates a sphere tree by recursive octree subdivision of the bounding cube of the shape.
+/// Meshes (and primitives, via their meshes) are covered on their surface, boxes, cylinders, cones and octrees are filled.
+/// Spheres are represented exactly by a single node.
+/// \param shape Collision shape.
+/// \param depth Levels of subdivision, the leaves are cells of 1/2^depth of the size of the bounding cube.
+SphereTree GenerateSphereTree(const shapes::Shape& shape, int depth);
+
+/// \brief Key of the sphere tree of a shape for a given depth, derived from the geometry of the shape. Empty for shapes that should not be cached (octrees).
+std::string GetSphereTreeKey(const shapes::Shape& shape, int depth);
+
+void SaveSphereTree(const SphereTree& tree, const std::string& file_name);
+bool LoadSphereTree(const std::string& file_name, SphereTree& tree);
+
+/// \brief Returns the sphere tree of a shape, generating it on the first request.
+/// Trees are cached in memory for the lifetime of the process and, if cache_directory is set, stored on disk so that they are
+/// generated only once (e.g., offline, by loading the scene once).
+std::shared_ptr<const SphereTree> GetSphereTree(const shapes::Shape& shape, int depth, const std::string& cache_directory = "");
+}  // namespace exotica
+
+#endif  // EXOTICA_COLLISION_SCENE_SPHERE_TREE_SPHERE_TREE_H_
@@ -0,0 +1,566 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_collision_scene_sphere_tree/collision_scene_sphere_tree.h>
+#include <exotica_core/collision_scene_initializer.h>
+#include <exotica_core/factory.h>
+#include <exotica_core/scene.h>
+#include <exotica_core/server.h>
+#include <exotica_core/setup.h>
+#include <exotica_core/tools/parallel_loop.h>
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+REGISTER_COLLISION_SCENE_TYPE("CollisionSceneSphereTree", exotica::CollisionSceneSphereTree)
+
+namespace exotica
+{
+namespace
+{
+inline bool IsRobotLink(std::shared_ptr<KinematicElement> e)
+{
+    return e->is_robot_link || e->closest_robot_link.lock();
+}
+}  // namespace
+
+void CollisionSceneSphereTree::Setup()
+{
+    if (parameters_.Depth < 0 || parameters_.Depth > 10) ThrowPretty("Depth has to be between 0 and 10: " << parameters_.Depth);
+    if (!parameters_.CacheDirectory.empty() && !PathExists(ParsePath(parameters_.CacheDirectory))) ThrowPretty("CacheDirectory '" << parameters_.CacheDirectory << "' does not exist.");
+
+    exact_scene_.reset();
+    if (parameters_.UseExactFallback)
+    {
+        // The exact scene shares the scaling and padding of this scene
+        Initializer exact_initializer = CollisionSceneInitializer(parameters_);
+        exact_initializer.SetName("exotica/CollisionSceneFCLLatest");
+        exact_initializer.SetProperty("Name", object_name_ + "_exact");
+        exact_scene_ = exotica::Setup::CreateCollisionScene(exact_initializer);
+        exact_scene_->debug_ = debug_;
+        exact_scene_->Setup();
+        exact_scene_->SetAlwaysExternallyUpdatedCollisionScene(true);
+    }
+
+    if (parameters_.NumThreads < 0) ThrowPretty("Invalid number of threads: " << parameters_.NumThreads);
+    if (parameters_.BatchSize < 1) ThrowPretty("BatchSize has to be positive: " << parameters_.BatchSize);
+    num_threads_ = Server::ResolveNumThreads(parameters_.NumThreads);
+}
+
+void CollisionSceneSphereTree::UpdateCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects)
+{
+    kinematic_elements_map_ = objects;
+    objects_.clear();
+    robot_objects_.clear();
+    world_objects_.clear();
+
+    auto world_links_to_exclude_from_collision_scene = scene_.lock()->get_world_links_to_exclude_from_collision_scene();
+    for (const auto& object : objects)
+    {
+        // Check whether object is excluded as a world collision object:
+        if (world_links_to_exclude_from_collision_scene.count(object.first) > 0)
+        {
+            if (debug_) HIGHLIGHT_NAMED("CollisionSceneSphereTree::UpdateCollisionObject", object.first << " is excluded, skipping.");
+            continue;
+        }
+
+        std::shared_ptr<KinematicElement> element = object.second.lock();
+        if (!element || !element->shape) continue;
+        if (element->shape->type == shapes::PLANE)
+        {
+            WARNING_NAMED("CollisionSceneSphereTree", "Planes are not supported, ignoring " << object.first << ".");
+            continue;
+        }
+
+        CollisionObject new_object;
+        new_object.name = object.first;
+        new_object.element = element;
+        SetCollisionObjectTree(new_object, element);
+        if (debug_) HIGHLIGHT_NAMED("CollisionSceneSphereTree", object.first << ": " << new_object.tree->nodes.size() << " spheres, " << new_object.tree->NumLeaves() << " leaves");
+
+        (new_object.is_robot ? robot_objects_ : world_objects_).push_back(objects_.size());
+        objects_.push_back(new_object);
+    }
+
+    if (exact_scene_)
+    {
+        exact_scene_->AssignScene(scene_.lock());
+        exact_scene_->SetACM(acm_);
+        exact_scene_->UpdateCollisionObjects(objects);
+    }
+
+    UpdateCollisionFilter();
+    UpdateCollisionObjectTransforms();
+    needs_update_of_collision_objects_ = false;
+}
+
+void CollisionSceneSphereTree::UpdateReattachedCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects)
+{
+    // Fall back to recreating all objects if the collision scene is out of date, e.g., because elements have been added since
+    for (const auto& object : objects)
+    {
+        const auto& it = kinematic_elements_map_.find(object.first);
+        if (needs_update_of_collision_objects_ || it == kinematic_elements_map_.end() || object.second.expired() || it->second.lock() != object.second.lock())
+        {
+            CollisionScene::UpdateReattachedCollisionObjects(objects);
+            return;
+        }
+    }
+
+    for (CollisionObject& collision_object : objects_)
+    {
+        const auto& it = objects.find(collision_object.name);
+        if (it != objects.end()) SetCollisionObjectTree(collision_object, it->second.lock());
+    }
+
+    robot_objects_.clear();
+    world_objects_.clear();
+    for (std::size_t i = 0; i < objects_.size(); ++i) (objects_[i].is_robot ? robot_objects_ : world_objects_).push_back(i);
+
+    if (exact_scene_) exact_scene_->UpdateReattachedCollisionObjects(objects);
+    exact_scene_needs_update_ = true;
+
+    // Re-attached objects are matched against the ACM through their new closest robot link
+    UpdateCollisionFilter();
+}
+
+void CollisionSceneSphereTree::SetCollisionObjectTree(CollisionObject& object, const std::shared_ptr<KinematicElement>& element)
+{
+    object.is_robot = IsRobotLink(element);
+    const double scale = object.is_robot ? robot_link_scale_ : world_link_scale_;
+    const double padding = object.is_robot ? robot_link_padding_ : world_link_padding_;
+    std::shared_ptr<const SphereTree> tree = GetSphereTree(*element->shape, parameters_.Depth, parameters_.CacheDirectory);
+    object.tree = (scale == 1.0 && padding == 0.0) ? tree : std::make_shared<const SphereTree>(tree->Scaled(scale, padding));
+}
+
+void CollisionSceneSphereTree::UpdateCollisionObjectTransforms()
+{
+    EXOTICA_PROFILE_SCOPE("CollisionSceneSphereTree::UpdateCollisionObjectTransforms");
+    for (CollisionObject& object : objects_)
+    {
+        std::shared_ptr<KinematicElement> element = object.element.lock();
+        if (!element) ThrowPretty("Expired pointer, this should not happen - make sure to call UpdateCollisionObjects() after UpdateSceneFrames()");
+        object.translation = Eigen::Map<const Eigen::Vector3d>(element->frame.p.data);
+        object.rotation = Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor>>(element->frame.M.data);
+    }
+    exact_scene_needs_update_ = true;
+}
+
+void CollisionSceneSphereTree::UpdateExactScene()
+{
+    if (exact_scene_needs_update_)
+    {
+        exact_scene_->UpdateCollisionObjectTransforms();
+        exact_scene_needs_update_ = false;
+    }
+}
+
+void CollisionSceneSphereTree::SetACM(const AllowedCollisionMatrix& acm)
+{
+    CollisionScene::SetACM(acm);
+    if (exact_scene_) exact_scene_->SetACM(acm);
+    UpdateCollisionFilter();
+}
+
+void CollisionSceneSphereTree::UpdateCollisionFilter()
+{
+    const std::size_t num_objects = objects_.size();
+    collision_filter_.assign(num_objects * num_objects, false);
+    for (std::size_t i = 0; i < num_objects; ++i)
+    {
+        for (std::size_t j = i + 1; j < num_objects; ++j)
+        {
+            if (objects_[i].element.expired() || objects_[j].element.expired()) continue;
+            const bool allowed = IsAllowedToCollide(objects_[i].name, objects_[j].name, true);
+            collision_filter_[i * num_objects + j] = allowed;
+            collision_filter_[j * num_objects + i] = allowed;
+        }
+    }
+}
+
+void CollisionSceneSphereTree::Traverse(Traversal& traversal, int node1, int node2) const
+{
+    const SphereTree::Node& n1 = traversal.o1->tree->nodes[node1];
+    const SphereTree::Node& n2 = traversal.o2->tree->nodes[node2];
+    const Eigen::Vector3d c1 = traversal.o1->rotation * n1.centre + traversal.o1->translation;
+    const Eigen::Vector3d c2 = traversal.o2->rotation * n2.centre + traversal.o2->translation;
+
+    // The spheres enclose their subtrees, so their distance bounds the distance of all pairs of leaves below
+    const double distance = (c2 - c1).norm() - n1.radius - n2.radius;
+    if (distance >= traversal.distance) return;
+
+    if (n1.num_children == 0 && n2.num_children == 0)
+    {
+        traversal.distance = distance;
+        traversal.leaf1 = node1;
+        traversal.leaf2 = node2;
+        return;
+    }
+
+    // Descend into the larger sphere first
+    if (n2.num_children == 0 || (n1.num_children > 0 && n1.radius >= n2.radius))
+    {
+        for (int child = n1.first_child; child < n1.first_child + n1.num_children; ++child)
+        {
+            Traverse(traversal, child, node2);
+            if (traversal.stop_at_first && traversal.leaf1 != -1) return;
+        }
+    }
+    else
+    {
+        for (int child = n2.first_child; child < n2.first_child + n2.num_children; ++child)
+        {
+            Traverse(traversal, node1, child);
+            if (traversal.stop_at_first && traversal.leaf1 != -1) return;
+        }
+    }
+}
+
+bool CollisionSceneSphereTree::ComputeDistance(std::size_t i, std::size_t j, double check_margin, CollisionProxy& proxy)
+{
+    const CollisionObject& o1 = objects_[i];
+    const CollisionObject& o2 = objects_[j];
+    Traversal traversal;
+    traversal.o1 = &o1;
+    traversal.o2 = &o2;
+    traversal.distance = check_margin;
+    traversal.stop_at_first = false;
+    Traverse(traversal, 0, 0);
+    if (traversal.leaf1 == -1) return false;
+
+    if (exact_scene_ && traversal.distance < parameters_.ExactFallbackMargin)
+    {
+        UpdateExactScene();
+        std::vector<CollisionProxy> exact_proxies = exact_scene_->GetCollisionDistance(o1.name, o2.name);
+        if (!exact_proxies.empty())
+        {
+            proxy = *std::min_element(exact_proxies.begin(), exact_proxies.end(), [](const CollisionProxy& a, const CollisionProxy& b) { return a.distance < b.distance; });
+            return proxy.distance < check_margin;
+        }
+    }
+
+    const SphereTree::Node& leaf1 = o1.tree->nodes[traversal.leaf1];
+    const SphereTree::Node& leaf2 = o2.tree->nodes[traversal.leaf2];
+    const Eigen::Vector3d c1 = o1.rotation * leaf1.centre + o1.translation;
+    const Eigen::Vector3d c2 = o2.rotation * leaf2.centre + o2.translation;
+    const double centre_distance = (c2 - c1).norm();
+    const Eigen::Vector3d normal = centre_distance > 1e-9 ? Eigen::Vector3d((c2 - c1) / centre_distance) : Eigen::Vector3d::UnitZ();
+
+    proxy.e1 = o1.element.lock();
+    proxy.e2 = o2.element.lock();
+    proxy.distance = traversal.distance;
+    proxy.normal1 = normal;
+    proxy.normal2 = -normal;
+    proxy.contact1 = c1 + leaf1.radius * normal;
+    proxy.contact2 = c2 - leaf2.radius * normal;
+    return true;
+}
+
+bool CollisionSceneSphereTree::InCollision(const CollisionObject& o1, const CollisionObject& o2, double safe_distance) const
+{
+    // Touching counts as a collision
+    Traversal traversal;
+    traversal.o1 = &o1;
+    traversal.o2 = &o2;
+    traversal.distance = safe_distance > 0.0 ? safe_distance : std::numeric_limits<double>::min();
+    traversal.stop_at_first = true;
+    Traverse(traversal, 0, 0);
+    return traversal.leaf1 != -1;
+}
+
+bool CollisionSceneSphereTree::InCollision(std::size_t i, std::size_t j, double safe_distance)
+{
+    if (!InCollision(objects_[i], objects_[j], safe_distance)) return false;
+
+    // The spheres overestimate the shapes, confirm with the exact scene
+    if (exact_scene_)
+    {
+        UpdateExactScene();
+        return !exact_scene_->IsCollisionFree(objects_[i].name, objects_[j].name, safe_distance);
+    }
+    return true;
+}
+
+std::vector<std::size_t> CollisionSceneSphereTree::GetObjectsByName(const std::string& name) const
+{
+    std::vector<std::size_t> ret;
+    for (std::size_t i = 0; i < objects_.size(); ++i)
+    {
+        std::shared_ptr<KinematicElement> element = objects_[i].element.lock();
+        // As in CollisionSceneFCLLatest, the name can either be the link (e.g., base_link) or the collision object (e.g., base_link_collision_0)
+        if (objects_[i].name == name || element->parent.lock()->segment.getName() == name) ret.push_back(i);
+    }
+    if (ret.empty()) ThrowPretty("Can't find object '" << name << "'!");
+    return ret;
+}
+
+bool CollisionSceneSphereTree::IsStateValid(bool self, double safe_distance)
+{
+    EXOTICA_PROFILE_SCOPE("CollisionSceneSphereTree::IsStateValid");
+    if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
+
+    const std::size_t num_objects = objects_.size();
+    for (std::size_t i : robot_objects_)
+    {
+        for (std::size_t j : world_objects_)
+        {
+            if (collision_filter_[i * num_objects + j] && InCollision(i, j, safe_distance)) return false;
+        }
+    }
+
+    if (self)
+    {
+        for (std::size_t a = 0; a < robot_objects_.size(); ++a)
+        {
+            for (std::size_t b = a + 1; b < robot_objects_.size(); ++b)
+            {
+                const std::size_t i = robot_objects_[a], j = robot_objects_[b];
+                if (collision_filter_[i * num_objects + j] && InCollision(i, j, safe_distance)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool CollisionSceneSphereTree::AreObjectsCollisionFree(const std::vector<CollisionObject>& objects, bool self, double safe_distance) const
+{
+    const std::size_t num_objects = objects.size();
+    for (std::size_t i : robot_objects_)
+    {
+        for (std::size_t j : world_objects_)
+        {
+            if (collision_filter_[i * num_objects + j] && InCollision(objects[i], objects[j], safe_distance)) return false;
+        }
+    }
+
+    if (self)
+    {
+        for (std::size_t a = 0; a < robot_objects_.size(); ++a)
+        {
+            for (std::size_t b = a + 1; b < robot_objects_.size(); ++b)
+            {
+                const std::size_t i = robot_objects_[a], j = robot_objects_[b];
+                if (collision_filter_[i * num_objects + j] && InCollision(objects[i], objects[j], safe_distance)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<bool> CollisionSceneSphereTree::AreStatesValid(Eigen::MatrixXdRefConst states, bool self, double safe_distance, bool stop_at_first_invalid)
+{
+    // The exact fallback queries the collision objects of the scene, which requires updating it to each state
+    if (exact_scene_) return CollisionScene::AreStatesValid(states, self, safe_distance, stop_at_first_invalid);
+
+    const KinematicTree& kinematic_tree = scene_.lock()->GetKinematicTree();
+    std::vector<int> element_ids(objects_.size());
+    std::vector<int> frame_indices(objects_.size());
+    for (std::size_t k = 0; k < objects_.size(); ++k)
+    {
+        std::shared_ptr<KinematicElement> element = objects_[k].element.lock();
+        if (!element) ThrowPretty("Expired pointer, this should not happen - make sure to call UpdateCollisionObjects() after UpdateSceneFrames()");
+        element_ids[k] = element->id;
+    }
+
+    const int num_states = static_cast<int>(states.rows());
+    std::vector<char> valid(num_states, false);  // std::vector<bool> can not be written concurrently
+    int num_checked = 0;
+    while (num_checked < num_states)
+    {
+        const int batch_size = std::min(parameters_.BatchSize, num_states - num_checked);
+        kinematic_tree.UpdateBatchFrames(states.middleRows(num_checked, batch_size).transpose(), batch_workspace_);
+        // Elements the batch did not compute are marked with -1, they can not be checked
+        for (std::size_t k = 0; k < objects_.size(); ++k)
+        {
+            const int id = element_ids[k] + 1;
+            frame_indices[k] = id < static_cast<int>(batch_workspace_.index.size()) ? batch_workspace_.index[id] : -1;
+            if (frame_indices[k] < 0) ThrowPretty("The batch kinematics did not compute the frame of collision object '" << objects_[k].name << "' - make sure to call UpdateCollisionObjects() after UpdateSceneFrames()");
+        }
+
+        // Each thread poses its own copy of the objects, the sphere trees are shared
+        const int num_threads = std::min(num_threads_, batch_size);
+        std::vector<std::vector<CollisionObject>> thread_objects(num_threads, objects_);
+        ParallelLoop(num_threads, batch_size, [&](int thread, int n) {
+            std::vector<CollisionObject>& objects = thread_objects[thread];
+            for (std::size_t k = 0; k < objects.size(); ++k)
+            {
+                const KDL::Frame& frame = batch_workspace_.frames[frame_indices[k] * batch_size + n];
+                objects[k].translation = Eigen::Map<const Eigen::Vector3d>(frame.p.data);
+                objects[k].rotation = Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor>>(frame.M.data);
+            }
+            valid[num_checked + n] = AreObjectsCollisionFree(objects, self, safe_distance);
+        });
+        num_checked += batch_size;
+
+        // Batches are checked in order, the states after the first invalid one are reported as invalid
+        if (stop_at_first_invalid && std::find(valid.begin(), valid.begin() + num_checked, false) != valid.begin() + num_checked) break;
+    }
+
+    std::vector<bool> ret(valid.begin(), valid.end());
+    if (stop_at_first_invalid)
+    {
+        const auto first_invalid = std::find(ret.begin(), ret.end(), false);
+        if (first_invalid != ret.end()) std::fill(first_invalid, ret.end(), false);
+    }
+    return ret;
+}
+
+bool CollisionSceneSphereTree::IsCollisionFree(const std::string& o1, const std::string& o2, double safe_distance)
+{
+    EXOTICA_PROFILE_SCOPE("CollisionSceneSphereTree::IsCollisionFree");
+    if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
+
+    for (std::size_t i : GetObjectsByName(o1))
+    {
+        for (std::size_t j : GetObjectsByName(o2))
+        {
+            if (InCollision(i, j, safe_distance)) return false;
+        }
+    }
+    return true;
+}
+
+std::vector<CollisionProxy> CollisionSceneSphereTree::GetCollisionDistance(bool self, double check_margin)
+{
+    EXOTICA_PROFILE_SCOPE("CollisionSceneSphereTree::GetCollisionDistance");
+    if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
+
+    std::vector<CollisionProxy> proxies;
+    if (self) AppendVector(proxies, GetRobotToRobotCollisionDistance(check_margin));
+    AppendVector(proxies, GetRobotToWorldCollisionDistance(check_margin));
+    return proxies;
+}
+
+std::vector<CollisionProxy> CollisionSceneSphereTree::GetCollisionDistance(const std::string& o1, const std::string& o2, double check_margin)
+{
+    EXOTICA_PROFILE_SCOPE("CollisionSceneSphereTree::GetCollisionDistance");
+    if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
+
+    std::vector<CollisionProxy> proxies;
+    CollisionProxy proxy;
+    for (std::size_t i : GetObjectsByName(o1))
+    {
+        for (std::size_t j : GetObjectsByName(o2))
+        {
+            if (ComputeDistance(i, j, check_margin, proxy)) proxies.push_back(proxy);
+        }
+    }
+    return proxies;
+}
+
+std::vector<CollisionProxy> CollisionSceneSphereTree::GetCollisionDistance(const std::string& o1, const bool& self)
+{
+    return GetCollisionDistance(o1, self, false);
+}
+
+std::vector<CollisionProxy> CollisionSceneSphereTree::GetCollisionDistance(const std::string& o1, const bool& self, const bool& disable_collision_scene_update, double check_margin)
+{
+    EXOTICA_PROFILE_SCOPE("CollisionSceneSphereTree::GetCollisionDistance");
+    if (!always_externally_updated_collision_scene_ && !disable_collision_scene_update) UpdateCollisionObjectTransforms();
+
+    std::vector<CollisionProxy> proxies;
+    CollisionProxy proxy;
+    const std::size_t num_objects = objects_.size();
+    for (std::size_t i : GetObjectsByName(o1))
+    {
+        for (std::size_t j = 0; j < num_objects; ++j)
+        {
+            if (!collision_filter_[i * num_objects + j] || (!self && objects_[i].is_robot && objects_[j].is_robot)) continue;
+            if (ComputeDistance(i, j, check_margin, proxy)) proxies.push_back(proxy);
+        }
+    }
+    return proxies;
+}
+
+std::vector<CollisionProxy> CollisionSceneSphereTree::GetCollisionDistance(const std::vector<std::string>& objects, const bool& self, double check_margin)
+{
+    EXOTICA_PROFILE_SCOPE("CollisionSceneSphereTree::GetCollisionDistance");
+    if (!always_externally_updated_collision_scene_) UpdateCollisionObjectTransforms();
+
+    std::vector<CollisionProxy> proxies;
+    for (const auto& o1 : objects)
+        AppendVector(proxies, GetCollisionDistance(o1, self, true, check_margin));
+
+    return proxies;
+}
+
+std::vector<CollisionProxy> CollisionSceneSphereTree::GetRobotToRobotCollisionDistance(double check_margin)
+{
+    // For each robot collision object to each robot collision object
+    std::vector<CollisionProxy> proxies;
+    CollisionProxy proxy;
+    const std::size_t num_objects = objects_.size();
+    for (std::size_t i : robot_objects_)
+    {
+        for (std::size_t j : robot_objects_)
+        {
+            if (collision_filter_[i * num_objects + j] && ComputeDistance(i, j, check_margin, proxy)) proxies.push_back(proxy);
+        }
+    }
+    return proxies;
+}
+
+std::vector<CollisionProxy> CollisionSceneSphereTree::GetRobotToWorldCollisionDistance(double check_margin)
+{
+    // For each robot collision object to each world collision object
+    std::vector<CollisionProxy> proxies;
+    CollisionProxy proxy;
+    const std::size_t num_objects = objects_.size();
+    for (std::size_t i : robot_objects_)
+    {
+        for (std::size_t j : world_objects_)
+        {
+            if (collision_filter_[i * num_objects + j] && ComputeDistance(i, j, check_margin, proxy)) proxies.push_back(proxy);
+        }
+    }
+    return proxies;
+}
+
+Eigen::Vector3d CollisionSceneSphereTree::GetTranslation(const std::string& name)
+{
+    auto it = kinematic_elements_map_.find(name);
+    if (it == kinematic_elements_map_.end() || it->second.expired()) ThrowPretty("KinematicElement is not a valid collision link:" << name);
+    return Eigen::Map<Eigen::Vector3d>(it->second.lock()->frame.p.data);
+}
+
+std::vector<std::string> CollisionSceneSphereTree::GetCollisionWorldLinks()
+{
+    std::vector<std::string> ret;
+    for (std::size_t i : world_objects_) ret.push_back(objects_[i].name);
+    return ret;
+}
+
+std::vector<std::string> CollisionSceneSphereTree::GetCollisionRobotLinks()
+{
+    std::vector<std::string> ret;
+    for (std::size_t i : robot_objects_) ret.push_back(objects_[i].name);
+    return ret;
+}
+}  // namespace exotica
@@ -0,0 +1,401 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_collision_scene_sphere_tree/sphere_tree.h>
+#include <exotica_core/tools.h>
+
+#include <geometric_shapes/mesh_operations.h>
+#include <geometric_shapes/shape_operations.h>
+#include <octomap/octomap.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace exotica
+{
+namespace
+{
+void SampleTriangle(const Eigen::Vector3d& a, const Eigen::Vector3d& b, const Eigen::Vector3d& c, double spacing, std::vector<Eigen::Vector3d>& points)
+{
+    const double max_edge = std::max((b - a).norm(), std::max((c - a).norm(), (c - b).norm()));
+    const int n = std::max(1, static_cast<int>(std::ceil(max_edge / spacing)));
+    for (int i = 0; i <= n; ++i)
+    {
+        for (int j = 0; j <= n - i; ++j)
+        {
+            points.push_back(a + (b - a) * (static_cast<double>(i) / n) + (c - a) * (static_cast<double>(j) / n));
+        }
+    }
+}
+
+void SampleMesh(const shapes::Mesh& mesh, double spacing, std::vector<Eigen::Vector3d>& points)
+{
+    for (unsigned int i = 0; i < mesh.triangle_count; ++i)
+    {
+        const Eigen::Map<const Eigen::Vector3d> a(mesh.vertices + 3 * mesh.triangles[3 * i]);
+        const Eigen::Map<const Eigen::Vector3d> b(mesh.vertices + 3 * mesh.triangles[3 * i + 1]);
+        const Eigen::Map<const Eigen::Vector3d> c(mesh.vertices + 3 * mesh.triangles[3 * i + 2]);
+        SampleTriangle(a, b, c, spacing, points);
+    }
+}
+
+// Whether a point is inside of a solid primitive
+bool ContainsPoint(const shapes::Shape& shape, const Eigen::Vector3d& p)
+{
+    switch (shape.type)
+    {
+        case shapes::BOX:
+        {
+            const double* size = static_cast<const shapes::Box&>(shape).size;
+            return std::abs(p.x()) <= 0.5 * size[0] && std::abs(p.y()) <= 0.5 * size[1] && std::abs(p.z()) <= 0.5 * size[2];
+        }
+        case shapes::CYLINDER:
+        {
+            const shapes::Cylinder& cylinder = static_cast<const shapes::Cylinder&>(shape);
+            return std::abs(p.z()) <= 0.5 * cylinder.length && p.x() * p.x() + p.y() * p.y() <= cylinder.radius * cylinder.radius;
+        }
+        case shapes::CONE:
+        {
+            // The tip is on the positive z axis, the base on the negative z axis
+            const shapes::Cone& cone = static_cast<const shapes::Cone&>(shape);
+            if (std::abs(p.z()) > 0.5 * cone.length) return false;
+            const double radius = cone.radius * (0.5 * cone.length - p.z()) / cone.length;
+            return p.x() * p.x() + p.y() * p.y() <= radius * radius;
+        }
+        default:
+            return false;
+    }
+}
+
+class SphereTreeBuilder
+{
+public:
+    SphereTreeBuilder(const std::vector<Eigen::Vector3d>& points, double point_radius, int depth) : points_(points), point_radius_(point_radius), depth_(depth)
+    {
+        // Bounding cube of the points, the leaves are its cells at the given depth
+        Eigen::Vector3d min = points_[0], max = points_[0];
+        for (const Eigen::Vector3d& p : points_)
+        {
+            min = min.cwiseMin(p);
+            max = max.cwiseMax(p);
+        }
+        const int num_cells = 1 << depth_;
+        const double cell_size = std::max((max - min).maxCoeff(), 1e-9) / num_cells;
+        cells_.resize(points_.size());
+        for (std::size_t i = 0; i < points_.size(); ++i)
+        {
+            cells_[i] = ((points_[i] - min) / cell_size).array().floor().cast<int>().max(0).min(num_cells - 1).matrix();
+        }
+    }
+
+    SphereTree Build()
+    {
+        std::vector<int> ids(points_.size());
+        for (std::size_t i = 0; i < ids.size(); ++i) ids[i] = static_cast<int>(i);
+        tree_.nodes.resize(1);
+        BuildNode(0, 0, ids);
+        return tree_;
+    }
+
+private:
+    void BuildNode(int node, int level, const std::vector<int>& ids)
+    {
+        if (level == depth_)
+        {
+            // Leaves are the bounding spheres of their points, inflated to cover the shape in between the points
+            Eigen::Vector3d min = points_[ids[0]], max = points_[ids[0]];
+            for (int id : ids)
+            {
+                min = min.cwiseMin(points_[id]);
+                max = max.cwiseMax(points_[id]);
+            }
+            const Eigen::Vector3d centre = 0.5 * (min + max);
+            double radius = 0.0;
+            for (int id : ids) radius = std::max(radius, (points_[id] - centre).norm());
+            tree_.nodes[node] = {centre, radius + point_radius_, 0, 0};
+            return;
+        }
+
+        std::vector<int> child_ids[8];
+        const int shift = depth_ - level - 1;
+        for (int id : ids)
+        {
+            const Eigen::Vector3i& cell = cells_[id];
+            child_ids[((cell.x() >> shift) & 1) | (((cell.y() >> shift) & 1) << 1) | (((cell.z() >> shift) & 1) << 2)].push_back(id);
+        }
+
+        const int first_child = static_cast<int>(tree_.nodes.size());
+        int num_children = 0;
+        for (int octant = 0; octant < 8; ++octant) num_children += !child_ids[octant].empty();
+        tree_.nodes.resize(first_child + num_children);
+        for (int octant = 0, child = first_child; octant < 8; ++octant)
+        {
+            if (!child_ids[octant].empty()) BuildNode(child++, level + 1, child_ids[octant]);
+        }
+
+        // Inner nodes enclose the spheres of their children
+        Eigen::Vector3d min = tree_.nodes[first_child].centre, max = min;
+        for (int child = first_child; child < first_child + num_children; ++child)
+        {
+            min = min.cwiseMin(tree_.nodes[child].centre - Eigen::Vector3d::Constant(tree_.nodes[child].radius));
+            max = max.cwiseMax(tree_.nodes[child].centre + Eigen::Vector3d::Constant(tree_.nodes[child].radius));
+        }
+        const Eigen::Vector3d centre = 0.5 * (min + max);
+        double radius = 0.0;
+        for (int child = first_child; child < first_child + num_children; ++child)
+        {
+            radius = std::max(radius, (tree_.nodes[child].centre - centre).norm() + tree_.nodes[child].radius);
+        }
+        tree_.nodes[node] = {centre, radius, first_child, num_children};
+    }
+
+    const std::vector<Eigen::Vector3d>& points_;
+    std::vector<Eigen::Vector3i> cells_;
+    double point_radius_;
+    int depth_;
+    SphereTree tree_;
+};
+
+template <typename T>
+void AppendBytes(std::string& key, const T* data, std::size_t count)
+{
+    key.append(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+}  // namespace
+
+SphereTree SphereTree::Scaled(double scale, double padding) const
+{
+    SphereTree ret = *this;
+    for (Node& node : ret.nodes)
+    {
+        node.centre *= scale;
+        node.radius = node.radius * scale + padding;
+    }
+    return ret;
+}
+
+std::size_t SphereTree::NumLeaves() const
+{
+    return std::count_if(nodes.begin(), nodes.end(), [](const Node& node) { return node.num_children == 0; });
+}
+
+SphereTree GenerateSphereTree(const shapes::Shape& shape, int depth)
+{
+    if (depth < 0 || depth > 10) ThrowPretty("Sphere tree depth has to be between 0 and 10: " << depth);
+
+    SphereTree tree;
+    if (shape.type == shapes::SPHERE)
+    {
+        tree.nodes.push_back({Eigen::Vector3d::Zero(), static_cast<const shapes::Sphere&>(shape).radius, 0, 0});
+        return tree;
+    }
+
+    // Points sampled on (and in) the shape, such that every point of the shape is within point_radius of a sample
+    std::vector<Eigen::Vector3d> points;
+    double point_radius;
+    if (shape.type == shapes::OCTREE)
+    {
+        const std::shared_ptr<const octomap::OcTree>& octree = static_cast<const shapes::OcTree&>(shape).octree;
+        if (!octree) ThrowPretty("Empty octree.");
+        const double resolution = octree->getResolution();
+        for (auto it = octree->begin_leafs(); it != octree->end_leafs(); ++it)
+        {
+            if (!octree->isNodeOccupied(*it)) continue;
+            // Pruned leaves are sampled at the resolution of the octree
+            const int samples = std::max(1, static_cast<int>(std::round(it.getSize() / resolution)));
+            const Eigen::Vector3d origin = Eigen::Vector3d(it.getX(), it.getY(), it.getZ()) - Eigen::Vector3d::Constant(0.5 * it.getSize());
+            for (int a = 0; a < samples; ++a)
+                for (int b = 0; b < samples; ++b)
+                    for (int c = 0; c < samples; ++c)
+                        points.push_back(origin + (Eigen::Vector3d(a, b, c) + Eigen::Vector3d::Constant(0.5)) * resolution);
+        }
+        point_radius = 0.5 * std::sqrt(3.0) * resolution;
+
+        // Subdivide at least down to the resolution of the octree
+        if (!points.empty())
+        {
+            double extent_min[3], extent_max[3];
+            octree->getMetricMin(extent_min[0], extent_min[1], extent_min[2]);
+            octree->getMetricMax(extent_max[0], extent_max[1], extent_max[2]);
+            double extent = 0.0;
+            for (int k = 0; k < 3; ++k) extent = std::max(extent, extent_max[k] - extent_min[k]);
+            depth = std::max(depth, std::min(10, static_cast<int>(std::ceil(std::log2(std::max(1.0, extent / resolution))))));
+        }
+    }
+    else
+    {
+        std::unique_ptr<shapes::Mesh> primitive_mesh;
+        const shapes::Mesh* mesh;
+        if (shape.type == shapes::MESH)
+        {
+            mesh = static_cast<const shapes::Mesh*>(&shape);
+        }
+        else
+        {
+            primitive_mesh.reset(shapes::createMeshFromShape(&shape));
+            if (!primitive_mesh) ThrowPretty("Shape type " << shape.type << " is not supported.");
+            mesh = primitive_mesh.get();
+        }
+        if (mesh->vertex_count == 0) ThrowPretty("Empty mesh.");
+
+        // The spacing is a fraction of the size of the leaves
+        Eigen::Vector3d min = Eigen::Map<const Eigen::Vector3d>(mesh->vertices), max = min;
+        for (unsigned int i = 1; i < mesh->vertex_count; ++i)
+        {
+            min = min.cwiseMin(Eigen::Map<const Eigen::Vector3d>(mesh->vertices + 3 * i));
+            max = max.cwiseMax(Eigen::Map<const Eigen::Vector3d>(mesh->vertices + 3 * i));
+        }
+        const double spacing = std::max((max - min).maxCoeff(), 1e-9) / (1 << depth) / 4.0;
+        point_radius = spacing;
+
+        for (unsigned int i = 0; i < mesh->vertex_count; ++i) points.push_back(Eigen::Map<const Eigen::Vector3d>(mesh->vertices + 3 * i));
+        SampleMesh(*mesh, spacing, points);
+
+        // Fill solid primitives
+        if (shape.type == shapes::BOX || shape.type == shapes::CYLINDER || shape.type == shapes::CONE)
+        {
+            const Eigen::Vector3i num_samples = ((max - min) / spacing).array().ceil().cast<int>().max(1).matrix();
+            for (int x = 0; x < num_samples.x(); ++x)
+            {
+                for (int y = 0; y < num_samples.y(); ++y)
+                {
+                    for (int z = 0; z < num_samples.z(); ++z)
+                    {
+                        const Eigen::Vector3d p = min + (Eigen::Vector3d(x, y, z) + Eigen::Vector3d::Constant(0.5)).cwiseProduct(max - min).cwiseQuotient(num_samples.cast<double>());
+                        if (ContainsPoint(shape, p)) points.push_back(p);
+                    }
+                }
+            }
+        }
+    }
+    if (points.empty()) ThrowPretty("Shape of type " << shape.type << " has no points to approximate.");
+
+    return SphereTreeBuilder(points, point_radius, depth).Build();
+}
+
+std::string GetSphereTreeKey(const shapes::Shape& shape, int depth)
+{
+    std::string key;
+    AppendBytes(key, &shape.type, 1);
+    AppendBytes(key, &depth, 1);
+    switch (shape.type)
+    {
+        case shapes::SPHERE:
+            AppendBytes(key, &static_cast<const shapes::Sphere&>(shape).radius, 1);
+            break;
+        case shapes::BOX:
+            AppendBytes(key, static_cast<const shapes::Box&>(shape).size, 3);
+            break;
+        case shapes::CYLINDER:
+            AppendBytes(key, &static_cast<const shapes::Cylinder&>(shape).radius, 1);
+            AppendBytes(key, &static_cast<const shapes::Cylinder&>(shape).length, 1);
+            break;
+        case shapes::CONE:
+            AppendBytes(key, &static_cast<const shapes::Cone&>(shape).radius, 1);
+            AppendBytes(key, &static_cast<const shapes::Cone&>(shape).length, 1);
+            break;
+        case shapes::MESH:
+        {
+            const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(shape);
+            AppendBytes(key, mesh.vertices, 3 * mesh.vertex_count);
+            AppendBytes(key, mesh.triangles, 3 * mesh.triangle_count);
+            break;
+        }
+        default:
+            // Octrees are usually sensor data which changes between runs
+            return "";
+    }
+    std::stringstream ss;
+    ss << "sphere_tree_" << shapes::shapeStringName(&shape) << "_" << depth << "_" << std::hex << std::hash<std::string>()(key);
+    return ss.str();
+}
+
+void SaveSphereTree(const SphereTree& tree, const std::string& file_name)
+{
+    std::ofstream file(file_name);
+    if (!file.good()) ThrowPretty("Can't write sphere tree to '" << file_name << "'!");
+    file << std::setprecision(17) << tree.nodes.size() << "\n";
+    for (const SphereTree::Node& node : tree.nodes)
+    {
+        file << node.centre.x() << " " << node.centre.y() << " " << node.centre.z() << " " << node.radius << " " << node.first_child << " " << node.num_children << "\n";
+    }
+}
+
+bool LoadSphereTree(const std::string& file_name, SphereTree& tree)
+{
+    std::ifstream file(file_name);
+    std::size_t num_nodes;
+    if (!(file >> num_nodes) || num_nodes == 0) return false;
+    tree.nodes.resize(num_nodes);
+    for (SphereTree::Node& node : tree.nodes)
+    {
+        if (!(file >> node.centre.x() >> node.centre.y() >> node.centre.z() >> node.radius >> node.first_child >> node.num_children)) return false;
+        if (node.num_children < 0 || node.first_child < 0 || static_cast<std::size_t>(node.first_child + node.num_children) > num_nodes) return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const SphereTree> GetSphereTree(const shapes::Shape& shape, int depth, const std::string& cache_directory)
+{
+    static std::mutex cache_mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const SphereTree>> cache;
+
+    const std::string key = GetSphereTreeKey(shape, depth);
+    if (key.empty()) return std::make_shared<const SphereTree>(GenerateSphereTree(shape, depth));
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache.find(key);
+    if (it != cache.end()) return it->second;
+
+    std::shared_ptr<SphereTree> tree = std::make_shared<SphereTree>();
+    const std::string file_name = cache_directory.empty() ? "" : ParsePath(cache_directory) + "/" + key + ".txt";
+    if (file_name.empty() || !LoadSphereTree(file_name, *tree))
+    {
+        *tree = GenerateSphereTree(shape, depth);
+        if (!file_name.empty())
+        {
+            try
+            {
+                SaveSphereTree(*tree, file_name);
+            }
+            catch (const std::exception& e)
+            {
+                WARNING_NAMED("GetSphereTree", e.what());
+            }
+        }
+    }
+    cache[key] = tree;
+    return tree;
+}
+}  // namespace exotica
@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_TASK_MAPS_BACKWARD_DIFFERENCE_H_
+#define EXOTICA_CORE_TASK_MAPS_BACKWARD_DIFFERENCE_H_
+
+#include <algorithm>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+#include <exotica_core/tools/conversions.h>
+#include <exotica_core/tools/exception.h>
+
+namespace exotica
+{
+/// \brief Evaluates the backward difference phi_t = x_t + sum_k coefficients(k - 1) * x_{t-k} for all states of a trajectory, one state per column of x.
+/// The states before the first column are taken from previous_states, of which column k - 1 is the state k steps before it.
+inline void BackwardDifferenceTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRefConst previous_states, Eigen::VectorXdRefConst coefficients, Eigen::MatrixXdRef phi)
+{
+    if (previous_states.rows() != x.rows() || previous_states.cols() != coefficients.rows()) ThrowPretty("Wrong size of the previous states!");
+    if (phi.rows() != x.rows() || phi.cols() != x.cols()) ThrowPretty("Wrong size of phi!");
+
+    const int T = x.cols();
+    phi = x;
+    for (int k = 1; k <= coefficients.rows(); ++k)
+    {
+        const double c = coefficients(k - 1);
+        if (T > k) phi.rightCols(T - k).noalias() += c * x.leftCols(T - k);
+        for (int t = 0; t < std::min(k, T); ++t) phi.col(t).noalias() += c * previous_states.col(k - t - 1);
+    }
+}
+
+/// \brief Appends the Jacobian of BackwardDifferenceTrajectory for T states of N joints as triplets: identity blocks on the
+/// diagonal and the identity blocks of the previous states, weighted with their coefficients, below.
+inline void BackwardDifferenceTrajectoryJacobian(int T, int N, Eigen::VectorXdRefConst coefficients, std::vector<Eigen::Triplet<double>>& jacobian)
+{
+    const int num_coefficients = coefficients.rows();
+    jacobian.clear();
+    jacobian.reserve(T * N * (num_coefficients + 1));
+    for (int t = 0; t < T; ++t)
+    {
+        for (int k = 0; k <= std::min(num_coefficients, t); ++k)
+        {
+            const double c = k == 0 ? 1.0 : coefficients(k - 1);
+            for (int j = 0; j < N; ++j) jacobian.emplace_back(t * N + j, (t - k) * N + j, c);
+        }
+    }
+}
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_TASK_MAPS_BACKWARD_DIFFERENCE_H_
@@ -46,12 +46,23 @@ public:
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi) override;
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian) override;
     int TaskSpaceDim() override;
+    bool UsesSceneState() const override { return true; }
 
 private:
     void Initialize();
     void InitializeDebug();
+    void PublishDebug(Eigen::VectorXdRefConst phi);
+
+    /// \brief Computes the CoM and, if update_jacobian, its Jacobian from the masses and first moments of the subtrees of all elements.
+    /// The Jacobian column of joint j is (m_j v_j + w_j x (c_j - m_j p_j)) / M, where v_j and w_j is the twist of a unit velocity of the
+    /// joint with reference point p_j at its element, and m_j and c_j are the mass and first moment of the subtree moved by the joint.
+    void UpdateRecursive(Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian, bool update_jacobian);
 
     Eigen::VectorXd mass_;
+    bool recursive_ = true;
+    std::vector<std::shared_ptr<KinematicElement>> traversal_;  ///< Elements in depth-first order, i.e., parents before their children
+    Eigen::VectorXd subtree_mass_;                              ///< Indexed by KinematicElement::id
+    Eigen::Matrix3Xd subtree_moment_;                           ///< Mass-weighted sum of the link CoMs of each subtree
     ros::Publisher com_links_pub_;
     ros::Publisher com_pub_;
     ros::Publisher goal_pub_;
@@ -43,6 +43,7 @@ public:
 
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi) override;
     int TaskSpaceDim() override;
+    bool UsesSceneState() const override { return true; }
 
 private:
     void Initialize();
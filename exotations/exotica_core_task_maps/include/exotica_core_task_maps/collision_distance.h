@@ -33,6 +33,7 @@
 #include <algorithm>
 #include <cmath>
 #include <limits>
+#include <unordered_map>
 
 #include <exotica_core/task_map.h>
 #include <exotica_core_task_maps/collision_distance_initializer.h>
@@ -47,18 +48,28 @@ public:
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi) override;
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef J) override;
     int TaskSpaceDim() override;
+    bool UsesSceneState() const override { return true; }
 
-    std::vector<CollisionProxy> get_collision_proxies() { return closest_proxies_; }
+    std::vector<CollisionProxy> get_collision_proxies();
 
 private:
     void Initialize();
+    void UpdateHandleToJointIndex();
 
     std::vector<std::string> robot_joints_;
     std::map<std::string, std::vector<std::string>> controlled_joint_to_collision_link_map_;
+    std::unordered_map<std::string, int> collision_link_to_joint_index_;  ///< Index of the controlled joint moving each collision link
     bool check_self_collision_ = true;
     double robot_margin_;
     double world_margin_;
+    double check_margin_ = std::numeric_limits<double>::infinity();
     std::vector<CollisionProxy> closest_proxies_;
+    CollisionProxyBuffer proxies_;
+    std::vector<int> closest_proxy_index_;    ///< Index into proxies_ of the closest proxy of each joint, -1 if none
+    std::vector<double> closest_distance_;    ///< Distance of the closest proxy of each joint minus its margin
+    std::vector<int> handle_to_joint_index_;  ///< collision_link_to_joint_index_ by frame handle, -1 for other frames
+    int handle_world_version_ = -1;           ///< World version handle_to_joint_index_ was built for
+    Eigen::MatrixXd J_tmp_;
 
     int dim_;
     CollisionScenePtr cscene_;
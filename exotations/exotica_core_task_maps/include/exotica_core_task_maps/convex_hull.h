@@ -30,6 +30,10 @@
 #ifndef EXOTICA_CORE_TASK_MAPS_CONVEXHULL_H_
 #define EXOTICA_CORE_TASK_MAPS_CONVEXHULL_H_
 
+#include <algorithm>
+#include <limits>
+#include <list>
+
 #include <Eigen/Dense>
 
 #include <exotica_core/tools.h>
@@ -37,12 +41,12 @@
 namespace exotica
 {
 /// \brief DetDiff2D Computes the 2D determinant (analogous to a 2D cross product) of a two vectors defined by P_1P_2 and P_1P.
-double DetDiff2D(Eigen::VectorXdRefConst p1, Eigen::VectorXdRefConst p2, Eigen::VectorXdRefConst p)
+inline double DetDiff2D(Eigen::VectorXdRefConst p1, Eigen::VectorXdRefConst p2, Eigen::VectorXdRefConst p)
 {
     return (p(1) - p1(1)) * (p2(0) - p1(0)) - (p2(1) - p1(1)) * (p(0) - p1(0));
 }
 
-std::list<int> QuickHull(Eigen::MatrixXdRefConst points, std::list<int>& half_points, int p1, int p2)
+inline std::list<int> QuickHull(Eigen::MatrixXdRefConst points, std::list<int>& half_points, int p1, int p2)
 {
     int ind = -1;
     double max_dist = 0;
@@ -75,7 +79,7 @@ std::list<int> QuickHull(Eigen::MatrixXdRefConst points, std::list<int>& half_po
     return hull;
 }
 
-std::list<int> ConvexHull2D(Eigen::MatrixXdRefConst points)
+inline std::list<int> ConvexHull2D(Eigen::MatrixXdRefConst points)
 {
     if (points.cols() != 2) ThrowPretty("Input must contain 2D points!");
 
@@ -105,6 +109,72 @@ std::list<int> ConvexHull2D(Eigen::MatrixXdRefConst points)
 
     return hull;
 }
+
+/// \brief ConvexHull2DCache memoises the convex hull of a set of 2D points, e.g., the contact points of a support polygon.
+/// The hull is only recomputed when the number of points changed or a point moved by more than the tolerance (in either
+/// coordinate) since the hull was last computed. The queries use the current points with the vertices of the memoised hull.
+class ConvexHull2DCache
+{
+public:
+    explicit ConvexHull2DCache(double tolerance = 0.0) : tolerance_(tolerance) {}
+
+    void SetTolerance(double tolerance) { tolerance_ = tolerance; }
+
+    /// \brief Returns the indices of the points on the convex hull (clockwise), recomputing it if the points moved.
+    const std::list<int>& Update(Eigen::MatrixXdRefConst points)
+    {
+        if (num_computations_ == 0 || points.rows() != reference_points_.rows() || points.cols() != reference_points_.cols() ||
+            (points.rows() > 0 && (points - reference_points_).cwiseAbs().maxCoeff() > tolerance_))
+        {
+            reference_points_ = points;
+            hull_ = ConvexHull2D(points);
+            ++num_computations_;
+        }
+        return hull_;
+    }
+
+    /// \brief Whether p lies strictly inside the hull of the points, O(hull size).
+    bool IsInside(Eigen::MatrixXdRefConst points, Eigen::VectorXdRefConst p) const
+    {
+        if (hull_.size() < 3) return false;
+        bool has_positive = false, has_negative = false;
+        for (std::list<int>::const_iterator it = hull_.begin(); it != hull_.end(); ++it)
+        {
+            const int b = (std::next(it) == hull_.end()) ? *hull_.begin() : *std::next(it);
+            const double d = DetDiff2D(points.row(*it).transpose(), points.row(b).transpose(), p);
+            if (d >= 0.0) has_positive = true;
+            if (d <= 0.0) has_negative = true;
+            if (has_positive && has_negative) return false;
+        }
+        return true;
+    }
+
+    /// \brief Distance of p to the boundary of the hull of the points, negative inside, O(hull size).
+    double Distance(Eigen::MatrixXdRefConst points, Eigen::VectorXdRefConst p) const
+    {
+        if (hull_.empty()) return std::numeric_limits<double>::infinity();
+        double distance = std::numeric_limits<double>::infinity();
+        for (std::list<int>::const_iterator it = hull_.begin(); it != hull_.end(); ++it)
+        {
+            const int b = (std::next(it) == hull_.end()) ? *hull_.begin() : *std::next(it);
+            const Eigen::Vector2d a_p = p - points.row(*it).transpose();
+            const Eigen::Vector2d a_b = (points.row(b) - points.row(*it)).transpose();
+            const double length_squared = a_b.squaredNorm();
+            const double t = length_squared > 0.0 ? std::min(1.0, std::max(0.0, a_p.dot(a_b) / length_squared)) : 0.0;
+            distance = std::min(distance, (a_p - t * a_b).norm());
+        }
+        return IsInside(points, p) ? -distance : distance;
+    }
+
+    const std::list<int>& GetHull() const { return hull_; }
+    int GetNumComputations() const { return num_computations_; }
+
+private:
+    double tolerance_;
+    Eigen::MatrixXd reference_points_;  ///< Points the hull was computed from
+    std::list<int> hull_;
+    int num_computations_ = 0;
+};
 }  // namespace exotica
 
 #endif  // EXOTICA_CORE_TASK_MAPS_CONVEXHULL_H_
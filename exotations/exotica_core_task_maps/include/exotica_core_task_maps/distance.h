@@ -30,18 +30,25 @@
 #ifndef EXOTICA_CORE_TASK_MAPS_DISTANCE_H_
 #define EXOTICA_CORE_TASK_MAPS_DISTANCE_H_
 
-#include <exotica_core/task_map.h>
+#include <exotica_core/task_map_autodiff.h>
 
 #include <exotica_core_task_maps/distance_initializer.h>
 
 namespace exotica
 {
-class Distance : public TaskMap, public Instantiable<DistanceInitializer>
+/// \brief Distance of each frame from its base frame. The derivatives are computed with automatic differentiation.
+class Distance : public TaskMapAutoDiff<Distance>, public Instantiable<DistanceInitializer>
 {
 public:
-    void Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi) override;
-    void Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian) override;
-    void Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian, HessianRef hessian) override;
+    template <typename T>
+    void Phi(const Eigen::Matrix<T, Eigen::Dynamic, 1>& frames, Eigen::Matrix<T, Eigen::Dynamic, 1>& phi) const
+    {
+        for (int i = 0; i < phi.rows(); ++i)
+        {
+            phi(i) = frames.template segment<3>(i * 3).norm();
+        }
+    }
+
     int TaskSpaceDim() override;
 };
 }  // namespace exotica
@@ -56,6 +56,8 @@ public:
     Eigen::Vector3d GetUpperLimit(const int eff_id) const;
 
 private:
+    void UpdatePhi(Eigen::VectorXdRef phi) const;  ///< Evaluates the box limits of all end-effectors at once.
+
     Eigen::VectorXd eff_lower_;   ///< End-effector lower x, y, z limit.
     Eigen::VectorXd eff_upper_;   ///< End-effector upper x, y, z limit.
     int n_effs_;                  ///< Number of end-effectors.
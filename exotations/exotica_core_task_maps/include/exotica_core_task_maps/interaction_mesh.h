@@ -57,6 +57,13 @@ public:
     Eigen::MatrixXd GetWeights();
 
     static Eigen::VectorXd ComputeLaplace(Eigen::VectorXdRefConst eff_Phi, Eigen::MatrixXdRefConst weights, Eigen::MatrixXd* dist = nullptr, Eigen::VectorXd* wsum = nullptr);
+
+    /// \brief Computes the Laplace coordinates phi of the nodes eff_Phi, iterating over the edges of the mesh only.
+    /// Stores the distance of each node to its neighbours in edge_distances and the weight normalisers in wsum.
+    static void ComputeLaplace(Eigen::VectorXdRefConst eff_Phi, Eigen::MatrixXdRefConst weights, const std::vector<std::vector<int>>& neighbours, Eigen::VectorXdRef phi, std::vector<std::vector<double>>& edge_distances, Eigen::VectorXd& wsum);
+
+    /// \brief Returns the nodes connected to each node by a non-zero weight.
+    static std::vector<std::vector<int>> ComputeNeighbours(Eigen::MatrixXdRefConst weights);
     void ComputeGoalLaplace(const Eigen::VectorXd& x, Eigen::VectorXd& goal);
     static void ComputeGoalLaplace(const std::vector<KDL::Frame>& nodes, Eigen::VectorXd& goal, Eigen::MatrixXdRefConst weights);
 
@@ -66,8 +73,15 @@ protected:
     void DestroyDebug();
 
     Eigen::MatrixXd weights_;
+    std::vector<std::vector<int>> neighbours_;  ///< Nodes connected to each node by a non-zero weight
     int eff_size_ = 0;
 
+    // Per-edge quantities of the last update, shared by the Laplace coordinates and the Jacobian
+    Eigen::VectorXd eff_Phi_;
+    std::vector<std::vector<double>> edge_distances_;
+    Eigen::VectorXd wsum_;
+    Eigen::MatrixXd edge_derivatives_;
+
     ros::Publisher imesh_mark_pub_;
     visualization_msgs::Marker imesh_mark_;
 };
@@ -63,6 +63,10 @@ public:
 
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi) override;
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian) override;
+    bool HasTrajectoryUpdate() const override { return true; }
+    bool UsesPreviousStates() const override { return true; }
+    void UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi) override;
+    void UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi, std::vector<Eigen::Triplet<double>>& jacobian) override;
     int TaskSpaceDim() override;
 
 private:
@@ -47,6 +47,9 @@ public:
     void Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi) override;
     void Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian) override;
     void Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian, HessianRef hessian) override;
+    bool HasTrajectoryUpdate() const override { return true; }
+    void UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi) override;
+    void UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi, std::vector<Eigen::Triplet<double>>& jacobian) override;
 
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRefConst u, Eigen::VectorXdRef phi) override;
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRefConst u, Eigen::VectorXdRef phi, Eigen::MatrixXdRef dphi_dx, Eigen::MatrixXdRef dphi_du) override;
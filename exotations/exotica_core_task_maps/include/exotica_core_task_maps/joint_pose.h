@@ -44,6 +44,9 @@ public:
     void Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi) override;
     void Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian) override;
     void Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian, HessianRef hessian) override;
+    bool HasTrajectoryUpdate() const override { return true; }
+    void UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi) override;
+    void UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi, std::vector<Eigen::Triplet<double>>& jacobian) override;
     int TaskSpaceDim() override;
 
     const std::vector<int>& get_joint_map() const;
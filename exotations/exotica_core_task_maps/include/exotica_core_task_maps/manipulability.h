@@ -54,7 +54,7 @@ namespace exotica
 ///
 /// Note that
 ///   - the associated value for \f$\rho\f$ <b>must</b> be negative in order to maximize the manipulability, and
-///   - derivatives of \f$\Phi\f$ are computed using finite differences.
+///   - the Jacobian of \f$\Phi\f$ is computed analytically from one Cholesky factorisation of \f$J(x)J(x)^T\f$ per update, with finite differences only at singular configurations.
 ///
 /// Todo
 ///   - Update user options, that is allow user to specify to compute based on translation, rotation, all, yoshikawa, or asada as in Peter Corkes' toolbox (cf. https://github.com/petercorke/robotics-toolbox-matlab/blob/0ca01aac26b4475094845982b9a5e80b02c024fd/%40SerialLink/maniplty.m#L27).
@@ -63,9 +63,18 @@ class Manipulability : public TaskMap, public Instantiable<ManipulabilityInitial
 public:
     void Instantiate(const ManipulabilityInitializer& init) override;
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi) override;
+    void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian) override;
     int TaskSpaceDim() override;
+    bool UsesKinematicJacobians() const override { return true; }
 
 private:
+    /// \brief Computes the Cholesky factorisation of J J^T of end-effector i, returns false if it is singular.
+    bool Factorize(int i);
+
+    Eigen::MatrixXd jjt_;
+    Eigen::LLT<Eigen::MatrixXd> jjt_factorization_;
+    Eigen::MatrixXd jjt_inverse_j_;  ///< (J J^T)^-1 J
+
     int n_end_effs_;     ///< Number of end-effectors.
     int n_rows_of_jac_;  ///< Number of rows from the top to extract from full jacobian. Is either 3 (position) or 6 (position and rotation).
 };
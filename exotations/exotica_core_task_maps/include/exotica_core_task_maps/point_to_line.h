@@ -58,6 +58,10 @@ private:
     /// @return 3D vector from #point to its projection on #line
     Eigen::Vector3d Direction(const Eigen::Vector3d& point);
 
+    /// @brief Evaluates Direction() for all frames at once
+    /// @param directions stacked 3D vectors from the frames to their projections on #line
+    void Directions(Eigen::VectorXdRef directions) const;
+
     Eigen::Vector3d line_start_;  ///< start point of line in base frame
     Eigen::Vector3d line_end_;    ///< end point of line in base frame
     Eigen::Vector3d line_;        ///< vector from start to end point of line
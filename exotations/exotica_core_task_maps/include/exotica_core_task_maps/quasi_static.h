@@ -33,6 +33,7 @@
 #include <exotica_core/kinematic_tree.h>
 #include <exotica_core/task_map.h>
 
+#include <exotica_core_task_maps/convex_hull.h>
 #include <exotica_core_task_maps/quasi_static_initializer.h>
 
 #include <visualization_msgs/MarkerArray.h>
@@ -50,10 +51,13 @@ public:
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi) override;
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian) override;
     int TaskSpaceDim() override;
+    bool UsesSceneState() const override { return true; }
 
 private:
     void Initialize();
+    void PublishDebug(Eigen::VectorXdRefConst com, Eigen::MatrixXdRefConst supports, const std::list<int>& hull);
 
+    ConvexHull2DCache hull_cache_;  ///< Support polygon, recomputed only when the contacts move by more than HullTolerance
     visualization_msgs::MarkerArray debug_msg_;
     ros::Publisher debug_pub_;
 };
@@ -48,6 +48,7 @@ public:
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef J) override;
 
     int TaskSpaceDim() override;
+    bool UsesSceneState() const override { return true; }
 
 private:
     void Initialize();
@@ -59,6 +60,10 @@ private:
 
     const unsigned int dim_ = 1;
     CollisionScenePtr cscene_;
+    CollisionProxyBuffer robot_proxies_;
+    CollisionProxyBuffer world_proxies_;
+    Eigen::MatrixXd J_a_;
+    Eigen::MatrixXd J_b_;
 
     void UpdateInternal(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef J, bool updateJacobian = true);
 };
@@ -48,12 +48,18 @@ public:
     int TaskSpaceDim() override;
 
 private:
-    double Distance(const KDL::Frame& eff_A, const KDL::Frame& eff_B, double r_A, double r_B);
-    void Jacobian(const KDL::Frame& eff_A, const KDL::Frame& eff_B, const KDL::Jacobian& jacA, const KDL::Jacobian& jacB, double r_A, double r_B, Eigen::Block<Eigen::Ref<Eigen::MatrixXd>, 1, -1, false> ret);
+    void UpdateInternal(Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian, bool update_jacobian);
 
     std::map<std::string, std::vector<int>> groups_;
     std::vector<double> radiuses_;
 
+    std::vector<std::vector<int>> group_spheres_;    ///< Frame indices of each group, in the order of groups_
+    std::vector<Eigen::ArrayXd> group_radii_;         ///< Radii of the spheres of each group
+    std::vector<Eigen::Matrix3Xd> group_positions_;  ///< Centres of the spheres of each group, one column per sphere
+    Eigen::Matrix3Xd differences_;
+    Eigen::ArrayXd distances_;
+    Eigen::Matrix3Xd group_directions_B_;
+
     visualization_msgs::MarkerArray debug_msg_;
     ros::Publisher debug_pub_;
     double eps_;
@@ -46,6 +46,7 @@ public:
 
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi) override;
     int TaskSpaceDim() override;
+    bool UsesSceneState() const override { return true; }
 
 private:
     void Initialize();
@@ -56,6 +57,8 @@ private:
 
     unsigned int dim_ = 1;
     CollisionScenePtr cscene_;
+    CollisionProxyBuffer robot_proxies_;
+    CollisionProxyBuffer world_proxies_;
 };
 }  // namespace exotica
 
@@ -33,6 +33,8 @@
 #include <algorithm>
 #include <cmath>
 #include <limits>
+#include <utility>
+#include <vector>
 
 #include <exotica_core/task_map.h>
 #include <exotica_core_task_maps/variable_size_collision_distance_initializer.h>
@@ -47,6 +49,7 @@ public:
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi) override;
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef J) override;
     int TaskSpaceDim() override;
+    bool UsesSceneState() const override { return true; }
 
 private:
     void Initialize();
@@ -54,6 +57,11 @@ private:
 
     std::size_t dim_;
     CollisionScenePtr cscene_;
+    CollisionProxyBuffer proxies_;
+    std::vector<std::pair<int, int>> contacts_;                    ///< Witness points within the margin as (frame handle, 2 * proxy + side), sorted by link
+    Eigen::Matrix<double, Eigen::Dynamic, 6> contact_directions_;  ///< Normal and moment arm of the witness points of one link
+    Eigen::MatrixXd link_jacobian_;
+    Eigen::MatrixXd contact_jacobians_;
 
     void UpdateInternal(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef J, bool updateJacobian = true);
 };
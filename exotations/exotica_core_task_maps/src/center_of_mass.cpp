@@ -37,6 +37,13 @@ namespace exotica
 void CenterOfMass::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi)
 {
     if (phi.rows() != dim_) ThrowNamed("Wrong size of phi!");
+    if (frames_.size() == 0 && recursive_)
+    {
+        Eigen::MatrixXd jacobian(0, 0);
+        UpdateRecursive(phi, jacobian, false);
+        return;
+    }
+
     double M = mass_.sum();
     if (M == 0.0) return;
 
@@ -55,16 +62,7 @@ void CenterOfMass::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi)
     com = com / M;
     for (int i = 0; i < dim_; ++i) phi(i) = com[i];
 
-    if (debug_ && Server::IsRos())
-    {
-        com_marker_.pose.position.x = phi(0);
-        com_marker_.pose.position.y = phi(1);
-        com_marker_.pose.position.z = phi(2);
-
-        com_marker_.header.stamp = com_links_marker_.header.stamp = ros::Time::now();
-        com_links_pub_.publish(com_links_marker_);
-        com_pub_.publish(com_marker_);
-    }
+    if (debug_ && Server::IsRos()) PublishDebug(phi);
 }
 
 void CenterOfMass::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian)
@@ -74,6 +72,12 @@ void CenterOfMass::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eig
     jacobian.setZero();
     KDL::Vector com;
 
+    if (frames_.size() == 0 && recursive_)
+    {
+        UpdateRecursive(phi, jacobian, true);
+        return;
+    }
+
     if (frames_.size() > 0)
     {
         double M = mass_.sum();
@@ -126,16 +130,98 @@ void CenterOfMass::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eig
     }
     for (int i = 0; i < dim_; ++i) phi(i) = com[i];
 
-    if (debug_ && Server::IsRos())
+    if (debug_ && Server::IsRos()) PublishDebug(phi);
+}
+
+void CenterOfMass::UpdateRecursive(Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian, bool update_jacobian)
+{
+    const KinematicTree& tree = scene_->GetKinematicTree();
+    const std::vector<std::weak_ptr<KinematicElement>>& elements = tree.GetTree();
+
+    // Depth-first order from the roots, so that the subtrees can be accumulated by iterating backwards
+    traversal_.clear();
+    for (const std::weak_ptr<KinematicElement>& welement : elements)
     {
-        com_marker_.pose.position.x = phi(0);
-        com_marker_.pose.position.y = phi(1);
-        com_marker_.pose.position.z = phi(2);
+        std::shared_ptr<KinematicElement> element = welement.lock();
+        if (element && !element->parent.lock()) traversal_.push_back(element);
+    }
+    for (std::size_t i = 0; i < traversal_.size(); ++i)
+    {
+        for (const std::weak_ptr<KinematicElement>& child : traversal_[i]->children)
+        {
+            if (std::shared_ptr<KinematicElement> element = child.lock()) traversal_.push_back(element);
+        }
+    }
 
-        com_marker_.header.stamp = com_links_marker_.header.stamp = ros::Time::now();
-        com_links_pub_.publish(com_links_marker_);
-        com_pub_.publish(com_marker_);
+    if (debug_) com_links_marker_.points.resize(0);
+    subtree_mass_.setZero(elements.size());
+    subtree_moment_.setZero(3, elements.size());
+    double M = 0.0;
+    Eigen::Vector3d moment = Eigen::Vector3d::Zero();
+    for (auto it = traversal_.rbegin(); it != traversal_.rend(); ++it)
+    {
+        const std::shared_ptr<KinematicElement>& element = *it;
+        if (element->is_robot_link || element->closest_robot_link.lock())  // Only for robot links and attached objects
+        {
+            const double mass = element->segment.getInertia().getMass();
+            if (mass > 0)
+            {
+                const KDL::Vector com_local = element->frame * element->segment.getInertia().getCOG();
+                subtree_mass_(element->id) += mass;
+                subtree_moment_.col(element->id) += mass * Eigen::Map<const Eigen::Vector3d>(com_local.data);
+                if (debug_)
+                {
+                    geometry_msgs::Point pt;
+                    pt.x = com_local[0];
+                    pt.y = com_local[1];
+                    pt.z = com_local[2];
+                    com_links_marker_.points.push_back(pt);
+                }
+            }
+        }
+
+        std::shared_ptr<KinematicElement> parent = element->parent.lock();
+        if (parent)
+        {
+            subtree_mass_(parent->id) += subtree_mass_(element->id);
+            subtree_moment_.col(parent->id) += subtree_moment_.col(element->id);
+        }
+        else
+        {
+            M += subtree_mass_(element->id);
+            moment += subtree_moment_.col(element->id);
+        }
+    }
+    if (M == 0.0) return;
+    phi = (moment / M).head(dim_);
+
+    if (update_jacobian)
+    {
+        jacobian.setZero();
+        for (const std::shared_ptr<KinematicElement>& element : traversal_)
+        {
+            if (!element->is_controlled || subtree_mass_(element->id) == 0.0) continue;
+            KDL::Frame segment_reference;
+            if (element->parent.lock() != nullptr) segment_reference = element->parent.lock()->frame;
+            const KDL::Twist twist = segment_reference.M * element->segment.twist(tree.GetTreeState()(element->id), 1.0);
+            const double subtree_mass = subtree_mass_(element->id);
+            const Eigen::Vector3d velocity = subtree_mass * Eigen::Map<const Eigen::Vector3d>(twist.vel.data) + Eigen::Map<const Eigen::Vector3d>(twist.rot.data).cross(subtree_moment_.col(element->id) - subtree_mass * Eigen::Map<const Eigen::Vector3d>(element->frame.p.data));
+            jacobian.col(element->control_id) += (velocity / M).head(dim_);
+        }
     }
+
+    if (debug_ && Server::IsRos()) PublishDebug(phi);
+}
+
+void CenterOfMass::PublishDebug(Eigen::VectorXdRefConst phi)
+{
+    com_marker_.pose.position.x = phi(0);
+    com_marker_.pose.position.y = phi(1);
+    com_marker_.pose.position.z = enable_z_ ? phi(2) : 0.0;
+
+    com_marker_.header.stamp = com_links_marker_.header.stamp = ros::Time::now();
+    com_links_pub_.publish(com_links_marker_);
+    com_pub_.publish(com_marker_);
 }
 
 int CenterOfMass::TaskSpaceDim()
@@ -146,6 +232,7 @@ int CenterOfMass::TaskSpaceDim()
 void CenterOfMass::Initialize()
 {
     enable_z_ = parameters_.EnableZ;
+    recursive_ = parameters_.Recursive;
     if (enable_z_)
         dim_ = 3;
     else
@@ -51,54 +51,98 @@ void CollisionDistance::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi
 
 void CollisionDistance::UpdateInternal(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef J, bool updateJacobian)
 {
-    if (!scene_->AlwaysUpdatesCollisionScene())
-        cscene_->UpdateCollisionObjectTransforms();
+    // One pass over all robot links computes the proxies of all joints. Each proxy is assigned to the joints
+    // owning either of its links, which keep the closest one, hence robot-to-robot pairs are only computed once.
+    cscene_->GetCachedCollisionDistance(check_self_collision_, check_margin_, proxies_);
+    UpdateHandleToJointIndex();
+    const KinematicTree& tree = scene_->GetKinematicTree();
+    std::fill(closest_proxy_index_.begin(), closest_proxy_index_.end(), -1);
+    for (int p = 0; p < proxies_.Size(); ++p)
+    {
+        const KinematicElement& e1 = tree.GetElement(proxies_.e1[p]);
+        const KinematicElement& e2 = tree.GetElement(proxies_.e2[p]);
+        const bool is_robot_to_robot = (e1.is_robot_link || !e1.closest_robot_link.expired()) && (e2.is_robot_link || !e2.closest_robot_link.expired());
+        const double distance = proxies_.distance[p] - (is_robot_to_robot ? robot_margin_ : world_margin_);
+        for (const int handle : {proxies_.e1[p], proxies_.e2[p]})
+        {
+            const int i = handle_to_joint_index_[handle];
+            if (i < 0) continue;
+
+            if (closest_proxy_index_[i] < 0 || distance < closest_distance_[i])
+            {
+                closest_proxy_index_[i] = p;
+                closest_distance_[i] = distance;
+            }
+        }
+    }
 
-    // For all robot links: Get all collision distances, sort by distance, and process the closest.
+    // The distance is symmetric in the two links of a proxy, so is its Jacobian
     for (int i = 0; i < dim_; ++i)
     {
-        std::vector<CollisionProxy> proxies = cscene_->GetCollisionDistance(controlled_joint_to_collision_link_map_[robot_joints_[i]], check_self_collision_);
-        if (proxies.size() == 0)
+        const int p = closest_proxy_index_[i];
+        if (p < 0)
         {
             // phi(i) = 0;
             // J.row(i).setZero();
             continue;
         }
 
-        CollisionProxy& closest_proxy = closest_proxies_[i];
-        closest_proxy.distance = std::numeric_limits<double>::max();
-        for (const auto& tmp_proxy : proxies)
-        {
-            const bool is_robot_to_robot = (tmp_proxy.e1->is_robot_link || tmp_proxy.e1->closest_robot_link.lock()) && (tmp_proxy.e2->is_robot_link || tmp_proxy.e2->closest_robot_link.lock());
-            const double& margin = is_robot_to_robot ? robot_margin_ : world_margin_;
-            if ((tmp_proxy.distance - margin) < closest_proxy.distance)
-            {
-                closest_proxy = tmp_proxy;
-                closest_proxy.distance -= margin;
-            }
-        }
-
-        phi(i) = closest_proxy.distance;
+        phi(i) = closest_distance_[i];
 
         if (updateJacobian)
         {
-            KDL::Frame arel = KDL::Frame(closest_proxy.e1->frame.Inverse(KDL::Vector(
-                closest_proxy.contact1(0), closest_proxy.contact1(1), closest_proxy.contact1(2))));
-            KDL::Frame brel = KDL::Frame(closest_proxy.e2->frame.Inverse(KDL::Vector(
-                closest_proxy.contact2(0), closest_proxy.contact2(1), closest_proxy.contact2(2))));
-
-            Eigen::MatrixXd tmpJ = scene_->GetKinematicTree().Jacobian(
-                closest_proxy.e1, arel, nullptr, KDL::Frame());
-            J.row(i) += (closest_proxy.normal1.transpose() * tmpJ.topRows<3>());
-            tmpJ = scene_->GetKinematicTree().Jacobian(closest_proxy.e2, brel, nullptr,
-                                                       KDL::Frame());
-            J.row(i) -= (closest_proxy.normal1.transpose() * tmpJ.topRows<3>());
+            const KinematicElement& e1 = tree.GetElement(proxies_.e1[p]);
+            const KinematicElement& e2 = tree.GetElement(proxies_.e2[p]);
+            KDL::Frame arel = KDL::Frame(e1.frame.Inverse(KDL::Vector(
+                proxies_.contact1(0, p), proxies_.contact1(1, p), proxies_.contact1(2, p))));
+            KDL::Frame brel = KDL::Frame(e2.frame.Inverse(KDL::Vector(
+                proxies_.contact2(0, p), proxies_.contact2(1, p), proxies_.contact2(2, p))));
+
+            J_tmp_ = tree.Jacobian(proxies_.e1[p], arel, 0, KDL::Frame());
+            J.row(i) += (proxies_.normal1.col(p).transpose() * J_tmp_.topRows<3>());
+            J_tmp_ = tree.Jacobian(proxies_.e2[p], brel, 0, KDL::Frame());
+            J.row(i) -= (proxies_.normal1.col(p).transpose() * J_tmp_.topRows<3>());
         }
     }
 
     J *= -1;  // yup, this is was wrong since forever.
 }
 
+void CollisionDistance::UpdateHandleToJointIndex()
+{
+    // Frame handles are only stable until the tree is rebuilt, which bumps the world version
+    const KinematicTree& tree = scene_->GetKinematicTree();
+    if (handle_world_version_ == scene_->GetWorldVersion() && handle_to_joint_index_.size() == tree.GetTree().size()) return;
+
+    handle_to_joint_index_.assign(tree.GetTree().size(), -1);
+    for (const auto& it : collision_link_to_joint_index_)
+    {
+        if (tree.GetTreeMap().count(it.first)) handle_to_joint_index_[tree.GetFrameHandle(it.first)] = it.second;
+    }
+    handle_world_version_ = scene_->GetWorldVersion();
+}
+
+std::vector<CollisionProxy> CollisionDistance::get_collision_proxies()
+{
+    // Only the closest proxies are kept as CollisionProxy, the elements are looked up on request
+    const KinematicTree& tree = scene_->GetKinematicTree();
+    for (int i = 0; i < dim_; ++i)
+    {
+        const int p = closest_proxy_index_[i];
+        if (p < 0 || p >= proxies_.Size()) continue;
+
+        CollisionProxy& proxy = closest_proxies_[i];
+        proxy.e1 = tree.GetTree()[proxies_.e1[p]].lock();
+        proxy.e2 = tree.GetTree()[proxies_.e2[p]].lock();
+        proxy.contact1 = proxies_.contact1.col(p);
+        proxy.normal1 = proxies_.normal1.col(p);
+        proxy.contact2 = proxies_.contact2.col(p);
+        proxy.normal2 = proxies_.normal2.col(p);
+        proxy.distance = closest_distance_[i];
+    }
+    return closest_proxies_;
+}
+
 void CollisionDistance::AssignScene(ScenePtr scene)
 {
     scene_ = scene;
@@ -111,12 +155,21 @@ void CollisionDistance::Initialize()
     check_self_collision_ = parameters_.CheckSelfCollision;
     world_margin_ = parameters_.WorldMargin;
     robot_margin_ = parameters_.RobotMargin;
+    check_margin_ = parameters_.CheckMargin >= 0.0 ? parameters_.CheckMargin : std::numeric_limits<double>::infinity();
 
     // Get names of all controlled joints and their corresponding child links
     robot_joints_ = scene_->GetControlledJointNames();
     controlled_joint_to_collision_link_map_ = scene_->GetControlledJointToCollisionLinkMap();
     dim_ = static_cast<int>(robot_joints_.size());
     closest_proxies_.assign(dim_, CollisionProxy());
+    closest_proxy_index_.assign(dim_, -1);
+    closest_distance_.assign(dim_, 0.0);
+    handle_world_version_ = -1;
+    collision_link_to_joint_index_.clear();
+    for (int i = 0; i < dim_; ++i)
+    {
+        for (const std::string& link : controlled_joint_to_collision_link_map_[robot_joints_[i]]) collision_link_to_joint_index_[link] = i;
+    }
     if (debug_)
     {
         HIGHLIGHT_NAMED("Collision Distance", "Dimension: " << dim_
@@ -33,58 +33,6 @@ REGISTER_TASKMAP_TYPE("Distance", exotica::Distance);
 
 namespace exotica
 {
-void Distance::Update(Eigen::VectorXdRefConst /*q*/, Eigen::VectorXdRef phi)
-{
-    if (phi.rows() != kinematics[0].Phi.rows()) ThrowNamed("Wrong size of Phi!");
-    for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
-    {
-        phi(i) = kinematics[0].Phi(i).p.Norm();
-    }
-}
-
-void Distance::Update(Eigen::VectorXdRefConst /*q*/, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian)
-{
-    if (phi.rows() != kinematics[0].Phi.rows()) ThrowNamed("Wrong size of Phi!");
-    if (jacobian.rows() != kinematics[0].jacobian.rows() || jacobian.cols() != kinematics[0].jacobian(0).data.cols()) ThrowNamed("Wrong size of jacobian! " << kinematics[0].jacobian(0).data.cols());
-    for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
-    {
-        phi(i) = kinematics[0].Phi(i).p.Norm();
-        jacobian.row(i) = (kinematics[0].Phi(i).p[0] * kinematics[0].jacobian[i].data.row(0) + kinematics[0].Phi(i).p[1] * kinematics[0].jacobian[i].data.row(1) + kinematics[0].Phi(i).p[2] * kinematics[0].jacobian[i].data.row(2)) / phi(i);
-    }
-}
-
-void Distance::Update(Eigen::VectorXdRefConst /*q*/, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian, HessianRef hessian)
-{
-    if (phi.rows() != kinematics[0].Phi.rows()) ThrowNamed("Wrong size of Phi!");
-    if (jacobian.rows() != kinematics[0].jacobian.rows() || jacobian.cols() != kinematics[0].jacobian(0).data.cols()) ThrowNamed("Wrong size of jacobian! " << kinematics[0].jacobian(0).data.cols());
-    for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
-    {
-        const double& p_x = kinematics[0].Phi(i).p[0];
-        const double& p_y = kinematics[0].Phi(i).p[1];
-        const double& p_z = kinematics[0].Phi(i).p[2];
-
-        const Eigen::RowVectorXd& dp_x_dq = kinematics[0].jacobian[i].data.row(0);
-        const Eigen::RowVectorXd& dp_y_dq = kinematics[0].jacobian[i].data.row(1);
-        const Eigen::RowVectorXd& dp_z_dq = kinematics[0].jacobian[i].data.row(2);
-        Eigen::MatrixXd& ddp_x_ddq = kinematics[0].hessian[i](0);
-        Eigen::MatrixXd& ddp_y_ddq = kinematics[0].hessian[i](1);
-        Eigen::MatrixXd& ddp_z_ddq = kinematics[0].hessian[i](2);
-
-        phi(i) = kinematics[0].Phi(i).p.Norm();
-        const Eigen::RowVectorXd jacobian_numerator = (kinematics[0].Phi(i).p[0] * kinematics[0].jacobian[i].data.row(0) + kinematics[0].Phi(i).p[1] * kinematics[0].jacobian[i].data.row(1) + kinematics[0].Phi(i).p[2] * kinematics[0].jacobian[i].data.row(2));
-        jacobian.row(i).noalias() = jacobian_numerator / phi(i);
-
-        // Two part Hessian
-        Eigen::MatrixXd hessian_part1 = -jacobian_numerator.transpose() * jacobian_numerator;
-        hessian_part1 /= std::pow((p_x * p_x + p_y * p_y + p_z * p_z), (3 / 2));
-
-        Eigen::MatrixXd hessian_part2 = (p_x * ddp_x_ddq + p_y * ddp_y_ddq + p_z * ddp_z_ddq) + (dp_x_dq.transpose() * dp_x_dq + dp_y_dq.transpose() * dp_y_dq + dp_z_dq.transpose() * dp_z_dq);
-        hessian_part2 /= phi(i);
-
-        hessian(i).noalias() = hessian_part1 + hessian_part2;
-    }
-}
-
 int Distance::TaskSpaceDim()
 {
     return kinematics[0].Phi.rows();
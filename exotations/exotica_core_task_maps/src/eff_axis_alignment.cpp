@@ -168,6 +168,21 @@ void EffAxisAlignment::Update(Eigen::VectorXdRefConst /*q*/, Eigen::VectorXdRef
     }
 }
 
+void EffAxisAlignment::Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian, HessianRef hessian)
+{
+    Update(q, phi, jacobian);
+
+    for (int i = 0; i < n_frames_; ++i)
+    {
+        // phi is linear in the positions of both frames, the Hessian is the direction-weighted sum of their position Hessians
+        hessian(i).block(0, 0, jacobian.cols(), jacobian.cols()).setZero();
+        for (int k = 0; k < 3; ++k)
+        {
+            hessian(i).block(0, 0, jacobian.cols(), jacobian.cols()) += dir_(k, i) * (kinematics[0].hessian[i + n_frames_](k) - kinematics[0].hessian[i](k));
+        }
+    }
+}
+
 int EffAxisAlignment::TaskSpaceDim()
 {
     return n_frames_;
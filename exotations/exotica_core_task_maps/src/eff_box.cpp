@@ -28,6 +28,7 @@
 //
 
 #include <exotica_core/server.h>
+#include <exotica_core/tools/effector_kernels.h>
 #include <exotica_core_task_maps/eff_box.h>
 
 REGISTER_TASKMAP_TYPE("EffBox", exotica::EffBox);
@@ -38,15 +39,7 @@ void EffBox::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi)
 {
     if (phi.rows() != TaskSpaceDim()) ThrowNamed("Wrong size of phi!");
 
-    for (int i = 0; i < n_effs_; ++i)
-    {
-        // Setup
-        const int eff_id = 3 * i;
-
-        // Compute phi
-        phi.segment(eff_id, 3) = Eigen::Map<Eigen::Vector3d>(kinematics[0].Phi(i).p.data) - eff_upper_.segment<3>(eff_id);
-        phi.segment(eff_id + three_times_n_effs_, 3) = eff_lower_.segment<3>(eff_id) - Eigen::Map<Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
-    }
+    UpdatePhi(phi);
 
     if (debug_ && Server::IsRos()) PublishObjectsAsMarkerArray();
 }
@@ -56,21 +49,21 @@ void EffBox::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::Ma
     if (phi.rows() != TaskSpaceDim()) ThrowNamed("Wrong size of phi!");
     if (jacobian.rows() != TaskSpaceDim() || jacobian.cols() != kinematics[0].jacobian(0).data.cols()) ThrowNamed("Wrong size of jacobian! " << kinematics[0].jacobian(0).data.cols());
 
-    for (int i = 0; i < n_effs_; ++i)
-    {
-        // Setup
-        const int eff_id = 3 * i;
-
-        // Compute phi and jacobian
-        phi.segment(eff_id, 3) = Eigen::Map<Eigen::Vector3d>(kinematics[0].Phi(i).p.data) - eff_upper_.segment<3>(eff_id);
-        phi.segment(eff_id + three_times_n_effs_, 3) = eff_lower_.segment<3>(eff_id) - Eigen::Map<Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
-        jacobian.middleRows(eff_id, 3) = kinematics[0].jacobian(i).data.topRows<3>();
-        jacobian.middleRows(eff_id + three_times_n_effs_, 3) = -kinematics[0].jacobian(i).data.topRows<3>();
-    }
+    UpdatePhi(phi);
+    StackFrameJacobians<3>(kinematics[0], jacobian, 0, 1.0);
+    StackFrameJacobians<3>(kinematics[0], jacobian, three_times_n_effs_, -1.0);
 
     if (debug_ && Server::IsRos()) PublishObjectsAsMarkerArray();
 }
 
+void EffBox::UpdatePhi(Eigen::VectorXdRef phi) const
+{
+    // Upper limits in the first half of phi, lower limits in the second half
+    const FramePositionsMap positions = GetFramePositions(kinematics[0]);
+    Eigen::Map<Eigen::Matrix3Xd>(phi.data(), 3, n_effs_) = positions - Eigen::Map<const Eigen::Matrix3Xd>(eff_upper_.data(), 3, n_effs_);
+    Eigen::Map<Eigen::Matrix3Xd>(phi.data() + three_times_n_effs_, 3, n_effs_) = Eigen::Map<const Eigen::Matrix3Xd>(eff_lower_.data(), 3, n_effs_) - positions;
+}
+
 Eigen::Vector3d EffBox::GetLowerLimit(const int eff_id) const
 {
     if (eff_id < 0 || eff_id >= n_effs_) ThrowNamed("Given eff_id (" << eff_id << ") is out of range [0, " << n_effs_ << ")!");
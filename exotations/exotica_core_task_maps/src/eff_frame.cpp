@@ -27,6 +27,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <exotica_core/tools/effector_kernels.h>
 #include <exotica_core_task_maps/eff_frame.h>
 
 REGISTER_TASKMAP_TYPE("EffFrame", exotica::EffFrame);
@@ -53,9 +54,9 @@ std::vector<TaskVectorEntry> EffFrame::GetLieGroupIndices()
 void EffFrame::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi)
 {
     if (phi.rows() != kinematics[0].Phi.rows() * big_stride_) ThrowNamed("Wrong size of Phi!");
+    Eigen::Map<Eigen::Matrix3Xd, 0, Eigen::OuterStride<>>(phi.data(), 3, kinematics[0].Phi.rows(), Eigen::OuterStride<>(big_stride_)) = GetFramePositions(kinematics[0]);
     for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
     {
-        phi.segment<3>(i * big_stride_) = Eigen::Map<Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
         phi.segment(i * big_stride_ + 3, small_stride_) = SetRotation(kinematics[0].Phi(i).M, rotation_type_);
     }
 }
@@ -64,11 +65,11 @@ void EffFrame::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::
 {
     if (phi.rows() != kinematics[0].Phi.rows() * big_stride_) ThrowNamed("Wrong size of Phi!");
     if (jacobian.rows() != kinematics[0].jacobian.rows() * 6 || jacobian.cols() != kinematics[0].jacobian(0).data.cols()) ThrowNamed("Wrong size of jacobian! " << kinematics[0].jacobian(0).data.cols());
+    Eigen::Map<Eigen::Matrix3Xd, 0, Eigen::OuterStride<>>(phi.data(), 3, kinematics[0].Phi.rows(), Eigen::OuterStride<>(big_stride_)) = GetFramePositions(kinematics[0]);
+    StackFrameJacobians<6>(kinematics[0], jacobian);
     for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
     {
-        phi.segment<3>(i * big_stride_) = Eigen::Map<Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
         phi.segment(i * big_stride_ + 3, small_stride_) = SetRotation(kinematics[0].Phi(i).M, rotation_type_);
-        jacobian.middleRows<6>(i * 6) = kinematics[0].jacobian[i].data;
     }
 }
 
@@ -76,11 +77,11 @@ void EffFrame::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::
 {
     if (phi.rows() != kinematics[0].Phi.rows() * big_stride_) ThrowNamed("Wrong size of Phi!");
     if (jacobian.rows() != kinematics[0].jacobian.rows() * 6 || jacobian.cols() != kinematics[0].jacobian(0).data.cols()) ThrowNamed("Wrong size of jacobian! " << kinematics[0].jacobian(0).data.cols());
+    Eigen::Map<Eigen::Matrix3Xd, 0, Eigen::OuterStride<>>(phi.data(), 3, kinematics[0].Phi.rows(), Eigen::OuterStride<>(big_stride_)) = GetFramePositions(kinematics[0]);
+    StackFrameJacobians<6>(kinematics[0], jacobian);
     for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
     {
-        phi.segment<3>(i * big_stride_) = Eigen::Map<Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
         phi.segment(i * big_stride_ + 3, small_stride_) = SetRotation(kinematics[0].Phi(i).M, rotation_type_);
-        jacobian.middleRows<6>(i * 6) = kinematics[0].jacobian[i].data;
 
         for (int j = 0; j < 6; ++j)
         {
@@ -27,6 +27,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <exotica_core/tools/effector_kernels.h>
 #include <exotica_core_task_maps/eff_position.h>
 
 REGISTER_TASKMAP_TYPE("EffPosition", exotica::EffPosition);
@@ -36,32 +37,25 @@ namespace exotica
 void EffPosition::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi)
 {
     if (phi.rows() != kinematics[0].Phi.rows() * 3) ThrowNamed("Wrong size of Phi!");
-    for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
-    {
-        phi.segment<3>(i * 3) = Eigen::Map<Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
-    }
+    Eigen::Map<Eigen::Matrix3Xd>(phi.data(), 3, kinematics[0].Phi.rows()) = GetFramePositions(kinematics[0]);
 }
 
 void EffPosition::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian)
 {
     if (phi.rows() != kinematics[0].Phi.rows() * 3) ThrowNamed("Wrong size of Phi!");
     if (jacobian.rows() != kinematics[0].jacobian.rows() * 3 || jacobian.cols() != kinematics[0].jacobian(0).data.cols()) ThrowNamed("Wrong size of jacobian! " << kinematics[0].jacobian(0).data.cols());
-    for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
-    {
-        phi.segment<3>(i * 3) = Eigen::Map<Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
-        jacobian.middleRows<3>(i * 3) = kinematics[0].jacobian[i].data.topRows<3>();
-    }
+    Eigen::Map<Eigen::Matrix3Xd>(phi.data(), 3, kinematics[0].Phi.rows()) = GetFramePositions(kinematics[0]);
+    StackFrameJacobians<3>(kinematics[0], jacobian);
 }
 
 void EffPosition::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian, HessianRef hessian)
 {
     if (phi.rows() != kinematics[0].Phi.rows() * 3) ThrowNamed("Wrong size of Phi!");
     if (jacobian.rows() != kinematics[0].jacobian.rows() * 3 || jacobian.cols() != kinematics[0].jacobian(0).data.cols()) ThrowNamed("Wrong size of jacobian! " << kinematics[0].jacobian(0).data.cols());
+    Eigen::Map<Eigen::Matrix3Xd>(phi.data(), 3, kinematics[0].Phi.rows()) = GetFramePositions(kinematics[0]);
+    StackFrameJacobians<3>(kinematics[0], jacobian);
     for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
     {
-        phi.segment<3>(i * 3) = Eigen::Map<Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
-        jacobian.middleRows<3>(i * 3) = kinematics[0].jacobian[i].data.topRows<3>();
-
         for (int j = 0; j < 3; ++j)
         {
             hessian(i * 3 + j).block(0, 0, jacobian.cols(), jacobian.cols()) = kinematics[0].hessian[i](j);
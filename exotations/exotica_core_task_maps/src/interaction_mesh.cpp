@@ -43,14 +43,12 @@ void InteractionMesh::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi)
 
     if (phi.rows() != M * 3) ThrowNamed("Wrong size of Phi!");
 
-    Eigen::VectorXd eff_Phi;
+    eff_Phi_.resize(M * 3);
     for (int i = 0; i < M; ++i)
     {
-        eff_Phi(i * 3) = kinematics[0].Phi(i).p[0];
-        eff_Phi(i * 3 + 1) = kinematics[0].Phi(i).p[1];
-        eff_Phi(i * 3 + 2) = kinematics[0].Phi(i).p[2];
+        eff_Phi_.segment<3>(i * 3) = Eigen::Map<const Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
     }
-    phi = ComputeLaplace(eff_Phi, weights_);
+    ComputeLaplace(eff_Phi_, weights_, neighbours_, phi, edge_distances_, wsum_);
 
     if (debug_) Debug(phi);
 }
@@ -63,59 +61,49 @@ void InteractionMesh::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi,
     if (phi.rows() != M * 3) ThrowNamed("Wrong size of Phi!");
     if (jacobian.rows() != M * 3 || jacobian.cols() != N) ThrowNamed("Wrong size of jacobian! " << N);
 
-    Eigen::MatrixXd dist;
-    Eigen::VectorXd wsum;
-    Eigen::VectorXd eff_Phi(M * 3);
+    eff_Phi_.resize(M * 3);
     for (int i = 0; i < M; ++i)
     {
-        eff_Phi(i * 3) = kinematics[0].Phi(i).p[0];
-        eff_Phi(i * 3 + 1) = kinematics[0].Phi(i).p[1];
-        eff_Phi(i * 3 + 2) = kinematics[0].Phi(i).p[2];
+        eff_Phi_.segment<3>(i * 3) = Eigen::Map<const Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
     }
-    phi = ComputeLaplace(eff_Phi, weights_, &dist, &wsum);
+    ComputeLaplace(eff_Phi_, weights_, neighbours_, phi, edge_distances_, wsum_);
 
-    double A, _A, Sk, Sl, w, _w;
-    int i, j, k, l;
-    Eigen::Vector3d distance, _distance = Eigen::Vector3d::Zero(3, 1);
-    for (i = 0; i < N; ++i)
+    // Node j has the Laplace coordinates phi_j = p_j - sum_l w_jl p_l with w_jl = W_jl / (d_jl wsum_j), where wsum_j = sum_k W_jk / d_jk.
+    // Only the edges with positive weights contribute to the Jacobian. The derivatives of their distances, S_jl = (p_j - p_l)^T (J_j - J_l) / d_jl,
+    // are computed once per edge, and dA_jl/dq = d(d_jl wsum_j)/dq = S_jl P_j - d_jl T_j with P_j = sum_k W_jk / d_jk and T_j = sum_k W_jk S_jk / d_jk^2.
+    for (int j = 0; j < M; ++j)
     {
-        for (j = 0; j < M; ++j)
+        const Eigen::MatrixXd& jacobian_j = kinematics[0].jacobian[j].data;
+        jacobian.middleRows<3>(3 * j) = jacobian_j.topRows<3>();
+
+        const std::vector<int>& neighbours = neighbours_[j];
+        const std::vector<double>& dist = edge_distances_[j];
+        const int num_edges = static_cast<int>(neighbours.size());
+        edge_derivatives_.resize(num_edges, N);
+        double positive_weight_sum = 0.0;
+        Eigen::RowVectorXd weighted_derivative_sum = Eigen::RowVectorXd::Zero(N);
+        for (int e = 0; e < num_edges; ++e)
         {
-            if (j < M)
-                jacobian.block(3 * j, i, 3, 1) = kinematics[0].jacobian[j].data.block(0, i, 3, 1);
-            for (l = 0; l < M; ++l)
+            const int l = neighbours[e];
+            if (dist[e] > 0 && weights_(j, l) > 0)
             {
-                if (j != l)
-                {
-                    if (dist(j, l) > 0 && wsum(j) > 0 && weights_(j, l) > 0)
-                    {
-                        A = dist(j, l) * wsum(j);
-                        w = weights_(j, l) / A;
-
-                        _A = 0;
-                        distance = eff_Phi.segment(j * 3, 3) - eff_Phi.segment(l * 3, 3);
-                        _distance = kinematics[0].jacobian[j].data.block(0, i, 3, 1) - kinematics[0].jacobian[l].data.block(0, i, 3, 1);
-
-                        Sl = distance.dot(_distance) / dist(j, l);
-                        for (k = 0; k < M; ++k)
-                        {
-                            if (j != k && dist(j, k) > 0 && weights_(j, k) > 0)
-                            {
-                                distance = eff_Phi.segment(j * 3, 3) - eff_Phi.segment(k * 3, 3);
-                                _distance = kinematics[0].jacobian[j].data.block(0, i, 3, 1) - kinematics[0].jacobian[k].data.block(0, i, 3, 1);
-                                Sk = distance.dot(_distance) / dist(j, k);
-                                _A += weights_(j, k) * (Sl * dist(j, k) - Sk * dist(j, l)) / (dist(j, k) * dist(j, k));
-                            }
-                        }
-                        _w = -weights_(j, l) * _A / (A * A);
-                    }
-                    else
-                    {
-                        _w = 0;
-                        w = 0;
-                    }
-                    jacobian.block(3 * j, i, 3, 1) -= eff_Phi.segment(l * 3, 3) * _w + kinematics[0].jacobian[l].data.block(0, i, 3, 1) * w;
-                }
+                const Eigen::Vector3d distance = eff_Phi_.segment<3>(j * 3) - eff_Phi_.segment<3>(l * 3);
+                edge_derivatives_.row(e).noalias() = distance.transpose() * (jacobian_j.topRows<3>() - kinematics[0].jacobian[l].data.topRows<3>()) / dist[e];
+                positive_weight_sum += weights_(j, l) / dist[e];
+                weighted_derivative_sum += weights_(j, l) * edge_derivatives_.row(e) / (dist[e] * dist[e]);
+            }
+        }
+
+        if (wsum_(j) <= 0) continue;
+        for (int e = 0; e < num_edges; ++e)
+        {
+            const int l = neighbours[e];
+            if (dist[e] > 0 && weights_(j, l) > 0)
+            {
+                const double A = dist[e] * wsum_(j);
+                const double w = weights_(j, l) / A;
+                const Eigen::RowVectorXd _w = -weights_(j, l) * (edge_derivatives_.row(e) * positive_weight_sum - dist[e] * weighted_derivative_sum) / (A * A);
+                jacobian.middleRows<3>(3 * j).noalias() -= eff_Phi_.segment<3>(l * 3) * _w + kinematics[0].jacobian[l].data.topRows<3>() * w;
             }
         }
     }
@@ -146,10 +134,11 @@ void InteractionMesh::Instantiate(const InteractionMeshInitializer& init)
     weights_.setOnes(eff_size_, eff_size_);
     if (init.Weights.rows() == eff_size_ * eff_size_)
     {
-        weights_.array() = init.Weights.array();
+        weights_ = Eigen::Map<const Eigen::MatrixXd>(init.Weights.data(), eff_size_, eff_size_);
         HIGHLIGHT("Loading iMesh weights.\n"
                   << weights_);
     }
+    neighbours_ = ComputeNeighbours(weights_);
 }
 
 void InteractionMesh::AssignScene(ScenePtr scene)
@@ -242,50 +231,70 @@ int InteractionMesh::TaskSpaceDim()
     return 3 * eff_size_;
 }
 
-Eigen::VectorXd InteractionMesh::ComputeLaplace(Eigen::VectorXdRefConst eff_Phi, Eigen::MatrixXdRefConst weights, Eigen::MatrixXd* dist_ptr, Eigen::VectorXd* wsum_ptr)
+std::vector<std::vector<int>> InteractionMesh::ComputeNeighbours(Eigen::MatrixXdRefConst weights)
 {
-    int N = eff_Phi.rows() / 3;
-    Eigen::VectorXd Phi = Eigen::VectorXd::Zero(N * 3);
-    Eigen::MatrixXd dist = Eigen::MatrixXd::Zero(N, N);
-    Eigen::VectorXd wsum = Eigen::VectorXd::Zero(N);
-    /** Compute distance matrix (inverse proportional) */
+    std::vector<std::vector<int>> neighbours(weights.rows());
+    for (int j = 0; j < weights.rows(); ++j)
+    {
+        for (int l = 0; l < weights.cols(); ++l)
+        {
+            if (j != l && weights(j, l) != 0.0) neighbours[j].push_back(l);
+        }
+    }
+    return neighbours;
+}
+
+void InteractionMesh::ComputeLaplace(Eigen::VectorXdRefConst eff_Phi, Eigen::MatrixXdRefConst weights, const std::vector<std::vector<int>>& neighbours, Eigen::VectorXdRef phi, std::vector<std::vector<double>>& edge_distances, Eigen::VectorXd& wsum)
+{
+    const int N = eff_Phi.rows() / 3;
+    edge_distances.resize(N);
+    wsum.setZero(N);
+    /** Compute the distances along the edges and the weight normaliser */
     for (int j = 0; j < N; ++j)
     {
-        for (int l = j + 1; l < N; ++l)
+        edge_distances[j].resize(neighbours[j].size());
+        for (std::size_t e = 0; e < neighbours[j].size(); ++e)
         {
-            if (!(j >= N && l >= N))
-            {
-                dist(j, l) = dist(l, j) = (eff_Phi.segment(j * 3, 3) - eff_Phi.segment(l * 3, 3)).norm();
-            }
+            const int l = neighbours[j][e];
+            edge_distances[j][e] = (eff_Phi.segment<3>(j * 3) - eff_Phi.segment<3>(l * 3)).norm();
+            if (edge_distances[j][e] > 0) wsum(j) += weights(j, l) / edge_distances[j][e];
         }
     }
-    /** Computer weight normaliser */
+    /** Compute Laplace coordinates */
     for (int j = 0; j < N; ++j)
     {
-        for (int l = 0; l < N; ++l)
+        phi.segment<3>(j * 3) = eff_Phi.segment<3>(j * 3);
+        if (wsum(j) <= 0) continue;
+        for (std::size_t e = 0; e < neighbours[j].size(); ++e)
         {
-            if (dist(j, l) > 0 && j != l)
+            const int l = neighbours[j][e];
+            if (edge_distances[j][e] > 0)
             {
-                wsum(j) += weights(j, l) / dist(j, l);
+                phi.segment<3>(j * 3) -= eff_Phi.segment<3>(l * 3) * weights(j, l) / (edge_distances[j][e] * wsum(j));
             }
         }
     }
-    /** Compute Laplace coordinates */
-    for (int j = 0; j < N; ++j)
+}
+
+Eigen::VectorXd InteractionMesh::ComputeLaplace(Eigen::VectorXdRefConst eff_Phi, Eigen::MatrixXdRefConst weights, Eigen::MatrixXd* dist_ptr, Eigen::VectorXd* wsum_ptr)
+{
+    int N = eff_Phi.rows() / 3;
+    Eigen::VectorXd Phi(N * 3);
+    std::vector<std::vector<double>> edge_distances;
+    Eigen::VectorXd wsum;
+    ComputeLaplace(eff_Phi, weights, ComputeNeighbours(weights), Phi, edge_distances, wsum);
+    if (dist_ptr)
     {
-        Phi.segment(j * 3, 3) = eff_Phi.segment(j * 3, 3);
-        for (int l = 0; l < N; ++l)
+        /** Compute distance matrix */
+        dist_ptr->setZero(N, N);
+        for (int j = 0; j < N; ++j)
         {
-            if (j != l)
+            for (int l = j + 1; l < N; ++l)
             {
-                if (dist(j, l) > 0 && wsum(j) > 0)
-                {
-                    Phi.segment(j * 3, 3) -= eff_Phi.segment(l * 3, 3) * weights(j, l) / (dist(j, l) * wsum(j));
-                }
+                (*dist_ptr)(j, l) = (*dist_ptr)(l, j) = (eff_Phi.segment<3>(j * 3) - eff_Phi.segment<3>(l * 3)).norm();
             }
         }
     }
-    if (dist_ptr) *dist_ptr = dist;
     if (wsum_ptr) *wsum_ptr = wsum;
     return Phi;
 }
@@ -306,7 +315,7 @@ void InteractionMesh::ComputeGoalLaplace(const std::vector<KDL::Frame>& nodes, E
 void InteractionMesh::ComputeGoalLaplace(const Eigen::VectorXd& x, Eigen::VectorXd& goal)
 {
     scene_->Update(x);
-    Eigen::VectorXd eff_Phi;
+    Eigen::VectorXd eff_Phi(3 * eff_size_);
     for (int i = 0; i < eff_size_; ++i)
     {
         eff_Phi(i * 3) = kinematics[0].Phi(i).p[0];
@@ -328,6 +337,7 @@ void InteractionMesh::SetWeight(int i, int j, double weight)
         ThrowNamed("Invalid weight: " << weight);
     }
     weights_(i, j) = weight;
+    neighbours_ = ComputeNeighbours(weights_);
 }
 
 void InteractionMesh::SetWeights(const Eigen::MatrixXd& weights)
@@ -338,5 +348,6 @@ void InteractionMesh::SetWeights(const Eigen::MatrixXd& weights)
         ThrowNamed("Invalid weight matrix (" << weights.rows() << "X" << weights.cols() << "). Has to be" << M << "x" << M);
     }
     weights_ = weights;
+    neighbours_ = ComputeNeighbours(weights_);
 }
 }  // namespace exotica
@@ -27,6 +27,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <exotica_core_task_maps/backward_difference.h>
 #include <exotica_core_task_maps/joint_acceleration_backward_difference.h>
 
 REGISTER_TASKMAP_TYPE("JointAccelerationBackwardDifference", exotica::JointAccelerationBackwardDifference);
@@ -98,6 +99,18 @@ void JointAccelerationBackwardDifference::Update(Eigen::VectorXdRefConst x, Eige
     jacobian = I_;
 }
 
+void JointAccelerationBackwardDifference::UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi)
+{
+    if (x.rows() != N_) ThrowNamed("Wrong size of x!");
+    BackwardDifferenceTrajectory(x, q_, backward_difference_params_, phi);
+}
+
+void JointAccelerationBackwardDifference::UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi, std::vector<Eigen::Triplet<double>>& jacobian)
+{
+    UpdateTrajectory(x, phi);
+    BackwardDifferenceTrajectoryJacobian(x.cols(), N_, backward_difference_params_, jacobian);
+}
+
 int JointAccelerationBackwardDifference::TaskSpaceDim()
 {
     return N_;
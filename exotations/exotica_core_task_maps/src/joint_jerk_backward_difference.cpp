@@ -27,6 +27,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <exotica_core_task_maps/backward_difference.h>
 #include <exotica_core_task_maps/joint_jerk_backward_difference.h>
 
 REGISTER_TASKMAP_TYPE("JointJerkBackwardDifference", exotica::JointJerkBackwardDifference);
@@ -99,6 +100,18 @@ void JointJerkBackwardDifference::Update(Eigen::VectorXdRefConst x, Eigen::Vecto
     jacobian = I_;
 }
 
+void JointJerkBackwardDifference::UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi)
+{
+    if (x.rows() != N_) ThrowNamed("Wrong size of x!");
+    BackwardDifferenceTrajectory(x, q_, backward_difference_params_, phi);
+}
+
+void JointJerkBackwardDifference::UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi, std::vector<Eigen::Triplet<double>>& jacobian)
+{
+    UpdateTrajectory(x, phi);
+    BackwardDifferenceTrajectoryJacobian(x.cols(), N_, backward_difference_params_, jacobian);
+}
+
 int JointJerkBackwardDifference::TaskSpaceDim()
 {
     return N_;
@@ -95,6 +95,38 @@ void JointLimit::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen
     Update(x, phi, jacobian);
 }
 
+void JointLimit::UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi)
+{
+    if (x.rows() != N) ThrowNamed("Wrong size of x!");
+    if (phi.rows() != N || phi.cols() != x.cols()) ThrowNamed("Wrong size of phi!");
+
+    const Eigen::MatrixXd& limits = scene_->GetKinematicTree().GetJointLimits();
+    const Eigen::VectorXd tau = 0.5 * safe_percentage_ * (limits.col(1) - limits.col(0));
+    const Eigen::ArrayXXd low_limits = (limits.col(0) + tau).array().replicate(1, x.cols());
+    const Eigen::ArrayXXd high_limits = (limits.col(1) - tau).array().replicate(1, x.cols());
+
+    phi = (x.array() < low_limits).select(x.array() - low_limits, (x.array() > high_limits).select(x.array() - high_limits, 0.0)).matrix();
+}
+
+void JointLimit::UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi, std::vector<Eigen::Triplet<double>>& jacobian)
+{
+    UpdateTrajectory(x, phi);
+
+    // Diagonal blocks, 0 within the limits and 1 outside
+    const Eigen::MatrixXd& limits = scene_->GetKinematicTree().GetJointLimits();
+    const Eigen::VectorXd tau = 0.5 * safe_percentage_ * (limits.col(1) - limits.col(0));
+    jacobian.clear();
+    jacobian.reserve(x.cols() * N);
+    for (int t = 0; t < x.cols(); ++t)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            const bool within_limits = x(i, t) >= limits(i, 0) + tau(i) && x(i, t) <= limits(i, 1) - tau(i);
+            jacobian.emplace_back(t * N + i, t * N + i, within_limits ? 0.0 : 1.0);
+        }
+    }
+}
+
 void JointLimit::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRefConst u, Eigen::VectorXdRef phi)
 {
     Update(x.head(scene_->get_num_positions()), phi);
@@ -59,6 +59,30 @@ void JointPose::Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen:
     Update(q, phi, jacobian);
 }
 
+void JointPose::UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi)
+{
+    if (x.rows() != num_controlled_joints_) ThrowNamed("Wrong size of x!");
+    if (phi.rows() != static_cast<int>(joint_map_.size()) || phi.cols() != x.cols()) ThrowNamed("Wrong size of Phi!");
+    for (std::size_t i = 0; i < joint_map_.size(); ++i)
+    {
+        phi.row(i) = x.row(joint_map_[i]).array() - joint_ref_(i);
+    }
+}
+
+void JointPose::UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi, std::vector<Eigen::Triplet<double>>& jacobian)
+{
+    UpdateTrajectory(x, phi);
+    jacobian.clear();
+    jacobian.reserve(x.cols() * joint_map_.size());
+    for (int t = 0; t < x.cols(); ++t)
+    {
+        for (std::size_t i = 0; i < joint_map_.size(); ++i)
+        {
+            jacobian.emplace_back(t * joint_map_.size() + i, t * num_controlled_joints_ + joint_map_[i], 1.0);
+        }
+    }
+}
+
 void JointPose::AssignScene(ScenePtr scene)
 {
     scene_ = scene;
@@ -27,6 +27,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <exotica_core_task_maps/backward_difference.h>
 #include <exotica_core_task_maps/joint_velocity_backward_difference.h>
 
 REGISTER_TASKMAP_TYPE("JointVelocityBackwardDifference", exotica::JointVelocityBackwardDifference);
@@ -91,6 +92,18 @@ void JointVelocityBackwardDifference::Update(Eigen::VectorXdRefConst q, Eigen::V
     jacobian = I_;
 }
 
+void JointVelocityBackwardDifference::UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi)
+{
+    if (x.rows() != N_) ThrowNamed("Wrong size of x!");
+    BackwardDifferenceTrajectory(x, q_, Eigen::VectorXd::Constant(1, backward_difference_params_), phi);
+}
+
+void JointVelocityBackwardDifference::UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi, std::vector<Eigen::Triplet<double>>& jacobian)
+{
+    UpdateTrajectory(x, phi);
+    BackwardDifferenceTrajectoryJacobian(x.cols(), N_, Eigen::VectorXd::Constant(1, backward_difference_params_), jacobian);
+}
+
 int JointVelocityBackwardDifference::TaskSpaceDim()
 {
     return N_;
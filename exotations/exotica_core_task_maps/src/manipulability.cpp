@@ -27,20 +27,82 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <algorithm>
+
 #include <exotica_core_task_maps/manipulability.h>
 
 REGISTER_TASKMAP_TYPE("Manipulability", exotica::Manipulability);
 
 namespace exotica
 {
+bool Manipulability::Factorize(int i)
+{
+    const Eigen::MatrixXd& J = kinematics[0].jacobian[i].data;
+    jjt_.noalias() = J.topRows(n_rows_of_jac_) * J.topRows(n_rows_of_jac_).transpose();
+    jjt_factorization_.compute(jjt_);
+    return jjt_factorization_.info() == Eigen::Success;
+}
+
 void Manipulability::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi)
 {
     if (phi.rows() != TaskSpaceDim()) ThrowNamed("Wrong size of phi!");
 
     for (int i = 0; i < n_end_effs_; ++i)
     {
-        const Eigen::MatrixXd& J = kinematics[0].jacobian[i].data.topRows(n_rows_of_jac_);
-        phi(i) = -std::sqrt((J * J.transpose()).determinant());
+        // sqrt(det(J J^T)) is the product of the diagonal of the Cholesky factor
+        if (Factorize(i))
+        {
+            phi(i) = -jjt_factorization_.matrixLLT().diagonal().prod();
+        }
+        else
+        {
+            phi(i) = -std::sqrt(std::max(0.0, jjt_.determinant()));
+        }
+    }
+}
+
+void Manipulability::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian)
+{
+    if (phi.rows() != TaskSpaceDim()) ThrowNamed("Wrong size of phi!");
+    if (jacobian.rows() != TaskSpaceDim() || jacobian.cols() != kinematics[0].jacobian(0).data.cols()) ThrowNamed("Wrong size of jacobian! " << kinematics[0].jacobian(0).data.cols());
+
+    if (!parameters_.AnalyticJacobian)
+    {
+        TaskMap::Update(x, phi, jacobian);
+        return;
+    }
+
+    for (int i = 0; i < n_end_effs_; ++i)
+    {
+        // Singular configurations fall back to finite differences
+        if (!Factorize(i))
+        {
+            TaskMap::Update(x, phi, jacobian);
+            return;
+        }
+        const Eigen::MatrixXd& J = kinematics[0].jacobian[i].data;
+        const double m = jjt_factorization_.matrixLLT().diagonal().prod();
+        phi(i) = -m;
+
+        // dm/dq_b = m tr((J J^T)^-1 J dJ^T/dq_b), with the derivatives of the Jacobian columns from the kinematic Hessian:
+        // dv_a/dq_b = w_p x v_d and dw_d/dq_p = w_p x w_d, where p is the more proximal and d the more distal of the joints a and b.
+        jjt_inverse_j_ = jjt_factorization_.solve(J.topRows(n_rows_of_jac_));
+        jacobian.row(i).setZero();
+        const std::vector<int>& columns = kinematics[0].frame[i].jacobian_columns;
+        for (std::size_t k = 0; k < columns.size(); ++k)
+        {
+            const int p = columns[k];
+            const Eigen::Vector3d w_p = J.block<3, 1>(3, p);
+            for (std::size_t l = k; l < columns.size(); ++l)
+            {
+                const int d = columns[l];
+                const Eigen::Vector3d dv = w_p.cross(J.block<3, 1>(0, d));
+                jacobian(i, d) -= m * jjt_inverse_j_.block<3, 1>(0, p).dot(dv);
+                if (p == d) continue;
+                jacobian(i, p) -= m * jjt_inverse_j_.block<3, 1>(0, d).dot(dv);
+                if (n_rows_of_jac_ == 6) jacobian(i, p) -= m * jjt_inverse_j_.block<3, 1>(3, d).dot(w_p.cross(J.block<3, 1>(3, d)));
+            }
+        }
     }
 }
 
@@ -28,6 +28,7 @@
 //
 
 #include <exotica_core/server.h>
+#include <exotica_core/tools/effector_kernels.h>
 #include <exotica_core_task_maps/point_to_line.h>
 
 REGISTER_TASKMAP_TYPE("PointToLine", exotica::PointToLine);
@@ -84,37 +85,62 @@ void PointToLine::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi)
 {
     if (phi.rows() != kinematics[0].Phi.rows() * 3) ThrowNamed("Wrong size of phi!");
 
-    for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
+    if (debug_)
+    {
+        for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
+        {
+            const Eigen::Vector3d p = line_start_ + Eigen::Map<const Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
+            phi.segment<3>(i * 3) = -Direction(p);
+        }
+    }
+    else
     {
-        const Eigen::Vector3d p = line_start_ + Eigen::Map<const Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
-        phi.segment<3>(i * 3) = -Direction(p);
+        Directions(phi);
+        phi = -phi;
     }
 }
 
+void PointToLine::Directions(Eigen::VectorXdRef directions) const
+{
+    // Same as Direction() for all frames at once: with p = line_start_ + position, t = (position * line_) / |line_|^2
+    const FramePositionsMap positions = GetFramePositions(kinematics[0]);
+    Eigen::RowVectorXd t = (line_.transpose() * positions) / line_.squaredNorm();
+    if (!infinite_) t = t.cwiseMax(0.0).cwiseMin(1.0);
+    Eigen::Map<Eigen::Matrix3Xd>(directions.data(), 3, positions.cols()).noalias() = line_ * t - positions;
+}
+
 void PointToLine::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian)
 {
     if (phi.rows() != kinematics[0].Phi.rows() * 3) ThrowNamed("Wrong size of phi!");
     if (jacobian.rows() != kinematics[0].jacobian.rows() * 3 || jacobian.cols() != kinematics[0].jacobian(0).data.cols()) ThrowNamed("Wrong size of jacobian! " << kinematics[0].jacobian(0).data.cols());
 
+    if (debug_)
+    {
+        for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
+        {
+            phi.segment<3>(i * 3) = Direction(line_start_ + Eigen::Map<const Eigen::Vector3d>(kinematics[0].Phi(i).p.data));
+        }
+    }
+    else
+    {
+        Directions(phi);
+    }
+
+    // -J for all frames, then (line_ * line_^T / |line_|^2 - I) * J for the frames that are not clipped at t=0
+    StackFrameJacobians<3>(kinematics[0], jacobian, 0, -1.0);
+    const FramePositionsMap positions = GetFramePositions(kinematics[0]);
+    const Eigen::Vector3d line_normalized = line_ / line_.squaredNorm();
     for (int i = 0; i < kinematics[0].Phi.rows(); ++i)
     {
         // point in base frame
-        const Eigen::Vector3d p = line_start_ + Eigen::Map<const Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
+        const Eigen::Vector3d p = line_start_ + positions.col(i);
         // direction from point to line
-        const Eigen::Vector3d dv = Direction(p);
-        phi.segment<3>(i * 3) = dv;
+        const Eigen::Vector3d dv = phi.segment<3>(i * 3);
 
-        if ((dv + p - line_start_).norm() < std::numeric_limits<double>::epsilon())
+        if ((dv + p - line_start_).norm() >= std::numeric_limits<double>::epsilon())
         {
-            // clipped (t=0) case
-            jacobian.middleRows<3>(i * 3) = -kinematics[0].jacobian[i].data.topRows<3>();
-        }
-        else
-        {
-            for (int j = 0; j < jacobian.cols(); ++j)
-            {
-                jacobian.middleRows<3>(i * 3).col(j) = kinematics[0].jacobian[i].data.topRows<3>().col(j).dot(line_ / line_.squaredNorm()) * line_ - kinematics[0].jacobian[i].data.topRows<3>().col(j);
-            }
+            const Eigen::RowVectorXd projection = line_normalized.transpose() * jacobian.middleRows<3>(i * 3);
+            jacobian.middleRows<3>(i * 3).noalias() -= line_ * projection;
         }
 
         // visualisation of point, line and their distance
@@ -181,7 +181,14 @@ void QuasiStatic::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi)
         supports(i, 1) = kinematics[0].Phi(i).p[1];
     }
 
-    std::list<int> hull = ConvexHull2D(supports);
+    const std::list<int>& hull = hull_cache_.Update(supports);
+
+    // Strictly inside the support polygon the potential is not evaluated if only positive values are reported
+    if (parameters_.PositiveOnly && hull_cache_.IsInside(supports, com))
+    {
+        PublishDebug(com, supports, hull);
+        return;
+    }
 
     double n = hull.size();
     double wnd = 0.0;
@@ -213,24 +220,7 @@ void QuasiStatic::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi)
         }
     }
 
-    if (debug_)
-    {
-        debug_msg_.markers[0].pose.position.x = com(0);
-        debug_msg_.markers[0].pose.position.y = com(1);
-        debug_msg_.markers[0].pose.position.z = 0.0;
-
-        debug_msg_.markers[1].points.resize(hull.size() + 1);
-        int ii = 0;
-        for (int i : hull)
-        {
-            debug_msg_.markers[1].points[ii].x = supports(i, 0);
-            debug_msg_.markers[1].points[ii].y = supports(i, 1);
-            debug_msg_.markers[1].points[ii++].z = 0.0;
-        }
-        debug_msg_.markers[1].points[hull.size()] = debug_msg_.markers[1].points[0];
-
-        debug_pub_.publish(debug_msg_);
-    }
+    PublishDebug(com, supports, hull);
 }
 
 void QuasiStatic::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian)
@@ -275,7 +265,14 @@ void QuasiStatic::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eige
         supportsJ.middleRows(i * 2, 2) = kinematics[0].jacobian(i).data.topRows(2);
     }
 
-    std::list<int> hull = ConvexHull2D(supports);
+    const std::list<int>& hull = hull_cache_.Update(supports);
+
+    // Strictly inside the support polygon the potential is not evaluated if only positive values are reported
+    if (parameters_.PositiveOnly && hull_cache_.IsInside(supports, com))
+    {
+        PublishDebug(com, supports, hull);
+        return;
+    }
 
     double n = hull.size();
     double wnd = 0.0;
@@ -312,25 +309,28 @@ void QuasiStatic::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eige
         }
     }
 
-    if (debug_)
-    {
-        debug_msg_.markers[0].pose.position.x = com(0);
-        debug_msg_.markers[0].pose.position.y = com(1);
-        debug_msg_.markers[0].pose.position.z = 0.0;
+    PublishDebug(com, supports, hull);
+}
 
-        debug_msg_.markers[1].points.resize(hull.size() + 1);
-        int ii = 0;
-        for (int i : hull)
-        {
-            debug_msg_.markers[1].points[ii].x = supports(i, 0);
-            debug_msg_.markers[1].points[ii].y = supports(i, 1);
-            debug_msg_.markers[1].points[ii].z = 0.0;
-            ++ii;
-        }
-        debug_msg_.markers[1].points[ii] = debug_msg_.markers[1].points[0];
+void QuasiStatic::PublishDebug(Eigen::VectorXdRefConst com, Eigen::MatrixXdRefConst supports, const std::list<int>& hull)
+{
+    if (!debug_) return;
+    debug_msg_.markers[0].pose.position.x = com(0);
+    debug_msg_.markers[0].pose.position.y = com(1);
+    debug_msg_.markers[0].pose.position.z = 0.0;
 
-        debug_pub_.publish(debug_msg_);
+    debug_msg_.markers[1].points.resize(hull.size() + 1);
+    int ii = 0;
+    for (int i : hull)
+    {
+        debug_msg_.markers[1].points[ii].x = supports(i, 0);
+        debug_msg_.markers[1].points[ii].y = supports(i, 1);
+        debug_msg_.markers[1].points[ii].z = 0.0;
+        ++ii;
     }
+    debug_msg_.markers[1].points[ii] = debug_msg_.markers[1].points[0];
+
+    debug_pub_.publish(debug_msg_);
 }
 
 int QuasiStatic::TaskSpaceDim()
@@ -340,6 +340,8 @@ int QuasiStatic::TaskSpaceDim()
 
 void QuasiStatic::Initialize()
 {
+    if (parameters_.HullTolerance < 0.0) ThrowNamed("HullTolerance has to be non-negative!");
+    hull_cache_.SetTolerance(parameters_.HullTolerance);
     {
         visualization_msgs::Marker mrk;
         mrk.action = visualization_msgs::Marker::ADD;
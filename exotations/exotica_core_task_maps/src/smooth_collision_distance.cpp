@@ -57,72 +57,40 @@ void SmoothCollisionDistance::UpdateInternal(Eigen::VectorXdRefConst x,
                                              Eigen::MatrixXdRef J,
                                              bool updateJacobian)
 {
-    if (!scene_->AlwaysUpdatesCollisionScene())
-        cscene_->UpdateCollisionObjectTransforms();
-
-    //  1) Create vector to store CollisionProxy
-    std::vector<CollisionProxy> proxies;
-
-    //  2) For each robot link, check against each robot link
+    //  1) For each robot link, check against each robot link
     if (check_self_collision_)
-    {
-        AppendVector(proxies, cscene_->GetRobotToRobotCollisionDistance(robot_margin_));
-    }
+        cscene_->GetCachedRobotToRobotCollisionDistance(robot_margin_, robot_proxies_);
+    else
+        robot_proxies_.Clear();
 
-    //  3) For each robot link, check against each environment link
-    AppendVector(proxies, cscene_->GetRobotToWorldCollisionDistance(world_margin_));
+    //  2) For each robot link, check against each environment link
+    cscene_->GetCachedRobotToWorldCollisionDistance(world_margin_, world_proxies_);
 
-    //  4) Compute d, J
+    //  3) Compute d, J
     double& d = phi(0);
+    const KinematicTree& tree = scene_->GetKinematicTree();
+    for (const auto& proxies : {std::make_pair(&robot_proxies_, robot_margin_), std::make_pair(&world_proxies_, world_margin_)})
     {
-        KDL::Frame arel, brel;
-        Eigen::MatrixXd J_a(6, scene_->GetKinematicTree().GetNumControlledJoints()), J_b(6, scene_->GetKinematicTree().GetNumControlledJoints());
-        for (const auto& proxy : proxies)
+        const CollisionProxyBuffer& proxy = *proxies.first;
+        const double margin = proxies.second;
+        for (int i = 0; i < proxy.Size(); ++i)
         {
-            bool is_robot_to_robot = (proxy.e1 != nullptr && proxy.e2 != nullptr) && (proxy.e1->is_robot_link || proxy.e1->closest_robot_link.lock()) && (proxy.e2->is_robot_link || proxy.e2->closest_robot_link.lock());
-            double& margin = is_robot_to_robot ? robot_margin_ : world_margin_;
+            if (proxy.distance[i] >= margin) continue;
 
-            if (proxy.distance < margin)
-            {
-                // Cost
-                d += std::pow((1. - proxy.distance / margin), linear_ ? 1 : 2);
-
-                if (updateJacobian)
-                {
-                    // Jacobian
-                    if (proxy.e1 != nullptr)
-                    {
-                        arel = KDL::Frame(proxy.e1->frame.Inverse(KDL::Vector(proxy.contact1.x(), proxy.contact1.y(), proxy.contact1.z())));
-                        J_a = scene_->GetKinematicTree().Jacobian(proxy.e1, arel, nullptr, KDL::Frame());
-                    }
-                    else
-                    {
-                        arel = arel.Identity();
-                        J_a.setZero();
-                    }
+            // Cost
+            d += std::pow((1. - proxy.distance[i] / margin), linear_ ? 1 : 2);
 
-                    if (proxy.e2 != nullptr)
-                    {
-                        brel = KDL::Frame(proxy.e2->frame.Inverse(KDL::Vector(proxy.contact2.x(), proxy.contact2.y(), proxy.contact2.z())));
-                        J_b = scene_->GetKinematicTree().Jacobian(proxy.e2, brel, nullptr, KDL::Frame());
-                    }
-                    else
-                    {
-                        brel = brel.Identity();
-                        J_b.setZero();
-                    }
-
-                    if (!linear_)
-                    {
-                        J += (2. / (margin * margin)) * (proxy.normal1.transpose() * J_a.topRows<3>());
-                        J -= (2. / (margin * margin)) * (proxy.normal1.transpose() * J_b.topRows<3>());
-                    }
-                    else
-                    {
-                        J += 1 / margin * (proxy.normal1.transpose() * J_a.topRows<3>());
-                        J -= 1 / margin * (proxy.normal1.transpose() * J_b.topRows<3>());
-                    }
-                }
+            if (updateJacobian)
+            {
+                // Jacobian
+                const KDL::Frame arel(tree.GetElement(proxy.e1[i]).frame.Inverse(KDL::Vector(proxy.contact1(0, i), proxy.contact1(1, i), proxy.contact1(2, i))));
+                const KDL::Frame brel(tree.GetElement(proxy.e2[i]).frame.Inverse(KDL::Vector(proxy.contact2(0, i), proxy.contact2(1, i), proxy.contact2(2, i))));
+                J_a_ = tree.Jacobian(proxy.e1[i], arel, 0, KDL::Frame());
+                J_b_ = tree.Jacobian(proxy.e2[i], brel, 0, KDL::Frame());
+
+                const double scale = linear_ ? 1. / margin : 2. / (margin * margin);
+                J += scale * (proxy.normal1.col(i).transpose() * J_a_.topRows<3>());
+                J -= scale * (proxy.normal1.col(i).transpose() * J_b_.topRows<3>());
             }
         }
     }
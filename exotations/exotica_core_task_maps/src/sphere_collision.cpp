@@ -27,6 +27,9 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <cmath>
+#include <limits>
+
 #include <exotica_core/server.h>
 #include <exotica_core_task_maps/sphere_collision.h>
 
@@ -66,86 +69,97 @@ void SphereCollision::Instantiate(const SphereCollisionInitializer& init)
         debug_pub_ = Server::Advertise<visualization_msgs::MarkerArray>(ns_ + "/CollisionSpheres", 1, true);
     }
 
+    // Spheres, radii and centres of each group in the order of groups_, stored contiguously per group
+    group_spheres_.clear();
+    group_radii_.clear();
+    group_positions_.clear();
+    for (const auto& it : groups_)
+    {
+        group_spheres_.push_back(it.second);
+        group_radii_.push_back(Eigen::ArrayXd(it.second.size()));
+        for (std::size_t k = 0; k < it.second.size(); ++k) group_radii_.back()(k) = radiuses_[it.second[k]];
+        group_positions_.push_back(Eigen::Matrix3Xd(3, it.second.size()));
+    }
+
     dim_ = groups_.size() * (groups_.size() - 1) / 2;
 }
 
-double SphereCollision::Distance(const KDL::Frame& eff_A, const KDL::Frame& eff_B, double r_A, double r_B)
+void SphereCollision::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi)
 {
-    return 1.0 / (1.0 + exp(5.0 * eps_ * ((eff_A.p - eff_B.p).Norm() - r_A - r_B)));
+    if (phi.rows() != TaskSpaceDim()) ThrowNamed("Wrong size of phi!");
+    Eigen::MatrixXd jacobian(0, 0);
+    UpdateInternal(phi, jacobian, false);
 }
 
-void SphereCollision::Jacobian(const KDL::Frame& eff_A, const KDL::Frame& eff_B, const KDL::Jacobian& jacA, const KDL::Jacobian& jacB, double r_A, double r_B, Eigen::Block<Eigen::Ref<Eigen::MatrixXd>, 1, -1, false> ret)
+void SphereCollision::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian)
 {
-    const Eigen::Vector3d eA_minus_eB = Eigen::Map<const Eigen::Vector3d>(eff_A.p.data) - Eigen::Map<const Eigen::Vector3d>(eff_B.p.data);
-    const double eA_minus_eB_norm = eA_minus_eB.norm();
-    for (unsigned int i = 0; i < jacA.columns(); ++i)
-    {
-        ret(i) += -static_cast<double>((jacA.data.col(i).head<3>() - jacB.data.col(i).head<3>()).adjoint() * eA_minus_eB) / eA_minus_eB_norm;
-    }
+    if (phi.rows() != TaskSpaceDim()) ThrowNamed("Wrong size of phi!");
+    if (jacobian.rows() != TaskSpaceDim() || jacobian.cols() != kinematics[0].jacobian(0).data.cols()) ThrowNamed("Wrong size of jacobian! " << kinematics[0].jacobian(0).data.cols());
+    UpdateInternal(phi, jacobian, true);
 }
 
-void SphereCollision::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi)
+// For each pair of groups A and B, phi = sum_ij 1 / (1 + exp(5 eps (d_ij - r_i - r_j))) with d_ij = |p_i - p_j|, and
+// the Jacobian row is sum_ij -(J_i - J_j)^T u_ij with u_ij = (p_i - p_j) / d_ij. The latter is accumulated per sphere,
+// sum_i J_i^T (-sum_j u_ij) + sum_j J_j^T (sum_i u_ij), so that each sphere Jacobian is only projected once per pair of groups.
+void SphereCollision::UpdateInternal(Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian, bool update_jacobian)
 {
-    if (phi.rows() != TaskSpaceDim()) ThrowNamed("Wrong size of phi!");
     phi.setZero();
+    if (update_jacobian) jacobian.setZero();
 
-    auto Aend = groups_.end()--;
-    auto Bend = groups_.end();
-    int phiI = 0;
-    for (auto A = groups_.begin(); A != Aend; ++A)
+    // Gather the sphere centres of each group
+    const int num_groups = static_cast<int>(group_spheres_.size());
+    for (int g = 0; g < num_groups; ++g)
     {
-        for (auto B = std::next(A); B != Bend; ++B)
+        for (std::size_t k = 0; k < group_spheres_[g].size(); ++k)
         {
-            for (std::size_t ii = 0; ii < A->second.size(); ++ii)
-            {
-                for (std::size_t jj = 0; jj < B->second.size(); ++jj)
-                {
-                    int i = A->second[ii];
-                    int j = B->second[jj];
-                    phi(phiI) += Distance(kinematics[0].Phi(i), kinematics[0].Phi(j), radiuses_[i], radiuses_[j]);
-                }
-            }
-            ++phiI;
+            group_positions_[g].col(k) = Eigen::Map<const Eigen::Vector3d>(kinematics[0].Phi(group_spheres_[g][k]).p.data);
         }
     }
 
-    if (debug_ && Server::IsRos())
-    {
-        for (std::size_t i = 0; i < debug_msg_.markers.size(); ++i)
-        {
-            debug_msg_.markers[i].pose.position.x = kinematics[0].Phi(i).p[0];
-            debug_msg_.markers[i].pose.position.y = kinematics[0].Phi(i).p[1];
-            debug_msg_.markers[i].pose.position.z = kinematics[0].Phi(i).p[2];
-        }
-        debug_pub_.publish(debug_msg_);
-    }
-}
-
-void SphereCollision::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian)
-{
-    if (phi.rows() != TaskSpaceDim()) ThrowNamed("Wrong size of phi!");
-    if (jacobian.rows() != TaskSpaceDim() || jacobian.cols() != kinematics[0].jacobian(0).data.cols()) ThrowNamed("Wrong size of jacobian! " << kinematics[0].jacobian(0).data.cols());
-    phi.setZero();
-    jacobian.setZero();
+    // exp() overflows beyond this bound, i.e., the sphere pairs of groups whose bounding boxes are further apart contribute exactly 0 to phi
+    static const double exponent_limit = std::log(std::numeric_limits<double>::max());
+    const double scale = 5.0 * eps_;
 
-    auto Aend = groups_.end()--;
-    auto Bend = groups_.end();
     int phiI = 0;
-    for (auto A = groups_.begin(); A != Aend; ++A)
+    for (int a = 0; a < num_groups; ++a)
     {
-        for (auto B = std::next(A); B != Bend; ++B)
+        for (int b = a + 1; b < num_groups; ++b, ++phiI)
         {
-            for (std::size_t ii = 0; ii < A->second.size(); ++ii)
+            const Eigen::Matrix3Xd& positions_A = group_positions_[a];
+            const Eigen::Matrix3Xd& positions_B = group_positions_[b];
+
+            // The Jacobian accumulates the directions of all sphere pairs, regardless of their distance
+            if (!update_jacobian && scale > 0.0)
+            {
+                const Eigen::Vector3d gap = (positions_A.rowwise().minCoeff() - positions_B.rowwise().maxCoeff()).cwiseMax(positions_B.rowwise().minCoeff() - positions_A.rowwise().maxCoeff()).cwiseMax(0.0);
+                if (scale * (gap.norm() - group_radii_[a].maxCoeff() - group_radii_[b].maxCoeff()) > exponent_limit) continue;
+            }
+
+            if (update_jacobian) group_directions_B_.setZero(3, positions_B.cols());
+            for (int i = 0; i < positions_A.cols(); ++i)
+            {
+                // Differences p_j - p_i and distances to all spheres of B
+                differences_ = positions_B.colwise() - positions_A.col(i);
+                distances_ = differences_.colwise().norm().transpose().array();
+                phi(phiI) += (1.0 + (scale * (distances_ - group_radii_[a](i) - group_radii_[b])).exp()).inverse().sum();
+
+                if (update_jacobian)
+                {
+                    // -sum_j u_ij for sphere i, and u_ij added to sphere j
+                    differences_.array().rowwise() /= distances_.transpose();
+                    const Eigen::Vector3d direction_A = differences_.rowwise().sum();
+                    jacobian.row(phiI).noalias() += direction_A.transpose() * kinematics[0].jacobian(group_spheres_[a][i]).data.topRows<3>();
+                    group_directions_B_ -= differences_;
+                }
+            }
+
+            if (update_jacobian)
             {
-                for (std::size_t jj = 0; jj < B->second.size(); ++jj)
+                for (int j = 0; j < positions_B.cols(); ++j)
                 {
-                    int i = A->second[ii];
-                    int j = B->second[jj];
-                    phi(phiI) += Distance(kinematics[0].Phi(i), kinematics[0].Phi(j), radiuses_[i], radiuses_[j]);
-                    Jacobian(kinematics[0].Phi(i), kinematics[0].Phi(j), kinematics[0].jacobian(i), kinematics[0].jacobian(j), radiuses_[i], radiuses_[j], jacobian.row(phiI));
+                    jacobian.row(phiI).noalias() += group_directions_B_.col(j).transpose() * kinematics[0].jacobian(group_spheres_[b][j]).data.topRows<3>();
                 }
             }
-            ++phiI;
         }
     }
 
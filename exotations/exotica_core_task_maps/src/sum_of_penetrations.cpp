@@ -38,36 +38,23 @@ void SumOfPenetrations::Update(Eigen::VectorXdRefConst x,
 {
     if (phi.rows() != dim_) ThrowNamed("Wrong size of phi!");
     phi.setZero();
-    Eigen::MatrixXd J;
 
-    //  1) Create vector to store CollisionProxy
-    std::vector<CollisionProxy> proxies;
-
-    //  2) For each robot link, check against each robot link
+    //  1) For each robot link, check against each robot link
     if (check_self_collision_)
-    {
-        AppendVector(proxies, cscene_->GetRobotToRobotCollisionDistance(robot_margin_));
-    }
+        cscene_->GetCachedRobotToRobotCollisionDistance(robot_margin_, robot_proxies_);
+    else
+        robot_proxies_.Clear();
 
-    //  3) For each robot link, check against each environment link
-    AppendVector(proxies, cscene_->GetRobotToWorldCollisionDistance(world_margin_));
+    //  2) For each robot link, check against each environment link
+    cscene_->GetCachedRobotToWorldCollisionDistance(world_margin_, world_proxies_);
 
+    //  3) Accumulate the penetration of the margin over the distances of all proxies at once
     double& d = phi(0);
-    for (const auto& proxy : proxies)
+    for (const auto& proxies : {std::make_pair(&robot_proxies_, robot_margin_), std::make_pair(&world_proxies_, world_margin_)})
     {
-        bool is_robot_to_robot = (proxy.e1->is_robot_link || proxy.e1->closest_robot_link.lock()) && (proxy.e2->is_robot_link || proxy.e2->closest_robot_link.lock());
-        double& margin = is_robot_to_robot ? robot_margin_ : world_margin_;
-        if (proxy.distance < margin)
-        {
-            if (proxy.distance < 0)
-            {
-                d += std::abs(proxy.distance);
-            }
-            else
-            {
-                d += std::abs(proxy.distance - margin);
-            }
-        }
+        const Eigen::Map<const Eigen::ArrayXd> distance(proxies.first->distance.data(), proxies.first->Size());
+        const double margin = proxies.second;
+        d += (distance < margin).select((distance < 0.0).select(-distance, margin - distance), 0.0).sum();
     }
 }
 
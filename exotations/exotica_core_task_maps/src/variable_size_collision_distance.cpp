@@ -49,55 +49,56 @@ void VariableSizeCollisionDistance::Update(Eigen::VectorXdRefConst x, Eigen::Vec
 
 void VariableSizeCollisionDistance::UpdateInternal(Eigen::VectorXdRefConst x, Eigen::VectorXdRef phi, Eigen::MatrixXdRef J, bool updateJacobian)
 {
-    std::vector<CollisionProxy> proxies = cscene_->GetRobotToWorldCollisionDistance(world_margin_);
+    cscene_->GetCachedRobotToWorldCollisionDistance(world_margin_, proxies_);
 
     // Figure out if dim_ or size of proxies is larger:
-    if (proxies.size() > dim_) WARNING("Too many proxies!");
-    int max_dim = std::min(proxies.size(), dim_);
+    if (static_cast<std::size_t>(proxies_.Size()) > dim_) WARNING("Too many proxies!");
+    const int max_dim = std::min(proxies_.Size(), static_cast<int>(dim_));
 
-    KDL::Frame arel, brel;
-    Eigen::MatrixXd J_a(6, scene_->GetKinematicTree().GetNumControlledJoints()), J_b(6, scene_->GetKinematicTree().GetNumControlledJoints());
+    // Penetration of the margin of all proxies at once, proxies outside the margin are left untouched
+    const Eigen::Map<const Eigen::ArrayXd> distance(proxies_.distance.data(), max_dim);
+    phi.head(max_dim) = (distance <= world_margin_).select(world_margin_ - distance, phi.head(max_dim).array());
+    if (!updateJacobian) return;
+
+    // Gather the witness points of the proxies within the margin per link: (frame handle, 2 * proxy + side)
+    contacts_.clear();
     for (int i = 0; i < max_dim; ++i)
     {
-        const CollisionProxy& proxy = proxies[i];
+        if (distance(i) > world_margin_) continue;
+        // Proxies against objects without a frame in the tree (handle -1) contribute no Jacobian on that side
+        if (proxies_.e1[i] >= 0) contacts_.emplace_back(proxies_.e1[i], 2 * i);
+        if (proxies_.e2[i] >= 0) contacts_.emplace_back(proxies_.e2[i], 2 * i + 1);
+    }
+    std::sort(contacts_.begin(), contacts_.end());
 
-        if (proxy.distance > world_margin_)
-        {
-            // Zero. Do nothing.
-        }
-        else
+    // The Jacobians of all witness points on a link follow from the link Jacobian:
+    //     n^T J_p = n^T J_v + ((p - o) x n)^T J_w
+    // where o is the origin of the link. The first witness point moves along normal1, the second against it.
+    const KinematicTree& tree = scene_->GetKinematicTree();
+    for (std::size_t begin = 0; begin < contacts_.size();)
+    {
+        const int handle = contacts_[begin].first;
+        std::size_t end = begin + 1;
+        while (end < contacts_.size() && contacts_[end].first == handle) ++end;
+        const int num_contacts = static_cast<int>(end - begin);
+
+        const Eigen::Map<const Eigen::Vector3d> origin(tree.GetElement(handle).frame.p.data);
+        contact_directions_.resize(num_contacts, 6);
+        for (int j = 0; j < num_contacts; ++j)
         {
-            phi(i) = world_margin_ - proxy.distance;
-
-            if (updateJacobian)
-            {
-                // Jacobian
-                if (proxy.e1 != nullptr)
-                {
-                    arel = KDL::Frame(proxy.e1->frame.Inverse(KDL::Vector(proxy.contact1.x(), proxy.contact1.y(), proxy.contact1.z())));
-                    J_a = scene_->GetKinematicTree().Jacobian(proxy.e1, arel, nullptr, KDL::Frame());
-                }
-                else
-                {
-                    arel = arel.Identity();
-                    J_a.setZero();
-                }
-
-                if (proxy.e2 != nullptr)
-                {
-                    brel = KDL::Frame(proxy.e2->frame.Inverse(KDL::Vector(proxy.contact2.x(), proxy.contact2.y(), proxy.contact2.z())));
-                    J_b = scene_->GetKinematicTree().Jacobian(proxy.e2, brel, nullptr, KDL::Frame());
-                }
-                else
-                {
-                    brel = brel.Identity();
-                    J_b.setZero();
-                }
-
-                J.row(i) += proxy.normal1.transpose() * J_a.topRows<3>();
-                J.row(i) -= proxy.normal1.transpose() * J_b.topRows<3>();
-            }
+            const int proxy = contacts_[begin + j].second / 2;
+            const bool second = contacts_[begin + j].second % 2;
+            const Eigen::Vector3d normal = second ? Eigen::Vector3d(-proxies_.normal1.col(proxy)) : Eigen::Vector3d(proxies_.normal1.col(proxy));
+            const Eigen::Vector3d arm = (second ? proxies_.contact2.col(proxy) : proxies_.contact1.col(proxy)) - origin;
+            contact_directions_.row(j).head<3>() = normal.transpose();
+            contact_directions_.row(j).tail<3>() = arm.cross(normal).transpose();
         }
+
+        link_jacobian_ = tree.Jacobian(handle, KDL::Frame(), 0, KDL::Frame());
+        contact_jacobians_.noalias() = contact_directions_ * link_jacobian_;
+        for (int j = 0; j < num_contacts; ++j) J.row(contacts_[begin + j].second / 2) += contact_jacobians_.row(j);
+
+        begin = end;
     }
 }
 
@@ -236,7 +236,7 @@ bool test_jacobian_time_indexed(std::shared_ptr<T> problem, TimeIndexedTask& tas
     return true;
 }
 
-UnconstrainedEndPoseProblemPtr setup_problem(Initializer& map, const std::string& collision_scene = "", const std::vector<Initializer>& links = std::vector<Initializer>())
+UnconstrainedEndPoseProblemPtr setup_problem(Initializer& map, const std::string& collision_scene = "", const std::vector<Initializer>& links = std::vector<Initializer>(), const bool packed_kinematics = false)
 {
     Initializer scene;
     if (!collision_scene.empty())
@@ -256,6 +256,7 @@ UnconstrainedEndPoseProblemPtr setup_problem(Initializer& map, const std::string
                                                                    {"Maps", std::vector<Initializer>({map})},
                                                                    {"Cost", std::vector<Initializer>({cost})},
                                                                    {"W", W},
+                                                                   {"PackedKinematics", packed_kinematics},
                                                                });
     Server::Instance()->GetModel("robot_description", urdf_string_, srdf_string_);
 
@@ -268,6 +269,7 @@ UnconstrainedEndPoseProblemPtr setup_problem(Initializer& map, const std::string
                                                                      {"Maps", std::vector<Initializer>({map})},
                                                                      {"Cost", std::vector<Initializer>({cost, cost, cost})},
                                                                      {"W", W},
+                                                                     {"PackedKinematics", packed_kinematics},
                                                                  });
 
     test_random(std::static_pointer_cast<UnconstrainedEndPoseProblem>(Setup::CreateProblem(problem)));
@@ -395,6 +397,7 @@ TEST(ExoticaTaskMaps, testEffAxisAlignment)
         EXPECT_TRUE(test_random(problem));
 
         EXPECT_TRUE(test_jacobian(problem));
+        EXPECT_TRUE(test_hessian(problem));
     }
     catch (const std::exception& e)
     {
@@ -926,6 +929,22 @@ TEST(ExoticaTaskMaps, testCoM)
             EXPECT_TRUE(test_values(X, Y, jacobian, problem));
         }
         EXPECT_TRUE(test_jacobian(problem));
+
+        TEST_COUT << "CoM test with per-link Jacobians";
+        map = Initializer("exotica/CenterOfMass", {{"Name", std::string("MyTask")},
+                                                   {"EnableZ", true},
+                                                   {"Recursive", false}});
+        UnconstrainedEndPoseProblemPtr problem_per_link = setup_problem(map);
+        problem_per_link->GetScene()->AddObject("Payload", KDL::Frame(), "", shapes::ShapeConstPtr(nullptr), KDL::RigidBodyInertia(0.5));
+        problem_per_link->GetScene()->AttachObjectLocal("Payload", "endeff", KDL::Frame());
+        for (int i = 0; i < num_trials_; ++i)
+        {
+            const Eigen::VectorXd x = problem->GetScene()->GetKinematicTree().GetRandomControlledState();
+            problem->Update(x);
+            problem_per_link->Update(x);
+            EXPECT_LT((problem->Phi.data - problem_per_link->Phi.data).lpNorm<Eigen::Infinity>(), 1e-12);
+            EXPECT_LT((problem->jacobian - problem_per_link->jacobian).lpNorm<Eigen::Infinity>(), 1e-12);
+        }
     }
     catch (const std::exception& e)
     {
@@ -1058,6 +1077,69 @@ TEST(ExoticaTaskMaps, testPoint2Line)
     }
 }
 
+TEST(ExoticaTaskMaps, testPackedEffectorJacobians)
+{
+    try
+    {
+        TEST_COUT << "Packed vs per-effector kinematics test";
+        // Several frames with offsets and bases so that the strided packed path is exercised per column
+        const auto frames = [](const std::string& type) {
+            std::vector<Initializer> frames;
+            for (const std::string& link : {"link2", "link3", "endeff"})
+                frames.push_back(Initializer(type, {{"Link", link},
+                                                    {"LinkOffset", std::string("0.1 0.2 0.3")},
+                                                    {"Base", std::string("link1")},
+                                                    {"BaseOffset", std::string("0.1 0 0.1")}}));
+            return frames;
+        };
+
+        std::vector<Initializer> maps;
+        maps.emplace_back(Initializer("exotica/EffPosition", {{"Name", std::string("MyTask")}, {"EndEffector", frames("Frame")}}));
+        maps.emplace_back(Initializer("exotica/EffFrame", {{"Name", std::string("MyTask")}, {"EndEffector", frames("Frame")}}));
+        {
+            std::vector<Initializer> box_frames;
+            for (const std::string& link : {"link2", "link3", "endeff"})
+                box_frames.push_back(Initializer("FrameWithBoxLimits", {{"Link", link},
+                                                                        {"LinkOffset", std::string("0.1 0.2 0.3")},
+                                                                        {"XLim", Eigen::Vector2d(-0.1, 0.1)},
+                                                                        {"YLim", Eigen::Vector2d(-0.1, 0.1)},
+                                                                        {"ZLim", Eigen::Vector2d(0.5, 0.8)}}));
+            maps.emplace_back(Initializer("exotica/EffBox", {{"Name", std::string("MyTask")}, {"EndEffector", box_frames}}));
+        }
+        maps.emplace_back(Initializer("exotica/PointToLine", {{"Name", std::string("MyTask")}, {"EndPoint", std::string("0.5 0.5 0")}, {"EndEffector", frames("Frame")}}));
+
+        for (Initializer& map : maps)
+        {
+            TEST_COUT << map.GetName();
+            UnconstrainedEndPoseProblemPtr per_effector = setup_problem(map, "", std::vector<Initializer>(), false);
+            UnconstrainedEndPoseProblemPtr packed = setup_problem(map, "", std::vector<Initializer>(), true);
+            for (int i = 0; i < num_trials_; ++i)
+            {
+                const Eigen::VectorXd x = per_effector->GetScene()->GetKinematicTree().GetRandomControlledState();
+                per_effector->Update(x);
+                packed->Update(x);
+                EXPECT_LT((per_effector->Phi - packed->Phi).lpNorm<Eigen::Infinity>(), 1e-12);
+                EXPECT_LT((per_effector->jacobian - packed->jacobian).lpNorm<Eigen::Infinity>(), 1e-12);
+            }
+            EXPECT_TRUE(test_jacobian(packed));
+        }
+
+        // PointToLine keeps its per-frame implementation for debug output, which must agree with the batched one
+        Initializer debug_map("exotica/PointToLine", {{"Name", std::string("MyTask")}, {"Debug", true}, {"EndPoint", std::string("0.5 0.5 0")}, {"EndEffector", frames("Frame")}});
+        UnconstrainedEndPoseProblemPtr debug = setup_problem(debug_map, "", std::vector<Initializer>(), true);
+        UnconstrainedEndPoseProblemPtr packed = setup_problem(maps.back(), "", std::vector<Initializer>(), true);
+        const Eigen::VectorXd x = debug->GetScene()->GetKinematicTree().GetRandomControlledState();
+        debug->Update(x);
+        packed->Update(x);
+        EXPECT_LT((debug->Phi - packed->Phi).lpNorm<Eigen::Infinity>(), 1e-12);
+        EXPECT_LT((debug->jacobian - packed->jacobian).lpNorm<Eigen::Infinity>(), 1e-12);
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
 TEST(ExoticaTaskMaps, testPoint2Plane)
 {
     try
@@ -1110,6 +1192,130 @@ TEST(ExoticaTaskMaps, testCollisionDistance)
     }
 }
 
+TEST(ExoticaTaskMaps, testCollisionQueryCache)
+{
+    try
+    {
+        TEST_COUT << "Collision query cache test";
+        Initializer map("exotica/CollisionDistance", {{"Name", std::string("MyTask")},
+                                                      {"CheckSelfCollision", true},
+                                                      {}});
+        UnconstrainedEndPoseProblemPtr problem = setup_problem(map, "exotica/CollisionSceneFCLLatest");
+        ScenePtr scene = problem->GetScene();
+        CollisionScenePtr cscene = scene->GetCollisionScene();
+        for (int i = 0; i < num_trials_; ++i)
+        {
+            const Eigen::VectorXd x = Eigen::VectorXd::Random(problem->N);
+            scene->Update(x);
+            const std::vector<CollisionProxy>& cached = cscene->GetCachedCollisionDistance(true);
+            // Repeated queries of the same state share the result
+            EXPECT_EQ(&cached, &cscene->GetCachedCollisionDistance(true));
+            const std::vector<CollisionProxy> proxies = cscene->GetCollisionDistance(true);
+            ASSERT_EQ(cached.size(), proxies.size());
+            for (std::size_t j = 0; j < proxies.size(); ++j) EXPECT_NEAR(cached[j].distance, proxies[j].distance, 1e-9);
+            EXPECT_EQ(cscene->IsStateValidCached(true), cscene->IsStateValid(true));
+
+            // Updating the tree without the Scene must not return the proxies of the previous state
+            scene->GetKinematicTree().Update(Eigen::VectorXd::Random(problem->N));
+            cscene->UpdateCollisionObjectTransforms();
+            const std::vector<CollisionProxy>& moved = cscene->GetCachedCollisionDistance(true);
+            const std::vector<CollisionProxy> moved_reference = cscene->GetCollisionDistance(true);
+            ASSERT_EQ(moved.size(), moved_reference.size());
+            for (std::size_t j = 0; j < moved_reference.size(); ++j) EXPECT_NEAR(moved[j].distance, moved_reference[j].distance, 1e-9);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaTaskMaps, testCollisionQueryCacheJacobian)
+{
+    try
+    {
+        // The finite differences update the problem once per perturbation, each of which has to invalidate the shared queries
+        TEST_COUT << "Collision query cache Jacobian test";
+        Initializer map("exotica/SmoothCollisionDistance", {{"Name", std::string("MyTask")},
+                                                            {"CheckSelfCollision", true},
+                                                            {"WorldMargin", 0.01},
+                                                            {"RobotMargin", 0.01},
+                                                            {"Linear", true},
+                                                            {}});
+        UnconstrainedEndPoseProblemPtr problem = setup_problem(map, "exotica/CollisionSceneFCLLatest");
+        EXPECT_TRUE(test_random(problem));
+        EXPECT_TRUE(test_jacobian(problem));
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+// Proxies as (link names, distance) in a canonical order, the buffers refer to the links by frame handle and the vectors by element
+std::vector<std::pair<std::string, double>> sorted_proxies(const std::vector<CollisionProxy>& proxies)
+{
+    std::vector<std::pair<std::string, double>> sorted;
+    for (const CollisionProxy& proxy : proxies) sorted.emplace_back(proxy.e1->segment.getName() + "/" + proxy.e2->segment.getName(), proxy.distance);
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+std::vector<std::pair<std::string, double>> sorted_proxies(const CollisionProxyBuffer& proxies, const KinematicTree& tree)
+{
+    std::vector<std::pair<std::string, double>> sorted;
+    for (int i = 0; i < proxies.Size(); ++i) sorted.emplace_back(tree.GetElement(proxies.e1[i]).segment.getName() + "/" + tree.GetElement(proxies.e2[i]).segment.getName(), proxies.distance[i]);
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
+
+void expect_same_proxies(const std::vector<std::pair<std::string, double>>& a, const std::vector<std::pair<std::string, double>>& b)
+{
+    ASSERT_EQ(a.size(), b.size());
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        EXPECT_EQ(a[i].first, b[i].first);
+        EXPECT_NEAR(a[i].second, b[i].second, 1e-9);
+    }
+}
+
+TEST(ExoticaTaskMaps, testCollisionProxyBuffer)
+{
+    try
+    {
+        TEST_COUT << "CollisionProxyBuffer test";
+        Initializer map("exotica/CollisionDistance", {{"Name", std::string("MyTask")},
+                                                      {"CheckSelfCollision", true},
+                                                      {}});
+        UnconstrainedEndPoseProblemPtr problem = setup_problem(map, "exotica/CollisionSceneFCLLatest");
+        ScenePtr scene = problem->GetScene();
+        CollisionScenePtr cscene = scene->GetCollisionScene();
+        const KinematicTree& tree = scene->GetKinematicTree();
+        // One buffer is reused across all queries, a shorter result has to replace a longer one
+        CollisionProxyBuffer buffer;
+        for (int i = 0; i < num_trials_; ++i)
+        {
+            const Eigen::VectorXd x = Eigen::VectorXd::Random(problem->N);
+            scene->Update(x);
+            for (double margin : {0.0, 0.1})
+            {
+                cscene->GetCollisionDistance(true, margin, buffer);
+                expect_same_proxies(sorted_proxies(buffer, tree), sorted_proxies(cscene->GetCollisionDistance(true, margin)));
+                cscene->GetRobotToRobotCollisionDistance(margin, buffer);
+                expect_same_proxies(sorted_proxies(buffer, tree), sorted_proxies(cscene->GetRobotToRobotCollisionDistance(margin)));
+                cscene->GetRobotToWorldCollisionDistance(margin, buffer);
+                expect_same_proxies(sorted_proxies(buffer, tree), sorted_proxies(cscene->GetRobotToWorldCollisionDistance(margin)));
+                cscene->GetCachedCollisionDistance(true, margin, buffer);
+                expect_same_proxies(sorted_proxies(buffer, tree), sorted_proxies(cscene->GetCollisionDistance(true, margin)));
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
 TEST(ExoticaTaskMaps, testSmoothCollisionDistance)
 {
     try
@@ -1136,6 +1342,51 @@ TEST(ExoticaTaskMaps, testSmoothCollisionDistance)
     }
 }
 
+TEST(ExoticaTaskMaps, testVariableSizeCollisionDistance)
+{
+    try
+    {
+        TEST_COUT << "VariableSizeCollisionDistance test";
+        Initializer map("exotica/VariableSizeCollisionDistance", {{"Name", std::string("MyTask")},
+                                                                  {"Dimension", 20},
+                                                                  {"WorldMargin", 0.1},
+                                                                  {}});
+        UnconstrainedEndPoseProblemPtr problem = setup_problem(map, "exotica/CollisionSceneFCLLatest");
+        EXPECT_TRUE(test_random(problem));
+        EXPECT_TRUE(test_jacobian(problem));
+        EXPECT_GE(problem->Phi.data.minCoeff(), 0.0);
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaTaskMaps, testSumOfPenetrations)
+{
+    try
+    {
+        const std::vector<bool> self_collision = {true, false};
+        for (bool check_self_collision : self_collision)
+        {
+            TEST_COUT << "SumOfPenetrations test " << (check_self_collision ? "with" : "without") << " self-collision";
+            Initializer map("exotica/SumOfPenetrations", {{"Name", std::string("MyTask")},
+                                                          {"CheckSelfCollision", check_self_collision},
+                                                          {"WorldMargin", 0.1},
+                                                          {"RobotMargin", 0.1},
+                                                          {}});
+            UnconstrainedEndPoseProblemPtr problem = setup_problem(map, "exotica/CollisionSceneFCLLatest");
+            EXPECT_TRUE(test_random(problem));
+            ASSERT_EQ(problem->Phi.data.size(), 1);
+            EXPECT_GE(problem->Phi.data(0), 0.0);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
 TEST(ExoticaTaskMaps, testQuasiStatic)
 {
     try
@@ -1326,6 +1577,142 @@ TEST(ExoticaTaskMaps, testManipulability)
         // TODO: Add test_values
 
         EXPECT_TRUE(test_jacobian(problem));
+
+        TEST_COUT << "Manipulability Test - position only";
+        map.AddProperty(Property("OnlyPosition", false, true));
+        problem = setup_problem(map);
+        EXPECT_TRUE(test_random(problem));
+        EXPECT_TRUE(test_jacobian(problem));
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaTaskMaps, testParallelFiniteDifferenceJacobian)
+{
+    try
+    {
+        TEST_COUT << "Parallel finite-difference Jacobian test";
+        // Manipulability without AnalyticJacobian uses the default finite-difference Jacobian of TaskMap
+        std::vector<UnconstrainedEndPoseProblemPtr> problems;
+        for (const int num_threads : {1, 2})
+        {
+            Initializer map("exotica/Manipulability", {{"Name", std::string("MyTask")},
+                                                       {"AnalyticJacobian", false},
+                                                       {"FiniteDifferenceNumThreads", num_threads},
+                                                       {"EndEffector", std::vector<Initializer>(
+                                                                           {Initializer("Frame", {{"Link", std::string("endeff")},
+                                                                                                  {"LinkOffset", std::string("0.5 0 0.5")},
+                                                                                                  {"Base", std::string("base")},
+                                                                                                  {"BaseOffset", std::string("0.5 0.5 0")}})})}});
+            problems.push_back(setup_problem(map));
+        }
+
+        for (int i = 0; i < num_trials_; ++i)
+        {
+            const Eigen::VectorXd x = problems[0]->GetScene()->GetKinematicTree().GetRandomControlledState();
+            for (UnconstrainedEndPoseProblemPtr problem : problems) problem->Update(x);
+            EXPECT_LT((problems[0]->jacobian - problems[1]->jacobian).lpNorm<Eigen::Infinity>(), 1e-12);
+            EXPECT_LT((problems[0]->Phi - problems[1]->Phi).lpNorm<Eigen::Infinity>(), 1e-12);
+        }
+        EXPECT_TRUE(test_jacobian(problems[1]));
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaTaskMaps, testFiniteDifferenceModes)
+{
+    try
+    {
+        TEST_COUT << "Finite-difference mode test";
+        for (const std::string mode : {"Forward", "Central"})
+        {
+            std::vector<UnconstrainedEndPoseProblemPtr> problems;
+            for (const int num_threads : {1, 2})
+            {
+                Initializer map("exotica/Manipulability", {{"Name", std::string("MyTask")},
+                                                           {"AnalyticJacobian", false},
+                                                           {"FiniteDifferenceMode", mode},
+                                                           {"FiniteDifferenceNumThreads", num_threads},
+                                                           {"EndEffector", std::vector<Initializer>(
+                                                                               {Initializer("Frame", {{"Link", std::string("endeff")},
+                                                                                                      {"LinkOffset", std::string("0.5 0 0.5")},
+                                                                                                      {"Base", std::string("base")},
+                                                                                                      {"BaseOffset", std::string("0.5 0.5 0")}})})}});
+                problems.push_back(setup_problem(map));
+            }
+
+            TEST_COUT << mode << " differences";
+            for (int i = 0; i < num_trials_; ++i)
+            {
+                const Eigen::VectorXd x = problems[0]->GetScene()->GetKinematicTree().GetRandomControlledState();
+                for (UnconstrainedEndPoseProblemPtr problem : problems) problem->Update(x);
+                EXPECT_LT((problems[0]->jacobian - problems[1]->jacobian).lpNorm<Eigen::Infinity>(), 1e-12);
+            }
+            EXPECT_TRUE(test_jacobian(problems[0]));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaTaskMaps, testTrajectoryUpdate)
+{
+    try
+    {
+        std::vector<Initializer> maps = {Initializer("exotica/JointPose", {{"Name", std::string("MyTask")}}),
+                                         Initializer("exotica/JointLimit", {{"Name", std::string("MyTask")}, {"SafePercentage", 0.1}}),
+                                         Initializer("exotica/JointVelocityBackwardDifference", {{"Name", std::string("MyTask")}, {"dt", 0.01}}),
+                                         Initializer("exotica/JointAccelerationBackwardDifference", {{"Name", std::string("MyTask")}, {"dt", 0.01}}),
+                                         Initializer("exotica/JointJerkBackwardDifference", {{"Name", std::string("MyTask")}, {"dt", 0.01}})};
+        for (Initializer& map : maps)
+        {
+            TEST_COUT << map.GetName() << " trajectory update test";
+            UnconstrainedEndPoseProblemPtr problem = setup_problem(map);
+            TaskMapPtr task_map = problem->GetTaskMaps().at("MyTask");
+            ASSERT_TRUE(task_map->HasTrajectoryUpdate());
+
+            constexpr int T = 5;
+            const int N = problem->N;
+            const int M = task_map->length;
+            Eigen::MatrixXd x(N, T);
+            for (int t = 0; t < T; ++t) x.col(t) = problem->GetScene()->GetKinematicTree().GetRandomControlledState();
+            Eigen::MatrixXd phi(M, T);
+            std::vector<Eigen::Triplet<double>> triplets;
+            task_map->UpdateTrajectory(x, phi, triplets);
+            Eigen::SparseMatrix<double> jacobian(M * T, N * T);
+            jacobian.setFromTriplets(triplets.begin(), triplets.end());
+
+            // The first time step only uses the start state as history, the joint pose and limits none at all
+            const bool has_history = map.GetName().find("BackwardDifference") != std::string::npos;
+            EXPECT_EQ(task_map->UsesPreviousStates(), has_history);
+            for (int t = 0; t < (has_history ? 1 : T); ++t)
+            {
+                Eigen::VectorXd phi_t = Eigen::VectorXd::Zero(M);
+                task_map->Update(x.col(t), phi_t);
+                EXPECT_LT((phi.col(t) - phi_t).lpNorm<Eigen::Infinity>(), 1e-12);
+            }
+
+            constexpr double h = 1e-6;
+            Eigen::MatrixXd jacobian_fd(M * T, N * T);
+            for (int i = 0; i < N * T; ++i)
+            {
+                Eigen::MatrixXd x_perturbed = x;
+                x_perturbed(i % N, i / N) += h;
+                Eigen::MatrixXd phi_perturbed(M, T);
+                task_map->UpdateTrajectory(x_perturbed, phi_perturbed);
+                phi_perturbed -= phi;
+                jacobian_fd.col(i) = Eigen::Map<const Eigen::VectorXd>(phi_perturbed.data(), M * T) / h;
+            }
+            EXPECT_LT((Eigen::MatrixXd(jacobian) - jacobian_fd).lpNorm<Eigen::Infinity>(), 1e-5);
+        }
     }
     catch (const std::exception& e)
     {
@@ -96,6 +96,25 @@ protected:
     ///@return  Indicates success
     void InitTrajectory(const std::vector<Eigen::VectorXd>& q_init);
 
+    ///\brief Receding-horizon warm start: shifts the messages, beliefs and trajectory of the previous solve by MPCShift time steps,
+    /// clamps the first time step to the start state, extrapolates the new tail and relinearises the task messages
+    ///@param q0 Start state
+    void ShiftMessages(Eigen::VectorXdRefConst q0);
+
+    ///\brief Computes the task messages of all time steps at the current beliefs and the initial cost
+    void InitTaskMessages();
+
+    ///\brief Solves the problem at its current number of time steps (see MultiresolutionLevels)
+    ///@param solution Returned solution trajectory
+    ///@param max_iterations Maximum number of iterations
+    void SolveAtResolution(Eigen::MatrixXd& solution, int max_iterations);
+
+    ///\brief Runs the sweeps from the current messages until convergence
+    ///@param solution Returned solution trajectory
+    ///@param max_iterations Maximum number of iterations
+    ///@param timer Timer started at the beginning of the solve
+    void SolveSweeps(Eigen::MatrixXd& solution, int max_iterations, const Timer& timer);
+
 private:
     UnconstrainedTimeIndexedProblemPtr prob_;  //!< Shared pointer to the planning problem.
     double damping = 0.01;                     //!< Damping
@@ -138,7 +157,7 @@ private:
     std::vector<Eigen::VectorXd> q_old;     //!< Configuration space trajectory (last most optimal value)
     std::vector<Eigen::VectorXd> qhat_old;  //!< Point of linearisation (last most optimal value)
     Eigen::VectorXd cost_control_old_;      //!< Control cost for each time step (last most optimal value)
-    Eigen::MatrixXd cost_task_old_;         //!< Task cost for each task for each time step (last most optimal value)
+    Eigen::VectorXd cost_task_old_;         //!< Task cost for each task for each time step (last most optimal value)
 
     std::vector<Eigen::VectorXd> damping_reference_;         //!< Damping reference point
     double cost_ = 0.0;                                      //!< cost of MAP trajectory
@@ -150,6 +169,12 @@ private:
     Eigen::MatrixXd W;     //!< Configuration space weight matrix inverse
     Eigen::MatrixXd Winv;  //!< Configuration space weight matrix inverse
 
+    Eigen::LLT<Eigen::MatrixXd> llt_;       //!< Cholesky factorisation reused by the message and belief updates
+    Eigen::MatrixXd covariance_workspace_;  //!< Workspace of the matrices factorised by the message updates (N,N)
+    Eigen::MatrixXd marginal_covariance_;   //!< Workspace of the marginalised forward/backward message covariance (N,N)
+    Eigen::VectorXd mean_workspace_;        //!< Workspace of the message and belief means (N)
+    Eigen::VectorXd task_residual_;         //!< Linearised task residual of all cost tasks at the current time step
+
     int last_T_;  //!< T the last time InitMessages was called.
 
     int sweep_ = 0;  //!< Sweeps so far
@@ -160,12 +185,17 @@ private:
         FORWARD = 0,
         SYMMETRIC,
         LOCAL_GAUSS_NEWTON,
-        LOCAL_GAUSS_NEWTON_DAMPED
+        LOCAL_GAUSS_NEWTON_DAMPED,
+        PARALLEL
     };
     int sweep_mode_ = 0;  //!< Sweep mode
     int update_count_ = 0;
 
     bool verbose_ = false;
+    int multiresolution_levels_ = 1;       //!< Number of resolutions solved coarse-to-fine, 1 solves at the resolution of the problem only
+    int multiresolution_iterations_ = 10;  //!< Maximum iterations of each coarse resolution
+    int mpc_shift_ = 0;                    //!< Time steps the messages of the previous solve are shifted by to warm-start the next solve, 0 disables it
+    bool has_solution_ = false;            //!< Whether the messages hold the result of a previous solve at the current T
 
     /// \brief Updates the forward message at time step $t$
     /// @param t Time step
@@ -211,6 +241,21 @@ private:
                         int max_relocation_iterations, double tolerance, bool force_relocation,
                         double max_step_size = -1.);
 
+    /// \brief Updates the belief at time step $t$ from the forward, backward and task messages
+    /// @param t Time step
+    void UpdateBelief(int t);
+
+    /// \brief Update messages of all time steps in one Jacobi-style sweep
+    /// @param max_relocation_iterations Maximum number of relocation while searching for a good linearisation point
+    /// @param tolerance Tolerance for for stopping the search.
+    /// @param force_relocation Set to true to force relocation even when the result is within tolerance.
+    /// @param max_step_size Step size for the relocation of the points of linearisation.
+    /// The forward and backward messages are computed first, for all time steps. The task messages are then relocated
+    /// against these beliefs, and all relocated time steps are evaluated in one trajectory update of the problem.
+    /// The problem evaluates the time steps concurrently on clones of the scene (see TrajectoryNumThreads).
+    void UpdateTimestepsParallel(int max_relocation_iterations, double tolerance, bool force_relocation,
+                                 double max_step_size = -1.);
+
     /// \brief Update messages for given time step using the Gauss Newton method
     /// @param t Time step.
     /// @param update_fwd Update the forward message.
@@ -58,6 +58,12 @@ public:
     /// @return        Successful if the problem is a valid UnconstrainedEndPoseProblem
     void SpecifyProblem(PlanningProblemPtr pointer) override;
 
+    /// \brief Number of task messages of the last solve that reused a cached linearisation (see LinearizationTolerance)
+    int GetNumberOfReusedLinearizations() const { return reused_linearizations_; }
+
+    /// \brief Number of task messages of the last solve that updated the problem to linearise the tasks
+    int GetNumberOfRecomputedLinearizations() const { return recomputed_linearizations_; }
+
 protected:
     /// \brief Initializes message data.
     /// @param q0 Start configuration
@@ -130,6 +136,15 @@ private:
     int sweep_mode_ = 0;  //!< Sweep mode
     int update_count_ = 0;
 
+    double linearization_tolerance_ = 0.0;  //!< Maximum change of the point of linearisation for which the cached linearisation is reused
+    bool linearization_valid_ = false;      //!< Whether the cached linearisation corresponds to the current problem
+    Eigen::VectorXd linearization_point_;   //!< Configuration the cached linearisation was computed at
+    Eigen::MatrixXd linearization_R_;       //!< Task message covariance of the cached linearisation
+    Eigen::VectorXd linearization_r_;       //!< Task message mean of the cached linearisation
+    double linearization_rhat_ = 0.0;       //!< Task message point of linearisation of the cached linearisation
+    int reused_linearizations_ = 0;         //!< Number of task messages reusing the cached linearisation
+    int recomputed_linearizations_ = 0;     //!< Number of task messages updating the problem
+
     bool verbose_ = false;
 
     /// \brief Updates the forward message
@@ -198,6 +213,10 @@ private:
     /// \brief Reverts back to previous state if the cost of the current state is higher.
     void PerhapsUndoStep();
 
+    /// \brief Linearises the task message at x from the current state of the problem and caches the result. UnconstrainedEndPoseProblem::Update(x) has to be called before calling this function.
+    /// @param x Configuration the problem has been updated with.
+    void LinearizeTaskMessage(const Eigen::VectorXd& x);
+
     /// \brief Updates the task cost terms \f$ R, r, \hat{r} \f$. UnconstrainedEndPoseProblem::Update() has to be called before calling this function.
     void GetTaskCosts();
 
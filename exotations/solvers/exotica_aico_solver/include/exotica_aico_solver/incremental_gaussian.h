@@ -87,13 +87,7 @@ public:
         T += x;
         double f = 1. / W / (W - 1.);
         dX = W * x - T;
-        for (int r = 0; r < D; ++r)
-        {
-            for (int c = 0; c < D; ++c)
-            {
-                S(r, c) += f * dX(r) * dX(c);
-            }
-        }
+        S.noalias() += f * dX * dX.transpose();
     }
 
     inline void add(SinglePassMeanCovariance& M)
@@ -102,7 +96,7 @@ public:
     }
 
     void add(double& W_, const Eigen::Ref<const Eigen::VectorXd>& T_,
-             const Eigen::Ref<const Eigen::VectorXd>& S_)
+             const Eigen::Ref<const Eigen::MatrixXd>& S_)
     {
         if (W == 0.)
         {
@@ -114,13 +108,8 @@ public:
         dX = T_ / W_ - T / W;
 
         double f = W * W_ / (W + W_);
-        for (int r = 0; r < D; ++r)
-        {
-            for (int c = 0; c < D; ++c)
-            {
-                S(r, c) += S_(r, c) + f * dX(r) * dX(c);
-            }
-        }
+        S += S_;
+        S.noalias() += f * dX * dX.transpose();
         T += T_;
         W += W_;
     }
@@ -138,13 +127,7 @@ public:
         dX = x - T / W;
 
         double f = W * w / (W + w);
-        for (int r = 0; r < D; ++r)
-        {
-            for (int c = 0; c < D; ++c)
-            {
-                S(r, c) += f * dX(r) * dX(c);
-            }
-        }
+        S.noalias() += f * dX * dX.transpose();
 
         T += w * x;
         W += w;
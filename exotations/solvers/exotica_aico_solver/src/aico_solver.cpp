@@ -35,6 +35,8 @@
 /// \file aico_solver.h
 /// \brief Approximate Inference Control
 
+#include <algorithm>
+
 #include <exotica_aico_solver/aico_solver.h>
 #include <exotica_core/server.h>
 
@@ -53,6 +55,8 @@ void AICOSolver::Instantiate(const AICOSolverInitializer& init)
         sweep_mode_ = LOCAL_GAUSS_NEWTON;
     else if (mode == "LocalGaussNewtonDamped")
         sweep_mode_ = LOCAL_GAUSS_NEWTON_DAMPED;
+    else if (mode == "Parallel")
+        sweep_mode_ = PARALLEL;
     else
     {
         ThrowNamed("Unknown sweep mode '" << init.SweepMode << "'");
@@ -64,6 +68,12 @@ void AICOSolver::Instantiate(const AICOSolverInitializer& init)
     damping_init_ = init.Damping;
     use_bwd_msg_ = init.UseBackwardMessage;
     verbose_ = init.Verbose;
+    if (init.MultiresolutionLevels < 1) ThrowNamed("MultiresolutionLevels needs to be at least 1, got " << init.MultiresolutionLevels);
+    if (init.MultiresolutionIterations < 1) ThrowNamed("MultiresolutionIterations needs to be at least 1, got " << init.MultiresolutionIterations);
+    multiresolution_levels_ = init.MultiresolutionLevels;
+    multiresolution_iterations_ = init.MultiresolutionIterations;
+    if (init.MPCShift < 0) ThrowNamed("MPCShift needs to be non-negative, got " << init.MPCShift);
+    mpc_shift_ = init.MPCShift;
 }
 
 AICOSolver::AICOSolver() = default;
@@ -83,13 +93,61 @@ void AICOSolver::SpecifyProblem(PlanningProblemPtr problem)
 }
 
 void AICOSolver::Solve(Eigen::MatrixXd& solution)
+{
+    EXOTICA_PROFILE_SCOPE("AICOSolver::Solve");
+    Timer timer;
+
+    // Coarse-to-fine: each coarser level halves the number of time steps, its solution is interpolated as the initial trajectory of the next level.
+    // A receding-horizon re-solve starts from the shifted messages of the previous solve instead.
+    const int T = prob_->GetT();
+    const bool shift_messages = mpc_shift_ > 0 && has_solution_ && T == last_T_;
+    ResolutionGuard<UnconstrainedTimeIndexedProblem> restore_resolution(*prob_, T);
+    for (int level = shift_messages ? 0 : multiresolution_levels_ - 1; level > 0; --level)
+    {
+        const int T_level = (T - 1) / (1 << level) + 1;
+        if (T_level < 3 || T_level == prob_->GetT()) continue;
+        if (verbose_) HIGHLIGHT("AICO: Solving multiresolution level " << level << " with T=" << T_level);
+        prob_->SetResolution(T_level);
+        SolveAtResolution(solution, std::min(multiresolution_iterations_, GetNumberOfMaxIterations()));
+
+        std::vector<Eigen::VectorXd> q_init(T_level);
+        for (int t = 0; t < T_level; ++t) q_init[t] = solution.row(t).transpose();
+        prob_->SetInitialTrajectory(q_init);
+    }
+    prob_->SetResolution(T);
+
+    SolveAtResolution(solution, GetNumberOfMaxIterations());
+    if (multiresolution_levels_ > 1) planning_time_ = timer.GetDuration();
+}
+
+void AICOSolver::SolveAtResolution(Eigen::MatrixXd& solution, int max_iterations)
 {
     prob_->PreUpdate();
-    prob_->ResetCostEvolution(GetNumberOfMaxIterations() + 1);
+    prob_->ResetCostEvolution(max_iterations + 1);
     prob_->termination_criterion = TerminationCriterion::NotStarted;
     planning_time_ = -1;
 
     Eigen::VectorXd q0 = prob_->ApplyStartState();
+
+    // Check if the trajectory length has changed, if so update the messages.
+    if (prob_->GetT() != last_T_) InitMessages();
+
+    Timer timer;
+    update_count_ = 0;
+    damping = damping_init_;
+    if (prob_->GetT() <= 0)
+    {
+        ThrowNamed("Problem has not been initialized properly: T=0!");
+    }
+    if (mpc_shift_ > 0 && has_solution_ && mpc_shift_ < prob_->GetT())
+    {
+        if (verbose_) HIGHLIGHT("AICO::Solve warm-started from the messages of the previous solve shifted by " << mpc_shift_ << " time steps");
+        iteration_count_ = -1;
+        ShiftMessages(q0);
+        SolveSweeps(solution, max_iterations, timer);
+        return;
+    }
+
     std::vector<Eigen::VectorXd> q_init = prob_->GetInitialTrajectory();
 
     // If the initial value of the initial trajectory does not equal the start
@@ -108,26 +166,21 @@ void AICOSolver::Solve(Eigen::MatrixXd& solution)
     prob_->SetStartState(q_init[0]);
     prob_->ApplyStartState();
 
-    // Check if the trajectory length has changed, if so update the messages.
-    if (prob_->GetT() != last_T_) InitMessages();
-
-    Timer timer;
     if (verbose_) ROS_WARN_STREAM("AICO: Setting up the solver");
-    update_count_ = 0;
-    damping = damping_init_;
-    double d;
-    if (prob_->GetT() <= 0)
-    {
-        ThrowNamed("Problem has not been initialized properly: T=0!");
-    }
     iteration_count_ = -1;
     InitTrajectory(q_init);
+    SolveSweeps(solution, max_iterations, timer);
+}
+
+void AICOSolver::SolveSweeps(Eigen::MatrixXd& solution, int max_iterations, const Timer& timer)
+{
     if (verbose_) ROS_WARN_STREAM("AICO: Solving");
+    double d;
 
     // Reset sweep and iteration count
     sweep_ = 0;
     iteration_count_ = 0;
-    while (iteration_count_ < GetNumberOfMaxIterations())
+    while (iteration_count_ < max_iterations)
     {
         // Check whether user interrupted (Ctrl+C)
         if (Server::IsRos() && !ros::ok())
@@ -185,7 +238,7 @@ void AICOSolver::Solve(Eigen::MatrixXd& solution)
     }
 
     // Check whether maximum iteration count was reached
-    if (iteration_count_ == GetNumberOfMaxIterations())
+    if (iteration_count_ == max_iterations)
     {
         if (debug_) HIGHLIGHT("Maximum iterations reached");
         prob_->termination_criterion = TerminationCriterion::IterationLimit;
@@ -197,6 +250,7 @@ void AICOSolver::Solve(Eigen::MatrixXd& solution)
         sol.row(tt) = q[tt];
     }
     solution = sol;
+    has_solution_ = true;
     planning_time_ = timer.GetDuration();
 }
 
@@ -247,6 +301,12 @@ void AICOSolver::InitMessages()
     cost_task_.resize(prob_->GetT());
     cost_task_.setZero();
 
+    llt_ = Eigen::LLT<Eigen::MatrixXd>(prob_->N);
+    covariance_workspace_.resize(prob_->N, prob_->N);
+    marginal_covariance_.resize(prob_->N, prob_->N);
+    mean_workspace_.resize(prob_->N);
+    task_residual_.resize(prob_->cost.length_jacobian);
+
     q_stat_.resize(prob_->GetT());
     for (int t = 0; t < prob_->GetT(); ++t)
     {
@@ -255,6 +315,7 @@ void AICOSolver::InitMessages()
 
     // Set last_T_ to the problem T
     last_T_ = prob_->GetT();
+    has_solution_ = false;
 }
 
 void AICOSolver::InitTrajectory(const std::vector<Eigen::VectorXd>& q_init)
@@ -279,6 +340,67 @@ void AICOSolver::InitTrajectory(const std::vector<Eigen::VectorXd>& q_init)
         Vinv.at(t).setZero();
         Vinv.at(t).diagonal().setConstant(damping);
     }
+    InitTaskMessages();
+}
+
+void AICOSolver::ShiftMessages(Eigen::VectorXdRefConst q0)
+{
+    const int T = prob_->GetT();
+    const int k = mpc_shift_;
+
+    // Time step t takes the messages, beliefs and trajectory of time step t + k, the storage is rotated in place
+    std::rotate(s.begin(), s.begin() + k, s.end());
+    std::rotate(Sinv.begin(), Sinv.begin() + k, Sinv.end());
+    std::rotate(v.begin(), v.begin() + k, v.end());
+    std::rotate(Vinv.begin(), Vinv.begin() + k, Vinv.end());
+    std::rotate(r.begin(), r.begin() + k, r.end());
+    std::rotate(R.begin(), R.begin() + k, R.end());
+    std::rotate(b.begin(), b.begin() + k, b.end());
+    std::rotate(Binv.begin(), Binv.begin() + k, Binv.end());
+    std::rotate(q.begin(), q.begin() + k, q.end());
+    std::rotate(qhat.begin(), qhat.begin() + k, qhat.end());
+    std::rotate(q_stat_.begin(), q_stat_.begin() + k, q_stat_.end());
+
+    // The first time step is clamped to the new start state
+    s[0] = q0;
+    b[0] = q0;
+    q[0] = q0;
+    Sinv[0].setZero();
+    Sinv[0].diagonal().setConstant(1e10);
+    Binv[0].setIdentity();
+    Binv[0] *= 1e10;
+
+    // The new tail is extrapolated at the velocity of the last shifted time step (clamped to the joint limits) and initialised as in InitTrajectory
+    const Eigen::MatrixXd& joint_limits = prob_->GetScene()->GetKinematicTree().GetJointLimits();
+    for (int t = std::max(T - k, 1); t < T; ++t)
+    {
+        q[t] = q[t - 1];
+        if (t > 1) q[t] += q[t - 1] - q[t - 2];
+        q[t] = q[t].cwiseMax(joint_limits.col(0)).cwiseMin(joint_limits.col(1));
+        b[t] = q[t];
+        s[t] = q[t];
+        v[t] = q[t];
+        Sinv[t].setZero();
+        Sinv[t].diagonal().setConstant(damping);
+        Vinv[t].setZero();
+        Vinv[t].diagonal().setConstant(damping);
+        Binv[t].setZero();
+        q_stat_[t].clear();
+    }
+    if (use_bwd_msg_)
+    {
+        // The rotation moved the terminal backward message to T - 1 - k, the new terminal time step gets it back
+        v[T - 1] = bwd_msg_v_;
+        Vinv[T - 1] = bwd_msg_Vinv_;
+    }
+    damping_reference_ = b;
+
+    // The goals and the start state may have changed, so the task messages of all time steps are relinearised at the shifted beliefs
+    InitTaskMessages();
+}
+
+void AICOSolver::InitTaskMessages()
+{
     for (int t = 0; t < prob_->GetT(); ++t)
     {
         // Compute task message reference
@@ -305,22 +427,35 @@ void AICOSolver::InitTrajectory(const std::vector<Eigen::VectorXd>& q_init)
 
 void AICOSolver::UpdateFwdMessage(int t)
 {
-    Eigen::MatrixXd barS(prob_->N, prob_->N), St;
-    inverseSymPosDef(barS, Sinv[t - 1] + R[t - 1]);
-    s[t] = barS * (Sinv[t - 1] * s[t - 1] + r[t - 1]);
-    St = Winv + barS;
-    inverseSymPosDef(Sinv[t], St);
+    // The factorisation of Sinv[t-1] + R[t-1] provides both the marginalised covariance and the mean
+    covariance_workspace_ = Sinv[t - 1] + R[t - 1];
+    llt_.compute(covariance_workspace_);
+    marginal_covariance_.setIdentity();
+    llt_.solveInPlace(marginal_covariance_);
+    mean_workspace_.noalias() = Sinv[t - 1] * s[t - 1];
+    mean_workspace_ += r[t - 1];
+    s[t].noalias() = marginal_covariance_ * mean_workspace_;
+    covariance_workspace_ = Winv + marginal_covariance_;
+    llt_.compute(covariance_workspace_);
+    Sinv[t].setIdentity();
+    llt_.solveInPlace(Sinv[t]);
 }
 
 void AICOSolver::UpdateBwdMessage(int t)
 {
-    Eigen::MatrixXd barV(prob_->N, prob_->N), Vt;
     if (t < prob_->GetT() - 1)
     {
-        inverseSymPosDef(barV, Vinv[t + 1] + R[t + 1]);
-        v[t] = barV * (Vinv[t + 1] * v[t + 1] + r[t + 1]);
-        Vt = Winv + barV;
-        inverseSymPosDef(Vinv[t], Vt);
+        covariance_workspace_ = Vinv[t + 1] + R[t + 1];
+        llt_.compute(covariance_workspace_);
+        marginal_covariance_.setIdentity();
+        llt_.solveInPlace(marginal_covariance_);
+        mean_workspace_.noalias() = Vinv[t + 1] * v[t + 1];
+        mean_workspace_ += r[t + 1];
+        v[t].noalias() = marginal_covariance_ * mean_workspace_;
+        covariance_workspace_ = Winv + marginal_covariance_;
+        llt_.compute(covariance_workspace_);
+        Vinv[t].setIdentity();
+        llt_.solveInPlace(Vinv[t]);
     }
     if (t == prob_->GetT() - 1)
     {
@@ -362,11 +497,14 @@ void AICOSolver::UpdateTaskMessage(int t,
 double AICOSolver::GetTaskCosts(int t)
 {
     double C = 0;
-    Eigen::MatrixXd Jt;
     double prec;
     rhat[t] = 0;
     R[t].setZero();
     r[t].setZero();
+
+    // Linearised task residual J * qhat - ydiff of all cost tasks
+    task_residual_.noalias() = prob_->cost.jacobian[t] * qhat[t];
+    task_residual_ -= prob_->cost.ydiff[t];
     for (int i = 0; i < prob_->cost.num_tasks; ++i)
     {
         prec = prob_->cost.rho[t](i);
@@ -374,11 +512,11 @@ double AICOSolver::GetTaskCosts(int t)
         {
             int start = prob_->cost.indexing[i].start_jacobian;
             int len = prob_->cost.indexing[i].length_jacobian;
-            Jt = prob_->cost.jacobian[t].middleRows(start, len).transpose();
+            const auto J = prob_->cost.jacobian[t].middleRows(start, len);
             C += prec * (prob_->cost.ydiff[t].segment(start, len)).squaredNorm();
-            R[t] += prec * Jt * prob_->cost.jacobian[t].middleRows(start, len);
-            r[t] += prec * Jt * (-prob_->cost.ydiff[t].segment(start, len) + prob_->cost.jacobian[t].middleRows(start, len) * qhat[t]);
-            rhat[t] += prec * (-prob_->cost.ydiff[t].segment(start, len) + prob_->cost.jacobian[t].middleRows(start, len) * qhat[t]).squaredNorm();
+            R[t].noalias() += prec * J.transpose() * J;
+            r[t].noalias() += prec * J.transpose() * task_residual_.segment(start, len);
+            rhat[t] += prec * task_residual_.segment(start, len).squaredNorm();
         }
     }
     return prob_->get_ct() * C;
@@ -391,16 +529,7 @@ void AICOSolver::UpdateTimestep(int t, bool update_fwd, bool update_bwd,
     if (update_fwd) UpdateFwdMessage(t);
     if (update_bwd) UpdateBwdMessage(t);
 
-    if (damping != 0.0)
-    {
-        Binv[t] = Sinv[t] + Vinv[t] + R[t] + Eigen::MatrixXd::Identity(prob_->N, prob_->N) * damping;
-        AinvBSymPosDef(b[t], Binv[t], Sinv[t] * s[t] + Vinv[t] * v[t] + r[t] + damping * damping_reference_[t]);
-    }
-    else
-    {
-        Binv[t] = Sinv[t] + Vinv[t] + R[t];
-        AinvBSymPosDef(b[t], Binv[t], Sinv[t] * s[t] + Vinv[t] * v[t] + r[t]);
-    }
+    UpdateBelief(t);
 
     for (int k = 0; k < max_relocation_iterations && !(Server::IsRos() && !ros::ok()); ++k)
     {
@@ -412,15 +541,69 @@ void AICOSolver::UpdateTimestep(int t, bool update_fwd, bool update_bwd,
         if (update_fwd) UpdateFwdMessage(t);
         if (update_bwd) UpdateBwdMessage(t);
 
-        if (damping != 0.0)
+        UpdateBelief(t);
+    }
+}
+
+void AICOSolver::UpdateBelief(int t)
+{
+    Binv[t] = Sinv[t] + Vinv[t] + R[t];
+    mean_workspace_.noalias() = Sinv[t] * s[t];
+    mean_workspace_.noalias() += Vinv[t] * v[t];
+    mean_workspace_ += r[t];
+    if (damping != 0.0)
+    {
+        Binv[t].diagonal().array() += damping;
+        mean_workspace_ += damping * damping_reference_[t];
+    }
+    llt_.compute(Binv[t]);
+    b[t] = mean_workspace_;
+    llt_.solveInPlace(b[t]);
+}
+
+void AICOSolver::UpdateTimestepsParallel(int max_relocation_iterations, double tolerance, bool force_relocation,
+                                         double max_step_size)
+{
+    const int T = prob_->GetT();
+    for (int t = 1; t < T; ++t) UpdateFwdMessage(t);
+    for (int t = T - 2; t > 0; --t) UpdateBwdMessage(t);
+    for (int t = 1; t < T; ++t) UpdateBelief(t);
+
+    // All time steps are relocated against the same messages. Their task messages are independent of each other,
+    // hence the problem evaluates them in a single trajectory update (in parallel if TrajectoryNumThreads > 1).
+    Eigen::VectorXd qhat_trajectory(prob_->N * (T - 1));
+    std::vector<int> relocated_time_steps;
+    relocated_time_steps.reserve(T - 1);
+    for (int k = 0; k < max_relocation_iterations && !(Server::IsRos() && !ros::ok()); ++k)
+    {
+        relocated_time_steps.clear();
+        for (int t = 1; t < T; ++t)
         {
-            Binv[t] = Sinv[t] + Vinv[t] + R[t] + Eigen::MatrixXd::Identity(prob_->N, prob_->N) * damping;
-            AinvBSymPosDef(b[t], Binv[t], Sinv[t] * s[t] + Vinv[t] * v[t] + r[t] + damping * damping_reference_[t]);
+            if (!((!k && force_relocation) || (b[t] - qhat[t]).array().abs().maxCoeff() > tolerance)) continue;
+
+            Eigen::VectorXd diff = b[t] - qhat[t];
+            double nrm = diff.norm();
+            if (max_step_size > 0. && nrm > max_step_size)
+            {
+                qhat[t] += diff * (max_step_size / nrm);
+            }
+            else
+            {
+                qhat[t] = b[t];
+            }
+            relocated_time_steps.push_back(t);
         }
-        else
+        if (relocated_time_steps.empty()) break;
+
+        for (int t = 1; t < T; ++t) qhat_trajectory.segment((t - 1) * prob_->N, prob_->N) = qhat[t];
+        prob_->Update(qhat_trajectory);
+        update_count_ += static_cast<int>(relocated_time_steps.size());
+
+        for (const int t : relocated_time_steps)
         {
-            Binv[t] = Sinv[t] + Vinv[t] + R[t];
-            AinvBSymPosDef(b[t], Binv[t], Sinv[t] * s[t] + Vinv[t] * v[t] + r[t]);
+            double c = GetTaskCosts(t);
+            q_stat_[t].addw(c > 0 ? 1.0 / (1.0 + c) : 1.0, b[t]);
+            UpdateBelief(t);
         }
     }
 }
@@ -442,7 +625,22 @@ double AICOSolver::EvaluateTrajectory(const std::vector<Eigen::VectorXd>& x,
     q = x;
 
     // Perform update / roll-out
-    if (!skip_update)
+    if (!skip_update && sweep_mode_ == PARALLEL)
+    {
+        Eigen::VectorXd x_trajectory(prob_->N * (prob_->GetT() - 1));
+        for (int t = 0; t < prob_->GetT(); ++t)
+        {
+            if (!q[t].allFinite())
+            {
+                ThrowNamed("q[" << t << "] is not finite: " << q[t].transpose());
+            }
+            if (t > 0) x_trajectory.segment((t - 1) * prob_->N, prob_->N) = q[t];
+        }
+        update_count_ += prob_->GetT();
+        prob_->Update(q[0], 0);
+        prob_->Update(x_trajectory);
+    }
+    else if (!skip_update)
     {
         for (int t = 0; t < prob_->GetT(); ++t)
         {
@@ -521,6 +719,9 @@ double AICOSolver::Step()
                 UpdateTimestep(t, false, true, (iteration_count_ ? 5 : 0), minimum_step_tolerance_, false, 1.);
             }
             break;
+        case PARALLEL:
+            UpdateTimestepsParallel((iteration_count_ ? 2 : 1), minimum_step_tolerance_, !iteration_count_, 1.);  //relocate all time steps at once
+            break;
         default:
             ThrowNamed("non-existing Sweep mode");
     }
@@ -569,7 +770,6 @@ void AICOSolver::RememberOldState()
     Binv_old = Binv;
     rhat_old = rhat;
     b_old = b;
-    r_old = r;
     q_old = q;
     qhat_old = qhat;
     cost_old_ = cost_;
@@ -585,24 +785,25 @@ void AICOSolver::PerhapsUndoStep()
     {
         sweep_improved_cost_ = false;
         damping *= 10.;
-        s = s_old;
-        Sinv = Sinv_old;
-        v = v_old;
-        Vinv = Vinv_old;
-        r = r_old;
-        R = R_old;
-        Binv = Binv_old;
-        rhat = rhat_old;
-        b = b_old;
-        r = r_old;
-        q = q_old;
-        qhat = qhat_old;
-        cost_ = cost_old_;
-        damping_reference_ = b_old;
-        cost_control_ = cost_control_old_;
-        cost_task_ = cost_task_old_;
-        best_sweep_ = best_sweep_old_;
-        b_step_ = b_step_old_;
+
+        // The rejected state is swapped into the buffers of the previous state, they are overwritten by the next RememberOldState
+        s.swap(s_old);
+        Sinv.swap(Sinv_old);
+        v.swap(v_old);
+        Vinv.swap(Vinv_old);
+        r.swap(r_old);
+        R.swap(R_old);
+        Binv.swap(Binv_old);
+        rhat.swap(rhat_old);
+        b.swap(b_old);
+        q.swap(q_old);
+        qhat.swap(qhat_old);
+        std::swap(cost_, cost_old_);
+        damping_reference_ = b;
+        cost_control_.swap(cost_control_old_);
+        cost_task_.swap(cost_task_old_);
+        std::swap(best_sweep_, best_sweep_old_);
+        std::swap(b_step_, b_step_old_);
         if (verbose_) HIGHLIGHT("Reverting to previous line-search step (" << best_sweep_ << ")");
     }
     else
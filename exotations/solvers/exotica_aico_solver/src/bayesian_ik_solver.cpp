@@ -62,6 +62,7 @@ void BayesianIKSolver::Instantiate(const BayesianIKSolverInitializer& init)
     damping_init_ = init.Damping;
     use_bwd_msg_ = init.UseBackwardMessage;
     verbose_ = init.Verbose;
+    linearization_tolerance_ = init.LinearizationTolerance;
 }
 
 void BayesianIKSolver::SpecifyProblem(PlanningProblemPtr problem)
@@ -78,6 +79,7 @@ void BayesianIKSolver::SpecifyProblem(PlanningProblemPtr problem)
 
 void BayesianIKSolver::Solve(Eigen::MatrixXd& solution)
 {
+    EXOTICA_PROFILE_SCOPE("BayesianIKSolver::Solve");
     prob_->ResetCostEvolution(GetNumberOfMaxIterations() + 1);
     prob_->termination_criterion = TerminationCriterion::NotStarted;
     planning_time_ = -1;
@@ -87,9 +89,14 @@ void BayesianIKSolver::Solve(Eigen::MatrixXd& solution)
     Timer timer;
     if (verbose_) ROS_WARN_STREAM("BayesianIKSolver: Setting up the solver");
     update_count_ = 0;
+    reused_linearizations_ = 0;
+    recomputed_linearizations_ = 0;
     damping = damping_init_;
     double d;
     iteration_count_ = -1;
+
+    // The scene or the task goals may have changed since the last call
+    linearization_valid_ = false;
     InitTrajectory(q0);
     if (verbose_) ROS_WARN_STREAM("BayesianIKSolver: Solving");
 
@@ -268,19 +275,38 @@ void BayesianIKSolver::UpdateTaskMessage(const Eigen::Ref<const Eigen::VectorXd>
         qhat = qhat_t;
     }
 
+    // The task message only depends on the linearisation and not on qhat, i.e., it can be reused while the linear model is valid
+    if (linearization_valid_ && linearization_tolerance_ >= 0.0 && (qhat - linearization_point_).array().abs().maxCoeff() <= linearization_tolerance_)
+    {
+        R = linearization_R_;
+        r = linearization_r_;
+        rhat = linearization_rhat_;
+        ++reused_linearizations_;
+        return;
+    }
+
     prob_->Update(qhat);
     ++update_count_;
+    ++recomputed_linearizations_;
     GetTaskCosts();
     // q_stat_.addw(c > 0 ? 1.0 / (1.0 + c) : 1.0, qhat_t);
 }
 
 void BayesianIKSolver::GetTaskCosts()
+{
+    LinearizeTaskMessage(qhat);
+    R = linearization_R_;
+    r = linearization_r_;
+    rhat = linearization_rhat_;
+}
+
+void BayesianIKSolver::LinearizeTaskMessage(const Eigen::VectorXd& x)
 {
     Eigen::MatrixXd Jt;
     double prec;
-    rhat = 0;
-    R.setZero();
-    r.setZero();
+    linearization_rhat_ = 0;
+    linearization_R_.setZero(prob_->N, prob_->N);
+    linearization_r_.setZero(prob_->N);
     for (int i = 0; i < prob_->cost.num_tasks; ++i)
     {
         prec = prob_->cost.rho(i);
@@ -289,11 +315,13 @@ void BayesianIKSolver::GetTaskCosts()
             const int& start = prob_->cost.indexing[i].start_jacobian;
             const int& len = prob_->cost.indexing[i].length_jacobian;
             Jt = prob_->cost.jacobian.middleRows(start, len).transpose();
-            R += prec * Jt * prob_->cost.jacobian.middleRows(start, len);
-            r += prec * Jt * (-prob_->cost.ydiff.segment(start, len) + prob_->cost.jacobian.middleRows(start, len) * qhat);
-            rhat += prec * (-prob_->cost.ydiff.segment(start, len) + prob_->cost.jacobian.middleRows(start, len) * qhat).squaredNorm();
+            linearization_R_ += prec * Jt * prob_->cost.jacobian.middleRows(start, len);
+            linearization_r_ += prec * Jt * (-prob_->cost.ydiff.segment(start, len) + prob_->cost.jacobian.middleRows(start, len) * x);
+            linearization_rhat_ += prec * (-prob_->cost.ydiff.segment(start, len) + prob_->cost.jacobian.middleRows(start, len) * x).squaredNorm();
         }
     }
+    linearization_point_ = x;
+    linearization_valid_ = true;
 }
 
 void BayesianIKSolver::UpdateTimestep(bool update_fwd, bool update_bwd,
@@ -355,6 +383,9 @@ double BayesianIKSolver::EvaluateTrajectory(const Eigen::VectorXd& x, bool skip_
     {
         ++update_count_;
         prob_->Update(q);
+
+        // The roll-out linearises the problem at the new belief, which is where the next sweep relocates to
+        if (linearization_tolerance_ >= 0.0) LinearizeTaskMessage(q);
     }
 
     // Task cost
@@ -36,6 +36,8 @@
 #include <exotica_core/tools/conversions.h>
 #include <exotica_ddp_solver/abstract_ddp_solver_initializer.h>
 
+#include <array>
+
 namespace exotica
 {
 // \brief Base DDP Solver class that implements the forward pass.
@@ -43,7 +45,7 @@ namespace exotica
 class AbstractDDPSolver : public FeedbackMotionSolver
 {
 public:
-    ///\brief Solves the problem
+    ///\brief Solves the problem, coarse-to-fine if MultiresolutionLevels > 1
     ///@param solution Returned solution trajectory as a vector of joint configurations.
     void Solve(Eigen::MatrixXd& solution) override;
 
@@ -83,10 +85,33 @@ public:
     std::vector<double> get_regularization_evolution() const;
     // void set_regularization_evolution(const int index, const double cost);
 
+    /// \brief Phases of an iteration timed by the solvers, i.e., the columns of get_phase_duration_evolution.
+    enum Phase
+    {
+        kDynamicsDerivativesPhase = 0,  ///< Derivatives of the state transitions (fx, fu)
+        kCostDerivativesPhase,          ///< Derivatives of the costs
+        kBackwardPassPhase,             ///< Whole backward pass, including the derivatives and BoxQP
+        kBoxQPPhase,                    ///< BoxQP of the control-limited solvers
+        kLineSearchPhase,               ///< Forward rollouts of all step lengths tried by the line search
+        kProblemUpdatePhase,            ///< Update of the problem along the accepted iterate
+        kNumberOfPhases
+    };
+
+    /// \brief Returns the durations in seconds of the phases (columns, see Phase) of each iteration (rows).
+    Eigen::MatrixXd get_phase_duration_evolution() const;
+
+    /// \brief Returns the number of forward rollouts tried by the line search of each iteration.
+    std::vector<int> get_line_search_trials_evolution() const;
+
 protected:
     DynamicTimeIndexedShootingProblemPtr prob_;  ///< Shared pointer to the planning problem.
     DynamicsSolverPtr dynamics_solver_;          ///< Shared pointer to the dynamics solver.
 
+    ///\brief Solves the problem at its current number of time steps (see MultiresolutionLevels)
+    ///@param solution Returned control trajectory
+    ///@param max_iterations Maximum number of iterations
+    virtual void SolveAtResolution(Eigen::MatrixXd& solution, int max_iterations);
+
     ///\brief Computes the control gains for a the trajectory in the associated
     ///     DynamicTimeIndexedProblem.
     virtual void BackwardPass() = 0;
@@ -98,6 +123,10 @@ protected:
     /// @return The cost associated with the new control and state trajectory.
     double ForwardPass(const double alpha);
 
+    ///\brief Simulates the line-search steps in parallel rollouts (ParallelLineSearch) and returns the index of the first step the serial line
+    ///     search accepts, i.e., the index it continues from (0 if disabled).
+    int ParallelLineSearch();
+
     AbstractDDPSolverInitializer base_parameters_;
 
     virtual void IncreaseRegularization()
@@ -145,13 +174,23 @@ protected:
     std::vector<Eigen::VectorXd> X_ref_;  ///< Reference state trajectory for feedback control
     std::vector<Eigen::VectorXd> U_ref_;  ///< Reference control trajectory for feedback control
 
-    std::vector<Eigen::MatrixXd> Quu_inv_;  ///< Inverse of the Hessian of the Hamiltonian
-    std::vector<Eigen::MatrixXd> fx_;       ///< Derivative of the dynamics f w.r.t. x
-    std::vector<Eigen::MatrixXd> fu_;       ///< Derivative of the dynamics f w.r.t. u
+    std::vector<Eigen::MatrixXd> Quu_inv_;      ///< Inverse of the Hessian of the Hamiltonian
+    TrajectoryLinearization linearization_;  ///< Derivatives of the dynamics (fx, fu) and of the cost along the trajectory
 
     std::vector<double> control_cost_evolution_;    ///< Evolution of the control cost (control regularization)
     std::vector<double> steplength_evolution_;      ///< Evolution of the steplength
     std::vector<double> regularization_evolution_;  ///< Evolution of the regularization (xreg/ureg)
+
+    std::array<double, kNumberOfPhases> phase_durations_;                   ///< Durations of the phases of the current iteration
+    std::vector<std::array<double, kNumberOfPhases>> phase_duration_evolution_;  ///< Evolution of the phase durations
+    int line_search_trials_ = 0;                                            ///< Number of forward rollouts of the current line search
+    std::vector<int> line_search_trials_evolution_;                         ///< Evolution of the number of forward rollouts of the line search
+
+    ///\brief Resets the phase durations and line-search trials of the logs (e.g. at the beginning of Solve).
+    void ResetPhaseDurationEvolution();
+
+    ///\brief Stores the phase durations and line-search trials of the current iteration and resets them for the next one.
+    void StorePhaseDurations(const int iteration);
 };
 
 }  // namespace exotica
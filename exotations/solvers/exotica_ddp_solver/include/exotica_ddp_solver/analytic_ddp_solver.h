@@ -48,7 +48,18 @@ private:
     ///     DynamicTimeIndexedProblem.
     void BackwardPass() override;
 
-    Eigen::LLT<Eigen::MatrixXd> Quu_llt_;
+    ///\brief Riccati recursion of the backward pass. Instantiated with fixed sizes
+    ///     for common small systems and with Eigen::Dynamic for all others.
+    template <int NDX, int NU>
+    void BackwardPassRecursion();
+
+    // Workspace of BackwardPass
+    Eigen::MatrixXd Quu_llt_;              ///< Storage of the in-place Cholesky decomposition of Quu (NU,NU)
+    Eigen::VectorXd x_, u_;                ///< State and control of the second order terms
+    Eigen::MatrixXd Vxx_fx_;               ///< Vxx fx (NDX,NDX)
+    Eigen::MatrixXd Vxx_fu_;               ///< Vxx fu (NDX,NU)
+    Eigen::VectorXd Quu_k_;                ///< Quu k + Qu (NU)
+    Eigen::MatrixXd Quu_K_;                ///< Quu K + Qux (NU,NDX)
 };
 }  // namespace exotica
 
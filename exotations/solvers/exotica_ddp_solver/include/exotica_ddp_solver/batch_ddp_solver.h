@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_DDP_SOLVER_BATCH_DDP_SOLVER_H_
+#define EXOTICA_DDP_SOLVER_BATCH_DDP_SOLVER_H_
+
+#include <exotica_core/motion_solver.h>
+#include <exotica_core/problems/dynamic_time_indexed_shooting_problem.h>
+#include <exotica_core/server.h>
+#include <exotica_ddp_solver/batch_ddp_solver_initializer.h>
+
+namespace exotica
+{
+/// \brief Solves many independent DynamicTimeIndexedShootingProblems of identical structure with the iterations of the AnalyticDDPSolver in
+/// lockstep, e.g., to generate datasets of small trajectory optimisation problems.
+///
+/// The problems may differ in their start states, goal states, Q, Qf, R and initial controls. They need to have the same T, tau and
+/// Euclidean state space, dynamics solvers of the same type and dt, L2 control costs and no task maps. The dynamics of all problems are
+/// evaluated with the dynamics solver of the first problem, i.e., its parameters (e.g., masses) apply to all.
+///
+/// The data of all problems is stored as structure of arrays, one column per problem and one row per matrix entry, such that the backward
+/// pass, the feedback controls and the costs are element-wise expressions over the batch that the compiler vectorises. The rollouts of
+/// the line search simulate all problems at once with SimulateBatch, the derivatives of the dynamics are evaluated with one
+/// ComputeDerivativesBatch call for all problems. Problems that converge or diverge drop out of the batch after the iteration.
+///
+/// Unlike the AbstractDDPSolver, the solver does not expose the gains, value function or Q-function derivatives: the columns of a problem
+/// are reused by the remaining problems once it drops out, such that they only hold the last iteration of the still active problems. The
+/// results of each problem are its states, controls, cost evolution and termination criterion.
+class BatchDDPSolver : public MotionSolver, public Instantiable<BatchDDPSolverInitializer>
+{
+public:
+    void Instantiate(const BatchDDPSolverInitializer& init) override;
+
+    ///\brief Binds the solver to a single problem, i.e., a batch of one.
+    void SpecifyProblem(PlanningProblemPtr pointer) override;
+
+    ///\brief Binds the solver to the problems solved in lockstep, which must be pre-initialised and of identical structure.
+    void SpecifyProblems(const std::vector<DynamicTimeIndexedShootingProblemPtr>& problems);
+
+    ///\brief Solves all problems and returns the control trajectory of the first one.
+    ///@param solution Returned control trajectory of the first problem.
+    void Solve(Eigen::MatrixXd& solution) override;
+
+    ///\brief Solves all problems. The states, controls, cost evolution and termination criterion of each problem are set as by Solve
+    ///     of a single-problem solver.
+    ///@param solutions Returned control trajectories (T-1 x NU), one per problem.
+    void SolveBatch(std::vector<Eigen::MatrixXd>& solutions);
+
+    const std::vector<DynamicTimeIndexedShootingProblemPtr>& GetProblems() const { return problems_; }
+
+    /// \brief Returns the number of iterations each problem took in the last Solve.
+    const std::vector<int>& GetNumberOfIterations() const { return num_iterations_; }
+
+    /// \brief Structure-of-arrays storage of one (rows x cols) matrix per problem: entry (i, j) of all problems is the contiguous row
+    /// i + j * rows, column c belongs to the c-th active problem.
+    typedef Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> BatchArray;
+    typedef Eigen::Array<double, 1, Eigen::Dynamic> BatchRow;  ///< One scalar per problem
+
+private:
+    /// \brief Resizes the batch storage and loads the goals, weights, start states and initial controls of all problems.
+    void LoadProblems();
+
+    /// \brief Linearises the dynamics about the reference trajectories and computes the gains of the active problems.
+    void BackwardPass();
+
+    /// \brief Simulates the controls U_ref + alpha * k + K * (x - X_ref) of all active problems into X_try_, U_try_ and cost_try_
+    ///     (open_loop: U_ref).
+    void ForwardPass(double alpha, bool open_loop);
+
+    /// \brief Writes the reference trajectory of the active problem in column c back to its problem.
+    void FinishProblem(int c, TerminationCriterion criterion, int iterations);
+
+    /// \brief Keeps the active problems whose column is marked in keep, in order, i.e., moves their columns to the front of the batch.
+    void CompactBatch(const std::vector<bool>& keep);
+
+    std::vector<DynamicTimeIndexedShootingProblemPtr> problems_;  ///< Problems of the batch
+    DynamicsSolverPtr dynamics_solver_;                           ///< Dynamics solver of the first problem, evaluates the dynamics of all problems
+    std::vector<int> num_iterations_;                             ///< Number of iterations of each problem in the last Solve
+
+    Eigen::VectorXd alpha_space_;  ///< Backtracking line-search steplengths
+    int T_ = 0;                    ///< Length of the state trajectories
+    int NU_ = 0;                   ///< Size of control vector
+    int NX_ = 0;                   ///< Size of state vector (Euclidean, i.e., also the size of the tangent vector)
+    double dt_ = 0.0;              ///< Integration time-step
+    int num_substeps_ = 1;         ///< Integration steps per time step, i.e., tau / dt
+
+    // Structure of arrays of the active problems: n_ columns are used, column c belongs to problem active_[c]
+    int n_ = 0;                                                     ///< Number of active problems
+    std::vector<int> active_;                                       ///< Index of the problem of each column
+    std::vector<BatchArray> X_ref_, U_ref_;                         ///< Reference trajectories (NX x 1 per time step, NU x 1 per time step)
+    std::vector<BatchArray> X_try_, U_try_;                         ///< Trajectories of the line-search step
+    std::vector<BatchArray> X_star_, Q_;                            ///< Goal states and state cost weights (NX x NX)
+    BatchArray R_sym_, R_diag_;                                     ///< Control cost Hessian w (R + R^T) (NU x NU) and diagonal w diag(R) of the control cost
+    std::vector<BatchArray> fx_, fu_;                               ///< Derivatives of the state transitions (NX x NX, NX x NU)
+    std::vector<BatchArray> Vx_, Vxx_;                              ///< Gradient and Hessian of the value function
+    std::vector<BatchArray> k_, K_;                                 ///< Feed-forward terms and feedback gains (NU x NX)
+    BatchArray Qx_, Qu_, Qxx_, Quu_, Qux_;                          ///< Expansion of the Hamiltonian of the current time step
+    BatchArray Quu_llt_;                                            ///< Cholesky factor of Quu (lower triangle)
+    BatchArray Vxx_fx_, Vxx_fu_;                                    ///< Vxx fx, Vxx fu
+    BatchArray Quu_k_, Quu_K_;                                      ///< Quu k + Qu, Quu K + Qux
+    BatchArray x_diff_;                                             ///< State differences of the current time step
+    BatchRow cost_, cost_prev_, cost_try_;                          ///< Costs of the references, the previous iteration and the line-search step
+    BatchRow lambda_, alpha_best_, scratch_;                        ///< Regularization, line-search step taken, scratch row
+    Eigen::Array<bool, 1, Eigen::Dynamic> factorized_, searching_;  ///< Quu is positive definite, line search is ongoing
+    std::vector<int> last_best_iteration_;                          ///< Function tolerance patience
+
+    Eigen::MatrixXd X_stack_, U_stack_;                 ///< Reference trajectories of all active problems, time step major (NX x n*(T-1))
+    std::vector<Eigen::MatrixXd> Fx_stack_, Fu_stack_;  ///< Derivatives of the stacked states and controls
+    Eigen::MatrixXd x_batch_, u_batch_, x_next_batch_;  ///< States and controls of SimulateBatch
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_DDP_SOLVER_BATCH_DDP_SOLVER_H_
@@ -30,6 +30,7 @@
 #ifndef EXOTICA_DDP_SOLVER_CONTROL_LIMITED_DDP_SOLVER_H_
 #define EXOTICA_DDP_SOLVER_CONTROL_LIMITED_DDP_SOLVER_H_
 
+#include <exotica_core/tools/box_qp.h>
 #include <exotica_ddp_solver/abstract_ddp_solver.h>
 #include <exotica_ddp_solver/control_limited_ddp_solver_initializer.h>
 #include <unsupported/Eigen/CXX11/Tensor>
@@ -47,6 +48,8 @@ private:
     ///\brief Computes the control gains for a the trajectory in the associated
     ///     DynamicTimeIndexedProblem.
     void BackwardPass() override;
+
+    BoxQPWorkspace boxqp_workspace_;  ///< Shared by the BoxQPs of all time steps
 };
 }  // namespace exotica
 
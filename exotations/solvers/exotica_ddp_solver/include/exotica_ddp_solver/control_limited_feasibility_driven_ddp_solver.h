@@ -30,6 +30,7 @@
 #ifndef EXOTICA_DDP_SOLVER_CONTROL_LIMITED_FEASIBILITY_DRIVEN_DDP_SOLVER_H_
 #define EXOTICA_DDP_SOLVER_CONTROL_LIMITED_FEASIBILITY_DRIVEN_DDP_SOLVER_H_
 
+#include <exotica_core/tools/box_qp.h>
 #include <exotica_ddp_solver/control_limited_feasibility_driven_ddp_solver_initializer.h>
 #include <exotica_ddp_solver/feasibility_driven_ddp_solver.h>
 
@@ -46,9 +47,9 @@ protected:
     void ComputeGains(const int t) override;
 
     void AllocateData() override;
-    std::vector<Eigen::MatrixXd> Quu_inv_;
     Eigen::VectorXd du_lb_;
     Eigen::VectorXd du_ub_;
+    BoxQPWorkspace boxqp_workspace_;  ///< Shared by the BoxQPs of all time steps
 };
 }  // namespace exotica
 
@@ -41,7 +41,6 @@ namespace exotica
 class AbstractFeasibilityDrivenDDPSolver : public AbstractDDPSolver
 {
 public:
-    void Solve(Eigen::MatrixXd& solution) override;
     void SpecifyProblem(PlanningProblemPtr pointer) override;
 
     const std::vector<Eigen::VectorXd>& get_fs() const { return fs_; };
@@ -52,6 +51,8 @@ protected:
     int NDX_;
     int last_T_ = -1;
 
+    void SolveAtResolution(Eigen::MatrixXd& solution, int max_iterations) override;
+
     void IncreaseRegularization() override;
     void DecreaseRegularization() override;
     const Eigen::Vector2d& ExpectedImprovement();
@@ -78,11 +79,25 @@ protected:
     void ForwardPass(const double steplength);
     double TryStep(const double steplength);
 
+    ///\brief Predicts whether the line search accepts the step length by a multiple-shooting rollout of the trial step (ParallelForwardPass):
+    ///     the horizon is split into one segment per thread of the problem's rollouts, the nodes at the segment beginnings are predicted by the
+    ///     linearised dynamics and the segments are simulated in parallel. The gaps at the segment boundaries are closed by the serial TryStep of
+    ///     the steps predicted to be accepted.
+    bool PredictStep(const double steplength);
+
     virtual void AllocateData();
 
+    ///\brief Shifts the trajectories of the problem (see DynamicTimeIndexedShootingProblem::ShiftTrajectory) by mpc_shift_ time steps to
+    ///     warm-start the re-solve of a receding horizon.
+    void ShiftWarmStart();
+
     Eigen::MatrixXd control_limits_;
     double initial_regularization_rate_ = 1e-9;             // Set from parameters on Instantiate
     bool clamp_to_control_limits_in_forward_pass_ = false;  // Set from parameters on Instantiate
+    int mpc_shift_ = 0;                                     // Set from parameters on Instantiate
+    double max_planning_time_ = 0.;                         // Set from parameters on Instantiate
+    bool has_solution_ = false;                             //!< Whether the allocated data holds the solution of a previous Solve (to be shifted)
+    bool parallel_forward_pass_ = false;                    // Set from parameters on Instantiate
 
     double steplength_;                  //!< Current applied step-length
     Eigen::Vector2d d_;                  //!< LQ approximation of the expected improvement
@@ -99,6 +114,8 @@ protected:
     double th_acceptnegstep_ = 2.;  //!< Threshold used for accepting step along ascent direction
     std::vector<Eigen::VectorXd> us_;
     std::vector<Eigen::VectorXd> xs_;
+    Eigen::MatrixXd xs_batch_;  //!< States of the current iterate (one column per node) for LinearizeDynamics
+    Eigen::MatrixXd us_batch_;  //!< Controls of the current iterate for LinearizeDynamics
     bool is_feasible_ = false;
     double xreg_ = 1e-9;      //!< State regularization
     double ureg_ = 1e-9;      //!< Control regularization
@@ -109,6 +126,19 @@ protected:
     std::vector<Eigen::VectorXd> xs_try_;  //!< State trajectory computed by line-search procedure
     std::vector<Eigen::VectorXd> us_try_;  //!< Control trajectory computed by line-search procedure
     std::vector<Eigen::VectorXd> dx_;
+    std::vector<Eigen::VectorXd> xs_best_;  //!< Best feasible state trajectory found within the deadline (MaxPlanningTime)
+    std::vector<Eigen::VectorXd> us_best_;  //!< Best feasible control trajectory found within the deadline (MaxPlanningTime)
+    double best_cost_;                      //!< Cost of the best feasible iterate
+
+    // Multiple-shooting rollouts of PredictStep
+    typedef DynamicTimeIndexedShootingProblem::ShootingPolicy ShootingPolicy;
+    std::vector<int> segment_begin_;
+    std::vector<Eigen::VectorXd> x_begin_;
+    std::vector<Eigen::VectorXd> gap_steps_;      //!< (steplength - 1) * fs_: the gaps left open by an infeasible trial step
+    std::vector<Eigen::VectorXd> segment_nodes_;  //!< Shooting node written by the policy, one per segment as each segment runs on one thread
+    Eigen::VectorXd node0_;                       //!< First shooting node of the trial step
+    Eigen::VectorXd predict_dx_, predict_dx_next_, predict_du_;
+    Eigen::MatrixXd X_segments_, U_segments_, X_sim_segments_;
 
     // allocate data
     std::vector<Eigen::VectorXd> fs_;  //!< Gaps/defects between shooting nodes
@@ -33,8 +33,34 @@ namespace exotica
 {
 void AbstractDDPSolver::Solve(Eigen::MatrixXd& solution)
 {
+    EXOTICA_PROFILE_SCOPE("AbstractDDPSolver::Solve");
     if (!prob_) ThrowNamed("Solver has not been initialized!");
-    Timer planning_timer, backward_pass_timer, line_search_timer;
+    if (base_parameters_.MultiresolutionLevels < 1) ThrowNamed("MultiresolutionLevels needs to be at least 1, got " << base_parameters_.MultiresolutionLevels);
+    Timer planning_timer;
+
+    // Coarse-to-fine: each coarser level halves the number of time steps, its controls are resampled as the initial guess of the next level
+    const int T = prob_->get_T();
+    ResolutionGuard<DynamicTimeIndexedShootingProblem> restore_resolution(*prob_, T);
+    for (int level = base_parameters_.MultiresolutionLevels - 1; level > 0; --level)
+    {
+        const int T_level = (T - 1) / (1 << level) + 1;
+        if (T_level < 3 || T_level == prob_->get_T()) continue;
+        if (debug_) HIGHLIGHT_NAMED("DDPSolver", "Solving multiresolution level " << level << " with T=" << T_level);
+        prob_->SetResolution(T_level);
+        SolveAtResolution(solution, std::min(base_parameters_.MultiresolutionIterations, GetNumberOfMaxIterations()));
+        prob_->set_U(solution.transpose());
+    }
+    prob_->SetResolution(T);
+
+    SolveAtResolution(solution, GetNumberOfMaxIterations());
+    if (base_parameters_.MultiresolutionLevels > 1) planning_time_ = planning_timer.GetDuration();
+}
+
+void AbstractDDPSolver::SolveAtResolution(Eigen::MatrixXd& solution, int max_iterations)
+{
+    EXOTICA_PROFILE_SCOPE("AbstractDDPSolver::SolveAtResolution");
+    if (!prob_) ThrowNamed("Solver has not been initialized!");
+    Timer planning_timer, backward_pass_timer, line_search_timer, problem_update_timer;
 
     T_ = prob_->get_T();
     NU_ = prob_->GetScene()->get_num_controls();
@@ -43,14 +69,15 @@ void AbstractDDPSolver::Solve(Eigen::MatrixXd& solution)
     NV_ = prob_->GetScene()->get_num_velocities();
     dt_ = dynamics_solver_->get_dt();
     lambda_ = base_parameters_.RegularizationRate;
-    prob_->ResetCostEvolution(GetNumberOfMaxIterations() + 1);
+    prob_->ResetCostEvolution(max_iterations + 1);
     prob_->PreUpdate();
     solution.resize(T_ - 1, NU_);
 
     // Resizing and allocating logged variables
-    control_cost_evolution_.assign(GetNumberOfMaxIterations() + 1, std::numeric_limits<double>::quiet_NaN());
-    steplength_evolution_.assign(GetNumberOfMaxIterations() + 1, std::numeric_limits<double>::quiet_NaN());
-    regularization_evolution_.assign(GetNumberOfMaxIterations() + 1, std::numeric_limits<double>::quiet_NaN());
+    control_cost_evolution_.assign(max_iterations + 1, std::numeric_limits<double>::quiet_NaN());
+    steplength_evolution_.assign(max_iterations + 1, std::numeric_limits<double>::quiet_NaN());
+    regularization_evolution_.assign(max_iterations + 1, std::numeric_limits<double>::quiet_NaN());
+    ResetPhaseDurationEvolution();
 
     // Perform initial roll-out
     cost_ = 0.0;
@@ -98,15 +125,15 @@ void AbstractDDPSolver::Solve(Eigen::MatrixXd& solution)
     Qux_.assign(T_ - 1, Eigen::MatrixXd::Zero(NU_, NDX_));
     Quu_.assign(T_ - 1, Eigen::MatrixXd::Zero(NU_, NU_));
     Quu_inv_.assign(T_ - 1, Eigen::MatrixXd::Zero(NU_, NU_));
-    fx_.assign(T_ - 1, Eigen::MatrixXd::Zero(NDX_, NDX_));
-    fu_.assign(T_ - 1, Eigen::MatrixXd::Zero(NDX_, NU_));
+    linearization_.fx.assign(T_ - 1, Eigen::MatrixXd::Zero(NDX_, NDX_));
+    linearization_.fu.assign(T_ - 1, Eigen::MatrixXd::Zero(NDX_, NU_));
 
-    if (debug_) HIGHLIGHT_NAMED("DDPSolver", "Running DDP solver for max " << GetNumberOfMaxIterations() << " iterations");
+    if (debug_) HIGHLIGHT_NAMED("DDPSolver", "Running DDP solver for max " << max_iterations << " iterations");
 
     cost_prev_ = cost_;
     int last_best_iteration = 0;
 
-    for (int iteration = 1; iteration <= GetNumberOfMaxIterations(); ++iteration)
+    for (int iteration = 1; iteration <= max_iterations; ++iteration)
     {
         // Check whether user interrupted (Ctrl+C)
         if (Server::IsRos() && !ros::ok())
@@ -120,13 +147,14 @@ void AbstractDDPSolver::Solve(Eigen::MatrixXd& solution)
         backward_pass_timer.Reset();
         BackwardPass();
         time_taken_backward_pass_ = backward_pass_timer.GetDuration();
+        phase_durations_[kBackwardPassPhase] = time_taken_backward_pass_;
 
         // Forward-pass to compute new control trajectory
         line_search_timer.Reset();
 
         double rollout_cost = cost_prev_;
         // Perform a linear search to find the best rate
-        for (int ai = 0; ai < alpha_space_.size(); ++ai)
+        for (int ai = ParallelLineSearch(); ai < alpha_space_.size(); ++ai)
         {
             const double& alpha = alpha_space_(ai);
             rollout_cost = ForwardPass(alpha);
@@ -142,6 +170,7 @@ void AbstractDDPSolver::Solve(Eigen::MatrixXd& solution)
             }
         }
         time_taken_forward_pass_ = line_search_timer.GetDuration();
+        phase_durations_[kLineSearchPhase] = time_taken_forward_pass_;
 
         // Finiteness checks
         // if (!U_try_.allFinite())
@@ -230,16 +259,25 @@ void AbstractDDPSolver::Solve(Eigen::MatrixXd& solution)
 
         // Roll-out and store reference state trajectory
         // TODO: This roll-out may not be required => The line-search already does a roll-out.
+        problem_update_timer.Reset();
         for (int t = 0; t < T_ - 1; ++t)
             prob_->Update(U_ref_[t], t);
         for (int t = 0; t < T_; ++t)
             X_ref_[t] = prob_->get_X(t);
-
-        prob_->SetCostEvolution(iteration, cost_);
+        phase_durations_[kProblemUpdatePhase] = problem_update_timer.GetDuration();
+
+        IterationRecord record;
+        record.cost = cost_;
+        record.step_length = alpha_best_;
+        record.regularization = lambda_;
+        record.phase_durations[0] = time_taken_backward_pass_;
+        record.phase_durations[1] = time_taken_forward_pass_;
+        prob_->SetCostEvolution(iteration, record);
         control_cost_evolution_.at(iteration) = control_cost_;
+        StorePhaseDurations(iteration);
 
         // Iteration limit
-        if (iteration == GetNumberOfMaxIterations())
+        if (iteration == max_iterations)
         {
             if (debug_) HIGHLIGHT_NAMED("DDPSolver", "Max iterations reached. Time: " << planning_timer.GetDuration());
             prob_->termination_criterion = TerminationCriterion::IterationLimit;
@@ -255,6 +293,9 @@ void AbstractDDPSolver::Solve(Eigen::MatrixXd& solution)
         prob_->Update(U_ref_[t], t);  // TODO: This roll-out may also not be required...
     }
 
+    // Export the policy of GetFeedbackControl for control threads
+    PublishFeedbackPolicy(std::make_shared<const FeedbackPolicy>(dynamics_solver_, X_ref_, U_ref_, std::vector<Eigen::VectorXd>(k_.begin(), k_.begin() + T_ - 1), std::vector<Eigen::MatrixXd>(K_.begin(), K_.begin() + T_ - 1)));
+
     planning_time_ = planning_timer.GetDuration();
 }
 
@@ -278,8 +319,44 @@ void AbstractDDPSolver::SpecifyProblem(PlanningProblemPtr pointer)
     if (debug_) HIGHLIGHT_NAMED("DDPSolver", "initialized");
 }
 
+int AbstractDDPSolver::ParallelLineSearch()
+{
+    const int num_threads = prob_->GetRolloutNumThreads();
+    if (!base_parameters_.ParallelLineSearch || num_threads <= 1) return 0;
+
+    // Simulates the step lengths in order in batches of one rollout per thread. The first step length with a lower cost is the one the serial line
+    // search accepts, it is replayed by the serial line search to update the problem. Returns the index the serial line search continues from.
+    const Eigen::VectorXd x0 = prob_->get_X(0);
+    const Eigen::MatrixXd& control_limits = dynamics_solver_->get_control_limits();
+    Eigen::VectorXd costs;
+    std::vector<Eigen::MatrixXd> X_rollouts;
+    std::vector<Eigen::VectorXd> xdiff_rollouts(num_threads, Eigen::VectorXd(NDX_));
+    for (int begin = 0; begin < alpha_space_.size(); begin += num_threads)
+    {
+        const int num_rollouts = std::min(num_threads, static_cast<int>(alpha_space_.size()) - begin);
+        // The state deltas use the dynamics solver of the calling thread and a buffer of the rollout, the shared dynamics_solver_ is not thread-safe
+        const DynamicTimeIndexedShootingProblem::RolloutPolicy policy = [&](int k, int t, DynamicsSolver& dynamics_solver, Eigen::VectorXdRefConst x, Eigen::VectorXdRef u) {
+            Eigen::VectorXd& xdiff = xdiff_rollouts[k];
+            dynamics_solver.StateDelta(x, X_ref_[t], xdiff);
+            u = U_ref_[t];
+            u.noalias() += alpha_space_(begin + k) * k_[t];
+            u.noalias() += K_[t] * xdiff;
+            if (base_parameters_.ClampControlsInForwardPass) u = u.cwiseMax(control_limits.col(0)).cwiseMin(control_limits.col(1));
+        };
+        prob_->Rollout(x0, num_rollouts, policy, costs, X_rollouts);
+        line_search_trials_ += num_rollouts;
+        for (int k = 0; k < num_rollouts; ++k)
+        {
+            if (costs(k) < cost_) return begin + k;
+        }
+    }
+    return alpha_space_.size();
+}
+
 double AbstractDDPSolver::ForwardPass(const double alpha)
 {
+    EXOTICA_PROFILE_SCOPE("AbstractDDPSolver::ForwardPass");
+    ++line_search_trials_;
     cost_try_ = 0.0;
     control_cost_try_ = 0.0;
 
@@ -309,6 +386,24 @@ double AbstractDDPSolver::ForwardPass(const double alpha)
     return cost_try_;
 }
 
+void AbstractDDPSolver::ResetPhaseDurationEvolution()
+{
+    std::array<double, kNumberOfPhases> nan_durations;
+    nan_durations.fill(std::numeric_limits<double>::quiet_NaN());
+    phase_duration_evolution_.assign(GetNumberOfMaxIterations() + 1, nan_durations);
+    line_search_trials_evolution_.assign(GetNumberOfMaxIterations() + 1, -1);
+    phase_durations_.fill(0.0);
+    line_search_trials_ = 0;
+}
+
+void AbstractDDPSolver::StorePhaseDurations(const int iteration)
+{
+    phase_duration_evolution_.at(iteration) = phase_durations_;
+    line_search_trials_evolution_.at(iteration) = line_search_trials_;
+    phase_durations_.fill(0.0);
+    line_search_trials_ = 0;
+}
+
 Eigen::VectorXd AbstractDDPSolver::GetFeedbackControl(Eigen::VectorXdRefConst x, int t) const
 {
     Eigen::VectorXd u = U_ref_[t] + k_[t] + K_[t] * dynamics_solver_->StateDelta(x, X_ref_[t]);
@@ -329,8 +424,8 @@ const std::vector<Eigen::VectorXd>& AbstractDDPSolver::get_U_try() const { retur
 const std::vector<Eigen::VectorXd>& AbstractDDPSolver::get_X_ref() const { return X_ref_; }
 const std::vector<Eigen::VectorXd>& AbstractDDPSolver::get_U_ref() const { return U_ref_; }
 const std::vector<Eigen::MatrixXd>& AbstractDDPSolver::get_Quu_inv() const { return Quu_inv_; }
-const std::vector<Eigen::MatrixXd>& AbstractDDPSolver::get_fx() const { return fx_; }
-const std::vector<Eigen::MatrixXd>& AbstractDDPSolver::get_fu() const { return fu_; }
+const std::vector<Eigen::MatrixXd>& AbstractDDPSolver::get_fx() const { return linearization_.fx; }
+const std::vector<Eigen::MatrixXd>& AbstractDDPSolver::get_fu() const { return linearization_.fu; }
 std::vector<double> AbstractDDPSolver::get_control_cost_evolution() const
 {
     std::vector<double> ret;
@@ -382,4 +477,29 @@ std::vector<double> AbstractDDPSolver::get_regularization_evolution() const
     }
     return ret;
 }
+
+Eigen::MatrixXd AbstractDDPSolver::get_phase_duration_evolution() const
+{
+    // Iteration 0 is the initial rollout, the iterations that have not been run are NaN
+    std::size_t num_iterations = 0;
+    while (num_iterations + 1 < phase_duration_evolution_.size() && line_search_trials_evolution_[num_iterations + 1] >= 0) ++num_iterations;
+    Eigen::MatrixXd ret(num_iterations, kNumberOfPhases);
+    for (std::size_t i = 0; i < num_iterations; ++i)
+    {
+        for (int phase = 0; phase < kNumberOfPhases; ++phase) ret(i, phase) = phase_duration_evolution_[i + 1][phase];
+    }
+    return ret;
+}
+
+std::vector<int> AbstractDDPSolver::get_line_search_trials_evolution() const
+{
+    std::vector<int> ret;
+    ret.reserve(line_search_trials_evolution_.size());
+    for (size_t position = 1; position < line_search_trials_evolution_.size(); ++position)
+    {
+        if (line_search_trials_evolution_[position] < 0) break;
+        ret.push_back(line_search_trials_evolution_[position]);
+    }
+    return ret;
+}
 }  // namespace exotica
@@ -41,10 +41,19 @@ void AnalyticDDPSolver::Instantiate(const AnalyticDDPSolverInitializer& init)
 
 void AnalyticDDPSolver::BackwardPass()
 {
+    EXOTICA_PROFILE_SCOPE("AnalyticDDPSolver::BackwardPass");
     // NB: The DynamicTimeIndexedShootingProblem assumes row-major notation for derivatives
     //     The solvers follow DDP papers where we have a column-major notation => there will be transposes.
-    Vx_.back() = prob_->GetStateCostJacobian(T_ - 1);
-    Vxx_.back() = prob_->GetStateCostHessian(T_ - 1);
+    // NB: LinearizeDynamics computes the derivatives of the state transition function which includes the selected integration scheme.
+    Timer timer;
+    prob_->LinearizeDynamics(prob_->get_X(), prob_->get_U(), linearization_);  // (NDX,NDX), (NDX,NU)
+    phase_durations_[kDynamicsDerivativesPhase] += timer.GetDuration();
+    timer.Reset();
+    prob_->QuadratizeCost(linearization_);
+    phase_durations_[kCostDerivativesPhase] += timer.GetDuration();
+
+    Vx_.back() = linearization_.lx.back();
+    Vxx_.back() = linearization_.lxx.back();
 
     // Regularization as introduced in Tassa's thesis, Eq. 24(a)
     if (lambda_ != 0.0)
@@ -52,78 +61,141 @@ void AnalyticDDPSolver::BackwardPass()
         Vxx_.back().diagonal().array() += lambda_;
     }
 
-    // concatenation axis for tensor products
-    //  See https://eigen.tuxfamily.org/dox-devel/unsupported/eigen_tensors.html#title14
-    const Eigen::array<Eigen::IndexPair<int>, 1> dims = {Eigen::IndexPair<int>(1, 0)};
-    Eigen::Tensor<double, 1> Vx_tensor;
+    // Workspace of the backward pass, only (re)allocated when the problem dimensions change
+    x_.resize(NX_);
+    u_.resize(NU_);
+    Vxx_fx_.resize(NDX_, NDX_);
+    Vxx_fu_.resize(NDX_, NU_);
+    Quu_k_.resize(NU_);
+    Quu_K_.resize(NU_, NDX_);
+    Quu_llt_.resize(NU_, NU_);
+
+    // Small systems run the recursion on fixed-size types, everything else falls back to dynamic sizes.
+    if (NDX_ == 2 && NU_ == 1)
+        BackwardPassRecursion<2, 1>();  // Pendulum, 1D double integrator
+    else if (NDX_ == 4 && NU_ == 1)
+        BackwardPassRecursion<4, 1>();  // Cartpole
+    else if (NDX_ == 4 && NU_ == 2)
+        BackwardPassRecursion<4, 2>();  // 2D double integrator
+    else if (NDX_ == 6 && NU_ == 3)
+        BackwardPassRecursion<6, 3>();  // 3D double integrator
+    else if (NDX_ == 12 && NU_ == 4)
+        BackwardPassRecursion<12, 4>();  // Quadrotor
+    else
+        BackwardPassRecursion<Eigen::Dynamic, Eigen::Dynamic>();
+}
+
+template <int NDX, int NU>
+void AnalyticDDPSolver::BackwardPassRecursion()
+{
+    typedef Eigen::Matrix<double, NDX, 1> VectorNDX;
+    typedef Eigen::Matrix<double, NU, 1> VectorNU;
+    typedef Eigen::Matrix<double, NDX, NDX> MatrixNDX;
+    typedef Eigen::Matrix<double, NU, NU> MatrixNU;
+    typedef Eigen::Matrix<double, NDX, NU> MatrixNDXNU;
+    typedef Eigen::Matrix<double, NU, NDX> MatrixNUNDX;
+
+    // The recursion operates on maps of the dynamic storage, i.e., the fixed-size
+    // variants only change the expression types and never allocate.
+    Eigen::Map<MatrixNDX> Vxx_fx(Vxx_fx_.data(), NDX_, NDX_);
+    Eigen::Map<MatrixNDXNU> Vxx_fu(Vxx_fu_.data(), NDX_, NU_);
+    Eigen::Map<VectorNU> Quu_k(Quu_k_.data(), NU_);
+    Eigen::Map<MatrixNUNDX> Quu_K(Quu_K_.data(), NU_, NDX_);
+    Eigen::Map<MatrixNU> Quu_llt_storage(Quu_llt_.data(), NU_, NU_);
 
-    Eigen::VectorXd x(NX_), u(NU_);  // TODO: Replace
-    // Quu_llt_ = Eigen::LLT<Eigen::MatrixXd>(NU_);  // TODO: Allocate outside
     for (int t = T_ - 2; t >= 0; t--)
     {
-        x = prob_->get_X(t);  // (NX,1)
-        u = prob_->get_U(t);  // (NU,1)
-
-        // NB: ComputeDerivatives computes the derivatives of the state transition function which includes the selected integration scheme.
-        dynamics_solver_->ComputeDerivatives(x, u);
-        fx_[t].noalias() = dynamics_solver_->get_Fx();  // (NDX,NDX)
-        fu_[t].noalias() = dynamics_solver_->get_Fu();  // (NDX,NU)
+        Eigen::Map<const MatrixNDX> fx(linearization_.fx[t].data(), NDX_, NDX_);
+        Eigen::Map<const MatrixNDXNU> fu(linearization_.fu[t].data(), NDX_, NU_);
+        Eigen::Map<const VectorNDX> Vx_next(Vx_[t + 1].data(), NDX_);
+        Eigen::Map<const MatrixNDX> Vxx_next(Vxx_[t + 1].data(), NDX_, NDX_);
+        Eigen::Map<VectorNDX> Qx(Qx_[t].data(), NDX_);
+        Eigen::Map<VectorNU> Qu(Qu_[t].data(), NU_);
+        Eigen::Map<MatrixNDX> Qxx(Qxx_[t].data(), NDX_, NDX_);
+        Eigen::Map<MatrixNU> Quu(Quu_[t].data(), NU_, NU_);
+        Eigen::Map<MatrixNUNDX> Qux(Qux_[t].data(), NU_, NDX_);
+        Eigen::Map<VectorNU> k(k_[t].data(), NU_);
+        Eigen::Map<MatrixNUNDX> K(K_[t].data(), NU_, NDX_);
+        Eigen::Map<VectorNDX> Vx(Vx_[t].data(), NDX_);
+        Eigen::Map<MatrixNDX> Vxx(Vxx_[t].data(), NDX_, NDX_);
 
         //
         // NB: We use a modified cost function to compare across different
         // time horizons - the running cost is scaled by dt_
         //
-        Qx_[t].noalias() = dt_ * prob_->GetStateCostJacobian(t);    // Eq. 20(a)            (1,NDX)^T => (NDX,1)
-        Qx_[t].noalias() += fx_[t].transpose() * Vx_[t + 1];        //      lx + fx_ @ Vx_  (NDX,NDX)^T*(NDX,1)
-        Qu_[t].noalias() = dt_ * prob_->GetControlCostJacobian(t);  // Eq. 20(b)            (1,NU)^T => (NU,1)
-        Qu_[t].noalias() += fu_[t].transpose() * Vx_[t + 1];        //                      (NU,NDX)*(NDX,1) => (NU,1)
-
-        Qxx_[t].noalias() = dt_ * prob_->GetStateCostHessian(t);         // Eq. 20(c)        (NDX,NDX)^T => (NDX,NDX)
-        Qxx_[t].noalias() += fx_[t].transpose() * Vxx_[t + 1] * fx_[t];  //                  + (NDX,NDX)^T*(NDX,NDX)*(NDX,NDX)
-        Quu_[t].noalias() = dt_ * prob_->GetControlCostHessian(t);       // Eq. 20(d)        (NU,NU)^T
-        Quu_[t].noalias() += fu_[t].transpose() * Vxx_[t + 1] * fu_[t];  //                  + (NDX,NU)^T*(NDX,NDX)*(NDX,NU)
+        Qx.noalias() = dt_ * linearization_.lx[t];    // Eq. 20(a)        (1,NDX)^T => (NDX,1)
+        Qu.noalias() = dt_ * linearization_.lu[t];    // Eq. 20(b)        (1,NU)^T => (NU,1)
+        Qxx.noalias() = dt_ * linearization_.lxx[t];  // Eq. 20(c)        (NDX,NDX)^T => (NDX,NDX)
+        Quu.noalias() = dt_ * linearization_.luu[t];  // Eq. 20(d)        (NU,NU)^T
+
+        Qx.noalias() += fx.transpose() * Vx_next;  //      lx + fx_ @ Vx_  (NDX,NDX)^T*(NDX,1)
+        Qu.noalias() += fu.transpose() * Vx_next;  //                      (NU,NDX)*(NDX,1) => (NU,1)
+
+        // Vxx fx and Vxx fu are shared by the second order terms
+        Vxx_fx.noalias() = Vxx_next * fx;          //                  (NDX,NDX)*(NDX,NDX)
+        Vxx_fu.noalias() = Vxx_next * fu;          //                  (NDX,NDX)*(NDX,NU)
+        Qxx.noalias() += fx.transpose() * Vxx_fx;  //                  + (NDX,NDX)^T*(NDX,NDX)*(NDX,NDX)
+        Quu.noalias() += fu.transpose() * Vxx_fu;  //                  + (NDX,NU)^T*(NDX,NDX)*(NDX,NU)
         // Qux_[t].noalias() = dt_ * prob_->GetStateControlCostHessian();          // Eq. 20(e)        (NU,NDX)
         // NB: This assumes that Lux is always 0.
-        Qux_[t].noalias() = fu_[t].transpose() * Vxx_[t + 1] * fx_[t];  //                  + (NDX,NU)^T*(NDX,NDX) =>(NU,NDX)
+        Qux.noalias() = fu.transpose() * Vxx_fx;  //                  + (NDX,NU)^T*(NDX,NDX) =>(NU,NDX)
 
         // The tensor product terms need to be added if second-order dynamics are considered.
         if (parameters_.UseSecondOrderDynamics && dynamics_solver_->get_has_second_order_derivatives())
         {
-            Vx_tensor = Eigen::TensorMap<Eigen::Tensor<double, 1>>(Vx_[t + 1].data(), NDX_);
+            x_ = prob_->get_X(t);  // (NX,1)
+            u_ = prob_->get_U(t);  // (NU,1)
 
-            Qxx_[t] += Eigen::TensorToMatrix((Eigen::Tensor<double, 2>)dynamics_solver_->fxx(x, u).contract(Vx_tensor, dims), NDX_, NDX_) * dt_;
+            // Contracted with Vx directly, i.e., without forming the dense second order tensors
+            Qxx += dynamics_solver_->ContractFxx(x_, u_, Vx_[t + 1]) * dt_;
 
-            Quu_[t] += Eigen::TensorToMatrix((Eigen::Tensor<double, 2>)dynamics_solver_->fuu(x, u).contract(Vx_tensor, dims), NU_, NU_) * dt_;
+            Quu += dynamics_solver_->ContractFuu(x_, u_, Vx_[t + 1]) * dt_;
 
-            Qux_[t] += Eigen::TensorToMatrix((Eigen::Tensor<double, 2>)dynamics_solver_->fxu(x, u).contract(Vx_tensor, dims), NU_, NDX_) * dt_;  // transpose?
+            Qux += dynamics_solver_->ContractFxu(x_, u_, Vx_[t + 1]) * dt_;
         }
 
         // Control regularization for numerical stability
-        Quu_[t].diagonal().array() += lambda_;
-
-        // Compute gains using Cholesky decomposition
-        Quu_inv_[t] = Quu_[t].llt().solve(Eigen::MatrixXd::Identity(NU_, NU_));
-        k_[t].noalias() = -Quu_inv_[t] * Qu_[t];
-        K_[t].noalias() = -Quu_inv_[t] * Qux_[t];
-
-        // Using Cholesky decomposition:
-        // Quu_llt_.compute(Quu_);
-        // K_[t] = -Qux_;
-        // Quu_llt_.solveInPlace(K_[t]);
-        // k_[t] = -Qu_;
-        // Quu_llt_.solveInPlace(k_[t]);
+        Quu.diagonal().array() += lambda_;
+
+        // Compute gains using the Cholesky decomposition in place, i.e., without forming the inverse of Quu
+        Quu_llt_storage = Quu;
+        Eigen::LLT<Eigen::Ref<MatrixNU>> Quu_llt(Quu_llt_storage);
+        k.noalias() = -Qu;
+        Quu_llt.solveInPlace(k);
+        K.noalias() = -Qux;
+        Quu_llt.solveInPlace(K);
+        Quu_inv_[t].setIdentity();
+        Quu_llt.solveInPlace(Quu_inv_[t]);
 
         // V = Q - 0.5 * (Qu_.transpose() * Quu_inv_ * Qu_)(0);
 
         // With regularisation:
-        Vx_[t] = Qx_[t] + K_[t].transpose() * Quu_[t] * k_[t] + K_[t].transpose() * Qu_[t] + Qux_[t].transpose() * k_[t];     // Eq. 25(b)
-        Vxx_[t] = Qxx_[t] + K_[t].transpose() * Quu_[t] * K_[t] + K_[t].transpose() * Qux_[t] + Qux_[t].transpose() * K_[t];  // Eq. 25(c)
-        Vxx_[t] = 0.5 * (Vxx_[t] + Vxx_[t].transpose()).eval();                                                               // Ensure the Hessian of the value function is symmetric.
+        // Vx = Qx + K^T Quu k + K^T Qu + Qux^T k                                                                    // Eq. 25(b)
+        Quu_k = Qu;
+        Quu_k.noalias() += Quu * k;
+        Vx = Qx;
+        Vx.noalias() += K.transpose() * Quu_k;
+        Vx.noalias() += Qux.transpose() * k;
+        // Vxx = Qxx + K^T Quu K + K^T Qux + Qux^T K                                                                 // Eq. 25(c)
+        Quu_K = Qux;
+        Quu_K.noalias() += Quu * K;
+        Vxx = Qxx;
+        Vxx.noalias() += K.transpose() * Quu_K;
+        Vxx.noalias() += Qux.transpose() * K;
+
+        // Ensure the Hessian of the value function is symmetric.
+        for (int j = 0; j < NDX_; ++j)
+        {
+            for (int i = j + 1; i < NDX_; ++i)
+            {
+                Vxx(i, j) = Vxx(j, i) = 0.5 * (Vxx(i, j) + Vxx(j, i));
+            }
+        }
 
         // Regularization as introduced in Tassa's thesis, Eq. 24(a)
         if (lambda_ != 0.0)
         {
-            Vxx_[t].diagonal().array() += lambda_;
+            Vxx.diagonal().array() += lambda_;
         }
     }
 }
@@ -0,0 +1,563 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_ddp_solver/batch_ddp_solver.h>
+
+#include <algorithm>
+#include <cmath>
+
+REGISTER_MOTIONSOLVER_TYPE("BatchDDPSolver", exotica::BatchDDPSolver)
+
+namespace exotica
+{
+namespace
+{
+typedef BatchDDPSolver::BatchArray BatchArray;
+typedef BatchDDPSolver::BatchRow BatchRow;
+typedef Eigen::Array<bool, 1, Eigen::Dynamic> BatchMask;
+
+// C = op(A) B (accumulate: C += op(A) B) for the first n problems, where op(A) (A^T if transpose_a) is m x p and B is p x q. C must
+// not alias A or B.
+void BatchMultiply(const BatchArray& A, bool transpose_a, int m, int p, const BatchArray& B, int q, BatchArray& C, bool accumulate, int n)
+{
+    const int a_rows = transpose_a ? p : m;
+    for (int j = 0; j < q; ++j)
+    {
+        for (int i = 0; i < m; ++i)
+        {
+            auto c = C.row(i + j * m).head(n);
+            if (!accumulate) c.setZero();
+            for (int k = 0; k < p; ++k)
+            {
+                c += A.row(transpose_a ? k + i * a_rows : i + k * a_rows).head(n) * B.row(k + j * p).head(n);
+            }
+        }
+    }
+}
+
+// Adds the values of the first n problems to the diagonal of the m x m matrices of A.
+void BatchAddToDiagonal(BatchArray& A, int m, const BatchRow& values, int n)
+{
+    for (int i = 0; i < m; ++i) A.row(i + i * m).head(n) += values.head(n);
+}
+
+// out = d^T W d for the m x m matrices W and the vectors d of the first n problems.
+void BatchQuadraticForm(const BatchArray& W, const BatchArray& d, int m, BatchRow& out, int n)
+{
+    out.head(n).setZero();
+    for (int j = 0; j < m; ++j)
+    {
+        for (int i = 0; i < m; ++i) out.head(n) += d.row(i).head(n) * W.row(i + j * m).head(n) * d.row(j).head(n);
+    }
+}
+
+// Cholesky factorisation A = L L^T of the m x m matrices of the first n problems into the lower triangle of L. Problems whose matrix is
+// not positive definite are cleared in ok, their factor is finite but meaningless.
+void BatchCholesky(const BatchArray& A, int m, BatchArray& L, BatchMask& ok, BatchRow& scratch, int n)
+{
+    auto d = scratch.head(n);
+    for (int j = 0; j < m; ++j)
+    {
+        d = A.row(j + j * m).head(n);
+        for (int k = 0; k < j; ++k) d -= L.row(j + k * m).head(n).square();
+        ok.head(n) = ok.head(n) && (d > 0.);
+        L.row(j + j * m).head(n) = (d > 0.).select(d, 1.).sqrt();
+        for (int i = j + 1; i < m; ++i)
+        {
+            auto l = L.row(i + j * m).head(n);
+            l = A.row(i + j * m).head(n);
+            for (int k = 0; k < j; ++k) l -= L.row(i + k * m).head(n) * L.row(j + k * m).head(n);
+            l /= L.row(j + j * m).head(n);
+        }
+    }
+}
+
+// Solves L L^T X = X in place for the m x q right-hand sides X of the first n problems.
+void BatchCholeskySolveInPlace(const BatchArray& L, int m, BatchArray& X, int q, int n)
+{
+    for (int j = 0; j < q; ++j)
+    {
+        for (int i = 0; i < m; ++i)
+        {
+            auto x = X.row(i + j * m).head(n);
+            for (int k = 0; k < i; ++k) x -= L.row(i + k * m).head(n) * X.row(k + j * m).head(n);
+            x /= L.row(i + i * m).head(n);
+        }
+        for (int i = m - 1; i >= 0; --i)
+        {
+            auto x = X.row(i + j * m).head(n);
+            for (int k = i + 1; k < m; ++k) x -= L.row(k + i * m).head(n) * X.row(k + j * m).head(n);
+            x /= L.row(i + i * m).head(n);
+        }
+    }
+}
+}  // namespace
+
+void BatchDDPSolver::Instantiate(const BatchDDPSolverInitializer& init)
+{
+    parameters_ = init;
+}
+
+void BatchDDPSolver::SpecifyProblem(PlanningProblemPtr pointer)
+{
+    if (pointer->type() != "exotica::DynamicTimeIndexedShootingProblem")
+    {
+        ThrowNamed("This BatchDDPSolver can't solve problem of type '" << pointer->type() << "'!");
+    }
+    SpecifyProblems({std::static_pointer_cast<DynamicTimeIndexedShootingProblem>(pointer)});
+}
+
+void BatchDDPSolver::SpecifyProblems(const std::vector<DynamicTimeIndexedShootingProblemPtr>& problems)
+{
+    if (problems.empty()) ThrowNamed("No problems given!");
+    for (const DynamicTimeIndexedShootingProblemPtr& problem : problems)
+    {
+        if (!problem) ThrowNamed("Problem is not initialized!");
+    }
+
+    const DynamicTimeIndexedShootingProblemPtr& first = problems[0];
+    const DynamicsSolverPtr first_dynamics_solver = first->GetScene()->GetDynamicsSolver();
+    const int NX = first->GetScene()->get_num_state();
+    const int NU = first->GetScene()->get_num_controls();
+    for (std::size_t i = 0; i < problems.size(); ++i)
+    {
+        const DynamicTimeIndexedShootingProblemPtr& problem = problems[i];
+        const ScenePtr& scene = problem->GetScene();
+        const DynamicsSolverPtr& dynamics_solver = scene->GetDynamicsSolver();
+        if (scene->get_num_state_derivative() != scene->get_num_state() || scene->get_has_quaternion_floating_base()) ThrowNamed("Problem " << i << " does not have a Euclidean state space");
+        if (problem->get_T() != first->get_T() || problem->get_tau() != first->get_tau()) ThrowNamed("Problem " << i << " has T=" << problem->get_T() << " and tau=" << problem->get_tau() << ", expected T=" << first->get_T() << " and tau=" << first->get_tau());
+        if (scene->get_num_state() != NX || scene->get_num_controls() != NU) ThrowNamed("Problem " << i << " has " << scene->get_num_state() << " states and " << scene->get_num_controls() << " controls, expected " << NX << " and " << NU);
+        if (dynamics_solver->type() != first_dynamics_solver->type() || dynamics_solver->get_dt() != first_dynamics_solver->get_dt()) ThrowNamed("Problem " << i << " uses the dynamics solver " << dynamics_solver->type() << " with dt=" << dynamics_solver->get_dt() << ", expected " << first_dynamics_solver->type() << " with dt=" << first_dynamics_solver->get_dt());
+        if (problem->cost.num_tasks > 0) ThrowNamed("Problem " << i << " has task maps, which are not supported by the BatchDDPSolver");
+        if (problem->get_loss_type() != ControlCostLossTermType::L2) ThrowNamed("Problem " << i << " does not use the L2 control cost, which is the only one supported by the BatchDDPSolver");
+    }
+
+    MotionSolver::SpecifyProblem(first);
+    problems_ = problems;
+    dynamics_solver_ = first_dynamics_solver;
+    num_iterations_.assign(problems_.size(), 0);
+
+    // Set up backtracking line-search coefficients
+    alpha_space_ = Eigen::VectorXd::LinSpaced(11, 0.0, -3.0);
+    for (int ai = 0; ai < alpha_space_.size(); ++ai)
+    {
+        alpha_space_(ai) = std::pow(10.0, alpha_space_(ai));
+    }
+}
+
+void BatchDDPSolver::LoadProblems()
+{
+    const int N = static_cast<int>(problems_.size());
+    T_ = problems_[0]->get_T();
+    NU_ = problems_[0]->GetScene()->get_num_controls();
+    NX_ = problems_[0]->GetScene()->get_num_state();
+    dt_ = dynamics_solver_->get_dt();
+    num_substeps_ = static_cast<int>(problems_[0]->get_tau() / dt_);
+
+    const auto allocate = [N](std::vector<BatchArray>& arrays, int num_time_steps, int rows) {
+        arrays.resize(num_time_steps);
+        for (BatchArray& array : arrays) array.resize(rows, N);
+    };
+    allocate(X_ref_, T_, NX_);
+    allocate(X_try_, T_, NX_);
+    allocate(X_star_, T_, NX_);
+    allocate(Q_, T_, NX_ * NX_);
+    allocate(Vx_, T_, NX_);
+    allocate(Vxx_, T_, NX_ * NX_);
+    allocate(U_ref_, T_ - 1, NU_);
+    allocate(U_try_, T_ - 1, NU_);
+    allocate(fx_, T_ - 1, NX_ * NX_);
+    allocate(fu_, T_ - 1, NX_ * NU_);
+    allocate(k_, T_ - 1, NU_);
+    allocate(K_, T_ - 1, NU_ * NX_);
+    R_sym_.resize(NU_ * NU_, N);
+    R_diag_.resize(NU_, N);
+    Qx_.resize(NX_, N);
+    Qu_.resize(NU_, N);
+    Qxx_.resize(NX_ * NX_, N);
+    Quu_.resize(NU_ * NU_, N);
+    Quu_llt_.resize(NU_ * NU_, N);
+    Qux_.resize(NU_ * NX_, N);
+    Vxx_fx_.resize(NX_ * NX_, N);
+    Vxx_fu_.resize(NX_ * NU_, N);
+    Quu_k_.resize(NU_, N);
+    Quu_K_.resize(NU_ * NX_, N);
+    x_diff_.resize(NX_, N);
+    cost_.resize(N);
+    cost_prev_.resize(N);
+    cost_try_.resize(N);
+    lambda_.setConstant(N, parameters_.RegularizationRate);
+    alpha_best_.setZero(N);
+    scratch_.resize(N);
+    factorized_.resize(N);
+    searching_.resize(N);
+    last_best_iteration_.assign(N, 0);
+
+    n_ = N;
+    active_.resize(N);
+    for (int c = 0; c < N; ++c)
+    {
+        active_[c] = c;
+        const DynamicTimeIndexedShootingProblemPtr& problem = problems_[c];
+        problem->ResetCostEvolution(GetNumberOfMaxIterations() + 1);
+        problem->PreUpdate();
+        X_try_[0].col(c) = problem->ApplyStartState().array();
+        for (int t = 0; t < T_; ++t)
+        {
+            X_star_[t].col(c) = problem->get_X_star().col(t).array();
+            Q_[t].col(c) = Eigen::Map<const Eigen::ArrayXd>(problem->get_Q(t).data(), NX_ * NX_);
+        }
+        for (int t = 0; t < T_ - 1; ++t) U_ref_[t].col(c) = problem->get_U().col(t).array();
+
+        const Eigen::MatrixXd& R = problem->get_R();
+        const double w = problem->get_control_cost_weight();
+        const Eigen::MatrixXd R_sym = w * (R + R.transpose());
+        R_sym_.col(c) = Eigen::Map<const Eigen::ArrayXd>(R_sym.data(), NU_ * NU_);
+        R_diag_.col(c) = w * R.diagonal().array();
+    }
+}
+
+void BatchDDPSolver::ForwardPass(double alpha, bool open_loop)
+{
+    EXOTICA_PROFILE_SCOPE("BatchDDPSolver::ForwardPass");
+    const Eigen::MatrixXd& control_limits = dynamics_solver_->get_control_limits();
+    const bool clamp_controls = parameters_.ClampControlsInForwardPass && !open_loop;
+    auto cost = cost_try_.head(n_);
+    auto step_cost = scratch_.head(n_);
+    cost.setZero();
+    x_next_batch_.resize(NX_, n_);
+
+    for (int t = 0; t < T_ - 1; ++t)
+    {
+        BatchArray& X = X_try_[t];
+        BatchArray& U = U_try_[t];
+        if (open_loop)
+        {
+            U.leftCols(n_) = U_ref_[t].leftCols(n_);
+        }
+        else
+        {
+            // u = U_ref + alpha * k + K * (x - X_ref)
+            x_diff_.leftCols(n_) = X.leftCols(n_) - X_ref_[t].leftCols(n_);
+            U.leftCols(n_) = U_ref_[t].leftCols(n_) + alpha * k_[t].leftCols(n_);
+            BatchMultiply(K_[t], false, NU_, NX_, x_diff_, 1, U, true, n_);
+        }
+        if (clamp_controls)
+        {
+            for (int i = 0; i < NU_; ++i) U.row(i).head(n_) = U.row(i).head(n_).max(control_limits(i, 0)).min(control_limits(i, 1));
+        }
+
+        // Running cost
+        x_diff_.leftCols(n_) = X.leftCols(n_) - X_star_[t].leftCols(n_);
+        BatchQuadraticForm(Q_[t], x_diff_, NX_, scratch_, n_);
+        for (int i = 0; i < NU_; ++i) step_cost += R_diag_.row(i).head(n_) * U.row(i).head(n_).square();
+        cost += dt_ * step_cost;
+
+        // Simulate for tau
+        x_batch_ = X.leftCols(n_).matrix();
+        u_batch_ = U.leftCols(n_).matrix();
+        for (int i = 0; i < num_substeps_; ++i)
+        {
+            dynamics_solver_->SimulateBatch(x_batch_, u_batch_, x_next_batch_);
+            x_batch_.swap(x_next_batch_);
+        }
+        if (dynamics_solver_->get_has_state_limits())
+        {
+            for (int c = 0; c < n_; ++c) dynamics_solver_->ClampToStateLimits(x_batch_.col(c));
+        }
+        X_try_[t + 1].leftCols(n_) = x_batch_.array();
+    }
+
+    // Terminal cost
+    x_diff_.leftCols(n_) = X_try_[T_ - 1].leftCols(n_) - X_star_[T_ - 1].leftCols(n_);
+    BatchQuadraticForm(Q_[T_ - 1], x_diff_, NX_, scratch_, n_);
+    cost += step_cost;
+}
+
+void BatchDDPSolver::BackwardPass()
+{
+    EXOTICA_PROFILE_SCOPE("BatchDDPSolver::BackwardPass");
+    const int n = n_;
+
+    // Derivatives of the state transitions of all active problems in one batch, time step major
+    X_stack_.resize(NX_, n * (T_ - 1));
+    U_stack_.resize(NU_, n * (T_ - 1));
+    for (int t = 0; t < T_ - 1; ++t)
+    {
+        X_stack_.middleCols(t * n, n) = X_ref_[t].leftCols(n).matrix();
+        U_stack_.middleCols(t * n, n) = U_ref_[t].leftCols(n).matrix();
+    }
+    dynamics_solver_->ComputeDerivativesBatch(X_stack_, U_stack_, Fx_stack_, Fu_stack_);
+    for (int t = 0; t < T_ - 1; ++t)
+    {
+        for (int c = 0; c < n; ++c)
+        {
+            fx_[t].col(c) = Eigen::Map<const Eigen::ArrayXd>(Fx_stack_[t * n + c].data(), NX_ * NX_);
+            fu_[t].col(c) = Eigen::Map<const Eigen::ArrayXd>(Fu_stack_[t * n + c].data(), NX_ * NU_);
+        }
+    }
+
+    // Terminal value function: lx = 2 Q (x - x*), lxx = Q (see DynamicTimeIndexedShootingProblem::GetStateCostJacobian)
+    x_diff_.leftCols(n) = X_ref_[T_ - 1].leftCols(n) - X_star_[T_ - 1].leftCols(n);
+    BatchMultiply(Q_[T_ - 1], false, NX_, NX_, x_diff_, 1, Vx_[T_ - 1], false, n);
+    Vx_[T_ - 1].leftCols(n) *= 2.0;
+    Vxx_[T_ - 1].leftCols(n) = Q_[T_ - 1].leftCols(n);
+    BatchAddToDiagonal(Vxx_[T_ - 1], NX_, lambda_, n);  // Regularization as introduced in Tassa's thesis, Eq. 24(a)
+
+    factorized_.head(n).setConstant(true);
+    for (int t = T_ - 2; t >= 0; --t)
+    {
+        // Qx = dt lx + fx^T Vx'
+        x_diff_.leftCols(n) = X_ref_[t].leftCols(n) - X_star_[t].leftCols(n);
+        BatchMultiply(Q_[t], false, NX_, NX_, x_diff_, 1, Qx_, false, n);
+        Qx_.leftCols(n) *= 2.0 * dt_;
+        BatchMultiply(fx_[t], true, NX_, NX_, Vx_[t + 1], 1, Qx_, true, n);
+
+        // Qu = dt lu + fu^T Vx'
+        BatchMultiply(R_sym_, false, NU_, NU_, U_ref_[t], 1, Qu_, false, n);
+        Qu_.leftCols(n) *= dt_;
+        BatchMultiply(fu_[t], true, NU_, NX_, Vx_[t + 1], 1, Qu_, true, n);
+
+        // Vxx fx and Vxx fu are shared by the second order terms
+        BatchMultiply(Vxx_[t + 1], false, NX_, NX_, fx_[t], NX_, Vxx_fx_, false, n);
+        BatchMultiply(Vxx_[t + 1], false, NX_, NX_, fu_[t], NU_, Vxx_fu_, false, n);
+        Qxx_.leftCols(n) = dt_ * Q_[t].leftCols(n);
+        BatchMultiply(fx_[t], true, NX_, NX_, Vxx_fx_, NX_, Qxx_, true, n);
+        Quu_.leftCols(n) = dt_ * R_sym_.leftCols(n);
+        BatchMultiply(fu_[t], true, NU_, NX_, Vxx_fu_, NU_, Quu_, true, n);
+        BatchMultiply(fu_[t], true, NU_, NX_, Vxx_fx_, NX_, Qux_, false, n);
+
+        // Control regularization for numerical stability
+        BatchAddToDiagonal(Quu_, NU_, lambda_, n);
+
+        // k = -Quu^-1 Qu, K = -Quu^-1 Qux
+        BatchCholesky(Quu_, NU_, Quu_llt_, factorized_, scratch_, n);
+        k_[t].leftCols(n) = -Qu_.leftCols(n);
+        BatchCholeskySolveInPlace(Quu_llt_, NU_, k_[t], 1, n);
+        K_[t].leftCols(n) = -Qux_.leftCols(n);
+        BatchCholeskySolveInPlace(Quu_llt_, NU_, K_[t], NX_, n);
+
+        // Vx = Qx + K^T Quu k + K^T Qu + Qux^T k                                                                    // Eq. 25(b)
+        Quu_k_.leftCols(n) = Qu_.leftCols(n);
+        BatchMultiply(Quu_, false, NU_, NU_, k_[t], 1, Quu_k_, true, n);
+        Vx_[t].leftCols(n) = Qx_.leftCols(n);
+        BatchMultiply(K_[t], true, NX_, NU_, Quu_k_, 1, Vx_[t], true, n);
+        BatchMultiply(Qux_, true, NX_, NU_, k_[t], 1, Vx_[t], true, n);
+
+        // Vxx = Qxx + K^T Quu K + K^T Qux + Qux^T K                                                                 // Eq. 25(c)
+        Quu_K_.leftCols(n) = Qux_.leftCols(n);
+        BatchMultiply(Quu_, false, NU_, NU_, K_[t], NX_, Quu_K_, true, n);
+        Vxx_[t].leftCols(n) = Qxx_.leftCols(n);
+        BatchMultiply(K_[t], true, NX_, NU_, Quu_K_, NX_, Vxx_[t], true, n);
+        BatchMultiply(Qux_, true, NX_, NU_, K_[t], NX_, Vxx_[t], true, n);
+
+        // Ensure the Hessian of the value function is symmetric.
+        for (int j = 0; j < NX_; ++j)
+        {
+            for (int i = j + 1; i < NX_; ++i)
+            {
+                Vxx_[t].row(i + j * NX_).head(n) = 0.5 * (Vxx_[t].row(i + j * NX_).head(n) + Vxx_[t].row(j + i * NX_).head(n));
+                Vxx_[t].row(j + i * NX_).head(n) = Vxx_[t].row(i + j * NX_).head(n);
+            }
+        }
+
+        // Regularization as introduced in Tassa's thesis, Eq. 24(a)
+        BatchAddToDiagonal(Vxx_[t], NX_, lambda_, n);
+    }
+}
+
+void BatchDDPSolver::FinishProblem(int c, TerminationCriterion criterion, int iterations)
+{
+    const int i = active_[c];
+    const DynamicTimeIndexedShootingProblemPtr& problem = problems_[i];
+    for (int t = 0; t < T_ - 1; ++t) problem->Update(U_ref_[t].col(c).matrix(), t);
+    problem->termination_criterion = criterion;
+    num_iterations_[i] = iterations;
+}
+
+void BatchDDPSolver::CompactBatch(const std::vector<bool>& keep)
+{
+    int m = 0;
+    for (int c = 0; c < n_; ++c)
+    {
+        if (!keep[c]) continue;
+        if (m != c)
+        {
+            // The derivatives, gains and value functions are recomputed by the next backward pass
+            const auto move = [c, m](BatchArray& array) { array.col(m) = array.col(c); };
+            for (BatchArray& array : X_ref_) move(array);
+            for (BatchArray& array : U_ref_) move(array);
+            for (BatchArray& array : X_star_) move(array);
+            for (BatchArray& array : Q_) move(array);
+            move(X_try_[0]);
+            move(R_sym_);
+            move(R_diag_);
+            cost_(m) = cost_(c);
+            cost_prev_(m) = cost_prev_(c);
+            lambda_(m) = lambda_(c);
+            alpha_best_(m) = alpha_best_(c);
+            last_best_iteration_[m] = last_best_iteration_[c];
+            active_[m] = active_[c];
+        }
+        ++m;
+    }
+    n_ = m;
+}
+
+void BatchDDPSolver::SolveBatch(std::vector<Eigen::MatrixXd>& solutions)
+{
+    EXOTICA_PROFILE_SCOPE("BatchDDPSolver::SolveBatch");
+    if (problems_.empty()) ThrowNamed("Solver has not been initialized!");
+    Timer planning_timer;
+    const int max_iterations = GetNumberOfMaxIterations();
+
+    // Initial roll-out
+    LoadProblems();
+    ForwardPass(0.0, true);
+    for (int t = 0; t < T_; ++t) X_ref_[t].leftCols(n_) = X_try_[t].leftCols(n_);
+    cost_.head(n_) = cost_try_.head(n_);
+    cost_prev_.head(n_) = cost_.head(n_);
+    for (int c = 0; c < n_; ++c) problems_[c]->SetCostEvolution(0, cost_(c));
+
+    if (debug_) HIGHLIGHT_NAMED("BatchDDPSolver", "Running DDP solver on " << n_ << " problems for max " << max_iterations << " iterations");
+
+    std::vector<bool> keep;
+    for (int iteration = 1; iteration <= max_iterations && n_ > 0; ++iteration)
+    {
+        // Check whether user interrupted (Ctrl+C)
+        if (Server::IsRos() && !ros::ok())
+        {
+            if (debug_) HIGHLIGHT("Solving cancelled by user");
+            for (int c = 0; c < n_; ++c) FinishProblem(c, TerminationCriterion::UserDefined, iteration - 1);
+            n_ = 0;
+            break;
+        }
+
+        BackwardPass();
+
+        // Line search in lockstep: all problems try the same step length, each one stops searching at the first step lowering its cost
+        searching_.head(n_) = factorized_.head(n_);
+        for (int ai = 0; ai < alpha_space_.size() && searching_.head(n_).any(); ++ai)
+        {
+            const double alpha = alpha_space_(ai);
+            ForwardPass(alpha, false);
+            for (int c = 0; c < n_; ++c)
+            {
+                if (!searching_(c) || !(cost_try_(c) < cost_(c))) continue;
+                cost_(c) = cost_try_(c);
+                alpha_best_(c) = alpha;
+                searching_(c) = false;
+                for (int t = 0; t < T_; ++t) X_ref_[t].col(c) = X_try_[t].col(c);
+                for (int t = 0; t < T_ - 1; ++t) U_ref_[t].col(c) = U_try_[t].col(c);
+            }
+        }
+
+        // Stopping criteria and regularization of each problem, as in AbstractDDPSolver
+        keep.assign(n_, false);
+        for (int c = 0; c < n_; ++c)
+        {
+            const DynamicTimeIndexedShootingProblemPtr& problem = problems_[active_[c]];
+            if (!std::isfinite(cost_(c)))
+            {
+                WARNING_NAMED("BatchDDPSolver", "Divergence of problem " << active_[c] << ": Cost is non-finite: " << cost_(c));
+                FinishProblem(c, TerminationCriterion::Divergence, iteration);
+                continue;
+            }
+
+            // Relative function tolerance
+            // (f_t-1 - f_t) <= functionTolerance * max(1, abs(f_t))
+            if ((cost_prev_(c) - cost_(c)) < parameters_.FunctionTolerance * std::max(1.0, std::abs(cost_(c))))
+            {
+                // Function tolerance patience check
+                if (parameters_.FunctionTolerancePatience <= 0 || iteration - last_best_iteration_[c] > parameters_.FunctionTolerancePatience)
+                {
+                    FinishProblem(c, TerminationCriterion::FunctionTolerance, iteration);
+                    continue;
+                }
+            }
+            else
+            {
+                // Reset function tolerance patience
+                last_best_iteration_[c] = iteration;
+            }
+
+            // Regularization
+            if (lambda_(c) != 0.0 && lambda_(c) > 1e9)
+            {
+                WARNING_NAMED("BatchDDPSolver", "Divergence of problem " << active_[c] << ": Regularization too large (" << lambda_(c) << ")");
+                FinishProblem(c, TerminationCriterion::Divergence, iteration);
+                continue;
+            }
+
+            if (cost_(c) < cost_prev_(c))
+            {
+                cost_prev_(c) = cost_(c);
+                if (alpha_best_(c) < parameters_.ThresholdRegularizationDecrease)
+                {
+                    lambda_(c) *= 10.;
+                }
+                else if (alpha_best_(c) > parameters_.ThresholdRegularizationIncrease)
+                {
+                    if (lambda_(c) > parameters_.MinimumRegularization) lambda_(c) /= 10.;
+                }
+            }
+            else
+            {
+                cost_(c) = cost_prev_(c);
+                lambda_(c) *= 10.;
+            }
+            problem->SetCostEvolution(iteration, cost_(c));
+
+            // Iteration limit
+            if (iteration == max_iterations)
+            {
+                FinishProblem(c, TerminationCriterion::IterationLimit, iteration);
+                continue;
+            }
+            keep[c] = true;
+        }
+
+        if (debug_) HIGHLIGHT_NAMED("BatchDDPSolver", "Iteration " << iteration << ":\t" << std::count(keep.begin(), keep.end(), true) << " of " << problems_.size() << " problems active. Time: " << planning_timer.GetDuration() << " s");
+
+        // Converged and diverged problems drop out of the batch
+        CompactBatch(keep);
+    }
+
+    solutions.resize(problems_.size());
+    for (std::size_t i = 0; i < problems_.size(); ++i) solutions[i] = problems_[i]->get_U().transpose();
+    planning_time_ = planning_timer.GetDuration();
+}
+
+void BatchDDPSolver::Solve(Eigen::MatrixXd& solution)
+{
+    std::vector<Eigen::MatrixXd> solutions;
+    SolveBatch(solutions);
+    solution = solutions[0];
+}
+}  // namespace exotica
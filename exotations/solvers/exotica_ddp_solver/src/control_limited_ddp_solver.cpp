@@ -43,72 +43,77 @@ void ControlLimitedDDPSolver::Instantiate(const ControlLimitedDDPSolverInitializ
 
 void ControlLimitedDDPSolver::BackwardPass()
 {
+    EXOTICA_PROFILE_SCOPE("ControlLimitedDDPSolver::BackwardPass");
     const Eigen::MatrixXd& control_limits = dynamics_solver_->get_control_limits();
 
-    Vx_.back().noalias() = prob_->GetStateCostJacobian(T_ - 1);
-    Vxx_.back().noalias() = prob_->GetStateCostHessian(T_ - 1);
+    Timer timer;
+    prob_->LinearizeDynamics(prob_->get_X(), prob_->get_U(), linearization_);
+    phase_durations_[kDynamicsDerivativesPhase] += timer.GetDuration();
+    timer.Reset();
+    prob_->QuadratizeCost(linearization_);
+    phase_durations_[kCostDerivativesPhase] += timer.GetDuration();
+    const std::vector<Eigen::MatrixXd>& fx = linearization_.fx;
+    const std::vector<Eigen::MatrixXd>& fu = linearization_.fu;
 
-    // concatenation axis for tensor products
-    //  See https://eigen.tuxfamily.org/dox-devel/unsupported/eigen_tensors.html#title14
-    Eigen::array<Eigen::IndexPair<int>, 1> dims = {Eigen::IndexPair<int>(1, 0)};
+    Vx_.back().noalias() = linearization_.lx.back();
+    Vxx_.back().noalias() = linearization_.lxx.back();
 
     Eigen::VectorXd x(NX_), u(NU_);  // TODO: Replace
+    Eigen::VectorXd low_limit(NU_), high_limit(NU_);
     for (int t = T_ - 2; t >= 0; t--)
     {
         x = prob_->get_X(t);
         u = prob_->get_U(t);
 
-        dynamics_solver_->ComputeDerivatives(x, u);
-        fx_[t].noalias() = dynamics_solver_->get_Fx();
-        fu_[t].noalias() = dynamics_solver_->get_Fu();
+        Qx_[t].noalias() = dt_ * linearization_.lx[t];
+        Qu_[t].noalias() = dt_ * linearization_.lu[t];
+        Qxx_[t].noalias() = dt_ * linearization_.lxx[t];
+        Quu_[t].noalias() = dt_ * linearization_.luu[t];
 
-        Qx_[t].noalias() = dt_ * prob_->GetStateCostJacobian(t) + fx_[t].transpose() * Vx_[t + 1];
-        Qu_[t].noalias() = dt_ * prob_->GetControlCostJacobian(t) + fu_[t].transpose() * Vx_[t + 1];
+        Qx_[t].noalias() += fx[t].transpose() * Vx_[t + 1];
+        Qu_[t].noalias() += fu[t].transpose() * Vx_[t + 1];
 
         // State regularization
         Vxx_[t + 1].diagonal().array() += lambda_;
 
-        Qxx_[t].noalias() = dt_ * prob_->GetStateCostHessian(t) + fx_[t].transpose() * Vxx_[t + 1] * fx_[t];
-        Quu_[t].noalias() = dt_ * prob_->GetControlCostHessian(t) + fu_[t].transpose() * Vxx_[t + 1] * fu_[t];
+        Qxx_[t].noalias() += fx[t].transpose() * Vxx_[t + 1] * fx[t];
+        Quu_[t].noalias() += fu[t].transpose() * Vxx_[t + 1] * fu[t];
         // Qux_[t].noalias() = dt_ * prob_->GetStateControlCostHessian()  // TODO: Reactivate once we have costs that depend on both x and u!
-        Qux_[t].noalias() = fu_[t].transpose() * Vxx_[t + 1] * fx_[t];
+        Qux_[t].noalias() = fu[t].transpose() * Vxx_[t + 1] * fx[t];
 
         if (parameters_.UseSecondOrderDynamics && dynamics_solver_->get_has_second_order_derivatives())
         {
-            Eigen::Tensor<double, 1> Vx_tensor = Eigen::TensorMap<Eigen::Tensor<double, 1>>(Vx_[t + 1].data(), NDX_);
-            Qxx_[t].noalias() += Eigen::TensorToMatrix((Eigen::Tensor<double, 2>)dynamics_solver_->fxx(x, u).contract(Vx_tensor, dims), NDX_, NDX_) * dt_;
-            Quu_[t].noalias() += Eigen::TensorToMatrix((Eigen::Tensor<double, 2>)dynamics_solver_->fuu(x, u).contract(Vx_tensor, dims), NU_, NU_) * dt_;
-            Qux_[t].noalias() += Eigen::TensorToMatrix((Eigen::Tensor<double, 2>)dynamics_solver_->fxu(x, u).contract(Vx_tensor, dims), NU_, NDX_) * dt_;
+            Qxx_[t].noalias() += dynamics_solver_->ContractFxx(x, u, Vx_[t + 1]) * dt_;
+            Quu_[t].noalias() += dynamics_solver_->ContractFuu(x, u, Vx_[t + 1]) * dt_;
+            Qux_[t].noalias() += dynamics_solver_->ContractFxu(x, u, Vx_[t + 1]) * dt_;
         }
 
-        Eigen::VectorXd low_limit = control_limits.col(0) - u,
-                        high_limit = control_limits.col(1) - u;
+        low_limit = control_limits.col(0) - u;
+        high_limit = control_limits.col(1) - u;
 
         // Quu_.diagonal().array() += lambda_;
-        BoxQPSolution boxqp_sol;
+        const Eigen::VectorXd& boxqp_init = parameters_.BoxQPWarmStart ? k_[t] : u;
+        timer.Reset();
         if (parameters_.UseNewBoxQP)
         {
-            boxqp_sol = BoxQP(Quu_[t], Qu_[t], low_limit, high_limit, u, 0.1, 100, 1e-5, lambda_, parameters_.BoxQPUsePolynomialLinesearch, parameters_.BoxQPUseCholeskyFactorization);
+            BoxQP(Quu_[t], Qu_[t], low_limit, high_limit, boxqp_init, 0.1, 100, 1e-5, lambda_, parameters_.BoxQPUsePolynomialLinesearch, parameters_.BoxQPUseCholeskyFactorization, boxqp_workspace_);
         }
         else
         {
-            boxqp_sol = ExoticaBoxQP(Quu_[t], Qu_[t], low_limit, high_limit, u, 0.1, 100, 1e-5, lambda_, parameters_.BoxQPUsePolynomialLinesearch, parameters_.BoxQPUseCholeskyFactorization);
+            boxqp_workspace_.SetSolution(ExoticaBoxQP(Quu_[t], Qu_[t], low_limit, high_limit, boxqp_init, 0.1, 100, 1e-5, lambda_, parameters_.BoxQPUsePolynomialLinesearch, parameters_.BoxQPUseCholeskyFactorization));
         }
+        phase_durations_[kBoxQPPhase] += timer.GetDuration();
 
-        Quu_inv_[t].setZero();
-        if (boxqp_sol.free_idx.size() > 0)
-            for (std::size_t i = 0; i < boxqp_sol.free_idx.size(); ++i)
-                for (std::size_t j = 0; j < boxqp_sol.free_idx.size(); ++j)
-                    Quu_inv_[t](boxqp_sol.free_idx[i], boxqp_sol.free_idx[j]) = boxqp_sol.Hff_inv(i, j);
+        Quu_inv_[t] = boxqp_workspace_.Hff_inv;
 
         // Compute controls
         K_[t].noalias() = -Quu_inv_[t] * Qux_[t];
-        k_[t].noalias() = boxqp_sol.x;
+        k_[t] = boxqp_workspace_.x;
 
         // Update the value function w.r.t. u as k (feed-forward term) is clamped inside the BoxQP
-        if (boxqp_sol.free_idx.size() > 0)
-            for (std::size_t i = 0; i < boxqp_sol.clamped_idx.size(); ++i)
-                Qu_[t](boxqp_sol.clamped_idx[i]) = 0.;
+        if (boxqp_workspace_.free_idx.size() > 0)
+            for (std::size_t i = 0; i < boxqp_workspace_.clamped_idx.size(); ++i)
+                Qu_[t](boxqp_workspace_.clamped_idx[i]) = 0.;
 
         Vx_[t].noalias() = Qx_[t] + K_[t].transpose() * Quu_[t] * k_[t] + K_[t].transpose() * Qu_[t] + Qux_[t].transpose() * k_[t];     // Eq. 25(b)
         Vxx_[t].noalias() = Qxx_[t] + K_[t].transpose() * Quu_[t] * K_[t] + K_[t].transpose() * Qux_[t] + Qux_[t].transpose() * K_[t];  // Eq. 25(c)
@@ -49,20 +49,22 @@ void ControlLimitedFeasibilityDrivenDDPSolver::Instantiate(const ControlLimitedF
     th_gradient_tolerance_ = parameters_.GradientTolerance;
     th_acceptstep_ = parameters_.DescentStepAcceptanceThreshold;
     th_acceptnegstep_ = parameters_.AscentStepAcceptanceThreshold;
+
+    if (parameters_.MPCShift < 0) ThrowNamed("MPCShift needs to be non-negative, got " << parameters_.MPCShift);
+    if (parameters_.MaxPlanningTime < 0.) ThrowNamed("MaxPlanningTime needs to be non-negative, got " << parameters_.MaxPlanningTime);
+    if (base_parameters_.ParallelLineSearch) ThrowNamed("ParallelLineSearch is not supported by the feasibility-driven DDP solvers, use ParallelForwardPass instead");
+    mpc_shift_ = parameters_.MPCShift;
+    max_planning_time_ = parameters_.MaxPlanningTime;
+    parallel_forward_pass_ = parameters_.ParallelForwardPass;
 }
 
 void ControlLimitedFeasibilityDrivenDDPSolver::AllocateData()
 {
     AbstractFeasibilityDrivenDDPSolver::AllocateData();
 
-    Quu_inv_.resize(T_ - 1);
-    for (int t = 0; t < T_ - 1; ++t)
-    {
-        Quu_inv_[t] = Eigen::MatrixXd::Zero(NU_, NU_);
-    }
-
     du_lb_.resize(NU_);
     du_ub_.resize(NU_);
+    boxqp_workspace_.Resize(NU_);
 }
 
 void ControlLimitedFeasibilityDrivenDDPSolver::ComputeGains(const int t)
@@ -77,39 +79,29 @@ void ControlLimitedFeasibilityDrivenDDPSolver::ComputeGains(const int t)
     du_lb_ = control_limits_.col(0) - us_[t];
     du_ub_ = control_limits_.col(1) - us_[t];
 
-    // TODO: Use pre-allocated BoxQP
-    BoxQPSolution boxqp_sol;
+    Timer boxqp_timer;
     if (parameters_.UseNewBoxQP)
     {
-        boxqp_sol = BoxQP(Quu_[t], Qu_[t], du_lb_, du_ub_, k_[t], 0.1, 100, 1e-5, ureg_, parameters_.BoxQPUsePolynomialLinesearch, parameters_.BoxQPUseCholeskyFactorization);
+        BoxQP(Quu_[t], Qu_[t], du_lb_, du_ub_, k_[t], 0.1, 100, 1e-5, ureg_, parameters_.BoxQPUsePolynomialLinesearch, parameters_.BoxQPUseCholeskyFactorization, boxqp_workspace_);
     }
     else
     {
-        boxqp_sol = ExoticaBoxQP(Quu_[t], Qu_[t], du_lb_, du_ub_, k_[t], 0.1, 100, 1e-5, ureg_, parameters_.BoxQPUsePolynomialLinesearch, parameters_.BoxQPUseCholeskyFactorization);
+        boxqp_workspace_.SetSolution(ExoticaBoxQP(Quu_[t], Qu_[t], du_lb_, du_ub_, k_[t], 0.1, 100, 1e-5, ureg_, parameters_.BoxQPUsePolynomialLinesearch, parameters_.BoxQPUseCholeskyFactorization));
     }
+    phase_durations_[kBoxQPPhase] += boxqp_timer.GetDuration();
 
     // Compute controls
-    Quu_inv_[t].setZero();
-    if (boxqp_sol.free_idx.size() > 0)
-    {
-        for (std::size_t i = 0; i < boxqp_sol.free_idx.size(); ++i)
-        {
-            for (std::size_t j = 0; j < boxqp_sol.free_idx.size(); ++j)
-            {
-                Quu_inv_[t](boxqp_sol.free_idx[i], boxqp_sol.free_idx[j]) = boxqp_sol.Hff_inv(i, j);  // 8,8
-            }
-        }
-    }
+    Quu_inv_[t] = boxqp_workspace_.Hff_inv;
     K_[t].noalias() = Quu_inv_[t] * Qxu_[t].transpose();
-    k_[t].noalias() = -boxqp_sol.x;
+    k_[t].noalias() = -boxqp_workspace_.x;
 
     // The box-QP clamped the gradient direction; this is important for accounting
     // the algorithm advancement (i.e. stopping criteria)
-    if (boxqp_sol.clamped_idx.size() > 0)
+    if (boxqp_workspace_.clamped_idx.size() > 0)
     {
-        for (std::size_t i = 0; i < boxqp_sol.clamped_idx.size(); ++i)
+        for (std::size_t i = 0; i < boxqp_workspace_.clamped_idx.size(); ++i)
         {
-            Qu_[t](boxqp_sol.clamped_idx[i]) = 0.;
+            Qu_[t](boxqp_workspace_.clamped_idx[i]) = 0.;
         }
     }
 }
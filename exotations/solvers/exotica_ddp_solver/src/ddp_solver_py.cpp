@@ -28,6 +28,7 @@
 //
 
 #include <exotica_ddp_solver/analytic_ddp_solver.h>
+#include <exotica_ddp_solver/batch_ddp_solver.h>
 #include <exotica_ddp_solver/control_limited_ddp_solver.h>
 #include <exotica_ddp_solver/control_limited_feasibility_driven_ddp_solver.h>
 #include <exotica_ddp_solver/feasibility_driven_ddp_solver.h>
@@ -63,7 +64,13 @@ PYBIND11_MODULE(exotica_ddp_solver_py, module)
         .def_property_readonly("fu", &AbstractDDPSolver::get_fu)
         .def_property_readonly("control_cost_evolution", &AbstractDDPSolver::get_control_cost_evolution)
         .def_property_readonly("steplength_evolution", &AbstractDDPSolver::get_steplength_evolution)
-        .def_property_readonly("regularization_evolution", &AbstractDDPSolver::get_regularization_evolution);
+        .def_property_readonly("regularization_evolution", &AbstractDDPSolver::get_regularization_evolution)
+        .def_property_readonly("phase_duration_evolution", &AbstractDDPSolver::get_phase_duration_evolution)
+        .def_property_readonly("line_search_trials_evolution", &AbstractDDPSolver::get_line_search_trials_evolution)
+        .def_property_readonly_static("phase_names", [](py::object) {
+            // Columns of phase_duration_evolution
+            return std::vector<std::string>{"dynamics_derivatives", "cost_derivatives", "backward_pass", "box_qp", "line_search", "problem_update"};
+        });
 
     py::class_<AnalyticDDPSolver, std::shared_ptr<AnalyticDDPSolver>, AbstractDDPSolver> analytic_ddp_solver(module, "AnalyticDDPSolver");
 
@@ -75,4 +82,16 @@ PYBIND11_MODULE(exotica_ddp_solver_py, module)
     feasibility_driven_ddp_solver.def_property_readonly("us", &FeasibilityDrivenDDPSolver::get_us);
 
     py::class_<ControlLimitedFeasibilityDrivenDDPSolver, std::shared_ptr<ControlLimitedFeasibilityDrivenDDPSolver>, AbstractDDPSolver> control_limited_feasibility_driven_ddp_solver(module, "ControlLimitedFeasibilityDrivenDDPSolver");
+
+    py::class_<BatchDDPSolver, std::shared_ptr<BatchDDPSolver>, MotionSolver> batch_ddp_solver(module, "BatchDDPSolver");
+    batch_ddp_solver.def("specify_problems", &BatchDDPSolver::SpecifyProblems, "Binds the solver to pre-initialised problems of identical structure, which are solved in lockstep", py::arg("problems"));
+    batch_ddp_solver.def(
+        "solve_batch", [](BatchDDPSolver* sol) {
+            std::vector<Eigen::MatrixXd> solutions;
+            sol->SolveBatch(solutions);
+            return solutions;
+        },
+        "Solves all problems and returns their control trajectories. The states, controls, cost evolution and termination criterion are set on each problem.", py::call_guard<py::gil_scoped_release>());
+    batch_ddp_solver.def_property_readonly("problems", &BatchDDPSolver::GetProblems);
+    batch_ddp_solver.def_property_readonly("number_of_iterations", &BatchDDPSolver::GetNumberOfIterations);
 }
@@ -29,6 +29,8 @@
 
 #include <exotica_ddp_solver/feasibility_driven_ddp_solver.h>
 
+#include <algorithm>
+
 REGISTER_MOTIONSOLVER_TYPE("FeasibilityDrivenDDPSolver", exotica::FeasibilityDrivenDDPSolver)
 
 namespace exotica
@@ -47,6 +49,13 @@ void FeasibilityDrivenDDPSolver::Instantiate(const FeasibilityDrivenDDPSolverIni
     th_gradient_tolerance_ = parameters_.GradientTolerance;
     th_acceptstep_ = parameters_.DescentStepAcceptanceThreshold;
     th_acceptnegstep_ = parameters_.AscentStepAcceptanceThreshold;
+
+    if (parameters_.MPCShift < 0) ThrowNamed("MPCShift needs to be non-negative, got " << parameters_.MPCShift);
+    if (parameters_.MaxPlanningTime < 0.) ThrowNamed("MaxPlanningTime needs to be non-negative, got " << parameters_.MaxPlanningTime);
+    if (base_parameters_.ParallelLineSearch) ThrowNamed("ParallelLineSearch is not supported by the feasibility-driven DDP solvers, use ParallelForwardPass instead");
+    mpc_shift_ = parameters_.MPCShift;
+    max_planning_time_ = parameters_.MaxPlanningTime;
+    parallel_forward_pass_ = parameters_.ParallelForwardPass;
 }
 
 void AbstractFeasibilityDrivenDDPSolver::AllocateData()
@@ -68,17 +77,21 @@ void AbstractFeasibilityDrivenDDPSolver::AllocateData()
 
     xs_.resize(T + 1);
     us_.resize(T);
+    xs_batch_.resize(NX_, T + 1);
+    us_batch_.resize(NU_, T);
     xs_try_.resize(T + 1);
     us_try_.resize(T);
     dx_.resize(T + 1);
+    xs_best_.assign(T + 1, Eigen::VectorXd::Zero(NX_));
+    us_best_.assign(T, Eigen::VectorXd::Zero(NU_));
 
     FuTVxx_p_.resize(T);
     Quu_ldlt_.resize(T);
     Quuk_.resize(T);
 
     Quu_inv_.resize(T);
-    fx_.resize(T);
-    fu_.resize(T);
+    linearization_.fx.resize(T);
+    linearization_.fu.resize(T);
 
     for (int t = 0; t < T; ++t)
     {
@@ -109,8 +122,8 @@ void AbstractFeasibilityDrivenDDPSolver::AllocateData()
         Quuk_[t] = Eigen::VectorXd(NU_);
 
         Quu_inv_[t] = Eigen::MatrixXd(NU_, NU_);
-        fx_[t] = Eigen::MatrixXd(NDX_, NDX_);
-        fu_[t] = Eigen::MatrixXd(NDX_, NU_);
+        linearization_.fx[t] = Eigen::MatrixXd(NDX_, NDX_);
+        linearization_.fu[t] = Eigen::MatrixXd(NDX_, NU_);
     }
     Vxx_.back() = Eigen::MatrixXd::Zero(NDX_, NDX_);
     Vx_.back() = Eigen::VectorXd::Zero(NDX_);
@@ -123,6 +136,13 @@ void AbstractFeasibilityDrivenDDPSolver::AllocateData()
 
     // If T changed, we need to re-allocate.
     last_T_ = T_;
+    has_solution_ = false;
+}
+
+void AbstractFeasibilityDrivenDDPSolver::ShiftWarmStart()
+{
+    // Only the trajectories carry over, the gains are recomputed by the first backward pass before they are used
+    prob_->ShiftTrajectory(mpc_shift_);
 }
 
 void AbstractFeasibilityDrivenDDPSolver::SpecifyProblem(PlanningProblemPtr pointer)
@@ -139,14 +159,18 @@ void AbstractFeasibilityDrivenDDPSolver::SpecifyProblem(PlanningProblemPtr point
     AllocateData();
 }
 
-void AbstractFeasibilityDrivenDDPSolver::Solve(Eigen::MatrixXd& solution)
+void AbstractFeasibilityDrivenDDPSolver::SolveAtResolution(Eigen::MatrixXd& solution, int max_iterations)
 {
+    EXOTICA_PROFILE_SCOPE("AbstractFeasibilityDrivenDDPSolver::SolveAtResolution");
     if (!prob_) ThrowNamed("Solver has not been initialized!");
-    Timer planning_timer, backward_pass_timer, line_search_timer;
+    Timer planning_timer, backward_pass_timer, line_search_timer, problem_update_timer;
 
     T_ = prob_->get_T();
     if (T_ != last_T_) AllocateData();
 
+    // Real-time MPC: warm-start from the shifted solution of the previous Solve
+    if (mpc_shift_ > 0 && has_solution_) ShiftWarmStart();
+
     dt_ = dynamics_solver_->get_dt();
     control_limits_ = dynamics_solver_->get_control_limits();
 
@@ -161,10 +185,11 @@ void AbstractFeasibilityDrivenDDPSolver::Solve(Eigen::MatrixXd& solution)
     xs_.back() = X_warm.col(T_ - 1);
     is_feasible_ = false;  // We assume the first iteration is always infeasible. TODO: Make this configurable
 
-    prob_->ResetCostEvolution(GetNumberOfMaxIterations() + 1);
-    control_cost_evolution_.assign(GetNumberOfMaxIterations() + 1, std::numeric_limits<double>::quiet_NaN());
-    steplength_evolution_.assign(GetNumberOfMaxIterations() + 1, std::numeric_limits<double>::quiet_NaN());
-    regularization_evolution_.assign(GetNumberOfMaxIterations() + 1, std::numeric_limits<double>::quiet_NaN());
+    prob_->ResetCostEvolution(max_iterations + 1);
+    control_cost_evolution_.assign(max_iterations + 1, std::numeric_limits<double>::quiet_NaN());
+    steplength_evolution_.assign(max_iterations + 1, std::numeric_limits<double>::quiet_NaN());
+    regularization_evolution_.assign(max_iterations + 1, std::numeric_limits<double>::quiet_NaN());
+    ResetPhaseDurationEvolution();
     prob_->PreUpdate();
     solution.resize(T_ - 1, NU_);
 
@@ -189,13 +214,16 @@ void AbstractFeasibilityDrivenDDPSolver::Solve(Eigen::MatrixXd& solution)
 
     bool diverged = false;
     bool converged = false;
+    bool deadline_reached = false;
+    best_cost_ = std::numeric_limits<double>::infinity();
+    time_taken_forward_pass_ = 0.;
 
     bool recalcDiff = true;
     int iter;
 
     // double time_taken_setup_ = planning_timer.GetDuration();
 
-    for (iter = 1; iter <= GetNumberOfMaxIterations(); ++iter)
+    for (iter = 1; iter <= max_iterations; ++iter)
     {
         // Check whether user interrupted (Ctrl+C)
         if (Server::IsRos() && !ros::ok())
@@ -205,6 +233,15 @@ void AbstractFeasibilityDrivenDDPSolver::Solve(Eigen::MatrixXd& solution)
             break;
         }
 
+        // The accepted step of the line search updated the problem, its costs and gaps are evaluated before the backward pass
+        if (recalcDiff)
+        {
+            problem_update_timer.Reset();
+            CalcDiff();
+            phase_durations_[kProblemUpdatePhase] = problem_update_timer.GetDuration();
+            recalcDiff = false;
+        }
+
         backward_pass_timer.Reset();
         while (!ComputeDirection(recalcDiff))
         {
@@ -223,6 +260,7 @@ void AbstractFeasibilityDrivenDDPSolver::Solve(Eigen::MatrixXd& solution)
             }
         }
         time_taken_backward_pass_ = backward_pass_timer.GetDuration();
+        phase_durations_[kBackwardPassPhase] = time_taken_backward_pass_;
 
         if (diverged)
         {
@@ -230,6 +268,14 @@ void AbstractFeasibilityDrivenDDPSolver::Solve(Eigen::MatrixXd& solution)
             break;
         }
 
+        // Real-time MPC: stop if the line search is not expected to finish before the deadline (estimated by the last line search)
+        if (max_planning_time_ > 0. && planning_timer.GetDuration() + time_taken_forward_pass_ > max_planning_time_)
+        {
+            if (debug_) HIGHLIGHT_NAMED("FeasibilityDrivenDDPSolver::Solve", "Deadline reached: " << planning_timer.GetDuration() << " s (MaxPlanningTime: " << max_planning_time_ << " s)")
+            deadline_reached = true;
+            break;
+        }
+
         UpdateExpectedImprovement();
 
         // We need to recalculate the derivatives when the step length passes
@@ -238,6 +284,11 @@ void AbstractFeasibilityDrivenDDPSolver::Solve(Eigen::MatrixXd& solution)
         for (int ai = 0; ai < alpha_space_.size(); ++ai)
         {
             steplength_ = alpha_space_(ai);
+            if (parallel_forward_pass_ && prob_->GetRolloutNumThreads() > 1 && !PredictStep(steplength_))
+            {
+                control_cost_evolution_.at(iter) = control_cost_;
+                continue;
+            }
             dV_ = TryStep(steplength_);
 
             ExpectedImprovement();
@@ -251,7 +302,6 @@ void AbstractFeasibilityDrivenDDPSolver::Solve(Eigen::MatrixXd& solution)
                     SetCandidate(xs_try_, us_try_, (was_feasible_) || (steplength_ == 1.0));
                     cost_ = cost_try_;
                     control_cost_ = control_cost_try_;
-                    prob_->SetCostEvolution(iter, cost_);
                     control_cost_evolution_.at(iter) = control_cost_;
                     recalcDiff = true;
                     break;
@@ -266,7 +316,6 @@ void AbstractFeasibilityDrivenDDPSolver::Solve(Eigen::MatrixXd& solution)
                     SetCandidate(xs_try_, us_try_, (was_feasible_) || (steplength_ == 1));
                     cost_ = cost_try_;
                     control_cost_ = control_cost_try_;
-                    prob_->SetCostEvolution(iter, cost_);
                     control_cost_evolution_.at(iter) = control_cost_;
                     break;
                 }
@@ -276,14 +325,30 @@ void AbstractFeasibilityDrivenDDPSolver::Solve(Eigen::MatrixXd& solution)
                 // }
             }
 
-            prob_->SetCostEvolution(iter, cost_);
             control_cost_evolution_.at(iter) = control_cost_;
         }
         time_taken_forward_pass_ = line_search_timer.GetDuration();
+        phase_durations_[kLineSearchPhase] = time_taken_forward_pass_;
+
+        if (max_planning_time_ > 0. && is_feasible_ && cost_ < best_cost_)
+        {
+            best_cost_ = cost_;
+            xs_best_ = xs_;
+            us_best_ = us_;
+        }
 
         steplength_evolution_.at(iter) = steplength_;
         regularization_evolution_.at(iter) = xreg_;
 
+        IterationRecord record;
+        record.cost = cost_;
+        record.step_length = steplength_;
+        record.regularization = xreg_;
+        record.phase_durations[0] = time_taken_backward_pass_;
+        record.phase_durations[1] = time_taken_forward_pass_;
+        prob_->SetCostEvolution(iter, record);
+        StorePhaseDurations(iter);
+
         if (debug_)
         {
             if (iter % 10 == 0 || iter == 1)
@@ -349,7 +414,17 @@ void AbstractFeasibilityDrivenDDPSolver::Solve(Eigen::MatrixXd& solution)
 
     if (diverged) prob_->termination_criterion = TerminationCriterion::Divergence;
     if (converged) prob_->termination_criterion = TerminationCriterion::Convergence;
-    if (!converged && iter == GetNumberOfMaxIterations() + 1) prob_->termination_criterion = TerminationCriterion::IterationLimit;
+    if (!converged && (iter == max_iterations + 1 || deadline_reached)) prob_->termination_criterion = TerminationCriterion::IterationLimit;
+
+    // Real-time MPC: return the best feasible iterate if the last one is infeasible or worse
+    if (max_planning_time_ > 0. && best_cost_ < std::numeric_limits<double>::infinity() && (!is_feasible_ || best_cost_ < cost_))
+    {
+        xs_ = xs_best_;
+        us_ = us_best_;
+        cost_ = best_cost_;
+        is_feasible_ = true;
+        for (int t = 0; t < T_ - 1; ++t) prob_->Update(xs_[t], us_[t], t);
+    }
 
     // Store the best solution found over all iterations
     for (int t = 0; t < T_ - 1; ++t)
@@ -358,6 +433,12 @@ void AbstractFeasibilityDrivenDDPSolver::Solve(Eigen::MatrixXd& solution)
         // prob_->Update(us_[t], t);
     }
 
+    // Export the feedback policy of the solution for control threads, the gains follow u = us - K dx
+    std::vector<Eigen::MatrixXd> K(T_ - 1);
+    for (int t = 0; t < T_ - 1; ++t) K[t] = -K_[t];
+    PublishFeedbackPolicy(std::make_shared<const FeedbackPolicy>(dynamics_solver_, xs_, us_, std::vector<Eigen::VectorXd>(T_ - 1, Eigen::VectorXd::Zero(NU_)), std::move(K)));
+
+    has_solution_ = true;
     planning_time_ = planning_timer.GetDuration();
 
     // HIGHLIGHT(std::setprecision(4) << "Setup: " << time_taken_setup_ * 1e3 << "\tBwd: " << time_taken_backward_pass_ * 1e3 << "\tFwd: " << time_taken_forward_pass_ * 1e3 << "\tSolve = " << (planning_time_ - time_taken_setup_)*1e3 << "\talpha=" << steplength_)
@@ -479,10 +560,12 @@ double AbstractFeasibilityDrivenDDPSolver::TryStep(const double steplength)
 
 void AbstractFeasibilityDrivenDDPSolver::ForwardPass(const double steplength)
 {
+    EXOTICA_PROFILE_SCOPE("AbstractFeasibilityDrivenDDPSolver::ForwardPass");
     if (steplength > 1. || steplength < 0.)
     {
         ThrowPretty("Invalid argument: invalid step length, value should be between 0. to 1. - got=" << steplength);
     }
+    ++line_search_trials_;
     cost_try_ = 0.;
     control_cost_try_ = 0.;
     xnext_ = prob_->get_X(0);
@@ -543,6 +626,77 @@ void AbstractFeasibilityDrivenDDPSolver::ForwardPass(const double steplength)
     }
 }
 
+bool AbstractFeasibilityDrivenDDPSolver::PredictStep(const double steplength)
+{
+    // Segments of (almost) equal length, one per thread
+    const int T = T_ - 1;
+    const int num_segments = std::min(prob_->GetRolloutNumThreads(), T);
+    segment_begin_.resize(num_segments);
+    x_begin_.resize(num_segments, Eigen::VectorXd(NX_));
+    segment_nodes_.resize(num_segments, Eigen::VectorXd(NX_));
+    for (int j = 0; j < num_segments; ++j) segment_begin_[j] = static_cast<int>(static_cast<long>(j) * T / num_segments);
+
+    const DynamicsSolverPtr dynamics_solver = prob_->GetScene()->GetDynamicsSolver();
+    const bool close_gaps = is_feasible_ || steplength == 1.;
+    if (!close_gaps)
+    {
+        gap_steps_.resize(T_);
+        for (int t = 0; t < T_; ++t) gap_steps_[t].noalias() = (steplength - 1.) * fs_[t];
+    }
+
+    // The nodes at the segment beginnings are predicted by the linearised dynamics: dx_{t+1} = fx dx_t + fu du_t + steplength * f_{t+1}
+    x_begin_[0] = prob_->get_X(0);
+    node0_.resize(NX_);
+    if (close_gaps)
+        node0_ = x_begin_[0];
+    else
+        dynamics_solver->Integrate(x_begin_[0], gap_steps_[0], 1., node0_);
+    predict_dx_ = dynamics_solver->StateDelta(node0_, xs_[0]);
+    for (int j = 1, t = 0; j < num_segments; ++j)
+    {
+        for (; t < segment_begin_[j]; ++t)
+        {
+            predict_du_.noalias() = -steplength * k_[t];
+            predict_du_.noalias() -= K_[t] * predict_dx_;
+            predict_dx_next_.noalias() = linearization_.fx[t] * predict_dx_;
+            predict_dx_next_.noalias() += linearization_.fu[t] * predict_du_;
+            if (!is_feasible_) predict_dx_next_.noalias() += steplength * fs_[t + 1];
+            predict_dx_.swap(predict_dx_next_);
+        }
+        dynamics_solver->Integrate(xs_[t], predict_dx_, 1., x_begin_[j]);
+    }
+
+    // Trial step of ForwardPass, the nodes at the segment beginnings are the predicted ones. Each segment integrates the gaps with the
+    // dynamics solver of its thread into its own node buffer.
+    const ShootingPolicy policy = [&](int j, int t, DynamicsSolver& segment_dynamics_solver, const Eigen::VectorXd& x_sim, Eigen::VectorXdRef x_t, Eigen::VectorXdRef u_t) {
+        Eigen::VectorXd& node = segment_nodes_[j];
+        if (t == 0)
+            node = node0_;
+        else if (close_gaps || t == segment_begin_[j])
+            node = x_sim;
+        else
+            segment_dynamics_solver.Integrate(x_sim, gap_steps_[t], 1., node);
+        x_t = node;
+        if (t == T) return;
+        u_t = us_[t];
+        u_t.noalias() -= steplength * k_[t];
+        u_t.noalias() -= K_[t] * segment_dynamics_solver.StateDelta(node, xs_[t]);
+        if (clamp_to_control_limits_in_forward_pass_) u_t = u_t.cwiseMax(control_limits_.col(0)).cwiseMin(control_limits_.col(1));
+    };
+    double cost;
+    prob_->RolloutMultipleShooting(segment_begin_, x_begin_, policy, X_segments_, U_segments_, X_sim_segments_, cost);
+    ++line_search_trials_;
+    if (IsNaN(cost)) return false;
+
+    // Acceptance test of the line search for the predicted trial step
+    for (int t = 0; t < T_; ++t) xs_try_[t] = X_segments_.col(t);
+    dV_ = cost_ - cost;
+    ExpectedImprovement();
+    dVexp_ = steplength * (d_[0] + 0.5 * steplength * d_[1]);
+    if (dVexp_ >= 0) return d_[0] < th_grad_ || dV_ > th_acceptstep_ * dVexp_;
+    return dV_ > th_acceptnegstep_ * dVexp_;
+}
+
 bool AbstractFeasibilityDrivenDDPSolver::ComputeDirection(const bool recalcDiff)
 {
     if (recalcDiff)
@@ -585,8 +739,24 @@ double AbstractFeasibilityDrivenDDPSolver::CalcDiff()
 
 bool AbstractFeasibilityDrivenDDPSolver::BackwardPassFDDP()
 {
-    Vxx_.back() = prob_->GetStateCostHessian(T_ - 1);
-    Vx_.back() = prob_->GetStateCostJacobian(T_ - 1);
+    EXOTICA_PROFILE_SCOPE("AbstractFeasibilityDrivenDDPSolver::BackwardPassFDDP");
+    // Derivatives of the state transitions along the current iterate, evaluated for all time steps at once
+    for (std::size_t t = 0; t < xs_.size(); ++t)
+    {
+        xs_batch_.col(t) = xs_[t];
+        if (t < us_.size()) us_batch_.col(t) = us_[t];
+    }
+    Timer timer;
+    prob_->LinearizeDynamics(xs_batch_, us_batch_, linearization_);
+    phase_durations_[kDynamicsDerivativesPhase] += timer.GetDuration();
+    timer.Reset();
+    prob_->QuadratizeCost(linearization_);
+    phase_durations_[kCostDerivativesPhase] += timer.GetDuration();
+    const std::vector<Eigen::MatrixXd>& fx = linearization_.fx;
+    const std::vector<Eigen::MatrixXd>& fu = linearization_.fu;
+
+    Vxx_.back() = linearization_.lxx.back();
+    Vx_.back() = linearization_.lx.back();
 
     if (!std::isnan(xreg_))
     {
@@ -603,23 +773,19 @@ bool AbstractFeasibilityDrivenDDPSolver::BackwardPassFDDP()
         const Eigen::MatrixXd& Vxx_p = Vxx_[t + 1];
         const Eigen::VectorXd& Vx_p = Vx_[t + 1];
 
-        Qxx_[t].noalias() = dt_ * prob_->GetStateCostHessian(t);
+        Qxx_[t].noalias() = dt_ * linearization_.lxx[t];
         Qxu_[t].noalias() = dt_ * prob_->GetStateControlCostHessian().transpose();
-        Quu_[t].noalias() = dt_ * prob_->GetControlCostHessian(t);
-        Qx_[t].noalias() = dt_ * prob_->GetStateCostJacobian(t);
-        Qu_[t].noalias() = dt_ * prob_->GetControlCostJacobian(t);
-
-        dynamics_solver_->ComputeDerivatives(xs_[t], us_[t]);
-        fx_[t].noalias() = dynamics_solver_->get_Fx();
-        fu_[t].noalias() = dynamics_solver_->get_Fu();
-
-        FxTVxx_p_.noalias() = fx_[t].transpose() * Vxx_p;
-        FuTVxx_p_[t].noalias() = fu_[t].transpose() * Vxx_p;
-        Qxx_[t].noalias() += FxTVxx_p_ * fx_[t];
-        Qxu_[t].noalias() += FxTVxx_p_ * fu_[t];
-        Quu_[t].noalias() += FuTVxx_p_[t] * fu_[t];
-        Qx_[t].noalias() += fx_[t].transpose() * Vx_p;
-        Qu_[t].noalias() += fu_[t].transpose() * Vx_p;
+        Qx_[t].noalias() = dt_ * linearization_.lx[t];
+        Qu_[t].noalias() = dt_ * linearization_.lu[t];
+        Quu_[t].noalias() = dt_ * linearization_.luu[t];
+
+        FxTVxx_p_.noalias() = fx[t].transpose() * Vxx_p;
+        FuTVxx_p_[t].noalias() = fu[t].transpose() * Vxx_p;
+        Qxx_[t].noalias() += FxTVxx_p_ * fx[t];
+        Qxu_[t].noalias() += FxTVxx_p_ * fu[t];
+        Quu_[t].noalias() += FuTVxx_p_[t] * fu[t];
+        Qx_[t].noalias() += fx[t].transpose() * Vx_p;
+        Qu_[t].noalias() += fu[t].transpose() * Vx_p;
 
         if (!std::isnan(ureg_))
         {
@@ -700,6 +866,8 @@ void AbstractFeasibilityDrivenDDPSolver::ComputeGains(const int t)
     Quu_ldlt_[t].solveInPlace(K_[t]);
     k_[t] = Qu_[t];
     Quu_ldlt_[t].solveInPlace(k_[t]);
+    Quu_inv_[t].setIdentity();
+    Quu_ldlt_[t].solveInPlace(Quu_inv_[t]);
 }
 
 }  // namespace exotica
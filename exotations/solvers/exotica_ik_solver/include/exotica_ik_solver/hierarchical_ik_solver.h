@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2018-2020, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_IK_SOLVER_HIERARCHICAL_IK_SOLVER_H_
+#define EXOTICA_IK_SOLVER_HIERARCHICAL_IK_SOLVER_H_
+
+#include <exotica_core/motion_solver.h>
+#include <exotica_core/problems/unconstrained_end_pose_problem.h>
+
+#include <exotica_ik_solver/hierarchical_ik_solver_initializer.h>
+
+namespace exotica
+{
+///
+/// \brief	Prioritised (strict hierarchy) Inverse Kinematics Solver
+/// The cost tasks of the problem are grouped into priority levels. Each level is solved with a damped, weighted
+/// pseudo-inverse in the null-space of all higher priority levels. Steps are accepted by a backtracking line-search
+/// which compares the errors of the levels lexicographically.
+///
+class HierarchicalIKSolver : public MotionSolver, public Instantiable<HierarchicalIKSolverInitializer>
+{
+public:
+    void Solve(Eigen::MatrixXd& solution) override;
+    void SpecifyProblem(PlanningProblemPtr pointer) override;
+
+    /// \brief Number of priority levels
+    int GetNumberOfPriorityLevels() const { return static_cast<int>(levels_.size()); }
+
+    /// \brief Errors of each priority level at the solution of the last solve
+    const Eigen::VectorXd& GetLevelErrors() const { return level_errors_; }
+
+private:
+    /// \brief Cost tasks sharing a priority level and the workspaces of their pseudo-inverse
+    struct PriorityLevel
+    {
+        std::vector<int> tasks;                                     ///< Indices of the cost tasks of this level
+        int length_jacobian = 0;                                    ///< Number of task space rows of this level
+        Eigen::MatrixXd jacobian;                                   ///< Weighted Jacobian of this level in the coordinates z (m_k, N)
+        Eigen::VectorXd error;                                      ///< Weighted task space error of this level (m_k)
+        Eigen::VectorXd residual;                                   ///< Error not yet resolved by the higher levels (m_k)
+        Eigen::MatrixXd projected_jacobian_t;                       ///< Transposed Jacobian projected into the null-space of the higher levels (N, m_k)
+        Eigen::ColPivHouseholderQR<Eigen::MatrixXd> decomposition;  ///< Rank-revealing decomposition of projected_jacobian_t, shared by the step and the null-space update
+        Eigen::MatrixXd r_factor;                                   ///< Leading rows of the R factor of decomposition (rank, m_k)
+        Eigen::MatrixXd system;                                     ///< Damped Gram matrix of the R factor (rank, rank)
+        Eigen::LLT<Eigen::MatrixXd> system_decomposition;           ///< Cholesky decomposition of system
+        Eigen::VectorXd reduced_step;                               ///< Step of this level in the coordinates of the basis (rank)
+        Eigen::MatrixXd basis;                                      ///< Orthonormal basis of the row space of the projected Jacobian (N, rank)
+    };
+
+    /// \brief Computes the prioritised step qd_ from the current state of the problem
+    /// @return Whether the pseudo-inverses of all levels could be computed
+    bool ComputeStep();
+
+    /// \brief Computes the weighted error of each priority level from the current state of the problem
+    void ComputeLevelErrors(Eigen::VectorXd& errors) const;
+
+    /// \brief Lexicographic comparison of level errors (levels whose errors differ by less than the tolerance are considered equal)
+    bool IsLexicographicallySmaller(const Eigen::VectorXd& errors, const Eigen::VectorXd& reference) const;
+
+    UnconstrainedEndPoseProblemPtr prob_;  // Shared pointer to the planning problem.
+
+    std::vector<PriorityLevel> levels_;  ///< Priority levels, sorted from the highest to the lowest priority
+    Eigen::MatrixXd W_inv_;              ///< Joint-space weighting (inverse)
+    Eigen::MatrixXd W_inv_cholesky_;     ///< Cholesky factor L of the inverse joint-space weighting, W^-1 = L L^T
+    Eigen::VectorXd alpha_space_;        ///< Steplengths for backtracking line-search
+
+    // Pre-allocation of variables used during optimisation
+    double step_;                             ///< Size of step: Sum of squared norm of qd_
+    double steplength_;                       ///< Accepted steplength
+    Eigen::VectorXd q_;                       ///< Joint configuration vector, used during optimisation
+    Eigen::VectorXd qd_;                      ///< Change in joint configuration, used during optimisation
+    Eigen::VectorXd z_;                       ///< Change in the weighted coordinates z, qd_ = L z_
+    Eigen::VectorXd level_step_;              ///< Contribution of one level to z_
+    Eigen::VectorXd q_tmp_;                   ///< Line-search candidate configuration
+    Eigen::MatrixXd null_space_projector_;    ///< Projector into the null-space of the levels solved so far (N, N)
+    Eigen::VectorXd level_errors_;            ///< Errors of each priority level, used during optimisation
+    Eigen::VectorXd level_errors_candidate_;  ///< Errors of each priority level at the line-search candidate
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_IK_SOLVER_HIERARCHICAL_IK_SOLVER_H_
@@ -50,6 +50,7 @@ public:
 private:
     UnconstrainedEndPoseProblemPtr prob_;  // Shared pointer to the planning problem.
 
+    Eigen::MatrixXd W_;            ///< Joint-space weighting
     Eigen::MatrixXd W_inv_;        ///< Joint-space weighting (inverse)
     Eigen::VectorXd alpha_space_;  ///< Steplengths for backtracking line-search
 
@@ -62,11 +63,14 @@ private:
     Eigen::VectorXd qd_;                           ///< Change in joint configuration, used during optimisation
     Eigen::VectorXd yd_;                           ///< Task space difference/error, used during optimisation
     Eigen::MatrixXd cost_jacobian_;                ///< Jacobian, used during optimisation
-    Eigen::MatrixXd J_pseudo_inverse_;             ///< Jacobian pseudo-inverse, used during optimisation
     double error_;                                 ///< Error, used during optimisation
     double error_prev_;                            ///< Error at previous iteration, used during optimisation
-    Eigen::LLT<Eigen::MatrixXd> J_decomposition_;  ///< Cholesky decomposition for the weighted pseudo-inverse
-    Eigen::MatrixXd J_tmp_;                        ///< Temporary variable for inverse computation
+    Eigen::LLT<Eigen::MatrixXd> J_decomposition_;  ///< Cholesky decomposition of the damped normal equations
+    Eigen::MatrixXd J_tmp_;                        ///< Damped normal equations matrix, in task space (m,m) or joint space (n,n)
+    Eigen::VectorXd normal_equations_rhs_;         ///< Right-hand side and solution of the task space normal equations
+    Eigen::MatrixXd JT_times_J_;                   ///< J^T * S^2 * J of the fused update, used for the joint space normal equations
+    Eigen::VectorXd JT_times_yd_;                  ///< J^T * S^2 * ydiff of the fused update, used for the joint space normal equations
+    bool use_joint_space_normal_equations_;        ///< Whether the normal equations are solved in joint space (more task dimensions than joints)
 
     // Convergence thresholds
     double th_stop_;  ///< Gradient convergence threshold
@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2018-2020, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_IK_SOLVER_QP_IK_SOLVER_H_
+#define EXOTICA_IK_SOLVER_QP_IK_SOLVER_H_
+
+#include <exotica_core/motion_solver.h>
+#include <exotica_core/problems/bounded_end_pose_problem.h>
+#include <exotica_core/problems/end_pose_problem.h>
+#include <exotica_core/tools/admm_qp.h>
+
+#include <exotica_ik_solver/qp_ik_solver_initializer.h>
+
+namespace exotica
+{
+///
+/// \brief	Constrained velocity Inverse Kinematics Solver
+/// Each iteration solves the Gauss-Newton step of the cost as a quadratic program
+///     min 0.5 dq^T (J^T S J + damping W) dq + (J^T S ydiff)^T dq
+///     s.t. equality + J_eq dq = 0, inequality + J_neq dq <= 0, lb - q <= dq <= ub - q, |dq| <= MaxStep
+/// with the linearised equality and inequality constraints of an EndPoseProblem and the joint limits of a
+/// BoundedEndPoseProblem (or of an EndPoseProblem with UseBounds). The QP is solved by AdmmQP and warm-started
+/// from the previous step, i.e., the active set carries over between iterations and consecutive calls to Solve. The step of a QP that
+/// does not converge within QPMaxIterations is clamped to the joint limits and MaxStep, and the warm start is discarded.
+///
+class QPIKSolver : public MotionSolver, public Instantiable<QPIKSolverInitializer>
+{
+public:
+    void Solve(Eigen::MatrixXd& solution) override;
+    void SpecifyProblem(PlanningProblemPtr pointer) override;
+
+    /// \brief Total number of QP iterations of the last solve
+    int GetNumberOfQPIterations() const { return qp_iterations_; }
+
+private:
+    /// \brief Updates the problem at q_ and linearises its cost and constraints into the QP
+    void UpdateQP();
+
+    /// \brief Scalar cost and feasibility of the problem at its current state
+    double GetScalarCost();
+    bool IsValid();
+
+    BoundedEndPoseProblemPtr bounded_prob_;  ///< Set if a BoundedEndPoseProblem is solved
+    EndPoseProblemPtr end_pose_prob_;        ///< Set if an EndPoseProblem is solved
+    AdmmQP qp_;                              ///< QP solver, keeps its iterates between steps and calls to Solve
+
+    // Pre-allocation of variables used during optimisation
+    int num_equality_ = 0;      ///< Number of equality constraints
+    int num_inequality_ = 0;    ///< Number of inequality constraints
+    bool use_bounds_ = false;   ///< Whether the joint limits are constraints of the QP
+    int qp_iterations_ = 0;     ///< QP iterations accumulated over the last solve
+    Eigen::MatrixXd bounds_;    ///< Joint limits (N, 2)
+    Eigen::MatrixXd W_;         ///< Joint-space weighting
+    Eigen::VectorXd q_;         ///< Joint configuration vector, used during optimisation
+    Eigen::VectorXd qd_;        ///< Change in joint configuration, used during optimisation
+    Eigen::MatrixXd hessian_;   ///< Gauss-Newton Hessian of the QP (N, N)
+    Eigen::VectorXd gradient_;  ///< Gradient of the QP (N)
+    Eigen::MatrixXd A_;         ///< Constraint matrix of the QP: equalities, inequalities and joint limits
+    Eigen::VectorXd lower_;     ///< Lower bounds of A_ dq
+    Eigen::VectorXd upper_;     ///< Upper bounds of A_ dq
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_IK_SOLVER_QP_IK_SOLVER_H_
@@ -0,0 +1,260 @@
+//
+// Copyright (c) 2018-2020, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <algorithm>
+
+#include <exotica_ik_solver/hierarchical_ik_solver.h>
+
+REGISTER_MOTIONSOLVER_TYPE("HierarchicalIKSolver", exotica::HierarchicalIKSolver)
+
+namespace exotica
+{
+void HierarchicalIKSolver::SpecifyProblem(PlanningProblemPtr pointer)
+{
+    if (pointer->type() != "exotica::UnconstrainedEndPoseProblem")
+    {
+        ThrowNamed("This HierarchicalIKSolver can't solve problem of type '" << pointer->type() << "'!");
+    }
+    MotionSolver::SpecifyProblem(pointer);
+    prob_ = std::static_pointer_cast<UnconstrainedEndPoseProblem>(pointer);
+
+    W_inv_ = prob_->W.inverse();
+
+    // Check dimension of W_ as this is a public member of the problem, and thus, can be edited by error.
+    if (W_inv_.rows() != prob_->N || W_inv_.cols() != prob_->N)
+        ThrowNamed("Size of W incorrect: (" << W_inv_.rows() << ", " << W_inv_.cols() << "), when expected: (" << prob_->N << ", " << prob_->N << ")");
+    W_inv_cholesky_ = W_inv_.llt().matrixL();
+
+    // Group the cost tasks into priority levels
+    const int num_tasks = prob_->cost.num_tasks;
+    Eigen::VectorXi priority_levels = parameters_.PriorityLevels;
+    if (priority_levels.size() == 0) priority_levels = Eigen::VectorXi::LinSpaced(num_tasks, 0, num_tasks - 1);
+    if (priority_levels.size() != num_tasks)
+        ThrowNamed("PriorityLevels needs one level per cost task (" << num_tasks << "), given: " << priority_levels.size());
+    if (num_tasks > 0 && priority_levels.minCoeff() < 0) ThrowNamed("Priority levels have to be non-negative!");
+
+    levels_.clear();
+    for (int level = 0; num_tasks > 0 && level <= priority_levels.maxCoeff(); ++level)
+    {
+        PriorityLevel priority_level;
+        for (int i = 0; i < num_tasks; ++i)
+        {
+            if (priority_levels(i) != level) continue;
+            priority_level.tasks.push_back(i);
+            priority_level.length_jacobian += prob_->cost.indexing[i].length_jacobian;
+        }
+        if (priority_level.tasks.empty()) continue;
+
+        const int m = priority_level.length_jacobian;
+        priority_level.jacobian.resize(m, prob_->N);
+        priority_level.error.resize(m);
+        priority_level.residual.resize(m);
+        priority_level.projected_jacobian_t.resize(prob_->N, m);
+        priority_level.decomposition = Eigen::ColPivHouseholderQR<Eigen::MatrixXd>(prob_->N, m);
+        levels_.push_back(priority_level);
+    }
+
+    // Set up backtracking line-search coefficients
+    alpha_space_ = Eigen::VectorXd::LinSpaced(10, 1.0, 0.1);
+
+    // Allocate variables
+    q_.resize(prob_->N);
+    qd_.resize(prob_->N);
+    z_.resize(prob_->N);
+    level_step_.resize(prob_->N);
+    q_tmp_.resize(prob_->N);
+    null_space_projector_.resize(prob_->N, prob_->N);
+    level_errors_.resize(levels_.size());
+    level_errors_candidate_.resize(levels_.size());
+}
+
+void HierarchicalIKSolver::ComputeLevelErrors(Eigen::VectorXd& errors) const
+{
+    const auto rho = prob_->cost.S.diagonal();
+    for (std::size_t k = 0; k < levels_.size(); ++k)
+    {
+        errors(k) = 0.0;
+        for (const int i : levels_[k].tasks)
+        {
+            const TaskIndexing& indexing = prob_->cost.indexing[i];
+            errors(k) += prob_->cost.ydiff.segment(indexing.start_jacobian, indexing.length_jacobian).dot(rho.segment(indexing.start_jacobian, indexing.length_jacobian).cwiseProduct(prob_->cost.ydiff.segment(indexing.start_jacobian, indexing.length_jacobian)));
+        }
+    }
+}
+
+bool HierarchicalIKSolver::IsLexicographicallySmaller(const Eigen::VectorXd& errors, const Eigen::VectorXd& reference) const
+{
+    for (int k = 0; k < errors.size(); ++k)
+    {
+        if (errors(k) < reference(k) - parameters_.Tolerance) return true;
+        if (errors(k) > reference(k) + parameters_.Tolerance) return false;
+    }
+    return errors.sum() < reference.sum();
+}
+
+bool HierarchicalIKSolver::ComputeStep()
+{
+    // Recursive null-space projection in the coordinates z with qd = L z, where W^-1 = L L^T:
+    //   z_k = z_{k-1} + (J_k L P_{k-1})^# (e_k - J_k L z_{k-1})
+    //   P_k = P_{k-1} - (J_k L P_{k-1})^+ J_k L P_{k-1}
+    // where (.)^# is the damped and (.)^+ the exact pseudo-inverse. A rank-revealing QR decomposition of each projected
+    // level, P_{k-1} L^T J_k^T = Q R Pi^T, provides both: the projector P_k = P_{k-1} - Q_r Q_r^T onto the remaining
+    // null-space and the damped step Q_r (R_r R_r^T + damping I)^-1 R_r Pi^T (e_k - J_k L z_{k-1}), with r the rank of the level.
+    // The projection is exact even for levels that are rank deficient after projection, i.e., the damping of a lower level
+    // cannot disturb the higher levels.
+    const auto rho = prob_->cost.S.diagonal();
+    z_.setZero();
+    null_space_projector_.setIdentity();
+    for (PriorityLevel& level : levels_)
+    {
+        // Tasks whose weights have been set to zero do not constrain the lower levels
+        if (std::all_of(level.tasks.begin(), level.tasks.end(), [this](int i) { return prob_->cost.rho(i) == 0.0; })) continue;
+
+        int row = 0;
+        for (const int i : level.tasks)
+        {
+            const TaskIndexing& indexing = prob_->cost.indexing[i];
+            level.jacobian.middleRows(row, indexing.length_jacobian).noalias() = rho.segment(indexing.start_jacobian, indexing.length_jacobian).asDiagonal() * prob_->cost.jacobian.middleRows(indexing.start_jacobian, indexing.length_jacobian) * W_inv_cholesky_;
+            level.error.segment(row, indexing.length_jacobian) = rho.segment(indexing.start_jacobian, indexing.length_jacobian).cwiseProduct(prob_->cost.ydiff.segment(indexing.start_jacobian, indexing.length_jacobian));
+            row += indexing.length_jacobian;
+        }
+
+        level.projected_jacobian_t.noalias() = null_space_projector_ * level.jacobian.transpose();
+        level.decomposition.compute(level.projected_jacobian_t);
+        const int rank = static_cast<int>(level.decomposition.rank());
+        if (rank == 0) continue;  // The level is fully determined by the higher levels
+
+        level.residual = level.error;
+        level.residual.noalias() -= level.jacobian * z_;
+        level.residual = level.decomposition.colsPermutation().transpose() * level.residual;
+        level.r_factor = level.decomposition.matrixR().topRows(rank).triangularView<Eigen::Upper>();
+        level.system.noalias() = level.r_factor * level.r_factor.transpose();
+        level.system.diagonal().array() += parameters_.Damping;
+        level.system_decomposition.compute(level.system);
+        if (level.system_decomposition.info() != Eigen::Success) return false;
+
+        level.reduced_step.noalias() = level.r_factor * level.residual;
+        level.system_decomposition.solveInPlace(level.reduced_step);
+        level_step_.setZero();
+        level_step_.head(rank) = level.reduced_step;
+        level_step_.applyOnTheLeft(level.decomposition.householderQ());
+        z_ += level_step_;
+
+        level.basis = level.decomposition.householderQ() * Eigen::MatrixXd::Identity(prob_->N, rank);
+        null_space_projector_.noalias() -= level.basis * level.basis.transpose();
+    }
+    qd_.noalias() = W_inv_cholesky_ * z_;
+    return true;
+}
+
+void HierarchicalIKSolver::Solve(Eigen::MatrixXd& solution)
+{
+    EXOTICA_PROFILE_SCOPE("HierarchicalIKSolver::Solve");
+    if (!prob_) ThrowNamed("Solver has not been initialized!");
+
+    Timer timer;
+
+    prob_->ResetCostEvolution(GetNumberOfMaxIterations() + 1);
+    q_ = prob_->ApplyStartState();
+
+    int i;
+    for (i = 0; i < GetNumberOfMaxIterations(); ++i)
+    {
+        prob_->Update(q_);
+        ComputeLevelErrors(level_errors_);
+        prob_->SetCostEvolution(i, prob_->GetScalarCost());
+
+        // Absolute function tolerance check
+        if (prob_->GetScalarCost() < parameters_.Tolerance)
+        {
+            prob_->termination_criterion = TerminationCriterion::FunctionTolerance;
+            break;
+        }
+
+        // Another solver of MotionSolver::SolveMultiStart already found a solution
+        if (IsStopRequested())
+        {
+            prob_->termination_criterion = TerminationCriterion::UserDefined;
+            break;
+        }
+
+        if (!ComputeStep())
+        {
+            WARNING_NAMED("HierarchicalIKSolver", "Cholesky decomposition failed, consider increasing the damping (" << parameters_.Damping << ").");
+            prob_->termination_criterion = TerminationCriterion::Divergence;
+            break;
+        }
+
+        // Support for a maximum step, e.g., when used as real-time, interactive IK
+        const double max_vel = qd_.cwiseAbs().maxCoeff();
+        if (parameters_.MaxStep != 0.0 && max_vel > parameters_.MaxStep) qd_ *= parameters_.MaxStep / max_vel;
+
+        // Line search, the step is accepted if it reduces the errors in the order of their priority
+        bool step_accepted = false;
+        for (int ai = 0; ai < alpha_space_.size(); ++ai)
+        {
+            steplength_ = alpha_space_(ai);
+            q_tmp_ = q_ - steplength_ * qd_;
+            prob_->Update(q_tmp_);
+            ComputeLevelErrors(level_errors_candidate_);
+
+            if (IsLexicographicallySmaller(level_errors_candidate_, level_errors_))
+            {
+                q_ = q_tmp_;
+                qd_ *= steplength_;
+                level_errors_ = level_errors_candidate_;
+                step_accepted = true;
+                break;
+            }
+        }
+
+        // No step reduced the errors of the levels: the hierarchy has converged to a (local) optimum
+        step_ = step_accepted ? qd_.squaredNorm() : 0.0;
+
+        if (debug_) HIGHLIGHT_NAMED("HierarchicalIKSolver", "Iteration " << i << ": level errors " << level_errors_.transpose() << ", step " << step_ << ", step length " << steplength_);
+
+        // Check step tolerance
+        if (step_ < parameters_.StepToleranceConvergenceThreshold)
+        {
+            prob_->termination_criterion = TerminationCriterion::StepTolerance;
+            break;
+        }
+    }
+
+    // Check if we ran out of iterations
+    if (i == GetNumberOfMaxIterations())
+    {
+        prob_->termination_criterion = TerminationCriterion::IterationLimit;
+    }
+
+    solution.resize(1, prob_->N);
+    solution.row(0) = q_.transpose();
+    planning_time_ = timer.GetDuration();
+}
+}  // namespace exotica
@@ -29,6 +29,8 @@
 
 #include <exotica_ik_solver/ik_solver.h>
 
+#include <cmath>
+
 REGISTER_MOTIONSOLVER_TYPE("IKSolver", exotica::IKSolver)
 
 namespace exotica
@@ -42,7 +44,8 @@ void IKSolver::SpecifyProblem(PlanningProblemPtr pointer)
     MotionSolver::SpecifyProblem(pointer);
     prob_ = std::static_pointer_cast<UnconstrainedEndPoseProblem>(pointer);
 
-    W_inv_ = prob_->W.inverse();
+    W_ = prob_->W;
+    W_inv_ = W_.inverse();
 
     // Check dimension of W_ as this is a public member of the problem, and thus, can be edited by error.
     if (W_inv_.rows() != prob_->N || W_inv_.cols() != prob_->N)
@@ -67,12 +70,23 @@ void IKSolver::SpecifyProblem(PlanningProblemPtr pointer)
     qd_.resize(prob_->N);
     yd_.resize(prob_->cost.length_jacobian);
     cost_jacobian_.resize(prob_->cost.length_jacobian, prob_->N);
-    J_pseudo_inverse_.resize(prob_->N, prob_->cost.length_jacobian);
-    J_tmp_.resize(prob_->cost.length_jacobian, prob_->cost.length_jacobian);
+
+    // The damped normal equations are solved in the smaller of task and joint space
+    use_joint_space_normal_equations_ = prob_->cost.length_jacobian > prob_->N;
+    const int normal_equations_size = use_joint_space_normal_equations_ ? prob_->N : prob_->cost.length_jacobian;
+    J_tmp_.resize(normal_equations_size, normal_equations_size);
+    if (use_joint_space_normal_equations_)
+    {
+        JT_times_J_.resize(prob_->N, prob_->N);
+        JT_times_yd_.resize(prob_->N);
+    }
+    J_decomposition_ = Eigen::LLT<Eigen::MatrixXd>(normal_equations_size);
+    normal_equations_rhs_.resize(normal_equations_size);
 }
 
 void IKSolver::Solve(Eigen::MatrixXd& solution)
 {
+    EXOTICA_PROFILE_SCOPE("IKSolver::Solve");
     if (!prob_) ThrowNamed("Solver has not been initialized!");
 
     Timer timer;
@@ -89,8 +103,16 @@ void IKSolver::Solve(Eigen::MatrixXd& solution)
     int i;
     for (i = 0; i < GetNumberOfMaxIterations(); ++i)
     {
-        prob_->Update(q_);
-        error_ = prob_->GetScalarCost();
+        // In joint space, the normal equations are accumulated by the problem directly from the Jacobians of the task maps
+        if (use_joint_space_normal_equations_)
+        {
+            error_ = prob_->UpdateFused(q_, JT_times_yd_, JT_times_J_);
+        }
+        else
+        {
+            prob_->Update(q_);
+            error_ = prob_->GetScalarCost();
+        }
         prob_->SetCostEvolution(i, error_);
         error_prev_ = error_;
 
@@ -101,17 +123,38 @@ void IKSolver::Solve(Eigen::MatrixXd& solution)
             break;
         }
 
-        yd_.noalias() = prob_->cost.S * prob_->cost.ydiff;
-        cost_jacobian_.noalias() = prob_->cost.S * prob_->cost.jacobian;
+        // Another solver of MotionSolver::SolveMultiStart already found a solution
+        if (IsStopRequested())
+        {
+            prob_->termination_criterion = TerminationCriterion::UserDefined;
+            break;
+        }
+
+        if (!use_joint_space_normal_equations_)
+        {
+            yd_ = prob_->cost.S.diagonal().cwiseProduct(prob_->cost.ydiff);
+            cost_jacobian_.noalias() = prob_->cost.S.diagonal().asDiagonal() * prob_->cost.jacobian;
+        }
 
         // Weighted Regularized Pseudo-Inverse
-        //   J_pseudo_inverse_ = W_inv_ * cost_jacobian_.transpose() * ( cost_jacobian_ * W_inv_ * cost_jacobian_.transpose() + lambda_ * I ).inverse();
+        //   qd_ = W_inv_ * cost_jacobian_.transpose() * ( cost_jacobian_ * W_inv_ * cost_jacobian_.transpose() + lambda_ * I )^-1 * yd_
+        // or, equivalently, in joint space (used if there are more task dimensions than joints):
+        //   qd_ = ( cost_jacobian_.transpose() * cost_jacobian_ + lambda_ * W )^-1 * cost_jacobian_.transpose() * yd_
+        // The factorisation is applied to the residual directly, the pseudo-inverse is never formed.
 
         bool decomposition_ok = false;
         while (!decomposition_ok)
         {
-            J_tmp_.noalias() = cost_jacobian_ * W_inv_ * cost_jacobian_.transpose();
-            J_tmp_.diagonal().array() += lambda_;  // Add regularisation
+            if (use_joint_space_normal_equations_)
+            {
+                J_tmp_ = JT_times_J_;
+                J_tmp_.noalias() += lambda_ * W_;  // Add regularisation
+            }
+            else
+            {
+                J_tmp_.noalias() = cost_jacobian_ * W_inv_ * cost_jacobian_.transpose();
+                J_tmp_.diagonal().array() += lambda_;  // Add regularisation
+            }
             J_decomposition_.compute(J_tmp_);
             if (J_decomposition_.info() != Eigen::Success)
             {
@@ -130,10 +173,17 @@ void IKSolver::Solve(Eigen::MatrixXd& solution)
                 decomposition_ok = true;
             }
         }
-        J_tmp_.noalias() = J_decomposition_.solve(Eigen::MatrixXd::Identity(prob_->cost.length_jacobian, prob_->cost.length_jacobian));  // Inverse
-        J_pseudo_inverse_.noalias() = W_inv_ * cost_jacobian_.transpose() * J_tmp_;
-
-        qd_.noalias() = J_pseudo_inverse_ * yd_;
+        if (use_joint_space_normal_equations_)
+        {
+            qd_ = JT_times_yd_;
+            J_decomposition_.solveInPlace(qd_);
+        }
+        else
+        {
+            normal_equations_rhs_ = yd_;
+            J_decomposition_.solveInPlace(normal_equations_rhs_);
+            qd_.noalias() = W_inv_ * (cost_jacobian_.transpose() * normal_equations_rhs_);
+        }
 
         // Support for a maximum step, e.g., when used as real-time, interactive IK
         if (GetNumberOfMaxIterations() == 1 && parameters_.MaxStep != 0.0)
@@ -163,8 +213,8 @@ void IKSolver::Solve(Eigen::MatrixXd& solution)
         // Step tolerance parameter
         step_ = qd_.squaredNorm();
 
-        // Gradient tolerance
-        stop_ = cost_jacobian_.norm();
+        // Gradient tolerance, ||S * J||_F = sqrt(trace(J^T * S^2 * J))
+        stop_ = use_joint_space_normal_equations_ ? std::sqrt(JT_times_J_.trace()) : cost_jacobian_.norm();
 
         // Debug output
         if (debug_) PrintDebug(i);
@@ -224,6 +274,9 @@ void IKSolver::Solve(Eigen::MatrixXd& solution)
             case TerminationCriterion::IterationLimit:
                 HIGHLIGHT_NAMED("IKSolver", "Reached iteration limit.");
                 break;
+            case TerminationCriterion::UserDefined:
+                HIGHLIGHT_NAMED("IKSolver", "Stopped by another solver of the multi-start.");
+                break;
 
             default:
                 break;
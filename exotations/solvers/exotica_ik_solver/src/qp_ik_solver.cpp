@@ -0,0 +1,229 @@
+//
+// Copyright (c) 2018-2020, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <algorithm>
+#include <limits>
+
+#include <exotica_ik_solver/qp_ik_solver.h>
+
+REGISTER_MOTIONSOLVER_TYPE("QPIKSolver", exotica::QPIKSolver)
+
+namespace exotica
+{
+void QPIKSolver::SpecifyProblem(PlanningProblemPtr pointer)
+{
+    bounded_prob_.reset();
+    end_pose_prob_.reset();
+    if (pointer->type() == "exotica::BoundedEndPoseProblem")
+    {
+        bounded_prob_ = std::static_pointer_cast<BoundedEndPoseProblem>(pointer);
+        W_ = bounded_prob_->W;
+        num_equality_ = 0;
+        num_inequality_ = 0;
+        use_bounds_ = true;
+    }
+    else if (pointer->type() == "exotica::EndPoseProblem")
+    {
+        end_pose_prob_ = std::static_pointer_cast<EndPoseProblem>(pointer);
+        W_ = end_pose_prob_->W;
+        num_equality_ = end_pose_prob_->equality.length_jacobian;
+        num_inequality_ = end_pose_prob_->inequality.length_jacobian;
+        use_bounds_ = end_pose_prob_->use_bounds;
+    }
+    else
+    {
+        ThrowNamed("This QPIKSolver can't solve problem of type '" << pointer->type() << "'!");
+    }
+    MotionSolver::SpecifyProblem(pointer);
+
+    // Check dimension of W_ as this is a public member of the problem, and thus, can be edited by error.
+    if (W_.rows() != prob_->N || W_.cols() != prob_->N)
+        ThrowNamed("Size of W incorrect: (" << W_.rows() << ", " << W_.cols() << "), when expected: (" << prob_->N << ", " << prob_->N << ")");
+
+    qp_.max_iterations = parameters_.QPMaxIterations;
+    qp_.absolute_tolerance = parameters_.QPTolerance;
+    qp_.relative_tolerance = parameters_.QPTolerance;
+    qp_.rho = parameters_.QPPenalty;
+    qp_.warm_start = parameters_.WarmStart;
+    qp_.ResetWarmStart();
+
+    // Joint limits and the maximum step are box constraints on every joint
+    const int num_box = (use_bounds_ || parameters_.MaxStep > 0.0) ? prob_->N : 0;
+    const int num_constraints = num_equality_ + num_inequality_ + num_box;
+    q_.resize(prob_->N);
+    qd_.resize(prob_->N);
+    hessian_.resize(prob_->N, prob_->N);
+    gradient_.resize(prob_->N);
+    A_.setZero(num_constraints, prob_->N);
+    A_.bottomRows(num_box).setIdentity();
+    lower_.resize(num_constraints);
+    upper_.resize(num_constraints);
+    lower_.segment(num_equality_, num_inequality_).setConstant(-std::numeric_limits<double>::infinity());
+}
+
+double QPIKSolver::GetScalarCost()
+{
+    return bounded_prob_ ? bounded_prob_->GetScalarCost() : end_pose_prob_->GetScalarCost();
+}
+
+bool QPIKSolver::IsValid()
+{
+    return bounded_prob_ ? bounded_prob_->IsValid() : end_pose_prob_->IsValid();
+}
+
+void QPIKSolver::UpdateQP()
+{
+    const EndPoseTask& cost = bounded_prob_ ? bounded_prob_->cost : end_pose_prob_->cost;
+    if (bounded_prob_)
+    {
+        bounded_prob_->Update(q_);
+    }
+    else
+    {
+        end_pose_prob_->Update(q_);
+    }
+
+    // Gauss-Newton approximation of the cost ydiff^T S ydiff around q_
+    hessian_.noalias() = cost.jacobian.transpose() * cost.S.diagonal().asDiagonal() * cost.jacobian;
+    hessian_.noalias() += parameters_.Damping * W_;
+    gradient_.noalias() = cost.jacobian.transpose() * cost.S.diagonal().cwiseProduct(cost.ydiff);
+
+    // Linearised constraints: equality + J_eq dq = 0 and inequality + J_neq dq <= 0
+    if (num_equality_ > 0)
+    {
+        A_.topRows(num_equality_) = end_pose_prob_->GetEqualityJacobian();
+        upper_.head(num_equality_) = -end_pose_prob_->GetEquality();
+        lower_.head(num_equality_) = upper_.head(num_equality_);
+    }
+    if (num_inequality_ > 0)
+    {
+        A_.middleRows(num_equality_, num_inequality_) = end_pose_prob_->GetInequalityJacobian();
+        upper_.segment(num_equality_, num_inequality_) = -end_pose_prob_->GetInequality();
+    }
+
+    // Box constraints lb - q <= dq <= ub - q intersected with |dq| <= MaxStep
+    const int num_box = A_.rows() - num_equality_ - num_inequality_;
+    if (num_box > 0)
+    {
+        const double max_step = parameters_.MaxStep > 0.0 ? parameters_.MaxStep : std::numeric_limits<double>::infinity();
+        for (int i = 0; i < prob_->N; ++i)
+        {
+            double lower = -max_step, upper = max_step;
+            if (use_bounds_)
+            {
+                lower = std::min(std::max(lower, bounds_(i, 0) - q_(i)), max_step);
+                upper = std::max(std::min(upper, bounds_(i, 1) - q_(i)), -max_step);
+            }
+            lower_(num_equality_ + num_inequality_ + i) = lower;
+            upper_(num_equality_ + num_inequality_ + i) = upper;
+        }
+    }
+}
+
+void QPIKSolver::Solve(Eigen::MatrixXd& solution)
+{
+    EXOTICA_PROFILE_SCOPE("QPIKSolver::Solve");
+    if (!prob_) ThrowNamed("Solver has not been initialized!");
+
+    Timer timer;
+
+    prob_->ResetCostEvolution(GetNumberOfMaxIterations() + 1);
+    q_ = prob_->ApplyStartState();
+    bounds_ = bounded_prob_ ? bounded_prob_->GetBounds() : end_pose_prob_->GetBounds();
+    qp_.warm_start = parameters_.WarmStart;
+    qp_iterations_ = 0;
+
+    int i;
+    for (i = 0; i < GetNumberOfMaxIterations(); ++i)
+    {
+        UpdateQP();
+        const double error = GetScalarCost();
+        prob_->SetCostEvolution(i, error);
+
+        // Absolute function tolerance check, the constraints have to be satisfied as well
+        if (error < parameters_.Tolerance && IsValid())
+        {
+            prob_->termination_criterion = TerminationCriterion::FunctionTolerance;
+            break;
+        }
+
+        // Another solver of MotionSolver::SolveMultiStart already found a solution
+        if (IsStopRequested())
+        {
+            prob_->termination_criterion = TerminationCriterion::UserDefined;
+            break;
+        }
+
+        const bool converged = qp_.Solve(hessian_, gradient_, A_, lower_, upper_);
+        qp_iterations_ += qp_.GetNumberOfIterations();
+        qd_ = qp_.GetSolution();
+        if (!converged)
+        {
+            // The iterate of an unconverged QP may violate the constraints. The step is clamped to the joint limits and the maximum step,
+            // which are box constraints, and the iterates are discarded so that the next step does not start from the unconverged active set.
+            if (debug_) WARNING_NAMED("QPIKSolver", "QP did not converge within " << qp_.GetNumberOfIterations() << " iterations (primal residual " << qp_.GetPrimalResidual() << ", dual residual " << qp_.GetDualResidual() << ").");
+            if (!qd_.allFinite()) qd_.setZero();
+            const int num_box = A_.rows() - num_equality_ - num_inequality_;
+            if (num_box > 0) qd_ = qd_.cwiseMax(lower_.tail(num_box)).cwiseMin(upper_.tail(num_box));
+            qp_.ResetWarmStart();
+        }
+        q_ += qd_;
+
+        const double step = qd_.squaredNorm();
+        if (debug_) HIGHLIGHT_NAMED("QPIKSolver", "Iteration " << i << ": cost " << error << ", step " << step << ", QP iterations " << qp_.GetNumberOfIterations());
+
+        // Check step tolerance
+        if (step < parameters_.StepToleranceConvergenceThreshold)
+        {
+            prob_->termination_criterion = TerminationCriterion::StepTolerance;
+            break;
+        }
+    }
+
+    // Check if we ran out of iterations
+    if (i == GetNumberOfMaxIterations())
+    {
+        prob_->termination_criterion = TerminationCriterion::IterationLimit;
+    }
+
+    // Evaluate the final configuration, e.g., for IsValid and the cost of the solution
+    if (bounded_prob_)
+    {
+        bounded_prob_->Update(q_);
+    }
+    else
+    {
+        end_pose_prob_->Update(q_);
+    }
+
+    solution.resize(1, prob_->N);
+    solution.row(0) = q_.transpose();
+    planning_time_ = timer.GetDuration();
+}
+}  // namespace exotica
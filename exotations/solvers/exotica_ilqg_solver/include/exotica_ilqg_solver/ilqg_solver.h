@@ -61,6 +61,13 @@ private:
     DynamicTimeIndexedShootingProblemPtr prob_;       ///!< Shared pointer to the planning problem.
     DynamicsSolverPtr dynamics_solver_;               ///!< Shared pointer to the dynamics solver.
     std::vector<Eigen::MatrixXd> l_gains_, L_gains_;  ///!< Control gains.
+    TrajectoryLinearization linearization_;           ///!< Derivatives of the dynamics and of the cost along the trajectory.
+
+    // Control noise of the backward pass, allocated once per Solve
+    Eigen::MatrixXd noise_jacobians_;    ///!< Control noise Jacobians C_i of the noise columns i, stacked (NX,NU*NU).
+    Eigen::MatrixXd noise_offsets_;      ///!< Noise offsets c_i = C_i u of the current time step (NX,NU).
+    Eigen::MatrixXd S_noise_jacobians_;  ///!< S C (NX,NU*NU).
+    Eigen::MatrixXd S_noise_offsets_;    ///!< S c (NX,NU).
 
     Eigen::MatrixXd best_ref_x_, best_ref_u_;  ///!< Reference trajectory for feedback control.
 
@@ -48,6 +48,7 @@ void ILQGSolver::SpecifyProblem(PlanningProblemPtr pointer)
 
 void ILQGSolver::BackwardPass()
 {
+    EXOTICA_PROFILE_SCOPE("ILQGSolver::BackwardPass");
     constexpr double min_clamp_ = -1e10;
     constexpr double max_clamp_ = 1e10;
     const int T = prob_->get_T();
@@ -59,25 +60,27 @@ void ILQGSolver::BackwardPass()
     Eigen::MatrixXd big_C_times_big_C = Eigen::MatrixXd::Zero(NU, NU);
     Eigen::MatrixXd little_c_times_little_c = Eigen::MatrixXd::Zero(1, 1);
 
+    // Derivatives of the dynamics and of the cost for all time steps at once
+    prob_->LinearizeTrajectory(prob_->get_X(), prob_->get_U(), linearization_);
+
     // Value function and derivatives at the final timestep
     double s0 = prob_->GetStateCost(T - 1);
-    Eigen::MatrixXd s = prob_->GetStateCostJacobian(T - 1);
-    Eigen::MatrixXd S = prob_->GetStateCostHessian(T - 1);
+    Eigen::MatrixXd s = linearization_.lx[T - 1];
+    Eigen::MatrixXd S = linearization_.lxx[T - 1];
 
     for (int t = T - 2; t > 0; --t)
     {
         // eq. 3
         Eigen::VectorXd x = prob_->get_X(t), u = prob_->get_U(t);
-        dynamics_solver_->ComputeDerivatives(x, u);
-        Eigen::MatrixXd A = dynamics_solver_->get_Fx();
-        Eigen::MatrixXd B = dynamics_solver_->get_Fu();
+        const Eigen::MatrixXd& A = linearization_.fx[t];
+        const Eigen::MatrixXd& B = linearization_.fu[t];
 
         double q0 = dt * (prob_->GetStateCost(t) + prob_->GetControlCost(t));
         // Aliases from the paper used. These are used with different names in e.g. DDPSolver.
-        Eigen::MatrixXd q = dt * prob_->GetStateCostJacobian(t);
-        Eigen::MatrixXd Q = dt * prob_->GetStateCostHessian(t);
-        Eigen::MatrixXd r = dt * prob_->GetControlCostJacobian(t);
-        Eigen::MatrixXd R = dt * prob_->GetControlCostHessian(t);
+        Eigen::MatrixXd q = dt * linearization_.lx[t];
+        Eigen::MatrixXd Q = dt * linearization_.lxx[t];
+        Eigen::MatrixXd r = dt * linearization_.lu[t];
+        Eigen::MatrixXd R = dt * linearization_.luu[t];
         Eigen::MatrixXd P = dt * prob_->GetStateControlCostHessian();
 
         Eigen::MatrixXd g = r + B.transpose() * s;
@@ -86,16 +89,21 @@ void ILQGSolver::BackwardPass()
 
         if (parameters_.IncludeNoiseTerms)
         {
-            Eigen::MatrixXd F = prob_->get_F(t);
+            // With C_i = sqrt(dt) F[i]_u and c_i = sqrt(dt) F[i]_u u, all products of S with the
+            // noise terms of the time step are evaluated in one product each.
             for (int i = 0; i < NU; ++i)
             {
-                Eigen::MatrixXd C = std::sqrt(dt) * prob_->GetControlNoiseJacobian(i);
-                Eigen::VectorXd c = std::sqrt(dt) * F.col(i);
+                noise_offsets_.col(i).noalias() = noise_jacobians_.middleCols(i * NU, NU) * u;
+            }
+            S_noise_jacobians_.noalias() = S * noise_jacobians_;
+            S_noise_offsets_.noalias() = S * noise_offsets_;
 
-                big_C_times_little_c = big_C_times_little_c + C.transpose() * S * c;
-                big_C_times_big_C = big_C_times_big_C + C.transpose() * S * C;
-                little_c_times_little_c = little_c_times_little_c + c.transpose() * S * c;
+            for (int i = 0; i < NU; ++i)
+            {
+                big_C_times_little_c.noalias() += dt * (noise_jacobians_.middleCols(i * NU, NU).transpose() * S_noise_offsets_.col(i));
+                big_C_times_big_C.noalias() += dt * (noise_jacobians_.middleCols(i * NU, NU).transpose() * S_noise_jacobians_.middleCols(i * NU, NU));
             }
+            little_c_times_little_c(0) += dt * noise_offsets_.cwiseProduct(S_noise_offsets_).sum();
 
             g = g + big_C_times_little_c;
             H = H + big_C_times_big_C;
@@ -144,6 +152,7 @@ void ILQGSolver::BackwardPass()
 
 double ILQGSolver::ForwardPass(const double alpha, Eigen::MatrixXdRefConst ref_x, Eigen::MatrixXdRefConst ref_u)
 {
+    EXOTICA_PROFILE_SCOPE("ILQGSolver::ForwardPass");
     double cost = 0;
     const int T = prob_->get_T();
     const Eigen::MatrixXd control_limits = dynamics_solver_->get_control_limits();
@@ -173,6 +182,7 @@ double ILQGSolver::ForwardPass(const double alpha, Eigen::MatrixXdRefConst ref_x
 
 void ILQGSolver::Solve(Eigen::MatrixXd& solution)
 {
+    EXOTICA_PROFILE_SCOPE("ILQGSolver::Solve");
     if (!prob_) ThrowNamed("Solver has not been initialized!");
     Timer planning_timer, backward_pass_timer, line_search_timer;
     // TODO: This is an interesting approach but might give us incorrect results.
@@ -197,6 +207,19 @@ void ILQGSolver::Solve(Eigen::MatrixXd& solution)
     l_gains_.assign(T, Eigen::MatrixXd::Zero(NU, 1));
     L_gains_.assign(T, Eigen::MatrixXd::Zero(NU, NX));
 
+    // The control noise Jacobians do not change along the trajectory
+    if (parameters_.IncludeNoiseTerms)
+    {
+        noise_jacobians_.resize(NX, NU * NU);
+        for (int i = 0; i < NU; ++i)
+        {
+            noise_jacobians_.middleCols(i * NU, NU) = prob_->GetControlNoiseJacobian(i);
+        }
+        noise_offsets_.resize(NX, NU);
+        S_noise_jacobians_.resize(NX, NU * NU);
+        S_noise_offsets_.resize(NX, NU);
+    }
+
     // all of the below are not pointers, since we want to copy over
     //  solutions across iterations
     Eigen::MatrixXd new_U, global_best_U = prob_->get_U();
@@ -306,6 +329,19 @@ void ILQGSolver::Solve(Eigen::MatrixXd& solution)
         prob_->Update(global_best_U.col(t), t);
     }
 
+    // Export the policy of GetFeedbackControl for control threads once an iteration has improved the cost
+    if (best_ref_x_.cols() == T)
+    {
+        std::vector<Eigen::VectorXd> X_ref(T), U_ref(T - 1), k(T - 1);
+        for (int t = 0; t < T; ++t) X_ref[t] = best_ref_x_.col(t);
+        for (int t = 0; t < T - 1; ++t)
+        {
+            U_ref[t] = best_ref_u_.col(t);
+            k[t] = l_gains_[t];
+        }
+        PublishFeedbackPolicy(std::make_shared<const FeedbackPolicy>(dynamics_solver_, std::move(X_ref), std::move(U_ref), std::move(k), std::vector<Eigen::MatrixXd>(L_gains_.begin(), L_gains_.begin() + T - 1)));
+    }
+
     planning_time_ = planning_timer.GetDuration();
 
     // TODO: See note at disable.
@@ -59,6 +59,7 @@ private:
     DynamicTimeIndexedShootingProblemPtr prob_;                              ///!< Shared pointer to the planning problem.
     DynamicsSolverPtr dynamics_solver_;                                      ///!< Shared pointer to the dynamics solver.
     std::vector<Eigen::MatrixXd> K_gains_, Ku_gains_, Kv_gains_, vk_gains_;  ///!< Control gains.
+    TrajectoryLinearization linearization_;                                  ///!< Derivatives of the dynamics along the trajectory.
 
     Eigen::MatrixXd best_ref_x_, best_ref_u_;  ///!< Reference trajectory for feedback control.
 
@@ -46,6 +46,7 @@ void ILQRSolver::SpecifyProblem(PlanningProblemPtr pointer)
 
 void ILQRSolver::BackwardPass()
 {
+    EXOTICA_PROFILE_SCOPE("ILQRSolver::BackwardPass");
     constexpr double min_clamp_ = -1e10;
     constexpr double max_clamp_ = 1e10;
     const int T = prob_->get_T();
@@ -69,12 +70,15 @@ void ILQRSolver::BackwardPass()
         return std::min(std::max(x, min_clamp_), max_clamp_);
     });
 
+    // Derivatives of the state transitions for all time steps at once
+    prob_->LinearizeDynamics(prob_->get_X(), prob_->get_U(), linearization_);
+
     for (int t = T - 2; t >= 0; t--)
     {
         Eigen::VectorXd x = prob_->get_X(t), u = prob_->get_U(t);
-        dynamics_solver_->ComputeDerivatives(x, u);
-        Eigen::MatrixXd Ak = dynamics_solver_->get_Fx(), Bk = dynamics_solver_->get_Fu(),
-                        Q = dt * prob_->get_Q(t);
+        const Eigen::MatrixXd& Ak = linearization_.fx[t];
+        const Eigen::MatrixXd& Bk = linearization_.fu[t];
+        Eigen::MatrixXd Q = dt * prob_->get_Q(t);
 
         // this inverse is common for all factors
         // TODO: use LLT
@@ -101,6 +105,7 @@ void ILQRSolver::BackwardPass()
 
 double ILQRSolver::ForwardPass(const double alpha, Eigen::MatrixXdRefConst ref_x, Eigen::MatrixXdRefConst ref_u)
 {
+    EXOTICA_PROFILE_SCOPE("ILQRSolver::ForwardPass");
     double cost = 0;
     const int T = prob_->get_T();
     const Eigen::MatrixXd control_limits = dynamics_solver_->get_control_limits();
@@ -129,6 +134,7 @@ double ILQRSolver::ForwardPass(const double alpha, Eigen::MatrixXdRefConst ref_x
 
 void ILQRSolver::Solve(Eigen::MatrixXd& solution)
 {
+    EXOTICA_PROFILE_SCOPE("ILQRSolver::Solve");
     if (!prob_) ThrowNamed("Solver has not been initialized!");
     Timer planning_timer, backward_pass_timer, line_search_timer;
 
@@ -302,6 +308,22 @@ void ILQRSolver::Solve(Eigen::MatrixXd& solution)
         prob_->Update(new_U.col(t), t);
     }
 
+    // Export the policy of GetFeedbackControl for control threads once an iteration has improved the cost,
+    // its feed-forward term is -Ku u_ref - Kv v_{t+1}
+    if (best_ref_x_.cols() == T)
+    {
+        std::vector<Eigen::VectorXd> X_ref(T), U_ref(T - 1), k(T - 1);
+        std::vector<Eigen::MatrixXd> K(T - 1);
+        for (int t = 0; t < T; ++t) X_ref[t] = best_ref_x_.col(t);
+        for (int t = 0; t < T - 1; ++t)
+        {
+            U_ref[t] = best_ref_u_.col(t);
+            k[t] = -Ku_gains_[t] * best_ref_u_.col(t) - Kv_gains_[t] * vk_gains_[t + 1];
+            K[t] = -K_gains_[t];
+        }
+        PublishFeedbackPolicy(std::make_shared<const FeedbackPolicy>(dynamics_solver_, std::move(X_ref), std::move(U_ref), std::move(k), std::move(K)));
+    }
+
     planning_time_ = planning_timer.GetDuration();
 }
 
@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_INTERIOR_POINT_SOLVER_INTERIOR_POINT_SOLVER_H_
+#define EXOTICA_INTERIOR_POINT_SOLVER_INTERIOR_POINT_SOLVER_H_
+
+#include <Eigen/SparseCholesky>
+
+#include <exotica_core/motion_solver.h>
+#include <exotica_core/problems/time_indexed_problem.h>
+
+#include <exotica_interior_point_solver/interior_point_solver_initializer.h>
+
+namespace exotica
+{
+///
+/// \brief	Sparse primal-dual interior-point solver for TimeIndexedProblem
+/// Solves min f(x) s.t. c(x) = 0, g(x) <= 0 over the trajectory x = (x_1, ..., x_{T-1}), where c are the equality tasks,
+/// g the inequality tasks, the joint velocity limits (if set) and the joint limits (if UseBounds). The inequalities are
+/// written with slacks, g(x) + s = 0, s >= 0, and the barrier subproblems are solved by damped Newton steps on the
+/// condensed KKT system
+///     [ H + J_g^T Sigma J_g   J_c^T ] [ dx      ]
+///     [ J_c                   0     ] [ dlambda ] = -rhs
+/// with the (Gauss-Newton) Hessian of the cost H = GetCostHessianStructured() and Sigma = Z S^-1. The Jacobians and the
+/// Hessian are taken from the structured sparse getters of the problem, hence the sparsity pattern of the KKT system is
+/// fixed and its symbolic factorisation is reused across iterations. The curvature of the constraints is neglected.
+///
+class InteriorPointSolver : public MotionSolver, public Instantiable<InteriorPointSolverInitializer>
+{
+public:
+    void Solve(Eigen::MatrixXd& solution) override;
+    void SpecifyProblem(PlanningProblemPtr pointer) override;
+
+    /// \brief Number of symbolic factorisations (sparsity pattern analyses) of the KKT system in the last solve
+    int GetNumberOfSymbolicFactorizations() const { return symbolic_factorizations_; }
+
+private:
+    /// \brief Sets up the linear inequalities (joint velocity limits and joint limits) of the current problem
+    void SetUpLinearInequalities(Eigen::VectorXdRefConst q0);
+
+    /// \brief Updates the problem at x and evaluates the cost, the equality and the inequality constraints
+    void Evaluate(Eigen::VectorXdRefConst x);
+
+    /// \brief Evaluates the derivatives of the cost and the constraints at the state of the last call to Evaluate
+    void EvaluateDerivatives();
+
+    /// \brief Merit function: barrier objective plus the l1-norm of the constraint violation weighted by penalty_
+    double GetMerit(Eigen::VectorXdRefConst s) const;
+
+    /// \brief Assembles and factorises the KKT system at the current iterate
+    /// @return Whether a factorisation with the correct inertia was found
+    bool FactorizeKKT();
+
+    TimeIndexedProblemPtr prob_;  ///< Shared pointer to the planning problem.
+
+    int num_variables_ = 0;             ///< Number of optimisation variables, N * (T - 1)
+    int num_equality_ = 0;              ///< Number of equality constraints
+    int num_nonlinear_inequality_ = 0;  ///< Number of inequality constraints of the inequality tasks
+    int num_inequality_ = 0;            ///< Number of all inequality constraints (nonlinear and linear)
+
+    Eigen::SparseMatrix<double> linear_inequality_jacobian_;  ///< Constant Jacobian A of the linear inequalities A x + b <= 0
+    Eigen::VectorXd linear_inequality_offset_;                ///< Offset b of the linear inequalities A x + b <= 0
+
+    // Iterates and steps
+    double mu_ = 0.0;          ///< Barrier parameter
+    double penalty_ = 0.0;     ///< Penalty of the constraint violation in the merit function
+    Eigen::VectorXd x_;        ///< Trajectory
+    Eigen::VectorXd lambda_;   ///< Multipliers of the equality constraints
+    Eigen::VectorXd s_;        ///< Slacks of the inequality constraints
+    Eigen::VectorXd z_;        ///< Multipliers of the inequality constraints
+    Eigen::VectorXd dx_;       ///< Step of x_
+    Eigen::VectorXd dlambda_;  ///< Step of lambda_
+    Eigen::VectorXd ds_;       ///< Step of s_
+    Eigen::VectorXd dz_;       ///< Step of z_
+    Eigen::VectorXd x_trial_;  ///< Line-search candidate of x_
+    Eigen::VectorXd s_trial_;  ///< Line-search candidate of s_
+
+    // Evaluation of the problem at x
+    double cost_ = 0.0;                                ///< Cost f(x)
+    Eigen::RowVectorXd cost_jacobian_;                 ///< Gradient of the cost
+    Eigen::VectorXd equality_;                         ///< Equality constraints c(x)
+    Eigen::VectorXd inequality_;                       ///< Inequality constraints g(x), nonlinear followed by linear
+    Eigen::SparseMatrix<double> equality_jacobian_;    ///< Jacobian of c(x)
+    Eigen::SparseMatrix<double> inequality_jacobian_;  ///< Jacobian of g(x)
+    std::vector<Eigen::Triplet<double>> triplets_;     ///< Triplets used to assemble the sparse matrices
+    Eigen::VectorXd lagrangian_gradient_;              ///< Gradient of the Lagrangian
+
+    // KKT system
+    Eigen::VectorXd sigma_;                                                      ///< Z S^-1
+    Eigen::SparseMatrix<double> weighted_inequality_jacobian_;                   ///< Sigma J_g
+    Eigen::SparseMatrix<double> reduced_hessian_;                                ///< H + J_g^T Sigma J_g
+    Eigen::SparseMatrix<double> kkt_matrix_;                                     ///< Lower triangle of the KKT system
+    std::vector<int> kkt_outer_index_;                                           ///< Sparsity pattern of the last analysed KKT system (outer indices)
+    std::vector<int> kkt_inner_index_;                                           ///< Sparsity pattern of the last analysed KKT system (inner indices)
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>, Eigen::Lower> kkt_ldlt_;  ///< Sparse LDL^T factorisation of the KKT system
+    Eigen::VectorXd kkt_rhs_;                                                    ///< Right-hand side of the KKT system
+    Eigen::VectorXd kkt_solution_;                                               ///< Solution of the KKT system
+    int symbolic_factorizations_ = 0;                                            ///< Number of pattern analyses in the last solve
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_INTERIOR_POINT_SOLVER_INTERIOR_POINT_SOLVER_H_
@@ -0,0 +1,341 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <exotica_interior_point_solver/interior_point_solver.h>
+
+REGISTER_MOTIONSOLVER_TYPE("InteriorPointSolver", exotica::InteriorPointSolver)
+
+namespace exotica
+{
+void InteriorPointSolver::SpecifyProblem(PlanningProblemPtr pointer)
+{
+    if (pointer->type() != "exotica::TimeIndexedProblem")
+    {
+        ThrowNamed("This InteriorPointSolver can't solve problem of type '" << pointer->type() << "'!");
+    }
+    MotionSolver::SpecifyProblem(pointer);
+    prob_ = std::static_pointer_cast<TimeIndexedProblem>(pointer);
+}
+
+void InteriorPointSolver::SetUpLinearInequalities(Eigen::VectorXdRefConst q0)
+{
+    const int N = prob_->N;
+    const int T = prob_->GetT();
+    std::vector<Eigen::Triplet<double>> entries;
+    std::vector<double> offsets;
+
+    // Joint velocity limits lb <= D x <= ub as D x - ub <= 0 and lb - D x <= 0
+    if (prob_->GetJointVelocityLimits().maxCoeff() > 0.0)
+    {
+        const int dimension = prob_->get_joint_velocity_constraint_dimension();
+        Eigen::MatrixXd bounds = prob_->GetJointVelocityConstraintBounds();
+        // The bounds of the first time step contain x_0 of the initial trajectory, which may differ from the start state
+        bounds.topRows(N).colwise() += q0 - prob_->GetInitialTrajectory()[0];
+        for (const Eigen::Triplet<double>& entry : prob_->GetJointVelocityConstraintJacobianTriplets())
+        {
+            entries.emplace_back(entry.row(), entry.col(), entry.value());
+            entries.emplace_back(dimension + entry.row(), entry.col(), -entry.value());
+        }
+        for (int i = 0; i < dimension; ++i) offsets.push_back(-bounds(i, 1));
+        for (int i = 0; i < dimension; ++i) offsets.push_back(bounds(i, 0));
+    }
+
+    // Joint limits lb <= x <= ub, joints without finite limits are skipped
+    if (prob_->use_bounds)
+    {
+        const Eigen::MatrixXd bounds = prob_->GetBounds();
+        for (int t = 1; t < T; ++t)
+        {
+            for (int j = 0; j < N; ++j)
+            {
+                const int column = (t - 1) * N + j;
+                if (std::isfinite(bounds(j, 1)))
+                {
+                    entries.emplace_back(offsets.size(), column, 1.0);
+                    offsets.push_back(-bounds(j, 1));
+                }
+                if (std::isfinite(bounds(j, 0)))
+                {
+                    entries.emplace_back(offsets.size(), column, -1.0);
+                    offsets.push_back(bounds(j, 0));
+                }
+            }
+        }
+    }
+
+    linear_inequality_jacobian_.resize(offsets.size(), num_variables_);
+    linear_inequality_jacobian_.setFromTriplets(entries.begin(), entries.end());
+    linear_inequality_offset_ = Eigen::Map<const Eigen::VectorXd>(offsets.data(), offsets.size());
+}
+
+void InteriorPointSolver::Evaluate(Eigen::VectorXdRefConst x)
+{
+    prob_->Update(x);
+    cost_ = prob_->GetCost();
+    equality_ = prob_->GetEquality();
+    inequality_.head(num_nonlinear_inequality_) = prob_->GetInequality();
+    inequality_.tail(linear_inequality_offset_.size()) = linear_inequality_offset_;
+    inequality_.tail(linear_inequality_offset_.size()).noalias() += linear_inequality_jacobian_ * x;
+}
+
+void InteriorPointSolver::EvaluateDerivatives()
+{
+    prob_->GetCostJacobian(cost_jacobian_);
+    equality_jacobian_ = prob_->GetEqualityJacobianStructured();
+
+    // The Jacobian of the inequalities stacks the nonlinear and the constant linear part, both with a fixed pattern
+    const Eigen::SparseMatrix<double>& nonlinear_jacobian = prob_->GetInequalityJacobianStructured();
+    triplets_.clear();
+    for (int k = 0; k < nonlinear_jacobian.outerSize(); ++k)
+        for (Eigen::SparseMatrix<double>::InnerIterator it(nonlinear_jacobian, k); it; ++it)
+            triplets_.emplace_back(it.row(), it.col(), it.value());
+    for (int k = 0; k < linear_inequality_jacobian_.outerSize(); ++k)
+        for (Eigen::SparseMatrix<double>::InnerIterator it(linear_inequality_jacobian_, k); it; ++it)
+            triplets_.emplace_back(num_nonlinear_inequality_ + it.row(), it.col(), it.value());
+    inequality_jacobian_.resize(num_inequality_, num_variables_);
+    inequality_jacobian_.setFromTriplets(triplets_.begin(), triplets_.end());
+}
+
+double InteriorPointSolver::GetMerit(Eigen::VectorXdRefConst s) const
+{
+    return cost_ - mu_ * s.array().log().sum() + penalty_ * (equality_.lpNorm<1>() + (inequality_ + s).lpNorm<1>());
+}
+
+bool InteriorPointSolver::FactorizeKKT()
+{
+    const int n = num_variables_;
+    const int m = num_equality_;
+
+    reduced_hessian_ = prob_->GetCostHessianStructured();
+    if (num_inequality_ > 0)
+    {
+        weighted_inequality_jacobian_ = sigma_.asDiagonal() * inequality_jacobian_;
+        reduced_hessian_ = reduced_hessian_ + Eigen::SparseMatrix<double>(inequality_jacobian_.transpose() * weighted_inequality_jacobian_);
+    }
+
+    // The regularisation is increased until the factorisation has the inertia (n, m, 0) of a strictly convex subproblem
+    double regularization = parameters_.Regularization;
+    for (int attempt = 0; attempt < 10; ++attempt)
+    {
+        triplets_.clear();
+        for (int k = 0; k < reduced_hessian_.outerSize(); ++k)
+            for (Eigen::SparseMatrix<double>::InnerIterator it(reduced_hessian_, k); it; ++it)
+                if (it.row() >= it.col()) triplets_.emplace_back(it.row(), it.col(), it.value());
+        for (int i = 0; i < n; ++i) triplets_.emplace_back(i, i, regularization);
+        for (int k = 0; k < equality_jacobian_.outerSize(); ++k)
+            for (Eigen::SparseMatrix<double>::InnerIterator it(equality_jacobian_, k); it; ++it)
+                triplets_.emplace_back(n + it.row(), it.col(), it.value());
+        for (int i = 0; i < m; ++i) triplets_.emplace_back(n + i, n + i, -parameters_.Regularization);
+        kkt_matrix_.resize(n + m, n + m);
+        kkt_matrix_.setFromTriplets(triplets_.begin(), triplets_.end());
+
+        // The symbolic factorisation is only recomputed if the sparsity pattern changed
+        const int* outer = kkt_matrix_.outerIndexPtr();
+        const int* inner = kkt_matrix_.innerIndexPtr();
+        if (kkt_outer_index_.size() != static_cast<std::size_t>(n + m + 1) || kkt_inner_index_.size() != static_cast<std::size_t>(kkt_matrix_.nonZeros()) ||
+            !std::equal(kkt_outer_index_.begin(), kkt_outer_index_.end(), outer) || !std::equal(kkt_inner_index_.begin(), kkt_inner_index_.end(), inner))
+        {
+            kkt_ldlt_.analyzePattern(kkt_matrix_);
+            kkt_outer_index_.assign(outer, outer + n + m + 1);
+            kkt_inner_index_.assign(inner, inner + kkt_matrix_.nonZeros());
+            ++symbolic_factorizations_;
+        }
+        kkt_ldlt_.factorize(kkt_matrix_);
+        if (kkt_ldlt_.info() == Eigen::Success && (kkt_ldlt_.vectorD().array() > 0.0).count() == n && (kkt_ldlt_.vectorD().array() < 0.0).count() == m) return true;
+
+        regularization = regularization < 1e-4 ? 1e-4 : 10.0 * regularization;
+        if (debug_) HIGHLIGHT_NAMED("InteriorPointSolver", "Wrong inertia of the KKT system, increasing the regularisation to " << regularization);
+    }
+    return false;
+}
+
+void InteriorPointSolver::Solve(Eigen::MatrixXd& solution)
+{
+    EXOTICA_PROFILE_SCOPE("InteriorPointSolver::Solve");
+    if (!prob_) ThrowNamed("Solver has not been initialized!");
+
+    Timer timer;
+    prob_->PreUpdate();
+    prob_->ResetCostEvolution(GetNumberOfMaxIterations() + 1);
+    prob_->termination_criterion = TerminationCriterion::NotStarted;
+
+    const int N = prob_->N;
+    const int T = prob_->GetT();
+    if (T < 2) ThrowNamed("Problem has not been initialized properly: T=" << T << "!");
+
+    // If the initial trajectory does not start at the start state, it is not used as initial guess
+    const Eigen::VectorXd q0 = prob_->ApplyStartState();
+    std::vector<Eigen::VectorXd> q_init = prob_->GetInitialTrajectory();
+    if (!q0.isApprox(q_init[0])) q_init.assign(T, q0);
+
+    num_variables_ = N * (T - 1);
+    x_.resize(num_variables_);
+    for (int t = 1; t < T; ++t) x_.segment((t - 1) * N, N) = q_init[t];
+
+    SetUpLinearInequalities(q0);
+    num_equality_ = prob_->get_active_nonlinear_equality_constraints_dimension();
+    num_nonlinear_inequality_ = prob_->get_active_nonlinear_inequality_constraints_dimension();
+    num_inequality_ = num_nonlinear_inequality_ + linear_inequality_offset_.size();
+    cost_jacobian_.resize(num_variables_);
+    inequality_.resize(num_inequality_);
+    kkt_rhs_.resize(num_variables_ + num_equality_);
+    symbolic_factorizations_ = 0;
+
+    Evaluate(x_);
+    EvaluateDerivatives();
+
+    // Slacks are initialised away from the boundary, the multipliers on the central path of the initial barrier parameter
+    mu_ = parameters_.InitialBarrier;
+    penalty_ = 1.0;
+    lambda_.setZero(num_equality_);
+    s_ = (-inequality_).cwiseMax(1e-2);
+    z_ = mu_ * s_.cwiseInverse();
+
+    const double tau = parameters_.FractionToBoundary;
+    int i;
+    for (i = 0; i < GetNumberOfMaxIterations(); ++i)
+    {
+        prob_->SetCostEvolution(i, cost_);
+
+        // Optimality conditions of the original problem
+        lagrangian_gradient_ = cost_jacobian_.transpose();
+        if (num_equality_ > 0) lagrangian_gradient_.noalias() += equality_jacobian_.transpose() * lambda_;
+        if (num_inequality_ > 0) lagrangian_gradient_.noalias() += inequality_jacobian_.transpose() * z_;
+        const double complementarity = num_inequality_ > 0 ? s_.dot(z_) / num_inequality_ : 0.0;
+        const double equality_violation = num_equality_ > 0 ? equality_.lpNorm<Eigen::Infinity>() : 0.0;
+        const double inequality_violation = num_inequality_ > 0 ? std::max(inequality_.maxCoeff(), 0.0) : 0.0;
+        const double constraint_violation = std::max(equality_violation, inequality_violation);
+        // Large multipliers scale the stationarity tolerance (as in IPOPT)
+        const double multiplier_scaling = std::max(1.0, (lambda_.lpNorm<1>() + z_.lpNorm<1>()) / std::max(1, num_equality_ + num_inequality_) / 100.0);
+        const double stationarity = lagrangian_gradient_.lpNorm<Eigen::Infinity>() / multiplier_scaling;
+
+        if (debug_) HIGHLIGHT_NAMED("InteriorPointSolver", "Iteration " << i << ": cost " << cost_ << ", stationarity " << stationarity << ", constraint violation " << constraint_violation << ", complementarity " << complementarity << ", mu " << mu_);
+
+        if (stationarity <= parameters_.Tolerance && constraint_violation <= parameters_.ConstraintTolerance && complementarity <= parameters_.Tolerance)
+        {
+            prob_->termination_criterion = TerminationCriterion::Convergence;
+            break;
+        }
+
+        // Another solver of MotionSolver::SolveMultiStart already found a solution
+        if (IsStopRequested())
+        {
+            prob_->termination_criterion = TerminationCriterion::UserDefined;
+            break;
+        }
+
+        // Barrier parameter of this iteration
+        if (num_inequality_ > 0) mu_ = std::max(parameters_.BarrierReduction * complementarity, 0.1 * parameters_.Tolerance);
+        sigma_ = z_.cwiseQuotient(s_);
+
+        if (!FactorizeKKT())
+        {
+            WARNING_NAMED("InteriorPointSolver", "Factorisation of the KKT system failed.");
+            prob_->termination_criterion = TerminationCriterion::Divergence;
+            break;
+        }
+
+        // Condensed Newton step: the slack and the inequality multiplier steps are eliminated
+        //   ds = -(g + s) - J_g dx
+        //   dz = Sigma (J_g dx + g + s) - z + mu S^-1 e
+        ds_ = -(inequality_ + s_);  // -(g + s), completed below
+        kkt_rhs_.head(num_variables_) = -lagrangian_gradient_;
+        if (num_inequality_ > 0) kkt_rhs_.head(num_variables_).noalias() -= inequality_jacobian_.transpose() * (-sigma_.cwiseProduct(ds_) - z_ + mu_ * s_.cwiseInverse());
+        kkt_rhs_.tail(num_equality_) = -equality_;
+        kkt_solution_ = kkt_ldlt_.solve(kkt_rhs_);
+        dx_ = kkt_solution_.head(num_variables_);
+        dlambda_ = kkt_solution_.tail(num_equality_);
+        if (num_inequality_ > 0) ds_.noalias() -= inequality_jacobian_ * dx_;
+        dz_ = -sigma_.cwiseProduct(ds_) - z_ + mu_ * s_.cwiseInverse();
+
+        // Fraction-to-boundary rule keeps the slacks and the multipliers strictly positive
+        double alpha_primal = 1.0, alpha_dual = 1.0;
+        for (int j = 0; j < num_inequality_; ++j)
+        {
+            if (ds_(j) < 0.0) alpha_primal = std::min(alpha_primal, -tau * s_(j) / ds_(j));
+            if (dz_(j) < 0.0) alpha_dual = std::min(alpha_dual, -tau * z_(j) / dz_(j));
+        }
+
+        // Backtracking line-search on the l1 merit function
+        double multiplier_norm = 0.0;
+        if (num_equality_ > 0) multiplier_norm = (lambda_ + dlambda_).lpNorm<Eigen::Infinity>();
+        if (num_inequality_ > 0) multiplier_norm = std::max(multiplier_norm, (z_ + alpha_dual * dz_).lpNorm<Eigen::Infinity>());
+        penalty_ = std::max(penalty_, 1.1 * multiplier_norm);
+        const double merit = GetMerit(s_);
+        const double directional_derivative = cost_jacobian_.dot(dx_) - mu_ * ds_.cwiseQuotient(s_).sum() - penalty_ * (equality_.lpNorm<1>() + (inequality_ + s_).lpNorm<1>());
+
+        double alpha = alpha_primal;
+        bool step_accepted = false;
+        for (int k = 0; k <= parameters_.MaxBacktrackIterations; ++k, alpha *= 0.5)
+        {
+            x_trial_ = x_ + alpha * dx_;
+            s_trial_ = s_ + alpha * ds_;
+            Evaluate(x_trial_);
+            if (GetMerit(s_trial_) <= merit + 1e-4 * alpha * std::min(directional_derivative, 0.0))
+            {
+                step_accepted = true;
+                break;
+            }
+        }
+        if (!step_accepted)
+        {
+            if (debug_) HIGHLIGHT_NAMED("InteriorPointSolver", "Line-search failed after " << parameters_.MaxBacktrackIterations << " backtracking steps.");
+            Evaluate(x_);
+            prob_->termination_criterion = TerminationCriterion::BacktrackIterationLimit;
+            break;
+        }
+
+        x_ = x_trial_;
+        s_ = s_trial_;
+        lambda_ += alpha * dlambda_;
+        z_ += alpha_dual * dz_;
+
+        // The multipliers may not drift too far from the central path (kappa_Sigma safeguard of IPOPT)
+        constexpr double kappa = 1e10;
+        for (int j = 0; j < num_inequality_; ++j) z_(j) = std::min(std::max(z_(j), mu_ / (kappa * s_(j))), kappa * mu_ / s_(j));
+
+        EvaluateDerivatives();
+    }
+
+    // Check if we ran out of iterations
+    if (i == GetNumberOfMaxIterations())
+    {
+        prob_->termination_criterion = TerminationCriterion::IterationLimit;
+    }
+
+    solution.resize(T, N);
+    solution.row(0) = q0.transpose();
+    for (int t = 1; t < T; ++t) solution.row(t) = x_.segment((t - 1) * N, N).transpose();
+    planning_time_ = timer.GetDuration();
+}
+}  // namespace exotica
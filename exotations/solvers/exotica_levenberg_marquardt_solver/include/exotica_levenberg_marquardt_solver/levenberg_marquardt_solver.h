@@ -26,6 +26,9 @@
 #include <exotica_core/motion_solver.h>
 #include <exotica_core/problems/unconstrained_end_pose_problem.h>
 
+#include <Eigen/SparseCholesky>
+#include <vector>
+
 #include <exotica_levenberg_marquardt_solver/levenberg_marquardt_solver_initializer.h>
 
 namespace exotica
@@ -37,7 +40,28 @@ public:
 
     void SpecifyProblem(PlanningProblemPtr pointer) override;
 
+    /// \brief Number of iterations of the last solve in which the Jacobian was evaluated by the problem
+    int GetNumberOfJacobianEvaluations() const { return jacobian_evaluations_; }
+
 private:
+    /// \brief Broyden rank-one update of cost_jacobian_ from the step q_ - q_prev_ and the change of the residual yd_ - yd_prev_.
+    /// Updates JT_times_J_ and, if the damping did not change, the Cholesky factorisation llt_ by rank updates.
+    /// @return Whether llt_ holds the factorisation of the updated JT_times_J_
+    bool BroydenUpdate(bool update_factorisation);
+
+    /// \brief Sets the structural non-zeros of the cost Jacobian from the cost task maps: the rows of task maps that only depend on their
+    /// kinematic frames are non-zero in the columns of the joints moving these frames, other task maps (e.g., of joint space quantities
+    /// or querying the scene) may depend on all joints.
+    void InitializeSparseJacobianPattern();
+
+    /// \brief Creates sparse_jacobian_ with the structural non-zeros of jacobian_pattern_.
+    void SetSparseJacobianPattern();
+
+    /// \brief Computes the step qd_ from the sparse normal equations (J^T * J + lambda * M) qd = J^T * yd (SparseNormalEquations).
+    /// J^T * J is only formed again if the Jacobian changed, and the symbolic analysis of sparse_llt_ is only repeated if its sparsity
+    /// pattern changed, i.e., if the Jacobian had non-zeros outside jacobian_pattern_.
+    void SolveSparseNormalEquations();
+
     UnconstrainedEndPoseProblemPtr prob_;  ///< Shared pointer to the planning problem.
 
     // Pre-allocation of variables used during optimisation
@@ -51,6 +75,27 @@ private:
     double error_;                     ///< Error, used during optimisation
     double error_prev_;                ///< Previous iteration error, used during optimisation
     Eigen::LLT<Eigen::MatrixXd> llt_;  ///< Cholesky decomposition for J^T*J
+
+    // Quasi-Newton (Broyden) mode
+    int jacobian_evaluations_ = 0;   ///< Number of Jacobian evaluations of the last solve
+    Eigen::VectorXd q_prev_;         ///< Joint configuration of the previous iteration
+    Eigen::VectorXd yd_prev_;        ///< Task space error of the previous iteration
+    Eigen::VectorXd broyden_step_;   ///< Step of the previous iteration, q_ - q_prev_
+    Eigen::VectorXd broyden_u_;      ///< Task space part of the rank-one update of the Jacobian
+    Eigen::VectorXd broyden_a_;      ///< J^T broyden_u_, used for the rank updates of J^T*J
+    Eigen::VectorXd broyden_plus_;   ///< Positive rank-one term of the update of J^T*J
+    Eigen::VectorXd broyden_minus_;  ///< Negative rank-one term of the update of J^T*J
+
+    // Sparse normal equations
+    Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> jacobian_pattern_;  ///< Structural non-zeros of cost_jacobian_
+    Eigen::SparseMatrix<double> sparse_jacobian_;                           ///< cost_jacobian_ at the structural non-zeros
+    bool sparse_jacobian_changed_ = true;                                   ///< Whether sparse_jacobian_ changed since J^T * J was formed
+    Eigen::SparseMatrix<double> sparse_JT_times_J_;                         ///< J^T * J
+    Eigen::SparseMatrix<double> sparse_normal_matrix_;                      ///< J^T * J + lambda * M, including the whole diagonal
+    Eigen::SparseMatrix<double> sparse_damping_;                            ///< lambda * M as a sparse diagonal matrix
+    Eigen::SimplicialLLT<Eigen::SparseMatrix<double>> sparse_llt_;          ///< Sparse Cholesky decomposition of sparse_normal_matrix_
+    std::vector<int> analysed_outer_, analysed_inner_;                      ///< Sparsity pattern of the last symbolic analysis of sparse_llt_
+    Eigen::VectorXd JT_times_yd_;                                           ///< Right-hand side J^T * yd of the normal equations
 };
 }  // namespace exotica
 
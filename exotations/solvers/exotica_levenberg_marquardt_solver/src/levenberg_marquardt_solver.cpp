@@ -20,6 +20,9 @@
 // SOFTWARE.
 //
 
+#include <algorithm>
+#include <cmath>
+
 #include "exotica_levenberg_marquardt_solver/levenberg_marquardt_solver.h"
 
 REGISTER_MOTIONSOLVER_TYPE("LevenbergMarquardtSolverSolver", exotica::LevenbergMarquardtSolver)
@@ -53,6 +56,22 @@ void LevenbergMarquardtSolver::SpecifyProblem(PlanningProblemPtr pointer)
     qd_.resize(prob_->N);
     yd_.resize(prob_->cost.S.rows());
     cost_jacobian_.resize(prob_->cost.S.rows(), prob_->N);
+    q_prev_.resize(prob_->N);
+    yd_prev_.resize(prob_->cost.S.rows());
+    broyden_step_.resize(prob_->N);
+    broyden_u_.resize(prob_->cost.S.rows());
+    broyden_a_.resize(prob_->N);
+    broyden_plus_.resize(prob_->N);
+    broyden_minus_.resize(prob_->N);
+
+    if (parameters_.BroydenUpdates < 0) ThrowNamed("BroydenUpdates has to be non-negative, given: " << parameters_.BroydenUpdates);
+    if (parameters_.SparseNormalEquations && parameters_.BroydenUpdates > 0) ThrowNamed("SparseNormalEquations can't be combined with BroydenUpdates: the Broyden updates make the Jacobian dense");
+
+    sparse_damping_.resize(prob_->N, prob_->N);
+    sparse_damping_.setIdentity();
+    analysed_outer_.clear();
+    analysed_inner_.clear();
+    JT_times_yd_.resize(prob_->N);
 
     if (parameters_.ScaleProblem == "none")
     {
@@ -68,8 +87,147 @@ void LevenbergMarquardtSolver::SpecifyProblem(PlanningProblemPtr pointer)
     }
 }
 
+bool LevenbergMarquardtSolver::BroydenUpdate(bool update_factorisation)
+{
+    // Broyden's update J += u dq^T with u = (dyd - J dq) / (dq^T dq) is the least change of J which satisfies the secant
+    // condition J dq = dyd.
+    broyden_step_ = q_ - q_prev_;
+    const double step_squared_norm = broyden_step_.squaredNorm();
+    if (step_squared_norm == 0.0) return update_factorisation;
+
+    broyden_u_ = yd_ - yd_prev_;
+    broyden_u_.noalias() -= cost_jacobian_ * broyden_step_;
+    broyden_u_ /= step_squared_norm;
+
+    if (update_factorisation)
+    {
+        // J^T J changes by a dq^T + dq a^T + (u^T u) dq dq^T, a = J^T u, which is written as the difference of the two
+        // rank-one terms p p^T - m m^T with p, m = (a' / s +- s dq) / sqrt(2), a' = a + 0.5 (u^T u) dq and s^2 = |a'| / |dq|.
+        broyden_a_.noalias() = cost_jacobian_.transpose() * broyden_u_;
+        broyden_a_ += (0.5 * broyden_u_.squaredNorm()) * broyden_step_;
+        const double a_norm = broyden_a_.norm();
+        if (a_norm > 0.0)
+        {
+            const double scale = std::sqrt(a_norm / std::sqrt(step_squared_norm));
+            broyden_plus_ = (broyden_a_ / scale + scale * broyden_step_) / std::sqrt(2.0);
+            broyden_minus_ = (broyden_a_ / scale - scale * broyden_step_) / std::sqrt(2.0);
+            JT_times_J_.noalias() += broyden_plus_ * broyden_plus_.transpose();
+            JT_times_J_.noalias() -= broyden_minus_ * broyden_minus_.transpose();
+            llt_.rankUpdate(broyden_plus_, 1.0);
+            llt_.rankUpdate(broyden_minus_, -1.0);
+        }
+    }
+
+    cost_jacobian_.noalias() += broyden_u_ * broyden_step_.transpose();
+    return update_factorisation && llt_.info() == Eigen::Success;
+}
+
+void LevenbergMarquardtSolver::InitializeSparseJacobianPattern()
+{
+    jacobian_pattern_.setConstant(prob_->cost.length_jacobian, prob_->N, false);
+    for (int i = 0; i < prob_->cost.num_tasks; ++i)
+    {
+        const TaskMapPtr& task = prob_->cost.tasks[i];
+        auto rows = jacobian_pattern_.middleRows(prob_->cost.indexing[i].start_jacobian, prob_->cost.indexing[i].length_jacobian);
+        if (task->UsesSceneState() || task->GetFrames().empty())
+        {
+            rows.setConstant(true);
+            continue;
+        }
+        for (const KinematicSolution& kinematics : task->kinematics)
+        {
+            if (kinematics.frame == nullptr) continue;
+            for (int j = 0; j < kinematics.length; ++j)
+            {
+                for (const int column : kinematics.frame[j].jacobian_columns) rows.col(column).setConstant(true);
+            }
+        }
+    }
+    SetSparseJacobianPattern();
+}
+
+void LevenbergMarquardtSolver::SetSparseJacobianPattern()
+{
+    std::vector<Eigen::Triplet<double>> triplets;
+    triplets.reserve(jacobian_pattern_.count());
+    for (int c = 0; c < jacobian_pattern_.cols(); ++c)
+    {
+        for (int r = 0; r < jacobian_pattern_.rows(); ++r)
+        {
+            if (jacobian_pattern_(r, c)) triplets.emplace_back(r, c, 0.0);
+        }
+    }
+    sparse_jacobian_.resize(jacobian_pattern_.rows(), jacobian_pattern_.cols());
+    sparse_jacobian_.setFromTriplets(triplets.begin(), triplets.end());
+    sparse_jacobian_.makeCompressed();
+    sparse_jacobian_changed_ = true;
+}
+
+void LevenbergMarquardtSolver::SolveSparseNormalEquations()
+{
+    // Task maps may depend on more joints than those moving their kinematic frames, the pattern then grows
+    if (((cost_jacobian_.array() != 0.0) && !jacobian_pattern_.array()).any())
+    {
+        jacobian_pattern_ = jacobian_pattern_.array() || (cost_jacobian_.array() != 0.0);
+        SetSparseJacobianPattern();
+        if (debug_) HIGHLIGHT_NAMED("Levenberg-Marquardt", "Jacobian has non-zeros outside of the kinematic chains of its tasks, " << jacobian_pattern_.count() << " structural non-zeros");
+    }
+
+    for (int k = 0; k < sparse_jacobian_.outerSize(); ++k)
+    {
+        for (Eigen::SparseMatrix<double>::InnerIterator it(sparse_jacobian_, k); it; ++it)
+        {
+            const double value = cost_jacobian_(it.row(), it.col());
+            if (it.value() != value)
+            {
+                it.valueRef() = value;
+                sparse_jacobian_changed_ = true;
+            }
+        }
+    }
+
+    // J^T * J keeps the structural non-zeros of J, its pattern only changes with the pattern of J
+    if (sparse_jacobian_changed_)
+    {
+        sparse_JT_times_J_ = sparse_jacobian_.transpose() * sparse_jacobian_;
+        if (parameters_.ScaleProblem == "Jacobian")
+        {
+            M_.diagonal() = sparse_JT_times_J_.diagonal();
+        }
+        sparse_jacobian_changed_ = false;
+    }
+
+    // lambda * M is stored on the whole diagonal, also when it is zero, so that the pattern does not depend on the damping
+    Eigen::Map<Eigen::VectorXd>(sparse_damping_.valuePtr(), prob_->N) = lambda_ * M_.diagonal();
+    sparse_normal_matrix_ = sparse_JT_times_J_ + sparse_damping_;
+    sparse_normal_matrix_.makeCompressed();
+
+    const int nnz = static_cast<int>(sparse_normal_matrix_.nonZeros());
+    const bool pattern_changed = analysed_inner_.size() != static_cast<std::size_t>(nnz) ||
+                                 !std::equal(analysed_outer_.begin(), analysed_outer_.end(), sparse_normal_matrix_.outerIndexPtr()) ||
+                                 !std::equal(analysed_inner_.begin(), analysed_inner_.end(), sparse_normal_matrix_.innerIndexPtr());
+    if (pattern_changed)
+    {
+        sparse_llt_.analyzePattern(sparse_normal_matrix_);
+        analysed_outer_.assign(sparse_normal_matrix_.outerIndexPtr(), sparse_normal_matrix_.outerIndexPtr() + prob_->N + 1);
+        analysed_inner_.assign(sparse_normal_matrix_.innerIndexPtr(), sparse_normal_matrix_.innerIndexPtr() + nnz);
+        if (debug_) HIGHLIGHT_NAMED("Levenberg-Marquardt", "Symbolic analysis of J^T * J with " << nnz << " non-zeros");
+    }
+
+    sparse_llt_.factorize(sparse_normal_matrix_);
+    if (sparse_llt_.info() != Eigen::Success)
+    {
+        ThrowPretty("Error during sparse matrix decomposition of J^T * J (lambda=" << lambda_ << "):\n"
+                                                                                   << Eigen::MatrixXd(sparse_normal_matrix_));
+    }
+
+    JT_times_yd_.noalias() = sparse_jacobian_.transpose() * yd_;
+    qd_ = sparse_llt_.solve(JT_times_yd_);
+}
+
 void LevenbergMarquardtSolver::Solve(Eigen::MatrixXd& solution)
 {
+    EXOTICA_PROFILE_SCOPE("LevenbergMarquardtSolver::Solve");
     if (!prob_) ThrowNamed("Solver has not been initialized!");
 
     prob_->ResetCostEvolution(GetNumberOfMaxIterations() + 1);
@@ -81,19 +239,66 @@ void LevenbergMarquardtSolver::Solve(Eigen::MatrixXd& solution)
     solution.resize(1, prob_->N);
 
     lambda_ = parameters_.Damping;  // Reset initial damping
+    jacobian_evaluations_ = 0;
+    int broyden_updates = 0;          // Broyden updates since the last evaluation of the Jacobian
+    bool factorisation_valid = false;  // Whether llt_ holds the factorisation of the current J^T * J + lambda * M
+    double lambda_factorised = lambda_;
+
+    // The dense normal equations without Broyden updates are accumulated by the problem directly from the Jacobians of the task maps,
+    // the sparse normal equations and the Broyden updates need the Jacobian itself
+    const bool fused_update = parameters_.BroydenUpdates == 0 && !parameters_.SparseNormalEquations;
     for (int i = 0; i < GetNumberOfMaxIterations(); ++i)
     {
-        prob_->Update(q_);
-
-        yd_.noalias() = prob_->cost.S * prob_->cost.ydiff;
+        // In the quasi-Newton mode, the Jacobian is only evaluated every BroydenUpdates iterations
+        bool evaluate_jacobian = parameters_.BroydenUpdates == 0 || i == 0 || broyden_updates >= parameters_.BroydenUpdates;
 
         // weighted sum of squares
         error_prev_ = error_;
-        error_ = prob_->GetScalarCost();
+        if (fused_update)
+        {
+            error_ = prob_->UpdateFused(q_, JT_times_yd_, JT_times_J_);
+        }
+        else
+        {
+            if (evaluate_jacobian)
+            {
+                prob_->Update(q_);
+            }
+            else
+            {
+                prob_->UpdateCost(q_);
+            }
+
+            yd_ = prob_->cost.S.diagonal().cwiseProduct(prob_->cost.ydiff);
+            error_ = prob_->GetScalarCost();
+        }
 
         prob_->SetCostEvolution(i, error_);
 
-        cost_jacobian_.noalias() = prob_->cost.S * prob_->cost.jacobian;
+        // Another solver of MotionSolver::SolveMultiStart already found a solution
+        if (IsStopRequested())
+        {
+            prob_->termination_criterion = TerminationCriterion::UserDefined;
+            break;
+        }
+
+        // The approximated Jacobian did not decrease the error: evaluate the Jacobian at the current configuration
+        if (!evaluate_jacobian && error_ >= error_prev_)
+        {
+            prob_->Update(q_);
+            evaluate_jacobian = true;
+        }
+
+        // The kinematic frames of the tasks, and hence the Jacobian structure, may have changed since the last solve
+        if (parameters_.SparseNormalEquations && i == 0) InitializeSparseJacobianPattern();
+
+        if (evaluate_jacobian)
+        {
+            if (!fused_update) cost_jacobian_.noalias() = prob_->cost.S.diagonal().asDiagonal() * prob_->cost.jacobian;
+            ++jacobian_evaluations_;
+            broyden_updates = 0;
+            factorisation_valid = false;
+        }
 
         // source: https://uk.mathworks.com/help/optim/ug/least-squares-model-fitting-algorithms.html, eq. 13
         if (i > 0)
@@ -112,23 +317,51 @@ void LevenbergMarquardtSolver::Solve(Eigen::MatrixXd& solution)
 
         if (debug_) HIGHLIGHT_NAMED("Levenberg-Marquardt", "damping: " << lambda_);
 
-        if (parameters_.ScaleProblem == "Jacobian")
+        if (!evaluate_jacobian)
         {
-            M_.diagonal().noalias() = (cost_jacobian_.transpose() * cost_jacobian_).diagonal();
+            // The factorisation can only be updated by rank updates if the regularisation lambda * M did not change
+            factorisation_valid = BroydenUpdate(factorisation_valid && lambda_ == lambda_factorised && parameters_.ScaleProblem == "none");
+            ++broyden_updates;
         }
 
-        JT_times_J_.noalias() = cost_jacobian_.transpose() * cost_jacobian_;
-        JT_times_J_ += lambda_ * M_;
-
-        llt_.compute(JT_times_J_);
-        if (llt_.info() != Eigen::Success)
+        if (parameters_.SparseNormalEquations)
         {
-            ThrowPretty("Error during matrix decomposition of J^T * J (lambda=" << lambda_ << "):\n"
-                                                                                << JT_times_J_);
+            SolveSparseNormalEquations();
+        }
+        else
+        {
+            if (!factorisation_valid)
+            {
+                if (!fused_update) JT_times_J_.noalias() = cost_jacobian_.transpose() * cost_jacobian_;
+                if (parameters_.ScaleProblem == "Jacobian")
+                {
+                    M_.diagonal() = JT_times_J_.diagonal();
+                }
+
+                JT_times_J_ += lambda_ * M_;
+
+                llt_.compute(JT_times_J_);
+                if (llt_.info() != Eigen::Success)
+                {
+                    ThrowPretty("Error during matrix decomposition of J^T * J (lambda=" << lambda_ << "):\n"
+                                                                                        << JT_times_J_);
+                }
+                factorisation_valid = true;
+                lambda_factorised = lambda_;
+            }
+            if (fused_update)
+            {
+                qd_ = JT_times_yd_;
+            }
+            else
+            {
+                qd_.noalias() = cost_jacobian_.transpose() * yd_;
+            }
+            llt_.solveInPlace(qd_);
         }
-        qd_.noalias() = cost_jacobian_.transpose() * yd_;
-        llt_.solveInPlace(qd_);
 
+        q_prev_ = q_;
+        yd_prev_ = yd_;
         if (parameters_.Alpha.size() == 1)
         {
             q_ -= qd_ * parameters_.Alpha[0];
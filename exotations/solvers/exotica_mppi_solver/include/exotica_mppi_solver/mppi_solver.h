@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_MPPI_SOLVER_MPPI_SOLVER_H_
+#define EXOTICA_MPPI_SOLVER_MPPI_SOLVER_H_
+
+#include <exotica_core/feedback_motion_solver.h>
+#include <exotica_core/problems/dynamic_time_indexed_shooting_problem.h>
+#include <exotica_core/server.h>
+
+#include <exotica_mppi_solver/mppi_solver_initializer.h>
+
+#include <mutex>
+#include <random>
+
+namespace exotica
+{
+// This code is based on:
+// G. Williams, P. Drews, B. Goldfain, J. M. Rehg, E. A. Theodorou, Information Theoretic MPC for Model-Based Reinforcement Learning, ICRA 2017
+// https://ieeexplore.ieee.org/document/7989202
+//
+// The costs of the sampled control trajectories are those of DynamicTimeIndexedShootingProblem::Rollout, i.e., the costs minimised by the
+// gradient-based solvers, and do not have to be differentiable (e.g., collision checks or contact switches).
+class MPPISolver : public FeedbackMotionSolver, public Instantiable<MPPISolverInitializer>
+{
+public:
+    void Instantiate(const MPPISolverInitializer& init) override;
+
+    ///\brief Solves the problem
+    ///@param solution Returned solution trajectory as a vector of joint configurations.
+    void Solve(Eigen::MatrixXd& solution) override;
+
+    ///\brief Binds the solver to a specific problem which must be pre-initalised
+    ///@param pointer Shared pointer to the motion planning problem
+    ///@return        Successful if the problem is a valid DynamicTimeIndexedProblem
+    void SpecifyProblem(PlanningProblemPtr pointer) override;
+
+    /// \brief Returns the nominal control of time step t of the last completed Solve. Sampling-based MPC does not compute feedback gains,
+    /// the control does not depend on x. Safe to call from a control thread while Solve runs.
+    Eigen::VectorXd GetFeedbackControl(Eigen::VectorXdRefConst x, int t) const override;
+
+private:
+    enum class UpdateRule
+    {
+        MPPI,
+        CEM
+    };
+
+    /// \brief Resizes the samples and the noise to the horizon of the problem.
+    void AllocateData();
+
+    /// \brief Draws the standard normal noise of all samples but the first (nominal) one.
+    void SampleNoise();
+
+    /// \brief Writes the control trajectory of sample k, the nominal controls perturbed by the scaled noise and clamped to the control limits.
+    void PerturbControls(int k);
+
+    /// \brief Updates the nominal controls (and the noise of CEM) from the costs of the samples.
+    void UpdateNominalControls();
+
+    DynamicTimeIndexedShootingProblemPtr prob_;  ///!< Shared pointer to the planning problem.
+    DynamicsSolverPtr dynamics_solver_;          ///!< Shared pointer to the dynamics solver.
+
+    UpdateRule update_rule_ = UpdateRule::MPPI;
+    int num_samples_ = 0;
+    int num_elite_samples_ = 0;
+    Eigen::VectorXd noise_sigma_;  ///!< Standard deviation of the noise of each control
+    double max_planning_time_ = 0.0;
+    int mpc_shift_ = 0;
+
+    int last_T_ = -1;            ///!< Horizon the samples are allocated for
+    bool has_solution_ = false;  ///!< Whether the problem holds the nominal trajectories of a previous Solve (to be shifted)
+
+    std::mt19937 generator_;
+    std::normal_distribution<double> standard_normal_noise_{0, 1};
+
+    Eigen::MatrixXd control_limits_;
+    Eigen::MatrixXd U_nominal_;               ///!< Nominal controls (NU x T-1)
+    Eigen::MatrixXd U_feedback_;              ///!< Nominal controls of the last completed Solve, returned by GetFeedbackControl
+    mutable std::mutex feedback_mutex_;       ///!< Guards U_feedback_
+    Eigen::MatrixXd sigma_;                   ///!< Standard deviation of the noise of each control and time step (NU x T-1)
+    std::vector<Eigen::MatrixXd> noise_;      ///!< Standard normal noise of each sample (NU x T-1)
+    std::vector<Eigen::MatrixXd> U_samples_;  ///!< Sampled control trajectories (NU x T-1)
+    std::vector<Eigen::MatrixXd> X_samples_;  ///!< State trajectories of the samples (NX x T)
+    Eigen::VectorXd costs_;                   ///!< Costs of the samples
+    Eigen::VectorXd weights_;                 ///!< Weights of the samples in the update
+    std::vector<int> sample_order_;           ///!< Indices of the samples, the elite samples first (CEM)
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_MPPI_SOLVER_MPPI_SOLVER_H_
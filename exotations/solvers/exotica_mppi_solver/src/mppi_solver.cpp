@@ -0,0 +1,302 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_mppi_solver/mppi_solver.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+REGISTER_MOTIONSOLVER_TYPE("MPPISolver", exotica::MPPISolver)
+
+namespace exotica
+{
+void MPPISolver::Instantiate(const MPPISolverInitializer& init)
+{
+    parameters_ = init;
+
+    if (parameters_.UpdateRule == "MPPI")
+    {
+        update_rule_ = UpdateRule::MPPI;
+    }
+    else if (parameters_.UpdateRule == "CEM")
+    {
+        update_rule_ = UpdateRule::CEM;
+    }
+    else
+    {
+        ThrowNamed("Unknown UpdateRule '" << parameters_.UpdateRule << "', use MPPI or CEM");
+    }
+
+    if (parameters_.NumSamples < 2) ThrowNamed("NumSamples needs to be at least 2, got " << parameters_.NumSamples);
+    if (parameters_.Temperature <= 0.) ThrowNamed("Temperature needs to be positive, got " << parameters_.Temperature);
+    if (update_rule_ == UpdateRule::CEM && (parameters_.NumEliteSamples < 1 || parameters_.NumEliteSamples > parameters_.NumSamples)) ThrowNamed("NumEliteSamples needs to be between 1 and NumSamples, got " << parameters_.NumEliteSamples);
+    if (parameters_.FunctionTolerance < 0.) ThrowNamed("FunctionTolerance needs to be non-negative, got " << parameters_.FunctionTolerance);
+    if (parameters_.MPCShift < 0) ThrowNamed("MPCShift needs to be non-negative, got " << parameters_.MPCShift);
+    if (parameters_.MaxPlanningTime < 0.) ThrowNamed("MaxPlanningTime needs to be non-negative, got " << parameters_.MaxPlanningTime);
+
+    num_samples_ = parameters_.NumSamples;
+    num_elite_samples_ = parameters_.NumEliteSamples;
+    mpc_shift_ = parameters_.MPCShift;
+    max_planning_time_ = parameters_.MaxPlanningTime;
+    generator_.seed(parameters_.Seed);
+}
+
+void MPPISolver::SpecifyProblem(PlanningProblemPtr pointer)
+{
+    DynamicTimeIndexedShootingProblemPtr problem = std::dynamic_pointer_cast<DynamicTimeIndexedShootingProblem>(pointer);
+    if (!problem)
+    {
+        ThrowNamed("This MPPISolver can't solve problem of type '" << pointer->type() << "'!");
+    }
+    MotionSolver::SpecifyProblem(pointer);
+    prob_ = problem;
+    dynamics_solver_ = prob_->GetScene()->GetDynamicsSolver();
+
+    const int NU = prob_->GetScene()->get_num_controls();
+    if (parameters_.NoiseSigma.size() == 0)
+    {
+        noise_sigma_ = Eigen::VectorXd::Ones(NU);
+    }
+    else if (parameters_.NoiseSigma.size() == 1)
+    {
+        noise_sigma_ = Eigen::VectorXd::Constant(NU, parameters_.NoiseSigma(0));
+    }
+    else if (parameters_.NoiseSigma.size() == NU)
+    {
+        noise_sigma_ = parameters_.NoiseSigma;
+    }
+    else
+    {
+        ThrowNamed("NoiseSigma needs to have size 1 or " << NU << ", got " << parameters_.NoiseSigma.size());
+    }
+    if ((noise_sigma_.array() < 0.).any()) ThrowNamed("NoiseSigma needs to be non-negative");
+
+    last_T_ = -1;
+    has_solution_ = false;
+    std::lock_guard<std::mutex> lock(feedback_mutex_);
+    U_feedback_.resize(0, 0);
+}
+
+void MPPISolver::AllocateData()
+{
+    const int T = prob_->get_T();
+    const int NU = prob_->GetScene()->get_num_controls();
+
+    U_nominal_.resize(NU, T - 1);
+    sigma_.resize(NU, T - 1);
+    noise_.assign(num_samples_, Eigen::MatrixXd::Zero(NU, T - 1));
+    U_samples_.assign(num_samples_, Eigen::MatrixXd::Zero(NU, T - 1));
+    costs_.setZero(num_samples_);
+    weights_.setZero(num_samples_);
+    sample_order_.resize(num_samples_);
+
+    // Common random numbers are drawn once per horizon
+    SampleNoise();
+
+    last_T_ = T;
+    has_solution_ = false;
+}
+
+void MPPISolver::SampleNoise()
+{
+    // The first sample is the nominal trajectory
+    for (int k = 1; k < num_samples_; ++k)
+    {
+        for (int i = 0; i < noise_[k].size(); ++i) noise_[k](i) = standard_normal_noise_(generator_);
+    }
+}
+
+void MPPISolver::PerturbControls(int k)
+{
+    Eigen::MatrixXd& U = U_samples_[k];
+    U.noalias() = U_nominal_ + sigma_.cwiseProduct(noise_[k]);
+    for (int t = 0; t < U.cols(); ++t)
+    {
+        U.col(t) = U.col(t).cwiseMax(control_limits_.col(0)).cwiseMin(control_limits_.col(1));
+    }
+}
+
+void MPPISolver::UpdateNominalControls()
+{
+    if (update_rule_ == UpdateRule::MPPI)
+    {
+        // Exponential weights relative to the best sample, samples with non-finite costs have zero weight
+        double min_cost = std::numeric_limits<double>::infinity();
+        for (int k = 0; k < num_samples_; ++k)
+        {
+            if (std::isfinite(costs_(k))) min_cost = std::min(min_cost, costs_(k));
+        }
+        for (int k = 0; k < num_samples_; ++k)
+        {
+            weights_(k) = std::isfinite(costs_(k)) ? std::exp(-(costs_(k) - min_cost) / parameters_.Temperature) : 0.0;
+        }
+        weights_ /= weights_.sum();
+
+        U_nominal_.setZero();
+        for (int k = 0; k < num_samples_; ++k)
+        {
+            if (weights_(k) > 0.) U_nominal_.noalias() += weights_(k) * U_samples_[k];
+        }
+    }
+    else
+    {
+        // Refit the mean and standard deviation to the elite samples, non-finite costs are sorted last
+        std::iota(sample_order_.begin(), sample_order_.end(), 0);
+        std::partial_sort(sample_order_.begin(), sample_order_.begin() + num_elite_samples_, sample_order_.end(), [this](int a, int b) {
+            return costs_(a) < costs_(b) || (std::isfinite(costs_(a)) && !std::isfinite(costs_(b)));
+        });
+
+        U_nominal_.setZero();
+        for (int i = 0; i < num_elite_samples_; ++i) U_nominal_ += U_samples_[sample_order_[i]];
+        U_nominal_ /= static_cast<double>(num_elite_samples_);
+
+        sigma_.setZero();
+        for (int i = 0; i < num_elite_samples_; ++i) sigma_.array() += (U_samples_[sample_order_[i]] - U_nominal_).array().square();
+        sigma_ = (sigma_ / static_cast<double>(num_elite_samples_)).cwiseSqrt();
+    }
+}
+
+void MPPISolver::Solve(Eigen::MatrixXd& solution)
+{
+    EXOTICA_PROFILE_SCOPE("MPPISolver::Solve");
+    if (!prob_) ThrowNamed("Solver has not been initialized!");
+    Timer planning_timer, iteration_timer;
+
+    const int T = prob_->get_T();
+    const int NU = prob_->GetScene()->get_num_controls();
+    if (T != last_T_) AllocateData();
+
+    // Real-time MPC: warm-start from the shifted nominal trajectories of the previous Solve
+    if (mpc_shift_ > 0 && has_solution_) prob_->ShiftTrajectory(mpc_shift_);
+
+    const double dt = dynamics_solver_->get_dt();
+    control_limits_ = dynamics_solver_->get_control_limits();
+    const Eigen::VectorXd x0 = prob_->ApplyStartState();
+    prob_->PreUpdate();
+
+    U_nominal_ = prob_->get_U();
+    for (int t = 0; t < T - 1; ++t) sigma_.col(t) = noise_sigma_;
+
+    prob_->ResetCostEvolution(GetNumberOfMaxIterations() + 1);
+    prob_->termination_criterion = TerminationCriterion::IterationLimit;
+
+    if (debug_) HIGHLIGHT_NAMED("MPPISolver", "Running " << parameters_.UpdateRule << " with " << num_samples_ << " samples for max " << GetNumberOfMaxIterations() << " iterations");
+
+    double cost_prev = std::numeric_limits<double>::infinity();
+    double time_taken_iteration = 0.0;
+    int iteration = 0;
+    while (iteration < GetNumberOfMaxIterations())
+    {
+        // Check whether user interrupted (Ctrl+C)
+        if (Server::IsRos() && !ros::ok())
+        {
+            if (debug_) HIGHLIGHT("Solving cancelled by user");
+            prob_->termination_criterion = TerminationCriterion::UserDefined;
+            break;
+        }
+
+        // Real-time MPC: only start the iteration if it is expected to finish before the deadline (estimated by the last iteration)
+        if (max_planning_time_ > 0. && iteration > 0 && planning_timer.GetDuration() + time_taken_iteration > max_planning_time_)
+        {
+            if (debug_) HIGHLIGHT_NAMED("MPPISolver", "Deadline reached: " << planning_timer.GetDuration() << " s (MaxPlanningTime: " << max_planning_time_ << " s)");
+            break;
+        }
+        iteration_timer.Reset();
+
+        if (!parameters_.CommonRandomNumbers) SampleNoise();
+        for (int k = 0; k < num_samples_; ++k) PerturbControls(k);
+        prob_->Rollout(x0, U_samples_, costs_, X_samples_);
+
+        // The first sample is the nominal trajectory of this iteration
+        const double cost = costs_(0);
+        prob_->SetCostEvolution(iteration, cost);
+        if (!costs_.array().isFinite().any())
+        {
+            prob_->termination_criterion = TerminationCriterion::Divergence;
+            WARNING_NAMED("MPPISolver", "Diverged: The costs of all samples are not finite.");
+            break;
+        }
+
+        // Relative function tolerance
+        // (f_t-1 - f_t) <= functionTolerance * max(1, abs(f_t))
+        if (parameters_.FunctionTolerance > 0. && std::abs(cost_prev - cost) <= parameters_.FunctionTolerance * std::max(1.0, std::abs(cost)))
+        {
+            if (debug_) HIGHLIGHT_NAMED("MPPISolver", "Function tolerance reached (" << cost << " < " << cost_prev << "). Time: " << planning_timer.GetDuration());
+            prob_->termination_criterion = TerminationCriterion::FunctionTolerance;
+            break;
+        }
+        cost_prev = cost;
+
+        UpdateNominalControls();
+        ++iteration;
+        time_taken_iteration = iteration_timer.GetDuration();
+
+        if (debug_) HIGHLIGHT_NAMED("MPPISolver", "Iteration " << iteration << std::setprecision(3) << ":\tTime: " << time_taken_iteration << " s\tNominal cost: " << cost << "\tBest sample cost: " << costs_.minCoeff());
+    }
+
+    // Roll out the nominal controls on the problem
+    double cost = 0.0;
+    for (int t = 0; t < T - 1; ++t)
+    {
+        prob_->Update(U_nominal_.col(t), t);
+        cost += dt * (prob_->GetControlCost(t) + prob_->GetStateCost(t));
+    }
+    cost += prob_->GetStateCost(T - 1);
+    prob_->SetCostEvolution(iteration, cost);
+
+    solution = U_nominal_.transpose();
+    {
+        std::lock_guard<std::mutex> lock(feedback_mutex_);
+        U_feedback_ = U_nominal_;
+    }
+
+    // Export the nominal controls for control threads, sampling-based MPC does not compute feedback gains
+    {
+        const int NDX = prob_->GetScene()->get_num_state_derivative();
+        std::vector<Eigen::VectorXd> X_ref(T), U_ref(T - 1), k(T - 1, Eigen::VectorXd::Zero(NU));
+        std::vector<Eigen::MatrixXd> K(T - 1, Eigen::MatrixXd::Zero(NU, NDX));
+        for (int t = 0; t < T; ++t) X_ref[t] = prob_->get_X(t);
+        for (int t = 0; t < T - 1; ++t) U_ref[t] = U_nominal_.col(t);
+        PublishFeedbackPolicy(std::make_shared<const FeedbackPolicy>(dynamics_solver_, std::move(X_ref), std::move(U_ref), std::move(k), std::move(K)));
+    }
+
+    has_solution_ = true;
+    planning_time_ = planning_timer.GetDuration();
+}
+
+Eigen::VectorXd MPPISolver::GetFeedbackControl(Eigen::VectorXdRefConst x, int t) const
+{
+    std::lock_guard<std::mutex> lock(feedback_mutex_);
+    if (t < 0 || t >= U_feedback_.cols()) ThrowNamed("Requested t=" << t << " out of range, needs to be 0 =< t < " << U_feedback_.cols());
+    return U_feedback_.col(t);
+}
+
+}  // namespace exotica
@@ -30,6 +30,11 @@
 #ifndef EXOTICA_OMPL_CONTROL_SOLVER_OMPL_CONTROL_SOLVER_H_
 #define EXOTICA_OMPL_CONTROL_SOLVER_OMPL_CONTROL_SOLVER_H_
 
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 // #include <exotica_core/feedback_motion_solver.h>
 #include <exotica_core/motion_solver.h>
 #include <exotica_core/problems/dynamic_time_indexed_shooting_problem.h>
@@ -37,11 +42,15 @@
 #include <exotica_ompl_control_solver/ompl_control_solver_initializer.h>
 
 // TODO: Remove unused includes
+#include <ompl/base/goals/GoalSampleableRegion.h>
 #include <ompl/base/goals/GoalState.h>
 #include <ompl/base/spaces/SE2StateSpace.h>
+#include <ompl/control/ControlSampler.h>
+#include <ompl/control/DirectedControlSampler.h>
 #include <ompl/control/SimpleSetup.h>
 #include <ompl/control/SpaceInformation.h>
 #include <ompl/control/spaces/RealVectorControlSpace.h>
+#include <ompl/util/RandomNumbers.h>
 
 namespace ob = ompl::base;
 namespace oc = ompl::control;
@@ -62,6 +71,14 @@ public:
         const double duration,
         ob::State *result) const override
     {
+        if (cache_size_ > 0)
+        {
+            int steps = 0;
+            for (double t = 0; t < duration; t += timeStep_) ++steps;
+            PropagateCached(state, control, steps, result);
+            return;
+        }
+
         double t = 0;
         space_->copyState(result, state);
 
@@ -72,6 +89,19 @@ public:
         }
     }
 
+    /// \brief Caches the integrated states of the last num_entries (source state, control) pairs, quantised by resolution.
+    /// Longer durations from a cached pair continue its integration. 0 entries disable the cache.
+    void SetCache(int num_entries, double resolution);
+
+    /// \brief Returns the number of propagations answered from the cache entirely.
+    std::size_t GetCacheHits() const;
+
+    /// \brief Returns the number of propagations that continued a shorter cached integration.
+    std::size_t GetCachePartialHits() const;
+
+    /// \brief Returns the number of propagations not found in the cache.
+    std::size_t GetCacheMisses() const;
+
     void setIntegrationTimeStep(double timeStep)
     {
         timeStep_ = timeStep;
@@ -82,11 +112,36 @@ public:
         return timeStep_;
     }
 
+    /// \brief Propagates the state with each of the controls for at most steps[k] propagation steps, as
+    /// SpaceInformation::propagateWhileValid does, but with all controls in lockstep (DynamicsSolver::SimulateBatch).
+    /// On return, steps[k] is the number of valid steps of control k and results[k] the last valid state.
+    void PropagateBatchWhileValid(const ob::State *state, const std::vector<oc::Control *> &controls, std::vector<unsigned int> &steps, std::vector<ob::State *> &results) const;
+
 private:
+    struct CacheKeyHash
+    {
+        std::size_t operator()(const std::vector<std::int64_t> &key) const;
+    };
+
+    /// \brief The states after each integration step from a source state with a control
+    typedef std::list<std::pair<std::vector<std::int64_t>, std::vector<Eigen::VectorXd>>> Cache;
+
+    /// \brief Integrates steps timesteps from the state, reusing and extending the cached integration
+    void PropagateCached(const ob::State *state, const oc::Control *control, int steps, ob::State *result) const;
+
     double timeStep_ = 0.0;
     oc::SpaceInformationPtr space_;
     DynamicsSolverPtr dynamics_solver_;
 
+    int cache_size_ = 0;
+    double cache_resolution_ = 1e-6;
+    mutable std::mutex cache_mutex_;                                                                    ///< Guards the cache and its counters
+    mutable Cache cache_;                                                                               ///< Most recently used first
+    mutable std::unordered_map<std::vector<std::int64_t>, Cache::iterator, CacheKeyHash> cache_index_;  ///< Entries of cache_ by key
+    mutable std::size_t cache_hits_ = 0;
+    mutable std::size_t cache_partial_hits_ = 0;
+    mutable std::size_t cache_misses_ = 0;
+
     void Integrate(ob::State *ob_x, const oc::Control *oc_u, double dt) const
     {
         const int NU = dynamics_solver_->get_num_controls();
@@ -103,6 +158,62 @@ private:
     }
 };
 
+/// \brief Samples several controls towards a target state, propagates them together and keeps the one reaching closest
+/// (as oc::SimpleDirectedControlSampler with several control samples, but with batched propagation).
+class OMPLBatchDirectedControlSampler : public oc::DirectedControlSampler
+{
+public:
+    OMPLBatchDirectedControlSampler(const oc::SpaceInformation *si, std::shared_ptr<const OMPLStatePropagator> propagator, unsigned int num_control_samples);
+    ~OMPLBatchDirectedControlSampler() override;
+
+    unsigned int sampleTo(oc::Control *control, const ob::State *source, ob::State *dest) override;
+    unsigned int sampleTo(oc::Control *control, const oc::Control *previous, const ob::State *source, ob::State *dest) override;
+
+private:
+    unsigned int GetBestControl(oc::Control *control, const ob::State *source, ob::State *dest, const oc::Control *previous);
+
+    oc::ControlSamplerPtr control_sampler_;
+    std::shared_ptr<const OMPLStatePropagator> propagator_;
+    std::vector<oc::Control *> controls_;  ///< Candidate controls
+    std::vector<ob::State *> states_;      ///< States reached by the candidate controls
+    std::vector<unsigned int> steps_;      ///< Propagation steps of the candidate controls
+};
+
+/// \brief Goal region of the states within the threshold of the goal state. Goal samples perturb the positions of the goal
+/// state (DynamicsSolver::GetPosition) and keep its velocities. If hold_control_limits is set, samples whose inverse dynamics
+/// (the control holding the state, DynamicsSolver::InverseDynamics) exceed the control limits are rejected.
+class OMPLGoalRegion : public ob::GoalSampleableRegion
+{
+public:
+    OMPLGoalRegion(const oc::SpaceInformationPtr &si, const Eigen::VectorXd &goal, double threshold, DynamicsSolverPtr dynamics_solver, bool hold_control_limits);
+
+    double distanceGoal(const ob::State *state) const override;
+    void sampleGoal(ob::State *state) const override;
+    unsigned int maxSampleCount() const override;
+
+private:
+    Eigen::VectorXd goal_;
+    DynamicsSolverPtr dynamics_solver_;
+    bool hold_control_limits_;
+    int num_positions_;
+    mutable ompl::RNG rng_;
+};
+
+/// \brief Samples controls around the control holding the goal state with probability bias, uniformly otherwise.
+class OMPLGoalBiasedControlSampler : public oc::ControlSampler
+{
+public:
+    /// \param stddev Standard deviation of the controls sampled around goal_control, relative to the range of each control.
+    OMPLGoalBiasedControlSampler(const oc::ControlSpace *space, const Eigen::VectorXd &goal_control, double bias, double stddev);
+
+    void sample(oc::Control *control) override;
+
+private:
+    Eigen::VectorXd goal_control_;
+    double bias_;
+    double stddev_;
+};
+
 class OMPLControlSolver : public MotionSolver
 {
 public:
@@ -131,6 +242,7 @@ protected:
     std::unique_ptr<oc::SimpleSetup> setup_;
     std::string algorithm_;
     ConfiguredPlannerAllocator planner_allocator_;
+    std::shared_ptr<OMPLStatePropagator> propagator_;
 
     void Setup();
 
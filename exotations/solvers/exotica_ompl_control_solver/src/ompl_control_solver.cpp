@@ -27,10 +27,284 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <cmath>
+#include <cstring>
+#include <limits>
+
 #include <exotica_ompl_control_solver/ompl_control_solver.h>
 
 namespace exotica
 {
+void OMPLStatePropagator::PropagateBatchWhileValid(const ob::State *state, const std::vector<oc::Control *> &controls, std::vector<unsigned int> &steps, std::vector<ob::State *> &results) const
+{
+    const int num_samples = static_cast<int>(controls.size());
+    if (steps.size() != controls.size() || results.size() != controls.size()) ThrowPretty("Expected " << num_samples << " step counts and results, got " << steps.size() << " and " << results.size());
+
+    // The batch advances all states by one timestep of the dynamics solver, which has to match the propagation step
+    const double dt = dynamics_solver_->get_dt();
+    if (std::abs(space_->getPropagationStepSize() - dt) > 1e-9 || std::abs(timeStep_ - dt) > 1e-9)
+    {
+        for (int k = 0; k < num_samples; ++k) steps[k] = space_->propagateWhileValid(state, controls[k], steps[k], results[k]);
+        return;
+    }
+
+    const int NU = dynamics_solver_->get_num_controls();
+    const int NX = dynamics_solver_->get_num_positions() + dynamics_solver_->get_num_velocities();
+    const Eigen::Map<const Eigen::VectorXd> x0(state->as<ob::RealVectorStateSpace::StateType>()->values, NX);
+
+    Eigen::MatrixXd X(NX, num_samples), U(NU, num_samples), X_next(NX, num_samples);
+    std::vector<unsigned int> valid_steps(num_samples, 0);
+    std::vector<bool> active(num_samples, true);
+    unsigned int max_steps = 0;
+    for (int k = 0; k < num_samples; ++k)
+    {
+        X.col(k) = x0;
+        U.col(k) = Eigen::Map<const Eigen::VectorXd>(controls[k]->as<oc::RealVectorControlSpace::ControlType>()->values, NU);
+        space_->copyState(results[k], state);
+        max_steps = std::max(max_steps, steps[k]);
+    }
+
+    for (unsigned int step = 0; step < max_steps; ++step)
+    {
+        dynamics_solver_->SimulateBatch(X, U, X_next);
+
+        // A control stops at its step count or before its first invalid state
+        bool any_active = false;
+        for (int k = 0; k < num_samples; ++k)
+        {
+            if (!active[k]) continue;
+            if (step >= steps[k])
+            {
+                active[k] = false;
+                continue;
+            }
+            double *x = results[k]->as<ob::RealVectorStateSpace::StateType>()->values;
+            Eigen::Map<Eigen::VectorXd>(x, NX) = X_next.col(k);
+            if (!space_->isValid(results[k]))
+            {
+                Eigen::Map<Eigen::VectorXd>(x, NX) = X.col(k);
+                active[k] = false;
+                continue;
+            }
+            ++valid_steps[k];
+            any_active = true;
+        }
+        if (!any_active) break;
+        X.swap(X_next);
+    }
+    steps = valid_steps;
+}
+
+std::size_t OMPLStatePropagator::CacheKeyHash::operator()(const std::vector<std::int64_t> &key) const
+{
+    std::size_t seed = key.size();
+    for (const std::int64_t &value : key) seed ^= std::hash<std::int64_t>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+void OMPLStatePropagator::SetCache(int num_entries, double resolution)
+{
+    if (num_entries > 0 && !(resolution > 0.0)) ThrowPretty("The resolution of the propagation cache has to be positive, given: " << resolution);
+
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    cache_size_ = std::max(num_entries, 0);
+    cache_resolution_ = resolution;
+    cache_.clear();
+    cache_index_.clear();
+    cache_hits_ = 0;
+    cache_partial_hits_ = 0;
+    cache_misses_ = 0;
+}
+
+std::size_t OMPLStatePropagator::GetCacheHits() const
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return cache_hits_;
+}
+
+std::size_t OMPLStatePropagator::GetCachePartialHits() const
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return cache_partial_hits_;
+}
+
+std::size_t OMPLStatePropagator::GetCacheMisses() const
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return cache_misses_;
+}
+
+void OMPLStatePropagator::PropagateCached(const ob::State *state, const oc::Control *control, int steps, ob::State *result) const
+{
+    const int NU = dynamics_solver_->get_num_controls();
+    const int NX = dynamics_solver_->get_num_positions() + dynamics_solver_->get_num_velocities();
+    const Eigen::Map<const Eigen::VectorXd> x(state->as<ob::RealVectorStateSpace::StateType>()->values, NX);
+    const Eigen::Map<const Eigen::VectorXd> u(control->as<oc::RealVectorControlSpace::ControlType>()->values, NU);
+    double *x_result = result->as<ob::RealVectorStateSpace::StateType>()->values;
+    if (steps == 0)
+    {
+        space_->copyState(result, state);
+        return;
+    }
+
+    std::vector<std::int64_t> key(NX + NU);
+    for (int i = 0; i < NX; ++i) key[i] = std::llround(x(i) / cache_resolution_);
+    for (int i = 0; i < NU; ++i) key[NX + i] = std::llround(u(i) / cache_resolution_);
+
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = cache_index_.find(key);
+    if (it == cache_index_.end())
+    {
+        ++cache_misses_;
+        cache_.emplace_front(key, std::vector<Eigen::VectorXd>());
+        it = cache_index_.emplace(std::move(key), cache_.begin()).first;
+        while (static_cast<int>(cache_.size()) > cache_size_)
+        {
+            cache_index_.erase(cache_.back().first);
+            cache_.pop_back();
+        }
+    }
+    else
+    {
+        cache_.splice(cache_.begin(), cache_, it->second);
+        if (static_cast<int>(it->second->second.size()) >= steps)
+            ++cache_hits_;
+        else
+            ++cache_partial_hits_;
+    }
+
+    // Continue the cached integration up to the requested number of steps
+    std::vector<Eigen::VectorXd> &states = it->second->second;
+    while (static_cast<int>(states.size()) < steps)
+    {
+        const Eigen::VectorXd x_previous = states.empty() ? Eigen::VectorXd(x) : states.back();
+        states.emplace_back(dynamics_solver_->Simulate(x_previous, u, timeStep_));
+    }
+    std::memcpy(x_result, states[steps - 1].data(), NX * sizeof(double));
+}
+
+OMPLGoalRegion::OMPLGoalRegion(const oc::SpaceInformationPtr &si, const Eigen::VectorXd &goal, double threshold, DynamicsSolverPtr dynamics_solver, bool hold_control_limits)
+    : ob::GoalSampleableRegion(si), goal_(goal), dynamics_solver_(dynamics_solver), hold_control_limits_(hold_control_limits)
+{
+    setThreshold(threshold);
+    num_positions_ = static_cast<int>(dynamics_solver_->GetPosition(goal_).size());
+}
+
+double OMPLGoalRegion::distanceGoal(const ob::State *state) const
+{
+    return (Eigen::Map<const Eigen::VectorXd>(state->as<ob::RealVectorStateSpace::StateType>()->values, goal_.size()) - goal_).norm();
+}
+
+void OMPLGoalRegion::sampleGoal(ob::State *state) const
+{
+    constexpr int max_attempts = 10;
+    double *x = state->as<ob::RealVectorStateSpace::StateType>()->values;
+    const Eigen::MatrixXd &control_limits = dynamics_solver_->get_control_limits();
+    for (int attempt = 0; attempt < max_attempts; ++attempt)
+    {
+        // Uniformly within the ball of the threshold around the goal positions
+        Eigen::VectorXd direction(num_positions_);
+        for (int i = 0; i < num_positions_; ++i) direction(i) = rng_.gaussian01();
+        const double radius = threshold_ * std::pow(rng_.uniform01(), 1.0 / num_positions_);
+        Eigen::VectorXd sample = goal_;
+        if (direction.norm() > 0.0) sample.head(num_positions_) += radius * direction.normalized();
+        Eigen::Map<Eigen::VectorXd>(x, goal_.size()) = sample;
+        si_->enforceBounds(state);
+        if (!isSatisfied(state)) continue;
+
+        if (hold_control_limits_)
+        {
+            const Eigen::VectorXd u = dynamics_solver_->InverseDynamics(Eigen::Map<const Eigen::VectorXd>(x, goal_.size()));
+            if ((u.array() < control_limits.col(0).array()).any() || (u.array() > control_limits.col(1).array()).any()) continue;
+        }
+        return;
+    }
+    Eigen::Map<Eigen::VectorXd>(x, goal_.size()) = goal_;
+}
+
+unsigned int OMPLGoalRegion::maxSampleCount() const
+{
+    return std::numeric_limits<unsigned int>::max();
+}
+
+OMPLGoalBiasedControlSampler::OMPLGoalBiasedControlSampler(const oc::ControlSpace *space, const Eigen::VectorXd &goal_control, double bias, double stddev)
+    : oc::ControlSampler(space), goal_control_(goal_control), bias_(bias), stddev_(stddev)
+{
+}
+
+void OMPLGoalBiasedControlSampler::sample(oc::Control *control)
+{
+    const ob::RealVectorBounds &bounds = space_->as<oc::RealVectorControlSpace>()->getBounds();
+    double *u = control->as<oc::RealVectorControlSpace::ControlType>()->values;
+    const bool near_goal_control = rng_.uniform01() < bias_;
+    for (std::size_t i = 0; i < bounds.low.size(); ++i)
+    {
+        if (near_goal_control)
+            u[i] = std::min(std::max(rng_.gaussian(goal_control_(i), stddev_ * (bounds.high[i] - bounds.low[i])), bounds.low[i]), bounds.high[i]);
+        else
+            u[i] = rng_.uniformReal(bounds.low[i], bounds.high[i]);
+    }
+}
+
+OMPLBatchDirectedControlSampler::OMPLBatchDirectedControlSampler(const oc::SpaceInformation *si, std::shared_ptr<const OMPLStatePropagator> propagator, unsigned int num_control_samples)
+    : oc::DirectedControlSampler(si), control_sampler_(si->allocControlSampler()), propagator_(propagator), steps_(num_control_samples, 0)
+{
+    if (num_control_samples == 0) ThrowPretty("At least one control has to be sampled per extension");
+    for (unsigned int i = 0; i < num_control_samples; ++i)
+    {
+        controls_.push_back(si_->allocControl());
+        states_.push_back(si_->allocState());
+    }
+}
+
+OMPLBatchDirectedControlSampler::~OMPLBatchDirectedControlSampler()
+{
+    for (oc::Control *control : controls_) si_->freeControl(control);
+    for (ob::State *state : states_) si_->freeState(state);
+}
+
+unsigned int OMPLBatchDirectedControlSampler::sampleTo(oc::Control *control, const ob::State *source, ob::State *dest)
+{
+    return GetBestControl(control, source, dest, nullptr);
+}
+
+unsigned int OMPLBatchDirectedControlSampler::sampleTo(oc::Control *control, const oc::Control *previous, const ob::State *source, ob::State *dest)
+{
+    return GetBestControl(control, source, dest, previous);
+}
+
+unsigned int OMPLBatchDirectedControlSampler::GetBestControl(oc::Control *control, const ob::State *source, ob::State *dest, const oc::Control *previous)
+{
+    const unsigned int min_duration = si_->getMinControlDuration();
+    const unsigned int max_duration = si_->getMaxControlDuration();
+    for (std::size_t i = 0; i < controls_.size(); ++i)
+    {
+        if (previous != nullptr)
+            control_sampler_->sampleNext(controls_[i], previous, source);
+        else
+            control_sampler_->sample(controls_[i], source);
+        steps_[i] = control_sampler_->sampleStepCount(min_duration, max_duration);
+    }
+
+    propagator_->PropagateBatchWhileValid(source, controls_, steps_, states_);
+
+    std::size_t best = 0;
+    double best_distance = si_->distance(states_[0], dest);
+    for (std::size_t i = 1; i < controls_.size(); ++i)
+    {
+        const double distance = si_->distance(states_[i], dest);
+        if (distance < best_distance)
+        {
+            best = i;
+            best_distance = distance;
+        }
+    }
+
+    si_->copyControl(control, controls_[best]);
+    si_->copyState(dest, states_[best]);
+    return steps_[best];
+}
+
 void OMPLControlSolver::SpecifyProblem(PlanningProblemPtr pointer)
 {
     if (pointer->type() != "exotica::DynamicTimeIndexedShootingProblem")
@@ -85,6 +359,30 @@ void OMPLControlSolver::Setup()
 
     cspace->setBounds(control_bounds_);
 
+    // The control holding the goal state, if the dynamics solver supports inverse dynamics
+    const Eigen::VectorXd goal_eig_vector = prob_->get_X_star().col(T - 1);
+    Eigen::VectorXd goal_control;
+    bool has_goal_control = false;
+    if (init_.GoalControlBias > 0.0 || init_.GoalRegionSampling)
+    {
+        try
+        {
+            goal_control = dynamics_solver_->InverseDynamics(goal_eig_vector);
+            has_goal_control = true;
+        }
+        catch (const std::exception &e)
+        {
+            WARNING_NAMED(algorithm_, "No control holding the goal state, goal samples and controls are not biased by it: " << e.what());
+        }
+    }
+    if (init_.GoalControlBias > 0.0 && has_goal_control)
+    {
+        const double bias = init_.GoalControlBias, stddev = init_.GoalControlStdDev;
+        cspace->setControlSamplerAllocator([goal_control, bias, stddev](const oc::ControlSpace *space) {
+            return std::make_shared<OMPLGoalBiasedControlSampler>(space, goal_control, bias, stddev);
+        });
+    }
+
     // define a simple setup class
     setup_.reset(new oc::SimpleSetup(cspace));
     oc::SpaceInformationPtr si = setup_->getSpaceInformation();
@@ -93,9 +391,20 @@ void OMPLControlSolver::Setup()
     setup_->setStateValidityChecker([this, si](const ob::State *state) { return isStateValid(si, state); });
 
     std::shared_ptr<OMPLStatePropagator> propagator(std::make_shared<OMPLStatePropagator>(si, dynamics_solver_));
+    propagator->SetCache(init_.PropagationCacheSize, init_.PropagationCacheResolution);
+    propagator_ = propagator;
 
     setup_->setStatePropagator(propagator);
 
+    // Planners steering towards sampled states try several controls per extension, propagated together
+    if (init_.ControlSamplesPerExtension > 1)
+    {
+        const unsigned int num_control_samples = static_cast<unsigned int>(init_.ControlSamplesPerExtension);
+        si->setDirectedControlSamplerAllocator([propagator, num_control_samples](const oc::SpaceInformation *si) {
+            return std::make_shared<OMPLBatchDirectedControlSampler>(si, propagator, num_control_samples);
+        });
+    }
+
     const Eigen::VectorXd start_eig = prob_->ApplyStartState();
     const Eigen::MatrixXd goal_eig = prob_->get_X_star().col(T - 1);
 
@@ -113,7 +422,15 @@ void OMPLControlSolver::Setup()
         goal_state_[i] = goal_eig(i);
     }
 
-    setup_->setStartAndGoalStates(start_state_, goal_state_, init_.ConvergenceTolerance);
+    if (init_.GoalRegionSampling)
+    {
+        setup_->setStartState(start_state_);
+        setup_->setGoal(std::make_shared<OMPLGoalRegion>(si, goal_eig_vector, init_.ConvergenceTolerance, dynamics_solver_, has_goal_control));
+    }
+    else
+    {
+        setup_->setStartAndGoalStates(start_state_, goal_state_, init_.ConvergenceTolerance);
+    }
 
     ob::PlannerPtr optimizingPlanner(planner_allocator_(si));
     setup_->setPlanner(optimizingPlanner);
@@ -124,6 +441,7 @@ void OMPLControlSolver::Setup()
 
 void OMPLControlSolver::Solve(Eigen::MatrixXd &solution)
 {
+    EXOTICA_PROFILE_SCOPE("OMPLControlSolver::Solve");
     if (!prob_) ThrowNamed("Solver has not been initialized!");
     Timer planning_timer, backward_pass_timer, line_search_timer;
 
@@ -136,6 +454,8 @@ void OMPLControlSolver::Solve(Eigen::MatrixXd &solution)
 
     Setup();
     ob::PlannerStatus solved = setup_->solve(init_.MaxIterationTime);
+    if (debug_ && init_.PropagationCacheSize > 0)
+        HIGHLIGHT_NAMED(algorithm_, "Propagation cache: " << propagator_->GetCacheHits() << " hits, " << propagator_->GetCachePartialHits() << " partial hits, " << propagator_->GetCacheMisses() << " misses");
 
     if (solved)
     {
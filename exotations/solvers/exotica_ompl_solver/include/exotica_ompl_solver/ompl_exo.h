@@ -30,8 +30,16 @@
 #ifndef EXOTICA_OMPL_SOLVER_OMPL_EXO_H_
 #define EXOTICA_OMPL_SOLVER_OMPL_EXO_H_
 
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 #include <exotica_core/problems/sampling_problem.h>
 
+#include <ompl/base/DiscreteMotionValidator.h>
+#include <ompl/base/MotionValidator.h>
 #include <ompl/base/SpaceInformation.h>
 #include <ompl/base/StateSpace.h>
 #include <ompl/base/StateValidityChecker.h>
@@ -62,11 +70,104 @@ public:
     virtual void ExoticaToOMPLState(const Eigen::VectorXd &q, ompl::base::State *state) const = 0;
     virtual void OMPLToExoticaState(const ompl::base::State *state, Eigen::VectorXd &q) const = 0;
 
+    /// \brief Returns the exotica state of an OMPL state. State spaces storing the exotica state contiguously return a view of the
+    /// state without copying (OMPLRNStateSpace), the others convert into buffer, which is only resized if its size differs.
+    /// The view is valid as long as the state (or the buffer) is.
+    virtual Eigen::Map<const Eigen::VectorXd> GetExoticaState(const ompl::base::State *state, Eigen::VectorXd &buffer) const
+    {
+        OMPLToExoticaState(state, buffer);
+        return Eigen::Map<const Eigen::VectorXd>(buffer.data(), buffer.rows());
+    }
+
     virtual ompl::base::StateSamplerPtr allocDefaultStateSampler() const = 0;
     virtual void StateDebug(const Eigen::VectorXd &q) const = 0;
 
+    /// \brief Sets the states (one per row) around which the default samplers draw DemonstrationSampleRatio of their samples,
+    /// e.g., previous solutions. Applies to the samplers allocated before as well. Has to be called before planning.
+    void SetDemonstrationStates(Eigen::MatrixXdRefConst states) { *demonstration_states_ = states; }
+    const Eigen::MatrixXd &GetDemonstrationStates() const { return *demonstration_states_; }
+
 protected:
+    /// \brief Wraps the uniform sampler of the state space to draw samples around the demonstration states (DemonstrationSampleRatio > 0).
+    ompl::base::StateSamplerPtr AllocDemonstrationSampler(const ompl::base::StateSamplerPtr &uniform_sampler) const;
+
     OMPLSolverInitializer init_;
+    std::shared_ptr<Eigen::MatrixXd> demonstration_states_ = std::make_shared<Eigen::MatrixXd>();  ///< Shared with the samplers
+};
+
+/// \brief State sampler drawing a fraction of its samples from a Gaussian around a random demonstration state, in the coordinates of the
+/// problem, and the others from the uniform sampler of the state space. Without demonstration states, all samples are uniform.
+class OMPLDemonstrationStateSampler : public ompl::base::StateSampler
+{
+public:
+    OMPLDemonstrationStateSampler(const OMPLStateSpace *space, const ompl::base::StateSamplerPtr &uniform_sampler, const std::shared_ptr<const Eigen::MatrixXd> &demonstration_states, double ratio, double standard_deviation);
+
+    void sampleUniform(ompl::base::State *state) override;
+    void sampleUniformNear(ompl::base::State *state, const ompl::base::State *near, double distance) override;
+    void sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, double standard_deviation) override;
+
+protected:
+    const OMPLStateSpace *exotica_space_;
+    ompl::base::StateSamplerPtr uniform_sampler_;
+    std::shared_ptr<const Eigen::MatrixXd> demonstration_states_;
+    double ratio_;
+    double standard_deviation_;
+    Eigen::VectorXd q_;
+};
+
+/// \brief Workspace positions of a link at the states of the planner, for the workspace projection of KPIECE and BKPIECE
+/// (OMPLWorkspaceProjection). The validity checkers store the position of each valid state they checked from the forward kinematics
+/// of the check, so projecting the states of new motions costs a look-up. The positions are keyed by the exotica state, which OMPL
+/// copies bit-wise into the states of its motions. Positions of states missing from the cache are computed on a clone of the scene.
+class OMPLWorkspaceProjectionCache
+{
+public:
+    /// \param capacity Number of positions kept, the older half is evicted when the newer half is full.
+    OMPLWorkspaceProjectionCache(const SamplingProblemPtr &prob, const std::string &link, std::size_t capacity = 1 << 16);
+
+    /// \brief Stores the position of the link for the state q from the kinematics of the scene of the problem, which has to be updated to q.
+    void Store(Eigen::VectorXdRefConst q);
+
+    /// \brief Stores the position of the link for the state q from the kinematics of tree, e.g., of a validity workspace, which has to be updated to q.
+    void Store(Eigen::VectorXdRefConst q, const KinematicTree &tree);
+
+    /// \brief Returns the position of the link at the state q.
+    Eigen::Vector3d Get(Eigen::VectorXdRefConst q);
+
+    /// \brief Clears the positions and the statistics, and refreshes the clone of the scene if the world of the problem has changed.
+    void Clear();
+
+    std::size_t GetNumberOfHits() const { return hits_; }
+    std::size_t GetNumberOfMisses() const { return misses_; }
+
+private:
+    struct Entry
+    {
+        Eigen::VectorXd q;
+        Eigen::Vector3d position;
+    };
+    typedef std::unordered_multimap<std::size_t, Entry> EntryMap;
+
+    static std::size_t Hash(Eigen::VectorXdRefConst q);
+    static bool Find(const EntryMap &entries, std::size_t hash, Eigen::VectorXdRefConst q, Eigen::Vector3d &position);
+    void Insert(Eigen::VectorXdRefConst q, const Eigen::Vector3d &position);
+    void UpdateScene();
+
+    SamplingProblemPtr prob_;
+    std::string link_;
+    int handle_ = -1;             ///< Frame handle of the link in the scene of the problem
+    int root_handle_ = -1;        ///< Frame handle of the root in the scene of the problem
+    ScenePtr scene_;              ///< Clone of the scene computing the positions of the states missing from the cache
+    int scene_version_ = -1;      ///< World version of the scene of the problem when scene_ was cloned
+    int clone_handle_ = -1;       ///< Frame handle of the link in scene_
+    int clone_root_handle_ = -1;  ///< Frame handle of the root in scene_
+    std::size_t capacity_;        ///< Number of positions in entries_ and previous_entries_ together
+    std::mutex mutex_;            ///< Guards entries_, previous_entries_ and the statistics
+    std::mutex scene_mutex_;      ///< Guards scene_
+    EntryMap entries_;            ///< Positions stored since previous_entries_ were evicted
+    EntryMap previous_entries_;   ///< Older positions, evicted when entries_ holds half the capacity
+    std::size_t hits_ = 0;
+    std::size_t misses_ = 0;
 };
 
 class OMPLStateValidityChecker : public ompl::base::StateValidityChecker
@@ -78,8 +179,107 @@ public:
 
     bool isValid(const ompl::base::State *state, double &dist) const override;
 
+    /// \brief Checks the state and computes its clearance, the distance of the robot to collision capped at check_margin. Self-collision
+    /// distances count half, since both links move. States checked on a workspace clone (see SetNumberOfWorkspaces) get a clearance of 0,
+    /// invalid states a clearance of -1.
+    bool IsValid(const ompl::base::State *state, double &clearance, double check_margin) const;
+
+    /// \brief Sets up thread-safe validity checking for planners running on several threads. The threads other than the calling
+    /// thread are assigned one of num_workspaces clones of the scene (SamplingProblem::PrepareValidityWorkspaces) in the order
+    /// of their first check, further threads share the problem under a lock. With 0 workspaces, states are checked on the problem only.
+    /// Has to be called from the thread calling the planner, before planning.
+    void SetNumberOfWorkspaces(int num_workspaces);
+
+    /// \brief Stores the workspace positions of the valid states in cache (null: none).
+    void SetProjectionCache(const std::shared_ptr<OMPLWorkspaceProjectionCache> &cache) { projection_cache_ = cache; }
+
 protected:
+    /// \brief Checks the state, and computes its clearance if clearance is not null.
+    bool CheckState(const ompl::base::State *state, double *clearance, double check_margin) const;
+
     SamplingProblemPtr prob_;
+
+    /// \brief Workspace assigned to a thread in a generation of SetNumberOfWorkspaces (-1: the thread checks states on prob_)
+    struct ThreadWorkspace
+    {
+        std::uint64_t generation = 0;
+        int workspace = -1;
+    };
+
+    int num_workspaces_ = 0;
+    std::uint64_t generation_ = 0;                ///< Generation of the last SetNumberOfWorkspaces, 0 before the first
+    std::thread::id planning_thread_;             ///< Thread checking states on prob_ directly
+    mutable std::atomic<int> next_workspace_{0};  ///< Next workspace to assign to a thread
+    mutable std::mutex problem_mutex_;            ///< Guards the checks on prob_ once workspaces are set up
+    std::shared_ptr<OMPLWorkspaceProjectionCache> projection_cache_;
+};
+
+/// \brief Discrete motion validator checking the interpolated states of a motion as one batch with SamplingProblem::AreStatesValid,
+/// which checks them in parallel with ValidityNumThreads > 1. The states are interpolated at the resolution of the state space.
+class OMPLMotionValidator : public ompl::base::MotionValidator
+{
+public:
+    OMPLMotionValidator(const ompl::base::SpaceInformationPtr &si, const SamplingProblemPtr &prob);
+
+    bool checkMotion(const ompl::base::State *s1, const ompl::base::State *s2) const override;
+
+    bool checkMotion(const ompl::base::State *s1, const ompl::base::State *s2, std::pair<ompl::base::State *, double> &last_valid) const override;
+
+    /// \brief Stores the workspace position of the end state of each valid motion in cache (null: none).
+    void SetProjectionCache(const std::shared_ptr<OMPLWorkspaceProjectionCache> &cache) { projection_cache_ = cache; }
+
+protected:
+    /// \brief Returns the index of the first invalid state of the num_segments states interpolated from s1 (excluded) to s2 (included), or num_segments if all are valid.
+    int GetFirstInvalidState(const ompl::base::State *s1, const ompl::base::State *s2, int num_segments) const;
+
+    SamplingProblemPtr prob_;
+    std::shared_ptr<OMPLWorkspaceProjectionCache> projection_cache_;
+};
+
+/// \brief Motion validator stepping along a motion by the clearance of its states (conservative advancement). No point of the robot
+/// moves further than lipschitz_constant times the distance in the state space, so the next state is placed clearance / lipschitz_constant
+/// further along the motion, or one longest valid segment further where this is less. The clearance to self-collisions is half the
+/// distance of the links, which move up to 2 lipschitz_constant relative to each other. On open workspaces, most motions need a few
+/// checks, near obstacles the states of the fine steps are only checked for validity. The state validity checker of the space information
+/// has to be an OMPLStateValidityChecker.
+class OMPLClearanceMotionValidator : public ompl::base::MotionValidator
+{
+public:
+    OMPLClearanceMotionValidator(const ompl::base::SpaceInformationPtr &si, double lipschitz_constant);
+
+    bool checkMotion(const ompl::base::State *s1, const ompl::base::State *s2) const override;
+
+    bool checkMotion(const ompl::base::State *s1, const ompl::base::State *s2, std::pair<ompl::base::State *, double> &last_valid) const override;
+
+protected:
+    /// \brief Returns whether the motion from s1 (assumed valid) to s2 is valid, otherwise sets last_valid_time to the fraction of the motion known to be valid.
+    bool CheckMotion(const ompl::base::State *s1, const ompl::base::State *s2, double &last_valid_time) const;
+
+    double lipschitz_constant_;
+};
+
+/// \brief Motion validator checking the collisions of each motion with one continuous query of all robot links
+/// (CollisionScene::ContinuousCollisionCheckTrajectory) and the other constraints of the problem at the end state only.
+/// The query interpolates the poses of the links, not the joints, hence it approximates the swept volume of long motions.
+/// In hybrid mode, contacts found by the query are confirmed with discrete checks at the resolution of the state space, and
+/// collision scenes without continuous queries are checked discretely throughout.
+class OMPLContinuousMotionValidator : public ompl::base::MotionValidator
+{
+public:
+    OMPLContinuousMotionValidator(const ompl::base::SpaceInformationPtr &si, const SamplingProblemPtr &prob, bool hybrid);
+
+    bool checkMotion(const ompl::base::State *s1, const ompl::base::State *s2) const override;
+
+    bool checkMotion(const ompl::base::State *s1, const ompl::base::State *s2, std::pair<ompl::base::State *, double> &last_valid) const override;
+
+protected:
+    /// \brief Returns whether the motion from s1 (assumed valid) to s2 is valid, otherwise sets last_valid_time to the fraction of the motion known to be valid.
+    bool CheckMotion(const ompl::base::State *s1, const ompl::base::State *s2, double &last_valid_time) const;
+
+    SamplingProblemPtr prob_;
+    bool hybrid_;
+    bool continuous_ = true;  ///< Whether the collision scene supports continuous queries
+    ompl::base::DiscreteMotionValidator discrete_validator_;
 };
 
 class OMPLRNStateSpace : public OMPLStateSpace
@@ -108,6 +308,7 @@ public:
     void SetBounds(SamplingProblemPtr &prob) override;
     void ExoticaToOMPLState(const Eigen::VectorXd &q, ompl::base::State *state) const override;
     void OMPLToExoticaState(const ompl::base::State *state, Eigen::VectorXd &q) const override;
+    Eigen::Map<const Eigen::VectorXd> GetExoticaState(const ompl::base::State *state, Eigen::VectorXd &buffer) const override;
     void StateDebug(const Eigen::VectorXd &q) const override;
 };
 
@@ -341,6 +542,34 @@ public:
 private:
     std::vector<int> variables_;
 };
+
+/// \brief Projects states to the workspace position of a link, e.g., of the end-effector, for KPIECE and BKPIECE. The positions
+/// are taken from the forward kinematics of the validity checks (OMPLWorkspaceProjectionCache).
+class OMPLWorkspaceProjection : public ompl::base::ProjectionEvaluator
+{
+public:
+    OMPLWorkspaceProjection(const ompl::base::StateSpacePtr &space, const std::shared_ptr<OMPLWorkspaceProjectionCache> &cache, double cell_size)
+        : ompl::base::ProjectionEvaluator(space), cache_(cache), cell_size_(cell_size)
+    {
+    }
+
+    unsigned int getDimension(void) const override
+    {
+        return 3;
+    }
+
+    void defaultCellSizes() override
+    {
+        cellSizes_.assign(3, cell_size_);
+    }
+
+    void project(const ompl::base::State *state,
+                 OMPLProjection projection) const override;
+
+private:
+    std::shared_ptr<OMPLWorkspaceProjectionCache> cache_;
+    double cell_size_;
+};
 }  // namespace exotica
 
 #endif  // EXOTICA_OMPL_SOLVER_OMPL_EXO_H_
@@ -85,6 +85,13 @@ public:
     int MilestoneCount();
     bool IsMultiQuery() const;
     void SetMultiQuery(bool val);
+
+    /// \brief Writes the roadmap (milestones and edges) and the hash of the scene it was validated against to a binary file.
+    void SaveRoadmap(const std::string& filename);
+
+    /// \brief Replaces the roadmap with one written by SaveRoadmap and switches to multi-query mode.
+    ///        If the scene has changed since the roadmap was saved, invalid milestones and edges are removed.
+    void LoadRoadmap(const std::string& filename);
 };
 
 class LazyPRMSolver : public OMPLSolver<SamplingProblem>, Instantiable<LazyPRMSolverInitializer>
@@ -99,6 +106,13 @@ public:
     int MilestoneCount();
     bool IsMultiQuery() const;
     void SetMultiQuery(bool val);
+
+    /// \brief Writes the roadmap (milestones and edges) and the hash of the scene it was saved in to a binary file.
+    void SaveRoadmap(const std::string& filename);
+
+    /// \brief Replaces the roadmap with one written by SaveRoadmap and switches to multi-query mode.
+    ///        Milestones and edges of the loaded roadmap are re-validated lazily when a query uses them.
+    void LoadRoadmap(const std::string& filename);
 };
 
 class RRTStarSolver : public OMPLSolver<SamplingProblem>, Instantiable<RRTStarSolverInitializer>
@@ -74,6 +74,13 @@ public:
     void SetValidSegmentCountFactor(unsigned int factor) { state_space_->setValidSegmentCountFactor(factor); }
     unsigned int GetValidSegmentCountFactor() const { return state_space_->getValidSegmentCountFactor(); }
 
+    /// \brief Returns the time of each state of the last solution if it was time-parameterised (PostProcess), otherwise an empty vector.
+    const Eigen::VectorXd &GetSolutionTimes() const { return solution_times_; }
+
+    /// \brief Sets the states (one per row) around which DemonstrationSampleRatio of the samples are drawn, e.g., previous solutions of similar problems.
+    void SetDemonstrationStates(Eigen::MatrixXdRefConst states);
+    const Eigen::MatrixXd &GetDemonstrationStates() const { return demonstration_states_; }
+
 protected:
     template <typename T>
     static ompl::base::PlannerPtr AllocatePlanner(const ompl::base::SpaceInformationPtr &si, const std::string &new_name)
@@ -88,14 +95,29 @@ protected:
     void PreSolve();
     void PostSolve();
     void GetPath(Eigen::MatrixXd &traj, ompl::base::PlannerTerminationCondition &ptc);
+
+    /// \brief Shortcuts, smooths and time-parameterises the states of the solution path (PostProcess), see path_post_processing.h.
+    void PostProcessPath(const ompl::geometric::PathGeometric &pg, Eigen::MatrixXd &traj, ompl::base::PlannerTerminationCondition &ptc);
+
+    /// \brief Creates and sets up the planners racing the planner of the simple setup (NumParallelPlanners, PortfolioPlanners).
+    void SetUpParallelPlanners();
+
+    /// \brief Runs the planner of the simple setup and the parallel planners until the first exact solution.
+    ompl::base::PlannerStatus SolveParallel(const ompl::base::PlannerTerminationCondition &ptc);
+
     OMPLSolverInitializer init_;
     std::shared_ptr<ProblemType> prob_;
     ompl::geometric::SimpleSetupPtr ompl_simple_setup_;
     ompl::base::StateSpacePtr state_space_;
+    ompl_ptr<OMPLStateValidityChecker> validity_checker_;
+    std::shared_ptr<OMPLWorkspaceProjectionCache> projection_cache_;  // workspace positions of the states (ProjectionLink)
+    std::vector<ompl::base::PlannerPtr> parallel_planners_;  // planners racing the planner of the simple setup
     ConfiguredPlannerAllocator planner_allocator_;
     std::string algorithm_;
     bool multi_query_ = false;
     std::vector<double> bounds_;  // original bounds for locked state space
+    Eigen::VectorXd solution_times_;        // times of the states of the last solution, see GetSolutionTimes
+    Eigen::MatrixXd demonstration_states_;  // states the default samplers are biased towards, see SetDemonstrationStates
 };
 }  // namespace exotica
 
@@ -0,0 +1,65 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_OMPL_SOLVER_PATH_POST_PROCESSING_H_
+#define EXOTICA_OMPL_SOLVER_PATH_POST_PROCESSING_H_
+
+#include <exotica_core/problems/sampling_problem.h>
+
+#include <ompl/base/PlannerTerminationCondition.h>
+
+namespace exotica
+{
+/// \brief Randomised shortcutting of a path (one state per row) in batches. Each round draws batch_size pairs of points along the path
+/// and checks the straight connections of all of them as one batch with SamplingProblem::AreStatesValid, i.e., in parallel with
+/// ValidityNumThreads > 1. The valid connections replace the sections of the path between their points, longest saving first,
+/// skipping those overlapping a connection already applied.
+/// \param resolution Maximum distance between the checked states of a connection.
+/// \return Number of shortcuts applied.
+int ShortcutPath(Eigen::MatrixXd &path, const SamplingProblemPtr &prob, double resolution, int num_rounds, int batch_size, const ompl::base::PlannerTerminationCondition &ptc);
+
+/// \brief Smooths a path (one state per row) with the clamped uniform cubic B-spline using its states as control points, sampled with
+/// at most resolution between samples. The samples are checked with SamplingProblem::AreStatesValid and, with continuous_collision_check,
+/// with CollisionScene::ContinuousCollisionCheckTrajectory. Where a sample is invalid, the control points of its span are repeated three
+/// times, which pulls the spline onto the path around them, and the spline is checked again.
+/// \return Whether a valid spline was found, otherwise smooth_path is the path itself.
+bool SmoothPath(Eigen::MatrixXdRefConst path, const SamplingProblemPtr &prob, double resolution, bool continuous_collision_check, Eigen::MatrixXd &smooth_path);
+
+/// \brief Returns the times at which the states of a path (one per row) are reached when moving along it as fast as the velocity and
+/// acceleration limits of the joints allow, starting and ending at rest. The accelerations along the path and around its corners are
+/// bounded. Limits which are not positive and finite do not constrain the motion, e.g., without acceleration limits, each segment
+/// is traversed at the velocity limits of its joints.
+Eigen::VectorXd TimeParameterisePath(Eigen::MatrixXdRefConst path, Eigen::VectorXdRefConst velocity_limits, Eigen::VectorXdRefConst acceleration_limits);
+
+/// \brief Interpolates a time-parameterised path linearly at multiples of dt. The last sample is the last state of the path.
+/// \param[out] sample_times Times of the samples.
+Eigen::MatrixXd ResamplePath(Eigen::MatrixXdRefConst path, Eigen::VectorXdRefConst times, double dt, Eigen::VectorXd &sample_times);
+}  // namespace exotica
+
+#endif  // EXOTICA_OMPL_SOLVER_PATH_POST_PROCESSING_H_
@@ -27,6 +27,11 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+
 #include <exotica_ompl_solver/ompl_exo.h>
 
 namespace exotica
@@ -37,28 +42,484 @@ OMPLStateValidityChecker::OMPLStateValidityChecker(const ompl::base::SpaceInform
 
 bool OMPLStateValidityChecker::isValid(const ompl::base::State *state) const
 {
-    double tmp = 0.0;
-    return isValid(state, tmp);
+    return CheckState(state, nullptr, 0.0);
 }
 
 bool OMPLStateValidityChecker::isValid(const ompl::base::State *state, double &dist) const
 {
-    Eigen::VectorXd q(prob_->N);
+    return CheckState(state, &dist, std::numeric_limits<double>::infinity());
+}
+
+bool OMPLStateValidityChecker::IsValid(const ompl::base::State *state, double &clearance, double check_margin) const
+{
+    return CheckState(state, &clearance, check_margin);
+}
+
+OMPLWorkspaceProjectionCache::OMPLWorkspaceProjectionCache(const SamplingProblemPtr &prob, const std::string &link, std::size_t capacity) : prob_(prob), link_(link), capacity_(capacity)
+{
+    if (!prob_->GetScene()->GetKinematicTree().HasModelLink(link)) ThrowPretty("Unknown projection link '" << link << "'!");
+    UpdateScene();
+}
+
+void OMPLWorkspaceProjectionCache::UpdateScene()
+{
+    // Adding objects rebuilds the tree and may change the handles
+    handle_ = prob_->GetScene()->GetKinematicTree().GetFrameHandle(link_);
+    root_handle_ = prob_->GetScene()->GetKinematicTree().GetFrameHandle("");
+    scene_ = prob_->GetScene()->Clone();
+    scene_->StopDebugPublisher();
+    scene_->debug_ = false;
+    scene_version_ = prob_->GetScene()->GetWorldVersion();
+    clone_handle_ = scene_->GetKinematicTree().GetFrameHandle(link_);
+    clone_root_handle_ = scene_->GetKinematicTree().GetFrameHandle("");
+}
+
+std::size_t OMPLWorkspaceProjectionCache::Hash(Eigen::VectorXdRefConst q)
+{
+    std::size_t hash = 0;
+    for (int i = 0; i < q.rows(); ++i)
+        hash ^= std::hash<double>()(q(i)) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+bool OMPLWorkspaceProjectionCache::Find(const EntryMap &entries, std::size_t hash, Eigen::VectorXdRefConst q, Eigen::Vector3d &position)
+{
+    const auto range = entries.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.q == q)
+        {
+            position = it->second.position;
+            return true;
+        }
+    }
+    return false;
+}
+
+void OMPLWorkspaceProjectionCache::Insert(Eigen::VectorXdRefConst q, const Eigen::Vector3d &position)
+{
+    // Evicts the older half rather than all positions, so the positions of the recent motions survive
+    if (2 * entries_.size() >= capacity_)
+    {
+        previous_entries_.swap(entries_);
+        entries_.clear();
+    }
+    entries_.emplace(Hash(q), Entry{q, position});
+}
+
+void OMPLWorkspaceProjectionCache::Store(Eigen::VectorXdRefConst q)
+{
+    const KDL::Frame frame = prob_->GetScene()->GetKinematicTree().FK(handle_, KDL::Frame(), root_handle_, KDL::Frame());
+    std::lock_guard<std::mutex> lock(mutex_);
+    Insert(q, Eigen::Map<const Eigen::Vector3d>(frame.p.data));
+}
+
+void OMPLWorkspaceProjectionCache::Store(Eigen::VectorXdRefConst q, const KinematicTree &tree)
+{
+    const KDL::Frame frame = tree.FK(tree.GetFrameHandle(link_), KDL::Frame(), tree.GetFrameHandle(""), KDL::Frame());
+    std::lock_guard<std::mutex> lock(mutex_);
+    Insert(q, Eigen::Map<const Eigen::Vector3d>(frame.p.data));
+}
+
+Eigen::Vector3d OMPLWorkspaceProjectionCache::Get(Eigen::VectorXdRefConst q)
+{
+    Eigen::Vector3d position;
+    const std::size_t hash = Hash(q);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (Find(entries_, hash, q, position) || Find(previous_entries_, hash, q, position))
+        {
+            ++hits_;
+            return position;
+        }
+        ++misses_;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(scene_mutex_);
+        scene_->Update(q);
+        position = Eigen::Map<const Eigen::Vector3d>(scene_->GetKinematicTree().FK(clone_handle_, KDL::Frame(), clone_root_handle_, KDL::Frame()).p.data);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Insert(q, position);
+    return position;
+}
+
+void OMPLWorkspaceProjectionCache::Clear()
+{
+    {
+        // Attached objects and custom links may have moved the link since the clone was created
+        std::lock_guard<std::mutex> lock(scene_mutex_);
+        if (scene_version_ != prob_->GetScene()->GetWorldVersion()) UpdateScene();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    previous_entries_.clear();
+    hits_ = 0;
+    misses_ = 0;
+}
+
+void OMPLWorkspaceProjection::project(const ompl::base::State *state, OMPLProjection projection) const
+{
+    // Projections are computed from several threads with parallel planners
+    static thread_local Eigen::VectorXd buffer;
+    const Eigen::Vector3d position = cache_->Get(static_cast<const OMPLStateSpace *>(space_)->GetExoticaState(state, buffer));
+    for (int i = 0; i < 3; ++i) projection(i) = position(i);
+}
 
+bool OMPLStateValidityChecker::CheckState(const ompl::base::State *state, double *clearance, double check_margin) const
+{
+    // States are checked from several threads with parallel planners
+    static thread_local Eigen::VectorXd buffer;
 #if ROS_VERSION_MINIMUM(1, 12, 0)  // if ROS version >= ROS_KINETIC
-    std::static_pointer_cast<OMPLStateSpace>(si_->getStateSpace())->OMPLToExoticaState(state, q);
+    const Eigen::Map<const Eigen::VectorXd> q = std::static_pointer_cast<OMPLStateSpace>(si_->getStateSpace())->GetExoticaState(state, buffer);
 #else
-    boost::static_pointer_cast<OMPLStateSpace>(si_->getStateSpace())->OMPLToExoticaState(state, q);
+    const Eigen::Map<const Eigen::VectorXd> q = boost::static_pointer_cast<OMPLStateSpace>(si_->getStateSpace())->GetExoticaState(state, buffer);
 #endif
 
-    if (!prob_->IsStateValid(q))
+    // The distance query reuses the collision object transforms of the validity check (see CollisionScene::GetCachedCollisionDistance).
+    // Both elements of a self-collision move with the robot, their distance closes twice as fast as the distance to the world.
+    const auto get_clearance = [this, clearance, check_margin]() {
+        if (clearance == nullptr) return;
+        const auto moves_with_robot = [](const std::shared_ptr<KinematicElement> &element) { return element->is_robot_link || !element->closest_robot_link.expired(); };
+        *clearance = check_margin;
+        for (const CollisionProxy &proxy : prob_->GetScene()->GetCollisionScene()->GetCachedCollisionDistance(true, 2.0 * check_margin))
+        {
+            const double distance = std::max(proxy.distance, 0.0);
+            *clearance = std::min(*clearance, moves_with_robot(proxy.e1) && moves_with_robot(proxy.e2) ? 0.5 * distance : distance);
+        }
+    };
+
+    // The workspace projection reads the kinematics of the check
+    const auto store_projection = [this, &q]() {
+        if (projection_cache_) projection_cache_->Store(q);
+    };
+
+    bool valid;
+    if (num_workspaces_ == 0)
+    {
+        valid = prob_->IsStateValid(q);
+        if (valid) store_projection();
+        if (valid) get_clearance();
+    }
+    else
+    {
+        // Each planner thread checks its states on its own clone, the clones are assigned on the first check of a thread. The
+        // assignment is kept per thread and is only valid for the generation of SetNumberOfWorkspaces it was made in
+        static thread_local ThreadWorkspace thread_workspace;
+        if (thread_workspace.generation != generation_)
+        {
+            thread_workspace.generation = generation_;
+            thread_workspace.workspace = -1;
+            if (std::this_thread::get_id() != planning_thread_)
+            {
+                const int next = next_workspace_++;
+                if (next < num_workspaces_) thread_workspace.workspace = next;
+            }
+        }
+        const int workspace = thread_workspace.workspace;
+        if (workspace >= 0)
+        {
+            valid = prob_->IsStateValid(q, workspace);
+            if (valid && projection_cache_) projection_cache_->Store(q, prob_->GetValidityWorkspaceScene(workspace)->GetKinematicTree());
+            // Distances are only queried on the problem itself
+            if (clearance != nullptr) *clearance = 0.0;
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(problem_mutex_);
+            valid = prob_->IsStateValid(q);
+            if (valid) store_projection();
+            if (valid) get_clearance();
+        }
+    }
+
+    if (!valid)
     {
-        dist = -1;
+        if (clearance != nullptr) *clearance = -1;
         return false;
     }
     return true;
 }
 
+void OMPLStateValidityChecker::SetNumberOfWorkspaces(int num_workspaces)
+{
+    // The generations are unique across checkers, a thread never reuses the assignment of another checker
+    static std::atomic<std::uint64_t> generations(0);
+    if (num_workspaces > 0) prob_->PrepareValidityWorkspaces(num_workspaces);
+    num_workspaces_ = num_workspaces;
+    planning_thread_ = std::this_thread::get_id();
+    next_workspace_ = 0;
+    generation_ = ++generations;
+}
+
+OMPLMotionValidator::OMPLMotionValidator(const ompl::base::SpaceInformationPtr &si, const SamplingProblemPtr &prob) : ompl::base::MotionValidator(si), prob_(prob)
+{
+}
+
+int OMPLMotionValidator::GetFirstInvalidState(const ompl::base::State *s1, const ompl::base::State *s2, int num_segments) const
+{
+#if ROS_VERSION_MINIMUM(1, 12, 0)  // if ROS version >= ROS_KINETIC
+    const std::shared_ptr<OMPLStateSpace> state_space = std::static_pointer_cast<OMPLStateSpace>(si_->getStateSpace());
+#else
+    const boost::shared_ptr<OMPLStateSpace> state_space = boost::static_pointer_cast<OMPLStateSpace>(si_->getStateSpace());
+#endif
+
+    Eigen::MatrixXd states(num_segments, prob_->N);
+    Eigen::VectorXd q(prob_->N);
+    ompl::base::State *state = si_->allocState();
+    for (int j = 1; j <= num_segments; ++j)
+    {
+        state_space->interpolate(s1, s2, static_cast<double>(j) / static_cast<double>(num_segments), state);
+        states.row(j - 1) = state_space->GetExoticaState(state, q).transpose();
+    }
+    si_->freeState(state);
+
+    const std::vector<bool> valid = prob_->AreStatesValid(states, true);
+    for (int j = 0; j < num_segments; ++j)
+    {
+        if (!valid[j]) return j;
+    }
+
+    // The end state becomes the state of the new motion. Checked serially, it is the last state of the scene. Checked in
+    // parallel, it is the last state of the workspace of the last block.
+    if (projection_cache_ && num_segments > 0)
+    {
+        const int num_threads = std::min(prob_->GetValidityNumThreads(), num_segments);
+        const KinematicTree &tree = num_threads <= 1 ? prob_->GetScene()->GetKinematicTree() : prob_->GetValidityWorkspaceScene(num_threads - 1)->GetKinematicTree();
+        if (tree.GetControlledState() == states.row(num_segments - 1).transpose()) projection_cache_->Store(states.row(num_segments - 1).transpose(), tree);
+    }
+    return num_segments;
+}
+
+bool OMPLMotionValidator::checkMotion(const ompl::base::State *s1, const ompl::base::State *s2) const
+{
+    const int num_segments = static_cast<int>(si_->getStateSpace()->validSegmentCount(s1, s2));
+    const bool result = GetFirstInvalidState(s1, s2, num_segments) == num_segments;
+    if (result)
+        ++valid_;
+    else
+        ++invalid_;
+    return result;
+}
+
+bool OMPLMotionValidator::checkMotion(const ompl::base::State *s1, const ompl::base::State *s2, std::pair<ompl::base::State *, double> &last_valid) const
+{
+    const int num_segments = static_cast<int>(si_->getStateSpace()->validSegmentCount(s1, s2));
+    const int first_invalid = GetFirstInvalidState(s1, s2, num_segments);
+    const bool result = first_invalid == num_segments;
+    if (!result)
+    {
+        last_valid.second = static_cast<double>(first_invalid) / static_cast<double>(num_segments);
+        if (last_valid.first != nullptr) si_->getStateSpace()->interpolate(s1, s2, last_valid.second, last_valid.first);
+    }
+    if (result)
+        ++valid_;
+    else
+        ++invalid_;
+    return result;
+}
+
+OMPLContinuousMotionValidator::OMPLContinuousMotionValidator(const ompl::base::SpaceInformationPtr &si, const SamplingProblemPtr &prob, bool hybrid) : ompl::base::MotionValidator(si), prob_(prob), hybrid_(hybrid), discrete_validator_(si)
+{
+    // Probes whether the collision scene implements continuous queries
+    try
+    {
+        prob_->GetScene()->GetCollisionScene()->ContinuousCollisionCheckTrajectory(prob_->GetScene()->GetKinematicTree().GetControlledState().transpose(), true);
+    }
+    catch (const Exception &e)
+    {
+        if (!hybrid_) ThrowPretty("Continuous motion validation requires a collision scene implementing ContinuousCollisionCheckTrajectory: " << e.what());
+        WARNING("The collision scene does not support continuous queries, motions are checked discretely.");
+        continuous_ = false;
+    }
+}
+
+bool OMPLContinuousMotionValidator::CheckMotion(const ompl::base::State *s1, const ompl::base::State *s2, double &last_valid_time) const
+{
+    last_valid_time = 0.0;
+    if (!continuous_)
+    {
+        std::pair<ompl::base::State *, double> last_valid(nullptr, 0.0);
+        const bool valid = discrete_validator_.checkMotion(s1, s2, last_valid);
+        last_valid_time = last_valid.second;
+        return valid;
+    }
+
+    const double distance = si_->distance(s1, s2);
+    const double resolution = si_->getStateSpace()->getLongestValidSegmentLength();
+    // The validity checker also stores the workspace projection of s2
+    if (!si_->isValid(s2)) return false;
+    if (distance <= resolution) return true;
+
+#if ROS_VERSION_MINIMUM(1, 12, 0)  // if ROS version >= ROS_KINETIC
+    const std::shared_ptr<OMPLStateSpace> state_space = std::static_pointer_cast<OMPLStateSpace>(si_->getStateSpace());
+#else
+    const boost::shared_ptr<OMPLStateSpace> state_space = boost::static_pointer_cast<OMPLStateSpace>(si_->getStateSpace());
+#endif
+    Eigen::MatrixXd states(2, prob_->N);
+    Eigen::VectorXd q(prob_->N);
+    states.row(0) = state_space->GetExoticaState(s1, q).transpose();
+    states.row(1) = state_space->GetExoticaState(s2, q).transpose();
+
+    double time_of_contact = 1.0;
+    for (const ContinuousCollisionProxy &proxy : prob_->GetScene()->GetCollisionScene()->ContinuousCollisionCheckTrajectory(states, true))
+    {
+        if (proxy.in_collision) time_of_contact = std::min(time_of_contact, proxy.time_of_contact);
+    }
+    if (time_of_contact >= 1.0) return true;
+
+    if (hybrid_)
+    {
+        std::pair<ompl::base::State *, double> last_valid(nullptr, 0.0);
+        const bool valid = discrete_validator_.checkMotion(s1, s2, last_valid);
+        last_valid_time = last_valid.second;
+        return valid;
+    }
+
+    // Keeps one longest valid segment away from the contact
+    last_valid_time = std::max(0.0, time_of_contact - resolution / distance);
+    return false;
+}
+
+bool OMPLContinuousMotionValidator::checkMotion(const ompl::base::State *s1, const ompl::base::State *s2) const
+{
+    double last_valid_time;
+    const bool result = CheckMotion(s1, s2, last_valid_time);
+    if (result)
+        ++valid_;
+    else
+        ++invalid_;
+    return result;
+}
+
+bool OMPLContinuousMotionValidator::checkMotion(const ompl::base::State *s1, const ompl::base::State *s2, std::pair<ompl::base::State *, double> &last_valid) const
+{
+    double last_valid_time;
+    const bool result = CheckMotion(s1, s2, last_valid_time);
+    if (!result)
+    {
+        last_valid.second = last_valid_time;
+        if (last_valid.first != nullptr) si_->getStateSpace()->interpolate(s1, s2, last_valid.second, last_valid.first);
+    }
+    if (result)
+        ++valid_;
+    else
+        ++invalid_;
+    return result;
+}
+
+OMPLClearanceMotionValidator::OMPLClearanceMotionValidator(const ompl::base::SpaceInformationPtr &si, double lipschitz_constant) : ompl::base::MotionValidator(si), lipschitz_constant_(lipschitz_constant)
+{
+    if (lipschitz_constant_ <= 0.0) ThrowPretty("The Lipschitz constant has to be positive, given: " << lipschitz_constant_);
+}
+
+bool OMPLClearanceMotionValidator::CheckMotion(const ompl::base::State *s1, const ompl::base::State *s2, double &last_valid_time) const
+{
+    const OMPLStateValidityChecker *validity_checker = static_cast<const OMPLStateValidityChecker *>(si_->getStateValidityChecker().get());
+    const double distance = si_->distance(s1, s2);
+    const double resolution = si_->getStateSpace()->getLongestValidSegmentLength();
+    last_valid_time = 0.0;
+    if (distance <= resolution) return si_->isValid(s2);
+
+    // The clearance of a state certifies the motion up to clearance / lipschitz_constant_ further along
+    double clearance = 0.0;
+    validity_checker->IsValid(s1, clearance, lipschitz_constant_ * distance);
+
+    // Near obstacles the steps are one longest valid segment whatever the clearance, i.e., the states only need the boolean check. The
+    // clearance is queried again after a few such steps to find out whether the motion left the obstacles behind.
+    constexpr int max_steps_without_clearance = 4;
+    int steps_without_clearance = 0;
+    ompl::base::State *state = si_->allocState();
+    bool valid = true;
+    double t = 0.0;
+    while (t < 1.0)
+    {
+        const double step = clearance / lipschitz_constant_;
+        const double next_t = std::min(t + std::max(step, resolution) / distance, 1.0);
+        si_->getStateSpace()->interpolate(s1, s2, next_t, state);
+        if (next_t >= 1.0 || (step < resolution && ++steps_without_clearance < max_steps_without_clearance))
+        {
+            valid = si_->isValid(state);
+            clearance = 0.0;
+        }
+        else
+        {
+            // Only the clearance up to the end of the motion is needed
+            steps_without_clearance = 0;
+            valid = validity_checker->IsValid(state, clearance, lipschitz_constant_ * distance * (1.0 - next_t));
+        }
+        if (!valid) break;
+        t = next_t;
+    }
+    si_->freeState(state);
+    last_valid_time = t;
+    return valid;
+}
+
+bool OMPLClearanceMotionValidator::checkMotion(const ompl::base::State *s1, const ompl::base::State *s2) const
+{
+    double last_valid_time;
+    const bool result = CheckMotion(s1, s2, last_valid_time);
+    if (result)
+        ++valid_;
+    else
+        ++invalid_;
+    return result;
+}
+
+bool OMPLClearanceMotionValidator::checkMotion(const ompl::base::State *s1, const ompl::base::State *s2, std::pair<ompl::base::State *, double> &last_valid) const
+{
+    double last_valid_time;
+    const bool result = CheckMotion(s1, s2, last_valid_time);
+    if (!result)
+    {
+        last_valid.second = last_valid_time;
+        if (last_valid.first != nullptr) si_->getStateSpace()->interpolate(s1, s2, last_valid.second, last_valid.first);
+    }
+    if (result)
+        ++valid_;
+    else
+        ++invalid_;
+    return result;
+}
+
+ompl::base::StateSamplerPtr OMPLStateSpace::AllocDemonstrationSampler(const ompl::base::StateSamplerPtr &uniform_sampler) const
+{
+    if (init_.DemonstrationSampleRatio <= 0.0) return uniform_sampler;
+    return ompl::base::StateSamplerPtr(new OMPLDemonstrationStateSampler(this, uniform_sampler, demonstration_states_, init_.DemonstrationSampleRatio, init_.DemonstrationSampleStdDev));
+}
+
+OMPLDemonstrationStateSampler::OMPLDemonstrationStateSampler(const OMPLStateSpace *space, const ompl::base::StateSamplerPtr &uniform_sampler, const std::shared_ptr<const Eigen::MatrixXd> &demonstration_states, double ratio, double standard_deviation)
+    : ompl::base::StateSampler(space), exotica_space_(space), uniform_sampler_(uniform_sampler), demonstration_states_(demonstration_states), ratio_(ratio), standard_deviation_(standard_deviation)
+{
+}
+
+void OMPLDemonstrationStateSampler::sampleUniform(ompl::base::State *state)
+{
+    const Eigen::MatrixXd &states = *demonstration_states_;
+    if (states.rows() == 0 || rng_.uniform01() >= ratio_)
+    {
+        uniform_sampler_->sampleUniform(state);
+        return;
+    }
+
+    q_ = states.row(rng_.uniformInt(0, static_cast<int>(states.rows()) - 1)).transpose();
+    for (int i = 0; i < q_.rows(); ++i) q_(i) += rng_.gaussian(0.0, standard_deviation_);
+    exotica_space_->ExoticaToOMPLState(q_, state);
+    space_->enforceBounds(state);
+}
+
+void OMPLDemonstrationStateSampler::sampleUniformNear(ompl::base::State *state, const ompl::base::State *near, double distance)
+{
+    uniform_sampler_->sampleUniformNear(state, near, distance);
+}
+
+void OMPLDemonstrationStateSampler::sampleGaussian(ompl::base::State *state, const ompl::base::State *mean, double standard_deviation)
+{
+    uniform_sampler_->sampleGaussian(state, mean, standard_deviation);
+}
+
 OMPLRNStateSpace::OMPLRNStateSpace(OMPLSolverInitializer init) : OMPLStateSpace(init)
 {
     setName("OMPLRNStateSpace");
@@ -66,7 +527,7 @@ OMPLRNStateSpace::OMPLRNStateSpace(OMPLSolverInitializer init) : OMPLStateSpace(
 
 ompl::base::StateSamplerPtr OMPLRNStateSpace::allocDefaultStateSampler() const
 {
-    return CompoundStateSpace::allocDefaultStateSampler();
+    return AllocDemonstrationSampler(CompoundStateSpace::allocDefaultStateSampler());
 }
 
 void OMPLRNStateSpace::SetBounds(SamplingProblemPtr &prob)
@@ -100,6 +561,7 @@ void OMPLRNStateSpace::ExoticaToOMPLState(const Eigen::VectorXd &q, ompl::base::
 
 void OMPLRNStateSpace::OMPLToExoticaState(const ompl::base::State *state, Eigen::VectorXd &q) const
 {
+    EXOTICA_PROFILE_SCOPE("OMPLRNStateSpace::OMPLToExoticaState");
     if (!state)
     {
         ThrowPretty("Invalid state!");
@@ -109,6 +571,15 @@ void OMPLRNStateSpace::OMPLToExoticaState(const ompl::base::State *state, Eigen:
     memcpy(q.data(), state->as<OMPLRNStateSpace::StateType>()->getRNSpace().values, sizeof(double) * q.rows());
 }
 
+Eigen::Map<const Eigen::VectorXd> OMPLRNStateSpace::GetExoticaState(const ompl::base::State *state, Eigen::VectorXd & /*buffer*/) const
+{
+    if (!state)
+    {
+        ThrowPretty("Invalid state!");
+    }
+    return Eigen::Map<const Eigen::VectorXd>(state->as<OMPLRNStateSpace::StateType>()->getRNSpace().values, getDimension());
+}
+
 void OMPLRNStateSpace::StateDebug(const Eigen::VectorXd &q) const
 {
     //  TODO
@@ -121,7 +592,7 @@ OMPLSE3RNStateSpace::OMPLSE3RNStateSpace(OMPLSolverInitializer init) : OMPLState
 
 ompl::base::StateSamplerPtr OMPLSE3RNStateSpace::allocDefaultStateSampler() const
 {
-    return CompoundStateSpace::allocDefaultStateSampler();
+    return AllocDemonstrationSampler(CompoundStateSpace::allocDefaultStateSampler());
 }
 
 void OMPLSE3RNStateSpace::SetBounds(SamplingProblemPtr &prob)
@@ -186,7 +657,9 @@ void OMPLSE3RNStateSpace::ExoticaToOMPLState(const Eigen::VectorXd &q, ompl::bas
 
 void OMPLSE3RNStateSpace::OMPLToExoticaState(const ompl::base::State *state, Eigen::VectorXd &q) const
 {
-    q.setZero(getDimension());
+    EXOTICA_PROFILE_SCOPE("OMPLSE3RNStateSpace::OMPLToExoticaState");
+    // Every element is overwritten below
+    if (q.rows() != static_cast<int>(getDimension())) q.resize(getDimension());
     const OMPLSE3RNStateSpace::StateType *statetype = static_cast<const OMPLSE3RNStateSpace::StateType *>(state);
     q(0) = statetype->SE3StateSpace().getX();
     q(1) = statetype->SE3StateSpace().getY();
@@ -208,7 +681,7 @@ OMPLSE2RNStateSpace::OMPLSE2RNStateSpace(OMPLSolverInitializer init) : OMPLState
 
 ompl::base::StateSamplerPtr OMPLSE2RNStateSpace::allocDefaultStateSampler() const
 {
-    return CompoundStateSpace::allocDefaultStateSampler();
+    return AllocDemonstrationSampler(CompoundStateSpace::allocDefaultStateSampler());
 }
 
 void OMPLSE2RNStateSpace::SetBounds(SamplingProblemPtr &prob)
@@ -270,7 +743,9 @@ void OMPLSE2RNStateSpace::ExoticaToOMPLState(const Eigen::VectorXd &q, ompl::bas
 
 void OMPLSE2RNStateSpace::OMPLToExoticaState(const ompl::base::State *state, Eigen::VectorXd &q) const
 {
-    q.setZero(getDimension());
+    EXOTICA_PROFILE_SCOPE("OMPLSE2RNStateSpace::OMPLToExoticaState");
+    // Every element is overwritten below
+    if (q.rows() != static_cast<int>(getDimension())) q.resize(getDimension());
     const OMPLSE2RNStateSpace::StateType *statetype = static_cast<const OMPLSE2RNStateSpace::StateType *>(state);
     q(0) = statetype->SE2StateSpace().getX();
     q(1) = statetype->SE2StateSpace().getY();
@@ -289,7 +764,7 @@ OMPLDubinsRNStateSpace::OMPLDubinsRNStateSpace(OMPLSolverInitializer init) : OMP
 
 ompl::base::StateSamplerPtr OMPLDubinsRNStateSpace::allocDefaultStateSampler() const
 {
-    return CompoundStateSpace::allocDefaultStateSampler();
+    return AllocDemonstrationSampler(CompoundStateSpace::allocDefaultStateSampler());
 }
 
 void OMPLDubinsRNStateSpace::SetBounds(SamplingProblemPtr &prob)
@@ -351,7 +826,9 @@ void OMPLDubinsRNStateSpace::ExoticaToOMPLState(const Eigen::VectorXd &q, ompl::
 
 void OMPLDubinsRNStateSpace::OMPLToExoticaState(const ompl::base::State *state, Eigen::VectorXd &q) const
 {
-    q.setZero(getDimension());
+    EXOTICA_PROFILE_SCOPE("OMPLDubinsRNStateSpace::OMPLToExoticaState");
+    // Every element is overwritten below
+    if (q.rows() != static_cast<int>(getDimension())) q.resize(getDimension());
     const OMPLDubinsRNStateSpace::StateType *statetype = static_cast<const OMPLDubinsRNStateSpace::StateType *>(state);
     q(0) = statetype->DubinsStateSpace().getX();
     q(1) = statetype->DubinsStateSpace().getY();
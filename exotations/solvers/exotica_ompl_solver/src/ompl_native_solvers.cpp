@@ -27,6 +27,13 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+#include <ompl/base/PlannerDataStorage.h>
 #include <ompl/geometric/planners/cforest/CForest.h>
 #include <ompl/geometric/planners/est/EST.h>
 #include <ompl/geometric/planners/kpiece/BKPIECE1.h>
@@ -53,6 +60,132 @@ REGISTER_MOTIONSOLVER_TYPE("LBTRRTSolver", exotica::LBTRRTSolver)
 
 namespace exotica
 {
+namespace
+{
+constexpr char kRoadmapMagic[8] = {'E', 'X', 'O', 'R', 'M', 'A', 'P', '\0'};
+constexpr std::uint32_t kRoadmapFormatVersion = 1;
+
+// FNV-1a, unlike std::hash the result is stable between runs and builds
+void HashBytes(std::uint64_t &hash, const void *data, std::size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+// Numbers are serialised in little-endian byte order, the hashes and roadmap files do not depend on the byte order of the host
+template <typename T>
+void ToLittleEndian(std::uint64_t value, unsigned char (&bytes)[sizeof(T)])
+{
+    for (std::size_t i = 0; i < sizeof(T); ++i) bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+template <typename T>
+T FromLittleEndian(const unsigned char (&bytes)[sizeof(T)])
+{
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i) value |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+    return static_cast<T>(value);
+}
+
+void HashDouble(std::uint64_t &hash, double value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    unsigned char bytes[sizeof(bits)];
+    ToLittleEndian<std::uint64_t>(bits, bytes);
+    HashBytes(hash, bytes, sizeof(bytes));
+}
+
+void HashString(std::uint64_t &hash, const std::string &value)
+{
+    HashBytes(hash, value.c_str(), value.size() + 1);
+}
+
+// Hash of everything a validated roadmap depends on: the controlled joints, their limits, the collision geometry of the world and
+// the objects attached to the robot with their poses relative to their parents.
+std::uint64_t GetSceneHash(const ScenePtr &scene)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    const KinematicTree &tree = scene->GetKinematicTree();
+    for (const std::string &joint : tree.GetControlledJointNames()) HashString(hash, joint);
+    const Eigen::MatrixXd &joint_limits = tree.GetJointLimits();
+    for (Eigen::Index i = 0; i < joint_limits.size(); ++i) HashDouble(hash, joint_limits.data()[i]);
+    HashString(hash, scene->GetScene());
+    for (const std::pair<const std::string, AttachedObject> &object : scene->GetAttachedObjects())
+    {
+        HashString(hash, object.first);
+        HashString(hash, object.second.parent);
+        const KDL::Frame pose = tree.FK(object.first, KDL::Frame(), object.second.parent, KDL::Frame());
+        for (int i = 0; i < 3; ++i) HashDouble(hash, pose.p.data[i]);
+        for (int i = 0; i < 9; ++i) HashDouble(hash, pose.M.data[i]);
+    }
+    return hash;
+}
+
+void WriteRoadmap(const std::string &filename, const ompl::base::PlannerData &data, std::uint64_t scene_hash)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) ThrowPretty("Cannot open '" << filename << "' for writing!");
+    unsigned char version[sizeof(std::uint32_t)], hash[sizeof(std::uint64_t)];
+    ToLittleEndian<std::uint32_t>(kRoadmapFormatVersion, version);
+    ToLittleEndian<std::uint64_t>(scene_hash, hash);
+    file.write(kRoadmapMagic, sizeof(kRoadmapMagic));
+    file.write(reinterpret_cast<const char *>(version), sizeof(version));
+    file.write(reinterpret_cast<const char *>(hash), sizeof(hash));
+    ompl::base::PlannerDataStorage().store(data, file);
+    if (!file.good()) ThrowPretty("Failed to write roadmap to '" << filename << "'!");
+}
+
+// Returns the scene hash stored with the roadmap.
+std::uint64_t ReadRoadmap(const std::string &filename, ompl::base::PlannerData &data)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) ThrowPretty("Cannot open '" << filename << "' for reading!");
+    char magic[sizeof(kRoadmapMagic)];
+    unsigned char version_bytes[sizeof(std::uint32_t)], hash_bytes[sizeof(std::uint64_t)];
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(version_bytes), sizeof(version_bytes));
+    file.read(reinterpret_cast<char *>(hash_bytes), sizeof(hash_bytes));
+    if (!file.good() || std::memcmp(magic, kRoadmapMagic, sizeof(magic)) != 0) ThrowPretty("'" << filename << "' is not a roadmap file!");
+    const std::uint32_t version = FromLittleEndian<std::uint32_t>(version_bytes);
+    const std::uint64_t scene_hash = FromLittleEndian<std::uint64_t>(hash_bytes);
+    if (version != kRoadmapFormatVersion) ThrowPretty("Unsupported roadmap format version " << version << " in '" << filename << "'!");
+    ompl::base::PlannerDataStorage().load(file, data);
+    if (data.numVertices() == 0) WARNING("Roadmap '" << filename << "' is empty.");
+    return scene_hash;
+}
+
+// Removes the edges and milestones of the roadmap which are not valid in the current scene.
+void RevalidateRoadmap(ompl::base::PlannerData &data, const ompl::base::SpaceInformationPtr &si)
+{
+    // Edges are stored in both directions, each motion is only checked once
+    std::map<std::pair<unsigned int, unsigned int>, bool> checked_motions;
+    std::vector<unsigned int> edges;
+    for (unsigned int i = 0; i < data.numVertices(); ++i)
+    {
+        data.getEdges(i, edges);
+        for (const unsigned int j : edges)
+        {
+            const std::pair<unsigned int, unsigned int> motion(std::min(i, j), std::max(i, j));
+            auto it = checked_motions.find(motion);
+            if (it == checked_motions.end())
+                it = checked_motions.emplace(motion, si->checkMotion(data.getVertex(i).getState(), data.getVertex(j).getState())).first;
+            if (!it->second) data.removeEdge(i, j);
+        }
+    }
+
+    // Removing a vertex re-indexes the ones after it
+    for (unsigned int i = data.numVertices(); i-- > 0;)
+    {
+        if (!si->isValid(data.getVertex(i).getState())) data.removeVertex(i);
+    }
+}
+}  // namespace
+
 RRTStarSolver::RRTStarSolver() = default;
 
 void RRTStarSolver::Instantiate(const RRTStarSolverInitializer &init)
@@ -191,6 +324,36 @@ void PRMSolver::SetMultiQuery(bool val)
     multi_query_ = val;
 }
 
+void PRMSolver::SaveRoadmap(const std::string &filename)
+{
+    if (!ompl_simple_setup_ || !ompl_simple_setup_->getPlanner()) ThrowPretty("The roadmap has not been created yet, solve or grow the roadmap first!");
+    ompl::base::PlannerData data(ompl_simple_setup_->getSpaceInformation());
+    ompl_simple_setup_->getPlanner()->getPlannerData(data);
+    WriteRoadmap(filename, data, GetSceneHash(prob_->GetScene()));
+}
+
+void PRMSolver::LoadRoadmap(const std::string &filename)
+{
+    if (!ompl_simple_setup_) ThrowPretty("Problem has not been set!");
+    if (!state_space_->as<OMPLStateSpace>()->isLocked()) state_space_->as<OMPLStateSpace>()->SetBounds(prob_);
+    if (!ompl_simple_setup_->getSpaceInformation()->isSetup()) ompl_simple_setup_->getSpaceInformation()->setup();
+
+    ompl::base::PlannerData data(ompl_simple_setup_->getSpaceInformation());
+    if (ReadRoadmap(filename, data) != GetSceneHash(prob_->GetScene()))
+    {
+        const unsigned int milestones = data.numVertices(), edges = data.numEdges();
+        RevalidateRoadmap(data, ompl_simple_setup_->getSpaceInformation());
+        HIGHLIGHT_NAMED(algorithm_, "Scene has changed since the roadmap was saved, removed " << milestones - data.numVertices() << " milestones and " << edges - data.numEdges() << " edges.");
+    }
+
+    ompl::base::PlannerPtr planner(new ompl::geometric::PRM(data));
+    planner->setName(algorithm_);
+    planner->setProblemDefinition(ompl_simple_setup_->getProblemDefinition());
+    ompl_simple_setup_->setPlanner(planner);
+    // Solving in single-query mode would clear the roadmap
+    multi_query_ = true;
+}
+
 LazyPRMSolver::LazyPRMSolver() = default;
 
 void LazyPRMSolver::Instantiate(const LazyPRMSolverInitializer &init)
@@ -240,4 +403,31 @@ void LazyPRMSolver::SetMultiQuery(bool val)
 {
     multi_query_ = val;
 }
+
+void LazyPRMSolver::SaveRoadmap(const std::string &filename)
+{
+    if (!ompl_simple_setup_ || !ompl_simple_setup_->getPlanner()) ThrowPretty("The roadmap has not been created yet, solve first!");
+    ompl::base::PlannerData data(ompl_simple_setup_->getSpaceInformation());
+    ompl_simple_setup_->getPlanner()->getPlannerData(data);
+    WriteRoadmap(filename, data, GetSceneHash(prob_->GetScene()));
+}
+
+void LazyPRMSolver::LoadRoadmap(const std::string &filename)
+{
+    if (!ompl_simple_setup_) ThrowPretty("Problem has not been set!");
+    if (!state_space_->as<OMPLStateSpace>()->isLocked()) state_space_->as<OMPLStateSpace>()->SetBounds(prob_);
+    if (!ompl_simple_setup_->getSpaceInformation()->isSetup()) ompl_simple_setup_->getSpaceInformation()->setup();
+
+    ompl::base::PlannerData data(ompl_simple_setup_->getSpaceInformation());
+    if (ReadRoadmap(filename, data) != GetSceneHash(prob_->GetScene()))
+        HIGHLIGHT_NAMED(algorithm_, "Scene has changed since the roadmap was saved, milestones and edges will be re-validated on use.");
+
+    // LazyPRM checks the validity of loaded milestones and edges when a query first uses them
+    ompl::base::PlannerPtr planner(new ompl::geometric::LazyPRM(data));
+    planner->setName(algorithm_);
+    planner->setProblemDefinition(ompl_simple_setup_->getProblemDefinition());
+    ompl_simple_setup_->setPlanner(planner);
+    // Solving in single-query mode would clear the roadmap
+    multi_query_ = true;
+}
 }  // namespace exotica
@@ -33,6 +33,7 @@
 #include <pybind11/stl.h>
 
 #include <exotica_ompl_solver/ompl_native_solvers.h>
+#include <exotica_ompl_solver/path_post_processing.h>
 
 using namespace exotica;
 namespace py = pybind11;
@@ -43,8 +44,18 @@ PYBIND11_MODULE(exotica_ompl_solver_py, module)
 
     py::module::import("pyexotica");
 
+    module.def("time_parameterise_path", &TimeParameterisePath, "Times at which the states of a path (one per row) are reached under the velocity and acceleration limits, starting and ending at rest.", py::arg("path"), py::arg("velocity_limits"), py::arg("acceleration_limits"));
+    module.def("resample_path", [](Eigen::MatrixXdRefConst path, Eigen::VectorXdRefConst times, double dt) {
+        Eigen::VectorXd sample_times;
+        Eigen::MatrixXd samples = ResamplePath(path, times, dt, sample_times);
+        return py::make_tuple(samples, sample_times);
+    },
+               "Interpolates a time-parameterised path linearly at multiples of dt, returns the samples and their times.", py::arg("path"), py::arg("times"), py::arg("dt"));
+
     py::class_<OMPLSolver<SamplingProblem>, std::shared_ptr<OMPLSolver<SamplingProblem>>, MotionSolver> ompl_solver(module, "OMPLMotionSolver");
     ompl_solver.def("GetRandomSeed", &OMPLSolver<SamplingProblem>::GetRandomSeed);
+    ompl_solver.def_property_readonly("solution_times", &OMPLSolver<SamplingProblem>::GetSolutionTimes);
+    ompl_solver.def_property("demonstration_states", &OMPLSolver<SamplingProblem>::GetDemonstrationStates, &OMPLSolver<SamplingProblem>::SetDemonstrationStates);
 
     // State-space properties exposed via OMPLSolver
     ompl_solver.def_property_readonly("maximum_extent", &OMPLSolver<SamplingProblem>::GetMaximumExtent);
@@ -71,6 +82,8 @@ PYBIND11_MODULE(exotica_ompl_solver_py, module)
     prm.def("setup", &PRMSolver::Setup);
     prm.def("edge_count", &PRMSolver::EdgeCount);
     prm.def("milestone_count", &PRMSolver::MilestoneCount);
+    prm.def("save_roadmap", &PRMSolver::SaveRoadmap);
+    prm.def("load_roadmap", &PRMSolver::LoadRoadmap);
 
     py::class_<LazyPRMSolver, std::shared_ptr<LazyPRMSolver>, OMPLSolver<SamplingProblem>> lprm(module, "LazyPRMSolver");
     lprm.def_property("multi_query", &LazyPRMSolver::IsMultiQuery, &LazyPRMSolver::SetMultiQuery);
@@ -79,4 +92,6 @@ PYBIND11_MODULE(exotica_ompl_solver_py, module)
     lprm.def("setup", &LazyPRMSolver::Setup);
     lprm.def("edge_count", &LazyPRMSolver::EdgeCount);
     lprm.def("milestone_count", &LazyPRMSolver::MilestoneCount);
+    lprm.def("save_roadmap", &LazyPRMSolver::SaveRoadmap);
+    lprm.def("load_roadmap", &LazyPRMSolver::LoadRoadmap);
 }
@@ -28,12 +28,82 @@
 //
 
 #include <exotica_ompl_solver/ompl_solver.h>
-
+#include <exotica_ompl_solver/path_post_processing.h>
+
+#include <ompl/base/samplers/BridgeTestValidStateSampler.h>
+#include <ompl/base/samplers/GaussianValidStateSampler.h>
+#include <ompl/base/samplers/MaximizeClearanceValidStateSampler.h>
+#include <ompl/base/samplers/ObstacleBasedValidStateSampler.h>
+#include <ompl/geometric/planners/est/EST.h>
+#include <ompl/geometric/planners/kpiece/BKPIECE1.h>
+#include <ompl/geometric/planners/kpiece/KPIECE1.h>
+#include <ompl/geometric/planners/prm/LazyPRM.h>
+#include <ompl/geometric/planners/prm/PRM.h>
+#include <ompl/geometric/planners/rrt/LBTRRT.h>
+#include <ompl/geometric/planners/rrt/RRT.h>
+#include <ompl/geometric/planners/rrt/RRTConnect.h>
+#include <ompl/geometric/planners/rrt/RRTstar.h>
+#include <ompl/tools/multiplan/ParallelPlan.h>
 #include <ompl/util/Console.h>
 #include <ompl/util/RandomNumbers.h>
 
 namespace exotica
 {
+namespace
+{
+ompl::base::PlannerPtr AllocatePortfolioPlanner(const ompl::base::SpaceInformationPtr &si, const std::string &name)
+{
+    ompl::base::PlannerPtr planner;
+    if (name == "RRT")
+        planner.reset(new ompl::geometric::RRT(si));
+    else if (name == "RRTConnect")
+        planner.reset(new ompl::geometric::RRTConnect(si));
+    else if (name == "PRM")
+        planner.reset(new ompl::geometric::PRM(si));
+    else if (name == "LazyPRM")
+        planner.reset(new ompl::geometric::LazyPRM(si));
+    else if (name == "EST")
+        planner.reset(new ompl::geometric::EST(si));
+    else if (name == "KPIECE")
+        planner.reset(new ompl::geometric::KPIECE1(si));
+    else if (name == "BKPIECE")
+        planner.reset(new ompl::geometric::BKPIECE1(si));
+    else if (name == "RRTStar")
+        planner.reset(new ompl::geometric::RRTstar(si));
+    else if (name == "LBTRRT")
+        planner.reset(new ompl::geometric::LBTRRT(si));
+    else
+        ThrowPretty("Unknown portfolio planner '" << name << "'!");
+    planner->setName("Exotica_" + name + "_Portfolio");
+    return planner;
+}
+
+ompl::base::ValidStateSamplerPtr AllocateValidStateSampler(const ompl::base::SpaceInformation *si, const std::string &name, double standard_deviation)
+{
+    if (name == "Gaussian")
+    {
+        ompl::base::GaussianValidStateSampler *sampler = new ompl::base::GaussianValidStateSampler(si);
+        if (standard_deviation > 0.0) sampler->setStdDev(standard_deviation);
+        return ompl::base::ValidStateSamplerPtr(sampler);
+    }
+    else if (name == "BridgeTest")
+    {
+        ompl::base::BridgeTestValidStateSampler *sampler = new ompl::base::BridgeTestValidStateSampler(si);
+        if (standard_deviation > 0.0) sampler->setStdDev(standard_deviation);
+        return ompl::base::ValidStateSamplerPtr(sampler);
+    }
+    else if (name == "ObstacleBased")
+    {
+        return ompl::base::ValidStateSamplerPtr(new ompl::base::ObstacleBasedValidStateSampler(si));
+    }
+    else if (name == "MaximizeClearance")
+    {
+        return ompl::base::ValidStateSamplerPtr(new ompl::base::MaximizeClearanceValidStateSampler(si));
+    }
+    ThrowPretty("Unknown valid state sampler '" << name << "', use one of: Uniform, Gaussian, BridgeTest, ObstacleBased, MaximizeClearance");
+}
+}  // namespace
+
 template <class ProblemType>
 OMPLSolver<ProblemType>::OMPLSolver() = default;
 
@@ -59,7 +129,50 @@ void OMPLSolver<ProblemType>::SpecifyProblem(PlanningProblemPtr pointer)
     else
         ThrowNamed("Unsupported base type " << prob_->GetScene()->GetKinematicTree().GetControlledBaseType());
     ompl_simple_setup_.reset(new ompl::geometric::SimpleSetup(state_space_));
-    ompl_simple_setup_->setStateValidityChecker(ompl::base::StateValidityCheckerPtr(new OMPLStateValidityChecker(ompl_simple_setup_->getSpaceInformation(), prob_)));
+    // The validity checks fill the cache of the workspace projection
+    projection_cache_.reset();
+    if (!init_.ProjectionLink.empty())
+    {
+        if (init_.Projection.rows() > 0) ThrowNamed("Projection and ProjectionLink can't be combined!");
+        if (init_.ProjectionCellSize <= 0.0) ThrowNamed("ProjectionCellSize has to be positive, given: " << init_.ProjectionCellSize);
+        projection_cache_ = std::make_shared<OMPLWorkspaceProjectionCache>(prob_, init_.ProjectionLink);
+    }
+    validity_checker_.reset(new OMPLStateValidityChecker(ompl_simple_setup_->getSpaceInformation(), prob_));
+    validity_checker_->SetProjectionCache(projection_cache_);
+    ompl_simple_setup_->setStateValidityChecker(validity_checker_);
+    parallel_planners_.clear();
+    // The batch motion validator checks on the clones of the problem itself, which the planner threads of a parallel plan would share
+    const bool parallel_planning = init_.NumParallelPlanners > 1 || !init_.PortfolioPlanners.empty();
+    if (init_.ClearanceMotionValidation)
+    {
+        if (init_.BatchMotionValidation) WARNING_NAMED(algorithm_, "BatchMotionValidation is ignored with ClearanceMotionValidation.");
+        if (init_.ContinuousMotionValidation) WARNING_NAMED(algorithm_, "ContinuousMotionValidation is ignored with ClearanceMotionValidation.");
+        if (init_.ClearanceLipschitzConstant <= 0.0) ThrowNamed("ClearanceMotionValidation requires a positive ClearanceLipschitzConstant, given: " << init_.ClearanceLipschitzConstant);
+        ompl_simple_setup_->getSpaceInformation()->setMotionValidator(ompl::base::MotionValidatorPtr(new OMPLClearanceMotionValidator(ompl_simple_setup_->getSpaceInformation(), init_.ClearanceLipschitzConstant)));
+    }
+    else if (init_.ContinuousMotionValidation && parallel_planning)
+        WARNING_NAMED(algorithm_, "ContinuousMotionValidation is not supported with parallel planners and is ignored.");
+    else if (init_.ContinuousMotionValidation)
+    {
+        if (init_.BatchMotionValidation) WARNING_NAMED(algorithm_, "BatchMotionValidation is ignored with ContinuousMotionValidation.");
+        ompl_simple_setup_->getSpaceInformation()->setMotionValidator(ompl::base::MotionValidatorPtr(new OMPLContinuousMotionValidator(ompl_simple_setup_->getSpaceInformation(), prob_, init_.ContinuousMotionValidationHybrid)));
+    }
+    else if (init_.BatchMotionValidation && parallel_planning)
+        WARNING_NAMED(algorithm_, "BatchMotionValidation is not supported with parallel planners and is ignored.");
+    else if (init_.BatchMotionValidation)
+    {
+        OMPLMotionValidator *motion_validator = new OMPLMotionValidator(ompl_simple_setup_->getSpaceInformation(), prob_);
+        motion_validator->SetProjectionCache(projection_cache_);
+        ompl_simple_setup_->getSpaceInformation()->setMotionValidator(ompl::base::MotionValidatorPtr(motion_validator));
+    }
+    if (init_.ValidStateSampler != "Uniform")
+    {
+        // Fails early on unknown samplers rather than when the planner first allocates one
+        AllocateValidStateSampler(ompl_simple_setup_->getSpaceInformation().get(), init_.ValidStateSampler, init_.ValidStateSamplerStdDev);
+        const std::string sampler = init_.ValidStateSampler;
+        const double standard_deviation = init_.ValidStateSamplerStdDev;
+        ompl_simple_setup_->getSpaceInformation()->setValidStateSamplerAllocator([sampler, standard_deviation](const ompl::base::SpaceInformation *si) { return AllocateValidStateSampler(si, sampler, standard_deviation); });
+    }
     ompl_simple_setup_->setPlannerAllocator(boost::bind(planner_allocator_, _1, algorithm_));
 
     if (init_.Projection.rows() > 0)
@@ -77,6 +190,9 @@ void OMPLSolver<ProblemType>::SpecifyProblem(PlanningProblemPtr pointer)
         else if (prob_->GetScene()->GetKinematicTree().GetControlledBaseType() == BaseType::FLOATING)
             ompl_simple_setup_->getStateSpace()->registerDefaultProjection(ompl::base::ProjectionEvaluatorPtr(new OMPLSE3RNProjection(state_space_, project_vars)));
     }
+
+    if (projection_cache_)
+        ompl_simple_setup_->getStateSpace()->registerDefaultProjection(ompl::base::ProjectionEvaluatorPtr(new OMPLWorkspaceProjection(state_space_, projection_cache_, init_.ProjectionCellSize)));
 }
 
 template <class ProblemType>
@@ -98,6 +214,7 @@ void OMPLSolver<ProblemType>::PreSolve()
         ompl_simple_setup_->getPlanner()->setProblemDefinition(ompl_simple_setup_->getProblemDefinition());
     }
     ompl_simple_setup_->getSpaceInformation()->getMotionValidator()->resetMotionCounter();
+    if (projection_cache_) projection_cache_->Clear();
 }
 
 template <class ProblemType>
@@ -107,6 +224,7 @@ void OMPLSolver<ProblemType>::PostSolve()
     int v = ompl_simple_setup_->getSpaceInformation()->getMotionValidator()->getValidMotionCount();
     int iv = ompl_simple_setup_->getSpaceInformation()->getMotionValidator()->getInvalidMotionCount();
     if (debug_) CONSOLE_BRIDGE_logDebug("There were %d valid motions and %d invalid motions.", v, iv);
+    if (debug_ && projection_cache_) CONSOLE_BRIDGE_logDebug("Workspace projection: %zu cached and %zu computed positions.", projection_cache_->GetNumberOfHits(), projection_cache_->GetNumberOfMisses());
 
     if (ompl_simple_setup_->getProblemDefinition()->hasApproximateSolution())
         CONSOLE_BRIDGE_logWarn("Computed solution is approximate");
@@ -146,6 +264,11 @@ void OMPLSolver<ProblemType>::GetPath(Eigen::MatrixXd &traj, ompl::base::Planner
     const ompl::base::SpaceInformationPtr &si = ompl_simple_setup_->getSpaceInformation();
 
     ompl::geometric::PathGeometric pg = ompl_simple_setup_->getSolutionPath();
+    if (init_.PostProcess)
+    {
+        PostProcessPath(pg, traj, ptc);
+        return;
+    }
     if (init_.Smooth)
     {
         bool try_more = true;
@@ -191,6 +314,89 @@ void OMPLSolver<ProblemType>::GetPath(Eigen::MatrixXd &traj, ompl::base::Planner
     }
 }
 
+template <class ProblemType>
+void OMPLSolver<ProblemType>::SetDemonstrationStates(Eigen::MatrixXdRefConst states)
+{
+    if (prob_ && states.rows() > 0 && states.cols() != prob_->N) ThrowNamed("Demonstration states (" << states.cols() << ") and problem (" << prob_->N << ") dimension disagree");
+    demonstration_states_ = states;
+}
+
+template <class ProblemType>
+void OMPLSolver<ProblemType>::PostProcessPath(const ompl::geometric::PathGeometric &pg, Eigen::MatrixXd &traj, ompl::base::PlannerTerminationCondition &ptc)
+{
+    Eigen::MatrixXd path(pg.getStateCount(), prob_->GetSpaceDim());
+    Eigen::VectorXd tmp(prob_->GetSpaceDim());
+    for (int i = 0; i < static_cast<int>(pg.getStateCount()); ++i)
+    {
+        state_space_->as<OMPLStateSpace>()->OMPLToExoticaState(pg.getState(i), tmp);
+        path.row(i) = tmp.transpose();
+    }
+
+    // Shortcuts and the spline are straight and smooth in the coordinates of the problem, which ignores the Dubins constraints
+    traj = path;
+    if (!init_.IsDubinsStateSpace)
+    {
+        // Shortcuts and the spline are checked at the resolution of the discrete motion validation
+        const double resolution = state_space_->getLongestValidSegmentLength();
+        const int num_shortcuts = ShortcutPath(path, prob_, resolution, init_.ShortcutRounds, init_.ShortcutBatchSize, ptc);
+        if (debug_) HIGHLIGHT_NAMED(algorithm_, "Applied " << num_shortcuts << " shortcuts, " << path.rows() << " states left.");
+        traj = path;
+        if (init_.BSplineSmoothing && !SmoothPath(path, prob_, resolution, init_.ContinuousCollisionCheck, traj))
+            WARNING_NAMED(algorithm_, "No valid B-spline found, returning the shortcut path.");
+    }
+
+    const KinematicTree &tree = prob_->GetScene()->GetKinematicTree();
+    solution_times_ = TimeParameterisePath(traj, tree.GetVelocityLimits(), tree.GetAccelerationLimits());
+    if (init_.PostProcessTimeStep > 0.0)
+    {
+        const Eigen::MatrixXd states = traj;
+        const Eigen::VectorXd times = solution_times_;
+        traj = ResamplePath(states, times, init_.PostProcessTimeStep, solution_times_);
+    }
+}
+
+template <class ProblemType>
+void OMPLSolver<ProblemType>::SetUpParallelPlanners()
+{
+    const int num_instances = std::max(1, init_.NumParallelPlanners);
+    const std::size_t num_planners = num_instances - 1 + init_.PortfolioPlanners.size();
+    if (parallel_planners_.size() != num_planners)
+    {
+        parallel_planners_.clear();
+        for (int i = 1; i < num_instances; ++i)
+            parallel_planners_.push_back(planner_allocator_(ompl_simple_setup_->getSpaceInformation(), algorithm_ + "_" + std::to_string(i)));
+        for (const std::string &name : init_.PortfolioPlanners)
+            parallel_planners_.push_back(AllocatePortfolioPlanner(ompl_simple_setup_->getSpaceInformation(), name));
+    }
+
+    for (const ompl::base::PlannerPtr &planner : parallel_planners_)
+    {
+        if (!multi_query_) planner->clear();
+        planner->setProblemDefinition(ompl_simple_setup_->getProblemDefinition());
+        if (planner->params().hasParam("Range"))
+            planner->params().setParam("Range", init_.Range);
+        if (planner->params().hasParam("GoalBias"))
+            planner->params().setParam("GoalBias", init_.GoalBias);
+        if (!planner->isSetup()) planner->setup();
+    }
+
+    // Every planner runs on its own thread and checks states on its own clone of the scene
+    validity_checker_->SetNumberOfWorkspaces(num_planners > 0 ? static_cast<int>(num_planners) + 1 : 0);
+}
+
+template <class ProblemType>
+ompl::base::PlannerStatus OMPLSolver<ProblemType>::SolveParallel(const ompl::base::PlannerTerminationCondition &ptc)
+{
+    ompl::tools::ParallelPlan parallel_plan(ompl_simple_setup_->getProblemDefinition());
+    parallel_plan.addPlanner(ompl_simple_setup_->getPlanner());
+    for (const ompl::base::PlannerPtr &planner : parallel_planners_) parallel_plan.addPlanner(planner);
+
+    // The first solution found terminates all planners
+    const ompl::base::PlannerStatus status = parallel_plan.solve(ptc, 1, parallel_planners_.size() + 1, false);
+    validity_checker_->SetNumberOfWorkspaces(0);
+    return status;
+}
+
 template <class ProblemType>
 void OMPLSolver<ProblemType>::Solve(Eigen::MatrixXd &solution)
 {
@@ -247,14 +453,28 @@ void OMPLSolver<ProblemType>::Solve(Eigen::MatrixXd &solution)
     state_space_->as<OMPLStateSpace>()->ExoticaToOMPLState(q0, ompl_start_state.get());
     ompl_simple_setup_->setStartState(ompl_start_state);
 
+    solution_times_.resize(0);
+    if (demonstration_states_.rows() > 0 && demonstration_states_.cols() != prob_->N) ThrowNamed("Demonstration states (" << demonstration_states_.cols() << ") and problem (" << prob_->N << ") dimension disagree");
+    state_space_->as<OMPLStateSpace>()->SetDemonstrationStates(demonstration_states_);
     PreSolve();
+    SetUpParallelPlanners();
     ompl::time::point start = ompl::time::now();
     ompl::base::PlannerTerminationCondition ptc = ompl::base::timedPlannerTerminationCondition(init_.Timeout - ompl::time::seconds(ompl::time::now() - start));
 
     Timer t;
-    if (ompl_simple_setup_->solve(ptc) == ompl::base::PlannerStatus::EXACT_SOLUTION && ompl_simple_setup_->haveSolutionPath())
+    const ompl::base::PlannerStatus status = parallel_planners_.empty() ? ompl_simple_setup_->solve(ptc) : SolveParallel(ptc);
+    if (status == ompl::base::PlannerStatus::EXACT_SOLUTION && ompl_simple_setup_->haveSolutionPath())
     {
         GetPath(solution, ptc);
+        if (init_.UseSolutionsAsDemonstrations && solution.cols() == prob_->N)
+        {
+            const int kept_rows = std::min<int>(demonstration_states_.rows(), std::max(0, init_.MaxDemonstrationStates - static_cast<int>(solution.rows())));
+            const int new_rows = std::min<int>(solution.rows(), std::max(0, init_.MaxDemonstrationStates));
+            Eigen::MatrixXd demonstration_states(kept_rows + new_rows, prob_->N);
+            demonstration_states.topRows(kept_rows) = demonstration_states_.bottomRows(kept_rows);
+            demonstration_states.bottomRows(new_rows) = solution.bottomRows(new_rows);
+            demonstration_states_ = std::move(demonstration_states);
+        }
     }
     planning_time_ = t.GetDuration();
     PostSolve();
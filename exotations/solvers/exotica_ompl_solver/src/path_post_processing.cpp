@@ -0,0 +1,326 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <ompl/util/RandomNumbers.h>
+
+#include <exotica_ompl_solver/path_post_processing.h>
+
+namespace exotica
+{
+namespace
+{
+// Arc length of the path up to each of its states
+Eigen::VectorXd GetArcLength(Eigen::MatrixXdRefConst path)
+{
+    Eigen::VectorXd arc_length = Eigen::VectorXd::Zero(path.rows());
+    for (int i = 1; i < path.rows(); ++i) arc_length(i) = arc_length(i - 1) + (path.row(i) - path.row(i - 1)).norm();
+    return arc_length;
+}
+
+// Returns the point at arc length s along the path, and the index of the segment it lies on
+Eigen::VectorXd GetPointAt(Eigen::MatrixXdRefConst path, const Eigen::VectorXd &arc_length, double s, int &segment)
+{
+    segment = static_cast<int>(std::upper_bound(arc_length.data(), arc_length.data() + arc_length.size(), s) - arc_length.data()) - 1;
+    segment = std::min(std::max(segment, 0), static_cast<int>(path.rows()) - 2);
+    const double length = arc_length(segment + 1) - arc_length(segment);
+    const double fraction = length > 0.0 ? std::min((s - arc_length(segment)) / length, 1.0) : 0.0;
+    return (path.row(segment) + fraction * (path.row(segment + 1) - path.row(segment))).transpose();
+}
+
+// Point of the span of the uniform cubic B-spline with control points p0 to p3 at 0 <= u <= 1
+Eigen::VectorXd EvaluateBSplineSpan(const Eigen::VectorXd &p0, const Eigen::VectorXd &p1, const Eigen::VectorXd &p2, const Eigen::VectorXd &p3, double u)
+{
+    const double u2 = u * u, u3 = u2 * u;
+    return ((1.0 - u) * (1.0 - u) * (1.0 - u) * p0 + (3.0 * u3 - 6.0 * u2 + 4.0) * p1 + (-3.0 * u3 + 3.0 * u2 + 3.0 * u + 1.0) * p2 + u3 * p3) / 6.0;
+}
+}  // namespace
+
+int ShortcutPath(Eigen::MatrixXd &path, const SamplingProblemPtr &prob, double resolution, int num_rounds, int batch_size, const ompl::base::PlannerTerminationCondition &ptc)
+{
+    if (resolution <= 0.0) ThrowPretty("The resolution has to be positive, given: " << resolution);
+
+    struct Shortcut
+    {
+        double begin, end;               ///< Arc length of the points on the path
+        int begin_segment, end_segment;  ///< Segments of the path the points lie on
+        Eigen::VectorXd begin_state, end_state;
+        double saving;                ///< Length of the section of the path minus the length of the shortcut
+        int first_state, num_states;  ///< Block of the checked states of the shortcut in the batch
+    };
+
+    ompl::RNG rng;
+    int num_applied = 0;
+    for (int round = 0; round < num_rounds && path.rows() > 2 && ptc == false; ++round)
+    {
+        const Eigen::VectorXd arc_length = GetArcLength(path);
+        const double total_length = arc_length(arc_length.size() - 1);
+        if (total_length <= 0.0) break;
+
+        std::vector<Shortcut> shortcuts;
+        int num_states = 0;
+        for (int k = 0; k < batch_size; ++k)
+        {
+            Shortcut shortcut;
+            shortcut.begin = rng.uniformReal(0.0, total_length);
+            shortcut.end = rng.uniformReal(0.0, total_length);
+            if (shortcut.begin > shortcut.end) std::swap(shortcut.begin, shortcut.end);
+            shortcut.begin_state = GetPointAt(path, arc_length, shortcut.begin, shortcut.begin_segment);
+            shortcut.end_state = GetPointAt(path, arc_length, shortcut.end, shortcut.end_segment);
+            // Points on the same segment are connected by the path already
+            if (shortcut.begin_segment == shortcut.end_segment) continue;
+            const double length = (shortcut.end_state - shortcut.begin_state).norm();
+            shortcut.saving = shortcut.end - shortcut.begin - length;
+            if (shortcut.saving <= std::numeric_limits<double>::epsilon() * total_length) continue;
+            shortcut.first_state = num_states;
+            shortcut.num_states = static_cast<int>(std::ceil(length / resolution)) + 1;
+            num_states += shortcut.num_states;
+            shortcuts.push_back(shortcut);
+        }
+        if (shortcuts.empty()) continue;
+
+        // All shortcuts of the round are checked as one batch, including their ends
+        Eigen::MatrixXd states(num_states, path.cols());
+        for (const Shortcut &shortcut : shortcuts)
+        {
+            for (int j = 0; j < shortcut.num_states; ++j)
+            {
+                const double fraction = shortcut.num_states > 1 ? static_cast<double>(j) / static_cast<double>(shortcut.num_states - 1) : 1.0;
+                states.row(shortcut.first_state + j) = (shortcut.begin_state + fraction * (shortcut.end_state - shortcut.begin_state)).transpose();
+            }
+        }
+        const std::vector<bool> valid = prob->AreStatesValid(states, false);
+
+        std::vector<const Shortcut *> candidates;
+        for (const Shortcut &shortcut : shortcuts)
+        {
+            if (std::all_of(valid.begin() + shortcut.first_state, valid.begin() + shortcut.first_state + shortcut.num_states, [](bool v) { return v; }))
+                candidates.push_back(&shortcut);
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Shortcut *a, const Shortcut *b) { return a->saving > b->saving; });
+        std::vector<const Shortcut *> applied;
+        for (const Shortcut *candidate : candidates)
+        {
+            if (std::none_of(applied.begin(), applied.end(), [candidate](const Shortcut *a) { return candidate->begin < a->end && a->begin < candidate->end; }))
+                applied.push_back(candidate);
+        }
+        if (applied.empty()) continue;
+        std::sort(applied.begin(), applied.end(), [](const Shortcut *a, const Shortcut *b) { return a->begin < b->begin; });
+
+        // Replaces the sections of the path, dropping states repeated where a shortcut begins or ends on a state of the path
+        std::vector<Eigen::VectorXd> new_path;
+        const auto append = [&new_path](const Eigen::VectorXd &state) {
+            if (new_path.empty() || (state - new_path.back()).norm() > 0.0) new_path.push_back(state);
+        };
+        int next = 0;
+        for (const Shortcut *shortcut : applied)
+        {
+            for (; next <= shortcut->begin_segment; ++next) append(path.row(next).transpose());
+            append(shortcut->begin_state);
+            append(shortcut->end_state);
+            next = shortcut->end_segment + 1;
+        }
+        for (; next < path.rows(); ++next) append(path.row(next).transpose());
+
+        path.resize(new_path.size(), path.cols());
+        for (std::size_t i = 0; i < new_path.size(); ++i) path.row(i) = new_path[i].transpose();
+        num_applied += static_cast<int>(applied.size());
+    }
+    return num_applied;
+}
+
+bool SmoothPath(Eigen::MatrixXdRefConst path, const SamplingProblemPtr &prob, double resolution, bool continuous_collision_check, Eigen::MatrixXd &smooth_path)
+{
+    if (resolution <= 0.0) ThrowPretty("The resolution has to be positive, given: " << resolution);
+    const int num_points = static_cast<int>(path.rows());
+    smooth_path = path;
+    if (num_points < 3) return true;
+
+    // Control points repeated three times are interpolated by the spline, the ends clamp it to the ends of the path
+    std::vector<bool> pinned(num_points, false);
+    pinned.front() = pinned.back() = true;
+    while (true)
+    {
+        std::vector<int> control_points;
+        for (int i = 0; i < num_points; ++i)
+            control_points.insert(control_points.end(), pinned[i] ? 3 : 1, i);
+
+        // Span k uses the control points k to k + 3
+        std::vector<Eigen::VectorXd> samples;
+        std::vector<int> sample_spans;
+        for (std::size_t k = 0; k + 3 < control_points.size(); ++k)
+        {
+            const Eigen::VectorXd p0 = path.row(control_points[k]).transpose(), p1 = path.row(control_points[k + 1]).transpose();
+            const Eigen::VectorXd p2 = path.row(control_points[k + 2]).transpose(), p3 = path.row(control_points[k + 3]).transpose();
+            // The length of the span is bounded by the length of its control polygon
+            const double length = (p1 - p0).norm() + (p2 - p1).norm() + (p3 - p2).norm();
+            const int num_samples = std::max(1, static_cast<int>(std::ceil(length / resolution)));
+            for (int j = k == 0 ? 0 : 1; j <= num_samples; ++j)
+            {
+                samples.push_back(EvaluateBSplineSpan(p0, p1, p2, p3, static_cast<double>(j) / static_cast<double>(num_samples)));
+                sample_spans.push_back(static_cast<int>(k));
+            }
+        }
+        Eigen::MatrixXd states(samples.size(), path.cols());
+        for (std::size_t i = 0; i < samples.size(); ++i) states.row(i) = samples[i].transpose();
+
+        const std::vector<bool> valid = prob->AreStatesValid(states, true);
+        int first_invalid = static_cast<int>(std::find(valid.begin(), valid.end(), false) - valid.begin());
+        if (continuous_collision_check && first_invalid == static_cast<int>(samples.size()))
+        {
+            // A contact at time t + s lies between the samples t and t + 1
+            for (const ContinuousCollisionProxy &proxy : prob->GetScene()->GetCollisionScene()->ContinuousCollisionCheckTrajectory(states, true))
+            {
+                if (proxy.in_collision) first_invalid = std::min(first_invalid, std::min(static_cast<int>(proxy.time_of_contact) + 1, static_cast<int>(samples.size()) - 1));
+            }
+        }
+        if (first_invalid == static_cast<int>(samples.size()))
+        {
+            smooth_path = states;
+            return true;
+        }
+
+        // Spans between pinned control points lie on the path, which is then invalid itself
+        const int span = sample_spans[first_invalid];
+        bool pinned_any = false;
+        for (const int i : {control_points[span + 1], control_points[span + 2]})
+        {
+            if (pinned[i]) continue;
+            pinned[i] = true;
+            pinned_any = true;
+        }
+        if (!pinned_any) break;
+    }
+    smooth_path = path;
+    return false;
+}
+
+Eigen::VectorXd TimeParameterisePath(Eigen::MatrixXdRefConst path, Eigen::VectorXdRefConst velocity_limits, Eigen::VectorXdRefConst acceleration_limits)
+{
+    if (velocity_limits.size() != path.cols() || acceleration_limits.size() != path.cols())
+        ThrowPretty("Limits (" << velocity_limits.size() << ", " << acceleration_limits.size() << ") and path (" << path.cols() << ") dimension disagree");
+
+    const int num_states = static_cast<int>(path.rows());
+    Eigen::VectorXd times = Eigen::VectorXd::Zero(num_states);
+    if (num_states < 2) return times;
+
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    const auto limit = [](double value) { return value > 0.0 && std::isfinite(value) ? value : inf; };
+
+    // Maximum speed and acceleration along each segment, in units of the path length
+    const int num_segments = num_states - 1;
+    Eigen::VectorXd length(num_segments), max_speed(num_segments), max_acceleration(num_segments);
+    Eigen::MatrixXd direction = Eigen::MatrixXd::Zero(path.cols(), num_segments);
+    for (int i = 0; i < num_segments; ++i)
+    {
+        length(i) = (path.row(i + 1) - path.row(i)).norm();
+        if (length(i) > 0.0) direction.col(i) = (path.row(i + 1) - path.row(i)).transpose() / length(i);
+        max_speed(i) = max_acceleration(i) = inf;
+        for (int j = 0; j < path.cols(); ++j)
+        {
+            if (direction(j, i) == 0.0) continue;
+            max_speed(i) = std::min(max_speed(i), limit(velocity_limits(j)) / std::abs(direction(j, i)));
+            max_acceleration(i) = std::min(max_acceleration(i), limit(acceleration_limits(j)) / std::abs(direction(j, i)));
+        }
+    }
+
+    Eigen::VectorXd speed = Eigen::VectorXd::Zero(num_states);
+    for (int i = 1; i < num_states - 1; ++i)
+    {
+        speed(i) = std::min(max_speed(i - 1), max_speed(i));
+        // The direction changes over the halves of the adjacent segments
+        const double ds = 0.5 * (length(i - 1) + length(i));
+        for (int j = 0; j < path.cols(); ++j)
+        {
+            const double turn = std::abs(direction(j, i) - direction(j, i - 1));
+            if (turn > 0.0) speed(i) = std::min(speed(i), std::sqrt(limit(acceleration_limits(j)) * ds / turn));
+        }
+    }
+
+    // Without an acceleration limit along the end segments, the path starts and ends at their speed limits
+    if (max_acceleration(0) == inf) speed(0) = max_speed(0);
+    if (max_acceleration(num_segments - 1) == inf) speed(num_segments) = max_speed(num_segments - 1);
+
+    // Forward and backward passes bound the change of speed by the acceleration along the path
+    for (int i = 0; i < num_segments; ++i)
+        speed(i + 1) = std::min(speed(i + 1), std::sqrt(speed(i) * speed(i) + 2.0 * max_acceleration(i) * length(i)));
+    for (int i = num_segments - 1; i >= 0; --i)
+        speed(i) = std::min(speed(i), std::sqrt(speed(i + 1) * speed(i + 1) + 2.0 * max_acceleration(i) * length(i)));
+
+    for (int i = 0; i < num_segments; ++i)
+    {
+        // Trapezoidal profile: accelerates from the speed at the start to the peak speed, cruises and decelerates to the speed at the end
+        const double v_0 = speed(i), v_1 = speed(i + 1), a = max_acceleration(i);
+        double peak = max_speed(i);
+        if (a < inf) peak = std::min(peak, std::sqrt(a * length(i) + 0.5 * (v_0 * v_0 + v_1 * v_1)));
+        double duration = 0.0;
+        if (length(i) > 0.0 && peak < inf)
+        {
+            duration = length(i) / peak;
+            if (a < inf) duration += (2.0 * peak - v_0 - v_1) / a - (2.0 * peak * peak - v_0 * v_0 - v_1 * v_1) / (2.0 * a * peak);
+        }
+        times(i + 1) = times(i) + duration;
+    }
+    return times;
+}
+
+Eigen::MatrixXd ResamplePath(Eigen::MatrixXdRefConst path, Eigen::VectorXdRefConst times, double dt, Eigen::VectorXd &sample_times)
+{
+    if (dt <= 0.0) ThrowPretty("The time step has to be positive, given: " << dt);
+    if (times.size() != path.rows()) ThrowPretty("Number of times (" << times.size() << ") and states (" << path.rows() << ") disagree");
+    if (path.rows() == 0) ThrowPretty("Empty path!");
+
+    const double duration = times(times.size() - 1);
+    const int num_samples = static_cast<int>(std::ceil(duration / dt - 1e-9)) + 1;
+    Eigen::MatrixXd samples(num_samples, path.cols());
+    sample_times.resize(num_samples);
+    int segment = 0;
+    for (int k = 0; k < num_samples; ++k)
+    {
+        const double t = std::min(k * dt, duration);
+        while (segment < path.rows() - 2 && times(segment + 1) < t) ++segment;
+        if (path.rows() == 1)
+        {
+            samples.row(k) = path.row(0);
+        }
+        else
+        {
+            const double segment_duration = times(segment + 1) - times(segment);
+            const double fraction = segment_duration > 0.0 ? std::min((t - times(segment)) / segment_duration, 1.0) : 1.0;
+            samples.row(k) = path.row(segment) + fraction * (path.row(segment + 1) - path.row(segment));
+        }
+        sample_times(k) = t;
+    }
+    sample_times(num_samples - 1) = duration;
+    return samples;
+}
+}  // namespace exotica
@@ -9,6 +9,7 @@ from scipy.optimize import (
     SR1,
     # BFGS
 )
+from scipy.sparse import csc_matrix
 import numpy as np
 from time import time
 
@@ -18,13 +19,19 @@ class SciPyTimeIndexedSolver(object):
     Uses SciPy to solve a constrained TimeIndexedProblem. Options for SciPy minimize
     can be found here:
     https://docs.scipy.org/doc/scipy/reference/generated/scipy.optimize.minimize.html
+
+    Jacobians are handed to SciPy as scipy.sparse.csc_matrix built on the
+    problem's persistent sparsity pattern, so only the values are copied per
+    call. With sparse_hessian=True and method="trust-constr" the exact sparse
+    cost Hessian is used in place of the SR1 approximation.
     """
 
-    def __init__(self, problem=None, method=None, debug=False):
+    def __init__(self, problem=None, method=None, debug=False, sparse_hessian=False):
         print("Initialising SciPy Solver")
         self.problem = problem
         self.debug = debug
         self.method = method
+        self.sparse_hessian = sparse_hessian
         self.hessian_update_strategy = None
         if self.method != "SLSQP":
             self.hessian_update_strategy = SR1()
@@ -38,13 +45,20 @@ class SciPyTimeIndexedSolver(object):
         # print("EQ", self.problem.get_equality().shape)
         return self.problem.get_equality()
 
+    @staticmethod
+    def _to_csc(view, scale=1.0):
+        # The index arrays alias the problem's persistent pattern; the values are
+        # copied since SciPy's quasi-Newton updates keep the previous Jacobian.
+        (data, indices, indptr), shape = view
+        return csc_matrix((scale * data, indices, indptr), shape=shape, copy=False)
+
     def eq_constraint_jac(self, x):
         self.problem.update(x)
-        # print("EQ-Jac", self.problem.get_equality_jacobian().shape)
+        jac = self._to_csc(self.problem.get_equality_jacobian_csc())
         if self.method == "SLSQP":  # SLSQP does not support sparse Jacobians/Hessians
-            return self.problem.get_equality_jacobian().todense()
+            return jac.toarray()
         else:
-            return self.problem.get_equality_jacobian()
+            return jac
 
     def neq_constraint_fun(self, x):
         self.problem.update(x)
@@ -53,16 +67,20 @@ class SciPyTimeIndexedSolver(object):
 
     def neq_constraint_jac(self, x):
         self.problem.update(x)
-        # print("NEQ-Jac", self.problem.get_inequality_jacobian().shape)
+        jac = self._to_csc(self.problem.get_inequality_jacobian_csc(), -1.0)
         if self.method == "SLSQP":  # SLSQP does not support sparse Jacobians/Hessians
-            return -1.0 * self.problem.get_inequality_jacobian().todense()
+            return jac.toarray()
         else:
-            return -1.0 * self.problem.get_inequality_jacobian()
+            return jac
 
     def cost_fun(self, x):
         self.problem.update(x)
         return self.problem.get_cost(), self.problem.get_cost_jacobian()
 
+    def cost_hess(self, x):
+        self.problem.update(x)
+        return self._to_csc(self.problem.get_cost_hessian_csc())
+
     def solve(self):
         # Extract start state
         x0 = np.asarray(self.problem.initial_trajectory)[1:, :].flatten()
@@ -121,6 +139,10 @@ class SciPyTimeIndexedSolver(object):
                 self.problem.get_bounds()[:, 1].repeat(self.problem.T - 1),
             )
 
+        cost_hess = self.hessian_update_strategy
+        if self.sparse_hessian and self.method == "trust-constr":
+            cost_hess = self.cost_hess
+
         s = time()
         res = minimize(
             self.cost_fun,
@@ -128,7 +150,7 @@ class SciPyTimeIndexedSolver(object):
             method=self.method,
             bounds=bounds,
             jac=True,
-            hess=self.hessian_update_strategy,
+            hess=cost_hess,
             constraints=cons,
             options={
                 "disp": self.debug,
@@ -30,7 +30,13 @@
 #ifndef TIME_INDEXED_RRT_CONNECT_SOLVER_TIME_INDEXED_RRT_CONNECT_H_
 #define TIME_INDEXED_RRT_CONNECT_SOLVER_TIME_INDEXED_RRT_CONNECT_H_
 
+#include <atomic>
+#include <deque>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #include <exotica_core/motion_solver.h>
 #include <exotica_core/problems/time_indexed_sampling_problem.h>
@@ -45,6 +51,7 @@
 #include <ompl/tools/config/SelfConfig.h>
 
 #include <exotica_time_indexed_rrt_connect_solver/time_indexed_rrt_connect_initializer.h>
+#include <exotica_time_indexed_rrt_connect_solver/time_sliced_nearest_neighbors.h>
 
 namespace exotica
 {
@@ -97,8 +104,20 @@ public:
 
     bool isValid(const ompl::base::State *state, double &dist) const override;
 
+    /// \brief Sets up thread-safe validity checking for planners growing trees on several threads. The threads other than the
+    /// calling thread are assigned one of num_workspaces clones of the scene (TimeIndexedSamplingProblem::PrepareValidityWorkspaces)
+    /// in the order of their first check, further threads share the problem under a lock. With 0 workspaces, states are checked on
+    /// the problem only. Has to be called from the thread calling the planner, before planning.
+    void SetNumberOfWorkspaces(int num_workspaces);
+
 protected:
     TimeIndexedSamplingProblemPtr prob_;
+
+    int num_workspaces_ = 0;
+    std::thread::id planning_thread_;                                     ///< Thread checking states on prob_ directly
+    mutable std::mutex workspaces_mutex_;                                 ///< Guards thread_workspaces_
+    mutable std::mutex problem_mutex_;                                    ///< Guards the checks on prob_ once workspaces are set up
+    mutable std::unordered_map<std::thread::id, int> thread_workspaces_;  ///< Workspace of each planner thread
 };
 
 typedef boost::function<ompl::base::PlannerPtr(const ompl::base::SpaceInformationPtr &si, const std::string &name)> ConfiguredPlannerAllocator;
@@ -170,6 +189,32 @@ public:
         tGoal_.reset(new NN<Motion *>());
     }
 
+    /// \brief Grow the start and the goal tree concurrently, the goal tree on a second thread.
+    /// Each thread owns its tree (and its nearest neighbors datastructure) and connects it
+    /// to the newest motion added to the other tree. The state validity checker has to be
+    /// thread-safe, see OMPLTimeIndexedStateValidityChecker::SetNumberOfWorkspaces.
+    void setParallelTreeGrowth(bool parallel)
+    {
+        parallelTreeGrowth_ = parallel;
+    }
+
+    /// \brief Partition the trees into time slices of the given duration for nearest neighbor queries
+    /// (see NearestNeighborsTimeSliced), or use the default datastructures if the duration is 0.
+    /// Clears the trees.
+    void setTimeSliceDuration(double duration);
+
+    /// \brief Get the duration of the time slices the trees are partitioned into
+    double getTimeSliceDuration() const
+    {
+        return timeSliceDuration_;
+    }
+
+    /// \brief Get whether the trees are grown concurrently
+    bool getParallelTreeGrowth() const
+    {
+        return parallelTreeGrowth_;
+    }
+
     void setup() override;
 
 protected:
@@ -200,6 +245,7 @@ protected:
         Motion *xmotion;
         bool start;
         bool correct_time;
+        bool reverse_check;  ///< Whether the time of the state grown towards must not be corrected (connecting the trees)
     };
 
     /// \brief The state of the tree after an attempt to extend it
@@ -213,48 +259,64 @@ protected:
         REACHED
     };
 
+    /// \brief Shared state of the two threads growing the trees concurrently
+    struct ParallelGrowthInfo
+    {
+        std::atomic<bool> stop{false};
+        std::mutex mutex;                  ///< Guards the queues, the connection and the exception
+        std::deque<Motion *> incoming[2];  ///< Motions added to the goal tree (to connect the start tree to) and to the start tree
+        Motion *startMotion = nullptr;
+        Motion *goalMotion = nullptr;
+        std::exception_ptr exception;  ///< First exception thrown while growing either tree
+    };
+
     /// \brief Free the memory allocated by this planner
     void freeMemory();
 
+    /// \brief Allocate the nearest neighbors datastructures if they have not been set
+    void setupNearestNeighbors();
+
     /// \brief Compute distance between motions (actually distance between contained states)
     double distanceFunction(const Motion *a, const Motion *b) const
     {
         return si_->distance(a->state, b->state);
     }
 
-    double forwardTimeDistance(const Motion *a, const Motion *b) const
+    /// \brief Whether b can be reached from a forward (or backward) in time within the velocity limits
+    bool isTimeAdmissible(const Motion *a, const Motion *b, bool forward) const
     {
-        static const Eigen::VectorXd max_vel = si_->getStateSpace()->as<OMPLTimeIndexedRNStateSpace>()->prob_->vel_limits;
+        const Eigen::VectorXd &max_vel = si_->getStateSpace()->as<OMPLTimeIndexedRNStateSpace>()->prob_->vel_limits;
 
         double ta, tb;
         Eigen::VectorXd qa, qb;
         si_->getStateSpace()->as<OMPLTimeIndexedRNStateSpace>()->OMPLToExoticaState(a->state, qa, ta);
         si_->getStateSpace()->as<OMPLTimeIndexedRNStateSpace>()->OMPLToExoticaState(b->state, qb, tb);
 
-        if (tb < ta) return 1e10;
+        if (forward ? tb < ta : tb > ta) return false;
         Eigen::VectorXd diff = (qb - qa).cwiseAbs();
         double min_dt = (diff.array() / max_vel.array()).maxCoeff();
-        if (fabs(tb - ta) < min_dt) return 1e10;
+        return fabs(tb - ta) >= min_dt;
+    }
+
+    double forwardTimeDistance(const Motion *a, const Motion *b) const
+    {
+        if (!isTimeAdmissible(a, b, true)) return 1e10;
         return si_->distance(a->state, b->state);
     }
 
     double reverseTimeDistance(const Motion *a, const Motion *b) const
     {
-        static const Eigen::VectorXd max_vel = si_->getStateSpace()->as<OMPLTimeIndexedRNStateSpace>()->prob_->vel_limits;
-
-        double ta, tb;
-        Eigen::VectorXd qa, qb;
-        si_->getStateSpace()->as<OMPLTimeIndexedRNStateSpace>()->OMPLToExoticaState(a->state, qa, ta);
-        si_->getStateSpace()->as<OMPLTimeIndexedRNStateSpace>()->OMPLToExoticaState(b->state, qb, tb);
-
-        if (tb > ta) return 1e10;
-        Eigen::VectorXd diff = (qb - qa).cwiseAbs();
-        double min_dt = (diff.array() / max_vel.array()).maxCoeff();
-        if (fabs(tb - ta) < min_dt) return 1e10;
+        if (!isTimeAdmissible(a, b, false)) return 1e10;
         return si_->distance(a->state, b->state);
     }
 
-    bool correctTime(const Motion *a, Motion *b, bool reverse, bool &changed) const
+    /// \brief Time of the state of a motion
+    double motionTime(const Motion *a) const
+    {
+        return static_cast<const OMPLTimeIndexedRNStateSpace::StateType *>(a->state)->getTime().position;
+    }
+
+    bool correctTime(const Motion *a, Motion *b, bool reverse, bool reverse_check, bool &changed) const
     {
         Eigen::VectorXd max_vel = si_->getStateSpace()->as<OMPLTimeIndexedRNStateSpace>()->prob_->vel_limits;
         double ta, tb;
@@ -265,7 +327,7 @@ protected:
         double min_dt = (diff.array() / max_vel.array()).maxCoeff();
         if (fabs(tb - ta) < min_dt)
         {
-            if (reverse_check_) return false;
+            if (reverse_check) return false;
             tb = ta + (reverse ? -min_dt : min_dt);
             changed = true;
         }
@@ -279,6 +341,15 @@ protected:
     /// \brief Grow a tree towards a random state
     GrowState growTree(TreeData &tree, TreeGrowingInfo &tgi, Motion *rmotion);
 
+    /// \brief Construct the path through the connected motions and add it to the problem definition
+    void addSolution(Motion *startMotion, Motion *goalMotion);
+
+    /// \brief Grow both trees concurrently until they are connected
+    base::PlannerStatus solveParallel(const base::PlannerTerminationCondition &ptc, base::GoalSampleableRegion *goal);
+
+    /// \brief Grow the start or the goal tree and connect it to the motions added to the other tree
+    void growTreeParallel(bool start, const base::PlannerTerminationCondition &ptc, base::GoalSampleableRegion *goal, ParallelGrowthInfo &info);
+
     /// \brief State sampler
     base::StateSamplerPtr sampler_;
 
@@ -297,7 +368,11 @@ protected:
     /// \brief The pair of states in each tree connected during planning.  Used for PlannerData computation
     std::pair<base::State *, base::State *> connectionPoint_;
 
-    bool reverse_check_;
+    /// \brief Whether the trees are grown concurrently
+    bool parallelTreeGrowth_ = false;
+
+    /// \brief Duration of the time slices of the nearest neighbors datastructures, 0 for the default datastructures
+    double timeSliceDuration_ = 0.0;
 };
 }  // namespace exotica
 
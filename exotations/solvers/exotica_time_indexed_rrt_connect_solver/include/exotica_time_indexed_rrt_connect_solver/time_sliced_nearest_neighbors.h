@@ -0,0 +1,246 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef TIME_INDEXED_RRT_CONNECT_SOLVER_TIME_SLICED_NEAREST_NEIGHBORS_H_
+#define TIME_INDEXED_RRT_CONNECT_SOLVER_TIME_SLICED_NEAREST_NEIGHBORS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <ompl/datastructures/NearestNeighbors.h>
+#include <ompl/datastructures/NearestNeighborsGNAT.h>
+#include <ompl/util/Exception.h>
+
+namespace exotica
+{
+/// \brief Nearest neighbors datastructure for time-indexed states.
+/// The elements are partitioned into slices of fixed duration, each of them indexed by a GNAT over the (metric) distance function.
+/// Slices on the wrong side of the query in time, or farther away in time than the best candidate found so far, are skipped.
+/// Candidates are filtered with the admissibility predicate (time monotonicity and velocity limits) before they are compared.
+/// If no element is admissible, the nearest element is returned regardless, such that the planner can correct its time.
+template <typename _T>
+class NearestNeighborsTimeSliced : public ompl::NearestNeighbors<_T>
+{
+public:
+    typedef std::function<double(const _T &)> TimeFunction;
+    typedef std::function<bool(const _T &, const _T &)> AdmissibleFunction;  ///< Called as (query, element)
+
+    /// \param slice_duration Duration of the time slices.
+    /// \param time Time of an element.
+    /// \param admissible Whether the element (second argument) can be connected to the query (first argument).
+    /// \param elements_after_query Whether admissible elements are later than the query (true) or earlier (false).
+    /// \param time_weight Weight of the time in the distance function, the time difference times the weight is a lower bound on the distance.
+    NearestNeighborsTimeSliced(double slice_duration, TimeFunction time, AdmissibleFunction admissible, bool elements_after_query, double time_weight = 1.0)
+        : slice_duration_(slice_duration), time_(time), admissible_(admissible), elements_after_query_(elements_after_query), time_weight_(time_weight)
+    {
+        if (!(slice_duration_ > 0.0)) throw ompl::Exception("The duration of the time slices has to be positive");
+    }
+
+    virtual ~NearestNeighborsTimeSliced() = default;
+
+    void setDistanceFunction(const typename ompl::NearestNeighbors<_T>::DistanceFunction &distFun) override
+    {
+        ompl::NearestNeighbors<_T>::setDistanceFunction(distFun);
+        for (auto &slice : slices_) slice.second->setDistanceFunction(distFun);
+    }
+
+    bool reportsSortedResults() const override
+    {
+        return true;
+    }
+
+    void clear() override
+    {
+        slices_.clear();
+        size_ = 0;
+    }
+
+    void add(const _T &data) override
+    {
+        auto it = slices_.find(sliceIndex(data));
+        if (it == slices_.end())
+        {
+            std::shared_ptr<ompl::NearestNeighbors<_T>> slice = std::make_shared<ompl::NearestNeighborsGNAT<_T>>();
+            slice->setDistanceFunction(this->distFun_);
+            it = slices_.emplace(sliceIndex(data), slice).first;
+        }
+        it->second->add(data);
+        ++size_;
+    }
+
+    void add(const std::vector<_T> &data) override
+    {
+        for (const _T &element : data) add(element);
+    }
+
+    bool remove(const _T &data) override
+    {
+        auto it = slices_.find(sliceIndex(data));
+        if (it == slices_.end() || !it->second->remove(data)) return false;
+        if (it->second->size() == 0) slices_.erase(it);
+        --size_;
+        return true;
+    }
+
+    _T nearest(const _T &data) const override
+    {
+        std::vector<std::pair<double, _T>> candidates;
+        search(data, 1, std::numeric_limits<double>::infinity(), candidates);
+        if (!candidates.empty()) return candidates.front().second;
+
+        // No admissible element: fall back to the nearest one
+        bool found = false;
+        std::pair<double, _T> best;
+        for (const auto &slice : slices_)
+        {
+            const _T element = slice.second->nearest(data);
+            const double d = this->distFun_(data, element);
+            if (!found || d < best.first) best = std::make_pair(d, element);
+            found = true;
+        }
+        if (!found) throw ompl::Exception("No elements found in nearest neighbors data structure");
+        return best.second;
+    }
+
+    void nearestK(const _T &data, std::size_t k, std::vector<_T> &nbh) const override
+    {
+        std::vector<std::pair<double, _T>> candidates;
+        search(data, k, std::numeric_limits<double>::infinity(), candidates);
+        nbh.clear();
+        for (const auto &candidate : candidates) nbh.push_back(candidate.second);
+    }
+
+    void nearestR(const _T &data, double radius, std::vector<_T> &nbh) const override
+    {
+        std::vector<std::pair<double, _T>> candidates;
+        search(data, std::numeric_limits<std::size_t>::max(), radius, candidates);
+        nbh.clear();
+        for (const auto &candidate : candidates) nbh.push_back(candidate.second);
+    }
+
+    std::size_t size() const override
+    {
+        return size_;
+    }
+
+    void list(std::vector<_T> &data) const override
+    {
+        data.clear();
+        std::vector<_T> slice_data;
+        for (const auto &slice : slices_)
+        {
+            slice.second->list(slice_data);
+            data.insert(data.end(), slice_data.begin(), slice_data.end());
+        }
+    }
+
+private:
+    long sliceIndex(const _T &data) const
+    {
+        return static_cast<long>(std::floor(time_(data) / slice_duration_));
+    }
+
+    /// \brief Lower bound on the distance of the query to the elements of a slice, negative if the slice holds no admissible elements.
+    double sliceLowerBound(long index, double t) const
+    {
+        const double begin = index * slice_duration_, end = begin + slice_duration_;
+        if (elements_after_query_ ? end < t : begin > t) return -1.0;
+        return time_weight_ * std::max(0.0, elements_after_query_ ? begin - t : t - end);
+    }
+
+    /// \brief Finds the (at most k) nearest admissible elements within the radius, sorted by distance.
+    void search(const _T &data, std::size_t k, double radius, std::vector<std::pair<double, _T>> &candidates) const
+    {
+        candidates.clear();
+        if (k == 0) return;
+
+        // Visit the admissible slices in the order of their distance in time
+        const double t = time_(data);
+        std::vector<std::pair<double, const ompl::NearestNeighbors<_T> *>> slices;
+        for (const auto &slice : slices_)
+        {
+            const double bound = sliceLowerBound(slice.first, t);
+            if (bound >= 0.0 && bound <= radius) slices.emplace_back(bound, slice.second.get());
+        }
+        std::sort(slices.begin(), slices.end(), [](const std::pair<double, const ompl::NearestNeighbors<_T> *> &a, const std::pair<double, const ompl::NearestNeighbors<_T> *> &b) { return a.first < b.first; });
+
+        std::vector<_T> nbh;
+        for (const auto &slice : slices)
+        {
+            double worst = candidates.size() < k ? radius : candidates.back().first;
+            if (slice.first > worst) break;
+
+            // Query growing numbers of neighbors until enough admissible ones are found or the remaining ones are too far
+            std::size_t num_queried = std::min(slice.second->size(), k == std::numeric_limits<std::size_t>::max() ? slice.second->size() : 2 * k);
+            std::size_t num_checked = 0;
+            while (true)
+            {
+                if (radius < std::numeric_limits<double>::infinity())
+                    slice.second->nearestR(data, std::min(radius, worst), nbh);
+                else
+                    slice.second->nearestK(data, num_queried, nbh);
+
+                bool too_far = false;
+                for (std::size_t i = num_checked; i < nbh.size(); ++i)
+                {
+                    if (!admissible_(data, nbh[i])) continue;
+                    const double d = this->distFun_(data, nbh[i]);
+                    worst = candidates.size() < k ? radius : candidates.back().first;
+                    if (d > worst)
+                    {
+                        too_far = true;
+                        break;
+                    }
+                    candidates.insert(std::upper_bound(candidates.begin(), candidates.end(), d, [](double value, const std::pair<double, _T> &c) { return value < c.first; }), std::make_pair(d, nbh[i]));
+                    if (candidates.size() > k) candidates.pop_back();
+                }
+                num_checked = nbh.size();
+                if (too_far || radius < std::numeric_limits<double>::infinity() || num_queried >= slice.second->size()) break;
+                num_queried = std::min(slice.second->size(), 2 * num_queried);
+            }
+        }
+    }
+
+    double slice_duration_;
+    TimeFunction time_;
+    AdmissibleFunction admissible_;
+    bool elements_after_query_;
+    double time_weight_;
+    std::size_t size_ = 0;
+    std::map<long, std::shared_ptr<ompl::NearestNeighbors<_T>>> slices_;
+};
+}  // namespace exotica
+
+#endif  // TIME_INDEXED_RRT_CONNECT_SOLVER_TIME_SLICED_NEAREST_NEIGHBORS_H_
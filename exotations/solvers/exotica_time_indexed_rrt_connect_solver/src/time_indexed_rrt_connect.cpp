@@ -85,15 +85,40 @@ bool OMPLTimeIndexedStateValidityChecker::isValid(const ompl::base::State *state
 
 bool OMPLTimeIndexedStateValidityChecker::isValid(const ompl::base::State *state, double &dist) const
 {
-    Eigen::VectorXd q(prob_->N);
-    double t;
-#if ROS_VERSION_MINIMUM(1, 12, 0)  // if ROS version >= ROS_KINETIC
-    std::static_pointer_cast<OMPLTimeIndexedRNStateSpace>(si_->getStateSpace())->OMPLToExoticaState(state, q, t);
-#else
-    boost::static_pointer_cast<OMPLTimeIndexedRNStateSpace>(si_->getStateSpace())->OMPLToExoticaState(state, q, t);
-#endif
+    // The joint positions are checked in place, without copying them out of the state
+    const OMPLTimeIndexedRNStateSpace::StateType *ss = static_cast<const OMPLTimeIndexedRNStateSpace::StateType *>(state);
+    const Eigen::Map<const Eigen::VectorXd> q(ss->getRNSpace().values, prob_->N);
 
-    if (!prob_->IsValid(q, t))
+    bool valid;
+    if (num_workspaces_ == 0)
+    {
+        valid = prob_->IsValid(q, ss->getTime().position);
+    }
+    else
+    {
+        // Each planner thread checks its states on its own clone, the clones are assigned on the first check of a thread. The locks only
+        // guard the assignment and the problem shared by the planning thread and the threads without a clone, not the checks on the clones
+        int workspace = -1;
+        if (std::this_thread::get_id() != planning_thread_)
+        {
+            std::lock_guard<std::mutex> lock(workspaces_mutex_);
+            auto it = thread_workspaces_.find(std::this_thread::get_id());
+            if (it == thread_workspaces_.end() && static_cast<int>(thread_workspaces_.size()) < num_workspaces_)
+                it = thread_workspaces_.emplace(std::this_thread::get_id(), static_cast<int>(thread_workspaces_.size())).first;
+            if (it != thread_workspaces_.end()) workspace = it->second;
+        }
+        if (workspace >= 0)
+        {
+            valid = prob_->IsValid(q, ss->getTime().position, workspace);
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(problem_mutex_);
+            valid = prob_->IsValid(q, ss->getTime().position);
+        }
+    }
+
+    if (!valid)
     {
         dist = -1;
         return false;
@@ -101,6 +126,15 @@ bool OMPLTimeIndexedStateValidityChecker::isValid(const ompl::base::State *state
     return true;
 }
 
+void OMPLTimeIndexedStateValidityChecker::SetNumberOfWorkspaces(int num_workspaces)
+{
+    std::lock_guard<std::mutex> lock(workspaces_mutex_);
+    if (num_workspaces > 0) prob_->PrepareValidityWorkspaces(num_workspaces);
+    num_workspaces_ = num_workspaces;
+    planning_thread_ = std::this_thread::get_id();
+    thread_workspaces_.clear();
+}
+
 // The solver
 void TimeIndexedRRTConnectSolver::Instantiate(const TimeIndexedRRTConnectSolverInitializer &init)
 {
@@ -129,6 +163,8 @@ void TimeIndexedRRTConnectSolver::SpecifyProblem(PlanningProblemPtr pointer)
     ompl_simple_setup_->getSpaceInformation()->setup();
     ompl_simple_setup_->setup();
     if (ompl_simple_setup_->getPlanner()->params().hasParam("Range")) ompl_simple_setup_->getPlanner()->params().setParam("Range", this->parameters_.Range);
+    ompl_simple_setup_->getPlanner()->as<OMPLTimeIndexedRRTConnect>()->setParallelTreeGrowth(this->parameters_.ParallelTreeGrowth);
+    ompl_simple_setup_->getPlanner()->as<OMPLTimeIndexedRRTConnect>()->setTimeSliceDuration(this->parameters_.TimeSliceDuration);
 }
 
 void TimeIndexedRRTConnectSolver::PreSolve()
@@ -239,6 +275,7 @@ void TimeIndexedRRTConnectSolver::GetPath(Eigen::MatrixXd &traj, ompl::base::Pla
 
 void TimeIndexedRRTConnectSolver::Solve(Eigen::MatrixXd &solution)
 {
+    EXOTICA_PROFILE_SCOPE("TimeIndexedRRTConnectSolver::Solve");
     Timer timer;
 
     // Reset bounds on time space
@@ -255,6 +292,11 @@ void TimeIndexedRRTConnectSolver::Solve(Eigen::MatrixXd &solution)
     ompl_simple_setup_->setStartState(ompl_start_state);
 
     PreSolve();
+
+    // The goal tree is grown on a second thread, which checks its states on a clone of the scene
+    OMPLTimeIndexedStateValidityChecker *validity_checker = static_cast<OMPLTimeIndexedStateValidityChecker *>(ompl_simple_setup_->getStateValidityChecker().get());
+    validity_checker->SetNumberOfWorkspaces(this->parameters_.ParallelTreeGrowth ? 1 : 0);
+
     ompl::time::point start = ompl::time::now();
     if (!ptc_)
         ptc_.reset(new ompl::base::PlannerTerminationCondition(ompl::base::timedPlannerTerminationCondition(this->parameters_.Timeout - ompl::time::seconds(ompl::time::now() - start))));
@@ -262,6 +304,7 @@ void TimeIndexedRRTConnectSolver::Solve(Eigen::MatrixXd &solution)
     {
         GetPath(solution, *ptc_);
     }
+    validity_checker->SetNumberOfWorkspaces(0);
     PostSolve();
 
     planning_time_ = timer.GetDuration();
@@ -294,6 +337,25 @@ void OMPLTimeIndexedRRTConnect::setup()
     tools::SelfConfig sc(si_, getName());
     sc.configurePlannerRange(maxDistance_);
 
+    setupNearestNeighbors();
+}
+
+void OMPLTimeIndexedRRTConnect::setupNearestNeighbors()
+{
+    if (timeSliceDuration_ > 0.0)
+    {
+        // The start tree grows forward in time, so its admissible neighbors are earlier than the query; the goal tree grows backward
+        const double time_weight = si_->getStateSpace()->as<base::CompoundStateSpace>()->getSubspaceWeight(1);
+        const NearestNeighborsTimeSliced<Motion *>::TimeFunction time = [this](Motion *const &a) { return motionTime(a); };
+        if (!tStart_) tStart_.reset(new NearestNeighborsTimeSliced<Motion *>(timeSliceDuration_, time, [this](Motion *const &query, Motion *const &element) { return isTimeAdmissible(query, element, false); }, false, time_weight));
+        if (!tGoal_) tGoal_.reset(new NearestNeighborsTimeSliced<Motion *>(timeSliceDuration_, time, [this](Motion *const &query, Motion *const &element) { return isTimeAdmissible(query, element, true); }, true, time_weight));
+
+        // The slices are indexed by the metric distance, the time constraints are checked separately
+        tStart_->setDistanceFunction(boost::bind(&OMPLTimeIndexedRRTConnect::distanceFunction, this, _1, _2));
+        tGoal_->setDistanceFunction(boost::bind(&OMPLTimeIndexedRRTConnect::distanceFunction, this, _1, _2));
+        return;
+    }
+
 #if ROS_VERSION_MINIMUM(1, 12, 0)  // if ROS version >= ROS_KINETIC
     if (!tStart_) tStart_.reset(tools::SelfConfig::getDefaultNearestNeighbors<Motion *>(this));
     if (!tGoal_) tGoal_.reset(tools::SelfConfig::getDefaultNearestNeighbors<Motion *>(this));
@@ -307,6 +369,19 @@ void OMPLTimeIndexedRRTConnect::setup()
     tGoal_->setDistanceFunction(boost::bind(&OMPLTimeIndexedRRTConnect::forwardTimeDistance, this, _1, _2));
 }
 
+void OMPLTimeIndexedRRTConnect::setTimeSliceDuration(double duration)
+{
+    if (duration < 0.0) ThrowPretty("The duration of the time slices has to be non-negative, given: " << duration);
+    timeSliceDuration_ = duration;
+
+    // The trees are reallocated with the new datastructures
+    freeMemory();
+    tStart_.reset();
+    tGoal_.reset();
+    connectionPoint_ = std::make_pair<base::State *, base::State *>(nullptr, nullptr);
+    if (setup_) setupNearestNeighbors();
+}
+
 void OMPLTimeIndexedRRTConnect::freeMemory()
 {
     std::vector<Motion *> motions;
@@ -348,7 +423,7 @@ OMPLTimeIndexedRRTConnect::GrowState OMPLTimeIndexedRRTConnect::growTree(TreeDat
     Motion *nmotion = tree->nearest(rmotion);
 
     bool changed = false;
-    if (!correctTime(nmotion, rmotion, !tgi.start, changed)) return TRAPPED;
+    if (!correctTime(nmotion, rmotion, !tgi.start, tgi.reverse_check, changed)) return TRAPPED;
 
     // assume we can reach the state we go towards
     bool reach = !changed;
@@ -424,6 +499,8 @@ ompl::base::PlannerStatus OMPLTimeIndexedRRTConnect::solve(const base::PlannerTe
         return base::PlannerStatus::INVALID_GOAL;
     }
 
+    if (parallelTreeGrowth_) return solveParallel(ptc, goal);
+
     if (!sampler_) sampler_ = si_->allocStateSampler();
 
     OMPL_INFORM("%s: Starting planning with %d states already in datastructure", getName().c_str(), (int)(tStart_->size() + tGoal_->size()));
@@ -463,7 +540,7 @@ ompl::base::PlannerStatus OMPLTimeIndexedRRTConnect::solve(const base::PlannerTe
 
         // sample random state
         sampler_->sampleUniform(rstate);
-        reverse_check_ = false;
+        tgi.reverse_check = false;
         GrowState gs = growTree(tree, tgi, rmotion);
 
         if (gs != TRAPPED)
@@ -479,7 +556,7 @@ ompl::base::PlannerStatus OMPLTimeIndexedRRTConnect::solve(const base::PlannerTe
             GrowState gsc = ADVANCED;
             tgi.start = startTree;
 
-            reverse_check_ = true;
+            tgi.reverse_check = true;
             while (ptc == false && gsc == ADVANCED)
             {
                 gsc = growTree(otherTree, tgi, rmotion);
@@ -499,45 +576,168 @@ ompl::base::PlannerStatus OMPLTimeIndexedRRTConnect::solve(const base::PlannerTe
                 else
                     goalMotion = goalMotion->parent;
 
-                connectionPoint_ = std::make_pair(startMotion->state, goalMotion->state);
+                addSolution(startMotion, goalMotion);
+                solved = true;
+                break;
+            }
+        }
+    }
+
+    si_->freeState(tgi.xstate);
+    si_->freeState(rstate);
+    delete rmotion;
+
+    OMPL_INFORM("%s: Created %u states (%u start + %u goal)", getName().c_str(), tStart_->size() + tGoal_->size(), tStart_->size(), tGoal_->size());
+    return solved ? base::PlannerStatus::EXACT_SOLUTION : base::PlannerStatus::TIMEOUT;
+}
 
-                // construct the solution path
-                Motion *solution = startMotion;
-                std::vector<Motion *> mpath1;
-                while (solution != nullptr)
+void OMPLTimeIndexedRRTConnect::addSolution(Motion *startMotion, Motion *goalMotion)
+{
+    connectionPoint_ = std::make_pair(startMotion->state, goalMotion->state);
+
+    // construct the solution path
+    Motion *solution = startMotion;
+    std::vector<Motion *> mpath1;
+    while (solution != nullptr)
+    {
+        mpath1.push_back(solution);
+        solution = solution->parent;
+    }
+
+    solution = goalMotion;
+    std::vector<Motion *> mpath2;
+    while (solution != nullptr)
+    {
+        mpath2.push_back(solution);
+        solution = solution->parent;
+    }
+
+    ompl::geometric::PathGeometric *path = new ompl::geometric::PathGeometric(si_);
+    path->getStates().reserve(mpath1.size() + mpath2.size());
+    for (int i = mpath1.size() - 1; i >= 0; --i)
+        path->append(mpath1[i]->state);
+    for (unsigned int i = 0; i < mpath2.size(); ++i)
+        path->append(mpath2[i]->state);
+
+    pdef_->addSolutionPath(base::PathPtr(path), false, 0.0, getName());
+}
+
+ompl::base::PlannerStatus OMPLTimeIndexedRRTConnect::solveParallel(const base::PlannerTerminationCondition &ptc, base::GoalSampleableRegion *goal)
+{
+    OMPL_INFORM("%s: Starting parallel planning with %d states already in datastructure", getName().c_str(), (int)(tStart_->size() + tGoal_->size()));
+
+    // The start tree is grown on this thread, the goal tree on a second one
+    ParallelGrowthInfo info;
+    std::thread goal_thread(&OMPLTimeIndexedRRTConnect::growTreeParallel, this, false, std::cref(ptc), goal, std::ref(info));
+    growTreeParallel(true, ptc, goal, info);
+    goal_thread.join();
+    if (info.exception) std::rethrow_exception(info.exception);
+
+    const bool solved = info.startMotion != nullptr;
+    if (solved) addSolution(info.startMotion, info.goalMotion);
+
+    OMPL_INFORM("%s: Created %u states (%u start + %u goal)", getName().c_str(), tStart_->size() + tGoal_->size(), tStart_->size(), tGoal_->size());
+    return solved ? base::PlannerStatus::EXACT_SOLUTION : base::PlannerStatus::TIMEOUT;
+}
+
+void OMPLTimeIndexedRRTConnect::growTreeParallel(bool start, const base::PlannerTerminationCondition &ptc, base::GoalSampleableRegion *goal, ParallelGrowthInfo &info)
+{
+    // Only this thread accesses the tree, the motions of the other tree are only read once they have been queued
+    TreeData &tree = start ? tStart_ : tGoal_;
+    std::deque<Motion *> &incoming = info.incoming[start ? 0 : 1];
+    std::deque<Motion *> &outgoing = info.incoming[start ? 1 : 0];
+
+    base::StateSamplerPtr sampler = si_->allocStateSampler();
+    TreeGrowingInfo tgi;
+    tgi.xstate = si_->allocState();
+    tgi.xmotion = nullptr;
+    tgi.start = start;
+    Motion *rmotion = new Motion(si_);
+
+    try
+    {
+        while (ptc == false && !info.stop)
+        {
+            if (!start && (tGoal_->size() == 0 || pis_.getSampledGoalsCount() < tGoal_->size() / 2))
+            {
+                const base::State *st = tGoal_->size() == 0 ? pis_.nextGoal(ptc) : pis_.nextGoal();
+                if (st)
                 {
-                    mpath1.push_back(solution);
-                    solution = solution->parent;
+                    Motion *motion = new Motion(si_);
+                    si_->copyState(motion->state, st);
+                    motion->root = motion->state;
+                    tGoal_->add(motion);
                 }
 
-                solution = goalMotion;
-                std::vector<Motion *> mpath2;
-                while (solution != nullptr)
+                if (tGoal_->size() == 0)
                 {
-                    mpath2.push_back(solution);
-                    solution = solution->parent;
+                    OMPL_ERROR("%s: Unable to sample any valid states for goal tree", getName().c_str());
+                    info.stop = true;
+                    break;
                 }
+            }
 
-                ompl::geometric::PathGeometric *path = new ompl::geometric::PathGeometric(si_);
-                path->getStates().reserve(mpath1.size() + mpath2.size());
-                for (int i = mpath1.size() - 1; i >= 0; --i)
-                    path->append(mpath1[i]->state);
-                for (unsigned int i = 0; i < mpath2.size(); ++i)
-                    path->append(mpath2[i]->state);
+            // attempt to connect this tree to the newest motion of the other tree, older ones are superseded by it
+            Motion *otherMotion = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(info.mutex);
+                if (!incoming.empty())
+                {
+                    otherMotion = incoming.back();
+                    incoming.clear();
+                }
+            }
+            if (otherMotion != nullptr)
+            {
+                si_->copyState(rmotion->state, otherMotion->state);
+                tgi.reverse_check = true;
+                GrowState gsc = ADVANCED;
+                while (ptc == false && !info.stop && gsc == ADVANCED)
+                {
+                    gsc = growTree(tree, tgi, rmotion);
+                }
 
-                pdef_->addSolutionPath(base::PathPtr(path), false, 0.0, getName());
-                solved = true;
-                break;
+                Motion *startMotion = start ? tgi.xmotion : otherMotion;
+                Motion *goalMotion = start ? otherMotion : tgi.xmotion;
+                if (gsc == REACHED && goal->isStartGoalPairValid(startMotion->root, goalMotion->root))
+                {
+                    // the motion just added duplicates the state of the other motion, so we go one step 'back' in this tree
+                    if (start)
+                        startMotion = startMotion->parent;
+                    else
+                        goalMotion = goalMotion->parent;
+
+                    std::lock_guard<std::mutex> lock(info.mutex);
+                    if (!info.stop)
+                    {
+                        info.startMotion = startMotion;
+                        info.goalMotion = goalMotion;
+                        info.stop = true;
+                    }
+                    break;
+                }
+            }
+
+            // sample random state and extend this tree
+            sampler->sampleUniform(rmotion->state);
+            tgi.reverse_check = false;
+            if (growTree(tree, tgi, rmotion) != TRAPPED)
+            {
+                std::lock_guard<std::mutex> lock(info.mutex);
+                outgoing.push_back(tgi.xmotion);
             }
         }
     }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(info.mutex);
+        if (!info.exception) info.exception = std::current_exception();
+        info.stop = true;
+    }
 
     si_->freeState(tgi.xstate);
-    si_->freeState(rstate);
+    si_->freeState(rmotion->state);
     delete rmotion;
-
-    OMPL_INFORM("%s: Created %u states (%u start + %u goal)", getName().c_str(), tStart_->size() + tGoal_->size(), tStart_->size(), tGoal_->size());
-    return solved ? base::PlannerStatus::EXACT_SOLUTION : base::PlannerStatus::TIMEOUT;
 }
 
 void OMPLTimeIndexedRRTConnect::getPlannerData(base::PlannerData &data) const
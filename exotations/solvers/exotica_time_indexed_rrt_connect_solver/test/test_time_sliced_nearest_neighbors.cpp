@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_time_indexed_rrt_connect_solver/time_sliced_nearest_neighbors.h>
+#include <gtest/gtest.h>
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace exotica;
+
+namespace
+{
+constexpr double kTimeWeight = 2.0;
+constexpr double kMaxVelocity = 1.5;
+
+// Elements are indices into a set of time-indexed points, with the time as the first coordinate
+class TimeSlicedNearestNeighborsTest : public ::testing::TestWithParam<bool>
+{
+protected:
+    void SetUp() override
+    {
+        elements_after_query_ = GetParam();
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<double> time(0.0, 10.0), position(-5.0, 5.0);
+        for (int i = 0; i < 500; ++i) points_.push_back(Eigen::Vector3d(time(generator), position(generator), position(generator)));
+
+        nn_.reset(new NearestNeighborsTimeSliced<int>(
+            0.7, [this](const int &i) { return points_[i](0); },
+            [this](const int &query, const int &element) { return Admissible(query, element); }, elements_after_query_, kTimeWeight));
+        nn_->setDistanceFunction([this](const int &a, const int &b) { return Distance(a, b); });
+    }
+
+    double Distance(int a, int b) const
+    {
+        const Eigen::Vector3d d = points_[a] - points_[b];
+        return std::sqrt(kTimeWeight * kTimeWeight * d(0) * d(0) + d.tail<2>().squaredNorm());
+    }
+
+    bool Admissible(int query, int element) const
+    {
+        const double dt = elements_after_query_ ? points_[element](0) - points_[query](0) : points_[query](0) - points_[element](0);
+        return dt >= 0.0 && (points_[element].tail<2>() - points_[query].tail<2>()).norm() <= kMaxVelocity * dt;
+    }
+
+    /// \brief Admissible elements among data sorted by their distance to the query, all elements if none is admissible and fallback is set.
+    std::vector<int> BruteForce(int query, const std::vector<int> &data, bool fallback = false) const
+    {
+        std::vector<int> result;
+        for (int element : data)
+            if (Admissible(query, element)) result.push_back(element);
+        if (result.empty() && fallback) result = data;
+        std::sort(result.begin(), result.end(), [this, query](int a, int b) { return Distance(query, a) < Distance(query, b); });
+        return result;
+    }
+
+    bool elements_after_query_;
+    std::vector<Eigen::Vector3d> points_;
+    std::unique_ptr<NearestNeighborsTimeSliced<int>> nn_;
+};
+}  // namespace
+
+TEST_P(TimeSlicedNearestNeighborsTest, MatchesBruteForce)
+{
+    // The first 400 points are added, the remaining ones are used as queries
+    std::vector<int> data;
+    for (int i = 0; i < 400; ++i) data.push_back(i);
+    nn_->add(data);
+    EXPECT_EQ(nn_->size(), data.size());
+
+    std::vector<int> listed;
+    nn_->list(listed);
+    std::sort(listed.begin(), listed.end());
+    EXPECT_EQ(listed, data);
+
+    std::vector<int> nbh;
+    int num_queries_with_neighbors = 0;
+    for (int query = 400; query < 500; ++query)
+    {
+        const std::vector<int> expected = BruteForce(query, data);
+        if (expected.size() >= 5) ++num_queries_with_neighbors;
+
+        EXPECT_EQ(nn_->nearest(query), BruteForce(query, data, true).front()) << "Query " << query;
+
+        nn_->nearestK(query, 5, nbh);
+        EXPECT_EQ(nbh, std::vector<int>(expected.begin(), expected.begin() + std::min<std::size_t>(5, expected.size()))) << "Query " << query;
+
+        const double radius = 3.0;
+        nn_->nearestR(query, radius, nbh);
+        std::vector<int> expected_in_radius;
+        for (int element : expected)
+            if (Distance(query, element) <= radius) expected_in_radius.push_back(element);
+        EXPECT_EQ(nbh, expected_in_radius) << "Query " << query;
+    }
+    // Most queries have to exercise the admissible search rather than the fallback
+    EXPECT_GT(num_queries_with_neighbors, 50);
+}
+
+TEST_P(TimeSlicedNearestNeighborsTest, MatchesBruteForceAfterRemoval)
+{
+    std::vector<int> data;
+    for (int i = 0; i < 400; ++i) nn_->add(i);
+    for (int i = 0; i < 400; ++i)
+    {
+        if (i % 3 == 0)
+            EXPECT_TRUE(nn_->remove(i));
+        else
+            data.push_back(i);
+    }
+    EXPECT_FALSE(nn_->remove(0));
+    EXPECT_EQ(nn_->size(), data.size());
+
+    std::vector<int> nbh;
+    for (int query = 400; query < 500; ++query)
+    {
+        EXPECT_EQ(nn_->nearest(query), BruteForce(query, data, true).front()) << "Query " << query;
+        const std::vector<int> expected = BruteForce(query, data);
+        nn_->nearestK(query, 3, nbh);
+        EXPECT_EQ(nbh, std::vector<int>(expected.begin(), expected.begin() + std::min<std::size_t>(3, expected.size()))) << "Query " << query;
+    }
+}
+
+TEST_P(TimeSlicedNearestNeighborsTest, FallsBackToNearestElement)
+{
+    // No element is admissible for queries beyond the end (or before the beginning) of the elements in time
+    points_.push_back(Eigen::Vector3d(elements_after_query_ ? 20.0 : -10.0, 0.0, 0.0));
+    const int query = static_cast<int>(points_.size()) - 1;
+    std::vector<int> data;
+    for (int i = 0; i < 400; ++i) data.push_back(i);
+    nn_->add(data);
+
+    ASSERT_TRUE(BruteForce(query, data).empty());
+    std::vector<int> nbh;
+    nn_->nearestK(query, 5, nbh);
+    EXPECT_TRUE(nbh.empty());
+    EXPECT_EQ(nn_->nearest(query), BruteForce(query, data, true).front());
+
+    nn_->clear();
+    EXPECT_EQ(nn_->size(), 0u);
+    EXPECT_THROW(nn_->nearest(query), ompl::Exception);
+}
+
+INSTANTIATE_TEST_CASE_P(TimeSlicedNearestNeighbors, TimeSlicedNearestNeighborsTest, ::testing::Values(true, false));
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
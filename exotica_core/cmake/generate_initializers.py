@@ -148,14 +148,14 @@ def declaration(data):
 def parser(type_in):
     parser = ""
     if type_in == "std::string":
-        return "boost::any_cast<" + type_in + ">(prop.Get())"
+        return "prop->GetValue<" + type_in + ">()"
     elif type_in == "exotica::Initializer" or type_in == "Initializer":
-        return "prop.IsInitializerVectorType()?boost::any_cast<std::vector<exotica::Initializer>>(prop.Get()).at(0):boost::any_cast<exotica::Initializer>(prop.Get())"
+        return "prop->IsInitializerVectorType()?prop->GetValue<std::vector<exotica::Initializer>>().at(0):prop->GetValue<exotica::Initializer>()"
     elif (
         type_in == "std::vector<Initializer>"
         or type_in == "std::vector<exotica::Initializer>"
     ):
-        return "boost::any_cast<std::vector<exotica::Initializer>>(prop.Get())"
+        return "prop->GetValue<std::vector<exotica::Initializer>>()"
     elif type_in == "Eigen::VectorXd":
         parser = "ParseVector<double,Eigen::Dynamic>"
     elif type_in == "Eigen::Vector4d":
@@ -183,11 +183,11 @@ def parser(type_in):
         sys.exit(2)
 
     return (
-        "prop.IsStringType()?"
+        "prop->IsStringType()?"
         + parser
-        + "(boost::any_cast<std::string>(prop.Get())):boost::any_cast<"
+        + "(prop->GetValue<std::string>()):prop->GetValue<"
         + type_in
-        + ">(prop.Get())"
+        + ">()"
     )
 
 
@@ -211,11 +211,9 @@ def copy(data):
 def add(data):
     if "Required" in data:
         return (
-            '        if (other.HasProperty("'
+            '        { const Property* prop = other.FindProperty("'
             + data["Name"]
-            + '")) { const Property& prop = other.properties_.at("'
-            + data["Name"]
-            + '"); if(prop.IsSet()) {'
+            + '"); if (prop != nullptr && prop->IsSet()) {'
             + (data["Name"])
             + " = "
             + parser(data["Type"])
@@ -228,15 +226,13 @@ def add(data):
 def check(data, name):
     if "Required" in data and data["Required"]:
         return (
-            '        if(!other.HasProperty("'
-            + data["Name"]
-            + '") || !other.properties_.at("'
+            '        { const Property* prop = other.FindProperty("'
             + data["Name"]
-            + '").IsSet()) ThrowPretty("Initializer '
+            + '"); if (prop == nullptr || !prop->IsSet()) ThrowPretty("Initializer '
             + name
             + " requires property "
             + data["Name"]
-            + ' to be set!");\n'
+            + ' to be set!"); }\n'
         )
     else:
         return ""
@@ -32,11 +32,16 @@
 
 #include <Eigen/Dense>
 
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <map>
 #include <sstream>
 #include <string>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <exotica_core/factory.h>
 #include <exotica_core/kinematic_element.h>
@@ -116,6 +121,38 @@ struct ContinuousCollisionProxy
     }
 };
 
+/// \brief Narrowphase queries of a pair of collision objects, see CollisionStatistics.
+struct CollisionPairStatistics
+{
+    std::string object1;
+    std::string object2;
+    std::size_t num_queries = 0;  ///< Number of narrowphase queries
+    double time = 0.0;            ///< Cumulative time of the narrowphase queries in seconds
+};
+
+/// \brief Counters of the collision and distance queries since the statistics were last reset.
+struct CollisionStatistics
+{
+    std::size_t num_broadphase_candidates = 0;   ///< Pairs reported by the broadphase or passing the AABB check, before the collision filter
+    std::size_t num_collision_checks = 0;        ///< Narrowphase collision checks
+    std::size_t num_distance_computations = 0;   ///< Narrowphase distance computations
+    std::size_t num_fallbacks = 0;               ///< Distance computations without valid nearest points, for which fallback contacts are used
+    std::vector<CollisionPairStatistics> pairs;  ///< Sorted by descending cumulative time, i.e., the hot pairs come first
+
+    /// \brief Prints the counters and the pairs with the highest cumulative time.
+    inline std::string Print(std::size_t max_pairs = 10) const
+    {
+        std::stringstream ss;
+        ss << "CollisionStatistics: broadphase candidates: " << num_broadphase_candidates << " collision checks: " << num_collision_checks
+           << " distance computations: " << num_distance_computations << " fallbacks: " << num_fallbacks;
+        for (std::size_t i = 0; i < std::min(max_pairs, pairs.size()); ++i)
+        {
+            ss << "\n  '" << pairs[i].object1 << "' - '" << pairs[i].object2 << "': " << pairs[i].num_queries << " queries, " << pairs[i].time * 1e3 << " ms";
+        }
+        return ss.str();
+    }
+};
+
 struct CollisionProxy
 {
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -144,6 +181,66 @@ struct CollisionProxy
     }
 };
 
+/// @brief Collision proxies in structure-of-arrays layout, see the CollisionProxyBuffer overloads of CollisionScene::GetCollisionDistance.
+/// The elements are referenced by frame handle (KinematicTree::GetFrameHandle, KinematicTree::GetElement) instead of shared pointers.
+/// Only the first Size() entries of the arrays are valid. Clear keeps the memory, hence a buffer reused across queries does not allocate
+/// once it has grown to the number of proxies.
+struct CollisionProxyBuffer
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    std::vector<int> e1;  ///< Frame handles of the first elements
+    std::vector<int> e2;  ///< Frame handles of the second elements
+    Eigen::Matrix3Xd contact1;
+    Eigen::Matrix3Xd normal1;
+    Eigen::Matrix3Xd contact2;
+    Eigen::Matrix3Xd normal2;
+    std::vector<double> distance;
+
+    int Size() const { return size_; }
+    void Clear() { size_ = 0; }
+    void Reserve(int capacity)
+    {
+        if (capacity <= static_cast<int>(distance.size())) return;
+        e1.resize(capacity);
+        e2.resize(capacity);
+        contact1.conservativeResize(3, capacity);
+        normal1.conservativeResize(3, capacity);
+        contact2.conservativeResize(3, capacity);
+        normal2.conservativeResize(3, capacity);
+        distance.resize(capacity);
+    }
+
+    void Append(int e1_in, int e2_in, const Eigen::Vector3d& contact1_in, const Eigen::Vector3d& normal1_in, const Eigen::Vector3d& contact2_in, const Eigen::Vector3d& normal2_in, double distance_in)
+    {
+        if (size_ == static_cast<int>(distance.size())) Reserve(std::max(16, 2 * size_));
+        e1[size_] = e1_in;
+        e2[size_] = e2_in;
+        contact1.col(size_) = contact1_in;
+        normal1.col(size_) = normal1_in;
+        contact2.col(size_) = contact2_in;
+        normal2.col(size_) = normal2_in;
+        distance[size_] = distance_in;
+        ++size_;
+    }
+
+    void Append(const CollisionProxyBuffer& other)
+    {
+        Reserve(size_ + other.size_);
+        std::copy(other.e1.begin(), other.e1.begin() + other.size_, e1.begin() + size_);
+        std::copy(other.e2.begin(), other.e2.begin() + other.size_, e2.begin() + size_);
+        contact1.middleCols(size_, other.size_) = other.contact1.leftCols(other.size_);
+        normal1.middleCols(size_, other.size_) = other.normal1.leftCols(other.size_);
+        contact2.middleCols(size_, other.size_) = other.contact2.leftCols(other.size_);
+        normal2.middleCols(size_, other.size_) = other.normal2.leftCols(other.size_);
+        std::copy(other.distance.begin(), other.distance.begin() + other.size_, distance.begin() + size_);
+        size_ += other.size_;
+    }
+
+private:
+    int size_ = 0;
+};
+
 /// The class of collision scene
 class CollisionScene : public Object, public Uncopyable, public virtual InstantiableBase
 {
@@ -167,6 +264,13 @@ public:
     /// @return True, if the state is collision free..
     virtual bool IsStateValid(bool self = true, double safe_distance = 0.0) = 0;
 
+    /// \brief Checks a batch of states, updating the scene to each state in turn. The scene is left in the last checked state.
+    /// @param states Controlled states, one per row.
+    /// @param self Indicate if self collision check is required.
+    /// @param stop_at_first_invalid Whether to stop at the first invalid state. The states after it are reported as invalid.
+    /// @return Validity of each state.
+    virtual std::vector<bool> AreStatesValid(Eigen::MatrixXdRefConst states, bool self = true, double safe_distance = 0.0, bool stop_at_first_invalid = false);
+
     /// @brief Checks if two objects are in collision.
     /// @param o1 Name of object 1.
     /// @param o2 Name of object 2.
@@ -174,14 +278,16 @@ public:
     virtual bool IsCollisionFree(const std::string& o1, const std::string& o2, double safe_distance = 0.0) { ThrowPretty("Not implemented!"); }
     /// \brief Computes collision distances.
     /// \param self Indicate if self collision check is required.
+    /// \param check_margin Pairs of shapes further apart than this margin are skipped.
     /// \return Collision proximity objects for all colliding pairs of shapes.
     ///
-    virtual std::vector<CollisionProxy> GetCollisionDistance(bool self) { ThrowPretty("Not implemented!"); }
+    virtual std::vector<CollisionProxy> GetCollisionDistance(bool self, double check_margin = std::numeric_limits<double>::infinity()) { ThrowPretty("Not implemented!"); }
     /// \brief Computes collision distances between two objects.
     /// \param o1 Name of object 1.
     /// \param o2 Name of object 2.
+    /// \param check_margin Pairs of shapes further apart than this margin are skipped.
     /// \return Vector of proximity objects.
-    virtual std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const std::string& o2) { ThrowPretty("Not implemented!"); }
+    virtual std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const std::string& o2, double check_margin = std::numeric_limits<double>::infinity()) { ThrowPretty("Not implemented!"); }
     /// @brief Gets the closest distance of any collision object which is allowed to collide with any collision object related to object o1.
     /// @param[in] o1 Name of object 1.
     /// @return Vector of proximity objects.
@@ -189,13 +295,46 @@ public:
     /// @brief      Gets the closest distance of any collision object which is allowed to collide with any collision object related to object o1.
     /// @param[in]  o1    Name of object 1.
     /// @param[in]  disable_collision_scene_update    Allows disabling of collision object transforms (requires manual update).
+    /// @param[in]  check_margin    Margin for distance checks - only objects closer than this margin will be checked
     /// @return     Vector of proximity objects.
-    virtual std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const bool& self, const bool& disable_collision_scene_update) { ThrowPretty("Not implemented!"); }
+    virtual std::vector<CollisionProxy> GetCollisionDistance(const std::string& o1, const bool& self, const bool& disable_collision_scene_update, double check_margin = std::numeric_limits<double>::infinity()) { ThrowPretty("Not implemented!"); }
     /// @brief      Gets the closest distance of any collision object which is
     /// allowed to collide with any collision object related to any of the objects.
     /// @param[in]  objects    Vector of object names.
+    /// @param[in]  check_margin    Margin for distance checks - only objects closer than this margin will be checked
     /// @return     Vector of proximity objects.
-    virtual std::vector<CollisionProxy> GetCollisionDistance(const std::vector<std::string>& objects, const bool& self) { ThrowPretty("Not implemented!"); }
+    virtual std::vector<CollisionProxy> GetCollisionDistance(const std::vector<std::string>& objects, const bool& self, double check_margin = std::numeric_limits<double>::infinity()) { ThrowPretty("Not implemented!"); }
+    /// @brief      Cached variants of GetCollisionDistance(self, check_margin), GetRobotToRobotCollisionDistance, GetRobotToWorldCollisionDistance and IsStateValid.
+    ///             Each query is computed once per state of the Scene (see Scene::GetStateVersion) and the result is shared by all callers,
+    ///             e.g., by the collision task maps of one problem. The collision object transforms are updated before the first query of a
+    ///             state if the Scene does not update them itself. The returned references are valid until the state of the Scene changes.
+    const std::vector<CollisionProxy>& GetCachedCollisionDistance(bool self, double check_margin = std::numeric_limits<double>::infinity());
+    const std::vector<CollisionProxy>& GetCachedRobotToRobotCollisionDistance(double check_margin);
+    const std::vector<CollisionProxy>& GetCachedRobotToWorldCollisionDistance(double check_margin);
+    bool IsStateValidCached(bool self = true, double safe_distance = 0.0);
+
+    /// @brief      Variants of GetCollisionDistance(self, check_margin), GetRobotToRobotCollisionDistance and GetRobotToWorldCollisionDistance
+    ///             writing into a caller-owned buffer, which is cleared first. The default implementations convert the results of the above;
+    ///             scenes overriding them (e.g., CollisionSceneFCLLatest) neither allocate nor touch shared pointers per proxy.
+    virtual void GetCollisionDistance(bool self, double check_margin, CollisionProxyBuffer& proxies);
+    virtual void GetRobotToRobotCollisionDistance(double check_margin, CollisionProxyBuffer& proxies);
+    virtual void GetRobotToWorldCollisionDistance(double check_margin, CollisionProxyBuffer& proxies);
+    /// @brief      Cached variants of the buffer queries, copying the proxies shared by all callers within a state into the buffer.
+    void GetCachedCollisionDistance(bool self, double check_margin, CollisionProxyBuffer& proxies);
+    void GetCachedRobotToRobotCollisionDistance(double check_margin, CollisionProxyBuffer& proxies);
+    void GetCachedRobotToWorldCollisionDistance(double check_margin, CollisionProxyBuffer& proxies);
+    /// @brief      Discards the results of the cached queries, e.g., after moving collision objects without updating the Scene.
+    void InvalidateQueryCache() { ++query_cache_invalidations_; }
+    /// @brief      Selects the per-pair distance cache used by the following distance queries, if the scene has one (e.g., UseDistanceCache
+    ///             of CollisionSceneFCLLatest). Time-indexed problems use one slot per time step, so that the distances of a time step are
+    ///             bounded from its own state in the previous iteration rather than from the previous time step.
+    virtual void SetDistanceCacheSlot(int slot) {}
+    virtual int GetDistanceCacheSlot() const { return 0; }
+
+    /// @brief Returns the statistics of the collision and distance queries since the last reset.
+    /// Statistics are only collected by scenes which support and enable it, e.g., CollisionSceneFCLLatest with CollectStatistics.
+    virtual CollisionStatistics GetCollisionStatistics() const { ThrowPretty("Not implemented!"); }
+    virtual void ResetCollisionStatistics() { ThrowPretty("Not implemented!"); }
     /// @brief      Gets the closest distances between links within the robot that are closer than check_margin
     /// @param[in]  check_margin    Margin for distance checks - only objects closer than this margin will be checked
     virtual std::vector<CollisionProxy> GetRobotToRobotCollisionDistance(double check_margin) { ThrowPretty("Not implemented!"); }
@@ -223,13 +362,28 @@ public:
     /// @param[in]  motion_transforms   A tuple consisting out of collision object name and its beginning and final transform.
     /// @return     Vector of deepest ContinuousCollisionProxy (one per dimension).
     virtual std::vector<ContinuousCollisionProxy> ContinuousCollisionCast(const std::vector<std::vector<std::tuple<std::string, Eigen::Isometry3d, Eigen::Isometry3d>>>& motion_transforms) { ThrowPretty("Not implemented!"); }
+    /// @brief      Performs a continuous collision check of the robot along a whole trajectory.
+    ///             The motion of every object between consecutive states is interpolated between its poses, as in ContinuousCollisionCheck.
+    /// @param[in]  trajectory  Controlled states, one per row.
+    /// @param[in]  self        Indicate if self collision check is required.
+    /// @return     One ContinuousCollisionProxy per robot collision object (in the order of GetCollisionRobotLinks) with its earliest contact.
+    ///             The time of contact is in units of trajectory segments, i.e., t + s for a contact at fraction s of the segment from state t to t + 1.
+    ///             Objects without contact have time_of_contact equal to the index of the last state.
+    virtual std::vector<ContinuousCollisionProxy> ContinuousCollisionCheckTrajectory(Eigen::MatrixXdRefConst trajectory, bool self = true) { ThrowPretty("Not implemented!"); }
+    /// @brief      Casts a batch of rays against the world (i.e., non-robot) collision objects, e.g., for line-of-sight checks.
+    /// @param[in]  origins       Origins of the rays in the world frame, one per column.
+    /// @param[in]  directions    Directions of the rays in the world frame, one per column. They do not need to be normalised.
+    /// @param[in]  max_distance  Rays are only cast up to this distance.
+    /// @return     Distance along each ray to the first hit, zero if its origin is inside an object and infinity if there is no hit within max_distance.
+    virtual Eigen::VectorXd RayCast(const Eigen::Ref<const Eigen::Matrix3Xd>& origins, const Eigen::Ref<const Eigen::Matrix3Xd>& directions, double max_distance = std::numeric_limits<double>::infinity()) { ThrowPretty("Not implemented!"); }
     /// @brief      Returns the translation of the named collision object.
     /// @param[in]  name    Name of the collision object to query.
     virtual Eigen::Vector3d GetTranslation(const std::string& name) = 0;
 
-    void SetACM(const AllowedCollisionMatrix& acm)
+    virtual void SetACM(const AllowedCollisionMatrix& acm)
     {
         acm_ = acm;
+        InvalidateQueryCache();
     }
 
     bool GetAlwaysExternallyUpdatedCollisionScene() const { return always_externally_updated_collision_scene_; }
@@ -244,6 +398,7 @@ public:
         if (scale < 0.0)
             ThrowPretty("Link scaling needs to be greater than or equal to 0");
         robot_link_scale_ = scale;
+        InvalidateQueryCache();
         needs_update_of_collision_objects_ = true;
     }
 
@@ -253,6 +408,7 @@ public:
         if (scale < 0.0)
             ThrowPretty("Link scaling needs to be greater than or equal to 0");
         world_link_scale_ = scale;
+        InvalidateQueryCache();
         needs_update_of_collision_objects_ = true;
     }
 
@@ -262,6 +418,7 @@ public:
         if (padding < 0.0)
             HIGHLIGHT_NAMED("SetRobotLinkPadding", "Generally, padding should be positive.");
         robot_link_padding_ = padding;
+        InvalidateQueryCache();
         needs_update_of_collision_objects_ = true;
     }
 
@@ -271,6 +428,7 @@ public:
         if (padding < 0.0)
             HIGHLIGHT_NAMED("SetRobotLinkPadding", "Generally, padding should be positive.");
         world_link_padding_ = padding;
+        InvalidateQueryCache();
         needs_update_of_collision_objects_ = true;
     }
 
@@ -278,6 +436,7 @@ public:
     void SetReplacePrimitiveShapesWithMeshes(const bool value)
     {
         replace_primitive_shapes_with_meshes_ = value;
+        InvalidateQueryCache();
         needs_update_of_collision_objects_ = true;
     }
 
@@ -285,6 +444,26 @@ public:
     /// \param objects Vector kinematic element pointers of collision objects.
     virtual void UpdateCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects) = 0;
 
+    /// \brief Updates only the collision objects of kinematic elements that have been re-attached, e.g., when attaching an object to the robot.
+    /// The default implementation recreates all collision objects, implementations fall back to it if they are out of date.
+    /// \param objects Kinematic elements of the re-attached collision objects (a subset of the objects passed to UpdateCollisionObjects).
+    virtual void UpdateReattachedCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects);
+
+    /// \brief Updates the collision objects of kinematic elements whose octree shapes have been modified in place.
+    /// The default implementation recreates all collision objects.
+    /// \param objects Kinematic elements with modified octrees (a subset of the objects passed to UpdateCollisionObjects).
+    virtual void UpdateOctreeCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects);
+
+    /// \brief Creates the collision objects of kinematic elements added to the tree, e.g., the shapes of world objects added by a planning scene diff.
+    /// The default implementation recreates all collision objects.
+    /// \param objects Kinematic elements of the added collision objects.
+    virtual void AddCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects);
+
+    /// \brief Destroys the collision objects of kinematic elements removed from the tree (KinematicTree::RemoveEnvironmentElement).
+    /// The default implementation recreates all collision objects.
+    /// \param names Names of the removed kinematic elements.
+    virtual void RemoveCollisionObjects(const std::vector<std::string>& names);
+
     /// \brief Updates collision object transformations from the kinematic tree.
     virtual void UpdateCollisionObjectTransforms() = 0;
 
@@ -292,6 +471,7 @@ public:
     void set_replace_cylinders_with_capsules(const bool value)
     {
         replace_cylinders_with_capsules_ = value;
+        InvalidateQueryCache();
         needs_update_of_collision_objects_ = true;
     }
 
@@ -310,6 +490,33 @@ protected:
     /// Stores a pointer to the Scene which owns this CollisionScene
     std::weak_ptr<Scene> scene_;
 
+    /// Cached query results of the current state of the Scene, see GetCachedCollisionDistance
+    enum class CachedQuery
+    {
+        Distance,
+        RobotToRobotDistance,
+        RobotToWorldDistance,
+        Validity
+    };
+    /// \brief Clears the cached queries if the state of the Scene has changed since they were computed.
+    void UpdateQueryCache();
+    std::map<std::tuple<CachedQuery, bool, double>, std::vector<CollisionProxy>> cached_proxies_;
+    std::map<std::tuple<CachedQuery, bool, double>, bool> cached_validity_;
+    /// Buffer queries are kept across states (and only recomputed) to reuse their memory
+    struct CachedProxyBuffer
+    {
+        CollisionProxyBuffer proxies;
+        int generation = -1;
+    };
+    std::map<std::tuple<CachedQuery, bool, double>, CachedProxyBuffer> cached_proxy_buffers_;
+    int cache_generation_ = 0;  ///< Incremented whenever the cached queries are discarded
+    const CollisionProxyBuffer& GetCachedProxyBuffer(CachedQuery query, bool self, double check_margin);
+    void ConvertProxies(const std::vector<CollisionProxy>& in, CollisionProxyBuffer& out) const;
+    std::uint64_t cached_tree_stamp_ = std::numeric_limits<std::uint64_t>::max();
+    std::array<int, 4> cached_versions_ = {-1, -1, -1, -1};  ///< Versions of the state, world, attachments and ACM of the cached queries
+    int cached_invalidations_ = -1;
+    int query_cache_invalidations_ = 0;
+
     /// The allowed collision matrix
     AllowedCollisionMatrix acm_;
 
@@ -34,9 +34,12 @@
 #include <exotica_core/object.h>
 #include <exotica_core/property.h>
 #include <exotica_core/tools.h>
+#include <exotica_core/tools/parallel_loop.h>
 
 #include <exotica_core/dynamics_solver_initializer.h>
 
+#include <vector>
+
 #define REGISTER_DYNAMICS_SOLVER_TYPE(TYPE, DERIV) EXOTICA_CORE_REGISTER(exotica::DynamicsSolver, TYPE, DERIV)
 
 namespace exotica
@@ -45,10 +48,12 @@ class Scene;
 
 enum Integrator
 {
-    RK1 = 0,          ///< Forward Euler (explicit)
-    SymplecticEuler,  ///< Semi-Implicit Euler
-    RK2,              ///< Explicit trapezoid rule
-    RK4,              ///< Runge-Kutta 4
+    RK1 = 0,                ///< Forward Euler (explicit)
+    SymplecticEuler,        ///< Semi-Implicit Euler
+    RK2,                    ///< Explicit trapezoid rule
+    RK4,                    ///< Runge-Kutta 4
+    ImplicitEuler,          ///< Backward Euler, solved with Newton's method. Stable for stiff dynamics at large dt.
+    LinearlyImplicitEuler,  ///< Semi-implicit (Rosenbrock) Euler, i.e., the first Newton step of ImplicitEuler
 };
 
 template <typename T, int NX, int NU>
@@ -83,6 +88,42 @@ public:
     /// \brief Computes derivatives fx, fu, Fx, Fu [single call for efficiency, derivatives can be retrieved with get_fx, get_fu, get_Fx, get_Fu]
     virtual void ComputeDerivatives(const StateVector& x, const ControlVector& u);
 
+    /// \brief Computes the derivatives as ComputeDerivatives and returns the differential dynamics f(x, u). Solvers that
+    /// obtain f as a by-product of the derivatives (e.g. the Pinocchio solvers) answer both from a single evaluation.
+    virtual StateVector ComputeAll(const StateVector& x, const ControlVector& u);
+
+    /// \brief Computes the state transition derivatives Fx[t], Fu[t] for all steps t of a trajectory.
+    ///
+    /// X holds the states (at least U.cols()) and U the controls, one column per step. Fx and Fu are grown to U.cols()
+    /// if needed. The default evaluates ComputeDerivatives step by step; solvers whose derivatives can be evaluated
+    /// concurrently override it to run in parallel over t (see SetDerivativesNumThreads). get_fx, get_Fx etc. are
+    /// not defined after a batch evaluation.
+    virtual void ComputeDerivativesBatch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, std::vector<StateDerivative>& Fx, std::vector<ControlDerivative>& Fu);
+
+    /// \brief Evaluates the dynamics f for the states X and controls U (one pair per column) into Xdot (ndx x X.cols()).
+    ///
+    /// The default evaluates f column by column. Solvers override it with vectorised or parallel code (see
+    /// SetDerivativesNumThreads), e.g. for the many rollouts of sampling-based MPC.
+    virtual void f_batch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, Eigen::MatrixXdRef Xdot);
+
+    /// \brief Advances the states X by one timestep dt with the controls U (one pair per column) in lockstep, as
+    /// SimulateOneStep does for a single state. X_next has the size of X. The dynamics are evaluated with f_batch.
+    void SimulateBatch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, Eigen::MatrixXdRef X_next);
+
+    /// \brief Single-precision variant of f_batch for sampling workloads that do not need double precision.
+    ///
+    /// The default converts to double and calls f_batch. FixedSizeDynamicsSolver models evaluate f_batch_fixed in
+    /// float, which doubles the SIMD width and halves the memory traffic of large batches.
+    virtual void f_batch_float(Eigen::MatrixXfRefConst X, Eigen::MatrixXfRefConst U, Eigen::MatrixXfRef Xdot);
+
+    /// \brief Single-precision variant of SimulateBatch, the dynamics are evaluated with f_batch_float. Samples that
+    /// use ImplicitEuler or Integrate are still stepped in double.
+    void SimulateBatchFloat(Eigen::MatrixXfRefConst X, Eigen::MatrixXfRefConst U, Eigen::MatrixXfRef X_next);
+
+    /// \brief Sets the number of threads used by ComputeDerivativesBatch and f_batch (0: hardware concurrency).
+    void SetDerivativesNumThreads(int num_threads);
+    int GetDerivativesNumThreads() const { return derivatives_num_threads_; }
+
     /// \brief Returns derivative Fx computed by ComputeDerivatives
     const StateDerivative& get_Fx() const;
 
@@ -107,6 +148,15 @@ public:
     /// \brief Derivative of the forward dynamics w.r.t. the control [finite differencing]
     ControlDerivative fu_fd(const StateVector& x, const ControlVector& u);
 
+    /// \brief Sets the number of threads evaluating the columns of fx_fd and fu_fd in parallel (0: hardware concurrency).
+    void SetFiniteDifferenceNumThreads(int num_threads);
+    int GetFiniteDifferenceNumThreads() const { return finite_difference_num_threads_; }
+
+    /// \brief Creates a new instance of this solver from its initializer, assigned to the same scene, with the current
+    /// dt, integrator and control limits. The finite-difference derivatives are evaluated in parallel on such clones;
+    /// solvers with state that is not described by their initializer override this to copy it.
+    virtual std::shared_ptr<AbstractDynamicsSolver<T, NX, NU>> Clone() const;
+
     /// \brief Returns whether second-order derivatives are available
     const bool& get_has_second_order_derivatives() const
     {
@@ -119,11 +169,22 @@ public:
     //
     // Additionally, the first subscript is the *second* partial derivative.
     //  I.e. f_xu = (f_u)_x
+    // The middle dimension is the output, i.e. fxx is NDX x NDX x NDX, fuu NU x NDX x NU and fxu NU x NDX x NDX.
     // TODO: Eigen::Tensor to be replaced with exotica::Hessian
     virtual Eigen::Tensor<T, 3> fxx(const StateVector& x, const ControlVector& u);
     virtual Eigen::Tensor<T, 3> fuu(const StateVector& x, const ControlVector& u);
     virtual Eigen::Tensor<T, 3> fxu(const StateVector& x, const ControlVector& u);
 
+    /// \brief Contractions of the second order derivatives with lambda (NDX) over the output dimension, i.e.
+    /// sum_i lambda_i * d²f_i/dx² (NDX x NDX), sum_i lambda_i * d²f_i/du² (NU x NU) and sum_i lambda_i * d²f_i/dudx (NU x NDX).
+    ///
+    /// These are the only second order terms needed by DDP, with lambda = Vx. The defaults contract the dense tensors
+    /// above, or return zeros without forming them if the solver has no second order derivatives. Solvers that know the
+    /// (sparse) structure of their second order derivatives override these to avoid the dense NDX^3 tensors.
+    virtual Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> ContractFxx(const StateVector& x, const ControlVector& u, const StateVector& lambda);
+    virtual Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> ContractFuu(const StateVector& x, const ControlVector& u, const StateVector& lambda);
+    virtual Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> ContractFxu(const StateVector& x, const ControlVector& u, const StateVector& lambda);
+
     /// \brief Simulates the dynamic system from starting state x using control u for t seconds
     ///
     /// Simulates the system and steps the simulation by timesteps dt for a total time of t using the specified integration scheme starting from state x and with controls u.
@@ -136,6 +197,7 @@ public:
     virtual StateVector StateDelta(const StateVector& x_1, const StateVector& x_2)
     {
         assert(x_1.size() == x_2.size());
+        if (has_quaternion_floating_base_) return FloatingBaseStateDelta(x_1, x_2);
         return x_1 - x_2;
     }
 
@@ -151,6 +213,7 @@ public:
         assert(x_1.size() == x_2.size());
         assert(first_or_second == ArgumentPosition::ARG0 || first_or_second == ArgumentPosition::ARG1);
 
+        if (has_quaternion_floating_base_) return FloatingBasedStateDelta(x_1, x_2, first_or_second);
         if (!second_order_derivatives_initialized_) InitializeSecondOrderDerivatives();
 
         if (first_or_second == ArgumentPosition::ARG0)
@@ -166,6 +229,7 @@ public:
         assert(x_1.size() == x_2.size());
         assert(first_or_second == ArgumentPosition::ARG0 || first_or_second == ArgumentPosition::ARG1);
 
+        if (has_quaternion_floating_base_) return FloatingBaseddStateDelta(x_1, x_2, first_or_second);
         if (!second_order_derivatives_initialized_) InitializeSecondOrderDerivatives();
 
         return ddStateDelta_;
@@ -226,6 +290,29 @@ public:
     virtual void Integrate(const StateVector& x, const StateVector& dx, const double dt, StateVector& xout);
 
 private:
+    /// \brief Evaluates the finite-difference derivative of f w.r.t. x (wrt_state) or u, on clones in parallel if enabled.
+    void ComputeFiniteDifferences(const StateVector& x, const ControlVector& u, bool wrt_state, Eigen::MatrixXd& derivative);
+
+    /// \brief Evaluates column i of the finite-difference derivative on solver (this or a clone using RK1).
+    void ComputeFiniteDifferenceColumn(AbstractDynamicsSolver& solver, const StateVector& x, const ControlVector& u, const StateVector& f_nominal, bool wrt_state, int i, Eigen::MatrixXd& derivative) const;
+
+    void UpdateFiniteDifferenceClones(int num_clones);
+
+    /// \brief Integrate and StateDelta for states [p, quaternion (x, y, z, w), joints, velocities] using the SE(3) x R^n
+    /// kernels in tools/floating_base.h.
+    void FloatingBaseIntegrate(const StateVector& x, const StateVector& dx, const double dt, StateVector& xout);
+    StateVector FloatingBaseStateDelta(const StateVector& x_1, const StateVector& x_2);
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> FloatingBasedStateDelta(const StateVector& x_1, const StateVector& x_2, const ArgumentPosition first_or_second);
+    Hessian FloatingBaseddStateDelta(const StateVector& x_1, const StateVector& x_2, const ArgumentPosition first_or_second);
+
+    friend class Scene;  // Sets scene_ and has_quaternion_floating_base_ when assigning the solver
+    Initializer initializer_;          ///< Used to create the clones of the solver
+    std::weak_ptr<Scene> scene_;       ///< Scene the solver was assigned to, if any
+    int finite_difference_num_threads_ = 1;
+    FiniteDifferenceMode finite_difference_mode_ = FiniteDifferenceMode::Central;
+    double finite_difference_step_ = 1e-6;
+    std::vector<std::shared_ptr<AbstractDynamicsSolver<T, NX, NU>>> finite_difference_clones_;
+
     bool control_limits_initialized_ = false;
     Eigen::VectorXd raw_control_limits_low_, raw_control_limits_high_;
     Eigen::MatrixXd dStateDelta_;
@@ -238,6 +325,8 @@ protected:
     int num_state_ = -1;             ///< Size of state space (num_positions + num_velocities)
     int num_state_derivative_ = -1;  ///< Size of the tangent vector to the state space (2 * num_velocities)
 
+    bool has_quaternion_floating_base_ = false;  ///< Whether the configuration starts with an SE(3) floating base with a quaternion, set by the Scene.
+
     bool has_second_order_derivatives_ = false;          ///< Whether this solver provides second order derivatives. If false (default), assumed to be all zeros.
     bool second_order_derivatives_initialized_ = false;  ///< Whether fxx, fxu and fuu have been initialized to 0.
 
@@ -247,6 +336,9 @@ protected:
 
     T dt_ = 0.01;                              ///< Internal timestep used for integration. Defaults to 10ms.
     Integrator integrator_ = Integrator::RK1;  ///< Chosen integrator. Defaults to Euler (RK1).
+    int implicit_euler_max_iterations_ = 10;   ///< Newton iterations of ImplicitEuler
+    double implicit_euler_tolerance_ = 1e-10;  ///< Residual norm at which ImplicitEuler has converged
+    int derivatives_num_threads_ = 1;          ///< Number of threads used by ComputeDerivativesBatch and f_batch
     // TODO: Need to enforce control limits.
     // First column is the low limits, second is the high limits.
     Eigen::MatrixXd control_limits_;  ///< ControlLimits. Default is empty vector.
@@ -255,6 +347,16 @@ protected:
     // TODO: To be deprecated in favour of explicit call to Integrate in Simulate
     virtual StateVector SimulateOneStep(const StateVector& x, const ControlVector& u);
 
+    /// \brief Solves x_next = x + dt f(x_next, u) with Newton's method starting from x (ImplicitEuler), or takes the
+    /// first Newton step x_next = x + dt (I - dt fx(x, u))^-1 f(x, u) only (LinearlyImplicitEuler).
+    StateVector ImplicitEulerStep(const StateVector& x, const ControlVector& u);
+
+    /// \brief Shared implementation of SimulateBatch and SimulateBatchFloat.
+    template <typename Scalar>
+    void SimulateBatchImpl(const Eigen::Ref<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>>& X, const Eigen::Ref<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>>& U, Eigen::Ref<Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>> X_next);
+    void EvaluateBatch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, Eigen::MatrixXdRef Xdot) { f_batch(X, U, Xdot); }
+    void EvaluateBatch(Eigen::MatrixXfRefConst X, Eigen::MatrixXfRefConst U, Eigen::MatrixXfRef Xdot) { f_batch_float(X, U, Xdot); }
+
     void InitializeSecondOrderDerivatives();
     Eigen::Tensor<T, 3> fxx_default_, fuu_default_, fxu_default_;
 
@@ -267,6 +369,332 @@ protected:
 typedef AbstractDynamicsSolver<double, Eigen::Dynamic, Eigen::Dynamic> DynamicsSolver;
 
 typedef std::shared_ptr<exotica::DynamicsSolver> DynamicsSolverPtr;
+
+///
+/// \brief Adaptor implementing the dynamic DynamicsSolver interface for models of compile-time size.
+///
+/// Models with NQ positions, NQ velocities and NU controls implement the dynamics and their derivatives on
+/// fixed-size (stack-allocated) types:
+///
+///     void f_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateVector& xdot) const;
+///     void fx_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedStateDerivative& fx) const;
+///     void fu_fixed(const FixedStateVector& x, const FixedControlVector& u, FixedControlDerivative& fu) const;
+///
+/// f, fx, fu, F and ComputeDerivatives of the dynamic interface are forwarded to these. Step, StepDerivatives
+/// and Rollout integrate the model with the selected integrator (including RK2 and RK4) without allocating, e.g. for
+/// many rollouts in MPC.
+/// The state is assumed to be Euclidean, i.e. Integrate is not used.
+///
+template <typename Derived, int NQ, int NU>
+class FixedSizeDynamicsSolver : public DynamicsSolver
+{
+public:
+    static constexpr int NX = 2 * NQ;
+    typedef Eigen::Matrix<double, NX, 1> FixedStateVector;
+    typedef Eigen::Matrix<double, NU, 1> FixedControlVector;
+    typedef Eigen::Matrix<double, NX, NX> FixedStateDerivative;
+    typedef Eigen::Matrix<double, NX, NU> FixedControlDerivative;
+    template <typename Scalar>
+    using FixedStateBatchT = Eigen::Array<Scalar, NX, Eigen::Dynamic, Eigen::RowMajor>;
+    template <typename Scalar>
+    using FixedControlBatchT = Eigen::Array<Scalar, NU, Eigen::Dynamic, Eigen::RowMajor>;
+    template <typename Scalar>
+    using FixedBatchRowT = Eigen::Array<Scalar, 1, Eigen::Dynamic>;
+    typedef FixedStateBatchT<double> FixedStateBatch;      ///< One state per column, each row contiguous
+    typedef FixedControlBatchT<double> FixedControlBatch;  ///< One control per column, each row contiguous
+    typedef FixedBatchRowT<double> FixedBatchRow;          ///< One entry for all samples
+
+    FixedSizeDynamicsSolver()
+    {
+        num_positions_ = NQ;
+        num_velocities_ = NQ;
+        num_controls_ = NU;
+    }
+
+    StateVector f(const StateVector& x, const ControlVector& u) override
+    {
+        CheckSize(x, u);
+        FixedStateVector xdot;
+        derived().f_fixed(x, u, xdot);
+        return xdot;
+    }
+
+    StateDerivative fx(const StateVector& x, const ControlVector& u) override
+    {
+        CheckSize(x, u);
+        FixedStateDerivative fx;
+        derived().fx_fixed(x, u, fx);
+        return fx;
+    }
+
+    ControlDerivative fu(const StateVector& x, const ControlVector& u) override
+    {
+        CheckSize(x, u);
+        FixedControlDerivative fu;
+        derived().fu_fixed(x, u, fu);
+        return fu;
+    }
+
+    StateVector F(const StateVector& x, const ControlVector& u) override
+    {
+        CheckSize(x, u);
+        FixedStateVector xout;
+        Step(x, u, xout);
+        return xout;
+    }
+
+    /// \brief Evaluates f_batch_fixed of the model. Each row of the batch holds one state or control entry for all
+    /// samples, so models can implement f_batch_fixed with row-wise array expressions the compiler vectorises.
+    void f_batch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, Eigen::MatrixXdRef Xdot) override
+    {
+        if (X.rows() != NX || U.rows() != NU || X.cols() != U.cols()) ThrowPretty("Wrong size of states or controls: " << X.rows() << "x" << X.cols() << " and " << U.rows() << "x" << U.cols() << ", expected " << NX << " and " << NU << " rows");
+        if (Xdot.rows() != NX || Xdot.cols() != X.cols()) ThrowPretty("Wrong size of Xdot: " << Xdot.rows() << "x" << Xdot.cols() << ", expected " << NX << "x" << X.cols());
+        const FixedStateBatch X_batch = X.array();
+        const FixedControlBatch U_batch = U.array();
+        FixedStateBatch Xdot_batch(NX, X.cols());
+        derived().f_batch_fixed(X_batch, U_batch, Xdot_batch);
+        Xdot = Xdot_batch.matrix();
+    }
+
+    /// \brief Evaluates f_batch_fixed of the model in single precision.
+    void f_batch_float(Eigen::MatrixXfRefConst X, Eigen::MatrixXfRefConst U, Eigen::MatrixXfRef Xdot) override
+    {
+        if (X.rows() != NX || U.rows() != NU || X.cols() != U.cols()) ThrowPretty("Wrong size of states or controls: " << X.rows() << "x" << X.cols() << " and " << U.rows() << "x" << U.cols() << ", expected " << NX << " and " << NU << " rows");
+        if (Xdot.rows() != NX || Xdot.cols() != X.cols()) ThrowPretty("Wrong size of Xdot: " << Xdot.rows() << "x" << Xdot.cols() << ", expected " << NX << "x" << X.cols());
+        const FixedStateBatchT<float> X_batch = X.array();
+        const FixedControlBatchT<float> U_batch = U.array();
+        FixedStateBatchT<float> Xdot_batch(NX, X.cols());
+        derived().f_batch_fixed(X_batch, U_batch, Xdot_batch);
+        Xdot = Xdot_batch.matrix();
+    }
+
+    /// \brief Default of f_batch_fixed, evaluating f_fixed (in double) sample by sample. Models hide it with a
+    /// vectorised version templated on the scalar, which is instantiated for double and float.
+    template <typename Scalar>
+    void f_batch_fixed(const FixedStateBatchT<Scalar>& X, const FixedControlBatchT<Scalar>& U, FixedStateBatchT<Scalar>& Xdot) const
+    {
+        FixedStateVector xdot;
+        for (int k = 0; k < X.cols(); ++k)
+        {
+            derived().f_fixed(X.col(k).matrix().template cast<double>(), U.col(k).matrix().template cast<double>(), xdot);
+            Xdot.col(k) = xdot.array().template cast<Scalar>();
+        }
+    }
+
+    /// \brief Parallel over the steps of the trajectory, the fixed-size derivatives are thread-safe.
+    void ComputeDerivativesBatch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, std::vector<StateDerivative>& Fx, std::vector<ControlDerivative>& Fu) override
+    {
+        const int num_steps = static_cast<int>(U.cols());
+        if (X.rows() != NX || X.cols() < num_steps) ThrowPretty("Wrong size of states: " << X.rows() << "x" << X.cols() << ", expected " << NX << "x" << num_steps);
+        if (U.rows() != NU) ThrowPretty("Wrong number of controls: " << U.rows() << ", expected " << NU);
+        if (static_cast<int>(Fx.size()) < num_steps) Fx.resize(num_steps);
+        if (static_cast<int>(Fu.size()) < num_steps) Fu.resize(num_steps);
+
+        ParallelLoop(derivatives_num_threads_, num_steps, [&](int, int t) {
+            FixedStateDerivative fx, Fx_t;
+            FixedControlDerivative fu, Fu_t;
+            TransitionDerivatives(X.col(t), U.col(t), fx, fu, Fx_t, Fu_t);
+            Fx[t] = Fx_t;
+            Fu[t] = Fu_t;
+        });
+    }
+
+    void ComputeDerivatives(const StateVector& x, const ControlVector& u) override
+    {
+        CheckSize(x, u);
+        FixedStateDerivative fx, Fx;
+        FixedControlDerivative fu, Fu;
+        TransitionDerivatives(x, u, fx, fu, Fx, Fu);
+        fx_ = fx;
+        fu_ = fu;
+        Fx_ = Fx;
+        Fu_ = Fu;
+    }
+
+    /// \brief State transition: integrates the dynamics from x with controls u for one timestep dt.
+    void Step(const FixedStateVector& x, const FixedControlVector& u, FixedStateVector& xout) const
+    {
+        FixedStateVector xdot;
+        derived().f_fixed(x, u, xdot);
+        switch (integrator_)
+        {
+            case Integrator::RK1:
+                xout.noalias() = x + dt_ * xdot;
+                break;
+            case Integrator::SymplecticEuler:
+                xout.template head<NQ>().noalias() = x.template head<NQ>() + dt_ * x.template tail<NQ>() + (dt_ * dt_) * xdot.template tail<NQ>();
+                xout.template tail<NQ>().noalias() = x.template tail<NQ>() + dt_ * xdot.template tail<NQ>();
+                break;
+            case Integrator::RK2:
+            {
+                FixedStateVector xdot1;
+                derived().f_fixed(x + dt_ * xdot, u, xdot1);
+                xout.noalias() = x + (0.5 * dt_) * (xdot + xdot1);
+            }
+            break;
+            case Integrator::RK4:
+            {
+                FixedStateVector k2, k3, k4;
+                derived().f_fixed(x + (0.5 * dt_) * xdot, u, k2);
+                derived().f_fixed(x + (0.5 * dt_) * k2, u, k3);
+                derived().f_fixed(x + dt_ * k3, u, k4);
+                xout.noalias() = x + (dt_ / 6.0) * (xdot + 2.0 * k2 + 2.0 * k3 + k4);
+            }
+            break;
+            case Integrator::ImplicitEuler:
+            case Integrator::LinearlyImplicitEuler:
+                ImplicitEulerStep(x, u, xdot, xout);
+                break;
+            default:
+                ThrowPretty("Not implemented!");
+        }
+    }
+
+    /// \brief Derivatives Fx and Fu of the state transition Step.
+    void StepDerivatives(const FixedStateVector& x, const FixedControlVector& u, FixedStateDerivative& Fx, FixedControlDerivative& Fu) const
+    {
+        FixedStateDerivative fx;
+        FixedControlDerivative fu;
+        TransitionDerivatives(x, u, fx, fu, Fx, Fu);
+    }
+
+    /// \brief Rolls out the controls (NU x T-1) from x0, writing the states (NX x T, starting with x0).
+    void Rollout(const FixedStateVector& x0, Eigen::MatrixXdRefConst controls, Eigen::MatrixXdRef states) const
+    {
+        if (controls.rows() != NU) ThrowPretty("Wrong number of controls: " << controls.rows() << ", expected " << NU);
+        if (states.rows() != NX || states.cols() != controls.cols() + 1) ThrowPretty("Wrong size of states: " << states.rows() << "x" << states.cols() << ", expected " << NX << "x" << controls.cols() + 1);
+        FixedStateVector x = x0, xout;
+        states.col(0) = x;
+        for (int t = 0; t < controls.cols(); ++t)
+        {
+            Step(x, controls.col(t), xout);
+            states.col(t + 1) = xout;
+            x = xout;
+        }
+    }
+
+private:
+    const Derived& derived() const { return static_cast<const Derived&>(*this); }
+
+    void CheckSize(const StateVector& x, const ControlVector& u) const
+    {
+        if (x.size() != NX) ThrowPretty("Wrong size of state: " << x.size() << ", expected " << NX);
+        if (u.size() != NU) ThrowPretty("Wrong size of control: " << u.size() << ", expected " << NU);
+    }
+
+    /// \brief (Linearly) implicit Euler step from x with xdot = f(x, u), cf. DynamicsSolver::ImplicitEulerStep.
+    void ImplicitEulerStep(const FixedStateVector& x, const FixedControlVector& u, const FixedStateVector& xdot, FixedStateVector& xout) const
+    {
+        const int max_iterations = (integrator_ == Integrator::LinearlyImplicitEuler) ? 1 : implicit_euler_max_iterations_;
+        FixedStateVector residual = -dt_ * xdot, xdot_next;
+        FixedStateDerivative dresidual;
+        xout = x;
+        for (int iteration = 0; iteration < max_iterations; ++iteration)
+        {
+            derived().fx_fixed(xout, u, dresidual);
+            dresidual *= -dt_;
+            dresidual.diagonal().array() += 1.0;
+            xout -= dresidual.partialPivLu().solve(residual);
+
+            if (integrator_ == Integrator::LinearlyImplicitEuler) break;
+            derived().f_fixed(xout, u, xdot_next);
+            residual.noalias() = xout - x - dt_ * xdot_next;
+            if (residual.norm() < implicit_euler_tolerance_) break;
+        }
+    }
+
+    /// \brief Derivatives fx, fu of the dynamics at (x, u), chained through the integrator, cf. DynamicsSolver::ComputeDerivatives.
+    void TransitionDerivatives(const FixedStateVector& x, const FixedControlVector& u, FixedStateDerivative& fx, FixedControlDerivative& fu, FixedStateDerivative& Fx, FixedControlDerivative& Fu) const
+    {
+        derived().fx_fixed(x, u, fx);
+        derived().fu_fixed(x, u, fu);
+        Fx.setIdentity();
+        Fu.setZero();
+        switch (integrator_)
+        {
+            case Integrator::RK1:
+                Fx.template topRightCorner<NQ, NQ>().diagonal().array() += dt_;
+                Fx.template bottomRows<NQ>() += dt_ * fx.template bottomRows<NQ>();
+                Fu.template bottomRows<NQ>() = dt_ * fu.template bottomRows<NQ>();
+                break;
+            case Integrator::SymplecticEuler:
+                Fx.template topRightCorner<NQ, NQ>().diagonal().array() += dt_;
+                Fx.template topRows<NQ>() += (dt_ * dt_) * fx.template bottomRows<NQ>();
+                Fx.template bottomRows<NQ>() += dt_ * fx.template bottomRows<NQ>();
+                Fu.template topRows<NQ>() = (dt_ * dt_) * fu.template bottomRows<NQ>();
+                Fu.template bottomRows<NQ>() = dt_ * fu.template bottomRows<NQ>();
+                break;
+            case Integrator::RK2:
+            case Integrator::RK4:
+            {
+                // Each stage k_i = f(x + c_i dt k_{i-1}, u) chains through the derivatives of the previous stage
+                const int num_stages = integrator_ == Integrator::RK2 ? 2 : 4;
+                const double c[4] = {0.0, integrator_ == Integrator::RK2 ? 1.0 : 0.5, 0.5, 1.0};
+                const double b[4] = {integrator_ == Integrator::RK2 ? 0.5 : 1.0 / 6.0, integrator_ == Integrator::RK2 ? 0.5 : 1.0 / 3.0, 1.0 / 3.0, 1.0 / 6.0};
+                FixedStateVector k, x_stage;
+                FixedStateDerivative A, dk_dx = fx;
+                FixedControlDerivative B, dk_du = fu;
+                derived().f_fixed(x, u, k);
+                Fx.noalias() += (b[0] * dt_) * dk_dx;
+                Fu.noalias() += (b[0] * dt_) * dk_du;
+                for (int i = 1; i < num_stages; ++i)
+                {
+                    x_stage.noalias() = x + (c[i] * dt_) * k;
+                    derived().f_fixed(x_stage, u, k);
+                    derived().fx_fixed(x_stage, u, A);
+                    derived().fu_fixed(x_stage, u, B);
+                    const FixedStateDerivative dk_dx_previous = dk_dx;
+                    dk_dx = A;
+                    dk_dx.noalias() += (c[i] * dt_) * A * dk_dx_previous;
+                    dk_du = B + (c[i] * dt_) * A * dk_du;
+                    Fx.noalias() += (b[i] * dt_) * dk_dx;
+                    Fu.noalias() += (b[i] * dt_) * dk_du;
+                }
+            }
+            break;
+            // Implicit function theorem on x_next - x - dt f(x_next, u) = 0, cf. DynamicsSolver::ComputeDerivatives
+            case Integrator::ImplicitEuler:
+            {
+                FixedStateVector xdot, x_next;
+                FixedStateDerivative A;
+                FixedControlDerivative B;
+                derived().f_fixed(x, u, xdot);
+                ImplicitEulerStep(x, u, xdot, x_next);
+                derived().fx_fixed(x_next, u, A);
+                derived().fu_fixed(x_next, u, B);
+                Fx.noalias() -= dt_ * A;
+                const Eigen::PartialPivLU<FixedStateDerivative> lu(Fx);
+                Fx = lu.inverse();
+                Fu.noalias() = lu.solve(dt_ * B);
+            }
+            break;
+            // x_next = x + dt s with (I - dt fx) s = f, the change of fx and fu along s by central differences
+            case Integrator::LinearlyImplicitEuler:
+            {
+                FixedStateVector xdot;
+                FixedStateDerivative A_plus, A_minus;
+                FixedControlDerivative B_plus, B_minus;
+                derived().f_fixed(x, u, xdot);
+                Fx.noalias() -= dt_ * fx;
+                const Eigen::PartialPivLU<FixedStateDerivative> lu(Fx);
+                const FixedStateVector s = lu.solve(xdot);
+
+                const double h = 1e-5 / std::max(1.0, s.norm());
+                derived().fx_fixed(x + (0.5 * h) * s, u, A_plus);
+                derived().fx_fixed(x - (0.5 * h) * s, u, A_minus);
+                derived().fu_fixed(x + (0.5 * h) * s, u, B_plus);
+                derived().fu_fixed(x - (0.5 * h) * s, u, B_minus);
+
+                Fx.noalias() = dt_ * lu.solve(fx + (dt_ / h) * (A_plus - A_minus));
+                Fx.diagonal().array() += 1.0;
+                Fu.noalias() = dt_ * lu.solve(fu + (dt_ / h) * (B_plus - B_minus));
+            }
+            break;
+            default:
+                ThrowPretty("Not implemented!");
+        }
+    }
+};
 }  // namespace exotica
 
 #endif  // EXOTICA_CORE_DYNAMICS_SOLVER_H_
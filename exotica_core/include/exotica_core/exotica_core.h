@@ -34,6 +34,7 @@
 #include <exotica_core/feedback_motion_solver.h>
 #include <exotica_core/loaders/xml_loader.h>
 #include <exotica_core/motion_solver.h>
+#include <exotica_core/pipeline_pool.h>
 #include <exotica_core/planning_problem.h>
 #include <exotica_core/problems/bounded_end_pose_problem.h>
 #include <exotica_core/problems/bounded_time_indexed_problem.h>
@@ -98,6 +98,12 @@ public:
         }
     }
 
+    /// \brief Returns whether a class of the given type has been registered
+    bool HasType(const std::string& type) const
+    {
+        return type_registry_.find(type) != type_registry_.end();
+    }
+
     /// \brief Lists the valid implementations which are available and registered
     std::vector<std::string> GetDeclaredClasses()
     {
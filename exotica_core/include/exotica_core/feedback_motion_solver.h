@@ -30,15 +30,76 @@
 #ifndef EXOTICA_CORE_FEEDBACK_MOTION_SOLVER_H_
 #define EXOTICA_CORE_FEEDBACK_MOTION_SOLVER_H_
 
+#include <exotica_core/dynamics_solver.h>
 #include <exotica_core/motion_solver.h>
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
 namespace exotica
 {
+/// \brief Time-varying affine feedback policy u = U_ref[t] + k[t] + K[t] StateDelta(x, X_ref[t]), clamped to the control limits.
+///
+/// A policy is immutable once constructed, i.e., it can be evaluated from a control thread while the solver that
+/// exported it computes the next one. StateDelta of the dynamics solver has to be safe to call concurrently.
+class FeedbackPolicy
+{
+public:
+    FeedbackPolicy(DynamicsSolverPtr dynamics_solver, std::vector<Eigen::VectorXd> X_ref, std::vector<Eigen::VectorXd> U_ref, std::vector<Eigen::VectorXd> k, std::vector<Eigen::MatrixXd> K);
+
+    /// \brief Returns the control of time step t (0 <= t < get_T() - 1) for the state x.
+    Eigen::VectorXd GetControl(Eigen::VectorXdRefConst x, int t) const;
+
+    int get_T() const { return static_cast<int>(X_ref_.size()); }  ///< Number of time steps of the reference state trajectory
+    const std::vector<Eigen::VectorXd>& get_X_ref() const { return X_ref_; }
+    const std::vector<Eigen::VectorXd>& get_U_ref() const { return U_ref_; }
+    const std::vector<Eigen::VectorXd>& get_k() const { return k_; }
+    const std::vector<Eigen::MatrixXd>& get_K() const { return K_; }
+
+private:
+    const DynamicsSolverPtr dynamics_solver_;
+    const Eigen::MatrixXd control_limits_;
+    const std::vector<Eigen::VectorXd> X_ref_;  ///< Reference states (T)
+    const std::vector<Eigen::VectorXd> U_ref_;  ///< Reference controls (T-1)
+    const std::vector<Eigen::VectorXd> k_;      ///< Feed-forward terms (T-1)
+    const std::vector<Eigen::MatrixXd> K_;      ///< Feedback gains (T-1)
+};
+
+typedef std::shared_ptr<const FeedbackPolicy> FeedbackPolicyConstPtr;
+
 class FeedbackMotionSolver : public MotionSolver
 {
 public:
+    FeedbackMotionSolver();
+
     // \brief Returns a control input given the state x and timestep t.
     virtual Eigen::VectorXd GetFeedbackControl(Eigen::VectorXdRefConst x, int t) const = 0;
+
+    /// \brief Returns the feedback policy exported by the last Solve (nullptr before the first Solve). The policy stays
+    /// valid and unchanged while the solver runs again.
+    FeedbackPolicyConstPtr GetFeedbackPolicy() const;
+
+    /// \brief Evaluates the feedback policy exported by the last Solve. Unlike GetFeedbackControl, this does not read the
+    /// solver state and never waits for a running Solve, i.e., it can be called from a control thread at a high rate.
+    Eigen::VectorXd GetPublishedFeedbackControl(Eigen::VectorXdRefConst x, int t) const;
+
+protected:
+    /// \brief Exports policy to the readers of GetFeedbackPolicy and GetPublishedFeedbackControl. Only called from the
+    /// solving thread; waits for readers still evaluating the policy before the previous one.
+    void PublishFeedbackPolicy(FeedbackPolicyConstPtr policy);
+
+private:
+    // Double buffer of the published policies: readers register in the count of the active slot, the solver only writes
+    // to the inactive slot once its readers have left.
+    std::array<FeedbackPolicyConstPtr, 2> published_policies_;
+    std::atomic<int> active_policy_;
+    mutable std::array<std::atomic<int>, 2> policy_readers_;
+
+    /// \brief Registers a reader of the active slot and returns its index. Lock-free: only retries if a policy was
+    /// published in the meantime.
+    int AcquirePublishedPolicy() const;
 };
 }  // namespace exotica
 
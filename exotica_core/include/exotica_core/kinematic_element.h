@@ -34,6 +34,7 @@
 #include <geometric_shapes/shapes.h>
 #include <kdl/frames.hpp>
 #include <kdl/segment.hpp>
+#include <cstdint>
 #include <stack>
 
 namespace exotica
@@ -86,7 +87,7 @@ public:
         SetChildrenClosestRobotLink();
     }
 
-    inline KDL::Frame GetPose(const double& x = 0.0)
+    inline KDL::Frame GetPose(const double& x = 0.0) const
     {
         if (is_trajectory_generated)
         {
@@ -118,6 +119,7 @@ public:
     std::weak_ptr<KinematicElement> closest_robot_link = std::shared_ptr<KinematicElement>(nullptr);
     KDL::Segment segment = KDL::Segment();
     KDL::Frame frame = KDL::Frame::Identity();
+    std::uint64_t frame_stamp = 0;  // Update stamp of the KinematicTree when the frame was last recomputed
     KDL::Frame generated_offset = KDL::Frame::Identity();
     bool is_trajectory_generated = false;
     std::vector<double> joint_limits;
@@ -31,10 +31,12 @@
 #define EXOTICA_CORE_KINEMATIC_TREE_H_
 
 #include <map>
+#include <memory>
 #include <random>
 #include <string>
 #include <vector>
 
+#include <geometry_msgs/TransformStamped.h>
 #include <moveit/robot_model/robot_model.h>
 #include <tf/transform_datatypes.h>
 #include <visualization_msgs/MarkerArray.h>
@@ -58,7 +60,16 @@ enum KinematicRequestFlags
     KIN_FK = 0,
     KIN_J = 2,
     KIN_FK_VEL = 4,
-    KIN_H = 8
+    KIN_H = 8,
+    KIN_PACKED = 16,
+    KIN_J_DOT = 32
+};
+
+/// @brief Library computing the poses and Jacobians of the requested frames, see KinematicTree::SetKinematicsBackend.
+enum KinematicsBackendType
+{
+    KINEMATICS_BACKEND_KDL = 0,
+    KINEMATICS_BACKEND_PINOCCHIO = 1
 };
 
 enum JointLimitType
@@ -93,6 +104,11 @@ struct KinematicFrameRequest
 struct KinematicsRequest
 {
     KinematicsRequest();
+
+    /// @brief Appends frames to the request, sharing any contiguous run of identical frames requested already.
+    /// @return Index of the first of the frames, which are contiguous in the request (and in the KinematicResponse).
+    int AddFrames(const std::vector<KinematicFrameRequest>& new_frames);
+
     KinematicRequestFlags flags = KinematicRequestFlags::KIN_FK;
     std::vector<KinematicFrameRequest> frames;  // The segments to which the end-effectors are attached
 };
@@ -106,6 +122,7 @@ struct KinematicFrame
     KDL::Frame temp_AB;
     KDL::Frame temp_A;
     KDL::Frame temp_B;
+    std::vector<int> jacobian_columns;  //!< Sorted control ids of the joints moving frame A relative to frame B, i.e., the structurally non-zero Jacobian columns
 };
 
 /// @brief The KinematicResponse is the container to keep kinematic update data.
@@ -120,7 +137,14 @@ struct KinematicResponse
     ArrayFrame Phi;
     ArrayTwist Phi_dot;
     ArrayJacobian jacobian;
+    ArrayJacobian jacobian_dot;
     ArrayHessian hessian;
+
+    int structure_version = -1;  //!< Version of the tree structure the Jacobian columns and Hessians of this response were set up for
+
+    /// @brief Contiguous copy of Phi and jacobian, only allocated when KIN_PACKED is requested.
+    /// Layout: positions (3 x size), rotations (9 x size, each a column-major 3x3 matrix), Jacobians (6 x (N * size)).
+    Eigen::VectorXd packed;
 };
 
 /// @brief The KinematicSolution is created from - and maps into - a KinematicResponse.
@@ -132,16 +156,69 @@ public:
     void Create(std::shared_ptr<KinematicResponse> solution);
     int start = -1;
     int length = -1;
+    const KinematicFrame* frame = nullptr;  //!< Frame definitions (length entries), including the Jacobian sparsity pattern
     Eigen::Map<Eigen::VectorXd> X{nullptr, 0};
     Eigen::Map<ArrayFrame> Phi{nullptr, 0};
     Eigen::Map<ArrayTwist> Phi_dot{nullptr, 0};
     Eigen::Map<ArrayJacobian> jacobian{nullptr, 0};
+    Eigen::Map<ArrayJacobian> jacobian_dot{nullptr, 0};
     Eigen::Map<ArrayHessian> hessian{nullptr, 0};
+
+    // Packed layout (KIN_PACKED)
+    Eigen::Map<Eigen::Matrix3Xd> Phi_position{nullptr, 3, 0};                          //!< Positions, one column per frame
+    Eigen::Map<Eigen::Matrix<double, 9, Eigen::Dynamic>> Phi_rotation{nullptr, 9, 0};  //!< Rotation matrices (column-major), one column per frame
+    Eigen::Map<Eigen::MatrixXd> jacobian_packed{nullptr, 6, 0};                        //!< Jacobians, frame i occupies columns [i * N, (i + 1) * N)
+};
+
+/// @brief Scratch memory for evaluating kinematics without modifying the KinematicTree.
+/// Each thread evaluating kinematics concurrently on the same tree needs its own workspace.
+struct KinematicWorkspace
+{
+    std::vector<const KinematicElement*> elements;  //!< Tree elements in breadth-first order
+    std::vector<int> parents;                       //!< Index of the parent of each element in elements (-1 for the root)
+    std::vector<int> index;                         //!< Index into elements for every element id + 1
+    std::vector<KDL::Frame> frames;                 //!< World frames of all elements, element-major with the states as inner index
+    std::vector<KinematicResponse> responses;       //!< Result of KinematicTree::Update(x, workspace), a single response
+};
+
+/// @brief Fixed-size view of a KinematicSolution for a compile-time number of controlled joints.
+/// The view maps the data of the KinematicSolution without copying it, so the same RequestFrames interface is used,
+/// while task maps for small arms can use fixed-size Eigen arithmetic (no heap allocation, unrolled loops).
+/// @tparam NX Number of controlled joints.
+template <int NX>
+class FixedKinematicSolution
+{
+public:
+    typedef Eigen::Matrix<double, NX, 1> StateType;
+    typedef Eigen::Matrix<double, 6, NX> JacobianType;
+    typedef Eigen::Matrix<double, NX, NX> HessianBlockType;
+
+    FixedKinematicSolution() = default;
+    explicit FixedKinematicSolution(const KinematicSolution& solution) { Create(solution); }
+
+    /// @brief Attaches the view to a KinematicSolution. The KinematicSolution has to outlive the view.
+    void Create(const KinematicSolution& solution)
+    {
+        if (solution.X.rows() != NX) ThrowPretty("Size mismatch: the kinematic solution has " << solution.X.rows() << " controlled joints, expected " << NX);
+        solution_ = &solution;
+    }
+
+    int Size() const { return solution_->Phi.rows(); }
+    Eigen::Map<const StateType> X() const { return Eigen::Map<const StateType>(solution_->X.data()); }
+    const KDL::Frame& Phi(int i) const { return solution_->Phi(i); }
+    Eigen::Map<const JacobianType> Jacobian(int i) const { return Eigen::Map<const JacobianType>(solution_->jacobian(i).data.data()); }
+    Eigen::Map<const HessianBlockType> Hessian(int i, int k) const { return Eigen::Map<const HessianBlockType>(solution_->hessian(i)(k).data()); }
+
+private:
+    const KinematicSolution* solution_ = nullptr;
 };
 
 class KinematicTree : public Uncopyable
 {
 public:
+    KinematicTree();
+    ~KinematicTree();
+
     void Instantiate(const std::string& joint_group, robot_model::RobotModelPtr model, const std::string& name);
     const std::string& GetRootFrameName() const;
     const std::string& GetRootJointName() const;
@@ -150,6 +227,48 @@ public:
     BaseType GetControlledBaseType() const;
     std::shared_ptr<KinematicResponse> RequestFrames(const KinematicsRequest& request);
     void Update(Eigen::VectorXdRefConst x);
+
+    /// @brief Updates the tree and the poses of the requested frames (Phi) for the controlled state x, leaving the Jacobians
+    /// and Hessians of the shared KinematicResponse unchanged. As in Update(x), only the subtrees of joints whose position
+    /// changed are recomputed, e.g., for finite differences perturbing one joint at a time.
+    void UpdateFrames(Eigen::VectorXdRefConst x);
+
+    /// @brief Updates the kinematics for the controlled state x and velocity x_dot.
+    /// In addition to Update(x), this computes the frame velocities (Phi_dot, KIN_FK_VEL) and
+    /// the Jacobian time-derivatives (jacobian_dot, KIN_J_DOT) if requested. Update(x) leaves them unchanged.
+    void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRefConst x_dot);
+
+    /// @brief UpdateBatch evaluates the requested frames for many controlled states at once.
+    /// The tree is traversed once per batch and every element is updated for all states before moving on to its children.
+    /// Neither the internal state nor the shared KinematicResponse are modified.
+    /// @param X Controlled states, one per column (num_controlled_joints x num_states).
+    /// @param out Responses, resized to the number of states. Each is laid out in the same way as the shared KinematicResponse.
+    void UpdateBatch(Eigen::MatrixXdRefConst X, std::vector<KinematicResponse>& out);
+
+    /// @brief Thread-safe variant of UpdateBatch using caller-provided scratch memory.
+    /// Concurrent calls with separate workspaces are safe as long as the tree is not modified (e.g., updated, or frames added) at the same time.
+    void UpdateBatch(Eigen::MatrixXdRefConst X, std::vector<KinematicResponse>& out, KinematicWorkspace& workspace) const;
+
+    /// @brief Computes the world frames of all elements of the tree for many controlled states, without filling in any responses.
+    /// The frame of the element with index i in workspace.elements for state n is workspace.frames[i * X.cols() + n], and
+    /// workspace.index[element->id + 1] is the index of an element. Thread-safe under the same conditions as UpdateBatch with a workspace.
+    /// @param X Controlled states, one per column (num_controlled_joints x num_states).
+    void UpdateBatchFrames(Eigen::MatrixXdRefConst X, KinematicWorkspace& workspace) const;
+
+    /// @brief Evaluates the requested frames for a single controlled state without modifying the tree.
+    /// The result is stored in workspace.responses[0]. Thread-safe under the same conditions as UpdateBatch with a workspace.
+    void Update(Eigen::VectorXdRefConst x, KinematicWorkspace& workspace) const;
+
+    /// @brief Evaluates the pose of element_A (with offset_a) relative to element_B (with offset_b), as in FK, for many controlled states at once.
+    /// Neither the internal state nor the shared KinematicResponse are modified. An empty name refers to the root of the tree.
+    /// @param X Controlled states, one per column (num_controlled_joints x num_states).
+    /// @param poses Poses, resized to the number of states.
+    /// @param jacobians If not null, resized to the number of states and filled with the Jacobians, as in Jacobian.
+    void FKBatch(Eigen::MatrixXdRefConst X, const std::string& element_A, const KDL::Frame& offset_a, const std::string& element_B, const KDL::Frame& offset_b, std::vector<KDL::Frame>& poses, std::vector<KDL::Jacobian>* jacobians = nullptr);
+
+    /// @brief Thread-safe variant of FKBatch using caller-provided scratch memory, under the same conditions as UpdateBatch with a workspace.
+    void FKBatch(Eigen::MatrixXdRefConst X, const std::string& element_A, const KDL::Frame& offset_a, const std::string& element_B, const KDL::Frame& offset_b, std::vector<KDL::Frame>& poses, std::vector<KDL::Jacobian>* jacobians, KinematicWorkspace& workspace) const;
+
     void ResetJointLimits();
     const Eigen::MatrixXd& GetJointLimits() const { return joint_limits_; }
     void SetJointLimitsLower(Eigen::VectorXdRefConst lower_in);
@@ -200,12 +319,36 @@ public:
     exotica::Hessian Hessian(std::shared_ptr<KinematicElement> element_A, const KDL::Frame& offset_a, std::shared_ptr<KinematicElement> element_B, const KDL::Frame& offset_b) const;
     exotica::Hessian Hessian(const std::string& element_A, const KDL::Frame& offset_a, const std::string& element_B, const KDL::Frame& offset_b) const;
 
+    /// @brief Resolves a frame name to an integer handle for the FK/Jacobian/Hessian overloads below, avoiding repeated name lookups.
+    /// Handles of robot links are stable. Handles of environment frames are only valid until the scene is reset (ResetModel)
+    /// or an environment element is removed (RemoveEnvironmentElement).
+    /// @param name Name of the link, an empty string refers to the root frame.
+    /// @return Handle of the frame.
+    int GetFrameHandle(const std::string& name) const;
+    /// @brief Returns the element of a frame handle, without locking it.
+    const KinematicElement& GetElement(int handle) const
+    {
+        if (handle < 0 || handle >= static_cast<int>(frame_handles_.size())) ThrowPretty("Invalid frame handle " << handle);
+        return *frame_handles_[handle];
+    }
+    KDL::Frame FK(int handle_A, const KDL::Frame& offset_a, int handle_B, const KDL::Frame& offset_b) const;
+    Eigen::MatrixXd Jacobian(int handle_A, const KDL::Frame& offset_a, int handle_B, const KDL::Frame& offset_b) const;
+    exotica::Hessian Hessian(int handle_A, const KDL::Frame& offset_a, int handle_B, const KDL::Frame& offset_b) const;
+
     void ResetModel();
+    /// \brief Adds an element to the tree. Elements attached to the root, or to the element added last, are appended to the flattened
+    /// tree in place, so adding many elements in a row takes linear time and leaves the requested frames and their Jacobians valid.
     std::shared_ptr<KinematicElement> AddElement(const std::string& name, const Eigen::Isometry3d& transform, const std::string& parent = "", shapes::ShapeConstPtr shape = shapes::ShapeConstPtr(nullptr), const KDL::RigidBodyInertia& inertia = KDL::RigidBodyInertia::Zero(), const Eigen::Vector4d& color = Eigen::Vector4d(0.5, 0.5, 0.5, 1.0), const std::vector<VisualElement>& visual = {}, bool is_controlled = false);
     std::shared_ptr<KinematicElement> AddEnvironmentElement(const std::string& name, const Eigen::Isometry3d& transform, const std::string& parent = "", shapes::ShapeConstPtr shape = shapes::ShapeConstPtr(nullptr), const KDL::RigidBodyInertia& inertia = KDL::RigidBodyInertia::Zero(), const Eigen::Vector4d& color = Eigen::Vector4d(0.5, 0.5, 0.5, 1.0), const std::vector<VisualElement>& visual = {}, bool is_controlled = false);
     std::shared_ptr<KinematicElement> AddElement(const std::string& name, const Eigen::Isometry3d& transform, const std::string& parent, const std::string& shape_resource_path, Eigen::Vector3d scale = Eigen::Vector3d::Ones(), const KDL::RigidBodyInertia& inertia = KDL::RigidBodyInertia::Zero(), const Eigen::Vector4d& color = Eigen::Vector4d(0.5, 0.5, 0.5, 1.0), const std::vector<VisualElement>& visual = {}, bool is_controlled = false);
+    /// \brief Updates the tree after adding elements or resetting the model. The name maps are only rebuilt after ResetModel.
     void UpdateModel();
     void ChangeParent(const std::string& name, const std::string& parent, const KDL::Frame& pose, bool relative);
+    /// \brief Sets the pose of an element relative to its parent. Only the subtree of the element is recomputed by the next update.
+    void SetElementPose(const std::string& name, const KDL::Frame& pose);
+    /// \brief Removes an environment element and its descendants (e.g., a world object and its collision shapes), which all have to be
+    /// environment elements. The flattened tree is updated in place. The ids of the elements added after them are decremented.
+    void RemoveEnvironmentElement(const std::string& name);
     int IsControlled(std::shared_ptr<KinematicElement> joint);
     int IsControlledLink(const std::string& link_name);
 
@@ -229,6 +372,7 @@ public:
     Eigen::VectorXd GetControlledState() const;
 
     const std::vector<std::weak_ptr<KinematicElement>>& GetTree() const { return tree_; }
+    const Eigen::VectorXd& GetTreeState() const { return tree_state_; }  //!< Joint positions of all elements, indexed by KinematicElement::id
     const std::vector<std::shared_ptr<KinematicElement>>& GetModelTree() const { return model_tree_; }
     const std::map<std::string, std::weak_ptr<KinematicElement>>& GetTreeMap() const { return tree_map_; }
     const std::map<std::string, std::weak_ptr<KinematicElement>>& GetCollisionTreeMap() const { return collision_tree_map_; }
@@ -242,23 +386,132 @@ public:
 
     /// @brief SetSeed sets the seed of the random generator for deterministic joint state sampling
     /// @param seed unsigned integer
-    void SetSeed(const uint_fast32_t seed) { generator_.seed(seed); }
+    void SetSeed(const uint_fast32_t seed)
+    {
+        generator_.seed(seed);
+        bulk_seed_ = seed;
+    }
     /// Random state generation
     Eigen::VectorXd GetRandomControlledState();
 
+    /// @brief Fills a matrix with uniformly distributed controlled states within the joint limits, one state per column.
+    /// Uses a counter-based generator: sample k of a stream only depends on the seed, the stream and k, hence separate
+    /// threads can sample from separate streams (or disjoint offsets of one stream) without sharing state.
+    /// @param states Output matrix (num_controlled_joints x num_samples).
+    /// @param stream Index of the random stream, e.g., the thread id.
+    /// @param offset Index of the first sample within the stream.
+    void GetRandomControlledStates(Eigen::MatrixXdRef states, std::uint64_t stream = 0, std::uint64_t offset = 0) const;
+
+    /// @brief Returns the number of elements whose frames were recomputed during the last update.
+    /// Only the subtrees below joints that changed (and below trajectory-generated elements) are recomputed.
+    std::size_t GetNumUpdatedElements() const { return num_updated_elements_; }
+    /// @brief Returns the stamp of the last update, incremented on every update of the tree.
+    /// Every element stores the stamp of the update that last recomputed its frame (KinematicElement::frame_stamp),
+    /// i.e., an element moved since a previously stored stamp s iff its frame_stamp > s.
+    std::uint64_t GetUpdateStamp() const { return update_stamp_; }
+    /// @brief Invalidates all element frames. Required after modifying KinematicElements (e.g. their pose or trajectory) directly.
+    void RequestFullTreeUpdate()
+    {
+        full_tree_update_required_ = true;
+        tree_compiled_ = false;
+    }
+
+    /// @brief Sets the number of threads used to compute the Jacobians and Hessians of the requested frames.
+    /// @param num_threads Number of threads (1: serial, 0: use all hardware threads).
+    /// @param parallel_threshold Minimum number of requested frames for which the computation is split across threads.
+    void SetNumThreads(int num_threads, int parallel_threshold = 16);
+    int GetNumThreads() const { return num_threads_; }
+
+    /// @brief Selects the library computing the poses and Jacobians of the requested frames in Update.
+    /// Pinocchio evaluates the Jacobians of all robot joints at once (computeJointJacobians) and maps them into the KinematicResponse in
+    /// the same conventions as KDL. Requests without Jacobians and UpdateFrames compose the poses from the element frames of the tree,
+    /// which gains nothing from Pinocchio. The Pinocchio model is kept when switching back to KDL. It requires a fixed base, and frames whose chains contain controlled elements
+    /// that are not part of the URDF (e.g., controlled environment elements) are still computed with KDL. The element frames of the tree,
+    /// Hessians, the batch evaluation and the FK/Jacobian/Hessian queries always use KDL. Falls back to KDL with a warning if
+    /// exotica_core was built without Pinocchio or the model is not supported.
+    void SetKinematicsBackend(KinematicsBackendType backend);
+    KinematicsBackendType GetKinematicsBackend() const { return backend_; }
+
     void SetKinematicResponse(std::shared_ptr<KinematicResponse> response_in) { solution_ = response_in; }
     std::shared_ptr<KinematicResponse> GetKinematicResponse() { return solution_; }
+
+    /// @brief Provides T copies of the current KinematicResponse, e.g., one per time step, for use with SetKinematicResponse.
+    /// The copies are allocated in one contiguous pool owned by the tree. The pool is reused as long as the kinematic request
+    /// does not change and the previously provided responses have been released, i.e., changing only T does not reallocate.
+    /// @param T Number of responses.
+    /// @param responses Output, resized to T.
+    void GetKinematicResponses(int T, std::vector<std::shared_ptr<KinematicResponse>>& responses);
     bool debug = false;
+    bool publish_debug_frames = true;       //!< Whether updates publish the frames in debug mode (disabled when the Scene publishes asynchronously)
+    double publish_frames_threshold = 1e-6;  //!< PublishFrames skips frames that moved less than this (m or rad) since they were last published
+    double publish_frames_keepalive = 1.0;   //!< Period (s) after which PublishFrames publishes all frames again, so that TF listeners keep them
 
 private:
     void BuildTree(const KDL::Tree& RobotKinematics);
     void AddElementFromSegmentMapIterator(KDL::SegmentMap::const_iterator segment, std::shared_ptr<KinematicElement> parent);
+    void CompileTree();
+    /// \brief Appends a new element to the flattened tree without recompiling it. Only possible if the subtree of the parent ends at the
+    /// end of the flattened tree, returns false otherwise.
+    bool AppendFlatElement(KinematicElement* element, KinematicElement* parent);
+    void UpdateState(Eigen::VectorXdRefConst x);
     void UpdateTree();
+    void UpdateFlatElements(int begin, int end);
     void UpdateFK();
     void UpdateJ();
     void ComputeJ(KinematicFrame& frame, KDL::Jacobian& jacobian) const;
+    void ComputeJacobianColumns(KinematicFrame& frame) const;
+    /// \brief Sets up the Jacobian columns and clears the Hessians of the active response if it was created for an older structure of the tree.
+    void RefreshStaleResponse();
     void UpdateH();
     void ComputeH(KinematicFrame& frame, const KDL::Jacobian& jacobian, exotica::Hessian& hessian) const;
+    void ComputeH(const std::vector<int>& jacobian_columns, const KDL::Jacobian& jacobian, exotica::Hessian& hessian) const;
+    /// \brief Jacobian of two elements of the compiled tree. Walks the flattened parents instead of locking the parent pointers.
+    /// \param jacobian_columns If not null, receives the sorted control ids of the joints in the chains, as in ComputeJacobianColumns.
+    void ComputeJ(const KinematicElement* element_A, const KDL::Frame& offset_a, const KinematicElement* element_B, const KDL::Frame& offset_b, KDL::Jacobian& jacobian, std::vector<int>* jacobian_columns) const;
+    Eigen::MatrixXd Jacobian(const KinematicElement* element_A, const KDL::Frame& offset_a, const KinematicElement* element_B, const KDL::Frame& offset_b) const;
+    exotica::Hessian Hessian(const KinematicElement* element_A, const KDL::Frame& offset_a, const KinematicElement* element_B, const KDL::Frame& offset_b) const;
+    void UpdateJdot(Eigen::VectorXdRefConst x_dot);
+    void ComputeJdot(const KinematicFrame& frame, const KDL::Jacobian& jacobian, Eigen::VectorXdRefConst x_dot, KDL::Jacobian& jacobian_dot) const;
+    void UpdatePacked(KinematicResponse& response) const;
+    void ComputeBatchJ(Eigen::MatrixXdRefConst X, int n, const KinematicWorkspace& workspace, int index_A, const KDL::Frame& frame_A, int index_B, const KDL::Frame& frame_B, KDL::Jacobian& jacobian) const;
+
+    // Flattened tree, compiled from the object graph whenever the model changes
+    bool tree_compiled_ = false;                    //!< Whether the flattened tree is up to date with the object graph
+    std::vector<KinematicElement*> flat_elements_;  //!< Elements in depth-first order
+    std::vector<int> flat_parents_;                 //!< Index of the parent of each element (-1 for the root)
+    std::vector<int> flat_subtree_end_;             //!< One past the index of the last descendant of each element
+    std::vector<int> flat_state_index_;             //!< Index into tree_state_ for moving joints, -1 for constant poses, -2 for trajectory-generated elements
+    std::vector<KDL::Frame> flat_local_poses_;      //!< Local poses of elements with constant poses, last generated poses of trajectory-generated elements
+    std::vector<KDL::Frame> flat_frames_;           //!< World frames of the elements
+    std::vector<int> flat_index_;                   //!< Index into the flattened tree for every element id + 1
+    std::vector<int> flat_trajectory_indices_;      //!< Indices of the trajectory-generated elements, updated whenever their generated pose changes
+
+    // Incremental tree update
+    bool full_tree_update_required_ = true;  //!< Whether all element frames have to be recomputed on the next update
+    std::size_t num_updated_elements_ = 0;   //!< Number of element frames recomputed during the last update
+    std::uint64_t update_stamp_ = 0;         //!< Incremented on every update, stored on the elements whose frames are recomputed
+    std::vector<int> changed_elements_;      //!< Ids of the elements whose pose changed since the last update
+    std::vector<int> changed_flat_indices_;  //!< Scratch memory for UpdateTree
+
+    // Response pool
+    std::shared_ptr<std::vector<KinematicResponse>> response_pool_;  //!< Contiguous responses handed out by GetKinematicResponses
+    int request_version_ = 0;                                        //!< Incremented on every RequestFrames
+    int response_pool_version_ = -1;                                 //!< Request version the pool was created for
+    int structure_version_ = 0;                                      //!< Incremented whenever the structure of the tree changes
+
+    // Pinocchio backend (kinematic_tree_pinocchio.cpp)
+    struct PinocchioKinematics;
+    std::unique_ptr<PinocchioKinematics> pinocchio_;
+    KinematicsBackendType backend_ = KINEMATICS_BACKEND_KDL;
+    /// \brief Computes the poses and Jacobians of the requested frames with Pinocchio.
+    void UpdatePinocchio();
+
+    // Threading
+    int num_threads_ = 1;          //!< Number of threads for UpdateJ/UpdateH
+    int parallel_threshold_ = 16;  //!< Minimum number of frames for running UpdateJ/UpdateH in parallel
+
+    // Batch evaluation
+    KinematicWorkspace batch_workspace_;
 
     // Joint limits
     // TODO: Add effort limits
@@ -272,6 +525,7 @@ private:
     std::random_device rd_;
     std::mt19937 generator_;
     std::vector<std::uniform_real_distribution<double>> random_state_distributions_;
+    std::uint64_t bulk_seed_ = 0;  //!< Seed of the counter-based generator used by GetRandomControlledStates
 
     BaseType model_base_type_;
     BaseType controlled_base_type_ = BaseType::FIXED;
@@ -280,8 +534,10 @@ private:
     int state_size_ = -1;
     Eigen::VectorXd tree_state_;
     robot_model::RobotModelPtr model_;
+    std::shared_ptr<const KDL::Tree> kdl_tree_;  //!< Keeps the KDL tree cached by the Server alive while the model is in use
     std::string root_joint_name_ = "";
     std::vector<std::weak_ptr<KinematicElement>> tree_;
+    std::vector<const KinematicElement*> frame_handles_;  //!< Elements of tree_ indexed by frame handle
     std::vector<std::shared_ptr<KinematicElement>> model_tree_;
     std::vector<std::shared_ptr<KinematicElement>> environment_tree_;
     std::map<std::string, std::weak_ptr<KinematicElement>> tree_map_;
@@ -297,8 +553,16 @@ private:
     std::shared_ptr<KinematicResponse> solution_ = std::make_shared<KinematicResponse>();
     KinematicRequestFlags flags_;
 
-    std::vector<tf::StampedTransform> debug_tree_;
-    std::vector<tf::StampedTransform> debug_frames_;
+    /// \brief Rebuilds the frame ids of debug_transforms_ after the tree, the request or the prefix changed
+    void BuildDebugTransforms(const std::string& tf_prefix);
+
+    std::vector<geometry_msgs::TransformStamped> debug_transforms_;          ///< Tree elements followed by the two transforms of each requested frame
+    std::vector<geometry_msgs::TransformStamped> debug_changed_transforms_;  ///< Subset of debug_transforms_ sent by PublishFrames
+    std::vector<KDL::Frame> debug_published_frames_;                         ///< Poses last published for debug_transforms_
+    std::vector<std::size_t> debug_changed_indices_;
+    std::string debug_tf_prefix_;
+    bool debug_transforms_valid_ = false;
+    ros::Time debug_full_publish_time_;
     ros::Publisher shapes_pub_;
     ros::Publisher octomap_pub_;
     bool debug_scene_changed_;
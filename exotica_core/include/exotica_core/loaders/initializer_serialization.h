@@ -0,0 +1,54 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_INITIALIZER_SERIALIZATION_H_
+#define EXOTICA_CORE_INITIALIZER_SERIALIZATION_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include <exotica_core/property.h>
+
+namespace exotica
+{
+/// \brief Writes initializers in a compact binary format. Only string and initializer vector properties are supported, i.e., the
+/// properties created by the XML loader, other property types throw.
+void SerializeInitializers(const std::vector<Initializer>& initializers, std::ostream& out);
+
+/// \brief Reads initializers written by SerializeInitializers. Returns false if the data is truncated, corrupt or was written by an
+/// incompatible version of the format.
+bool DeserializeInitializers(std::istream& in, std::vector<Initializer>& initializers);
+
+/// \brief 64-bit FNV-1a hash, e.g., of the contents of configuration files.
+std::uint64_t HashContent(const std::string& content, std::uint64_t seed = 14695981039346656037ULL);
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_INITIALIZER_SERIALIZATION_H_
@@ -35,6 +35,13 @@
 #include <exotica_core/property.h>
 #include <exotica_core/setup.h>
 
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace exotica
 {
 class XMLLoader
@@ -50,6 +57,20 @@ public:
     {
     }
 
+    /// \brief Enables the on-disk cache of parsed configurations in directory (created if needed), an empty directory disables it.
+    /// Entries are keyed on a hash of the XML content, hence edited files are parsed again. Defaults to the environment variable
+    /// EXOTICA_CONFIG_CACHE_DIR. Parsed configurations are cached in memory regardless.
+    static void SetCacheDirectory(const std::string& directory) { Instance()->cache_directory_ = directory; }
+    static const std::string& GetCacheDirectory() { return Instance()->cache_directory_; }
+
+    /// \brief Clears the in-memory cache of parsed configurations. The on-disk cache is kept.
+    static void ClearCache();
+
+    /// \brief Sets the maximum number of configurations kept in memory (default 64), the oldest ones are evicted first.
+    static void SetCacheCapacity(std::size_t capacity);
+    static std::size_t GetCacheCapacity() { return Instance()->cache_capacity_; }
+    static std::size_t GetCacheSize();
+
     Initializer LoadXML(std::string file_name, bool parsePathAsXML = false);
     void LoadXML(std::string file_name, Initializer& solver, Initializer& problem, const std::string& solver_name = "", const std::string& problem_name = "", bool parsePathAsXML = false);
     static void Load(std::string file_name, Initializer& solver, Initializer& problem, const std::string& solver_name = "", const std::string& problem_name = "", bool parsePathAsXML = false)
@@ -89,6 +110,18 @@ public:
 private:
     XMLLoader();
     static std::shared_ptr<XMLLoader> instance_;
+
+    /// \brief Returns the top-level initializers of the document (only the first one if first_only), from the caches if possible.
+    std::vector<Initializer> LoadInitializers(const std::string& file_name, bool parsePathAsXML, bool first_only);
+
+    /// \brief Evicts the oldest in-memory entries beyond the capacity, requires cache_mutex_ to be held.
+    void TrimCache();
+
+    std::string cache_directory_;
+    std::mutex cache_mutex_;
+    std::unordered_map<std::uint64_t, std::vector<Initializer>> cache_;
+    std::deque<std::uint64_t> cache_order_;  ///< Keys of cache_ in insertion order
+    std::size_t cache_capacity_ = 64;
 };
 }  // namespace exotica
 
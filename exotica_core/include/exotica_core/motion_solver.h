@@ -30,6 +30,9 @@
 #ifndef EXOTICA_CORE_MOTION_SOLVER_H_
 #define EXOTICA_CORE_MOTION_SOLVER_H_
 
+#include <atomic>
+#include <map>
+
 #include <exotica_core/factory.h>
 #include <exotica_core/object.h>
 #include <exotica_core/planning_problem.h>
@@ -57,10 +60,38 @@ public:
     int GetNumberOfMaxIterations() { return max_iterations_; }
     double GetPlanningTime() { return planning_time_; }
 
+    /// \brief Solves the problem from each of the seeds (start states) and returns the best solution, i.e. the valid one with the lowest cost.
+    /// The seeds are solved in parallel by clones of this solver on clones of the problem (see PlanningProblem::Clone). All of them stop as soon as
+    /// one finds a valid solution within the function tolerance (see IsStopRequested). Supports problems implementing PlanningProblem::UpdateEndPoseCost, i.e., the end-pose problems.
+    void SolveMultiStart(const std::vector<Eigen::VectorXd>& seeds, Eigen::MatrixXd& solution);
+
+    /// \brief Solves the problem for each of the targets from each of the seeds, e.g. for reachability checks of many candidate poses.
+    /// A target sets the goals of cost tasks by name, the goals of tasks it does not list are those of the problem. The (target, seed)
+    /// pairs are solved in parallel by the solvers of SolveMultiStart, the seeds of a target stop as soon as one finds a valid solution
+    /// within the function tolerance. The goals and the start state of the problem are left unchanged. Supports problems implementing PlanningProblem::GetCostGoal and SetCostGoal.
+    /// @param targets Goals of the cost tasks by task name, for each target
+    /// @param seeds Start states tried for each target
+    /// @param solutions Best solution of each target, valid ones are preferred, then the one with the lowest cost
+    /// @param success Whether the solution of each target is valid and reached the function tolerance
+    void SolveBatch(const std::vector<std::map<std::string, Eigen::VectorXd>>& targets, const std::vector<Eigen::VectorXd>& seeds, std::vector<Eigen::VectorXd>& solutions, std::vector<bool>& success);
+    void SetMultiStartNumThreads(int num_threads);
+    int GetMultiStartNumThreads() const { return multi_start_num_threads_; }
+
 protected:
+    /// \brief Whether another solver of SolveMultiStart already found a solution. Solvers supporting it stop iterating with TerminationCriterion::UserDefined.
+    bool IsStopRequested() const { return stop_requested_ != nullptr && stop_requested_->load(std::memory_order_relaxed); }
+
     PlanningProblemPtr problem_;
     double planning_time_ = -1;
     int max_iterations_ = 100;
+
+private:
+    void UpdateMultiStartWorkers(int num_workers);
+
+    Initializer initializer_;  ///< Used to create the solvers of SolveMultiStart
+    int multi_start_num_threads_ = 1;
+    std::vector<std::shared_ptr<MotionSolver>> multi_start_workers_;
+    std::shared_ptr<const std::atomic<bool>> stop_requested_;
 };
 
 typedef std::shared_ptr<exotica::MotionSolver> MotionSolverPtr;
@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_PIPELINE_POOL_H_
+#define EXOTICA_CORE_PIPELINE_POOL_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <exotica_core/motion_solver.h>
+#include <exotica_core/planning_problem.h>
+#include <exotica_core/property.h>
+#include <exotica_core/tools/uncopyable.h>
+
+namespace exotica
+{
+/// \brief Pool of solvers and their problems (and scenes), instantiated once from the same configuration and reused by
+/// concurrent requests, e.g., of a planning service solving for different goals. Acquire hands out a solver whose problem has been
+/// reset to the reference problem of the pool (see PlanningProblem::UpdateClone), the solver is returned to the pool when the last
+/// copy of the returned pointer is destroyed. Problems whose world has been changed (objects added, attached or removed) are
+/// instantiated again instead. Supports the problems implementing UpdateClone, i.e., the end-pose and time-indexed problems.
+class PipelinePool : Uncopyable
+{
+public:
+    /// \param solver Initializer of the solvers
+    /// \param problem Initializer of the problems
+    /// \param size Number of pipelines instantiated up front, 0 uses the number of hardware threads
+    PipelinePool(const Initializer& solver, const Initializer& problem, int size = 0);
+
+    /// \brief Loads the solver and problem initializers from an XML configuration file (see XMLLoader::LoadSolver).
+    PipelinePool(const std::string& file_name, int size = 0);
+
+    /// \brief Returns a solver with a clean problem, waits for one to be released if all are in use.
+    MotionSolverPtr Acquire();
+
+    /// \brief Returns a solver with a clean problem, or nullptr if all are in use.
+    MotionSolverPtr TryAcquire();
+
+    /// \brief The problem the pooled problems are reset to, e.g., to change the default goals of future requests. Must not be
+    /// changed while solvers are being acquired.
+    PlanningProblemPtr GetReferenceProblem() const { return reference_problem_; }
+
+    int GetSize() const { return size_; }
+    int GetNumAvailable() const;
+
+private:
+    struct Pipeline
+    {
+        MotionSolverPtr solver;
+        int world_version;  ///< World version of the scene when the pipeline was handed out
+    };
+
+    /// \brief Shared with the handed out solvers, so they can be returned after the pool has been destroyed.
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable released;
+        std::vector<Pipeline> idle;
+    };
+
+    void Initialize(int size);
+    Pipeline CreatePipeline() const;
+    MotionSolverPtr HandOut(Pipeline pipeline);
+
+    Initializer solver_initializer_;
+    Initializer problem_initializer_;
+    PlanningProblemPtr reference_problem_;
+    int max_iterations_ = 100;
+    int size_ = 0;
+    std::shared_ptr<State> state_;
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_PIPELINE_POOL_H_
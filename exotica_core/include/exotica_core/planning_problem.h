@@ -40,6 +40,8 @@
 #include <exotica_core/task_map.h>
 #include <exotica_core/task_space_vector.h>
 #include <exotica_core/tools/conversions.h>
+#include <exotica_core/tools/iteration_telemetry.h>
+#include <exotica_core/tools/problem_recorder.h>
 #include <exotica_core/tools/uncopyable.h>
 
 #define REGISTER_PROBLEM_TYPE(TYPE, DERIV) EXOTICA_CORE_REGISTER_CORE(exotica::PlanningProblem, TYPE, DERIV)
@@ -88,9 +90,36 @@ public:
     double GetCostEvolution(int index) const;
     void ResetCostEvolution(size_t size);
     void SetCostEvolution(int index, double value);
+    /// \brief Sets the cost of iteration index to record.cost and streams the record to the iteration telemetry.
+    void SetCostEvolution(int index, const IterationRecord& record);
+    /// \brief Returns the records of the solver iterations, which can be read from another thread while solving (see IterationTelemetry).
+    /// Every SetCostEvolution streams a record, ResetCostEvolution restarts its wall time.
+    const IterationTelemetry& GetIterationTelemetry() const { return iteration_telemetry_; }
+    /// \brief Records the inputs of the problem to the recorder (see ProblemRecorder), nullptr stops recording.
+    void SetRecorder(std::shared_ptr<ProblemRecorder> recorder);
+    const std::shared_ptr<ProblemRecorder>& GetRecorder() const { return recorder_; }
     KinematicRequestFlags GetFlags() const { return flags_; }
     /// \brief Evaluates whether the problem is valid.
     virtual bool IsValid() { ThrowNamed("Not implemented"); };
+
+    /// \brief Creates an independent copy of the problem, e.g. to solve it from several seeds in parallel (see MotionSolver::SolveMultiStart).
+    /// The clone is instantiated from the initializer of this problem, i.e. objects added to the scene afterwards are not copied.
+    /// The robot model is cached by the Server and thus shared between the clones.
+    std::shared_ptr<PlanningProblem> Clone() const;
+
+    /// \brief Copies the state that may have changed since the instantiation (start state, model state, joint limits, goals and weights) to a clone of this problem.
+    virtual void UpdateClone(PlanningProblem& clone) const { ThrowNamed("Cloning is not implemented for problems of type '" << type() << "'!"); }
+
+    /// \brief Whether UpdateClone, and hence Clone, are implemented for this type of problem.
+    virtual bool SupportsCloning() const { return false; }
+
+    /// \brief Updates an end-pose problem at x and returns its scalar cost, which ranks the solutions of MotionSolver::SolveMultiStart.
+    virtual double UpdateEndPoseCost(Eigen::VectorXdRefConst x) { ThrowNamed("Multi-start solving is not supported for problems of type '" << type() << "'!"); }
+
+    /// \brief Goal of a cost task of an end-pose problem, the goals define the targets of MotionSolver::SolveBatch.
+    virtual Eigen::VectorXd GetCostGoal(const std::string& task_name) { ThrowNamed("Batch solving is not supported for problems of type '" << type() << "'!"); }
+    virtual void SetCostGoal(const std::string& task_name, Eigen::VectorXdRefConst goal) { ThrowNamed("Batch solving is not supported for problems of type '" << type() << "'!"); }
+
     double t_start;
     TerminationCriterion termination_criterion;
 
@@ -103,6 +132,15 @@ protected:
     void UpdateTaskKinematics(std::shared_ptr<KinematicResponse> response);
     void UpdateMultipleTaskKinematics(std::vector<std::shared_ptr<KinematicResponse>> responses);
 
+    /// \brief Copies the start state and time, the model state and the joint limits to a clone (used by UpdateClone).
+    void UpdateCloneBase(PlanningProblem& clone) const;
+
+    /// \brief Clones tasks_ onto a workspace scene (see Scene::CloneWorkspace) and requests their frames in the same order as this problem.
+    /// \param workspace Scene the clones of the task maps are evaluated on.
+    /// \param flags Kinematics flags requested for the frames of the clones.
+    /// \return Clones of tasks_, in the same order.
+    TaskMapVec CloneTasks(const ScenePtr& workspace, KinematicRequestFlags flags) const;
+
     ScenePtr scene_;
     TaskMapMap task_maps_;
     TaskMapVec tasks_;
@@ -110,6 +148,9 @@ protected:
     Eigen::VectorXd start_state_;
     unsigned int number_of_problem_updates_ = 0;  // Stores number of times the problem has been updated
     std::vector<std::pair<std::chrono::high_resolution_clock::time_point, double>> cost_evolution_;
+    IterationTelemetry iteration_telemetry_;
+    Initializer initializer_;                    ///< Used to create the clones of the problem
+    std::shared_ptr<ProblemRecorder> recorder_;  ///< See SetRecorder
 };
 
 typedef Factory<PlanningProblem> PlanningProblemFac;
@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_PLUGIN_FACTORY_H_
+#define EXOTICA_CORE_PLUGIN_FACTORY_H_
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <exotica_core/factory.h>
+#include <exotica_core/tools.h>
+
+#include <pluginlib/class_loader.h>
+
+namespace exotica
+{
+/// \brief Creates plug-ins of BaseClass. Plug-ins register their creator functions in the Factory when their library is loaded
+/// (see EXOTICA_CORE_REGISTER), hence pluginlib is only used to resolve and load a plug-in the first time it is requested. Later
+/// requests call the registered creator directly. When all plug-ins are linked statically (make sure the linker keeps their
+/// registrars, e.g., with --whole-archive), pluginlib is not used at all.
+template <class BaseClass>
+class PluginFactory
+{
+public:
+    PluginFactory(const std::string& package, const std::string& base_class) : package_(package), base_class_(base_class)
+    {
+    }
+
+    std::shared_ptr<BaseClass> CreateInstance(const std::string& type)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        Factory<BaseClass>& factory = Factory<BaseClass>::Instance();
+        if (factory.HasType(type)) return factory.CreateInstance(type);
+        return ToStdPtr(GetClassLoader().createInstance(type));
+    }
+
+    /// \brief Lists the plug-ins declared to pluginlib and the ones registered statically.
+    std::vector<std::string> GetDeclaredClasses()
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::vector<std::string> ret;
+        try
+        {
+            ret = GetClassLoader().getDeclaredClasses();
+        }
+        catch (const pluginlib::PluginlibException& e)
+        {
+            WARNING_NAMED("PluginFactory", "Can't list the " << base_class_ << " plug-ins declared to pluginlib: " << e.what());
+        }
+        for (const std::string& type : Factory<BaseClass>::Instance().GetDeclaredClasses())
+        {
+            if (std::find(ret.begin(), ret.end(), type) == ret.end()) ret.push_back(type);
+        }
+        return ret;
+    }
+
+private:
+    /// \brief The class loader is only constructed when needed as it scans the plug-in manifests of all packages.
+    pluginlib::ClassLoader<BaseClass>& GetClassLoader()
+    {
+        if (!class_loader_) class_loader_.reset(new pluginlib::ClassLoader<BaseClass>(package_, base_class_));
+        return *class_loader_;
+    }
+
+    std::string package_;
+    std::string base_class_;
+    std::unique_ptr<pluginlib::ClassLoader<BaseClass>> class_loader_;
+    std::recursive_mutex mutex_;  // Recursive, as constructors of plug-ins may create other plug-ins
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_PLUGIN_FACTORY_H_
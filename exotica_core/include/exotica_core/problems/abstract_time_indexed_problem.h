@@ -52,6 +52,37 @@ public:
     /// \param t        Timestep to update
     virtual void Update(Eigen::VectorXdRefConst x_in, int t);
 
+    /// \brief Sets the number of threads evaluating the time steps of Update(x_trajectory_in) in parallel (1: serial, 0: all hardware threads).
+    /// Each thread evaluates a block of time steps on its own clone of the scene and the task maps. The clones are created from the
+    /// initializers of the task maps, hence changes to task maps after their instantiation are not reflected. Problems with task maps
+    /// using the kinematics of previous time steps are always updated serially. The kinematic responses of the time steps are not
+    /// updated by the parallel evaluation.
+    void SetTrajectoryNumThreads(int num_threads);
+
+    /// \brief Returns the number of threads evaluating the time steps of Update(x_trajectory_in).
+    int GetTrajectoryNumThreads() const { return trajectory_num_threads_; }
+
+    /// \brief Sets whether Update(x_trajectory_in) skips the time steps whose state and previous state did not change since they were last evaluated.
+    /// Changes of goals, Rho (PreUpdate) or of the world invalidate all time steps. Other changes the problem can not observe, e.g., of the members
+    /// of task maps or of joints that are not controlled, require a call to InvalidateTimeSteps.
+    void SetSkipUnchangedTimeSteps(bool skip) { skip_unchanged_time_steps_ = skip; }
+    bool GetSkipUnchangedTimeSteps() const { return skip_unchanged_time_steps_; }
+
+    /// \brief Marks all time steps for re-evaluation by the next Update(x_trajectory_in).
+    void InvalidateTimeSteps();
+
+    /// \brief Returns the number of time steps evaluated by the last Update(x_trajectory_in).
+    int GetNumberOfRecomputedTimeSteps() const { return number_of_recomputed_time_steps_; }
+
+    /// \brief Shifts the trajectory by k time steps for a receding-horizon re-solve (warm start): time step t takes the state, task-map values
+    /// and kinematic response of time step t + k, the last k states are extrapolated at the velocity of the last shifted time step (clamped to
+    /// the joint limits) and evaluated, and the shifted trajectory becomes the initial trajectory. The storage is reused, i.e., no variables
+    /// are reinitialised. Goals and Rho stay indexed by the time step of the horizon and the time-indexed tasks of the shifted time steps are
+    /// updated for them. The first time step is shifted as well, i.e., x[0] becomes the old x[k], whereas the start state is not changed:
+    /// set it to the measured state with SetStartState before re-solving.
+    /// \param k    Number of time steps to shift by, 0 < k < T.
+    void ShiftTrajectory(int k);
+
     /// \brief Returns the duration of the trajectory (T * tau).
     double GetDuration() const;
 
@@ -65,6 +96,10 @@ public:
     /// \brief Updates internal variables before solving, e.g., after setting new values for Rho.
     virtual void PreUpdate();
 
+    /// \brief Copies the number of time steps, time step duration, goals, weights, joint velocity limits and initial trajectory to a clone.
+    void UpdateClone(PlanningProblem& clone) const override;
+    bool SupportsCloning() const override { return true; }
+
     /// \brief Sets goal for a given task at a given timestep (cost task).
     /// \param task_name    Name of task
     /// \param goal         Goal
@@ -146,6 +181,11 @@ public:
     /// \brief Sets the time discretization tau for the trajectory.
     void SetTau(const double tau_in);
 
+    /// \brief Changes the number of time steps to T_in while keeping the duration (T-1)*tau of the trajectory, e.g., to solve coarse-to-fine
+    /// (see MultiresolutionLevels of the solvers). The goals and weights of each time step are those of the nearest time step of the resolution
+    /// before the first call, which is restored exactly when it is set again. The initial trajectory is interpolated linearly.
+    void SetResolution(int T_in);
+
     /// \brief Returns the cost scaling factor.
     double get_ct() const;
 
@@ -155,18 +195,27 @@ public:
     /// \brief Returns the Jacobian of the scalar task cost at timestep t
     Eigen::RowVectorXd GetScalarTaskJacobian(int t) const;
 
+    /// \brief Writes the Jacobian of the scalar task cost at timestep t into jacobian (of size N) without allocating.
+    void GetScalarTaskJacobian(int t, Eigen::Ref<Eigen::RowVectorXd> jacobian) const;
+
     /// \brief Returns the scalar transition cost (x^T*W*x) at timestep t
     double GetScalarTransitionCost(int t) const;
 
     /// \brief Returns the Jacobian of the transition cost at timestep t
     Eigen::RowVectorXd GetScalarTransitionJacobian(int t) const;
 
+    /// \brief Writes the Jacobian of the transition cost at timestep t into jacobian (of size N) without allocating.
+    void GetScalarTransitionJacobian(int t, Eigen::Ref<Eigen::RowVectorXd> jacobian) const;
+
     /// \brief Returns the scalar cost for the entire trajectory (both task and transition cost).
     double GetCost() const;
 
     /// \brief Returns the Jacobian of the scalar cost over the entire trajectory (Jacobian of GetCost).
     Eigen::RowVectorXd GetCostJacobian() const;
 
+    /// \brief Writes the Jacobian of the scalar cost over the entire trajectory into jacobian (of size N * (T - 1)) without allocating.
+    void GetCostJacobian(Eigen::Ref<Eigen::RowVectorXd> jacobian) const;
+
     /// \brief Returns the equality constraint values for the entire trajectory.
     Eigen::VectorXd GetEquality() const;
 
@@ -182,6 +231,30 @@ public:
     /// \brief Returns a vector of triplets to fill a sparse Jacobian for the equality constraints.
     std::vector<Eigen::Triplet<double>> GetEqualityJacobianTriplets() const;
 
+    /// \brief Returns the sparse Jacobian of the equality constraints over the entire trajectory, as GetEqualityJacobian.
+    /// The sparsity pattern is only rebuilt when the active constraints change (PreUpdate) and the values are updated in place,
+    /// hence the compressed storage (outer and inner indices) of the returned matrix can be used to reuse a symbolic factorisation.
+    const Eigen::SparseMatrix<double>& GetEqualityJacobianStructured();
+
+    /// \brief Returns the sparse Jacobian of the inequality constraints with a persistent sparsity pattern, see GetEqualityJacobianStructured.
+    const Eigen::SparseMatrix<double>& GetInequalityJacobianStructured();
+
+    /// \brief Returns the blocks of the block-tridiagonal Hessian of GetCost() w.r.t. the trajectory: diagonal[t - 1] is the second derivative
+    /// w.r.t. x_t (t = 1, ..., T - 1) and off_diagonal[t - 1] the second derivative w.r.t. x_{t+1} and x_t (t = 1, ..., T - 2).
+    /// The task terms use the Hessians of the task maps if DerivativeOrder is 2, and the Gauss-Newton approximation otherwise.
+    void GetCostHessianBlocks(std::vector<Eigen::MatrixXd>& diagonal, std::vector<Eigen::MatrixXd>& off_diagonal) const;
+
+    /// \brief Returns the product of the Hessian of GetCost() (see GetCostHessianBlocks) with v (of size N * (T - 1)) without forming the Hessian,
+    /// e.g., for conjugate gradient or truncated Newton steps. Costs O(T * length_jacobian * N), plus the task map Hessians if DerivativeOrder is 2.
+    Eigen::VectorXd GetCostHessianVectorProduct(Eigen::VectorXdRefConst v) const;
+
+    /// \brief Writes the product of the Hessian of GetCost() with v into hv (of size N * (T - 1)), see GetCostHessianVectorProduct.
+    void GetCostHessianVectorProduct(Eigen::VectorXdRefConst v, Eigen::Ref<Eigen::VectorXd> hv) const;
+
+    /// \brief Returns the Hessian of GetCost() as a sparse matrix with a fixed block-tridiagonal sparsity pattern (only rebuilt when T changes),
+    /// where the values are updated in place, see GetEqualityJacobianStructured.
+    const Eigen::SparseMatrix<double>& GetCostHessianStructured();
+
     /// \brief Returns the dimension of the active equality constraints.
     int get_active_nonlinear_equality_constraints_dimension() const;
 
@@ -241,6 +314,20 @@ public:
 protected:
     virtual void ReinitializeVariables();
 
+    /// \brief Updates the scene for time step t, unless the kinematics of the whole trajectory were already computed by Update(x_trajectory_in).
+    void UpdateScene(Eigen::VectorXdRefConst x_in, int t);
+
+    /// \brief Evaluates the used task maps of time step t into Phi[t], jacobian[t] and hessian[t].
+    /// \param maps    The task maps of this problem or their clones of a trajectory workspace.
+    void UpdateTaskMaps(const TaskMapVec& maps, int t);
+
+    /// \brief Evaluates the used task maps that only depend on the state of each time step (see TaskMap::HasTrajectoryUpdate)
+    /// for all given time steps at once. UpdateTaskMaps then skips them until trajectory_task_maps_updated_ is reset.
+    void UpdateTrajectoryTaskMaps(const std::vector<int>& time_steps);
+
+    /// \brief Updates the time-indexed tasks (cost and constraints) of time step t from Phi[t], jacobian[t] and hessian[t].
+    virtual void UpdateTimeIndexedTasks(int t);
+
     /// \brief Checks the desired time index for bounds and supports -1 indexing.
     inline void ValidateTimeIndex(int& t_in) const
     {
@@ -268,9 +355,53 @@ protected:
 
     std::vector<Eigen::VectorXd> initial_trajectory_;
     std::vector<std::shared_ptr<KinematicResponse>> kinematic_solutions_;
+    bool trajectory_kinematics_updated_ = false;  //!< Whether the kinematics of all time steps have been computed in one pass (see Update(x_trajectory_in))
+    bool trajectory_task_maps_updated_ = false;   //!< Whether the task maps with a trajectory update have been evaluated for all time steps (see UpdateTrajectoryTaskMaps)
 
     double ct;  //!< Normalisation of scalar cost and Jacobian over trajectory length
 
+    /// \brief Clone of the scene and the task maps on which a block of time steps of Update(x_trajectory_in) is evaluated in parallel.
+    struct TrajectoryWorkspace
+    {
+        ScenePtr scene;
+        TaskMapVec maps;  ///< Clones of tasks_, in the same order
+    };
+
+    /// \brief Whether the time steps of Update(x_trajectory_in) can be evaluated on the trajectory workspaces.
+    bool CanUpdateTrajectoryInParallel() const;
+    void UpdateTrajectoryWorkspaces(int num_workspaces);
+    /// \brief Calls PreUpdate of the task map clones of the trajectory workspaces, to be called by PreUpdate.
+    void PreUpdateTrajectoryWorkspaces();
+
+    /// \brief Whether time step t has been evaluated for its current state and previous state.
+    bool IsTimeStepEvaluated(int t) const;
+    void MarkTimeStepEvaluated(int t);
+
+    /// \brief Sparse matrix with a persistent sparsity pattern. The values are written in place, in the order in which the entries of the pattern were added.
+    struct StructuredSparseMatrix
+    {
+        void SetPattern(int rows, int cols, const std::vector<Eigen::Triplet<double>>& entries);
+
+        Eigen::SparseMatrix<double> matrix;
+        std::vector<int> value_index;                  ///< Index into the compressed values of each entry of the pattern
+        std::vector<std::pair<int, int>> constraints;  ///< Active constraints the pattern was created for
+    };
+    StructuredSparseMatrix equality_jacobian_structured_;
+    StructuredSparseMatrix inequality_jacobian_structured_;
+    StructuredSparseMatrix cost_hessian_structured_;
+    void UpdateConstraintJacobianStructured(const TimeIndexedTask& task, const std::vector<std::pair<int, int>>& active_constraints, int dimension, StructuredSparseMatrix& jacobian) const;
+
+    bool skip_unchanged_time_steps_ = false;
+    int number_of_recomputed_time_steps_ = 0;
+    int evaluated_world_version_ = -1;                   ///< World version of the scene the evaluated time steps are valid for
+    std::vector<char> time_step_evaluated_;              ///< Whether the time step has been evaluated since the last InvalidateTimeSteps
+    std::vector<Eigen::VectorXd> evaluated_x_;           ///< State of each time step when it was last evaluated
+    std::vector<Eigen::VectorXd> evaluated_x_previous_;  ///< State of the previous time step when the time step was last evaluated
+
+    int trajectory_num_threads_ = 1;
+    int trajectory_workspaces_version_ = -1;  ///< World version of the scene the clones were created from
+    std::vector<TrajectoryWorkspace> trajectory_workspaces_;
+
     Eigen::VectorXd q_dot_max_;  //!< Joint velocity limit (rad/s)
     Eigen::VectorXd xdiff_max_;  //!< Maximum change in the variables in a single timestep tau_. Gets set/updated via SetJointVelocityLimits or ReinitializeVariables.
 
@@ -280,6 +411,16 @@ protected:
     int active_nonlinear_equality_constraints_dimension_ = 0;
     int active_nonlinear_inequality_constraints_dimension_ = 0;
 
+    /// \brief Resolution, goals and weights SetResolution resamples from, T = 0 if the resolution has not been changed.
+    struct ResolutionReference
+    {
+        int T = 0;
+        double tau = 0.0;
+        std::vector<TaskSpaceVector> cost_y, inequality_y, equality_y;
+        std::vector<Eigen::VectorXd> cost_rho, inequality_rho, equality_rho;
+    };
+    ResolutionReference resolution_reference_;
+
     // Terms related with the joint velocity constraint - the Jacobian triplets are constant so can be cached.
     int joint_velocity_constraint_dimension_ = 0;
     std::vector<Eigen::Triplet<double>> joint_velocity_constraint_jacobian_triplets_;
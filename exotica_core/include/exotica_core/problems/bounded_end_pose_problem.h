@@ -52,12 +52,21 @@ public:
     Eigen::VectorXd GetGoal(const std::string& task_name);
     double GetRho(const std::string& task_name);
     void PreUpdate() override;
+    void UpdateClone(PlanningProblem& clone) const override;
+    bool SupportsCloning() const override { return true; }
+    double UpdateEndPoseCost(Eigen::VectorXdRefConst x) override;
+    Eigen::VectorXd GetCostGoal(const std::string& task_name) override { return GetGoal(task_name); }
+    void SetCostGoal(const std::string& task_name, Eigen::VectorXdRefConst goal) override { SetGoal(task_name, goal); }
     Eigen::MatrixXd GetBounds() const;
 
     bool IsValid() override;
 
     double GetScalarCost() const;
     Eigen::RowVectorXd GetScalarJacobian() const;
+
+    /// \brief Writes the Jacobian of the scalar cost into jacobian (of size N) without allocating.
+    void GetScalarJacobian(Eigen::Ref<Eigen::RowVectorXd> jacobian) const;
+
     double GetScalarTaskCost(const std::string& task_name) const;
 
     EndPoseTask cost;
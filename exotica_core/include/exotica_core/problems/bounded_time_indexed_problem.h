@@ -50,11 +50,6 @@ public:
     /// \brief Updates internal variables before solving, e.g., after setting new values for Rho.
     void PreUpdate() override;
 
-    /// \brief Updates an individual timestep from a given state vector
-    /// \param x_in     State
-    /// \param t        Timestep to update
-    void Update(Eigen::VectorXdRefConst x, int t) override;
-
     // Checks bound constraints
     bool IsValid() override;
 
@@ -88,6 +83,7 @@ public:
 
 private:
     void ReinitializeVariables() override;
+    void UpdateTimeIndexedTasks(int t) override;
 };
 typedef std::shared_ptr<exotica::BoundedTimeIndexedProblem> BoundedTimeIndexedProblemPtr;
 }  // namespace exotica
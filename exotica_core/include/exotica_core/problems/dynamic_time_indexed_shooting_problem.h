@@ -33,9 +33,12 @@
 #include <exotica_core/dynamics_solver.h>
 #include <exotica_core/planning_problem.h>
 #include <exotica_core/tasks.h>
+#include <exotica_core/tools/sparse_costs.h>
 
 #include <exotica_core/dynamic_time_indexed_shooting_problem_initializer.h>
 
+#include <functional>
+
 namespace exotica
 {
 enum ControlCostLossTermType
@@ -47,6 +50,18 @@ enum ControlCostLossTermType
     PseudoHuber = 3,
 };
 
+/// \brief Derivatives of the dynamics and of the cost along a trajectory, one block per time step (see
+/// DynamicTimeIndexedShootingProblem::LinearizeTrajectory). The running cost derivatives are not scaled by dt.
+struct TrajectoryLinearization
+{
+    std::vector<Eigen::MatrixXd> fx;   ///< Derivative of the state transition w.r.t. x (NDX,NDX), t < T-1
+    std::vector<Eigen::MatrixXd> fu;   ///< Derivative of the state transition w.r.t. u (NDX,NU), t < T-1
+    std::vector<Eigen::VectorXd> lx;   ///< Gradient of the state cost (NDX), t < T
+    std::vector<Eigen::MatrixXd> lxx;  ///< Hessian of the state cost (NDX,NDX), t < T
+    std::vector<Eigen::VectorXd> lu;   ///< Gradient of the control cost (NU), t < T-1
+    std::vector<Eigen::MatrixXd> luu;  ///< Hessian of the control cost (NU,NU), t < T-1
+};
+
 class DynamicTimeIndexedShootingProblem : public PlanningProblem, public Instantiable<DynamicTimeIndexedShootingProblemInitializer>
 {
 public:
@@ -61,18 +76,71 @@ public:
     void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRefConst u, int t);
     void UpdateTerminalState(Eigen::VectorXdRefConst x);  // Updates the terminal state and recomputes the terminal cost - this is required e.g. when considering defects in the dynamics
 
+    /// \brief Simulates the control trajectories U_rollouts[k] (num-controls x T-1) from the state x0 and returns the cost and the state trajectory
+    /// (num-states x T) of each rollout. The cost of a rollout is the cost minimised by the solvers, i.e., the sum of dt * (GetControlCost(t) + GetStateCost(t))
+    /// over t < T-1 and the terminal cost GetStateCost(T-1), evaluated along the rollout. The rollouts are simulated in parallel (see SetRolloutNumThreads)
+    /// and do not change the state, controls or costs of the problem. With stochastic updates, rollout k is perturbed by the noise of its own stream
+    /// (see SampleNoise; all rollouts share the noise drawn in PreUpdate with CommonRandomNumbers), i.e., the result does not depend on the number
+    /// of threads. Task maps using the kinematics of previous time steps are not supported.
+    void Rollout(Eigen::VectorXdRefConst x0, const std::vector<Eigen::MatrixXd>& U_rollouts, Eigen::VectorXd& costs, std::vector<Eigen::MatrixXd>& X_rollouts);
+
+    /// \brief Control policy of a closed-loop rollout: writes the control u of rollout k at time step t for the state x. Called concurrently
+    /// from the threads of Rollout, i.e., it has to be thread-safe: dynamics_solver is the one of the calling thread.
+    typedef std::function<void(int k, int t, DynamicsSolver& dynamics_solver, Eigen::VectorXdRefConst x, Eigen::VectorXdRef u)> RolloutPolicy;
+
+    /// \brief Simulates num_rollouts closed-loop rollouts from the state x0 with the controls of policy, e.g., the feedback policies of the
+    /// line-search steps of DDP. Returns the cost and the state trajectory of each rollout as the open-loop Rollout.
+    void Rollout(Eigen::VectorXdRefConst x0, int num_rollouts, const RolloutPolicy& policy, Eigen::VectorXd& costs, std::vector<Eigen::MatrixXd>& X_rollouts);
+
+    /// \brief Shooting policy of a multiple-shooting rollout: writes the shooting node x and the control u of time step t of segment j given the
+    /// state x_sim simulated from the node of the previous time step (the start state of the segment at its first time step); u is not used
+    /// at t = T-1. Called concurrently from the threads of RolloutMultipleShooting, i.e., it has to be thread-safe: dynamics_solver is the one
+    /// of the calling thread and the segments are simulated by one thread each.
+    typedef std::function<void(int j, int t, DynamicsSolver& dynamics_solver, const Eigen::VectorXd& x_sim, Eigen::VectorXdRef x, Eigen::VectorXdRef u)> ShootingPolicy;
+
+    /// \brief Multiple-shooting rollout: simulates the segments of the horizon starting at the time steps segment_begin (increasing, the first
+    /// one 0) in parallel (see SetRolloutNumThreads), segment j from the state x_begin[j]. Returns the shooting nodes X (num-states x T), the
+    /// controls U (num-controls x T-1), the states X_sim (num-states x T) simulated from the nodes of the previous time steps (X_sim(0) = x_begin[0])
+    /// and the cost of the nodes and controls as in Rollout. The gaps of the multiple-shooting trajectory are the differences between X_sim and X.
+    void RolloutMultipleShooting(const std::vector<int>& segment_begin, const std::vector<Eigen::VectorXd>& x_begin, const ShootingPolicy& policy, Eigen::MatrixXd& X, Eigen::MatrixXd& U, Eigen::MatrixXd& X_sim, double& cost);
+
+    /// \brief Sets the number of threads simulating the rollouts of Rollout in parallel, each on its own clone of the scene (with its own dynamics solver)
+    /// and the task maps (1: serial, 0: all hardware threads).
+    void SetRolloutNumThreads(int num_threads);
+
+    /// \brief Returns the number of threads simulating the rollouts of Rollout.
+    int GetRolloutNumThreads() const { return rollout_num_threads_; }
+
+    /// \brief Shifts the state and control trajectories by k time steps for a receding-horizon re-solve (warm start): time step t takes the
+    /// state, control, task-map values and kinematic response of time step t + k, the last control is held for the last k controls and the
+    /// tail of the state trajectory is simulated from it. The storage is reused, i.e., no variables are reinitialised. The goals (X_star, task
+    /// goals and Rho) stay indexed by the time step of the horizon; with ContractTaskHessians, the contracted task-map Hessians of the shifted
+    /// time steps are kept as they are. The first state is shifted as well, i.e., X(0) becomes the old X(k), whereas the start state is not
+    /// changed: set it to the measured state with SetStartState before re-solving.
+    /// \param k    Number of time steps to shift by, 0 < k < T-1.
+    void ShiftTrajectory(int k);
+
     const int& get_T() const;     ///< Returns the number of timesteps in the state trajectory.
     void set_T(const int& T_in);  ///< Sets the number of timesteps in the state trajectory.
 
     const double& get_tau() const;  ///< Returns the discretization timestep tau
 
+    /// \brief Changes the number of time steps to T_in while keeping the duration (T-1)*tau of the trajectory, e.g., to solve coarse-to-fine
+    /// (see MultiresolutionLevels of the DDP solvers). tau and the dt of the dynamics solver are scaled by the same factor. The goal states,
+    /// Q and the goals and weights of the costs of each time step are those of the nearest time step of the resolution before the first call,
+    /// which is restored exactly when it is set again. The state trajectory is interpolated linearly, each control is held from the nearest
+    /// control at the middle of its time step.
+    void SetResolution(int T_in);
+
     const Eigen::MatrixXd& get_X() const;      ///< Returns the state trajectory X
     Eigen::VectorXd get_X(int t) const;        ///< Returns the state at time t
     void set_X(Eigen::MatrixXdRefConst X_in);  ///< Sets the state trajectory X (can be used as the initial guess)
+    Eigen::Ref<Eigen::MatrixXd> get_X_view();  ///< Returns a writable view of X for in-place edits (quaternions are not re-normalised)
 
     const Eigen::MatrixXd& get_U() const;      ///< Returns the control trajectory U
     Eigen::VectorXd get_U(int t) const;        ///< Returns the control state at time t
     void set_U(Eigen::MatrixXdRefConst U_in);  ///< Sets the control trajectory U (can be used as the initial guess)
+    Eigen::Ref<Eigen::MatrixXd> get_U_view();  ///< Returns a writable view of U for in-place edits
 
     const Eigen::MatrixXd& get_X_star() const;           ///< Returns the target state trajectory X
     void set_X_star(Eigen::MatrixXdRefConst X_star_in);  ///< Sets the target state trajectory X
@@ -91,20 +159,31 @@ public:
     void EnableStochasticUpdates();
     void DisableStochasticUpdates();
 
+    /// \brief Seeds the stochastic noise and restarts its streams. Update draws the noise of a new stream whenever it simulates time step 0
+    /// (only in PreUpdate with CommonRandomNumbers), rollout k of Rollout the noise of the k-th following stream.
+    void SetNoiseSeed(std::uint64_t seed);
+
+    /// \brief Fills noise (2 * num-states x T-1) with the standard normal noise of a stream for the whole horizon: column t holds the
+    /// control-dependent noise (first num-states rows) and the white noise (last num-states rows) of time step t. The noise only depends on
+    /// the seed and the stream, i.e., it is reproducible and any thread can generate any stream.
+    void SampleNoise(std::uint64_t stream, Eigen::MatrixXdRef noise) const;
+
     // TODO: Make private and add getter (no need to be public!)
     TimeIndexedTask cost;                  ///< Cost task
     std::vector<TaskSpaceVector> Phi;      ///< Stacked TaskMap vector
     std::vector<Eigen::MatrixXd> dPhi_dx;  ///< Stacked TaskMap Jacobian w.r.t. state
     std::vector<Eigen::MatrixXd> dPhi_du;  ///< Stacked TaskMap Jacobian w.r.t. control
-    std::vector<Hessian> ddPhi_ddx;        ///< Stacked TaskMap Hessian w.r.t. state
-    std::vector<Hessian> ddPhi_ddu;        ///< Stacked TaskMap Hessian w.r.t. control
-    std::vector<Hessian> ddPhi_dxdu;       ///< Stacked TaskMap Hessian w.r.t. state and control
+    std::vector<Hessian> ddPhi_ddx;        ///< Stacked TaskMap Hessian w.r.t. state (empty if ContractTaskHessians is set)
+    std::vector<Hessian> ddPhi_ddu;        ///< Stacked TaskMap Hessian w.r.t. control (empty if ContractTaskHessians is set)
+    std::vector<Hessian> ddPhi_dxdu;       ///< Stacked TaskMap Hessian w.r.t. state and control (empty if ContractTaskHessians is set)
 
     // TODO: Make private and add getter/setter
     int length_Phi;       ///< Length of TaskSpaceVector (Phi => stacked task-maps)
     int length_jacobian;  ///< Length of tangent vector to Phi
     int num_tasks;        ///< Number of TaskMaps
 
+    /// \brief Unscaled state cost of time step t, consistent with GetStateCostJacobian and GetStateCostHessian.
+    /// The callers apply the time scaling: running costs are multiplied by dt, the terminal cost is not scaled.
     double GetStateCost(int t) const;
     double GetControlCost(int t) const;
 
@@ -112,6 +191,27 @@ public:
     Eigen::VectorXd GetControlCostJacobian(int t);  ///< lu
     Eigen::MatrixXd GetStateCostHessian(int t);     ///< lxx
     Eigen::MatrixXd GetControlCostHessian(int t);   ///< luu
+
+    /// \brief Returns lxx * v without forming lxx, i.e. from the task Jacobians (and the task map Hessians if DerivativeOrder is 2).
+    Eigen::VectorXd GetStateCostHessianVectorProduct(int t, Eigen::VectorXdRefConst v);
+
+    /// \brief Returns luu * v without forming luu.
+    Eigen::VectorXd GetControlCostHessianVectorProduct(int t, Eigen::VectorXdRefConst v);
+
+    /// \brief Writes lu and luu of time step t into jacobian and hessian, evaluating the derivatives of the sparsity loss in one pass.
+    void GetControlCostDerivatives(int t, Eigen::VectorXd& jacobian, Eigen::MatrixXd& hessian);
+
+    /// \brief Linearises the dynamics about the states X (num-states x T) and controls U (num-controls x T-1) and quadratises the cost
+    /// about the trajectory of the last Update, i.e., LinearizeDynamics followed by QuadratizeCost. The storage of linearization is reused.
+    void LinearizeTrajectory(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, TrajectoryLinearization& linearization);
+
+    /// \brief Writes the state transition derivatives fx, fu about X and U into linearization with the batched ComputeDerivativesBatch
+    /// of the dynamics solver.
+    void LinearizeDynamics(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, TrajectoryLinearization& linearization);
+
+    /// \brief Writes the cost derivatives lx, lxx, lu, luu of all time steps into linearization. The state cost derivatives are
+    /// evaluated in parallel over t with the derivative threads of the dynamics solver (see DynamicsSolver::SetDerivativesNumThreads).
+    void QuadratizeCost(TrajectoryLinearization& linearization);
     Eigen::MatrixXd GetStateControlCostHessian()
     {
         // NOTE: For quadratic costs this is always 0
@@ -163,7 +263,7 @@ public:
     }
 
     const ControlCostLossTermType& get_loss_type() const { return loss_type_; }
-    void set_loss_type(const ControlCostLossTermType& loss_type_in) { loss_type_ = loss_type_in; }
+    void set_loss_type(const ControlCostLossTermType& loss_type_in);
     double get_control_cost_weight() const { return control_cost_weight_; }
     void set_control_cost_weight(const double control_cost_weight_in) { control_cost_weight_ = control_cost_weight_in; }
 
@@ -184,8 +284,55 @@ protected:
 
     void UpdateTaskMaps(Eigen::VectorXdRefConst x, Eigen::VectorXdRefConst u, int t);
 
+    /// \brief State cost of time step t for the state difference x_diff and the general costs general_cost evaluated at the state.
+    /// Unscaled as GetStateCost, the rollouts multiply the running costs by dt.
+    double ComputeStateCost(Eigen::VectorXdRefConst x_diff, const TimeIndexedTask& general_cost, int t) const;
+    /// \brief Control cost of time step t for the control u.
+    double ComputeControlCost(Eigen::VectorXdRefConst u) const;
+    /// \brief Weighted rows and non-zero columns of the task Jacobian of one time step (SparseCostHessian), with storage for the compact blocks.
+    struct SparseCostHessianPattern
+    {
+        bool valid = false;
+        std::vector<int> rows;      ///< Rows of J with a non-zero weight
+        std::vector<int> cols;      ///< Columns of J with a non-zero entry in rows at the time the pattern was built
+        Eigen::MatrixXd J_active;   ///< J(rows, cols), in the top-left corner
+        Eigen::MatrixXd SJ_active;  ///< S(rows, rows) J(rows, cols), in the top-left corner
+        Eigen::MatrixXd H_active;   ///< J(rows, cols)^T S(rows, rows) J(rows, cols), in the top-left corner
+    };
+    /// \brief Computes H = J^T S J for the diagonal weights S from the weighted rows and the non-zero columns of J only (SparseCostHessian).
+    /// The pattern is kept while the weights do not change and J has no non-zero entry in the weighted rows outside of its columns.
+    static void SparseGaussNewtonHessian(const Eigen::MatrixXd& J, const Eigen::MatrixXd& S, SparseCostHessianPattern& pattern, Eigen::MatrixXd& H);
+
+    /// \brief Clone of the scene and the task maps simulating the rollouts of one thread.
+    struct RolloutWorkspace
+    {
+        ScenePtr scene;        ///< Owns its own dynamics solver
+        TaskMapVec maps;       ///< Clones of tasks_, in the same order
+        TimeIndexedTask cost;  ///< Copy of cost evaluating the general costs on the task maps of the clone
+        TaskSpaceVector Phi;
+    };
+    /// \brief Creates or updates the rollout workspaces to match the scene, the dynamics solver and the costs of this problem.
+    void UpdateRolloutWorkspaces(int num_workspaces);
+    /// \brief Updates the task maps and general costs of a rollout workspace for the state x and control u at time step t.
+    void UpdateRolloutTaskMaps(RolloutWorkspace& workspace, Eigen::VectorXdRefConst x, Eigen::VectorXdRefConst u, int t);
+    /// \brief Adds the stochastic noise of the standard normal samples noise (see SampleNoise) for the control u to the state x.
+    void AddNoise(Eigen::VectorXdRef x, Eigen::VectorXdRefConst u, Eigen::VectorXdRefConst noise) const;
+
     int T_;       ///< Number of time steps
     double tau_;  ///< Time step duration
+
+    /// \brief Resolution and goals SetResolution resamples from, T = 0 if the resolution has not been changed.
+    struct ResolutionReference
+    {
+        int T = 0;
+        double tau = 0.0;
+        double dt = 0.0;
+        Eigen::MatrixXd X_star;
+        std::vector<Eigen::MatrixXd> Q;
+        std::vector<TaskSpaceVector> cost_y;
+        std::vector<Eigen::VectorXd> cost_rho;
+    };
+    ResolutionReference resolution_reference_;
     bool stochastic_matrices_specified_ = false;
     bool stochastic_updates_enabled_ = false;
 
@@ -210,15 +357,27 @@ protected:
     std::vector<Eigen::VectorXd> control_cost_jacobian_;
     std::vector<Eigen::MatrixXd> control_cost_hessian_;
 
+    // Used instead of ddPhi_ddx, ddPhi_ddu and ddPhi_dxdu if ContractTaskHessians is set
+    Hessian ddPhi_ddx_buffer_;                        ///< Task-map Hessians w.r.t. state of the time step being updated
+    Hessian ddPhi_ddu_buffer_;                        ///< Task-map Hessians w.r.t. control of the time step being updated
+    Hessian ddPhi_dxdu_buffer_;                       ///< Task-map Hessians w.r.t. state and control of the time step being updated
+    std::vector<Eigen::MatrixXd> task_cost_hessian_;  ///< Contracted task-map Hessians of the general costs, sum_i S_ii * ydiff_i * ddPhi_ddx_i, per time step
+    std::vector<SparseCostHessianPattern> sparse_cost_hessian_patterns_;  ///< Per time step, used if SparseCostHessian is set
+
     std::vector<std::shared_ptr<KinematicResponse>> kinematic_solutions_;
 
-    std::mt19937 generator_;
-    std::normal_distribution<double> standard_normal_noise_{0, 1};
+    std::uint64_t noise_seed_ = 0;    ///< Seed of the stochastic noise
+    std::uint64_t noise_stream_ = 0;  ///< Next stream of the stochastic noise
+    Eigen::MatrixXd noise_;           ///< Standard normal noise of the current stream (2 * num-states x T-1)
 
     TaskSpaceVector cost_Phi;
 
     double control_cost_weight_ = 1;
     ControlCostLossTermType loss_type_;
+    VectorLossFunction control_loss_ = &L2Loss::Evaluate;   ///< Sparsity loss of the controls, selected by set_loss_type
+    const Eigen::VectorXd* control_loss_rate_ = &l1_rate_;  ///< Rates of control_loss_
+    Eigen::VectorXd control_loss_gradient_;
+    Eigen::VectorXd control_loss_hessian_;
     void InstantiateCostTerms(const DynamicTimeIndexedShootingProblemInitializer& init);
 
     // sparsity costs
@@ -227,6 +386,10 @@ protected:
     Eigen::VectorXd bimodal_huber_mode1_, bimodal_huber_mode2_;
 
     Eigen::VectorXd smooth_l1_mean_, smooth_l1_std_;
+
+    int rollout_num_threads_ = 1;
+    int rollout_workspaces_version_ = -1;  ///< World version of the scene the clones were created from
+    std::vector<RolloutWorkspace> rollout_workspaces_;
 };
 typedef std::shared_ptr<exotica::DynamicTimeIndexedShootingProblem> DynamicTimeIndexedShootingProblemPtr;
 }  // namespace exotica
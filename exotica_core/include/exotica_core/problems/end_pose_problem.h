@@ -61,10 +61,19 @@ public:
     Eigen::VectorXd GetGoalNEQ(const std::string& task_name);
     double GetRhoNEQ(const std::string& task_name);
     void PreUpdate() override;
+    void UpdateClone(PlanningProblem& clone) const override;
+    bool SupportsCloning() const override { return true; }
+    double UpdateEndPoseCost(Eigen::VectorXdRefConst x) override;
+    Eigen::VectorXd GetCostGoal(const std::string& task_name) override { return GetGoal(task_name); }
+    void SetCostGoal(const std::string& task_name, Eigen::VectorXdRefConst goal) override { SetGoal(task_name, goal); }
     Eigen::MatrixXd GetBounds() const;
 
     double GetScalarCost();
     Eigen::RowVectorXd GetScalarJacobian();
+
+    /// \brief Writes the Jacobian of the scalar cost into jacobian (of size N) without allocating.
+    void GetScalarJacobian(Eigen::Ref<Eigen::RowVectorXd> jacobian);
+
     double GetScalarTaskCost(const std::string& task_name) const;
     Eigen::VectorXd GetEquality();
     Eigen::MatrixXd GetEqualityJacobian();
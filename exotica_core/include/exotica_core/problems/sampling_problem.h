@@ -47,9 +47,37 @@ public:
 
     void Update(Eigen::VectorXdRefConst x);
     bool IsStateValid(Eigen::VectorXdRefConst x);
+
+    /// \brief Checks a batch of states (one per row), see IsStateValid.
+    /// With ValidityNumThreads > 1, the states are split across threads, each checking its states on its own clone of the scene and the task maps.
+    /// The clones are created from the initializers of the task maps and recreated when the world changes. They do not change the state of this
+    /// problem or its scene. Otherwise, the states are checked in turn on this problem.
+    /// \param stop_at_first_invalid Whether to stop at the first invalid state. The states after it are reported as invalid.
+    /// \return Validity of each state.
+    std::vector<bool> AreStatesValid(Eigen::MatrixXdRefConst states, bool stop_at_first_invalid = true);
     bool IsValid() override;
     void PreUpdate() override;
 
+    /// \brief Sets the number of threads checking the states of AreStatesValid in parallel (1: serial, 0: all hardware threads).
+    void SetValidityNumThreads(int num_threads);
+
+    /// \brief Returns the number of threads checking the states of AreStatesValid.
+    int GetValidityNumThreads() const { return validity_num_threads_; }
+
+    /// \brief Creates (or refreshes) num_workspaces clones of the scene and the task maps for IsStateValid(x, workspace), see AreStatesValid.
+    /// Not thread-safe: has to be called before the workspaces are used concurrently, e.g., before planning with several threads.
+    void PrepareValidityWorkspaces(int num_workspaces);
+
+    /// \brief Returns the number of workspaces prepared by PrepareValidityWorkspaces (or AreStatesValid).
+    int GetNumberOfValidityWorkspaces() const { return static_cast<int>(validity_workspaces_.size()); }
+
+    /// \brief Checks the state x on the clone workspace (0 <= workspace < GetNumberOfValidityWorkspaces()) without changing this problem or its scene.
+    /// Calls with distinct workspaces are thread-safe.
+    bool IsStateValid(Eigen::VectorXdRefConst x, int workspace);
+
+    /// \brief Returns the scene of the clone workspace, e.g., to read the kinematics of its last check.
+    ScenePtr GetValidityWorkspaceScene(int workspace) const;
+
     int GetSpaceDim();
 
     void SetGoalEQ(const std::string& task_name, Eigen::VectorXdRefConst goal);
@@ -76,8 +104,29 @@ public:
     int num_tasks;
 
 private:
+    /// \brief Checks the bounds of the state x and the constraints evaluated into inequality and equality.
+    bool IsValid(Eigen::VectorXdRefConst x, const SamplingTask& inequality, const SamplingTask& equality) const;
+
+    /// \brief Clone of the scene and the task maps on which a block of states of AreStatesValid is checked in parallel.
+    struct ValidityWorkspace
+    {
+        ScenePtr scene;
+        TaskMapVec maps;  ///< Clones of tasks_, in the same order
+        TaskSpaceVector Phi;
+        SamplingTask inequality;  ///< Copy of inequality evaluated on Phi of the clone
+        SamplingTask equality;    ///< Copy of equality evaluated on Phi of the clone
+    };
+    void UpdateValidityWorkspaces(int num_workspaces);
+
+    /// \brief Checks the state x on the clone of workspace.
+    bool IsStateValid(Eigen::VectorXdRefConst x, ValidityWorkspace& workspace) const;
+
     Eigen::VectorXd goal_;
     bool compound_;
+
+    int validity_num_threads_ = 1;
+    int validity_workspaces_version_ = -1;  ///< World version of the scene the clones were created from
+    std::vector<ValidityWorkspace> validity_workspaces_;
 };
 
 typedef std::shared_ptr<exotica::SamplingProblem> SamplingProblemPtr;
@@ -30,6 +30,11 @@
 #ifndef EXOTICA_CORE_TIME_INDEXED_SAMPLING_PROBLEM_H_
 #define EXOTICA_CORE_TIME_INDEXED_SAMPLING_PROBLEM_H_
 
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 #include <exotica_core/planning_problem.h>
 #include <exotica_core/tasks.h>
 
@@ -47,9 +52,33 @@ public:
 
     void Update(Eigen::VectorXdRefConst x, const double& t);
     using PlanningProblem::IsValid;
+
+    /// \brief Checks the state x at time t. With ValidityCacheSize > 0, the results are cached for the quantised (x, t):
+    /// on a cache hit, neither the scene nor Phi are updated. The cache is invalidated when the world of the scene, the goals
+    /// or the constraints change; joint states changed directly in the scene require ClearValidityCache.
     bool IsValid(Eigen::VectorXdRefConst x, const double& t);  // Not overriding on purpose
     void PreUpdate() override;
 
+    /// \brief Creates (or refreshes) num_workspaces clones of the scene and the task maps for IsValid(x, t, workspace).
+    /// Not thread-safe: has to be called before the workspaces are used concurrently, e.g., before planning with several threads.
+    void PrepareValidityWorkspaces(int num_workspaces);
+
+    /// \brief Returns the number of workspaces prepared by PrepareValidityWorkspaces.
+    int GetNumberOfValidityWorkspaces() const { return static_cast<int>(validity_workspaces_.size()); }
+
+    /// \brief Checks the state x at time t on the clone workspace (0 <= workspace < GetNumberOfValidityWorkspaces()) without changing
+    /// this problem or its scene. Calls with distinct workspaces are thread-safe.
+    bool IsValid(Eigen::VectorXdRefConst x, const double& t, int workspace);
+
+    /// \brief Clears the validity cache and resets its counters.
+    void ClearValidityCache();
+
+    /// \brief Returns the number of IsValid queries answered from the validity cache.
+    std::size_t GetValidityCacheHits() const;
+
+    /// \brief Returns the number of IsValid queries not found in the validity cache.
+    std::size_t GetValidityCacheMisses() const;
+
     int GetSpaceDim();
 
     void SetGoalEQ(const std::string& task_name, Eigen::VectorXdRefConst goal);
@@ -82,8 +111,47 @@ public:
     int num_tasks;
 
 private:
+    /// \brief Checks the constraints evaluated into inequality and equality.
+    bool IsValid(const SamplingTask& inequality, const SamplingTask& equality) const;
+
+    struct ValidityCacheKeyHash
+    {
+        std::size_t operator()(const std::vector<std::int64_t>& key) const;
+    };
+
+    /// \brief Quantises (x, t) into key and looks up its validity, returns whether it was found.
+    /// The key stays empty if the cache is disabled. Thread-safe.
+    bool LookUpValidity(Eigen::VectorXdRefConst x, const double& t, std::vector<std::int64_t>& key, bool& valid);
+
+    /// \brief Caches the validity of key, evicting the least recently used results beyond ValidityCacheSize. Thread-safe.
+    void StoreValidity(std::vector<std::int64_t>&& key, bool valid);
+
+    /// \brief Removes all cached results, keeping the counters.
+    void InvalidateValidityCache();
+
+    /// \brief Clone of the scene and the task maps on which states are checked concurrently, see PrepareValidityWorkspaces.
+    struct ValidityWorkspace
+    {
+        ScenePtr scene;
+        TaskMapVec maps;  ///< Clones of tasks_, in the same order
+        TaskSpaceVector Phi;
+        SamplingTask inequality;  ///< Copy of inequality evaluated on Phi of the clone
+        SamplingTask equality;    ///< Copy of equality evaluated on Phi of the clone
+    };
+
     double t_goal_;         ///< Goal time: The time at which goal_ should be reached and the upper bound for the time-dimension
     Eigen::VectorXd goal_;  ///< Goal state to reach (spatial) at temporal goal (t_goal_)
+
+    int validity_workspaces_version_ = -1;  ///< World version of the scene the clones were created from
+    std::vector<ValidityWorkspace> validity_workspaces_;
+
+    typedef std::list<std::pair<std::vector<std::int64_t>, bool>> ValidityCache;
+    mutable std::mutex validity_cache_mutex_;                                                                            ///< Guards the cache and its counters
+    ValidityCache validity_cache_;                                                                                       ///< Quantised (x, t) and validity, most recently used first
+    std::unordered_map<std::vector<std::int64_t>, ValidityCache::iterator, ValidityCacheKeyHash> validity_cache_index_;  ///< Entries of validity_cache_ by key
+    int validity_cache_world_version_ = -1;                                                                              ///< World version the cached results were computed in
+    std::size_t validity_cache_hits_ = 0;
+    std::size_t validity_cache_misses_ = 0;
 };
 
 typedef std::shared_ptr<exotica::TimeIndexedSamplingProblem> TimeIndexedSamplingProblemPtr;
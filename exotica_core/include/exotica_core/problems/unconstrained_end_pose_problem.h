@@ -46,6 +46,17 @@ public:
     void Instantiate(const UnconstrainedEndPoseProblemInitializer& init) override;
     void Update(Eigen::VectorXdRefConst x);
 
+    /// \brief Updates the task maps and the cost at x without computing their Jacobians and Hessians, e.g., for quasi-Newton solvers.
+    /// jacobian, hessian and the derivatives of cost keep the values of the last call to Update.
+    void UpdateCost(Eigen::VectorXdRefConst x);
+
+    /// \brief Fused update for Gauss-Newton type solvers: updates the task maps at x and accumulates the normal equations of the weighted residual S * ydiff,
+    /// JT_times_J = J^T * S^2 * J (N x N) and JT_times_yd = J^T * S^2 * ydiff (of size N), without copying the task Jacobians into cost (see EndPoseTask::UpdateFused).
+    /// Phi, jacobian, cost.Phi and cost.ydiff are updated, hence GetScalarCost and GetTaskError are valid afterwards.
+    /// cost.jacobian and hessian keep the values of the last call to Update, as does GetScalarJacobian, which reads cost.jacobian.
+    /// \return The scalar cost, as GetScalarCost.
+    double UpdateFused(Eigen::VectorXdRefConst x, Eigen::VectorXdRef JT_times_yd, Eigen::MatrixXdRef JT_times_J);
+
     bool IsValid() override { return true; }
     void SetGoal(const std::string& task_name, Eigen::VectorXdRefConst goal);
     void SetRho(const std::string& task_name, const double& rho);
@@ -54,11 +65,19 @@ public:
     Eigen::VectorXd GetNominalPose() const;
     void SetNominalPose(Eigen::VectorXdRefConst qNominal_in);
     void PreUpdate() override;
+    void UpdateClone(PlanningProblem& clone) const override;
+    bool SupportsCloning() const override { return true; }
+    double UpdateEndPoseCost(Eigen::VectorXdRefConst x) override;
+    Eigen::VectorXd GetCostGoal(const std::string& task_name) override { return GetGoal(task_name); }
+    void SetCostGoal(const std::string& task_name, Eigen::VectorXdRefConst goal) override { SetGoal(task_name, goal); }
     int GetTaskId(const std::string& task_name) const;
 
     double GetScalarCost() const;
     Eigen::RowVectorXd GetScalarJacobian() const;
 
+    /// \brief Writes the Jacobian of the scalar cost into jacobian (of size N) without allocating.
+    void GetScalarJacobian(Eigen::Ref<Eigen::RowVectorXd> jacobian) const;
+
     /**
      * @brief GetScalarTaskCost get weighted sum-of-squares of cost vector
      * @param task_name valid task
@@ -77,6 +96,10 @@ public:
     int length_Phi;
     int length_jacobian;
     int num_tasks;
+
+private:
+    void Update(Eigen::VectorXdRefConst x, KinematicRequestFlags flags);
+    void UpdateTaskMaps(Eigen::VectorXdRefConst x, KinematicRequestFlags flags);
 };
 typedef std::shared_ptr<exotica::UnconstrainedEndPoseProblem> UnconstrainedEndPoseProblemPtr;
 }  // namespace exotica
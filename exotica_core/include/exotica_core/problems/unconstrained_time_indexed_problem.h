@@ -53,11 +53,6 @@ public:
     /// \brief Updates internal variables before solving, e.g., after setting new values for Rho.
     void PreUpdate() override;
 
-    /// \brief Updates an individual timestep from a given state vector
-    /// \param x_in     State
-    /// \param t        Timestep to update
-    void Update(Eigen::VectorXdRefConst x_in, int t) override;
-
     // As this is an unconstrained problem, it is always valid.
     bool IsValid() override;
 
@@ -94,6 +89,7 @@ public:
 
 private:
     void ReinitializeVariables() override;
+    void UpdateTimeIndexedTasks(int t) override;
 };
 typedef std::shared_ptr<exotica::UnconstrainedTimeIndexedProblem> UnconstrainedTimeIndexedProblemPtr;
 }  // namespace exotica
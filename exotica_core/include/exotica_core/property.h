@@ -45,6 +45,14 @@ class Property
 {
 public:
     boost::any Get() const;
+
+    /// \brief Returns a reference to the stored value without copying it. Throws boost::bad_any_cast if the value is not of type T.
+    template <typename T>
+    const T& GetValue() const
+    {
+        return boost::any_cast<const T&>(value_);
+    }
+
     template <typename C>
     void Set(const C val)
     {
@@ -79,6 +87,8 @@ public:
     boost::any GetProperty(const std::string& name) const;
     void SetProperty(const std::string& name, boost::any);
     bool HasProperty(const std::string& name) const;
+    /// \brief Returns the property or nullptr if it has not been added, i.e., HasProperty and properties_.at with a single lookup.
+    const Property* FindProperty(const std::string& name) const;
     std::vector<std::string> GetPropertyNames() const;
 
     std::map<std::string, Property> properties_;
@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_REMOTE_SOLVE_H_
+#define EXOTICA_CORE_REMOTE_SOLVE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+#include <zmq.hpp>
+
+#include <exotica_core/pipeline_pool.h>
+#include <exotica_core/property.h>
+#include <exotica_core/tools/iteration_telemetry.h>
+#include <exotica_core/tools/uncopyable.h>
+
+namespace exotica
+{
+/// \brief Query of a remote solve: the state of the problem that differs from its configuration.
+struct RemoteSolveRequest
+{
+    Eigen::VectorXd start_state;  ///< Start state, the one of the configuration if empty
+    double start_time = 0.0;
+    std::map<std::string, Eigen::VectorXd> task_goals;  ///< Goals of cost tasks by name (end-pose problems; last time step of time-indexed problems)
+    Eigen::VectorXd goal_state;                         ///< Goal state of sampling problems, unchanged if empty
+    Eigen::MatrixXd initial_trajectory;                 ///< Initial trajectory of time-indexed problems (one state per row), unchanged if empty
+};
+
+/// \brief Outcome of a remote solve.
+struct RemoteSolveResult
+{
+    bool success = false;  ///< Whether the solver returned, otherwise error holds the reason
+    std::string error;
+    Eigen::MatrixXd solution;
+    double planning_time = -1.0;
+    int termination_criterion = -1;           ///< TerminationCriterion of the problem
+    std::vector<IterationRecord> iterations;  ///< Iterations streamed while solving
+};
+
+/// \brief Identifies a solver and problem configuration, i.e. the pipelines of a RemoteSolveServer.
+std::uint64_t HashConfiguration(const Initializer& solver, const Initializer& problem);
+
+/// \brief Worker solving the requests of RemoteSolveClients on pre-instantiated pipelines (see PipelinePool).
+///
+/// The server binds a ZMQ router socket. Pipelines are kept per configuration: the ones added with AddConfiguration and the ones
+/// shipped by clients with their first request for it. Requests are solved concurrently, as many per configuration as there are
+/// pipelines, the others wait. While solving, the iteration records (see PlanningProblem::GetIterationTelemetry) are streamed to the
+/// client, followed by the solution. Only configurations whose initializers can be serialized are supported, e.g. the ones loaded
+/// from XML (see SerializeInitializers).
+class RemoteSolveServer : Uncopyable
+{
+public:
+    /// \param url Endpoint to bind, e.g. "tcp://*:6001"
+    /// \param pool_size Number of pipelines per configuration, 0 uses the number of hardware threads
+    RemoteSolveServer(const std::string& url, int pool_size = 0);
+    ~RemoteSolveServer();
+
+    /// \brief Instantiates the pipelines of a configuration ahead of the first request.
+    void AddConfiguration(const Initializer& solver, const Initializer& problem);
+
+    /// \brief Loads the configuration from an XML file (see XMLLoader::Load).
+    void AddConfiguration(const std::string& file_name);
+
+    /// \brief Serves requests until Stop is called.
+    void Run();
+
+    /// \brief Makes Run return once the running solves have been replied to. Thread-safe.
+    void Stop() { stop_ = true; }
+
+private:
+    struct Job;
+    struct Configuration
+    {
+        std::unique_ptr<PipelinePool> pool;                  ///< Null until the pipelines have been instantiated
+        std::future<std::unique_ptr<PipelinePool>> loading;  ///< Instantiation of the pipelines, off the serving loop
+        std::vector<std::shared_ptr<Job>> pending;           ///< Requests waiting for a pipeline, oldest first
+    };
+
+    void HandleRequest(const std::string& identity, const std::string& data);
+    Configuration& GetConfiguration(std::uint64_t hash, const std::string& initializers);
+    /// \brief Takes the pipelines of the configurations that finished loading, the pending requests of the ones that failed are rejected.
+    void FinishLoading();
+    void StartPendingJobs();
+    void SendReply(const std::string& identity, const std::string& data);
+
+    int pool_size_;
+    zmq::context_t context_;
+    zmq::socket_t socket_;
+    std::map<std::uint64_t, Configuration> configurations_;
+    std::vector<std::shared_ptr<Job>> running_;
+    std::atomic<bool> stop_{false};
+};
+
+/// \brief Ships requests for a configuration to RemoteSolveServers and waits for the solutions.
+///
+/// The client connects a ZMQ dealer socket to all the servers, which distributes the requests round-robin between them. The
+/// initializers of the configuration are only sent to servers that do not have its pipelines yet. Not thread-safe: concurrent
+/// requests are made with SolveBatch or one client per thread.
+class RemoteSolveClient : Uncopyable
+{
+public:
+    /// \param urls Endpoints of the servers, e.g. "tcp://worker1:6001"
+    /// \param timeout_ms Time without a message from the servers after which the missing results are given up
+    RemoteSolveClient(const std::vector<std::string>& urls, const Initializer& solver, const Initializer& problem, int timeout_ms = 60000);
+
+    /// \brief Loads the configuration from an XML file (see XMLLoader::Load).
+    RemoteSolveClient(const std::vector<std::string>& urls, const std::string& file_name, int timeout_ms = 60000);
+
+    /// \brief Solves the request on one of the servers.
+    /// @param on_iteration Called for every iteration record streamed by the server, on the calling thread
+    RemoteSolveResult Solve(const RemoteSolveRequest& request, const std::function<void(const IterationRecord&)>& on_iteration = nullptr);
+
+    /// \brief Solves the requests concurrently on the servers.
+    /// @param on_iteration Called with the index of the request for every iteration record streamed by the servers
+    std::vector<RemoteSolveResult> SolveBatch(const std::vector<RemoteSolveRequest>& requests, const std::function<void(int, const IterationRecord&)>& on_iteration = nullptr);
+
+    std::uint64_t GetConfigurationHash() const { return configuration_hash_; }
+
+private:
+    void Connect();
+    void Send(std::uint64_t id, const RemoteSolveRequest& request, bool with_initializers);
+
+    std::vector<std::string> urls_;
+    int timeout_ms_;
+    std::string initializers_;  ///< Serialized solver and problem initializers
+    std::uint64_t configuration_hash_;
+    std::uint64_t next_id_ = 0;
+    zmq::context_t context_;
+    std::unique_ptr<zmq::socket_t> socket_;
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_REMOTE_SOLVE_H_
@@ -30,10 +30,16 @@
 #ifndef EXOTICA_CORE_SCENE_H_
 #define EXOTICA_CORE_SCENE_H_
 
+#include <condition_variable>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 
 #include <geometric_shapes/shapes.h>
 #include <moveit/planning_scene/planning_scene.h>
@@ -44,6 +50,7 @@
 #include <exotica_core/object.h>
 #include <exotica_core/property.h>
 #include <exotica_core/tools/conversions.h>
+#include <exotica_core/tools/timer.h>
 #include <exotica_core/trajectory.h>
 
 #include <exotica_core/scene_initializer.h>
@@ -59,6 +66,17 @@ struct AttachedObject
     KDL::Frame pose;
 };
 
+/// \brief Parts of the scene with their own version counter, see Scene::GetVersion and Scene::AddChangeListener.
+enum SceneChange
+{
+    SCENE_CHANGE_STATE = 1,         ///< Joint state, i.e., every update
+    SCENE_CHANGE_WORLD = 2,         ///< World objects, custom links and octrees
+    SCENE_CHANGE_ATTACHMENTS = 4,   ///< Objects attached to or detached from the robot
+    SCENE_CHANGE_ACM = 8,           ///< Allowed collision matrix
+    SCENE_CHANGE_TRAJECTORIES = 16  ///< Trajectory generators
+};
+constexpr int SCENE_CHANGE_ALL = SCENE_CHANGE_STATE | SCENE_CHANGE_WORLD | SCENE_CHANGE_ATTACHMENTS | SCENE_CHANGE_ACM | SCENE_CHANGE_TRAJECTORIES;
+
 #ifndef EXOTICA_CORE_DYNAMICS_SOLVER_H_
 template <typename T, int NX, int NU>
 class AbstractDynamicsSolver;
@@ -73,13 +91,88 @@ public:
     Scene();
     virtual ~Scene();
     virtual void Instantiate(const SceneInitializer& init);
+
+    ///
+    /// \brief Creates an independent copy of the scene, e.g. to evaluate a problem from several threads.
+    /// The clone shares the robot model (URDF/SRDF, meshes), the MoveIt world (copy-on-write) and the collision geometries with this scene.
+    /// Joint values, frames and collision object transforms are duplicated, as are custom links, attached objects and trajectories.
+    /// Kinematics requests are not copied: the clone has to be assigned to a problem (or call RequestKinematics) before use.
+    /// \return Freshly instantiated scene in the current state of this scene.
+    ///
+    std::shared_ptr<Scene> Clone() const;
+
+    /// \brief Clone of the scene for evaluations on a worker thread, without the debug publisher and debug output.
+    /// The world, attached objects and custom links are only copied when cloning: recreate the clones whenever GetWorldVersion changed.
+    std::shared_ptr<Scene> CloneWorkspace() const;
+
     void RequestKinematics(KinematicsRequest& request, std::function<void(std::shared_ptr<KinematicResponse>)> callback);
     const std::string& GetName() const;  // Deprecated - use GetObjectName
     void Update(Eigen::VectorXdRefConst x, double t = 0);
 
+    /// \brief Updates the scene for the controlled state x and velocity x_dot, see KinematicTree::Update(x, x_dot).
+    /// An empty x_dot only updates the positions, as Update(x, t).
+    void Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRefConst x_dot, double t = 0);
+
+    ///
+    /// \brief Updates the kinematics of a whole trajectory in one pass.
+    /// The kinematics of time step t (at time t * tau) are written into responses[t]. In contrast to calling Update for every time step,
+    /// the collision object transforms are refreshed only once at the end (if always updated), i.e., the collision scene reflects the last time step.
+    /// \param x_trajectory Controlled states, one per time step.
+    /// \param responses Kinematic responses, one per time step (e.g., from KinematicTree::GetKinematicResponses).
+    /// \param tau Time step duration.
+    /// \param t_begin First time step to update.
+    ///
+    void UpdateTrajectory(const std::vector<Eigen::VectorXd>& x_trajectory, const std::vector<std::shared_ptr<KinematicResponse>>& responses, double tau, int t_begin = 0);
+
+    ///
+    /// \brief Checks a batch of states for collisions, e.g., the interpolated states along a motion.
+    /// With CollisionNumThreads > 1, the states are split across threads, each checking its states on its own clone of this scene.
+    /// The clones are kept and recreated when the world changes. Otherwise, this scene is updated to each state in turn (see CollisionScene::AreStatesValid).
+    /// \param states Controlled states, one per row.
+    /// \param self Indicate if self collision check is required.
+    /// \param safe_distance Minimum distance between objects for a state to be valid.
+    /// \param stop_at_first_invalid Whether to stop at the first invalid state. The states after it are reported as invalid.
+    /// \return Validity of each state.
+    ///
+    std::vector<bool> AreStatesValid(Eigen::MatrixXdRefConst states, bool self = true, double safe_distance = 0.0, bool stop_at_first_invalid = false);
+
+    ///
+    /// \brief Computes the minimum collision distance of each of a batch of states, parallelised as AreStatesValid.
+    /// \param states Controlled states, one per row.
+    /// \param self Indicate if self collision check is required.
+    /// \param check_margin Pairs of shapes further apart than this margin are skipped.
+    /// \return Minimum distance of each state (negative if in collision, infinity if no pair is within the margin).
+    ///
+    Eigen::VectorXd GetMinimumCollisionDistances(Eigen::MatrixXdRefConst states, bool self = true, double check_margin = std::numeric_limits<double>::infinity());
+
+    /// \brief Returns a counter that is incremented whenever anything but the state changes (world objects, custom links, attached objects,
+    /// ACM or trajectories), e.g., to tell when clones of the scene are out of date.
+    int GetWorldVersion() const { return world_version_; }
+
+    /// \brief Returns a counter that is incremented whenever the state of the scene is updated, e.g., to tell when cached collision queries are out of date.
+    int GetStateVersion() const { return state_version_; }
+
+    /// \brief Returns the version counter of one part of the scene. Counters only increase, so caches can store the versions they were
+    /// computed for. Unlike GetWorldVersion, the version of SCENE_CHANGE_WORLD only counts changes of the world objects, custom links and octrees.
+    int GetVersion(SceneChange change) const;
+
+    /// \brief Registers a callback that is called after any of the given parts of the scene changed, on the thread changing the scene.
+    /// The callback must not modify the scene. Listeners are not copied to clones.
+    /// \param callback Called with the part that changed.
+    /// \param changes Combination of SceneChange flags, by default all but the state, which changes on every update.
+    /// \return Handle for RemoveChangeListener.
+    int AddChangeListener(std::function<void(SceneChange)> callback, int changes = SCENE_CHANGE_ALL & ~SCENE_CHANGE_STATE);
+    void RemoveChangeListener(int handle);
+
     /// \brief Returns a pointer to the CollisionScene
     const CollisionScenePtr& GetCollisionScene() const;
 
+    /// \brief Selects the distance cache of the collision scene used by the following updates, see CollisionScene::SetDistanceCacheSlot.
+    void SetDistanceCacheSlot(int slot)
+    {
+        if (collision_scene_ != nullptr) collision_scene_->SetDistanceCacheSlot(slot);
+    }
+
     /// \brief Returns a pointer to the CollisionScene
     std::shared_ptr<DynamicsSolver> GetDynamicsSolver() const;
 
@@ -126,6 +219,7 @@ public:
     ///
     void DetachObject(const std::string& name);
     bool HasAttachedObject(const std::string& name);
+    const std::map<std::string, AttachedObject>& GetAttachedObjects() const { return attached_objects_; }
 
     void AddObject(const std::string& name, const KDL::Frame& transform = KDL::Frame(), const std::string& parent = "", shapes::ShapeConstPtr shape = shapes::ShapeConstPtr(nullptr), const KDL::RigidBodyInertia& inertia = KDL::RigidBodyInertia::Zero(), const Eigen::Vector4d& color = Eigen::Vector4d(0.5, 0.5, 0.5, 1.0), const bool update_collision_scene = true);
 
@@ -135,6 +229,13 @@ public:
 
     void RemoveObject(const std::string& name);
 
+    /// @brief Applies occupancy changes to the octree of an existing object without recreating its collision objects.
+    /// The octree is modified in place and thus also changes for clones of this scene which share it. Notifies SCENE_CHANGE_WORLD.
+    /// @param[in] name Name of the object with an octree shape.
+    /// @param[in] occupied_points Points (in the object frame) whose leaves become occupied.
+    /// @param[in] free_points Points (in the object frame) whose leaves become free.
+    void UpdateOctree(const std::string& name, const std::vector<Eigen::Vector3d>& occupied_points, const std::vector<Eigen::Vector3d>& free_points = std::vector<Eigen::Vector3d>());
+
     /// @brief Update the collision scene from a moveit_msgs::PlanningSceneWorld
     /// @param[in] world moveit_msgs::PlanningSceneWorld
     void UpdatePlanningSceneWorld(const moveit_msgs::PlanningSceneWorldConstPtr& world);
@@ -147,10 +248,17 @@ public:
     /// as a moveit_msgs::PlanningScene
     moveit_msgs::PlanningScene GetPlanningSceneMsg();
 
+    /// @brief Returns the duration of the last UpdatePlanningScene or UpdatePlanningSceneWorld call in seconds.
+    double GetLastPlanningSceneUpdateDuration() const { return last_planning_scene_update_duration_; }
+
     void UpdateCollisionObjects();
     void UpdateTrajectoryGenerators(double t = 0);
 
     void PublishScene();
+
+    /// @brief Publishes the scene for debug visualisation, called on every update in debug mode.
+    /// If DebugPublishRate is set, this is rate limited and the messages are published from a background thread.
+    void PublishDebugScene();
     void PublishProxies(const std::vector<CollisionProxy>& proxies);
     visualization_msgs::Marker ProxyToMarker(const std::vector<CollisionProxy>& proxies, const std::string& frame);
     void LoadScene(const std::string& scene, const Eigen::Isometry3d& offset = Eigen::Isometry3d::Identity(), bool update_collision_scene = true);
@@ -158,6 +266,12 @@ public:
     void LoadSceneFile(const std::string& file_name, const Eigen::Isometry3d& offset = Eigen::Isometry3d::Identity(), bool update_collision_scene = true);
     void LoadSceneFile(const std::string& file_name, const KDL::Frame& offset = KDL::Frame(), bool update_collision_scene = true);
     std::string GetScene();
+
+    /// @brief Saves the world objects as a binary scene snapshot, including the mesh vertex, triangle and normal buffers.
+    /// Snapshots are loaded with LoadSceneFile, which maps the file into memory and skips parsing the text format, mesh resources
+    /// and computing normals. Octrees are not supported.
+    /// @param[in] file_name Path of the snapshot file.
+    void SaveSceneSnapshot(const std::string& file_name);
     void CleanScene();
 
     /// @brief Whether the collision scene transforms get updated on every scene update.
@@ -190,6 +304,34 @@ private:
     void UpdateMoveItPlanningScene();
 
     void LoadSceneFromStringStream(std::istream& in, const Eigen::Isometry3d& offset, bool update_collision_scene);
+    void LoadSceneSnapshot(const char* data, std::size_t size, const Eigen::Isometry3d& offset, bool update_collision_scene);
+
+    /// @brief      Updates the collision objects below a re-attached element without recreating the others.
+    void UpdateReattachedCollisionObjects(const std::string& name);
+
+    /// @brief Frames and state taken from the scene for the asynchronous debug publisher
+    struct DebugSnapshot
+    {
+        ros::Time timestamp;
+        std::string root_frame_name;
+        std::vector<std::string> frame_names;
+        std::vector<KDL::Frame> frames;
+        std::map<std::string, double> model_state;
+        std::unique_ptr<moveit_msgs::PlanningScene> planning_scene;  ///< Full planning scene, only set if the world changed
+    };
+
+    void StartDebugPublisher();
+    void StopDebugPublisher();
+    void DebugPublisherLoop();
+
+    /// @brief      Adds, removes and moves world objects in place. Only the kinematic elements and collision objects of the
+    ///             changed objects are created, moved or destroyed, the world and the collision scene are not rebuilt.
+    /// @param[in]  objects Collision objects from a planning scene diff.
+    /// @return     Whether all objects could be updated in place. If not, nothing was changed.
+    bool UpdateWorldObjects(const std::vector<moveit_msgs::CollisionObject>& objects);
+
+    /// @brief      Adds the kinematic element of a world object and the elements of its collision shapes.
+    std::shared_ptr<KinematicElement> AddWorldObjectElements(const std::string& name, const collision_detection::World::Object& object);
 
     /// The kinematica tree
     exotica::KinematicTree kinematica_;
@@ -213,6 +355,47 @@ private:
     ros::Publisher ps_pub_;
     ros::Publisher proxy_pub_;
 
+    /// Asynchronous debug publishing (DebugPublishRate)
+    double debug_publish_period_ = 0.0;  ///< Minimum time between two published snapshots, 0 to publish synchronously
+    Timer debug_publish_timer_;
+    int debug_published_world_version_ = -1;  ///< The next snapshot needs to include the full planning scene if the world changed since
+    std::thread debug_publisher_;
+    std::mutex debug_publisher_mutex_;
+    std::condition_variable debug_publisher_condition_;
+    std::unique_ptr<DebugSnapshot> debug_snapshot_;  ///< Latest snapshot that has not been published yet
+    bool debug_publisher_stop_ = false;
+
+    /// \brief Increments the version counters of the change and notifies the listeners.
+    void NotifyChange(SceneChange change);
+
+    /// Incremented whenever anything but the state changes, see GetWorldVersion
+    int world_version_ = 0;
+
+    /// Incremented on every update of the state, see GetStateVersion
+    int state_version_ = 0;
+
+    int world_objects_version_ = 0;
+    int attachment_version_ = 0;
+    int acm_version_ = 0;
+    int trajectory_version_ = 0;
+
+    struct ChangeListener
+    {
+        int changes;
+        std::function<void(SceneChange)> callback;
+    };
+    std::map<int, ChangeListener> change_listeners_;
+    int next_change_listener_ = 0;
+
+    /// \brief Passes the allowed collision matrix of the planning scene to the collision scene.
+    void UpdateAllowedCollisionMatrix();
+
+    /// Clones used to check batches of states in parallel (AreStatesValid)
+    void UpdateValidityWorkspaces(int num_workspaces);
+    int collision_num_threads_ = 1;
+    int validity_workspaces_version_ = -1;
+    std::vector<std::shared_ptr<Scene>> validity_workspaces_;
+
     /// \brief List of attached objects
     /// These objects will be reattached if the scene gets reloaded.
     std::map<std::string, AttachedObject> attached_objects_;
@@ -222,6 +405,15 @@ private:
 
     std::map<std::string, std::pair<std::weak_ptr<KinematicElement>, std::shared_ptr<Trajectory>>> trajectory_generators_;
 
+    /// \brief Poses of a trajectory generator memoised by time, e.g., for the time steps of a time-indexed problem.
+    struct TrajectoryPoseCache
+    {
+        std::shared_ptr<Trajectory> trajectory;
+        std::unordered_map<double, KDL::Frame> poses;
+    };
+    std::map<std::string, TrajectoryPoseCache> trajectory_pose_cache_;
+    double trajectory_time_resolution_ = 0.0;  ///< Duration of the time slices of the trajectories (0: exact times)
+
     bool force_collision_;
 
     /// \brief Mapping between model link names and collision links.
@@ -241,9 +433,22 @@ private:
     std::shared_ptr<KinematicResponse> kinematic_solution_;
     std::function<void(std::shared_ptr<KinematicResponse>)> kinematic_request_callback_;
     bool request_needs_updating_;
+    double last_planning_scene_update_duration_ = 0.0;
 };
 
 typedef std::shared_ptr<Scene> ScenePtr;
+
+/// \brief Selects a distance cache slot of the scene (see Scene::SetDistanceCacheSlot) for its lifetime and the default slot 0 again on exit,
+/// so that queries outside of the time steps of a problem do not disturb the cache of the last time step.
+class DistanceCacheSlotGuard : Uncopyable
+{
+public:
+    DistanceCacheSlotGuard(Scene& scene, int slot) : scene_(scene) { scene_.SetDistanceCacheSlot(slot); }
+    ~DistanceCacheSlotGuard() { scene_.SetDistanceCacheSlot(0); }
+
+private:
+    Scene& scene_;
+};
 }  // namespace exotica
 
 #endif  // EXOTICA_CORE_SCENE_H_
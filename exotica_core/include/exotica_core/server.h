@@ -30,14 +30,20 @@
 #ifndef EXOTICA_CORE_SERVER_H_
 #define EXOTICA_CORE_SERVER_H_
 
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
+#include <geometric_shapes/shapes.h>
+#include <kdl/tree.hpp>
 #include <moveit/robot_model_loader/robot_model_loader.h>
 #include <ros/ros.h>
 #include <tf/transform_broadcaster.h>
 
 #include <exotica_core/tools/exception.h>
+#include <exotica_core/tools/thread_pool.h>
 #include <exotica_core/tools/uncopyable.h>
 
 namespace exotica
@@ -84,6 +90,14 @@ public:
     /// @return robot model
     robot_model::RobotModelConstPtr GetModel(const std::string &path, const std::string &urdf = "", const std::string &srdf = "");
 
+    /// \brief Returns the KDL tree parsed from the URDF of the model. The tree is shared by all kinematic trees of the model while
+    /// any of them uses it.
+    static std::shared_ptr<const KDL::Tree> GetKDLTree(const robot_model::RobotModelConstPtr &model);
+
+    /// \brief Loads the mesh from the resource (e.g., package:// or file:// URI). Meshes are shared by all scenes while any of them
+    /// uses them, hence they must not be modified.
+    static shapes::ShapePtr GetMesh(const std::string &resource, const Eigen::Vector3d &scale = Eigen::Vector3d::Ones());
+
     /// \brief Get the name of ther server
     /// @return Server name
     std::string GetName();
@@ -91,8 +105,24 @@ public:
     inline static void InitRos(std::shared_ptr<ros::NodeHandle> nh, int numThreads = 2)
     {
         Instance()->node_.reset(new RosNode(nh, numThreads));
+        Instance()->ros_num_threads_ = numThreads;
     }
 
+    /// \brief Returns the process-wide thread pool, which runs all parallel loops (see ParallelLoop) and the seeds of
+    /// MotionSolver::SolveMultiStart, so that nested parallel work shares one set of threads.
+    /// It is created on first use with the configuration of ConfigureThreadPool.
+    static ThreadPool &GetThreadPool();
+
+    /// \brief Configures the process-wide thread pool, replacing the current one. Must not be called while tasks are running on it.
+    /// @param num_threads Number of threads, including the calling thread (0: the hardware threads not used by the ROS spinner of InitRos)
+    /// @param pin_threads Pins each thread of the pool to one CPU (Linux only)
+    /// @param deterministic Runs all tasks of the pool serially on the calling thread, and ResolveNumThreads returns 1
+    static void ConfigureThreadPool(int num_threads = 0, bool pin_threads = false, bool deterministic = false);
+
+    /// \brief Resolves the number of threads requested by parallel code, e.g., by initializer options:
+    /// 0 becomes the number of threads of the thread pool, and every request 1 in deterministic mode.
+    static int ResolveNumThreads(int num_threads);
+
     inline static bool IsRos() { return Instance()->node_ != nullptr; }
     inline static ros::NodeHandle &GetNodeHandle()
     {
@@ -180,9 +210,30 @@ private:
     std::string name_;
 
     std::shared_ptr<RosNode> node_;
+    int ros_num_threads_ = 0;  ///< Threads of the ROS spinner
+
+    std::mutex thread_pool_mutex_;
+    std::unique_ptr<ThreadPool> thread_pool_;
+    int thread_pool_num_threads_ = 0;  ///< Configured number of threads, 0 for the hardware threads not used by ROS
+    bool thread_pool_pin_threads_ = false;
+    bool thread_pool_deterministic_ = false;
+
+    /// \brief Loads the robot model from the URDF and SRDF strings, or returns the model loaded from the same content before
+    robot_model::RobotModelPtr LoadModelFromContent(const std::string &urdf, const std::string &srdf);
+
+    std::mutex model_cache_mutex_;  ///< Guards the robot model, KDL tree and mesh caches
 
     /// \brief Robot model cache
     std::map<std::string, robot_model::RobotModelPtr> robot_models_;
+    std::map<std::uint64_t, robot_model::RobotModelPtr> robot_models_by_content_;  ///< Keyed on a hash of the URDF and SRDF content
+
+    struct KDLTreeEntry
+    {
+        robot_model::RobotModelConstWeakPtr model;
+        std::weak_ptr<const KDL::Tree> tree;
+    };
+    std::map<const robot_model::RobotModel *, KDLTreeEntry> kdl_trees_;
+    std::map<std::string, std::weak_ptr<shapes::Shape>> meshes_;  ///< Keyed on the resource and scale
 };
 
 typedef std::shared_ptr<Server> ServerPtr;
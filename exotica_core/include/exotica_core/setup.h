@@ -38,10 +38,9 @@
 #include <exotica_core/motion_solver.h>
 #include <exotica_core/object.h>
 #include <exotica_core/planning_problem.h>
+#include <exotica_core/plugin_factory.h>
 #include <exotica_core/property.h>
 
-#include <pluginlib/class_loader.h>
-
 namespace exotica
 {
 class Setup : public Object, Uncopyable
@@ -60,11 +59,11 @@ public:
     static void Destroy();
 
     static void PrintSupportedClasses();
-    static std::shared_ptr<exotica::MotionSolver> CreateSolver(const std::string& type, bool prepend = true) { return ToStdPtr(Instance()->solvers_.createInstance((prepend ? "exotica/" : "") + type)); }
-    static std::shared_ptr<exotica::TaskMap> CreateMap(const std::string& type, bool prepend = true) { return ToStdPtr(Instance()->maps_.createInstance((prepend ? "exotica/" : "") + type)); }
+    static std::shared_ptr<exotica::MotionSolver> CreateSolver(const std::string& type, bool prepend = true) { return Instance()->solvers_.CreateInstance((prepend ? "exotica/" : "") + type); }
+    static std::shared_ptr<exotica::TaskMap> CreateMap(const std::string& type, bool prepend = true) { return Instance()->maps_.CreateInstance((prepend ? "exotica/" : "") + type); }
     static std::shared_ptr<exotica::PlanningProblem> CreateProblem(const std::string& type, bool prepend = true) { return Instance()->problems_.CreateInstance((prepend ? "exotica/" : "") + type); }
-    static std::shared_ptr<exotica::CollisionScene> CreateCollisionScene(const std::string& type, bool prepend = true) { return ToStdPtr(Instance()->collision_scenes_.createInstance((prepend ? "exotica/" : "") + type)); }
-    static std::shared_ptr<exotica::DynamicsSolver> CreateDynamicsSolver(const std::string& type, bool prepend = true) { return ToStdPtr(Instance()->dynamics_solvers_.createInstance((prepend ? "exotica/" : "") + type)); }
+    static std::shared_ptr<exotica::CollisionScene> CreateCollisionScene(const std::string& type, bool prepend = true) { return Instance()->collision_scenes_.CreateInstance((prepend ? "exotica/" : "") + type); }
+    static std::shared_ptr<exotica::DynamicsSolver> CreateDynamicsSolver(const std::string& type, bool prepend = true) { return Instance()->dynamics_solvers_.CreateInstance((prepend ? "exotica/" : "") + type); }
     static std::vector<std::string> GetSolvers();
     static std::vector<std::string> GetProblems();
     static std::vector<std::string> GetMaps();
@@ -74,7 +73,7 @@ public:
 
     static std::shared_ptr<exotica::MotionSolver> CreateSolver(const Initializer& init)
     {
-        std::shared_ptr<exotica::MotionSolver> ret = ToStdPtr(Instance()->solvers_.createInstance(init.GetName()));
+        std::shared_ptr<exotica::MotionSolver> ret = Instance()->solvers_.CreateInstance(init.GetName());
         ret->InstantiateInternal(init);
         return ret;
     }
@@ -103,14 +102,14 @@ public:
 
     static std::shared_ptr<exotica::DynamicsSolver> CreateDynamicsSolver(const Initializer& init)
     {
-        auto ret = ToStdPtr(Instance()->dynamics_solvers_.createInstance(init.GetName()));
+        auto ret = Instance()->dynamics_solvers_.CreateInstance(init.GetName());
         ret->InstantiateInternal(init);
         return ret;
     }
 
     static std::shared_ptr<exotica::CollisionScene> CreateCollisionScene(const Initializer& init)
     {
-        auto ret = ToStdPtr(Instance()->collision_scenes_.createInstance(init.GetName()));
+        auto ret = Instance()->collision_scenes_.CreateInstance(init.GetName());
         ret->InstantiateInternal(init);
         return ret;
     }
@@ -125,15 +124,15 @@ private:
 
     static std::shared_ptr<exotica::TaskMap> CreateMap(const Initializer& init)
     {
-        std::shared_ptr<exotica::TaskMap> ret = ToStdPtr(Instance()->maps_.createInstance(init.GetName()));
+        std::shared_ptr<exotica::TaskMap> ret = Instance()->maps_.CreateInstance(init.GetName());
         ret->InstantiateInternal(init);
         return ret;
     }
 
-    pluginlib::ClassLoader<exotica::MotionSolver> solvers_;
-    pluginlib::ClassLoader<exotica::TaskMap> maps_;
-    pluginlib::ClassLoader<exotica::CollisionScene> collision_scenes_;
-    pluginlib::ClassLoader<exotica::DynamicsSolver> dynamics_solvers_;
+    PluginFactory<exotica::MotionSolver> solvers_;
+    PluginFactory<exotica::TaskMap> maps_;
+    PluginFactory<exotica::CollisionScene> collision_scenes_;
+    PluginFactory<exotica::DynamicsSolver> dynamics_solvers_;
     PlanningProblemFac problems_;
 };
 
@@ -35,6 +35,7 @@
 #include <vector>
 
 #include <Eigen/Dense>  // Generally dense manipulations should be enough
+#include <Eigen/Sparse>
 
 #include <exotica_core/factory.h>  // The Factory template
 #include <exotica_core/object.h>   // The EXOTica base class
@@ -72,9 +73,36 @@ public:
     virtual int TaskSpaceDim() = 0;
     virtual int TaskSpaceJacobianDim() { return TaskSpaceDim(); }
     virtual void PreUpdate() {}
+
+    /// \brief Whether Update queries the scene (e.g., the collision scene or the kinematic tree) directly instead of only using the kinematic responses in kinematics.
+    /// Such task maps require the scene to be in the state passed to Update.
+    virtual bool UsesSceneState() const { return false; }
+
+    /// \brief Whether Update(q, phi) uses the Jacobians of the kinematic responses, e.g., to compute a manipulability measure.
+    /// Otherwise, the default finite-difference Jacobian only updates the frames (KinematicTree::UpdateFrames) for the perturbed states.
+    virtual bool UsesKinematicJacobians() const { return false; }
+
+    /// \brief Whether UpdateTrajectory is implemented. Such task maps only depend on the joint states, so all time steps of a trajectory can be evaluated at once and in any order.
+    virtual bool HasTrajectoryUpdate() const { return false; }
+
+    /// \brief Whether the task space vector of a time step also depends on the states before it (e.g., backward differences).
+    /// UpdateTrajectory takes these from the trajectory, whereas Update takes them from the log of previous joint states.
+    virtual bool UsesPreviousStates() const { return false; }
+
+    /// \brief Evaluates the task map for all states of a trajectory at once, one state per column of x. Column t of phi is the task space vector of time step t.
+    /// Task maps using previous states (e.g., backward differences) take the states before the first column from their log of previous joint states.
+    virtual void UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi);
+
+    /// \brief As above, and sets the block-banded Jacobian of the stacked phi w.r.t. the stacked states as triplets:
+    /// the entry (t * TaskSpaceJacobianDim() + i, s * x.rows() + j) is the derivative of phi(i, t) w.r.t. x(j, s).
+    virtual void UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi, std::vector<Eigen::Triplet<double>>& jacobian);
     virtual std::vector<TaskVectorEntry> GetLieGroupIndices() { return std::vector<TaskVectorEntry>(); }
     std::vector<KinematicFrameRequest> GetFrames() const;
 
+    /// \brief Creates a new instance of this task map from its initializer, assigned to the given scene (e.g., a clone of the scene of this task map).
+    /// The indices into the task space vectors of the problem are copied, the kinematics of the new instance still have to be requested from the scene.
+    std::shared_ptr<TaskMap> CreateClone(ScenePtr scene) const;
+
     std::vector<KinematicSolution> kinematics = std::vector<KinematicSolution>(1);
     int id = -1;
     int start = -1;
@@ -86,6 +114,30 @@ public:
 protected:
     std::vector<KinematicFrameRequest> frames_;
     ScenePtr scene_ = nullptr;
+
+private:
+    /// \brief Clone of the scene and the task map on which the columns of the finite-difference Jacobian are evaluated in parallel.
+    struct FiniteDifferenceWorkspace
+    {
+        ScenePtr scene;
+        std::shared_ptr<TaskMap> map;
+        Eigen::VectorXd q_perturbed;
+        Eigen::VectorXd phi_forward;
+        Eigen::VectorXd phi_backward;
+    };
+
+    /// \brief Computes column i of the finite-difference Jacobian with the scene and the task map of a workspace (or this task map).
+    /// q_perturbed has to equal q on entry and is restored on exit.
+    void ComputeFiniteDifferenceColumn(Scene& scene, TaskMap& map, Eigen::VectorXdRefConst q, Eigen::VectorXdRefConst phi, int i, Eigen::VectorXd& q_perturbed, Eigen::VectorXd& phi_forward, Eigen::VectorXd& phi_backward, Eigen::MatrixXdRef jacobian);
+
+    void UpdateFiniteDifferenceWorkspaces(int num_workspaces);
+
+    Initializer initializer_;  ///< Used to create the clones of the task map
+    int finite_difference_num_threads_ = 1;
+    FiniteDifferenceMode finite_difference_mode_ = FiniteDifferenceMode::Backward;
+    double finite_difference_step_ = 1e-6;
+    int finite_difference_workspaces_version_ = -1;  ///< World version of the scene the clones were created from
+    std::vector<FiniteDifferenceWorkspace> finite_difference_workspaces_;
 };
 
 // Typedefines for some common functionality
@@ -0,0 +1,155 @@
+//
+// Copyright (c) 2020, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_TASK_MAP_AUTODIFF_H_
+#define EXOTICA_CORE_TASK_MAP_AUTODIFF_H_
+
+#include <exotica_core/task_map.h>
+#include <exotica_core/tools/autodiff_chain_hessian.h>
+#include <exotica_core/tools/autodiff_chain_jacobian.h>
+
+namespace exotica
+{
+///
+/// \brief Task map base class computing the Jacobian and Hessian of phi with automatic differentiation.
+///
+/// The derived class implements phi once, templated on the scalar type, as a function of the frames of kinematics[0]:
+///
+///     template <typename T>
+///     void Phi(const Eigen::Matrix<T, Eigen::Dynamic, 1>& frames, Eigen::Matrix<T, Eigen::Dynamic, 1>& phi) const;
+///
+/// The entries [3 * i, 3 * i + 3) of frames are the position of frame i. phi is already sized to TaskSpaceDim(). The
+/// derivatives are chained onto the kinematic Jacobians (KIN_J) and Hessians (KIN_H) with AutoDiffChainJacobian and
+/// AutoDiffChainHessian.
+///
+template <typename Derived>
+class TaskMapAutoDiff : public TaskMap
+{
+public:
+    void Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi) override
+    {
+        if (phi.rows() != TaskSpaceDim()) ThrowNamed("Wrong size of Phi!");
+        UpdateFrameInput();
+        phi_.resize(phi.rows());
+        static_cast<const Derived&>(*this).Phi(frame_input_, phi_);
+        phi = phi_;
+    }
+
+    void Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian) override
+    {
+        if (phi.rows() != TaskSpaceDim()) ThrowNamed("Wrong size of Phi!");
+        if (kinematics[0].jacobian.rows() != kinematics[0].Phi.rows()) ThrowNamed("The Jacobians of the frames were not requested!");
+        const int num_columns = kinematics[0].jacobian(0).data.cols();
+        if (jacobian.rows() != phi.rows() || jacobian.cols() != num_columns) ThrowNamed("Wrong size of jacobian! " << num_columns);
+
+        UpdateFrameInput();
+        UpdateFrameInputJacobian();
+        phi_.resize(phi.rows());
+        jacobian_.resize(phi.rows(), num_columns);
+        Eigen::AutoDiffChainJacobian<PhiFunctor> autodiff{PhiFunctor(static_cast<const Derived&>(*this))};
+        autodiff(frame_input_, phi_, jacobian_, frame_input_jacobian_);
+        phi = phi_;
+        jacobian = jacobian_;
+    }
+
+    void Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian, HessianRef hessian) override
+    {
+        if (phi.rows() != TaskSpaceDim()) ThrowNamed("Wrong size of Phi!");
+        if (kinematics[0].jacobian.rows() != kinematics[0].Phi.rows()) ThrowNamed("The Jacobians of the frames were not requested!");
+        if (kinematics[0].hessian.rows() != kinematics[0].Phi.rows()) ThrowNamed("The Hessians of the frames were not requested!");
+        const int num_columns = kinematics[0].jacobian(0).data.cols();
+        if (jacobian.rows() != phi.rows() || jacobian.cols() != num_columns) ThrowNamed("Wrong size of jacobian! " << num_columns);
+
+        UpdateFrameInput();
+        UpdateFrameInputJacobian();
+        UpdateFrameInputHessian();
+        phi_.resize(phi.rows());
+        jacobian_.resize(phi.rows(), num_columns);
+        Eigen::AutoDiffChainHessian<PhiFunctor> autodiff{PhiFunctor(static_cast<const Derived&>(*this))};
+        autodiff(frame_input_, phi_, jacobian_, hessian_, frame_input_jacobian_, frame_input_hessian_);
+        phi = phi_;
+        jacobian = jacobian_;
+        for (int i = 0; i < phi.rows(); ++i)
+        {
+            hessian(i).block(0, 0, num_columns, num_columns) = hessian_(i);
+        }
+    }
+
+private:
+    /// \brief Adapts Derived::Phi to the functor interface of the autodiff chain rule.
+    struct PhiFunctor : public Functor
+    {
+        explicit PhiFunctor(const Derived& map) : map(&map) {}
+
+        template <typename T>
+        void operator()(const Eigen::Matrix<T, Eigen::Dynamic, 1>& frames, Eigen::Matrix<T, Eigen::Dynamic, 1>& phi) const
+        {
+            map->Phi(frames, phi);
+        }
+
+        const Derived* map;
+    };
+
+    void UpdateFrameInput()
+    {
+        const int num_frames = kinematics[0].Phi.rows();
+        frame_input_.resize(3 * num_frames);
+        for (int i = 0; i < num_frames; ++i) frame_input_.segment<3>(3 * i) = Eigen::Map<const Eigen::Vector3d>(kinematics[0].Phi(i).p.data);
+    }
+
+    /// \brief Derivatives of the frame input w.r.t. q, i.e., the linear part of the frame Jacobians.
+    void UpdateFrameInputJacobian()
+    {
+        const int num_frames = kinematics[0].Phi.rows();
+        const int num_columns = kinematics[0].jacobian(0).data.cols();
+        frame_input_jacobian_.resize(3 * num_frames, num_columns);
+        for (int i = 0; i < num_frames; ++i) frame_input_jacobian_.middleRows<3>(3 * i) = kinematics[0].jacobian(i).data.topRows<3>();
+    }
+
+    /// \brief Second derivatives of the frame input w.r.t. q, i.e., the linear part of the frame Hessians.
+    void UpdateFrameInputHessian()
+    {
+        const int num_frames = kinematics[0].Phi.rows();
+        frame_input_hessian_.resize(3 * num_frames);
+        for (int i = 0; i < num_frames; ++i)
+        {
+            for (int k = 0; k < 3; ++k) frame_input_hessian_(3 * i + k) = kinematics[0].hessian(i)(k);
+        }
+    }
+
+    Eigen::VectorXd frame_input_;
+    Eigen::MatrixXd frame_input_jacobian_;
+    Hessian frame_input_hessian_;
+    Eigen::VectorXd phi_;
+    Eigen::MatrixXd jacobian_;
+    Hessian hessian_;
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_TASK_MAP_AUTODIFF_H_
@@ -53,11 +53,19 @@ struct TaskSpaceVector
     ~TaskSpaceVector();
     TaskSpaceVector& operator=(std::initializer_list<double> other);
     Eigen::VectorXd operator-(const TaskSpaceVector& other);
+    /// \brief Writes the difference of this and other into out without allocating. out has to have the size of the tangent space.
+    void Difference(const TaskSpaceVector& other, Eigen::VectorXdRef out) const;
+    /// \brief Size of the tangent space, i.e., of the difference of two task space vectors.
+    int TangentSize() const;
     void SetZero(const int n);
 
     Eigen::VectorXd data;
     std::vector<TaskVectorEntry> map;
 };
+
+/// \brief Writes the difference of the task space values data and other_data, whose rotations are given by map (indexed from the start of data), into out, as TaskSpaceVector::Difference.
+/// Used to take the difference of parts of task space vectors in place. The sizes are not checked.
+void TaskSpaceDifference(Eigen::VectorXdRefConst data, Eigen::VectorXdRefConst other_data, const std::vector<TaskVectorEntry>& map, Eigen::VectorXdRef out);
 }  // namespace exotica
 
 #endif  // EXOTICA_CORE_TASK_SPACE_VECTOR_H_
@@ -50,6 +50,7 @@ struct TaskIndexing
     int length;
     int start_jacobian;
     int length_jacobian;
+    std::vector<TaskVectorEntry> map;  ///< Rotations of the task map, indexed from the start of its task space values
 };
 
 struct Task
@@ -98,6 +99,10 @@ struct TimeIndexedTask : public Task
 
     void ReinitializeVariables(int _T, std::shared_ptr<PlanningProblem> _prob, const TaskSpaceVector& _Phi);
 
+    /// \brief Sets the goals and weights of each time step to those of the nearest time step of y_in and rho_in,
+    /// which span the same duration with a different number of time steps (see GetNearestTimeStep).
+    void ResampleGoals(const std::vector<TaskSpaceVector>& y_in, const std::vector<Eigen::VectorXd>& rho_in);
+
     inline void ValidateTimeIndex(int& t_in) const;
 
     void SetGoal(const std::string& task_name, Eigen::VectorXdRefConst goal, int t);
@@ -109,6 +114,12 @@ struct TimeIndexedTask : public Task
     Eigen::VectorXd GetTaskError(const std::string& task_name, int t) const;
     Eigen::MatrixXd GetS(const std::string& task_name, int t) const;
 
+    /// \brief Whether the task map with the given id (see TaskMap::id) is part of this task and weighted at time step t, i.e., its rho is not zero (as of the last UpdateS).
+    inline bool IsTaskMapActive(int map_id, int t) const
+    {
+        return map_id < num_active_map_ids_ && t >= 0 && t < T && active_task_maps_[t * num_active_map_ids_ + map_id];
+    }
+
     std::vector<Eigen::VectorXd> rho;
     std::vector<TaskSpaceVector> y;
     std::vector<Eigen::VectorXd> ydiff;
@@ -120,8 +131,13 @@ struct TimeIndexedTask : public Task
     std::vector<Eigen::MatrixXd> jacobian;
     std::vector<Eigen::MatrixXd> dPhi_dx;
     std::vector<Eigen::MatrixXd> dPhi_du;
-    std::vector<Eigen::MatrixXd> S;
+    std::vector<Eigen::MatrixXd> S;  ///< Diagonal task weights (rho), applied as diagonal scaling
     int T;
+    bool store_hessians = true;  ///< Whether ReinitializeVariables allocates the Hessians of each time step (hessian, ddPhi_ddx, ddPhi_ddu, ddPhi_dxdu) if the problem requests KIN_H
+
+private:
+    int num_active_map_ids_ = 0;
+    std::vector<char> active_task_maps_;  ///< Whether the task map with id i is weighted at time step t, at index t * num_active_map_ids_ + i
 };
 
 struct EndPoseTask : public Task
@@ -135,6 +151,12 @@ struct EndPoseTask : public Task
     void Update(const TaskSpaceVector& big_Phi, Eigen::MatrixXdRefConst big_jacobian);
     void Update(const TaskSpaceVector& big_Phi);
 
+    /// \brief Fused evaluation for Gauss-Newton type solvers: updates Phi and ydiff from big_Phi and accumulates the normal equations of the weighted residual S * ydiff,
+    /// i.e., JT_times_J = J^T * S^2 * J (N x N) and JT_times_yd = J^T * S^2 * ydiff (of size N), reading the task Jacobians in place from big_jacobian.
+    /// jacobian and hessian are not updated. Tasks with a rho of zero are skipped after updating their Phi and ydiff.
+    /// \return The weighted sum of squares ydiff^T * S * ydiff.
+    double UpdateFused(const TaskSpaceVector& big_Phi, Eigen::MatrixXdRefConst big_jacobian, Eigen::VectorXdRef JT_times_yd, Eigen::MatrixXdRef JT_times_J);
+
     void SetGoal(const std::string& task_name, Eigen::VectorXdRefConst goal);
     Eigen::VectorXd GetGoal(const std::string& task_name) const;
 
@@ -150,7 +172,7 @@ struct EndPoseTask : public Task
     TaskSpaceVector Phi;
     Eigen::MatrixXd jacobian;
     Hessian hessian;
-    Eigen::MatrixXd S;
+    Eigen::MatrixXd S;  ///< Diagonal task weights (rho), applied as diagonal scaling
 };
 
 struct SamplingTask : public Task
@@ -172,7 +194,7 @@ struct SamplingTask : public Task
     TaskSpaceVector y;
     Eigen::VectorXd ydiff;
     TaskSpaceVector Phi;
-    Eigen::MatrixXd S;
+    Eigen::MatrixXd S;  ///< Diagonal task weights (rho), applied as diagonal scaling
 };
 }  // namespace exotica
 
@@ -31,12 +31,14 @@
 #define EXOTICA_CORE_TOOLS_H_
 
 #include <Eigen/Dense>
+#include <cstdint>
 #include <kdl/frames.hpp>
 #include <string>
 
 #include <exotica_core/tools/conversions.h>
 #include <exotica_core/tools/exception.h>
 #include <exotica_core/tools/printable.h>
+#include <exotica_core/tools/profiler.h>
 #include <exotica_core/tools/timer.h>
 #include <exotica_core/tools/uncopyable.h>
 #include <exotica_core/version.h>
@@ -118,6 +120,46 @@ std::string LoadFile(const std::string& path);
 
 bool PathExists(const std::string& path);
 
+/// \brief Returns the time step of a trajectory of T_from time steps nearest to time step t of a trajectory of T_to time steps of the same duration.
+int GetNearestTimeStep(int t, int T_from, int T_to);
+
+/// \brief Linearly interpolates a trajectory (one time step per column) at T equally spaced time steps spanning the same duration.
+Eigen::MatrixXd ResampleTrajectory(Eigen::MatrixXdRefConst trajectory, int T);
+
+/// \brief Restores the number of time steps of a problem (see SetResolution) when going out of scope, e.g., when a coarse level of a
+/// multiresolution solve throws.
+template <typename ProblemType>
+class ResolutionGuard : public Uncopyable
+{
+public:
+    ResolutionGuard(ProblemType& problem, int T) : problem_(problem), T_(T) {}
+    ~ResolutionGuard()
+    {
+        try
+        {
+            problem_.SetResolution(T_);
+        }
+        catch (const std::exception& e)
+        {
+            WARNING("Failed to restore the resolution T=" << T_ << ": " << e.what());
+        }
+    }
+
+private:
+    ProblemType& problem_;
+    const int T_;
+};
+
+/// \brief SplitMix64 finaliser, a counter-based generator passing BigCrush: hashing seed-dependent keys plus a counter gives
+/// reproducible random streams that any thread can evaluate at any position.
+inline std::uint64_t SplitMix64(std::uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
 /// \brief Argument position.
 ///        Used as parameter to refer to an argument.
 enum ArgumentPosition
@@ -128,6 +170,14 @@ enum ArgumentPosition
     ARG3 = 3,
     ARG4 = 4
 };
+
+/// \brief Finite-difference scheme of the default TaskMap Jacobian and DynamicsSolver derivatives
+enum class FiniteDifferenceMode
+{
+    Backward,
+    Forward,
+    Central
+};
 }  // namespace exotica
 
 namespace
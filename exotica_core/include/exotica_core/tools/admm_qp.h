@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_ADMM_QP_H_
+#define EXOTICA_CORE_ADMM_QP_H_
+
+#include <exotica_core/tools/exception.h>
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace exotica
+{
+/// \brief Solves the convex quadratic program
+///     min 0.5 x^T P x + q^T x  s.t.  l <= A x <= u
+/// with the alternating direction method of multipliers (ADMM) of OSQP (B. Stellato et al., OSQP: An Operator Splitting Solver for
+/// Quadratic Programs, Mathematical Programming Computation, 2020). Equality constraints are rows with l == u, unbounded sides are
+/// +-infinity. The primal iterate x, the constraint iterate z = A x and the multipliers y are kept between calls of Solve,
+/// i.e., consecutive solves of similar problems are warm-started from the previous active set (the non-zero multipliers).
+class AdmmQP
+{
+public:
+    int max_iterations = 200;           ///< Maximum number of ADMM iterations per solve
+    double absolute_tolerance = 1e-6;   ///< Absolute tolerance of the primal and dual residuals
+    double relative_tolerance = 1e-6;   ///< Relative tolerance of the primal and dual residuals
+    double rho = 0.1;                   ///< Penalty parameter of the inequality constraints (equality constraints use 1e3 rho)
+    double sigma = 1e-6;                ///< Regularisation of the x-update
+    double alpha = 1.6;                 ///< Over-relaxation parameter in (0, 2)
+    bool warm_start = true;             ///< Whether Solve starts from the iterates of the previous solve
+
+    /// \brief Solves the QP. Returns whether the residuals reached the tolerances within max_iterations.
+    bool Solve(const Eigen::MatrixXd& P, const Eigen::VectorXd& q, const Eigen::MatrixXd& A, const Eigen::VectorXd& l, const Eigen::VectorXd& u)
+    {
+        const Eigen::Index n = q.size(), m = l.size();
+        if (P.rows() != n || P.cols() != n) ThrowPretty("Wrong size of P: " << P.rows() << "x" << P.cols() << ", expected " << n << "x" << n);
+        if (A.rows() != m || A.cols() != n || u.size() != m) ThrowPretty("Wrong size of the constraints A (" << A.rows() << "x" << A.cols() << "), l (" << m << "), u (" << u.size() << ")");
+
+        // The iterates are reset if the dimensions changed
+        if (!warm_start || x_.size() != n || z_.size() != m)
+        {
+            x_.setZero(n);
+            z_.setZero(m);
+            y_.setZero(m);
+        }
+        x_tilde_.resize(n);
+        z_tilde_.resize(m);
+        rhs_.resize(n);
+        rho_vec_.resize(m);
+        z_previous_.resize(m);
+
+        // Equality constraints are enforced stiffly, constraints without bounds do not contribute
+        constexpr double infinity = std::numeric_limits<double>::infinity();
+        for (Eigen::Index i = 0; i < m; ++i)
+        {
+            if (l(i) == -infinity && u(i) == infinity)
+                rho_vec_(i) = 1e-6;
+            else if (u(i) - l(i) < 1e-9)
+                rho_vec_(i) = 1e3 * rho;
+            else
+                rho_vec_(i) = rho;
+        }
+
+        // The KKT system of the x-update is reduced to P + sigma I + A^T diag(rho) A, which is factorised once per solve
+        K_ = P;
+        K_.diagonal().array() += sigma;
+        K_.noalias() += A.transpose() * rho_vec_.asDiagonal() * A;
+        K_llt_.compute(K_);
+        if (K_llt_.info() != Eigen::Success) ThrowPretty("The QP is not convex (P + sigma I + A^T rho A is not positive definite)!");
+
+        // The projection of the warm-start onto the bounds keeps z feasible
+        z_ = z_.cwiseMax(l).cwiseMin(u);
+
+        converged_ = false;
+        for (iterations_ = 0; iterations_ < max_iterations; ++iterations_)
+        {
+            // x-update: (P + sigma I + A^T rho A) x_tilde = sigma x - q + A^T (rho z - y)
+            rhs_ = sigma * x_ - q;
+            rhs_.noalias() += A.transpose() * (rho_vec_.cwiseProduct(z_) - y_);
+            x_tilde_ = rhs_;
+            K_llt_.solveInPlace(x_tilde_);
+            z_tilde_.noalias() = A * x_tilde_;
+
+            // Relaxed updates of x, z and the multipliers y
+            x_ = alpha * x_tilde_ + (1.0 - alpha) * x_;
+            z_previous_ = z_;
+            z_tilde_ = alpha * z_tilde_ + (1.0 - alpha) * z_previous_;
+            z_ = (z_tilde_ + y_.cwiseQuotient(rho_vec_)).cwiseMax(l).cwiseMin(u);
+            y_ += rho_vec_.cwiseProduct(z_tilde_ - z_);
+
+            if (CheckConvergence(P, q, A))
+            {
+                converged_ = true;
+                ++iterations_;
+                break;
+            }
+        }
+        return converged_;
+    }
+
+    /// \brief Discards the iterates of the previous solve.
+    void ResetWarmStart()
+    {
+        x_.resize(0);
+        z_.resize(0);
+        y_.resize(0);
+    }
+
+    const Eigen::VectorXd& GetSolution() const { return x_; }         ///< Primal solution x
+    const Eigen::VectorXd& GetMultipliers() const { return y_; }      ///< Multipliers of the constraints (positive at active upper bounds, negative at active lower bounds)
+    int GetNumberOfIterations() const { return iterations_; }         ///< Number of iterations of the last solve
+    bool IsConverged() const { return converged_; }                   ///< Whether the last solve reached the tolerances
+    double GetPrimalResidual() const { return primal_residual_; }     ///< Infinity norm of A x - z of the last iteration
+    double GetDualResidual() const { return dual_residual_; }         ///< Infinity norm of P x + q + A^T y of the last iteration
+
+private:
+    bool CheckConvergence(const Eigen::MatrixXd& P, const Eigen::VectorXd& q, const Eigen::MatrixXd& A)
+    {
+        z_tilde_.noalias() = A * x_;  // A x, z_tilde_ is not needed anymore in this iteration
+        primal_residual_ = z_tilde_.size() > 0 ? (z_tilde_ - z_).lpNorm<Eigen::Infinity>() : 0.0;
+        const double primal_scale = z_tilde_.size() > 0 ? std::max(z_tilde_.lpNorm<Eigen::Infinity>(), z_.lpNorm<Eigen::Infinity>()) : 0.0;
+
+        rhs_.noalias() = P * x_;
+        const double Px_norm = rhs_.lpNorm<Eigen::Infinity>();
+        x_tilde_.noalias() = A.transpose() * y_;  // A^T y, x_tilde_ is not needed anymore in this iteration
+        const double ATy_norm = x_tilde_.lpNorm<Eigen::Infinity>();
+        rhs_ += q + x_tilde_;
+        dual_residual_ = rhs_.lpNorm<Eigen::Infinity>();
+        const double dual_scale = std::max(std::max(Px_norm, ATy_norm), q.lpNorm<Eigen::Infinity>());
+
+        return primal_residual_ <= absolute_tolerance + relative_tolerance * primal_scale && dual_residual_ <= absolute_tolerance + relative_tolerance * dual_scale;
+    }
+
+    Eigen::VectorXd x_, z_, y_;
+    Eigen::VectorXd x_tilde_, z_tilde_, z_previous_, rhs_, rho_vec_;
+    Eigen::MatrixXd K_;
+    Eigen::LLT<Eigen::MatrixXd> K_llt_;
+    int iterations_ = 0;
+    bool converged_ = false;
+    double primal_residual_ = std::numeric_limits<double>::infinity();
+    double dual_residual_ = std::numeric_limits<double>::infinity();
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_ADMM_QP_H_
@@ -0,0 +1,162 @@
+// Copyright (C) 2021
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// Modified from unsupported/Eigen/src/AutoDiff/AutoDiffJacobian.h
+
+#ifndef EIGEN_AUTODIFF_CHAIN_JACOBIAN_LANES_H_
+#define EIGEN_AUTODIFF_CHAIN_JACOBIAN_LANES_H_
+
+#include <exotica_core/tools/autodiff_scalar.h>
+#include <exotica_core/tools/functor.h>
+#include <algorithm>
+
+namespace Eigen
+{
+/// \brief Forward-mode Jacobian with a fixed number of derivative lanes: the Jacobian is evaluated Lanes columns at a
+/// time, with ceil(cols / Lanes) evaluations of the functor. Unlike the dynamic derivatives of AutoDiffChainJacobian,
+/// which are heap-allocated for every intermediate, the derivatives are stack-allocated and vectorised.
+template <typename Functor, int Lanes = 4>
+class AutoDiffChainJacobianLanes : public Functor
+{
+public:
+    AutoDiffChainJacobianLanes() : Functor() {}
+    AutoDiffChainJacobianLanes(const Functor &f) : Functor(f) {}
+// forward constructors
+#if EIGEN_HAS_VARIADIC_TEMPLATES
+    template <typename... T>
+    AutoDiffChainJacobianLanes(const T &... Values) : Functor(Values...)
+    {
+    }
+#else
+    template <typename T0>
+    AutoDiffChainJacobianLanes(const T0 &a0) : Functor(a0)
+    {
+    }
+    template <typename T0, typename T1>
+    AutoDiffChainJacobianLanes(const T0 &a0, const T1 &a1) : Functor(a0, a1)
+    {
+    }
+    template <typename T0, typename T1, typename T2>
+    AutoDiffChainJacobianLanes(const T0 &a0, const T1 &a1, const T2 &a2) : Functor(a0, a1, a2)
+    {
+    }
+#endif
+
+    typedef typename Functor::InputType InputType;
+    typedef typename Functor::ValueType ValueType;
+    typedef typename ValueType::Scalar Scalar;
+
+    enum
+    {
+        InputsAtCompileTime = InputType::RowsAtCompileTime,
+        ValuesAtCompileTime = ValueType::RowsAtCompileTime,
+        JacobianInputsAtCompileTime = Functor::JacobianColsAtCompileTime  // JacobianInputsAtCompileTime no longer have to match InputsAtCompileTime
+    };
+
+    typedef Matrix<Scalar, ValuesAtCompileTime, JacobianInputsAtCompileTime> JacobianType;
+
+    typedef Matrix<Scalar, InputsAtCompileTime, JacobianInputsAtCompileTime> InputJacobianType;  // Jacobian.cols() matches InputJacobian.cols()
+    typedef typename JacobianType::Index Index;
+
+    typedef Matrix<Scalar, Lanes, 1> DerivativeType;  // One lane per Jacobian column of a pass
+    typedef AutoDiffScalar<DerivativeType> ActiveScalar;
+
+    typedef Matrix<ActiveScalar, InputsAtCompileTime, 1> ActiveInput;
+    typedef Matrix<ActiveScalar, ValuesAtCompileTime, 1> ActiveValue;
+
+#if EIGEN_HAS_VARIADIC_TEMPLATES
+    // Some compilers don't accept variadic parameters after a default parameter,
+    // i.e., we can't just write _jac=0 but we need to overload operator():
+    EIGEN_STRONG_INLINE
+    void operator()(const InputType &x, ValueType &v) const
+    {
+        this->operator()(x, v);
+    }
+
+    template <typename... ParamsType>
+    void operator()(const InputType &x, ValueType &v, const ParamsType &... Params) const
+    {
+        this->operator()(x, v, Params...);
+    }
+
+    template <typename... ParamsType>
+    void operator()(const InputType &x, ValueType &v, JacobianType &jac, const ParamsType &... Params) const
+    {
+        this->operator()(x, v, jac, nullptr, Params...);
+    }
+
+    template <typename... ParamsType>
+    void operator()(const InputType &x, ValueType &v, JacobianType &jac, const InputJacobianType &ijac,
+                    const ParamsType &... Params) const
+    {
+        this->operator()(x, v, jac, &ijac, Params...);
+    }
+
+    // Optional parameter InputJacobian (_ijac)
+    template <typename... ParamsType>
+    void operator()(const InputType &x, ValueType &v, JacobianType &jac, const InputJacobianType *_ijac = 0,
+                    const ParamsType &... Params) const
+#else
+    EIGEN_STRONG_INLINE
+    void operator()(const InputType &x, ValueType &v) const
+    {
+        this->operator()(x, v);
+    }
+
+    void operator()(const InputType &x, ValueType &v, JacobianType &jac) const
+    {
+        this->operator()(x, v, jac, nullptr);
+    }
+
+    void operator()(const InputType &x, ValueType &v, JacobianType &jac, const InputJacobianType &ijac) const
+    {
+        this->operator()(x, v, jac, &ijac);
+    }
+
+    void operator()(const InputType &x, ValueType &v, JacobianType &jac = 0, const InputJacobianType *_ijac = 0) const
+#endif
+    {
+        ActiveInput ax = x.template cast<ActiveScalar>();
+        ActiveValue av(jac.rows());
+
+        const Index cols = jac.cols();
+        eigen_assert(_ijac || x.rows() == cols);
+
+        // One pass per block of Lanes columns, at least one pass for the value
+        for (Index c = 0; c == 0 || c < cols; c += Lanes)
+        {
+            const Index width = std::min<Index>(Lanes, cols - c);
+            for (Index i = 0; i < x.rows(); ++i)
+            {
+                ax[i].derivatives().setZero();
+                if (!_ijac)
+                {
+                    if (i >= c && i < c + width) ax[i].derivatives()(i - c) = 1.0;
+                }
+                else
+                {
+                    // If specified, copy derivatives from InputJacobian
+                    ax[i].derivatives().head(width) = _ijac->row(i).segment(c, width).transpose();
+                }
+            }
+
+#if EIGEN_HAS_VARIADIC_TEMPLATES
+            Functor::operator()(ax, av, Params...);
+#else
+            Functor::operator()(ax, av);
+#endif
+            for (Index i = 0; i < jac.rows(); ++i)
+            {
+                v[i] = av[i].value();
+                jac.row(i).segment(c, width) = av[i].derivatives().head(width).transpose();
+            }
+        }
+    }
+};
+
+}  // namespace Eigen
+
+#endif  // EIGEN_AUTODIFF_CHAIN_JACOBIAN_LANES_H_
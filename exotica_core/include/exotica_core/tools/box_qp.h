@@ -31,7 +31,10 @@
 #define EXOTICA_CORE_BOX_QP_H_
 
 #include <exotica_core/tools/exception.h>
+#include <exotica_core/tools/profiler.h>
 #include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 namespace exotica
@@ -44,69 +47,314 @@ typedef struct BoxQPSolution
     std::vector<size_t> clamped_idx;
 } BoxQPSolution;
 
-inline BoxQPSolution BoxQP(const Eigen::MatrixXd& H, const Eigen::VectorXd& q, const Eigen::VectorXd& b_low, const Eigen::VectorXd& b_high, const Eigen::VectorXd& x_init, const double th_acceptstep, const int max_iterations, const double th_gradient_tolerance, const double lambda, bool use_polynomial_linesearch = true, bool use_cholesky_factorization = true)
+/// \brief Cholesky factor L of the regularised free Hessian H(free, free) + lambda I of BoxQP. When the free set changes by a single index, i.e.,
+/// a single bound becomes active or inactive, the factor is updated by inserting or deleting its row and column with a rank-one downdate or
+/// update in O(n^2) instead of being recomputed in O(n^3).
+class BoxQPCholesky
+{
+public:
+    explicit BoxQPCholesky(const std::size_t nx) : L_(nx, nx), w_(nx), l_(nx) { idx_.reserve(nx); }
+
+    /// \brief Invalidates the factor, e.g., before factorising a different H.
+    void Reset() { valid_ = false; }
+
+    /// \brief Updates the factor to the free set free_idx (in increasing order). Returns false if H(free, free) + lambda I is not positive definite.
+    bool Update(const Eigen::MatrixXd& H, const std::vector<size_t>& free_idx, const double lambda)
+    {
+        if (valid_ && free_idx == idx_) return true;
+        if (valid_ && free_idx.size() == idx_.size() + 1)
+        {
+            // A bound became inactive: insert the index missing from the factor
+            std::size_t p = 0;
+            while (p < idx_.size() && idx_[p] == free_idx[p]) ++p;
+            if (std::equal(idx_.begin() + p, idx_.end(), free_idx.begin() + p + 1) && Insert(H, p, free_idx[p], lambda)) return true;
+        }
+        else if (valid_ && free_idx.size() + 1 == idx_.size())
+        {
+            // A bound became active: delete the index missing from the free set
+            std::size_t p = 0;
+            while (p < free_idx.size() && idx_[p] == free_idx[p]) ++p;
+            if (std::equal(free_idx.begin() + p, free_idx.end(), idx_.begin() + p + 1))
+            {
+                Delete(p);
+                return true;
+            }
+        }
+        return Compute(H, free_idx, lambda);
+    }
+
+    /// \brief Solves (H(free, free) + lambda I) x = b in place.
+    template <typename Derived>
+    void SolveInPlace(Eigen::MatrixBase<Derived>& b) const
+    {
+        const Eigen::Index n = idx_.size();
+        L_.topLeftCorner(n, n).triangularView<Eigen::Lower>().solveInPlace(b);
+        L_.topLeftCorner(n, n).triangularView<Eigen::Lower>().transpose().solveInPlace(b);
+    }
+
+private:
+    // Full factorisation of H(free, free) + lambda I
+    bool Compute(const Eigen::MatrixXd& H, const std::vector<size_t>& free_idx, const double lambda)
+    {
+        const Eigen::Index n = free_idx.size();
+        idx_ = free_idx;
+        for (Eigen::Index j = 0; j < n; ++j)
+        {
+            for (Eigen::Index i = j; i < n; ++i)
+            {
+                L_(i, j) = H(free_idx[i], free_idx[j]);
+            }
+            L_(j, j) += lambda;
+        }
+        Eigen::Ref<Eigen::MatrixXd> Hff = L_.topLeftCorner(n, n);
+        Eigen::LLT<Eigen::Ref<Eigen::MatrixXd>> llt(Hff);  // In-place decomposition of the lower triangle
+        valid_ = (llt.info() == Eigen::Success);
+        return valid_;
+    }
+
+    // Inserts the free index f at position p of the factor
+    bool Insert(const Eigen::MatrixXd& H, const std::size_t p, const std::size_t f, const double lambda)
+    {
+        const Eigen::Index n = idx_.size(), m = n - p;
+        Eigen::Ref<Eigen::VectorXd> l12 = l_.head(p);
+        Eigen::Ref<Eigen::VectorXd> l32 = w_.head(m);
+        for (std::size_t i = 0; i < p; ++i) l12(i) = H(idx_[i], f);
+        for (Eigen::Index i = 0; i < m; ++i) l32(i) = H(idx_[p + i], f);
+        L_.topLeftCorner(p, p).triangularView<Eigen::Lower>().solveInPlace(l12);
+        const double d = H(f, f) + lambda - l12.squaredNorm();
+        if (!(d > 0.)) return false;
+        const double l22 = std::sqrt(d);
+        l32.noalias() -= L_.block(p, 0, m, p) * l12;
+        l32 /= l22;
+
+        // Shift the rows and columns after p to make room for the new row and column
+        for (Eigen::Index i = n - 1; i >= static_cast<Eigen::Index>(p); --i)
+        {
+            for (Eigen::Index j = 0; j < static_cast<Eigen::Index>(p); ++j) L_(i + 1, j) = L_(i, j);
+            for (Eigen::Index j = i; j >= static_cast<Eigen::Index>(p); --j) L_(i + 1, j + 1) = L_(i, j);
+        }
+        L_.row(p).head(p) = l12.transpose();
+        L_(p, p) = l22;
+        L_.col(p).segment(p + 1, m) = l32;
+        idx_.insert(idx_.begin() + p, f);
+
+        // L33 L33^T = L33_old L33_old^T - l32 l32^T
+        if (!RankOneUpdate(p + 1, l32, -1.))
+        {
+            valid_ = false;
+            return false;
+        }
+        return true;
+    }
+
+    // Deletes the row and column at position p of the factor
+    void Delete(const std::size_t p)
+    {
+        const Eigen::Index n = idx_.size(), m = n - p - 1;
+        // L33 L33^T = L33_old L33_old^T + l32 l32^T
+        w_.head(m) = L_.col(p).segment(p + 1, m);
+        RankOneUpdate(p + 1, w_.head(m), 1.);
+        for (Eigen::Index i = p + 1; i < n; ++i)
+        {
+            for (Eigen::Index j = 0; j < static_cast<Eigen::Index>(p); ++j) L_(i - 1, j) = L_(i, j);
+            for (Eigen::Index j = p + 1; j <= i; ++j) L_(i - 1, j - 1) = L_(i, j);
+        }
+        idx_.erase(idx_.begin() + p);
+    }
+
+    // Rank-one update (sigma = 1) or downdate (sigma = -1) of the trailing block of the factor starting at position p. Overwrites w.
+    bool RankOneUpdate(const Eigen::Index p, Eigen::Ref<Eigen::VectorXd> w, const double sigma)
+    {
+        const Eigen::Index m = w.size();
+        for (Eigen::Index k = 0; k < m; ++k)
+        {
+            const double lkk = L_(p + k, p + k);
+            const double r2 = lkk * lkk + sigma * w(k) * w(k);
+            if (!(r2 > 0.)) return false;
+            const double r = std::sqrt(r2);
+            const double c = r / lkk, s = w(k) / lkk;
+            L_(p + k, p + k) = r;
+            for (Eigen::Index i = k + 1; i < m; ++i)
+            {
+                L_(p + i, p + k) = (L_(p + i, p + k) + sigma * s * w(i)) / c;
+                w(i) = c * w(i) - s * L_(p + i, p + k);
+            }
+        }
+        return true;
+    }
+
+    Eigen::MatrixXd L_;         ///< Lower triangular factor in the top-left corner of the size of the free set
+    Eigen::VectorXd w_, l_;     ///< Workspace of the updates
+    std::vector<size_t> idx_;   ///< Free set of the factor
+    bool valid_ = false;
+};
+
+/// \brief Preallocated storage and result of BoxQP for QPs of the same dimension, e.g., the control-limited QPs of all time steps of a DDP
+/// backward pass. Solving with a workspace that has the size of the QP does not allocate.
+struct BoxQPWorkspace
+{
+    explicit BoxQPWorkspace(const std::size_t nx = 0) : llt(0) { Resize(nx); }
+
+    /// \brief Resizes the storage to QPs of dimension nx. Does nothing if the workspace already has this size.
+    void Resize(const std::size_t nx)
+    {
+        if (x.size() == static_cast<Eigen::Index>(nx)) return;
+        x.resize(nx);
+        Hff_inv.resize(nx, nx);
+        free_idx.reserve(nx);
+        clamped_idx.reserve(nx);
+        grad.resize(nx);
+        dx.resize(nx);
+        xnew.resize(nx);
+        Hx.resize(nx);
+        qf.resize(nx);
+        xf.resize(nx);
+        xc.resize(nx);
+        dxf.resize(nx);
+        Hff.resize(nx, nx);
+        Hfc.resize(nx, nx);
+        Hff_inv_free.resize(nx, nx);
+        llt = BoxQPCholesky(nx);
+    }
+
+    /// \brief Stores the solution of another solver of the box-constrained QP, e.g., ExoticaBoxQP.
+    void SetSolution(const BoxQPSolution& solution)
+    {
+        Resize(solution.x.size());
+        x = solution.x;
+        free_idx = solution.free_idx;
+        clamped_idx = solution.clamped_idx;
+        Hff_inv.setZero();
+        for (std::size_t i = 0; i < free_idx.size(); ++i)
+        {
+            for (std::size_t j = 0; j < free_idx.size(); ++j)
+            {
+                Hff_inv(free_idx[i], free_idx[j]) = solution.Hff_inv(i, j);
+            }
+        }
+    }
+
+    Eigen::VectorXd x;                ///< Solution
+    Eigen::MatrixXd Hff_inv;          ///< Inverse of the free Hessian at the free indices of the solution and zero elsewhere (nx x nx)
+    std::vector<size_t> free_idx;     ///< Free indices of the solution
+    std::vector<size_t> clamped_idx;  ///< Clamped indices of the solution
+
+    // Workspace of BoxQP, of which the leading blocks of the size of the free and clamped sets are used
+    Eigen::VectorXd grad, dx, xnew, Hx, qf, xf, xc, dxf;
+    Eigen::MatrixXd Hff, Hfc, Hff_inv_free;
+    BoxQPCholesky llt;
+};
+
+/// \brief Solves the box-constrained QP min 0.5 x^T H x + q^T x s.t. b_low <= x <= b_high with a projected Newton method starting from x_init
+/// (clamped to the bounds). Warm-starting from the solution of a similar QP, e.g., of the same time step in the previous DDP iteration, also
+/// warm-starts the active set. With use_cholesky_factorization, the factorisation of the free Hessian is updated incrementally when a single bound
+/// becomes active or inactive (see BoxQPCholesky). The solution is stored in workspace, which is resized to the QP if needed.
+inline void BoxQP(const Eigen::MatrixXd& H, const Eigen::VectorXd& q, const Eigen::VectorXd& b_low, const Eigen::VectorXd& b_high, const Eigen::VectorXd& x_init, const double th_acceptstep, const int max_iterations, const double th_gradient_tolerance, const double lambda, const bool use_polynomial_linesearch, const bool use_cholesky_factorization, BoxQPWorkspace& workspace)
 {
+    EXOTICA_PROFILE_SCOPE("BoxQP");
     if (lambda < 0.) ThrowPretty("lambda needs to be positive.");
+    if (max_iterations <= 0) ThrowPretty("max_iterations needs to be positive, given: " << max_iterations);
 
     // gamma = acceptance threshold
     // epsilon = gradient tolerance
     // lambda = regularization for Cholesky factorization
     const std::size_t nx = x_init.size();
+    workspace.Resize(nx);
+    workspace.llt.Reset();
 
-    Eigen::VectorXd delta_xf(nx), x = x_init;
-    std::vector<size_t> clamped_idx, free_idx;
-    Eigen::VectorXd grad(nx);
-    Eigen::MatrixXd Hff(nx, nx), Hfc(nx, nx);
-
-    std::vector<double> alphas_;
-    const std::size_t& n_alphas_ = 10;
-    alphas_.resize(n_alphas_);
-    const Eigen::VectorXd alphas_linear = Eigen::VectorXd::LinSpaced(n_alphas_, 1.0, 0.1);
-    for (std::size_t n = 0; n < n_alphas_; ++n)
+    constexpr std::size_t n_alphas = 10;
+    double alphas[n_alphas];
+    for (std::size_t n = 0; n < n_alphas; ++n)
     {
         if (use_polynomial_linesearch)
         {
-            alphas_[n] = 1. / pow(2., static_cast<double>(n));
+            alphas[n] = 1. / pow(2., static_cast<double>(n));
         }
         else
         {
-            alphas_[n] = alphas_linear(n);
+            alphas[n] = 1.0 - 0.1 * static_cast<double>(n);  // LinSpaced(n_alphas, 1.0, 0.1)
         }
     }
-    double fold_, fnew_;
+    double fold, fnew;
 
     // Ensure a feasible warm-start
-    for (int i = 0; i < x.size(); ++i)
+    Eigen::VectorXd& x = workspace.x;
+    for (std::size_t i = 0; i < nx; ++i)
     {
         x(i) = std::max(std::min(x_init(i), b_high(i)), b_low(i));
     }
 
-    BoxQPSolution solution;
-    solution.clamped_idx.reserve(nx);
-    solution.free_idx.reserve(nx);
-    std::size_t num_free, num_clamped;
-    Eigen::LLT<Eigen::MatrixXd> Hff_inv_llt_;
-    Eigen::VectorXd qf_, xf_, xc_, dxf_, dx_(nx);
+    std::vector<size_t>& free_idx = workspace.free_idx;
+    std::vector<size_t>& clamped_idx = workspace.clamped_idx;
+    std::size_t num_free = 0, num_clamped = 0;
+    Eigen::VectorXd &grad = workspace.grad, &dx = workspace.dx, &xnew = workspace.xnew, &Hx = workspace.Hx;
+
+    // Factorises (or inverts) the free Hessian of the current free set
+    auto factorize_free_hessian = [&](const int k) {
+        if (use_cholesky_factorization)
+        {
+            if (!workspace.llt.Update(H, free_idx, lambda))
+            {
+                ThrowPretty("Error during Cholesky decomposition of Hff (iter=" << k << "):\n"
+                                                                                << "H:\n"
+                                                                                << H << "\nnum_free: " << num_free << " num_clamped: " << num_clamped << " lambda: " << lambda);
+            }
+        }
+        else
+        {
+            for (std::size_t i = 0; i < num_free; ++i)
+            {
+                const std::size_t& fi = free_idx[i];
+                for (std::size_t j = 0; j < num_free; ++j)
+                {
+                    workspace.Hff(i, j) = H(fi, free_idx[j]);
+                }
+            }
+            if (lambda != 0.)
+            {
+                workspace.Hff.diagonal().head(num_free).array() += lambda;
+            }
+            workspace.Hff_inv_free.topLeftCorner(num_free, num_free) = workspace.Hff.topLeftCorner(num_free, num_free).inverse();
+        }
+    };
+
+    // Stores the inverse of the free Hessian of the current free set at the free indices of the solution
+    auto set_solution = [&]() {
+        auto Hff_inv_free = workspace.Hff_inv_free.topLeftCorner(num_free, num_free);
+        if (use_cholesky_factorization)
+        {
+            Hff_inv_free.setIdentity();
+            if (num_free != 0) workspace.llt.SolveInPlace(Hff_inv_free);
+        }
+        workspace.Hff_inv.setZero();
+        for (std::size_t i = 0; i < num_free; ++i)
+        {
+            for (std::size_t j = 0; j < num_free; ++j)
+            {
+                workspace.Hff_inv(free_idx[i], free_idx[j]) = Hff_inv_free(i, j);
+            }
+        }
+    };
 
     for (int k = 0; k < max_iterations; ++k)
     {
-        solution.clamped_idx.clear();
-        solution.free_idx.clear();
+        clamped_idx.clear();
+        free_idx.clear();
 
         // Compute the gradient
-        grad = q;
-        grad.noalias() += H * x;
+        Hx.noalias() = H * x;
+        grad = q + Hx;
 
         // Check if any element is at the limits
         for (std::size_t i = 0; i < nx; ++i)
         {
             if ((x(i) == b_low(i) && grad(i) > 0.) || (x(i) == b_high(i) && grad(i) < 0.))
-                solution.clamped_idx.push_back(i);
+                clamped_idx.push_back(i);
             else
-                solution.free_idx.push_back(i);
+                free_idx.push_back(i);
         }
-        num_free = solution.free_idx.size();
-        num_clamped = solution.clamped_idx.size();
+        num_free = free_idx.size();
+        num_clamped = clamped_idx.size();
 
         // Check convergence
         //  a) Either norm of gradient is below threshold
@@ -114,147 +362,105 @@ inline BoxQPSolution BoxQP(const Eigen::MatrixXd& H, const Eigen::VectorXd& q, c
         //  b) None of the dimensions is free (all are at boundary)
         if (grad.lpNorm<Eigen::Infinity>() <= th_gradient_tolerance || num_free == 0)
         {
-            // During first iteration return the inverse of the free Hessian
-            if (k == 0 && num_free != 0)
-            {
-                Hff.resize(num_free, num_free);
-                for (std::size_t i = 0; i < num_free; ++i)
-                {
-                    const std::size_t& fi = solution.free_idx[i];
-                    for (std::size_t j = 0; j < num_free; ++j)
-                    {
-                        Hff(i, j) = H(fi, solution.free_idx[j]);
-                    }
-                }
-                // Add regularization
-                if (lambda != 0.)
-                {
-                    Hff.diagonal().array() += lambda;
-                }
-
-                // Compute the inverse
-                if (use_cholesky_factorization)
-                {
-                    Hff_inv_llt_.compute(Hff);
-                    const Eigen::ComputationInfo& info = Hff_inv_llt_.info();
-                    if (info != Eigen::Success)
-                    {
-                        ThrowPretty("Error during Cholesky decomposition of Hff");
-                    }
-                    solution.Hff_inv.setIdentity(num_free, num_free);
-                    Hff_inv_llt_.solveInPlace(solution.Hff_inv);
-                }
-                else
-                {
-                    solution.Hff_inv = Hff.inverse();
-                }
-            }
-
-            if (num_free == 0)
+            // Return the inverse of the free Hessian of the free set of the solution
+            if (num_free != 0)
             {
-                solution.Hff_inv.resize(num_free, num_free);
+                factorize_free_hessian(k);
             }
 
             // Set solution
-            solution.x = x;
-            return solution;
+            set_solution();
+            return;
         }
 
         // Compute the search direction as Newton step along the free space
-        qf_.resize(num_free);
-        xf_.resize(num_free);
-        xc_.resize(num_clamped);
-        dxf_.resize(num_free);
-        Hff.resize(num_free, num_free);
-        Hfc.resize(num_free, num_clamped);
+        Eigen::Ref<Eigen::VectorXd> qf = workspace.qf.head(num_free), xf = workspace.xf.head(num_free), xc = workspace.xc.head(num_clamped), dxf = workspace.dxf.head(num_free);
+        Eigen::Ref<Eigen::MatrixXd> Hfc = workspace.Hfc.topLeftCorner(num_free, num_clamped);
         for (std::size_t i = 0; i < num_free; ++i)
         {
-            const std::size_t& fi = solution.free_idx[i];
-            qf_(i) = q(fi);
-            xf_(i) = x(fi);
-            for (std::size_t j = 0; j < num_free; ++j)
-            {
-                Hff(i, j) = H(fi, solution.free_idx[j]);
-            }
+            const std::size_t& fi = free_idx[i];
+            qf(i) = q(fi);
+            xf(i) = x(fi);
             for (std::size_t j = 0; j < num_clamped; ++j)
             {
-                const std::size_t cj = solution.clamped_idx[j];
-                xc_(j) = x(cj);
+                const std::size_t cj = clamped_idx[j];
+                xc(j) = x(cj);
                 Hfc(i, j) = H(fi, cj);
             }
         }
-        if (lambda != 0.)
-        {
-            Hff.diagonal().array() += lambda;
-        }
-
-        // Compute the inverse
-        if (use_cholesky_factorization)
-        {
-            Hff_inv_llt_.compute(Hff);
-            const Eigen::ComputationInfo& info = Hff_inv_llt_.info();
-            if (info != Eigen::Success)
-            {
-                ThrowPretty("Error during Cholesky decomposition of Hff (iter=" << k << "):\n"
-                                                                                << Hff << "\n"
-                                                                                << "H:\n"
-                                                                                << H << "\nnum_free: " << num_free << " num_clamped: " << num_clamped << " lambda: " << lambda);
-            }
-            solution.Hff_inv.setIdentity(num_free, num_free);
-            Hff_inv_llt_.solveInPlace(solution.Hff_inv);
-        }
-        else
-        {
-            solution.Hff_inv = Hff.inverse();
-        }
+        factorize_free_hessian(k);
 
-        dxf_ = -qf_;
+        dxf = -qf;
         if (num_clamped != 0)
         {
-            dxf_.noalias() -= Hfc * xc_;
+            dxf.noalias() -= Hfc * xc;
         }
         if (use_cholesky_factorization)
         {
-            Hff_inv_llt_.solveInPlace(dxf_);
+            workspace.llt.SolveInPlace(dxf);
         }
         else
         {
-            dxf_ = solution.Hff_inv * dxf_;
+            // Use xnew as temporary, it is overwritten by the line search
+            xnew.head(num_free).noalias() = workspace.Hff_inv_free.topLeftCorner(num_free, num_free) * dxf;
+            dxf = xnew.head(num_free);
         }
-        dxf_ -= xf_;
-        dx_.setZero();
+        dxf -= xf;
+        dx.setZero();
         for (std::size_t i = 0; i < num_free; ++i)
         {
-            dx_(solution.free_idx[i]) = dxf_(i);
+            dx(free_idx[i]) = dxf(i);
         }
 
         // Try different step lengths
-        Eigen::VectorXd xnew_(nx);
-        fold_ = 0.5 * x.dot(H * x) + q.dot(x);
-        for (std::vector<double>::const_iterator it = alphas_.begin(); it != alphas_.end(); ++it)
+        fold = 0.5 * x.dot(Hx) + q.dot(x);
+        for (std::size_t n = 0; n < n_alphas; ++n)
         {
-            double steplength = *it;
+            const double steplength = alphas[n];
             for (std::size_t i = 0; i < nx; ++i)
             {
-                xnew_(i) = std::max(std::min(x(i) + steplength * dx_(i), b_high(i)), b_low(i));
+                xnew(i) = std::max(std::min(x(i) + steplength * dx(i), b_high(i)), b_low(i));
             }
-            fnew_ = 0.5 * xnew_.dot(H * xnew_) + q.dot(xnew_);
-            if (fold_ - fnew_ > th_acceptstep * grad.dot(x - xnew_))
+            Hx.noalias() = H * xnew;
+            fnew = 0.5 * xnew.dot(Hx) + q.dot(xnew);
+            if (fold - fnew > th_acceptstep * grad.dot(x - xnew))
             {
-                x = xnew_;
+                x = xnew;
                 break;
             }
 
             // If line-search fails, return.
-            if (it == alphas_.end() - 1)
+            if (n == n_alphas - 1)
             {
-                solution.x = x;
-                return solution;
+                set_solution();
+                return;
             }
         }
     }
 
-    solution.x = x;
+    set_solution();
+}
+
+/// \brief Solves the box-constrained QP with a temporary workspace (see BoxQP with a BoxQPWorkspace). Hff_inv of the solution is the inverse of
+/// the free Hessian of the free set of the solution.
+inline BoxQPSolution BoxQP(const Eigen::MatrixXd& H, const Eigen::VectorXd& q, const Eigen::VectorXd& b_low, const Eigen::VectorXd& b_high, const Eigen::VectorXd& x_init, const double th_acceptstep, const int max_iterations, const double th_gradient_tolerance, const double lambda, bool use_polynomial_linesearch = true, bool use_cholesky_factorization = true)
+{
+    BoxQPWorkspace workspace(x_init.size());
+    BoxQP(H, q, b_low, b_high, x_init, th_acceptstep, max_iterations, th_gradient_tolerance, lambda, use_polynomial_linesearch, use_cholesky_factorization, workspace);
+
+    BoxQPSolution solution;
+    solution.x = workspace.x;
+    solution.free_idx = workspace.free_idx;
+    solution.clamped_idx = workspace.clamped_idx;
+    const std::size_t num_free = solution.free_idx.size();
+    solution.Hff_inv.resize(num_free, num_free);
+    for (std::size_t i = 0; i < num_free; ++i)
+    {
+        for (std::size_t j = 0; j < num_free; ++j)
+        {
+            solution.Hff_inv(i, j) = workspace.Hff_inv(solution.free_idx[i], solution.free_idx[j]);
+        }
+    }
     return solution;
 }
 
@@ -53,6 +53,8 @@ typedef const Eigen::Ref<const Eigen::VectorXd>& VectorXdRefConst;
 typedef const Eigen::Ref<const Eigen::MatrixXd>& MatrixXdRefConst;
 typedef typename Eigen::Ref<Eigen::VectorXd> VectorXdRef;
 typedef typename Eigen::Ref<Eigen::MatrixXd> MatrixXdRef;
+typedef const Eigen::Ref<const Eigen::MatrixXf>& MatrixXfRefConst;
+typedef typename Eigen::Ref<Eigen::MatrixXf> MatrixXfRef;
 
 Eigen::VectorXd VectorTransform(double px = 0.0, double py = 0.0, double pz = 0.0, double qx = 0.0, double qy = 0.0, double qz = 0.0, double qw = 1.0);
 Eigen::VectorXd IdentityTransform();
@@ -256,35 +258,35 @@ inline int ToNumber<int>(const std::string& val)
 }
 
 template <typename T, const int S>  // Eigen::Vector<S><T>
-inline Eigen::Matrix<T, S, 1> ParseVector(const std::string value)
+inline Eigen::Matrix<T, S, 1> ParseVector(const std::string& value)
 {
-    Eigen::Matrix<T, S, 1> ret;
+    // Entries are collected first to avoid resizing the Eigen vector for every entry
+    std::vector<T> entries;
     std::string temp_entry;
-    int i = 0;
 
     std::istringstream text_parser(value);
 
     while (text_parser >> temp_entry)
     {
-        ret.conservativeResize(++i);
         try
         {
-            ret[i - 1] = ToNumber<T>(temp_entry);
+            entries.push_back(ToNumber<T>(temp_entry));
         }
         catch (const std::invalid_argument& /* e */)
         {
-            ret[i - 1] = std::numeric_limits<T>::quiet_NaN();
+            entries.push_back(std::numeric_limits<T>::quiet_NaN());
         }
     }
+    const int i = static_cast<int>(entries.size());
     if (i == 0) WARNING_NAMED("Parser", "Empty vector!")
     if (S != Eigen::Dynamic && S != i)
     {
         ThrowPretty("Wrong vector size! Requested: " + std::to_string(S) + ", Provided: " + std::to_string(i));
     }
-    return ret;
+    return Eigen::Map<const Eigen::Matrix<T, S, 1>>(entries.data(), i);
 }
 
-inline bool ParseBool(const std::string value)
+inline bool ParseBool(const std::string& value)
 {
     bool ret;
     std::istringstream text_parser(value);
@@ -292,7 +294,7 @@ inline bool ParseBool(const std::string value)
     return ret;
 }
 
-inline double ParseDouble(const std::string value)
+inline double ParseDouble(const std::string& value)
 {
     double ret;
     std::istringstream text_parser(value);
@@ -305,7 +307,7 @@ inline double ParseDouble(const std::string value)
     return ret;
 }
 
-inline int ParseInt(const std::string value)
+inline int ParseInt(const std::string& value)
 {
     int ret;
     std::istringstream text_parser(value);
@@ -331,7 +333,7 @@ inline std::vector<std::string> ParseList(const std::string& value, char token =
     return ret;
 }
 
-inline std::vector<int> ParseIntList(const std::string value)
+inline std::vector<int> ParseIntList(const std::string& value)
 {
     std::stringstream ss(value);
     std::string item;
@@ -351,7 +353,7 @@ inline std::vector<int> ParseIntList(const std::string value)
     return ret;
 }
 
-inline std::vector<bool> ParseBoolList(const std::string value)
+inline std::vector<bool> ParseBoolList(const std::string& value)
 {
     std::stringstream ss(value);
     std::string item;
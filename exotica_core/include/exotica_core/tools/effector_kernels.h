@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_TOOLS_EFFECTOR_KERNELS_H_
+#define EXOTICA_CORE_TOOLS_EFFECTOR_KERNELS_H_
+
+#include <exotica_core/kinematic_tree.h>
+
+/// Kernels evaluating all frames of a KinematicSolution in one pass instead of one KDL::Frame/KDL::Jacobian at a time.
+/// The Jacobian kernels run over contiguous memory when the problem requests packed kinematics (PackedKinematics, KIN_PACKED)
+/// and fall back to one block copy per frame otherwise.
+
+namespace exotica
+{
+typedef Eigen::Map<const Eigen::Matrix3Xd, 0, Eigen::OuterStride<>> FramePositionsMap;
+
+/// @brief Positions of all frames of a kinematic solution as a 3 x n matrix, without copying.
+/// Maps the packed positions if available, otherwise strides over the KDL frames.
+inline FramePositionsMap GetFramePositions(const KinematicSolution& solution)
+{
+    const int n = solution.Phi.rows();
+    if (n == 0) return FramePositionsMap(nullptr, 3, 0, Eigen::OuterStride<>(3));
+    if (solution.Phi_position.cols() == n) return FramePositionsMap(solution.Phi_position.data(), 3, n, Eigen::OuterStride<>(3));
+    static_assert(sizeof(KDL::Frame) % sizeof(double) == 0, "KDL::Frame is expected to be an array of doubles");
+    return FramePositionsMap(solution.Phi(0).p.data, 3, n, Eigen::OuterStride<>(sizeof(KDL::Frame) / sizeof(double)));
+}
+
+/// @brief Stacks the top Rows rows of the Jacobians of all frames, scaled by scale, into out:
+///        out.middleRows<Rows>(row_offset + Rows * i) = scale * jacobian(i).data.topRows<Rows>()
+/// With packed kinematics, each column of out is written in a single pass over the packed Jacobians.
+template <int Rows>
+inline void StackFrameJacobians(const KinematicSolution& solution, Eigen::MatrixXdRef out, const int row_offset = 0, const double scale = 1.0)
+{
+    static_assert(Rows > 0 && Rows <= 6, "A frame Jacobian has six rows");
+    const int n = solution.jacobian.rows();
+    if (n == 0) return;
+    const int N = solution.jacobian(0).data.cols();
+    if (solution.jacobian_packed.cols() == N * n)
+    {
+        typedef Eigen::Map<const Eigen::Matrix<double, Rows, Eigen::Dynamic>, 0, Eigen::OuterStride<>> PackedColumnMap;
+        for (int j = 0; j < N; ++j)
+        {
+            Eigen::Map<Eigen::Matrix<double, Rows, Eigen::Dynamic>>(out.col(j).data() + row_offset, Rows, n) = scale * PackedColumnMap(solution.jacobian_packed.data() + 6 * j, Rows, n, Eigen::OuterStride<>(6 * N));
+        }
+    }
+    else
+    {
+        for (int i = 0; i < n; ++i) out.middleRows<Rows>(row_offset + Rows * i) = scale * solution.jacobian(i).data.topRows<Rows>();
+    }
+}
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_TOOLS_EFFECTOR_KERNELS_H_
@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_EXPERIENCE_STORE_H_
+#define EXOTICA_CORE_EXPERIENCE_STORE_H_
+
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <exotica_core/planning_problem.h>
+#include <exotica_core/scene.h>
+
+namespace exotica
+{
+/// \brief Solution of a previous planning query.
+struct Experience
+{
+    std::string problem_type;
+    std::size_t scene_hash = 0;  ///< See ExperienceStore::HashScene
+    Eigen::VectorXd start;
+    Eigen::VectorXd goal;      ///< Targets of the query, e.g., the goal state or the concatenated task goals
+    Eigen::MatrixXd solution;  ///< As returned by MotionSolver::Solve
+    double cost = std::numeric_limits<double>::infinity();
+};
+
+/// \brief Stores the solutions of planning queries and retrieves the nearest ones to warm start similar queries.
+///
+/// Experiences are keyed by the problem type, the hash of the world in the scene and the sizes of start, goal and solution. Among
+/// the experiences with the same key, the distance of a query is ||start - experience.start||^2 + goal_weight * ||goal - experience.goal||^2.
+/// The oldest experiences are dropped once the capacity is reached. All methods are thread-safe.
+class ExperienceStore
+{
+public:
+    explicit ExperienceStore(std::size_t capacity = 1000, double goal_weight = 1.0);
+
+    void Add(const Experience& experience);
+
+    /// \brief Stores the solution of the current query of the problem (its type, scene and start state) for the given goal.
+    void Add(const PlanningProblemPtr& problem, Eigen::VectorXdRefConst goal, Eigen::MatrixXdRefConst solution, double cost);
+
+    /// \brief Returns up to k experiences with the same key nearest to start and goal (nearest first) within max_distance.
+    std::vector<Experience> FindNearest(const std::string& problem_type, std::size_t scene_hash, Eigen::VectorXdRefConst start, Eigen::VectorXdRefConst goal, std::size_t k = 1, double max_distance = std::numeric_limits<double>::infinity()) const;
+
+    /// \brief Seeds the problem with the best of the k nearest experiences of its current query.
+    ///
+    /// The stored trajectories of time-indexed and sampling problems are resampled to the horizon of the problem (if it has one) and
+    /// repaired by blending them into the current start state (and the goal state, for sampling problems). The candidates are then
+    /// revalidated with the batch validity checks of the problem or the scene and the valid one with the lowest cost is used. If none is
+    /// valid, optimisation problems are seeded with the nearest candidate, as the solver repairs it, while sampling problems are not seeded.
+    ///  - Time-indexed problems: sets the initial trajectory.
+    ///  - Dynamic shooting problems: sets the control trajectory (the solution of the DDP solvers).
+    ///  - End-pose problems: sets the start state, i.e. the initial guess of the solvers.
+    ///  - Sampling problems: nothing is set, the returned seed is a valid path which can be used instead of solving.
+    /// @param seed The seed used, in the layout of the solutions
+    /// @return Whether a seed was found
+    bool WarmStart(const PlanningProblemPtr& problem, Eigen::VectorXdRefConst goal, Eigen::MatrixXd& seed, std::size_t k = 5, double max_distance = std::numeric_limits<double>::infinity()) const;
+
+    std::size_t Size() const;
+    void Clear();
+
+    std::size_t GetCapacity() const { return capacity_; }
+    void SetCapacity(std::size_t capacity);
+
+    /// \brief Hashes the names, shapes and poses of the links of the scene that are not robot links (world objects), i.e. the environment an experience was planned in.
+    /// Poses are rounded to 0.1 mm and 0.001 (rotation matrix entries) so that re-adding an object at the same place gives the same hash.
+    static std::size_t HashScene(const ScenePtr& scene);
+
+    /// \brief Linearly interpolates the rows of the trajectory to the given number of rows.
+    static Eigen::MatrixXd ResampleTrajectory(Eigen::MatrixXdRefConst trajectory, int rows);
+
+private:
+    std::size_t capacity_;
+    double goal_weight_;
+    mutable std::mutex mutex_;
+    std::deque<Experience> experiences_;  ///< Oldest first
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_EXPERIENCE_STORE_H_
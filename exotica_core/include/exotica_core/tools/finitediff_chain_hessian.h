@@ -11,10 +11,12 @@
 #define EIGEN_FINITEDIFF_CHAIN_HESSIAN_H_
 
 #include <functional>
+#include <vector>
 
 #include <exotica_core/tools/finitediff_chain_jacobian.h>
 #include <exotica_core/tools/finitediff_common.h>
 #include <exotica_core/tools/functor.h>
+#include <exotica_core/tools/parallel_loop.h>
 
 namespace Eigen
 {
@@ -42,6 +44,22 @@ public:
 
     UpdateFunctionCallbackType update_ = [](const InputJacobianRowType &jx, InputType &x) { x = jx; };
     Scalar epsfcn_;
+    SparsityPatternType sparsity_pattern_;         ///< Non-zero structure of the Jacobian, empty if dense
+    std::vector<std::vector<int>> column_groups_;  ///< Structurally orthogonal columns of sparsity_pattern_
+    int num_threads_ = 1;                          ///< Number of threads evaluating the column groups
+
+    /// \brief Sets the sparsity pattern (values x Jacobian columns) of the Jacobian, see FiniteDiffChainJacobian. Row j of
+    /// the Hessian of value i can only be non-zero where column j of the Jacobian is, so the same column groups are
+    /// perturbed together for the Jacobians and the Hessians. An empty pattern restores the dense evaluation.
+    void SetSparsityPattern(const SparsityPatternType &pattern)
+    {
+        sparsity_pattern_ = pattern;
+        column_groups_ = ColorJacobianColumns(pattern);
+    }
+
+    /// \brief Sets the number of threads evaluating the column groups of the sparse mode in parallel. The functor and the
+    /// update callback need to be thread-safe to use more than one thread.
+    void SetNumThreads(const int num_threads) { num_threads_ = num_threads; }
 
     FiniteDiffChainHessian(Scalar epsfcn = 0.) : Functor(), epsfcn_(epsfcn) {}
     FiniteDiffChainHessian(const Functor &f, Scalar epsfcn = 0.) : Functor(f), epsfcn_(epsfcn) {}
@@ -109,6 +127,9 @@ public:
     int operator()(const InputJacobianRowType &_jx, ValueType &v, JacobianType &jac, const ParamsType &... Params) const
     {
         FiniteDiffChainJacobian<Functor, mode> autoj(*static_cast<const Functor *>(this), update_, epsfcn_);
+        autoj.sparsity_pattern_ = sparsity_pattern_;
+        autoj.column_groups_ = column_groups_;
+        autoj.num_threads_ = num_threads_;
         return autoj(_jx, v, jac, Params...);
     }
 
@@ -127,6 +148,9 @@ public:
     int operator()(const InputJacobianRowType &_jx, ValueType &v, JacobianType &jac) const
     {
         FiniteDiffChainJacobian<Functor, mode> autoj(*static_cast<const Functor *>(this), update_, epsfcn_);
+        autoj.sparsity_pattern_ = sparsity_pattern_;
+        autoj.column_groups_ = column_groups_;
+        autoj.num_threads_ = num_threads_;
         return autoj(_jx, v, jac);
     }
 
@@ -137,6 +161,8 @@ public:
         using std::sqrt;
         // Local variables
         FiniteDiffChainJacobian<Functor, mode> autoj(*static_cast<const Functor *>(this), update_, epsfcn_);
+        autoj.sparsity_pattern_ = sparsity_pattern_;
+        autoj.column_groups_ = column_groups_;
         Scalar h;
         int nfev = 0;
         const typename InputJacobianRowType::Index n = _jx.size();
@@ -175,6 +201,61 @@ public:
                 eigen_assert(false);
         };
 
+        // Sparse mode: perturb all columns of a group at once, the Jacobian row of a value changes with at most one of them
+        if (!column_groups_.empty())
+        {
+            InputJacobianRowType step(n);
+            for (int j = 0; j < n; ++j)
+            {
+                step[j] = eps * abs(jx[j]);
+                if (step[j] == 0.) step[j] = eps;
+                step[j] = sqrt(sqrt(step[j]));
+            }
+            for (Index l = 0; l < m; ++l) hess[l].setZero();
+
+            const int num_groups = static_cast<int>(column_groups_.size());
+            // The counts of the groups are summed afterwards, as the groups are evaluated concurrently
+            std::vector<int> group_nfev(num_groups, 0);
+            exotica::ParallelLoop(num_groups > 1 ? num_threads_ : 1, num_groups, [&](int, int g) {
+                const std::vector<int> &group = column_groups_[g];
+                InputJacobianRowType jx_g = _jx;
+                ValueType v_g = v;
+                JacobianType jac1_g(jac.rows(), jac.cols()), jac2_g(jac.rows(), jac.cols());
+
+                for (const int j : group) jx_g[j] += step[j];
+#if EIGEN_HAS_VARIADIC_TEMPLATES
+                group_nfev[g] += autoj(jx_g, v_g, jac2_g, Params...);
+#else
+                group_nfev[g] += autoj(jx_g, v_g, jac2_g);
+#endif
+                if (mode == Central)
+                {
+                    for (const int j : group) jx_g[j] -= 2 * step[j];
+#if EIGEN_HAS_VARIADIC_TEMPLATES
+                    group_nfev[g] += autoj(jx_g, v_g, jac1_g, Params...);
+#else
+                    group_nfev[g] += autoj(jx_g, v_g, jac1_g);
+#endif
+                }
+                const JacobianType &jac_low = (mode == Central) ? jac1_g : jac1;
+                const Scalar scale = (mode == Central) ? 2 : 1;
+
+                for (const int j : group)
+                {
+                    for (Index l = 0; l < m; ++l)
+                    {
+                        if (!sparsity_pattern_(l, j)) continue;
+                        if (mode == Central)
+                            hess[l].col(j) = (jac2_g.row(l) - jac_low.row(l)).transpose() / (scale * step[j]);
+                        else
+                            hess[l].row(j) = (jac2_g.row(l) - jac_low.row(l)) / (scale * step[j]);
+                    }
+                }
+            });
+            for (const int group_evaluations : group_nfev) nfev += group_evaluations;
+            return nfev;
+        }
+
         // Function Body
         for (int j = 0; j < n; ++j)
         {
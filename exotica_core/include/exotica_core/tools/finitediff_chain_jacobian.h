@@ -11,9 +11,11 @@
 #define EIGEN_FINITEDIFF_CHAIN_JACOBIAN_H_
 
 #include <functional>
+#include <vector>
 
 #include <exotica_core/tools/finitediff_common.h>
 #include <exotica_core/tools/functor.h>
+#include <exotica_core/tools/parallel_loop.h>
 
 namespace Eigen
 {
@@ -40,6 +42,22 @@ public:
 
     UpdateFunctionCallbackType update_ = [](const InputJacobianRowType &jx, InputType &x) { x = jx; };
     Scalar epsfcn_;
+    SparsityPatternType sparsity_pattern_;         ///< Non-zero structure of the Jacobian, empty if dense
+    std::vector<std::vector<int>> column_groups_;  ///< Structurally orthogonal columns of sparsity_pattern_
+    int num_threads_ = 1;                          ///< Number of threads evaluating the column groups
+
+    /// \brief Sets the sparsity pattern (values x Jacobian columns) of the Jacobian. The columns are then grouped by
+    /// colouring and all columns of a group are perturbed in one evaluation, i.e., the Jacobian costs one (Forward) or
+    /// two (Central) evaluations per group instead of per column. An empty pattern restores the dense evaluation.
+    void SetSparsityPattern(const SparsityPatternType &pattern)
+    {
+        sparsity_pattern_ = pattern;
+        column_groups_ = ColorJacobianColumns(pattern);
+    }
+
+    /// \brief Sets the number of threads evaluating the column groups of the sparse mode in parallel. The functor and the
+    /// update callback need to be thread-safe to use more than one thread.
+    void SetNumThreads(const int num_threads) { num_threads_ = num_threads; }
 
     FiniteDiffChainJacobian(Scalar epsfcn = 0.) : Functor(), epsfcn_(epsfcn) {}
     FiniteDiffChainJacobian(const Functor &f, Scalar epsfcn = 0.) : Functor(f), epsfcn_(epsfcn) {}
@@ -157,6 +175,66 @@ public:
                 eigen_assert(false);
         };
 
+        // Sparse mode: perturb all columns of a group at once and assign the differences to the non-zero rows
+        if (!column_groups_.empty())
+        {
+            eigen_assert(sparsity_pattern_.rows() == v.rows() && sparsity_pattern_.cols() == n);
+            InputJacobianRowType step(n);
+            for (int j = 0; j < n; ++j)
+            {
+                step[j] = eps * abs(jx[j]);
+                if (step[j] == 0.) step[j] = eps;
+            }
+            jac.setZero();
+
+            const int num_groups = static_cast<int>(column_groups_.size());
+            // The counts of the groups are summed afterwards, as the groups are evaluated concurrently
+            std::vector<int> group_nfev(num_groups, 0);
+            exotica::ParallelLoop(num_groups > 1 ? num_threads_ : 1, num_groups, [&](int, int g) {
+                const std::vector<int> &group = column_groups_[g];
+                InputJacobianRowType jx_g = _jx;
+                InputType x_g;
+                ValueType val1_g, val2_g;
+                if (ValuesAtCompileTime == Dynamic)
+                {
+                    val1_g.resize(v.rows());
+                    val2_g.resize(v.rows());
+                }
+
+                for (const int j : group) jx_g[j] += step[j];
+                update_(jx_g, x_g);
+#if EIGEN_HAS_VARIADIC_TEMPLATES
+                Functor::operator()(x_g, val2_g, Params...);
+#else
+                Functor::operator()(x_g, val2_g);
+#endif
+                ++group_nfev[g];
+                if (mode == Central)
+                {
+                    for (const int j : group) jx_g[j] -= 2 * step[j];
+                    update_(jx_g, x_g);
+#if EIGEN_HAS_VARIADIC_TEMPLATES
+                    Functor::operator()(x_g, val1_g, Params...);
+#else
+                    Functor::operator()(x_g, val1_g);
+#endif
+                    ++group_nfev[g];
+                }
+                const ValueType &val_low = (mode == Central) ? val1_g : val1;
+                const Scalar scale = (mode == Central) ? 2 : 1;
+
+                for (const int j : group)
+                {
+                    for (Index i = 0; i < v.rows(); ++i)
+                    {
+                        if (sparsity_pattern_(i, j)) jac(i, j) = (val2_g[i] - val_low[i]) / (scale * step[j]);
+                    }
+                }
+            });
+            for (const int group_evaluations : group_nfev) nfev += group_evaluations;
+            return nfev;
+        }
+
         // Function Body
         for (int j = 0; j < n; ++j)
         {
@@ -30,6 +30,9 @@
 #ifndef EIGEN_FINITEDIFF_COMMON_H_
 #define EIGEN_FINITEDIFF_COMMON_H_
 
+#include <Eigen/Core>
+#include <vector>
+
 namespace Eigen
 {
 enum NumericalDiffMode
@@ -37,6 +40,32 @@ enum NumericalDiffMode
     Forward,
     Central
 };
+
+/// \brief Sparsity pattern of a Jacobian (values x inputs), true where an entry may be non-zero.
+typedef Matrix<bool, Dynamic, Dynamic> SparsityPatternType;
+
+/// \brief Partitions the columns of a Jacobian with the given sparsity pattern into groups of structurally orthogonal
+/// columns, i.e., of columns without a common non-zero row (greedy Curtis-Powell-Reid colouring). The columns of a group
+/// can be perturbed together in a single function evaluation.
+inline std::vector<std::vector<int>> ColorJacobianColumns(const SparsityPatternType &pattern)
+{
+    std::vector<std::vector<int>> groups;
+    SparsityPatternType rows_in_group(pattern.rows(), 0);
+    for (int j = 0; j < pattern.cols(); ++j)
+    {
+        std::size_t g = 0;
+        while (g < groups.size() && (rows_in_group.col(g).array() && pattern.col(j).array()).any()) ++g;
+        if (g == groups.size())
+        {
+            groups.emplace_back();
+            rows_in_group.conservativeResize(NoChange, g + 1);
+            rows_in_group.col(g).setConstant(false);
+        }
+        groups[g].push_back(j);
+        rows_in_group.col(g) = rows_in_group.col(g).array() || pattern.col(j).array();
+    }
+    return groups;
 }
+}  // namespace Eigen
 
 #endif  // EIGEN_FINITEDIFF_COMMON_H_
@@ -0,0 +1,232 @@
+//
+// Copyright (c) 2020, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_TOOLS_FLOATING_BASE_H_
+#define EXOTICA_CORE_TOOLS_FLOATING_BASE_H_
+
+#include <cmath>
+
+#include <Eigen/Dense>
+
+#include <exotica_core/tools.h>
+
+/// Lie group operations on SE(3) x R^n configurations q = [position (3), quaternion (x, y, z, w), joints (n)] with tangent
+/// vectors dq = [linear velocity (3), angular velocity (3), joints (n)], where the twist of the floating base is expressed
+/// in the local frame (as for the free-flyer joint of Pinocchio): q (+) dq = q * exp(dq), q_1 (-) q_2 = log(q_2^-1 * q_1).
+/// The base block uses fixed-size types and closed-form Jacobians, and the functions write into their arguments.
+namespace exotica
+{
+namespace floating_base
+{
+typedef Eigen::Matrix<double, 6, 1> Vector6d;
+typedef Eigen::Matrix<double, 6, 6> Matrix6d;
+
+inline Eigen::Matrix3d Skew(const Eigen::Vector3d& w)
+{
+    Eigen::Matrix3d S;
+    S << 0.0, -w(2), w(1),
+        w(2), 0.0, -w(0),
+        -w(1), w(0), 0.0;
+    return S;
+}
+
+/// \brief Coefficients of the series in the SO(3) and SE(3) exponential maps, with Taylor expansions for small angles.
+struct ExpCoefficients
+{
+    explicit ExpCoefficients(double theta)
+    {
+        const double theta2 = theta * theta, theta4 = theta2 * theta2;
+        // The closed forms of d, e and f cancel catastrophically well above the machine precision
+        if (theta < 1e-2)
+        {
+            a = 1.0 - theta2 / 6.0 + theta4 / 120.0;                // sin(theta) / theta
+            b = 0.5 - theta2 / 24.0 + theta4 / 720.0;               // (1 - cos(theta)) / theta^2
+            c = 1.0 / 6.0 - theta2 / 120.0 + theta4 / 5040.0;       // (theta - sin(theta)) / theta^3
+            d = 1.0 / 12.0 + theta2 / 720.0 + theta4 / 30240.0;     // (1 - a / (2 b)) / theta^2
+            e = 1.0 / 24.0 - theta2 / 720.0 + theta4 / 40320.0;     // (theta^2 + 2 cos(theta) - 2) / (2 theta^4)
+            f = 1.0 / 120.0 - theta2 / 2520.0 + theta4 / 120960.0;  // (2 theta - 3 sin(theta) + theta cos(theta)) / (2 theta^5)
+        }
+        else
+        {
+            const double s = std::sin(theta), co = std::cos(theta);
+            a = s / theta;
+            b = (1.0 - co) / theta2;
+            c = (theta - s) / (theta2 * theta);
+            d = (1.0 - a / (2.0 * b)) / theta2;
+            e = (theta2 + 2.0 * co - 2.0) / (2.0 * theta4);
+            f = (2.0 * theta - 3.0 * s + theta * co) / (2.0 * theta4 * theta);
+        }
+    }
+
+    double a, b, c, d, e, f;
+};
+
+/// \brief Exponential map of SO(3).
+inline Eigen::Matrix3d ExpSO3(const Eigen::Vector3d& w)
+{
+    const ExpCoefficients k(w.norm());
+    const Eigen::Matrix3d W = Skew(w);
+    return Eigen::Matrix3d::Identity() + k.a * W + k.b * W * W;
+}
+
+/// \brief Logarithm of SO(3), the angle is within [0, pi].
+inline Eigen::Vector3d LogSO3(const Eigen::Matrix3d& R)
+{
+    const Eigen::AngleAxisd angle_axis(R);
+    return angle_axis.angle() * angle_axis.axis();
+}
+
+/// \brief d log(R exp(dw)) / d dw at dw = 0, i.e., the inverse of the right Jacobian of SO(3) at w = log(R).
+inline Eigen::Matrix3d JlogSO3(const Eigen::Vector3d& w)
+{
+    const ExpCoefficients k(w.norm());
+    const Eigen::Matrix3d W = Skew(w);
+    return Eigen::Matrix3d::Identity() + 0.5 * W + k.d * W * W;
+}
+
+/// \brief Coupling block Q of the SE(3) Jacobians for the twist [v; w] (cf. Barfoot, State Estimation for Robotics, 7.1.5).
+inline Eigen::Matrix3d CouplingSE3(const Eigen::Vector3d& v, const Eigen::Vector3d& w)
+{
+    const ExpCoefficients k(w.norm());
+    const Eigen::Matrix3d V = Skew(v), W = Skew(w);
+    const Eigen::Matrix3d WV = W * V, VW = V * W, WVW = WV * W;
+    return 0.5 * V + k.c * (WV + VW + WVW) + k.e * (W * WV + VW * W - 3.0 * WVW) + k.f * (WVW * W + W * WVW);
+}
+
+/// \brief Exponential map of SE(3) for the twist [v; w].
+inline void ExpSE3(const Vector6d& twist, Eigen::Matrix3d& R, Eigen::Vector3d& p)
+{
+    const Eigen::Vector3d w = twist.tail<3>();
+    const ExpCoefficients k(w.norm());
+    const Eigen::Matrix3d W = Skew(w);
+    R = Eigen::Matrix3d::Identity() + k.a * W + k.b * W * W;
+    p = (Eigen::Matrix3d::Identity() + k.b * W + k.c * W * W) * twist.head<3>();
+}
+
+/// \brief Logarithm of SE(3).
+inline Vector6d LogSE3(const Eigen::Matrix3d& R, const Eigen::Vector3d& p)
+{
+    const Eigen::Vector3d w = LogSO3(R);
+    const ExpCoefficients k(w.norm());
+    const Eigen::Matrix3d W = Skew(w);
+    Vector6d twist;
+    twist.head<3>() = (Eigen::Matrix3d::Identity() - 0.5 * W + k.d * W * W) * p;
+    twist.tail<3>() = w;
+    return twist;
+}
+
+/// \brief d exp(twist + d) / d d expressed locally, i.e., the right Jacobian of SE(3): exp(twist + d) ~ exp(twist) exp(Jexp d).
+inline Matrix6d JexpSE3(const Vector6d& twist)
+{
+    // The right Jacobian is the left Jacobian at -twist
+    const Eigen::Vector3d v = -twist.head<3>(), w = -twist.tail<3>();
+    const ExpCoefficients k(w.norm());
+    const Eigen::Matrix3d W = Skew(w);
+    const Eigen::Matrix3d J = Eigen::Matrix3d::Identity() + k.b * W + k.c * W * W;
+    Matrix6d Jexp;
+    Jexp << J, CouplingSE3(v, w), Eigen::Matrix3d::Zero(), J;
+    return Jexp;
+}
+
+/// \brief d log(M exp(d)) / d d at d = 0 for twist = log(M), i.e., the inverse of JexpSE3(twist).
+inline Matrix6d JlogSE3(const Vector6d& twist)
+{
+    // The inverse of the right Jacobian is the inverse of the left Jacobian at -twist
+    const Eigen::Vector3d v = -twist.head<3>(), w = -twist.tail<3>();
+    const ExpCoefficients k(w.norm());
+    const Eigen::Matrix3d W = Skew(w);
+    const Eigen::Matrix3d J_inv = Eigen::Matrix3d::Identity() - 0.5 * W + k.d * W * W;
+    Matrix6d Jlog;
+    Jlog << J_inv, -J_inv * CouplingSE3(v, w) * J_inv, Eigen::Matrix3d::Zero(), J_inv;
+    return Jlog;
+}
+
+/// \brief Adjoint of the inverse of (R, p) acting on twists [v; w].
+inline Matrix6d AdjointInverse(const Eigen::Matrix3d& R, const Eigen::Vector3d& p)
+{
+    Matrix6d Ad;
+    Ad << R.transpose(), -R.transpose() * Skew(p), Eigen::Matrix3d::Zero(), R.transpose();
+    return Ad;
+}
+
+/// \brief Relative transform M_2^-1 * M_1 of the floating bases of q_1 and q_2.
+inline void RelativeBaseTransform(Eigen::VectorXdRefConst q_1, Eigen::VectorXdRefConst q_2, Eigen::Matrix3d& R, Eigen::Vector3d& p)
+{
+    const Eigen::Matrix3d R_2 = Eigen::Quaterniond(q_2.segment<4>(3)).normalized().toRotationMatrix();
+    R = R_2.transpose() * Eigen::Quaterniond(q_1.segment<4>(3)).normalized().toRotationMatrix();
+    p = R_2.transpose() * (q_1.head<3>() - q_2.head<3>());
+}
+
+/// \brief q_out = q (+) dq. q_out must not alias q.
+inline void Integrate(Eigen::VectorXdRefConst q, Eigen::VectorXdRefConst dq, Eigen::VectorXdRef q_out)
+{
+    const Eigen::Quaterniond quaternion = Eigen::Quaterniond(q.segment<4>(3)).normalized();
+    Eigen::Matrix3d R_delta;
+    Eigen::Vector3d p_delta;
+    ExpSE3(dq.head<6>(), R_delta, p_delta);
+    q_out.head<3>() = q.head<3>() + quaternion * p_delta;
+    q_out.segment<4>(3) = (quaternion * Eigen::Quaterniond(R_delta)).normalized().coeffs();
+    q_out.tail(q.size() - 7) = q.tail(q.size() - 7) + dq.tail(dq.size() - 6);
+}
+
+/// \brief dq_out = q_1 (-) q_2.
+inline void Difference(Eigen::VectorXdRefConst q_1, Eigen::VectorXdRefConst q_2, Eigen::VectorXdRef dq_out)
+{
+    Eigen::Matrix3d R;
+    Eigen::Vector3d p;
+    RelativeBaseTransform(q_1, q_2, R, p);
+    dq_out.head<6>() = LogSE3(R, p);
+    dq_out.tail(dq_out.size() - 6) = q_1.tail(q_1.size() - 7) - q_2.tail(q_2.size() - 7);
+}
+
+/// \brief Jacobian of q_1 (-) q_2 w.r.t. the tangent of q_1 (ARG0) or q_2 (ARG1). J is overwritten.
+inline void dDifference(Eigen::VectorXdRefConst q_1, Eigen::VectorXdRefConst q_2, const ArgumentPosition first_or_second, Eigen::MatrixXdRef J)
+{
+    Eigen::Matrix3d R;
+    Eigen::Vector3d p;
+    RelativeBaseTransform(q_1, q_2, R, p);
+    const Matrix6d Jlog = JlogSE3(LogSE3(R, p));
+
+    J.setZero();
+    if (first_or_second == ArgumentPosition::ARG0)
+    {
+        J.topLeftCorner<6, 6>() = Jlog;
+        J.diagonal().tail(J.rows() - 6).setOnes();
+    }
+    else
+    {
+        // log(exp(-d) M) = log(M exp(-Ad(M^-1) d))
+        J.topLeftCorner<6, 6>().noalias() = -Jlog * AdjointInverse(R, p);
+        J.diagonal().tail(J.rows() - 6).setConstant(-1.0);
+    }
+}
+}  // namespace floating_base
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_TOOLS_FLOATING_BASE_H_
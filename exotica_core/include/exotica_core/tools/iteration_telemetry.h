@@ -0,0 +1,144 @@
+//
+// Copyright (c) 2020, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_ITERATION_TELEMETRY_H_
+#define EXOTICA_CORE_ITERATION_TELEMETRY_H_
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace exotica
+{
+/// \brief Record of one solver iteration. Quantities a solver does not provide are NaN.
+struct IterationRecord
+{
+    static constexpr int kNumberOfPhases = 4;
+
+    int iteration = -1;
+    double time = std::numeric_limits<double>::quiet_NaN();  ///< Wall time since the start of the solve (s)
+    double cost = std::numeric_limits<double>::quiet_NaN();
+    double step_length = std::numeric_limits<double>::quiet_NaN();
+    double regularization = std::numeric_limits<double>::quiet_NaN();
+    double constraint_violation = std::numeric_limits<double>::quiet_NaN();
+    /// \brief Wall time (s) of the phases of the iteration, solver-specific (e.g., backward pass and forward pass of DDP solvers).
+    std::array<double, kNumberOfPhases> phase_durations{{std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN()}};
+};
+
+/// \brief Fixed-capacity ring buffer of iteration records, written by the solver and read by other threads (e.g., monitoring) while solving.
+///
+/// There is a single writer (Push) that never blocks or allocates. Readers (Read) do not block the writer either: each slot carries a
+/// sequence number, which is odd while the slot is written, and a record is only returned if the sequence number did not change while
+/// it was read. Readers that fall behind by more than the capacity lose the overwritten records. The records are counted over the
+/// lifetime of the buffer, hence a reader passes the count returned by its last Read to receive only the new records.
+class IterationTelemetry
+{
+public:
+    explicit IterationTelemetry(std::size_t capacity = 1024) : capacity_(std::max<std::size_t>(capacity, 1)), slots_(new Slot[capacity_])
+    {
+    }
+
+    /// \brief Restarts the wall time of the records, e.g., at the start of a solve. Only to be called by the writer.
+    void Reset()
+    {
+        start_time_ = std::chrono::high_resolution_clock::now();
+    }
+
+    /// \brief Appends a record, overwriting the oldest one if the buffer is full. The time is set to the wall time since Reset.
+    void Push(const IterationRecord& record)
+    {
+        const std::uint64_t index = count_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[index % capacity_];
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.values[0].store(static_cast<double>(record.iteration), std::memory_order_relaxed);
+        slot.values[1].store(std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::high_resolution_clock::now() - start_time_).count(), std::memory_order_relaxed);
+        slot.values[2].store(record.cost, std::memory_order_relaxed);
+        slot.values[3].store(record.step_length, std::memory_order_relaxed);
+        slot.values[4].store(record.regularization, std::memory_order_relaxed);
+        slot.values[5].store(record.constraint_violation, std::memory_order_relaxed);
+        for (int i = 0; i < IterationRecord::kNumberOfPhases; ++i) slot.values[6 + i].store(record.phase_durations[i], std::memory_order_relaxed);
+
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+        count_.store(index + 1, std::memory_order_release);
+    }
+
+    /// \brief Appends the records pushed since the first count_since records to records.
+    /// \return Number of records pushed so far, to be passed as count_since to the next Read.
+    std::uint64_t Read(std::uint64_t count_since, std::vector<IterationRecord>& records) const
+    {
+        const std::uint64_t count = count_.load(std::memory_order_acquire);
+        for (std::uint64_t index = std::max(count_since, count > capacity_ ? count - capacity_ : 0); index < count; ++index)
+        {
+            const Slot& slot = slots_[index % capacity_];
+            const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * index + 2) continue;  // Overwritten or being written
+
+            IterationRecord record;
+            record.iteration = static_cast<int>(slot.values[0].load(std::memory_order_relaxed));
+            record.time = slot.values[1].load(std::memory_order_relaxed);
+            record.cost = slot.values[2].load(std::memory_order_relaxed);
+            record.step_length = slot.values[3].load(std::memory_order_relaxed);
+            record.regularization = slot.values[4].load(std::memory_order_relaxed);
+            record.constraint_violation = slot.values[5].load(std::memory_order_relaxed);
+            for (int i = 0; i < IterationRecord::kNumberOfPhases; ++i) record.phase_durations[i] = slot.values[6 + i].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+            records.push_back(record);
+        }
+        return count;
+    }
+
+    /// \brief Returns the number of records pushed so far.
+    std::uint64_t GetNumberOfRecords() const { return count_.load(std::memory_order_acquire); }
+
+    std::size_t GetCapacity() const { return capacity_; }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::uint64_t> sequence{0};
+        std::array<std::atomic<double>, 6 + IterationRecord::kNumberOfPhases> values;
+    };
+
+    const std::size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<std::uint64_t> count_{0};
+    std::chrono::high_resolution_clock::time_point start_time_ = std::chrono::high_resolution_clock::now();
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_ITERATION_TELEMETRY_H_
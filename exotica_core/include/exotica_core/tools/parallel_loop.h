@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_PARALLEL_LOOP_H_
+#define EXOTICA_CORE_PARALLEL_LOOP_H_
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <vector>
+
+namespace exotica
+{
+enum class ParallelSchedule
+{
+    Static,  ///< Every thread processes one contiguous block of the indices
+    Dynamic  ///< Threads take the next index whenever they are done with one
+};
+
+/// \brief Calls block(b) for all b in [0, num_blocks) on the thread pool of the Server (see Server::GetThreadPool) and returns when
+/// all calls have returned. Defined in server.cpp, which keeps this header free of the Server and its dependencies.
+void ParallelForOnServerThreadPool(int num_blocks, const std::function<void(int)>& block);
+
+/// \brief Calls body(thread, i) for all i in [0, num_items) in up to num_threads blocks, indices of each block in increasing order.
+/// thread is the index of the block in [0, num_threads), e.g. to select its workspace: a block runs on one thread at a time.
+/// The blocks run on the thread pool of the Server, so loops nested in other loops or in pool tasks share its threads instead of
+/// oversubscribing the machine. An exception thrown by body stops its block, and once all blocks have finished the exception of
+/// the lowest block is rethrown on the calling thread.
+template <typename Body>
+void ParallelLoop(int num_threads, int num_items, const Body& body, ParallelSchedule schedule = ParallelSchedule::Static)
+{
+    num_threads = std::max(1, std::min(num_threads, num_items));
+    if (num_threads == 1)
+    {
+        for (int i = 0; i < num_items; ++i) body(0, i);
+        return;
+    }
+
+    std::vector<std::exception_ptr> thread_exceptions(num_threads);
+    std::atomic<int> next_item(0);
+    ParallelForOnServerThreadPool(num_threads, [&](int thread) {
+        try
+        {
+            if (schedule == ParallelSchedule::Static)
+            {
+                const int end = static_cast<int>((static_cast<long>(thread) + 1) * num_items / num_threads);
+                for (int i = static_cast<int>(static_cast<long>(thread) * num_items / num_threads); i < end; ++i) body(thread, i);
+            }
+            else
+            {
+                for (int i = next_item++; i < num_items; i = next_item++) body(thread, i);
+            }
+        }
+        catch (...)
+        {
+            thread_exceptions[thread] = std::current_exception();
+        }
+    });
+    for (const std::exception_ptr& exception : thread_exceptions)
+    {
+        if (exception) std::rethrow_exception(exception);
+    }
+}
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_PARALLEL_LOOP_H_
@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_PROBLEM_RECORDER_H_
+#define EXOTICA_CORE_PROBLEM_RECORDER_H_
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <exotica_core/tools/conversions.h>
+#include <exotica_core/tools/uncopyable.h>
+
+namespace exotica
+{
+class PlanningProblem;
+
+enum class ProblemEventType : std::uint8_t
+{
+    SetStartState = 1,
+    SetStartTime = 2,
+    SetGoal = 3,
+    SetRho = 4,
+    SetGoalEQ = 5,
+    SetRhoEQ = 6,
+    SetGoalNEQ = 7,
+    SetRhoNEQ = 8,
+    Update = 9,             ///< Update(x), or Update(x, t) of time-indexed problems
+    UpdateTrajectory = 10,  ///< Update(x_trajectory) of time-indexed problems
+    PlanningScene = 11      ///< Serialized moveit_msgs::PlanningScene of the world, recorded before the first update after it changed
+};
+
+/// \brief Input of a problem captured by ProblemRecorder.
+struct ProblemEvent
+{
+    ProblemEventType type;
+    std::int64_t time = 0;  ///< Time since the recording started (ns)
+    std::string task_name;
+    int t = -1;             ///< Time step, -1 for the problems without time steps
+    double scalar = 0.0;    ///< Start time or rho
+    Eigen::VectorXd value;  ///< Start state, goal or state
+    std::string data;       ///< Serialized planning scene
+};
+
+/// \brief Writes the inputs of a problem (start state and time, goals, weights, world changes and updates) to a compact binary log,
+/// which ProblemLog replays on a problem instantiated from the same configuration, e.g., to profile production workloads offline.
+///
+/// The recorder is attached with PlanningProblem::SetRecorder. The end-pose and time-indexed problems record their inputs, the
+/// updates made by a problem itself while evaluating another input (e.g., the time steps of Update(x_trajectory)) are not recorded.
+class ProblemRecorder : Uncopyable
+{
+public:
+    explicit ProblemRecorder(const std::string& file_name);
+    ~ProblemRecorder();
+
+    void RecordVector(ProblemEventType type, Eigen::VectorXdRefConst value, int t = -1);
+    void RecordScalar(ProblemEventType type, double scalar);
+    void RecordGoal(ProblemEventType type, const std::string& task_name, Eigen::VectorXdRefConst goal, int t = -1);
+    void RecordRho(ProblemEventType type, const std::string& task_name, double rho, int t = -1);
+
+    /// \brief Records an update of the problem, preceded by the world of the scene if it changed since the last update.
+    void RecordUpdate(ProblemEventType type, Eigen::VectorXdRefConst x, int t = -1);
+
+    void Flush();
+
+    std::size_t GetNumberOfEvents() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return num_events_;
+    }
+
+    /// \brief Ignores the events recorded during its lifetime, e.g., the nested updates of an update. Does nothing for nullptr.
+    class Suppress : Uncopyable
+    {
+    public:
+        explicit Suppress(ProblemRecorder* recorder) : recorder_(recorder)
+        {
+            if (recorder_) recorder_->AddSuppressDepth(1);
+        }
+        ~Suppress()
+        {
+            if (recorder_) recorder_->AddSuppressDepth(-1);
+        }
+
+    private:
+        ProblemRecorder* recorder_;
+    };
+
+private:
+    friend class PlanningProblem;
+
+    /// \brief Writes the header of the log on the first call, called by PlanningProblem::SetRecorder. The recorder can be
+    /// re-attached after Detach to a problem of the same type and dimension only.
+    void Attach(PlanningProblem* problem);
+    /// \brief Stops recording the problem, called when it is destroyed or gets another recorder.
+    void Detach(PlanningProblem* problem);
+    void AddSuppressDepth(int delta);
+    /// \brief Write and IsRecording expect mutex_ to be held.
+    void Write(const ProblemEvent& event);
+    bool IsRecording() const { return problem_ != nullptr && suppress_depth_ == 0; }
+
+    std::ofstream out_;
+    mutable std::mutex mutex_;            ///< Guards the log and the members below
+    PlanningProblem* problem_ = nullptr;  ///< Recorded problem, cleared by Detach before it is destroyed
+    std::string problem_type_;            ///< Type of the problems in the log, empty until the header is written
+    int problem_dimension_ = 0;           ///< Dimension of the problems in the log
+    int world_version_ = -1;              ///< World version of the last recorded planning scene
+    int suppress_depth_ = 0;
+    std::size_t num_events_ = 0;
+    std::int64_t start_;
+};
+
+/// \brief Log written by ProblemRecorder.
+class ProblemLog
+{
+public:
+    explicit ProblemLog(const std::string& file_name);
+
+    const std::string& GetProblemType() const { return problem_type_; }
+    int GetProblemDimension() const { return problem_dimension_; }
+    const std::vector<ProblemEvent>& GetEvents() const { return events_; }
+
+    /// \brief Applies the events in order to a problem of the same type. Each event runs in a profiling zone named after its type
+    /// (see Profiler), the recorded timing between events is not reproduced.
+    /// \return Wall time of each event (s)
+    std::vector<double> Replay(const std::shared_ptr<PlanningProblem>& problem) const;
+
+private:
+    std::string problem_type_;
+    int problem_dimension_ = 0;
+    std::vector<ProblemEvent> events_;
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_PROBLEM_RECORDER_H_
@@ -0,0 +1,174 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_PROFILER_H_
+#define EXOTICA_CORE_PROFILER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <exotica_core/tools/uncopyable.h>
+
+namespace exotica
+{
+/// \brief A completed profiling zone as recorded by ProfileZone.
+struct ProfileEvent
+{
+    const char* name;               ///< Zone name, has to outlive the profiler (string literal or __func__)
+    std::int64_t start;             ///< Start time (ns) since the profiler was created
+    std::int64_t duration;          ///< Wall time of the zone (ns)
+    std::int64_t self;              ///< Wall time of the zone not spent in nested zones (ns)
+    std::int64_t allocations;       ///< Heap allocations of the thread within the zone (exotica_allocation_tracking, 0 otherwise)
+    std::int64_t self_allocations;  ///< Heap allocations within the zone outside of nested zones
+    int depth;                      ///< Nesting depth of the zone on its thread
+    int thread;                     ///< Index of the recording thread, in order of the first recorded zone
+};
+
+/// \brief Aggregate timings of all events with the same zone name.
+struct ProfileZoneStatistics
+{
+    std::string name;
+    std::size_t count = 0;
+    double total = 0.0;                 ///< Total wall time (s)
+    double self = 0.0;                  ///< Total wall time not spent in nested zones (s)
+    double min = 0.0;                   ///< Shortest event (s)
+    double max = 0.0;                   ///< Longest event (s)
+    double mean = 0.0;                  ///< Mean wall time (s)
+    std::int64_t allocations = 0;       ///< Total heap allocations
+    std::int64_t self_allocations = 0;  ///< Total heap allocations outside of nested zones
+    std::int64_t max_allocations = 0;   ///< Largest number of heap allocations of one event
+};
+
+/// \brief Collects profiling zones of all threads.
+///
+/// Every thread records into its own buffer, hence recording only takes an uncontended lock; the buffers are merged when the events
+/// are exported. Zones are placed with the EXOTICA_PROFILE_SCOPE and EXOTICA_PROFILE_FUNCTION macros, which are only compiled in when
+/// EXOTica is built with the CMake option EXOTICA_ENABLE_PROFILING. Without it, the profiler stays empty.
+///
+/// The debug option EXOTICA_ENABLE_ALLOCATION_TRACKING builds the library exotica_allocation_tracking, which interposes malloc, calloc
+/// and realloc (glibc only), also covering operator new and Eigen. When it is linked into an executable (e.g. a test) or preloaded
+/// with LD_PRELOAD, the zones record the number of heap allocations made by their thread. Zones of the real-time path should then
+/// report no allocations. exotica_core itself never replaces the allocator.
+class Profiler : public Uncopyable
+{
+public:
+    static Profiler& Instance();
+
+    /// \brief Whether the profiling zones are compiled in (EXOTICA_ENABLE_PROFILING).
+    static bool IsCompiledIn();
+
+    /// \brief Whether heap allocations are counted, i.e., exotica_allocation_tracking is linked into or preloaded in the process.
+    static bool IsAllocationTrackingLoaded();
+
+    /// \brief Number of heap allocations made by the calling thread so far, 0 without exotica_allocation_tracking.
+    static std::int64_t GetThreadAllocations();
+
+    /// \brief Enables or disables recording at run time. Recording is enabled by default.
+    void SetEnabled(bool enabled) { enabled_ = enabled; }
+    bool IsEnabled() const { return enabled_; }
+
+    /// \brief Limits the number of events kept per thread, further events are counted as dropped. 0 disables the limit.
+    void SetMaxEventsPerThread(std::size_t max_events) { max_events_per_thread_ = max_events; }
+    std::size_t GetNumberOfDroppedEvents() const;
+
+    /// \brief Removes all recorded events and the buffers of threads that exited.
+    void Clear();
+
+    /// \brief Returns the events of all threads, sorted by start time.
+    std::vector<ProfileEvent> GetEvents() const;
+
+    /// \brief Returns the aggregate timings per zone name, sorted by descending total time.
+    std::vector<ProfileZoneStatistics> GetStatistics() const;
+
+    /// \brief Returns the aggregate timings as a human-readable table.
+    std::string GetStatisticsTable() const;
+
+    /// \brief Returns the events in the Chrome trace event format (JSON), which can be loaded in chrome://tracing and Perfetto.
+    std::string GetChromeTrace() const;
+    void SaveChromeTrace(const std::string& file_name) const;
+
+    /// \brief Monotonic time (ns) since the profiler was created.
+    std::int64_t Now() const;
+
+private:
+    friend class ProfileZone;
+
+    struct ThreadBuffer
+    {
+        std::mutex mutex;
+        std::vector<ProfileEvent> events;
+        std::vector<std::int64_t> nested_durations;    ///< Wall time of the nested zones per open depth
+        std::vector<std::int64_t> nested_allocations;  ///< Heap allocations of the nested zones per open depth
+        std::size_t dropped = 0;
+        int thread = 0;
+        int depth = 0;
+    };
+
+    Profiler();
+    ThreadBuffer& GetThreadBuffer();
+
+    std::atomic<bool> enabled_{true};
+    std::atomic<std::size_t> max_events_per_thread_{0};
+    std::int64_t epoch_;
+
+    mutable std::mutex buffers_mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    int next_thread_ = 0;
+};
+
+/// \brief Records the wall time between its construction and destruction as a profiling zone.
+class ProfileZone : public Uncopyable
+{
+public:
+    explicit ProfileZone(const char* name);
+    ~ProfileZone();
+
+private:
+    Profiler::ThreadBuffer* buffer_ = nullptr;
+    const char* name_;
+    std::int64_t start_;
+    std::int64_t start_allocations_;
+};
+}  // namespace exotica
+
+#ifdef EXOTICA_ENABLE_PROFILING
+#define EXOTICA_PROFILE_CONCATENATE_IMPL(a, b) a##b
+#define EXOTICA_PROFILE_CONCATENATE(a, b) EXOTICA_PROFILE_CONCATENATE_IMPL(a, b)
+#define EXOTICA_PROFILE_SCOPE(name) ::exotica::ProfileZone EXOTICA_PROFILE_CONCATENATE(exotica_profile_zone_, __LINE__)(name)
+#define EXOTICA_PROFILE_FUNCTION() EXOTICA_PROFILE_SCOPE(__PRETTY_FUNCTION__)
+#else
+#define EXOTICA_PROFILE_SCOPE(name)
+#define EXOTICA_PROFILE_FUNCTION()
+#endif
+
+#endif  // EXOTICA_CORE_PROFILER_H_
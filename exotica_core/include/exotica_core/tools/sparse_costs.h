@@ -98,6 +98,67 @@ inline double pseudo_huber_hessian(double x, double beta)
     return std::pow(beta, 4) * std::sqrt(1.0 + x * x / (beta * beta)) / (std::pow(beta * beta + x * x, 2));
 }
 
+/// \brief Sparsity losses evaluated on all the elements of a vector at once, e.g. on the controls of a time step.
+///
+/// Evaluate returns the sum of the losses of the elements of x with the rates beta and, unless they are null, sets gradient
+/// and hessian to the element-wise first and second derivative (i.e. the diagonal of the Hessian) in the same pass.
+/// The results match the element-wise functions above.
+struct L2Loss
+{
+    static double Evaluate(const Eigen::Ref<const Eigen::VectorXd>& x, const Eigen::Ref<const Eigen::VectorXd>& /*beta*/, Eigen::VectorXd* gradient, Eigen::VectorXd* hessian)
+    {
+        // The quadratic cost is not a sparsity loss, it is already part of the control cost
+        if (gradient != nullptr) gradient->setZero(x.rows());
+        if (hessian != nullptr) hessian->setZero(x.rows());
+        return 0.0;
+    }
+};
+
+struct SmoothL1Loss
+{
+    static double Evaluate(const Eigen::Ref<const Eigen::VectorXd>& x_in, const Eigen::Ref<const Eigen::VectorXd>& beta_in, Eigen::VectorXd* gradient, Eigen::VectorXd* hessian)
+    {
+        const auto x = x_in.array();
+        const auto beta = beta_in.array();
+        const auto inside = x.abs() < beta;
+        if (gradient != nullptr) *gradient = inside.select(x / beta, (x < -beta).select(-1.0, Eigen::ArrayXd::Ones(x.rows()))).matrix();
+        if (hessian != nullptr) *hessian = inside.select(beta.inverse(), 0.0).matrix();
+        return inside.select(0.5 * x.square() / beta, x.abs() - 0.5 * beta).sum();
+    }
+};
+
+/// \brief A rate of 0 disables the loss.
+struct HuberLoss
+{
+    static double Evaluate(const Eigen::Ref<const Eigen::VectorXd>& x_in, const Eigen::Ref<const Eigen::VectorXd>& beta_in, Eigen::VectorXd* gradient, Eigen::VectorXd* hessian)
+    {
+        const auto x = x_in.array();
+        const auto beta = beta_in.array();
+        const auto inside = x.abs() < beta;
+        if (gradient != nullptr) *gradient = inside.select(x, (x < 0.0).select(-beta, beta)).matrix();
+        if (hessian != nullptr) *hessian = inside.select(Eigen::ArrayXd::Ones(x.rows()), 0.0).matrix();
+        return inside.select(0.5 * x.square(), beta * (x.abs() - 0.5 * beta)).sum();
+    }
+};
+
+/// \brief A rate of 0 disables the loss.
+struct PseudoHuberLoss
+{
+    static double Evaluate(const Eigen::Ref<const Eigen::VectorXd>& x_in, const Eigen::Ref<const Eigen::VectorXd>& beta_in, Eigen::VectorXd* gradient, Eigen::VectorXd* hessian)
+    {
+        const auto x = x_in.array();
+        const auto beta = beta_in.array();
+        const auto enabled = beta != 0.0;
+        // With s = sqrt(1 + (x / beta)^2), the loss is beta^2 * (s - 1), its gradient x / s and the Hessian 1 / s^3
+        const auto s = (1.0 + (x / beta).square()).sqrt();
+        if (gradient != nullptr) *gradient = enabled.select(x / s, 0.0).matrix();
+        if (hessian != nullptr) *hessian = enabled.select(s.cube().inverse(), 0.0).matrix();
+        return enabled.select(beta.square() * (s - 1.0), 0.0).sum();
+    }
+};
+
+/// \brief Signature of Evaluate of the losses, e.g. to select one at instantiation.
+typedef double (*VectorLossFunction)(const Eigen::Ref<const Eigen::VectorXd>& x, const Eigen::Ref<const Eigen::VectorXd>& beta, Eigen::VectorXd* gradient, Eigen::VectorXd* hessian);
 }  // namespace exotica
 
 #endif  // EXOTICA_CORE_TOOLS_SPARSE_COSTS_H_
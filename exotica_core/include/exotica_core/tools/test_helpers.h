@@ -30,7 +30,12 @@
 #ifndef EXOTICA_CORE_TEST_HELPERS_H_
 #define EXOTICA_CORE_TEST_HELPERS_H_
 
+#include <stdlib.h>
+#include <unistd.h>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 
 namespace exotica
 {
@@ -43,6 +48,16 @@ public:
         std::cout << "\033[32m[          ]\033[0m \033[35m" << str().c_str() << "\033[0m" << std::endl;
     }
 };
+
+// Creates an empty file with a unique name in /tmp, such that concurrently running tests do not share files
+inline std::string CreateTemporaryFile(const std::string& prefix)
+{
+    std::string file_name = "/tmp/" + prefix + "_XXXXXX";
+    const int fd = mkstemp(&file_name[0]);
+    if (fd == -1) throw std::runtime_error("Can't create a temporary file for " + prefix);
+    close(fd);
+    return file_name;
+}
 }  // namespace exotica
 
 #define TEST_COUT TestCout()
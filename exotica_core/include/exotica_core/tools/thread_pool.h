@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef EXOTICA_CORE_THREAD_POOL_H_
+#define EXOTICA_CORE_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <exotica_core/tools/uncopyable.h>
+
+namespace exotica
+{
+/// \brief Work-stealing thread pool.
+///
+/// Every worker has its own queue of tasks: tasks submitted from a worker are queued there, others are distributed
+/// round-robin. Workers run the newest task of their own queue first and steal the oldest tasks of the other queues when
+/// theirs is empty. The process-wide pool is owned by the Server, see Server::GetThreadPool.
+class ThreadPool : public Uncopyable
+{
+public:
+    /// \param num_threads Number of worker threads. Without workers, tasks run on the submitting thread.
+    /// \param pin_threads Pins worker i to CPU i (Linux only).
+    /// \param deterministic Runs all tasks on the submitting thread in submission order, regardless of num_threads.
+    ThreadPool(int num_threads, bool pin_threads = false, bool deterministic = false);
+    ~ThreadPool();
+
+    /// \brief Returns the number of worker threads.
+    int GetNumThreads() const { return static_cast<int>(threads_.size()); }
+
+    /// \brief Returns whether the tasks run serially in submission order.
+    bool IsDeterministic() const { return deterministic_; }
+
+    /// \brief Schedules the task and returns its future, which rethrows exceptions thrown by the task.
+    template <typename Function>
+    std::future<typename std::result_of<Function()>::type> Submit(Function&& task)
+    {
+        typedef typename std::result_of<Function()>::type Result;
+        std::shared_ptr<std::packaged_task<Result()>> packaged_task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(task));
+        std::future<Result> future = packaged_task->get_future();
+        Enqueue([packaged_task]() { (*packaged_task)(); });
+        return future;
+    }
+
+    /// \brief Calls body(i) for all i in [begin, end), in chunks of grain_size consecutive indices, and returns when all calls
+    /// have returned. The calling thread takes part and then waits for the chunks taken by the workers. It runs no other
+    /// tasks, e.g., of concurrent loops, so it may hold locks used by them. Calls may be nested in tasks.
+    /// The first exception thrown by body is rethrown on the calling thread.
+    void ParallelFor(int begin, int end, const std::function<void(int)>& body, int grain_size = 1);
+
+private:
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void Enqueue(std::function<void()> task);
+
+    /// \brief Runs one task of the queue of the worker (-1 if not a worker) or stolen from another queue. Returns false if there was none.
+    bool RunPendingTask(int worker);
+
+    void WorkerLoop(int worker);
+
+    /// \brief Returns the index of the calling thread among the workers of this pool, -1 if it is not one of them.
+    int GetWorkerIndex() const;
+
+    bool deterministic_;
+    std::vector<std::unique_ptr<TaskQueue>> queues_;  ///< One queue per worker
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;                       ///< Guards stop_ for the sleeping workers
+    std::condition_variable condition_;      ///< Wakes workers up when tasks are submitted or the pool stops
+    std::atomic<int> num_pending_tasks_{0};  ///< Tasks queued and not yet taken by a thread
+    std::atomic<unsigned int> next_queue_{0};
+    bool stop_ = false;
+};
+}  // namespace exotica
+
+#endif  // EXOTICA_CORE_THREAD_POOL_H_
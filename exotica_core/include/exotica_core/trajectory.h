@@ -31,9 +31,13 @@
 #define EXOTICA_CORE_TRAJECTORY_H_
 
 #include <exotica_core/tools/conversions.h>
+#include <exotica_core/tools/uncopyable.h>
 #include <Eigen/Dense>
+#include <fstream>
 #include <kdl/trajectory_composite.hpp>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace exotica
 {
@@ -58,6 +62,136 @@ protected:
     Eigen::MatrixXd data_;
     std::shared_ptr<KDL::Trajectory_Composite> trajectory_;
 };
+
+///
+/// \brief Piecewise polynomial (cubic or quintic) interpolation of vector-valued knots with precomputed coefficients.
+///
+/// The coefficients are stored per polynomial order (structure of arrays): coefficient k of all segments is a
+/// dimension x segments matrix, so evaluating one segment is a short sequence of contiguous vector operations.
+/// Segments are looked up in O(1) if the knots are uniformly spaced and in O(log n) otherwise. Times outside of
+/// [GetStartTime(), GetEndTime()] are clamped.
+///
+class SplineTrajectory
+{
+public:
+    enum SplineType
+    {
+        Cubic = 3,    ///< Natural cubic spline (C2, zero acceleration at the ends)
+        Quintic = 5,  ///< Quintic Hermite spline, matching the given (or finite difference) velocities and accelerations
+    };
+
+    SplineTrajectory() = default;
+    /// \brief Interpolates the knots (one row per time) with the velocities and accelerations of quintic segments estimated by finite differences.
+    SplineTrajectory(Eigen::VectorXdRefConst times, Eigen::MatrixXdRefConst knots, SplineType type = Cubic);
+    /// \brief Quintic spline through the knots with the given velocities and accelerations (one row per time).
+    SplineTrajectory(Eigen::VectorXdRefConst times, Eigen::MatrixXdRefConst knots, Eigen::MatrixXdRefConst velocities, Eigen::MatrixXdRefConst accelerations);
+
+    void GetPosition(double t, Eigen::VectorXdRef position) const;
+    void GetVelocity(double t, Eigen::VectorXdRef velocity) const;
+    void GetAcceleration(double t, Eigen::VectorXdRef acceleration) const;
+    Eigen::VectorXd GetPosition(double t) const;
+    Eigen::VectorXd GetVelocity(double t) const;
+    Eigen::VectorXd GetAcceleration(double t) const;
+
+    /// \brief Evaluates the spline at many times, returning one row per time.
+    Eigen::MatrixXd GetPositions(Eigen::VectorXdRefConst times) const;
+    Eigen::MatrixXd GetVelocities(Eigen::VectorXdRefConst times) const;
+    Eigen::MatrixXd GetAccelerations(Eigen::VectorXdRefConst times) const;
+
+    SplineType GetType() const { return type_; }
+    int GetDimension() const { return static_cast<int>(knots_.cols()); }
+    int GetNumberOfSegments() const { return static_cast<int>(times_.size()) - 1; }
+    double GetStartTime() const { return times_(0); }
+    double GetEndTime() const { return times_(times_.size() - 1); }
+    double GetDuration() const { return GetEndTime() - GetStartTime(); }
+    const Eigen::VectorXd& GetTimes() const { return times_; }
+    const Eigen::MatrixXd& GetKnots() const { return knots_; }
+
+private:
+    void Initialize(Eigen::VectorXdRefConst times, Eigen::MatrixXdRefConst knots);
+    void ConstructQuintic(Eigen::MatrixXdRefConst velocities, Eigen::MatrixXdRefConst accelerations);
+    /// \brief Returns the segment containing t and sets tau to the time since the start of the segment.
+    int FindSegment(double t, double& tau) const;
+    void Evaluate(int derivative, double t, Eigen::VectorXdRef value) const;
+    Eigen::MatrixXd Evaluate(int derivative, Eigen::VectorXdRefConst times) const;
+
+    SplineType type_ = Cubic;
+    Eigen::VectorXd times_;
+    Eigen::MatrixXd knots_;
+    std::vector<Eigen::MatrixXd> coefficients_;  ///< coefficients_[k](i, s): coefficient of tau^k of dimension i in segment s
+    bool uniform_ = false;
+    double inverse_dt_ = 0.0;
+};
+
+/// \brief Read-only view of the states or controls of a trajectory in a trajectory file, with one row per time step.
+typedef Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> TrajectoryFileData;
+
+///
+/// \brief Writes trajectories (e.g. the solutions of motion solvers) one after another to a binary trajectory file.
+///
+/// All trajectories of a file share the joint names, the time step dt and the number of controls. The states
+/// (and controls) of each trajectory are appended as soon as it is written, so a file can be read back with
+/// TrajectoryFileReader while it is still being written and records of a crashed writer are not lost.
+///
+class TrajectoryFileWriter : Uncopyable
+{
+public:
+    TrajectoryFileWriter(const std::string& file_name, const std::vector<std::string>& joint_names, double dt, int num_controls = 0);
+    ~TrajectoryFileWriter();
+
+    /// \brief Appends a trajectory with one row per time step and a column per joint. Requires a file without controls.
+    void Write(Eigen::MatrixXdRefConst states);
+    /// \brief Appends a trajectory with its controls (one row per time step and a column per control, e.g. T-1 rows).
+    void Write(Eigen::MatrixXdRefConst states, Eigen::MatrixXdRefConst controls);
+    void Flush();
+    void Close();
+    std::size_t GetNumberOfTrajectories() const { return num_trajectories_; }
+
+private:
+    std::ofstream file_;
+    std::string file_name_;
+    int num_joints_;
+    int num_controls_;
+    std::size_t num_trajectories_ = 0;
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> buffer_;  ///< Row-major copy of the data being written
+};
+
+///
+/// \brief Memory-maps a trajectory file written by TrajectoryFileWriter and gives access to its trajectories without copying them.
+///
+/// The views returned by GetStates and GetControls are valid as long as the reader exists. An incomplete trajectory at the
+/// end of the file (e.g. one that is still being written) is ignored.
+///
+class TrajectoryFileReader : Uncopyable
+{
+public:
+    explicit TrajectoryFileReader(const std::string& file_name);
+    ~TrajectoryFileReader();
+
+    const std::vector<std::string>& GetJointNames() const { return joint_names_; }
+    double GetTimeStep() const { return dt_; }
+    int GetNumberOfControls() const { return num_controls_; }
+    std::size_t GetNumberOfTrajectories() const { return records_.size(); }
+    TrajectoryFileData GetStates(std::size_t index) const;
+    TrajectoryFileData GetControls(std::size_t index) const;
+
+private:
+    struct Record
+    {
+        const double* states;
+        const double* controls;
+        Eigen::Index num_states;
+        Eigen::Index num_controls;
+    };
+    const Record& GetRecord(std::size_t index) const;
+
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::vector<std::string> joint_names_;
+    double dt_ = 0.0;
+    int num_controls_ = 0;
+    std::vector<Record> records_;
+};
 }  // namespace exotica
 
 #endif  // EXOTICA_CORE_TRAJECTORY_H_
@@ -30,7 +30,12 @@
 #ifndef EXOTICA_CORE_VISUALIZATION_MESHCAT_H_
 #define EXOTICA_CORE_VISUALIZATION_MESHCAT_H_
 
+#include <condition_variable>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <zmq.hpp>
 
 #include <exotica_core/scene.h>
@@ -38,6 +43,11 @@
 
 namespace exotica
 {
+/// \brief Streams the scene to a MeshCat server.
+///
+/// Messages are packed on the calling thread and sent by a background thread, so displaying states does not wait for the
+/// server. Transform and property updates that have not been sent yet are replaced by newer ones for the same path, i.e.,
+/// stale frames are dropped instead of queued.
 class VisualizationMeshcat : public Uncopyable
 {
 public:
@@ -46,6 +56,7 @@ public:
 
     void Initialize(bool use_mesh_materials);
 
+    /// \brief Sends the visual geometry of the scene. Objects the viewer already has with identical content are not sent again, only their transforms are updated.
     void DisplayScene(bool use_mesh_materials = true);
     void DisplayState(Eigen::VectorXdRefConst state, double t = 0.0);
     void DisplayTrajectory(Eigen::MatrixXdRefConst trajectory, double dt = 1.0);
@@ -58,16 +69,43 @@ public:
     std::string GetWebURL();
     std::string GetFileURL();
 
+    /// \brief Blocks until all queued messages have been sent.
+    void Flush();
+
 private:
+    struct QueuedMessage
+    {
+        std::string type;
+        std::string path;
+        std::string data;  ///< Packed message
+    };
+
     ScenePtr scene_ = std::make_shared<Scene>(nullptr);
 
     void ConnectZMQ();
+    /// \brief ConnectZMQ for the send thread, reports failures instead of throwing.
+    void ReconnectZMQ();
     void SendZMQ(const std::string& data);
     std::string ReceiveZMQ();
     std::string RequestWebURL();
 
+    /// \brief Packs the message and queues it for sending.
+    /// \param coalesce_key Replaces the queued message with the same key, if any. Messages without key are sent in order and are never replaced.
     template <typename T>
-    void SendMsg(T msg);
+    void SendMsg(T msg, const std::string& coalesce_key = "");
+
+    template <typename T>
+    QueuedMessage PackMsg(const T& msg);
+    void QueueMsg(QueuedMessage&& queued, const std::string& coalesce_key);
+
+    /// \brief Sends the object unless the viewer already has it with the same content, then sends its transform.
+    /// The UUIDs of the object are replaced by ones derived from its path, so that only changes of the content are sent.
+    template <typename T>
+    void SendObject(T& object, const KDL::Frame& frame);
+
+    void StartSendThread();
+    void StopSendThread();
+    void SendLoop();
 
     std::string zmq_url_;
     std::string web_url_;
@@ -77,6 +115,17 @@ private:
 
     zmq::context_t context_;
     std::unique_ptr<zmq::socket_t> socket_;
+
+    std::thread send_thread_;
+    std::mutex queue_mutex_;
+    std::condition_variable queue_condition_;  ///< Wakes up the send thread
+    std::condition_variable sent_condition_;   ///< Wakes up Flush
+    std::vector<QueuedMessage> queue_;
+    std::map<std::string, size_t> queue_index_;  ///< Coalesce key to position in queue_, since the last message without key
+    bool sending_ = false;
+
+    std::map<std::string, size_t> displayed_objects_;  ///< Path to the hash of the packed set_object message the viewer has
+    bool stop_ = false;
 };
 }  // namespace exotica
 
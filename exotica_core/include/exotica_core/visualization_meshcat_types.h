@@ -32,6 +32,8 @@
 
 #define MSGPACK_USE_DEFINE_MAP
 
+#include <functional>
+#include <iomanip>
 #include <iostream>
 #include <msgpack.hpp>
 
@@ -59,7 +61,7 @@ inline long RGB(double R, double G, double B)
     return static_cast<long>(std::min(std::max(R, 0.0), 1.0) * 255) * 65536L + static_cast<long>(std::min(std::max(G, 0.0), 1.0) * 255) * 256L + static_cast<long>(std::min(std::max(B, 0.0), 1.0) * 255);
 }
 
-unsigned char random_char()
+inline unsigned char random_char()
 {
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -67,7 +69,7 @@ unsigned char random_char()
     return static_cast<unsigned char>(dis(gen));
 }
 
-std::string generate_hex(const unsigned int len)
+inline std::string generate_hex(const unsigned int len)
 {
     std::stringstream ss;
     for (auto i = 0; i < len; ++i)
@@ -81,11 +83,24 @@ std::string generate_hex(const unsigned int len)
     return ss.str();
 }
 
-std::string generate_uuid()
+inline std::string generate_uuid()
 {
     return generate_hex(4) + "-" + generate_hex(4) + "-" + generate_hex(4) + "-" + generate_hex(4);
 }
 
+/// \brief UUID in the format of generate_uuid derived from the name, so that messages with the same name and content are identical.
+inline std::string generate_uuid(const std::string& name)
+{
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (int i = 0; i < 4; ++i)
+    {
+        if (i > 0) ss << "-";
+        ss << std::setw(8) << (std::hash<std::string>()(name + "/" + std::to_string(i)) & 0xffffffffu);
+    }
+    return ss.str();
+}
+
 struct Base
 {
     Base() = default;
@@ -409,6 +424,25 @@ MeshObject<T> CreateMeshObject(const T& geometry_in, const Material& material_in
     return ret;
 };
 
+/// \brief Replaces the random UUIDs of an object and its geometries and materials by ones derived from the name.
+template <typename T>
+void AssignUuids(Object<T>& object, const std::string& name)
+{
+    object.object.uuid = generate_uuid(name);
+    for (std::size_t i = 0; i < object.geometries.size(); ++i) object.geometries[i].uuid = generate_uuid(name + "/geometry/" + std::to_string(i));
+    for (std::size_t i = 0; i < object.materials.size(); ++i) object.materials[i].uuid = generate_uuid(name + "/material/" + std::to_string(i));
+    if (!object.geometries.empty()) object.object.geometry = object.geometries[0].uuid;
+    if (!object.materials.empty()) object.object.material = object.materials[0].uuid;
+}
+
+template <typename T>
+void AssignUuids(MeshObject<T>& object, const std::string& name)
+{
+    object.object.uuid = generate_uuid(name);
+    for (std::size_t i = 0; i < object.geometries.size(); ++i) object.geometries[i].uuid = generate_uuid(name + "/geometry/" + std::to_string(i));
+    for (std::size_t i = 0; i < object.materials.size(); ++i) object.materials[i].uuid = generate_uuid(name + "/material/" + std::to_string(i));
+}
+
 struct SetTransform
 {
     SetTransform() = default;
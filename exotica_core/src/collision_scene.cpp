@@ -55,6 +55,166 @@ void CollisionScene::InstantiateBase(const Initializer& init)
     if (debug_) INFO_NAMED(object_name_, "Initialized CollisionScene of type " << GetObjectName());
 }
 
+std::vector<bool> CollisionScene::AreStatesValid(Eigen::MatrixXdRefConst states, bool self, double safe_distance, bool stop_at_first_invalid)
+{
+    std::shared_ptr<Scene> scene = scene_.lock();
+    std::vector<bool> ret(states.rows(), false);
+    for (int i = 0; i < states.rows(); ++i)
+    {
+        scene->Update(states.row(i).transpose());
+        ret[i] = IsStateValid(self, safe_distance);
+        if (!ret[i] && stop_at_first_invalid) break;
+    }
+    return ret;
+}
+
+void CollisionScene::UpdateReattachedCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects)
+{
+    scene_.lock()->UpdateCollisionObjects();
+}
+
+void CollisionScene::UpdateOctreeCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects)
+{
+    scene_.lock()->UpdateCollisionObjects();
+}
+
+void CollisionScene::AddCollisionObjects(const std::map<std::string, std::weak_ptr<KinematicElement>>& objects)
+{
+    scene_.lock()->UpdateCollisionObjects();
+}
+
+void CollisionScene::RemoveCollisionObjects(const std::vector<std::string>& names)
+{
+    scene_.lock()->UpdateCollisionObjects();
+}
+
+void CollisionScene::UpdateQueryCache()
+{
+    std::shared_ptr<Scene> scene = scene_.lock();
+    if (scene == nullptr) ThrowPretty("The CollisionScene is not assigned to a Scene!");
+    // The tree can be updated without the Scene, e.g., by KinematicTree::Update or by the clones of the validity workspaces
+    const std::uint64_t tree_stamp = scene->GetKinematicTree().GetUpdateStamp();
+    // Only the parts of the scene the queries depend on discard them, e.g., changing a trajectory does not until the next update
+    const std::array<int, 4> versions = {scene->GetVersion(SCENE_CHANGE_STATE), scene->GetVersion(SCENE_CHANGE_WORLD), scene->GetVersion(SCENE_CHANGE_ATTACHMENTS), scene->GetVersion(SCENE_CHANGE_ACM)};
+    if (cached_tree_stamp_ == tree_stamp && cached_versions_ == versions && cached_invalidations_ == query_cache_invalidations_) return;
+
+    cached_proxies_.clear();
+    cached_validity_.clear();
+    ++cache_generation_;
+    if (!scene->AlwaysUpdatesCollisionScene()) UpdateCollisionObjectTransforms();
+    cached_tree_stamp_ = tree_stamp;
+    cached_versions_ = versions;
+    cached_invalidations_ = query_cache_invalidations_;
+}
+
+const std::vector<CollisionProxy>& CollisionScene::GetCachedCollisionDistance(bool self, double check_margin)
+{
+    UpdateQueryCache();
+    const auto key = std::make_tuple(CachedQuery::Distance, self, check_margin);
+    auto it = cached_proxies_.find(key);
+    if (it == cached_proxies_.end()) it = cached_proxies_.emplace(key, GetCollisionDistance(self, check_margin)).first;
+    return it->second;
+}
+
+const std::vector<CollisionProxy>& CollisionScene::GetCachedRobotToRobotCollisionDistance(double check_margin)
+{
+    UpdateQueryCache();
+    const auto key = std::make_tuple(CachedQuery::RobotToRobotDistance, true, check_margin);
+    auto it = cached_proxies_.find(key);
+    if (it == cached_proxies_.end()) it = cached_proxies_.emplace(key, GetRobotToRobotCollisionDistance(check_margin)).first;
+    return it->second;
+}
+
+const std::vector<CollisionProxy>& CollisionScene::GetCachedRobotToWorldCollisionDistance(double check_margin)
+{
+    UpdateQueryCache();
+    const auto key = std::make_tuple(CachedQuery::RobotToWorldDistance, false, check_margin);
+    auto it = cached_proxies_.find(key);
+    if (it == cached_proxies_.end()) it = cached_proxies_.emplace(key, GetRobotToWorldCollisionDistance(check_margin)).first;
+    return it->second;
+}
+
+void CollisionScene::ConvertProxies(const std::vector<CollisionProxy>& in, CollisionProxyBuffer& out) const
+{
+    const KinematicTree& tree = scene_.lock()->GetKinematicTree();
+    out.Clear();
+    out.Reserve(static_cast<int>(in.size()));
+    for (const CollisionProxy& proxy : in)
+    {
+        out.Append(tree.GetFrameHandle(proxy.e1->segment.getName()), tree.GetFrameHandle(proxy.e2->segment.getName()), proxy.contact1, proxy.normal1, proxy.contact2, proxy.normal2, proxy.distance);
+    }
+}
+
+void CollisionScene::GetCollisionDistance(bool self, double check_margin, CollisionProxyBuffer& proxies)
+{
+    ConvertProxies(GetCollisionDistance(self, check_margin), proxies);
+}
+
+void CollisionScene::GetRobotToRobotCollisionDistance(double check_margin, CollisionProxyBuffer& proxies)
+{
+    ConvertProxies(GetRobotToRobotCollisionDistance(check_margin), proxies);
+}
+
+void CollisionScene::GetRobotToWorldCollisionDistance(double check_margin, CollisionProxyBuffer& proxies)
+{
+    ConvertProxies(GetRobotToWorldCollisionDistance(check_margin), proxies);
+}
+
+const CollisionProxyBuffer& CollisionScene::GetCachedProxyBuffer(CachedQuery query, bool self, double check_margin)
+{
+    UpdateQueryCache();
+    CachedProxyBuffer& cached = cached_proxy_buffers_[std::make_tuple(query, self, check_margin)];
+    if (cached.generation != cache_generation_)
+    {
+        switch (query)
+        {
+            case CachedQuery::Distance:
+                GetCollisionDistance(self, check_margin, cached.proxies);
+                break;
+            case CachedQuery::RobotToRobotDistance:
+                GetRobotToRobotCollisionDistance(check_margin, cached.proxies);
+                break;
+            case CachedQuery::RobotToWorldDistance:
+                GetRobotToWorldCollisionDistance(check_margin, cached.proxies);
+                break;
+            default:
+                ThrowPretty("Not a distance query!");
+        }
+        cached.generation = cache_generation_;
+    }
+    return cached.proxies;
+}
+
+void CollisionScene::GetCachedCollisionDistance(bool self, double check_margin, CollisionProxyBuffer& proxies)
+{
+    const CollisionProxyBuffer& cached = GetCachedProxyBuffer(CachedQuery::Distance, self, check_margin);
+    proxies.Clear();
+    proxies.Append(cached);
+}
+
+void CollisionScene::GetCachedRobotToRobotCollisionDistance(double check_margin, CollisionProxyBuffer& proxies)
+{
+    const CollisionProxyBuffer& cached = GetCachedProxyBuffer(CachedQuery::RobotToRobotDistance, true, check_margin);
+    proxies.Clear();
+    proxies.Append(cached);
+}
+
+void CollisionScene::GetCachedRobotToWorldCollisionDistance(double check_margin, CollisionProxyBuffer& proxies)
+{
+    const CollisionProxyBuffer& cached = GetCachedProxyBuffer(CachedQuery::RobotToWorldDistance, false, check_margin);
+    proxies.Clear();
+    proxies.Append(cached);
+}
+
+bool CollisionScene::IsStateValidCached(bool self, double safe_distance)
+{
+    UpdateQueryCache();
+    const auto key = std::make_tuple(CachedQuery::Validity, self, safe_distance);
+    auto it = cached_validity_.find(key);
+    if (it == cached_validity_.end()) it = cached_validity_.emplace(key, IsStateValid(self, safe_distance)).first;
+    return it->second;
+}
+
 bool CollisionScene::IsAllowedToCollide(const std::string& o1, const std::string& o2, const bool& self)
 {
     std::shared_ptr<KinematicElement> e1 = scene_.lock()->GetKinematicTree().FindKinematicElementByName(o1);
@@ -29,6 +29,12 @@
 
 #include <exotica_core/dynamics_solver.h>
 #include <exotica_core/scene.h>
+#include <exotica_core/server.h>
+#include <exotica_core/setup.h>
+#include <exotica_core/tools/floating_base.h>
+#include <exotica_core/tools/parallel_loop.h>
+
+#include <thread>
 
 namespace exotica
 {
@@ -42,9 +48,27 @@ template <typename T, int NX, int NU>
 void AbstractDynamicsSolver<T, NX, NU>::InstantiateBase(const Initializer& init)
 {
     Object::InstantiateObject(init);
+    initializer_ = init;
     DynamicsSolverInitializer dynamics_solver_initializer = DynamicsSolverInitializer(init);
     this->SetDt(dynamics_solver_initializer.dt);
     this->SetIntegrator(dynamics_solver_initializer.Integrator);
+    if (dynamics_solver_initializer.ImplicitEulerMaxIterations < 1) ThrowNamed("ImplicitEulerMaxIterations needs to be positive: " << dynamics_solver_initializer.ImplicitEulerMaxIterations);
+    implicit_euler_max_iterations_ = dynamics_solver_initializer.ImplicitEulerMaxIterations;
+    implicit_euler_tolerance_ = dynamics_solver_initializer.ImplicitEulerTolerance;
+    this->SetDerivativesNumThreads(dynamics_solver_initializer.DerivativesNumThreads);
+    this->SetFiniteDifferenceNumThreads(dynamics_solver_initializer.FiniteDifferenceNumThreads);
+
+    if (dynamics_solver_initializer.FiniteDifferenceMode == "Backward")
+        finite_difference_mode_ = FiniteDifferenceMode::Backward;
+    else if (dynamics_solver_initializer.FiniteDifferenceMode == "Forward")
+        finite_difference_mode_ = FiniteDifferenceMode::Forward;
+    else if (dynamics_solver_initializer.FiniteDifferenceMode == "Central")
+        finite_difference_mode_ = FiniteDifferenceMode::Central;
+    else
+        ThrowNamed("Unknown finite-difference mode: " << dynamics_solver_initializer.FiniteDifferenceMode);
+    if (dynamics_solver_initializer.FiniteDifferenceStep <= 0.0) ThrowNamed("Invalid finite-difference step: " << dynamics_solver_initializer.FiniteDifferenceStep);
+    finite_difference_step_ = dynamics_solver_initializer.FiniteDifferenceStep;
+    finite_difference_clones_.clear();
 
     // Just store the control limits supplied.
     //  They will need to be reshaped to the correct size when num_velocities_ becomes known.
@@ -87,11 +111,10 @@ Eigen::Matrix<T, NX, 1> AbstractDynamicsSolver<T, NX, NU>::SimulateOneStep(const
             Integrate(x, xdot, dt_, xout);
             return xout;
         }
-        // NB: RK2 and RK4 are currently deactivated as we do not yet have correct derivatives for state transitions.
-        /*// Explicit trapezoid rule (RK2)
+        // Explicit trapezoid rule (RK2)
         case Integrator::RK2:
         {
-            assert(num_positions_ == num_velocities_);  // If this is not true, we should have specialised methods.
+            if (num_positions_ != num_velocities_) ThrowPretty("RK2 requires a Euclidean state space, use RK1 or SymplecticEuler.");
 
             StateVector xdot0 = f(x, u);
             StateVector x1est = x + dt_ * xdot0;  // explicit Euler step
@@ -103,7 +126,7 @@ Eigen::Matrix<T, NX, 1> AbstractDynamicsSolver<T, NX, NU>::SimulateOneStep(const
         // Runge-Kutta 4
         case Integrator::RK4:
         {
-            assert(num_positions_ == num_velocities_);  // If this is not true, we should have specialised methods.
+            if (num_positions_ != num_velocities_) ThrowPretty("RK4 requires a Euclidean state space, use RK1 or SymplecticEuler.");
 
             StateVector k1 = dt_ * f(x, u);
             StateVector k2 = dt_ * f(x + 0.5 * k1, u);
@@ -112,16 +135,48 @@ Eigen::Matrix<T, NX, 1> AbstractDynamicsSolver<T, NX, NU>::SimulateOneStep(const
             StateVector dx = (k1 + k4) / 6. + (k2 + k3) / 3.;
 
             return x + dx;
-        }*/
+        }
+        // Implicit and linearly implicit Euler
+        case Integrator::ImplicitEuler:
+        case Integrator::LinearlyImplicitEuler:
+        {
+            return ImplicitEulerStep(x, u);
+        }
         default:
             ThrowPretty("Not implemented!");
     };
 }
 
+template <typename T, int NX, int NU>
+Eigen::Matrix<T, NX, 1> AbstractDynamicsSolver<T, NX, NU>::ImplicitEulerStep(const StateVector& x, const ControlVector& u)
+{
+    if (num_positions_ != num_velocities_ || has_quaternion_floating_base_) ThrowPretty("Implicit integrators require a Euclidean state space, use RK1 or SymplecticEuler.");
+
+    // Newton's method on the residual r(x_next) = x_next - x - dt f(x_next, u), with dr/dx_next = I - dt fx(x_next, u)
+    const int max_iterations = (integrator_ == Integrator::LinearlyImplicitEuler) ? 1 : implicit_euler_max_iterations_;
+    StateVector x_next = x;
+    StateVector residual = -dt_ * f(x, u);
+    for (int iteration = 0; iteration < max_iterations; ++iteration)
+    {
+        StateDerivative dresidual = -dt_ * fx(x_next, u);
+        dresidual.diagonal().array() += 1.0;
+        x_next -= dresidual.partialPivLu().solve(residual);
+
+        if (integrator_ == Integrator::LinearlyImplicitEuler) break;
+        residual = x_next - x - dt_ * f(x_next, u);
+        if (residual.norm() < implicit_euler_tolerance_) return x_next;
+    }
+
+    if (integrator_ == Integrator::ImplicitEuler && debug_) WARNING_NAMED(object_name_, "ImplicitEuler did not converge in " << max_iterations << " iterations, residual: " << residual.norm());
+    return x_next;
+}
+
 template <typename T, int NX, int NU>
 void AbstractDynamicsSolver<T, NX, NU>::Integrate(const StateVector& x, const StateVector& dx, const double dt, StateVector& xout)
 {
-    assert(num_positions_ == num_velocities_);  // Integration on manifolds needs to be handled using function overloads in specific dynamics solvers.
+    if (has_quaternion_floating_base_) return FloatingBaseIntegrate(x, dx, dt, xout);
+
+    assert(num_positions_ == num_velocities_);  // Integration on other manifolds needs to be handled using function overloads in specific dynamics solvers.
     assert(x.size() == get_num_state());
     assert(dx.size() == get_num_state_derivative());
     assert(xout.size() == get_num_state());
@@ -129,8 +184,13 @@ void AbstractDynamicsSolver<T, NX, NU>::Integrate(const StateVector& x, const St
 
     switch (integrator_)
     {
-        // Forward Euler (RK1)
+        // Forward Euler (RK1). The Runge-Kutta and implicit schemes combine their stages in SimulateOneStep, so
+        // integrating a given tangent vector is an Euler step for them as well.
         case Integrator::RK1:
+        case Integrator::RK2:
+        case Integrator::RK4:
+        case Integrator::ImplicitEuler:
+        case Integrator::LinearlyImplicitEuler:
         {
             xout.noalias() = x + dt * dx;
         }
@@ -155,6 +215,105 @@ void AbstractDynamicsSolver<T, NX, NU>::Integrate(const StateVector& x, const St
     };
 }
 
+template <typename T, int NX, int NU>
+void AbstractDynamicsSolver<T, NX, NU>::FloatingBaseIntegrate(const StateVector& x, const StateVector& dx, const double dt, StateVector& xout)
+{
+    assert(x.size() == get_num_state());
+    assert(dx.size() == get_num_state_derivative());
+    assert(xout.size() == get_num_state());
+    if (dt < 1e-6) ThrowPretty("dt needs to be positive!");
+
+    const Eigen::VectorBlock<const StateVector> q = x.head(num_positions_);
+    const Eigen::VectorBlock<const StateVector> v = x.tail(num_velocities_);
+    const Eigen::VectorBlock<const StateVector> a = dx.tail(num_velocities_);
+
+    // The configuration is integrated along v * dt (RK1) or v * dt + a * dt^2 (SymplecticEuler) in the tangent space
+    Eigen::VectorXd dq(num_velocities_);
+    switch (integrator_)
+    {
+        case Integrator::RK1:
+        case Integrator::RK2:
+        case Integrator::RK4:
+        case Integrator::ImplicitEuler:
+        case Integrator::LinearlyImplicitEuler:
+            dq.noalias() = dt * dx.head(num_velocities_);
+            break;
+        case Integrator::SymplecticEuler:
+            dq.noalias() = dt * v + (dt * dt) * a;
+            break;
+        default:
+            ThrowPretty("Not implemented!");
+    };
+
+    floating_base::Integrate(q, dq, xout.head(num_positions_));
+    xout.tail(num_velocities_).noalias() = v + dt * a;
+}
+
+template <typename T, int NX, int NU>
+Eigen::Matrix<T, NX, 1> AbstractDynamicsSolver<T, NX, NU>::FloatingBaseStateDelta(const StateVector& x_1, const StateVector& x_2)
+{
+    if (x_1.size() != num_state_ || x_2.size() != num_state_) ThrowPretty("x_1 or x_2 do not have correct size, x1=" << x_1.size() << " x2=" << x_2.size() << " expected " << num_state_);
+
+    StateVector dx(num_state_derivative_);
+    floating_base::Difference(x_1.head(num_positions_), x_2.head(num_positions_), dx.head(num_velocities_));
+    dx.tail(num_velocities_).noalias() = x_1.tail(num_velocities_) - x_2.tail(num_velocities_);
+    return dx;
+}
+
+template <typename T, int NX, int NU>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> AbstractDynamicsSolver<T, NX, NU>::FloatingBasedStateDelta(const StateVector& x_1, const StateVector& x_2, const ArgumentPosition first_or_second)
+{
+    if (x_1.size() != num_state_ || x_2.size() != num_state_) ThrowPretty("x_1 or x_2 do not have correct size, x1=" << x_1.size() << " x2=" << x_2.size() << " expected " << num_state_);
+    if (first_or_second != ArgumentPosition::ARG0 && first_or_second != ArgumentPosition::ARG1) ThrowPretty("Can only take derivative w.r.t. x_1 or x_2, i.e., ARG0 or ARG1. Provided: " << first_or_second);
+
+    Eigen::MatrixXd J = Eigen::MatrixXd::Zero(num_state_derivative_, num_state_derivative_);
+    floating_base::dDifference(x_1.head(num_positions_), x_2.head(num_positions_), first_or_second, J.topLeftCorner(num_velocities_, num_velocities_));
+    J.bottomRightCorner(num_velocities_, num_velocities_).diagonal().setConstant(first_or_second == ArgumentPosition::ARG0 ? 1.0 : -1.0);
+    return J;
+}
+
+template <typename T, int NX, int NU>
+Hessian AbstractDynamicsSolver<T, NX, NU>::FloatingBaseddStateDelta(const StateVector& x_1, const StateVector& x_2, const ArgumentPosition first_or_second)
+{
+    if (x_1.size() != num_state_ || x_2.size() != num_state_) ThrowPretty("x_1 or x_2 do not have correct size, x1=" << x_1.size() << " x2=" << x_2.size() << " expected " << num_state_);
+    if (first_or_second != ArgumentPosition::ARG0 && first_or_second != ArgumentPosition::ARG1) ThrowPretty("Can only take derivative w.r.t. x_1 or x_2, i.e., ARG0 or ARG1. Provided: " << first_or_second);
+
+    Hessian ddx;
+    ddx.setConstant(num_state_derivative_, Eigen::MatrixXd::Zero(num_state_derivative_, num_state_derivative_));
+
+    // Only the SE(3) block of the Jacobian depends on the state, and only on the floating base. Its derivative along the
+    // six base directions is taken by central differences of the closed-form Jacobian.
+    constexpr double eps = 1e-6;
+    const StateVector& q_perturbed_nominal = (first_or_second == ArgumentPosition::ARG0) ? x_1 : x_2;
+    Eigen::VectorXd q_plus(num_positions_), q_minus(num_positions_), dq = Eigen::VectorXd::Zero(num_velocities_);
+    Eigen::MatrixXd J_plus(num_velocities_, num_velocities_), J_minus(num_velocities_, num_velocities_);
+    for (int i = 0; i < 6; ++i)
+    {
+        dq(i) = 0.5 * eps;
+        floating_base::Integrate(q_perturbed_nominal.head(num_positions_), dq, q_plus);
+        dq(i) = -0.5 * eps;
+        floating_base::Integrate(q_perturbed_nominal.head(num_positions_), dq, q_minus);
+        dq(i) = 0.0;
+
+        if (first_or_second == ArgumentPosition::ARG0)
+        {
+            floating_base::dDifference(q_plus, x_2.head(num_positions_), first_or_second, J_plus);
+            floating_base::dDifference(q_minus, x_2.head(num_positions_), first_or_second, J_minus);
+        }
+        else
+        {
+            floating_base::dDifference(x_1.head(num_positions_), q_plus, first_or_second, J_plus);
+            floating_base::dDifference(x_1.head(num_positions_), q_minus, first_or_second, J_minus);
+        }
+
+        for (int k = 0; k < 6; ++k)
+        {
+            ddx(k).block<6, 1>(0, i) = (J_plus.block<1, 6>(k, 0).transpose() - J_minus.block<1, 6>(k, 0).transpose()) / eps;
+        }
+    }
+    return ddx;
+}
+
 template <typename T, int NX, int NU>
 Eigen::Matrix<T, NX, 1> AbstractDynamicsSolver<T, NX, NU>::Simulate(const StateVector& x, const ControlVector& u, T t)
 {
@@ -239,6 +398,10 @@ void AbstractDynamicsSolver<T, NX, NU>::SetIntegrator(const std::string& integra
         integrator_ = Integrator::RK2;
     else if (integrator_in == "RK4")
         integrator_ = Integrator::RK4;
+    else if (integrator_in == "ImplicitEuler")
+        integrator_ = Integrator::ImplicitEuler;
+    else if (integrator_in == "LinearlyImplicitEuler")
+        integrator_ = Integrator::LinearlyImplicitEuler;
     else
         ThrowPretty("Unknown integrator: " << integrator_in);
 }
@@ -297,10 +460,10 @@ void AbstractDynamicsSolver<T, NX, NU>::InitializeSecondOrderDerivatives()
     fxx_default_ = Eigen::Tensor<T, 3>(ndx, ndx, ndx);
     fxx_default_.setZero();
 
-    fuu_default_ = Eigen::Tensor<T, 3>(ndx, num_controls_, num_controls_);
+    fuu_default_ = Eigen::Tensor<T, 3>(num_controls_, ndx, num_controls_);
     fuu_default_.setZero();
 
-    fxu_default_ = Eigen::Tensor<T, 3>(ndx, ndx, num_controls_);
+    fxu_default_ = Eigen::Tensor<T, 3>(num_controls_, ndx, ndx);
     fxu_default_.setZero();
 
     dStateDelta_.setIdentity(get_num_state_derivative(), get_num_state_derivative());
@@ -330,6 +493,42 @@ Eigen::Tensor<T, 3> AbstractDynamicsSolver<T, NX, NU>::fxu(const StateVector& x,
     return fxu_default_;
 }
 
+// Contracts X(a, i, b) over the output dimension i: result(a, b) = sum_i lambda_i * X(a, i, b)
+template <typename T>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> ContractSecondOrderTensor(const Eigen::Tensor<T, 3>& tensor, const Eigen::Matrix<T, Eigen::Dynamic, 1>& lambda)
+{
+    if (tensor.dimension(1) != lambda.size()) ThrowPretty("Wrong size of lambda: " << lambda.size() << ", expected " << tensor.dimension(1));
+
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> result = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(tensor.dimension(0), tensor.dimension(2));
+    for (int b = 0; b < tensor.dimension(2); ++b)
+        for (int i = 0; i < tensor.dimension(1); ++i)
+            for (int a = 0; a < tensor.dimension(0); ++a)
+                result(a, b) += lambda(i) * tensor(a, i, b);
+    return result;
+}
+
+template <typename T, int NX, int NU>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> AbstractDynamicsSolver<T, NX, NU>::ContractFxx(const StateVector& x, const ControlVector& u, const StateVector& lambda)
+{
+    const int ndx = get_num_state_derivative();
+    if (!has_second_order_derivatives_) return Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(ndx, ndx);
+    return ContractSecondOrderTensor<T>(fxx(x, u), lambda);
+}
+
+template <typename T, int NX, int NU>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> AbstractDynamicsSolver<T, NX, NU>::ContractFuu(const StateVector& x, const ControlVector& u, const StateVector& lambda)
+{
+    if (!has_second_order_derivatives_) return Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(num_controls_, num_controls_);
+    return ContractSecondOrderTensor<T>(fuu(x, u), lambda);
+}
+
+template <typename T, int NX, int NU>
+Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> AbstractDynamicsSolver<T, NX, NU>::ContractFxu(const StateVector& x, const ControlVector& u, const StateVector& lambda)
+{
+    if (!has_second_order_derivatives_) return Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(num_controls_, get_num_state_derivative());
+    return ContractSecondOrderTensor<T>(fxu(x, u), lambda);
+}
+
 template <typename T, int NX, int NU>
 Eigen::Matrix<T, NU, 1> AbstractDynamicsSolver<T, NX, NU>::InverseDynamics(const StateVector& state)
 {
@@ -339,62 +538,125 @@ Eigen::Matrix<T, NU, 1> AbstractDynamicsSolver<T, NX, NU>::InverseDynamics(const
 template <typename T, int NX, int NU>
 Eigen::Matrix<T, NX, NX> AbstractDynamicsSolver<T, NX, NU>::fx_fd(const StateVector& x, const ControlVector& u)
 {
-    const int nx = get_num_state();
-    const int ndx = get_num_state_derivative();
+    Eigen::MatrixXd fx_fd(get_num_state_derivative(), get_num_state_derivative());
+    ComputeFiniteDifferences(x, u, true, fx_fd);
+    return fx_fd;
+}
+
+template <typename T, int NX, int NU>
+Eigen::Matrix<T, NX, NX> AbstractDynamicsSolver<T, NX, NU>::fx(const StateVector& x, const ControlVector& u)
+{
+    return fx_fd(x, u);
+}
+
+template <typename T, int NX, int NU>
+Eigen::Matrix<T, NX, NU> AbstractDynamicsSolver<T, NX, NU>::fu_fd(const StateVector& x, const ControlVector& u)
+{
+    Eigen::MatrixXd fu_fd(get_num_state_derivative(), num_controls_);
+    ComputeFiniteDifferences(x, u, false, fu_fd);
+    return fu_fd;
+}
+
+template <typename T, int NX, int NU>
+void AbstractDynamicsSolver<T, NX, NU>::ComputeFiniteDifferences(const StateVector& x, const ControlVector& u, bool wrt_state, Eigen::MatrixXd& derivative)
+{
+    // The one-sided schemes share the nominal evaluation between all columns
+    StateVector f_nominal;
+    if (finite_difference_mode_ != FiniteDifferenceMode::Central) f_nominal = f(x, u);
+
+    const int num_threads = std::min(finite_difference_num_threads_, static_cast<int>(derivative.cols()));
+    if (num_threads > 1)
+    {
+        UpdateFiniteDifferenceClones(num_threads);
+
+        // The columns are split across the clones, each perturbs one dimension at a time
+        ParallelLoop(num_threads, static_cast<int>(derivative.cols()), [&](int thread, int i) {
+            ComputeFiniteDifferenceColumn(*finite_difference_clones_[thread], x, u, f_nominal, wrt_state, i, derivative);
+        });
+        return;
+    }
 
     // This finite differencing only works with RK1 due to Integrate(x, u, dt)
     // We thus store the previous Integrator, set it to RK1, then set it back
     // afterwards.
     Integrator previous_integrator = integrator_;
     integrator_ = Integrator::RK1;  // Note, this by-passes potentially overriden virtual set_integrator callbacks
-
-    // Finite differences
-    Eigen::MatrixXd fx_fd(ndx, ndx);
-    constexpr double eps = 1e-6;
-    Eigen::VectorXd x_low(nx), x_high(nx), xdiff(ndx);
-    for (int i = 0; i < ndx; ++i)
+    for (int i = 0; i < derivative.cols(); ++i)
     {
-        xdiff.setZero();
-        xdiff(i) = eps / 2.0;
-
-        Integrate(x, -xdiff, 1., x_low);
-        Integrate(x, xdiff, 1., x_high);
-
-        fx_fd.col(i) = (f(x_high, u) - f(x_low, u)) / eps;
+        ComputeFiniteDifferenceColumn(*this, x, u, f_nominal, wrt_state, i, derivative);
     }
-
-    // Reset integrator
     integrator_ = previous_integrator;
-
-    return fx_fd;
 }
 
 template <typename T, int NX, int NU>
-Eigen::Matrix<T, NX, NX> AbstractDynamicsSolver<T, NX, NU>::fx(const StateVector& x, const ControlVector& u)
+void AbstractDynamicsSolver<T, NX, NU>::ComputeFiniteDifferenceColumn(AbstractDynamicsSolver& solver, const StateVector& x, const ControlVector& u, const StateVector& f_nominal, bool wrt_state, int i, Eigen::MatrixXd& derivative) const
 {
-    return fx_fd(x, u);
+    const double h = finite_difference_step_;
+    auto evaluate = [&](double delta) -> StateVector {
+        if (wrt_state)
+        {
+            StateVector dx = StateVector::Zero(get_num_state_derivative());
+            StateVector x_perturbed(x.size());
+            dx(i) = delta;
+            solver.Integrate(x, dx, 1., x_perturbed);
+            return solver.f(x_perturbed, u);
+        }
+        ControlVector u_perturbed = u;
+        u_perturbed(i) += delta;
+        return solver.f(x, u_perturbed);
+    };
+
+    switch (finite_difference_mode_)
+    {
+        case FiniteDifferenceMode::Backward:
+            derivative.col(i) = (f_nominal - evaluate(-h)) / h;
+            break;
+        case FiniteDifferenceMode::Forward:
+            derivative.col(i) = (evaluate(h) - f_nominal) / h;
+            break;
+        case FiniteDifferenceMode::Central:
+            derivative.col(i) = (evaluate(h / 2.0) - evaluate(-h / 2.0)) / h;
+            break;
+    }
 }
 
 template <typename T, int NX, int NU>
-Eigen::Matrix<T, NX, NU> AbstractDynamicsSolver<T, NX, NU>::fu_fd(const StateVector& x, const ControlVector& u)
+void AbstractDynamicsSolver<T, NX, NU>::UpdateFiniteDifferenceClones(int num_clones)
 {
-    const int ndx = get_num_state_derivative();
-
-    // Finite differences
-    constexpr double eps = 1e-6;
-    Eigen::MatrixXd fu_fd(ndx, num_controls_);
-    Eigen::VectorXd u_low(num_controls_), u_high(num_controls_);
-    for (int i = 0; i < num_controls_; ++i)
+    while (static_cast<int>(finite_difference_clones_.size()) < num_clones)
     {
-        u_low = u;
-        u_high = u;
-        u_low(i) -= eps / 2.0;
-        u_high(i) += eps / 2.0;
+        std::shared_ptr<AbstractDynamicsSolver<T, NX, NU>> clone = Clone();
+        clone->SetFiniteDifferenceNumThreads(1);
+        clone->integrator_ = Integrator::RK1;  // See ComputeFiniteDifferences
+        finite_difference_clones_.push_back(clone);
+    }
+}
 
-        fu_fd.col(i) = (f(x, u_high) - f(x, u_low)) / eps;
+template <typename T, int NX, int NU>
+std::shared_ptr<AbstractDynamicsSolver<T, NX, NU>> AbstractDynamicsSolver<T, NX, NU>::Clone() const
+{
+    std::shared_ptr<AbstractDynamicsSolver<T, NX, NU>> clone = Setup::CreateDynamicsSolver(initializer_);
+    clone->debug_ = false;
+    if (std::shared_ptr<Scene> scene = scene_.lock())
+    {
+        clone->AssignScene(scene);
+        clone->scene_ = scene;
     }
+    clone->ns_ = ns_;
+    clone->SetDt(dt_);
+    clone->integrator_ = integrator_;
+    clone->implicit_euler_max_iterations_ = implicit_euler_max_iterations_;
+    clone->implicit_euler_tolerance_ = implicit_euler_tolerance_;
+    clone->has_quaternion_floating_base_ = has_quaternion_floating_base_;
+    if (control_limits_initialized_) clone->set_control_limits(control_limits_.col(0), control_limits_.col(1));
+    return clone;
+}
 
-    return fu_fd;
+template <typename T, int NX, int NU>
+void AbstractDynamicsSolver<T, NX, NU>::SetFiniteDifferenceNumThreads(int num_threads)
+{
+    if (num_threads < 0) ThrowPretty("Invalid number of threads: " << num_threads);
+    finite_difference_num_threads_ = Server::ResolveNumThreads(num_threads);
 }
 
 template <typename T, int NX, int NU>
@@ -443,11 +705,227 @@ void AbstractDynamicsSolver<T, NX, NU>::ComputeDerivatives(const StateVector& x,
             Fu_.bottomRows(num_velocities_).noalias() = da_du * dt_;
         }
         break;
+        // Explicit trapezoid rule (RK2): chain the derivatives of the stage k2 = f(x + dt k1, u) through k1 = f(x, u)
+        case Integrator::RK2:
+        {
+            if (num_positions_ != num_velocities_) ThrowPretty("RK2 requires a Euclidean state space, use RK1 or SymplecticEuler.");
+
+            const StateVector x1 = x + dt_ * f(x, u);
+            const StateDerivative A2 = fx(x1, u);
+            const StateDerivative dk2_dx = A2 + dt_ * A2 * fx_;
+            const ControlDerivative dk2_du = fu(x1, u) + dt_ * A2 * fu_;
+
+            Fx_ = (0.5 * dt_) * (fx_ + dk2_dx);
+            Fx_.diagonal().array() += 1.0;
+            Fu_ = (0.5 * dt_) * (fu_ + dk2_du);
+        }
+        break;
+        // Runge-Kutta 4: the derivative of each stage k_i = f(x + c_i dt k_{i-1}, u) chains through the previous stage
+        case Integrator::RK4:
+        {
+            if (num_positions_ != num_velocities_) ThrowPretty("RK4 requires a Euclidean state space, use RK1 or SymplecticEuler.");
+
+            const StateVector x2 = x + (0.5 * dt_) * f(x, u);
+            const StateVector k2 = f(x2, u);
+            const StateVector x3 = x + (0.5 * dt_) * k2;
+            const StateVector k3 = f(x3, u);
+            const StateVector x4 = x + dt_ * k3;
+
+            const StateDerivative A2 = fx(x2, u);
+            const StateDerivative dk2_dx = A2 + (0.5 * dt_) * A2 * fx_;
+            const ControlDerivative dk2_du = fu(x2, u) + (0.5 * dt_) * A2 * fu_;
+            const StateDerivative A3 = fx(x3, u);
+            const StateDerivative dk3_dx = A3 + (0.5 * dt_) * A3 * dk2_dx;
+            const ControlDerivative dk3_du = fu(x3, u) + (0.5 * dt_) * A3 * dk2_du;
+            const StateDerivative A4 = fx(x4, u);
+            const StateDerivative dk4_dx = A4 + dt_ * A4 * dk3_dx;
+            const ControlDerivative dk4_du = fu(x4, u) + dt_ * A4 * dk3_du;
+
+            Fx_ = (dt_ / 6.0) * (fx_ + 2.0 * dk2_dx + 2.0 * dk3_dx + dk4_dx);
+            Fx_.diagonal().array() += 1.0;
+            Fu_ = (dt_ / 6.0) * (fu_ + 2.0 * dk2_du + 2.0 * dk3_du + dk4_du);
+        }
+        break;
+        // Implicit Euler: by the implicit function theorem on x_next - x - dt f(x_next, u) = 0,
+        // Fx = (I - dt fx(x_next, u))^-1 and Fu = (I - dt fx(x_next, u))^-1 dt fu(x_next, u).
+        case Integrator::ImplicitEuler:
+        {
+            const StateVector x_next = ImplicitEulerStep(x, u);
+            StateDerivative dresidual = -dt_ * fx(x_next, u);
+            dresidual.diagonal().array() += 1.0;
+            const Eigen::PartialPivLU<StateDerivative> lu(dresidual);
+            Fx_ = lu.inverse();
+            Fu_ = lu.solve(dt_ * fu(x_next, u));
+        }
+        break;
+        // Linearly implicit Euler: x_next = x + dt s with (I - dt fx(x, u)) s = f(x, u). The derivatives of fx(x, u)
+        // enter through the directional derivatives of fx and fu along s, evaluated by central differences.
+        case Integrator::LinearlyImplicitEuler:
+        {
+            if (num_positions_ != num_velocities_ || has_quaternion_floating_base_) ThrowPretty("Implicit integrators require a Euclidean state space, use RK1 or SymplecticEuler.");
+
+            StateDerivative M = -dt_ * fx_;
+            M.diagonal().array() += 1.0;
+            const Eigen::PartialPivLU<StateDerivative> lu(M);
+            const StateVector s = lu.solve(f(x, u));
+
+            const double h = 1e-5 / std::max(1.0, s.norm());
+            const StateVector x_plus = x + (0.5 * h) * s, x_minus = x - (0.5 * h) * s;
+            const StateDerivative dfx_ds = (fx(x_plus, u) - fx(x_minus, u)) / h;
+            const ControlDerivative dfu_ds = (fu(x_plus, u) - fu(x_minus, u)) / h;
+
+            Fx_ = dt_ * lu.solve(fx_ + dt_ * dfx_ds);
+            Fx_.diagonal().array() += 1.0;
+            Fu_ = dt_ * lu.solve(fu_ + dt_ * dfu_ds);
+        }
+        break;
+        default:
+            ThrowPretty("Not implemented!");
+    };
+}
+
+template <typename T, int NX, int NU>
+Eigen::Matrix<T, NX, 1> AbstractDynamicsSolver<T, NX, NU>::ComputeAll(const StateVector& x, const ControlVector& u)
+{
+    ComputeDerivatives(x, u);
+    return f(x, u);
+}
+
+template <typename T, int NX, int NU>
+void AbstractDynamicsSolver<T, NX, NU>::ComputeDerivativesBatch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, std::vector<StateDerivative>& Fx, std::vector<ControlDerivative>& Fu)
+{
+    const int num_steps = static_cast<int>(U.cols());
+    if (X.cols() < num_steps) ThrowPretty("Not enough states: " << X.cols() << ", expected " << num_steps);
+    if (static_cast<int>(Fx.size()) < num_steps) Fx.resize(num_steps);
+    if (static_cast<int>(Fu.size()) < num_steps) Fu.resize(num_steps);
+
+    // ComputeDerivatives stores its results in the solver, so the steps are evaluated one after another.
+    for (int t = 0; t < num_steps; ++t)
+    {
+        ComputeDerivatives(X.col(t), U.col(t));
+        Fx[t] = Fx_;
+        Fu[t] = Fu_;
+    }
+}
+
+template <typename T, int NX, int NU>
+void AbstractDynamicsSolver<T, NX, NU>::f_batch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, Eigen::MatrixXdRef Xdot)
+{
+    if (X.rows() != get_num_state() || U.rows() != num_controls_ || X.cols() != U.cols()) ThrowPretty("Wrong size of states or controls: " << X.rows() << "x" << X.cols() << " and " << U.rows() << "x" << U.cols() << ", expected " << get_num_state() << " and " << num_controls_ << " rows");
+    if (Xdot.rows() != get_num_state_derivative() || Xdot.cols() != X.cols()) ThrowPretty("Wrong size of Xdot: " << Xdot.rows() << "x" << Xdot.cols() << ", expected " << get_num_state_derivative() << "x" << X.cols());
+
+    for (int k = 0; k < X.cols(); ++k)
+    {
+        Xdot.col(k) = f(X.col(k), U.col(k));
+    }
+}
+
+template <typename T, int NX, int NU>
+void AbstractDynamicsSolver<T, NX, NU>::f_batch_float(Eigen::MatrixXfRefConst X, Eigen::MatrixXfRefConst U, Eigen::MatrixXfRef Xdot)
+{
+    if (Xdot.rows() != get_num_state_derivative() || Xdot.cols() != X.cols()) ThrowPretty("Wrong size of Xdot: " << Xdot.rows() << "x" << Xdot.cols() << ", expected " << get_num_state_derivative() << "x" << X.cols());
+
+    Eigen::MatrixXd Xdot_double(get_num_state_derivative(), X.cols());
+    f_batch(X.cast<double>(), U.cast<double>(), Xdot_double);
+    Xdot = Xdot_double.cast<float>();
+}
+
+template <typename T, int NX, int NU>
+void AbstractDynamicsSolver<T, NX, NU>::SimulateBatch(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, Eigen::MatrixXdRef X_next)
+{
+    SimulateBatchImpl<double>(X, U, X_next);
+}
+
+template <typename T, int NX, int NU>
+void AbstractDynamicsSolver<T, NX, NU>::SimulateBatchFloat(Eigen::MatrixXfRefConst X, Eigen::MatrixXfRefConst U, Eigen::MatrixXfRef X_next)
+{
+    SimulateBatchImpl<float>(X, U, X_next);
+}
+
+template <typename T, int NX, int NU>
+template <typename Scalar>
+void AbstractDynamicsSolver<T, NX, NU>::SimulateBatchImpl(const Eigen::Ref<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>>& X, const Eigen::Ref<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>>& U, Eigen::Ref<Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>> X_next)
+{
+    typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> BatchMatrix;
+    if (X_next.rows() != X.rows() || X_next.cols() != X.cols()) ThrowPretty("Wrong size of X_next: " << X_next.rows() << "x" << X_next.cols() << ", expected " << X.rows() << "x" << X.cols());
+
+    const int num_samples = static_cast<int>(X.cols());
+    const bool is_euclidean = (num_positions_ == num_velocities_ && !has_quaternion_floating_base_);
+
+    // The implicit schemes solve for each sample separately
+    if (integrator_ == Integrator::ImplicitEuler || integrator_ == Integrator::LinearlyImplicitEuler)
+    {
+        for (int k = 0; k < num_samples; ++k)
+        {
+            X_next.col(k) = ImplicitEulerStep(X.col(k).template cast<double>(), U.col(k).template cast<double>()).template cast<Scalar>();
+        }
+        return;
+    }
+
+    const Scalar dt = static_cast<Scalar>(dt_);
+    BatchMatrix Xdot(get_num_state_derivative(), num_samples);
+    EvaluateBatch(X, U, Xdot);
+
+    switch (integrator_)
+    {
+        // Forward Euler (RK1), symplectic Euler
+        case Integrator::RK1:
+        case Integrator::SymplecticEuler:
+        {
+            if (!is_euclidean)
+            {
+                StateVector xout(get_num_state());
+                for (int k = 0; k < num_samples; ++k)
+                {
+                    Integrate(X.col(k).template cast<double>(), Xdot.col(k).template cast<double>(), dt_, xout);
+                    X_next.col(k) = xout.template cast<Scalar>();
+                }
+            }
+            else if (integrator_ == Integrator::RK1)
+            {
+                X_next.noalias() = X + dt * Xdot;
+            }
+            else
+            {
+                X_next.topRows(num_positions_).noalias() = X.topRows(num_positions_) + dt * X.bottomRows(num_velocities_) + (dt * dt) * Xdot.bottomRows(num_velocities_);
+                X_next.bottomRows(num_velocities_).noalias() = X.bottomRows(num_velocities_) + dt * Xdot.bottomRows(num_velocities_);
+            }
+        }
+        break;
+        // Explicit trapezoid rule (RK2)
+        case Integrator::RK2:
+        {
+            if (!is_euclidean) ThrowPretty("RK2 requires a Euclidean state space, use RK1 or SymplecticEuler.");
+
+            BatchMatrix Xdot1(get_num_state_derivative(), num_samples);
+            EvaluateBatch(X + dt * Xdot, U, Xdot1);
+            X_next.noalias() = X + (dt / Scalar(2)) * (Xdot + Xdot1);
+        }
+        break;
+        // Runge-Kutta 4
+        case Integrator::RK4:
+        {
+            if (!is_euclidean) ThrowPretty("RK4 requires a Euclidean state space, use RK1 or SymplecticEuler.");
+
+            BatchMatrix k2(get_num_state_derivative(), num_samples), k3(get_num_state_derivative(), num_samples), k4(get_num_state_derivative(), num_samples);
+            EvaluateBatch(X + (dt / Scalar(2)) * Xdot, U, k2);
+            EvaluateBatch(X + (dt / Scalar(2)) * k2, U, k3);
+            EvaluateBatch(X + dt * k3, U, k4);
+            X_next.noalias() = X + (dt / Scalar(6)) * (Xdot + Scalar(2) * k2 + Scalar(2) * k3 + k4);
+        }
+        break;
         default:
             ThrowPretty("Not implemented!");
     };
 }
 
+template <typename T, int NX, int NU>
+void AbstractDynamicsSolver<T, NX, NU>::SetDerivativesNumThreads(int num_threads)
+{
+    if (num_threads < 0) ThrowPretty("Invalid number of threads: " << num_threads);
+    derivatives_num_threads_ = Server::ResolveNumThreads(num_threads);
+}
+
 template <typename T, int NX, int NU>
 const Eigen::Matrix<T, NX, NX>& AbstractDynamicsSolver<T, NX, NU>::get_fx() const
 {
@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2018, University of Edinburgh
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_core/feedback_motion_solver.h>
+
+namespace exotica
+{
+namespace
+{
+// Deregisters a reader of a slot of the published policies when leaving the scope
+class PolicyReaderGuard
+{
+public:
+    explicit PolicyReaderGuard(std::atomic<int>& readers) : readers_(readers) {}
+    ~PolicyReaderGuard() { --readers_; }
+
+private:
+    std::atomic<int>& readers_;
+};
+}  // namespace
+
+FeedbackPolicy::FeedbackPolicy(DynamicsSolverPtr dynamics_solver, std::vector<Eigen::VectorXd> X_ref, std::vector<Eigen::VectorXd> U_ref, std::vector<Eigen::VectorXd> k, std::vector<Eigen::MatrixXd> K)
+    : dynamics_solver_(dynamics_solver), control_limits_(dynamics_solver ? dynamics_solver->get_control_limits() : Eigen::MatrixXd(0, 2)), X_ref_(std::move(X_ref)), U_ref_(std::move(U_ref)), k_(std::move(k)), K_(std::move(K))
+{
+    if (!dynamics_solver_) ThrowPretty("No dynamics solver given!");
+    if (X_ref_.size() != U_ref_.size() + 1 || k_.size() != U_ref_.size() || K_.size() != U_ref_.size())
+        ThrowPretty("Mismatching policy length: " << X_ref_.size() << " reference states, " << U_ref_.size() << " reference controls, " << k_.size() << " feed-forward terms and " << K_.size() << " feedback gains");
+}
+
+Eigen::VectorXd FeedbackPolicy::GetControl(Eigen::VectorXdRefConst x, int t) const
+{
+    if (t < 0 || t >= static_cast<int>(U_ref_.size())) ThrowPretty("Requested t=" << t << " out of range, needs to be 0 =< t < " << U_ref_.size());
+
+    Eigen::VectorXd u = U_ref_[t] + k_[t];
+    u.noalias() += K_[t] * dynamics_solver_->StateDelta(x, X_ref_[t]);
+    return u.cwiseMax(control_limits_.col(0)).cwiseMin(control_limits_.col(1));
+}
+
+FeedbackMotionSolver::FeedbackMotionSolver() : active_policy_(0)
+{
+    policy_readers_[0] = 0;
+    policy_readers_[1] = 0;
+}
+
+FeedbackPolicyConstPtr FeedbackMotionSolver::GetFeedbackPolicy() const
+{
+    const int slot = AcquirePublishedPolicy();
+    PolicyReaderGuard guard(policy_readers_[slot]);
+    return published_policies_[slot];
+}
+
+Eigen::VectorXd FeedbackMotionSolver::GetPublishedFeedbackControl(Eigen::VectorXdRefConst x, int t) const
+{
+    const int slot = AcquirePublishedPolicy();
+    PolicyReaderGuard guard(policy_readers_[slot]);
+    if (!published_policies_[slot]) ThrowPretty("No feedback policy has been published, call Solve first!");
+    return published_policies_[slot]->GetControl(x, t);
+}
+
+void FeedbackMotionSolver::PublishFeedbackPolicy(FeedbackPolicyConstPtr policy)
+{
+    const int slot = 1 - active_policy_.load();
+
+    // Readers of the inactive slot started before the last publication, they finish their evaluation shortly
+    while (policy_readers_[slot].load() != 0)
+    {
+    }
+    published_policies_[slot] = std::move(policy);
+    active_policy_.store(slot);
+}
+
+int FeedbackMotionSolver::AcquirePublishedPolicy() const
+{
+    while (true)
+    {
+        const int slot = active_policy_.load();
+        ++policy_readers_[slot];
+        // The slot may have been overwritten if a policy was published between the load and the registration
+        if (active_policy_.load() == slot) return slot;
+        --policy_readers_[slot];
+    }
+}
+}  // namespace exotica
@@ -31,6 +31,8 @@
 #include <iostream>
 #include <queue>
 #include <set>
+#include <stack>
+#include <thread>
 
 #include <eigen_conversions/eigen_kdl.h>
 #include <geometric_shapes/mesh_operations.h>
@@ -40,11 +42,11 @@
 #include <octomap_msgs/conversions.h>
 #include <tf_conversions/tf_kdl.h>
 #include <kdl/frames_io.hpp>
-#include <kdl_parser/kdl_parser.hpp>
 
 #include <exotica_core/kinematic_tree.h>
 #include <exotica_core/server.h>
 #include <exotica_core/tools.h>
+#include <exotica_core/tools/parallel_loop.h>
 
 namespace exotica
 {
@@ -61,11 +63,39 @@ KinematicResponse::KinematicResponse(KinematicRequestFlags _flags, int _size, in
     Hessian Hzero = Hessian::Constant(6, Eigen::MatrixXd::Zero(_n, _n));
     if (_flags & KIN_J) jacobian = ArrayJacobian::Constant(_size, Jzero);
     if (_flags & KIN_H) hessian = ArrayHessian::Constant(_size, Hzero);
+    if (_flags & KIN_J_DOT) jacobian_dot = ArrayJacobian::Constant(_size, Jzero);
+    if (_flags & KIN_PACKED) packed.setZero(12 * _size + ((_flags & KIN_J) ? 6 * _n * _size : 0));
     x.setZero(_n);
 }
 
+static bool IsSameFrameRequest(const KinematicFrameRequest& a, const KinematicFrameRequest& b)
+{
+    return a.frame_A_link_name == b.frame_A_link_name && a.frame_B_link_name == b.frame_B_link_name && KDL::Equal(a.frame_A_offset, b.frame_A_offset, 1e-12) && KDL::Equal(a.frame_B_offset, b.frame_B_offset, 1e-12);
+}
+
 KinematicsRequest::KinematicsRequest() = default;
 
+int KinematicsRequest::AddFrames(const std::vector<KinematicFrameRequest>& new_frames)
+{
+    const int num_requested = static_cast<int>(frames.size());
+    const int num_new = static_cast<int>(new_frames.size());
+    if (num_new == 0) return num_requested;
+
+    // Share the first run of requested frames which matches the new frames, or a head of them at the end of the request
+    for (int start = 0; start < num_requested; ++start)
+    {
+        int matched = 0;
+        while (matched < num_new && start + matched < num_requested && IsSameFrameRequest(frames[start + matched], new_frames[matched])) ++matched;
+        if (matched == num_new || start + matched == num_requested)
+        {
+            frames.insert(frames.end(), new_frames.begin() + matched, new_frames.end());
+            return start;
+        }
+    }
+    frames.insert(frames.end(), new_frames.begin(), new_frames.end());
+    return num_requested;
+}
+
 KinematicFrameRequest::KinematicFrameRequest() = default;
 
 KinematicFrameRequest::KinematicFrameRequest(std::string _frame_A_link_name, KDL::Frame _frame_A_offset, std::string _frame_B_link_name, KDL::Frame _frame_B_offset) : frame_A_link_name(_frame_A_link_name), frame_A_offset(_frame_A_offset), frame_B_link_name(_frame_B_link_name), frame_B_offset(_frame_B_offset)
@@ -81,11 +111,21 @@ KinematicSolution::KinematicSolution(int _start, int _length) : start(_start), l
 void KinematicSolution::Create(std::shared_ptr<KinematicResponse> solution)
 {
     if (start < 0 || length < 0) ThrowPretty("Kinematic solution was not initialized!");
+    frame = solution->frame.data() + start;
     new (&Phi) Eigen::Map<ArrayFrame>(solution->Phi.data() + start, length);
     new (&X) Eigen::Map<Eigen::VectorXd>(solution->x.data(), solution->x.rows());
     if (solution->flags & KIN_FK_VEL) new (&Phi_dot) Eigen::Map<ArrayTwist>(solution->Phi_dot.data() + start, length);
     if (solution->flags & KIN_J) new (&jacobian) Eigen::Map<ArrayJacobian>(solution->jacobian.data() + start, length);
+    if (solution->flags & KIN_J_DOT) new (&jacobian_dot) Eigen::Map<ArrayJacobian>(solution->jacobian_dot.data() + start, length);
     if (solution->flags & KIN_H) new (&hessian) Eigen::Map<ArrayHessian>(solution->hessian.data() + start, length);
+    if (solution->flags & KIN_PACKED)
+    {
+        const int size = solution->Phi.rows();
+        const int N = solution->x.rows();
+        new (&Phi_position) Eigen::Map<Eigen::Matrix3Xd>(solution->packed.data() + 3 * start, 3, length);
+        new (&Phi_rotation) Eigen::Map<Eigen::Matrix<double, 9, Eigen::Dynamic>>(solution->packed.data() + 3 * size + 9 * start, 9, length);
+        if (solution->flags & KIN_J) new (&jacobian_packed) Eigen::Map<Eigen::MatrixXd>(solution->packed.data() + 12 * size + 6 * N * start, 6, N * length);
+    }
 }
 
 int KinematicTree::GetNumControlledJoints() const
@@ -138,15 +178,8 @@ void KinematicTree::Instantiate(const std::string& joint_group, robot_model::Rob
     }
 
     model_ = model;
-    KDL::Tree robot_kinematics;
-    if (kdl_parser::treeFromUrdfModel(*model_->getURDF(), robot_kinematics))
-    {
-        BuildTree(robot_kinematics);
-    }
-    else
-    {
-        ThrowPretty("Can't load URDF model!");
-    }
+    kdl_tree_ = Server::GetKDLTree(model_);
+    BuildTree(*kdl_tree_);
 
     if (Server::IsRos())
     {
@@ -279,6 +312,8 @@ void KinematicTree::BuildTree(const KDL::Tree& robot_kinematics)
 
     UpdateModel();
     tree_state_.setZero();
+    full_tree_update_required_ = true;
+    tree_compiled_ = false;
 
     if (debug)
     {
@@ -331,6 +366,7 @@ void KinematicTree::BuildTree(const KDL::Tree& robot_kinematics)
 
     // Create random distributions for state sampling
     generator_ = std::mt19937(rd_());
+    bulk_seed_ = (static_cast<std::uint64_t>(rd_()) << 32) | rd_();
 
     // Add visual shapes
     const urdf::ModelInterfaceSharedPtr& urdf = model_->getURDF();
@@ -387,7 +423,7 @@ void KinematicTree::BuildTree(const KDL::Tree& robot_kinematics)
                         std::shared_ptr<urdf::Mesh> mesh = std::static_pointer_cast<urdf::Mesh>(ToStdPtr(urdf_visual->geometry));
                         visual.shape_resource_path = mesh->filename;
                         visual.scale = Eigen::Vector3d(mesh->scale.x, mesh->scale.y, mesh->scale.z);
-                        visual.shape = std::shared_ptr<shapes::Mesh>(shapes::createMeshFromResource(mesh->filename));
+                        visual.shape = Server::GetMesh(mesh->filename);
                     }
                     break;
                     default:
@@ -404,11 +440,19 @@ void KinematicTree::UpdateModel()
 {
     root_ = tree_[0].lock();
     tree_state_.conservativeResize(tree_.size());
-    for (std::weak_ptr<KinematicElement> joint : tree_)
+    // AddElement keeps the maps and the flattened tree up to date, the other changes require a rebuild
+    if (frame_handles_.size() != tree_.size())
     {
-        tree_map_[joint.lock()->segment.getName()] = joint.lock();
+        frame_handles_.clear();
+        for (std::weak_ptr<KinematicElement> joint : tree_)
+        {
+            tree_map_[joint.lock()->segment.getName()] = joint.lock();
+            frame_handles_.push_back(joint.lock().get());
+        }
+        full_tree_update_required_ = true;
+        tree_compiled_ = false;
     }
-    debug_tree_.resize(tree_.size() - 1);
+    debug_transforms_valid_ = false;
     UpdateTree();
     debug_scene_changed_ = true;
 }
@@ -419,6 +463,7 @@ void KinematicTree::ResetModel()
     tree_map_.clear();
     environment_tree_.clear();
     tree_.resize(model_tree_.size());
+    frame_handles_.clear();
     UpdateModel();
     debug_scene_changed_ = true;
 
@@ -476,7 +521,120 @@ void KinematicTree::ChangeParent(const std::string& name, const std::string& par
     child->parent_name = parent->segment.getName();
     parent->children.push_back(child);
     child->UpdateClosestRobotLink();
+    full_tree_update_required_ = true;
+    tree_compiled_ = false;
+    debug_scene_changed_ = true;
+}
+
+void KinematicTree::SetElementPose(const std::string& name, const KDL::Frame& pose)
+{
+    const auto it = tree_map_.find(name);
+    if (it == tree_map_.end() || it->second.expired()) ThrowPretty("Attempting to move unknown frame '" << name << "'!");
+    std::shared_ptr<KinematicElement> element = it->second.lock();
+    if (element->id < static_cast<int>(model_tree_.size())) ThrowPretty("Can't move robot link '" << name << "'!");
+    if (element->is_trajectory_generated) ThrowPretty("Can't move frame '" << name << "', its pose is generated by a trajectory!");
+    element->segment = KDL::Segment(element->segment.getName(), element->segment.getJoint(), pose, element->segment.getInertia());
+    if (tree_compiled_)
+    {
+        // The structure is unchanged, only the subtree of the element needs to be recomputed
+        flat_local_poses_[flat_index_[element->id + 1]] = element->GetPose();
+        changed_elements_.push_back(element->id);
+    }
+    debug_transforms_valid_ = false;
+}
+
+void KinematicTree::RemoveEnvironmentElement(const std::string& name)
+{
+    const auto it = tree_map_.find(name);
+    if (it == tree_map_.end() || it->second.expired()) ThrowPretty("Attempting to remove unknown frame '" << name << "'!");
+    const std::shared_ptr<KinematicElement> element = it->second.lock();
+
+    // Collect the element and its descendants, they are kept alive until the tree no longer refers to them
+    std::vector<std::shared_ptr<KinematicElement>> removed = {element};
+    std::vector<bool> is_removed(tree_.size(), false);
+    for (std::size_t i = 0; i < removed.size(); ++i)
+    {
+        const std::shared_ptr<KinematicElement> current = removed[i];
+        if (std::find(environment_tree_.begin(), environment_tree_.end(), current) == environment_tree_.end()) ThrowPretty("Can't remove '" << current->segment.getName() << "', it is not an environment element!");
+        is_removed[current->id] = true;
+        for (const std::weak_ptr<KinematicElement>& child : current->children)
+        {
+            if (!child.expired()) removed.push_back(child.lock());
+        }
+    }
+
+    std::shared_ptr<KinematicElement> parent = element->parent.lock();
+    parent->children.erase(std::remove_if(parent->children.begin(), parent->children.end(), [&element](const std::weak_ptr<KinematicElement>& child) { return child.lock() == element; }), parent->children.end());
+    for (const std::shared_ptr<KinematicElement>& current : removed)
+    {
+        tree_map_.erase(current->segment.getName());
+        collision_tree_map_.erase(current->segment.getName());
+    }
+    environment_tree_.erase(std::remove_if(environment_tree_.begin(), environment_tree_.end(), [&is_removed](const std::shared_ptr<KinematicElement>& current) { return is_removed[current->id]; }), environment_tree_.end());
+
+    if (tree_compiled_)
+    {
+        // The descendants of the element directly follow it, so the subtree is removed as one range
+        const int begin = flat_index_[element->id + 1];
+        const int end = flat_subtree_end_[begin];
+        const int count = end - begin;
+        flat_elements_.erase(flat_elements_.begin() + begin, flat_elements_.begin() + end);
+        flat_parents_.erase(flat_parents_.begin() + begin, flat_parents_.begin() + end);
+        flat_subtree_end_.erase(flat_subtree_end_.begin() + begin, flat_subtree_end_.begin() + end);
+        flat_state_index_.erase(flat_state_index_.begin() + begin, flat_state_index_.begin() + end);
+        flat_local_poses_.erase(flat_local_poses_.begin() + begin, flat_local_poses_.begin() + end);
+        flat_frames_.erase(flat_frames_.begin() + begin, flat_frames_.begin() + end);
+        for (std::size_t i = 0; i < flat_elements_.size(); ++i)
+        {
+            if (flat_parents_[i] >= end) flat_parents_[i] -= count;
+            if (flat_subtree_end_[i] >= end) flat_subtree_end_[i] -= count;
+        }
+        flat_trajectory_indices_.erase(std::remove_if(flat_trajectory_indices_.begin(), flat_trajectory_indices_.end(), [begin, end](int index) { return index >= begin && index < end; }), flat_trajectory_indices_.end());
+        for (int& index : flat_trajectory_indices_)
+        {
+            if (index >= end) index -= count;
+        }
+    }
+
+    // Compact the elements, the ids of the elements after the removed ones are decremented.
+    // The ids of environment elements are their indices in tree_.
+    const int num_model_elements = static_cast<int>(model_tree_.size());
+    std::vector<int> new_ids(tree_.size(), -1);
+    int num_elements = num_model_elements;
+    for (int id = num_model_elements; id < static_cast<int>(tree_.size()); ++id)
+    {
+        if (is_removed[id]) continue;
+        new_ids[id] = num_elements;
+        tree_[num_elements] = tree_[id];
+        frame_handles_[num_elements] = frame_handles_[id];
+        tree_state_(num_elements) = tree_state_(id);
+        ++num_elements;
+    }
+    tree_.resize(num_elements);
+    frame_handles_.resize(num_elements);
+    tree_state_.conservativeResize(num_elements);
+    for (int id = num_model_elements; id < num_elements; ++id) tree_[id].lock()->id = id;
+    for (int& id : changed_elements_)
+    {
+        if (id >= num_model_elements) id = new_ids[id];
+    }
+    changed_elements_.erase(std::remove(changed_elements_.begin(), changed_elements_.end(), -1), changed_elements_.end());
+    if (tree_compiled_)
+    {
+        flat_index_.assign(tree_.size() + 1, -1);
+        for (std::size_t i = 0; i < flat_elements_.size(); ++i) flat_index_[flat_elements_[i]->id + 1] = static_cast<int>(i);
+    }
+
+    debug_transforms_valid_ = false;
     debug_scene_changed_ = true;
+
+    // Remove the markers of the removed shapes
+    if (Server::IsRos())
+    {
+        visualization_msgs::Marker mrk;
+        mrk.action = 3;  // visualization_msgs::Marker::DELETEALL
+        marker_array_msg_.markers.push_back(mrk);
+    }
 }
 
 std::shared_ptr<KinematicElement> KinematicTree::AddEnvironmentElement(const std::string& name, const Eigen::Isometry3d& transform, const std::string& parent, shapes::ShapeConstPtr shape, const KDL::RigidBodyInertia& inertia, const Eigen::Vector4d& color, const std::vector<VisualElement>& visual, bool is_controlled)
@@ -507,7 +665,7 @@ std::shared_ptr<KinematicElement> KinematicTree::AddElement(const std::string& n
         ThrowPretty("Path cannot be resolved.");
     }
 
-    shapes::ShapePtr shape = shapes::ShapePtr(shapes::createMeshFromResource(shape_path, scale));
+    shapes::ShapePtr shape = Server::GetMesh(shape_path, scale);
     std::shared_ptr<KinematicElement> element = AddElement(name, transform, parent, shape, inertia, color, visual, is_controlled);
     element->shape_resource_path = shape_path;
     element->scale = scale;
@@ -523,17 +681,9 @@ std::shared_ptr<KinematicElement> KinematicTree::AddElement(const std::string& n
     }
     else
     {
-        bool found = false;
-        for (const auto& element : tree_)
-        {
-            if (element.lock()->segment.getName() == parent)
-            {
-                parent_element = element.lock();
-                found = true;
-                break;
-            }
-        }
-        if (!found) ThrowPretty("Can't find parent link named '" << parent << "'!");
+        const auto it = tree_map_.find(parent);
+        if (it != tree_map_.end()) parent_element = it->second.lock();
+        if (!parent_element) ThrowPretty("Can't find parent link named '" << parent << "'!");
     }
     KDL::Frame transform_kdl;
     tf::transformEigenToKDL(transform, transform_kdl);
@@ -549,10 +699,22 @@ std::shared_ptr<KinematicElement> KinematicTree::AddElement(const std::string& n
     new_element->parent_name = parent;
     new_element->is_controlled = is_controlled;
     tree_.push_back(new_element);
+    frame_handles_.push_back(new_element.get());
     parent_element->children.push_back(new_element);
     new_element->UpdateClosestRobotLink();
     tree_map_[name] = new_element;
     new_element->visual = visual;
+    if (tree_compiled_ && AppendFlatElement(new_element.get(), parent_element.get()))
+    {
+        // Only the frame of the new element needs to be computed
+        changed_elements_.push_back(new_element->id);
+    }
+    else
+    {
+        full_tree_update_required_ = true;
+        tree_compiled_ = false;
+    }
+    debug_transforms_valid_ = false;
     debug_scene_changed_ = true;
     return new_element;
 }
@@ -605,10 +767,37 @@ int KinematicTree::IsControlledLink(const std::string& link_name)
     return -1;
 }
 
+void KinematicTree::GetKinematicResponses(int T, std::vector<std::shared_ptr<KinematicResponse>>& responses)
+{
+    if (T < 0) ThrowPretty("Invalid number of responses: " << T);
+
+    // The pool can only be reused if no responses other than solution_ are still in use
+    bool reuse = response_pool_ && response_pool_version_ == request_version_ && static_cast<int>(response_pool_->size()) >= T;
+    if (reuse)
+    {
+        const bool solution_in_pool = !solution_.owner_before(response_pool_) && !response_pool_.owner_before(solution_);
+        reuse = response_pool_.use_count() == (solution_in_pool ? 2 : 1);
+    }
+
+    if (!reuse)
+    {
+        // Grow geometrically to avoid reallocating on every change of a receding horizon
+        std::size_t size = static_cast<std::size_t>(T);
+        if (response_pool_ && response_pool_version_ == request_version_) size = std::max(size, 2 * response_pool_->size());
+        response_pool_ = std::make_shared<std::vector<KinematicResponse>>(size, *solution_);
+        response_pool_version_ = request_version_;
+    }
+
+    responses.resize(T);
+    for (int t = 0; t < T; ++t) responses[t] = std::shared_ptr<KinematicResponse>(response_pool_, &(*response_pool_)[t]);
+}
+
 std::shared_ptr<KinematicResponse> KinematicTree::RequestFrames(const KinematicsRequest& request)
 {
     flags_ = request.flags;
     if (flags_ & KIN_H) flags_ = flags_ | KIN_J;
+    // Velocities are computed from the Jacobians
+    if (flags_ & KIN_FK_VEL || flags_ & KIN_J_DOT) flags_ = flags_ | KIN_J;
     solution_.reset(new KinematicResponse(flags_, request.frames.size(), num_controlled_joints_));
 
     state_size_ = num_controlled_joints_;
@@ -640,6 +829,7 @@ std::shared_ptr<KinematicResponse> KinematicTree::RequestFrames(const Kinematics
 
         solution_->frame[i].frame_A_offset = request.frames[i].frame_A_offset;
         solution_->frame[i].frame_B_offset = request.frames[i].frame_B_offset;
+        ComputeJacobianColumns(solution_->frame[i]);
     }
 
     if (debug)
@@ -650,61 +840,401 @@ std::shared_ptr<KinematicResponse> KinematicTree::RequestFrames(const Kinematics
         }
     }
 
-    debug_frames_.resize(solution_->frame.size() * 2);
+    debug_transforms_valid_ = false;
 
+    solution_->structure_version = structure_version_;
+    ++request_version_;
     return solution_;
 }
 
 void KinematicTree::Update(Eigen::VectorXdRefConst x)
+{
+    EXOTICA_PROFILE_SCOPE("KinematicTree::Update");
+    UpdateState(x);
+    if (backend_ == KINEMATICS_BACKEND_PINOCCHIO && flags_ & KIN_J)
+    {
+        UpdatePinocchio();
+    }
+    else
+    {
+        UpdateFK();
+        if (flags_ & KIN_J) UpdateJ();
+    }
+    if (flags_ & KIN_J && flags_ & KIN_H) UpdateH();
+    if (flags_ & KIN_PACKED) UpdatePacked(*solution_);
+    if (debug && publish_debug_frames) PublishFrames();
+}
+
+void KinematicTree::UpdateFrames(Eigen::VectorXdRefConst x)
+{
+    EXOTICA_PROFILE_SCOPE("KinematicTree::UpdateFrames");
+    UpdateState(x);
+    // The element frames are already up to date, composing the requested frames needs no Pinocchio
+    UpdateFK();
+    if (flags_ & KIN_PACKED) UpdatePacked(*solution_);
+}
+
+void KinematicTree::UpdateState(Eigen::VectorXdRefConst x)
 {
     if (x.size() != state_size_) ThrowPretty("Wrong state vector size! Got " << x.size() << " expected " << state_size_);
 
+    // Only joints whose position changed need their subtrees recomputed
     for (int i = 0; i < num_controlled_joints_; ++i)
-        tree_state_(controlled_joints_[i].lock()->id) = x(i);
+    {
+        const int id = controlled_joints_[i].lock()->id;
+        if (tree_state_(id) != x(i))
+        {
+            tree_state_(id) = x(i);
+            changed_elements_.push_back(id);
+        }
+    }
 
     // Store the updated state in the KinematicResponse (solution_)
     solution_->x = x;
 
     UpdateTree();
-    UpdateFK();
-    if (flags_ & KIN_J) UpdateJ();
-    if (flags_ & KIN_J && flags_ & KIN_H) UpdateH();
-    if (debug) PublishFrames();
+
+    RefreshStaleResponse();
 }
 
-void KinematicTree::UpdateTree()
+void KinematicTree::RefreshStaleResponse()
 {
-    std::queue<std::shared_ptr<KinematicElement>> elements;
-    elements.push(root_);
-    root_->RemoveExpiredChildren();
-    while (elements.size() > 0)
+    // Responses may be swapped in (SetKinematicResponse) after the structure of the tree changed
+    if (solution_->structure_version == structure_version_) return;
+    for (KinematicFrame& frame : solution_->frame) ComputeJacobianColumns(frame);
+    if (flags_ & KIN_H)
     {
-        auto element = elements.front();
+        for (int i = 0; i < solution_->hessian.size(); ++i)
+            for (int j = 0; j < solution_->hessian(i).size(); ++j) solution_->hessian(i)(j).setZero();
+    }
+    solution_->structure_version = structure_version_;
+}
+
+void KinematicTree::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRefConst x_dot)
+{
+    if (x_dot.size() != state_size_) ThrowPretty("Wrong velocity vector size! Got " << x_dot.size() << " expected " << state_size_);
+    Update(x);
+
+    if (flags_ & KIN_FK_VEL)
+    {
+        for (int i = 0; i < solution_->Phi_dot.rows(); ++i)
+        {
+            const Eigen::Matrix<double, 6, 1> twist = solution_->jacobian(i).data * x_dot;
+            for (int j = 0; j < 6; ++j) solution_->Phi_dot(i)[j] = twist(j);
+        }
+    }
+    if (flags_ & KIN_J_DOT) UpdateJdot(x_dot);
+}
+
+void KinematicTree::CompileTree()
+{
+    flat_elements_.clear();
+    flat_parents_.clear();
+    flat_state_index_.clear();
+    flat_local_poses_.clear();
+    flat_trajectory_indices_.clear();
+    flat_index_.assign(tree_.size() + 1, -1);
+
+    // Depth-first traversal, i.e., the descendants of every element directly follow it
+    std::stack<std::pair<std::shared_ptr<KinematicElement>, int>> elements;
+    elements.emplace(root_, -1);
+    while (!elements.empty())
+    {
+        const std::shared_ptr<KinematicElement> element = elements.top().first;
+        const int parent = elements.top().second;
         elements.pop();
-        // Elements with id > -1 have parent links.
-        // ID=-1 is the global world reference frame.
-        if (element->id > -1)
+
+        const int index = static_cast<int>(flat_elements_.size());
+        flat_elements_.push_back(element.get());
+        flat_parents_.push_back(parent);
+        flat_index_[element->id + 1] = index;
+        if (element->is_trajectory_generated)
+        {
+            flat_state_index_.push_back(-2);
+            flat_trajectory_indices_.push_back(index);
+        }
+        else if (element->id > -1 && element->segment.getJoint().getType() != KDL::Joint::JointType::None)
+        {
+            flat_state_index_.push_back(element->id);
+        }
+        else
+        {
+            flat_state_index_.push_back(-1);
+        }
+        flat_local_poses_.push_back(element->GetPose());
+
+        element->RemoveExpiredChildren();
+        for (auto child = element->children.rbegin(); child != element->children.rend(); ++child)
         {
-            if (element->segment.getJoint().getType() != KDL::Joint::JointType::None)
+            elements.emplace(child->lock(), index);
+        }
+    }
+
+    const int num_elements = static_cast<int>(flat_elements_.size());
+    flat_subtree_end_.resize(num_elements);
+    for (int i = 0; i < num_elements; ++i) flat_subtree_end_[i] = i + 1;
+    for (int i = num_elements - 1; i > 0; --i) flat_subtree_end_[flat_parents_[i]] = std::max(flat_subtree_end_[flat_parents_[i]], flat_subtree_end_[i]);
+    flat_frames_.resize(num_elements);
+    tree_compiled_ = true;
+}
+
+bool KinematicTree::AppendFlatElement(KinematicElement* element, KinematicElement* parent)
+{
+    const int num_elements = static_cast<int>(flat_elements_.size());
+    if (static_cast<int>(flat_index_.size()) != element->id + 1) return false;
+    const int parent_index = flat_index_[parent->id + 1];
+    // The descendants of every element have to stay contiguous
+    if (parent_index < 0 || flat_subtree_end_[parent_index] != num_elements) return false;
+
+    flat_elements_.push_back(element);
+    flat_parents_.push_back(parent_index);
+    flat_state_index_.push_back(-1);
+    flat_local_poses_.push_back(element->GetPose());
+    flat_frames_.push_back(flat_frames_[parent_index] * flat_local_poses_.back());
+    flat_index_.push_back(num_elements);
+    flat_subtree_end_.push_back(num_elements + 1);
+    for (int i = parent_index; i >= 0; i = flat_parents_[i]) flat_subtree_end_[i] = num_elements + 1;
+    return true;
+}
+
+/// \brief Whether two frames are exactly equal, unlike KDL::Equal which compares with a tolerance.
+static bool IsSameFrame(const KDL::Frame& a, const KDL::Frame& b)
+{
+    return std::equal(a.p.data, a.p.data + 3, b.p.data) && std::equal(a.M.data, a.M.data + 9, b.M.data);
+}
+
+void KinematicTree::UpdateTree()
+{
+    EXOTICA_PROFILE_SCOPE("KinematicTree::UpdateTree");
+    if (!tree_compiled_) CompileTree();
+    num_updated_elements_ = 0;
+    ++update_stamp_;
+
+    if (full_tree_update_required_)
+    {
+        UpdateFlatElements(0, static_cast<int>(flat_elements_.size()));
+        changed_elements_.clear();
+        full_tree_update_required_ = false;
+
+        // The structure of the tree may have changed
+        ++structure_version_;
+        return;
+    }
+
+    // Elements following a trajectory may have moved independently of the state
+    changed_flat_indices_.clear();
+    for (const int index : flat_trajectory_indices_)
+    {
+        if (!IsSameFrame(flat_elements_[index]->GetPose(), flat_local_poses_[index])) changed_flat_indices_.push_back(index);
+    }
+    for (const int id : changed_elements_) changed_flat_indices_.push_back(flat_index_[id + 1]);
+    changed_elements_.clear();
+
+    // Only subtrees without a changed ancestor are updated, each is a contiguous range
+    std::sort(changed_flat_indices_.begin(), changed_flat_indices_.end());
+    int end = 0;
+    for (const int index : changed_flat_indices_)
+    {
+        if (index < end) continue;
+        end = flat_subtree_end_[index];
+        UpdateFlatElements(index, end);
+    }
+}
+
+void KinematicTree::UpdateFlatElements(int begin, int end)
+{
+    for (int i = begin; i < end; ++i)
+    {
+        KinematicElement* element = flat_elements_[i];
+        const int state_index = flat_state_index_[i];
+        // NB: Trajectory-generated elements (including the root, to support
+        // trajectories for the base joint) use their generated pose.
+        const KDL::Frame local = state_index >= 0 ? element->segment.pose(tree_state_(state_index)) : (state_index == -1 ? flat_local_poses_[i] : element->GetPose());
+        if (state_index == -2) flat_local_poses_[i] = local;  // The generated pose the frame was computed from
+        flat_frames_[i] = flat_parents_[i] >= 0 ? flat_frames_[flat_parents_[i]] * local : local;
+        element->frame = flat_frames_[i];
+        element->frame_stamp = update_stamp_;
+    }
+    num_updated_elements_ += end - begin;
+}
+
+void KinematicTree::UpdateBatch(Eigen::MatrixXdRefConst X, std::vector<KinematicResponse>& out)
+{
+    UpdateBatch(X, out, batch_workspace_);
+}
+
+void KinematicTree::Update(Eigen::VectorXdRefConst x, KinematicWorkspace& workspace) const
+{
+    UpdateBatch(x, workspace.responses, workspace);
+}
+
+void KinematicTree::UpdateBatchFrames(Eigen::MatrixXdRefConst X, KinematicWorkspace& workspace) const
+{
+    EXOTICA_PROFILE_SCOPE("KinematicTree::UpdateBatchFrames");
+    if (X.rows() != state_size_) ThrowPretty("Wrong state matrix size! Got " << X.rows() << " rows, expected " << state_size_);
+    const int num_states = static_cast<int>(X.cols());
+
+    // Flatten the tree in breadth-first order, i.e., every parent precedes its children.
+    // The tree is not modified, expired children are skipped instead of removed.
+    workspace.elements.clear();
+    workspace.parents.clear();
+    workspace.index.assign(tree_.size() + 1, -1);
+    workspace.elements.push_back(root_.get());
+    workspace.parents.push_back(-1);
+    for (std::size_t i = 0; i < workspace.elements.size(); ++i)
+    {
+        const KinematicElement* element = workspace.elements[i];
+        workspace.index[element->id + 1] = static_cast<int>(i);
+        for (const std::weak_ptr<KinematicElement>& child : element->children)
+        {
+            if (child.expired()) continue;
+            workspace.elements.push_back(child.lock().get());
+            workspace.parents.push_back(static_cast<int>(i));
+        }
+    }
+
+    // Compute the world frames of all elements for all states.
+    workspace.frames.resize(workspace.elements.size() * num_states);
+    for (std::size_t i = 0; i < workspace.elements.size(); ++i)
+    {
+        const KinematicElement* element = workspace.elements[i];
+        KDL::Frame* frames = &workspace.frames[i * num_states];
+        if (workspace.parents[i] == -1)
+        {
+            const KDL::Frame pose = element->GetPose();
+            for (int n = 0; n < num_states; ++n) frames[n] = pose;
+        }
+        else
+        {
+            const KDL::Frame* parent_frames = &workspace.frames[workspace.parents[i] * num_states];
+            if (element->control_id >= 0)
             {
-                element->frame = element->parent.lock()->frame * element->GetPose(tree_state_(element->id));
+                for (int n = 0; n < num_states; ++n) frames[n] = parent_frames[n] * element->GetPose(X(element->control_id, n));
             }
             else
             {
-                element->frame = element->parent.lock()->frame * element->GetPose();
+                // Uncontrolled joints keep their current position in the model state.
+                const KDL::Frame pose = element->segment.getJoint().getType() != KDL::Joint::JointType::None ? element->GetPose(tree_state_(element->id)) : element->GetPose();
+                for (int n = 0; n < num_states; ++n) frames[n] = parent_frames[n] * pose;
             }
         }
-        // Root of tree.
-        else
+    }
+}
+
+void KinematicTree::UpdateBatch(Eigen::MatrixXdRefConst X, std::vector<KinematicResponse>& out, KinematicWorkspace& workspace) const
+{
+    EXOTICA_PROFILE_SCOPE("KinematicTree::UpdateBatch");
+    UpdateBatchFrames(X, workspace);
+    const int num_states = static_cast<int>(X.cols());
+
+    // Fill in the responses.
+    const std::size_t num_frames = solution_->frame.size();
+    out.resize(num_states);
+    for (int n = 0; n < num_states; ++n)
+    {
+        KinematicResponse& response = out[n];
+        if (response.flags != flags_ || response.frame.size() != num_frames || response.x.size() != num_controlled_joints_)
         {
-            // NB: We could simply set KDL::Frame() here, however, to support
-            // trajectories for the base joint, we return GetPose();
-            element->frame = element->GetPose();
+            response = KinematicResponse(flags_, num_frames, num_controlled_joints_);
         }
-        element->RemoveExpiredChildren();
-        for (std::weak_ptr<KinematicElement> child : element->children)
+        response.frame = solution_->frame;
+        if (solution_->structure_version != structure_version_)
         {
-            elements.push(child.lock());
+            for (KinematicFrame& frame : response.frame) ComputeJacobianColumns(frame);
+        }
+        response.x = X.col(n);
+    }
+
+    for (std::size_t i = 0; i < num_frames; ++i)
+    {
+        const KinematicFrame& frame = solution_->frame[i];
+        const int index_A = workspace.index[frame.frame_A.lock()->id + 1];
+        const int index_B = workspace.index[frame.frame_B.lock()->id + 1];
+        for (int n = 0; n < num_states; ++n)
+        {
+            KinematicFrame& batch_frame = out[n].frame[i];
+            batch_frame.temp_A = workspace.frames[index_A * num_states + n] * frame.frame_A_offset;
+            batch_frame.temp_B = workspace.frames[index_B * num_states + n] * frame.frame_B_offset;
+            batch_frame.temp_AB = batch_frame.temp_B.Inverse() * batch_frame.temp_A;
+            out[n].Phi(i) = batch_frame.temp_AB;
+
+            if (flags_ & KIN_J)
+            {
+                KDL::Jacobian& jacobian = out[n].jacobian(i);
+                ComputeBatchJ(X, n, workspace, index_A, batch_frame.temp_A, index_B, batch_frame.temp_B, jacobian);
+
+                if (flags_ & KIN_H)
+                {
+                    // The responses may be reused from a tree with different chains
+                    for (int j = 0; j < out[n].hessian(i).size(); ++j) out[n].hessian(i)(j).setZero();
+                    ComputeH(batch_frame, jacobian, out[n].hessian(i));
+                }
+            }
+        }
+    }
+
+    if (flags_ & KIN_PACKED)
+    {
+        for (int n = 0; n < num_states; ++n) UpdatePacked(out[n]);
+    }
+}
+
+void KinematicTree::ComputeBatchJ(Eigen::MatrixXdRefConst X, int n, const KinematicWorkspace& workspace, int index_A, const KDL::Frame& frame_A, int index_B, const KDL::Frame& frame_B, KDL::Jacobian& jacobian) const
+{
+    const int num_states = static_cast<int>(X.cols());
+    jacobian.data.setZero();
+    const KDL::Rotation B_inverse = frame_B.M.Inverse();
+    for (int index = index_A; index != -1; index = workspace.parents[index])
+    {
+        const KinematicElement* it = workspace.elements[index];
+        if (it->control_id < 0) continue;
+        const KDL::Rotation segment_reference = workspace.parents[index] != -1 ? workspace.frames[workspace.parents[index] * num_states + n].M : KDL::Rotation::Identity();
+        jacobian.setColumn(it->control_id, B_inverse * (segment_reference * it->segment.twist(X(it->control_id, n), 1.0)).RefPoint(frame_A.p - workspace.frames[index * num_states + n].p));
+    }
+    for (int index = index_B; index != -1; index = workspace.parents[index])
+    {
+        const KinematicElement* it = workspace.elements[index];
+        if (it->control_id < 0) continue;
+        const KDL::Rotation segment_reference = workspace.parents[index] != -1 ? workspace.frames[workspace.parents[index] * num_states + n].M : KDL::Rotation::Identity();
+        jacobian.setColumn(it->control_id, jacobian.getColumn(it->control_id) - (B_inverse * (segment_reference * it->segment.twist(X(it->control_id, n), 1.0)).RefPoint(frame_A.p - workspace.frames[index * num_states + n].p)));
+    }
+}
+
+void KinematicTree::FKBatch(Eigen::MatrixXdRefConst X, const std::string& element_A, const KDL::Frame& offset_a, const std::string& element_B, const KDL::Frame& offset_b, std::vector<KDL::Frame>& poses, std::vector<KDL::Jacobian>* jacobians)
+{
+    FKBatch(X, element_A, offset_a, element_B, offset_b, poses, jacobians, batch_workspace_);
+}
+
+void KinematicTree::FKBatch(Eigen::MatrixXdRefConst X, const std::string& element_A, const KDL::Frame& offset_a, const std::string& element_B, const KDL::Frame& offset_b, std::vector<KDL::Frame>& poses, std::vector<KDL::Jacobian>* jacobians, KinematicWorkspace& workspace) const
+{
+    EXOTICA_PROFILE_SCOPE("KinematicTree::FKBatch");
+    const std::string name_a = element_A == "" ? root_->segment.getName() : element_A;
+    const std::string name_b = element_B == "" ? root_->segment.getName() : element_B;
+    auto A = tree_map_.find(name_a);
+    if (A == tree_map_.end()) ThrowPretty("Can't find link '" << name_a << "'!");
+    auto B = tree_map_.find(name_b);
+    if (B == tree_map_.end()) ThrowPretty("Can't find link '" << name_b << "'!");
+    std::shared_ptr<KinematicElement> element_a = A->second.lock();
+    std::shared_ptr<KinematicElement> element_b = B->second.lock();
+    if (!element_a || !element_b) ThrowPretty("The pointer to a KinematicElement is dead.");
+
+    UpdateBatchFrames(X, workspace);
+    const int num_states = static_cast<int>(X.cols());
+    const int index_A = workspace.index[element_a->id + 1];
+    const int index_B = workspace.index[element_b->id + 1];
+
+    poses.resize(num_states);
+    if (jacobians != nullptr) jacobians->resize(num_states, KDL::Jacobian(num_controlled_joints_));
+    for (int n = 0; n < num_states; ++n)
+    {
+        const KDL::Frame frame_A = workspace.frames[index_A * num_states + n] * offset_a;
+        const KDL::Frame frame_B = workspace.frames[index_B * num_states + n] * offset_b;
+        poses[n] = frame_B.Inverse() * frame_A;
+        if (jacobians != nullptr)
+        {
+            KDL::Jacobian& jacobian = (*jacobians)[n];
+            if (jacobian.columns() != static_cast<unsigned int>(num_controlled_joints_)) jacobian.resize(num_controlled_joints_);
+            ComputeBatchJ(X, n, workspace, index_A, frame_A, index_B, frame_B, jacobian);
         }
     }
 }
@@ -715,28 +1245,41 @@ void KinematicTree::PublishFrames(const std::string& tf_prefix)
     {
         const ros::Time timestamp = ros::Time::now();
 
-        // Step 1: Publish frames for every element in the tree.
-        {
-            int i = 0;
-            for (std::weak_ptr<KinematicElement> element : tree_)
+        // Step 1: Publish frames for every element in the tree and the requested frames that changed.
+        if (!debug_transforms_valid_ || tf_prefix != debug_tf_prefix_) BuildDebugTransforms(tf_prefix);
+        const bool publish_all = (timestamp - debug_full_publish_time_).toSec() >= publish_frames_keepalive;
+        if (publish_all) debug_full_publish_time_ = timestamp;
+
+        std::size_t i = 0;
+        debug_changed_indices_.clear();
+        auto update_transform = [&](const KDL::Frame& pose) {
+            KDL::Frame& published = debug_published_frames_[i];
+            const KDL::Twist delta = KDL::diff(published, pose);
+            if (publish_all || delta.vel.Norm() > publish_frames_threshold || delta.rot.Norm() > publish_frames_threshold)
             {
-                tf::Transform T;
-                tf::transformKDLToTF(element.lock()->frame, T);
-                if (i > 0) debug_tree_[i - 1] = tf::StampedTransform(T, timestamp, tf::resolve(tf_prefix, GetRootFrameName()), tf::resolve(tf_prefix, element.lock()->segment.getName()));
-                ++i;
+                published = pose;
+                tf::transformKDLToMsg(pose, debug_transforms_[i].transform);
+                debug_transforms_[i].header.stamp = timestamp;
+                debug_changed_indices_.push_back(i);
             }
-            Server::SendTransform(debug_tree_);
-            i = 0;
-            for (KinematicFrame& frame : solution_->frame)
-            {
-                tf::Transform T;
-                tf::transformKDLToTF(frame.temp_B, T);
-                debug_frames_[i * 2] = tf::StampedTransform(T, timestamp, tf::resolve(tf_prefix, GetRootFrameName()), tf::resolve(tf_prefix, "Frame" + std::to_string(i) + "B" + frame.frame_B.lock()->segment.getName()));
-                tf::transformKDLToTF(frame.temp_AB, T);
-                debug_frames_[i * 2 + 1] = tf::StampedTransform(T, timestamp, tf::resolve(tf_prefix, "Frame" + std::to_string(i) + "B" + frame.frame_B.lock()->segment.getName()), tf::resolve(tf_prefix, "Frame" + std::to_string(i) + "A" + frame.frame_A.lock()->segment.getName()));
-                ++i;
-            }
-            Server::SendTransform(debug_frames_);
+            ++i;
+        };
+        for (std::size_t j = 1; j < tree_.size(); ++j) update_transform(tree_[j].lock()->frame);
+        for (const KinematicFrame& frame : solution_->frame)
+        {
+            update_transform(frame.temp_B);
+            update_transform(frame.temp_AB);
+        }
+
+        if (debug_changed_indices_.size() == debug_transforms_.size())
+        {
+            Server::SendTransform(debug_transforms_);
+        }
+        else if (!debug_changed_indices_.empty())
+        {
+            debug_changed_transforms_.resize(debug_changed_indices_.size());
+            for (std::size_t n = 0; n < debug_changed_indices_.size(); ++n) debug_changed_transforms_[n] = debug_transforms_[debug_changed_indices_[n]];
+            Server::SendTransform(debug_changed_transforms_);
         }
 
         // Step 2: Publish visualisation markers for non-robot-model elements in the tree.
@@ -799,6 +1342,32 @@ void KinematicTree::PublishFrames(const std::string& tf_prefix)
     }
 }
 
+void KinematicTree::BuildDebugTransforms(const std::string& tf_prefix)
+{
+    const std::string root_frame_id = tf::resolve(tf_prefix, GetRootFrameName());
+    debug_transforms_.clear();
+    debug_transforms_.reserve(tree_.size() - 1 + 2 * solution_->frame.size());
+    auto add_transform = [this](const std::string& frame_id, const std::string& child_frame_id) {
+        geometry_msgs::TransformStamped transform;
+        transform.header.frame_id = frame_id;
+        transform.child_frame_id = child_frame_id;
+        debug_transforms_.push_back(transform);
+    };
+    for (std::size_t i = 1; i < tree_.size(); ++i) add_transform(root_frame_id, tf::resolve(tf_prefix, tree_[i].lock()->segment.getName()));
+    for (std::size_t i = 0; i < solution_->frame.size(); ++i)
+    {
+        const KinematicFrame& frame = solution_->frame[i];
+        const std::string frame_B_id = tf::resolve(tf_prefix, "Frame" + std::to_string(i) + "B" + frame.frame_B.lock()->segment.getName());
+        add_transform(root_frame_id, frame_B_id);
+        add_transform(frame_B_id, tf::resolve(tf_prefix, "Frame" + std::to_string(i) + "A" + frame.frame_A.lock()->segment.getName()));
+    }
+    debug_published_frames_.assign(debug_transforms_.size(), KDL::Frame::Identity());
+    debug_tf_prefix_ = tf_prefix;
+    debug_transforms_valid_ = true;
+    // Publish everything on the next call
+    debug_full_publish_time_ = ros::Time();
+}
+
 KDL::Frame KinematicTree::FK(KinematicFrame& frame) const
 {
     frame.temp_A = frame.frame_A.lock()->frame * frame.frame_A_offset;
@@ -829,8 +1398,59 @@ KDL::Frame KinematicTree::FK(const std::string& element_A, const KDL::Frame& off
     return FK(A->second.lock(), offset_a, B->second.lock(), offset_b);
 }
 
+int KinematicTree::GetFrameHandle(const std::string& name) const
+{
+    if (name == "") return 0;
+    auto it = tree_map_.find(name);
+    if (it == tree_map_.end()) ThrowPretty("Can't find link '" << name << "'!");
+    const auto handle = std::find(frame_handles_.begin(), frame_handles_.end(), it->second.lock().get());
+    if (handle == frame_handles_.end()) ThrowPretty("Link '" << name << "' is not part of the tree!");
+    return static_cast<int>(handle - frame_handles_.begin());
+}
+
+KDL::Frame KinematicTree::FK(int handle_A, const KDL::Frame& offset_a, int handle_B, const KDL::Frame& offset_b) const
+{
+    if (handle_A < 0 || handle_A >= static_cast<int>(frame_handles_.size())) ThrowPretty("Invalid frame handle " << handle_A);
+    if (handle_B < 0 || handle_B >= static_cast<int>(frame_handles_.size())) ThrowPretty("Invalid frame handle " << handle_B);
+    return (frame_handles_[handle_B]->frame * offset_b).Inverse() * (frame_handles_[handle_A]->frame * offset_a);
+}
+
+Eigen::MatrixXd KinematicTree::Jacobian(int handle_A, const KDL::Frame& offset_a, int handle_B, const KDL::Frame& offset_b) const
+{
+    if (handle_A < 0 || handle_A >= static_cast<int>(frame_handles_.size())) ThrowPretty("Invalid frame handle " << handle_A);
+    if (handle_B < 0 || handle_B >= static_cast<int>(frame_handles_.size())) ThrowPretty("Invalid frame handle " << handle_B);
+    if (!tree_compiled_) return Jacobian(tree_[handle_A].lock(), offset_a, tree_[handle_B].lock(), offset_b);
+    return Jacobian(frame_handles_[handle_A], offset_a, frame_handles_[handle_B], offset_b);
+}
+
+exotica::Hessian KinematicTree::Hessian(int handle_A, const KDL::Frame& offset_a, int handle_B, const KDL::Frame& offset_b) const
+{
+    if (handle_A < 0 || handle_A >= static_cast<int>(frame_handles_.size())) ThrowPretty("Invalid frame handle " << handle_A);
+    if (handle_B < 0 || handle_B >= static_cast<int>(frame_handles_.size())) ThrowPretty("Invalid frame handle " << handle_B);
+    if (!tree_compiled_) return this->Hessian(tree_[handle_A].lock(), offset_a, tree_[handle_B].lock(), offset_b);
+    return this->Hessian(frame_handles_[handle_A], offset_a, frame_handles_[handle_B], offset_b);
+}
+
+Eigen::MatrixXd KinematicTree::Jacobian(const KinematicElement* element_A, const KDL::Frame& offset_a, const KinematicElement* element_B, const KDL::Frame& offset_b) const
+{
+    KDL::Jacobian ret(num_controlled_joints_);
+    ComputeJ(element_A, offset_a, element_B, offset_b, ret, nullptr);
+    return ret.data;
+}
+
+exotica::Hessian KinematicTree::Hessian(const KinematicElement* element_A, const KDL::Frame& offset_a, const KinematicElement* element_B, const KDL::Frame& offset_b) const
+{
+    std::vector<int> jacobian_columns;
+    KDL::Jacobian J(num_controlled_joints_);
+    ComputeJ(element_A, offset_a, element_B, offset_b, J, &jacobian_columns);
+    exotica::Hessian hessian = exotica::Hessian::Constant(6, Eigen::MatrixXd::Zero(num_controlled_joints_, num_controlled_joints_));
+    ComputeH(jacobian_columns, J, hessian);
+    return hessian;
+}
+
 void KinematicTree::UpdateFK()
 {
+    EXOTICA_PROFILE_SCOPE("KinematicTree::UpdateFK");
     int i = 0;
     for (KinematicFrame& frame : solution_->frame)
     {
@@ -871,6 +1491,7 @@ exotica::Hessian KinematicTree::Hessian(std::shared_ptr<KinematicElement> elemen
     frame.frame_B = (element_B == nullptr) ? root_ : element_B;
     frame.frame_A_offset = offset_a;
     frame.frame_B_offset = offset_b;
+    ComputeJacobianColumns(frame);
     KDL::Jacobian J(num_controlled_joints_);
     ComputeJ(frame, J);
     exotica::Hessian hessian = exotica::Hessian::Constant(6, Eigen::MatrixXd::Zero(num_controlled_joints_, num_controlled_joints_));
@@ -917,22 +1538,75 @@ void KinematicTree::ComputeJ(KinematicFrame& frame, KDL::Jacobian& jacobian) con
     }
 }
 
+void KinematicTree::ComputeJ(const KinematicElement* element_A, const KDL::Frame& offset_a, const KinematicElement* element_B, const KDL::Frame& offset_b, KDL::Jacobian& jacobian, std::vector<int>* jacobian_columns) const
+{
+    jacobian.data.setZero();
+    if (jacobian_columns) jacobian_columns->clear();
+    const KDL::Frame frame_A = element_A->frame * offset_a;
+    const KDL::Rotation B_inverse = (element_B->frame * offset_b).M.Inverse();
+    double sign = 1.0;
+    for (const KinematicElement* end : {element_A, element_B})
+    {
+        for (int index = flat_index_[end->id + 1]; index != -1; index = flat_parents_[index])
+        {
+            const KinematicElement* it = flat_elements_[index];
+            if (!it->is_controlled) continue;
+            const KDL::Rotation segment_reference = flat_parents_[index] != -1 ? flat_elements_[flat_parents_[index]]->frame.M : KDL::Rotation::Identity();
+            jacobian.setColumn(it->control_id, jacobian.getColumn(it->control_id) + sign * (B_inverse * (segment_reference * it->segment.twist(tree_state_(it->id), 1.0)).RefPoint(frame_A.p - it->frame.p)));
+            if (jacobian_columns) jacobian_columns->push_back(it->control_id);
+        }
+        sign = -1.0;
+    }
+    if (jacobian_columns)
+    {
+        std::sort(jacobian_columns->begin(), jacobian_columns->end());
+        jacobian_columns->erase(std::unique(jacobian_columns->begin(), jacobian_columns->end()), jacobian_columns->end());
+    }
+}
+
+void KinematicTree::ComputeJacobianColumns(KinematicFrame& frame) const
+{
+    frame.jacobian_columns.clear();
+    if (frame.frame_A.expired() || frame.frame_B.expired()) return;
+
+    for (const std::weak_ptr<KinematicElement>& end : {frame.frame_A, frame.frame_B})
+    {
+        for (std::shared_ptr<KinematicElement> it = end.lock(); it != nullptr; it = it->parent.lock())
+        {
+            if (it->is_controlled) frame.jacobian_columns.push_back(it->control_id);
+        }
+    }
+    // Joints shared by both chains are kept: their contributions cancel numerically but not structurally
+    std::sort(frame.jacobian_columns.begin(), frame.jacobian_columns.end());
+    frame.jacobian_columns.erase(std::unique(frame.jacobian_columns.begin(), frame.jacobian_columns.end()), frame.jacobian_columns.end());
+}
+
 void KinematicTree::ComputeH(KinematicFrame& frame, const KDL::Jacobian& jacobian, exotica::Hessian& hessian) const
 {
-    hessian.conservativeResize(6);
-    for (int i = 0; i < 6; ++i)
+    ComputeH(frame.jacobian_columns, jacobian, hessian);
+}
+
+void KinematicTree::ComputeH(const std::vector<int>& jacobian_columns, const KDL::Jacobian& jacobian, exotica::Hessian& hessian) const
+{
+    // Only the entries of the joints in the kinematic chain of the frame are
+    // written. All other entries are structurally zero and are only cleared
+    // when the storage is (re)allocated - the callers clear the Hessian when
+    // the chain of the frame changes.
+    if (hessian.size() != 6 || hessian(0).rows() != jacobian.columns() || hessian(0).cols() != jacobian.columns())
     {
-        hessian(i).resize(jacobian.columns(), jacobian.columns());
-        hessian(i).setZero();
+        hessian = exotica::Hessian::Constant(6, Eigen::MatrixXd::Zero(jacobian.columns(), jacobian.columns()));
     }
 
     KDL::Twist axis;
 
-    for (int i = 0; i < jacobian.columns(); ++i)
+    const std::vector<int>& columns = jacobian_columns;
+    for (std::size_t k = 0; k < columns.size(); ++k)
     {
+        const int i = columns[k];
         axis.rot = jacobian.getColumn(i).rot;
-        for (int j = i; j < jacobian.columns(); ++j)
+        for (std::size_t l = k; l < columns.size(); ++l)
         {
+            const int j = columns[l];
             KDL::Twist Hij = axis * jacobian.getColumn(j);
             hessian(0)(i, j) = Hij[0];
             hessian(1)(i, j) = Hij[1];
@@ -950,23 +1624,87 @@ void KinematicTree::ComputeH(KinematicFrame& frame, const KDL::Jacobian& jacobia
     }
 }
 
+void KinematicTree::SetNumThreads(int num_threads, int parallel_threshold)
+{
+    if (num_threads < 0) ThrowPretty("Invalid number of threads: " << num_threads);
+    num_threads = Server::ResolveNumThreads(num_threads);
+    num_threads_ = num_threads;
+    parallel_threshold_ = parallel_threshold;
+}
+
+// The frames are independent once the tree has been updated. Each frame is
+// written by exactly one thread, hence the result does not depend on the
+// number of threads.
 void KinematicTree::UpdateJ()
 {
-    int i = 0;
-    for (KinematicFrame& frame : solution_->frame)
+    EXOTICA_PROFILE_SCOPE("KinematicTree::UpdateJ");
+    const int num_frames = static_cast<int>(solution_->frame.size());
+    ParallelLoop(num_frames >= parallel_threshold_ ? num_threads_ : 1, num_frames, [&](int, int i) { ComputeJ(solution_->frame[i], solution_->jacobian(i)); });
+}
+
+void KinematicTree::UpdateH()
+{
+    EXOTICA_PROFILE_SCOPE("KinematicTree::UpdateH");
+    const int num_frames = static_cast<int>(solution_->frame.size());
+    ParallelLoop(num_frames >= parallel_threshold_ ? num_threads_ : 1, num_frames, [&](int, int i) { ComputeH(solution_->frame[i], solution_->jacobian(i), solution_->hessian(i)); });
+}
+
+void KinematicTree::UpdateJdot(Eigen::VectorXdRefConst x_dot)
+{
+    EXOTICA_PROFILE_SCOPE("KinematicTree::UpdateJdot");
+    for (int i = 0; i < solution_->jacobian_dot.rows(); ++i)
     {
-        ComputeJ(frame, solution_->jacobian(i));
-        ++i;
+        ComputeJdot(solution_->frame[i], solution_->jacobian(i), x_dot, solution_->jacobian_dot(i));
     }
 }
 
-void KinematicTree::UpdateH()
+// Contracts the Hessian computed in ComputeH with the joint velocities without
+// forming it, i.e., jacobian_dot(m, a) = sum_b hessian(m)(a, b) * x_dot(b).
+void KinematicTree::ComputeJdot(const KinematicFrame& frame, const KDL::Jacobian& jacobian, Eigen::VectorXdRefConst x_dot, KDL::Jacobian& jacobian_dot) const
 {
-    int i = 0;
-    for (KinematicFrame& frame : solution_->frame)
+    jacobian_dot.data.setZero();
+    KDL::Twist axis;
+
+    const std::vector<int>& columns = frame.jacobian_columns;
+    for (std::size_t k = 0; k < columns.size(); ++k)
     {
-        ComputeH(frame, solution_->jacobian(i), solution_->hessian(i));
-        ++i;
+        const int i = columns[k];
+        axis.rot = jacobian.getColumn(i).rot;
+        for (std::size_t l = k; l < columns.size(); ++l)
+        {
+            const int j = columns[l];
+            const KDL::Twist Hij = axis * jacobian.getColumn(j);
+            for (int m = 0; m < 3; ++m)
+            {
+                jacobian_dot.data(m, i) += Hij[m] * x_dot(j);
+                if (i != j) jacobian_dot.data(m, j) += Hij[m] * x_dot(i);
+            }
+            if (i != j)
+            {
+                for (int m = 3; m < 6; ++m) jacobian_dot.data(m, j) += Hij[m] * x_dot(i);
+            }
+        }
+    }
+}
+
+void KinematicTree::UpdatePacked(KinematicResponse& response) const
+{
+    EXOTICA_PROFILE_SCOPE("KinematicTree::UpdatePacked");
+    const int size = response.Phi.rows();
+    const int N = response.x.rows();
+    Eigen::Map<Eigen::Matrix3Xd> position(response.packed.data(), 3, size);
+    Eigen::Map<Eigen::Matrix<double, 9, Eigen::Dynamic>> rotation(response.packed.data() + 3 * size, 9, size);
+    for (int i = 0; i < size; ++i)
+    {
+        position.col(i) = Eigen::Map<const Eigen::Vector3d>(response.Phi(i).p.data);
+        // KDL stores rotations row-major
+        Eigen::Map<Eigen::Matrix3d>(rotation.col(i).data()) = Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor>>(response.Phi(i).M.data);
+    }
+
+    if (response.flags & KIN_J)
+    {
+        Eigen::Map<Eigen::MatrixXd> jacobian(response.packed.data() + 12 * size, 6, N * size);
+        for (int i = 0; i < size; ++i) jacobian.middleCols(i * N, N) = response.jacobian(i).data;
     }
 }
 
@@ -1005,6 +1743,25 @@ Eigen::VectorXd KinematicTree::GetRandomControlledState()
     return q_rand;
 }
 
+void KinematicTree::GetRandomControlledStates(Eigen::MatrixXdRef states, std::uint64_t stream, std::uint64_t offset) const
+{
+    if (states.rows() != num_controlled_joints_) ThrowPretty("Wrong number of rows! Got " << states.rows() << " expected " << num_controlled_joints_);
+
+    const Eigen::VectorXd lower = joint_limits_.col(LIMIT_POSITION_LOWER);
+    const Eigen::VectorXd range = joint_limits_.col(LIMIT_POSITION_UPPER) - lower;
+    const std::uint64_t key = SplitMix64(bulk_seed_ ^ SplitMix64(stream));
+    const int num_samples = static_cast<int>(states.cols());
+    ParallelLoop(num_samples >= parallel_threshold_ ? num_threads_ : 1, num_samples, [&](int, int k) {
+        const std::uint64_t counter = (offset + static_cast<std::uint64_t>(k)) * static_cast<std::uint64_t>(num_controlled_joints_);
+        for (int i = 0; i < num_controlled_joints_; ++i)
+        {
+            // 53 random bits mapped to [0, 1)
+            const double u = static_cast<double>(SplitMix64(key + counter + i) >> 11) / 9007199254740992.0;
+            states(i, k) = lower(i) + u * range(i);
+        }
+    });
+}
+
 void KinematicTree::SetJointLimitsLower(Eigen::VectorXdRefConst lower_in)
 {
     if (lower_in.rows() == num_controlled_joints_)
@@ -1353,10 +2110,14 @@ void KinematicTree::SetModelState(Eigen::VectorXdRefConst x)
     {
         tree_state_(model_joints_map_.at(model_joints_names_[i]).lock()->id) = x(i);
     }
+    full_tree_update_required_ = true;
     UpdateTree();
+
+    RefreshStaleResponse();
+
     UpdateFK();
     if (flags_ & KIN_J) UpdateJ();
-    if (debug) PublishFrames();
+    if (debug && publish_debug_frames) PublishFrames();
 }
 
 void KinematicTree::SetModelState(const std::map<std::string, double>& x)
@@ -1372,10 +2133,14 @@ void KinematicTree::SetModelState(const std::map<std::string, double>& x)
             WARNING("Robot model does not contain joint '" << joint.first << "' - ignoring.");
         }
     }
+    full_tree_update_required_ = true;
     UpdateTree();
+
+    RefreshStaleResponse();
+
     UpdateFK();
     if (flags_ & KIN_J) UpdateJ();
-    if (debug) PublishFrames();
+    if (debug && publish_debug_frames) PublishFrames();
 }
 
 Eigen::VectorXd KinematicTree::GetControlledState() const
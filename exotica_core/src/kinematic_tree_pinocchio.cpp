@@ -0,0 +1,286 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifdef PINOCCHIO_FOUND
+// fwd.hpp needs to be included first (before Boost, which comes with ROS)
+#include <pinocchio/fwd.hpp>
+
+#include <pinocchio/algorithm/jacobian.hpp>
+#include <pinocchio/algorithm/joint-configuration.hpp>
+#include <pinocchio/algorithm/kinematics.hpp>
+#include <pinocchio/multibody/data.hpp>
+#include <pinocchio/multibody/model.hpp>
+#include <pinocchio/parsers/urdf.hpp>
+#endif
+
+#include <exotica_core/kinematic_tree.h>
+#include <exotica_core/tools.h>
+
+namespace exotica
+{
+#ifdef PINOCCHIO_FOUND
+struct KinematicTree::PinocchioKinematics
+{
+    /// \brief Where a side (A or B) of a requested frame is rigidly attached: a body of the Pinocchio model or, for elements that
+    /// are not below the robot, the root of the tree.
+    struct Anchor
+    {
+        const KinematicElement* element = nullptr;
+        int joint = -1;            ///< Pinocchio joint moving the anchor, -1 for the root of the tree
+        pinocchio::SE3 placement;  ///< Pose of the body relative to the joint
+    };
+
+    struct Frame
+    {
+        bool supported = false;  ///< Whether this frame can be computed with Pinocchio, otherwise KDL is used
+        Anchor A;
+        Anchor B;
+    };
+
+    robot_model::RobotModelPtr source;  ///< Robot model the Pinocchio model was built from
+    pinocchio::Model model;
+    std::unique_ptr<pinocchio::Data> data;
+    Eigen::VectorXd q;
+
+    // Mapping of the tree state to the Pinocchio configuration, set up whenever the structure of the tree changes
+    int structure_version = -1;
+    bool supported = false;             ///< Whether every controlled joint is a joint of the Pinocchio model
+    std::vector<int> joint_state;       ///< Index into the tree state for every Pinocchio joint, -1 if not in the tree
+    std::vector<int> velocity_control;  ///< Control id of every Pinocchio velocity, -1 if not controlled
+    const KinematicElement* robot_root = nullptr;
+
+    // Frames of the request, set up whenever the request or the structure of the tree changes
+    int request_version = -1;
+    int frames_structure_version = -1;
+    std::vector<Frame> frames;
+};
+
+static KDL::Frame ToKDL(const pinocchio::SE3& pose)
+{
+    const auto& R = pose.rotation();
+    const auto& p = pose.translation();
+    return KDL::Frame(KDL::Rotation(R(0, 0), R(0, 1), R(0, 2), R(1, 0), R(1, 1), R(1, 2), R(2, 0), R(2, 1), R(2, 2)), KDL::Vector(p(0), p(1), p(2)));
+}
+#else
+struct KinematicTree::PinocchioKinematics
+{
+};
+#endif
+
+// Defined here, where PinocchioKinematics is complete
+KinematicTree::KinematicTree() = default;
+KinematicTree::~KinematicTree() = default;
+
+void KinematicTree::SetKinematicsBackend(KinematicsBackendType backend)
+{
+    if (backend == KINEMATICS_BACKEND_KDL)
+    {
+        // The model is kept, switching back to Pinocchio does not rebuild it
+        backend_ = backend;
+        return;
+    }
+    if (backend != KINEMATICS_BACKEND_PINOCCHIO) ThrowPretty("Unknown kinematics backend " << static_cast<int>(backend));
+#ifdef PINOCCHIO_FOUND
+    if (!model_) ThrowPretty("The kinematic tree has not been instantiated!");
+    if (!pinocchio_ || pinocchio_->source != model_)
+    {
+        std::unique_ptr<PinocchioKinematics> pinocchio(new PinocchioKinematics());
+        pinocchio::urdf::buildModel(model_->getURDF(), pinocchio->model);
+        pinocchio->data.reset(new pinocchio::Data(pinocchio->model));
+        pinocchio->q = pinocchio::neutral(pinocchio->model);
+        pinocchio->source = model_;
+        pinocchio_ = std::move(pinocchio);
+    }
+    backend_ = backend;
+#else
+    WARNING("exotica_core was built without Pinocchio, the kinematics will be computed with KDL.");
+    backend_ = KINEMATICS_BACKEND_KDL;
+#endif
+}
+
+#ifdef PINOCCHIO_FOUND
+void KinematicTree::UpdatePinocchio()
+{
+    EXOTICA_PROFILE_SCOPE("KinematicTree::UpdatePinocchio");
+    PinocchioKinematics& pin = *pinocchio_;
+    const pinocchio::Model& model = pin.model;
+    pinocchio::Data& data = *pin.data;
+
+    if (pin.structure_version != structure_version_)
+    {
+        pin.joint_state.assign(model.njoints, -1);
+        pin.velocity_control.assign(model.nv, -1);
+        int num_mapped_controls = 0;
+        for (pinocchio::JointIndex i = 1; i < static_cast<pinocchio::JointIndex>(model.njoints); ++i)
+        {
+            const auto& element = model_joints_map_.find(model.names[i]);
+            if (element == model_joints_map_.end() || element->second.expired()) continue;
+            const std::shared_ptr<KinematicElement> joint = element->second.lock();
+            pin.joint_state[i] = joint->id;
+            if (joint->is_controlled && model.joints[i].nv() == 1)
+            {
+                pin.velocity_control[model.joints[i].idx_v()] = joint->control_id;
+                ++num_mapped_controls;
+            }
+        }
+        const auto& root = tree_map_.find(model_->getRootLinkName());
+        pin.robot_root = root != tree_map_.end() ? root->second.lock().get() : nullptr;
+        pin.supported = num_mapped_controls == num_controlled_joints_ && pin.robot_root != nullptr;
+        if (!pin.supported) WARNING("Not all controlled joints are joints of the URDF (e.g., a floating base), the kinematics will be computed with KDL.");
+        pin.structure_version = structure_version_;
+    }
+
+    if (!pin.supported)
+    {
+        UpdateFK();
+        UpdateJ();
+        return;
+    }
+
+    if (pin.request_version != request_version_ || pin.frames_structure_version != structure_version_ || pin.frames.size() != solution_->frame.size())
+    {
+        // Finds the body (or the root) every side of a frame is rigidly attached to. Frames with controlled elements
+        // between the side and its anchor, e.g., controlled environment elements, are not supported.
+        auto find_anchor = [&](const KinematicElement* element, PinocchioKinematics::Anchor& anchor) {
+            for (const KinematicElement* it = element; it != nullptr; it = it->parent.lock().get())
+            {
+                if (it->is_robot_link && model.existFrame(it->segment.getName(), pinocchio::BODY))
+                {
+                    const pinocchio::Frame& body = model.frames[model.getFrameId(it->segment.getName(), pinocchio::BODY)];
+                    anchor.element = it;
+                    anchor.joint = static_cast<int>(body.parent);
+                    anchor.placement = body.placement;
+                    return true;
+                }
+                if (it->is_controlled) return false;
+                if (it->parent.expired())
+                {
+                    anchor.element = it;
+                    anchor.joint = -1;
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        pin.frames.resize(solution_->frame.size());
+        for (std::size_t i = 0; i < solution_->frame.size(); ++i)
+        {
+            const KinematicFrame& frame = solution_->frame[i];
+            PinocchioKinematics::Frame& pin_frame = pin.frames[i];
+            pin_frame.supported = !frame.frame_A.expired() && !frame.frame_B.expired() &&
+                                  find_anchor(frame.frame_A.lock().get(), pin_frame.A) && find_anchor(frame.frame_B.lock().get(), pin_frame.B);
+        }
+        pin.request_version = request_version_;
+        pin.frames_structure_version = structure_version_;
+    }
+
+    // Configuration of all joints of the model, including the joints that are not controlled
+    for (pinocchio::JointIndex i = 1; i < static_cast<pinocchio::JointIndex>(model.njoints); ++i)
+    {
+        if (pin.joint_state[i] < 0) continue;
+        const double position = tree_state_(pin.joint_state[i]);
+        const int idx_q = model.joints[i].idx_q();
+        if (model.joints[i].nq() == 1)
+        {
+            pin.q(idx_q) = position;
+        }
+        else if (model.joints[i].nq() == 2 && model.joints[i].nv() == 1)
+        {
+            // Continuous joints are parametrised by the cosine and sine of the angle
+            pin.q(idx_q) = std::cos(position);
+            pin.q(idx_q + 1) = std::sin(position);
+        }
+    }
+
+    pinocchio::computeJointJacobians(model, data, pin.q);  // Includes the forward kinematics
+
+    // World frame of the robot root, i.e., of the universe of the Pinocchio model
+    const KDL::Frame& robot_root = pin.robot_root->frame;
+    auto anchor_frame = [&](const PinocchioKinematics::Anchor& anchor) {
+        return anchor.joint < 0 ? anchor.element->frame : robot_root * ToKDL(data.oMi[anchor.joint] * anchor.placement);
+    };
+    auto side_frame = [&](const PinocchioKinematics::Anchor& anchor, const KinematicElement* element, const KDL::Frame& offset) {
+        // Elements below the anchor are rigidly attached, their relative pose is taken from the tree
+        if (anchor.element == element) return anchor_frame(anchor) * offset;
+        return anchor_frame(anchor) * (anchor.element->frame.Inverse() * element->frame) * offset;
+    };
+
+    const int num_frames = static_cast<int>(solution_->frame.size());
+    for (int i = 0; i < num_frames; ++i)
+    {
+        KinematicFrame& frame = solution_->frame[i];
+        const PinocchioKinematics::Frame& pin_frame = pin.frames[i];
+        if (!pin_frame.supported)
+        {
+            solution_->Phi(i) = FK(frame);
+            ComputeJ(frame, solution_->jacobian(i));
+            continue;
+        }
+
+        frame.temp_A = side_frame(pin_frame.A, frame.frame_A.lock().get(), frame.frame_A_offset);
+        frame.temp_B = side_frame(pin_frame.B, frame.frame_B.lock().get(), frame.frame_B_offset);
+        frame.temp_AB = frame.temp_B.Inverse() * frame.temp_A;
+        solution_->Phi(i) = frame.temp_AB;
+
+        // data.J holds the spatial velocities of the joints in the universe frame at its origin. Shifted to the
+        // reference point of frame A and rotated into frame B, as in KinematicTree::ComputeJ.
+        Eigen::MatrixXd& jacobian = solution_->jacobian(i).data;
+        jacobian.setZero();
+        const KDL::Vector point_kdl = robot_root.Inverse() * frame.temp_A.p;
+        const Eigen::Vector3d point(point_kdl.x(), point_kdl.y(), point_kdl.z());
+        const KDL::Rotation rotation_kdl = frame.temp_B.M.Inverse() * robot_root.M;
+        const Eigen::Matrix3d rotation = Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor>>(rotation_kdl.data);
+        for (const auto& side : {std::make_pair(pin_frame.A.joint, 1.0), std::make_pair(pin_frame.B.joint, -1.0)})
+        {
+            if (side.first <= 0) continue;
+            for (const pinocchio::JointIndex joint : model.supports[side.first])
+            {
+                if (joint == 0) continue;
+                const int v = model.joints[joint].idx_v();
+                for (int k = v; k < v + model.joints[joint].nv(); ++k)
+                {
+                    const int control = pin.velocity_control[k];
+                    if (control < 0) continue;
+                    const auto column = data.J.col(k);
+                    jacobian.col(control).head<3>() += side.second * rotation * (column.head<3>() + column.tail<3>().cross(point));
+                    jacobian.col(control).tail<3>() += side.second * rotation * column.tail<3>();
+                }
+            }
+        }
+    }
+}
+#else
+void KinematicTree::UpdatePinocchio()
+{
+    UpdateFK();
+    UpdateJ();
+}
+#endif
+}  // namespace exotica
@@ -0,0 +1,201 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <algorithm>
+#include <istream>
+#include <ostream>
+
+#include <exotica_core/loaders/initializer_serialization.h>
+#include <exotica_core/tools/exception.h>
+
+namespace exotica
+{
+namespace
+{
+constexpr char kMagic[4] = {'E', 'X', 'O', 'I'};
+constexpr std::uint32_t kFormatVersion = 1;
+constexpr std::uint32_t kMaxStringLength = 1u << 28;  // Guards against allocating huge buffers for corrupt data
+
+enum PropertyKind : std::uint8_t
+{
+    PROPERTY_UNSET = 0,
+    PROPERTY_STRING = 1,
+    PROPERTY_INITIALIZERS = 2
+};
+
+void WriteUInt32(std::ostream& out, std::uint32_t value)
+{
+    char bytes[4];
+    for (int i = 0; i < 4; ++i) bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    out.write(bytes, 4);
+}
+
+bool ReadUInt32(std::istream& in, std::uint32_t& value)
+{
+    unsigned char bytes[4];
+    if (!in.read(reinterpret_cast<char*>(bytes), 4)) return false;
+    value = 0;
+    for (int i = 0; i < 4; ++i) value |= static_cast<std::uint32_t>(bytes[i]) << (8 * i);
+    return true;
+}
+
+void WriteString(std::ostream& out, const std::string& str)
+{
+    WriteUInt32(out, static_cast<std::uint32_t>(str.size()));
+    out.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+bool ReadString(std::istream& in, std::string& str)
+{
+    std::uint32_t size;
+    if (!ReadUInt32(in, size) || size > kMaxStringLength) return false;
+    str.resize(size);
+    return size == 0 || static_cast<bool>(in.read(&str[0], size));
+}
+
+void WriteInitializer(std::ostream& out, const Initializer& initializer);
+bool ReadInitializer(std::istream& in, Initializer& initializer, int depth);
+
+void WriteInitializers(std::ostream& out, const std::vector<Initializer>& initializers)
+{
+    WriteUInt32(out, static_cast<std::uint32_t>(initializers.size()));
+    for (const Initializer& initializer : initializers) WriteInitializer(out, initializer);
+}
+
+bool ReadInitializers(std::istream& in, std::vector<Initializer>& initializers, int depth)
+{
+    // Configurations are shallow, deeper nesting indicates corrupt data
+    if (depth > 64) return false;
+    std::uint32_t size;
+    if (!ReadUInt32(in, size)) return false;
+    initializers.clear();
+    for (std::uint32_t i = 0; i < size; ++i)
+    {
+        Initializer initializer;
+        if (!ReadInitializer(in, initializer, depth)) return false;
+        initializers.push_back(initializer);
+    }
+    return true;
+}
+
+void WriteInitializer(std::ostream& out, const Initializer& initializer)
+{
+    WriteString(out, initializer.GetName());
+    WriteUInt32(out, static_cast<std::uint32_t>(initializer.properties_.size()));
+    for (const auto& it : initializer.properties_)
+    {
+        const Property& property = it.second;
+        WriteString(out, property.GetName());
+        out.put(property.IsRequired() ? 1 : 0);
+        if (!property.IsSet())
+        {
+            out.put(PROPERTY_UNSET);
+        }
+        else if (property.IsStringType())
+        {
+            out.put(PROPERTY_STRING);
+            WriteString(out, boost::any_cast<std::string>(property.Get()));
+        }
+        else if (property.IsInitializerVectorType())
+        {
+            out.put(PROPERTY_INITIALIZERS);
+            WriteInitializers(out, boost::any_cast<std::vector<Initializer>>(property.Get()));
+        }
+        else
+        {
+            ThrowPretty("Can't serialize property '" << property.GetName() << "' of type '" << property.GetType() << "' of initializer '" << initializer.GetName() << "'");
+        }
+    }
+}
+
+bool ReadInitializer(std::istream& in, Initializer& initializer, int depth)
+{
+    std::string name;
+    std::uint32_t num_properties;
+    if (!ReadString(in, name) || !ReadUInt32(in, num_properties)) return false;
+    initializer.SetName(name);
+    for (std::uint32_t i = 0; i < num_properties; ++i)
+    {
+        std::string property_name;
+        char required, kind;
+        if (!ReadString(in, property_name) || !in.get(required) || !in.get(kind)) return false;
+        switch (kind)
+        {
+            case PROPERTY_UNSET:
+                initializer.AddProperty(Property(property_name, required != 0));
+                break;
+            case PROPERTY_STRING:
+            {
+                std::string value;
+                if (!ReadString(in, value)) return false;
+                initializer.AddProperty(Property(property_name, required != 0, value));
+                break;
+            }
+            case PROPERTY_INITIALIZERS:
+            {
+                std::vector<Initializer> value;
+                if (!ReadInitializers(in, value, depth + 1)) return false;
+                initializer.AddProperty(Property(property_name, required != 0, value));
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+
+void SerializeInitializers(const std::vector<Initializer>& initializers, std::ostream& out)
+{
+    out.write(kMagic, sizeof(kMagic));
+    WriteUInt32(out, kFormatVersion);
+    WriteInitializers(out, initializers);
+}
+
+bool DeserializeInitializers(std::istream& in, std::vector<Initializer>& initializers)
+{
+    char magic[sizeof(kMagic)];
+    std::uint32_t version;
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), kMagic)) return false;
+    if (!ReadUInt32(in, version) || version != kFormatVersion) return false;
+    return ReadInitializers(in, initializers, 0);
+}
+
+std::uint64_t HashContent(const std::string& content, std::uint64_t seed)
+{
+    std::uint64_t hash = seed;
+    for (const char c : content)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+}  // namespace exotica
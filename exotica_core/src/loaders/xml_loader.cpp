@@ -27,8 +27,18 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <sys/stat.h>
 #include <tinyxml2.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 
+#include <exotica_core/loaders/initializer_serialization.h>
 #include <exotica_core/loaders/xml_loader.h>
 #include <exotica_core/setup.h>
 
@@ -36,7 +46,11 @@ namespace exotica
 {
 std::shared_ptr<XMLLoader> XMLLoader::instance_ = nullptr;
 
-XMLLoader::XMLLoader() = default;
+XMLLoader::XMLLoader()
+{
+    const char* cache_directory = std::getenv("EXOTICA_CONFIG_CACHE_DIR");
+    if (cache_directory != nullptr) cache_directory_ = cache_directory;
+}
 
 bool parseXML(tinyxml2::XMLHandle& tag, Initializer& parent, const std::string& prefix);
 
@@ -128,82 +142,128 @@ bool parseXML(tinyxml2::XMLHandle& tag, Initializer& parent, const std::string&
     return true;
 }
 
-Initializer XMLLoader::LoadXML(std::string file_name, bool parsePathAsXML)
+void XMLLoader::ClearCache()
 {
-    tinyxml2::XMLDocument xml_file;
-    if (parsePathAsXML)
-    {
-        if (xml_file.Parse(file_name.c_str()) != tinyxml2::XML_SUCCESS)
-        {
-            ThrowPretty("Can't load file!\nFile: '" + file_name + "'");
-        }
-    }
-    else
-    {
-        std::string xml = LoadFile(file_name);  // assume it is a null-terminated string
-        if (xml_file.Parse(xml.c_str()) != tinyxml2::XML_SUCCESS)
-        {
-            ThrowPretty("Can't load file!\nFile: '" + ParsePath(file_name) + "'");
-        }
-    }
+    std::shared_ptr<XMLLoader> loader = Instance();
+    std::lock_guard<std::mutex> lock(loader->cache_mutex_);
+    loader->cache_.clear();
+    loader->cache_order_.clear();
+}
 
-    Initializer ret("TopLevel");
-    tinyxml2::XMLHandle root_tag(xml_file.RootElement()->FirstChildElement());
-    if (!parseXML(root_tag, ret, ""))
+void XMLLoader::SetCacheCapacity(std::size_t capacity)
+{
+    std::shared_ptr<XMLLoader> loader = Instance();
+    std::lock_guard<std::mutex> lock(loader->cache_mutex_);
+    loader->cache_capacity_ = capacity;
+    loader->TrimCache();
+}
+
+std::size_t XMLLoader::GetCacheSize()
+{
+    std::shared_ptr<XMLLoader> loader = Instance();
+    std::lock_guard<std::mutex> lock(loader->cache_mutex_);
+    return loader->cache_.size();
+}
+
+void XMLLoader::TrimCache()
+{
+    while (cache_.size() > cache_capacity_)
     {
-        ThrowPretty("Can't parse XML!\nFile: '" + file_name + "'");
+        cache_.erase(cache_order_.front());
+        cache_order_.pop_front();
     }
-    return ret;
 }
 
-void XMLLoader::LoadXML(std::string file_name, Initializer& solver, Initializer& problem, const std::string& solver_name, const std::string& problem_name, bool parsePathAsXML)
+std::vector<Initializer> XMLLoader::LoadInitializers(const std::string& file_name, bool parsePathAsXML, bool first_only)
 {
-    tinyxml2::XMLDocument xml_file;
-    if (parsePathAsXML)
+    const std::string xml = parsePathAsXML ? file_name : LoadFile(file_name);  // assume LoadFile returns a null-terminated string
+    const std::uint64_t key = HashContent(xml) ^ (first_only ? 0x9e3779b97f4a7c15ULL : 0);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        auto it = cache_.find(key);
+        if (it != cache_.end()) return it->second;
+    }
+
+    std::vector<Initializer> initializers;
+    std::string cache_file;
+    if (!cache_directory_.empty())
     {
-        if (xml_file.Parse(file_name.c_str()) != tinyxml2::XML_SUCCESS)
+        const std::string directory = ParsePath(cache_directory_);
+        if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) ThrowPretty("Can't create the configuration cache directory '" << directory << "': " << std::strerror(errno));
+        std::ostringstream name;
+        name << directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".exoi";
+        cache_file = name.str();
+
+        std::ifstream cached(cache_file, std::ios::binary);
+        if (cached && !DeserializeInitializers(cached, initializers))
         {
-#ifdef TINYXML_HAS_ERROR_STR
-            ThrowPretty("Can't load file!\n"
-                        << xml_file.ErrorStr() << "\nFile: '" + file_name + "'");
-#else
-            ThrowPretty("Can't load file!"
-                        << "\nFile: '" + file_name + "'");
-#endif
+            WARNING("Ignoring invalid configuration cache entry '" << cache_file << "'");
+            initializers.clear();
         }
     }
-    else
+
+    if (initializers.empty())
     {
-        std::string xml = LoadFile(file_name);  // assume LoadFile returns a null-terminated string
+        tinyxml2::XMLDocument xml_file;
         tinyxml2::XMLError return_code = xml_file.Parse(xml.c_str());
         if (xml_file.Error())
         {
+            const std::string source = parsePathAsXML ? file_name : ParsePath(file_name);
 #ifdef TINYXML_HAS_ERROR_STR
             ThrowPretty("Can't load file! Return code: " << return_code << "\n"
-                                                         << xml_file.ErrorStr() << "\nFile: '" + ParsePath(file_name) + "'");
+                                                         << xml_file.ErrorStr() << "\nFile: '" + source + "'");
 #else
             ThrowPretty("Can't load file! Return code: " << return_code << "\n"
-                                                         << "File: '" + ParsePath(file_name) + "'");
+                                                         << "File: '" + source + "'");
 #endif
         }
-    }
 
-    std::vector<Initializer> initializers;
-    tinyxml2::XMLHandle root_tag(xml_file.RootElement()->FirstChild());
-    while (root_tag.ToNode())
-    {
-        if (root_tag.ToElement() == nullptr)
+        tinyxml2::XMLHandle root_tag(xml_file.RootElement()->FirstChild());
+        while (root_tag.ToNode())
         {
+            if (root_tag.ToElement() == nullptr)
+            {
+                root_tag = root_tag.NextSibling();
+                continue;
+            }
+            initializers.push_back(Initializer("TopLevel"));
+            if (!parseXML(root_tag, initializers[initializers.size() - 1], ""))
+            {
+                if (first_only) ThrowPretty("Can't parse XML!\nFile: '" + file_name + "'");
+                initializers.pop_back();
+            }
+            if (first_only) break;
             root_tag = root_tag.NextSibling();
-            continue;
         }
-        initializers.push_back(Initializer("TopLevel"));
-        if (!parseXML(root_tag, initializers[initializers.size() - 1], ""))
+
+        if (!cache_file.empty())
         {
-            initializers.pop_back();
+            // Written to a temporary file first, such that concurrently starting processes never read partial entries
+            const std::string temporary_file = cache_file + "." + std::to_string(getpid());
+            {
+                std::ofstream cached(temporary_file, std::ios::binary);
+                SerializeInitializers(initializers, cached);
+            }
+            if (std::rename(temporary_file.c_str(), cache_file.c_str()) != 0) std::remove(temporary_file.c_str());
         }
-        root_tag = root_tag.NextSibling();
     }
+
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (cache_.emplace(key, initializers).second) cache_order_.push_back(key);
+    TrimCache();
+    return initializers;
+}
+
+Initializer XMLLoader::LoadXML(std::string file_name, bool parsePathAsXML)
+{
+    std::vector<Initializer> initializers = LoadInitializers(file_name, parsePathAsXML, true);
+    if (initializers.empty()) ThrowPretty("Can't parse XML!\nFile: '" + file_name + "'");
+    return initializers[0];
+}
+
+void XMLLoader::LoadXML(std::string file_name, Initializer& solver, Initializer& problem, const std::string& solver_name, const std::string& problem_name, bool parsePathAsXML)
+{
+    std::vector<Initializer> initializers = LoadInitializers(file_name, parsePathAsXML, false);
     bool found_solver = false;
     bool found_problem = false;
     if (solver_name.empty() || solver_name == "")
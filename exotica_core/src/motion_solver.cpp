@@ -27,23 +27,244 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <algorithm>
+#include <limits>
+#include <thread>
+
 #include "exotica_core/motion_solver.h"
 #include <exotica_core/server.h>
+#include <exotica_core/setup.h>
 #include <exotica_core/task_map.h>
+#include <exotica_core/tools/parallel_loop.h>
+#include <exotica_core/tools/timer.h>
 
 #include "exotica_core/motion_solver_initializer.h"
 
 namespace exotica
 {
+namespace
+{
+// Index of the best solution in [begin, end): valid solutions are preferred over invalid ones, then the one with the lowest cost
+int SelectBestSolution(int begin, int end, const std::vector<TerminationCriterion>& termination_criteria, const std::vector<char>& valid, const std::vector<double>& costs)
+{
+    int best = -1;
+    for (int i = begin; i < end; ++i)
+    {
+        if (termination_criteria[i] == TerminationCriterion::NotStarted) continue;
+        if (best == -1 || (valid[i] && !valid[best]) || (valid[i] == valid[best] && costs[i] < costs[best])) best = i;
+    }
+    return best;
+}
+}  // namespace
+
 void MotionSolver::InstantiateBase(const Initializer& init)
 {
     Object::InstantiateObject(init);
-    SetNumberOfMaxIterations(MotionSolverInitializer(init).MaxIterations);
+    initializer_ = init;
+    MotionSolverInitializer solver_init(init);
+    SetNumberOfMaxIterations(solver_init.MaxIterations);
+    SetMultiStartNumThreads(solver_init.MultiStartNumThreads);
 }
 
 void MotionSolver::SpecifyProblem(PlanningProblemPtr pointer)
 {
     problem_ = pointer;
+    multi_start_workers_.clear();
+}
+
+void MotionSolver::SetMultiStartNumThreads(int num_threads)
+{
+    if (num_threads < 0) ThrowNamed("Invalid number of threads: " << num_threads);
+    multi_start_num_threads_ = Server::ResolveNumThreads(num_threads);
+}
+
+void MotionSolver::UpdateMultiStartWorkers(int num_workers)
+{
+    while (static_cast<int>(multi_start_workers_.size()) < num_workers)
+    {
+        std::shared_ptr<MotionSolver> worker = Setup::CreateSolver(initializer_);
+        worker->debug_ = false;
+        worker->SpecifyProblem(problem_->Clone());
+        multi_start_workers_.push_back(worker);
+    }
+
+    // The goals, weights and the model state may have been changed since the last solve
+    for (int i = 0; i < num_workers; ++i)
+    {
+        MotionSolver& worker = *multi_start_workers_[i];
+        worker.SetNumberOfMaxIterations(max_iterations_);
+        problem_->UpdateClone(*worker.problem_);
+        worker.SpecifyProblem(worker.problem_);
+    }
+}
+
+void MotionSolver::SolveMultiStart(const std::vector<Eigen::VectorXd>& seeds, Eigen::MatrixXd& solution)
+{
+    if (!problem_) ThrowNamed("Solver has not been initialized!");
+    if (seeds.empty()) ThrowNamed("No seeds given!");
+
+    Timer timer;
+    const int num_seeds = static_cast<int>(seeds.size());
+    const int num_threads = std::min(multi_start_num_threads_, num_seeds);
+    std::vector<Eigen::MatrixXd> solutions(num_seeds);
+    std::vector<double> costs(num_seeds, std::numeric_limits<double>::infinity());
+    std::vector<char> valid(num_seeds, false);  // std::vector<bool> can not be written concurrently
+    std::vector<TerminationCriterion> termination_criteria(num_seeds, TerminationCriterion::NotStarted);
+
+    if (num_threads <= 1)
+    {
+        const Eigen::VectorXd start_state = problem_->GetStartState();
+        for (int i = 0; i < num_seeds; ++i)
+        {
+            problem_->SetStartState(seeds[i]);
+            Solve(solutions[i]);
+            termination_criteria[i] = problem_->termination_criterion;
+            costs[i] = problem_->UpdateEndPoseCost(solutions[i].row(0).transpose());
+            valid[i] = problem_->IsValid();
+            if (valid[i] && termination_criteria[i] == TerminationCriterion::FunctionTolerance) break;
+        }
+        problem_->SetStartState(start_state);
+    }
+    else
+    {
+        UpdateMultiStartWorkers(num_threads);
+
+        // Each block of contiguous seeds is solved with its own solver and problem on the thread pool of the Server
+        std::shared_ptr<std::atomic<bool>> stop_requested = std::make_shared<std::atomic<bool>>(false);
+        Server::GetThreadPool().ParallelFor(0, num_threads, [&](int block) {
+            MotionSolver& worker = *multi_start_workers_[block];
+            worker.stop_requested_ = stop_requested;
+            try
+            {
+                const int end = static_cast<int>((static_cast<long>(block) + 1) * num_seeds / num_threads);
+                for (int i = static_cast<int>(static_cast<long>(block) * num_seeds / num_threads); i < end && !stop_requested->load(); ++i)
+                {
+                    worker.problem_->SetStartState(seeds[i]);
+                    worker.Solve(solutions[i]);
+                    termination_criteria[i] = worker.problem_->termination_criterion;
+                    costs[i] = worker.problem_->UpdateEndPoseCost(solutions[i].row(0).transpose());
+                    valid[i] = worker.problem_->IsValid();
+                    if (valid[i] && termination_criteria[i] == TerminationCriterion::FunctionTolerance) stop_requested->store(true);
+                }
+            }
+            catch (...)
+            {
+                worker.stop_requested_ = nullptr;
+                throw;
+            }
+            worker.stop_requested_ = nullptr;
+        });
+    }
+
+    const int best = SelectBestSolution(0, num_seeds, termination_criteria, valid, costs);
+    solution = solutions[best];
+    problem_->UpdateEndPoseCost(solution.row(0).transpose());
+    problem_->termination_criterion = termination_criteria[best];
+    planning_time_ = timer.GetDuration();
+}
+
+void MotionSolver::SolveBatch(const std::vector<std::map<std::string, Eigen::VectorXd>>& targets, const std::vector<Eigen::VectorXd>& seeds, std::vector<Eigen::VectorXd>& solutions, std::vector<bool>& success)
+{
+    if (!problem_) ThrowNamed("Solver has not been initialized!");
+    if (seeds.empty()) ThrowNamed("No seeds given!");
+
+    Timer timer;
+    const int num_targets = static_cast<int>(targets.size());
+    const int num_seeds = static_cast<int>(seeds.size());
+    const int num_items = num_targets * num_seeds;
+    const int num_threads = std::min(multi_start_num_threads_, num_items);
+
+    // Task goals not given by a target keep the goal of the problem
+    std::map<std::string, Eigen::VectorXd> default_goals;
+    for (const std::map<std::string, Eigen::VectorXd>& target : targets)
+    {
+        for (const auto& goal : target)
+        {
+            if (default_goals.find(goal.first) == default_goals.end()) default_goals[goal.first] = problem_->GetCostGoal(goal.first);
+        }
+    }
+    auto set_target = [&targets, &default_goals](const PlanningProblemPtr& problem, int target) {
+        for (const auto& default_goal : default_goals)
+        {
+            const auto goal = targets[target].find(default_goal.first);
+            problem->SetCostGoal(default_goal.first, goal != targets[target].end() ? goal->second : default_goal.second);
+        }
+    };
+
+    // Results of each (target, seed) pair, the seeds of a target are consecutive
+    std::vector<Eigen::MatrixXd> item_solutions(num_items);
+    std::vector<double> costs(num_items, std::numeric_limits<double>::infinity());
+    std::vector<char> valid(num_items, false);  // std::vector<bool> can not be written concurrently
+    std::vector<TerminationCriterion> termination_criteria(num_items, TerminationCriterion::NotStarted);
+
+    if (num_threads <= 1)
+    {
+        const Eigen::VectorXd start_state = problem_->GetStartState();
+        try
+        {
+            for (int target = 0; target < num_targets; ++target)
+            {
+                set_target(problem_, target);
+                for (int i = target * num_seeds; i < (target + 1) * num_seeds; ++i)
+                {
+                    problem_->SetStartState(seeds[i - target * num_seeds]);
+                    Solve(item_solutions[i]);
+                    termination_criteria[i] = problem_->termination_criterion;
+                    costs[i] = problem_->UpdateEndPoseCost(item_solutions[i].row(0).transpose());
+                    valid[i] = problem_->IsValid();
+                    if (valid[i] && termination_criteria[i] == TerminationCriterion::FunctionTolerance) break;
+                }
+            }
+        }
+        catch (...)
+        {
+            for (const auto& default_goal : default_goals) problem_->SetCostGoal(default_goal.first, default_goal.second);
+            problem_->SetStartState(start_state);
+            throw;
+        }
+        for (const auto& default_goal : default_goals) problem_->SetCostGoal(default_goal.first, default_goal.second);
+        problem_->SetStartState(start_state);
+    }
+    else
+    {
+        UpdateMultiStartWorkers(num_threads);
+
+        // The pairs are handed out in order, i.e. the seeds of a target are solved concurrently and stop as soon as one of them succeeds
+        std::shared_ptr<std::vector<std::atomic<bool>>> stop_requested = std::make_shared<std::vector<std::atomic<bool>>>(num_targets);
+        for (std::atomic<bool>& stop : *stop_requested) stop.store(false);
+        std::vector<int> worker_targets(num_threads, -1);
+        ParallelLoop(
+            num_threads, num_items, [&](int thread, int i) {
+                const int target = i / num_seeds;
+                if ((*stop_requested)[target].load()) return;
+
+                MotionSolver& worker = *multi_start_workers_[thread];
+                if (target != worker_targets[thread])
+                {
+                    set_target(worker.problem_, target);
+                    worker.stop_requested_ = std::shared_ptr<const std::atomic<bool>>(stop_requested, &(*stop_requested)[target]);
+                    worker_targets[thread] = target;
+                }
+                worker.problem_->SetStartState(seeds[i - target * num_seeds]);
+                worker.Solve(item_solutions[i]);
+                termination_criteria[i] = worker.problem_->termination_criterion;
+                costs[i] = worker.problem_->UpdateEndPoseCost(item_solutions[i].row(0).transpose());
+                valid[i] = worker.problem_->IsValid();
+                if (valid[i] && termination_criteria[i] == TerminationCriterion::FunctionTolerance) (*stop_requested)[target].store(true);
+            },
+            ParallelSchedule::Dynamic);
+        for (int thread = 0; thread < num_threads; ++thread) multi_start_workers_[thread]->stop_requested_ = nullptr;
+    }
+
+    solutions.resize(num_targets);
+    success.assign(num_targets, false);
+    for (int target = 0; target < num_targets; ++target)
+    {
+        const int best = SelectBestSolution(target * num_seeds, (target + 1) * num_seeds, termination_criteria, valid, costs);
+        solutions[target] = item_solutions[best].row(0).transpose();
+        success[target] = valid[best] && termination_criteria[best] == TerminationCriterion::FunctionTolerance;
+    }
+    planning_time_ = timer.GetDuration();
 }
 
 std::string MotionSolver::Print(const std::string& prepend) const
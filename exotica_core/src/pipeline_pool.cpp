@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_core/loaders/xml_loader.h>
+#include <exotica_core/pipeline_pool.h>
+#include <exotica_core/server.h>
+#include <exotica_core/setup.h>
+
+namespace exotica
+{
+PipelinePool::PipelinePool(const Initializer& solver, const Initializer& problem, int size) : solver_initializer_(solver), problem_initializer_(problem)
+{
+    Initialize(size);
+}
+
+PipelinePool::PipelinePool(const std::string& file_name, int size)
+{
+    XMLLoader::Load(file_name, solver_initializer_, problem_initializer_);
+    Initialize(size);
+}
+
+void PipelinePool::Initialize(int size)
+{
+    if (size < 0) ThrowPretty("Invalid pool size: " << size);
+    size_ = Server::ResolveNumThreads(size);
+    reference_problem_ = Setup::CreateProblem(problem_initializer_);
+    if (!reference_problem_->SupportsCloning()) ThrowPretty("Problems of type '" << reference_problem_->type() << "' can not be pooled, they do not implement UpdateClone (supported are the end-pose and time-indexed problems).");
+    state_ = std::make_shared<State>();
+    state_->idle.reserve(size_);  // Releasing a solver must not allocate
+    for (int i = 0; i < size_; ++i) state_->idle.push_back(CreatePipeline());
+    max_iterations_ = state_->idle[0].solver->GetNumberOfMaxIterations();
+}
+
+PipelinePool::Pipeline PipelinePool::CreatePipeline() const
+{
+    Pipeline pipeline;
+    pipeline.solver = Setup::CreateSolver(solver_initializer_);
+    PlanningProblemPtr problem = reference_problem_->Clone();
+    pipeline.solver->SpecifyProblem(problem);
+    pipeline.world_version = problem->GetScene()->GetWorldVersion();
+    return pipeline;
+}
+
+MotionSolverPtr PipelinePool::Acquire()
+{
+    Pipeline pipeline;
+    {
+        std::unique_lock<std::mutex> lock(state_->mutex);
+        state_->released.wait(lock, [this] { return !state_->idle.empty(); });
+        pipeline = std::move(state_->idle.back());
+        state_->idle.pop_back();
+    }
+    return HandOut(std::move(pipeline));
+}
+
+MotionSolverPtr PipelinePool::TryAcquire()
+{
+    Pipeline pipeline;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->idle.empty()) return nullptr;
+        pipeline = std::move(state_->idle.back());
+        state_->idle.pop_back();
+    }
+    return HandOut(std::move(pipeline));
+}
+
+int PipelinePool::GetNumAvailable() const
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return static_cast<int>(state_->idle.size());
+}
+
+MotionSolverPtr PipelinePool::HandOut(Pipeline pipeline)
+{
+    try
+    {
+        PlanningProblemPtr problem = pipeline.solver->GetProblem();
+        if (problem->GetScene()->GetWorldVersion() != pipeline.world_version)
+        {
+            // The previous request changed the world, which is not reset by UpdateClone
+            pipeline = CreatePipeline();
+        }
+        else
+        {
+            reference_problem_->UpdateClone(*problem);
+            problem->ResetNumberOfProblemUpdates();
+            pipeline.solver->SetNumberOfMaxIterations(max_iterations_);
+            pipeline.solver->SpecifyProblem(problem);
+        }
+    }
+    catch (...)
+    {
+        // Keep the pool at its size, the pipeline is instantiated again on the next request
+        pipeline.world_version = -1;
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->idle.push_back(std::move(pipeline));
+        state_->released.notify_one();
+        throw;
+    }
+
+    MotionSolver* solver = pipeline.solver.get();
+    std::shared_ptr<State> state = state_;
+    return MotionSolverPtr(solver, [state, pipeline](MotionSolver*) mutable {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->idle.push_back(std::move(pipeline));
+        }
+        state->released.notify_one();
+    });
+}
+}  // namespace exotica
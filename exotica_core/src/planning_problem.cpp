@@ -41,7 +41,10 @@
 namespace exotica
 {
 PlanningProblem::PlanningProblem() = default;
-PlanningProblem::~PlanningProblem() = default;
+PlanningProblem::~PlanningProblem()
+{
+    if (recorder_) recorder_->Detach(this);
+}
 
 std::string PlanningProblem::Print(const std::string& prepend) const
 {
@@ -90,6 +93,7 @@ void PlanningProblem::PreUpdate()
 
 void PlanningProblem::SetStartState(Eigen::VectorXdRefConst x)
 {
+    if (recorder_) recorder_->RecordVector(ProblemEventType::SetStartState, x);
     const auto num_states = scene_->get_num_positions() + scene_->get_num_velocities();
     if (x.rows() == num_states)
     {
@@ -125,6 +129,7 @@ Eigen::VectorXd PlanningProblem::GetStartState() const
 
 void PlanningProblem::SetStartTime(double t)
 {
+    if (recorder_) recorder_->RecordScalar(ProblemEventType::SetStartTime, t);
     t_start = t;
 }
 
@@ -133,10 +138,18 @@ double PlanningProblem::GetStartTime() const
     return t_start;
 }
 
+void PlanningProblem::SetRecorder(std::shared_ptr<ProblemRecorder> recorder)
+{
+    if (recorder) recorder->Attach(this);
+    if (recorder_ && recorder_ != recorder) recorder_->Detach(this);
+    recorder_ = recorder;
+}
+
 void PlanningProblem::InstantiateBase(const Initializer& init_in)
 {
     Object::InstantiateObject(init_in);
     PlanningProblemInitializer init(init_in);
+    initializer_ = init_in;
 
     task_maps_.clear();
     tasks_.clear();
@@ -185,12 +198,14 @@ void PlanningProblem::InstantiateBase(const Initializer& init_in)
         default:
             ThrowPretty("Unsupported DerivativeOrder: " << init.DerivativeOrder);
     }
+    if (init.PackedKinematics) flags_ = flags_ | KIN_PACKED;
+    if (init.VelocityKinematics) flags_ = flags_ | KIN_FK_VEL | KIN_J_DOT;
 
     KinematicsRequest request;
     request.flags = flags_;
 
     // Create the maps
-    int id = 0;
+    int num_frames = 0;
     for (const Initializer& MapInitializer : init.Maps)
     {
         TaskMapPtr new_map = Setup::CreateMap(MapInitializer);
@@ -202,17 +217,19 @@ void PlanningProblem::InstantiateBase(const Initializer& init_in)
         }
         std::vector<KinematicFrameRequest> frames = new_map->GetFrames();
 
+        // Frames requested by several maps (e.g., the same effector) are computed once and shared
+        const int start = request.AddFrames(frames);
         for (size_t i = 0; i < new_map->kinematics.size(); ++i)
-            new_map->kinematics[i] = KinematicSolution(id, frames.size());
-        id += frames.size();
+            new_map->kinematics[i] = KinematicSolution(start, frames.size());
+        num_frames += frames.size();
 
-        request.frames.insert(request.frames.end(), frames.begin(), frames.end());
         task_maps_[new_map->GetObjectName()] = new_map;
         tasks_.push_back(new_map);
     }
+    if (debug_ && static_cast<int>(request.frames.size()) < num_frames) HIGHLIGHT_NAMED(object_name_, "Computing " << request.frames.size() << " of the " << num_frames << " requested frames, the others are shared between maps.");
     scene_->RequestKinematics(request, std::bind(&PlanningProblem::UpdateTaskKinematics, this, std::placeholders::_1));
 
-    id = 0;
+    int id = 0;
     int idJ = 0;
     for (int i = 0; i < tasks_.size(); ++i)
     {
@@ -231,6 +248,48 @@ void PlanningProblem::InstantiateBase(const Initializer& init_in)
     }
 }
 
+std::shared_ptr<PlanningProblem> PlanningProblem::Clone() const
+{
+    std::shared_ptr<PlanningProblem> clone = Setup::CreateProblem(initializer_);
+    clone->debug_ = false;
+    clone->scene_->StopDebugPublisher();
+    clone->scene_->debug_ = false;
+    clone->scene_->GetKinematicTree().debug = false;
+    UpdateClone(*clone);
+    return clone;
+}
+
+void PlanningProblem::UpdateCloneBase(PlanningProblem& clone) const
+{
+    if (clone.type() != type()) ThrowNamed("Can't update a clone of type '" << clone.type() << "' from a problem of type '" << type() << "'!");
+    clone.start_state_ = start_state_;
+    clone.t_start = t_start;
+
+    // Joints that are not controlled and the joint limits may have been changed since the instantiation
+    const Eigen::MatrixXd& joint_limits = scene_->GetKinematicTree().GetJointLimits();
+    clone.scene_->GetKinematicTree().SetModelState(scene_->GetKinematicTree().GetModelStateMap());
+    clone.scene_->GetKinematicTree().SetJointLimitsLower(joint_limits.col(0));
+    clone.scene_->GetKinematicTree().SetJointLimitsUpper(joint_limits.col(1));
+}
+
+TaskMapVec PlanningProblem::CloneTasks(const ScenePtr& workspace, KinematicRequestFlags flags) const
+{
+    // Same order of the frames as in InstantiateBase, so that the clones index the kinematic response like the task maps of this problem
+    TaskMapVec maps;
+    KinematicsRequest request;
+    request.flags = flags;
+    for (const TaskMapPtr& task : tasks_)
+    {
+        maps.push_back(task->CreateClone(workspace));
+        request.AddFrames(task->GetFrames());
+    }
+    workspace->RequestKinematics(request, [maps](std::shared_ptr<KinematicResponse> response) {
+        for (const TaskMapPtr& map : maps) map->kinematics[0].Create(response);
+    });
+    for (const TaskMapPtr& map : maps) map->PreUpdate();
+    return maps;
+}
+
 void PlanningProblem::UpdateTaskKinematics(std::shared_ptr<KinematicResponse> response)
 {
     for (auto task : tasks_)
@@ -306,10 +365,19 @@ void PlanningProblem::ResetCostEvolution(size_t size)
 {
     cost_evolution_.resize(size);
     cost_evolution_.assign(size, std::make_pair<std::chrono::high_resolution_clock::time_point, double>(std::chrono::high_resolution_clock::now(), std::numeric_limits<double>::quiet_NaN()));
+    iteration_telemetry_.Reset();
 }
 
 void PlanningProblem::SetCostEvolution(int index, double value)
 {
+    IterationRecord record;
+    record.cost = value;
+    SetCostEvolution(index, record);
+}
+
+void PlanningProblem::SetCostEvolution(int index, const IterationRecord& record)
+{
+    const double value = record.cost;
     if (index > -1 && index < cost_evolution_.size())
     {
         cost_evolution_[index].first = std::chrono::high_resolution_clock::now();
@@ -324,5 +392,9 @@ void PlanningProblem::SetCostEvolution(int index, double value)
     {
         ThrowPretty("Out of range: " << index << " where length=" << cost_evolution_.size());
     }
+
+    IterationRecord iteration_record = record;
+    iteration_record.iteration = index == -1 ? static_cast<int>(cost_evolution_.size()) - 1 : index;
+    iteration_telemetry_.Push(iteration_record);
 }
 }  // namespace exotica
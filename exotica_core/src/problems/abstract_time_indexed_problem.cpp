@@ -27,8 +27,13 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <algorithm>
+#include <thread>
+
 #include <exotica_core/problems/abstract_time_indexed_problem.h>
+#include <exotica_core/server.h>
 #include <exotica_core/setup.h>
+#include <exotica_core/tools/parallel_loop.h>
 
 namespace exotica
 {
@@ -64,7 +69,7 @@ void AbstractTimeIndexedProblem::ReinitializeVariables()
 
     x.assign(T_, Eigen::VectorXd::Zero(N));
     xdiff.assign(T_, Eigen::VectorXd::Zero(N));
-    if (flags_ & KIN_J) jacobian.assign(T_, Eigen::MatrixXd(length_jacobian, N));
+    if (flags_ & KIN_J) jacobian.assign(T_, Eigen::MatrixXd::Zero(length_jacobian, N));
     if (flags_ & KIN_H)
     {
         Hessian Htmp;
@@ -121,6 +126,7 @@ void AbstractTimeIndexedProblem::SetT(const int T_in)
         ThrowNamed("Invalid number of timesteps: " << T_in);
     }
     T_ = T_in;
+    resolution_reference_ = ResolutionReference();
     ReinitializeVariables();
 }
 
@@ -133,7 +139,39 @@ void AbstractTimeIndexedProblem::SetTau(const double tau_in)
 {
     if (tau_in <= 0.) ThrowPretty("tau_ is expected to be greater than 0. (tau_=" << tau_in << ")");
     tau_ = tau_in;
+    resolution_reference_ = ResolutionReference();
+    ReinitializeVariables();
+}
+
+void AbstractTimeIndexedProblem::SetResolution(int T_in)
+{
+    if (T_in <= 2) ThrowNamed("Invalid number of timesteps: " << T_in);
+    if (resolution_reference_.T == 0)
+    {
+        if (T_in == T_) return;
+        resolution_reference_.T = T_;
+        resolution_reference_.tau = tau_;
+        resolution_reference_.cost_y = cost.y;
+        resolution_reference_.cost_rho = cost.rho;
+        resolution_reference_.inequality_y = inequality.y;
+        resolution_reference_.inequality_rho = inequality.rho;
+        resolution_reference_.equality_y = equality.y;
+        resolution_reference_.equality_rho = equality.rho;
+    }
+
+    Eigen::MatrixXd trajectory(N, T_);
+    for (int t = 0; t < T_; ++t) trajectory.col(t) = initial_trajectory_[t];
+
+    T_ = T_in;
+    tau_ = T_ == resolution_reference_.T ? resolution_reference_.tau : resolution_reference_.tau * (resolution_reference_.T - 1) / (T_ - 1);
     ReinitializeVariables();
+    cost.ResampleGoals(resolution_reference_.cost_y, resolution_reference_.cost_rho);
+    inequality.ResampleGoals(resolution_reference_.inequality_y, resolution_reference_.inequality_rho);
+    equality.ResampleGoals(resolution_reference_.equality_y, resolution_reference_.equality_rho);
+    const Eigen::MatrixXd resampled = ResampleTrajectory(trajectory, T_);
+    for (int t = 0; t < T_; ++t) initial_trajectory_[t] = resampled.col(t);
+    if (T_ == resolution_reference_.T) resolution_reference_ = ResolutionReference();
+    PreUpdate();
 }
 
 void AbstractTimeIndexedProblem::PreUpdate()
@@ -174,8 +212,35 @@ void AbstractTimeIndexedProblem::PreUpdate()
     // based on the lastest KinematicResponse in order to reflect model state
     // updates etc.
     kinematic_solutions_.clear();
-    kinematic_solutions_.resize(T_);
-    for (int i = 0; i < T_; ++i) kinematic_solutions_[i] = std::make_shared<KinematicResponse>(*scene_->GetKinematicTree().GetKinematicResponse());
+    scene_->GetKinematicTree().GetKinematicResponses(T_, kinematic_solutions_);
+    PreUpdateTrajectoryWorkspaces();
+    InvalidateTimeSteps();
+}
+
+void AbstractTimeIndexedProblem::UpdateClone(PlanningProblem& clone) const
+{
+    UpdateCloneBase(clone);
+    AbstractTimeIndexedProblem& clone_problem = static_cast<AbstractTimeIndexedProblem&>(clone);
+    clone_problem.q_dot_max_ = q_dot_max_;
+    if (clone_problem.T_ != T_ || clone_problem.tau_ != tau_)
+    {
+        clone_problem.T_ = T_;
+        clone_problem.tau_ = tau_;
+        clone_problem.ReinitializeVariables();
+    }
+    clone_problem.cost.y = cost.y;
+    clone_problem.cost.rho = cost.rho;
+    clone_problem.inequality.y = inequality.y;
+    clone_problem.inequality.rho = inequality.rho;
+    clone_problem.equality.y = equality.y;
+    clone_problem.equality.rho = equality.rho;
+    clone_problem.W = W;
+    clone_problem.w_scale_ = w_scale_;
+    clone_problem.use_bounds = use_bounds;
+    clone_problem.xdiff_max_ = xdiff_max_;
+    clone_problem.initial_trajectory_ = initial_trajectory_;
+    clone_problem.InvalidateTimeSteps();
+    clone_problem.PreUpdate();
 }
 
 void AbstractTimeIndexedProblem::SetInitialTrajectory(const std::vector<Eigen::VectorXd>& q_init_in)
@@ -201,69 +266,272 @@ double AbstractTimeIndexedProblem::GetDuration() const
     return tau_ * static_cast<double>(T_);
 }
 
+void AbstractTimeIndexedProblem::SetTrajectoryNumThreads(int num_threads)
+{
+    if (num_threads < 0) ThrowNamed("Invalid number of threads: " << num_threads);
+    trajectory_num_threads_ = Server::ResolveNumThreads(num_threads);
+}
+
+void AbstractTimeIndexedProblem::PreUpdateTrajectoryWorkspaces()
+{
+    for (TrajectoryWorkspace& workspace : trajectory_workspaces_)
+    {
+        for (const TaskMapPtr& map : workspace.maps) map->PreUpdate();
+    }
+}
+
+bool AbstractTimeIndexedProblem::CanUpdateTrajectoryInParallel() const
+{
+    // Task maps using the kinematic responses of previous time steps need the responses of the problem
+    return std::none_of(tasks_.begin(), tasks_.end(), [](const TaskMapPtr& task) { return task->is_used && task->kinematics.size() > 1; });
+}
+
+void AbstractTimeIndexedProblem::UpdateTrajectoryWorkspaces(int num_workspaces)
+{
+    if (trajectory_workspaces_version_ != scene_->GetWorldVersion()) trajectory_workspaces_.clear();
+    trajectory_workspaces_version_ = scene_->GetWorldVersion();
+    while (static_cast<int>(trajectory_workspaces_.size()) < num_workspaces)
+    {
+        TrajectoryWorkspace workspace;
+        workspace.scene = scene_->CloneWorkspace();
+        workspace.maps = CloneTasks(workspace.scene, flags_);
+        trajectory_workspaces_.push_back(workspace);
+    }
+
+    // Joints that are not controlled and the joint limits may have been changed since
+    const std::map<std::string, double> model_state = scene_->GetKinematicTree().GetModelStateMap();
+    const Eigen::MatrixXd& joint_limits = scene_->GetKinematicTree().GetJointLimits();
+    for (int i = 0; i < num_workspaces; ++i)
+    {
+        TrajectoryWorkspace& workspace = trajectory_workspaces_[i];
+        workspace.scene->GetKinematicTree().SetModelState(model_state);
+        workspace.scene->GetKinematicTree().SetJointLimitsLower(joint_limits.col(0));
+        workspace.scene->GetKinematicTree().SetJointLimitsUpper(joint_limits.col(1));
+        for (std::size_t j = 0; j < tasks_.size(); ++j) workspace.maps[j]->is_used = tasks_[j]->is_used;
+    }
+}
+
+void AbstractTimeIndexedProblem::InvalidateTimeSteps()
+{
+    time_step_evaluated_.assign(T_, false);
+    evaluated_x_.assign(T_, Eigen::VectorXd());
+    evaluated_x_previous_.assign(T_, Eigen::VectorXd());
+    evaluated_world_version_ = scene_->GetWorldVersion();
+}
+
+bool AbstractTimeIndexedProblem::IsTimeStepEvaluated(int t) const
+{
+    if (!time_step_evaluated_[t] || evaluated_x_[t].size() != x[t].size() || evaluated_x_previous_[t].size() != x[t - 1].size()) return false;
+    return evaluated_x_[t] == x[t] && evaluated_x_previous_[t] == x[t - 1];
+}
+
+void AbstractTimeIndexedProblem::MarkTimeStepEvaluated(int t)
+{
+    if (static_cast<int>(time_step_evaluated_.size()) != T_) InvalidateTimeSteps();
+    time_step_evaluated_[t] = true;
+    evaluated_x_[t] = x[t];
+    if (t > 0) evaluated_x_previous_[t] = x[t - 1];
+}
+
+void AbstractTimeIndexedProblem::ShiftTrajectory(int k)
+{
+    if (k <= 0 || k >= T_) ThrowPretty("Invalid shift k=" << k << ", needs to be 0 < k < " << T_);
+    if (static_cast<int>(time_step_evaluated_.size()) != T_ || evaluated_world_version_ != scene_->GetWorldVersion()) InvalidateTimeSteps();
+
+    // Vectors of Eigen types are rotated by swapping their storage, task space vectors and derivatives are copied into the allocated storage
+    const int num_shifted = T_ - k;
+    std::rotate(x.begin(), x.begin() + k, x.end());
+    std::rotate(xdiff.begin(), xdiff.begin() + k, xdiff.end());
+    std::rotate(kinematic_solutions_.begin(), kinematic_solutions_.begin() + k, kinematic_solutions_.end());
+    std::rotate(time_step_evaluated_.begin(), time_step_evaluated_.begin() + k, time_step_evaluated_.end());
+    std::rotate(evaluated_x_.begin(), evaluated_x_.begin() + k, evaluated_x_.end());
+    std::rotate(evaluated_x_previous_.begin(), evaluated_x_previous_.begin() + k, evaluated_x_previous_.end());
+    for (int t = 0; t < num_shifted; ++t)
+    {
+        Phi[t] = Phi[t + k];
+        if (flags_ & KIN_J) jacobian[t] = jacobian[t + k];
+        if (flags_ & KIN_H) hessian[t] = hessian[t + k];
+        UpdateTimeIndexedTasks(t);
+    }
+
+    // Extrapolate and evaluate the tail
+    const Eigen::MatrixXd& joint_limits = scene_->GetKinematicTree().GetJointLimits();
+    for (int t = num_shifted; t < T_; ++t)
+    {
+        time_step_evaluated_[t] = false;
+        x[t] = x[t - 1];
+        if (t > 1) x[t] += xdiff[t - 1];
+        x[t] = x[t].cwiseMax(joint_limits.col(0)).cwiseMin(joint_limits.col(1));
+        Update(x[t], t);
+    }
+
+    for (int t = 0; t < T_; ++t) initial_trajectory_[t] = x[t];
+}
+
 void AbstractTimeIndexedProblem::Update(Eigen::VectorXdRefConst x_trajectory_in)
 {
     if (x_trajectory_in.size() != (T_ - 1) * N)
         ThrowPretty("To update using the trajectory Update method, please use a trajectory of size N x (T-1) (" << N * (T_ - 1) << "), given: " << x_trajectory_in.size());
-
+    if (recorder_) recorder_->RecordUpdate(ProblemEventType::UpdateTrajectory, x_trajectory_in);
+    // The time steps are replayed by replaying the trajectory update
+    ProblemRecorder::Suppress suppress_recording(recorder_.get());
+
+    // Time steps whose state and previous state did not change since they were last evaluated are skipped
+    if (static_cast<int>(time_step_evaluated_.size()) != T_ || evaluated_world_version_ != scene_->GetWorldVersion()) InvalidateTimeSteps();
+    for (int t = 1; t < T_; ++t) x[t] = x_trajectory_in.segment((t - 1) * N, N);
+    std::vector<int> time_steps;
+    time_steps.reserve(T_ - 1);
     for (int t = 1; t < T_; ++t)
     {
-        Update(x_trajectory_in.segment((t - 1) * N, N), t);
+        if (!skip_unchanged_time_steps_ || !IsTimeStepEvaluated(t)) time_steps.push_back(t);
     }
-}
+    number_of_recomputed_time_steps_ = static_cast<int>(time_steps.size());
+    if (time_steps.empty()) return;
 
-void AbstractTimeIndexedProblem::Update(Eigen::VectorXdRefConst x_in, int t)
-{
-    ValidateTimeIndex(t);
+    const int num_time_steps = static_cast<int>(time_steps.size());
+    const int num_threads = std::min(trajectory_num_threads_, num_time_steps);
+    if (num_threads > 1 && CanUpdateTrajectoryInParallel())
+    {
+        UpdateTrajectoryWorkspaces(num_threads);
 
-    x[t] = x_in;
+        // Each thread evaluates a contiguous block of time steps on its own clone. Phi, jacobian, hessian and the
+        // time-indexed tasks of distinct time steps are disjoint, hence they are written concurrently.
+        ParallelLoop(num_threads, num_time_steps, [&](int thread, int i) {
+            TrajectoryWorkspace& workspace = trajectory_workspaces_[thread];
+            const int t = time_steps[i];
+            {
+                DistanceCacheSlotGuard distance_cache_slot(*workspace.scene, t);
+                workspace.scene->Update(x[t], static_cast<double>(t) * tau_);
+                UpdateTaskMaps(workspace.maps, t);
+            }
+            UpdateTimeIndexedTasks(t);
+        });
 
-    // Set the corresponding KinematicResponse for KinematicTree in order to
-    // have Kinematics elements updated based in x_in.
-    scene_->GetKinematicTree().SetKinematicResponse(kinematic_solutions_[t]);
+        for (const int t : time_steps)
+        {
+            xdiff[t] = x[t] - x[t - 1];
+            MarkTimeStepEvaluated(t);
+        }
+        number_of_problem_updates_ += num_time_steps;
+        return;
+    }
 
-    // Pass the corresponding number of relevant task kinematics to the TaskMaps
-    // via the PlanningProblem::UpdateMultipleTaskKinematics method. For now we
-    // support passing _two_ timesteps - this can be easily changed later on.
-    std::vector<std::shared_ptr<KinematicResponse>> kinematics_solutions{kinematic_solutions_[t]};
+    // Task maps querying the scene directly (e.g., collision distances) need the scene in the state of each time step.
+    // Otherwise, the kinematics of the whole trajectory are computed in one pass and the collision object transforms are refreshed only once.
+    trajectory_kinematics_updated_ = std::none_of(tasks_.begin(), tasks_.end(), [](const TaskMapPtr& task) { return task->is_used && task->UsesSceneState(); });
+    if (trajectory_kinematics_updated_)
+    {
+        scene_->UpdateTrajectory(x, kinematic_solutions_, tau_, time_steps.front());
+    }
 
-    // If the current timestep is 0, pass the 0th timestep's response twice.
-    // Otherwise pass the (t-1)th response.
-    kinematics_solutions.emplace_back((t == 0) ? kinematic_solutions_[t] : kinematic_solutions_[t - 1]);
+    try
+    {
+        UpdateTrajectoryTaskMaps(time_steps);
+        for (const int t : time_steps)
+        {
+            Update(x_trajectory_in.segment((t - 1) * N, N), t);
+        }
+    }
+    catch (...)
+    {
+        trajectory_kinematics_updated_ = false;
+        trajectory_task_maps_updated_ = false;
+        throw;
+    }
+    trajectory_kinematics_updated_ = false;
+    trajectory_task_maps_updated_ = false;
+}
 
-    // Actually update the tasks' kinematics mappings.
-    PlanningProblem::UpdateMultipleTaskKinematics(kinematics_solutions);
+void AbstractTimeIndexedProblem::UpdateTrajectoryTaskMaps(const std::vector<int>& time_steps)
+{
+    // The task-map Hessians are only available per time step
+    if (flags_ & KIN_H) return;
+
+    const int num_time_steps = static_cast<int>(time_steps.size());
+    Eigen::MatrixXd states(N, num_time_steps);
+    for (int k = 0; k < num_time_steps; ++k) states.col(k) = x[time_steps[k]];
+
+    Eigen::MatrixXd phi;
+    std::vector<Eigen::Triplet<double>> triplets;
+    for (int i = 0; i < num_tasks; ++i)
+    {
+        const TaskMapPtr& map = tasks_[i];
+        if (!map->is_used || !map->HasTrajectoryUpdate() || map->UsesPreviousStates()) continue;
+
+        EXOTICA_PROFILE_SCOPE("TaskMap::UpdateTrajectory");
+        phi.resize(map->length, num_time_steps);
+        if (flags_ & KIN_J)
+        {
+            map->UpdateTrajectory(states, phi, triplets);
+            for (const int t : time_steps) jacobian[t].middleRows(map->start_jacobian, map->length_jacobian).setZero();
+            // Without previous states, the Jacobian only has the blocks of each time step w.r.t. its own state
+            for (const Eigen::Triplet<double>& triplet : triplets)
+            {
+                const int k = triplet.row() / map->length_jacobian;
+                if (triplet.col() / N != k) ThrowPretty("Task map '" << map->GetObjectName() << "' depends on other time steps.");
+                jacobian[time_steps[k]](map->start_jacobian + triplet.row() % map->length_jacobian, triplet.col() % N) += triplet.value();
+            }
+        }
+        else
+        {
+            map->UpdateTrajectory(states, phi);
+        }
+        for (int k = 0; k < num_time_steps; ++k) Phi[time_steps[k]].data.segment(map->start, map->length) = phi.col(k);
+    }
+    trajectory_task_maps_updated_ = true;
+}
 
+void AbstractTimeIndexedProblem::UpdateScene(Eigen::VectorXdRefConst x_in, int t)
+{
+    // The response of this time step has been filled in by Scene::UpdateTrajectory already
+    if (trajectory_kinematics_updated_) return;
     scene_->Update(x_in, static_cast<double>(t) * tau_);
-    Phi[t].SetZero(length_Phi);
-    if (flags_ & KIN_J) jacobian[t].setZero();
-    if (flags_ & KIN_H)
-        for (int i = 0; i < length_jacobian; ++i) hessian[t](i).setZero();
+}
+
+void AbstractTimeIndexedProblem::UpdateTaskMaps(const TaskMapVec& maps, int t)
+{
     for (int i = 0; i < num_tasks; ++i)
     {
-        // Only update TaskMap if rho is not 0
-        if (tasks_[i]->is_used)
+        // Only the TaskMaps weighted at this time step are differentiated, e.g., a via-point only at its time step.
+        // The other TaskMaps used by the problem are still evaluated, such that Phi and the task errors are current, their derivatives keep their last values.
+        if (trajectory_task_maps_updated_ && maps[i]->is_used && maps[i]->HasTrajectoryUpdate() && !maps[i]->UsesPreviousStates()) continue;
+        if (cost.IsTaskMapActive(i, t) || inequality.IsTaskMapActive(i, t) || equality.IsTaskMapActive(i, t))
         {
+            EXOTICA_PROFILE_SCOPE("TaskMap::Update");
+            Phi[t].data.segment(maps[i]->start, maps[i]->length).setZero();
+            if (flags_ & KIN_J) jacobian[t].middleRows(maps[i]->start_jacobian, maps[i]->length_jacobian).setZero();
+            if (flags_ & KIN_H)
+                for (int j = maps[i]->start_jacobian; j < maps[i]->start_jacobian + maps[i]->length_jacobian; ++j) hessian[t](j).setZero();
             if (flags_ & KIN_H)
             {
-                tasks_[i]->Update(x[t],
-                                  Phi[t].data.segment(tasks_[i]->start, tasks_[i]->length),
-                                  jacobian[t].middleRows(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian),
-                                  hessian[t].segment(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian));
+                maps[i]->Update(x[t],
+                                Phi[t].data.segment(maps[i]->start, maps[i]->length),
+                                jacobian[t].middleRows(maps[i]->start_jacobian, maps[i]->length_jacobian),
+                                hessian[t].segment(maps[i]->start_jacobian, maps[i]->length_jacobian));
             }
             else if (flags_ & KIN_J)
             {
-                tasks_[i]->Update(x[t],
-                                  Phi[t].data.segment(tasks_[i]->start, tasks_[i]->length),
-                                  Eigen::MatrixXdRef(jacobian[t].middleRows(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian))  // Adding MatrixXdRef(...) is a work-around for issue #737 when using Eigen 3.3.9
+                maps[i]->Update(x[t],
+                                Phi[t].data.segment(maps[i]->start, maps[i]->length),
+                                Eigen::MatrixXdRef(jacobian[t].middleRows(maps[i]->start_jacobian, maps[i]->length_jacobian))  // Adding MatrixXdRef(...) is a work-around for issue #737 when using Eigen 3.3.9
                 );
             }
             else
             {
-                tasks_[i]->Update(x[t], Phi[t].data.segment(tasks_[i]->start, tasks_[i]->length));
+                maps[i]->Update(x[t], Phi[t].data.segment(maps[i]->start, maps[i]->length));
             }
         }
+        else if (maps[i]->is_used)
+        {
+            EXOTICA_PROFILE_SCOPE("TaskMap::Update");
+            Phi[t].data.segment(maps[i]->start, maps[i]->length).setZero();
+            maps[i]->Update(x[t], Phi[t].data.segment(maps[i]->start, maps[i]->length));
+        }
     }
+}
+
+void AbstractTimeIndexedProblem::UpdateTimeIndexedTasks(int t)
+{
     if (flags_ & KIN_H)
     {
         cost.Update(Phi[t], jacobian[t], hessian[t], t);
@@ -282,7 +550,40 @@ void AbstractTimeIndexedProblem::Update(Eigen::VectorXdRefConst x_in, int t)
         inequality.Update(Phi[t], t);
         equality.Update(Phi[t], t);
     }
+}
+
+void AbstractTimeIndexedProblem::Update(Eigen::VectorXdRefConst x_in, int t)
+{
+    if (recorder_) recorder_->RecordUpdate(ProblemEventType::Update, x_in, t);
+    ValidateTimeIndex(t);
+
+    x[t] = x_in;
+
+    // Set the corresponding KinematicResponse for KinematicTree in order to
+    // have Kinematics elements updated based in x_in.
+    scene_->GetKinematicTree().SetKinematicResponse(kinematic_solutions_[t]);
+
+    // Pass the corresponding number of relevant task kinematics to the TaskMaps
+    // via the PlanningProblem::UpdateMultipleTaskKinematics method. For now we
+    // support passing _two_ timesteps - this can be easily changed later on.
+    std::vector<std::shared_ptr<KinematicResponse>> kinematics_solutions{kinematic_solutions_[t]};
+
+    // If the current timestep is 0, pass the 0th timestep's response twice.
+    // Otherwise pass the (t-1)th response.
+    kinematics_solutions.emplace_back((t == 0) ? kinematic_solutions_[t] : kinematic_solutions_[t - 1]);
+
+    // Actually update the tasks' kinematics mappings.
+    PlanningProblem::UpdateMultipleTaskKinematics(kinematics_solutions);
+
+    {
+        // The task maps query the distances of this time step as well
+        DistanceCacheSlotGuard distance_cache_slot(*scene_, t);
+        UpdateScene(x_in, t);
+        UpdateTaskMaps(tasks_, t);
+    }
+    UpdateTimeIndexedTasks(t);
     if (t > 0) xdiff[t] = x[t] - x[t - 1];
+    MarkTimeStepEvaluated(t);
     ++number_of_problem_updates_;
 }
 
@@ -303,37 +604,64 @@ double AbstractTimeIndexedProblem::GetCost() const
 
 Eigen::RowVectorXd AbstractTimeIndexedProblem::GetCostJacobian() const
 {
-    Eigen::RowVectorXd jac = Eigen::RowVectorXd::Zero(N * (T_ - 1));
+    Eigen::RowVectorXd jac(N * (T_ - 1));
+    GetCostJacobian(jac);
+    return jac;
+}
+
+void AbstractTimeIndexedProblem::GetCostJacobian(Eigen::Ref<Eigen::RowVectorXd> jacobian) const
+{
+    if (jacobian.cols() != N * (T_ - 1)) ThrowPretty("Wrong size of the cost Jacobian: " << jacobian.cols() << " expecting " << N * (T_ - 1));
+    jacobian.setZero();
     for (int t = 1; t < T_; ++t)
     {
-        jac.segment((t - 1) * N, N) += GetScalarTaskJacobian(t) + GetScalarTransitionJacobian(t);
-        if (t > 1) jac.segment((t - 2) * N, N) -= GetScalarTransitionJacobian(t);
+        // Accumulating the weighted rows of the task Jacobian avoids evaluating the weighted error into a temporary
+        for (int i = 0; i < cost.length_jacobian; ++i) jacobian.segment((t - 1) * N, N).noalias() += (2.0 * ct * cost.S[t](i, i) * cost.ydiff[t](i)) * cost.jacobian[t].row(i);
+        jacobian.segment((t - 1) * N, N).noalias() += (2.0 * ct) * W.lazyProduct(xdiff[t]).transpose();
+        if (t > 1) jacobian.segment((t - 2) * N, N).noalias() -= (2.0 * ct) * W.lazyProduct(xdiff[t]).transpose();
     }
-    return jac;
 }
 
 double AbstractTimeIndexedProblem::GetScalarTaskCost(int t) const
 {
     ValidateTimeIndex(t);
-    return ct * cost.ydiff[t].transpose() * cost.S[t] * cost.ydiff[t];
+    return ct * cost.ydiff[t].dot(cost.S[t].diagonal().cwiseProduct(cost.ydiff[t]));
 }
 
 Eigen::RowVectorXd AbstractTimeIndexedProblem::GetScalarTaskJacobian(int t) const
 {
+    Eigen::RowVectorXd jacobian(N);
+    GetScalarTaskJacobian(t, jacobian);
+    return jacobian;
+}
+
+void AbstractTimeIndexedProblem::GetScalarTaskJacobian(int t, Eigen::Ref<Eigen::RowVectorXd> jacobian) const
+{
+    EXOTICA_PROFILE_SCOPE("AbstractTimeIndexedProblem::GetScalarTaskJacobian");
     ValidateTimeIndex(t);
-    return cost.jacobian[t].transpose() * cost.S[t] * cost.ydiff[t] * 2.0 * ct;
+    if (jacobian.cols() != N) ThrowPretty("Wrong size of the task Jacobian: " << jacobian.cols() << " expecting " << N);
+    jacobian.setZero();
+    for (int i = 0; i < cost.length_jacobian; ++i) jacobian.noalias() += (2.0 * ct * cost.S[t](i, i) * cost.ydiff[t](i)) * cost.jacobian[t].row(i);
 }
 
 double AbstractTimeIndexedProblem::GetScalarTransitionCost(int t) const
 {
     ValidateTimeIndex(t);
-    return ct * xdiff[t].transpose() * W * xdiff[t];
+    return ct * xdiff[t].dot(W.lazyProduct(xdiff[t]));
 }
 
 Eigen::RowVectorXd AbstractTimeIndexedProblem::GetScalarTransitionJacobian(int t) const
+{
+    Eigen::RowVectorXd jacobian(N);
+    GetScalarTransitionJacobian(t, jacobian);
+    return jacobian;
+}
+
+void AbstractTimeIndexedProblem::GetScalarTransitionJacobian(int t, Eigen::Ref<Eigen::RowVectorXd> jacobian) const
 {
     ValidateTimeIndex(t);
-    return 2.0 * ct * W * xdiff[t];
+    if (jacobian.cols() != N) ThrowPretty("Wrong size of the transition Jacobian: " << jacobian.cols() << " expecting " << N);
+    jacobian.noalias() = (2.0 * ct) * W.lazyProduct(xdiff[t]).transpose();
 }
 
 int AbstractTimeIndexedProblem::get_active_nonlinear_equality_constraints_dimension() const
@@ -406,13 +734,13 @@ std::vector<Eigen::Triplet<double>> AbstractTimeIndexedProblem::GetEqualityJacob
 Eigen::VectorXd AbstractTimeIndexedProblem::GetEquality(int t) const
 {
     ValidateTimeIndex(t);
-    return equality.S[t] * equality.ydiff[t];
+    return equality.S[t].diagonal().cwiseProduct(equality.ydiff[t]);
 }
 
 Eigen::MatrixXd AbstractTimeIndexedProblem::GetEqualityJacobian(int t) const
 {
     ValidateTimeIndex(t);
-    return equality.S[t] * equality.jacobian[t];
+    return equality.S[t].diagonal().asDiagonal() * equality.jacobian[t];
 }
 
 Eigen::VectorXd AbstractTimeIndexedProblem::GetInequality() const
@@ -472,16 +800,193 @@ std::vector<Eigen::Triplet<double>> AbstractTimeIndexedProblem::GetInequalityJac
     return triplet_list;
 }
 
+void AbstractTimeIndexedProblem::StructuredSparseMatrix::SetPattern(int rows, int cols, const std::vector<Eigen::Triplet<double>>& entries)
+{
+    // The entries are unique, hence the values of the pattern tell where each entry ended up in the compressed storage
+    std::vector<Eigen::Triplet<double>> positions;
+    positions.reserve(entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i) positions.emplace_back(entries[i].row(), entries[i].col(), static_cast<double>(i));
+    matrix.resize(rows, cols);
+    matrix.setFromTriplets(positions.begin(), positions.end());
+    matrix.makeCompressed();
+    if (matrix.nonZeros() != static_cast<Eigen::Index>(entries.size())) ThrowPretty("The entries of a structured sparse matrix have to be unique!");
+    value_index.resize(entries.size());
+    for (Eigen::Index k = 0; k < matrix.nonZeros(); ++k) value_index[static_cast<std::size_t>(matrix.valuePtr()[k])] = static_cast<int>(k);
+}
+
+void AbstractTimeIndexedProblem::UpdateConstraintJacobianStructured(const TimeIndexedTask& task, const std::vector<std::pair<int, int>>& active_constraints, int dimension, StructuredSparseMatrix& jacobian) const
+{
+    // The entries are enumerated in the same order as by the triplet variants: active constraint, row, column
+    if (jacobian.constraints != active_constraints || jacobian.matrix.rows() != dimension || jacobian.matrix.cols() != N * (T_ - 1))
+    {
+        std::vector<Eigen::Triplet<double>> entries;
+        entries.reserve(dimension * N);
+        int start = 0;
+        for (const auto& constraint : active_constraints)
+        {
+            const TaskIndexing& indexing = task.indexing[constraint.second];
+            for (int row = start; row < start + indexing.length_jacobian; ++row)
+                for (int column = (constraint.first - 1) * N; column < constraint.first * N; ++column) entries.emplace_back(row, column, 0.0);
+            start += indexing.length_jacobian;
+        }
+        jacobian.SetPattern(dimension, N * (T_ - 1), entries);
+        jacobian.constraints = active_constraints;
+    }
+
+    double* values = jacobian.matrix.valuePtr();
+    std::size_t entry = 0;
+    for (const auto& constraint : active_constraints)
+    {
+        const TaskIndexing& indexing = task.indexing[constraint.second];
+        const double rho = task.rho[constraint.first](indexing.id);
+        const Eigen::MatrixXd& task_jacobian = task.jacobian[constraint.first];
+        for (int i = 0; i < indexing.length_jacobian; ++i)
+            for (int j = 0; j < N; ++j) values[jacobian.value_index[entry++]] = rho * task_jacobian(indexing.start_jacobian + i, j);
+    }
+}
+
+const Eigen::SparseMatrix<double>& AbstractTimeIndexedProblem::GetEqualityJacobianStructured()
+{
+    UpdateConstraintJacobianStructured(equality, active_nonlinear_equality_constraints_, active_nonlinear_equality_constraints_dimension_, equality_jacobian_structured_);
+    return equality_jacobian_structured_.matrix;
+}
+
+const Eigen::SparseMatrix<double>& AbstractTimeIndexedProblem::GetInequalityJacobianStructured()
+{
+    UpdateConstraintJacobianStructured(inequality, active_nonlinear_inequality_constraints_, active_nonlinear_inequality_constraints_dimension_, inequality_jacobian_structured_);
+    return inequality_jacobian_structured_.matrix;
+}
+
+void AbstractTimeIndexedProblem::GetCostHessianBlocks(std::vector<Eigen::MatrixXd>& diagonal, std::vector<Eigen::MatrixXd>& off_diagonal) const
+{
+    diagonal.resize(T_ - 1);
+    off_diagonal.resize(T_ - 2);
+    // Transition cost ct * xdiff_t^T W xdiff_t couples x_t and x_{t-1}, x_0 is fixed
+    const Eigen::MatrixXd W_sym = ct * (W + W.transpose());
+    for (int t = 1; t < T_; ++t)
+    {
+        Eigen::MatrixXd& block = diagonal[t - 1];
+
+        // Task cost ct * ydiff^T S ydiff
+        const Eigen::VectorXd s = cost.S[t].diagonal();
+        block.noalias() = 2.0 * ct * cost.jacobian[t].transpose() * s.asDiagonal() * cost.jacobian[t];
+        if (flags_ & KIN_H)
+        {
+            const Eigen::VectorXd s_ydiff = s.cwiseProduct(cost.ydiff[t]);
+            for (int i = 0; i < cost.length_jacobian; ++i)
+            {
+                if (s_ydiff(i) != 0.0) block += 2.0 * ct * s_ydiff(i) * cost.hessian[t](i);
+            }
+        }
+
+        block += W_sym;
+        if (t < T_ - 1)
+        {
+            block += W_sym;
+            off_diagonal[t - 1] = -W_sym;
+        }
+    }
+}
+
+Eigen::VectorXd AbstractTimeIndexedProblem::GetCostHessianVectorProduct(Eigen::VectorXdRefConst v) const
+{
+    Eigen::VectorXd hv(N * (T_ - 1));
+    GetCostHessianVectorProduct(v, hv);
+    return hv;
+}
+
+void AbstractTimeIndexedProblem::GetCostHessianVectorProduct(Eigen::VectorXdRefConst v, Eigen::Ref<Eigen::VectorXd> hv) const
+{
+    const int dimension = N * (T_ - 1);
+    if (v.size() != dimension) ThrowPretty("Wrong size of v: " << v.size() << " expecting " << dimension);
+    if (hv.size() != dimension) ThrowPretty("Wrong size of hv: " << hv.size() << " expecting " << dimension);
+
+    // Same terms as GetCostHessianBlocks, applied to v block by block
+    const Eigen::MatrixXd W_sym = ct * (W + W.transpose());
+    Eigen::VectorXd Jv(cost.length_jacobian);
+    for (int t = 1; t < T_; ++t)
+    {
+        const auto v_t = v.segment((t - 1) * N, N);
+        auto hv_t = hv.segment((t - 1) * N, N);
+
+        // Task cost ct * ydiff^T S ydiff
+        const Eigen::VectorXd s = cost.S[t].diagonal();
+        Jv.noalias() = cost.jacobian[t] * v_t;
+        Jv.array() *= 2.0 * ct * s.array();
+        hv_t.noalias() = cost.jacobian[t].transpose() * Jv;
+        if (flags_ & KIN_H)
+        {
+            for (int i = 0; i < cost.length_jacobian; ++i)
+            {
+                const double s_ydiff = s(i) * cost.ydiff[t](i);
+                if (s_ydiff != 0.0) hv_t.noalias() += (2.0 * ct * s_ydiff) * (cost.hessian[t](i) * v_t);
+            }
+        }
+
+        // Transition cost, x_0 is fixed
+        hv_t.noalias() += W_sym * v_t;
+        if (t > 1) hv_t.noalias() -= W_sym * v.segment((t - 2) * N, N);
+        if (t < T_ - 1) hv_t.noalias() += W_sym * (v_t - v.segment(t * N, N));
+    }
+}
+
+const Eigen::SparseMatrix<double>& AbstractTimeIndexedProblem::GetCostHessianStructured()
+{
+    const int dimension = N * (T_ - 1);
+    if (cost_hessian_structured_.matrix.rows() != dimension)
+    {
+        // Dense blocks on the diagonal and next to it, enumerated block by block in GetCostHessianBlocks order: diagonal, then below and above
+        std::vector<Eigen::Triplet<double>> entries;
+        entries.reserve(static_cast<std::size_t>(3 * T_) * N * N);
+        for (int t = 1; t < T_; ++t)
+        {
+            const int offset = (t - 1) * N;
+            for (int i = 0; i < N; ++i)
+                for (int j = 0; j < N; ++j) entries.emplace_back(offset + i, offset + j, 0.0);
+            if (t < T_ - 1)
+            {
+                for (int i = 0; i < N; ++i)
+                    for (int j = 0; j < N; ++j)
+                    {
+                        entries.emplace_back(offset + N + i, offset + j, 0.0);
+                        entries.emplace_back(offset + j, offset + N + i, 0.0);
+                    }
+            }
+        }
+        cost_hessian_structured_.SetPattern(dimension, dimension, entries);
+    }
+
+    std::vector<Eigen::MatrixXd> diagonal, off_diagonal;
+    GetCostHessianBlocks(diagonal, off_diagonal);
+    double* values = cost_hessian_structured_.matrix.valuePtr();
+    std::size_t entry = 0;
+    for (int t = 1; t < T_; ++t)
+    {
+        for (int i = 0; i < N; ++i)
+            for (int j = 0; j < N; ++j) values[cost_hessian_structured_.value_index[entry++]] = diagonal[t - 1](i, j);
+        if (t < T_ - 1)
+        {
+            for (int i = 0; i < N; ++i)
+                for (int j = 0; j < N; ++j)
+                {
+                    values[cost_hessian_structured_.value_index[entry++]] = off_diagonal[t - 1](i, j);
+                    values[cost_hessian_structured_.value_index[entry++]] = off_diagonal[t - 1](i, j);
+                }
+        }
+    }
+    return cost_hessian_structured_.matrix;
+}
+
 Eigen::VectorXd AbstractTimeIndexedProblem::GetInequality(int t) const
 {
     ValidateTimeIndex(t);
-    return inequality.S[t] * inequality.ydiff[t];
+    return inequality.S[t].diagonal().cwiseProduct(inequality.ydiff[t]);
 }
 
 Eigen::MatrixXd AbstractTimeIndexedProblem::GetInequalityJacobian(int t) const
 {
     ValidateTimeIndex(t);
-    return inequality.S[t] * inequality.jacobian[t];
+    return inequality.S[t].diagonal().asDiagonal() * inequality.jacobian[t];
 }
 
 int AbstractTimeIndexedProblem::get_joint_velocity_constraint_dimension() const
@@ -552,11 +1057,14 @@ std::vector<Eigen::Triplet<double>> AbstractTimeIndexedProblem::GetJointVelocity
 
 void AbstractTimeIndexedProblem::SetGoal(const std::string& task_name, Eigen::VectorXdRefConst goal, int t)
 {
+    if (recorder_) recorder_->RecordGoal(ProblemEventType::SetGoal, task_name, goal, t);
     cost.SetGoal(task_name, goal, t);
+    InvalidateTimeSteps();
 }
 
 void AbstractTimeIndexedProblem::SetRho(const std::string& task_name, const double rho, int t)
 {
+    if (recorder_) recorder_->RecordRho(ProblemEventType::SetRho, task_name, rho, t);
     cost.SetRho(task_name, rho, t);
     PreUpdate();
 }
@@ -573,11 +1081,14 @@ double AbstractTimeIndexedProblem::GetRho(const std::string& task_name, int t)
 
 void AbstractTimeIndexedProblem::SetGoalEQ(const std::string& task_name, Eigen::VectorXdRefConst goal, int t)
 {
+    if (recorder_) recorder_->RecordGoal(ProblemEventType::SetGoalEQ, task_name, goal, t);
     equality.SetGoal(task_name, goal, t);
+    InvalidateTimeSteps();
 }
 
 void AbstractTimeIndexedProblem::SetRhoEQ(const std::string& task_name, const double rho, int t)
 {
+    if (recorder_) recorder_->RecordRho(ProblemEventType::SetRhoEQ, task_name, rho, t);
     equality.SetRho(task_name, rho, t);
     PreUpdate();
 }
@@ -594,11 +1105,14 @@ double AbstractTimeIndexedProblem::GetRhoEQ(const std::string& task_name, int t)
 
 void AbstractTimeIndexedProblem::SetGoalNEQ(const std::string& task_name, Eigen::VectorXdRefConst goal, int t)
 {
+    if (recorder_) recorder_->RecordGoal(ProblemEventType::SetGoalNEQ, task_name, goal, t);
     inequality.SetGoal(task_name, goal, t);
+    InvalidateTimeSteps();
 }
 
 void AbstractTimeIndexedProblem::SetRhoNEQ(const std::string& task_name, const double rho, int t)
 {
+    if (recorder_) recorder_->RecordRho(ProblemEventType::SetRhoNEQ, task_name, rho, t);
     inequality.SetRho(task_name, rho, t);
     PreUpdate();
 }
@@ -105,14 +105,39 @@ void BoundedEndPoseProblem::PreUpdate()
     cost.UpdateS();
 }
 
+void BoundedEndPoseProblem::UpdateClone(PlanningProblem& clone) const
+{
+    UpdateCloneBase(clone);
+    BoundedEndPoseProblem& clone_problem = static_cast<BoundedEndPoseProblem&>(clone);
+    clone_problem.cost.y = cost.y;
+    clone_problem.cost.rho = cost.rho;
+    clone_problem.W = W;
+    clone_problem.PreUpdate();
+}
+
+double BoundedEndPoseProblem::UpdateEndPoseCost(Eigen::VectorXdRefConst x)
+{
+    Update(x);
+    return GetScalarCost();
+}
+
 double BoundedEndPoseProblem::GetScalarCost() const
 {
-    return cost.ydiff.transpose() * cost.S * cost.ydiff;
+    return cost.ydiff.dot(cost.S.diagonal().cwiseProduct(cost.ydiff));
 }
 
 Eigen::RowVectorXd BoundedEndPoseProblem::GetScalarJacobian() const
 {
-    return cost.jacobian.transpose() * cost.S * cost.ydiff * 2.0;
+    Eigen::RowVectorXd jacobian(N);
+    GetScalarJacobian(jacobian);
+    return jacobian;
+}
+
+void BoundedEndPoseProblem::GetScalarJacobian(Eigen::Ref<Eigen::RowVectorXd> jacobian) const
+{
+    if (jacobian.cols() != N) ThrowPretty("Wrong size of the Jacobian: " << jacobian.cols() << " expecting " << N);
+    jacobian.setZero();
+    for (int i = 0; i < cost.length_jacobian; ++i) jacobian.noalias() += (2.0 * cost.S(i, i) * cost.ydiff(i)) * cost.jacobian.row(i);
 }
 
 double BoundedEndPoseProblem::GetScalarTaskCost(const std::string& task_name) const
@@ -129,6 +154,7 @@ double BoundedEndPoseProblem::GetScalarTaskCost(const std::string& task_name) co
 
 void BoundedEndPoseProblem::Update(Eigen::VectorXdRefConst x)
 {
+    if (recorder_) recorder_->RecordUpdate(ProblemEventType::Update, x);
     scene_->Update(x, t_start);
     Phi.SetZero(length_Phi);
     if (flags_ & KIN_J) jacobian.setZero();
@@ -138,6 +164,7 @@ void BoundedEndPoseProblem::Update(Eigen::VectorXdRefConst x)
     {
         if (tasks_[i]->is_used)
         {
+            EXOTICA_PROFILE_SCOPE("TaskMap::Update");
             if (flags_ & KIN_H)
             {
                 tasks_[i]->Update(x,
@@ -175,6 +202,7 @@ void BoundedEndPoseProblem::Update(Eigen::VectorXdRefConst x)
 
 void BoundedEndPoseProblem::SetGoal(const std::string& task_name, Eigen::VectorXdRefConst goal)
 {
+    if (recorder_) recorder_->RecordGoal(ProblemEventType::SetGoal, task_name, goal);
     for (int i = 0; i < cost.indexing.size(); ++i)
     {
         if (cost.tasks[i]->GetObjectName() == task_name)
@@ -189,6 +217,7 @@ void BoundedEndPoseProblem::SetGoal(const std::string& task_name, Eigen::VectorX
 
 void BoundedEndPoseProblem::SetRho(const std::string& task_name, const double& rho)
 {
+    if (recorder_) recorder_->RecordRho(ProblemEventType::SetRho, task_name, rho);
     for (int i = 0; i < cost.indexing.size(); ++i)
     {
         if (cost.tasks[i]->GetObjectName() == task_name)
@@ -59,6 +59,8 @@ void BoundedTimeIndexedProblem::Instantiate(const BoundedTimeIndexedProblemIniti
 
     T_ = this->parameters_.T;
     tau_ = this->parameters_.tau;
+    SetTrajectoryNumThreads(this->parameters_.TrajectoryNumThreads);
+    SetSkipUnchangedTimeSteps(this->parameters_.SkipUnchangedTimeSteps);
     ApplyStartState(false);
     ReinitializeVariables();
 }
@@ -73,63 +75,13 @@ void BoundedTimeIndexedProblem::PreUpdate()
     // based on the lastest KinematicResponse in order to reflect model state
     // updates etc.
     kinematic_solutions_.clear();
-    kinematic_solutions_.resize(T_);
-    for (int i = 0; i < T_; ++i) kinematic_solutions_[i] = std::make_shared<KinematicResponse>(*scene_->GetKinematicTree().GetKinematicResponse());
+    scene_->GetKinematicTree().GetKinematicResponses(T_, kinematic_solutions_);
+    PreUpdateTrajectoryWorkspaces();
+    InvalidateTimeSteps();
 }
 
-void BoundedTimeIndexedProblem::Update(Eigen::VectorXdRefConst x_in, int t)
+void BoundedTimeIndexedProblem::UpdateTimeIndexedTasks(int t)
 {
-    ValidateTimeIndex(t);
-
-    x[t] = x_in;
-
-    // Set the corresponding KinematicResponse for KinematicTree in order to
-    // have Kinematics elements updated based in x_in.
-    scene_->GetKinematicTree().SetKinematicResponse(kinematic_solutions_[t]);
-
-    // Pass the corresponding number of relevant task kinematics to the TaskMaps
-    // via the PlanningProblem::UpdateMultipleTaskKinematics method. For now we
-    // support passing _two_ timesteps - this can be easily changed later on.
-    std::vector<std::shared_ptr<KinematicResponse>> kinematics_solutions{kinematic_solutions_[t]};
-
-    // If the current timestep is 0, pass the 0th timestep's response twice.
-    // Otherwise pass the (t-1)th response.
-    kinematics_solutions.emplace_back((t == 0) ? kinematic_solutions_[t] : kinematic_solutions_[t - 1]);
-
-    // Actually update the tasks' kinematics mappings.
-    PlanningProblem::UpdateMultipleTaskKinematics(kinematics_solutions);
-
-    scene_->Update(x_in, static_cast<double>(t) * tau_);
-
-    Phi[t].SetZero(length_Phi);
-    if (flags_ & KIN_J) jacobian[t].setZero();
-    if (flags_ & KIN_H)
-        for (int i = 0; i < length_jacobian; ++i) hessian[t](i).setZero();
-    for (int i = 0; i < num_tasks; ++i)
-    {
-        // Only update TaskMap if rho is not 0
-        if (tasks_[i]->is_used)
-        {
-            if (flags_ & KIN_H)
-            {
-                tasks_[i]->Update(x[t],
-                                  Phi[t].data.segment(tasks_[i]->start, tasks_[i]->length),
-                                  jacobian[t].middleRows(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian),
-                                  hessian[t].segment(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian));
-            }
-            else if (flags_ & KIN_J)
-            {
-                tasks_[i]->Update(x[t],
-                                  Phi[t].data.segment(tasks_[i]->start, tasks_[i]->length),
-                                  Eigen::MatrixXdRef(jacobian[t].middleRows(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian))  // Adding MatrixXdRef(...) is a work-around for issue #737 when using Eigen 3.3.9
-                );
-            }
-            else
-            {
-                tasks_[i]->Update(x[t], Phi[t].data.segment(tasks_[i]->start, tasks_[i]->length));
-            }
-        }
-    }
     if (flags_ & KIN_H)
     {
         cost.Update(Phi[t], jacobian[t], hessian[t], t);
@@ -142,10 +94,6 @@ void BoundedTimeIndexedProblem::Update(Eigen::VectorXdRefConst x_in, int t)
     {
         cost.Update(Phi[t], t);
     }
-
-    if (t > 0) xdiff[t] = x[t] - x[t - 1];
-
-    ++number_of_problem_updates_;
 }
 
 void BoundedTimeIndexedProblem::ReinitializeVariables()
@@ -168,7 +116,7 @@ void BoundedTimeIndexedProblem::ReinitializeVariables()
 
     x.assign(T_, Eigen::VectorXd::Zero(N));
     xdiff.assign(T_, Eigen::VectorXd::Zero(N));
-    if (flags_ & KIN_J) jacobian.assign(T_, Eigen::MatrixXd(length_jacobian, N));
+    if (flags_ & KIN_J) jacobian.assign(T_, Eigen::MatrixXd::Zero(length_jacobian, N));
     if (flags_ & KIN_H)
     {
         Hessian Htmp;
@@ -28,10 +28,13 @@
 //
 
 #include <exotica_core/problems/dynamic_time_indexed_shooting_problem.h>
+#include <exotica_core/server.h>
 #include <exotica_core/setup.h>
 #include <exotica_core/tools/conversions.h>
-#include <exotica_core/tools/sparse_costs.h>
+#include <exotica_core/tools/parallel_loop.h>
+#include <algorithm>
 #include <cmath>
+#include <thread>
 
 REGISTER_PROBLEM_TYPE("DynamicTimeIndexedShootingProblem", exotica::DynamicTimeIndexedShootingProblem)
 
@@ -105,6 +108,36 @@ void DynamicTimeIndexedShootingProblem::InstantiateCostTerms(const DynamicTimeIn
     }
 
     control_cost_weight_ = parameters_.ControlCostWeight;
+
+    control_loss_gradient_.resize(scene_->get_num_controls());
+    control_loss_hessian_.resize(scene_->get_num_controls());
+    set_loss_type(loss_type_);
+}
+
+void DynamicTimeIndexedShootingProblem::set_loss_type(const ControlCostLossTermType& loss_type_in)
+{
+    // The loss is selected once here instead of for every control of every time step
+    switch (loss_type_in)
+    {
+        case ControlCostLossTermType::L2:
+            control_loss_ = &L2Loss::Evaluate;
+            break;
+        case ControlCostLossTermType::SmoothL1:
+            control_loss_ = &SmoothL1Loss::Evaluate;
+            control_loss_rate_ = &l1_rate_;
+            break;
+        case ControlCostLossTermType::Huber:
+            control_loss_ = &HuberLoss::Evaluate;
+            control_loss_rate_ = &huber_rate_;
+            break;
+        case ControlCostLossTermType::PseudoHuber:
+            control_loss_ = &PseudoHuberLoss::Evaluate;
+            control_loss_rate_ = &huber_rate_;
+            break;
+        default:
+            ThrowPretty("Unknown loss type: " << loss_type_in);
+    }
+    loss_type_ = loss_type_in;
 }
 
 void DynamicTimeIndexedShootingProblem::Instantiate(const DynamicTimeIndexedShootingProblemInitializer& init)
@@ -112,6 +145,9 @@ void DynamicTimeIndexedShootingProblem::Instantiate(const DynamicTimeIndexedShoo
     this->parameters_ = init;
 
     if (!scene_->GetDynamicsSolver()) ThrowPretty("DynamicsSolver is not initialised!");
+    // Velocity-level kinematics (KIN_J_DOT) require the velocities in the same coordinates as the configuration
+    if (flags_ & KIN_J_DOT && scene_->GetDynamicsSolver()->get_num_velocities() != scene_->GetKinematicTree().GetNumControlledJoints())
+        ThrowPretty("VelocityKinematics requires as many velocities as controlled joints: the dynamics solver has " << scene_->GetDynamicsSolver()->get_num_velocities() << " velocities for " << scene_->GetKinematicTree().GetNumControlledJoints() << " joints.");
 
     const int NX = scene_->get_num_positions() + scene_->get_num_velocities(),
               NDX = 2 * scene_->get_num_velocities(),
@@ -230,6 +266,7 @@ void DynamicTimeIndexedShootingProblem::Instantiate(const DynamicTimeIndexedShoo
         stochastic_matrices_specified_ = true;
         stochastic_updates_enabled_ = true;
     }
+    SetNoiseSeed(static_cast<std::uint64_t>(parameters_.NoiseSeed));
 
     T_ = this->parameters_.T;
     tau_ = this->parameters_.tau;
@@ -240,6 +277,7 @@ void DynamicTimeIndexedShootingProblem::Instantiate(const DynamicTimeIndexedShoo
 
     // Initialize general costs
     cost.Initialize(this->parameters_.Cost, shared_from_this(), cost_Phi);
+    SetRolloutNumThreads(this->parameters_.RolloutNumThreads);
 
     ApplyStartState(false);
     InstantiateCostTerms(init);
@@ -256,6 +294,7 @@ void DynamicTimeIndexedShootingProblem::ReinitializeVariables()
     X_star_ = Eigen::MatrixXd::Zero(NX, T_);
     X_diff_ = Eigen::MatrixXd::Zero(NDX, T_);
     U_ = Eigen::MatrixXd::Zero(scene_->get_num_controls(), T_ - 1);
+    noise_ = Eigen::MatrixXd::Zero(2 * NX, T_ - 1);
 
     // Set w component of quaternion by default
     if (scene_->get_has_quaternion_floating_base())
@@ -359,16 +398,28 @@ void DynamicTimeIndexedShootingProblem::ReinitializeVariables()
 
     if (flags_ & KIN_J)
     {
-        dPhi_dx.assign(T_, Eigen::MatrixXd(length_jacobian, scene_->get_num_state_derivative()));
-        dPhi_du.assign(T_, Eigen::MatrixXd(length_jacobian, scene_->get_num_controls()));
+        dPhi_dx.assign(T_, Eigen::MatrixXd::Zero(length_jacobian, scene_->get_num_state_derivative()));
+        dPhi_du.assign(T_, Eigen::MatrixXd::Zero(length_jacobian, scene_->get_num_controls()));
     }
 
-    if (flags_ & KIN_H)
+    if (flags_ & KIN_H && parameters_.ContractTaskHessians)
+    {
+        // The task-map Hessians of one time step are contracted right after they have been computed, see UpdateTaskMaps
+        ddPhi_ddx_buffer_ = Hessian::Constant(length_jacobian, Eigen::MatrixXd::Zero(scene_->get_num_state_derivative(), scene_->get_num_state_derivative()));
+        ddPhi_ddu_buffer_ = Hessian::Constant(length_jacobian, Eigen::MatrixXd::Zero(scene_->get_num_controls(), scene_->get_num_controls()));
+        ddPhi_dxdu_buffer_ = Hessian::Constant(length_jacobian, Eigen::MatrixXd::Zero(scene_->get_num_state_derivative(), scene_->get_num_controls()));
+        task_cost_hessian_.assign(T_, Eigen::MatrixXd::Zero(NDX, NDX));
+        ddPhi_ddx.clear();
+        ddPhi_ddu.clear();
+        ddPhi_dxdu.clear();
+    }
+    else if (flags_ & KIN_H)
     {
         ddPhi_ddx.assign(T_, Hessian::Constant(length_jacobian, Eigen::MatrixXd::Zero(scene_->get_num_state_derivative(), scene_->get_num_state_derivative())));
         ddPhi_ddu.assign(T_, Hessian::Constant(length_jacobian, Eigen::MatrixXd::Zero(scene_->get_num_controls(), scene_->get_num_controls())));
         ddPhi_dxdu.assign(T_, Hessian::Constant(length_jacobian, Eigen::MatrixXd::Zero(scene_->get_num_state_derivative(), scene_->get_num_controls())));
     }
+    cost.store_hessians = !parameters_.ContractTaskHessians;
     cost.ReinitializeVariables(T_, shared_from_this(), cost_Phi);
 
     // Initialise variables for state and control cost
@@ -378,6 +429,7 @@ void DynamicTimeIndexedShootingProblem::ReinitializeVariables()
     state_cost_hessian_.assign(T_, Eigen::MatrixXd::Zero(NDX, NDX));
     general_cost_jacobian_.assign(T_, Eigen::VectorXd::Zero(NDX));
     general_cost_hessian_.assign(T_, Eigen::MatrixXd::Zero(NDX, NDX));
+    sparse_cost_hessian_patterns_.assign(T_, SparseCostHessianPattern());
     control_cost_jacobian_.assign(T_ - 1, Eigen::VectorXd::Zero(NU));
     control_cost_hessian_.assign(T_ - 1, Eigen::MatrixXd::Zero(NU, NU));
 
@@ -396,7 +448,56 @@ void DynamicTimeIndexedShootingProblem::set_T(const int& T_in)
         ThrowNamed("Invalid number of timesteps: " << T_in);
     }
     T_ = T_in;
+    resolution_reference_ = ResolutionReference();
+    ReinitializeVariables();
+}
+
+void DynamicTimeIndexedShootingProblem::SetResolution(int T_in)
+{
+    if (T_in <= 2) ThrowNamed("Invalid number of timesteps: " << T_in);
+    ResolutionReference& reference = resolution_reference_;
+    if (reference.T == 0)
+    {
+        if (T_in == T_) return;
+        reference.T = T_;
+        reference.tau = tau_;
+        reference.dt = scene_->GetDynamicsSolver()->get_dt();
+        reference.X_star = X_star_;
+        reference.Q = Q_;
+        reference.cost_y = cost.y;
+        reference.cost_rho = cost.rho;
+    }
+
+    const Eigen::MatrixXd X = X_;
+    const Eigen::MatrixXd U = U_;
+    const double tau_previous = tau_;
+
+    // tau stays a multiple of dt
+    const double scale = static_cast<double>(reference.T - 1) / (T_in - 1);
+    T_ = T_in;
+    tau_ = T_ == reference.T ? reference.tau : reference.tau * scale;
+    scene_->GetDynamicsSolver()->SetDt(T_ == reference.T ? reference.dt : reference.dt * scale);
     ReinitializeVariables();
+
+    for (int t = 0; t < T_; ++t)
+    {
+        const int s = GetNearestTimeStep(t, reference.T, T_);
+        X_star_.col(t) = reference.X_star.col(s);
+        Q_[t] = reference.Q[s];
+    }
+    cost.ResampleGoals(reference.cost_y, reference.cost_rho);
+
+    X_ = ResampleTrajectory(X, T_);
+    if (scene_->get_has_quaternion_floating_base())
+    {
+        for (int t = 0; t < T_; ++t) NormalizeQuaternionInConfigurationVector(X_.col(t));
+    }
+    for (int t = 0; t < T_ - 1; ++t)
+    {
+        U_.col(t) = U.col(std::min(static_cast<int>((t + 0.5) * tau_ / tau_previous), static_cast<int>(U.cols()) - 1));
+    }
+    if (T_ == reference.T) resolution_reference_ = ResolutionReference();
+    PreUpdate();
 }
 
 const double& DynamicTimeIndexedShootingProblem::get_tau() const
@@ -414,8 +515,10 @@ void DynamicTimeIndexedShootingProblem::PreUpdate()
     // based on the lastest KinematicResponse in order to reflect model state
     // updates etc.
     kinematic_solutions_.clear();
-    kinematic_solutions_.resize(T_);
-    for (int i = 0; i < T_; ++i) kinematic_solutions_[i] = std::make_shared<KinematicResponse>(*scene_->GetKinematicTree().GetKinematicResponse());
+    scene_->GetKinematicTree().GetKinematicResponses(T_, kinematic_solutions_);
+
+    // Noise of the first roll-out, of the whole solve with common random numbers
+    if (stochastic_matrices_specified_) SampleNoise(noise_stream_++, noise_);
 
     if (this->parameters_.WarmStartWithInverseDynamics)
     {
@@ -459,6 +562,11 @@ void DynamicTimeIndexedShootingProblem::set_X(Eigen::MatrixXdRefConst X_in)
     }
 }
 
+Eigen::Ref<Eigen::MatrixXd> DynamicTimeIndexedShootingProblem::get_X_view()
+{
+    return X_;
+}
+
 const Eigen::MatrixXd& DynamicTimeIndexedShootingProblem::get_U() const
 {
     return U_;
@@ -476,6 +584,11 @@ void DynamicTimeIndexedShootingProblem::set_U(Eigen::MatrixXdRefConst U_in)
     U_ = U_in;
 }
 
+Eigen::Ref<Eigen::MatrixXd> DynamicTimeIndexedShootingProblem::get_U_view()
+{
+    return U_;
+}
+
 const Eigen::MatrixXd& DynamicTimeIndexedShootingProblem::get_X_star() const
 {
     return X_star_;
@@ -583,20 +696,11 @@ void DynamicTimeIndexedShootingProblem::Update(Eigen::VectorXdRefConst x_in, Eig
     // Update xdiff
     scene_->GetDynamicsSolver()->StateDelta(X_.col(t + 1), X_star_.col(t + 1), X_diff_.col(t + 1));
 
-    // Stochastic noise, if enabled
+    // Stochastic noise, if enabled. The noise of a roll-out is generated for the whole horizon when it starts.
     if (stochastic_matrices_specified_ && stochastic_updates_enabled_)
     {
-        Eigen::VectorXd noise(scene_->get_num_positions() + scene_->get_num_velocities());
-        for (int i = 0; i < scene_->get_num_positions() + scene_->get_num_velocities(); ++i)
-            noise(i) = standard_normal_noise_(generator_);
-
-        Eigen::VectorXd control_dependent_noise = std::sqrt(scene_->GetDynamicsSolver()->get_dt()) * get_F(t) * noise;
-
-        for (int i = 0; i < scene_->get_num_positions() + scene_->get_num_velocities(); ++i)
-            noise(i) = standard_normal_noise_(generator_);
-        Eigen::VectorXd white_noise = std::sqrt(scene_->GetDynamicsSolver()->get_dt()) * CW_ * noise;
-
-        X_.col(t + 1) = X_.col(t + 1) + white_noise + control_dependent_noise;
+        if (t == 0 && !parameters_.CommonRandomNumbers) SampleNoise(noise_stream_++, noise_);
+        AddNoise(X_.col(t + 1), U_.col(t), noise_.col(t));
     }
 
     // Twice would not be necessary if "UpdateTerminalState" is used by the solver.
@@ -625,6 +729,58 @@ void DynamicTimeIndexedShootingProblem::Update(Eigen::VectorXdRefConst u, int t)
     return Update(X_.col(t), u, t);
 }
 
+void DynamicTimeIndexedShootingProblem::ShiftTrajectory(int k)
+{
+    if (k <= 0 || k >= T_ - 1) ThrowPretty("Invalid shift k=" << k << ", needs to be 0 < k < " << T_ - 1);
+
+    // Shift into the allocated storage, the kinematic responses are rotated
+    const int num_shifted = T_ - k;
+    for (int t = 0; t < num_shifted; ++t)
+    {
+        X_.col(t) = X_.col(t + k);
+        if (t < num_shifted - 1) U_.col(t) = U_.col(t + k);
+        scene_->GetDynamicsSolver()->StateDelta(X_.col(t), X_star_.col(t), X_diff_.col(t));
+    }
+    for (int t = num_shifted - 1; t < T_ - 1; ++t) U_.col(t) = U_.col(num_shifted - 2);
+    std::rotate(kinematic_solutions_.begin(), kinematic_solutions_.begin() + k, kinematic_solutions_.end());
+
+    if (num_tasks > 0)
+    {
+        for (int t = 0; t < num_shifted; ++t)
+        {
+            Phi[t] = Phi[t + k];
+            if (flags_ & KIN_J)
+            {
+                dPhi_dx[t] = dPhi_dx[t + k];
+                dPhi_du[t] = dPhi_du[t + k];
+            }
+            if (flags_ & KIN_H && parameters_.ContractTaskHessians)
+            {
+                task_cost_hessian_[t] = task_cost_hessian_[t + k];
+                cost.Update(Phi[t], dPhi_dx[t], dPhi_du[t], t);
+            }
+            else if (flags_ & KIN_H)
+            {
+                ddPhi_ddx[t] = ddPhi_ddx[t + k];
+                ddPhi_ddu[t] = ddPhi_ddu[t + k];
+                ddPhi_dxdu[t] = ddPhi_dxdu[t + k];
+                cost.Update(Phi[t], dPhi_dx[t], dPhi_du[t], ddPhi_ddx[t], ddPhi_ddu[t], ddPhi_dxdu[t], t);
+            }
+            else if (flags_ & KIN_J)
+            {
+                cost.Update(Phi[t], dPhi_dx[t], dPhi_du[t], t);
+            }
+            else
+            {
+                cost.Update(Phi[t], t);
+            }
+        }
+    }
+
+    // The last shifted state was evaluated as the terminal state, hence the tail is simulated from it
+    for (int t = num_shifted - 1; t < T_ - 1; ++t) Update(U_.col(t), t);
+}
+
 void DynamicTimeIndexedShootingProblem::UpdateTerminalState(Eigen::VectorXdRefConst x_in)
 {
     int t = T_ - 1;
@@ -666,42 +822,70 @@ void DynamicTimeIndexedShootingProblem::UpdateTaskMaps(Eigen::VectorXdRefConst x
     // NB: The KinematicTree only understands a certain format for the configuration (RPY)
     // => As a result, we need to use GetPosition to potentially convert.
     const Eigen::VectorXd q = scene_->GetDynamicsSolver()->GetPosition(x);
-    scene_->Update(q, static_cast<double>(t) * tau_);
-
-    // Reset the task space vector and its derivatives for the current timestep
-    Phi[t].SetZero(length_Phi);
-
-    if (flags_ & KIN_J)
+    DistanceCacheSlotGuard distance_cache_slot(*scene_, t);
+    if (flags_ & KIN_J_DOT)
     {
-        dPhi_dx[t].setZero();
-        dPhi_du[t].setZero();
+        scene_->Update(q, x.tail(q.size()), static_cast<double>(t) * tau_);
+    }
+    else
+    {
+        scene_->Update(q, static_cast<double>(t) * tau_);
     }
 
+    // With ContractTaskHessians, the Hessians of this time step go into the buffers instead
+    Hessian* ddPhi_ddx_t = nullptr;
+    Hessian* ddPhi_ddu_t = nullptr;
+    Hessian* ddPhi_dxdu_t = nullptr;
     if (flags_ & KIN_H)
     {
-        for (int i = 0; i < length_jacobian; ++i)
+        ddPhi_ddx_t = parameters_.ContractTaskHessians ? &ddPhi_ddx_buffer_ : &ddPhi_ddx[t];
+        ddPhi_ddu_t = parameters_.ContractTaskHessians ? &ddPhi_ddu_buffer_ : &ddPhi_ddu[t];
+        ddPhi_dxdu_t = parameters_.ContractTaskHessians ? &ddPhi_dxdu_buffer_ : &ddPhi_dxdu[t];
+        // The buffers are shared by all time steps, hence they must not keep the values of another one
+        if (parameters_.ContractTaskHessians)
         {
-            ddPhi_ddx[t](i).setZero();
-            ddPhi_ddu[t](i).setZero();
-            ddPhi_dxdu[t](i).setZero();
+            for (int i = 0; i < length_jacobian; ++i)
+            {
+                (*ddPhi_ddx_t)(i).setZero();
+                (*ddPhi_ddu_t)(i).setZero();
+                (*ddPhi_dxdu_t)(i).setZero();
+            }
         }
     }
 
-    // Update all task-maps
+    // Update all task-maps. The derivatives of the task maps not weighted at this time step keep their last values, their Phi is evaluated
+    // such that the task errors are current.
     for (int i = 0; i < num_tasks; ++i)
     {
-        // Only update TaskMap if rho is not 0
-        if (tasks_[i]->is_used)
+        if (cost.IsTaskMapActive(i, t))
         {
+            EXOTICA_PROFILE_SCOPE("TaskMap::Update");
+            // Reset the task space vector and its derivatives of the task map for the current timestep
+            Phi[t].data.segment(tasks_[i]->start, tasks_[i]->length).setZero();
+            if (flags_ & KIN_J)
+            {
+                dPhi_dx[t].middleRows(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian).setZero();
+                dPhi_du[t].middleRows(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian).setZero();
+            }
+            if (flags_ & KIN_H && !parameters_.ContractTaskHessians)
+            {
+                for (int j = tasks_[i]->start_jacobian; j < tasks_[i]->start_jacobian + tasks_[i]->length_jacobian; ++j)
+                {
+                    (*ddPhi_ddx_t)(j).setZero();
+                    (*ddPhi_ddu_t)(j).setZero();
+                    (*ddPhi_dxdu_t)(j).setZero();
+                }
+            }
+
             if (flags_ & KIN_H)
             {
                 tasks_[i]->Update(x, u,
                                   Phi[t].data.segment(tasks_[i]->start, tasks_[i]->length),
                                   dPhi_dx[t].middleRows(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian),
                                   dPhi_du[t].middleRows(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian),
-                                  ddPhi_ddx[t].segment(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian),
-                                  ddPhi_ddu[t].segment(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian),
-                                  ddPhi_dxdu[t].segment(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian));
+                                  ddPhi_ddx_t->segment(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian),
+                                  ddPhi_ddu_t->segment(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian),
+                                  ddPhi_dxdu_t->segment(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian));
             }
             else if (flags_ & KIN_J)
             {
@@ -715,10 +899,31 @@ void DynamicTimeIndexedShootingProblem::UpdateTaskMaps(Eigen::VectorXdRefConst x
                 tasks_[i]->Update(x, u, Phi[t].data.segment(tasks_[i]->start, tasks_[i]->length));
             }
         }
+        else if (tasks_[i]->is_used)
+        {
+            EXOTICA_PROFILE_SCOPE("TaskMap::Update");
+            Phi[t].data.segment(tasks_[i]->start, tasks_[i]->length).setZero();
+            tasks_[i]->Update(x, u, Phi[t].data.segment(tasks_[i]->start, tasks_[i]->length));
+        }
     }
 
     // Update costs (TimeIndexedTask)
-    if (flags_ & KIN_H)
+    if (flags_ & KIN_H && parameters_.ContractTaskHessians)
+    {
+        cost.Update(Phi[t], dPhi_dx[t], dPhi_du[t], t);
+
+        // Accumulate sum_i S_ii * ydiff_i * ddPhi_ddx_i of the general costs, the second-order term of the state cost Hessian
+        task_cost_hessian_[t].setZero();
+        for (const TaskIndexing& task : cost.indexing)
+        {
+            for (int i = 0; i < task.length_jacobian; ++i)
+            {
+                const int row = task.start_jacobian + i;
+                task_cost_hessian_[t].noalias() += (cost.S[t](row, row) * cost.ydiff[t](row)) * ddPhi_ddx_buffer_(cost.tasks[task.id]->start_jacobian + i);
+            }
+        }
+    }
+    else if (flags_ & KIN_H)
     {
         cost.Update(Phi[t], dPhi_dx[t], dPhi_du[t], ddPhi_ddx[t], ddPhi_ddu[t], ddPhi_dxdu[t], t);
     }
@@ -732,12 +937,214 @@ void DynamicTimeIndexedShootingProblem::UpdateTaskMaps(Eigen::VectorXdRefConst x
     }
 }
 
+void DynamicTimeIndexedShootingProblem::SetRolloutNumThreads(int num_threads)
+{
+    if (num_threads < 0) ThrowNamed("Invalid number of threads: " << num_threads);
+    rollout_num_threads_ = Server::ResolveNumThreads(num_threads);
+}
+
+void DynamicTimeIndexedShootingProblem::UpdateRolloutWorkspaces(int num_workspaces)
+{
+    if (rollout_workspaces_version_ != scene_->GetWorldVersion()) rollout_workspaces_.clear();
+    rollout_workspaces_version_ = scene_->GetWorldVersion();
+    // The rollouts only evaluate costs, hence the clones request the derivatives of the frames only where the task maps need them
+    KinematicRequestFlags workspace_flags = KIN_FK;
+    if (flags_ & KIN_J_DOT) workspace_flags |= KIN_J | KIN_J_DOT;
+    for (const TaskMapPtr& task : tasks_)
+    {
+        if (task->UsesKinematicJacobians()) workspace_flags |= KIN_J;
+    }
+    while (static_cast<int>(rollout_workspaces_.size()) < num_workspaces)
+    {
+        RolloutWorkspace workspace;
+        workspace.scene = scene_->CloneWorkspace();
+        if (!workspace.scene->GetDynamicsSolver()) ThrowPretty("DynamicsSolver of the scene clone is not initialised!");
+        workspace.maps = CloneTasks(workspace.scene, workspace_flags);
+        workspace.cost = cost;
+        rollout_workspaces_.push_back(workspace);
+    }
+
+    // Joints that are not controlled, the joint limits, the integration and the costs may have been changed since
+    const std::map<std::string, double> model_state = scene_->GetKinematicTree().GetModelStateMap();
+    const Eigen::MatrixXd& joint_limits = scene_->GetKinematicTree().GetJointLimits();
+    for (int i = 0; i < num_workspaces; ++i)
+    {
+        RolloutWorkspace& workspace = rollout_workspaces_[i];
+        workspace.scene->GetKinematicTree().SetModelState(model_state);
+        workspace.scene->GetKinematicTree().SetJointLimitsLower(joint_limits.col(0));
+        workspace.scene->GetKinematicTree().SetJointLimitsUpper(joint_limits.col(1));
+        workspace.scene->GetDynamicsSolver()->SetDt(scene_->GetDynamicsSolver()->get_dt());
+        workspace.scene->GetDynamicsSolver()->set_integrator(scene_->GetDynamicsSolver()->get_integrator());
+        for (std::size_t j = 0; j < tasks_.size(); ++j) workspace.maps[j]->is_used = tasks_[j]->is_used;
+        if (workspace.cost.y.size() != cost.y.size()) workspace.cost = cost;
+        workspace.cost.y = cost.y;
+        workspace.cost.S = cost.S;
+        workspace.Phi = Phi[0];
+    }
+}
+
+void DynamicTimeIndexedShootingProblem::UpdateRolloutTaskMaps(RolloutWorkspace& workspace, Eigen::VectorXdRefConst x, Eigen::VectorXdRefConst u, int t)
+{
+    // As UpdateTaskMaps, but only evaluates the task space vector
+    const Eigen::VectorXd q = workspace.scene->GetDynamicsSolver()->GetPosition(x);
+    if (flags_ & KIN_J_DOT)
+    {
+        workspace.scene->Update(q, x.tail(q.size()), static_cast<double>(t) * tau_);
+    }
+    else
+    {
+        workspace.scene->Update(q, static_cast<double>(t) * tau_);
+    }
+
+    workspace.Phi.SetZero(length_Phi);
+    for (int i = 0; i < num_tasks; ++i)
+    {
+        if (cost.IsTaskMapActive(i, t))
+        {
+            EXOTICA_PROFILE_SCOPE("TaskMap::Update");
+            workspace.maps[i]->Update(x, u, workspace.Phi.data.segment(workspace.maps[i]->start, workspace.maps[i]->length));
+        }
+    }
+    workspace.cost.Update(workspace.Phi, t);
+}
+
+void DynamicTimeIndexedShootingProblem::Rollout(Eigen::VectorXdRefConst x0, const std::vector<Eigen::MatrixXd>& U_rollouts, Eigen::VectorXd& costs, std::vector<Eigen::MatrixXd>& X_rollouts)
+{
+    const int NU = scene_->get_num_controls();
+    for (const Eigen::MatrixXd& U : U_rollouts)
+    {
+        if (U.rows() != NU || U.cols() != T_ - 1) ThrowPretty("Mismatching in size of control trajectory: " << U.rows() << "x" << U.cols() << " given, expected: " << NU << "x" << T_ - 1);
+    }
+    const RolloutPolicy open_loop = [&U_rollouts](int k, int t, DynamicsSolver& dynamics_solver, Eigen::VectorXdRefConst x, Eigen::VectorXdRef u) { u = U_rollouts[k].col(t); };
+    Rollout(x0, static_cast<int>(U_rollouts.size()), open_loop, costs, X_rollouts);
+}
+
+void DynamicTimeIndexedShootingProblem::Rollout(Eigen::VectorXdRefConst x0, int num_rollouts, const RolloutPolicy& policy, Eigen::VectorXd& costs, std::vector<Eigen::MatrixXd>& X_rollouts)
+{
+    const int NX = scene_->get_num_positions() + scene_->get_num_velocities();
+    const int NU = scene_->get_num_controls();
+    if (x0.rows() != NX) ThrowPretty("Mismatching in size of state vector: " << x0.rows() << " given, expected: " << NX);
+    if (num_rollouts < 0) ThrowPretty("Invalid number of rollouts: " << num_rollouts);
+    for (const TaskMapPtr& task : tasks_)
+    {
+        if (task->is_used && task->kinematics.size() > 1) ThrowPretty("Task map " << task->GetObjectName() << " uses the kinematics of previous time steps, which is not supported by Rollout");
+    }
+
+    costs = Eigen::VectorXd::Zero(num_rollouts);
+    X_rollouts.assign(num_rollouts, Eigen::MatrixXd::Zero(NX, T_));
+    if (num_rollouts == 0) return;
+
+    const int num_threads = std::min(rollout_num_threads_, num_rollouts);
+    UpdateRolloutWorkspaces(num_threads);
+    const double dt = scene_->GetDynamicsSolver()->get_dt();
+    const Eigen::VectorXd zero_control = Eigen::VectorXd::Zero(NU);
+    const bool stochastic = stochastic_matrices_specified_ && stochastic_updates_enabled_;
+
+    // Each thread simulates a contiguous block of rollouts with the dynamics solver and task maps of its own clone
+    ParallelLoop(num_threads, num_rollouts, [&](int thread, int k) {
+        RolloutWorkspace& workspace = rollout_workspaces_[thread];
+        const DynamicsSolverPtr dynamics_solver = workspace.scene->GetDynamicsSolver();
+        Eigen::VectorXd x_diff(scene_->get_num_state_derivative());
+        Eigen::VectorXd u(NU);
+        Eigen::MatrixXd noise = noise_;
+        Eigen::MatrixXd& X = X_rollouts[k];
+        X.col(0) = x0;
+        if (stochastic && !parameters_.CommonRandomNumbers) SampleNoise(noise_stream_ + k, noise);
+        for (int t = 0; t < T_ - 1; ++t)
+        {
+            policy(k, t, *dynamics_solver, X.col(t), u);
+            dynamics_solver->StateDelta(X.col(t), X_star_.col(t), x_diff);
+            if (num_tasks > 0) UpdateRolloutTaskMaps(workspace, X.col(t), u, t);
+            costs(k) += dt * (ComputeControlCost(u) + ComputeStateCost(x_diff, workspace.cost, t));
+
+            X.col(t + 1) = dynamics_solver->Simulate(X.col(t), u, tau_);
+            if (dynamics_solver->get_has_state_limits()) dynamics_solver->ClampToStateLimits(X.col(t + 1));
+            if (stochastic) AddNoise(X.col(t + 1), u, noise.col(t));
+        }
+
+        // Terminal cost
+        dynamics_solver->StateDelta(X.col(T_ - 1), X_star_.col(T_ - 1), x_diff);
+        if (num_tasks > 0) UpdateRolloutTaskMaps(workspace, X.col(T_ - 1), zero_control, T_ - 1);
+        costs(k) += ComputeStateCost(x_diff, workspace.cost, T_ - 1);
+    });
+    if (stochastic && !parameters_.CommonRandomNumbers) noise_stream_ += static_cast<std::uint64_t>(num_rollouts);
+}
+
+void DynamicTimeIndexedShootingProblem::RolloutMultipleShooting(const std::vector<int>& segment_begin, const std::vector<Eigen::VectorXd>& x_begin, const ShootingPolicy& policy, Eigen::MatrixXd& X, Eigen::MatrixXd& U, Eigen::MatrixXd& X_sim, double& cost)
+{
+    const int NX = scene_->get_num_positions() + scene_->get_num_velocities();
+    const int NU = scene_->get_num_controls();
+    const int num_segments = segment_begin.size();
+    if (num_segments == 0 || segment_begin[0] != 0) ThrowPretty("The first segment needs to begin at time step 0");
+    if (static_cast<int>(x_begin.size()) != num_segments) ThrowPretty("Mismatching number of segment start states: " << x_begin.size() << " given, expected: " << num_segments);
+    for (int j = 0; j < num_segments; ++j)
+    {
+        if (j > 0 && (segment_begin[j] <= segment_begin[j - 1] || segment_begin[j] >= T_ - 1)) ThrowPretty("Invalid segment begin " << segment_begin[j] << ", the segments need to begin at increasing time steps < " << T_ - 1);
+        if (x_begin[j].rows() != NX) ThrowPretty("Mismatching in size of state vector: " << x_begin[j].rows() << " given, expected: " << NX);
+    }
+    for (const TaskMapPtr& task : tasks_)
+    {
+        if (task->is_used && task->kinematics.size() > 1) ThrowPretty("Task map " << task->GetObjectName() << " uses the kinematics of previous time steps, which is not supported by RolloutMultipleShooting");
+    }
+
+    X.resize(NX, T_);
+    U.resize(NU, T_ - 1);
+    X_sim.resize(NX, T_);
+    X_sim.col(0) = x_begin[0];
+    Eigen::VectorXd segment_costs = Eigen::VectorXd::Zero(num_segments);
+
+    const int num_threads = std::min(rollout_num_threads_, num_segments);
+    UpdateRolloutWorkspaces(num_threads);
+    const double dt = scene_->GetDynamicsSolver()->get_dt();
+
+    // Each thread simulates whole segments with the dynamics solver and task maps of its own clone, a segment also simulates the state X_sim
+    // at the beginning of the next segment
+    ParallelLoop(
+        num_threads, num_segments, [&](int thread, int j) {
+            RolloutWorkspace& workspace = rollout_workspaces_[thread];
+            const DynamicsSolverPtr dynamics_solver = workspace.scene->GetDynamicsSolver();
+            Eigen::VectorXd x_diff(scene_->get_num_state_derivative());
+            Eigen::VectorXd u(NU);
+            const int end = (j + 1 < num_segments) ? segment_begin[j + 1] : T_ - 1;
+            Eigen::VectorXd x_sim = x_begin[j];
+            for (int t = segment_begin[j]; t < end; ++t)
+            {
+                policy(j, t, *dynamics_solver, x_sim, X.col(t), u);
+                U.col(t) = u;
+                dynamics_solver->StateDelta(X.col(t), X_star_.col(t), x_diff);
+                if (num_tasks > 0) UpdateRolloutTaskMaps(workspace, X.col(t), u, t);
+                segment_costs(j) += dt * (ComputeControlCost(u) + ComputeStateCost(x_diff, workspace.cost, t));
+
+                x_sim = dynamics_solver->Simulate(X.col(t), u, tau_);
+                if (dynamics_solver->get_has_state_limits()) dynamics_solver->ClampToStateLimits(x_sim);
+                X_sim.col(t + 1) = x_sim;
+            }
+
+            // Terminal cost
+            if (end == T_ - 1)
+            {
+                u.setZero();
+                policy(j, T_ - 1, *dynamics_solver, x_sim, X.col(T_ - 1), u);
+                dynamics_solver->StateDelta(X.col(T_ - 1), X_star_.col(T_ - 1), x_diff);
+                if (num_tasks > 0) UpdateRolloutTaskMaps(workspace, X.col(T_ - 1), u, T_ - 1);
+                segment_costs(j) += ComputeStateCost(x_diff, workspace.cost, T_ - 1);
+            }
+        },
+        ParallelSchedule::Dynamic);
+    cost = segment_costs.sum();
+}
+
 double DynamicTimeIndexedShootingProblem::GetStateCost(int t) const
 {
     ValidateTimeIndex(t);
-    const double state_cost = X_diff_.col(t).transpose() * Q_[t] * X_diff_.col(t);
-    const double general_cost = cost.ydiff[t].transpose() * cost.S[t] * cost.ydiff[t];
-    return state_cost + general_cost;  // TODO: ct scaling
+    return ComputeStateCost(X_diff_.col(t), cost, t);
+}
+
+double DynamicTimeIndexedShootingProblem::ComputeStateCost(Eigen::VectorXdRefConst x_diff, const TimeIndexedTask& general_cost, int t) const
+{
+    const double state_cost = x_diff.transpose() * Q_[t] * x_diff;
+    const double task_cost = general_cost.ydiff[t].dot(general_cost.S[t].diagonal().cwiseProduct(general_cost.ydiff[t]));
+    return state_cost + task_cost;
 }
 
 Eigen::VectorXd DynamicTimeIndexedShootingProblem::GetStateCostJacobian(int t)
@@ -750,11 +1157,90 @@ Eigen::VectorXd DynamicTimeIndexedShootingProblem::GetStateCostJacobian(int t)
 
     // m => dimension of task maps, "length_jacobian"
     // (m,NQ)^T * (m,m) * (m,1) * (1,1) => (NQ,1), TODO: We should change this to RowVectorXd format
-    general_cost_jacobian_[t].noalias() = cost.dPhi_dx[t].transpose() * cost.S[t] * cost.ydiff[t] * 2.0;
+    general_cost_jacobian_[t].noalias() = cost.dPhi_dx[t].transpose() * cost.S[t].diagonal().cwiseProduct(cost.ydiff[t]) * 2.0;
 
     return state_cost_jacobian_[t] + general_cost_jacobian_[t];
 }
 
+void DynamicTimeIndexedShootingProblem::SparseGaussNewtonHessian(const Eigen::MatrixXd& J, const Eigen::MatrixXd& S, SparseCostHessianPattern& pattern, Eigen::MatrixXd& H)
+{
+    // Only rows with a non-zero weight and columns with a non-zero entry in these rows contribute to J^T S J.
+    // A cached pattern remains valid while its columns cover all non-zero entries of the weighted rows.
+    bool valid = pattern.valid && pattern.J_active.rows() == J.rows() && pattern.J_active.cols() == J.cols();
+    for (int i = 0, a = 0; valid && i < J.rows(); ++i)
+    {
+        const bool weighted = S(i, i) != 0.;
+        valid = weighted == (a < static_cast<int>(pattern.rows.size()) && pattern.rows[a] == i);
+        if (weighted) ++a;
+    }
+    for (int j = 0, b = 0; valid && j < J.cols(); ++j)
+    {
+        if (b < static_cast<int>(pattern.cols.size()) && pattern.cols[b] == j)
+        {
+            ++b;
+            continue;
+        }
+        for (const int i : pattern.rows)
+        {
+            if (J(i, j) != 0.)
+            {
+                valid = false;
+                break;
+            }
+        }
+    }
+
+    if (!valid)
+    {
+        pattern.rows.clear();
+        pattern.cols.clear();
+        pattern.rows.reserve(J.rows());
+        pattern.cols.reserve(J.cols());
+        for (int i = 0; i < J.rows(); ++i)
+        {
+            if (S(i, i) != 0.) pattern.rows.push_back(i);
+        }
+        for (int j = 0; j < J.cols(); ++j)
+        {
+            for (const int i : pattern.rows)
+            {
+                if (J(i, j) != 0.)
+                {
+                    pattern.cols.push_back(j);
+                    break;
+                }
+            }
+        }
+        pattern.J_active.resize(J.rows(), J.cols());
+        pattern.SJ_active.resize(J.rows(), J.cols());
+        pattern.H_active.resize(J.cols(), J.cols());
+        pattern.valid = true;
+    }
+
+    const int num_rows = static_cast<int>(pattern.rows.size()), num_cols = static_cast<int>(pattern.cols.size());
+    auto J_active = pattern.J_active.topLeftCorner(num_rows, num_cols);
+    auto SJ_active = pattern.SJ_active.topLeftCorner(num_rows, num_cols);
+    auto H_active = pattern.H_active.topLeftCorner(num_cols, num_cols);
+    for (int b = 0; b < num_cols; ++b)
+    {
+        for (int a = 0; a < num_rows; ++a)
+        {
+            J_active(a, b) = J(pattern.rows[a], pattern.cols[b]);
+            SJ_active(a, b) = S(pattern.rows[a], pattern.rows[a]) * J_active(a, b);
+        }
+    }
+    H_active.noalias() = J_active.transpose() * SJ_active;
+
+    H.setZero(J.cols(), J.cols());
+    for (int b = 0; b < num_cols; ++b)
+    {
+        for (int a = 0; a < num_cols; ++a)
+        {
+            H(pattern.cols[a], pattern.cols[b]) = H_active(a, b);
+        }
+    }
+}
+
 Eigen::MatrixXd DynamicTimeIndexedShootingProblem::GetStateCostHessian(int t)
 {
     ValidateTimeIndex(t);
@@ -775,12 +1261,24 @@ Eigen::MatrixXd DynamicTimeIndexedShootingProblem::GetStateCostHessian(int t)
     }
 
     // General Cost
-    general_cost_hessian_[t].noalias() = cost.dPhi_dx[t].transpose() * cost.S[t] * cost.dPhi_dx[t];
+    if (parameters_.SparseCostHessian)
+    {
+        SparseGaussNewtonHessian(cost.dPhi_dx[t], cost.S[t], sparse_cost_hessian_patterns_[t], general_cost_hessian_[t]);
+    }
+    else
+    {
+        general_cost_hessian_[t].noalias() = cost.dPhi_dx[t].transpose() * cost.S[t].diagonal().asDiagonal() * cost.dPhi_dx[t];
+    }
 
     // Contract task-map Hessians
-    if (flags_ & KIN_H)
+    if (flags_ & KIN_H && parameters_.ContractTaskHessians)
     {
-        Eigen::RowVectorXd ydiffTS = cost.ydiff[t].transpose() * cost.S[t];  // (1*m)
+        // Contracted in UpdateTaskMaps
+        general_cost_hessian_[t].noalias() += task_cost_hessian_[t];
+    }
+    else if (flags_ & KIN_H)
+    {
+        Eigen::RowVectorXd ydiffTS = cost.S[t].diagonal().cwiseProduct(cost.ydiff[t]).transpose();  // (1*m)
         for (int i = 0; i < cost.length_jacobian; ++i)                       // length m
         {
             general_cost_hessian_[t].noalias() += ydiffTS(i) * cost.ddPhi_ddx[t](i);
@@ -790,6 +1288,58 @@ Eigen::MatrixXd DynamicTimeIndexedShootingProblem::GetStateCostHessian(int t)
     return 2.0 * state_cost_hessian_[t] + 2.0 * general_cost_hessian_[t];
 }
 
+Eigen::VectorXd DynamicTimeIndexedShootingProblem::GetStateCostHessianVectorProduct(int t, Eigen::VectorXdRefConst v)
+{
+    ValidateTimeIndex(t);
+    if (v.size() != scene_->get_num_state_derivative()) ThrowPretty("Wrong size of v: " << v.size() << " expecting " << scene_->get_num_state_derivative());
+
+    // Same terms as GetStateCostHessian, applied to v
+    dxdiff_[t] = scene_->GetDynamicsSolver()->dStateDelta(X_.col(t), X_star_.col(t), ArgumentPosition::ARG0);
+    Eigen::VectorXd hv = dxdiff_[t].transpose() * (Q_[t] * (dxdiff_[t] * v));
+    if (scene_->get_has_quaternion_floating_base())
+    {
+        Eigen::RowVectorXd xdiffTQ = X_diff_.col(t).transpose() * Q_[t];
+        Hessian ddxdiff = scene_->GetDynamicsSolver()->ddStateDelta(X_.col(t), X_star_.col(t), ArgumentPosition::ARG0);
+        for (int i = 0; i < ddxdiff.size(); ++i)
+        {
+            if (xdiffTQ(i) != 0.0) hv.noalias() += xdiffTQ(i) * (ddxdiff(i) * v);
+        }
+    }
+
+    const Eigen::VectorXd s = cost.S[t].diagonal();
+    const Eigen::VectorXd SJv = s.cwiseProduct(cost.dPhi_dx[t] * v);
+    hv.noalias() += cost.dPhi_dx[t].transpose() * SJv;
+    if (flags_ & KIN_H && parameters_.ContractTaskHessians)
+    {
+        hv.noalias() += task_cost_hessian_[t] * v;
+    }
+    else if (flags_ & KIN_H)
+    {
+        for (int i = 0; i < cost.length_jacobian; ++i)
+        {
+            const double s_ydiff = s(i) * cost.ydiff[t](i);
+            if (s_ydiff != 0.0) hv.noalias() += s_ydiff * (cost.ddPhi_ddx[t](i) * v);
+        }
+    }
+    return 2.0 * hv;
+}
+
+Eigen::VectorXd DynamicTimeIndexedShootingProblem::GetControlCostHessianVectorProduct(int t, Eigen::VectorXdRefConst v)
+{
+    if (t >= T_ - 1 || t < -1)
+    {
+        ThrowPretty("Requested t=" << t << " out of range, needs to be 0 =< t < " << T_ - 1);
+    }
+    else if (t == -1)
+    {
+        t = T_ - 2;
+    }
+    if (v.size() != scene_->get_num_controls()) ThrowPretty("Wrong size of v: " << v.size() << " expecting " << scene_->get_num_controls());
+
+    control_loss_(U_.col(t), *control_loss_rate_, nullptr, &control_loss_hessian_);
+    return control_cost_weight_ * (R_ * v + R_.transpose() * v + control_loss_hessian_.cwiseProduct(v));
+}
+
 Eigen::MatrixXd DynamicTimeIndexedShootingProblem::GetControlCostHessian(int t)
 {
     if (t >= T_ - 1 || t < -1)
@@ -807,19 +1357,8 @@ Eigen::MatrixXd DynamicTimeIndexedShootingProblem::GetControlCostHessian(int t)
     control_cost_hessian_[t] = R_ + R_.transpose();
 
     // Sparsity-related control Hessian
-    for (int iu = 0; iu < scene_->get_num_controls(); ++iu)
-    {
-        if (loss_type_ == ControlCostLossTermType::SmoothL1)
-            control_cost_hessian_[t](iu, iu) += smooth_l1_hessian(U_.col(t)[iu], l1_rate_(iu));
-
-        // if huber_rate is 0, huber is undefined
-        //  this is a shortcut for disabling the loss
-        else if (loss_type_ == ControlCostLossTermType::Huber && huber_rate_(iu) != 0)
-            control_cost_hessian_[t](iu, iu) += huber_hessian(U_.col(t)[iu], huber_rate_(iu));
-
-        else if (loss_type_ == ControlCostLossTermType::PseudoHuber && huber_rate_(iu) != 0)
-            control_cost_hessian_[t](iu, iu) += pseudo_huber_hessian(U_.col(t)[iu], huber_rate_(iu));
-    }
+    control_loss_(U_.col(t), *control_loss_rate_, nullptr, &control_loss_hessian_);
+    control_cost_hessian_[t].diagonal() += control_loss_hessian_;
     return control_cost_weight_ * control_cost_hessian_[t];
 }
 
@@ -833,30 +1372,20 @@ double DynamicTimeIndexedShootingProblem::GetControlCost(int t) const
     {
         t = T_ - 2;
     }
+    return ComputeControlCost(U_.col(t));
+}
 
+double DynamicTimeIndexedShootingProblem::ComputeControlCost(Eigen::VectorXdRefConst u) const
+{
     double cost = 0;
 
     // This allows composition of multiple functions
     //  useful when you want to apply different cost functions to different controls
     // if (parameters_.LossType == "L2")
-    cost += U_.col(t).cwiseAbs2().cwiseProduct(R_.diagonal()).sum();
+    cost += u.cwiseAbs2().cwiseProduct(R_.diagonal()).sum();
 
     // Sparsity-related control cost
-    for (int iu = 0; iu < scene_->get_num_controls(); ++iu)
-    {
-        // if (U_.col(t)[iu] >= control_limits.col(1)[iu])
-        //     continue;
-        if (loss_type_ == ControlCostLossTermType::SmoothL1)
-            cost += smooth_l1_cost(U_.col(t)[iu], l1_rate_(iu));
-
-        // if huber_rate is 0, huber is undefined
-        //  this is a shortcut for disabling the loss
-        else if (loss_type_ == ControlCostLossTermType::Huber && huber_rate_(iu) != 0)
-            cost += huber_cost(U_.col(t)[iu], huber_rate_(iu));
-
-        else if (loss_type_ == ControlCostLossTermType::PseudoHuber && huber_rate_(iu) != 0)
-            cost += pseudo_huber_cost(U_.col(t)[iu], huber_rate_(iu));
-    }
+    cost += control_loss_(u, *control_loss_rate_, nullptr, nullptr);
     if (!std::isfinite(cost))
     {
         cost = 0.0;  // Likely "inf" as u is too small.
@@ -882,22 +1411,64 @@ Eigen::VectorXd DynamicTimeIndexedShootingProblem::GetControlCostJacobian(int t)
     control_cost_jacobian_[t].noalias() = R_ * U_.col(t) + R_.transpose() * U_.col(t);
 
     // Sparsity-related control cost Jacobian
-    for (int iu = 0; iu < scene_->get_num_controls(); ++iu)
+    control_loss_(U_.col(t), *control_loss_rate_, &control_loss_gradient_, nullptr);
+    control_cost_jacobian_[t] += control_loss_gradient_;
+    return control_cost_weight_ * control_cost_jacobian_[t];
+}
+
+void DynamicTimeIndexedShootingProblem::GetControlCostDerivatives(int t, Eigen::VectorXd& jacobian, Eigen::MatrixXd& hessian)
+{
+    if (t >= T_ - 1 || t < -1)
     {
-        // if (U_.col(t)[iu] >= control_limits.col(1)[iu])
-        //     continue;
-        if (loss_type_ == ControlCostLossTermType::SmoothL1)
-            control_cost_jacobian_[t](iu) += smooth_l1_jacobian(U_.col(t)[iu], l1_rate_(iu));
+        ThrowPretty("Requested t=" << t << " out of range, needs to be 0 =< t < " << T_ - 1);
+    }
+    else if (t == -1)
+    {
+        t = T_ - 2;
+    }
 
-        // if huber_rate is 0, huber is undefined
-        //  this is a shortcut for disabling the loss
-        else if (loss_type_ == ControlCostLossTermType::Huber && huber_rate_(iu) != 0)
-            control_cost_jacobian_[t](iu) += huber_jacobian(U_.col(t)[iu], huber_rate_(iu));
+    control_cost_jacobian_[t].noalias() = R_ * U_.col(t) + R_.transpose() * U_.col(t);
+    control_cost_hessian_[t] = R_ + R_.transpose();
+
+    control_loss_(U_.col(t), *control_loss_rate_, &control_loss_gradient_, &control_loss_hessian_);
+    control_cost_jacobian_[t] += control_loss_gradient_;
+    control_cost_hessian_[t].diagonal() += control_loss_hessian_;
+
+    jacobian.noalias() = control_cost_weight_ * control_cost_jacobian_[t];
+    hessian.noalias() = control_cost_weight_ * control_cost_hessian_[t];
+}
 
-        else if (loss_type_ == ControlCostLossTermType::PseudoHuber && huber_rate_(iu) != 0)
-            control_cost_jacobian_[t](iu) += pseudo_huber_jacobian(U_.col(t)[iu], huber_rate_(iu));
+void DynamicTimeIndexedShootingProblem::LinearizeTrajectory(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, TrajectoryLinearization& linearization)
+{
+    LinearizeDynamics(X, U, linearization);
+    QuadratizeCost(linearization);
+}
+
+void DynamicTimeIndexedShootingProblem::LinearizeDynamics(Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U, TrajectoryLinearization& linearization)
+{
+    if (X.cols() != T_ || U.cols() != T_ - 1) ThrowPretty("Mismatching trajectory length: " << X.cols() << " states and " << U.cols() << " controls given, expected: " << T_ << " and " << T_ - 1);
+    scene_->GetDynamicsSolver()->ComputeDerivativesBatch(X, U, linearization.fx, linearization.fu);
+}
+
+void DynamicTimeIndexedShootingProblem::QuadratizeCost(TrajectoryLinearization& linearization)
+{
+    linearization.lx.resize(T_);
+    linearization.lxx.resize(T_);
+    linearization.lu.resize(T_ - 1);
+    linearization.luu.resize(T_ - 1);
+
+    // The state cost derivatives of a time step only use the buffers of that time step
+    const int num_threads = std::min(scene_->GetDynamicsSolver()->GetDerivativesNumThreads(), T_);
+    ParallelLoop(num_threads, T_, [&](int, int t) {
+        linearization.lx[t] = GetStateCostJacobian(t);
+        linearization.lxx[t] = GetStateCostHessian(t);
+    });
+
+    // The control cost derivatives share the buffers of the sparsity loss
+    for (int t = 0; t < T_ - 1; ++t)
+    {
+        GetControlCostDerivatives(t, linearization.lu[t], linearization.luu[t]);
     }
-    return control_cost_weight_ * control_cost_jacobian_[t];
 }
 
 Eigen::MatrixXd DynamicTimeIndexedShootingProblem::get_F(int t) const
@@ -934,4 +1505,46 @@ void DynamicTimeIndexedShootingProblem::DisableStochasticUpdates()
     stochastic_updates_enabled_ = false;
 }
 
+void DynamicTimeIndexedShootingProblem::SetNoiseSeed(std::uint64_t seed)
+{
+    noise_seed_ = seed;
+    noise_stream_ = 0;
+}
+
+void DynamicTimeIndexedShootingProblem::SampleNoise(std::uint64_t stream, Eigen::MatrixXdRef noise) const
+{
+    const int NX = scene_->get_num_positions() + scene_->get_num_velocities();
+    if (noise.rows() != 2 * NX || noise.cols() != T_ - 1) ThrowPretty("Wrong size of noise matrix! Got " << noise.rows() << "x" << noise.cols() << ", expected " << 2 * NX << "x" << T_ - 1);
+
+    // Box-Muller transform of pairs of uniform samples of a counter-based generator (see KinematicTree::GetRandomControlledStates),
+    // the transform is evaluated for all samples at once
+    const std::uint64_t key = SplitMix64(noise_seed_ ^ SplitMix64(stream));
+    const Eigen::Index num_pairs = (noise.size() + 1) / 2;
+    Eigen::ArrayXd radius(num_pairs), angle(num_pairs);
+    for (Eigen::Index i = 0; i < num_pairs; ++i)
+    {
+        // 53 random bits mapped to (0, 1] and [0, 1)
+        radius(i) = static_cast<double>((SplitMix64(key + 2 * static_cast<std::uint64_t>(i)) >> 11) + 1) / 9007199254740992.0;
+        angle(i) = static_cast<double>(SplitMix64(key + 2 * static_cast<std::uint64_t>(i) + 1) >> 11) / 9007199254740992.0;
+    }
+    radius = (-2.0 * radius.log()).sqrt();
+    angle *= 2.0 * M_PI;
+    Eigen::ArrayXd samples(2 * num_pairs);
+    samples.head(num_pairs) = radius * angle.cos();
+    samples.tail(num_pairs) = radius * angle.sin();
+    for (int t = 0; t < T_ - 1; ++t) noise.col(t) = samples.segment(t * 2 * NX, 2 * NX).matrix();
+}
+
+void DynamicTimeIndexedShootingProblem::AddNoise(Eigen::VectorXdRef x, Eigen::VectorXdRefConst u, Eigen::VectorXdRefConst noise) const
+{
+    // x += sqrt(dt) * (F(u) * noise_control + CW * noise_white) with the columns F(u).col(i) = Ci * u (see get_F)
+    const int NX = static_cast<int>(x.rows());
+    Eigen::VectorXd dx = CW_ * noise.tail(NX);
+    for (int i = 0; i < NX; ++i)
+    {
+        if (noise(i) != 0.0) dx.noalias() += noise(i) * (Ci_[i] * u);
+    }
+    x += std::sqrt(scene_->GetDynamicsSolver()->get_dt()) * dx;
+}
+
 }  // namespace exotica
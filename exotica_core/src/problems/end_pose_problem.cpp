@@ -112,14 +112,44 @@ void EndPoseProblem::PreUpdate()
     equality.UpdateS();
 }
 
+void EndPoseProblem::UpdateClone(PlanningProblem& clone) const
+{
+    UpdateCloneBase(clone);
+    EndPoseProblem& clone_problem = static_cast<EndPoseProblem&>(clone);
+    clone_problem.cost.y = cost.y;
+    clone_problem.cost.rho = cost.rho;
+    clone_problem.inequality.y = inequality.y;
+    clone_problem.inequality.rho = inequality.rho;
+    clone_problem.equality.y = equality.y;
+    clone_problem.equality.rho = equality.rho;
+    clone_problem.W = W;
+    clone_problem.use_bounds = use_bounds;
+    clone_problem.PreUpdate();
+}
+
+double EndPoseProblem::UpdateEndPoseCost(Eigen::VectorXdRefConst x)
+{
+    Update(x);
+    return GetScalarCost();
+}
+
 double EndPoseProblem::GetScalarCost()
 {
-    return cost.ydiff.transpose() * cost.S * cost.ydiff;
+    return cost.ydiff.dot(cost.S.diagonal().cwiseProduct(cost.ydiff));
 }
 
 Eigen::RowVectorXd EndPoseProblem::GetScalarJacobian()
 {
-    return cost.jacobian.transpose() * cost.S * cost.ydiff * 2.0;
+    Eigen::RowVectorXd jacobian(N);
+    GetScalarJacobian(jacobian);
+    return jacobian;
+}
+
+void EndPoseProblem::GetScalarJacobian(Eigen::Ref<Eigen::RowVectorXd> jacobian)
+{
+    if (jacobian.cols() != N) ThrowPretty("Wrong size of the Jacobian: " << jacobian.cols() << " expecting " << N);
+    jacobian.setZero();
+    for (int i = 0; i < cost.length_jacobian; ++i) jacobian.noalias() += (2.0 * cost.S(i, i) * cost.ydiff(i)) * cost.jacobian.row(i);
 }
 
 double EndPoseProblem::GetScalarTaskCost(const std::string& task_name) const
@@ -136,26 +166,27 @@ double EndPoseProblem::GetScalarTaskCost(const std::string& task_name) const
 
 Eigen::VectorXd EndPoseProblem::GetEquality()
 {
-    return equality.S * equality.ydiff;
+    return equality.S.diagonal().cwiseProduct(equality.ydiff);
 }
 
 Eigen::MatrixXd EndPoseProblem::GetEqualityJacobian()
 {
-    return equality.S * equality.jacobian;
+    return equality.S.diagonal().asDiagonal() * equality.jacobian;
 }
 
 Eigen::VectorXd EndPoseProblem::GetInequality()
 {
-    return inequality.S * inequality.ydiff;
+    return inequality.S.diagonal().cwiseProduct(inequality.ydiff);
 }
 
 Eigen::MatrixXd EndPoseProblem::GetInequalityJacobian()
 {
-    return inequality.S * inequality.jacobian;
+    return inequality.S.diagonal().asDiagonal() * inequality.jacobian;
 }
 
 void EndPoseProblem::Update(Eigen::VectorXdRefConst x)
 {
+    if (recorder_) recorder_->RecordUpdate(ProblemEventType::Update, x);
     scene_->Update(x, t_start);
     Phi.SetZero(length_Phi);
     if (flags_ & KIN_J) jacobian.setZero();
@@ -165,6 +196,7 @@ void EndPoseProblem::Update(Eigen::VectorXdRefConst x)
     {
         if (tasks_[i]->is_used)
         {
+            EXOTICA_PROFILE_SCOPE("TaskMap::Update");
             if (flags_ & KIN_H)
             {
                 tasks_[i]->Update(x,
@@ -208,6 +240,7 @@ void EndPoseProblem::Update(Eigen::VectorXdRefConst x)
 
 void EndPoseProblem::SetGoal(const std::string& task_name, Eigen::VectorXdRefConst goal)
 {
+    if (recorder_) recorder_->RecordGoal(ProblemEventType::SetGoal, task_name, goal);
     for (int i = 0; i < cost.indexing.size(); ++i)
     {
         if (cost.tasks[i]->GetObjectName() == task_name)
@@ -222,6 +255,7 @@ void EndPoseProblem::SetGoal(const std::string& task_name, Eigen::VectorXdRefCon
 
 void EndPoseProblem::SetRho(const std::string& task_name, const double& rho)
 {
+    if (recorder_) recorder_->RecordRho(ProblemEventType::SetRho, task_name, rho);
     for (int i = 0; i < cost.indexing.size(); ++i)
     {
         if (cost.tasks[i]->GetObjectName() == task_name)
@@ -260,6 +294,7 @@ double EndPoseProblem::GetRho(const std::string& task_name)
 
 void EndPoseProblem::SetGoalEQ(const std::string& task_name, Eigen::VectorXdRefConst goal)
 {
+    if (recorder_) recorder_->RecordGoal(ProblemEventType::SetGoalEQ, task_name, goal);
     for (int i = 0; i < equality.indexing.size(); ++i)
     {
         if (equality.tasks[i]->GetObjectName() == task_name)
@@ -274,6 +309,7 @@ void EndPoseProblem::SetGoalEQ(const std::string& task_name, Eigen::VectorXdRefC
 
 void EndPoseProblem::SetRhoEQ(const std::string& task_name, const double& rho)
 {
+    if (recorder_) recorder_->RecordRho(ProblemEventType::SetRhoEQ, task_name, rho);
     for (int i = 0; i < equality.indexing.size(); ++i)
     {
         if (equality.tasks[i]->GetObjectName() == task_name)
@@ -312,6 +348,7 @@ double EndPoseProblem::GetRhoEQ(const std::string& task_name)
 
 void EndPoseProblem::SetGoalNEQ(const std::string& task_name, Eigen::VectorXdRefConst goal)
 {
+    if (recorder_) recorder_->RecordGoal(ProblemEventType::SetGoalNEQ, task_name, goal);
     for (int i = 0; i < inequality.indexing.size(); ++i)
     {
         if (inequality.tasks[i]->GetObjectName() == task_name)
@@ -326,6 +363,7 @@ void EndPoseProblem::SetGoalNEQ(const std::string& task_name, Eigen::VectorXdRef
 
 void EndPoseProblem::SetRhoNEQ(const std::string& task_name, const double& rho)
 {
+    if (recorder_) recorder_->RecordRho(ProblemEventType::SetRhoNEQ, task_name, rho);
     for (int i = 0; i < inequality.indexing.size(); ++i)
     {
         if (inequality.tasks[i]->GetObjectName() == task_name)
@@ -27,8 +27,14 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include <exotica_core/problems/sampling_problem.h>
+#include <exotica_core/server.h>
 #include <exotica_core/setup.h>
+#include <exotica_core/tools/parallel_loop.h>
 
 REGISTER_PROBLEM_TYPE("SamplingProblem", exotica::SamplingProblem)
 
@@ -110,6 +116,7 @@ void SamplingProblem::Instantiate(const SamplingProblemInitializer& init)
         }
     }
 
+    SetValidityNumThreads(init.ValidityNumThreads);
     PreUpdate();
 }
 
@@ -119,6 +126,16 @@ void SamplingProblem::PreUpdate()
     for (int i = 0; i < tasks_.size(); ++i) tasks_[i]->is_used = false;
     inequality.UpdateS();
     equality.UpdateS();
+    for (ValidityWorkspace& workspace : validity_workspaces_)
+    {
+        for (const TaskMapPtr& map : workspace.maps) map->PreUpdate();
+    }
+}
+
+void SamplingProblem::SetValidityNumThreads(int num_threads)
+{
+    if (num_threads < 0) ThrowNamed("Invalid number of threads: " << num_threads);
+    validity_num_threads_ = Server::ResolveNumThreads(num_threads);
 }
 
 void SamplingProblem::SetGoalState(Eigen::VectorXdRefConst qT)
@@ -238,7 +255,10 @@ void SamplingProblem::Update(Eigen::VectorXdRefConst x)
     for (int i = 0; i < num_tasks; ++i)
     {
         if (tasks_[i]->is_used)
+        {
+            EXOTICA_PROFILE_SCOPE("TaskMap::Update");
             tasks_[i]->Update(x, Phi.data.segment(tasks_[i]->start, tasks_[i]->length));
+        }
     }
     inequality.Update(Phi);
     equality.Update(Phi);
@@ -246,10 +266,14 @@ void SamplingProblem::Update(Eigen::VectorXdRefConst x)
 }
 
 bool SamplingProblem::IsValid()
+{
+    return IsValid(scene_->GetKinematicTree().GetControlledState(), inequality, equality);
+}
+
+bool SamplingProblem::IsValid(Eigen::VectorXdRefConst x, const SamplingTask& inequality, const SamplingTask& equality) const
 {
     // Check bounds
-    const Eigen::VectorXd x = scene_->GetKinematicTree().GetControlledState();
-    const Eigen::MatrixXd bounds = scene_->GetKinematicTree().GetJointLimits();
+    const Eigen::MatrixXd& bounds = scene_->GetKinematicTree().GetJointLimits();
     for (int i = 0; i < N; ++i)
     {
         if (x(i) < bounds(i, 0) || x(i) > bounds(i, 1))
@@ -260,19 +284,19 @@ bool SamplingProblem::IsValid()
     }
 
     // Check constraints
-    const bool inequality_is_valid = ((inequality.S * inequality.ydiff).array() <= 0.0).all();
-    const bool equality_is_valid = ((equality.S * equality.ydiff).array().abs() == 0.0).all();
+    const bool inequality_is_valid = (inequality.S.diagonal().cwiseProduct(inequality.ydiff).array() <= 0.0).all();
+    const bool equality_is_valid = (equality.S.diagonal().cwiseProduct(equality.ydiff).array().abs() == 0.0).all();
 
     if (debug_)
     {
         HIGHLIGHT_NAMED("SamplingProblem::IsValid", "NEQ = " << std::boolalpha << inequality_is_valid << ", EQ = " << equality_is_valid);
         if (!equality_is_valid)
         {
-            HIGHLIGHT_NAMED("SamplingProblem::IsValid", "Equality: ydiff = " << equality.ydiff.transpose() << ", S * ydiff = " << (equality.S * equality.ydiff).transpose());
+            HIGHLIGHT_NAMED("SamplingProblem::IsValid", "Equality: ydiff = " << equality.ydiff.transpose() << ", S * ydiff = " << equality.S.diagonal().cwiseProduct(equality.ydiff).transpose());
         }
         if (!inequality_is_valid)
         {
-            HIGHLIGHT_NAMED("SamplingProblem::IsValid", "Inequality: ydiff = " << inequality.ydiff.transpose() << ", S * ydiff = " << (inequality.S * inequality.ydiff).transpose());
+            HIGHLIGHT_NAMED("SamplingProblem::IsValid", "Inequality: ydiff = " << inequality.ydiff.transpose() << ", S * ydiff = " << inequality.S.diagonal().cwiseProduct(inequality.ydiff).transpose());
         }
     }
 
@@ -285,6 +309,105 @@ bool SamplingProblem::IsStateValid(Eigen::VectorXdRefConst x)
     return IsValid();
 }
 
+void SamplingProblem::PrepareValidityWorkspaces(int num_workspaces)
+{
+    if (num_workspaces < 0) ThrowNamed("The number of workspaces has to be non-negative, given: " << num_workspaces);
+    UpdateValidityWorkspaces(num_workspaces);
+}
+
+bool SamplingProblem::IsStateValid(Eigen::VectorXdRefConst x, int workspace)
+{
+    if (workspace < 0 || workspace >= static_cast<int>(validity_workspaces_.size())) ThrowNamed("Invalid workspace " << workspace << ", " << validity_workspaces_.size() << " workspaces have been prepared.");
+    return IsStateValid(x, validity_workspaces_[workspace]);
+}
+
+ScenePtr SamplingProblem::GetValidityWorkspaceScene(int workspace) const
+{
+    if (workspace < 0 || workspace >= static_cast<int>(validity_workspaces_.size())) ThrowNamed("Invalid workspace " << workspace << ", " << validity_workspaces_.size() << " workspaces have been prepared.");
+    return validity_workspaces_[workspace].scene;
+}
+
+bool SamplingProblem::IsStateValid(Eigen::VectorXdRefConst x, ValidityWorkspace& workspace) const
+{
+    workspace.scene->Update(x);
+    for (int j = 0; j < num_tasks; ++j)
+    {
+        if (workspace.maps[j]->is_used)
+        {
+            EXOTICA_PROFILE_SCOPE("TaskMap::Update");
+            workspace.maps[j]->Update(x, workspace.Phi.data.segment(workspace.maps[j]->start, workspace.maps[j]->length));
+        }
+    }
+    workspace.inequality.Update(workspace.Phi);
+    workspace.equality.Update(workspace.Phi);
+    return IsValid(x, workspace.inequality, workspace.equality);
+}
+
+void SamplingProblem::UpdateValidityWorkspaces(int num_workspaces)
+{
+    if (validity_workspaces_version_ != scene_->GetWorldVersion()) validity_workspaces_.clear();
+    validity_workspaces_version_ = scene_->GetWorldVersion();
+    while (static_cast<int>(validity_workspaces_.size()) < num_workspaces)
+    {
+        ValidityWorkspace workspace;
+        workspace.scene = scene_->CloneWorkspace();
+        workspace.maps = CloneTasks(workspace.scene, flags_);
+        validity_workspaces_.push_back(workspace);
+    }
+
+    // Joints that are not controlled, goals and Rho may have been changed since
+    const std::map<std::string, double> model_state = scene_->GetKinematicTree().GetModelStateMap();
+    for (int i = 0; i < num_workspaces; ++i)
+    {
+        ValidityWorkspace& workspace = validity_workspaces_[i];
+        workspace.scene->GetKinematicTree().SetModelState(model_state);
+        for (std::size_t j = 0; j < tasks_.size(); ++j) workspace.maps[j]->is_used = tasks_[j]->is_used;
+        workspace.Phi = Phi;
+        workspace.inequality = inequality;
+        workspace.equality = equality;
+    }
+}
+
+std::vector<bool> SamplingProblem::AreStatesValid(Eigen::MatrixXdRefConst states, bool stop_at_first_invalid)
+{
+    if (states.cols() != N) ThrowNamed("Wrong state dimension: " << states.cols() << ", expected " << N);
+    const int num_states = static_cast<int>(states.rows());
+    const int num_threads = std::min(validity_num_threads_, num_states);
+    if (num_threads <= 1)
+    {
+        std::vector<bool> ret(num_states, false);
+        for (int i = 0; i < num_states; ++i)
+        {
+            ret[i] = IsStateValid(states.row(i).transpose());
+            if (!ret[i] && stop_at_first_invalid) break;
+        }
+        return ret;
+    }
+
+    UpdateValidityWorkspaces(num_threads);
+
+    // Each thread checks a contiguous block of states on its own clone (see Scene::AreStatesValid). When stopping at the
+    // first invalid state, all states before the first invalid one found so far are still checked.
+    std::vector<char> valid(num_states, false);  // std::vector<bool> can not be written concurrently
+    std::atomic<int> first_invalid(num_states);
+    ParallelLoop(num_threads, num_states, [&](int thread, int i) {
+        if (stop_at_first_invalid && i > first_invalid.load()) return;
+        valid[i] = IsStateValid(states.row(i).transpose(), validity_workspaces_[thread]);
+        if (!valid[i] && stop_at_first_invalid)
+        {
+            int current = first_invalid.load();
+            while (i < current && !first_invalid.compare_exchange_weak(current, i))
+            {
+            }
+        }
+    });
+    number_of_problem_updates_ += num_states;
+
+    std::vector<bool> ret(valid.begin(), valid.end());
+    if (stop_at_first_invalid) std::fill(ret.begin() + first_invalid.load(), ret.end(), false);
+    return ret;
+}
+
 int SamplingProblem::GetSpaceDim()
 {
     return N;
@@ -79,6 +79,8 @@ void TimeIndexedProblem::Instantiate(const TimeIndexedProblemInitializer& init)
 
     T_ = this->parameters_.T;
     tau_ = this->parameters_.tau;
+    SetTrajectoryNumThreads(this->parameters_.TrajectoryNumThreads);
+    SetSkipUnchangedTimeSteps(this->parameters_.SkipUnchangedTimeSteps);
     SetJointVelocityLimits(this->parameters_.JointVelocityLimits);
     ApplyStartState(false);
     ReinitializeVariables();
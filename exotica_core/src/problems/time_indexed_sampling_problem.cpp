@@ -27,6 +27,8 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <cmath>
+
 #include <exotica_core/problems/time_indexed_sampling_problem.h>
 #include <exotica_core/setup.h>
 
@@ -77,6 +79,8 @@ void TimeIndexedSamplingProblem::Instantiate(const TimeIndexedSamplingProblemIni
     if (t_goal_ <= t_start)
         ThrowNamed("Invalid goal time t_goal= " << t_goal_ << ", where t_start=" << t_start);
 
+    if (init.ValidityCacheSize > 0 && !(init.ValidityCacheResolution > 0.0)) ThrowNamed("ValidityCacheResolution has to be positive, given: " << init.ValidityCacheResolution);
+
     if (init.JointVelocityLimits.size() == N)
     {
         vel_limits = init.JointVelocityLimits;
@@ -161,6 +165,7 @@ void TimeIndexedSamplingProblem::SetGoalEQ(const std::string& task_name, Eigen::
         {
             if (goal.rows() != equality.indexing[i].length) ThrowPretty("Expected length of " << equality.indexing[i].length << " and got " << goal.rows());
             equality.y.data.segment(equality.indexing[i].start, equality.indexing[i].length) = goal;
+            InvalidateValidityCache();
             return;
         }
     }
@@ -213,6 +218,7 @@ void TimeIndexedSamplingProblem::SetGoalNEQ(const std::string& task_name, Eigen:
         {
             if (goal.rows() != inequality.indexing[i].length) ThrowPretty("Expected length of " << inequality.indexing[i].length << " and got " << goal.rows());
             inequality.y.data.segment(inequality.indexing[i].start, inequality.indexing[i].length) = goal;
+            InvalidateValidityCache();
             return;
         }
     }
@@ -259,18 +265,20 @@ double TimeIndexedSamplingProblem::GetRhoNEQ(const std::string& task_name)
 
 bool TimeIndexedSamplingProblem::IsValid(Eigen::VectorXdRefConst x, const double& t)
 {
-    scene_->Update(x, t);
-    for (int i = 0; i < num_tasks; ++i)
-    {
-        if (tasks_[i]->is_used)
-            tasks_[i]->Update(x, Phi.data.segment(tasks_[i]->start, tasks_[i]->length));
-    }
-    inequality.Update(Phi);
-    equality.Update(Phi);
-    ++number_of_problem_updates_;
+    std::vector<std::int64_t> key;
+    bool valid;
+    if (LookUpValidity(x, t, key, valid)) return valid;
+
+    Update(x, t);
+    valid = IsValid(inequality, equality);
+    StoreValidity(std::move(key), valid);
+    return valid;
+}
 
-    bool inequality_is_valid = ((inequality.S * inequality.ydiff).array() <= 0.0).all();
-    bool equality_is_valid = ((equality.S * equality.ydiff).array().abs() == 0.0).all();
+bool TimeIndexedSamplingProblem::IsValid(const SamplingTask& inequality, const SamplingTask& equality) const
+{
+    bool inequality_is_valid = (inequality.S.diagonal().cwiseProduct(inequality.ydiff).array() <= 0.0).all();
+    bool equality_is_valid = (equality.S.diagonal().cwiseProduct(equality.ydiff).array().abs() == 0.0).all();
 
     if (debug_)
     {
@@ -280,20 +288,162 @@ bool TimeIndexedSamplingProblem::IsValid(Eigen::VectorXdRefConst x, const double
     return (inequality_is_valid && equality_is_valid);
 }
 
+void TimeIndexedSamplingProblem::PrepareValidityWorkspaces(int num_workspaces)
+{
+    if (num_workspaces < 0) ThrowNamed("The number of workspaces has to be non-negative, given: " << num_workspaces);
+
+    if (validity_workspaces_version_ != scene_->GetWorldVersion()) validity_workspaces_.clear();
+    validity_workspaces_version_ = scene_->GetWorldVersion();
+    while (static_cast<int>(validity_workspaces_.size()) < num_workspaces)
+    {
+        ValidityWorkspace workspace;
+        workspace.scene = scene_->CloneWorkspace();
+        workspace.maps = CloneTasks(workspace.scene, flags_);
+        validity_workspaces_.push_back(workspace);
+    }
+
+    // Joints that are not controlled, goals and Rho may have been changed since
+    const std::map<std::string, double> model_state = scene_->GetKinematicTree().GetModelStateMap();
+    for (int i = 0; i < num_workspaces; ++i)
+    {
+        ValidityWorkspace& workspace = validity_workspaces_[i];
+        workspace.scene->GetKinematicTree().SetModelState(model_state);
+        for (std::size_t j = 0; j < tasks_.size(); ++j) workspace.maps[j]->is_used = tasks_[j]->is_used;
+        workspace.Phi = Phi;
+        workspace.inequality = inequality;
+        workspace.equality = equality;
+    }
+}
+
+bool TimeIndexedSamplingProblem::IsValid(Eigen::VectorXdRefConst x, const double& t, int workspace)
+{
+    if (workspace < 0 || workspace >= static_cast<int>(validity_workspaces_.size())) ThrowNamed("Invalid workspace " << workspace << ", " << validity_workspaces_.size() << " workspaces have been prepared.");
+    std::vector<std::int64_t> key;
+    bool valid;
+    if (LookUpValidity(x, t, key, valid)) return valid;
+
+    ValidityWorkspace& w = validity_workspaces_[workspace];
+    w.scene->Update(x, t);
+    for (int j = 0; j < num_tasks; ++j)
+    {
+        if (w.maps[j]->is_used)
+        {
+            EXOTICA_PROFILE_SCOPE("TaskMap::Update");
+            w.maps[j]->Update(x, w.Phi.data.segment(w.maps[j]->start, w.maps[j]->length));
+        }
+    }
+    w.inequality.Update(w.Phi);
+    w.equality.Update(w.Phi);
+    valid = IsValid(w.inequality, w.equality);
+    StoreValidity(std::move(key), valid);
+    return valid;
+}
+
 void TimeIndexedSamplingProblem::PreUpdate()
 {
     PlanningProblem::PreUpdate();
     for (int i = 0; i < tasks_.size(); ++i) tasks_[i]->is_used = false;
     inequality.UpdateS();
     equality.UpdateS();
+
+    // The constraints may have changed
+    InvalidateValidityCache();
 }
 
 void TimeIndexedSamplingProblem::Update(Eigen::VectorXdRefConst x, const double& t)
 {
-    IsValid(x, t);
+    scene_->Update(x, t);
+    for (int i = 0; i < num_tasks; ++i)
+    {
+        if (tasks_[i]->is_used)
+        {
+            EXOTICA_PROFILE_SCOPE("TaskMap::Update");
+            tasks_[i]->Update(x, Phi.data.segment(tasks_[i]->start, tasks_[i]->length));
+        }
+    }
+    inequality.Update(Phi);
+    equality.Update(Phi);
     ++number_of_problem_updates_;
 }
 
+std::size_t TimeIndexedSamplingProblem::ValidityCacheKeyHash::operator()(const std::vector<std::int64_t>& key) const
+{
+    std::size_t seed = key.size();
+    for (const std::int64_t& value : key) seed ^= std::hash<std::int64_t>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+bool TimeIndexedSamplingProblem::LookUpValidity(Eigen::VectorXdRefConst x, const double& t, std::vector<std::int64_t>& key, bool& valid)
+{
+    if (parameters.ValidityCacheSize <= 0) return false;
+
+    key.resize(x.size() + 1);
+    for (int i = 0; i < x.size(); ++i) key[i] = std::llround(x(i) / parameters.ValidityCacheResolution);
+    key[x.size()] = std::llround(t / parameters.ValidityCacheResolution);
+
+    std::lock_guard<std::mutex> lock(validity_cache_mutex_);
+    // Results are only valid for the world they were computed in
+    if (validity_cache_world_version_ != scene_->GetWorldVersion())
+    {
+        validity_cache_.clear();
+        validity_cache_index_.clear();
+        validity_cache_world_version_ = scene_->GetWorldVersion();
+    }
+
+    auto it = validity_cache_index_.find(key);
+    if (it == validity_cache_index_.end())
+    {
+        ++validity_cache_misses_;
+        return false;
+    }
+    ++validity_cache_hits_;
+    validity_cache_.splice(validity_cache_.begin(), validity_cache_, it->second);
+    valid = it->second->second;
+    return true;
+}
+
+void TimeIndexedSamplingProblem::StoreValidity(std::vector<std::int64_t>&& key, bool valid)
+{
+    if (key.empty()) return;
+
+    std::lock_guard<std::mutex> lock(validity_cache_mutex_);
+    if (validity_cache_index_.count(key) > 0) return;
+    validity_cache_.emplace_front(std::move(key), valid);
+    validity_cache_index_.emplace(validity_cache_.front().first, validity_cache_.begin());
+    while (static_cast<int>(validity_cache_.size()) > parameters.ValidityCacheSize)
+    {
+        validity_cache_index_.erase(validity_cache_.back().first);
+        validity_cache_.pop_back();
+    }
+}
+
+void TimeIndexedSamplingProblem::InvalidateValidityCache()
+{
+    std::lock_guard<std::mutex> lock(validity_cache_mutex_);
+    validity_cache_.clear();
+    validity_cache_index_.clear();
+}
+
+void TimeIndexedSamplingProblem::ClearValidityCache()
+{
+    InvalidateValidityCache();
+    std::lock_guard<std::mutex> lock(validity_cache_mutex_);
+    validity_cache_hits_ = 0;
+    validity_cache_misses_ = 0;
+}
+
+std::size_t TimeIndexedSamplingProblem::GetValidityCacheHits() const
+{
+    std::lock_guard<std::mutex> lock(validity_cache_mutex_);
+    return validity_cache_hits_;
+}
+
+std::size_t TimeIndexedSamplingProblem::GetValidityCacheMisses() const
+{
+    std::lock_guard<std::mutex> lock(validity_cache_mutex_);
+    return validity_cache_misses_;
+}
+
 int TimeIndexedSamplingProblem::GetSpaceDim()
 {
     return N;
@@ -83,14 +83,40 @@ void UnconstrainedEndPoseProblem::PreUpdate()
     cost.UpdateS();
 }
 
+void UnconstrainedEndPoseProblem::UpdateClone(PlanningProblem& clone) const
+{
+    UpdateCloneBase(clone);
+    UnconstrainedEndPoseProblem& clone_problem = static_cast<UnconstrainedEndPoseProblem&>(clone);
+    clone_problem.cost.y = cost.y;
+    clone_problem.cost.rho = cost.rho;
+    clone_problem.W = W;
+    clone_problem.q_nominal = q_nominal;
+    clone_problem.PreUpdate();
+}
+
+double UnconstrainedEndPoseProblem::UpdateEndPoseCost(Eigen::VectorXdRefConst x)
+{
+    Update(x);
+    return GetScalarCost();
+}
+
 double UnconstrainedEndPoseProblem::GetScalarCost() const
 {
-    return cost.ydiff.transpose() * cost.S * cost.ydiff;
+    return cost.ydiff.dot(cost.S.diagonal().cwiseProduct(cost.ydiff));
 }
 
 Eigen::RowVectorXd UnconstrainedEndPoseProblem::GetScalarJacobian() const
 {
-    return cost.jacobian.transpose() * cost.S * cost.ydiff * 2.0;
+    Eigen::RowVectorXd jacobian(N);
+    GetScalarJacobian(jacobian);
+    return jacobian;
+}
+
+void UnconstrainedEndPoseProblem::GetScalarJacobian(Eigen::Ref<Eigen::RowVectorXd> jacobian) const
+{
+    if (jacobian.cols() != N) ThrowPretty("Wrong size of the Jacobian: " << jacobian.cols() << " expecting " << N);
+    jacobian.setZero();
+    for (int i = 0; i < cost.length_jacobian; ++i) jacobian.noalias() += (2.0 * cost.S(i, i) * cost.ydiff(i)) * cost.jacobian.row(i);
 }
 
 double UnconstrainedEndPoseProblem::GetScalarTaskCost(const std::string& task_name) const
@@ -100,24 +126,65 @@ double UnconstrainedEndPoseProblem::GetScalarTaskCost(const std::string& task_na
 }
 
 void UnconstrainedEndPoseProblem::Update(Eigen::VectorXdRefConst x)
+{
+    if (recorder_) recorder_->RecordUpdate(ProblemEventType::Update, x);
+    Update(x, flags_);
+}
+
+void UnconstrainedEndPoseProblem::UpdateCost(Eigen::VectorXdRefConst x)
+{
+    Update(x, KIN_FK);
+}
+
+double UnconstrainedEndPoseProblem::UpdateFused(Eigen::VectorXdRefConst x, Eigen::VectorXdRef JT_times_yd, Eigen::MatrixXdRef JT_times_J)
+{
+    if (!(flags_ & KIN_J)) ThrowPretty("The fused update requires Jacobians, set DerivativeOrder to at least 1!");
+    if (JT_times_yd.rows() != N) ThrowPretty("Wrong size of J^T * yd: " << JT_times_yd.rows() << " expecting " << N);
+    if (JT_times_J.rows() != N || JT_times_J.cols() != N) ThrowPretty("Wrong size of J^T * J: " << JT_times_J.rows() << "x" << JT_times_J.cols() << " expecting " << N << "x" << N);
+    if (recorder_) recorder_->RecordUpdate(ProblemEventType::Update, x);
+    UpdateTaskMaps(x, KIN_FK | KIN_J);
+    ++number_of_problem_updates_;
+    return cost.UpdateFused(Phi, jacobian, JT_times_yd, JT_times_J);
+}
+
+void UnconstrainedEndPoseProblem::Update(Eigen::VectorXdRefConst x, KinematicRequestFlags flags)
+{
+    UpdateTaskMaps(x, flags);
+    if (flags & KIN_H)
+    {
+        cost.Update(Phi, jacobian, hessian);
+    }
+    else if (flags & KIN_J)
+    {
+        cost.Update(Phi, jacobian);
+    }
+    else
+    {
+        cost.Update(Phi);
+    }
+    ++number_of_problem_updates_;
+}
+
+void UnconstrainedEndPoseProblem::UpdateTaskMaps(Eigen::VectorXdRefConst x, KinematicRequestFlags flags)
 {
     scene_->Update(x, t_start);
     Phi.SetZero(length_Phi);
-    if (flags_ & KIN_J) jacobian.setZero();
-    if (flags_ & KIN_H)
+    if (flags & KIN_J) jacobian.setZero();
+    if (flags & KIN_H)
         for (int i = 0; i < length_jacobian; ++i) hessian(i).setZero();
     for (int i = 0; i < tasks_.size(); ++i)
     {
         if (tasks_[i]->is_used)
         {
-            if (flags_ & KIN_H)
+            EXOTICA_PROFILE_SCOPE("TaskMap::Update");
+            if (flags & KIN_H)
             {
                 tasks_[i]->Update(x,
                                   Phi.data.segment(tasks_[i]->start, tasks_[i]->length),
                                   jacobian.middleRows(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian),
                                   hessian.segment(tasks_[i]->start_jacobian, tasks_[i]->length_jacobian));
             }
-            else if (flags_ & KIN_J)
+            else if (flags & KIN_J)
             {
                 tasks_[i]->Update(x,
                                   Phi.data.segment(tasks_[i]->start, tasks_[i]->length),
@@ -130,23 +197,11 @@ void UnconstrainedEndPoseProblem::Update(Eigen::VectorXdRefConst x)
             }
         }
     }
-    if (flags_ & KIN_H)
-    {
-        cost.Update(Phi, jacobian, hessian);
-    }
-    else if (flags_ & KIN_J)
-    {
-        cost.Update(Phi, jacobian);
-    }
-    else
-    {
-        cost.Update(Phi);
-    }
-    ++number_of_problem_updates_;
 }
 
 void UnconstrainedEndPoseProblem::SetGoal(const std::string& task_name, Eigen::VectorXdRefConst goal)
 {
+    if (recorder_) recorder_->RecordGoal(ProblemEventType::SetGoal, task_name, goal);
     for (int i = 0; i < cost.indexing.size(); ++i)
     {
         if (cost.tasks[i]->GetObjectName() == task_name)
@@ -161,6 +216,7 @@ void UnconstrainedEndPoseProblem::SetGoal(const std::string& task_name, Eigen::V
 
 void UnconstrainedEndPoseProblem::SetRho(const std::string& task_name, const double& rho)
 {
+    if (recorder_) recorder_->RecordRho(ProblemEventType::SetRho, task_name, rho);
     for (int i = 0; i < cost.indexing.size(); ++i)
     {
         if (cost.tasks[i]->GetObjectName() == task_name)
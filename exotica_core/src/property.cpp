@@ -95,6 +95,12 @@ bool Initializer::HasProperty(const std::string& name) const
     return properties_.find(name) != properties_.end();
 }
 
+const Property* Initializer::FindProperty(const std::string& name) const
+{
+    auto it = properties_.find(name);
+    return it != properties_.end() ? &it->second : nullptr;
+}
+
 boost::any Initializer::GetProperty(const std::string& name) const
 {
     return properties_.at(name).Get();
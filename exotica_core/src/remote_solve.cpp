@@ -0,0 +1,660 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+#include <exotica_core/loaders/initializer_serialization.h>
+#include <exotica_core/loaders/xml_loader.h>
+#include <exotica_core/problems/abstract_time_indexed_problem.h>
+#include <exotica_core/problems/bounded_end_pose_problem.h>
+#include <exotica_core/problems/end_pose_problem.h>
+#include <exotica_core/problems/sampling_problem.h>
+#include <exotica_core/problems/time_indexed_sampling_problem.h>
+#include <exotica_core/problems/unconstrained_end_pose_problem.h>
+#include <exotica_core/remote_solve.h>
+
+namespace exotica
+{
+namespace
+{
+constexpr char kMagic[4] = {'E', 'X', 'O', 'R'};
+constexpr std::uint32_t kProtocolVersion = 1;
+
+enum MessageKind : std::uint8_t
+{
+    MESSAGE_REQUEST = 1,
+    MESSAGE_PROGRESS = 2,
+    MESSAGE_RESULT = 3
+};
+
+enum ResultStatus : std::uint8_t
+{
+    STATUS_SUCCESS = 0,
+    STATUS_FAILED = 1,
+    STATUS_UNKNOWN_CONFIGURATION = 2
+};
+
+/// \brief Appends little-endian values to a message.
+class MessageWriter
+{
+public:
+    MessageWriter(MessageKind kind, std::uint64_t id)
+    {
+        data.append(kMagic, 4);
+        UInt32(kProtocolVersion);
+        UInt8(kind);
+        UInt64(id);
+    }
+
+    void UInt8(std::uint8_t value) { data.push_back(static_cast<char>(value)); }
+    void UInt32(std::uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i) data.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+    void UInt64(std::uint64_t value)
+    {
+        for (int i = 0; i < 8; ++i) data.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+    void Double(double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        UInt64(bits);
+    }
+    void String(const std::string& value)
+    {
+        UInt32(static_cast<std::uint32_t>(value.size()));
+        data.append(value);
+    }
+    void Matrix(Eigen::MatrixXdRefConst value)
+    {
+        UInt32(static_cast<std::uint32_t>(value.rows()));
+        UInt32(static_cast<std::uint32_t>(value.cols()));
+        for (int j = 0; j < value.cols(); ++j)
+            for (int i = 0; i < value.rows(); ++i) Double(value(i, j));
+    }
+
+    std::string data;
+};
+
+/// \brief Reads the values written by MessageWriter, throws if the message is truncated.
+class MessageReader
+{
+public:
+    explicit MessageReader(const std::string& data) : data_(data)
+    {
+        if (data_.size() < 17 || std::memcmp(data_.data(), kMagic, 4) != 0) ThrowPretty("Not a remote solve message");
+        position_ = 4;
+        const std::uint32_t version = UInt32();
+        if (version != kProtocolVersion) ThrowPretty("Remote solve protocol version " << version << " is not supported, expecting " << kProtocolVersion);
+        kind = static_cast<MessageKind>(UInt8());
+        id = UInt64();
+    }
+
+    std::uint8_t UInt8()
+    {
+        Require(1);
+        return static_cast<std::uint8_t>(data_[position_++]);
+    }
+    std::uint32_t UInt32()
+    {
+        Require(4);
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) value |= static_cast<std::uint32_t>(static_cast<unsigned char>(data_[position_++])) << (8 * i);
+        return value;
+    }
+    std::uint64_t UInt64()
+    {
+        Require(8);
+        std::uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data_[position_++])) << (8 * i);
+        return value;
+    }
+    double Double()
+    {
+        const std::uint64_t bits = UInt64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    std::string String()
+    {
+        const std::uint32_t size = UInt32();
+        Require(size);
+        std::string value = data_.substr(position_, size);
+        position_ += size;
+        return value;
+    }
+    Eigen::MatrixXd Matrix()
+    {
+        const std::uint32_t rows = UInt32();
+        const std::uint32_t cols = UInt32();
+        Require(8 * static_cast<std::size_t>(rows) * cols);
+        Eigen::MatrixXd value(rows, cols);
+        for (std::uint32_t j = 0; j < cols; ++j)
+            for (std::uint32_t i = 0; i < rows; ++i) value(i, j) = Double();
+        return value;
+    }
+
+    MessageKind kind;
+    std::uint64_t id;
+
+private:
+    void Require(std::size_t size) const
+    {
+        if (data_.size() - position_ < size) ThrowPretty("Truncated remote solve message");
+    }
+
+    const std::string& data_;
+    std::size_t position_ = 0;
+};
+
+void WriteRecord(MessageWriter& writer, const IterationRecord& record)
+{
+    writer.UInt32(static_cast<std::uint32_t>(record.iteration));
+    writer.Double(record.time);
+    writer.Double(record.cost);
+    writer.Double(record.step_length);
+    writer.Double(record.regularization);
+    writer.Double(record.constraint_violation);
+    for (double duration : record.phase_durations) writer.Double(duration);
+}
+
+IterationRecord ReadRecord(MessageReader& reader)
+{
+    IterationRecord record;
+    record.iteration = static_cast<int>(reader.UInt32());
+    record.time = reader.Double();
+    record.cost = reader.Double();
+    record.step_length = reader.Double();
+    record.regularization = reader.Double();
+    record.constraint_violation = reader.Double();
+    for (double& duration : record.phase_durations) duration = reader.Double();
+    return record;
+}
+
+std::string SerializeConfiguration(const Initializer& solver, const Initializer& problem)
+{
+    std::ostringstream out;
+    SerializeInitializers({solver, problem}, out);
+    return out.str();
+}
+
+void SetTaskGoal(const PlanningProblemPtr& problem, const std::string& task_name, Eigen::VectorXdRefConst goal)
+{
+    if (std::shared_ptr<UnconstrainedEndPoseProblem> end_pose_problem = std::dynamic_pointer_cast<UnconstrainedEndPoseProblem>(problem))
+        end_pose_problem->SetGoal(task_name, goal);
+    else if (std::shared_ptr<BoundedEndPoseProblem> bounded_problem = std::dynamic_pointer_cast<BoundedEndPoseProblem>(problem))
+        bounded_problem->SetGoal(task_name, goal);
+    else if (std::shared_ptr<EndPoseProblem> constrained_problem = std::dynamic_pointer_cast<EndPoseProblem>(problem))
+        constrained_problem->SetGoal(task_name, goal);
+    else if (std::shared_ptr<AbstractTimeIndexedProblem> time_indexed_problem = std::dynamic_pointer_cast<AbstractTimeIndexedProblem>(problem))
+        time_indexed_problem->SetGoal(task_name, goal, time_indexed_problem->GetT() - 1);
+    else
+        ThrowPretty("Task goals are not supported for problems of type '" << problem->type() << "'!");
+}
+
+/// \brief Sets the state of the request on the problem of a pipeline.
+void ApplyRequest(const RemoteSolveRequest& request, const PlanningProblemPtr& problem)
+{
+    if (request.start_state.size() > 0) problem->SetStartState(request.start_state);
+    problem->SetStartTime(request.start_time);
+    for (const auto& goal : request.task_goals) SetTaskGoal(problem, goal.first, goal.second);
+
+    if (request.goal_state.size() > 0)
+    {
+        if (std::shared_ptr<SamplingProblem> sampling_problem = std::dynamic_pointer_cast<SamplingProblem>(problem))
+            sampling_problem->SetGoalState(request.goal_state);
+        else if (std::shared_ptr<TimeIndexedSamplingProblem> time_indexed_sampling_problem = std::dynamic_pointer_cast<TimeIndexedSamplingProblem>(problem))
+            time_indexed_sampling_problem->SetGoalState(request.goal_state);
+        else
+            ThrowPretty("Goal states are not supported for problems of type '" << problem->type() << "'!");
+    }
+
+    if (request.initial_trajectory.size() > 0)
+    {
+        std::shared_ptr<AbstractTimeIndexedProblem> time_indexed_problem = std::dynamic_pointer_cast<AbstractTimeIndexedProblem>(problem);
+        if (!time_indexed_problem) ThrowPretty("Initial trajectories are not supported for problems of type '" << problem->type() << "'!");
+        std::vector<Eigen::VectorXd> q_init(request.initial_trajectory.rows());
+        for (int t = 0; t < request.initial_trajectory.rows(); ++t) q_init[t] = request.initial_trajectory.row(t).transpose();
+        time_indexed_problem->SetInitialTrajectory(q_init);
+    }
+}
+
+std::string MessageToString(const zmq::message_t& message)
+{
+    return std::string(static_cast<const char*>(message.data()), message.size());
+}
+}  // namespace
+
+std::uint64_t HashConfiguration(const Initializer& solver, const Initializer& problem)
+{
+    return HashContent(SerializeConfiguration(solver, problem));
+}
+
+struct RemoteSolveServer::Job
+{
+    std::string identity;  ///< Router identity of the client
+    std::uint64_t id;
+    std::uint64_t configuration;
+    RemoteSolveRequest request;
+    MotionSolverPtr solver;  ///< Pipeline of the running job
+    std::future<RemoteSolveResult> result;
+    std::uint64_t telemetry_count = 0;  ///< Iteration records already streamed
+};
+
+RemoteSolveServer::RemoteSolveServer(const std::string& url, int pool_size) : pool_size_(pool_size), context_(1), socket_(context_, ZMQ_ROUTER)
+{
+    if (pool_size < 0) ThrowPretty("Invalid pool size: " << pool_size);
+    socket_.setsockopt(ZMQ_LINGER, 0);
+    socket_.bind(url);
+    HIGHLIGHT_NAMED("RemoteSolveServer", "Listening on " << url);
+}
+
+RemoteSolveServer::~RemoteSolveServer()
+{
+    // Wait for the running solves before their pipelines are destroyed
+    for (const std::shared_ptr<Job>& job : running_)
+        if (job->result.valid()) job->result.wait();
+}
+
+void RemoteSolveServer::AddConfiguration(const Initializer& solver, const Initializer& problem)
+{
+    const std::uint64_t hash = HashConfiguration(solver, problem);
+    Configuration& configuration = GetConfiguration(hash, SerializeConfiguration(solver, problem));
+    if (configuration.pool) return;
+    try
+    {
+        configuration.pool = configuration.loading.get();
+    }
+    catch (...)
+    {
+        configurations_.erase(hash);
+        throw;
+    }
+}
+
+void RemoteSolveServer::AddConfiguration(const std::string& file_name)
+{
+    Initializer solver, problem;
+    XMLLoader::Load(file_name, solver, problem);
+    AddConfiguration(solver, problem);
+}
+
+RemoteSolveServer::Configuration& RemoteSolveServer::GetConfiguration(std::uint64_t hash, const std::string& initializers)
+{
+    auto it = configurations_.find(hash);
+    if (it != configurations_.end()) return it->second;
+
+    std::vector<Initializer> configuration;
+    std::istringstream in(initializers);
+    if (!DeserializeInitializers(in, configuration) || configuration.size() != 2) ThrowPretty("Invalid configuration");
+    if (HashContent(initializers) != hash) ThrowPretty("The configuration does not match its hash");
+
+    // Loading the pipelines can take seconds, the serving loop keeps streaming the running solves meanwhile
+    HIGHLIGHT_NAMED("RemoteSolveServer", "Instantiating the pipelines of configuration " << hash);
+    Configuration& added = configurations_[hash];
+    const int pool_size = pool_size_;
+    added.loading = std::async(std::launch::async, [configuration, pool_size]() {
+        return std::unique_ptr<PipelinePool>(new PipelinePool(configuration[0], configuration[1], pool_size));
+    });
+    return added;
+}
+
+void RemoteSolveServer::FinishLoading()
+{
+    for (auto it = configurations_.begin(); it != configurations_.end();)
+    {
+        Configuration& configuration = it->second;
+        if (configuration.pool || configuration.loading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++it;
+            continue;
+        }
+
+        try
+        {
+            configuration.pool = configuration.loading.get();
+            ++it;
+        }
+        catch (const std::exception& e)
+        {
+            WARNING_NAMED("RemoteSolveServer", "Failed to instantiate the pipelines of configuration " << it->first << ": " << e.what());
+            for (const std::shared_ptr<Job>& job : configuration.pending)
+            {
+                MessageWriter reply(MESSAGE_RESULT, job->id);
+                reply.UInt8(STATUS_FAILED);
+                reply.String(e.what());
+                SendReply(job->identity, reply.data);
+            }
+            it = configurations_.erase(it);
+        }
+    }
+}
+
+void RemoteSolveServer::SendReply(const std::string& identity, const std::string& data)
+{
+    socket_.send(identity.data(), identity.size(), ZMQ_SNDMORE);
+    socket_.send(data.data(), data.size());
+}
+
+void RemoteSolveServer::HandleRequest(const std::string& identity, const std::string& data)
+{
+    MessageReader reader(data);
+    if (reader.kind != MESSAGE_REQUEST) ThrowPretty("Unexpected message kind " << static_cast<int>(reader.kind));
+
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->identity = identity;
+    job->id = reader.id;
+    job->configuration = reader.UInt64();
+    const std::string initializers = reader.String();
+    job->request.start_state = reader.Matrix();
+    job->request.start_time = reader.Double();
+    const std::uint32_t num_goals = reader.UInt32();
+    for (std::uint32_t i = 0; i < num_goals; ++i)
+    {
+        const std::string task_name = reader.String();
+        job->request.task_goals[task_name] = reader.Matrix();
+    }
+    job->request.goal_state = reader.Matrix();
+    job->request.initial_trajectory = reader.Matrix();
+
+    if (configurations_.count(job->configuration) == 0 && initializers.empty())
+    {
+        MessageWriter reply(MESSAGE_RESULT, job->id);
+        reply.UInt8(STATUS_UNKNOWN_CONFIGURATION);
+        SendReply(identity, reply.data);
+        return;
+    }
+    GetConfiguration(job->configuration, initializers).pending.push_back(job);
+}
+
+void RemoteSolveServer::StartPendingJobs()
+{
+    for (auto& it : configurations_)
+    {
+        Configuration& configuration = it.second;
+        while (configuration.pool && !configuration.pending.empty())
+        {
+            MotionSolverPtr solver = configuration.pool->TryAcquire();
+            if (!solver) break;
+
+            std::shared_ptr<Job> job = configuration.pending.front();
+            configuration.pending.erase(configuration.pending.begin());
+            job->solver = solver;
+            job->telemetry_count = solver->GetProblem()->GetIterationTelemetry().GetNumberOfRecords();
+            job->result = std::async(std::launch::async, [job]() {
+                RemoteSolveResult result;
+                try
+                {
+                    PlanningProblemPtr problem = job->solver->GetProblem();
+                    ApplyRequest(job->request, problem);
+                    job->solver->Solve(result.solution);
+                    result.planning_time = job->solver->GetPlanningTime();
+                    result.termination_criterion = static_cast<int>(problem->termination_criterion);
+                    result.success = true;
+                }
+                catch (const std::exception& e)
+                {
+                    result.error = e.what();
+                }
+                return result;
+            });
+            running_.push_back(job);
+        }
+    }
+}
+
+void RemoteSolveServer::Run()
+{
+    stop_ = false;
+    std::vector<IterationRecord> records;
+    while (!stop_ || !running_.empty())
+    {
+        zmq::pollitem_t items[] = {{static_cast<void*>(socket_), 0, ZMQ_POLLIN, 0}};
+        // Poll often while solving to stream the iterations, or while loading to start the pending requests soon after
+        const bool loading = std::any_of(configurations_.begin(), configurations_.end(), [](const std::pair<const std::uint64_t, Configuration>& it) { return !it.second.pool; });
+        zmq::poll(items, 1, running_.empty() && !loading ? 100 : 5);
+
+        while (!stop_ && (items[0].revents & ZMQ_POLLIN))
+        {
+            zmq::message_t identity, payload;
+            if (!socket_.recv(&identity, ZMQ_DONTWAIT)) break;
+            // The request is the last frame after the identity of the client
+            bool more = identity.more();
+            while (more && socket_.recv(&payload)) more = payload.more();
+
+            try
+            {
+                HandleRequest(MessageToString(identity), MessageToString(payload));
+            }
+            catch (const std::exception& e)
+            {
+                WARNING_NAMED("RemoteSolveServer", "Rejected request: " << e.what());
+                try
+                {
+                    const std::string data = MessageToString(payload);
+                    MessageReader reader(data);
+                    MessageWriter reply(MESSAGE_RESULT, reader.id);
+                    reply.UInt8(STATUS_FAILED);
+                    reply.String(e.what());
+                    SendReply(MessageToString(identity), reply.data);
+                }
+                catch (const std::exception&)
+                {
+                    // Not a request, nobody to reply to
+                }
+            }
+        }
+
+        FinishLoading();
+        StartPendingJobs();
+
+        for (auto job_it = running_.begin(); job_it != running_.end();)
+        {
+            Job& job = **job_it;
+            records.clear();
+            job.telemetry_count = job.solver->GetProblem()->GetIterationTelemetry().Read(job.telemetry_count, records);
+            const bool finished = job.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            if (finished)
+            {
+                // Records pushed right before returning
+                job.telemetry_count = job.solver->GetProblem()->GetIterationTelemetry().Read(job.telemetry_count, records);
+            }
+            if (!records.empty())
+            {
+                MessageWriter progress(MESSAGE_PROGRESS, job.id);
+                progress.UInt32(static_cast<std::uint32_t>(records.size()));
+                for (const IterationRecord& record : records) WriteRecord(progress, record);
+                SendReply(job.identity, progress.data);
+            }
+            if (!finished)
+            {
+                ++job_it;
+                continue;
+            }
+
+            const RemoteSolveResult result = job.result.get();
+            MessageWriter reply(MESSAGE_RESULT, job.id);
+            reply.UInt8(result.success ? STATUS_SUCCESS : STATUS_FAILED);
+            reply.String(result.error);
+            reply.Double(result.planning_time);
+            reply.UInt32(static_cast<std::uint32_t>(result.termination_criterion));
+            reply.Matrix(result.solution);
+            SendReply(job.identity, reply.data);
+
+            // Returns the pipeline to the pool
+            job.solver.reset();
+            job_it = running_.erase(job_it);
+        }
+    }
+
+    // Requests that did not get a pipeline before stopping
+    for (auto& it : configurations_)
+    {
+        for (const std::shared_ptr<Job>& job : it.second.pending)
+        {
+            MessageWriter reply(MESSAGE_RESULT, job->id);
+            reply.UInt8(STATUS_FAILED);
+            reply.String("The server stopped");
+            SendReply(job->identity, reply.data);
+        }
+        it.second.pending.clear();
+    }
+}
+
+RemoteSolveClient::RemoteSolveClient(const std::vector<std::string>& urls, const Initializer& solver, const Initializer& problem, int timeout_ms) : urls_(urls), timeout_ms_(timeout_ms), initializers_(SerializeConfiguration(solver, problem)), context_(1)
+{
+    if (urls_.empty()) ThrowPretty("No server to connect to");
+    if (timeout_ms_ <= 0) ThrowPretty("The timeout has to be positive, got " << timeout_ms_);
+    configuration_hash_ = HashContent(initializers_);
+    Connect();
+}
+
+RemoteSolveClient::RemoteSolveClient(const std::vector<std::string>& urls, const std::string& file_name, int timeout_ms) : urls_(urls), timeout_ms_(timeout_ms), context_(1)
+{
+    if (urls_.empty()) ThrowPretty("No server to connect to");
+    if (timeout_ms_ <= 0) ThrowPretty("The timeout has to be positive, got " << timeout_ms_);
+    Initializer solver, problem;
+    XMLLoader::Load(file_name, solver, problem);
+    initializers_ = SerializeConfiguration(solver, problem);
+    configuration_hash_ = HashContent(initializers_);
+    Connect();
+}
+
+void RemoteSolveClient::Connect()
+{
+    socket_.reset(new zmq::socket_t(context_, ZMQ_DEALER));
+    socket_->setsockopt(ZMQ_LINGER, 0);
+    // Only hand requests to servers that are connected, instead of queueing them for unreachable ones
+    socket_->setsockopt(ZMQ_IMMEDIATE, 1);
+    for (const std::string& url : urls_) socket_->connect(url);
+}
+
+void RemoteSolveClient::Send(std::uint64_t id, const RemoteSolveRequest& request, bool with_initializers)
+{
+    MessageWriter writer(MESSAGE_REQUEST, id);
+    writer.UInt64(configuration_hash_);
+    writer.String(with_initializers ? initializers_ : std::string());
+    writer.Matrix(request.start_state);
+    writer.Double(request.start_time);
+    writer.UInt32(static_cast<std::uint32_t>(request.task_goals.size()));
+    for (const auto& goal : request.task_goals)
+    {
+        writer.String(goal.first);
+        writer.Matrix(goal.second);
+    }
+    writer.Matrix(request.goal_state);
+    writer.Matrix(request.initial_trajectory);
+    socket_->send(writer.data.data(), writer.data.size());
+}
+
+RemoteSolveResult RemoteSolveClient::Solve(const RemoteSolveRequest& request, const std::function<void(const IterationRecord&)>& on_iteration)
+{
+    std::function<void(int, const IterationRecord&)> on_batch_iteration;
+    if (on_iteration) on_batch_iteration = [&on_iteration](int, const IterationRecord& record) { on_iteration(record); };
+    return SolveBatch({request}, on_batch_iteration)[0];
+}
+
+std::vector<RemoteSolveResult> RemoteSolveClient::SolveBatch(const std::vector<RemoteSolveRequest>& requests, const std::function<void(int, const IterationRecord&)>& on_iteration)
+{
+    std::vector<RemoteSolveResult> results(requests.size());
+    std::vector<bool> done(requests.size(), false);
+    std::size_t num_remaining = requests.size();
+
+    // Ids of earlier batches identify late replies, e.g. after a timeout
+    const std::uint64_t first_id = next_id_;
+    next_id_ += requests.size();
+    for (std::size_t i = 0; i < requests.size(); ++i) Send(first_id + i, requests[i], false);
+
+    while (num_remaining > 0)
+    {
+        zmq::pollitem_t items[] = {{static_cast<void*>(*socket_), 0, ZMQ_POLLIN, 0}};
+        zmq::poll(items, 1, timeout_ms_);
+        if (!(items[0].revents & ZMQ_POLLIN))
+        {
+            for (std::size_t i = 0; i < requests.size(); ++i)
+                if (!done[i]) results[i].error = "Timed out waiting for the servers";
+            // Drops the requests still queued for the servers
+            Connect();
+            break;
+        }
+
+        zmq::message_t message;
+        if (!socket_->recv(&message)) continue;
+        try
+        {
+            const std::string data = MessageToString(message);
+            MessageReader reader(data);
+            if (reader.id < first_id || reader.id >= first_id + requests.size()) continue;
+            const std::size_t index = reader.id - first_id;
+            if (done[index]) continue;
+
+            if (reader.kind == MESSAGE_PROGRESS)
+            {
+                const std::uint32_t num_records = reader.UInt32();
+                for (std::uint32_t i = 0; i < num_records; ++i)
+                {
+                    results[index].iterations.push_back(ReadRecord(reader));
+                    if (on_iteration) on_iteration(static_cast<int>(index), results[index].iterations.back());
+                }
+            }
+            else if (reader.kind == MESSAGE_RESULT)
+            {
+                const std::uint8_t status = reader.UInt8();
+                if (status == STATUS_UNKNOWN_CONFIGURATION)
+                {
+                    // The server does not have pipelines for the configuration yet
+                    Send(reader.id, requests[index], true);
+                    continue;
+                }
+                RemoteSolveResult& result = results[index];
+                result.error = reader.String();
+                if (status == STATUS_SUCCESS)
+                {
+                    result.planning_time = reader.Double();
+                    result.termination_criterion = static_cast<int>(reader.UInt32());
+                    result.solution = reader.Matrix();
+                    result.success = true;
+                }
+                done[index] = true;
+                --num_remaining;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            WARNING_NAMED("RemoteSolveClient", "Ignoring reply: " << e.what());
+        }
+    }
+    return results;
+}
+}  // namespace exotica
@@ -31,11 +31,18 @@
 #include <geometric_shapes/mesh_operations.h>
 #include <geometric_shapes/shape_operations.h>
 #include <kdl_conversions/kdl_msg.h>
+#include <octomap/OcTree.h>
+#include <tf_conversions/tf_kdl.h>
 
 #include <exotica_core/dynamics_solver.h>
 #include <exotica_core/scene.h>
 #include <exotica_core/server.h>
 #include <exotica_core/setup.h>
+#include <exotica_core/tools/parallel_loop.h>
+#include <exotica_core/tools/timer.h>
+
+#include <atomic>
+#include <cmath>
 
 #include <exotica_core/attach_link_initializer.h>
 #include <exotica_core/box_shape_initializer.h>
@@ -50,8 +57,212 @@
 
 #include <moveit/version.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+
 namespace exotica
 {
+// Binary scene snapshots store the world objects in a flat layout: a header followed by, per object, its name,
+// color and shapes. Each shape is stored as a 3x4 pose and its parameters, meshes with their vertex, triangle and
+// normal buffers. All fields are aligned to 8 bytes. Snapshots are loaded from a memory mapping of the file, and the
+// mesh buffers are copied straight from it: the normals are computed when saving, not when loading.
+constexpr char kSceneSnapshotMagic[8] = {'E', 'X', 'O', 'S', 'C', 'E', 'N', 'E'};
+constexpr uint32_t kSceneSnapshotVersion = 2;  // Version 1 did not store the mesh normals
+constexpr uint32_t kSceneSnapshotByteOrder = 0x01020304;
+
+inline bool IsSnapshotShapeType(shapes::ShapeType type)
+{
+    return type == shapes::SPHERE || type == shapes::BOX || type == shapes::CYLINDER || type == shapes::CONE || type == shapes::PLANE || type == shapes::MESH;
+}
+
+struct SceneSnapshotWriter
+{
+    void Write(const void* data, std::size_t size)
+    {
+        const char* bytes = reinterpret_cast<const char*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+        buffer.resize((buffer.size() + 7) & ~std::size_t(7), 0);
+    }
+
+    template <typename T>
+    void Write(const T& value)
+    {
+        Write(&value, sizeof(T));
+    }
+
+    void WriteString(const std::string& value)
+    {
+        Write<uint64_t>(value.size());
+        Write(value.data(), value.size());
+    }
+
+    void WriteShape(const shapes::Shape& shape)
+    {
+        Write<uint64_t>(shape.type);
+        switch (shape.type)
+        {
+            case shapes::SPHERE:
+                Write<double>(static_cast<const shapes::Sphere&>(shape).radius);
+                break;
+            case shapes::BOX:
+                Write(static_cast<const shapes::Box&>(shape).size, sizeof(double) * 3);
+                break;
+            case shapes::CYLINDER:
+            {
+                const double parameters[2] = {static_cast<const shapes::Cylinder&>(shape).radius, static_cast<const shapes::Cylinder&>(shape).length};
+                Write(parameters, sizeof(parameters));
+            }
+            break;
+            case shapes::CONE:
+            {
+                const double parameters[2] = {static_cast<const shapes::Cone&>(shape).radius, static_cast<const shapes::Cone&>(shape).length};
+                Write(parameters, sizeof(parameters));
+            }
+            break;
+            case shapes::PLANE:
+            {
+                const shapes::Plane& plane = static_cast<const shapes::Plane&>(shape);
+                const double parameters[4] = {plane.a, plane.b, plane.c, plane.d};
+                Write(parameters, sizeof(parameters));
+            }
+            break;
+            case shapes::MESH:
+            {
+                // The normals of the mesh may not have been computed, they are computed on a copy
+                const std::unique_ptr<shapes::Mesh> mesh(static_cast<const shapes::Mesh&>(shape).clone());
+                mesh->computeTriangleNormals();
+                mesh->computeVertexNormals();
+                Write<uint64_t>(mesh->vertex_count);
+                Write<uint64_t>(mesh->triangle_count);
+                Write(mesh->vertices, sizeof(double) * 3 * mesh->vertex_count);
+                Write(mesh->triangles, sizeof(unsigned int) * 3 * mesh->triangle_count);
+                Write(mesh->triangle_normals, sizeof(double) * 3 * mesh->triangle_count);
+                Write(mesh->vertex_normals, sizeof(double) * 3 * mesh->vertex_count);
+            }
+            break;
+            default:
+                ThrowPretty("Unsupported shape type " << static_cast<int>(shape.type));
+        }
+    }
+
+    std::vector<char> buffer;
+};
+
+struct SceneSnapshotReader
+{
+    SceneSnapshotReader(const char* data, std::size_t size) : data_(data), size_(size) {}
+
+    uint32_t version = kSceneSnapshotVersion;
+
+    const char* Skip(std::size_t size)
+    {
+        // Sizes read from the file are untrusted, hence compared against the remaining size without overflowing
+        if (size > Remaining()) ThrowPretty("Scene snapshot is truncated");
+        const std::size_t aligned_size = std::min((size + 7) & ~std::size_t(7), Remaining());
+        const char* ret = data_ + position_;
+        position_ += aligned_size;
+        return ret;
+    }
+
+    std::size_t Remaining() const
+    {
+        return size_ - position_;
+    }
+
+    void Read(void* data, std::size_t size)
+    {
+        std::memcpy(data, Skip(size), size);
+    }
+
+    template <typename T>
+    T Read()
+    {
+        T value;
+        Read(&value, sizeof(T));
+        return value;
+    }
+
+    std::string ReadString()
+    {
+        const uint64_t size = Read<uint64_t>();
+        return std::string(Skip(size), size);
+    }
+
+    shapes::ShapeConstPtr ReadShape()
+    {
+        const uint64_t type = Read<uint64_t>();
+        switch (type)
+        {
+            case shapes::SPHERE:
+                return shapes::ShapeConstPtr(new shapes::Sphere(Read<double>()));
+            case shapes::BOX:
+            {
+                double size[3];
+                Read(size, sizeof(size));
+                return shapes::ShapeConstPtr(new shapes::Box(size[0], size[1], size[2]));
+            }
+            case shapes::CYLINDER:
+            {
+                double parameters[2];
+                Read(parameters, sizeof(parameters));
+                return shapes::ShapeConstPtr(new shapes::Cylinder(parameters[0], parameters[1]));
+            }
+            case shapes::CONE:
+            {
+                double parameters[2];
+                Read(parameters, sizeof(parameters));
+                return shapes::ShapeConstPtr(new shapes::Cone(parameters[0], parameters[1]));
+            }
+            case shapes::PLANE:
+            {
+                double parameters[4];
+                Read(parameters, sizeof(parameters));
+                return shapes::ShapeConstPtr(new shapes::Plane(parameters[0], parameters[1], parameters[2], parameters[3]));
+            }
+            case shapes::MESH:
+            {
+                const uint64_t vertex_count = Read<uint64_t>();
+                const uint64_t triangle_count = Read<uint64_t>();
+                // The buffers have to fit into the rest of the file, corrupt counts must not cause huge allocations
+                if (vertex_count > Remaining() / (sizeof(double) * 3) || triangle_count > Remaining() / (sizeof(unsigned int) * 3) ||
+                    sizeof(double) * 3 * vertex_count + sizeof(unsigned int) * 3 * triangle_count > Remaining())
+                    ThrowPretty("Scene snapshot is truncated or contains an invalid mesh with " << vertex_count << " vertices and " << triangle_count << " triangles");
+                // shapes::Mesh owns its buffers, hence they are copied once from the mapping
+                shapes::Mesh* mesh = new shapes::Mesh(vertex_count, triangle_count);
+                shapes::ShapeConstPtr ret(mesh);
+                Read(mesh->vertices, sizeof(double) * 3 * vertex_count);
+                Read(mesh->triangles, sizeof(unsigned int) * 3 * triangle_count);
+                for (uint64_t i = 0; i < 3 * triangle_count; ++i)
+                {
+                    if (mesh->triangles[i] >= vertex_count) ThrowPretty("Scene snapshot contains a mesh with the invalid vertex index " << mesh->triangles[i] << " (" << vertex_count << " vertices)");
+                }
+                if (version == 1)
+                {
+                    mesh->computeTriangleNormals();
+                    mesh->computeVertexNormals();
+                    return ret;
+                }
+                if (!mesh->triangle_normals) mesh->triangle_normals = new double[3 * triangle_count];
+                if (!mesh->vertex_normals) mesh->vertex_normals = new double[3 * vertex_count];
+                Read(mesh->triangle_normals, sizeof(double) * 3 * triangle_count);
+                Read(mesh->vertex_normals, sizeof(double) * 3 * vertex_count);
+                return ret;
+            }
+            default:
+                ThrowPretty("Unsupported shape type " << type << " in scene snapshot");
+        }
+    }
+
+private:
+    const char* data_;
+    std::size_t size_;
+    std::size_t position_ = 0;
+};
+
 Scene::Scene() = default;
 
 Scene::Scene(const std::string& name) : request_needs_updating_(false)
@@ -59,7 +270,10 @@ Scene::Scene(const std::string& name) : request_needs_updating_(false)
     object_name_ = name;
 }
 
-Scene::~Scene() = default;
+Scene::~Scene()
+{
+    StopDebugPublisher();
+}
 
 const std::string& Scene::GetName() const
 {
@@ -83,6 +297,18 @@ void Scene::Instantiate(const SceneInitializer& init)
         Server::Instance()->GetModel(init.URDF, model, init.URDF, init.SRDF);
     }
     kinematica_.Instantiate(init.JointGroup, model, object_name_);
+    kinematica_.SetNumThreads(init.KinematicsNumThreads, init.KinematicsParallelThreshold);
+    if (init.KinematicsBackend == "KDL")
+        kinematica_.SetKinematicsBackend(KINEMATICS_BACKEND_KDL);
+    else if (init.KinematicsBackend == "Pinocchio")
+        kinematica_.SetKinematicsBackend(KINEMATICS_BACKEND_PINOCCHIO);
+    else
+        ThrowNamed("Unknown kinematics backend '" << init.KinematicsBackend << "', expected KDL or Pinocchio");
+    if (init.CollisionNumThreads < 0) ThrowNamed("Invalid number of threads: " << init.CollisionNumThreads);
+    collision_num_threads_ = Server::ResolveNumThreads(init.CollisionNumThreads);
+    if (init.TrajectoryTimeResolution < 0.0) ThrowNamed("Invalid trajectory time resolution: " << init.TrajectoryTimeResolution);
+    trajectory_time_resolution_ = init.TrajectoryTimeResolution;
+    validity_workspaces_.clear();
     ps_.reset(new planning_scene::PlanningScene(model));
 
     // Write URDF/SRDF to ROS param server
@@ -104,6 +330,12 @@ void Scene::Instantiate(const SceneInitializer& init)
             HIGHLIGHT_NAMED(object_name_, "Running in debug mode, planning scene will be published to '" << Server::Instance()->GetName() << "/" << object_name_ << "/PlanningScene'");
     }
 
+    // Publish debug visualisation from a background thread at a limited rate
+    StopDebugPublisher();
+    debug_publish_period_ = (debug_ && Server::IsRos() && init.DebugPublishRate > 0.0) ? 1.0 / init.DebugPublishRate : 0.0;
+    kinematica_.publish_debug_frames = debug_publish_period_ == 0.0;
+    if (debug_publish_period_ > 0.0) StartDebugPublisher();
+
     // Note: Using the LoadScene initializer does not support custom offsets/poses, assumes Identity transform to world_frame
     if (init.LoadScene != "")
     {
@@ -138,7 +370,7 @@ void Scene::Instantiate(const SceneInitializer& init)
             {
                 MeshShapeInitializer mesh(link.Shape[0]);
                 // TODO: This will not support textures.
-                link_shape.reset(shapes::createMeshFromResource(ParsePath(mesh.MeshFilePath), mesh.Scale));
+                link_shape = Server::GetMesh(ParsePath(mesh.MeshFilePath), mesh.Scale);
             }
             else if (shape.Type == "Octree")
             {
@@ -226,23 +458,7 @@ void Scene::Instantiate(const SceneInitializer& init)
         }
     }
 
-    // Set up allowed collision matrix (i.e., collision pairs that are filtered/ignored)
-    AllowedCollisionMatrix acm;
-    std::vector<std::string> acm_names;
-    ps_->getAllowedCollisionMatrix().getAllEntryNames(acm_names);
-    for (auto& name1 : acm_names)
-    {
-        for (auto& name2 : acm_names)
-        {
-            collision_detection::AllowedCollision::Type type = collision_detection::AllowedCollision::Type::ALWAYS;
-            ps_->getAllowedCollisionMatrix().getAllowedCollision(name1, name2, type);
-            if (type == collision_detection::AllowedCollision::Type::ALWAYS)
-            {
-                acm.setEntry(name1, name2);
-            }
-        }
-    }
-    if (collision_scene_ != nullptr) collision_scene_->SetACM(acm);
+    UpdateAllowedCollisionMatrix();
 
     // Set up trajectory generators
     for (const exotica::Initializer& it : init.Trajectories)
@@ -267,6 +483,7 @@ void Scene::Instantiate(const SceneInitializer& init)
         // Create dynamics solver
         dynamics_solver_ = Setup::CreateDynamicsSolver(init.DynamicsSolver.at(0));
         dynamics_solver_->AssignScene(shared_from_this());
+        dynamics_solver_->scene_ = shared_from_this();
         dynamics_solver_->ns_ = ns_ + "/" + dynamics_solver_->GetObjectName();
 
         num_positions_ = dynamics_solver_->get_num_positions();
@@ -287,10 +504,54 @@ void Scene::Instantiate(const SceneInitializer& init)
     // Check if the system has a floating-base, and if so, if it contains a quaternion.
     // Will need to trigger special logic below to handle this (w.r.t. normalisation).
     has_quaternion_floating_base_ = (GetKinematicTree().GetModelBaseType() == BaseType::FLOATING && num_state_ == num_state_derivative_ + 1);
+    if (dynamics_solver_ != nullptr) dynamics_solver_->has_quaternion_floating_base_ = has_quaternion_floating_base_;
 
     if (debug_) INFO_NAMED(object_name_, "Exotica Scene initialized");
 }
 
+std::shared_ptr<Scene> Scene::Clone() const
+{
+    // Everything that is not part of the robot model is copied from this scene below instead of being reloaded from files.
+    SceneInitializer init(parameters_);
+    init.LoadScene = "";
+    init.Links.clear();
+    init.AttachLinks.clear();
+    init.Trajectories.clear();
+    // The debug publisher reads ps_ from its thread, it is only started once the clone is complete
+    init.DebugPublishRate = 0.0;
+
+    // The robot model is cached by the Server and thus shared between the clones.
+    std::shared_ptr<Scene> clone = std::make_shared<Scene>(object_name_);
+    clone->ns_ = ns_;
+    clone->Instantiate(init);
+    clone->parameters_ = parameters_;
+
+    // The MoveIt diff scene shares the world objects (and their shapes) with this scene until either of them gets modified.
+    clone->ps_ = ps_->diff();
+    clone->custom_links_ = custom_links_;
+    clone->attached_objects_ = attached_objects_;
+    clone->trajectory_generators_ = trajectory_generators_;
+    clone->UpdateSceneFrames();
+    clone->UpdateInternalFrames(false);
+
+    clone->kinematica_.SetModelState(kinematica_.GetModelStateMap());
+    if (clone->collision_scene_ != nullptr) clone->collision_scene_->UpdateCollisionObjectTransforms();
+
+    clone->debug_publish_period_ = debug_publish_period_;
+    clone->kinematica_.publish_debug_frames = kinematica_.publish_debug_frames;
+    if (clone->debug_publish_period_ > 0.0) clone->StartDebugPublisher();
+    return clone;
+}
+
+std::shared_ptr<Scene> Scene::CloneWorkspace() const
+{
+    std::shared_ptr<Scene> workspace = Clone();
+    workspace->StopDebugPublisher();
+    workspace->debug_ = false;
+    workspace->kinematica_.debug = false;
+    return workspace;
+}
+
 void Scene::RequestKinematics(KinematicsRequest& request, std::function<void(std::shared_ptr<KinematicResponse>)> callback)
 {
     kinematic_request_ = request;
@@ -302,23 +563,142 @@ void Scene::RequestKinematics(KinematicsRequest& request, std::function<void(std
 
 void Scene::UpdateTrajectoryGenerators(double t)
 {
+    // Bounds the memory used by generators queried at ever-changing times (e.g., in closed-loop control)
+    constexpr std::size_t max_cached_poses = 10000;
+
+    // Objects following trajectories are static within a time slice
+    if (trajectory_time_resolution_ > 0.0) t = std::round(t / trajectory_time_resolution_) * trajectory_time_resolution_;
+
     for (auto& it : trajectory_generators_)
     {
-        it.second.first.lock()->generated_offset = it.second.second->GetPosition(t);
+        TrajectoryPoseCache& cache = trajectory_pose_cache_[it.first];
+        if (cache.trajectory != it.second.second)
+        {
+            cache.trajectory = it.second.second;
+            cache.poses.clear();
+        }
+
+        auto pose = cache.poses.find(t);
+        if (pose == cache.poses.end())
+        {
+            if (cache.poses.size() >= max_cached_poses) cache.poses.clear();
+            pose = cache.poses.emplace(t, it.second.second->GetPosition(t)).first;
+        }
+        it.second.first.lock()->generated_offset = pose->second;
     }
 }
 
 void Scene::Update(Eigen::VectorXdRefConst x, double t)
 {
+    Update(x, Eigen::VectorXd(), t);
+}
+
+void Scene::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRefConst x_dot, double t)
+{
+    EXOTICA_PROFILE_SCOPE("Scene::Update");
     if (request_needs_updating_ && kinematic_request_callback_)
     {
         UpdateInternalFrames();
     }
 
     UpdateTrajectoryGenerators(t);
-    kinematica_.Update(x);
+    if (x_dot.size() == 0)
+        kinematica_.Update(x);
+    else
+        kinematica_.Update(x, x_dot);
+    NotifyChange(SCENE_CHANGE_STATE);
     if (force_collision_ && collision_scene_ != nullptr) collision_scene_->UpdateCollisionObjectTransforms();
-    if (debug_) PublishScene();
+    if (debug_) PublishDebugScene();
+}
+
+void Scene::UpdateTrajectory(const std::vector<Eigen::VectorXd>& x_trajectory, const std::vector<std::shared_ptr<KinematicResponse>>& responses, double tau, int t_begin)
+{
+    EXOTICA_PROFILE_SCOPE("Scene::UpdateTrajectory");
+    if (x_trajectory.size() != responses.size()) ThrowPretty("Number of states (" << x_trajectory.size() << ") does not match the number of kinematic responses (" << responses.size() << ")");
+    if (t_begin < 0 || t_begin > static_cast<int>(x_trajectory.size())) ThrowPretty("Invalid first time step " << t_begin << " for a trajectory of length " << x_trajectory.size());
+
+    if (request_needs_updating_ && kinematic_request_callback_)
+    {
+        UpdateInternalFrames();
+    }
+
+    for (int t = t_begin; t < static_cast<int>(x_trajectory.size()); ++t)
+    {
+        kinematica_.SetKinematicResponse(responses[t]);
+        UpdateTrajectoryGenerators(static_cast<double>(t) * tau);
+        kinematica_.Update(x_trajectory[t]);
+    }
+
+    NotifyChange(SCENE_CHANGE_STATE);
+    if (force_collision_ && collision_scene_ != nullptr) collision_scene_->UpdateCollisionObjectTransforms();
+    if (debug_) PublishDebugScene();
+}
+
+std::vector<bool> Scene::AreStatesValid(Eigen::MatrixXdRefConst states, bool self, double safe_distance, bool stop_at_first_invalid)
+{
+    if (collision_scene_ == nullptr) ThrowNamed("No CollisionScene has been instantiated.");
+    if (states.cols() != static_cast<int>(kinematica_.GetNumControlledJoints())) ThrowNamed("Wrong state dimension: " << states.cols() << ", expected " << kinematica_.GetNumControlledJoints());
+
+    const int num_states = static_cast<int>(states.rows());
+    const int num_threads = std::min(collision_num_threads_, num_states);
+    if (num_threads <= 1) return collision_scene_->AreStatesValid(states, self, safe_distance, stop_at_first_invalid);
+
+    UpdateValidityWorkspaces(num_threads);
+
+    // Each thread checks a contiguous block of states on its own clone. When stopping at the first invalid
+    // state, all states before the first invalid one found so far are still checked, hence the result does
+    // not depend on the number of threads.
+    std::vector<char> valid(num_states, false);  // std::vector<bool> can not be written concurrently
+    std::atomic<int> first_invalid(num_states);
+    ParallelLoop(num_threads, num_states, [&](int thread, int i) {
+        if (stop_at_first_invalid && i > first_invalid.load()) return;
+        Scene& workspace = *validity_workspaces_[thread];
+        workspace.Update(states.row(i).transpose());
+        valid[i] = workspace.collision_scene_->IsStateValid(self, safe_distance);
+        if (!valid[i] && stop_at_first_invalid)
+        {
+            int current = first_invalid.load();
+            while (i < current && !first_invalid.compare_exchange_weak(current, i))
+            {
+            }
+        }
+    });
+
+    std::vector<bool> ret(valid.begin(), valid.end());
+    if (stop_at_first_invalid) std::fill(ret.begin() + first_invalid.load(), ret.end(), false);
+    return ret;
+}
+
+Eigen::VectorXd Scene::GetMinimumCollisionDistances(Eigen::MatrixXdRefConst states, bool self, double check_margin)
+{
+    if (collision_scene_ == nullptr) ThrowNamed("No CollisionScene has been instantiated.");
+    if (states.cols() != static_cast<int>(kinematica_.GetNumControlledJoints())) ThrowNamed("Wrong state dimension: " << states.cols() << ", expected " << kinematica_.GetNumControlledJoints());
+
+    const int num_states = static_cast<int>(states.rows());
+    const int num_threads = std::max(1, std::min(collision_num_threads_, num_states));
+    if (num_threads > 1) UpdateValidityWorkspaces(num_threads);
+
+    Eigen::VectorXd distances(num_states);
+    ParallelLoop(num_threads, num_states, [&](int thread, int i) {
+        // Without clones, this scene is updated to each state in turn, as in AreStatesValid
+        Scene& workspace = num_threads > 1 ? *validity_workspaces_[thread] : *this;
+        workspace.Update(states.row(i).transpose());
+        double distance = std::numeric_limits<double>::infinity();
+        for (const CollisionProxy& proxy : workspace.collision_scene_->GetCollisionDistance(self, check_margin)) distance = std::min(distance, proxy.distance);
+        distances(i) = distance;
+    });
+    return distances;
+}
+
+void Scene::UpdateValidityWorkspaces(int num_workspaces)
+{
+    if (validity_workspaces_version_ != world_version_) validity_workspaces_.clear();
+    validity_workspaces_version_ = world_version_;
+    while (static_cast<int>(validity_workspaces_.size()) < num_workspaces) validity_workspaces_.push_back(CloneWorkspace());
+
+    // Joints that are not controlled may have been changed since
+    const std::map<std::string, double> model_state = kinematica_.GetModelStateMap();
+    for (int i = 0; i < num_workspaces; ++i) validity_workspaces_[i]->kinematica_.SetModelState(model_state);
 }
 
 void Scene::UpdateMoveItPlanningScene()
@@ -360,6 +740,112 @@ void Scene::PublishScene()
     }
 }
 
+void Scene::PublishDebugScene()
+{
+    if (debug_publish_period_ == 0.0)
+    {
+        PublishScene();
+        return;
+    }
+
+    // Rate limit: in between, updates only pay for reading the clock
+    if (debug_publish_timer_.GetDuration() < debug_publish_period_) return;
+    debug_publish_timer_.Reset();
+
+    // Take a lightweight snapshot, the messages are assembled and published by the background thread
+    std::unique_ptr<DebugSnapshot> snapshot(new DebugSnapshot());
+    snapshot->timestamp = ros::Time::now();
+    snapshot->root_frame_name = kinematica_.GetRootFrameName();
+    const std::vector<std::weak_ptr<KinematicElement>>& tree = kinematica_.GetTree();
+    snapshot->frame_names.reserve(tree.size());
+    snapshot->frames.reserve(tree.size());
+    for (std::size_t i = 1; i < tree.size(); ++i)
+    {
+        std::shared_ptr<KinematicElement> element = tree[i].lock();
+        if (!element) continue;
+        snapshot->frame_names.push_back(element->segment.getName());
+        snapshot->frames.push_back(element->frame);
+    }
+    snapshot->model_state = kinematica_.GetModelStateMap();
+    if (debug_published_world_version_ != world_version_)
+    {
+        // The full planning scene is only sent when the world changed, otherwise a robot state diff suffices
+        snapshot->planning_scene.reset(new moveit_msgs::PlanningScene(GetPlanningSceneMsg()));
+        debug_published_world_version_ = world_version_;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(debug_publisher_mutex_);
+        // Snapshots that have not been published yet are replaced, but a pending full planning scene is kept
+        if (debug_snapshot_ && debug_snapshot_->planning_scene && !snapshot->planning_scene) snapshot->planning_scene = std::move(debug_snapshot_->planning_scene);
+        debug_snapshot_ = std::move(snapshot);
+    }
+    debug_publisher_condition_.notify_one();
+}
+
+void Scene::StartDebugPublisher()
+{
+    debug_publisher_stop_ = false;
+    debug_published_world_version_ = -1;
+    debug_publisher_ = std::thread(&Scene::DebugPublisherLoop, this);
+}
+
+void Scene::StopDebugPublisher()
+{
+    if (!debug_publisher_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(debug_publisher_mutex_);
+        debug_publisher_stop_ = true;
+    }
+    debug_publisher_condition_.notify_one();
+    debug_publisher_.join();
+    debug_snapshot_.reset();
+}
+
+void Scene::DebugPublisherLoop()
+{
+    std::unique_lock<std::mutex> lock(debug_publisher_mutex_);
+    while (true)
+    {
+        debug_publisher_condition_.wait(lock, [this] { return debug_publisher_stop_ || debug_snapshot_; });
+        if (debug_publisher_stop_) return;
+        std::unique_ptr<DebugSnapshot> snapshot = std::move(debug_snapshot_);
+        lock.unlock();
+
+        const std::string root_frame_name = tf::resolve("exotica", snapshot->root_frame_name);
+        std::vector<tf::StampedTransform> transforms;
+        transforms.reserve(snapshot->frames.size());
+        for (std::size_t i = 0; i < snapshot->frames.size(); ++i)
+        {
+            tf::Transform T;
+            tf::transformKDLToTF(snapshot->frames[i], T);
+            transforms.emplace_back(T, snapshot->timestamp, root_frame_name, tf::resolve("exotica", snapshot->frame_names[i]));
+        }
+        Server::SendTransform(transforms);
+
+        if (snapshot->planning_scene)
+        {
+            ps_pub_.publish(*snapshot->planning_scene);
+        }
+        else
+        {
+            moveit_msgs::PlanningScene msg;
+            msg.name = ps_->getName();
+            msg.is_diff = true;
+            msg.robot_state.is_diff = true;
+            msg.robot_state.joint_state.header.stamp = snapshot->timestamp;
+            for (const auto& joint : snapshot->model_state)
+            {
+                msg.robot_state.joint_state.name.push_back(joint.first);
+                msg.robot_state.joint_state.position.push_back(joint.second);
+            }
+            ps_pub_.publish(msg);
+        }
+
+        lock.lock();
+    }
+}
+
 void Scene::PublishProxies(const std::vector<CollisionProxy>& proxies)
 {
     if (Server::IsRos())
@@ -404,22 +890,234 @@ visualization_msgs::Marker Scene::ProxyToMarker(const std::vector<CollisionProxy
     return ret;
 }
 
+// Whether the diff only modifies world collision objects, i.e., the robot state, ACM, padding, etc. are left unchanged.
+static bool IsWorldObjectDiff(const moveit_msgs::PlanningScene& scene)
+{
+    return scene.is_diff && scene.robot_state.is_diff && scene.robot_state.joint_state.name.empty() &&
+           scene.robot_state.multi_dof_joint_state.joint_names.empty() && scene.robot_state.attached_collision_objects.empty() &&
+           scene.fixed_frame_transforms.empty() && scene.allowed_collision_matrix.entry_names.empty() &&
+           scene.link_padding.empty() && scene.link_scale.empty() && scene.object_colors.empty() &&
+           scene.world.octomap.octomap.data.empty();
+}
+
 void Scene::UpdatePlanningScene(const moveit_msgs::PlanningScene& scene)
 {
-    ps_->usePlanningSceneMsg(scene);
-    UpdateSceneFrames();
-    UpdateInternalFrames();
+    Timer timer;
+    if (!IsWorldObjectDiff(scene) || !UpdateWorldObjects(scene.world.collision_objects))
+    {
+        ps_->usePlanningSceneMsg(scene);
+        UpdateSceneFrames();
+        UpdateInternalFrames();
+        if (!scene.is_diff || !scene.allowed_collision_matrix.entry_names.empty()) UpdateAllowedCollisionMatrix();
+    }
+    last_planning_scene_update_duration_ = timer.GetDuration();
+    if (debug_) HIGHLIGHT_NAMED(object_name_, "Planning scene update took " << last_planning_scene_update_duration_ << "s");
 }
 
 void Scene::UpdatePlanningSceneWorld(const moveit_msgs::PlanningSceneWorldConstPtr& world)
 {
-    ps_->processPlanningSceneWorldMsg(*world);
-    UpdateSceneFrames();
-    UpdateInternalFrames();
+    Timer timer;
+    if (!world->octomap.octomap.data.empty() || !UpdateWorldObjects(world->collision_objects))
+    {
+        ps_->processPlanningSceneWorldMsg(*world);
+        UpdateSceneFrames();
+        UpdateInternalFrames();
+    }
+    last_planning_scene_update_duration_ = timer.GetDuration();
+    if (debug_) HIGHLIGHT_NAMED(object_name_, "Planning scene world update took " << last_planning_scene_update_duration_ << "s");
+}
+
+bool Scene::UpdateWorldObjects(const std::vector<moveit_msgs::CollisionObject>& objects)
+{
+    // World objects are added, removed and moved one by one. Appending shapes, removing all objects, or changing objects
+    // which other parts of the scene depend on (e.g., attached objects or requested frames) requires rebuilding the world.
+    if (objects.empty()) return false;
+    const auto& tree_map = kinematica_.GetTreeMap();
+    for (const moveit_msgs::CollisionObject& object : objects)
+    {
+        if (object.id.empty() || HasAttachedObject(object.id)) return false;
+        const bool exists = ps_->getWorld()->hasObject(object.id);
+        switch (object.operation)
+        {
+            case moveit_msgs::CollisionObject::ADD:
+                if (object.primitives.empty() && object.meshes.empty() && object.planes.empty()) return false;
+                break;
+            case moveit_msgs::CollisionObject::REMOVE:
+            case moveit_msgs::CollisionObject::MOVE:
+                if (!exists) return false;
+                break;
+            default:
+                return false;
+        }
+        if (!exists) continue;
+
+        // The element of the object has to be attached to the root
+        const auto& it = tree_map.find(object.id);
+        if (it == tree_map.end() || it->second.expired()) return false;
+        std::shared_ptr<KinematicElement> element = it->second.lock();
+        if (element->is_trajectory_generated || element->parent.lock()->segment.getName() != kinematica_.GetRootFrameName()) return false;
+        if (object.operation == moveit_msgs::CollisionObject::MOVE) continue;
+
+        // Removed objects may only have their collision shapes as children and must not be used elsewhere
+        std::vector<std::string> names = {object.id};
+        for (const std::weak_ptr<KinematicElement>& child : element->children)
+        {
+            if (child.expired()) continue;
+            if (!child.lock()->shape || !child.lock()->children.empty()) return false;
+            names.push_back(child.lock()->segment.getName());
+        }
+        for (const std::string& name : names)
+        {
+            if (trajectory_generators_.count(name) > 0) return false;
+            for (const KinematicFrameRequest& frame : kinematic_request_.frames)
+            {
+                if (frame.frame_A_link_name == name || frame.frame_B_link_name == name) return false;
+            }
+        }
+    }
+
+    std::map<std::string, std::weak_ptr<KinematicElement>> added;
+    std::vector<std::string> removed;
+    for (const moveit_msgs::CollisionObject& object : objects)
+    {
+        const bool exists = ps_->getWorld()->hasObject(object.id);
+        if (!ps_->processCollisionObjectMsg(object)) ThrowPretty("Failed to process collision object '" << object.id << "'");
+
+        if (object.operation == moveit_msgs::CollisionObject::MOVE)
+        {
+            // Use the first collision shape as the origin of the object (see AddWorldObjectElements). The poses of
+            // the collision shapes relative to the origin do not change when moving the object.
+            const auto& shape_pose = ps_->getWorld()->getObject(object.id)->shape_poses_[0];
+            Eigen::Isometry3d obj_transform;
+            obj_transform.translation() = shape_pose.translation();
+            obj_transform.linear() = shape_pose.rotation();
+            KDL::Frame pose;
+            tf::transformEigenToKDL(obj_transform, pose);
+            kinematica_.SetElementPose(object.id, pose);
+            continue;
+        }
+
+        // Removing the object, or replacing it when adding an existing one
+        if (exists)
+        {
+            for (const std::weak_ptr<KinematicElement>& child : kinematica_.GetTreeMap().at(object.id).lock()->children)
+            {
+                if (child.expired()) continue;
+                const std::string& name = child.lock()->segment.getName();
+                // Shapes added by this diff do not have collision objects yet
+                if (added.erase(name) == 0) removed.push_back(name);
+            }
+            kinematica_.RemoveEnvironmentElement(object.id);
+        }
+
+        if (object.operation == moveit_msgs::CollisionObject::ADD)
+        {
+            std::shared_ptr<KinematicElement> element = AddWorldObjectElements(object.id, *ps_->getWorld()->getObject(object.id));
+            for (const std::weak_ptr<KinematicElement>& child : element->children) added[child.lock()->segment.getName()] = child;
+        }
+    }
+
+    // Only the added and moved elements are computed, the requested frames are updated with the next state update
+    kinematica_.UpdateModel();
+    if (collision_scene_ != nullptr)
+    {
+        if (!removed.empty()) collision_scene_->RemoveCollisionObjects(removed);
+        if (!added.empty()) collision_scene_->AddCollisionObjects(added);
+        collision_scene_->UpdateCollisionObjectTransforms();
+    }
+    NotifyChange(SCENE_CHANGE_WORLD);
+    if (debug_) HIGHLIGHT_NAMED(object_name_, "Updated " << objects.size() << " world objects in place");
+    return true;
+}
+
+void Scene::UpdateAllowedCollisionMatrix()
+{
+    // Set up allowed collision matrix (i.e., collision pairs that are filtered/ignored)
+    AllowedCollisionMatrix acm;
+    std::vector<std::string> acm_names;
+    ps_->getAllowedCollisionMatrix().getAllEntryNames(acm_names);
+    for (auto& name1 : acm_names)
+    {
+        for (auto& name2 : acm_names)
+        {
+            collision_detection::AllowedCollision::Type type = collision_detection::AllowedCollision::Type::ALWAYS;
+            ps_->getAllowedCollisionMatrix().getAllowedCollision(name1, name2, type);
+            if (type == collision_detection::AllowedCollision::Type::ALWAYS)
+            {
+                acm.setEntry(name1, name2);
+            }
+        }
+    }
+    if (collision_scene_ != nullptr) collision_scene_->SetACM(acm);
+    NotifyChange(SCENE_CHANGE_ACM);
+}
+
+int Scene::GetVersion(SceneChange change) const
+{
+    switch (change)
+    {
+        case SCENE_CHANGE_STATE:
+            return state_version_;
+        case SCENE_CHANGE_WORLD:
+            return world_objects_version_;
+        case SCENE_CHANGE_ATTACHMENTS:
+            return attachment_version_;
+        case SCENE_CHANGE_ACM:
+            return acm_version_;
+        case SCENE_CHANGE_TRAJECTORIES:
+            return trajectory_version_;
+    }
+    ThrowPretty("Unknown scene change " << static_cast<int>(change));
+}
+
+int Scene::AddChangeListener(std::function<void(SceneChange)> callback, int changes)
+{
+    if (!callback) ThrowPretty("Invalid change listener callback!");
+    const int handle = next_change_listener_++;
+    change_listeners_[handle] = {changes, std::move(callback)};
+    return handle;
+}
+
+void Scene::RemoveChangeListener(int handle)
+{
+    change_listeners_.erase(handle);
+}
+
+void Scene::NotifyChange(SceneChange change)
+{
+    switch (change)
+    {
+        case SCENE_CHANGE_STATE:
+            ++state_version_;
+            break;
+        case SCENE_CHANGE_WORLD:
+            ++world_objects_version_;
+            break;
+        case SCENE_CHANGE_ATTACHMENTS:
+            ++attachment_version_;
+            break;
+        case SCENE_CHANGE_ACM:
+            ++acm_version_;
+            break;
+        case SCENE_CHANGE_TRAJECTORIES:
+            ++trajectory_version_;
+            break;
+    }
+    // Clones and caches built from the world depend on all but the state
+    if (change != SCENE_CHANGE_STATE) ++world_version_;
+
+    if (change_listeners_.empty()) return;
+    // Copy, so listeners can remove themselves
+    const auto listeners = change_listeners_;
+    for (const auto& listener : listeners)
+    {
+        if (listener.second.changes & change) listener.second.callback(change);
+    }
 }
 
 void Scene::UpdateCollisionObjects()
 {
+    NotifyChange(SCENE_CHANGE_STATE);
     if (collision_scene_ != nullptr) collision_scene_->UpdateCollisionObjects(kinematica_.GetCollisionTreeMap());
 }
 
@@ -557,8 +1255,9 @@ void Scene::SetModelState(Eigen::VectorXdRefConst x, double t, bool update_traj)
     // Update Kinematica internal state
     kinematica_.SetModelState(x);
 
+    NotifyChange(SCENE_CHANGE_STATE);
     if (force_collision_ && collision_scene_ != nullptr) collision_scene_->UpdateCollisionObjectTransforms();
-    if (debug_) PublishScene();
+    if (debug_) PublishDebugScene();
 }
 
 void Scene::SetModelState(const std::map<std::string, double>& x, double t, bool update_traj)
@@ -572,8 +1271,9 @@ void Scene::SetModelState(const std::map<std::string, double>& x, double t, bool
     // Update Kinematica internal state
     kinematica_.SetModelState(x);
 
+    NotifyChange(SCENE_CHANGE_STATE);
     if (force_collision_ && collision_scene_ != nullptr) collision_scene_->UpdateCollisionObjectTransforms();
-    if (debug_) PublishScene();
+    if (debug_) PublishDebugScene();
 }
 
 Eigen::VectorXd Scene::GetControlledState()
@@ -603,11 +1303,118 @@ void Scene::LoadSceneFile(const std::string& file_name, const KDL::Frame& offset
 
 void Scene::LoadSceneFile(const std::string& file_name, const Eigen::Isometry3d& offset, bool update_collision_scene)
 {
-    std::ifstream ss(ParsePath(file_name));
-    if (!ss.is_open()) ThrowPretty("Cant read file '" << ParsePath(file_name) << "'!");
+    const std::string path = ParsePath(file_name);
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) ThrowPretty("Cant read file '" << path << "'!");
+    struct stat file_stat;
+    const std::size_t size = fstat(fd, &file_stat) == 0 ? static_cast<std::size_t>(file_stat.st_size) : 0;
+    void* mapping = size >= sizeof(kSceneSnapshotMagic) ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);  // The mapping stays valid
+
+    // Binary snapshots (see SaveSceneSnapshot) are recognised by their magic number and read from the mapping
+    if (mapping != MAP_FAILED)
+    {
+        const char* data = static_cast<const char*>(mapping);
+        if (std::memcmp(data, kSceneSnapshotMagic, sizeof(kSceneSnapshotMagic)) == 0)
+        {
+            try
+            {
+                LoadSceneSnapshot(data, size, offset, update_collision_scene);
+            }
+            catch (...)
+            {
+                munmap(mapping, size);
+                throw;
+            }
+            munmap(mapping, size);
+            return;
+        }
+        munmap(mapping, size);
+    }
+
+    std::ifstream ss(path);
+    if (!ss.is_open()) ThrowPretty("Cant read file '" << path << "'!");
     LoadSceneFromStringStream(ss, offset, update_collision_scene);
 }
 
+void Scene::SaveSceneSnapshot(const std::string& file_name)
+{
+    SceneSnapshotWriter out;
+    out.Write(kSceneSnapshotMagic, sizeof(kSceneSnapshotMagic));
+    out.Write<uint32_t>(kSceneSnapshotVersion);
+    out.Write<uint32_t>(kSceneSnapshotByteOrder);
+
+    std::vector<collision_detection::World::ObjectConstPtr> objects;
+    for (const auto& object : *ps_->getWorld())
+    {
+        for (const shapes::ShapeConstPtr& shape : object.second->shapes_)
+        {
+            if (!IsSnapshotShapeType(shape->type)) ThrowPretty("Object '" << object.first << "' contains a shape of type " << static_cast<int>(shape->type) << " which is not supported by scene snapshots");
+        }
+        objects.push_back(object.second);
+    }
+
+    out.Write<uint32_t>(objects.size());
+    for (const auto& object : objects)
+    {
+        out.WriteString(object->id_);
+        Eigen::Vector4f color = Eigen::Vector4f::Zero();
+        const bool has_color = ps_->hasObjectColor(object->id_);
+        if (has_color)
+        {
+            const std_msgs::ColorRGBA color_msg = ps_->getObjectColor(object->id_);
+            color << color_msg.r, color_msg.g, color_msg.b, color_msg.a;
+        }
+        out.Write<uint32_t>(has_color);
+        out.Write<uint32_t>(object->shapes_.size());
+        out.Write(color.data(), sizeof(float) * 4);
+        for (std::size_t i = 0; i < object->shapes_.size(); ++i)
+        {
+            Eigen::Matrix<double, 3, 4> pose;
+            pose.leftCols<3>() = object->shape_poses_[i].rotation();
+            pose.col(3) = object->shape_poses_[i].translation();
+            out.Write(pose.data(), sizeof(double) * 12);
+            out.WriteShape(*object->shapes_[i]);
+        }
+    }
+
+    std::ofstream file(ParsePath(file_name), std::ios::binary);
+    if (!file.is_open()) ThrowPretty("Cant write file '" << ParsePath(file_name) << "'!");
+    file.write(out.buffer.data(), out.buffer.size());
+}
+
+void Scene::LoadSceneSnapshot(const char* data, std::size_t size, const Eigen::Isometry3d& offset, bool update_collision_scene)
+{
+    SceneSnapshotReader in(data, size);
+    in.Skip(sizeof(kSceneSnapshotMagic));
+    in.version = in.Read<uint32_t>();
+    if (in.version < 1 || in.version > kSceneSnapshotVersion) ThrowPretty("Unsupported scene snapshot version " << in.version << ", expected at most " << kSceneSnapshotVersion);
+    if (in.Read<uint32_t>() != kSceneSnapshotByteOrder) ThrowPretty("The scene snapshot was written on a machine with a different byte order");
+
+    const uint32_t num_objects = in.Read<uint32_t>();
+    for (uint32_t n = 0; n < num_objects; ++n)
+    {
+        const std::string name = in.ReadString();
+        const uint32_t has_color = in.Read<uint32_t>();
+        const uint32_t num_shapes = in.Read<uint32_t>();
+        float color[4];
+        in.Read(color, sizeof(color));
+        for (uint32_t i = 0; i < num_shapes; ++i)
+        {
+            Eigen::Matrix<double, 3, 4> pose_data;
+            in.Read(pose_data.data(), sizeof(double) * 12);
+            Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+            pose.linear() = pose_data.leftCols<3>();
+            pose.translation() = pose_data.col(3);
+            ps_->getWorldNonConst()->addToObject(name, in.ReadShape(), offset * pose);
+        }
+        if (has_color) ps_->setObjectColor(name, GetColor(color[0], color[1], color[2], color[3]));
+    }
+
+    UpdateSceneFrames();
+    if (update_collision_scene) UpdateInternalFrames();
+}
+
 void Scene::LoadSceneFromStringStream(std::istream& in, const Eigen::Isometry3d& offset, bool update_collision_scene)
 {
 #if ROS_VERSION_MINIMUM(1, 14, 0)  // if ROS version >= ROS_MELODIC
@@ -655,9 +1462,10 @@ void Scene::UpdateInternalFrames(bool update_request)
         AddTrajectory(traj.first, traj.second.second);
     }
 
+    // The collision objects are recreated below
     for (auto& link : attached_objects_)
     {
-        AttachObjectLocal(link.first, link.second.parent, link.second.pose);
+        kinematica_.ChangeParent(link.first, link.second.parent, link.second.pose, true);
     }
 
     kinematica_.UpdateModel();
@@ -671,6 +1479,42 @@ void Scene::UpdateInternalFrames(bool update_request)
     UpdateCollisionObjects();
 
     request_needs_updating_ = false;
+    NotifyChange(SCENE_CHANGE_WORLD);
+}
+
+std::shared_ptr<KinematicElement> Scene::AddWorldObjectElements(const std::string& name, const collision_detection::World::Object& object)
+{
+    // Use the first collision shape as the origin of the object
+    Eigen::Isometry3d obj_transform;
+    obj_transform.translation() = object.shape_poses_[0].translation();
+    obj_transform.linear() = object.shape_poses_[0].rotation();
+    std::shared_ptr<KinematicElement> element = kinematica_.AddEnvironmentElement(name, obj_transform);
+    std::vector<VisualElement> visuals;
+    for (std::size_t i = 0; i < object.shape_poses_.size(); ++i)
+    {
+        Eigen::Isometry3d shape_transform;
+        shape_transform.translation() = object.shape_poses_[i].translation();
+        shape_transform.linear() = object.shape_poses_[i].rotation();
+        Eigen::Isometry3d trans = obj_transform.inverse() * shape_transform;
+        VisualElement visual;
+        // Avoid name duplicates after loading from scene files
+        visual.name = i == 0 ? name : name + "_" + std::to_string(i);
+        visual.shape = shapes::ShapePtr(object.shapes_[i]->clone());
+        tf::transformEigenToKDL(trans, visual.frame);
+        if (ps_->hasObjectColor(name))
+        {
+            auto color_msg = ps_->getObjectColor(name);
+            visual.color = Eigen::Vector4d(color_msg.r, color_msg.g, color_msg.b, color_msg.a);
+            kinematica_.AddEnvironmentElement(name + "_collision_" + std::to_string(i), trans, name, object.shapes_[i], KDL::RigidBodyInertia::Zero(), visual.color);
+        }
+        else
+        {
+            kinematica_.AddEnvironmentElement(name + "_collision_" + std::to_string(i), trans, name, object.shapes_[i]);
+        }
+        if (visual.shape) visuals.push_back(visual);
+    }
+    element->visual = visuals;
+    return element;
 }
 
 void Scene::UpdateSceneFrames()
@@ -678,52 +1522,11 @@ void Scene::UpdateSceneFrames()
     kinematica_.ResetModel();
 
     // Add world objects
-    std::map<std::string, int> visual_map;
     for (const auto& object : *ps_->getWorld())
     {
         if (object.second->shapes_.size())
         {
-            // Use the first collision shape as the origin of the object
-            Eigen::Isometry3d obj_transform;
-            obj_transform.translation() = object.second->shape_poses_[0].translation();
-            obj_transform.linear() = object.second->shape_poses_[0].rotation();
-            std::shared_ptr<KinematicElement> element = kinematica_.AddEnvironmentElement(object.first, obj_transform);
-            std::vector<VisualElement> visuals;
-            for (int i = 0; i < object.second->shape_poses_.size(); ++i)
-            {
-                Eigen::Isometry3d shape_transform;
-                shape_transform.translation() = object.second->shape_poses_[i].translation();
-                shape_transform.linear() = object.second->shape_poses_[i].rotation();
-                Eigen::Isometry3d trans = obj_transform.inverse() * shape_transform;
-                VisualElement visual;
-                std::string name = object.first;
-                // Check for name duplicates after loading from scene files
-                const auto& it = visual_map.find(name);
-                if (it != visual_map.end())
-                {
-                    it->second++;
-                    name = name + "_" + std::to_string(it->second);
-                }
-                else
-                {
-                    visual_map[name] = 0;
-                }
-                visual.name = name;
-                visual.shape = shapes::ShapePtr(object.second->shapes_[i]->clone());
-                tf::transformEigenToKDL(trans, visual.frame);
-                if (ps_->hasObjectColor(object.first))
-                {
-                    auto color_msg = ps_->getObjectColor(object.first);
-                    visual.color = Eigen::Vector4d(color_msg.r, color_msg.g, color_msg.b, color_msg.a);
-                    kinematica_.AddEnvironmentElement(object.first + "_collision_" + std::to_string(i), trans, object.first, object.second->shapes_[i], KDL::RigidBodyInertia::Zero(), visual.color);
-                }
-                else
-                {
-                    kinematica_.AddEnvironmentElement(object.first + "_collision_" + std::to_string(i), trans, object.first, object.second->shapes_[i]);
-                }
-                if (visual.shape) visuals.push_back(visual);
-            }
-            element->visual = visuals;
+            AddWorldObjectElements(object.first, *object.second);
         }
         else
         {
@@ -798,6 +1601,7 @@ void Scene::UpdateSceneFrames()
     kinematica_.UpdateModel();
 
     request_needs_updating_ = true;
+    NotifyChange(SCENE_CHANGE_WORLD);
 }
 
 void Scene::AddObject(const std::string& name, const KDL::Frame& transform, const std::string& parent, shapes::ShapeConstPtr shape, const KDL::RigidBodyInertia& inertia, const Eigen::Vector4d& color, bool update_collision_scene)
@@ -858,16 +1662,67 @@ void Scene::RemoveObject(const std::string& name)
     ThrowPretty("Link " << name << " not removed as it cannot be found.");
 }
 
+void Scene::UpdateOctree(const std::string& name, const std::vector<Eigen::Vector3d>& occupied_points, const std::vector<Eigen::Vector3d>& free_points)
+{
+    // Objects from the planning scene world have their shapes in child elements
+    std::map<std::string, std::weak_ptr<KinematicElement>> objects;
+    for (const auto& object : kinematica_.GetCollisionTreeMap())
+    {
+        std::shared_ptr<KinematicElement> element = object.second.lock();
+        if (!element || !element->shape || element->shape->type != shapes::OCTREE) continue;
+        std::shared_ptr<KinematicElement> parent = element->parent.lock();
+        if (object.first == name || (parent && parent->segment.getName() == name)) objects.insert(object);
+    }
+    if (objects.empty()) ThrowPretty("Can't find an octree for object '" << name << "'!");
+
+    for (const auto& object : objects)
+    {
+        // The octomap is shared with the collision scene (and the planning scene), so the leaves are changed in place
+        octomap::OcTree& octree = const_cast<octomap::OcTree&>(*static_cast<const shapes::OcTree&>(*object.second.lock()->shape).octree);
+        for (const Eigen::Vector3d& point : occupied_points) octree.setNodeValue(point.x(), point.y(), point.z(), octree.getClampingThresMaxLog(), true);
+        for (const Eigen::Vector3d& point : free_points) octree.setNodeValue(point.x(), point.y(), point.z(), octree.getClampingThresMinLog(), true);
+        octree.updateInnerOccupancy();
+    }
+
+    // The leaves changed in place without a change of the state, so the cached queries are discarded explicitly
+    if (collision_scene_ != nullptr)
+    {
+        collision_scene_->UpdateOctreeCollisionObjects(objects);
+        collision_scene_->InvalidateQueryCache();
+    }
+
+    // The validity workspaces share the octree but have their own collision scenes, they are updated in place instead of being recreated
+    const bool validity_workspaces_current = validity_workspaces_version_ == world_version_;
+    for (const std::shared_ptr<Scene>& workspace : validity_workspaces_)
+    {
+        if (workspace->collision_scene_ == nullptr) continue;
+        std::map<std::string, std::weak_ptr<KinematicElement>> workspace_objects;
+        for (const auto& object : objects)
+        {
+            const auto& it = workspace->kinematica_.GetCollisionTreeMap().find(object.first);
+            if (it != workspace->kinematica_.GetCollisionTreeMap().end()) workspace_objects.insert(*it);
+        }
+        workspace->collision_scene_->UpdateOctreeCollisionObjects(workspace_objects);
+        workspace->collision_scene_->InvalidateQueryCache();
+    }
+
+    // Caches and clones keyed on the world version see the new occupancy, the full planning scene is sent with the next debug snapshot
+    NotifyChange(SCENE_CHANGE_WORLD);
+    if (validity_workspaces_current) validity_workspaces_version_ = world_version_;
+}
+
 void Scene::AttachObject(const std::string& name, const std::string& parent)
 {
     kinematica_.ChangeParent(name, parent, KDL::Frame::Identity(), false);
     attached_objects_[name] = AttachedObject(parent);
+    UpdateReattachedCollisionObjects(name);
 }
 
 void Scene::AttachObjectLocal(const std::string& name, const std::string& parent, const KDL::Frame& pose)
 {
     kinematica_.ChangeParent(name, parent, pose, true);
     attached_objects_[name] = AttachedObject(parent, pose);
+    UpdateReattachedCollisionObjects(name);
 }
 
 void Scene::AttachObjectLocal(const std::string& name, const std::string& parent, const Eigen::VectorXd& pose)
@@ -881,6 +1736,28 @@ void Scene::DetachObject(const std::string& name)
     auto object = attached_objects_.find(name);
     kinematica_.ChangeParent(name, "", KDL::Frame::Identity(), false);
     attached_objects_.erase(object);
+    UpdateReattachedCollisionObjects(name);
+}
+
+void Scene::UpdateReattachedCollisionObjects(const std::string& name)
+{
+    NotifyChange(SCENE_CHANGE_ATTACHMENTS);
+    if (collision_scene_ == nullptr) return;
+
+    // Collect the collision elements below the re-attached element, all other collision objects are unaffected
+    std::map<std::string, std::weak_ptr<KinematicElement>> objects;
+    for (const auto& object : kinematica_.GetCollisionTreeMap())
+    {
+        for (std::shared_ptr<KinematicElement> element = object.second.lock(); element; element = element->parent.lock())
+        {
+            if (element->segment.getName() == name)
+            {
+                objects.insert(object);
+                break;
+            }
+        }
+    }
+    collision_scene_->UpdateReattachedCollisionObjects(objects);
 }
 
 bool Scene::HasAttachedObject(const std::string& name)
@@ -905,7 +1782,11 @@ void Scene::AddTrajectory(const std::string& link, std::shared_ptr<Trajectory> t
     if (it == tree.end()) ThrowPretty("Can't find link '" << link << "'!");
     if (traj->GetDuration() == 0.0) ThrowPretty("The trajectory is empty!");
     trajectory_generators_[link] = std::pair<std::weak_ptr<KinematicElement>, std::shared_ptr<Trajectory>>(it->second, traj);
+    const auto& cache = trajectory_pose_cache_.find(link);
+    if (cache != trajectory_pose_cache_.end() && cache->second.trajectory != traj) trajectory_pose_cache_.erase(cache);
     it->second.lock()->is_trajectory_generated = true;
+    kinematica_.RequestFullTreeUpdate();
+    NotifyChange(SCENE_CHANGE_TRAJECTORIES);
 }
 
 std::shared_ptr<Trajectory> Scene::GetTrajectory(const std::string& link)
@@ -921,6 +1802,9 @@ void Scene::RemoveTrajectory(const std::string& link)
     if (it == trajectory_generators_.end()) ThrowPretty("No trajectory generator defined for link '" << link << "'!");
     it->second.first.lock()->is_trajectory_generated = false;
     trajectory_generators_.erase(it);
+    trajectory_pose_cache_.erase(link);
+    kinematica_.RequestFullTreeUpdate();
+    NotifyChange(SCENE_CHANGE_TRAJECTORIES);
 }
 
 int Scene::get_num_positions() const
@@ -27,11 +27,19 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <algorithm>
 #include <boost/any.hpp>
+#include <sstream>
+#include <thread>
 #include <typeinfo>
 
+#include <geometric_shapes/mesh_operations.h>
+#include <kdl_parser/kdl_parser.hpp>
+
+#include <exotica_core/loaders/initializer_serialization.h>
 #include <exotica_core/server.h>
 #include <exotica_core/tools.h>
+#include <exotica_core/tools/parallel_loop.h>
 
 exotica::ServerPtr exotica::Server::singleton_server_ = nullptr;
 namespace exotica
@@ -59,6 +67,40 @@ void Server::Destroy()
     exotica::Server::singleton_server_.reset();
 }
 
+ThreadPool& Server::GetThreadPool()
+{
+    std::shared_ptr<Server> server = Instance();
+    std::lock_guard<std::mutex> lock(server->thread_pool_mutex_);
+    // The calling thread takes part in parallel loops, the pool holds the others
+    if (!server->thread_pool_) server->thread_pool_.reset(new ThreadPool(ResolveNumThreads(0) - 1, server->thread_pool_pin_threads_, server->thread_pool_deterministic_));
+    return *server->thread_pool_;
+}
+
+void ParallelForOnServerThreadPool(int num_blocks, const std::function<void(int)>& block)
+{
+    Server::GetThreadPool().ParallelFor(0, num_blocks, block);
+}
+
+void Server::ConfigureThreadPool(int num_threads, bool pin_threads, bool deterministic)
+{
+    if (num_threads < 0) ThrowPretty("The number of threads has to be non-negative, given: " << num_threads);
+    std::shared_ptr<Server> server = Instance();
+    std::lock_guard<std::mutex> lock(server->thread_pool_mutex_);
+    server->thread_pool_.reset();
+    server->thread_pool_num_threads_ = num_threads;
+    server->thread_pool_pin_threads_ = pin_threads;
+    server->thread_pool_deterministic_ = deterministic;
+}
+
+int Server::ResolveNumThreads(int num_threads)
+{
+    std::shared_ptr<Server> server = Instance();
+    if (server->thread_pool_deterministic_) return 1;
+    if (num_threads > 0) return num_threads;
+    if (server->thread_pool_num_threads_ > 0) return server->thread_pool_num_threads_;
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - server->ros_num_threads_);
+}
+
 robot_model::RobotModelPtr LoadModelImpl(const std::string& urdf, const std::string& srdf)
 {
     rdf_loader::RDFLoader loader(urdf, srdf);
@@ -101,17 +143,17 @@ robot_model::RobotModelPtr Server::LoadModel(const std::string& name, const std:
     // URDF and SRDF are meant to be read from files
     else if (PathExists(urdf) && PathExists(srdf))
     {
-        model = LoadModelImpl(LoadFile(urdf), LoadFile(srdf));
+        model = LoadModelFromContent(LoadFile(urdf), LoadFile(srdf));
     }
     // URDF loaded from file, SRDF empty
     else if (PathExists(urdf) && srdf == "")
     {
-        model = LoadModelImpl(LoadFile(urdf), srdf);
+        model = LoadModelFromContent(LoadFile(urdf), srdf);
     }
     // URDF and SRDF are passed in as strings
     else if (urdf != "" && srdf != "")
     {
-        model = LoadModelImpl(urdf, srdf);
+        model = LoadModelFromContent(urdf, srdf);
     }
 
     if (model)
@@ -125,9 +167,22 @@ robot_model::RobotModelPtr Server::LoadModel(const std::string& name, const std:
     return model;
 }
 
+robot_model::RobotModelPtr Server::LoadModelFromContent(const std::string& urdf, const std::string& srdf)
+{
+    // Scenes loading the same files (or strings) share the model, e.g., the same URDF with different SRDFs does not
+    const std::uint64_t key = HashContent(srdf, HashContent(std::string(1, '\0'), HashContent(urdf)));
+    auto it = robot_models_by_content_.find(key);
+    if (it != robot_models_by_content_.end()) return it->second;
+    robot_model::RobotModelPtr model = LoadModelImpl(urdf, srdf);
+    robot_models_by_content_[key] = model;
+    return model;
+}
+
 void Server::GetModel(const std::string& path, robot_model::RobotModelPtr& model, const std::string& urdf, const std::string& srdf)
 {
-    if (robot_models_.find(path) != robot_models_.end())
+    std::lock_guard<std::mutex> lock(model_cache_mutex_);
+    // Models given as URDF/SRDF are looked up by their content in LoadModel
+    if (urdf == "" && srdf == "" && robot_models_.find(path) != robot_models_.end())
     {
         model = robot_models_[path];
     }
@@ -139,21 +194,51 @@ void Server::GetModel(const std::string& path, robot_model::RobotModelPtr& model
 
 robot_model::RobotModelConstPtr Server::GetModel(const std::string& path, const std::string& urdf, const std::string& srdf)
 {
-    if (robot_models_.count(path))
-    {
-        return robot_models_[path];
-    }
-    else
-    {
-        return LoadModel(path, urdf, srdf);
-    }
+    robot_model::RobotModelPtr model;
+    GetModel(path, model, urdf, srdf);
+    return model;
 }
 
 bool Server::HasModel(const std::string& path)
 {
+    std::lock_guard<std::mutex> lock(model_cache_mutex_);
     return robot_models_.find(path) != robot_models_.end();
 }
 
+std::shared_ptr<const KDL::Tree> Server::GetKDLTree(const robot_model::RobotModelConstPtr& model)
+{
+    std::shared_ptr<Server> server = Instance();
+    std::lock_guard<std::mutex> lock(server->model_cache_mutex_);
+    KDLTreeEntry& entry = server->kdl_trees_[model.get()];
+    std::shared_ptr<const KDL::Tree> tree = entry.tree.lock();
+    // The address of a destroyed model may have been reused
+    if (tree && entry.model.lock() == model) return tree;
+
+    std::shared_ptr<KDL::Tree> new_tree = std::make_shared<KDL::Tree>();
+    if (!kdl_parser::treeFromUrdfModel(*model->getURDF(), *new_tree)) ThrowPretty("Can't load URDF model!");
+    entry.model = model;
+    entry.tree = new_tree;
+    return new_tree;
+}
+
+shapes::ShapePtr Server::GetMesh(const std::string& resource, const Eigen::Vector3d& scale)
+{
+    std::ostringstream key;
+    key.precision(17);
+    key << resource << " " << scale(0) << " " << scale(1) << " " << scale(2);
+
+    std::shared_ptr<Server> server = Instance();
+    std::lock_guard<std::mutex> lock(server->model_cache_mutex_);
+    std::weak_ptr<shapes::Shape>& cached = server->meshes_[key.str()];
+    shapes::ShapePtr mesh = cached.lock();
+    if (!mesh)
+    {
+        mesh = shapes::ShapePtr(shapes::createMeshFromResource(resource, scale));
+        cached = mesh;
+    }
+    return mesh;
+}
+
 std::string Server::GetName()
 {
     return name_;
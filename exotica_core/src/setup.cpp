@@ -48,7 +48,7 @@ void Setup::Destroy()
 void Setup::PrintSupportedClasses()
 {
     HIGHLIGHT("Registered solvers:");
-    std::vector<std::string> solvers = Instance()->solvers_.getDeclaredClasses();
+    std::vector<std::string> solvers = Instance()->solvers_.GetDeclaredClasses();
     for (const std::string& s : solvers)
     {
         HIGHLIGHT(" '" << s << "'");
@@ -60,19 +60,19 @@ void Setup::PrintSupportedClasses()
         HIGHLIGHT(" '" << s << "'");
     }
     HIGHLIGHT("Registered task maps:");
-    std::vector<std::string> maps = Instance()->maps_.getDeclaredClasses();
+    std::vector<std::string> maps = Instance()->maps_.GetDeclaredClasses();
     for (const std::string& s : maps)
     {
         HIGHLIGHT(" '" << s << "'");
     }
     HIGHLIGHT("Registered collision scenes:");
-    std::vector<std::string> scenes = Instance()->collision_scenes_.getDeclaredClasses();
+    std::vector<std::string> scenes = Instance()->collision_scenes_.GetDeclaredClasses();
     for (const std::string& s : scenes)
     {
         HIGHLIGHT(" '" << s << "'");
     }
     HIGHLIGHT("Registered dynamics solvers:");
-    std::vector<std::string> dynamics_solvers = Instance()->dynamics_solvers_.getDeclaredClasses();
+    std::vector<std::string> dynamics_solvers = Instance()->dynamics_solvers_.GetDeclaredClasses();
     for (const std::string& s : dynamics_solvers)
     {
         HIGHLIGHT(" '" << s << "'");
@@ -103,7 +103,7 @@ void AppendInitializer(std::shared_ptr<InstantiableBase> it, std::vector<Initial
 std::vector<Initializer> Setup::GetInitializers()
 {
     std::vector<Initializer> ret = Scene().GetAllTemplates();
-    std::vector<std::string> solvers = Instance()->solvers_.getDeclaredClasses();
+    std::vector<std::string> solvers = Instance()->solvers_.GetDeclaredClasses();
     for (const std::string& s : solvers)
     {
         try
@@ -116,7 +116,7 @@ std::vector<Initializer> Setup::GetInitializers()
             continue;
         }
     }
-    std::vector<std::string> maps = Instance()->maps_.getDeclaredClasses();
+    std::vector<std::string> maps = Instance()->maps_.GetDeclaredClasses();
     for (const std::string& s : maps)
     {
         try
@@ -129,7 +129,7 @@ std::vector<Initializer> Setup::GetInitializers()
             continue;
         }
     }
-    std::vector<std::string> collision_scenes = Instance()->collision_scenes_.getDeclaredClasses();
+    std::vector<std::string> collision_scenes = Instance()->collision_scenes_.GetDeclaredClasses();
     for (const std::string& s : collision_scenes)
     {
         try
@@ -142,7 +142,7 @@ std::vector<Initializer> Setup::GetInitializers()
             continue;
         }
     }
-    std::vector<std::string> dynamics_solvers = Instance()->dynamics_solvers_.getDeclaredClasses();
+    std::vector<std::string> dynamics_solvers = Instance()->dynamics_solvers_.GetDeclaredClasses();
     for (const std::string& s : dynamics_solvers)
     {
         try
@@ -158,11 +158,11 @@ std::vector<Initializer> Setup::GetInitializers()
     return ret;
 }
 
-std::vector<std::string> Setup::GetSolvers() { return Instance()->solvers_.getDeclaredClasses(); }
+std::vector<std::string> Setup::GetSolvers() { return Instance()->solvers_.GetDeclaredClasses(); }
 std::vector<std::string> Setup::GetProblems() { return Instance()->problems_.GetDeclaredClasses(); }
-std::vector<std::string> Setup::GetMaps() { return Instance()->maps_.getDeclaredClasses(); }
-std::vector<std::string> Setup::GetCollisionScenes() { return Instance()->collision_scenes_.getDeclaredClasses(); }
-std::vector<std::string> Setup::GetDynamicsSolvers() { return Instance()->dynamics_solvers_.getDeclaredClasses(); }
+std::vector<std::string> Setup::GetMaps() { return Instance()->maps_.GetDeclaredClasses(); }
+std::vector<std::string> Setup::GetCollisionScenes() { return Instance()->collision_scenes_.GetDeclaredClasses(); }
+std::vector<std::string> Setup::GetDynamicsSolvers() { return Instance()->dynamics_solvers_.GetDeclaredClasses(); }
 Setup::Setup() : solvers_("exotica_core", "exotica::MotionSolver"),
                  maps_("exotica_core", "exotica::TaskMap"),
                  problems_(PlanningProblemFac::Instance()),
@@ -27,8 +27,15 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <exotica_core/server.h>
+#include <exotica_core/setup.h>
 #include <exotica_core/task_map.h>
 
+#include <exotica_core/tools/parallel_loop.h>
+
+#include <algorithm>
+#include <thread>
+
 #include <exotica_core/frame_initializer.h>
 #include <exotica_core/task_map_initializer.h>
 
@@ -44,6 +51,22 @@ void TaskMap::InstantiateBase(const Initializer& init)
     Object::InstantiateObject(init);
     TaskMapInitializer MapInitializer(init);
     is_used = true;
+    initializer_ = init;
+
+    if (MapInitializer.FiniteDifferenceNumThreads < 0) ThrowNamed("Invalid number of threads: " << MapInitializer.FiniteDifferenceNumThreads);
+    finite_difference_num_threads_ = Server::ResolveNumThreads(MapInitializer.FiniteDifferenceNumThreads);
+
+    if (MapInitializer.FiniteDifferenceMode == "Backward")
+        finite_difference_mode_ = FiniteDifferenceMode::Backward;
+    else if (MapInitializer.FiniteDifferenceMode == "Forward")
+        finite_difference_mode_ = FiniteDifferenceMode::Forward;
+    else if (MapInitializer.FiniteDifferenceMode == "Central")
+        finite_difference_mode_ = FiniteDifferenceMode::Central;
+    else
+        ThrowNamed("Unknown finite-difference mode: " << MapInitializer.FiniteDifferenceMode);
+    if (MapInitializer.FiniteDifferenceStep <= 0.0) ThrowNamed("Invalid finite-difference step: " << MapInitializer.FiniteDifferenceStep);
+    finite_difference_step_ = MapInitializer.FiniteDifferenceStep;
+    finite_difference_workspaces_.clear();
 
     frames_.clear();
 
@@ -59,8 +82,25 @@ std::vector<KinematicFrameRequest> TaskMap::GetFrames() const
     return frames_;
 }
 
+std::shared_ptr<TaskMap> TaskMap::CreateClone(ScenePtr scene) const
+{
+    std::shared_ptr<TaskMap> map = Setup::CreateMap(initializer_);
+    map->AssignScene(scene);
+    map->ns_ = ns_;
+    map->id = id;
+    map->start = start;
+    map->length = length;
+    map->start_jacobian = start_jacobian;
+    map->length_jacobian = length_jacobian;
+    map->is_used = is_used;
+    map->kinematics.resize(kinematics.size());
+    for (std::size_t i = 0; i < kinematics.size(); ++i) map->kinematics[i] = KinematicSolution(kinematics[i].start, kinematics[i].length);
+    return map;
+}
+
 void TaskMap::Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian)
 {
+    EXOTICA_PROFILE_SCOPE("TaskMap::UpdateFiniteDifferences");
     if (jacobian.rows() != TaskSpaceDim() && jacobian.cols() != q.rows())
         ThrowNamed("Jacobian dimension mismatch!");
 
@@ -69,37 +109,107 @@ void TaskMap::Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen::M
         ThrowNamed("Scene is not initialised!");
     }
 
-    // Set constants
-    constexpr double h = 1e-6;
-    constexpr double h_inverse = 1.0 / h;
-
     // Compute x/phi using forward mapping (no jacobian)
     Update(q, phi);
 
+    // Task maps using several kinematic responses (e.g., of previous time steps) are not cloned
+    const int num_threads = std::min(finite_difference_num_threads_, static_cast<int>(jacobian.cols()));
+    if (num_threads > 1 && kinematics.size() == 1)
+    {
+        UpdateFiniteDifferenceWorkspaces(num_threads);
+
+        // The columns are split across the clones, each perturbs one joint at a time on its own scene
+        for (int thread = 0; thread < num_threads; ++thread) finite_difference_workspaces_[thread].q_perturbed = q;
+        ParallelLoop(num_threads, static_cast<int>(jacobian.cols()), [&](int thread, int i) {
+            FiniteDifferenceWorkspace& workspace = finite_difference_workspaces_[thread];
+            ComputeFiniteDifferenceColumn(*workspace.scene, *workspace.map, q, phi, i, workspace.q_perturbed, workspace.phi_forward, workspace.phi_backward, jacobian);
+        });
+        return;
+    }
+
     // Setup for gradient estimate
-    Eigen::VectorXd q_backward(q.size()), phi_backward(TaskSpaceDim());
+    Eigen::VectorXd q_perturbed(q), phi_forward(TaskSpaceDim()), phi_backward(TaskSpaceDim());
 
-    // Backward finite differencing
+    // Only the subtrees of the perturbed joint and of the joint restored from the previous column are recomputed,
+    // and unless the task map uses them, the Jacobians are not.
     for (int i = 0; i < jacobian.cols(); ++i)
     {
-        // Compute and set x_backward as model state
-        q_backward = q;
-        q_backward(i) -= h;
-        scene_->GetKinematicTree().Update(q_backward);
-
-        // Compute phi_backward using forward mapping (no jacobian)
-        Update(q_backward, phi_backward);
-
-        // Compute gradient estimate
-        jacobian.col(i).noalias() = h_inverse * (phi - phi_backward);
+        ComputeFiniteDifferenceColumn(*scene_, *this, q, phi, i, q_perturbed, phi_forward, phi_backward, jacobian);
     }
 
     // Reset model state
     scene_->GetKinematicTree().Update(q);
 }
 
+void TaskMap::ComputeFiniteDifferenceColumn(Scene& scene, TaskMap& map, Eigen::VectorXdRefConst q, Eigen::VectorXdRefConst phi, int i, Eigen::VectorXd& q_perturbed, Eigen::VectorXd& phi_forward, Eigen::VectorXd& phi_backward, Eigen::MatrixXdRef jacobian)
+{
+    const double h = finite_difference_step_;
+    auto evaluate = [&](double dq, Eigen::VectorXd& phi_perturbed) {
+        // Compute and set the perturbed state as model state, then phi using forward mapping (no jacobian)
+        q_perturbed(i) = q(i) + dq;
+        if (UsesKinematicJacobians())
+        {
+            scene.GetKinematicTree().Update(q_perturbed);
+        }
+        else
+        {
+            scene.GetKinematicTree().UpdateFrames(q_perturbed);
+        }
+        map.Update(q_perturbed, phi_perturbed);
+    };
+
+    switch (finite_difference_mode_)
+    {
+        case FiniteDifferenceMode::Backward:
+            evaluate(-h, phi_backward);
+            jacobian.col(i).noalias() = (phi - phi_backward) / h;
+            break;
+        case FiniteDifferenceMode::Forward:
+            evaluate(h, phi_forward);
+            jacobian.col(i).noalias() = (phi_forward - phi) / h;
+            break;
+        case FiniteDifferenceMode::Central:
+            evaluate(h, phi_forward);
+            evaluate(-h, phi_backward);
+            jacobian.col(i).noalias() = (phi_forward - phi_backward) / (2.0 * h);
+            break;
+    }
+    q_perturbed(i) = q(i);
+}
+
+void TaskMap::UpdateFiniteDifferenceWorkspaces(int num_workspaces)
+{
+    if (finite_difference_workspaces_version_ != scene_->GetWorldVersion()) finite_difference_workspaces_.clear();
+    finite_difference_workspaces_version_ = scene_->GetWorldVersion();
+    while (static_cast<int>(finite_difference_workspaces_.size()) < num_workspaces)
+    {
+        FiniteDifferenceWorkspace workspace;
+        workspace.scene = scene_->CloneWorkspace();
+
+        // The clone of the task map evaluates the same frames, with its own kinematic response of the cloned scene
+        workspace.map = Setup::CreateMap(initializer_);
+        workspace.map->AssignScene(workspace.scene);
+        workspace.map->ns_ = ns_;
+        const std::vector<KinematicFrameRequest> frames = workspace.map->GetFrames();
+        workspace.map->kinematics[0] = KinematicSolution(0, frames.size());
+        KinematicsRequest request;
+        request.flags = UsesKinematicJacobians() ? KIN_FK | KIN_J : KIN_FK;
+        request.frames = frames;
+        std::shared_ptr<TaskMap> map = workspace.map;
+        workspace.scene->RequestKinematics(request, [map](std::shared_ptr<KinematicResponse> response) { map->kinematics[0].Create(response); });
+        workspace.phi_forward.resize(TaskSpaceDim());
+        workspace.phi_backward.resize(TaskSpaceDim());
+        finite_difference_workspaces_.push_back(workspace);
+    }
+
+    // Joints that are not controlled may have been changed since
+    const std::map<std::string, double> model_state = scene_->GetKinematicTree().GetModelStateMap();
+    for (int i = 0; i < num_workspaces; ++i) finite_difference_workspaces_[i].scene->GetKinematicTree().SetModelState(model_state);
+}
+
 void TaskMap::Update(Eigen::VectorXdRefConst q, Eigen::VectorXdRef phi, Eigen::MatrixXdRef jacobian, HessianRef hessian)
 {
+    EXOTICA_PROFILE_SCOPE("TaskMap::UpdateGaussNewtonHessian");
     Update(q, phi, jacobian);
     const int ndq = scene_->get_has_quaternion_floating_base() ? scene_->get_num_positions() - 1 : scene_->get_num_positions();
     for (int i = 0; i < TaskSpaceJacobianDim(); ++i)
@@ -129,4 +239,13 @@ void TaskMap::Update(Eigen::VectorXdRefConst x, Eigen::VectorXdRefConst u, Eigen
     Update(x.head(ndq), phi, dphi_dx.topLeftCorner(TaskSpaceJacobianDim(), ndq), ddphi_ddx);
 }
 
+void TaskMap::UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi)
+{
+    ThrowNamed("UpdateTrajectory is not implemented for this task map!");
+}
+
+void TaskMap::UpdateTrajectory(Eigen::MatrixXdRefConst x, Eigen::MatrixXdRef phi, std::vector<Eigen::Triplet<double>>& jacobian)
+{
+    ThrowNamed("UpdateTrajectory is not implemented for this task map!");
+}
 }  // namespace exotica
@@ -29,8 +29,31 @@
 
 #include <exotica_core/task_space_vector.h>
 
+#include <Eigen/Geometry>
+#include <cmath>
+
 namespace exotica
 {
+/// \brief Rotation vector taking R2 to R1, expressed in the world frame, i.e., R1 * (R2^-1 * R1).GetRot().
+inline Eigen::Vector3d RotationMatrixDifference(const Eigen::Matrix3d& R1, const Eigen::Matrix3d& R2)
+{
+    const Eigen::AngleAxisd error(R2.transpose() * R1);
+    return R1 * (error.angle() * error.axis());
+}
+
+/// \brief As RotationMatrixDifference, for quaternions (normalised before taking the difference).
+inline Eigen::Vector3d QuaternionDifference(const Eigen::Quaterniond& q1, const Eigen::Quaterniond& q2)
+{
+    const Eigen::Quaterniond q1_normalized = q1.normalized();
+    Eigen::Quaterniond error = q2.normalized().conjugate() * q1_normalized;
+    if (error.w() < 0.0) error.coeffs() = -error.coeffs();  // Shortest rotation, i.e., rotation angle in [0, pi]
+
+    // log(error) = angle * axis with vec() = sin(angle / 2) * axis, which tends to vec() * 2 for small angles
+    const double sin_half_angle = error.vec().norm();
+    const double scale = sin_half_angle > 1e-12 ? 2.0 * std::atan2(sin_half_angle, error.w()) / sin_half_angle : 2.0;
+    return q1_normalized * (scale * error.vec());
+}
+
 TaskVectorEntry::TaskVectorEntry(int _id, RotationType _type) : id(_id), type(_type)
 {
 }
@@ -53,41 +76,86 @@ TaskSpaceVector& TaskSpaceVector::operator=(std::initializer_list<double> other)
 
 void TaskSpaceVector::SetZero(const int n)
 {
-    data = Eigen::VectorXd::Zero(n);
+    // Called for every update, hence the identity rotations are written without converting them (all other types are zero)
+    data.setZero(n);
     for (const TaskVectorEntry& entry : map)
     {
-        const int len = GetRotationTypeLength(entry.type);
-        data.segment(entry.id, len) = SetRotation(KDL::Rotation(), entry.type);
+        if (entry.type == RotationType::QUATERNION)
+        {
+            data(entry.id + 3) = 1.0;
+        }
+        else if (entry.type == RotationType::MATRIX)
+        {
+            data(entry.id) = data(entry.id + 4) = data(entry.id + 8) = 1.0;
+        }
     }
 }
 
-Eigen::VectorXd TaskSpaceVector::operator-(const TaskSpaceVector& other)
+int TaskSpaceVector::TangentSize() const
 {
-    if (data.rows() != other.data.rows()) ThrowPretty("Task space vector sizes do not match!");
     int entry_size = 0;
     for (const TaskVectorEntry& entry : map) entry_size += GetRotationTypeLength(entry.type);
-    Eigen::VectorXd ret(data.rows() + map.size() * 3 - entry_size);
+    return data.rows() + map.size() * 3 - entry_size;
+}
+
+Eigen::VectorXd TaskSpaceVector::operator-(const TaskSpaceVector& other)
+{
+    Eigen::VectorXd ret(TangentSize());
+    Difference(other, ret);
+    return ret;
+}
+
+void TaskSpaceVector::Difference(const TaskSpaceVector& other, Eigen::VectorXdRef out) const
+{
+    if (data.rows() != other.data.rows()) ThrowPretty("Task space vector sizes do not match!");
+    if (out.rows() != TangentSize()) ThrowPretty("Wrong size of the difference vector: " << out.rows() << " expecting " << TangentSize());
+    TaskSpaceDifference(data, other.data, map, out);
+}
+
+void TaskSpaceDifference(Eigen::VectorXdRefConst data, Eigen::VectorXdRefConst other_data, const std::vector<TaskVectorEntry>& map, Eigen::VectorXdRef out)
+{
     int i_in = 0;
     int i_out = 0;
     for (const TaskVectorEntry& entry : map)
     {
-        if (i_in < entry.id) ret.segment(i_out, entry.id - i_in) = data.segment(i_in, entry.id - i_in) - other.data.segment(i_in, entry.id - i_in);
+        if (i_in < entry.id) out.segment(i_out, entry.id - i_in) = data.segment(i_in, entry.id - i_in) - other_data.segment(i_in, entry.id - i_in);
         i_out += entry.id - i_in;
         i_in += entry.id - i_in;
         const int len = GetRotationTypeLength(entry.type);
 
-        KDL::Rotation M1 = GetRotation(data.segment(entry.id, len), entry.type);
-        KDL::Rotation M2 = GetRotation(other.data.segment(entry.id, len), entry.type);
-        KDL::Rotation M = M2.Inverse() * M1;
-        KDL::Vector rotvec = M1 * (M.GetRot());
-        ret(i_out) = rotvec[0];
-        ret(i_out + 1) = rotvec[1];
-        ret(i_out + 2) = rotvec[2];
+        // Quaternions and rotation matrices are compared directly, e.g., of the frames of EffFrame, the other types through KDL
+        switch (entry.type)
+        {
+            case RotationType::QUATERNION:
+            {
+                if (data.segment<4>(entry.id).sum() == 0.0 || other_data.segment<4>(entry.id).sum() == 0.0) ThrowPretty("Invalid quaternion transform!");
+                const double* q1 = data.data() + entry.id;
+                const double* q2 = other_data.data() + entry.id;
+                out.segment<3>(i_out) = QuaternionDifference(Eigen::Quaterniond(q1[3], q1[0], q1[1], q1[2]), Eigen::Quaterniond(q2[3], q2[0], q2[1], q2[2]));
+                break;
+            }
+            case RotationType::MATRIX:
+            {
+                if (data.segment<9>(entry.id).sum() == 0.0 || other_data.segment<9>(entry.id).sum() == 0.0) ThrowPretty("Invalid matrix transform!");
+                // Stored row by row, as by SetRotation
+                typedef Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor>> RotationMatrixMap;
+                out.segment<3>(i_out) = RotationMatrixDifference(RotationMatrixMap(data.data() + entry.id), RotationMatrixMap(other_data.data() + entry.id));
+                break;
+            }
+            default:
+            {
+                const KDL::Rotation M1 = GetRotation(data.segment(entry.id, len), entry.type);
+                const KDL::Rotation M2 = GetRotation(other_data.segment(entry.id, len), entry.type);
+                const KDL::Vector rotvec = M1 * ((M2.Inverse() * M1).GetRot());
+                out(i_out) = rotvec[0];
+                out(i_out + 1) = rotvec[1];
+                out(i_out + 2) = rotvec[2];
+            }
+        }
         i_out += 3;
         i_in += len;
     }
-    if (i_in < data.rows()) ret.segment(i_out, data.rows() - i_in) = data.segment(i_in, data.rows() - i_in) - other.data.segment(i_in, data.rows() - i_in);
-    return ret;
+    if (i_in < data.rows()) out.segment(i_out, data.rows() - i_in) = data.segment(i_in, data.rows() - i_in) - other_data.segment(i_in, data.rows() - i_in);
 }
 
 std::vector<TaskVectorEntry> TaskVectorEntry::reindex(const std::vector<TaskVectorEntry>& _map, int _old_start, int _new_start)
@@ -32,6 +32,8 @@
 
 #include <exotica_core/task_initializer.h>
 
+#include <algorithm>
+
 namespace exotica
 {
 void Task::Initialize(const std::vector<exotica::Initializer>& inits, PlanningProblemPtr prob, TaskSpaceVector& Phi)
@@ -57,6 +59,7 @@ void Task::Initialize(const std::vector<exotica::Initializer>& inits, PlanningPr
         indexing[i].length = tasks[i]->length;
         indexing[i].start_jacobian = length_jacobian;
         indexing[i].length_jacobian = tasks[i]->length_jacobian;
+        indexing[i].map = TaskVectorEntry::reindex(tasks[i]->GetLieGroupIndices(), tasks[i]->start, 0);
 
         AppendVector(Phi.map, TaskVectorEntry::reindex(tasks[i]->GetLieGroupIndices(), tasks[i]->start, indexing[i].start));
         length_Phi += tasks[i]->length;
@@ -126,7 +129,7 @@ void EndPoseTask::Update(const TaskSpaceVector& big_Phi, Eigen::MatrixXdRefConst
         jacobian.middleRows(task.start_jacobian, task.length_jacobian) = big_jacobian.middleRows(tasks[task.id]->start_jacobian, tasks[task.id]->length_jacobian);
         hessian.segment(task.start_jacobian, task.length_jacobian) = big_hessian.segment(tasks[task.id]->start_jacobian, tasks[task.id]->length_jacobian);
     }
-    ydiff = Phi - y;
+    Phi.Difference(y, ydiff);
 }
 
 void EndPoseTask::Update(const TaskSpaceVector& big_Phi, Eigen::MatrixXdRefConst big_jacobian)
@@ -136,7 +139,7 @@ void EndPoseTask::Update(const TaskSpaceVector& big_Phi, Eigen::MatrixXdRefConst
         Phi.data.segment(task.start, task.length) = big_Phi.data.segment(tasks[task.id]->start, tasks[task.id]->length);
         jacobian.middleRows(task.start_jacobian, task.length_jacobian) = big_jacobian.middleRows(tasks[task.id]->start_jacobian, tasks[task.id]->length_jacobian);
     }
-    ydiff = Phi - y;
+    Phi.Difference(y, ydiff);
 }
 
 void EndPoseTask::Update(const TaskSpaceVector& big_Phi)
@@ -145,7 +148,29 @@ void EndPoseTask::Update(const TaskSpaceVector& big_Phi)
     {
         Phi.data.segment(task.start, task.length) = big_Phi.data.segment(tasks[task.id]->start, tasks[task.id]->length);
     }
-    ydiff = Phi - y;
+    Phi.Difference(y, ydiff);
+}
+
+double EndPoseTask::UpdateFused(const TaskSpaceVector& big_Phi, Eigen::MatrixXdRefConst big_jacobian, Eigen::VectorXdRef JT_times_yd, Eigen::MatrixXdRef JT_times_J)
+{
+    double cost = 0.0;
+    JT_times_yd.setZero();
+    JT_times_J.setZero();
+    for (const TaskIndexing& task : indexing)
+    {
+        const TaskMapPtr& task_map = tasks[task.id];
+        Phi.data.segment(task.start, task.length) = big_Phi.data.segment(task_map->start, task_map->length);
+        Eigen::VectorXdRef task_ydiff = ydiff.segment(task.start_jacobian, task.length_jacobian);
+        TaskSpaceDifference(Phi.data.segment(task.start, task.length), y.data.segment(task.start, task.length), task.map, task_ydiff);
+        if (rho(task.id) == 0.0) continue;
+
+        const auto task_jacobian = big_jacobian.middleRows(task_map->start_jacobian, task_map->length_jacobian);
+        const double rho_squared = rho(task.id) * rho(task.id);
+        cost += rho(task.id) * task_ydiff.squaredNorm();
+        JT_times_yd.noalias() += rho_squared * (task_jacobian.transpose() * task_ydiff);
+        JT_times_J.noalias() += rho_squared * (task_jacobian.transpose() * task_jacobian);
+    }
+    return cost;
 }
 
 void EndPoseTask::SetGoal(const std::string& task_name, Eigen::VectorXdRefConst goal)
@@ -233,6 +258,10 @@ void TimeIndexedTask::Initialize(const std::vector<exotica::Initializer>& inits,
 
 void TimeIndexedTask::UpdateS()
 {
+    num_active_map_ids_ = 0;
+    for (const TaskIndexing& task : indexing) num_active_map_ids_ = std::max(num_active_map_ids_, tasks[task.id]->id + 1);
+    active_task_maps_.assign(static_cast<std::size_t>(T) * num_active_map_ids_, false);
+
     for (int t = 0; t < T; ++t)
     {
         for (const TaskIndexing& task : indexing)
@@ -241,7 +270,11 @@ void TimeIndexedTask::UpdateS()
             {
                 S[t](i + task.start_jacobian, i + task.start_jacobian) = rho[t](task.id);
             }
-            if (rho[t](task.id) != 0.0) tasks[task.id]->is_used = true;
+            if (rho[t](task.id) != 0.0)
+            {
+                tasks[task.id]->is_used = true;
+                if (tasks[task.id]->id >= 0) active_task_maps_[t * num_active_map_ids_ + tasks[task.id]->id] = true;
+            }
         }
     }
 }
@@ -263,7 +296,7 @@ void TimeIndexedTask::Update(const TaskSpaceVector& big_Phi,
         ddPhi_ddu[t].segment(task.start_jacobian, task.length_jacobian) = big_ddPhi_ddu.segment(tasks[task.id]->start_jacobian, tasks[task.id]->length_jacobian);
         ddPhi_dxdu[t].segment(task.start_jacobian, task.length_jacobian) = big_ddPhi_dxdu.segment(tasks[task.id]->start_jacobian, tasks[task.id]->length_jacobian);
     }
-    ydiff[t] = Phi[t] - y[t];
+    Phi[t].Difference(y[t], ydiff[t]);
 }
 
 void TimeIndexedTask::Update(const TaskSpaceVector& big_Phi,
@@ -277,7 +310,7 @@ void TimeIndexedTask::Update(const TaskSpaceVector& big_Phi,
         dPhi_dx[t].middleRows(task.start_jacobian, task.length_jacobian) = big_dPhi_dx.middleRows(tasks[task.id]->start_jacobian, tasks[task.id]->length_jacobian);
         dPhi_du[t].middleRows(task.start_jacobian, task.length_jacobian) = big_dPhi_du.middleRows(tasks[task.id]->start_jacobian, tasks[task.id]->length_jacobian);
     }
-    ydiff[t] = Phi[t] - y[t];
+    Phi[t].Difference(y[t], ydiff[t]);
 }
 
 void TimeIndexedTask::Update(const TaskSpaceVector& big_Phi, Eigen::MatrixXdRefConst big_jacobian, HessianRefConst big_hessian, int t)
@@ -288,7 +321,7 @@ void TimeIndexedTask::Update(const TaskSpaceVector& big_Phi, Eigen::MatrixXdRefC
         jacobian[t].middleRows(task.start_jacobian, task.length_jacobian) = big_jacobian.middleRows(tasks[task.id]->start_jacobian, tasks[task.id]->length_jacobian);
         hessian[t].segment(task.start_jacobian, task.length_jacobian) = big_hessian.segment(tasks[task.id]->start_jacobian, tasks[task.id]->length_jacobian);
     }
-    ydiff[t] = Phi[t] - y[t];
+    Phi[t].Difference(y[t], ydiff[t]);
 }
 
 void TimeIndexedTask::Update(const TaskSpaceVector& big_Phi, Eigen::MatrixXdRefConst big_jacobian, int t)
@@ -298,7 +331,7 @@ void TimeIndexedTask::Update(const TaskSpaceVector& big_Phi, Eigen::MatrixXdRefC
         Phi[t].data.segment(task.start, task.length) = big_Phi.data.segment(tasks[task.id]->start, tasks[task.id]->length);
         jacobian[t].middleRows(task.start_jacobian, task.length_jacobian) = big_jacobian.middleRows(tasks[task.id]->start_jacobian, tasks[task.id]->length_jacobian);
     }
-    ydiff[t] = Phi[t] - y[t];
+    Phi[t].Difference(y[t], ydiff[t]);
 }
 
 void TimeIndexedTask::Update(const TaskSpaceVector& big_Phi, int t)
@@ -307,7 +340,7 @@ void TimeIndexedTask::Update(const TaskSpaceVector& big_Phi, int t)
     {
         Phi[t].data.segment(task.start, task.length) = big_Phi.data.segment(tasks[task.id]->start, tasks[task.id]->length);
     }
-    ydiff[t] = Phi[t] - y[t];
+    Phi[t].Difference(y[t], ydiff[t]);
 }
 
 inline void TimeIndexedTask::ValidateTimeIndex(int& t_in) const
@@ -418,13 +451,20 @@ void TimeIndexedTask::ReinitializeVariables(int _T, PlanningProblemPtr _prob, co
         dPhi_dx.assign(T, Eigen::MatrixXd(length_jacobian, _prob->GetScene()->get_num_state_derivative()));
         dPhi_du.assign(T, Eigen::MatrixXd(length_jacobian, _prob->GetScene()->get_num_controls()));
     }
-    if (_prob->GetFlags() & KIN_H)
+    if (_prob->GetFlags() & KIN_H && store_hessians)
     {
         hessian.assign(T, Hessian::Constant(length_jacobian, Eigen::MatrixXd::Zero(_prob->N, _prob->N)));
         ddPhi_ddx.assign(T, Hessian::Constant(length_jacobian, Eigen::MatrixXd::Zero(_prob->GetScene()->get_num_state_derivative(), _prob->GetScene()->get_num_state_derivative())));
         ddPhi_ddu.assign(T, Hessian::Constant(length_jacobian, Eigen::MatrixXd::Zero(_prob->GetScene()->get_num_controls(), _prob->GetScene()->get_num_controls())));
         ddPhi_dxdu.assign(T, Hessian::Constant(length_jacobian, Eigen::MatrixXd::Zero(_prob->GetScene()->get_num_state_derivative(), _prob->GetScene()->get_num_controls())));
     }
+    else
+    {
+        hessian.clear();
+        ddPhi_ddx.clear();
+        ddPhi_ddu.clear();
+        ddPhi_dxdu.clear();
+    }
     S.assign(T, Eigen::MatrixXd::Identity(length_jacobian, length_jacobian));
     ydiff.assign(T, Eigen::VectorXd::Zero(length_jacobian));
 
@@ -477,6 +517,21 @@ void TimeIndexedTask::ReinitializeVariables(int _T, PlanningProblemPtr _prob, co
             ThrowPretty("Invalid task rho size! Expecting " << T << " (or 1) and got " << task.Rho.rows());
         }
     }
+
+    // The task maps evaluated at each time step follow rho from the start, not only after the first PreUpdate
+    UpdateS();
+}
+
+void TimeIndexedTask::ResampleGoals(const std::vector<TaskSpaceVector>& y_in, const std::vector<Eigen::VectorXd>& rho_in)
+{
+    if (y_in.size() != rho_in.size() || y_in.empty()) ThrowPretty("Goals and weights need to be given for the same number of time steps!");
+    const int T_in = static_cast<int>(y_in.size());
+    for (int t = 0; t < T; ++t)
+    {
+        const int s = GetNearestTimeStep(t, T_in, T);
+        y[t] = y_in[s];
+        rho[t] = rho_in[s];
+    }
 }
 
 void SamplingTask::Initialize(const std::vector<exotica::Initializer>& inits, PlanningProblemPtr prob, TaskSpaceVector& unused)
@@ -536,7 +591,7 @@ void SamplingTask::Update(const TaskSpaceVector& big_Phi)
     {
         Phi.data.segment(task.start, task.length) = big_Phi.data.segment(tasks[task.id]->start, tasks[task.id]->length);
     }
-    ydiff = Phi - y;
+    Phi.Difference(y, ydiff);
 
     for (unsigned int i = 0; i < ydiff.size(); ++i)
         if (std::abs(ydiff[i]) < tolerance) ydiff[i] = 0.0;
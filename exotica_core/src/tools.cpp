@@ -27,6 +27,8 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <algorithm>
+#include <cmath>
 #include <cxxabi.h>  // The demangler for gcc... this makes this system dependent!
 #include <fstream>
 #include <iostream>
@@ -201,4 +203,32 @@ bool PathExists(const std::string& path)
     std::ifstream file(ParsePath(path));
     return (bool)file;
 }
+
+int GetNearestTimeStep(int t, int T_from, int T_to)
+{
+    if (T_to < 2) return 0;
+    return static_cast<int>(std::lround(static_cast<double>(t) * (T_from - 1) / (T_to - 1)));
+}
+
+Eigen::MatrixXd ResampleTrajectory(Eigen::MatrixXdRefConst trajectory, int T)
+{
+    if (trajectory.cols() < 1 || T < 1) ThrowPretty("Cannot resample a trajectory of " << trajectory.cols() << " to " << T << " time steps!");
+    if (T == trajectory.cols()) return trajectory;
+
+    Eigen::MatrixXd resampled(trajectory.rows(), T);
+    const double scale = T > 1 ? static_cast<double>(trajectory.cols() - 1) / (T - 1) : 0.0;
+    for (int t = 0; t < T; ++t)
+    {
+        const double s = t * scale;
+        const int i = std::min(static_cast<int>(s), static_cast<int>(trajectory.cols()) - 2);
+        if (i < 0)
+        {
+            resampled.col(t) = trajectory.col(0);
+            continue;
+        }
+        const double alpha = s - i;
+        resampled.col(t) = (1.0 - alpha) * trajectory.col(i) + alpha * trajectory.col(i + 1);
+    }
+    return resampled;
+}
 }  // namespace exotica
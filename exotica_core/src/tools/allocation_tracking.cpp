@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+// Heap allocation hooks of the allocation-tracking debug mode (EXOTICA_ENABLE_ALLOCATION_TRACKING). They are built into the separate
+// library exotica_allocation_tracking, which is only linked into test executables or preloaded (LD_PRELOAD), so that linking
+// exotica_core never replaces the allocator of a process. Profiler::GetThreadAllocations reads the count through a weak reference.
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __GLIBC__
+// Initial-exec TLS is accessed without calling into the allocator
+static __thread std::int64_t thread_allocations __attribute__((tls_model("initial-exec"))) = 0;
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t num, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+extern "C" void* malloc(size_t size)
+{
+    ++thread_allocations;
+    return __libc_malloc(size);
+}
+extern "C" void* calloc(size_t num, size_t size)
+{
+    ++thread_allocations;
+    return __libc_calloc(num, size);
+}
+extern "C" void* realloc(void* ptr, size_t size)
+{
+    ++thread_allocations;
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" std::int64_t exotica_thread_allocations()
+{
+    return thread_allocations;
+}
+#endif
@@ -0,0 +1,241 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include <exotica_core/problems/abstract_time_indexed_problem.h>
+#include <exotica_core/problems/dynamic_time_indexed_shooting_problem.h>
+#include <exotica_core/problems/sampling_problem.h>
+#include <exotica_core/tools/experience_store.h>
+
+namespace exotica
+{
+namespace
+{
+template <typename T>
+inline void HashCombine(std::size_t& seed, const T& value)
+{
+    seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+inline void HashRounded(std::size_t& seed, double value, double resolution)
+{
+    HashCombine(seed, static_cast<long long>(std::llround(value / resolution)));
+}
+
+/// \brief Blends the offset from the first row to start (and from the last row to goal, if given) linearly into the trajectory.
+void RepairTrajectory(Eigen::MatrixXd& trajectory, Eigen::VectorXdRefConst start, const Eigen::VectorXd* goal = nullptr)
+{
+    const int rows = static_cast<int>(trajectory.rows());
+    if (rows == 0 || start.size() != trajectory.cols()) return;
+    const Eigen::RowVectorXd start_offset = start.transpose() - trajectory.row(0);
+    Eigen::RowVectorXd goal_offset = Eigen::RowVectorXd::Zero(trajectory.cols());
+    if (goal != nullptr && goal->size() == trajectory.cols()) goal_offset = goal->transpose() - trajectory.row(rows - 1);
+    for (int t = 0; t < rows; ++t)
+    {
+        const double alpha = rows > 1 ? static_cast<double>(t) / static_cast<double>(rows - 1) : 0.0;
+        trajectory.row(t) += (1.0 - alpha) * start_offset + alpha * goal_offset;
+    }
+}
+
+inline bool AllValid(const std::vector<bool>& valid)
+{
+    return std::all_of(valid.begin(), valid.end(), [](bool v) { return v; });
+}
+}  // namespace
+
+ExperienceStore::ExperienceStore(std::size_t capacity, double goal_weight) : capacity_(std::max<std::size_t>(capacity, 1)), goal_weight_(goal_weight)
+{
+    if (goal_weight < 0.0) ThrowPretty("The goal weight has to be non-negative, got " << goal_weight);
+}
+
+void ExperienceStore::Add(const Experience& experience)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    experiences_.push_back(experience);
+    while (experiences_.size() > capacity_) experiences_.pop_front();
+}
+
+void ExperienceStore::Add(const PlanningProblemPtr& problem, Eigen::VectorXdRefConst goal, Eigen::MatrixXdRefConst solution, double cost)
+{
+    Experience experience;
+    experience.problem_type = problem->type();
+    experience.scene_hash = HashScene(problem->GetScene());
+    experience.start = problem->GetStartState();
+    experience.goal = goal;
+    experience.solution = solution;
+    experience.cost = cost;
+    Add(experience);
+}
+
+std::vector<Experience> ExperienceStore::FindNearest(const std::string& problem_type, std::size_t scene_hash, Eigen::VectorXdRefConst start, Eigen::VectorXdRefConst goal, std::size_t k, double max_distance) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::pair<double, std::size_t>> candidates;
+    for (std::size_t i = 0; i < experiences_.size(); ++i)
+    {
+        const Experience& experience = experiences_[i];
+        if (experience.scene_hash != scene_hash || experience.problem_type != problem_type || experience.start.size() != start.size() || experience.goal.size() != goal.size()) continue;
+        const double distance = (start - experience.start).squaredNorm() + goal_weight_ * (goal - experience.goal).squaredNorm();
+        if (distance <= max_distance) candidates.emplace_back(distance, i);
+    }
+
+    const std::size_t num_nearest = std::min(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + num_nearest, candidates.end());
+    std::vector<Experience> nearest;
+    nearest.reserve(num_nearest);
+    for (std::size_t i = 0; i < num_nearest; ++i) nearest.push_back(experiences_[candidates[i].second]);
+    return nearest;
+}
+
+bool ExperienceStore::WarmStart(const PlanningProblemPtr& problem, Eigen::VectorXdRefConst goal, Eigen::MatrixXd& seed, std::size_t k, double max_distance) const
+{
+    const Eigen::VectorXd start = problem->GetStartState();
+    std::vector<Experience> candidates = FindNearest(problem->type(), HashScene(problem->GetScene()), start, goal, k, max_distance);
+    if (candidates.empty()) return false;
+
+    std::shared_ptr<AbstractTimeIndexedProblem> time_indexed_problem = std::dynamic_pointer_cast<AbstractTimeIndexedProblem>(problem);
+    std::shared_ptr<DynamicTimeIndexedShootingProblem> shooting_problem = std::dynamic_pointer_cast<DynamicTimeIndexedShootingProblem>(problem);
+    std::shared_ptr<SamplingProblem> sampling_problem = std::dynamic_pointer_cast<SamplingProblem>(problem);
+
+    // Resample and repair the candidates to the current query
+    for (Experience& candidate : candidates)
+    {
+        if (time_indexed_problem)
+        {
+            candidate.solution = ResampleTrajectory(candidate.solution, time_indexed_problem->GetT());
+            RepairTrajectory(candidate.solution, start);
+        }
+        else if (shooting_problem)
+        {
+            candidate.solution = ResampleTrajectory(candidate.solution, shooting_problem->get_T() - 1);
+        }
+        else if (sampling_problem)
+        {
+            const Eigen::VectorXd goal_state = sampling_problem->GetGoalState();
+            RepairTrajectory(candidate.solution, start, &goal_state);
+        }
+    }
+
+    // Candidates in the order they are tried: lowest cost first
+    std::vector<std::size_t> order(candidates.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&candidates](std::size_t a, std::size_t b) { return candidates[a].cost < candidates[b].cost; });
+
+    int selected = -1;
+    for (std::size_t i : order)
+    {
+        const Eigen::MatrixXd& solution = candidates[i].solution;
+        bool valid = true;
+        if (sampling_problem)
+            valid = solution.cols() == problem->N && AllValid(sampling_problem->AreStatesValid(solution, true));
+        else if (time_indexed_problem && solution.cols() == problem->N)
+            valid = AllValid(problem->GetScene()->AreStatesValid(solution, true, 0.0, true));
+        if (valid)
+        {
+            selected = static_cast<int>(i);
+            break;
+        }
+    }
+
+    // The optimisation problems are seeded with the nearest candidate anyway, the solver repairs it
+    if (selected == -1)
+    {
+        if (sampling_problem) return false;
+        selected = 0;
+    }
+    seed = candidates[selected].solution;
+
+    if (time_indexed_problem)
+    {
+        std::vector<Eigen::VectorXd> q_init(seed.rows());
+        for (int t = 0; t < seed.rows(); ++t) q_init[t] = seed.row(t).transpose();
+        time_indexed_problem->SetInitialTrajectory(q_init);
+    }
+    else if (shooting_problem)
+    {
+        shooting_problem->set_U(seed.transpose());
+    }
+    else if (!sampling_problem && seed.rows() > 0 && seed.cols() == start.size())
+    {
+        // End-pose problems start from the start state
+        problem->SetStartState(seed.row(seed.rows() - 1).transpose());
+    }
+    return true;
+}
+
+std::size_t ExperienceStore::Size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return experiences_.size();
+}
+
+void ExperienceStore::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    experiences_.clear();
+}
+
+void ExperienceStore::SetCapacity(std::size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = std::max<std::size_t>(capacity, 1);
+    while (experiences_.size() > capacity_) experiences_.pop_front();
+}
+
+std::size_t ExperienceStore::HashScene(const ScenePtr& scene)
+{
+    constexpr double position_resolution = 1e-4;
+    constexpr double rotation_resolution = 1e-3;
+    std::size_t seed = 0;
+    for (const std::weak_ptr<KinematicElement>& weak_element : scene->GetKinematicTree().GetTree())
+    {
+        std::shared_ptr<KinematicElement> element = weak_element.lock();
+        if (!element || element->is_robot_link || !element->shape) continue;
+        HashCombine(seed, element->segment.getName());
+        HashCombine(seed, element->parent_name);
+        HashCombine(seed, static_cast<int>(element->shape->type));
+        HashCombine(seed, element->shape_resource_path);
+        const KDL::Frame pose = element->GetPose();
+        for (int i = 0; i < 3; ++i) HashRounded(seed, pose.p.data[i], position_resolution);
+        for (int i = 0; i < 9; ++i) HashRounded(seed, pose.M.data[i], rotation_resolution);
+        for (int i = 0; i < 3; ++i) HashRounded(seed, element->scale(i), position_resolution);
+    }
+    return seed;
+}
+
+Eigen::MatrixXd ExperienceStore::ResampleTrajectory(Eigen::MatrixXdRefConst trajectory, int rows)
+{
+    if (rows < 1) ThrowPretty("The number of rows has to be positive, got " << rows);
+    if (trajectory.rows() == rows || trajectory.rows() == 0) return trajectory;
+    return exotica::ResampleTrajectory(trajectory.transpose(), rows).transpose();
+}
+}  // namespace exotica
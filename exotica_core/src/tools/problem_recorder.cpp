@@ -0,0 +1,488 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <chrono>
+#include <cstring>
+
+#include <ros/serialization.h>
+
+#include <exotica_core/planning_problem.h>
+#include <exotica_core/problems/abstract_time_indexed_problem.h>
+#include <exotica_core/problems/bounded_end_pose_problem.h>
+#include <exotica_core/problems/end_pose_problem.h>
+#include <exotica_core/problems/unconstrained_end_pose_problem.h>
+#include <exotica_core/tools/problem_recorder.h>
+#include <exotica_core/tools/profiler.h>
+
+namespace exotica
+{
+namespace
+{
+constexpr char kMagic[4] = {'E', 'X', 'O', 'L'};
+constexpr std::uint32_t kFormatVersion = 1;
+
+std::int64_t Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void WriteUInt64(std::ostream& out, std::uint64_t value)
+{
+    char bytes[8];
+    for (int i = 0; i < 8; ++i) bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    out.write(bytes, 8);
+}
+
+void WriteUInt32(std::ostream& out, std::uint32_t value)
+{
+    char bytes[4];
+    for (int i = 0; i < 4; ++i) bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    out.write(bytes, 4);
+}
+
+void WriteDouble(std::ostream& out, double value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    WriteUInt64(out, bits);
+}
+
+void WriteString(std::ostream& out, const std::string& value)
+{
+    WriteUInt32(out, static_cast<std::uint32_t>(value.size()));
+    out.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+void WriteVector(std::ostream& out, const Eigen::VectorXd& value)
+{
+    WriteUInt32(out, static_cast<std::uint32_t>(value.size()));
+    for (int i = 0; i < value.size(); ++i) WriteDouble(out, value(i));
+}
+
+/// \brief Reads the values written above, throws if the log is truncated.
+class LogReader
+{
+public:
+    explicit LogReader(std::istream& in) : in_(in) {}
+
+    std::uint8_t UInt8()
+    {
+        char value;
+        if (!in_.get(value)) ThrowPretty("Truncated problem log");
+        return static_cast<std::uint8_t>(value);
+    }
+    std::uint32_t UInt32()
+    {
+        unsigned char bytes[4];
+        Read(reinterpret_cast<char*>(bytes), 4);
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) value |= static_cast<std::uint32_t>(bytes[i]) << (8 * i);
+        return value;
+    }
+    std::uint64_t UInt64()
+    {
+        unsigned char bytes[8];
+        Read(reinterpret_cast<char*>(bytes), 8);
+        std::uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) value |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+        return value;
+    }
+    double Double()
+    {
+        const std::uint64_t bits = UInt64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    std::string String()
+    {
+        std::string value(UInt32(), '\0');
+        if (!value.empty()) Read(&value[0], value.size());
+        return value;
+    }
+    Eigen::VectorXd Vector()
+    {
+        Eigen::VectorXd value(UInt32());
+        for (int i = 0; i < value.size(); ++i) value(i) = Double();
+        return value;
+    }
+
+private:
+    void Read(char* data, std::size_t size)
+    {
+        if (!in_.read(data, static_cast<std::streamsize>(size))) ThrowPretty("Truncated problem log");
+    }
+
+    std::istream& in_;
+};
+
+bool IsGoal(ProblemEventType type)
+{
+    return type == ProblemEventType::SetGoal || type == ProblemEventType::SetGoalEQ || type == ProblemEventType::SetGoalNEQ;
+}
+
+bool IsRho(ProblemEventType type)
+{
+    return type == ProblemEventType::SetRho || type == ProblemEventType::SetRhoEQ || type == ProblemEventType::SetRhoNEQ;
+}
+
+void ApplyGoal(const std::shared_ptr<PlanningProblem>& problem, const ProblemEvent& event)
+{
+    if (std::shared_ptr<AbstractTimeIndexedProblem> time_indexed_problem = std::dynamic_pointer_cast<AbstractTimeIndexedProblem>(problem))
+    {
+        switch (event.type)
+        {
+            case ProblemEventType::SetGoal:
+                return time_indexed_problem->SetGoal(event.task_name, event.value, event.t);
+            case ProblemEventType::SetGoalEQ:
+                return time_indexed_problem->SetGoalEQ(event.task_name, event.value, event.t);
+            case ProblemEventType::SetGoalNEQ:
+                return time_indexed_problem->SetGoalNEQ(event.task_name, event.value, event.t);
+            case ProblemEventType::SetRho:
+                return time_indexed_problem->SetRho(event.task_name, event.scalar, event.t);
+            case ProblemEventType::SetRhoEQ:
+                return time_indexed_problem->SetRhoEQ(event.task_name, event.scalar, event.t);
+            case ProblemEventType::SetRhoNEQ:
+                return time_indexed_problem->SetRhoNEQ(event.task_name, event.scalar, event.t);
+            default:
+                break;
+        }
+    }
+    else if (std::shared_ptr<EndPoseProblem> end_pose_problem = std::dynamic_pointer_cast<EndPoseProblem>(problem))
+    {
+        switch (event.type)
+        {
+            case ProblemEventType::SetGoal:
+                return end_pose_problem->SetGoal(event.task_name, event.value);
+            case ProblemEventType::SetGoalEQ:
+                return end_pose_problem->SetGoalEQ(event.task_name, event.value);
+            case ProblemEventType::SetGoalNEQ:
+                return end_pose_problem->SetGoalNEQ(event.task_name, event.value);
+            case ProblemEventType::SetRho:
+                return end_pose_problem->SetRho(event.task_name, event.scalar);
+            case ProblemEventType::SetRhoEQ:
+                return end_pose_problem->SetRhoEQ(event.task_name, event.scalar);
+            case ProblemEventType::SetRhoNEQ:
+                return end_pose_problem->SetRhoNEQ(event.task_name, event.scalar);
+            default:
+                break;
+        }
+    }
+    else if (std::shared_ptr<UnconstrainedEndPoseProblem> end_pose_problem = std::dynamic_pointer_cast<UnconstrainedEndPoseProblem>(problem))
+    {
+        if (event.type == ProblemEventType::SetGoal) return end_pose_problem->SetGoal(event.task_name, event.value);
+        if (event.type == ProblemEventType::SetRho) return end_pose_problem->SetRho(event.task_name, event.scalar);
+    }
+    else if (std::shared_ptr<BoundedEndPoseProblem> end_pose_problem = std::dynamic_pointer_cast<BoundedEndPoseProblem>(problem))
+    {
+        if (event.type == ProblemEventType::SetGoal) return end_pose_problem->SetGoal(event.task_name, event.value);
+        if (event.type == ProblemEventType::SetRho) return end_pose_problem->SetRho(event.task_name, event.scalar);
+    }
+    ThrowPretty("Can't replay event " << static_cast<int>(event.type) << " on a problem of type '" << problem->type() << "'!");
+}
+
+void ApplyUpdate(const std::shared_ptr<PlanningProblem>& problem, const ProblemEvent& event)
+{
+    if (std::shared_ptr<AbstractTimeIndexedProblem> time_indexed_problem = std::dynamic_pointer_cast<AbstractTimeIndexedProblem>(problem))
+    {
+        if (event.type == ProblemEventType::UpdateTrajectory)
+            time_indexed_problem->Update(event.value);
+        else
+            time_indexed_problem->Update(event.value, event.t);
+        return;
+    }
+    if (event.type == ProblemEventType::Update)
+    {
+        if (std::shared_ptr<EndPoseProblem> end_pose_problem = std::dynamic_pointer_cast<EndPoseProblem>(problem)) return end_pose_problem->Update(event.value);
+        if (std::shared_ptr<UnconstrainedEndPoseProblem> end_pose_problem = std::dynamic_pointer_cast<UnconstrainedEndPoseProblem>(problem)) return end_pose_problem->Update(event.value);
+        if (std::shared_ptr<BoundedEndPoseProblem> end_pose_problem = std::dynamic_pointer_cast<BoundedEndPoseProblem>(problem)) return end_pose_problem->Update(event.value);
+    }
+    ThrowPretty("Can't replay event " << static_cast<int>(event.type) << " on a problem of type '" << problem->type() << "'!");
+}
+}  // namespace
+
+ProblemRecorder::ProblemRecorder(const std::string& file_name) : out_(file_name, std::ios::binary | std::ios::trunc), start_(Now())
+{
+    if (!out_) ThrowPretty("Can't open '" << file_name << "' for writing");
+}
+
+ProblemRecorder::~ProblemRecorder()
+{
+    Flush();
+}
+
+void ProblemRecorder::Attach(PlanningProblem* problem)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (problem_ == problem) return;
+    if (problem_ != nullptr) ThrowPretty("The recorder is already recording another problem");
+    if (!problem_type_.empty())
+    {
+        if (problem->type() != problem_type_ || problem->N != problem_dimension_) ThrowPretty("The recorder has recorded a problem of type '" << problem_type_ << "' and dimension " << problem_dimension_ << ", got '" << problem->type() << "' of dimension " << problem->N);
+    }
+    else
+    {
+        problem_type_ = problem->type();
+        problem_dimension_ = problem->N;
+        out_.write(kMagic, 4);
+        WriteUInt32(out_, kFormatVersion);
+        WriteString(out_, problem_type_);
+        WriteUInt32(out_, static_cast<std::uint32_t>(problem_dimension_));
+    }
+    problem_ = problem;
+    world_version_ = -1;
+}
+
+void ProblemRecorder::Detach(PlanningProblem* problem)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (problem_ == problem) problem_ = nullptr;
+}
+
+void ProblemRecorder::AddSuppressDepth(int delta)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    suppress_depth_ += delta;
+}
+
+void ProblemRecorder::Write(const ProblemEvent& event)
+{
+    out_.put(static_cast<char>(event.type));
+    WriteUInt64(out_, static_cast<std::uint64_t>(event.time));
+    switch (event.type)
+    {
+        case ProblemEventType::SetStartState:
+        case ProblemEventType::UpdateTrajectory:
+            WriteVector(out_, event.value);
+            break;
+        case ProblemEventType::SetStartTime:
+            WriteDouble(out_, event.scalar);
+            break;
+        case ProblemEventType::Update:
+            WriteUInt32(out_, static_cast<std::uint32_t>(event.t));
+            WriteVector(out_, event.value);
+            break;
+        case ProblemEventType::PlanningScene:
+            WriteString(out_, event.data);
+            break;
+        default:
+            WriteString(out_, event.task_name);
+            WriteUInt32(out_, static_cast<std::uint32_t>(event.t));
+            if (IsGoal(event.type))
+                WriteVector(out_, event.value);
+            else
+                WriteDouble(out_, event.scalar);
+            break;
+    }
+    ++num_events_;
+}
+
+void ProblemRecorder::RecordVector(ProblemEventType type, Eigen::VectorXdRefConst value, int t)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!IsRecording()) return;
+    ProblemEvent event;
+    event.type = type;
+    event.time = Now() - start_;
+    event.value = value;
+    event.t = t;
+    Write(event);
+}
+
+void ProblemRecorder::RecordScalar(ProblemEventType type, double scalar)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!IsRecording()) return;
+    ProblemEvent event;
+    event.type = type;
+    event.time = Now() - start_;
+    event.scalar = scalar;
+    Write(event);
+}
+
+void ProblemRecorder::RecordGoal(ProblemEventType type, const std::string& task_name, Eigen::VectorXdRefConst goal, int t)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!IsRecording()) return;
+    ProblemEvent event;
+    event.type = type;
+    event.time = Now() - start_;
+    event.task_name = task_name;
+    event.value = goal;
+    event.t = t;
+    Write(event);
+}
+
+void ProblemRecorder::RecordRho(ProblemEventType type, const std::string& task_name, double rho, int t)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!IsRecording()) return;
+    ProblemEvent event;
+    event.type = type;
+    event.time = Now() - start_;
+    event.task_name = task_name;
+    event.scalar = rho;
+    event.t = t;
+    Write(event);
+}
+
+void ProblemRecorder::RecordUpdate(ProblemEventType type, Eigen::VectorXdRefConst x, int t)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!IsRecording()) return;
+    const ScenePtr scene = problem_->GetScene();
+    if (scene->GetWorldVersion() != world_version_)
+    {
+        world_version_ = scene->GetWorldVersion();
+        moveit_msgs::PlanningScene msg = scene->GetPlanningSceneMsg();
+        ProblemEvent event;
+        event.type = ProblemEventType::PlanningScene;
+        event.time = Now() - start_;
+        event.data.resize(ros::serialization::serializationLength(msg));
+        ros::serialization::OStream stream(reinterpret_cast<std::uint8_t*>(&event.data[0]), static_cast<std::uint32_t>(event.data.size()));
+        ros::serialization::serialize(stream, msg);
+        Write(event);
+    }
+
+    ProblemEvent event;
+    event.type = type;
+    event.time = Now() - start_;
+    event.value = x;
+    event.t = t;
+    Write(event);
+}
+
+void ProblemRecorder::Flush()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_.flush();
+}
+
+ProblemLog::ProblemLog(const std::string& file_name)
+{
+    std::ifstream in(file_name, std::ios::binary);
+    if (!in) ThrowPretty("Can't open '" << file_name << "'");
+    char magic[4];
+    if (!in.read(magic, 4) || std::memcmp(magic, kMagic, 4) != 0) ThrowPretty("'" << file_name << "' is not a problem log");
+
+    LogReader reader(in);
+    const std::uint32_t version = reader.UInt32();
+    if (version != kFormatVersion) ThrowPretty("Problem log version " << version << " is not supported, expecting " << kFormatVersion);
+    problem_type_ = reader.String();
+    problem_dimension_ = static_cast<int>(reader.UInt32());
+
+    while (in.peek() != std::char_traits<char>::eof())
+    {
+        ProblemEvent event;
+        event.type = static_cast<ProblemEventType>(reader.UInt8());
+        event.time = static_cast<std::int64_t>(reader.UInt64());
+        switch (event.type)
+        {
+            case ProblemEventType::SetStartState:
+            case ProblemEventType::UpdateTrajectory:
+                event.value = reader.Vector();
+                break;
+            case ProblemEventType::SetStartTime:
+                event.scalar = reader.Double();
+                break;
+            case ProblemEventType::Update:
+                event.t = static_cast<int>(reader.UInt32());
+                event.value = reader.Vector();
+                break;
+            case ProblemEventType::PlanningScene:
+                event.data = reader.String();
+                break;
+            default:
+                if (!IsGoal(event.type) && !IsRho(event.type)) ThrowPretty("Unknown event type " << static_cast<int>(event.type) << " in '" << file_name << "'");
+                event.task_name = reader.String();
+                event.t = static_cast<int>(reader.UInt32());
+                if (IsGoal(event.type))
+                    event.value = reader.Vector();
+                else
+                    event.scalar = reader.Double();
+                break;
+        }
+        events_.push_back(std::move(event));
+    }
+}
+
+std::vector<double> ProblemLog::Replay(const std::shared_ptr<PlanningProblem>& problem) const
+{
+    if (problem->type() != problem_type_) ThrowPretty("The log was recorded on a problem of type '" << problem_type_ << "', got '" << problem->type() << "'");
+    if (problem->N != problem_dimension_) ThrowPretty("The log was recorded on a problem of dimension " << problem_dimension_ << ", got " << problem->N);
+
+    std::vector<double> durations;
+    durations.reserve(events_.size());
+    for (const ProblemEvent& event : events_)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        switch (event.type)
+        {
+            case ProblemEventType::SetStartState:
+            {
+                EXOTICA_PROFILE_SCOPE("ProblemLog::SetStartState");
+                problem->SetStartState(event.value);
+            }
+            break;
+            case ProblemEventType::SetStartTime:
+                problem->SetStartTime(event.scalar);
+                break;
+            case ProblemEventType::Update:
+            {
+                EXOTICA_PROFILE_SCOPE("ProblemLog::Update");
+                ApplyUpdate(problem, event);
+            }
+            break;
+            case ProblemEventType::UpdateTrajectory:
+            {
+                EXOTICA_PROFILE_SCOPE("ProblemLog::UpdateTrajectory");
+                ApplyUpdate(problem, event);
+            }
+            break;
+            case ProblemEventType::PlanningScene:
+            {
+                EXOTICA_PROFILE_SCOPE("ProblemLog::PlanningScene");
+                moveit_msgs::PlanningScene msg;
+                ros::serialization::IStream stream(reinterpret_cast<std::uint8_t*>(const_cast<char*>(event.data.data())), static_cast<std::uint32_t>(event.data.size()));
+                ros::serialization::deserialize(stream, msg);
+                problem->GetScene()->UpdatePlanningScene(msg);
+            }
+            break;
+            default:
+            {
+                EXOTICA_PROFILE_SCOPE("ProblemLog::SetGoal");
+                ApplyGoal(problem, event);
+            }
+            break;
+        }
+        durations.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return durations;
+}
+}  // namespace exotica
@@ -0,0 +1,303 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+#include <exotica_core/tools/exception.h>
+#include <exotica_core/tools/profiler.h>
+
+// Defined by the hooks of exotica_allocation_tracking (allocation_tracking.cpp), null unless they are linked into the process
+extern "C" std::int64_t exotica_thread_allocations() __attribute__((weak));
+
+namespace exotica
+{
+namespace
+{
+std::int64_t SteadyClockNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void WriteJsonString(std::ostream& out, const char* str)
+{
+    out << '"';
+    for (const char* c = str; *c != '\0'; ++c)
+    {
+        switch (*c)
+        {
+            case '"':
+                out << "\\\"";
+                break;
+            case '\\':
+                out << "\\\\";
+                break;
+            default:
+                if (static_cast<unsigned char>(*c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(*c));
+                    out << escaped;
+                }
+                else
+                {
+                    out << *c;
+                }
+        }
+    }
+    out << '"';
+}
+}  // namespace
+
+Profiler::Profiler() : epoch_(SteadyClockNanoseconds())
+{
+}
+
+Profiler& Profiler::Instance()
+{
+    // Never destroyed: zones may still be closed by threads exiting after static destruction started
+    static Profiler* profiler = new Profiler();
+    return *profiler;
+}
+
+bool Profiler::IsCompiledIn()
+{
+#ifdef EXOTICA_ENABLE_PROFILING
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Profiler::IsAllocationTrackingLoaded()
+{
+    return exotica_thread_allocations != nullptr;
+}
+
+std::int64_t Profiler::GetThreadAllocations()
+{
+    return exotica_thread_allocations != nullptr ? exotica_thread_allocations() : 0;
+}
+
+std::int64_t Profiler::Now() const
+{
+    return SteadyClockNanoseconds() - epoch_;
+}
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+{
+    // Shared with the profiler, such that the events outlive the thread
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer)
+    {
+        buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffer->thread = next_thread_++;
+        buffers_.push_back(buffer);
+    }
+    return *buffer;
+}
+
+std::size_t Profiler::GetNumberOfDroppedEvents() const
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    std::size_t dropped = 0;
+    for (const auto& buffer : buffers_)
+    {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        dropped += buffer->dropped;
+    }
+    return dropped;
+}
+
+void Profiler::Clear()
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    for (const auto& buffer : buffers_)
+    {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        buffer->events.clear();
+        buffer->dropped = 0;
+    }
+    // Release the buffers of threads that exited
+    buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(), [](const std::shared_ptr<ThreadBuffer>& buffer) { return buffer.use_count() == 1; }), buffers_.end());
+}
+
+std::vector<ProfileEvent> Profiler::GetEvents() const
+{
+    std::vector<ProfileEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        for (const auto& buffer : buffers_)
+        {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            events.insert(events.end(), buffer->events.begin(), buffer->events.end());
+        }
+    }
+    // Events are recorded when they end, order enclosing zones before the nested ones
+    std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+        if (a.start != b.start) return a.start < b.start;
+        return a.depth < b.depth;
+    });
+    return events;
+}
+
+std::vector<ProfileZoneStatistics> Profiler::GetStatistics() const
+{
+    std::map<std::string, ProfileZoneStatistics> zones;
+    for (const ProfileEvent& event : GetEvents())
+    {
+        const double duration = 1e-9 * static_cast<double>(event.duration);
+        ProfileZoneStatistics& zone = zones[event.name];
+        if (zone.count == 0)
+        {
+            zone.name = event.name;
+            zone.min = duration;
+            zone.max = duration;
+        }
+        ++zone.count;
+        zone.total += duration;
+        zone.self += 1e-9 * static_cast<double>(event.self);
+        zone.min = std::min(zone.min, duration);
+        zone.max = std::max(zone.max, duration);
+        zone.allocations += event.allocations;
+        zone.self_allocations += event.self_allocations;
+        zone.max_allocations = std::max(zone.max_allocations, event.allocations);
+    }
+
+    std::vector<ProfileZoneStatistics> statistics;
+    statistics.reserve(zones.size());
+    for (auto& it : zones)
+    {
+        it.second.mean = it.second.total / static_cast<double>(it.second.count);
+        statistics.push_back(it.second);
+    }
+    std::sort(statistics.begin(), statistics.end(), [](const ProfileZoneStatistics& a, const ProfileZoneStatistics& b) { return a.total > b.total; });
+    return statistics;
+}
+
+std::string Profiler::GetStatisticsTable() const
+{
+    const std::vector<ProfileZoneStatistics> statistics = GetStatistics();
+    std::size_t name_width = 4;
+    for (const ProfileZoneStatistics& zone : statistics) name_width = std::max(name_width, zone.name.size());
+
+    std::ostringstream table;
+    table << std::left << std::setw(static_cast<int>(name_width)) << "Zone" << std::right
+          << std::setw(10) << "Count" << std::setw(14) << "Total (ms)" << std::setw(14) << "Self (ms)"
+          << std::setw(14) << "Mean (us)" << std::setw(14) << "Min (us)" << std::setw(14) << "Max (us)";
+    if (IsAllocationTrackingLoaded()) table << std::setw(14) << "Allocations" << std::setw(14) << "Self allocs" << std::setw(14) << "Max allocs";
+    table << '\n';
+    table << std::fixed << std::setprecision(3);
+    for (const ProfileZoneStatistics& zone : statistics)
+    {
+        table << std::left << std::setw(static_cast<int>(name_width)) << zone.name << std::right
+              << std::setw(10) << zone.count << std::setw(14) << 1e3 * zone.total << std::setw(14) << 1e3 * zone.self
+              << std::setw(14) << 1e6 * zone.mean << std::setw(14) << 1e6 * zone.min << std::setw(14) << 1e6 * zone.max;
+        if (IsAllocationTrackingLoaded()) table << std::setw(14) << zone.allocations << std::setw(14) << zone.self_allocations << std::setw(14) << zone.max_allocations;
+        table << '\n';
+    }
+    return table.str();
+}
+
+std::string Profiler::GetChromeTrace() const
+{
+    std::ostringstream trace;
+    trace << std::fixed << std::setprecision(3);
+    trace << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (const ProfileEvent& event : GetEvents())
+    {
+        if (!first) trace << ',';
+        first = false;
+        // Complete events, timestamps and durations in microseconds
+        trace << "{\"name\":";
+        WriteJsonString(trace, event.name);
+        trace << ",\"cat\":\"exotica\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+              << ",\"ts\":" << 1e-3 * static_cast<double>(event.start)
+              << ",\"dur\":" << 1e-3 * static_cast<double>(event.duration);
+        if (IsAllocationTrackingLoaded()) trace << ",\"args\":{\"allocations\":" << event.allocations << ",\"self_allocations\":" << event.self_allocations << '}';
+        trace << '}';
+    }
+    trace << "]}";
+    return trace.str();
+}
+
+void Profiler::SaveChromeTrace(const std::string& file_name) const
+{
+    std::ofstream file(file_name);
+    if (!file.is_open()) ThrowPretty("Can't open file '" << file_name << "' for writing.");
+    file << GetChromeTrace();
+}
+
+ProfileZone::ProfileZone(const char* name) : name_(name)
+{
+    Profiler& profiler = Profiler::Instance();
+    if (!profiler.IsEnabled()) return;
+    buffer_ = &profiler.GetThreadBuffer();
+    if (buffer_->nested_durations.size() <= static_cast<std::size_t>(buffer_->depth))
+    {
+        buffer_->nested_durations.resize(buffer_->depth + 1);
+        buffer_->nested_allocations.resize(buffer_->depth + 1);
+    }
+    buffer_->nested_durations[buffer_->depth] = 0;
+    buffer_->nested_allocations[buffer_->depth] = 0;
+    ++buffer_->depth;
+    start_allocations_ = Profiler::GetThreadAllocations();
+    start_ = profiler.Now();
+}
+
+ProfileZone::~ProfileZone()
+{
+    if (buffer_ == nullptr) return;
+    Profiler& profiler = Profiler::Instance();
+    const std::int64_t duration = profiler.Now() - start_;
+    const std::int64_t allocations = Profiler::GetThreadAllocations() - start_allocations_;
+    const int depth = --buffer_->depth;
+    if (depth > 0)
+    {
+        buffer_->nested_durations[depth - 1] += duration;
+        buffer_->nested_allocations[depth - 1] += allocations;
+    }
+
+    const std::size_t max_events = profiler.max_events_per_thread_;
+    std::lock_guard<std::mutex> lock(buffer_->mutex);
+    if (max_events > 0 && buffer_->events.size() >= max_events)
+    {
+        ++buffer_->dropped;
+        return;
+    }
+    buffer_->events.push_back({name_, start_, duration, duration - buffer_->nested_durations[depth], allocations, allocations - buffer_->nested_allocations[depth], depth, buffer_->thread});
+}
+}  // namespace exotica
@@ -0,0 +1,208 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <exotica_core/tools/exception.h>
+#include <exotica_core/tools/thread_pool.h>
+
+namespace exotica
+{
+namespace
+{
+// The pool and the index of the worker running on this thread
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local int current_worker = -1;
+}  // namespace
+
+ThreadPool::ThreadPool(int num_threads, bool pin_threads, bool deterministic) : deterministic_(deterministic)
+{
+    if (num_threads < 0) ThrowPretty("The number of threads has to be non-negative, given: " << num_threads);
+    if (deterministic_) return;
+
+    for (int i = 0; i < num_threads; ++i) queues_.emplace_back(new TaskQueue);
+    for (int i = 0; i < num_threads; ++i)
+    {
+        threads_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+#ifdef __linux__
+        if (pin_threads)
+        {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(i % std::max(1u, std::thread::hardware_concurrency()), &cpu_set);
+            pthread_setaffinity_np(threads_.back().native_handle(), sizeof(cpu_set_t), &cpu_set);
+        }
+#endif
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    for (std::thread& thread : threads_) thread.join();
+}
+
+int ThreadPool::GetWorkerIndex() const
+{
+    return current_pool == this ? current_worker : -1;
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+    if (threads_.empty())
+    {
+        task();
+        return;
+    }
+
+    int worker = GetWorkerIndex();
+    if (worker < 0) worker = static_cast<int>(next_queue_++ % queues_.size());
+    {
+        std::lock_guard<std::mutex> lock(queues_[worker]->mutex);
+        queues_[worker]->tasks.emplace_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++num_pending_tasks_;
+    }
+    condition_.notify_one();
+}
+
+bool ThreadPool::RunPendingTask(int worker)
+{
+    std::function<void()> task;
+    const int num_queues = static_cast<int>(queues_.size());
+    if (worker >= 0)
+    {
+        std::lock_guard<std::mutex> lock(queues_[worker]->mutex);
+        if (!queues_[worker]->tasks.empty())
+        {
+            task = std::move(queues_[worker]->tasks.back());
+            queues_[worker]->tasks.pop_back();
+        }
+    }
+    for (int i = 1; !task && i <= num_queues; ++i)
+    {
+        TaskQueue& queue = *queues_[(std::max(worker, 0) + i) % num_queues];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task) return false;
+
+    --num_pending_tasks_;
+    task();
+    return true;
+}
+
+void ThreadPool::WorkerLoop(int worker)
+{
+    current_pool = this;
+    current_worker = worker;
+    while (true)
+    {
+        if (RunPendingTask(worker)) continue;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() { return stop_ || num_pending_tasks_ > 0; });
+        if (stop_ && num_pending_tasks_ <= 0) return;
+    }
+}
+
+void ThreadPool::ParallelFor(int begin, int end, const std::function<void(int)>& body, int grain_size)
+{
+    if (end <= begin) return;
+    if (grain_size < 1) grain_size = 1;
+    const int num_chunks = (end - begin + grain_size - 1) / grain_size;
+    if (threads_.empty() || num_chunks == 1)
+    {
+        for (int i = begin; i < end; ++i) body(i);
+        return;
+    }
+
+    // The helpers may start after all chunks are done, so they share the state instead of referencing this stack frame
+    struct State
+    {
+        std::atomic<int> next_chunk{0};
+        std::atomic<int> remaining_chunks{0};
+        std::mutex mutex;
+        std::condition_variable done;  ///< Notified when the last chunk has returned
+        std::exception_ptr exception;
+    };
+    std::shared_ptr<State> state = std::make_shared<State>();
+    state->remaining_chunks = num_chunks;
+    const std::function<void(int)>* body_pointer = &body;
+    const std::function<void()> run_chunks = [state, body_pointer, begin, end, grain_size, num_chunks]() {
+        int chunk;
+        while ((chunk = state->next_chunk++) < num_chunks)
+        {
+            try
+            {
+                const int chunk_end = std::min(end, begin + (chunk + 1) * grain_size);
+                for (int i = begin + chunk * grain_size; i < chunk_end; ++i) (*body_pointer)(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->exception) state->exception = std::current_exception();
+            }
+            if (--state->remaining_chunks == 0)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->done.notify_all();
+            }
+        }
+    };
+
+    const int num_helpers = std::min(GetNumThreads(), num_chunks - 1);
+    for (int i = 0; i < num_helpers; ++i) Enqueue(run_chunks);
+    run_chunks();
+
+    // All chunks have been claimed, those claimed by helpers may still be running. No other tasks are run in the meantime:
+    // the caller may hold locks or thread-local workspaces which these tasks use, too. The helpers do not wait for this
+    // thread, so this cannot deadlock, also not when they run nested loops.
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&state]() { return state->remaining_chunks == 0; });
+    }
+    if (state->exception) std::rethrow_exception(state->exception);
+}
+}  // namespace exotica
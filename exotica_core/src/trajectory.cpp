@@ -27,6 +27,8 @@
 // POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <kdl/path.hpp>
 #include <kdl/path_line.hpp>
@@ -39,11 +41,78 @@
 #include <kdl/velocityprofile_spline.hpp>
 #include <string>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
 #include <exotica_core/tools.h>
 #include <exotica_core/trajectory.h>
 
 namespace exotica
 {
+// Trajectory files store a header with the joint names, the time step and the number of controls, followed by one
+// record per trajectory: its number of states and controls and then the states and controls, row-major (i.e. contiguous
+// per time step). All fields are aligned to 8 bytes, so the records can be used directly from the memory-mapped file.
+constexpr char kTrajectoryFileMagic[8] = {'E', 'X', 'O', 'T', 'R', 'A', 'J', 'S'};
+constexpr uint32_t kTrajectoryFileVersion = 1;
+constexpr uint32_t kTrajectoryFileByteOrder = 0x01020304;
+
+namespace
+{
+void WriteAligned(std::ofstream& file, const void* data, std::size_t size)
+{
+    static const char padding[8] = {};
+    file.write(reinterpret_cast<const char*>(data), size);
+    file.write(padding, ((size + 7) & ~std::size_t(7)) - size);
+}
+
+template <typename T>
+void WriteAligned(std::ofstream& file, const T& value)
+{
+    WriteAligned(file, &value, sizeof(T));
+}
+
+struct TrajectoryFileParser
+{
+    TrajectoryFileParser(const char* data, std::size_t size) : data(data), size(size) {}
+
+    // Sizes read from the file are untrusted, hence compared against the remaining size without overflowing
+    bool CanRead(std::size_t n) const
+    {
+        return n <= size - position && ((n + 7) & ~std::size_t(7)) <= size - position;
+    }
+
+    std::size_t Remaining() const
+    {
+        return size - position;
+    }
+
+    const char* Skip(std::size_t n)
+    {
+        if (!CanRead(n)) ThrowPretty("Trajectory file is truncated");
+        const char* ret = data + position;
+        position += (n + 7) & ~std::size_t(7);
+        return ret;
+    }
+
+    template <typename T>
+    T Read()
+    {
+        T value;
+        std::memcpy(&value, Skip(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    const char* data;
+    std::size_t size;
+    std::size_t position = 0;
+};
+}  // namespace
+
 Trajectory::Trajectory() : radius_(1.0), trajectory_(nullptr)
 {
 }
@@ -139,4 +208,385 @@ void Trajectory::ConstructFromData(Eigen::MatrixXdRefConst data, double radius)
     data_ = data;
     radius_ = radius;
 }
+
+void SplineTrajectory::Initialize(Eigen::VectorXdRefConst times, Eigen::MatrixXdRefConst knots)
+{
+    if (times.size() < 2) ThrowPretty("A spline trajectory needs at least 2 knots, got " << times.size());
+    if (knots.rows() != times.size()) ThrowPretty("Wrong number of knots: " << knots.rows() << ", expected " << times.size());
+    if (knots.cols() == 0) ThrowPretty("The knots are empty!");
+    for (int i = 0; i < times.size() - 1; ++i)
+    {
+        if (!(times(i + 1) > times(i))) ThrowPretty("Time indices must be monotonically increasing! " << i << " (" << times(i + 1) - times(i) << ")");
+    }
+    times_ = times;
+    knots_ = knots;
+
+    const double dt = times(1) - times(0);
+    uniform_ = true;
+    for (int i = 1; i < times.size() - 1 && uniform_; ++i) uniform_ = std::abs(times(i + 1) - times(i) - dt) <= 1e-9 * dt;
+    inverse_dt_ = 1.0 / dt;
+}
+
+SplineTrajectory::SplineTrajectory(Eigen::VectorXdRefConst times, Eigen::MatrixXdRefConst knots, SplineType type)
+    : type_(type)
+{
+    Initialize(times, knots);
+    const int n = static_cast<int>(times.size());
+    const Eigen::VectorXd h = times_.tail(n - 1) - times_.head(n - 1);
+
+    if (type == Cubic)
+    {
+        // Second derivatives at the knots of the natural spline, solving the tridiagonal system for all dimensions at once.
+        Eigen::MatrixXd second_derivatives = Eigen::MatrixXd::Zero(n, knots.cols());
+        if (n > 2)
+        {
+            Eigen::VectorXd diagonal(n - 2);
+            Eigen::MatrixXd rhs(n - 2, knots.cols());
+            for (int i = 1; i < n - 1; ++i)
+            {
+                diagonal(i - 1) = 2.0 * (h(i - 1) + h(i));
+                rhs.row(i - 1) = 6.0 * ((knots_.row(i + 1) - knots_.row(i)) / h(i) - (knots_.row(i) - knots_.row(i - 1)) / h(i - 1));
+            }
+            for (int i = 1; i < n - 2; ++i)
+            {
+                const double w = h(i) / diagonal(i - 1);
+                diagonal(i) -= w * h(i);
+                rhs.row(i) -= w * rhs.row(i - 1);
+            }
+            second_derivatives.row(n - 2) = rhs.row(n - 3) / diagonal(n - 3);
+            for (int i = n - 4; i >= 0; --i)
+            {
+                second_derivatives.row(i + 1) = (rhs.row(i) - h(i + 1) * second_derivatives.row(i + 2)) / diagonal(i);
+            }
+        }
+
+        coefficients_.assign(4, Eigen::MatrixXd(knots.cols(), n - 1));
+        for (int s = 0; s < n - 1; ++s)
+        {
+            coefficients_[0].col(s) = knots_.row(s).transpose();
+            coefficients_[1].col(s) = ((knots_.row(s + 1) - knots_.row(s)) / h(s) - h(s) * (2.0 * second_derivatives.row(s) + second_derivatives.row(s + 1)) / 6.0).transpose();
+            coefficients_[2].col(s) = 0.5 * second_derivatives.row(s).transpose();
+            coefficients_[3].col(s) = ((second_derivatives.row(s + 1) - second_derivatives.row(s)) / (6.0 * h(s))).transpose();
+        }
+    }
+    else if (type == Quintic)
+    {
+        // Central finite differences in the interior, one-sided velocities and the neighbouring accelerations at the ends.
+        Eigen::MatrixXd velocities(n, knots.cols());
+        Eigen::MatrixXd accelerations = Eigen::MatrixXd::Zero(n, knots.cols());
+        velocities.row(0) = (knots_.row(1) - knots_.row(0)) / h(0);
+        velocities.row(n - 1) = (knots_.row(n - 1) - knots_.row(n - 2)) / h(n - 2);
+        for (int i = 1; i < n - 1; ++i)
+        {
+            velocities.row(i) = (knots_.row(i + 1) - knots_.row(i - 1)) / (h(i - 1) + h(i));
+            accelerations.row(i) = 2.0 * ((knots_.row(i + 1) - knots_.row(i)) / h(i) - (knots_.row(i) - knots_.row(i - 1)) / h(i - 1)) / (h(i - 1) + h(i));
+        }
+        if (n > 2)
+        {
+            accelerations.row(0) = accelerations.row(1);
+            accelerations.row(n - 1) = accelerations.row(n - 2);
+        }
+        ConstructQuintic(velocities, accelerations);
+    }
+    else
+    {
+        ThrowPretty("Unknown spline type: " << type);
+    }
+}
+
+SplineTrajectory::SplineTrajectory(Eigen::VectorXdRefConst times, Eigen::MatrixXdRefConst knots, Eigen::MatrixXdRefConst velocities, Eigen::MatrixXdRefConst accelerations)
+    : type_(Quintic)
+{
+    Initialize(times, knots);
+    if (velocities.rows() != knots.rows() || velocities.cols() != knots.cols()) ThrowPretty("Wrong size of velocities: " << velocities.rows() << "x" << velocities.cols() << ", expected " << knots.rows() << "x" << knots.cols());
+    if (accelerations.rows() != knots.rows() || accelerations.cols() != knots.cols()) ThrowPretty("Wrong size of accelerations: " << accelerations.rows() << "x" << accelerations.cols() << ", expected " << knots.rows() << "x" << knots.cols());
+    ConstructQuintic(velocities, accelerations);
+}
+
+void SplineTrajectory::ConstructQuintic(Eigen::MatrixXdRefConst velocities, Eigen::MatrixXdRefConst accelerations)
+{
+    const int n = static_cast<int>(times_.size());
+    coefficients_.assign(6, Eigen::MatrixXd(knots_.cols(), n - 1));
+    for (int s = 0; s < n - 1; ++s)
+    {
+        const double h = times_(s + 1) - times_(s);
+        const Eigen::VectorXd dp = (knots_.row(s + 1) - knots_.row(s)).transpose();
+        const Eigen::VectorXd v0 = velocities.row(s).transpose(), v1 = velocities.row(s + 1).transpose();
+        const Eigen::VectorXd a0 = accelerations.row(s).transpose(), a1 = accelerations.row(s + 1).transpose();
+        coefficients_[0].col(s) = knots_.row(s).transpose();
+        coefficients_[1].col(s) = v0;
+        coefficients_[2].col(s) = 0.5 * a0;
+        coefficients_[3].col(s) = (20.0 * dp - (8.0 * v1 + 12.0 * v0) * h - (3.0 * a0 - a1) * h * h) / (2.0 * h * h * h);
+        coefficients_[4].col(s) = (-30.0 * dp + (14.0 * v1 + 16.0 * v0) * h + (3.0 * a0 - 2.0 * a1) * h * h) / (2.0 * h * h * h * h);
+        coefficients_[5].col(s) = (12.0 * dp - 6.0 * (v1 + v0) * h - (a0 - a1) * h * h) / (2.0 * h * h * h * h * h);
+    }
+}
+
+int SplineTrajectory::FindSegment(double t, double& tau) const
+{
+    const int num_segments = GetNumberOfSegments();
+    t = std::min(std::max(t, times_(0)), times_(num_segments));
+    int segment;
+    if (uniform_)
+    {
+        segment = static_cast<int>((t - times_(0)) * inverse_dt_);
+    }
+    else
+    {
+        segment = static_cast<int>(std::upper_bound(times_.data(), times_.data() + num_segments + 1, t) - times_.data()) - 1;
+    }
+    segment = std::min(std::max(segment, 0), num_segments - 1);
+    tau = t - times_(segment);
+    return segment;
+}
+
+void SplineTrajectory::Evaluate(int derivative, double t, Eigen::VectorXdRef value) const
+{
+    if (coefficients_.empty()) ThrowPretty("The spline trajectory is empty!");
+    if (value.size() != knots_.cols()) ThrowPretty("Wrong size of output: " << value.size() << ", expected " << knots_.cols());
+    double tau;
+    const int segment = FindSegment(t, tau);
+    const int order = static_cast<int>(coefficients_.size()) - 1;
+    if (derivative > order)
+    {
+        value.setZero();
+        return;
+    }
+
+    // Horner's scheme on the coefficients of the derivative, d^d/dtau^d tau^k = k! / (k - d)! tau^(k - d)
+    const auto falling_factorial = [derivative](int k) {
+        double factor = 1.0;
+        for (int j = 0; j < derivative; ++j) factor *= k - j;
+        return factor;
+    };
+    value = falling_factorial(order) * coefficients_[order].col(segment);
+    for (int k = order - 1; k >= derivative; --k)
+    {
+        value = value * tau + falling_factorial(k) * coefficients_[k].col(segment);
+    }
+}
+
+Eigen::MatrixXd SplineTrajectory::Evaluate(int derivative, Eigen::VectorXdRefConst times) const
+{
+    Eigen::MatrixXd values(knots_.cols(), times.size());
+    for (int i = 0; i < times.size(); ++i)
+    {
+        Evaluate(derivative, times(i), values.col(i));
+    }
+    return values.transpose();
+}
+
+void SplineTrajectory::GetPosition(double t, Eigen::VectorXdRef position) const
+{
+    Evaluate(0, t, position);
+}
+
+void SplineTrajectory::GetVelocity(double t, Eigen::VectorXdRef velocity) const
+{
+    Evaluate(1, t, velocity);
+}
+
+void SplineTrajectory::GetAcceleration(double t, Eigen::VectorXdRef acceleration) const
+{
+    Evaluate(2, t, acceleration);
+}
+
+Eigen::VectorXd SplineTrajectory::GetPosition(double t) const
+{
+    Eigen::VectorXd position(knots_.cols());
+    Evaluate(0, t, position);
+    return position;
+}
+
+Eigen::VectorXd SplineTrajectory::GetVelocity(double t) const
+{
+    Eigen::VectorXd velocity(knots_.cols());
+    Evaluate(1, t, velocity);
+    return velocity;
+}
+
+Eigen::VectorXd SplineTrajectory::GetAcceleration(double t) const
+{
+    Eigen::VectorXd acceleration(knots_.cols());
+    Evaluate(2, t, acceleration);
+    return acceleration;
+}
+
+Eigen::MatrixXd SplineTrajectory::GetPositions(Eigen::VectorXdRefConst times) const
+{
+    return Evaluate(0, times);
+}
+
+Eigen::MatrixXd SplineTrajectory::GetVelocities(Eigen::VectorXdRefConst times) const
+{
+    return Evaluate(1, times);
+}
+
+Eigen::MatrixXd SplineTrajectory::GetAccelerations(Eigen::VectorXdRefConst times) const
+{
+    return Evaluate(2, times);
+}
+
+TrajectoryFileWriter::TrajectoryFileWriter(const std::string& file_name, const std::vector<std::string>& joint_names, double dt, int num_controls)
+    : file_name_(ParsePath(file_name)), num_joints_(static_cast<int>(joint_names.size())), num_controls_(num_controls)
+{
+    if (joint_names.empty()) ThrowPretty("No joint names given!");
+    if (dt <= 0.0) ThrowPretty("Invalid time step: " << dt);
+    if (num_controls < 0) ThrowPretty("Invalid number of controls: " << num_controls);
+
+    file_.open(file_name_, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open()) ThrowPretty("Cant write file '" << file_name_ << "'!");
+    WriteAligned(file_, kTrajectoryFileMagic, sizeof(kTrajectoryFileMagic));
+    WriteAligned<uint32_t>(file_, kTrajectoryFileVersion);
+    WriteAligned<uint32_t>(file_, kTrajectoryFileByteOrder);
+    WriteAligned<uint64_t>(file_, joint_names.size());
+    for (const std::string& name : joint_names)
+    {
+        WriteAligned<uint64_t>(file_, name.size());
+        WriteAligned(file_, name.data(), name.size());
+    }
+    WriteAligned<double>(file_, dt);
+    WriteAligned<uint64_t>(file_, num_controls);
+    Flush();
+}
+
+TrajectoryFileWriter::~TrajectoryFileWriter()
+{
+    if (file_.is_open()) file_.close();
+}
+
+void TrajectoryFileWriter::Write(Eigen::MatrixXdRefConst states)
+{
+    if (num_controls_ > 0) ThrowPretty("The trajectories of '" << file_name_ << "' require controls!");
+    Write(states, Eigen::MatrixXd(0, 0));
+}
+
+void TrajectoryFileWriter::Write(Eigen::MatrixXdRefConst states, Eigen::MatrixXdRefConst controls)
+{
+    if (!file_.is_open()) ThrowPretty("Trajectory file '" << file_name_ << "' has been closed!");
+    if (states.cols() != num_joints_) ThrowPretty("Wrong number of joints: " << states.cols() << ", expected " << num_joints_);
+    if (num_controls_ == 0 && controls.size() > 0) ThrowPretty("The trajectories of '" << file_name_ << "' have no controls!");
+    if (num_controls_ > 0 && controls.rows() == 0) ThrowPretty("The trajectories of '" << file_name_ << "' require controls!");
+    if (controls.rows() > 0 && controls.cols() != num_controls_) ThrowPretty("Wrong number of controls: " << controls.cols() << ", expected " << num_controls_);
+
+    WriteAligned<uint64_t>(file_, states.rows());
+    WriteAligned<uint64_t>(file_, controls.rows());
+    buffer_ = states;
+    WriteAligned(file_, buffer_.data(), sizeof(double) * buffer_.size());
+    if (controls.rows() > 0)
+    {
+        buffer_ = controls;
+        WriteAligned(file_, buffer_.data(), sizeof(double) * buffer_.size());
+    }
+    if (!file_) ThrowPretty("Failed to write to '" << file_name_ << "'!");
+    ++num_trajectories_;
+}
+
+void TrajectoryFileWriter::Flush()
+{
+    file_.flush();
+}
+
+void TrajectoryFileWriter::Close()
+{
+    file_.close();
+}
+
+TrajectoryFileReader::TrajectoryFileReader(const std::string& file_name)
+{
+    const std::string path = ParsePath(file_name);
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) ThrowPretty("Cant read file '" << path << "'!");
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        close(fd);
+        ThrowPretty("Cant read file '" << path << "'!");
+    }
+    size_ = static_cast<std::size_t>(file_stat.st_size);
+    void* mapping = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping stays valid
+    if (mapping == MAP_FAILED) ThrowPretty("Failed to map file '" << path << "'!");
+    data_ = static_cast<const char*>(mapping);
+
+    try
+    {
+        TrajectoryFileParser in(data_, size_);
+        if (!in.CanRead(sizeof(kTrajectoryFileMagic)) || std::memcmp(in.Skip(sizeof(kTrajectoryFileMagic)), kTrajectoryFileMagic, sizeof(kTrajectoryFileMagic)) != 0) ThrowPretty("'" << path << "' is not a trajectory file!");
+        const uint32_t version = in.Read<uint32_t>();
+        if (version != kTrajectoryFileVersion) ThrowPretty("Unsupported trajectory file version " << version << ", expected " << kTrajectoryFileVersion);
+        if (in.Read<uint32_t>() != kTrajectoryFileByteOrder) ThrowPretty("The trajectory file was written on a machine with a different byte order");
+        // Each joint name takes at least its length field
+        const uint64_t num_joints_in_file = in.Read<uint64_t>();
+        if (num_joints_in_file == 0 || num_joints_in_file > in.Remaining() / sizeof(uint64_t)) ThrowPretty("Invalid number of joints " << num_joints_in_file << " in trajectory file '" << path << "'!");
+        joint_names_.resize(num_joints_in_file);
+        for (std::string& name : joint_names_)
+        {
+            const uint64_t length = in.Read<uint64_t>();
+            name.assign(in.Skip(length), length);
+        }
+        dt_ = in.Read<double>();
+        if (!(dt_ > 0.0) || !std::isfinite(dt_)) ThrowPretty("Invalid time step " << dt_ << " in trajectory file '" << path << "'!");
+        const uint64_t num_controls_in_file = in.Read<uint64_t>();
+        if (num_controls_in_file > static_cast<uint64_t>(std::numeric_limits<int>::max())) ThrowPretty("Invalid number of controls " << num_controls_in_file << " in trajectory file '" << path << "'!");
+        num_controls_ = static_cast<int>(num_controls_in_file);
+
+        // Index the complete records
+        const std::size_t num_joints = joint_names_.size();
+        while (in.CanRead(2 * sizeof(uint64_t)))
+        {
+            const std::size_t record_start = in.position;
+            Record record;
+            const uint64_t num_states = in.Read<uint64_t>();
+            const uint64_t num_controls = in.Read<uint64_t>();
+            // Counts that can not fit into the file indicate an incomplete record, but must not overflow the sizes below
+            const std::size_t max_rows = in.Remaining() / sizeof(double);
+            if (num_states > max_rows / num_joints || (num_controls_ > 0 && num_controls > max_rows / num_controls_) || (num_controls_ == 0 && num_controls > 0))
+            {
+                in.position = record_start;
+                break;
+            }
+            record.num_states = static_cast<Eigen::Index>(num_states);
+            record.num_controls = static_cast<Eigen::Index>(num_controls);
+            const std::size_t states_size = sizeof(double) * num_states * num_joints;
+            const std::size_t controls_size = sizeof(double) * num_controls * num_controls_;
+            if (!in.CanRead(states_size + controls_size))
+            {
+                in.position = record_start;
+                break;
+            }
+            record.states = reinterpret_cast<const double*>(in.Skip(states_size));
+            record.controls = reinterpret_cast<const double*>(in.Skip(controls_size));
+            records_.push_back(record);
+        }
+    }
+    catch (...)
+    {
+        munmap(const_cast<char*>(data_), size_);
+        throw;
+    }
+}
+
+TrajectoryFileReader::~TrajectoryFileReader()
+{
+    if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+}
+
+const TrajectoryFileReader::Record& TrajectoryFileReader::GetRecord(std::size_t index) const
+{
+    if (index >= records_.size()) ThrowPretty("Invalid trajectory index " << index << ", the file contains " << records_.size() << " trajectories");
+    return records_[index];
+}
+
+TrajectoryFileData TrajectoryFileReader::GetStates(std::size_t index) const
+{
+    const Record& record = GetRecord(index);
+    return TrajectoryFileData(record.states, record.num_states, static_cast<Eigen::Index>(joint_names_.size()));
+}
+
+TrajectoryFileData TrajectoryFileReader::GetControls(std::size_t index) const
+{
+    const Record& record = GetRecord(index);
+    return TrajectoryFileData(record.controls, record.num_controls, num_controls_);
+}
 }  // namespace exotica
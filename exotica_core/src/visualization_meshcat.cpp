@@ -82,10 +82,16 @@ VisualizationMeshcat::VisualizationMeshcat(ScenePtr scene, const std::string& ur
     HIGHLIGHT_NAMED("VisualizationMeshcat", "Initialising visualizer");
     Initialize(use_mesh_materials);
 }
-VisualizationMeshcat::~VisualizationMeshcat() = default;
+VisualizationMeshcat::~VisualizationMeshcat()
+{
+    StopSendThread();
+}
 
 void VisualizationMeshcat::Initialize(bool use_mesh_materials)
 {
+    // The socket is used synchronously until the send thread is started again
+    StopSendThread();
+
     // Connecting twice as per comment at:
     // https://github.com/rdeits/meshcat-python/blob/aa3865143120f5ace8e62aab71d825e33674d277/src/meshcat/visualizer.py#L60
     ConnectZMQ();
@@ -103,6 +109,86 @@ void VisualizationMeshcat::Initialize(bool use_mesh_materials)
     if (web_url_.size() > 7) file_url_ = web_url_.substr(0, web_url_.size() - 7) + "files/";
     ConnectZMQ();
     path_prefix_ = "/exotica/" + scene_->GetName() + "/";
+    displayed_objects_.clear();
+    StartSendThread();
+}
+
+void VisualizationMeshcat::StartSendThread()
+{
+    stop_ = false;
+    send_thread_ = std::thread(&VisualizationMeshcat::SendLoop, this);
+}
+
+void VisualizationMeshcat::StopSendThread()
+{
+    if (!send_thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stop_ = true;
+    }
+    queue_condition_.notify_all();
+    send_thread_.join();
+}
+
+void VisualizationMeshcat::SendLoop()
+{
+    std::vector<QueuedMessage> batch;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            sending_ = false;
+            sent_condition_.notify_all();
+            queue_condition_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            // Pending messages are sent before stopping
+            if (queue_.empty()) return;
+            batch.swap(queue_);
+            queue_index_.clear();
+            sending_ = true;
+        }
+
+        for (const QueuedMessage& msg : batch)
+        {
+            try
+            {
+                socket_->send(msg.type.data(), msg.type.size(), ZMQ_SNDMORE);
+                socket_->send(msg.path.data(), msg.path.size(), ZMQ_SNDMORE);
+                socket_->send(msg.data.data(), msg.data.size());
+                ReceiveZMQ();
+            }
+            catch (const std::exception& e)
+            {
+                // The request socket can't send again before it received a reply, start over with a new one
+                WARNING_NAMED("VisualizationMeshcat", "Failed to send '" << msg.type << "' message: " << e.what());
+                ReconnectZMQ();
+            }
+            catch (...)
+            {
+                WARNING_NAMED("VisualizationMeshcat", "Failed to send '" << msg.type << "' message: Unknown exception");
+                ReconnectZMQ();
+            }
+        }
+        batch.clear();
+    }
+}
+
+void VisualizationMeshcat::ReconnectZMQ()
+{
+    // Called from the send thread, where an exception would terminate the program
+    try
+    {
+        ConnectZMQ();
+    }
+    catch (const std::exception& e)
+    {
+        WARNING_NAMED("VisualizationMeshcat", "Failed to reconnect to " << zmq_url_ << ": " << e.what());
+    }
+}
+
+void VisualizationMeshcat::Flush()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    sent_condition_.wait(lock, [this] { return (queue_.empty() && !sending_) || !send_thread_.joinable(); });
 }
 
 void VisualizationMeshcat::ConnectZMQ()
@@ -144,14 +230,60 @@ std::string VisualizationMeshcat::GetFileURL()
 }
 
 template <typename T>
-void VisualizationMeshcat::SendMsg(T msg)
+VisualizationMeshcat::QueuedMessage VisualizationMeshcat::PackMsg(const T& msg)
 {
     msgpack::sbuffer sbuf;
     msgpack::pack(sbuf, msg);
-    socket_->send(msg.type.data(), msg.type.size(), ZMQ_SNDMORE);
-    socket_->send(msg.path.data(), msg.path.size(), ZMQ_SNDMORE);
-    socket_->send(sbuf.data(), sbuf.size());
-    ReceiveZMQ();
+    return QueuedMessage{msg.type, msg.path, std::string(sbuf.data(), sbuf.size())};
+}
+
+template <typename T>
+void VisualizationMeshcat::SendMsg(T msg, const std::string& coalesce_key)
+{
+    // Pack outside of the lock, only the queue is shared with the send thread
+    QueueMsg(PackMsg(msg), coalesce_key);
+}
+
+template <typename T>
+void VisualizationMeshcat::SendObject(T& object, const KDL::Frame& frame)
+{
+    visualization::AssignUuids(object.object, object.path);
+    QueuedMessage queued = PackMsg(object);
+    const size_t hash = std::hash<std::string>()(queued.data);
+    auto it = displayed_objects_.find(object.path);
+    if (it == displayed_objects_.end() || it->second != hash)
+    {
+        displayed_objects_[object.path] = hash;
+        QueueMsg(std::move(queued), "");
+    }
+    SendMsg(visualization::SetTransform(object.path, FrameToVector(frame)), "set_transform" + object.path);
+}
+
+void VisualizationMeshcat::QueueMsg(QueuedMessage&& queued, const std::string& coalesce_key)
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (coalesce_key.empty())
+        {
+            // Keep the order: queued updates must not be replaced by ones sent after this message
+            queue_index_.clear();
+            queue_.push_back(std::move(queued));
+        }
+        else
+        {
+            auto it = queue_index_.find(coalesce_key);
+            if (it != queue_index_.end())
+            {
+                queue_[it->second] = std::move(queued);
+            }
+            else
+            {
+                queue_index_[coalesce_key] = queue_.size();
+                queue_.push_back(std::move(queued));
+            }
+        }
+    }
+    queue_condition_.notify_one();
 }
 
 void VisualizationMeshcat::DisplayScene(bool use_mesh_materials)
@@ -175,8 +307,7 @@ void VisualizationMeshcat::DisplayScene(bool use_mesh_materials)
                                                            visualization::CreateGeometryObject(visualization::GeometrySphere(sphere->radius),
                                                                                                visualization::Material(visualization::RGB(visual.color(0), visual.color(1), visual.color(2)), visual.color(3))));
                     object.object.object.matrix = FrameToVector(visual.frame);
-                    SendMsg(object);
-                    SendMsg(visualization::SetTransform(object.path, FrameToVector(element->frame)));
+                    SendObject(object, element->frame);
                 }
                 break;
                 case shapes::BOX:
@@ -187,8 +318,7 @@ void VisualizationMeshcat::DisplayScene(bool use_mesh_materials)
                                                            visualization::CreateGeometryObject(visualization::GeometryBox(box->size[0], box->size[1], box->size[2]),
                                                                                                visualization::Material(visualization::RGB(visual.color(0), visual.color(1), visual.color(2)), visual.color(3))));
                     object.object.object.matrix = FrameToVector(visual.frame);
-                    SendMsg(object);
-                    SendMsg(visualization::SetTransform(object.path, FrameToVector(element->frame)));
+                    SendObject(object, element->frame);
                 }
                 break;
                 case shapes::CYLINDER:
@@ -200,8 +330,7 @@ void VisualizationMeshcat::DisplayScene(bool use_mesh_materials)
                                                                                                visualization::Material(visualization::RGB(visual.color(0), visual.color(1), visual.color(2)), visual.color(3))));
                     // Rotate the cylinder to match meshcat convention
                     object.object.object.matrix = FrameToVector(visual.frame * KDL::Frame(KDL::Rotation::RotX(M_PI_2)));
-                    SendMsg(object);
-                    SendMsg(visualization::SetTransform(object.path, FrameToVector(element->frame)));
+                    SendObject(object, element->frame);
                 }
                 break;
                 default:
@@ -216,8 +345,7 @@ void VisualizationMeshcat::DisplayScene(bool use_mesh_materials)
                                                                                                                                    visualization::Material(visualization::RGB(visual.color(0), visual.color(1), visual.color(2)), visual.color(3))));
                             object.object.object.matrix =
                                 FrameToVector(visual.frame, visual.scale(0), visual.scale(1), visual.scale(2));
-                            SendMsg(object);
-                            SendMsg(visualization::SetTransform(object.path, FrameToVector(element->frame)));
+                            SendObject(object, element->frame);
                         }
                         else
                         {
@@ -226,8 +354,7 @@ void VisualizationMeshcat::DisplayScene(bool use_mesh_materials)
                                                                                                    visualization::Material(visualization::RGB(visual.color(0), visual.color(1), visual.color(2)), visual.color(3))));
                             object.object.object.matrix =
                                 FrameToVector(visual.frame, visual.scale(0), visual.scale(1), visual.scale(2));
-                            SendMsg(object);
-                            SendMsg(visualization::SetTransform(object.path, FrameToVector(element->frame)));
+                            SendObject(object, element->frame);
                         }
                     }
                     else
@@ -240,8 +367,7 @@ void VisualizationMeshcat::DisplayScene(bool use_mesh_materials)
                                                                                                                                    visualization::Material(visualization::RGB(visual.color(0), visual.color(1), visual.color(2)), visual.color(3))));
                             object.object.object.matrix =
                                 FrameToVector(visual.frame, visual.scale(0), visual.scale(1), visual.scale(2));
-                            SendMsg(object);
-                            SendMsg(visualization::SetTransform(object.path, FrameToVector(element->frame)));
+                            SendObject(object, element->frame);
                         }
                         else
                         {
@@ -266,7 +392,8 @@ void VisualizationMeshcat::DisplayState(Eigen::VectorXdRefConst state, double t)
         if (element->visual.size() == 0) continue;
         for (auto visual : element->visual)
         {
-            SendMsg(visualization::SetTransform(path_prefix_ + visual.name, FrameToVector(element->frame)));
+            const std::string path = path_prefix_ + visual.name;
+            SendMsg(visualization::SetTransform(path, FrameToVector(element->frame)), "set_transform" + path);
         }
     }
 }
@@ -315,27 +442,37 @@ void VisualizationMeshcat::DisplayTrajectory(Eigen::MatrixXdRefConst trajectory,
         }
     }
 
-    SendMsg(set_animation);
+    // The whole trajectory is a single message, a newer one replaces it if it has not been sent yet
+    SendMsg(set_animation, "set_animation");
 }
 
 void VisualizationMeshcat::Delete(const std::string& path)
 {
+    // Deleted objects have to be sent again
+    const std::string prefix = "/exotica/" + path;
+    for (auto it = displayed_objects_.begin(); it != displayed_objects_.end();)
+    {
+        if (it->first.compare(0, prefix.size(), prefix) == 0)
+            it = displayed_objects_.erase(it);
+        else
+            ++it;
+    }
     SendMsg(visualization::Delete("/exotica/" + path));
 }
 
 void VisualizationMeshcat::SetProperty(const std::string& path, const std::string& property, const double& value)
 {
-    SendMsg(visualization::Property<double>(path, property, value));
+    SendMsg(visualization::Property<double>(path, property, value), "set_property" + path + "/" + property);
 }
 
 void VisualizationMeshcat::SetProperty(const std::string& path, const std::string& property, const std::string& value)
 {
-    SendMsg(visualization::Property<std::string>(path, property, value));
+    SendMsg(visualization::Property<std::string>(path, property, value), "set_property" + path + "/" + property);
 }
 
 void VisualizationMeshcat::SetProperty(const std::string& path, const std::string& property, const bool& value)
 {
-    SendMsg(visualization::Property<bool>(path, property, value));
+    SendMsg(visualization::Property<bool>(path, property, value), "set_property" + path + "/" + property);
 }
 
 void VisualizationMeshcat::SetProperty(const std::string& path, const std::string& property, const Eigen::Vector3d& value)
@@ -344,7 +481,7 @@ void VisualizationMeshcat::SetProperty(const std::string& path, const std::strin
     val[0] = value(0);
     val[1] = value(1);
     val[2] = value(2);
-    SendMsg(visualization::Property<std::vector<double>>(path, property, val));
+    SendMsg(visualization::Property<std::vector<double>>(path, property, val), "set_property" + path + "/" + property);
 }
 
 void VisualizationMeshcat::SetProperty(const std::string& path, const std::string& property, const Eigen::Vector4d& value)
@@ -354,7 +491,7 @@ void VisualizationMeshcat::SetProperty(const std::string& path, const std::strin
     val[1] = value(1);
     val[2] = value(2);
     val[3] = value(3);
-    SendMsg(visualization::Property<std::vector<double>>(path, property, val));
+    SendMsg(visualization::Property<std::vector<double>>(path, property, val), "set_property" + path + "/" + property);
 }
 }  // namespace exotica
 #endif  // MSGPACK_FOUND
@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_core/tools/profiler.h>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace exotica;
+
+// Linked with exotica_allocation_tracking, which replaces malloc, calloc and realloc of this executable only
+namespace
+{
+void Allocate(int num_allocations)
+{
+    for (int i = 0; i < num_allocations; ++i)
+    {
+        // Stored to a volatile pointer, hence the allocation cannot be elided
+        void* volatile memory = std::malloc(64);
+        std::free(memory);
+    }
+}
+
+const ProfileEvent& FindEvent(const std::vector<ProfileEvent>& events, const std::string& name)
+{
+    for (const ProfileEvent& event : events)
+    {
+        if (name == event.name) return event;
+    }
+    throw std::runtime_error("No event " + name);
+}
+}  // namespace
+
+TEST(AllocationTracking, CountsAllocationsOfThread)
+{
+    ASSERT_TRUE(Profiler::IsAllocationTrackingLoaded());
+    const std::int64_t start = Profiler::GetThreadAllocations();
+    Allocate(5);
+    EXPECT_EQ(Profiler::GetThreadAllocations() - start, 5);
+}
+
+TEST(AllocationTracking, ZonesRecordAllocations)
+{
+    Profiler& profiler = Profiler::Instance();
+    profiler.Clear();
+    profiler.SetEnabled(true);
+    {
+        ProfileZone outer("outer");
+        Allocate(2);
+        {
+            ProfileZone inner("inner");
+            Allocate(3);
+        }
+        {
+            ProfileZone empty("empty");
+        }
+    }
+
+    const std::vector<ProfileEvent> events = profiler.GetEvents();
+    const ProfileEvent& inner = FindEvent(events, "inner");
+    EXPECT_EQ(inner.allocations, 3);
+    EXPECT_EQ(inner.self_allocations, 3);
+    EXPECT_EQ(FindEvent(events, "empty").allocations, 0);
+
+    // Recording the nested events may allocate within the outer zone as well
+    const ProfileEvent& outer = FindEvent(events, "outer");
+    EXPECT_GE(outer.allocations, 5);
+    EXPECT_EQ(outer.self_allocations, outer.allocations - inner.allocations);
+    profiler.Clear();
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
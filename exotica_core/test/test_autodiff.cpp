@@ -36,6 +36,7 @@
 #include <exotica_core/tools/autodiff_chain_hessian.h>
 #include <exotica_core/tools/autodiff_chain_hessian_sparse.h>
 #include <exotica_core/tools/autodiff_chain_jacobian.h>
+#include <exotica_core/tools/autodiff_chain_jacobian_lanes.h>
 #include <exotica_core/tools/autodiff_chain_jacobian_sparse.h>
 #include <exotica_core/tools/finitediff_chain_hessian.h>
 #include <exotica_core/tools/finitediff_chain_jacobian.h>
@@ -125,6 +126,31 @@ struct Function3 : public FunctorType
     }
 };
 
+// Function4 couples each input with the next one, i.e., its Jacobian is upper bidiagonal.
+// The even and the odd columns of the Jacobian form two groups for the sparse finite differences.
+template <class FunctorType>
+struct Function4 : public FunctorType
+{
+    enum
+    {
+        Inputs = 4,
+        Values = 4,
+        JacobianCols = 4
+    };
+
+    template <typename T>
+    void operator()(const Eigen::Matrix<T, FunctorType::InputType::RowsAtCompileTime, 1> &x, Eigen::Matrix<T, FunctorType::ValueType::RowsAtCompileTime, 1> &y) const
+    {
+        using std::cos;
+        using std::sin;
+        for (int i = 0; i < 4; ++i)
+        {
+            y(i, 0) = cos(x(i, 0));
+            if (i < 3) y(i, 0) += x(i, 0) * sin(x(i + 1, 0));
+        }
+    }
+};
+
 // Typedefs for convenience
 template <template <typename> class DiffType, typename _FunctorType, template <typename> class FunctionType>
 struct TestingBase
@@ -137,6 +163,10 @@ struct TestingBase
     typedef typename Diff::JacobianType JacobianType;
 };
 
+// Three lanes for the four inputs, i.e., the second pass only uses one lane
+template <typename Functor>
+using AutoDiffChainJacobianLanes3 = Eigen::AutoDiffChainJacobianLanes<Functor, 3>;
+
 // Compute Jacobians using AutoDiff
 template <class T>
 struct JacobianFull : public T
@@ -539,6 +569,61 @@ double diffNorm(const HessianType1 &A, const HessianType2 &B)
     return ret / static_cast<double>(A.rows());
 }
 
+// Compares the sparse (coloured) finite differences with the dense ones
+template <typename Function, Eigen::NumericalDiffMode mode>
+void TestFiniteDiffSparsityPattern(const Eigen::SparsityPatternType &pattern, std::size_t num_groups)
+{
+    typedef Eigen::FiniteDiffChainJacobian<Function, mode> JacobianDiff;
+    typedef Eigen::FiniteDiffChainHessian<Function, mode> HessianDiff;
+
+    EXPECT_EQ(Eigen::ColorJacobianColumns(pattern).size(), num_groups);
+
+    for (int i = 0; i < N; ++i)
+    {
+        typename JacobianDiff::InputJacobianRowType x = JacobianDiff::InputJacobianRowType::Random(Function::Inputs) * INPUT_VECTOR_SCALE;
+        typename JacobianDiff::ValueType y(Function::Values), y_sparse(Function::Values);
+        typename JacobianDiff::JacobianType j(Function::Values, Function::JacobianCols), j_sparse(Function::Values, Function::JacobianCols);
+        typename HessianDiff::HessianType hess, hess_sparse;
+
+        Function f;
+        JacobianDiff dense_diff(f), sparse_diff(f);
+        sparse_diff.SetSparsityPattern(pattern);
+        const int nfev = dense_diff(x, y, j);
+        const int nfev_sparse = sparse_diff(x, y_sparse, j_sparse);
+        EXPECT_LT(nfev_sparse, nfev);
+        EXPECT_TRUE((y - y_sparse).norm() < THRESHOLD_ANALYTIC);
+        EXPECT_TRUE((j - j_sparse).norm() < THRESHOLD_ANALYTIC);
+
+        HessianDiff dense_hessian(f), sparse_hessian(f);
+        sparse_hessian.SetSparsityPattern(pattern);
+        sparse_hessian.SetNumThreads(2);
+        dense_hessian(x, y, j, hess);
+        sparse_hessian(x, y_sparse, j_sparse, hess_sparse);
+        EXPECT_TRUE((j - j_sparse).norm() < THRESHOLD_ANALYTIC);
+        EXPECT_TRUE(diffNorm(hess, hess_sparse) < THRESHOLD_ANALYTIC);
+    }
+}
+
+// Each block of three values of Function2 depends on a single input, i.e., all columns form one group.
+// The Jacobian of Function4 is bidiagonal, i.e., the even and the odd columns form two groups.
+template <typename Dynamic, Eigen::NumericalDiffMode mode>
+void TestFiniteDiffSparsityPatterns()
+{
+    typedef Function2<FunctorBase<double, Dynamic::Inputs2, Dynamic::Values2, Dynamic::JacobianCols2>> BlockFunction;
+    Eigen::SparsityPatternType block_pattern = Eigen::SparsityPatternType::Constant(BlockFunction::Values, BlockFunction::JacobianCols, false);
+    for (int i = 0; i < BlockFunction::Values; ++i) block_pattern(i, i / 3) = true;
+    TestFiniteDiffSparsityPattern<BlockFunction, mode>(block_pattern, 1);
+
+    typedef Function4<FunctorBase<double, Dynamic::Inputs1, Dynamic::Values1, Dynamic::JacobianCols1>> BandFunction;
+    Eigen::SparsityPatternType band_pattern = Eigen::SparsityPatternType::Constant(BandFunction::Values, BandFunction::JacobianCols, false);
+    for (int i = 0; i < BandFunction::Values; ++i)
+    {
+        band_pattern(i, i) = true;
+        if (i + 1 < BandFunction::JacobianCols) band_pattern(i, i + 1) = true;
+    }
+    TestFiniteDiffSparsityPattern<BandFunction, mode>(band_pattern, 2);
+}
+
 template <template <typename> class DiffType, typename Dynamic, Eigen::NumericalDiffMode mode>
 void TestHessians()
 {
@@ -698,7 +783,9 @@ void TestHessiansSparse()
 // 6. Run 3 with Central differencing
 // 7. AutoDiffChainJacobianSparse Jacobian computation against AutoDiffChainJacobian
 // 8. AutoDiffChainHessianSparse Hessian computation against AutoDiffChainHessian
-// 9. Run 1-7 with matrix sizes fixed at compile time
+// 9. AutoDiffChainJacobianLanes Jacobian computation against finite differences
+// 10. FiniteDiffChainJacobian and FiniteDiffChainHessian with a sparsity pattern against the dense evaluation
+// 11. Run 1-10 with matrix sizes fixed at compile time
 
 TEST(AutoDiffJacobian, JacobianComputationDynamicMatrix)
 {
@@ -720,6 +807,16 @@ TEST(AutoDiffJacobian, JacobianComputationTemplatedMatrixCentralDifferences)
     TestJacobians<Eigen::AutoDiffChainJacobian, TestStaticTrait, Eigen::Central>();
 }
 
+TEST(AutoDiffJacobianLanes, JacobianComputationDynamicMatrix)
+{
+    TestJacobians<AutoDiffChainJacobianLanes3, TestDynamicTrait, Eigen::Central>();
+}
+
+TEST(AutoDiffJacobianLanes, JacobianComputationTemplatedMatrix)
+{
+    TestJacobians<AutoDiffChainJacobianLanes3, TestStaticTrait, Eigen::Central>();
+}
+
 TEST(AutoDiffHessian, JacobianComputationDynamicMatrix)
 {
     TestJacobians<Eigen::AutoDiffChainHessian, TestDynamicTrait, Eigen::Forward>();
@@ -770,6 +867,18 @@ TEST(AutoDiffJacobianSparse, JacobianComputationTemplatedMatrix)
     TestJacobiansSparse<Eigen::AutoDiffChainJacobianSparse, TestStaticTrait>();
 }
 
+TEST(FiniteDiffSparsityPattern, DynamicMatrix)
+{
+    TestFiniteDiffSparsityPatterns<TestDynamicTrait, Eigen::Forward>();
+    TestFiniteDiffSparsityPatterns<TestDynamicTrait, Eigen::Central>();
+}
+
+TEST(FiniteDiffSparsityPattern, TemplatedMatrix)
+{
+    TestFiniteDiffSparsityPatterns<TestStaticTrait, Eigen::Forward>();
+    TestFiniteDiffSparsityPatterns<TestStaticTrait, Eigen::Central>();
+}
+
 TEST(AutoDiffHessianSparse, HessianComputationDynamicMatrix)
 {
     TestHessiansSparse<Eigen::AutoDiffChainHessianSparse, TestDynamicTrait>();
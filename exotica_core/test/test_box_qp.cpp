@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+// Checks that no Eigen object allocates while the workspace has the size of the QP
+#define EIGEN_RUNTIME_NO_MALLOC
+
+#include <exotica_core/tools/box_qp.h>
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace exotica;
+
+namespace
+{
+struct RandomBoxQP
+{
+    RandomBoxQP(const int nx, std::mt19937& generator) : H(nx, nx), q(nx), b_low(nx), b_high(nx), x_init(nx)
+    {
+        std::normal_distribution<double> normal;
+        Eigen::MatrixXd A(nx, nx);
+        for (int i = 0; i < A.size(); ++i) A(i) = normal(generator);
+        H = A * A.transpose() + Eigen::MatrixXd::Identity(nx, nx);
+        for (int i = 0; i < nx; ++i)
+        {
+            q(i) = 5.0 * normal(generator);
+            b_low(i) = -std::abs(normal(generator));
+            b_high(i) = std::abs(normal(generator));
+            x_init(i) = normal(generator);
+        }
+    }
+
+    Eigen::MatrixXd H;
+    Eigen::VectorXd q, b_low, b_high, x_init;
+};
+
+constexpr double kLambda = 1e-5;
+constexpr double kGradientTolerance = 1e-8;
+}  // namespace
+
+TEST(BoxQP, SolutionSatisfiesOptimalityConditions)
+{
+    std::mt19937 generator(0);
+    for (int nx = 1; nx <= 12; ++nx)
+    {
+        for (int k = 0; k < 20; ++k)
+        {
+            const RandomBoxQP qp(nx, generator);
+            // Without regularisation, the Newton steps solve the free problem exactly
+            const BoxQPSolution solution = BoxQP(qp.H, qp.q, qp.b_low, qp.b_high, qp.x_init, 0.1, 100, kGradientTolerance, 0.0, true, true);
+            const Eigen::VectorXd grad = qp.H * solution.x + qp.q;
+            for (int i = 0; i < nx; ++i)
+            {
+                EXPECT_GE(solution.x(i), qp.b_low(i));
+                EXPECT_LE(solution.x(i), qp.b_high(i));
+                // Projected gradient: zero at the free indices, pointing out of the box at the active bounds
+                if (solution.x(i) == qp.b_low(i))
+                    EXPECT_GT(grad(i), -1e-6);
+                else if (solution.x(i) == qp.b_high(i))
+                    EXPECT_LT(grad(i), 1e-6);
+                else
+                    EXPECT_NEAR(grad(i), 0.0, 1e-6);
+            }
+        }
+    }
+}
+
+TEST(BoxQP, RejectsNonPositiveMaxIterations)
+{
+    std::mt19937 generator(0);
+    const RandomBoxQP qp(4, generator);
+    for (const int max_iterations : {0, -1})
+    {
+        EXPECT_THROW(BoxQP(qp.H, qp.q, qp.b_low, qp.b_high, qp.x_init, 0.1, max_iterations, kGradientTolerance, kLambda, true, true), std::exception);
+    }
+}
+
+TEST(BoxQP, CholeskyFactorizationMatchesInverse)
+{
+    std::mt19937 generator(1);
+    for (int nx = 1; nx <= 12; ++nx)
+    {
+        for (int k = 0; k < 20; ++k)
+        {
+            const RandomBoxQP qp(nx, generator);
+            const BoxQPSolution cholesky = BoxQP(qp.H, qp.q, qp.b_low, qp.b_high, qp.x_init, 0.1, 100, kGradientTolerance, kLambda, true, true);
+            const BoxQPSolution inverse = BoxQP(qp.H, qp.q, qp.b_low, qp.b_high, qp.x_init, 0.1, 100, kGradientTolerance, kLambda, true, false);
+            EXPECT_TRUE(cholesky.x.isApprox(inverse.x, 1e-9));
+            ASSERT_EQ(cholesky.free_idx, inverse.free_idx);
+            EXPECT_TRUE(cholesky.Hff_inv.isApprox(inverse.Hff_inv, 1e-9));
+        }
+    }
+}
+
+TEST(BoxQP, WorkspaceScattersTheInverseOfTheFreeHessian)
+{
+    std::mt19937 generator(2);
+    BoxQPWorkspace workspace;
+    for (int k = 0; k < 50; ++k)
+    {
+        const RandomBoxQP qp(6, generator);
+        BoxQP(qp.H, qp.q, qp.b_low, qp.b_high, qp.x_init, 0.1, 100, kGradientTolerance, kLambda, true, true, workspace);
+        const BoxQPSolution solution = BoxQP(qp.H, qp.q, qp.b_low, qp.b_high, qp.x_init, 0.1, 100, kGradientTolerance, kLambda, true, true);
+        EXPECT_TRUE(workspace.x.isApprox(solution.x));
+        EXPECT_EQ(workspace.free_idx, solution.free_idx);
+
+        Eigen::MatrixXd Hff_inv = Eigen::MatrixXd::Zero(6, 6);
+        for (std::size_t i = 0; i < solution.free_idx.size(); ++i)
+            for (std::size_t j = 0; j < solution.free_idx.size(); ++j)
+                Hff_inv(solution.free_idx[i], solution.free_idx[j]) = solution.Hff_inv(i, j);
+        EXPECT_TRUE((workspace.Hff_inv - Hff_inv).isZero(1e-12));
+    }
+}
+
+TEST(BoxQP, WorkspaceOfTheRightSizeDoesNotAllocate)
+{
+    std::mt19937 generator(3);
+    std::vector<RandomBoxQP> qps;
+    for (int k = 0; k < 50; ++k) qps.emplace_back(8, generator);
+
+    BoxQPWorkspace workspace(8);
+    for (const RandomBoxQP& qp : qps)
+    {
+        Eigen::internal::set_is_malloc_allowed(false);
+        BoxQP(qp.H, qp.q, qp.b_low, qp.b_high, qp.x_init, 0.1, 100, kGradientTolerance, kLambda, true, true, workspace);
+        Eigen::internal::set_is_malloc_allowed(true);
+    }
+}
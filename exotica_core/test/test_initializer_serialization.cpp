@@ -0,0 +1,192 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_core/loaders/initializer_serialization.h>
+#include <exotica_core/loaders/xml_loader.h>
+#include <exotica_core/setup.h>
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace exotica;
+
+namespace
+{
+void ExpectEqualInitializers(const Initializer& expected, const Initializer& actual)
+{
+    EXPECT_EQ(expected.GetName(), actual.GetName());
+    ASSERT_EQ(expected.GetPropertyNames(), actual.GetPropertyNames());
+    for (const std::string& name : expected.GetPropertyNames())
+    {
+        const Property& a = expected.properties_.at(name);
+        const Property& b = actual.properties_.at(name);
+        EXPECT_EQ(a.IsRequired(), b.IsRequired()) << name;
+        ASSERT_EQ(a.IsSet(), b.IsSet()) << name;
+        if (!a.IsSet()) continue;
+        ASSERT_EQ(a.IsStringType(), b.IsStringType()) << name;
+        if (a.IsStringType())
+        {
+            EXPECT_EQ(boost::any_cast<std::string>(a.Get()), boost::any_cast<std::string>(b.Get())) << name;
+        }
+        else
+        {
+            const std::vector<Initializer> va = boost::any_cast<std::vector<Initializer>>(a.Get());
+            const std::vector<Initializer> vb = boost::any_cast<std::vector<Initializer>>(b.Get());
+            ASSERT_EQ(va.size(), vb.size()) << name;
+            for (std::size_t i = 0; i < va.size(); ++i) ExpectEqualInitializers(va[i], vb[i]);
+        }
+    }
+}
+
+std::vector<Initializer> CreateInitializers()
+{
+    Initializer map("exotica/EffPosition");
+    map.AddProperty(Property("Name", true, std::string("Position")));
+    map.AddProperty(Property("Debug", false));
+    Initializer frame("exotica/Frame");
+    frame.AddProperty(Property("Link", true, std::string("lwr_arm_6_link")));
+    frame.AddProperty(Property("LinkOffset", false, std::string("0 0 0.1")));
+    frame.AddProperty(Property("Empty", false, std::string("")));
+    map.AddProperty(Property("EndEffector", true, std::vector<Initializer>({frame, frame})));
+
+    Initializer problem("exotica/UnconstrainedEndPoseProblem");
+    problem.AddProperty(Property("Name", true, std::string("MyProblem")));
+    problem.AddProperty(Property("Maps", true, std::vector<Initializer>({map})));
+    problem.AddProperty(Property("Cost", false, std::vector<Initializer>()));
+    return {problem, Initializer("exotica/IKSolver")};
+}
+
+std::string CreateXML(int index)
+{
+    return "<Config><IKSolver Name=\"Solver" + std::to_string(index) + "\"><MaxIterations>1</MaxIterations></IKSolver></Config>";
+}
+}  // namespace
+
+TEST(InitializerSerialization, RoundTrip)
+{
+    const std::vector<Initializer> initializers = CreateInitializers();
+    std::stringstream buffer;
+    SerializeInitializers(initializers, buffer);
+
+    std::vector<Initializer> result;
+    ASSERT_TRUE(DeserializeInitializers(buffer, result));
+    ASSERT_EQ(result.size(), initializers.size());
+    for (std::size_t i = 0; i < initializers.size(); ++i) ExpectEqualInitializers(initializers[i], result[i]);
+}
+
+TEST(InitializerSerialization, RejectsCorruptData)
+{
+    std::stringstream buffer;
+    SerializeInitializers(CreateInitializers(), buffer);
+    const std::string data = buffer.str();
+    std::vector<Initializer> result;
+
+    // Every truncation of a valid entry is detected
+    for (std::size_t size = 0; size < data.size(); ++size)
+    {
+        std::stringstream truncated(data.substr(0, size));
+        EXPECT_FALSE(DeserializeInitializers(truncated, result)) << size;
+    }
+
+    std::string wrong_magic = data;
+    wrong_magic[0] = 'X';
+    std::stringstream wrong_magic_stream(wrong_magic);
+    EXPECT_FALSE(DeserializeInitializers(wrong_magic_stream, result));
+
+    std::string wrong_version = data;
+    wrong_version[4] = 2;
+    std::stringstream wrong_version_stream(wrong_version);
+    EXPECT_FALSE(DeserializeInitializers(wrong_version_stream, result));
+}
+
+TEST(InitializerSerialization, RejectsUnsupportedProperties)
+{
+    Initializer initializer("exotica/IKSolver");
+    initializer.AddProperty(Property("MaxIterations", true, 1));
+    std::stringstream buffer;
+    EXPECT_THROW(SerializeInitializers({initializer}, buffer), std::exception);
+}
+
+TEST(XMLLoader, InMemoryCacheIsBounded)
+{
+    XMLLoader::ClearCache();
+    const std::size_t capacity = XMLLoader::GetCacheCapacity();
+    XMLLoader::SetCacheCapacity(3);
+    for (int i = 0; i < 10; ++i)
+    {
+        Initializer solver = XMLLoader::Load(CreateXML(i), true);
+        EXPECT_EQ(boost::any_cast<std::string>(solver.GetProperty("Name")), "Solver" + std::to_string(i));
+        EXPECT_LE(XMLLoader::GetCacheSize(), 3u);
+    }
+    EXPECT_EQ(XMLLoader::GetCacheSize(), 3u);
+
+    // Loading a cached configuration again does not add an entry
+    XMLLoader::Load(CreateXML(9), true);
+    EXPECT_EQ(XMLLoader::GetCacheSize(), 3u);
+
+    XMLLoader::SetCacheCapacity(1);
+    EXPECT_EQ(XMLLoader::GetCacheSize(), 1u);
+    XMLLoader::ClearCache();
+    EXPECT_EQ(XMLLoader::GetCacheSize(), 0u);
+    XMLLoader::SetCacheCapacity(capacity);
+}
+
+TEST(XMLLoader, DiskCacheRoundTrip)
+{
+    char directory_template[] = "/tmp/exotica_config_cache_XXXXXX";
+    ASSERT_NE(mkdtemp(directory_template), nullptr);
+    const std::string directory = directory_template;
+    const std::string previous_directory = XMLLoader::GetCacheDirectory();
+    XMLLoader::SetCacheDirectory(directory);
+
+    XMLLoader::ClearCache();
+    const Initializer parsed = XMLLoader::Load(CreateXML(0), true);
+    // The second load after clearing the in-memory cache is served from disk
+    XMLLoader::ClearCache();
+    const Initializer cached = XMLLoader::Load(CreateXML(0), true);
+    ExpectEqualInitializers(parsed, cached);
+
+    XMLLoader::SetCacheDirectory(previous_directory);
+    XMLLoader::ClearCache();
+    const std::string command = "rm -rf " + directory;
+    EXPECT_EQ(std::system(command.c_str()), 0);
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    int ret = RUN_ALL_TESTS();
+    Setup::Destroy();
+    return ret;
+}
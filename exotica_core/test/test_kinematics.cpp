@@ -28,9 +28,22 @@
 //
 
 #include <exotica_core/exotica_core.h>
+#include <exotica_core/tools/floating_base.h>
 #include <exotica_core/tools/test_helpers.h>
+#ifdef MSGPACK_FOUND
+#include <exotica_core/visualization_meshcat.h>
+#include <exotica_core/visualization_meshcat_types.h>
+#endif
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+
 using namespace exotica;
 
 static const std::string urdf_string_ = "<robot name=\"test_robot\"><link name=\"base\"><visual><geometry><cylinder length=\"0.3\" radius=\"0.2\"/></geometry><origin xyz=\"0 0 0.15\"/></visual><collision><geometry><cylinder length=\"0.3\" radius=\"0.2\"/></geometry><origin xyz=\"0 0 0.15\"/></collision></link><link name=\"link1\"><inertial><mass value=\"0.2\"/><origin xyz=\"0 0 0.1\"/><inertia ixx=\"0.00381666666667\" ixy=\"0\" ixz=\"0\" iyy=\"0.0036\" iyz=\"0\" izz=\"0.00381666666667\"/></inertial><visual><geometry><cylinder length=\"0.15\" radius=\"0.05\"/></geometry><origin xyz=\"0 0 0.075\"/></visual><collision><geometry><cylinder length=\"0.15\" radius=\"0.05\"/></geometry><origin xyz=\"0 0 0.075\"/></collision></link><link name=\"link2\"><inertial><mass value=\"0.2\"/><origin xyz=\"0 0 0.1\"/><inertia ixx=\"0.00381666666667\" ixy=\"0\" ixz=\"0\" iyy=\"0.0036\" iyz=\"0\" izz=\"0.00381666666667\"/></inertial><visual><geometry><cylinder length=\"0.35\" radius=\"0.05\"/></geometry><origin xyz=\"0 0 0.175\"/></visual><collision><geometry><cylinder length=\"0.35\" radius=\"0.05\"/></geometry><origin xyz=\"0 0 0.175\"/></collision></link><link name=\"link3\"><inertial><mass value=\"0.2\"/><origin xyz=\"0 0 0.1\"/><inertia ixx=\"0.00381666666667\" ixy=\"0\" ixz=\"0\" iyy=\"0.0036\" iyz=\"0\" izz=\"0.00381666666667\"/></inertial><visual><geometry><cylinder length=\"0.45\" radius=\"0.05\"/></geometry><origin xyz=\"0 0 0.225\"/></visual><collision><geometry><cylinder length=\"0.45\" radius=\"0.05\"/></geometry><origin xyz=\"0 0 0.225\"/></collision></link><link name=\"endeff\"><inertial><mass value=\"0.2\"/><origin xyz=\"0 0 0.1\"/><inertia ixx=\"0.00381666666667\" ixy=\"0\" ixz=\"0\" iyy=\"0.0036\" iyz=\"0\" izz=\"0.00381666666667\"/></inertial><visual><geometry><cylinder length=\"0.05\" radius=\"0.1\"/></geometry><origin xyz=\"0 0 -0.025\"/></visual><collision><geometry><cylinder length=\"0.05\" radius=\"0.1\"/></geometry><origin xyz=\"0 0 -0.025\"/></collision></link><joint name=\"joint1\" type=\"revolute\"><parent link=\"base\"/><child link=\"link1\"/><origin xyz=\"0 0 0.3\" rpy=\"0 0 0\" /><axis xyz=\"0 0 1\" /><limit effort=\"200\" velocity=\"1.0\" lower=\"-0.4\" upper=\"0.4\"/><safety_controller k_position=\"30\" k_velocity=\"30\" soft_lower_limit=\"-0.4\" soft_upper_limit=\"0.4\"/></joint><joint name=\"joint2\" type=\"revolute\"><parent link=\"link1\"/><child link=\"link2\"/><origin xyz=\"0 0 0.15\" rpy=\"0 0 0\" /><axis xyz=\"0 1 0\" /><limit effort=\"200\" velocity=\"1.0\" lower=\"-0.4\" upper=\"0.4\"/><safety_controller k_position=\"30\" k_velocity=\"30\" soft_lower_limit=\"-0.4\" soft_upper_limit=\"0.4\"/></joint><joint name=\"joint3\" type=\"revolute\"><parent link=\"link2\"/><child link=\"link3\"/><origin xyz=\"0 0 0.35\" rpy=\"0 0 0\" /><axis xyz=\"0 1 0\" /><limit effort=\"200\" velocity=\"1.0\" lower=\"-0.4\" upper=\"0.4\"/><safety_controller k_position=\"30\" k_velocity=\"30\" soft_lower_limit=\"-0.4\" soft_upper_limit=\"0.4\"/></joint><joint name=\"joint4\" type=\"fixed\"><parent link=\"link3\"/><child link=\"endeff\"/><origin xyz=\"0 0 0.45\" rpy=\"0 0 0\" /></joint></robot>";
@@ -207,6 +220,954 @@ TEST(ExoticaCore, testKinematicHessian)
     }
 }
 
+TEST(ExoticaCore, testKinematicBatchUpdate)
+{
+    try
+    {
+        TEST_COUT << "Kinematic batch update test";
+        TestClass test;
+        Eigen::MatrixXd X(test.N, num_trials_);
+        for (int k = 0; k < num_trials_; ++k) X.col(k) = test.scene->GetKinematicTree().GetRandomControlledState();
+
+        std::vector<KinematicResponse> batch;
+        test.scene->GetKinematicTree().UpdateBatch(X, batch);
+        ASSERT_EQ(batch.size(), static_cast<std::size_t>(num_trials_));
+
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            test.scene->Update(X.col(k), 0.0);
+            EXPECT_TRUE(batch[k].x.isApprox(X.col(k)));
+            EXPECT_TRUE(KDL::Equal(batch[k].Phi(0), test.solution.Phi(0), 1e-12));
+            EXPECT_LT((batch[k].jacobian(0).data - test.solution.jacobian(0).data).norm(), 1e-12);
+            for (int i = 0; i < 6; ++i) EXPECT_LT((batch[k].hessian(0)(i) - test.solution.hessian(0)(i)).norm(), 1e-12);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testKinematicBatchFK)
+{
+    try
+    {
+        TEST_COUT << "Kinematic batch FK test";
+        TestClass test;
+        Eigen::MatrixXd X(test.N, num_trials_);
+        for (int k = 0; k < num_trials_; ++k) X.col(k) = test.scene->GetKinematicTree().GetRandomControlledState();
+
+        const KDL::Frame offset(KDL::Rotation::RPY(0.1, 0.2, 0.3), KDL::Vector(0.1, 0.0, 0.2));
+        std::vector<KDL::Frame> poses;
+        std::vector<KDL::Jacobian> jacobians;
+        test.scene->GetKinematicTree().FKBatch(X, "endeff", offset, "base", KDL::Frame(), poses, &jacobians);
+        ASSERT_EQ(poses.size(), static_cast<std::size_t>(num_trials_));
+        ASSERT_EQ(jacobians.size(), static_cast<std::size_t>(num_trials_));
+
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            test.scene->Update(X.col(k), 0.0);
+            EXPECT_TRUE(KDL::Equal(poses[k], test.scene->GetKinematicTree().FK("endeff", offset, "base", KDL::Frame()), 1e-12));
+            EXPECT_LT((jacobians[k].data - test.scene->GetKinematicTree().Jacobian("endeff", offset, "base", KDL::Frame())).norm(), 1e-12);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testKinematicsRequestSharedFrames)
+{
+    KinematicsRequest request;
+    const KDL::Frame offset(KDL::Vector(0.1, 0.0, 0.0));
+    EXPECT_EQ(request.AddFrames({KinematicFrameRequest("endeff"), KinematicFrameRequest("endeff", offset)}), 0);
+    EXPECT_EQ(request.AddFrames({KinematicFrameRequest("endeff")}), 0);
+    EXPECT_EQ(request.AddFrames({KinematicFrameRequest("endeff", offset)}), 1);
+    EXPECT_EQ(request.AddFrames({KinematicFrameRequest("endeff", offset), KinematicFrameRequest("base")}), 1);
+    EXPECT_EQ(request.AddFrames({KinematicFrameRequest("endeff", KDL::Frame(), "base")}), 3);
+    EXPECT_EQ(request.frames.size(), 4u);
+}
+
+TEST(ExoticaCore, testKinematicPackedLayout)
+{
+    try
+    {
+        TEST_COUT << "Kinematic packed layout test";
+        TestClass test;
+        KinematicsRequest request;
+        request.flags = KIN_FK | KIN_J | KIN_PACKED;
+        request.frames = {KinematicFrameRequest("endeff"), KinematicFrameRequest("endeff", KDL::Frame(), "base")};
+        test.solution = KinematicSolution(0, 2);
+        test.scene->RequestKinematics(request, std::bind(&TestClass::UpdateKinematics, &test, std::placeholders::_1));
+
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            test.scene->Update(test.scene->GetKinematicTree().GetRandomControlledState(), 0.0);
+            for (int i = 0; i < 2; ++i)
+            {
+                const Eigen::Matrix3d rotation = Eigen::Map<const Eigen::Matrix3d>(test.solution.Phi_rotation.col(i).data());
+                EXPECT_LT((test.solution.Phi_position.col(i) - Eigen::Map<const Eigen::Vector3d>(test.solution.Phi(i).p.data)).norm(), 1e-12);
+                EXPECT_LT((rotation - GetFrame(test.solution.Phi(i)).topLeftCorner<3, 3>()).norm(), 1e-12);
+                EXPECT_LT((test.solution.jacobian_packed.middleCols(i * test.N, test.N) - test.solution.jacobian(i).data).norm(), 1e-12);
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testKinematicJacobianColumns)
+{
+    try
+    {
+        TEST_COUT << "Kinematic Jacobian sparsity test";
+        TestClass test;
+        KinematicsRequest request;
+        request.flags = KIN_FK | KIN_J | KIN_H;
+        request.frames = {KinematicFrameRequest("link2"), KinematicFrameRequest("endeff", KDL::Frame(), "link2")};
+        test.solution = KinematicSolution(0, 2);
+        test.scene->RequestKinematics(request, std::bind(&TestClass::UpdateKinematics, &test, std::placeholders::_1));
+
+        EXPECT_EQ(test.solution.frame[0].jacobian_columns, std::vector<int>({0, 1}));
+        EXPECT_EQ(test.solution.frame[1].jacobian_columns, std::vector<int>({0, 1, 2}));
+
+        test.scene->Update(test.scene->GetKinematicTree().GetRandomControlledState(), 0.0);
+        EXPECT_TRUE(test.solution.jacobian(0).data.col(2).isZero());
+        for (int i = 0; i < 6; ++i)
+        {
+            EXPECT_TRUE(test.solution.hessian(0)(i).row(2).isZero());
+            EXPECT_TRUE(test.solution.hessian(0)(i).col(2).isZero());
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testKinematicParallelUpdate)
+{
+    try
+    {
+        TEST_COUT << "Kinematic parallel Jacobian/Hessian test";
+        TestClass test;
+        const int num_frames = 32;
+        KinematicsRequest request;
+        request.flags = KIN_FK | KIN_J | KIN_H;
+        for (int i = 0; i < num_frames; ++i) request.frames.push_back(KinematicFrameRequest(i % 2 ? "endeff" : "link3", GetFrame(Eigen::VectorXd::Random(3))));
+        test.solution = KinematicSolution(0, num_frames);
+        test.scene->RequestKinematics(request, std::bind(&TestClass::UpdateKinematics, &test, std::placeholders::_1));
+
+        KinematicTree& tree = test.scene->GetKinematicTree();
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            const Eigen::VectorXd x = tree.GetRandomControlledState();
+            tree.SetNumThreads(1);
+            test.scene->Update(x, 0.0);
+            const ArrayJacobian jacobian = test.solution.jacobian;
+            const ArrayHessian hessian = test.solution.hessian;
+
+            tree.SetNumThreads(4, 1);
+            tree.RequestFullTreeUpdate();
+            test.scene->Update(x, 0.0);
+            for (int i = 0; i < num_frames; ++i)
+            {
+                EXPECT_TRUE(jacobian(i).data == test.solution.jacobian(i).data);
+                for (int j = 0; j < 6; ++j) EXPECT_TRUE(hessian(i)(j) == test.solution.hessian(i)(j));
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testKinematicIncrementalInsertion)
+{
+    try
+    {
+        TEST_COUT << "Kinematic incremental insertion test";
+        TestClass test;
+        KinematicTree& tree = test.scene->GetKinematicTree();
+        const Eigen::VectorXd x = tree.GetRandomControlledState();
+        test.scene->Update(x, 0.0);
+        const KDL::Frame endeff = test.solution.Phi(0);
+
+        // Objects attached to the root and their children are appended to the flattened tree, only their frames are computed
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            const Eigen::Vector3d p_object = Eigen::Vector3d::Random(), p_child = Eigen::Vector3d::Random();
+            Eigen::Isometry3d pose_object = Eigen::Isometry3d::Identity(), pose_child = Eigen::Isometry3d::Identity();
+            pose_object.translation() = p_object;
+            pose_child.translation() = p_child;
+            tree.AddElement("object" + std::to_string(k), pose_object);
+            tree.AddElement("object" + std::to_string(k) + "_child", pose_child, "object" + std::to_string(k));
+            test.scene->Update(x, 0.0);
+            EXPECT_EQ(tree.GetNumUpdatedElements(), 2u);
+
+            const Eigen::Vector3d p = p_object + p_child;
+            EXPECT_TRUE(KDL::Equal(tree.FK("object" + std::to_string(k) + "_child", KDL::Frame(), "", KDL::Frame()), KDL::Frame(KDL::Vector(p(0), p(1), p(2))), 1e-12));
+        }
+        EXPECT_TRUE(KDL::Equal(test.solution.Phi(0), endeff, 1e-12));
+
+        const Eigen::VectorXd x1 = tree.GetRandomControlledState();
+        test.scene->Update(x1, 0.0);
+        const KDL::Frame incremental = test.solution.Phi(0);
+        tree.RequestFullTreeUpdate();
+        test.scene->Update(x1, 0.0);
+        EXPECT_TRUE(KDL::Equal(incremental, test.solution.Phi(0), 1e-12));
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testKinematicEnvironmentElementRemoval)
+{
+    try
+    {
+        TEST_COUT << "Kinematic environment element removal test";
+        TestClass test;
+        KinematicTree& tree = test.scene->GetKinematicTree();
+        const Eigen::VectorXd x = tree.GetRandomControlledState();
+        test.scene->Update(x, 0.0);
+
+        std::vector<Eigen::Vector3d> positions;
+        for (int k = 0; k < 3; ++k)
+        {
+            Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+            pose.translation() = Eigen::Vector3d::Random();
+            positions.push_back(pose.translation());
+            tree.AddEnvironmentElement("object" + std::to_string(k), pose);
+            tree.AddEnvironmentElement("object" + std::to_string(k) + "_child", Eigen::Isometry3d::Identity(), "object" + std::to_string(k));
+        }
+        test.scene->Update(x, 0.0);
+
+        // Moving an element only recomputes its subtree
+        positions[2] = Eigen::Vector3d::Random();
+        tree.SetElementPose("object2", KDL::Frame(KDL::Vector(positions[2](0), positions[2](1), positions[2](2))));
+        test.scene->Update(x, 0.0);
+        EXPECT_EQ(tree.GetNumUpdatedElements(), 2u);
+
+        // Removing an element removes its subtree, the ids of the following elements are their new indices
+        tree.RemoveEnvironmentElement("object1");
+        EXPECT_FALSE(tree.DoesLinkWithNameExist("object1"));
+        EXPECT_FALSE(tree.DoesLinkWithNameExist("object1_child"));
+        const std::vector<std::weak_ptr<KinematicElement>>& elements = tree.GetTree();
+        for (std::size_t id = tree.GetModelTree().size(); id < elements.size(); ++id) EXPECT_EQ(elements[id].lock()->id, static_cast<int>(id));
+        test.scene->Update(x, 0.0);
+        EXPECT_EQ(tree.GetNumUpdatedElements(), 0u);
+
+        for (int k : {0, 2})
+        {
+            const std::string name = "object" + std::to_string(k) + "_child";
+            const KDL::Frame expected(KDL::Vector(positions[k](0), positions[k](1), positions[k](2)));
+            EXPECT_TRUE(KDL::Equal(tree.FK(name, KDL::Frame(), "", KDL::Frame()), expected, 1e-12));
+            EXPECT_TRUE(KDL::Equal(tree.FK(tree.GetFrameHandle(name), KDL::Frame(), tree.GetFrameHandle(""), KDL::Frame()), expected, 1e-12));
+        }
+
+        // Elements appended after the removal are updated in place as well
+        tree.AddEnvironmentElement("object3", Eigen::Isometry3d::Identity());
+        test.scene->Update(x, 0.0);
+        EXPECT_EQ(tree.GetNumUpdatedElements(), 1u);
+
+        const KDL::Frame incremental = tree.FK("object2_child", KDL::Frame(), "", KDL::Frame());
+        tree.RequestFullTreeUpdate();
+        test.scene->Update(x, 0.0);
+        EXPECT_TRUE(KDL::Equal(incremental, tree.FK("object2_child", KDL::Frame(), "", KDL::Frame()), 1e-12));
+        EXPECT_THROW(tree.RemoveEnvironmentElement("endeff"), std::exception);
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testKinematicsBackendPinocchio)
+{
+    try
+    {
+        TEST_COUT << "Pinocchio kinematics backend test";
+        TestClass test;
+        KinematicTree& tree = test.scene->GetKinematicTree();
+        Eigen::Isometry3d pose_object = Eigen::Isometry3d::Identity();
+        pose_object.translation() = Eigen::Vector3d::Random();
+        tree.AddElement("object", pose_object, "link3");
+        tree.AddElement("world_object", pose_object);
+        tree.UpdateModel();
+
+        const KDL::Frame offset = GetFrame(Eigen::VectorXd::Random(6));
+        KinematicsRequest request;
+        request.flags = KIN_FK | KIN_J;
+        request.frames = {KinematicFrameRequest("endeff", offset), KinematicFrameRequest("link3", offset, "link1", offset),
+                          KinematicFrameRequest("object", KDL::Frame(), "endeff"), KinematicFrameRequest("world_object", offset, "link2")};
+        std::shared_ptr<KinematicResponse> response = tree.RequestFrames(request);
+
+        // Without Pinocchio, the backend falls back to KDL and the comparison is trivial
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            const Eigen::VectorXd x = tree.GetRandomControlledState();
+            tree.SetKinematicsBackend(KINEMATICS_BACKEND_KDL);
+            tree.Update(x);
+            const ArrayFrame Phi = response->Phi;
+            const ArrayJacobian jacobian = response->jacobian;
+            tree.SetKinematicsBackend(KINEMATICS_BACKEND_PINOCCHIO);
+            tree.Update(x);
+            for (int i = 0; i < Phi.rows(); ++i)
+            {
+                EXPECT_TRUE(KDL::Equal(response->Phi(i), Phi(i), 1e-10));
+                EXPECT_LT((response->jacobian(i).data - jacobian(i).data).norm(), 1e-10);
+            }
+        }
+
+        // Poses without Jacobians are composed from the element frames with either backend
+        request.flags = KIN_FK;
+        response = tree.RequestFrames(request);
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            const Eigen::VectorXd x = tree.GetRandomControlledState();
+            tree.SetKinematicsBackend(KINEMATICS_BACKEND_KDL);
+            tree.Update(x);
+            const ArrayFrame Phi = response->Phi;
+            tree.SetKinematicsBackend(KINEMATICS_BACKEND_PINOCCHIO);
+            tree.UpdateFrames(x);
+            for (int i = 0; i < Phi.rows(); ++i) EXPECT_TRUE(KDL::Equal(response->Phi(i), Phi(i), 1e-10));
+            tree.Update(x);
+            for (int i = 0; i < Phi.rows(); ++i) EXPECT_TRUE(KDL::Equal(response->Phi(i), Phi(i), 1e-10));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testKinematicFrameHandles)
+{
+    try
+    {
+        TEST_COUT << "Kinematic frame handle test";
+        TestClass test;
+        KinematicTree& tree = test.scene->GetKinematicTree();
+        const int endeff = tree.GetFrameHandle("endeff");
+        const int link1 = tree.GetFrameHandle("link1");
+        const int root = tree.GetFrameHandle("");
+        EXPECT_THROW(tree.GetFrameHandle("unknown_link"), std::exception);
+        EXPECT_THROW(tree.FK(-1, KDL::Frame(), root, KDL::Frame()), std::exception);
+
+        const KDL::Frame offset = GetFrame(Eigen::VectorXd::Random(6));
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            test.scene->Update(tree.GetRandomControlledState(), 0.0);
+            EXPECT_TRUE(KDL::Equal(tree.FK(endeff, offset, link1, KDL::Frame()), tree.FK("endeff", offset, "link1", KDL::Frame()), 1e-12));
+            EXPECT_TRUE(KDL::Equal(tree.FK(endeff, KDL::Frame(), root, KDL::Frame()), test.solution.Phi(0), 1e-12));
+            EXPECT_LT((tree.Jacobian(endeff, offset, link1, KDL::Frame()) - tree.Jacobian("endeff", offset, "link1", KDL::Frame())).norm(), 1e-12);
+            const Hessian H_handle = tree.Hessian(endeff, offset, link1, KDL::Frame());
+            const Hessian H_name = tree.Hessian("endeff", offset, "link1", KDL::Frame());
+            for (int i = 0; i < 6; ++i) EXPECT_LT((H_handle(i) - H_name(i)).norm(), 1e-12);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testFixedKinematicSolution)
+{
+    try
+    {
+        TEST_COUT << "Fixed-size kinematic solution test";
+        TestClass test;
+        ASSERT_EQ(test.N, 3);
+        EXPECT_THROW(FixedKinematicSolution<7>{test.solution}, std::exception);
+        FixedKinematicSolution<3> fixed(test.solution);
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            test.scene->Update(test.scene->GetKinematicTree().GetRandomControlledState(), 0.0);
+            EXPECT_EQ(fixed.Size(), 1);
+            EXPECT_TRUE(fixed.X() == test.solution.X);
+            EXPECT_TRUE(KDL::Equal(fixed.Phi(0), test.solution.Phi(0), 0.0));
+            EXPECT_TRUE(fixed.Jacobian(0) == test.solution.jacobian(0).data);
+            for (int i = 0; i < 6; ++i) EXPECT_TRUE(fixed.Hessian(0, i) == test.solution.hessian(0)(i));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testKinematicWorkspaceUpdate)
+{
+    try
+    {
+        TEST_COUT << "Kinematic concurrent workspace update test";
+        TestClass test;
+        const KinematicTree& tree = test.scene->GetKinematicTree();
+        const int num_threads = 4;
+        Eigen::MatrixXd X(test.N, num_trials_);
+        for (int k = 0; k < num_trials_; ++k) X.col(k) = test.scene->GetKinematicTree().GetRandomControlledState();
+
+        std::vector<std::vector<KDL::Frame>> results(num_threads, std::vector<KDL::Frame>(num_trials_));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back([&, t]() {
+                KinematicWorkspace workspace;
+                for (int k = 0; k < num_trials_; ++k)
+                {
+                    tree.Update(X.col(k), workspace);
+                    results[t][k] = workspace.responses[0].Phi(0);
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            test.scene->Update(X.col(k), 0.0);
+            for (int t = 0; t < num_threads; ++t) EXPECT_TRUE(KDL::Equal(results[t][k], test.solution.Phi(0), 1e-12));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testKinematicJacobianDot)
+{
+    try
+    {
+        TEST_COUT << "Kinematic Jacobian time-derivative test";
+        constexpr double h = 1e-6;
+        TestClass test;
+        KinematicsRequest request;
+        request.flags = KIN_FK | KIN_J | KIN_FK_VEL | KIN_J_DOT;
+        request.frames = {KinematicFrameRequest("endeff", GetFrame(Eigen::VectorXd::Random(3)))};
+        test.solution = KinematicSolution(0, 1);
+        test.scene->RequestKinematics(request, std::bind(&TestClass::UpdateKinematics, &test, std::placeholders::_1));
+
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            const Eigen::VectorXd x = test.scene->GetKinematicTree().GetRandomControlledState();
+            const Eigen::VectorXd x_dot = Eigen::VectorXd::Random(test.N);
+            test.scene->Update(x, x_dot, 0.0);
+            const Eigen::MatrixXd J0 = test.solution.jacobian(0).data;
+            const Eigen::MatrixXd Jdot = test.solution.jacobian_dot(0).data;
+            Eigen::VectorXd twist(6);
+            for (int i = 0; i < 6; ++i) twist(i) = test.solution.Phi_dot(0)[i];
+            EXPECT_LT((twist - J0 * x_dot).norm(), 1e-12);
+
+            test.scene->Update(x + h * x_dot, 0.0);
+            const Eigen::MatrixXd Jdot_fd = (test.solution.jacobian(0).data - J0) / h;
+            EXPECT_LT((Jdot - Jdot_fd).norm(), 1e-4);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testKinematicResponsePool)
+{
+    try
+    {
+        TEST_COUT << "Kinematic response pool test";
+        TestClass test;
+        KinematicTree& tree = test.scene->GetKinematicTree();
+        std::vector<std::shared_ptr<KinematicResponse>> responses;
+        tree.GetKinematicResponses(10, responses);
+        ASSERT_EQ(responses.size(), 10u);
+        for (int t = 1; t < 10; ++t) EXPECT_EQ(responses[t].get(), responses[0].get() + t);
+        const KinematicResponse* first = responses[0].get();
+
+        // Shrinking the horizon reuses the pool
+        tree.SetKinematicResponse(responses[3]);
+        responses.clear();
+        tree.GetKinematicResponses(5, responses);
+        EXPECT_EQ(responses[0].get(), first);
+
+        // Responses still in use are not handed out again
+        std::vector<std::shared_ptr<KinematicResponse>> other;
+        tree.GetKinematicResponses(5, other);
+        EXPECT_NE(other[0].get(), first);
+
+        // A new request invalidates the pool
+        KinematicsRequest request;
+        request.flags = KIN_FK | KIN_J;
+        request.frames = {KinematicFrameRequest("link2")};
+        test.scene->RequestKinematics(request, std::bind(&TestClass::UpdateKinematics, &test, std::placeholders::_1));
+        responses.clear();
+        other.clear();
+        tree.GetKinematicResponses(5, responses);
+        EXPECT_FALSE(responses[0]->flags & KIN_H);
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testRandomControlledStates)
+{
+    try
+    {
+        TEST_COUT << "Bulk random state sampling test";
+        TestClass test;
+        KinematicTree& tree = test.scene->GetKinematicTree();
+        tree.SetSeed(42);
+        Eigen::MatrixXd states(test.N, 1000), states_again(test.N, 1000), other_stream(test.N, 1000);
+        tree.GetRandomControlledStates(states, 3);
+        tree.GetRandomControlledStates(states_again, 3);
+        tree.GetRandomControlledStates(other_stream, 4);
+        EXPECT_TRUE(states == states_again);
+        EXPECT_FALSE(states == other_stream);
+
+        // Sampling at an offset continues the stream
+        Eigen::MatrixXd tail(test.N, 500);
+        tree.GetRandomControlledStates(tail, 3, 500);
+        EXPECT_TRUE(tail == states.rightCols(500));
+
+        const Eigen::MatrixXd& limits = tree.GetJointLimits();
+        for (int i = 0; i < test.N; ++i)
+        {
+            EXPECT_GE(states.row(i).minCoeff(), limits(i, LIMIT_POSITION_LOWER));
+            EXPECT_LE(states.row(i).maxCoeff(), limits(i, LIMIT_POSITION_UPPER));
+            EXPECT_NEAR(states.row(i).mean(), limits.row(i).mean(), 0.1 * (limits(i, LIMIT_POSITION_UPPER) - limits(i, LIMIT_POSITION_LOWER)));
+        }
+        Eigen::MatrixXd wrong_size(test.N + 1, 1);
+        EXPECT_THROW(tree.GetRandomControlledStates(wrong_size), std::exception);
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testKinematicIncrementalUpdate)
+{
+    try
+    {
+        TEST_COUT << "Kinematic incremental update test";
+        TestClass test;
+        KinematicTree& tree = test.scene->GetKinematicTree();
+
+        Eigen::VectorXd x0 = tree.GetRandomControlledState();
+        tree.RequestFullTreeUpdate();
+        test.scene->Update(x0, 0.0);
+        const std::size_t num_elements = tree.GetNumUpdatedElements();
+        test.scene->Update(x0, 0.0);
+        EXPECT_EQ(tree.GetNumUpdatedElements(), 0u);
+
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            // Perturb only the last joint, i.e., only the subtree below it is recomputed
+            Eigen::VectorXd x = x0;
+            x(test.N - 1) = tree.GetRandomControlledState()(test.N - 1);
+            test.scene->Update(x, 0.0);
+            EXPECT_GT(tree.GetNumUpdatedElements(), 0u);
+            EXPECT_LT(tree.GetNumUpdatedElements(), num_elements);
+            const KDL::Frame incremental = test.solution.Phi(0);
+
+            // Exactly the recomputed elements carry the stamp of the last update
+            std::size_t num_stamped_elements = 0;
+            for (const auto& element : tree.GetTreeMap())
+            {
+                if (element.second.lock()->frame_stamp == tree.GetUpdateStamp()) ++num_stamped_elements;
+            }
+            EXPECT_EQ(num_stamped_elements, tree.GetNumUpdatedElements());
+
+            tree.RequestFullTreeUpdate();
+            test.scene->Update(x, 0.0);
+            EXPECT_EQ(tree.GetNumUpdatedElements(), num_elements);
+            EXPECT_TRUE(KDL::Equal(incremental, test.solution.Phi(0), 1e-12));
+            x0 = x;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testSceneClone)
+{
+    try
+    {
+        TEST_COUT << "Scene clone test";
+        TestClass test;
+        Eigen::VectorXd x0 = test.scene->GetKinematicTree().GetRandomControlledState();
+        test.scene->Update(x0, 0.0);
+
+        ScenePtr clone = test.scene->Clone();
+        EXPECT_TRUE(clone->GetControlledState().isApprox(x0));
+        EXPECT_EQ(clone->GetControlledJointNames(), test.scene->GetControlledJointNames());
+
+        KinematicSolution clone_solution(0, 1);
+        KinematicsRequest request;
+        request.flags = KIN_FK | KIN_J | KIN_H;
+        request.frames = {KinematicFrameRequest("endeff")};
+        clone->RequestKinematics(request, [&clone_solution](std::shared_ptr<KinematicResponse> response) { clone_solution.Create(response); });
+
+        for (int k = 0; k < num_trials_; ++k)
+        {
+            // Updating the clone must not affect the original scene
+            Eigen::VectorXd x = clone->GetKinematicTree().GetRandomControlledState();
+            clone->Update(x, 0.0);
+            EXPECT_TRUE(test.scene->GetControlledState().isApprox(x0));
+
+            test.scene->Update(x, 0.0);
+            EXPECT_TRUE(KDL::Equal(clone_solution.Phi(0), test.solution.Phi(0), 1e-12));
+            EXPECT_TRUE(clone_solution.jacobian(0).data.isApprox(test.solution.jacobian(0).data));
+            test.scene->Update(x0, 0.0);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testSceneSnapshot)
+{
+    try
+    {
+        TEST_COUT << "Scene snapshot test";
+        TestClass test;
+
+        // A tetrahedron as a minimal mesh
+        shapes::Mesh* mesh = new shapes::Mesh(4, 4);
+        const double vertices[12] = {0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1};
+        const unsigned int triangles[12] = {0, 2, 1, 0, 1, 3, 0, 3, 2, 1, 2, 3};
+        std::copy(vertices, vertices + 12, mesh->vertices);
+        std::copy(triangles, triangles + 12, mesh->triangles);
+        const KDL::Frame box_pose(KDL::Rotation::RPY(0.1, 0.2, 0.3), KDL::Vector(1.0, 2.0, 3.0));
+        const KDL::Frame mesh_pose(KDL::Vector(-1.0, 0.0, 0.5));
+        test.scene->AddObjectToEnvironment("box", box_pose, shapes::ShapeConstPtr(new shapes::Box(0.1, 0.2, 0.3)), Eigen::Vector4d(1.0, 0.0, 0.0, 1.0));
+        test.scene->AddObjectToEnvironment("mesh", mesh_pose, shapes::ShapeConstPtr(mesh));
+
+        const std::string file_name = CreateTemporaryFile("exotica_test_scene_snapshot");
+        test.scene->SaveSceneSnapshot(file_name);
+        test.scene->CleanScene();
+        EXPECT_EQ(test.scene->GetTreeMap().count("box"), 0u);
+
+        test.scene->LoadSceneFile(file_name);
+        const auto& tree_map = test.scene->GetKinematicTree().GetTreeMap();
+        ASSERT_EQ(tree_map.count("box"), 1u);
+        ASSERT_EQ(tree_map.count("mesh"), 1u);
+        EXPECT_TRUE(KDL::Equal(tree_map.at("box").lock()->segment.getFrameToTip(), box_pose, 1e-12));
+        EXPECT_TRUE(KDL::Equal(tree_map.at("mesh").lock()->segment.getFrameToTip(), mesh_pose, 1e-12));
+
+        const auto loaded_mesh = std::static_pointer_cast<const shapes::Mesh>(tree_map.at("mesh_collision_0").lock()->shape);
+        ASSERT_EQ(loaded_mesh->vertex_count, 4u);
+        ASSERT_EQ(loaded_mesh->triangle_count, 4u);
+        EXPECT_TRUE(std::equal(vertices, vertices + 12, loaded_mesh->vertices));
+        EXPECT_TRUE(std::equal(triangles, triangles + 12, loaded_mesh->triangles));
+        // The normals are stored in the snapshot
+        shapes::Mesh reference(4, 4);
+        std::copy(vertices, vertices + 12, reference.vertices);
+        std::copy(triangles, triangles + 12, reference.triangles);
+        reference.computeTriangleNormals();
+        reference.computeVertexNormals();
+        EXPECT_TRUE(std::equal(reference.triangle_normals, reference.triangle_normals + 12, loaded_mesh->triangle_normals));
+        EXPECT_TRUE(std::equal(reference.vertex_normals, reference.vertex_normals + 12, loaded_mesh->vertex_normals));
+
+        // Corrupt snapshots are rejected instead of trusting the counts and indices stored in the file
+        std::ifstream file(file_name, std::ios::binary);
+        const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        const uint64_t mesh_header[3] = {shapes::MESH, 4, 4};
+        const std::size_t mesh_position = data.find(std::string(reinterpret_cast<const char*>(mesh_header), sizeof(mesh_header)));
+        ASSERT_NE(mesh_position, std::string::npos);
+        auto expect_load_fails = [&test, &file_name](const std::string& corrupt_data) {
+            std::ofstream(file_name, std::ios::binary) << corrupt_data;
+            test.scene->CleanScene();
+            EXPECT_THROW(test.scene->LoadSceneFile(file_name), std::exception);
+        };
+
+        expect_load_fails(data.substr(0, data.size() - 16));
+        for (const uint64_t count : {uint64_t(1) << 40, uint64_t(-1) / 24 + 1, uint64_t(-1)})
+        {
+            std::string corrupt_data = data;
+            corrupt_data.replace(mesh_position + 8, 8, reinterpret_cast<const char*>(&count), 8);  // Vertex count
+            expect_load_fails(corrupt_data);
+            corrupt_data = data;
+            corrupt_data.replace(mesh_position + 16, 8, reinterpret_cast<const char*>(&count), 8);  // Triangle count
+            expect_load_fails(corrupt_data);
+        }
+        std::string corrupt_data = data;
+        const unsigned int invalid_index = 4;
+        corrupt_data.replace(mesh_position + 24 + sizeof(vertices), sizeof(invalid_index), reinterpret_cast<const char*>(&invalid_index), sizeof(invalid_index));
+        expect_load_fails(corrupt_data);
+        std::remove(file_name.c_str());
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testSplineTrajectory)
+{
+    try
+    {
+        Eigen::VectorXd times(5);
+        times << 0.0, 0.5, 1.2, 2.0, 3.0;
+        const Eigen::MatrixXd knots = Eigen::MatrixXd::Random(5, 3);
+        constexpr double h = 1e-6;
+        for (SplineTrajectory::SplineType type : {SplineTrajectory::Cubic, SplineTrajectory::Quintic})
+        {
+            SplineTrajectory spline(times, knots, type);
+            EXPECT_TRUE(spline.GetPositions(times).isApprox(knots));
+            for (double t = 0.1; t < 2.9; t += 0.37)
+            {
+                EXPECT_TRUE(((spline.GetPosition(t + h) - spline.GetPosition(t - h)) / (2.0 * h)).isApprox(spline.GetVelocity(t), 1e-5));
+                EXPECT_TRUE(((spline.GetVelocity(t + h) - spline.GetVelocity(t - h)) / (2.0 * h)).isApprox(spline.GetAcceleration(t), 1e-5));
+            }
+            for (int i = 1; i < times.size() - 1; ++i)
+            {
+                EXPECT_TRUE(spline.GetAcceleration(times(i) - 1e-9).isApprox(spline.GetAcceleration(times(i) + 1e-9), 1e-5));
+            }
+            EXPECT_TRUE(spline.GetPosition(10.0).isApprox(knots.bottomRows<1>().transpose()));
+        }
+
+        const Eigen::VectorXd uniform_times = Eigen::VectorXd::LinSpaced(11, 0.0, 1.0);
+        const Eigen::MatrixXd uniform_knots = Eigen::MatrixXd::Random(11, 2);
+        EXPECT_TRUE(SplineTrajectory(uniform_times, uniform_knots).GetPositions(uniform_times).isApprox(uniform_knots));
+
+        // A quintic spline with the exact derivatives reproduces a quintic polynomial
+        const auto polynomial = [](double t) { return std::pow(t, 5) - t; };
+        Eigen::MatrixXd positions(times.size(), 1), velocities(times.size(), 1), accelerations(times.size(), 1);
+        for (int i = 0; i < times.size(); ++i)
+        {
+            positions(i, 0) = polynomial(times(i));
+            velocities(i, 0) = 5.0 * std::pow(times(i), 4) - 1.0;
+            accelerations(i, 0) = 20.0 * std::pow(times(i), 3);
+        }
+        EXPECT_NEAR(SplineTrajectory(times, positions, velocities, accelerations).GetPosition(1.7)(0), polynomial(1.7), 1e-9);
+
+        EXPECT_THROW(SplineTrajectory(times.reverse(), knots), std::exception);
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaCore, testFloatingBaseKernels)
+{
+    constexpr int num_joints = 2;
+    constexpr double eps = 1e-6;
+    auto random_configuration = []() {
+        Eigen::VectorXd q = Eigen::VectorXd::Random(7 + num_joints);
+        q.segment<4>(3) = Eigen::Quaterniond::UnitRandom().coeffs();
+        return q;
+    };
+
+    for (int trial = 0; trial < num_trials_; ++trial)
+    {
+        const Eigen::VectorXd q_1 = random_configuration(), q_2 = random_configuration();
+        const Eigen::VectorXd dq = Eigen::VectorXd::Random(6 + num_joints);
+        Eigen::VectorXd q(7 + num_joints), delta(6 + num_joints);
+
+        // (q (+) dq) (-) q = dq
+        floating_base::Integrate(q_1, dq, q);
+        floating_base::Difference(q, q_1, delta);
+        EXPECT_TRUE(delta.isApprox(dq, 1e-9));
+        EXPECT_NEAR(q.segment<4>(3).norm(), 1.0, 1e-12);
+
+        // Closed-form Jacobians against central differences in the tangent space
+        Eigen::MatrixXd J_1(6 + num_joints, 6 + num_joints), J_2(6 + num_joints, 6 + num_joints);
+        floating_base::dDifference(q_1, q_2, ArgumentPosition::ARG0, J_1);
+        floating_base::dDifference(q_1, q_2, ArgumentPosition::ARG1, J_2);
+        Eigen::VectorXd q_plus(7 + num_joints), q_minus(7 + num_joints), delta_plus(6 + num_joints), delta_minus(6 + num_joints);
+        for (int i = 0; i < 6 + num_joints; ++i)
+        {
+            const Eigen::VectorXd e = 0.5 * eps * Eigen::VectorXd::Unit(6 + num_joints, i);
+            floating_base::Integrate(q_1, e, q_plus);
+            floating_base::Integrate(q_1, -e, q_minus);
+            floating_base::Difference(q_plus, q_2, delta_plus);
+            floating_base::Difference(q_minus, q_2, delta_minus);
+            EXPECT_TRUE(((delta_plus - delta_minus) / eps).isApprox(J_1.col(i), 1e-5));
+
+            floating_base::Integrate(q_2, e, q_plus);
+            floating_base::Integrate(q_2, -e, q_minus);
+            floating_base::Difference(q_1, q_plus, delta_plus);
+            floating_base::Difference(q_1, q_minus, delta_minus);
+            EXPECT_TRUE(((delta_plus - delta_minus) / eps).isApprox(J_2.col(i), 1e-5));
+        }
+
+        const floating_base::Vector6d twist = dq.head<6>();
+        EXPECT_TRUE((floating_base::JlogSE3(twist) * floating_base::JexpSE3(twist)).isIdentity(1e-9));
+    }
+}
+
+// Matrix exponential of the 4x4 twist by scaling and squaring of the Taylor series, independent of the closed forms
+Eigen::Matrix4d NumericalExpSE3(const floating_base::Vector6d& twist)
+{
+    Eigen::Matrix4d X = Eigen::Matrix4d::Zero();
+    X.topLeftCorner<3, 3>() = floating_base::Skew(twist.tail<3>());
+    X.topRightCorner<3, 1>() = twist.head<3>();
+    int squarings = 0;
+    while (X.norm() > 0.1)
+    {
+        X /= 2.0;
+        ++squarings;
+    }
+    Eigen::Matrix4d exp = Eigen::Matrix4d::Identity(), term = Eigen::Matrix4d::Identity();
+    for (int k = 1; k < 20; ++k)
+    {
+        term = term * X / k;
+        exp += term;
+    }
+    for (int i = 0; i < squarings; ++i) exp = exp * exp;
+    return exp;
+}
+
+TEST(ExoticaCore, testFloatingBaseExpSE3)
+{
+    constexpr double eps = 1e-6;
+    // Angles around the switch to the Taylor expansions included
+    for (const double angle : {0.0, 1e-8, 1e-5, 1e-3, 0.99e-2, 1.01e-2, 0.1, 1.0, 2.5})
+    {
+        for (int trial = 0; trial < num_trials_; ++trial)
+        {
+            floating_base::Vector6d twist = floating_base::Vector6d::Random();
+            twist.tail<3>() = angle * twist.tail<3>().normalized();
+
+            Eigen::Matrix3d R;
+            Eigen::Vector3d p;
+            floating_base::ExpSE3(twist, R, p);
+            const Eigen::Matrix4d M = NumericalExpSE3(twist);
+            EXPECT_TRUE(R.isApprox(M.topLeftCorner<3, 3>(), 1e-12));
+            EXPECT_LT((p - M.topRightCorner<3, 1>()).norm(), 1e-12);
+
+            // exp(twist + d) = exp(twist) exp(Jexp d)
+            const floating_base::Matrix6d Jexp = floating_base::JexpSE3(twist);
+            const Eigen::Matrix4d M_inv = M.inverse();
+            for (int i = 0; i < 6; ++i)
+            {
+                const floating_base::Vector6d d = 0.5 * eps * floating_base::Vector6d::Unit(i);
+                const Eigen::Matrix4d M_plus = M_inv * NumericalExpSE3(twist + d), M_minus = M_inv * NumericalExpSE3(twist - d);
+                const floating_base::Vector6d column = (floating_base::LogSE3(M_plus.topLeftCorner<3, 3>(), M_plus.topRightCorner<3, 1>()) -
+                                                        floating_base::LogSE3(M_minus.topLeftCorner<3, 3>(), M_minus.topRightCorner<3, 1>())) /
+                                                       eps;
+                EXPECT_LT((column - Jexp.col(i)).norm(), 1e-7);
+            }
+        }
+    }
+
+    // The expansions have to agree with the closed forms where they switch over
+    const floating_base::ExpCoefficients below(1e-2 * (1.0 - 1e-9)), above(1e-2 * (1.0 + 1e-9));
+    EXPECT_NEAR(below.a, above.a, 1e-12);
+    EXPECT_NEAR(below.b, above.b, 1e-12);
+    EXPECT_NEAR(below.c, above.c, 1e-12);
+    EXPECT_NEAR(below.d, above.d, 1e-7);
+    EXPECT_NEAR(below.e, above.e, 1e-7);
+    EXPECT_NEAR(below.f, above.f, 1e-7);
+}
+
+#ifdef MSGPACK_FOUND
+TEST(ExoticaCore, testMeshcatObjectUuids)
+{
+    auto make_object = [](const std::string& path, double radius) {
+        auto object = visualization::SetObject(path, visualization::CreateGeometryObject(visualization::GeometrySphere(radius), visualization::Material(visualization::RGB(1.0, 0.0, 0.0))));
+        visualization::AssignUuids(object.object, object.path);
+        return object;
+    };
+    auto pack = [](const visualization::SetObjectType<visualization::Object<visualization::GeometrySphere>>& object) {
+        msgpack::sbuffer buffer;
+        msgpack::pack(buffer, object);
+        return std::string(buffer.data(), buffer.size());
+    };
+
+    // The same content under the same path packs to the same bytes, despite the random UUIDs of the constructors
+    const auto object = make_object("/exotica/scene/link", 0.1);
+    EXPECT_EQ(pack(object), pack(make_object("/exotica/scene/link", 0.1)));
+    EXPECT_EQ(object.object.object.geometry, object.object.geometries[0].uuid);
+    EXPECT_EQ(object.object.object.material, object.object.materials[0].uuid);
+
+    const auto moved = make_object("/exotica/scene/other_link", 0.1);
+    EXPECT_NE(object.object.object.uuid, moved.object.object.uuid);
+    EXPECT_NE(pack(object), pack(make_object("/exotica/scene/link", 0.2)));
+}
+
+TEST(ExoticaCore, testMeshcatSendThreadRecoversFromFailedRequests)
+{
+    TestClass test;
+
+    // MeshCat server that leaves the first message of the send thread unanswered
+    zmq::context_t context(1);
+    zmq::socket_t server(context, ZMQ_ROUTER);
+    server.bind("tcp://127.0.0.1:*");
+    char endpoint[256];
+    size_t endpoint_size = sizeof(endpoint);
+    server.getsockopt(ZMQ_LAST_ENDPOINT, endpoint, &endpoint_size);
+
+    std::atomic<bool> stop_server(false);
+    std::mutex received_mutex;
+    std::vector<std::string> received_paths;
+    std::thread server_thread([&]() {
+        int num_requests = 0;
+        zmq::pollitem_t item{static_cast<void*>(server), 0, ZMQ_POLLIN, 0};
+        while (!stop_server)
+        {
+            if (zmq::poll(&item, 1, 100) == 0) continue;
+
+            // Identity, empty delimiter, then the frames of the request: "url" or type, path and data
+            std::vector<std::string> frames;
+            do
+            {
+                zmq::message_t frame;
+                server.recv(&frame);
+                frames.emplace_back(static_cast<const char*>(frame.data()), frame.size());
+            } while (server.getsockopt<int>(ZMQ_RCVMORE));
+            if (frames.size() < 3) continue;
+            if (frames.size() > 3)
+            {
+                std::lock_guard<std::mutex> lock(received_mutex);
+                received_paths.push_back(frames[3]);
+            }
+            if (++num_requests == 2) continue;
+
+            const std::string reply = frames[2] == "url" ? "http://127.0.0.1:7000/static/" : "ok";
+            server.send(frames[0].data(), frames[0].size(), ZMQ_SNDMORE);
+            server.send("", 0, ZMQ_SNDMORE);
+            server.send(reply.data(), reply.size());
+        }
+    });
+
+    auto received = [&](const std::string& path) {
+        std::lock_guard<std::mutex> lock(received_mutex);
+        return std::find(received_paths.begin(), received_paths.end(), path) != received_paths.end();
+    };
+
+    {
+        VisualizationMeshcat visualization(test.scene, endpoint);
+        // The first message times out, the request socket then fails to send the second one and is replaced
+        for (const std::string path : {"/exotica/a", "/exotica/b", "/exotica/c"}) visualization.SetProperty(path, "visible", true);
+        visualization.Flush();
+        EXPECT_TRUE(received("/exotica/a"));
+        EXPECT_TRUE(received("/exotica/c"));
+
+        // The send thread is still running
+        visualization.SetProperty("/exotica/d", "visible", false);
+        visualization.Flush();
+        EXPECT_TRUE(received("/exotica/d"));
+    }
+
+    stop_server = true;
+    server_thread.join();
+}
+#endif
+
 int main(int argc, char** argv)
 {
     testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_core/task_space_vector.h>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+
+using namespace exotica;
+
+namespace
+{
+/// \brief Position followed by one rotation of the given type, e.g., as a frame of EffFrame.
+TaskSpaceVector CreateFrame(const Eigen::Vector3d& position, const KDL::Rotation& rotation, RotationType type)
+{
+    TaskSpaceVector y;
+    y.map = {TaskVectorEntry(3, type)};
+    y.data.resize(3 + GetRotationTypeLength(type));
+    y.data.head<3>() = position;
+    y.data.tail(GetRotationTypeLength(type)) = SetRotation(rotation, type);
+    return y;
+}
+
+/// \brief Difference of the rotations through KDL, as used for all other rotation types.
+Eigen::Vector3d KDLDifference(const KDL::Rotation& R1, const KDL::Rotation& R2)
+{
+    const KDL::Vector rotvec = R1 * ((R2.Inverse() * R1).GetRot());
+    return Eigen::Vector3d(rotvec[0], rotvec[1], rotvec[2]);
+}
+
+class RandomRotations
+{
+public:
+    KDL::Rotation Random()
+    {
+        return Rotate(KDL::Rotation::Identity(), Angle());
+    }
+
+    double Angle()
+    {
+        return std::uniform_real_distribution<double>(0.0, M_PI)(generator_);
+    }
+
+    /// \brief Rotation of R by angle about a random axis.
+    KDL::Rotation Rotate(const KDL::Rotation& R, double angle)
+    {
+        std::normal_distribution<double> normal;
+        KDL::Vector axis(normal(generator_), normal(generator_), normal(generator_));
+        axis.Normalize();
+        return R * KDL::Rotation::Rot2(axis, angle);
+    }
+
+private:
+    std::mt19937 generator_{42};
+};
+
+void CheckAgainstKDL(RotationType type, double near_identity_tolerance, double near_antipodal_tolerance)
+{
+    RandomRotations rotations;
+    const Eigen::Vector3d p1(0.1, -0.2, 0.3), p2(-0.4, 0.5, 0.6);
+    Eigen::VectorXd difference(6);
+    for (int i = 0; i < 1000; ++i)
+    {
+        const KDL::Rotation R1 = rotations.Random();
+        for (const std::pair<double, double>& angle_and_tolerance : {std::make_pair(rotations.Angle(), 1e-12),
+                                                                     std::make_pair(1e-9, near_identity_tolerance),
+                                                                     std::make_pair(M_PI - 1e-6, near_antipodal_tolerance)})
+        {
+            const KDL::Rotation R2 = rotations.Rotate(R1, angle_and_tolerance.first);
+            CreateFrame(p1, R1, type).Difference(CreateFrame(p2, R2, type), difference);
+            EXPECT_TRUE(difference.head<3>().isApprox(p1 - p2));
+            EXPECT_LT((difference.tail<3>() - KDLDifference(R1, R2)).norm(), angle_and_tolerance.second) << "Angle " << angle_and_tolerance.first;
+        }
+    }
+}
+}  // namespace
+
+TEST(TaskSpaceVector, QuaternionDifferenceMatchesKDL)
+{
+    CheckAgainstKDL(RotationType::QUATERNION, 1e-8, 1e-6);
+}
+
+TEST(TaskSpaceVector, RotationMatrixDifferenceMatchesKDL)
+{
+    CheckAgainstKDL(RotationType::MATRIX, 1e-8, 1e-6);
+}
+
+TEST(TaskSpaceVector, QuaternionsAreNormalized)
+{
+    RandomRotations rotations;
+    const KDL::Rotation R1 = rotations.Random(), R2 = rotations.Random();
+    TaskSpaceVector y1 = CreateFrame(Eigen::Vector3d::Zero(), R1, RotationType::QUATERNION);
+    TaskSpaceVector y2 = CreateFrame(Eigen::Vector3d::Zero(), R2, RotationType::QUATERNION);
+    const Eigen::VectorXd expected = y1 - y2;
+    y1.data.tail<4>() *= 2.0;
+    y2.data.tail<4>() *= -0.5;  // Same rotation, opposite hemisphere
+    EXPECT_LT((y1 - y2 - expected).norm(), 1e-12);
+}
+
+TEST(TaskSpaceVector, SetZeroWritesIdentityRotations)
+{
+    for (RotationType type : {RotationType::QUATERNION, RotationType::MATRIX, RotationType::RPY})
+    {
+        TaskSpaceVector y;
+        y.map = {TaskVectorEntry(3, type)};
+        y.SetZero(3 + GetRotationTypeLength(type));
+        EXPECT_TRUE((y.data.tail(GetRotationTypeLength(type)) - SetRotation(KDL::Rotation::Identity(), type)).isZero());
+        EXPECT_TRUE(y.data.head<3>().isZero());
+    }
+}
@@ -0,0 +1,200 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_core/server.h>
+#include <exotica_core/tools/parallel_loop.h>
+#include <exotica_core/tools/thread_pool.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace exotica;
+
+TEST(ThreadPool, SubmitReturnsResults)
+{
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.GetNumThreads(), 3);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; ++i) results.push_back(pool.Submit([i]() { return i * i; }));
+    for (int i = 0; i < 100; ++i) EXPECT_EQ(results[i].get(), i * i);
+}
+
+TEST(ThreadPool, SubmitRethrowsExceptions)
+{
+    ThreadPool pool(2);
+    std::future<void> result = pool.Submit([]() { throw std::runtime_error("Task failed"); });
+    EXPECT_THROW(result.get(), std::runtime_error);
+}
+
+TEST(ThreadPool, ParallelForVisitsEachIndexOnce)
+{
+    for (int num_threads : {0, 1, 4})
+    {
+        ThreadPool pool(num_threads);
+        for (int grain_size : {1, 3, 100})
+        {
+            std::vector<std::atomic<int>> visits(257);
+            for (std::atomic<int>& visit : visits) visit = 0;
+            pool.ParallelFor(5, 257, [&visits](int i) { ++visits[i]; }, grain_size);
+            for (int i = 0; i < 257; ++i) EXPECT_EQ(visits[i].load(), i < 5 ? 0 : 1) << "Index " << i << " with " << num_threads << " threads and grain size " << grain_size;
+        }
+    }
+}
+
+TEST(ThreadPool, ParallelForRethrowsExceptions)
+{
+    ThreadPool pool(3);
+    std::atomic<int> calls(0);
+    EXPECT_THROW(pool.ParallelFor(0, 64, [&calls](int i) {
+        ++calls;
+        if (i == 10) throw std::runtime_error("Body failed");
+    }),
+                 std::runtime_error);
+    // The other chunks still run to completion
+    EXPECT_EQ(calls.load(), 64);
+
+    // The pool remains usable
+    std::atomic<int> sum(0);
+    pool.ParallelFor(0, 10, [&sum](int i) { sum += i; });
+    EXPECT_EQ(sum.load(), 45);
+}
+
+TEST(ThreadPool, NestedParallelForCompletes)
+{
+    // Nested calls from the workers must not deadlock although all workers are busy with the outer loop
+    ThreadPool pool(2);
+    std::atomic<int> sum(0);
+    pool.ParallelFor(0, 8, [&pool, &sum](int) { pool.ParallelFor(0, 8, [&sum](int j) { sum += j; }); });
+    EXPECT_EQ(sum.load(), 8 * 28);
+}
+
+TEST(ThreadPool, ParallelForRunsOnlyItsOwnChunksWhileWaiting)
+{
+    // The caller of a loop holds a lock while it waits for a helper, a concurrent loop takes the same lock in its body.
+    // The caller must not run chunks of the concurrent loop, which would lock the mutex a second time on the same thread.
+    ThreadPool pool(2);
+    std::mutex mutex;
+    std::atomic<bool> helper_started(false);
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<int> concurrent_calls_on_caller(0);
+    std::thread concurrent([&]() {
+        while (!helper_started) std::this_thread::yield();
+        pool.ParallelFor(0, 16, [&](int) {
+            if (std::this_thread::get_id() == caller)
+            {
+                ++concurrent_calls_on_caller;
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+        });
+    });
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pool.ParallelFor(0, 2, [&](int) {
+            // The caller finishes its chunk once the helper runs the other one, then waits while the concurrent loop is queued
+            if (std::this_thread::get_id() == caller)
+            {
+                while (!helper_started) std::this_thread::yield();
+                return;
+            }
+            helper_started = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        });
+    }
+    concurrent.join();
+    EXPECT_EQ(concurrent_calls_on_caller.load(), 0);
+}
+
+TEST(ThreadPool, DeterministicRunsSeriallyInOrder)
+{
+    ThreadPool pool(4, false, true);
+    EXPECT_TRUE(pool.IsDeterministic());
+    const std::thread::id caller = std::this_thread::get_id();
+    std::vector<int> order;
+    bool on_caller = true;
+    pool.ParallelFor(0, 20, [&](int i) {
+        order.push_back(i);
+        on_caller = on_caller && std::this_thread::get_id() == caller;
+    });
+    for (int i = 0; i < 10; ++i)
+    {
+        pool.Submit([&, i]() {
+             order.push_back(20 + i);
+             on_caller = on_caller && std::this_thread::get_id() == caller;
+         })
+            .get();
+    }
+    EXPECT_TRUE(on_caller);
+    ASSERT_EQ(order.size(), 30u);
+    for (int i = 0; i < 30; ++i) EXPECT_EQ(order[i], i);
+}
+
+TEST(ThreadPool, ParallelLoopRunsOnTheServerThreadPool)
+{
+    // Three threads including the caller, nested loops must not start threads of their own
+    Server::ConfigureThreadPool(3);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::vector<std::atomic<int>> visits(64);
+    for (std::atomic<int>& visit : visits) visit = 0;
+    ParallelLoop(4, 8, [&](int, int i) {
+        ParallelLoop(4, 8, [&](int thread, int j) {
+            EXPECT_LT(thread, 4);
+            ++visits[8 * i + j];
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        });
+    });
+    for (const std::atomic<int>& visit : visits) EXPECT_EQ(visit.load(), 1);
+    EXPECT_LE(threads.size(), 3u);
+
+    // The exception of the lowest block is rethrown
+    try
+    {
+        ParallelLoop(4, 8, [](int thread, int) { throw std::runtime_error(std::to_string(thread)); }, ParallelSchedule::Static);
+        ADD_FAILURE() << "No exception was thrown";
+    }
+    catch (const std::runtime_error& e)
+    {
+        EXPECT_EQ(std::string(e.what()), "0");
+    }
+    Server::ConfigureThreadPool();
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,267 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <benchmark/benchmark.h>
+
+#include <exotica_core/exotica_core.h>
+
+#include <string>
+#include <vector>
+
+using namespace exotica;
+
+// Throughput benchmarks of the kinematics, collision queries and core task maps.
+// Besides the console output, results can be written for trend tracking, e.g.:
+//   exotica_benchmarks --benchmark_out=exotica_benchmarks.json --benchmark_out_format=json
+
+namespace
+{
+constexpr int kNumStates = 256;  // Random states cycled through by each benchmark
+
+struct RobotModel
+{
+    std::string name;
+    std::string urdf;
+    std::string srdf;
+    std::string joint_group;
+    std::vector<std::string> end_effectors;
+};
+
+const std::vector<RobotModel>& GetRobotModels()
+{
+    static const std::vector<RobotModel> robots = {
+        {"LWR", "{exotica_examples}/resources/robots/lwr_simplified.urdf", "{exotica_examples}/resources/robots/lwr_simplified.srdf", "arm", {"lwr_arm_7_link"}},
+        {"Valkyrie", "{exotica_examples}/resources/robots/valkyrie_sim.urdf", "{exotica_examples}/resources/robots/valkyrie_sim.srdf", "whole_body", {"leftPalm", "rightPalm", "leftFoot", "rightFoot"}},
+        {"Talos", "{exotica_examples}/resources/robots/talos.urdf", "{exotica_examples}/resources/robots/talos.srdf", "whole_body", {"arm_left_7_link", "arm_right_7_link", "left_sole_link", "right_sole_link"}},
+    };
+    return robots;
+}
+
+Initializer CreateSceneInitializer(const RobotModel& robot, const std::string& collision_scene = "", const std::string& load_scene = "")
+{
+    Initializer scene("Scene", {{"Name", std::string("BenchmarkScene")},
+                                {"JointGroup", robot.joint_group},
+                                {"URDF", robot.urdf},
+                                {"SRDF", robot.srdf}});
+    if (collision_scene.empty())
+    {
+        scene.AddProperty(Property("DoNotInstantiateCollisionScene", false, true));
+    }
+    else
+    {
+        scene.AddProperty(Property("AlwaysUpdateCollisionScene", false, true));
+        scene.AddProperty(Property("CollisionScene", false, std::vector<Initializer>({Initializer("exotica/" + collision_scene, {{"Name", std::string("BenchmarkCollisionScene")}})})));
+    }
+    if (!load_scene.empty()) scene.AddProperty(Property("LoadScene", false, load_scene));
+    return scene;
+}
+
+Eigen::MatrixXd GetRandomStates(ScenePtr scene)
+{
+    Eigen::MatrixXd states(scene->GetKinematicTree().GetNumControlledJoints(), kNumStates);
+    scene->GetKinematicTree().GetRandomControlledStates(states);
+    return states;
+}
+
+void Kinematics(benchmark::State& state, const RobotModel& robot, KinematicRequestFlags flags)
+{
+    ScenePtr scene = Setup::CreateScene(CreateSceneInitializer(robot));
+    KinematicsRequest request;
+    request.flags = flags;
+    for (const std::string& link : robot.end_effectors) request.frames.push_back(KinematicFrameRequest(link));
+    std::shared_ptr<KinematicResponse> response;
+    scene->RequestKinematics(request, [&response](std::shared_ptr<KinematicResponse> new_response) { response = new_response; });
+
+    const Eigen::MatrixXd states = GetRandomStates(scene);
+    int i = 0;
+    for (auto _ : state)
+    {
+        scene->Update(states.col(i++ % kNumStates));
+        benchmark::DoNotOptimize(response.get());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["joints"] = scene->GetKinematicTree().GetNumControlledJoints();
+    state.counters["frames"] = static_cast<double>(robot.end_effectors.size());
+}
+
+// The LWR in front of a shelf, and the whole-body self-collision of Valkyrie
+struct CollisionBenchmark
+{
+    std::string name;
+    const RobotModel& robot;
+    std::string load_scene;
+    bool self;
+};
+
+const std::vector<CollisionBenchmark>& GetCollisionBenchmarks()
+{
+    static const std::vector<CollisionBenchmark> benchmarks = {
+        {"LWR_Shelf", GetRobotModels()[0], "{exotica_examples}/resources/scenes/g03_open_back_storage_shelf.scene", true},
+        {"LWR_Kallax", GetRobotModels()[0], "{exotica_examples}/resources/scenes/kallax.scene", true},
+        {"Valkyrie_Self", GetRobotModels()[1], "", true},
+    };
+    return benchmarks;
+}
+
+void IsStateValidQuery(benchmark::State& state, const CollisionBenchmark& setup, const std::string& collision_scene)
+{
+    ScenePtr scene = Setup::CreateScene(CreateSceneInitializer(setup.robot, collision_scene, setup.load_scene));
+    const Eigen::MatrixXd states = GetRandomStates(scene);
+    int i = 0, num_valid = 0;
+    for (auto _ : state)
+    {
+        scene->Update(states.col(i++ % kNumStates));
+        num_valid += scene->GetCollisionScene()->IsStateValid(setup.self);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["valid_ratio"] = static_cast<double>(num_valid) / static_cast<double>(state.iterations());
+}
+
+void CollisionDistanceQuery(benchmark::State& state, const CollisionBenchmark& setup, const std::string& collision_scene)
+{
+    ScenePtr scene = Setup::CreateScene(CreateSceneInitializer(setup.robot, collision_scene, setup.load_scene));
+    const Eigen::MatrixXd states = GetRandomStates(scene);
+    int i = 0;
+    std::size_t num_proxies = 0;
+    for (auto _ : state)
+    {
+        scene->Update(states.col(i++ % kNumStates));
+        num_proxies += scene->GetCollisionScene()->GetCollisionDistance(setup.self).size();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["proxies"] = static_cast<double>(num_proxies) / static_cast<double>(state.iterations());
+}
+
+Initializer EndEffector(const std::string& link)
+{
+    return Initializer("Frame", {{"Link", link}});
+}
+
+// Core task maps attached to the end-effector of the LWR
+std::vector<Initializer> GetTaskMapInitializers()
+{
+    const std::vector<Initializer> eff({EndEffector("lwr_arm_7_link")});
+    return {
+        Initializer("exotica/EffPosition", {{"Name", std::string("EffPosition")}, {"EndEffector", eff}}),
+        Initializer("exotica/EffPositionXY", {{"Name", std::string("EffPositionXY")}, {"EndEffector", eff}}),
+        Initializer("exotica/EffOrientation", {{"Name", std::string("EffOrientation")}, {"EndEffector", eff}}),
+        Initializer("exotica/EffFrame", {{"Name", std::string("EffFrame")}, {"EndEffector", eff}}),
+        Initializer("exotica/EffAxisAlignment", {{"Name", std::string("EffAxisAlignment")}, {"EndEffector", std::vector<Initializer>({Initializer("Frame", {{"Link", std::string("lwr_arm_7_link")}, {"Axis", std::string("1 0 0")}, {"Direction", std::string("0 0 1")}})})}}),
+        Initializer("exotica/Distance", {{"Name", std::string("Distance")}, {"EndEffector", eff}}),
+        Initializer("exotica/PointToLine", {{"Name", std::string("PointToLine")}, {"EndPoint", std::string("0.5 0.5 1")}, {"EndEffector", eff}}),
+        Initializer("exotica/JointLimit", {{"Name", std::string("JointLimit")}}),
+        Initializer("exotica/JointPose", {{"Name", std::string("JointPose")}}),
+        Initializer("exotica/CenterOfMass", {{"Name", std::string("CenterOfMass")}}),
+        Initializer("exotica/Manipulability", {{"Name", std::string("Manipulability")}, {"EndEffector", eff}}),
+        Initializer("exotica/JointTorqueMinimizationProxy", {{"Name", std::string("JointTorqueMinimizationProxy")}, {"EndEffector", eff}}),
+        Initializer("exotica/InteractionMesh", {{"Name", std::string("InteractionMesh")}, {"EndEffector", std::vector<Initializer>({EndEffector("lwr_arm_3_link"), EndEffector("lwr_arm_5_link"), EndEffector("lwr_arm_7_link")})}}),
+        Initializer("exotica/SphereCollision", {{"Name", std::string("SphereCollision")}, {"Precision", 0.1}, {"EndEffector", std::vector<Initializer>({Initializer("Frame", {{"Link", std::string("lwr_arm_3_link")}, {"Radius", 0.1}, {"Group", std::string("Elbow")}}), Initializer("Frame", {{"Link", std::string("lwr_arm_7_link")}, {"Radius", 0.1}, {"Group", std::string("Hand")}})})}}),
+        Initializer("exotica/CollisionCheck", {{"Name", std::string("CollisionCheck")}, {"SelfCollision", true}}),
+        Initializer("exotica/CollisionDistance", {{"Name", std::string("CollisionDistance")}}),
+        Initializer("exotica/SmoothCollisionDistance", {{"Name", std::string("SmoothCollisionDistance")}}),
+    };
+}
+
+// Evaluates the task map and its Jacobian on a fixed state, the scene is only updated once
+void TaskMapUpdate(benchmark::State& state, const Initializer& map)
+{
+    Initializer problem_init("exotica/UnconstrainedEndPoseProblem", {{"Name", std::string("BenchmarkProblem")},
+                                                                     {"DerivativeOrder", 1},
+                                                                     {"PlanningScene", CreateSceneInitializer(GetRobotModels()[0], "CollisionSceneFCLLatest", "{exotica_examples}/resources/scenes/g03_open_back_storage_shelf.scene")},
+                                                                     {"Maps", std::vector<Initializer>({map})},
+                                                                     {"Cost", std::vector<Initializer>({Initializer("exotica/Task", {{"Task", boost::any_cast<std::string>(map.GetProperty("Name"))}})})}});
+    PlanningProblemPtr problem = Setup::CreateProblem(problem_init);
+    std::shared_ptr<UnconstrainedEndPoseProblem> end_pose_problem = std::static_pointer_cast<UnconstrainedEndPoseProblem>(problem);
+    TaskMapPtr task_map = problem->GetTaskMaps().begin()->second;
+
+    const Eigen::VectorXd x = GetRandomStates(problem->GetScene()).col(0);
+    end_pose_problem->Update(x);
+    Eigen::VectorXd phi(task_map->length);
+    Eigen::MatrixXd jacobian(task_map->length_jacobian, problem->N);
+    for (auto _ : state)
+    {
+        task_map->Update(x, phi, jacobian);
+        benchmark::DoNotOptimize(phi.data());
+        benchmark::DoNotOptimize(jacobian.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Conversion of a generic problem initializer, with all core task maps, to the typed initializer as done on instantiation
+void InitializerConversion(benchmark::State& state)
+{
+    std::vector<Initializer> cost;
+    for (const Initializer& map : GetTaskMapInitializers()) cost.push_back(Initializer("exotica/Task", {{"Task", boost::any_cast<std::string>(map.GetProperty("Name"))}, {"Rho", std::string("1e2")}}));
+    const Initializer problem_init("exotica/UnconstrainedEndPoseProblem", {{"Name", std::string("BenchmarkProblem")},
+                                                                           {"PlanningScene", CreateSceneInitializer(GetRobotModels()[0])},
+                                                                           {"StartState", std::string("0 0 0 0 0 0 0")},
+                                                                           {"Maps", GetTaskMapInitializers()},
+                                                                           {"Cost", cost}});
+    for (auto _ : state)
+    {
+        const UnconstrainedEndPoseProblemInitializer init(problem_init);
+        init.Check(problem_init);
+        benchmark::DoNotOptimize(init.Cost.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void RegisterBenchmarks()
+{
+    const std::vector<std::pair<std::string, KinematicRequestFlags>> kinematics = {{"FK", KIN_FK}, {"J", KIN_FK | KIN_J}, {"H", KIN_FK | KIN_J | KIN_H}};
+    for (const RobotModel& robot : GetRobotModels())
+        for (const auto& flags : kinematics)
+            benchmark::RegisterBenchmark(("Kinematics/" + robot.name + "/" + flags.first).c_str(), Kinematics, robot, flags.second)->Unit(benchmark::kMicrosecond);
+
+    for (const std::string& collision_scene : std::vector<std::string>({"CollisionSceneFCLLatest", "CollisionSceneSphereTree"}))
+    {
+        for (const CollisionBenchmark& setup : GetCollisionBenchmarks())
+        {
+            benchmark::RegisterBenchmark(("IsStateValid/" + collision_scene + "/" + setup.name).c_str(), IsStateValidQuery, setup, collision_scene)->Unit(benchmark::kMicrosecond);
+            benchmark::RegisterBenchmark(("CollisionDistance/" + collision_scene + "/" + setup.name).c_str(), CollisionDistanceQuery, setup, collision_scene)->Unit(benchmark::kMicrosecond);
+        }
+    }
+
+    for (const Initializer& map : GetTaskMapInitializers())
+        benchmark::RegisterBenchmark(("TaskMap/" + boost::any_cast<std::string>(map.GetProperty("Name"))).c_str(), TaskMapUpdate, map)->Unit(benchmark::kMicrosecond);
+
+    benchmark::RegisterBenchmark("InitializerConversion/UnconstrainedEndPoseProblem", InitializerConversion)->Unit(benchmark::kMicrosecond);
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    RegisterBenchmarks();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    Setup::Destroy();
+    return 0;
+}
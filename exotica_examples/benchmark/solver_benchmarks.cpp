@@ -0,0 +1,371 @@
+//
+// Copyright (c) 2021, University of Edinburgh, University of Oxford
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice,
+//    this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of  nor the names of its contributors may be used to
+//    endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include <exotica_core/exotica_core.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace exotica;
+
+// Runs the solvers of a catalogue of XML configurations repeatedly with fixed seeds and reports time-to-solution, iterations,
+// final cost, heap allocations and success as JSON and CSV, e.g.:
+//   exotica_solver_benchmarks --repetitions 20 --json solvers.json --csv solvers.csv
+
+// Counts the heap allocations of all threads while solving. The benchmark interposes malloc, calloc and realloc of glibc itself:
+// unlike the per-thread counters of test_problems, the count includes the worker threads of the solvers.
+static std::atomic<bool> count_heap_allocations{false};
+static std::atomic<long> num_heap_allocations{0};
+#ifdef __GLIBC__
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t num, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+extern "C" void* malloc(size_t size)
+{
+    if (count_heap_allocations.load(std::memory_order_relaxed)) num_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+extern "C" void* calloc(size_t num, size_t size)
+{
+    if (count_heap_allocations.load(std::memory_order_relaxed)) num_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(num, size);
+}
+extern "C" void* realloc(void* ptr, size_t size)
+{
+    if (count_heap_allocations.load(std::memory_order_relaxed)) num_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+namespace
+{
+struct Options
+{
+    std::string catalogue = "{exotica_examples}/resources/benchmarks/solver_catalogue.txt";
+    std::string filter;
+    std::string json;
+    std::string csv;
+    int repetitions = 10;
+    int seed = 0;
+};
+
+struct Run
+{
+    std::string config;
+    std::string solver;
+    std::string problem;
+    int repetition = 0;
+    int seed = 0;
+    double time = std::numeric_limits<double>::quiet_NaN();  ///< Wall time of Solve (s)
+    int iterations = 0;
+    double cost = std::numeric_limits<double>::quiet_NaN();  ///< Last recorded cost, NaN if the problem does not record costs
+    long allocations = -1;                                    ///< Heap allocations during Solve, -1 if not counted
+    std::string termination;
+    bool success = false;
+    std::string error;
+};
+
+void PrintUsage()
+{
+    HIGHLIGHT("Usage: exotica_solver_benchmarks [--catalogue FILE] [--filter SUBSTRING] [--repetitions N] [--seed SEED] [--json FILE] [--csv FILE]");
+}
+
+Options ParseArguments(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        if (argument == "--help" || argument == "-h")
+        {
+            PrintUsage();
+            std::exit(0);
+        }
+        if (i + 1 == argc) ThrowPretty("Missing value of argument '" << argument << "'");
+        const std::string value = argv[++i];
+        if (argument == "--catalogue")
+            options.catalogue = value;
+        else if (argument == "--filter")
+            options.filter = value;
+        else if (argument == "--json")
+            options.json = value;
+        else if (argument == "--csv")
+            options.csv = value;
+        else if (argument == "--repetitions")
+            options.repetitions = std::stoi(value);
+        else if (argument == "--seed")
+            options.seed = std::stoi(value);
+        else
+            ThrowPretty("Unknown argument '" << argument << "'");
+    }
+    if (options.repetitions < 1) ThrowPretty("The number of repetitions has to be positive, given: " << options.repetitions);
+    return options;
+}
+
+std::vector<std::string> LoadCatalogue(const std::string& file_name)
+{
+    std::vector<std::string> configs;
+    std::istringstream catalogue(LoadFile(file_name));
+    std::string line;
+    while (std::getline(catalogue, line))
+    {
+        line = line.substr(0, line.find('#'));
+        const std::size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos) continue;
+        configs.push_back(line.substr(begin, line.find_last_not_of(" \t\r") - begin + 1));
+    }
+    return configs;
+}
+
+// Sets the random seed of solvers that expose one (the OMPL-based solvers)
+void SetSeed(Initializer& solver, int seed)
+{
+    for (const Initializer& initializer : Setup::GetInitializers())
+    {
+        if (initializer.GetName() != solver.GetName()) continue;
+        for (const char* name : {"RandomSeed", "Seed"})
+            if (initializer.HasProperty(name)) solver.AddProperty(Property(name, false, seed));
+    }
+}
+
+std::string ToString(TerminationCriterion criterion)
+{
+    switch (criterion)
+    {
+        case TerminationCriterion::NotStarted:
+            return "NotStarted";
+        case TerminationCriterion::IterationLimit:
+            return "IterationLimit";
+        case TerminationCriterion::BacktrackIterationLimit:
+            return "BacktrackIterationLimit";
+        case TerminationCriterion::StepTolerance:
+            return "StepTolerance";
+        case TerminationCriterion::FunctionTolerance:
+            return "FunctionTolerance";
+        case TerminationCriterion::GradientTolerance:
+            return "GradientTolerance";
+        case TerminationCriterion::Divergence:
+            return "Divergence";
+        case TerminationCriterion::UserDefined:
+            return "UserDefined";
+        case TerminationCriterion::Convergence:
+            return "Convergence";
+    }
+    return "Unknown";
+}
+
+// Optimisers succeed if they converged. Sampling-based solvers do not set a termination criterion and succeed if they return a path,
+// since they throw otherwise.
+bool IsSuccess(TerminationCriterion criterion, const Eigen::MatrixXd& solution)
+{
+    switch (criterion)
+    {
+        case TerminationCriterion::StepTolerance:
+        case TerminationCriterion::FunctionTolerance:
+        case TerminationCriterion::GradientTolerance:
+        case TerminationCriterion::Convergence:
+            return true;
+        case TerminationCriterion::NotStarted:
+            return solution.size() > 0 && solution.allFinite();
+        default:
+            return false;
+    }
+}
+
+Run RunSolver(const std::string& config, int repetition, int seed)
+{
+    Run run;
+    run.config = config;
+    run.repetition = repetition;
+    run.seed = seed;
+    try
+    {
+        Initializer solver_init, problem_init;
+        XMLLoader::Load(config, solver_init, problem_init);
+        SetSeed(solver_init, seed);
+        std::srand(static_cast<unsigned int>(seed));
+
+        PlanningProblemPtr problem = Setup::CreateProblem(problem_init);
+        MotionSolverPtr solver = Setup::CreateSolver(solver_init);
+        solver->SpecifyProblem(problem);
+        run.solver = solver->type();
+        run.problem = problem->type();
+
+        Eigen::MatrixXd solution;
+        num_heap_allocations = 0;
+        count_heap_allocations = true;
+        Timer timer;
+        solver->Solve(solution);
+        run.time = timer.GetDuration();
+        count_heap_allocations = false;
+#ifdef __GLIBC__
+        run.allocations = num_heap_allocations;
+#endif
+
+        const std::vector<double> costs = problem->GetCostEvolution().second;
+        run.iterations = static_cast<int>(costs.size());
+        if (!costs.empty()) run.cost = costs.back();
+        run.termination = ToString(problem->termination_criterion);
+        run.success = IsSuccess(problem->termination_criterion, solution);
+    }
+    catch (const std::exception& e)
+    {
+        count_heap_allocations = false;
+        run.error = e.what();
+    }
+    return run;
+}
+
+double Median(std::vector<double> values)
+{
+    if (values.empty()) return std::numeric_limits<double>::quiet_NaN();
+    std::sort(values.begin(), values.end());
+    const std::size_t n = values.size();
+    return n % 2 == 1 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+std::string EscapeJson(const std::string& str)
+{
+    std::string escaped;
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (c == '\n')
+        {
+            escaped += "\\n";
+        }
+        else if (static_cast<unsigned char>(c) >= 0x20)
+        {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// JSON has no NaN
+std::string JsonNumber(double value)
+{
+    if (!std::isfinite(value)) return "null";
+    std::ostringstream number;
+    number << std::setprecision(17) << value;
+    return number.str();
+}
+
+void WriteJson(const std::string& file_name, const Options& options, const std::vector<Run>& runs)
+{
+    std::ofstream json(file_name);
+    if (!json.is_open()) ThrowPretty("Can't open file '" << file_name << "' for writing.");
+    json << "{\n  \"context\": {\"version\": \"" << EscapeJson(exotica::version) << "\", \"catalogue\": \"" << EscapeJson(options.catalogue)
+         << "\", \"repetitions\": " << options.repetitions << ", \"seed\": " << options.seed << "},\n  \"runs\": [";
+    for (std::size_t i = 0; i < runs.size(); ++i)
+    {
+        const Run& run = runs[i];
+        json << (i == 0 ? "\n" : ",\n") << "    {\"config\": \"" << EscapeJson(run.config) << "\", \"solver\": \"" << EscapeJson(run.solver)
+             << "\", \"problem\": \"" << EscapeJson(run.problem) << "\", \"repetition\": " << run.repetition << ", \"seed\": " << run.seed
+             << ", \"time\": " << JsonNumber(run.time) << ", \"iterations\": " << run.iterations << ", \"cost\": " << JsonNumber(run.cost)
+             << ", \"allocations\": " << run.allocations << ", \"termination\": \"" << run.termination << "\", \"success\": " << (run.success ? "true" : "false")
+             << ", \"error\": \"" << EscapeJson(run.error) << "\"}";
+    }
+    json << "\n  ]\n}\n";
+}
+
+void WriteCsv(const std::string& file_name, const std::vector<Run>& runs)
+{
+    std::ofstream csv(file_name);
+    if (!csv.is_open()) ThrowPretty("Can't open file '" << file_name << "' for writing.");
+    csv << "config,solver,problem,repetition,seed,time,iterations,cost,allocations,termination,success\n";
+    csv << std::setprecision(17);
+    for (const Run& run : runs)
+    {
+        csv << run.config << ',' << run.solver << ',' << run.problem << ',' << run.repetition << ',' << run.seed << ',' << run.time << ','
+            << run.iterations << ',' << run.cost << ',' << run.allocations << ',' << run.termination << ',' << run.success << '\n';
+    }
+}
+
+void PrintSummary(const std::string& config, const std::vector<Run>& runs)
+{
+    std::vector<double> times, costs;
+    int num_successes = 0;
+    double iterations = 0.0, allocations = 0.0;
+    for (const Run& run : runs)
+    {
+        if (!run.error.empty()) continue;
+        times.push_back(run.time);
+        if (std::isfinite(run.cost)) costs.push_back(run.cost);
+        iterations += run.iterations;
+        allocations += static_cast<double>(run.allocations);
+        num_successes += run.success;
+    }
+    const double num_completed = std::max<double>(1.0, static_cast<double>(times.size()));
+    HIGHLIGHT_NAMED(config, "success " << num_successes << "/" << runs.size() << ", median time " << Median(times) << " s, mean iterations "
+                                       << iterations / num_completed << ", median cost " << Median(costs) << ", mean allocations " << allocations / num_completed);
+    for (const Run& run : runs)
+        if (!run.error.empty()) WARNING_NAMED(config, "Repetition " << run.repetition << " failed: " << run.error);
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        const Options options = ParseArguments(argc, argv);
+        std::vector<Run> runs;
+        for (const std::string& config : LoadCatalogue(options.catalogue))
+        {
+            if (!options.filter.empty() && config.find(options.filter) == std::string::npos) continue;
+            std::vector<Run> config_runs;
+            for (int i = 0; i < options.repetitions; ++i) config_runs.push_back(RunSolver(config, i, options.seed + i));
+            PrintSummary(config, config_runs);
+            runs.insert(runs.end(), config_runs.begin(), config_runs.end());
+        }
+        if (!options.json.empty()) WriteJson(options.json, options, runs);
+        if (!options.csv.empty()) WriteCsv(options.csv, runs);
+    }
+    catch (const std::exception& e)
+    {
+        ERROR(e.what());
+        PrintUsage();
+        Setup::Destroy();
+        return 1;
+    }
+    Setup::Destroy();
+    return 0;
+}
@@ -0,0 +1,70 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/example_aico.xml'
+
+
+class AICOSolverCase(unittest.TestCase):
+
+    def setup(self, problem_options={}, **options):
+        solver_init, problem_init = exo.Initializers.load_xml_full(CONFIG)
+        problem = exo.Setup.create_problem((problem_init[0], dict(problem_init[1], **problem_options)))
+        solver = exo.Setup.create_solver((solver_init[0], dict(solver_init[1], MaxIterations=50, **options)))
+        solver.specify_problem(problem)
+        problem.start_state = np.zeros(problem.N)
+        return problem, solver
+
+    def test_mpc_shift_warm_start(self):
+        problem, solver = self.setup(MPCShift=1)
+        solution = solver.solve()
+        cold_start_cost = problem.get_cost_evolution()[1][0]
+
+        # Move one time step along the previous solution and re-solve
+        problem.start_state = solution[1]
+        shifted = solver.solve()
+        self.assertEqual(shifted.shape, (problem.T, problem.N))
+        np.testing.assert_allclose(shifted[0], solution[1])
+        costs = problem.get_cost_evolution()[1]
+        self.assertTrue(np.isfinite(costs[-1]))
+        # The shifted messages are a much better start than the constant start state
+        self.assertLess(costs[0], cold_start_cost)
+        self.assertLessEqual(costs[-1], costs[0])
+
+    def test_mpc_shift_with_backward_message(self):
+        # The backward message cannot be set from Python, the solver falls back to the default terminal message
+        problem, solver = self.setup(MPCShift=5, UseBackwardMessage=True)
+        solution = solver.solve()
+        problem.start_state = solution[5]
+        shifted = solver.solve()
+        self.assertTrue(np.all(np.isfinite(shifted)))
+
+    def test_parallel_sweep(self):
+        problem, solver = self.setup(SweepMode='Symmetric')
+        solver.solve()
+        symmetric_cost = problem.get_cost_evolution()[1][-1]
+
+        problem, solver = self.setup(SweepMode='Parallel')
+        solution = solver.solve()
+        self.assertEqual(solution.shape, (problem.T, problem.N))
+        costs = problem.get_cost_evolution()[1]
+        self.assertTrue(np.isfinite(costs[-1]))
+        self.assertLess(costs[-1], costs[0])
+        # The Jacobi-style sweep converges more slowly per sweep but to a comparable solution
+        self.assertLess(costs[-1], 2.0 * symmetric_cost + 1e-3)
+
+    def test_parallel_sweep_is_independent_of_the_number_of_threads(self):
+        solutions = []
+        for num_threads in [1, 2]:
+            problem, solver = self.setup(problem_options={'TrajectoryNumThreads': num_threads}, SweepMode='Parallel')
+            solutions.append(solver.solve())
+        np.testing.assert_allclose(solutions[0], solutions[1], rtol=1e-9, atol=1e-9)
+
+    def test_invalid_mpc_shift(self):
+        with self.assertRaises(Exception):
+            self.setup(MPCShift=-1)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,59 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+import exotica_ddp_solver_py  # noqa: F401, registers the BatchDDPSolver bindings
+
+CONFIG = '{exotica_examples}/resources/configs/dynamic_time_indexed/18_ilqr_pendulum.xml'
+SOLVER_OPTIONS = {'MaxIterations': 100, 'RegularizationRate': 1e-4, 'FunctionTolerance': 1e-3, 'FunctionTolerancePatience': 10, 'Debug': False}
+START_GOAL_STATES = [([0.0, 0.0], [3.14, 0.0]),
+                     ([0.5, 0.0], [3.14, 0.0]),
+                     ([-0.3, 1.0], [2.0, 0.0]),
+                     ([0.0, -2.0], [-1.5, 0.0])]
+
+
+class BatchDDPSolverCase(unittest.TestCase):
+
+    def create_problem(self, start_state, goal_state):
+        _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+        problem_init = (problem_init[0], dict(problem_init[1], StartState=np.array(start_state), GoalState=np.array(goal_state)))
+        return exo.Setup.create_problem(problem_init)
+
+    def solve_analytic(self, start_state, goal_state):
+        problem = self.create_problem(start_state, goal_state)
+        solver = exo.Setup.create_solver(('exotica/AnalyticDDPSolver', dict(SOLVER_OPTIONS, Name='AnalyticDDPSolver')))
+        solver.specify_problem(problem)
+        solution = solver.solve()
+        return problem, solution
+
+    def test_matches_analytic_ddp_solver(self):
+        # The batch solver runs the iterations of the AnalyticDDPSolver in lockstep, each problem has to converge to the same solution
+        problems = [self.create_problem(start, goal) for start, goal in START_GOAL_STATES]
+        solver = exo.Setup.create_solver(('exotica/BatchDDPSolver', dict(SOLVER_OPTIONS, Name='BatchDDPSolver')))
+        solver.specify_problems(problems)
+        solutions = solver.solve_batch()
+        self.assertEqual(len(solutions), len(problems))
+        self.assertEqual(len(solver.number_of_iterations), len(problems))
+
+        for problem, solution, (start, goal) in zip(problems, solutions, START_GOAL_STATES):
+            reference_problem, reference_solution = self.solve_analytic(start, goal)
+            self.assertEqual(solution.shape, reference_solution.shape)
+            self.assertEqual(problem.termination_criterion, reference_problem.termination_criterion)
+            reference_cost = reference_problem.get_cost_evolution()[1][-1]
+            self.assertAlmostEqual(problem.get_cost_evolution()[1][-1] / reference_cost, 1.0, places=3)
+            np.testing.assert_allclose(problem.X[:, -1], reference_problem.X[:, -1], atol=1e-2)
+            np.testing.assert_allclose(solution, reference_solution, atol=1e-2 * np.max(np.abs(reference_solution)))
+
+    def test_single_problem(self):
+        # Solve on a single problem is a batch of one
+        start, goal = START_GOAL_STATES[0]
+        problem = self.create_problem(start, goal)
+        solver = exo.Setup.create_solver(('exotica/BatchDDPSolver', dict(SOLVER_OPTIONS, Name='BatchDDPSolver')))
+        solver.specify_problem(problem)
+        solution = solver.solve()
+        _, reference_solution = self.solve_analytic(start, goal)
+        np.testing.assert_allclose(solution, reference_solution, atol=1e-2 * np.max(np.abs(reference_solution)))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,57 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/example_bayesian_ik.xml'
+
+
+def setup(**options):
+    solver_init, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    problem = exo.Setup.create_problem(problem_init)
+    solver = exo.Setup.create_solver((solver_init[0], dict(solver_init[1], MaxIterations=100, **options)))
+    solver.specify_problem(problem)
+    return problem, solver
+
+
+class BayesianIKSolverCase(unittest.TestCase):
+
+    def test_exact_reuse_matches_no_reuse(self):
+        # A tolerance of 0 only skips the duplicate update at the roll-out point and must not change the result
+        solutions = []
+        for tolerance in [-1.0, 0.0]:
+            problem, solver = setup(LinearizationTolerance=tolerance)
+            solutions.append(solver.solve()[0])
+            self.assertLessEqual(problem.get_cost_evolution()[1][-1], problem.get_cost_evolution()[1][0])
+        np.testing.assert_allclose(solutions[0], solutions[1], rtol=1e-12, atol=1e-12)
+
+    def test_approximate_reuse_converges(self):
+        problem, solver = setup(LinearizationTolerance=-1.0)
+        solver.solve()
+        exact_cost = problem.get_cost_evolution()[1][-1]
+
+        problem, solver = setup(LinearizationTolerance=1e-3)
+        solution = solver.solve()[0]
+        self.assertTrue(np.all(np.isfinite(solution)))
+        costs = problem.get_cost_evolution()[1]
+        self.assertLess(costs[-1], costs[0])
+        self.assertLess(costs[-1], exact_cost + 1e-3)
+
+    def test_cache_is_invalidated_between_solves(self):
+        goal = np.array([0.4, 0.2, 0.6, 0.0, 0.0, 0.0])
+
+        # Re-solving after the goal changed must not pick up the linearisation of the previous goal
+        problem, solver = setup()
+        solver.solve()
+        problem.start_state = np.zeros(problem.N)
+        problem.set_goal('Position', goal)
+        reused = solver.solve()[0]
+
+        problem, solver = setup()
+        problem.set_goal('Position', goal)
+        fresh = solver.solve()[0]
+        np.testing.assert_allclose(reused, fresh, rtol=1e-12, atol=1e-12)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,46 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/dynamic_time_indexed/18_ilqr_pendulum.xml'
+SOLVERS = ['exotica/AnalyticDDPSolver', 'exotica/ControlLimitedDDPSolver']
+FDDP_SOLVERS = ['exotica/FeasibilityDrivenDDPSolver', 'exotica/ControlLimitedFeasibilityDrivenDDPSolver']
+SOLVER_OPTIONS = {'MaxIterations': 50, 'Debug': False}
+
+
+def solve(solver_type, rollout_num_threads, **options):
+    _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    problem = exo.Setup.create_problem((problem_init[0], dict(problem_init[1], RolloutNumThreads=rollout_num_threads)))
+    solver = exo.Setup.create_solver((solver_type, dict(SOLVER_OPTIONS, Name='MySolver', **options)))
+    solver.specify_problem(problem)
+    solution = solver.solve()
+    return problem, solution
+
+
+class DDPParallelLineSearchCase(unittest.TestCase):
+
+    def test_matches_serial_line_search(self):
+        # The parallel rollouts only find the first accepted step, which is replayed by the serial line search
+        for solver_type in SOLVERS:
+            reference_problem, reference_solution = solve(solver_type, 1)
+            for num_threads in [2, 3, 4]:
+                problem, solution = solve(solver_type, num_threads, ParallelLineSearch=True)
+                np.testing.assert_allclose(solution, reference_solution, atol=1e-6, err_msg=solver_type)
+                np.testing.assert_allclose(problem.get_cost_evolution()[1][-1], reference_problem.get_cost_evolution()[1][-1], rtol=1e-6)
+
+    def test_clamped_controls(self):
+        for solver_type in SOLVERS:
+            _, reference_solution = solve(solver_type, 1, ClampControlsInForwardPass=True)
+            _, solution = solve(solver_type, 3, ClampControlsInForwardPass=True, ParallelLineSearch=True)
+            np.testing.assert_allclose(solution, reference_solution, atol=1e-6, err_msg=solver_type)
+
+    def test_rejected_by_feasibility_driven_solvers(self):
+        # The feasibility-driven solvers have their own line search, see ParallelForwardPass
+        for solver_type in FDDP_SOLVERS:
+            with self.assertRaises(Exception):
+                exo.Setup.create_solver((solver_type, dict(SOLVER_OPTIONS, Name='MySolver', ParallelLineSearch=True)))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,30 @@
+import unittest
+
+import pyexotica as exo
+import exotica_ddp_solver_py as ddp
+
+CONFIG = '{exotica_examples}/resources/configs/dynamic_time_indexed/18_ilqr_pendulum.xml'
+SOLVERS = ['exotica/AnalyticDDPSolver', 'exotica/ControlLimitedDDPSolver', 'exotica/FeasibilityDrivenDDPSolver', 'exotica/ControlLimitedFeasibilityDrivenDDPSolver']
+
+
+class DDPPhaseDurationsCase(unittest.TestCase):
+
+    def test_phases_are_timed(self):
+        phases = ddp.AbstractDDPSolver.phase_names
+        for solver_type in SOLVERS:
+            _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+            problem = exo.Setup.create_problem(problem_init)
+            solver = exo.Setup.create_solver((solver_type, {'Name': 'MySolver', 'MaxIterations': 5, 'Debug': False}))
+            solver.specify_problem(problem)
+            solver.solve()
+
+            durations = solver.phase_duration_evolution
+            self.assertEqual(durations.shape[1], len(phases))
+            # The first iteration always evaluates the problem along its iterate and differentiates it
+            first = dict(zip(phases, durations[0]))
+            for phase in ['dynamics_derivatives', 'cost_derivatives', 'backward_pass', 'line_search', 'problem_update']:
+                self.assertGreater(first[phase], 0.0, solver_type + ': ' + phase)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,31 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+import exotica_ddp_solver_py  # noqa: F401, registers the DDP solver bindings
+
+CONFIG = '{exotica_examples}/resources/configs/dynamic_time_indexed/18_ilqr_pendulum.xml'
+
+
+class DDPQuuInvCase(unittest.TestCase):
+
+    def check_inverse(self, solver_type):
+        _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+        problem = exo.Setup.create_problem(problem_init)
+        solver = exo.Setup.create_solver((solver_type, {'Name': 'MySolver', 'MaxIterations': 3, 'Debug': False}))
+        solver.specify_problem(problem)
+        solver.solve()
+
+        # Quu_inv is the inverse of the regularised Quu the gains were computed from
+        for Quu, Quu_inv in zip(solver.Quu, solver.Quu_inv):
+            np.testing.assert_allclose(Quu_inv.dot(Quu), np.eye(Quu.shape[0]), atol=1e-6, err_msg=solver_type)
+
+    def test_analytic_ddp(self):
+        self.check_inverse('exotica/AnalyticDDPSolver')
+
+    def test_feasibility_driven_ddp(self):
+        self.check_inverse('exotica/FeasibilityDrivenDDPSolver')
+
+
+if __name__ == '__main__':
+    unittest.main()
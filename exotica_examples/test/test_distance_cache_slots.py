@@ -0,0 +1,78 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+XML = '''<PlannerDemoConfig>
+  <AICOSolver Name="MySolver"/>
+  <UnconstrainedTimeIndexedProblem Name="MyProblem">
+    <PlanningScene>
+      <Scene>
+        <JointGroup>arm</JointGroup>
+        <URDF>{exotica_examples}/resources/robots/lwr_simplified.urdf</URDF>
+        <SRDF>{exotica_examples}/resources/robots/lwr_simplified.srdf</SRDF>
+        <CollisionScene>
+          <CollisionSceneFCLLatest Name="MyCollisionScene" UseDistanceCache="%d" CollectStatistics="1"/>
+        </CollisionScene>
+        <AlwaysUpdateCollisionScene>1</AlwaysUpdateCollisionScene>
+      </Scene>
+    </PlanningScene>
+    <Maps>
+      <SmoothCollisionDistance Name="Collision" WorldMargin="0.2" CheckSelfCollision="0" Linear="1"/>
+    </Maps>
+    <Cost>
+      <Task Task="Collision" Rho="10"/>
+    </Cost>
+    <T>20</T>
+    <tau>0.05</tau>
+    <W>7 6 5 4 3 2 1</W>
+  </UnconstrainedTimeIndexedProblem>
+</PlannerDemoConfig>'''
+
+
+def create_problem(use_distance_cache):
+    _, problem_init = exo.Initializers.load_xml_full(XML % int(use_distance_cache), parseAsXMLString=True)
+    problem = exo.Setup.create_problem(problem_init)
+    problem.get_scene().add_object('Box', exo.KDLFrame([0.5, 0., 0.6]), '', exo.Box(0.2, 0.2, 0.2), update_collision_scene=True)
+    return problem
+
+
+def make_trajectory(problem, offset=0.):
+    # Sweeps the arm past the box, so some time steps are within the margin and others are not
+    return np.concatenate([np.linspace(-1., 1., problem.N) * t / problem.T + offset for t in range(1, problem.T)])
+
+
+class DistanceCacheSlotsCase(unittest.TestCase):
+
+    def test_slot_is_restored(self):
+        problem = create_problem(True)
+        collision_scene = problem.get_scene().get_collision_scene()
+        problem.update(make_trajectory(problem))
+        self.assertEqual(collision_scene.distance_cache_slot, 0)
+        problem.update(np.zeros(problem.N), 5)
+        self.assertEqual(collision_scene.distance_cache_slot, 0)
+        with self.assertRaises(Exception):
+            collision_scene.distance_cache_slot = -1
+
+    def test_time_steps_use_their_own_cache(self):
+        problem = create_problem(True)
+        collision_scene = problem.get_scene().get_collision_scene()
+        problem.update(make_trajectory(problem))
+        first = collision_scene.get_collision_statistics().num_distance_computations
+
+        # Each time step is bounded from its own previous state, so the pairs far from the box are skipped
+        collision_scene.reset_collision_statistics()
+        problem.update(make_trajectory(problem, 1e-4))
+        second = collision_scene.get_collision_statistics().num_distance_computations
+        self.assertLess(second, first)
+
+        # The skipped pairs do not change the cost or its Jacobian
+        reference = create_problem(False)
+        reference.update(make_trajectory(reference, 1e-4))
+        for t in range(1, problem.T):
+            self.assertAlmostEqual(problem.get_scalar_task_cost(t), reference.get_scalar_task_cost(t))
+            np.testing.assert_allclose(problem.get_scalar_task_jacobian(t), reference.get_scalar_task_jacobian(t), atol=1e-9)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -166,6 +166,186 @@ def check_control_cost_hessian_at_t(problem, t):
     np.testing.assert_allclose(H_solver, H_numdiff, rtol=1e-5,
                                atol=1e-5, err_msg='ControlCostHessian does not match!')
 
+def check_control_cost_loss_types(problem):
+    ds = problem.get_scene().get_dynamics_solver()
+    loss_type = problem.loss_type
+    x = random_state(ds)
+    u = np.random.random((ds.nu,)) - 0.5
+    for loss in [exo.ControlCostLossTermType.L2, exo.ControlCostLossTermType.SmoothL1,
+                 exo.ControlCostLossTermType.Huber, exo.ControlCostLossTermType.PseudoHuber]:
+        problem.loss_type = loss
+        problem.update(x, u, 0)
+        check_control_cost_jacobian_at_t(problem, 0)
+        check_control_cost_hessian_at_t(problem, 0)
+
+        # The fused evaluation of the derivatives matches the separate one
+        problem.update(x, u, 0)
+        jacobian, hessian = problem.get_control_cost_derivatives(0)
+        np.testing.assert_allclose(jacobian, problem.get_control_cost_jacobian(0), rtol=1e-12,
+                                   atol=1e-12, err_msg='Fused ControlCostJacobian does not match!')
+        np.testing.assert_allclose(hessian, problem.get_control_cost_hessian(0), rtol=1e-12,
+                                   atol=1e-12, err_msg='Fused ControlCostHessian does not match!')
+    problem.loss_type = loss_type
+
+def check_rollouts(problem, num_rollouts=4, num_threads=2):
+    scene = problem.get_scene()
+    ds = scene.get_dynamics_solver()
+    problem.disable_stochastic_updates()
+
+    x0 = random_state(ds)
+    U_rollouts = [np.random.random((ds.nu, problem.T - 1)) for _ in range(num_rollouts)]
+    problem.rollout_num_threads = num_threads
+    costs, X_rollouts = problem.rollout(x0, U_rollouts)
+    np.testing.assert_equal(len(X_rollouts), num_rollouts)
+
+    # Sequential rollouts on the problem itself
+    for k in range(num_rollouts):
+        cost = 0.0
+        for t in range(problem.T - 1):
+            if t == 0:
+                problem.update(x0, U_rollouts[k][:, t], t)
+            else:
+                problem.update(U_rollouts[k][:, t], t)
+            cost += ds.dt * (problem.get_control_cost(t) + problem.get_state_cost(t))
+        cost += problem.get_state_cost(problem.T - 1)
+        np.testing.assert_allclose(X_rollouts[k], problem.X, rtol=1e-6,
+                                   atol=1e-6, err_msg='Rollout states do not match!')
+        np.testing.assert_allclose(costs[k], cost, rtol=1e-6,
+                                   atol=1e-6, err_msg='Rollout cost does not match!')
+
+def check_linearize_trajectory(problem):
+    ds = problem.get_scene().get_dynamics_solver()
+    problem.disable_stochastic_updates()
+
+    x0 = random_state(ds)
+    U = np.random.random((ds.nu, problem.T - 1))
+    for t in range(problem.T - 1):
+        if t == 0:
+            problem.update(x0, U[:, t], t)
+        else:
+            problem.update(U[:, t], t)
+
+    linearization = problem.linearize_trajectory(problem.X, problem.U)
+    Fx, Fu = ds.compute_derivatives_batch(problem.X, problem.U)
+    for t in range(problem.T - 1):
+        np.testing.assert_allclose(linearization.fx[t], Fx[t], rtol=1e-9,
+                                   atol=1e-9, err_msg='Linearised fx does not match!')
+        np.testing.assert_allclose(linearization.fu[t], Fu[t], rtol=1e-9,
+                                   atol=1e-9, err_msg='Linearised fu does not match!')
+        jacobian, hessian = problem.get_control_cost_derivatives(t)
+        np.testing.assert_allclose(linearization.lu[t], jacobian, rtol=1e-9,
+                                   atol=1e-9, err_msg='Linearised lu does not match!')
+        np.testing.assert_allclose(linearization.luu[t], hessian, rtol=1e-9,
+                                   atol=1e-9, err_msg='Linearised luu does not match!')
+    for t in range(problem.T):
+        np.testing.assert_allclose(linearization.lx[t], problem.get_state_cost_jacobian(t), rtol=1e-9,
+                                   atol=1e-9, err_msg='Linearised lx does not match!')
+        np.testing.assert_allclose(linearization.lxx[t], problem.get_state_cost_hessian(t), rtol=1e-9,
+                                   atol=1e-9, err_msg='Linearised lxx does not match!')
+
+def check_contracted_task_hessians(problem, problem_init):
+    # The same problem with the task-map Hessians accumulated into the state cost Hessian
+    contracted_init = (problem_init[0], dict(problem_init[1], ContractTaskHessians=True))
+    contracted_problem = exo.Setup.create_problem(contracted_init)
+    problem.disable_stochastic_updates()
+    contracted_problem.disable_stochastic_updates()
+    ds = problem.get_scene().get_dynamics_solver()
+
+    for t in range(problem.T - 1):
+        x = random_state(ds)
+        u = np.random.random((ds.nu,))
+        problem.update(x, u, t)
+        contracted_problem.update(x, u, t)
+        np.testing.assert_allclose(contracted_problem.get_state_cost_hessian(t), problem.get_state_cost_hessian(t), rtol=1e-9,
+                                   atol=1e-9, err_msg='StateCostHessian with contracted task-map Hessians does not match!')
+
+def check_hessian_vector_products(problem):
+    # The matrix-free products against the products with the state and control cost Hessians
+    ds = problem.get_scene().get_dynamics_solver()
+    problem.disable_stochastic_updates()
+
+    for t in range(problem.T):
+        x = random_state(ds)
+        u = np.random.random((ds.nu,))
+        if t == problem.T - 1:
+            problem.update_terminal_state(x)
+        else:
+            problem.update(x, u, t)
+        v = np.random.randn(ds.ndx)
+        np.testing.assert_allclose(problem.get_state_cost_hessian_vector_product(t, v), problem.get_state_cost_hessian(t).dot(v), rtol=1e-9,
+                                   atol=1e-9, err_msg='StateCostHessianVectorProduct does not match!')
+        if t < problem.T - 1:
+            v = np.random.randn(ds.nu)
+            np.testing.assert_allclose(problem.get_control_cost_hessian_vector_product(t, v), problem.get_control_cost_hessian(t).dot(v), rtol=1e-9,
+                                       atol=1e-9, err_msg='ControlCostHessianVectorProduct does not match!')
+
+def check_shift_trajectory(problem, k=2):
+    ds = problem.get_scene().get_dynamics_solver()
+    problem.disable_stochastic_updates()
+
+    x0 = random_state(ds)
+    U = np.random.random((ds.nu, problem.T - 1))
+    for t in range(problem.T - 1):
+        if t == 0:
+            problem.update(x0, U[:, t], t)
+        else:
+            problem.update(U[:, t], t)
+    X = problem.X.copy()
+
+    problem.shift_trajectory(k)
+    np.testing.assert_allclose(problem.X[:, :problem.T - k], X[:, k:], rtol=1e-9,
+                               atol=1e-9, err_msg='Shifted states do not match!')
+    np.testing.assert_allclose(problem.U[:, :problem.T - 1 - k], U[:, k:], rtol=1e-9,
+                               atol=1e-9, err_msg='Shifted controls do not match!')
+    X_shifted = problem.X.copy()
+    U_shifted = problem.U.copy()
+    state_costs = [problem.get_state_cost(t) for t in range(problem.T)]
+
+    # Evaluating the shifted controls from the shifted start state
+    for t in range(problem.T - 1):
+        if t == 0:
+            problem.update(X_shifted[:, 0], U_shifted[:, t], t)
+        else:
+            problem.update(U_shifted[:, t], t)
+    np.testing.assert_allclose(problem.X, X_shifted, rtol=1e-6,
+                               atol=1e-6, err_msg='Extrapolated states do not match!')
+    for t in range(problem.T):
+        np.testing.assert_allclose(problem.get_state_cost(t), state_costs[t], rtol=1e-6,
+                                   atol=1e-6, err_msg='State cost of the shifted trajectory does not match!')
+
+def check_trajectory_views(problem):
+    U = np.random.random(problem.U.shape)
+    U_view = problem.U_view
+    U_view[:] = U
+    np.testing.assert_equal(problem.U, U, err_msg='Writes to U_view do not alias U!')
+    X_view = problem.X_view
+    X_view[:, 0] = problem.start_state
+    np.testing.assert_equal(problem.X[:, 0], problem.start_state, err_msg='Writes to X_view do not alias X!')
+
+def check_set_resolution(problem):
+    ds = problem.get_scene().get_dynamics_solver()
+    T, tau, dt = problem.T, problem.tau, ds.dt
+    X_star = np.random.random(problem.X_star.shape)
+    problem.X_star = X_star
+
+    T_coarse = (T - 1) // 2 + 1
+    problem.set_resolution(T_coarse)
+    np.testing.assert_equal(problem.T, T_coarse)
+    np.testing.assert_allclose(problem.tau * (T_coarse - 1), tau * (T - 1), rtol=1e-12, err_msg='Span of the coarse trajectory changed!')
+    np.testing.assert_allclose(ds.dt / problem.tau, dt / tau, rtol=1e-12, err_msg='dt of the dynamics solver was not scaled with tau!')
+    np.testing.assert_equal(problem.U.shape[1], T_coarse - 1)
+    # The goal of each time step is the one of the nearest original time step
+    for t in range(T_coarse):
+        s = int(np.floor(t * (T - 1) / (T_coarse - 1) + 0.5))
+        np.testing.assert_equal(problem.X_star[:, t], X_star[:, s], err_msg='Goal states were not resampled!')
+
+    # Returning to the original resolution restores the time step and the goals exactly
+    problem.set_resolution(T)
+    np.testing.assert_equal(problem.T, T)
+    np.testing.assert_equal(problem.tau, tau)
+    np.testing.assert_equal(ds.dt, dt)
+    np.testing.assert_equal(problem.X_star, X_star)
+
 ###############################################################################
 
 if __name__ == "__main__":
@@ -224,3 +404,27 @@ if __name__ == "__main__":
 
         # TODO: test state control cost hessian
         # We assume this to be 0.
+
+        # test the control costs of all loss types
+        check_control_cost_loss_types(problem)
+
+        # test parallel rollouts
+        check_rollouts(problem)
+
+        # test the derivatives of the trajectory linearisation
+        check_linearize_trajectory(problem)
+
+        # test accumulating the task-map Hessians into the state cost Hessian
+        check_contracted_task_hessians(problem, problem_init)
+
+        # test the Hessian-vector products against the Hessians
+        check_hessian_vector_products(problem)
+
+        # test shifting the trajectory for receding-horizon re-solves
+        check_shift_trajectory(problem)
+
+        # test writing the trajectories in place through the views
+        check_trajectory_views(problem)
+
+        # test changing the number of time steps for multiresolution solving
+        check_set_resolution(problem)
@@ -1,8 +1,12 @@
 #!/usr/bin/env python
 # coding: utf-8
 import roslib
+import shutil
+import tempfile
 import unittest
-from pyexotica.testing import check_dynamics_solver_derivatives
+import numpy as np
+import pyexotica as exo
+from pyexotica.testing import check_dynamics_solver_derivatives, random_state
 
 PKG = 'exotica_examples'
 roslib.load_manifest(PKG)  # This line is not needed with Catkin.
@@ -31,13 +35,41 @@ class TestDynamicsSolver(unittest.TestCase):
         check_dynamics_solver_derivatives('exotica/PinocchioDynamicsSolver',
                                           u'{exotica_examples}/resources/robots/lwr_simplified.urdf',
                                           u'{exotica_examples}/resources/robots/lwr_simplified.srdf',
-                                          u'arm')
+                                          u'arm', do_test_runge_kutta=False)
 
     def test_pinocchio_gravity_compensation_dynamics_solver(self):
         check_dynamics_solver_derivatives('exotica/PinocchioDynamicsSolverWithGravityCompensation',
                                           u'{exotica_examples}/resources/robots/lwr_simplified.urdf',
                                           u'{exotica_examples}/resources/robots/lwr_simplified.srdf',
-                                          u'arm')
+                                          u'arm', do_test_runge_kutta=False)
+
+    def test_pinocchio_dynamics_solver_code_generation(self):
+        cache_directory = tempfile.mkdtemp()
+        try:
+            recursive = self.create_pinocchio_dynamics_solver({})
+            # The second solver loads the library compiled by the first one from the cache
+            for _ in range(2):
+                generated = self.create_pinocchio_dynamics_solver({'UseCodeGeneration': True, 'CodeGenerationCacheDirectory': cache_directory})
+                for _ in range(5):
+                    x = random_state(recursive)
+                    u = np.random.random((recursive.nu,))
+                    np.testing.assert_allclose(generated.fx(x, u), recursive.fx(x, u), atol=1e-9)
+                    np.testing.assert_allclose(generated.fu(x, u), recursive.fu(x, u), atol=1e-9)
+        finally:
+            shutil.rmtree(cache_directory)
+
+    def create_pinocchio_dynamics_solver(self, additional_args):
+        scene_init = exo.Initializers.SceneInitializer()
+        scene_init[1]['URDF'] = u'{exotica_examples}/resources/robots/lwr_simplified.urdf'
+        scene_init[1]['SRDF'] = u'{exotica_examples}/resources/robots/lwr_simplified.srdf'
+        scene_init[1]['JointGroup'] = u'arm'
+        scene_init[1]['DynamicsSolver'] = [('exotica/PinocchioDynamicsSolver', dict({'Name': u'MyDynamicsSolver'}, **additional_args))]
+        self.scenes.append(exo.Setup.create_scene(exo.Initializers.Initializer(scene_init)))
+        return self.scenes[-1].get_dynamics_solver()
+
+    def setUp(self):
+        # The dynamics solvers are owned by their scenes
+        self.scenes = []
 
 
 if __name__ == '__main__':
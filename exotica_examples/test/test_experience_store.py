@@ -0,0 +1,120 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/example_aico.xml'
+
+
+def make_experience(start, goal, solution, cost, problem_type='Problem', scene_hash=0):
+    experience = exo.Experience()
+    experience.problem_type = problem_type
+    experience.scene_hash = scene_hash
+    experience.start = np.asarray(start, dtype=float)
+    experience.goal = np.asarray(goal, dtype=float)
+    experience.solution = np.asarray(solution, dtype=float)
+    experience.cost = cost
+    return experience
+
+
+def load_problem():
+    _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    return exo.Setup.create_problem(problem_init)
+
+
+class ExperienceStoreCase(unittest.TestCase):
+
+    def test_find_nearest(self):
+        store = exo.ExperienceStore(capacity=10, goal_weight=2.0)
+        for i in range(5):
+            store.add(make_experience([float(i)], [0.], [[float(i)]], float(i)))
+        # Different key: problem type, scene hash and sizes
+        store.add(make_experience([0.], [0.], [[0.]], 0., problem_type='Other'))
+        store.add(make_experience([0.], [0.], [[0.]], 0., scene_hash=1))
+        store.add(make_experience([0., 0.], [0.], [[0., 0.]], 0.))
+        self.assertEqual(len(store), 8)
+
+        nearest = store.find_nearest('Problem', 0, np.array([2.9]), np.array([0.]), k=3)
+        self.assertEqual([e.start[0] for e in nearest], [3., 2., 4.])
+
+        # The goal distance is weighted: 2 * 1^2 + i^2 is within 2.5 only for i = 0
+        nearest = store.find_nearest('Problem', 0, np.array([0.]), np.array([1.]), k=5, max_distance=2.5)
+        self.assertEqual([e.start[0] for e in nearest], [0.])
+
+        self.assertEqual(len(store.find_nearest('Missing', 0, np.array([0.]), np.array([0.]))), 0)
+        store.clear()
+        self.assertEqual(len(store), 0)
+
+    def test_capacity(self):
+        store = exo.ExperienceStore(capacity=3)
+        for i in range(5):
+            store.add(make_experience([float(i)], [0.], [[float(i)]], 0.))
+        self.assertEqual(len(store), 3)
+        # The oldest experiences are dropped
+        nearest = store.find_nearest('Problem', 0, np.array([0.]), np.array([0.]), k=5)
+        self.assertEqual(sorted(e.start[0] for e in nearest), [2., 3., 4.])
+        store.capacity = 1
+        self.assertEqual(len(store), 1)
+        self.assertEqual(store.find_nearest('Problem', 0, np.array([0.]), np.array([0.]))[0].start[0], 4.)
+
+    def test_invalid_goal_weight(self):
+        with self.assertRaises(Exception):
+            exo.ExperienceStore(10, -1.0)
+
+    def test_resample_trajectory(self):
+        trajectory = np.array([[0., 1.], [1., 3.], [2., 5.]])
+        resampled = exo.ExperienceStore.resample_trajectory(trajectory, 5)
+        self.assertEqual(resampled.shape, (5, 2))
+        np.testing.assert_allclose(resampled[0], trajectory[0])
+        np.testing.assert_allclose(resampled[-1], trajectory[-1])
+        np.testing.assert_allclose(resampled[:, 0], np.linspace(0., 2., 5))
+        np.testing.assert_allclose(exo.ExperienceStore.resample_trajectory(trajectory, 3), trajectory)
+        with self.assertRaises(Exception):
+            exo.ExperienceStore.resample_trajectory(trajectory, 0)
+
+    def test_hash_scene(self):
+        problem = load_problem()
+        scene = problem.get_scene()
+        empty_hash = exo.ExperienceStore.hash_scene(scene)
+        scene.add_object('Box', exo.KDLFrame([1., 0., 0.]), '', exo.Box(0.2, 0.2, 0.2), update_collision_scene=True)
+        box_hash = exo.ExperienceStore.hash_scene(scene)
+        self.assertNotEqual(box_hash, empty_hash)
+
+        # Re-adding the object at the same place gives the same hash, moving it changes the hash
+        scene.remove_object('Box')
+        self.assertEqual(exo.ExperienceStore.hash_scene(scene), empty_hash)
+        scene.add_object('Box', exo.KDLFrame([1., 0., 0.]), '', exo.Box(0.2, 0.2, 0.2), update_collision_scene=True)
+        self.assertEqual(exo.ExperienceStore.hash_scene(scene), box_hash)
+        scene.remove_object('Box')
+        scene.add_object('Box', exo.KDLFrame([1., 0.5, 0.]), '', exo.Box(0.2, 0.2, 0.2), update_collision_scene=True)
+        self.assertNotEqual(exo.ExperienceStore.hash_scene(scene), box_hash)
+
+    def test_warm_start_time_indexed(self):
+        problem = load_problem()
+        store = exo.ExperienceStore()
+        goal = np.array([0.6, -0.1, 0.5])
+        self.assertIsNone(store.warm_start(problem, goal))
+
+        # A solution of a similar query at a different horizon
+        problem.start_state = np.zeros(problem.N)
+        solution = np.linspace(np.zeros(problem.N), 0.5 * np.ones(problem.N), problem.T // 2)
+        store.add(problem, goal, solution, 1.0)
+        self.assertEqual(len(store), 1)
+
+        start = 0.01 * np.ones(problem.N)
+        problem.start_state = start
+        seed = store.warm_start(problem, goal)
+        self.assertIsNotNone(seed)
+        # Resampled to the horizon of the problem and repaired into the new start state
+        self.assertEqual(seed.shape, (problem.T, problem.N))
+        np.testing.assert_allclose(seed[0], start)
+        np.testing.assert_allclose(seed[-1], solution[-1])
+        np.testing.assert_allclose(np.array(problem.initial_trajectory), seed)
+
+        # Queries in another scene are not matched
+        problem.get_scene().add_object('Box', exo.KDLFrame([1., 0., 0.]), '', exo.Box(0.2, 0.2, 0.2), update_collision_scene=True)
+        self.assertIsNone(store.warm_start(problem, goal))
+
+
+if __name__ == '__main__':
+    unittest.main()
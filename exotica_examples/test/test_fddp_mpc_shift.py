@@ -0,0 +1,48 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/dynamic_time_indexed/18_ilqr_pendulum.xml'
+SOLVERS = ['exotica/FeasibilityDrivenDDPSolver', 'exotica/ControlLimitedFeasibilityDrivenDDPSolver']
+SOLVER_OPTIONS = {'MaxIterations': 20, 'Debug': False}
+SHIFT = 3
+
+
+def create_solver(solver_type, **options):
+    _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    problem = exo.Setup.create_problem(problem_init)
+    solver = exo.Setup.create_solver((solver_type, dict(SOLVER_OPTIONS, Name='MySolver', **options)))
+    solver.specify_problem(problem)
+    return problem, solver
+
+
+class FDDPMPCShiftCase(unittest.TestCase):
+
+    def test_shift_warm_start(self):
+        # Re-solving with MPCShift matches shifting the problem by hand, i.e. only the trajectories carry over
+        for solver_type in SOLVERS:
+            mpc_problem, mpc_solver = create_solver(solver_type, MPCShift=SHIFT)
+            problem, solver = create_solver(solver_type)
+
+            # The first solve has nothing to shift
+            np.testing.assert_allclose(mpc_solver.solve(), solver.solve(), atol=1e-9, err_msg=solver_type)
+
+            for _ in range(2):
+                problem.shift_trajectory(SHIFT)
+                expected = solver.solve()
+                np.testing.assert_allclose(mpc_solver.solve(), expected, atol=1e-9, err_msg=solver_type)
+                np.testing.assert_allclose(mpc_problem.X, problem.X, atol=1e-9, err_msg=solver_type)
+
+    def test_shift_differs_from_unshifted_warm_start(self):
+        # The shifted warm start is actually used: after a single iteration the result still depends on the initial trajectory
+        for solver_type in SOLVERS:
+            _, mpc_solver = create_solver(solver_type, MPCShift=SHIFT, MaxIterations=1)
+            _, solver = create_solver(solver_type, MaxIterations=1)
+            mpc_solver.solve()
+            solver.solve()
+            self.assertFalse(np.allclose(mpc_solver.solve(), solver.solve(), atol=1e-9), msg=solver_type)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,48 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/dynamic_time_indexed/18_ilqr_pendulum.xml'
+SOLVERS = ['exotica/FeasibilityDrivenDDPSolver', 'exotica/ControlLimitedFeasibilityDrivenDDPSolver']
+SOLVER_OPTIONS = {'MaxIterations': 50, 'Debug': False}
+
+
+def solve(solver_type, rollout_num_threads, **options):
+    _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    problem = exo.Setup.create_problem((problem_init[0], dict(problem_init[1], RolloutNumThreads=rollout_num_threads)))
+    solver = exo.Setup.create_solver((solver_type, dict(SOLVER_OPTIONS, Name='MySolver', **options)))
+    solver.specify_problem(problem)
+    solution = solver.solve()
+    return problem, solution
+
+
+class FDDPParallelForwardPassCase(unittest.TestCase):
+
+    def test_matches_serial_forward_pass(self):
+        # The predicted steps only skip the simulation of rejected steps, the accepted ones are simulated serially
+        for solver_type in SOLVERS:
+            reference_problem, reference_solution = solve(solver_type, 1)
+            for num_threads in [2, 3, 5]:
+                problem, solution = solve(solver_type, num_threads, ParallelForwardPass=True)
+                np.testing.assert_allclose(solution, reference_solution, atol=1e-6, err_msg=solver_type)
+                np.testing.assert_allclose(problem.get_cost_evolution()[1][-1], reference_problem.get_cost_evolution()[1][-1], rtol=1e-6)
+
+    def test_infeasible_warm_start(self):
+        # A state trajectory that does not match the controls leaves gaps, the predicted nodes have to account for them
+        for solver_type in SOLVERS:
+            results = []
+            for num_threads, parallel in [(1, False), (3, True)]:
+                _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+                problem = exo.Setup.create_problem((problem_init[0], dict(problem_init[1], RolloutNumThreads=num_threads)))
+                X = problem.X
+                X[0, 1:] = np.linspace(0., 3.14, problem.T)[1:]
+                problem.X = X
+                solver = exo.Setup.create_solver((solver_type, dict(SOLVER_OPTIONS, Name='MySolver', ParallelForwardPass=parallel)))
+                solver.specify_problem(problem)
+                results.append(solver.solve())
+            np.testing.assert_allclose(results[1], results[0], atol=1e-6, err_msg=solver_type)
+
+
+if __name__ == '__main__':
+    unittest.main()
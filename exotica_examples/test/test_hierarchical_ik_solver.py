@@ -0,0 +1,104 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+# Two position tasks on the tip of the arm conflict with each other, the elbow task can be achieved in the null-space of either
+XML = '''<IKSolverDemoConfig>
+  <HierarchicalIKSolver Name="MySolver" MaxIterations="200" />
+  <UnconstrainedEndPoseProblem Name="MyProblem">
+    <PlanningScene>
+      <Scene>
+        <JointGroup>arm</JointGroup>
+        <URDF>{exotica_examples}/resources/robots/lwr_simplified.urdf</URDF>
+        <SRDF>{exotica_examples}/resources/robots/lwr_simplified.srdf</SRDF>
+      </Scene>
+    </PlanningScene>
+    <Maps>
+      <EffPosition Name="Tip">
+        <EndEffector>
+          <Frame Link="lwr_arm_7_link"/>
+        </EndEffector>
+      </EffPosition>
+      <EffPosition Name="OtherTip">
+        <EndEffector>
+          <Frame Link="lwr_arm_7_link"/>
+        </EndEffector>
+      </EffPosition>
+      <EffPosition Name="Elbow">
+        <EndEffector>
+          <Frame Link="lwr_arm_3_link"/>
+        </EndEffector>
+      </EffPosition>
+    </Maps>
+    <Cost>
+      <Task Task="Tip"/>
+      <Task Task="OtherTip"/>
+      <Task Task="Elbow"/>
+    </Cost>
+    <StartState>0.1 0.2 0.3 0.4 0.5 0.6 0.7</StartState>
+    <W>7 6 5 4 3 2 1</W>
+  </UnconstrainedEndPoseProblem>
+</IKSolverDemoConfig>'''
+
+Q_A = np.array([0.3, 0.6, -0.2, -0.8, 0.1, 0.5, 0.0])
+Q_B = np.array([-0.4, 0.9, 0.3, -0.4, -0.2, 0.3, 0.0])
+
+
+def positions(problem, q):
+    problem.update(q)
+    scene = problem.get_scene()
+    return scene.fk('lwr_arm_7_link').get_translation(), scene.fk('lwr_arm_3_link').get_translation()
+
+
+def solve(priority_levels, rho_other_tip=1.0):
+    solver_init, problem_init = exo.Initializers.load_xml_full(XML, parseAsXMLString=True)
+    problem = exo.Setup.create_problem(problem_init)
+    tip_a, elbow_a = positions(problem, Q_A)
+    tip_b, _ = positions(problem, Q_B)
+    problem.set_goal('Tip', tip_a)
+    problem.set_goal('OtherTip', tip_b)
+    problem.set_goal('Elbow', elbow_a)
+    problem.set_rho('OtherTip', rho_other_tip)
+    solver = exo.Setup.create_solver((solver_init[0], dict(solver_init[1], PriorityLevels=np.array(priority_levels))))
+    solver.specify_problem(problem)
+    solution = solver.solve()[0]
+    problem.update(solution)
+    return problem
+
+
+class HierarchicalIKSolverCase(unittest.TestCase):
+
+    def test_strict_priorities(self):
+        # The task of the highest level is achieved, the conflicting task of the lower level only where it does not interfere
+        for levels, first, second in [([0, 1, 2], 'Tip', 'OtherTip'), ([1, 0, 2], 'OtherTip', 'Tip')]:
+            problem = solve(levels)
+            self.assertLess(problem.get_scalar_task_cost(first), 1e-6)
+            self.assertGreater(problem.get_scalar_task_cost(second), 1e-3)
+
+    def test_null_space(self):
+        # The elbow goal is consistent with the tip goal of Q_A, it is achieved in the null-space of the tip task
+        problem = solve([0, 2, 1])
+        self.assertLess(problem.get_scalar_task_cost('Tip'), 1e-6)
+        self.assertLess(problem.get_scalar_task_cost('Elbow'), 1e-5)
+
+    def test_priority_does_not_depend_on_rho(self):
+        # The weight of a lower level does not matter, it cannot pull a higher level away from its goal
+        for rho in [1.0, 1e3]:
+            problem = solve([0, 1, 2], rho_other_tip=rho)
+            self.assertLess(problem.get_scalar_task_cost('Tip'), 1e-6)
+
+    def test_shared_level(self):
+        # Tasks sharing a level are traded off, neither of the conflicting tasks is achieved
+        problem = solve([0, 0, 1])
+        self.assertGreater(problem.get_scalar_task_cost('Tip'), 1e-6)
+        self.assertGreater(problem.get_scalar_task_cost('OtherTip'), 1e-6)
+
+    def test_invalid_priority_levels(self):
+        for levels in [[0, 1], [0, -1, 2]]:
+            with self.assertRaises(Exception):
+                solve(levels)
+
+
+if __name__ == '__main__':
+    unittest.main()
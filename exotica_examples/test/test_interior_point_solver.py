@@ -0,0 +1,116 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+# The tip has to reach a target at the end of the trajectory below a maximum height, at limited joint velocities
+XML = '''<SolverDemoConfig>
+  <InteriorPointSolver Name="MySolver" MaxIterations="200" />
+  <TimeIndexedProblem Name="MyProblem">
+    <PlanningScene>
+      <Scene>
+        <JointGroup>arm</JointGroup>
+        <URDF>{exotica_examples}/resources/robots/lwr_simplified.urdf</URDF>
+        <SRDF>{exotica_examples}/resources/robots/lwr_simplified.srdf</SRDF>
+      </Scene>
+    </PlanningScene>
+    <Maps>
+      <EffPosition Name="Tip">
+        <EndEffector>
+          <Frame Link="lwr_arm_6_link"/>
+        </EndEffector>
+      </EffPosition>
+      <EffPosition Name="Height">
+        <EndEffector>
+          <Frame Link="lwr_arm_6_link"/>
+        </EndEffector>
+      </EffPosition>
+    </Maps>
+    <Equality>
+      <Task Task="Tip"/>
+    </Equality>
+    <Inequality>
+      <Task Task="Height"/>
+    </Inequality>
+    <JointVelocityLimits>1.5</JointVelocityLimits>
+    <StartState>0.1 0.6 0.0 -1.2 0.0 0.8 0.0</StartState>
+    <T>20</T>
+    <tau>0.05</tau>
+    <W>7 6 5 4 3 2 1</W>
+  </TimeIndexedProblem>
+</SolverDemoConfig>'''
+
+Q_TARGET = np.array([0.7, 0.9, -0.3, -0.9, 0.2, 0.6, 0.0])
+TOLERANCE = 1e-5
+
+
+def tip_position(problem, q):
+    problem.update(q, 0)
+    return problem.get_scene().fk('lwr_arm_6_link').get_translation()
+
+
+def setup(**options):
+    solver_init, problem_init = exo.Initializers.load_xml_full(XML, parseAsXMLString=True)
+    problem = exo.Setup.create_problem(problem_init)
+    T = problem.T
+    start = problem.start_state.copy()
+    target = tip_position(problem, Q_TARGET)
+    max_height = max(tip_position(problem, start)[2], target[2]) + 0.02
+    for t in range(T):
+        problem.set_rho_eq('Tip', 1.0 if t == T - 1 else 0.0, t)
+        problem.set_goal_neq('Height', np.array([10., 10., max_height]), t)
+        problem.set_rho_neq('Height', 0.0 if t == 0 else 1.0, t)
+    problem.set_goal_eq('Tip', target, T - 1)
+    problem.start_state = start
+    solver = exo.Setup.create_solver((solver_init[0], dict(solver_init[1], **options)))
+    solver.specify_problem(problem)
+    return problem, solver
+
+
+class InteriorPointSolverCase(unittest.TestCase):
+
+    def check_feasible(self, problem, solution):
+        T = problem.T
+        self.assertEqual(solution.shape, (T, problem.N))
+        np.testing.assert_allclose(solution[0], problem.start_state, atol=1e-9)
+        for t in range(T):
+            problem.update(solution[t], t)
+        self.assertLess(np.max(np.abs(problem.get_equality(T - 1))), TOLERANCE)
+        for t in range(1, T):
+            self.assertLess(np.max(problem.get_inequality(t)), TOLERANCE)
+        velocities = np.diff(solution, axis=0) / problem.tau
+        self.assertLess(np.max(np.abs(velocities)), 1.5 + TOLERANCE)
+        bounds = problem.get_bounds()
+        self.assertTrue(np.all(solution >= bounds[:, 0] - TOLERANCE))
+        self.assertTrue(np.all(solution <= bounds[:, 1] + TOLERANCE))
+
+    def test_constraints(self):
+        problem, solver = setup()
+        self.check_feasible(problem, solver.solve())
+
+    def test_repeated_solve(self):
+        # The second solve starts from the first solution and reuses the symbolic factorisation
+        problem, solver = setup()
+        first = solver.solve()
+        problem.initial_trajectory = first
+        second = solver.solve()
+        self.check_feasible(problem, second)
+        np.testing.assert_allclose(second, first, atol=1e-4)
+
+    def test_infeasible_initial_trajectory(self):
+        # An initial trajectory violating the velocity limits is pulled back into the feasible set
+        problem, solver = setup()
+        initial = np.tile(problem.start_state, (problem.T, 1))
+        initial[1:] = Q_TARGET
+        problem.initial_trajectory = initial
+        self.check_feasible(problem, solver.solve())
+
+    def test_wrong_problem_type(self):
+        _, unconstrained = exo.Initializers.load_xml_full('{exotica_examples}/resources/configs/example_aico.xml')
+        solver = exo.Setup.create_solver(('exotica/InteriorPointSolver', {'Name': 'MySolver'}))
+        with self.assertRaises(Exception):
+            solver.specify_problem(exo.Setup.create_problem(unconstrained))
+
+
+if __name__ == '__main__':
+    unittest.main()
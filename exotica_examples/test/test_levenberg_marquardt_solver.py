@@ -0,0 +1,104 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+# Tasks on different links of the arm give a Jacobian whose rows only depend on some of the joints, the joint limit task depends on all
+XML = '''<IKSolverDemoConfig>
+  <LevenbergMarquardtSolver Name="MySolver" Damping="0.01" MaxIterations="100" />
+  <UnconstrainedEndPoseProblem Name="MyProblem">
+    <PlanningScene>
+      <Scene>
+        <JointGroup>arm</JointGroup>
+        <URDF>{exotica_examples}/resources/robots/lwr_simplified.urdf</URDF>
+        <SRDF>{exotica_examples}/resources/robots/lwr_simplified.srdf</SRDF>
+      </Scene>
+    </PlanningScene>
+    <Maps>
+      <EffPosition Name="Elbow">
+        <EndEffector>
+          <Frame Link="lwr_arm_3_link"/>
+        </EndEffector>
+      </EffPosition>
+      <EffFrame Name="Wrist">
+        <EndEffector>
+          <Frame Link="lwr_arm_5_link"/>
+        </EndEffector>
+      </EffFrame>
+      <EffPosition Name="Tip">
+        <EndEffector>
+          <Frame Link="lwr_arm_7_link"/>
+        </EndEffector>
+      </EffPosition>
+      <JointLimit Name="JointLimit"/>
+    </Maps>
+    <Cost>
+      <Task Task="Elbow"/>
+      <Task Task="Wrist"/>
+      <Task Task="Tip" Rho="10"/>
+      <Task Task="JointLimit" Rho="0.1"/>
+    </Cost>
+    <StartState>0.1 0.2 0.3 0.4 0.5 0.6 0.7</StartState>
+    <W>7 6 5 4 3 2 1</W>
+  </UnconstrainedEndPoseProblem>
+</IKSolverDemoConfig>'''
+
+
+class LevenbergMarquardtSolverCase(unittest.TestCase):
+
+    def solve(self, **options):
+        solver_init, problem_init = exo.Initializers.load_xml_full(XML, parseAsXMLString=True)
+        problem = exo.Setup.create_problem(problem_init)
+        solver = exo.Setup.create_solver((solver_init[0], dict(solver_init[1], **options)))
+        solver.specify_problem(problem)
+        problem.set_goal('Tip', np.array([0.4, 0.3, 0.6]))
+        problem.set_goal('Elbow', np.array([0.0, 0.1, 0.5]))
+        return problem, solver.solve()
+
+    def check_sparse_matches_dense(self, **options):
+        dense_problem, dense_solution = self.solve(**options)
+        sparse_problem, sparse_solution = self.solve(SparseNormalEquations=True, **options)
+        np.testing.assert_allclose(sparse_solution, dense_solution, atol=1e-6)
+        np.testing.assert_allclose(sparse_problem.get_cost_evolution()[1], dense_problem.get_cost_evolution()[1], rtol=1e-6, atol=1e-12)
+
+    def test_sparse_matches_dense(self):
+        self.check_sparse_matches_dense()
+
+    def test_sparse_matches_dense_scaled(self):
+        self.check_sparse_matches_dense(ScaleProblem='Jacobian')
+
+    def test_sparse_rejects_broyden_updates(self):
+        with self.assertRaises(Exception):
+            self.solve(SparseNormalEquations=True, BroydenUpdates=2)
+
+
+    def test_broyden_updates_converge(self):
+        # The quasi-Newton steps approximate the Jacobian in between evaluations, the solver reaches the same minimum
+        reference_problem, reference_solution = self.solve()
+        reference_cost = reference_problem.get_cost_evolution()[1][-1]
+        for broyden_updates in [1, 3, 10]:
+            problem, solution = self.solve(BroydenUpdates=broyden_updates)
+            costs = problem.get_cost_evolution()[1]
+            self.assertLess(costs[-1], costs[0])
+            np.testing.assert_allclose(costs[-1], reference_cost, rtol=1e-3, atol=1e-6)
+
+    def test_update_cost_matches_update(self):
+        # UpdateCost skips the Jacobians of the task maps, the cost has to be the one of a full update
+        solver_init, problem_init = exo.Initializers.load_xml_full(XML, parseAsXMLString=True)
+        problem = exo.Setup.create_problem(problem_init)
+        problem.set_goal('Tip', np.array([0.4, 0.3, 0.6]))
+        for _ in range(10):
+            q = np.random.uniform(-1., 1., problem.N)
+            problem.update(q)
+            cost, ydiff = problem.get_scalar_cost(), problem.ydiff.copy()
+            problem.update(np.zeros(problem.N))
+            problem.update_cost(q)
+            self.assertAlmostEqual(problem.get_scalar_cost(), cost)
+            np.testing.assert_allclose(problem.ydiff, ydiff)
+
+    def test_negative_broyden_updates(self):
+        with self.assertRaises(Exception):
+            self.solve(BroydenUpdates=-1)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,63 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+import exotica_mppi_solver_py  # noqa: F401, registers the MPPISolver bindings
+
+CONFIG = '{exotica_examples}/resources/configs/dynamic_time_indexed/24_mppi_pendulum.xml'
+
+
+class MPPISolverCase(unittest.TestCase):
+
+    def solve(self, **options):
+        solver_init, problem_init = exo.Initializers.load_xml_full(CONFIG)
+        solver_init = (solver_init[0], dict(solver_init[1], Debug=False, MaxIterations=30, NumSamples=64, **options))
+        problem = exo.Setup.create_problem(problem_init)
+        solver = exo.Setup.create_solver(solver_init)
+        solver.specify_problem(problem)
+        solution = solver.solve()
+        return solver, problem, solution
+
+    def check_solution(self, solver, problem, solution):
+        self.assertEqual(solution.shape, (problem.T - 1, 1))
+        self.assertTrue(np.all(np.abs(solution) <= 10.0 + 1e-9))
+        # The nominal controls improve on the initial (zero) controls
+        costs = problem.get_cost_evolution()[1]
+        self.assertLess(costs[-1], costs[0])
+        # Sampling-based MPC has no feedback gains, the control of the last Solve does not depend on the state
+        for t in [0, problem.T // 2, problem.T - 2]:
+            np.testing.assert_allclose(solver.get_feedback_control(np.random.random(2), t), solution[t])
+            np.testing.assert_allclose(solver.get_published_feedback_control(np.random.random(2), t), solution[t])
+
+    def test_mppi(self):
+        self.check_solution(*self.solve())
+
+    def test_cem(self):
+        self.check_solution(*self.solve(UpdateRule='CEM', NumEliteSamples=8))
+
+    def test_seed(self):
+        _, _, solution = self.solve(Seed=3)
+        _, _, same_seed_solution = self.solve(Seed=3)
+        _, _, other_seed_solution = self.solve(Seed=4)
+        np.testing.assert_array_equal(solution, same_seed_solution)
+        self.assertFalse(np.array_equal(solution, other_seed_solution))
+
+    def test_mpc_shift(self):
+        # The next Solve is warm-started from the shifted nominal controls rather than from the initial controls
+        solver, problem, _ = self.solve(MPCShift=1)
+        cold_start_cost = problem.get_cost_evolution()[1][0]
+        solver.solve()
+        warm_start_costs = problem.get_cost_evolution()[1]
+        self.assertLess(warm_start_costs[0], cold_start_cost)
+        self.assertLessEqual(warm_start_costs[-1], warm_start_costs[0])
+
+    def test_invalid_options(self):
+        solver_init, _ = exo.Initializers.load_xml_full(CONFIG)
+        with self.assertRaises(Exception):
+            exo.Setup.create_solver((solver_init[0], dict(solver_init[1], UpdateRule='Unknown')))
+        with self.assertRaises(Exception):
+            exo.Setup.create_solver((solver_init[0], dict(solver_init[1], NumSamples=1)))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,75 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+XML = '''<IKSolverDemoConfig>
+  <IKSolver Name="MySolver" MaxIterations="100" />
+  <UnconstrainedEndPoseProblem Name="MyProblem">
+    <PlanningScene>
+      <Scene>
+        <JointGroup>arm</JointGroup>
+        <URDF>{exotica_examples}/resources/robots/lwr_simplified.urdf</URDF>
+        <SRDF>{exotica_examples}/resources/robots/lwr_simplified.srdf</SRDF>
+      </Scene>
+    </PlanningScene>
+    <Maps>
+      <EffPosition Name="Position">
+        <EndEffector>
+          <Frame Link="lwr_arm_6_link"/>
+        </EndEffector>
+      </EffPosition>
+    </Maps>
+    <Cost>
+      <Task Task="Position"/>
+    </Cost>
+    <StartState>0 0 0 0 0 0 0</StartState>
+  </UnconstrainedEndPoseProblem>
+</IKSolverDemoConfig>'''
+
+Q_GOAL = np.array([0.3, 0.6, -0.2, -0.8, 0.1, 0.5, 0.0])
+
+
+def setup(num_threads):
+    solver_init, problem_init = exo.Initializers.load_xml_full(XML, parseAsXMLString=True)
+    problem = exo.Setup.create_problem(problem_init)
+    problem.update(Q_GOAL)
+    problem.set_goal('Position', problem.get_scene().fk('lwr_arm_6_link').get_translation())
+    solver = exo.Setup.create_solver((solver_init[0], dict(solver_init[1], MultiStartNumThreads=num_threads)))
+    solver.specify_problem(problem)
+    return problem, solver
+
+
+class MultiStartCase(unittest.TestCase):
+
+    def setUp(self):
+        # The seeds are solved on the thread pool of the Server, with more blocks than workers
+        exo.Setup.configure_thread_pool(3)
+        np.random.seed(42)
+        self.seeds = [np.random.uniform(-1.0, 1.0, 7) for _ in range(8)]
+
+    def tearDown(self):
+        exo.Setup.configure_thread_pool()
+
+    def test_parallel_reaches_goal(self):
+        for num_threads in [1, 4]:
+            problem, solver = setup(num_threads)
+            start_state = problem.start_state.copy()
+            solution = solver.solve_multi_start(self.seeds)
+            problem.update(solution[0])
+            self.assertLess(problem.get_scalar_task_cost('Position'), 1e-6)
+            np.testing.assert_array_equal(problem.start_state, start_state)
+
+    def test_parallel_errors_are_raised(self):
+        _, solver = setup(4)
+        if solver.multi_start_num_threads < 2:
+            self.skipTest('Multi-start runs serially')
+        # Every block starts with a seed of the wrong size
+        with self.assertRaises(Exception):
+            solver.solve_multi_start([np.zeros(3)] * 8)
+        # The solver remains usable
+        solver.solve_multi_start(self.seeds)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,57 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+DDP_CONFIG = '{exotica_examples}/resources/configs/dynamic_time_indexed/18_ilqr_pendulum.xml'
+AICO_CONFIG = '{exotica_examples}/resources/configs/example_aico.xml'
+
+
+class MultiresolutionSolversCase(unittest.TestCase):
+
+    def solve_ddp(self, **options):
+        _, problem_init = exo.Initializers.load_xml_full(DDP_CONFIG)
+        problem = exo.Setup.create_problem(problem_init)
+        solver = exo.Setup.create_solver(('exotica/AnalyticDDPSolver', dict({'Name': 'AnalyticDDPSolver', 'MaxIterations': 50, 'RegularizationRate': 1e-4, 'Debug': False}, **options)))
+        solver.specify_problem(problem)
+        solution = solver.solve()
+        return problem, solution
+
+    def test_ddp(self):
+        problem, solution = self.solve_ddp()
+        T, tau, dt = problem.T, problem.tau, problem.get_scene().get_dynamics_solver().dt
+        cold_start_cost = problem.get_cost_evolution()[1][0]
+
+        problem, solution = self.solve_ddp(MultiresolutionLevels=3, MultiresolutionIterations=5)
+        # The problem is back at its own resolution
+        self.assertEqual(problem.T, T)
+        self.assertEqual(problem.tau, tau)
+        self.assertEqual(problem.get_scene().get_dynamics_solver().dt, dt)
+        self.assertEqual(solution.shape, (T - 1, 1))
+        # The finest level starts from the resampled controls of the coarser levels rather than from zero controls
+        costs = problem.get_cost_evolution()[1]
+        self.assertLess(costs[0], cold_start_cost)
+        self.assertLessEqual(costs[-1], costs[0])
+
+    def test_aico(self):
+        solver_init, problem_init = exo.Initializers.load_xml_full(AICO_CONFIG)
+        problem = exo.Setup.create_problem(problem_init)
+        solver = exo.Setup.create_solver((solver_init[0], dict(solver_init[1], MaxIterations=50, MultiresolutionLevels=3, MultiresolutionIterations=5)))
+        solver.specify_problem(problem)
+        T, tau = problem.T, problem.tau
+        problem.start_state = np.zeros(problem.N)
+        solution = solver.solve()
+        self.assertEqual(problem.T, T)
+        self.assertEqual(problem.tau, tau)
+        self.assertEqual(solution.shape, (T, problem.N))
+        costs = problem.get_cost_evolution()[1]
+        self.assertTrue(np.isfinite(costs[-1]))
+        self.assertLessEqual(costs[-1], costs[0])
+
+    def test_invalid_levels(self):
+        with self.assertRaises(Exception):
+            self.solve_ddp(MultiresolutionLevels=0)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,55 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/example_manipulate_ompl.xml'
+START = [1.5035205538438838, 0.8730168650583787, -1.6298590879018438, 1.7106630821349438, -0.8789956712153559, 0.1278222471656531, 0.0]
+GOAL = [-1.5035205538442702, 0.8730168650583671, 1.6298590879018415, 1.7106630821349786, 0.8789956712153525, 0.12782224716566898, 0.0]
+# The links of the arm are less than 1.3 m away from its base
+LIPSCHITZ_CONSTANT = 1.3
+
+
+def setup(self_collision, **options):
+    _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    maps = [(name, dict(parameters, SelfCollision=self_collision)) for name, parameters in problem_init[1]['Maps']]
+    problem = exo.Setup.create_problem((problem_init[0], dict(problem_init[1], Maps=maps)))
+    solver = exo.Setup.create_solver(('exotica/RRTConnectSolver', dict({'Name': 'MySolver', 'Timeout': 10.0, 'RandomSeed': 1, 'Smooth': False}, **options)))
+    solver.specify_problem(problem)
+    problem.start_state = START
+    problem.goal_state = GOAL
+    return problem, solver
+
+
+class OMPLClearanceMotionValidationCase(unittest.TestCase):
+
+    def check_path(self, problem, solution, resolution=0.02):
+        # Every motion of the path has to be valid between the states visited by the validator
+        np.testing.assert_allclose(solution[0], START, atol=1e-6)
+        np.testing.assert_allclose(solution[-1], GOAL, atol=1e-6)
+        for a, b in zip(solution[:-1], solution[1:]):
+            steps = max(int(np.ceil(np.linalg.norm(b - a) / resolution)), 1)
+            for s in np.linspace(0., 1., steps + 1):
+                self.assertTrue(problem.is_state_valid(a + s * (b - a)))
+
+    def test_world_collisions(self):
+        problem, solver = setup(False, ClearanceMotionValidation=True, ClearanceLipschitzConstant=LIPSCHITZ_CONSTANT)
+        self.check_path(problem, solver.solve())
+
+    def test_self_collisions(self):
+        # The self-collision distances close twice as fast, the motions still may not pass through the robot
+        problem, solver = setup(True, ClearanceMotionValidation=True, ClearanceLipschitzConstant=LIPSCHITZ_CONSTANT)
+        self.check_path(problem, solver.solve())
+
+    def test_parallel_planners(self):
+        # States checked on workspace clones have no clearance, the validator steps finely
+        problem, solver = setup(True, ClearanceMotionValidation=True, ClearanceLipschitzConstant=LIPSCHITZ_CONSTANT, NumParallelPlanners=3)
+        self.check_path(problem, solver.solve())
+
+    def test_requires_lipschitz_constant(self):
+        with self.assertRaises(Exception):
+            setup(False, ClearanceMotionValidation=True)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,52 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/example_manipulate_ompl.xml'
+START = [1.5035205538438838, 0.8730168650583787, -1.6298590879018438, 1.7106630821349438, -0.8789956712153559, 0.1278222471656531, 0.0]
+GOAL = [-1.5035205538442702, 0.8730168650583671, 1.6298590879018415, 1.7106630821349786, 0.8789956712153525, 0.12782224716566898, 0.0]
+
+
+def setup(**options):
+    _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    problem = exo.Setup.create_problem(problem_init)
+    solver = exo.Setup.create_solver(('exotica/RRTConnectSolver', dict({'Name': 'MySolver', 'Timeout': 10.0, 'RandomSeed': 1, 'Smooth': False}, **options)))
+    solver.specify_problem(problem)
+    problem.start_state = START
+    problem.goal_state = GOAL
+    return problem, solver
+
+
+class OMPLContinuousMotionValidationCase(unittest.TestCase):
+
+    def check_path(self, problem, solution, resolution=0.02):
+        np.testing.assert_allclose(solution[0], START, atol=1e-6)
+        np.testing.assert_allclose(solution[-1], GOAL, atol=1e-6)
+        for a, b in zip(solution[:-1], solution[1:]):
+            steps = max(int(np.ceil(np.linalg.norm(b - a) / resolution)), 1)
+            for s in np.linspace(0., 1., steps + 1):
+                self.assertTrue(problem.is_state_valid(a + s * (b - a)))
+
+    def test_hybrid(self):
+        # Contacts of the continuous queries are confirmed at interpolated states, the motions are free at those states
+        problem, solver = setup(ContinuousMotionValidation=True)
+        self.check_path(problem, solver.solve())
+
+    def test_continuous_only(self):
+        # The link poses are interpolated rather than the joints, hence only the states of the path are checked here
+        problem, solver = setup(ContinuousMotionValidation=True, ContinuousMotionValidationHybrid=False)
+        solution = solver.solve()
+        np.testing.assert_allclose(solution[0], START, atol=1e-6)
+        np.testing.assert_allclose(solution[-1], GOAL, atol=1e-6)
+        for state in solution:
+            self.assertTrue(problem.is_state_valid(state))
+
+    def test_parallel_planners(self):
+        # Ignored with parallel planners, which validate motions on their own clones
+        problem, solver = setup(ContinuousMotionValidation=True, NumParallelPlanners=3)
+        self.check_path(problem, solver.solve())
+
+
+if __name__ == '__main__':
+    unittest.main()
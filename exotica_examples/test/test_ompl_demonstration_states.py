@@ -0,0 +1,50 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+import exotica_ompl_solver_py as ompl
+
+CONFIG = '{exotica_examples}/resources/configs/example_manipulate_ompl.xml'
+START = [1.5035205538438838, 0.8730168650583787, -1.6298590879018438, 1.7106630821349438, -0.8789956712153559, 0.1278222471656531, 0.0]
+GOAL = [-1.5035205538442702, 0.8730168650583671, 1.6298590879018415, 1.7106630821349786, 0.8789956712153525, 0.12782224716566898, 0.0]
+
+
+def setup(**options):
+    solver_init, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    problem = exo.Setup.create_problem(problem_init)
+    solver = exo.Setup.create_solver(('exotica/RRTConnectSolver', dict({'Name': 'MySolver', 'Timeout': 10.0, 'UseSolutionsAsDemonstrations': True, 'DemonstrationSampleRatio': 0.5}, **options)))
+    solver.specify_problem(problem)
+    problem.start_state = START
+    problem.goal_state = GOAL
+    return problem, solver
+
+
+class OMPLDemonstrationStatesCase(unittest.TestCase):
+
+    def test_states_are_capped(self):
+        problem, solver = setup(MaxDemonstrationStates=5)
+        for _ in range(4):
+            solution = solver.solve()
+            states = solver.demonstration_states
+            self.assertLessEqual(states.shape[0], 5)
+            # The newest states are kept
+            n = min(states.shape[0], solution.shape[0])
+            np.testing.assert_allclose(states[-n:], solution[-n:])
+
+    def test_states_of_solutions_are_appended(self):
+        problem, solver = setup()
+        solver.demonstration_states = np.array([START])
+        solution = solver.solve()
+        states = solver.demonstration_states
+        self.assertEqual(states.shape[0], 1 + solution.shape[0])
+        np.testing.assert_allclose(states[0], START)
+        np.testing.assert_allclose(states[1:], solution)
+
+    def test_no_states_are_kept(self):
+        problem, solver = setup(MaxDemonstrationStates=0)
+        solver.solve()
+        self.assertEqual(solver.demonstration_states.shape[0], 0)
+
+
+if __name__ == '__main__':
+    unittest.main()
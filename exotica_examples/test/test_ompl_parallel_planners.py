@@ -0,0 +1,51 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/example_manipulate_ompl.xml'
+START = [1.5035205538438838, 0.8730168650583787, -1.6298590879018438, 1.7106630821349438, -0.8789956712153559, 0.1278222471656531, 0.0]
+GOAL = [-1.5035205538442702, 0.8730168650583671, 1.6298590879018415, 1.7106630821349786, 0.8789956712153525, 0.12782224716566898, 0.0]
+
+
+def setup(solver_type, **options):
+    solver_init, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    problem = exo.Setup.create_problem(problem_init)
+    solver = exo.Setup.create_solver(('exotica/' + solver_type, dict({'Name': 'MySolver', 'Timeout': 10.0}, **options)))
+    solver.specify_problem(problem)
+    problem.start_state = START
+    problem.goal_state = GOAL
+    return problem, solver
+
+
+class OMPLParallelPlannersCase(unittest.TestCase):
+
+    def check_solution(self, problem, solution):
+        np.testing.assert_allclose(solution[0], START, atol=1e-6)
+        np.testing.assert_allclose(solution[-1], GOAL, atol=1e-6)
+        for q in solution:
+            self.assertTrue(problem.is_state_valid(q))
+
+    def test_parallel_planners(self):
+        # The planner threads check states on their own clones, repeated solves assign the clones again
+        for solver_type in ['RRTConnectSolver', 'PRMSolver']:
+            problem, solver = setup(solver_type, NumParallelPlanners=4)
+            for _ in range(3):
+                self.check_solution(problem, solver.solve())
+
+    def test_portfolio_planners(self):
+        problem, solver = setup('RRTConnectSolver', PortfolioPlanners=['RRT', 'KPIECE', 'EST'])
+        for _ in range(2):
+            self.check_solution(problem, solver.solve())
+
+    def test_more_planners_than_workspaces(self):
+        # Two solvers share the threads of the process, each assigns the workspaces of its own problem
+        problem_a, solver_a = setup('RRTConnectSolver', NumParallelPlanners=3)
+        problem_b, solver_b = setup('RRTConnectSolver', NumParallelPlanners=2)
+        for _ in range(2):
+            self.check_solution(problem_a, solver_a.solve())
+            self.check_solution(problem_b, solver_b.solve())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,51 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+import exotica_ompl_solver_py as ompl
+
+
+class OMPLTimeParameterisationCase(unittest.TestCase):
+
+    def test_two_states(self):
+        path = np.array([[0.0, 0.0], [1.0, 2.0]])
+        # The slowest joint moves 2 at 0.5, accelerating and decelerating at 2 takes 0.25 longer
+        times = ompl.time_parameterise_path(path, np.array([1.0, 0.5]), np.array([2.0, 2.0]))
+        np.testing.assert_allclose(times, [0.0, 4.25])
+        # Without the velocity limits, it accelerates to the middle and decelerates after
+        times = ompl.time_parameterise_path(path, np.zeros(2), np.array([2.0, 2.0]))
+        np.testing.assert_allclose(times, [0.0, 2.0])
+
+    def test_zero_acceleration_limits(self):
+        # Limits which are not positive do not constrain the motion, the segments are traversed at the velocity limits
+        path = np.array([[0.0, 0.0], [1.0, 0.0], [1.0, 1.0]])
+        times = ompl.time_parameterise_path(path, np.array([1.0, 0.5]), np.zeros(2))
+        np.testing.assert_allclose(times, [0.0, 1.0, 3.0])
+        times = ompl.time_parameterise_path(path[:2], np.array([1.0, 0.5]), np.zeros(2))
+        np.testing.assert_allclose(times, [0.0, 1.0])
+        # Without any limits, the path takes no time
+        times = ompl.time_parameterise_path(path, np.zeros(2), np.zeros(2))
+        np.testing.assert_allclose(times, np.zeros(3))
+
+    def test_limits(self):
+        np.random.seed(0)
+        path = np.cumsum(np.random.uniform(-1.0, 1.0, (10, 3)), axis=0)
+        velocity_limits = np.array([1.0, 2.0, 0.5])
+        times = ompl.time_parameterise_path(path, velocity_limits, np.array([1.0, 1.0, 1.0]))
+        self.assertTrue(np.all(np.diff(times) > 0.0))
+        # No segment is faster than the velocity limits allow
+        velocities = np.diff(path, axis=0) / np.diff(times)[:, None]
+        self.assertTrue(np.all(np.abs(velocities) <= velocity_limits + 1e-9))
+
+        samples, sample_times = ompl.resample_path(path, times, 0.1)
+        np.testing.assert_allclose(samples[0], path[0])
+        np.testing.assert_allclose(samples[-1], path[-1])
+        self.assertAlmostEqual(sample_times[-1], times[-1])
+
+    def test_single_state(self):
+        times = ompl.time_parameterise_path(np.zeros((1, 2)), np.ones(2), np.ones(2))
+        np.testing.assert_allclose(times, [0.0])
+
+
+if __name__ == '__main__':
+    unittest.main()
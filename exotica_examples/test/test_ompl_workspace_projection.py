@@ -0,0 +1,59 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/example_ompl_projections.xml'
+START = [0.0] * 7
+
+
+class OMPLWorkspaceProjectionCase(unittest.TestCase):
+
+    def solve(self, **options):
+        solver_init, problem_init = exo.Initializers.load_xml_full(CONFIG)
+        solver_init = (solver_init[0], dict(solver_init[1], Projection=np.array([]), ProjectionLink='lwr_arm_7_link', RandomSeed=1, **options))
+        problem = exo.Setup.create_problem(problem_init)
+        solver = exo.Setup.create_solver(solver_init)
+        solver.specify_problem(problem)
+        problem.start_state = START
+        solution = solver.solve()
+        self.check_solution(problem, solution)
+        return solver, problem
+
+    def check_solution(self, problem, solution):
+        self.assertGreater(solution.shape[0], 1)
+        np.testing.assert_allclose(solution[0], START, atol=1e-6)
+        np.testing.assert_allclose(solution[-1], problem.goal_state, atol=1e-3)
+        for q in solution:
+            self.assertTrue(problem.is_state_valid(q))
+
+    def test_default_motion_validation(self):
+        self.solve()
+
+    def test_batch_motion_validation(self):
+        self.solve(BatchMotionValidation=True)
+
+    def test_continuous_motion_validation(self):
+        self.solve(ContinuousMotionValidation=True)
+
+    def test_world_change(self):
+        # The positions of states missing from the cache come from a clone of the scene, which has to follow the world
+        solver, problem = self.solve()
+        problem.get_scene().add_object('Marker', exo.KDLFrame([2.0, 2.0, 2.0]), '', exo.Sphere(0.05), update_collision_scene=True)
+        problem.start_state = START
+        self.check_solution(problem, solver.solve())
+
+    def test_projection_options(self):
+        solver_init, problem_init = exo.Initializers.load_xml_full(CONFIG)
+        problem = exo.Setup.create_problem(problem_init)
+        # Projection and ProjectionLink are mutually exclusive
+        solver = exo.Setup.create_solver((solver_init[0], dict(solver_init[1], ProjectionLink='lwr_arm_7_link')))
+        with self.assertRaises(Exception):
+            solver.specify_problem(problem)
+        solver = exo.Setup.create_solver((solver_init[0], dict(solver_init[1], Projection=np.array([]), ProjectionLink='no_such_link')))
+        with self.assertRaises(Exception):
+            solver.specify_problem(problem)
+
+
+if __name__ == '__main__':
+    unittest.main()
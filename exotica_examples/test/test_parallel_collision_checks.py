@@ -0,0 +1,78 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+XML = '''<IKSolverDemoConfig>
+  <IKSolver Name="MySolver"/>
+  <UnconstrainedEndPoseProblem Name="MyProblem">
+    <PlanningScene>
+      <Scene>
+        <JointGroup>arm</JointGroup>
+        <URDF>{exotica_examples}/resources/robots/lwr_simplified.urdf</URDF>
+        <SRDF>{exotica_examples}/resources/robots/lwr_simplified.srdf</SRDF>
+        <CollisionScene>
+          <CollisionSceneFCLLatest Name="MyCollisionScene"/>
+        </CollisionScene>
+        <CollisionNumThreads>%d</CollisionNumThreads>
+      </Scene>
+    </PlanningScene>
+    <Maps>
+      <EffPosition Name="Position">
+        <EndEffector>
+          <Frame Link="lwr_arm_6_link"/>
+        </EndEffector>
+      </EffPosition>
+    </Maps>
+    <Cost>
+      <Task Task="Position"/>
+    </Cost>
+  </UnconstrainedEndPoseProblem>
+</IKSolverDemoConfig>'''
+
+
+def create_scene(num_threads):
+    _, problem_init = exo.Initializers.load_xml_full(XML % num_threads, parseAsXMLString=True)
+    problem = exo.Setup.create_problem(problem_init)
+    scene = problem.get_scene()
+    scene.add_object('Box', exo.KDLFrame([0.5, 0., 0.6]), '', exo.Box(0.3, 0.3, 0.3), update_collision_scene=True)
+    return problem, scene
+
+
+class ParallelCollisionChecksCase(unittest.TestCase):
+
+    def setUp(self):
+        # The problems have to stay alive as they own the scenes
+        self.serial_problem, self.serial_scene = create_scene(1)
+        self.parallel_problem, self.parallel_scene = create_scene(3)
+        np.random.seed(0)
+        self.states = np.random.uniform(-1.5, 1.5, (50, self.serial_problem.N))
+
+    def test_validity_matches_serial(self):
+        for stop_at_first_invalid in [False, True]:
+            serial = self.serial_scene.are_states_valid(self.states, check_self_collision=True, safe_distance=0.05, stop_at_first_invalid=stop_at_first_invalid)
+            parallel = self.parallel_scene.are_states_valid(self.states, check_self_collision=True, safe_distance=0.05, stop_at_first_invalid=stop_at_first_invalid)
+            self.assertEqual(serial, parallel)
+        # The box is placed such that the batch contains valid and invalid states
+        self.assertIn(True, serial)
+        self.assertIn(False, serial)
+
+    def test_distances_match_serial(self):
+        serial = self.serial_scene.get_minimum_collision_distances(self.states, check_self_collision=True, check_margin=0.5)
+        parallel = self.parallel_scene.get_minimum_collision_distances(self.states, check_self_collision=True, check_margin=0.5)
+        np.testing.assert_allclose(serial, parallel)
+
+    def test_clones_follow_the_world(self):
+        # Moving the box changes the world, so the clones checking the states have to be recreated
+        before = self.parallel_scene.get_minimum_collision_distances(self.states, check_self_collision=False)
+        for scene in [self.serial_scene, self.parallel_scene]:
+            scene.remove_object('Box')
+            scene.add_object('Box', exo.KDLFrame([0., 0.5, 0.6]), '', exo.Box(0.3, 0.3, 0.3), update_collision_scene=True)
+        serial = self.serial_scene.get_minimum_collision_distances(self.states, check_self_collision=False)
+        parallel = self.parallel_scene.get_minimum_collision_distances(self.states, check_self_collision=False)
+        np.testing.assert_allclose(serial, parallel)
+        self.assertFalse(np.allclose(before, parallel))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,62 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/example_ik.xml'
+SHOOTING_CONFIG = '{exotica_examples}/resources/configs/dynamic_time_indexed/18_ilqr_pendulum.xml'
+
+
+def create_pool(size):
+    solver_init, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    return exo.PipelinePool(solver_init, problem_init, size)
+
+
+class PipelinePoolCase(unittest.TestCase):
+
+    def test_acquire_and_release(self):
+        pool = create_pool(2)
+        self.assertEqual(pool.size, 2)
+        self.assertEqual(pool.num_available, 2)
+        first = pool.acquire()
+        second = pool.try_acquire()
+        self.assertIsNotNone(second)
+        self.assertEqual(pool.num_available, 0)
+        self.assertIsNone(pool.try_acquire())
+        del first
+        self.assertEqual(pool.num_available, 1)
+        del second
+        self.assertEqual(pool.num_available, 2)
+
+    def test_acquired_problems_are_reset(self):
+        pool = create_pool(1)
+        reference = pool.get_reference_problem()
+        goal = np.array([0.6, 0.4, 0.4, 0., 0., 0.])
+        reference.set_goal('Position', goal)
+
+        solver = pool.acquire()
+        problem = solver.get_problem()
+        np.testing.assert_allclose(problem.get_goal('Position'), goal)
+        # A request changes the goal, the start state and the iteration limit of its pipeline
+        problem.set_goal('Position', np.zeros(6))
+        problem.start_state = 0.1 * np.ones(7)
+        solver.max_iterations = 3
+        solver.solve()
+        del solver, problem
+
+        solver = pool.acquire()
+        problem = solver.get_problem()
+        np.testing.assert_allclose(problem.get_goal('Position'), goal)
+        np.testing.assert_allclose(problem.start_state, reference.start_state)
+        self.assertEqual(solver.max_iterations, 1)
+        self.assertEqual(problem.get_number_of_problem_updates(), 0)
+
+    def test_unsupported_problem(self):
+        solver_init, problem_init = exo.Initializers.load_xml_full(SHOOTING_CONFIG)
+        with self.assertRaises(Exception) as context:
+            exo.PipelinePool(solver_init, problem_init, 1)
+        self.assertIn('can not be pooled', str(context.exception))
+
+
+if __name__ == '__main__':
+    unittest.main()
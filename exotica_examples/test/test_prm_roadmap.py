@@ -0,0 +1,85 @@
+import os
+import shutil
+import struct
+import tempfile
+import unittest
+
+import numpy as np
+import pyexotica as exo
+from pyexotica import KDLFrame
+
+CONFIG = '{exotica_examples}/resources/configs/example_manipulate_ompl.xml'
+START = [1.5035205538438838, 0.8730168650583787, -1.6298590879018438, 1.7106630821349438, -0.8789956712153559, 0.1278222471656531, 0.0]
+GOAL = [-1.5035205538442702, 0.8730168650583671, 1.6298590879018415, 1.7106630821349786, 0.8789956712153525, 0.12782224716566898, 0.0]
+
+
+def setup(solver_type='PRMSolver'):
+    _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    problem = exo.Setup.create_problem(problem_init)
+    solver = exo.Setup.create_solver(('exotica/' + solver_type, {'Name': 'MySolver', 'Timeout': 10.0, 'MultiQuery': True}))
+    solver.specify_problem(problem)
+    problem.start_state = START
+    problem.goal_state = GOAL
+    return problem, solver
+
+
+class PRMRoadmapCase(unittest.TestCase):
+
+    def setUp(self):
+        # Each test writes its roadmaps into its own directory
+        self.directory = tempfile.mkdtemp()
+        self.filename = os.path.join(self.directory, 'roadmap.bin')
+
+    def tearDown(self):
+        shutil.rmtree(self.directory)
+
+    def check_solution(self, problem, solution):
+        np.testing.assert_allclose(solution[0], START, atol=1e-6)
+        np.testing.assert_allclose(solution[-1], GOAL, atol=1e-6)
+        for q in solution:
+            self.assertTrue(problem.is_state_valid(q))
+
+    def test_header_byte_order(self):
+        # The format version is stored in little-endian byte order after the magic
+        problem, solver = setup()
+        solver.solve()
+        solver.save_roadmap(self.filename)
+        with open(self.filename, 'rb') as f:
+            header = f.read(20)
+        self.assertEqual(header[:8], b'EXORMAP\0')
+        self.assertEqual(struct.unpack('<I', header[8:12])[0], 1)
+
+    def test_round_trip(self):
+        for solver_type in ['PRMSolver', 'LazyPRMSolver']:
+            problem, solver = setup(solver_type)
+            solver.solve()
+            solver.save_roadmap(self.filename)
+            problem, solver = setup(solver_type)
+            solver.load_roadmap(self.filename)
+            self.check_solution(problem, solver.solve())
+
+    def test_attached_object_changes_scene(self):
+        # The roadmap is grown without the item, attaching it to the end-effector invalidates milestones close to the obstacles.
+        # The attachment is part of the scene hash, i.e., the loaded roadmap is re-validated and the path avoids the item.
+        problem, solver = setup()
+        solver.solve()
+        solver.save_roadmap(self.filename)
+        for solver_type in ['PRMSolver', 'LazyPRMSolver']:
+            problem, solver = setup(solver_type)
+            problem.get_scene().attach_object_local('Item', 'lwr_arm_6_link', KDLFrame([0., 0., 0.1, 0., 0., 0., 1.]))
+            problem.get_scene().update(np.array(START))
+            if not problem.is_state_valid(np.array(START)) or not problem.is_state_valid(np.array(GOAL)):
+                continue
+            solver.load_roadmap(self.filename)
+            self.check_solution(problem, solver.solve())
+
+    def test_invalid_file(self):
+        problem, solver = setup()
+        with open(self.filename, 'wb') as f:
+            f.write(b'not a roadmap')
+        with self.assertRaises(Exception):
+            solver.load_roadmap(self.filename)
+
+
+if __name__ == '__main__':
+    unittest.main()
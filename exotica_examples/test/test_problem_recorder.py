@@ -0,0 +1,104 @@
+import gc
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+END_POSE_CONFIG = '{exotica_examples}/resources/configs/example_ik.xml'
+TIME_INDEXED_CONFIG = '{exotica_examples}/resources/configs/example_aico.xml'
+
+
+def create_problem(config):
+    _, problem_init = exo.Initializers.load_xml_full(config)
+    return exo.Setup.create_problem(problem_init)
+
+
+class ProblemRecorderCase(unittest.TestCase):
+
+    def setUp(self):
+        self.directory = tempfile.mkdtemp()
+        self.file_name = os.path.join(self.directory, 'problem.log')
+
+    def tearDown(self):
+        shutil.rmtree(self.directory)
+
+    def test_round_trip_end_pose(self):
+        problem = create_problem(END_POSE_CONFIG)
+        recorder = exo.ProblemRecorder(self.file_name)
+        problem.recorder = recorder
+        problem.start_state = 0.1 * np.ones(problem.N)
+        problem.set_goal('Position', np.array([0.5, 0.1, 0.5, 0., 0., 0.]))
+        problem.set_rho('Position', 2.0)
+        x = 0.2 * np.ones(problem.N)
+        problem.update(x)
+        # The first update is preceded by the planning scene
+        self.assertEqual(recorder.num_events, 5)
+        recorder.flush()
+
+        log = exo.ProblemLog(self.file_name)
+        self.assertEqual(log.problem_type, problem.type)
+        self.assertEqual(log.problem_dimension, problem.N)
+        self.assertEqual(len(log), 5)
+
+        replayed = create_problem(END_POSE_CONFIG)
+        durations = log.replay(replayed)
+        self.assertEqual(len(durations), 5)
+        self.assertTrue(all(duration >= 0. for duration in durations))
+        np.testing.assert_allclose(replayed.start_state, problem.start_state)
+        self.assertAlmostEqual(replayed.get_scalar_cost(), problem.get_scalar_cost())
+
+        # The type of the problem has to match
+        with self.assertRaises(Exception):
+            log.replay(create_problem(TIME_INDEXED_CONFIG))
+
+    def test_nested_updates_are_suppressed(self):
+        problem = create_problem(TIME_INDEXED_CONFIG)
+        recorder = exo.ProblemRecorder(self.file_name)
+        problem.recorder = recorder
+        problem.update(np.zeros(problem.N * problem.T))
+        # The planning scene and the trajectory, not the updates of its time steps
+        self.assertEqual(recorder.num_events, 2)
+        problem.update(np.zeros(problem.N), 1)
+        self.assertEqual(recorder.num_events, 3)
+        recorder.flush()
+        self.assertEqual(len(exo.ProblemLog(self.file_name)), 3)
+
+    def test_recorder_outlives_problem(self):
+        recorder = exo.ProblemRecorder(self.file_name)
+        problem = create_problem(END_POSE_CONFIG)
+        problem.recorder = recorder
+        problem.update(np.zeros(problem.N))
+        num_events = recorder.num_events
+        del problem
+        gc.collect()
+        recorder.flush()
+        self.assertEqual(recorder.num_events, num_events)
+
+        # A problem of the same type and dimension continues the log, others are rejected
+        problem = create_problem(END_POSE_CONFIG)
+        problem.recorder = recorder
+        problem.update(np.zeros(problem.N))
+        self.assertGreater(recorder.num_events, num_events)
+        with self.assertRaises(Exception):
+            create_problem(TIME_INDEXED_CONFIG).recorder = recorder
+
+        # Stopping the recording
+        problem.recorder = None
+        num_events = recorder.num_events
+        problem.update(np.zeros(problem.N))
+        self.assertEqual(recorder.num_events, num_events)
+        recorder.flush()
+        self.assertEqual(len(exo.ProblemLog(self.file_name)), num_events)
+
+    def test_invalid_log(self):
+        with open(self.file_name, 'wb') as f:
+            f.write(b'not a log')
+        with self.assertRaises(Exception):
+            exo.ProblemLog(self.file_name)
+
+
+if __name__ == '__main__':
+    unittest.main()
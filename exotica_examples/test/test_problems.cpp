@@ -29,12 +29,46 @@
 
 #include <exotica_core/exotica_core.h>
 #include <exotica_core/tools/test_helpers.h>
+#include <geometric_shapes/shapes.h>
 #include <gtest/gtest.h>
+#include <octomap/OcTree.h>
 
 using namespace exotica;
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
 #include <string>
+#include <thread>
 #include <vector>
 
+#ifdef __GLIBC__
+// Counts the heap allocations of the calling thread while enabled
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t num, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+static thread_local bool count_heap_allocations = false;
+static thread_local int num_heap_allocations = 0;
+extern "C" void* malloc(size_t size)
+{
+    if (count_heap_allocations) ++num_heap_allocations;
+    return __libc_malloc(size);
+}
+extern "C" void* calloc(size_t num, size_t size)
+{
+    if (count_heap_allocations) ++num_heap_allocations;
+    return __libc_calloc(num, size);
+}
+extern "C" void* realloc(void* ptr, size_t size)
+{
+    if (count_heap_allocations) ++num_heap_allocations;
+    return __libc_realloc(ptr, size);
+}
+#endif
+
 #define CREATE_PROBLEM(X, I) std::shared_ptr<X> problem = CreateProblem<X>(#X, I);
 #define NUM_TRIALS 100
 
@@ -241,6 +275,30 @@ void testHessianTimeIndexed(std::shared_ptr<T> problem, TimeIndexedTask& task, i
     TEST_COUT << "Test passed";
 }
 
+template <class T>
+void testEndPoseClone(std::shared_ptr<T> problem)
+{
+    TEST_COUT << "Testing problem clone";
+    const Eigen::VectorXd x = problem->GetStartState() + Eigen::VectorXd::Constant(problem->N, 0.1);
+    problem->SetStartState(x);
+    std::shared_ptr<T> clone = std::static_pointer_cast<T>(problem->Clone());
+    EXPECT_TRUE(clone->GetStartState().isApprox(x));
+    EXPECT_NE(clone->GetScene(), problem->GetScene());
+    problem->Update(x);
+    clone->Update(x);
+    EXPECT_NEAR(clone->GetScalarCost(), problem->GetScalarCost(), 1e-12);
+    EXPECT_TRUE(clone->cost.jacobian.isApprox(problem->cost.jacobian));
+
+    // Changes after cloning are copied by UpdateClone
+    problem->cost.rho *= 2.0;
+    problem->PreUpdate();
+    problem->UpdateClone(*clone);
+    problem->Update(x);
+    clone->Update(x);
+    EXPECT_NEAR(clone->GetScalarCost(), problem->GetScalarCost(), 1e-12);
+    TEST_COUT << "Test passed";
+}
+
 TEST(ExoticaProblems, UnconstrainedEndPoseProblem)
 {
     try
@@ -264,6 +322,25 @@ TEST(ExoticaProblems, UnconstrainedEndPoseProblem)
                 {
                     testHessianEndPose(problem, problem->cost);
                 }
+
+                TEST_COUT << "Testing fused update";
+                problem->Update(x);
+                const double cost = problem->GetScalarCost();
+                const Eigen::VectorXd Phi = problem->cost.Phi.data;
+                const Eigen::MatrixXd weighted_jacobian = problem->cost.S.diagonal().asDiagonal() * problem->cost.jacobian;
+                const Eigen::VectorXd JT_times_yd = weighted_jacobian.transpose() * problem->cost.S.diagonal().cwiseProduct(problem->cost.ydiff);
+                const Eigen::MatrixXd JT_times_J = weighted_jacobian.transpose() * weighted_jacobian;
+                problem->cost.Phi.data.setZero();
+                problem->cost.ydiff.setZero();
+                Eigen::VectorXd fused_JT_times_yd(problem->N);
+                Eigen::MatrixXd fused_JT_times_J(problem->N, problem->N);
+                EXPECT_NEAR(problem->UpdateFused(x, fused_JT_times_yd, fused_JT_times_J), cost, 1e-9);
+                EXPECT_NEAR(problem->GetScalarCost(), cost, 1e-9);
+                EXPECT_LT((problem->cost.Phi.data - Phi).norm(), 1e-9);
+                EXPECT_LT((problem->cost.ydiff - X[d]).norm(), 1e-9);
+                EXPECT_LT((fused_JT_times_yd - JT_times_yd).norm(), 1e-9);
+                EXPECT_LT((fused_JT_times_J - JT_times_J).norm(), 1e-9);
+                TEST_COUT << "Test passed";
             }
         }
         if (!(X[0] == X[1] && X[1] == X[2]))
@@ -387,6 +464,138 @@ TEST(ExoticaProblems, EndPoseProblem)
     }
 }
 
+TEST(ExoticaProblems, EndPoseProblemClone)
+{
+    try
+    {
+        {
+            CREATE_PROBLEM(UnconstrainedEndPoseProblem, 1);
+            testEndPoseClone(problem);
+        }
+        {
+            CREATE_PROBLEM(BoundedEndPoseProblem, 1);
+            testEndPoseClone(problem);
+        }
+        {
+            CREATE_PROBLEM(EndPoseProblem, 1);
+            testEndPoseClone(problem);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaProblems, EndPoseProblemMultiStart)
+{
+    try
+    {
+        CREATE_PROBLEM(UnconstrainedEndPoseProblem, 1);
+        MotionSolverPtr solver = Setup::CreateSolver(Initializer("exotica/IKSolver", {
+                                                                                         {"Name", std::string("MultiStartSolver")},
+                                                                                         {"MaxIterations", 100},
+                                                                                         {"MultiStartNumThreads", 2},
+                                                                                     }));
+        solver->SpecifyProblem(problem);
+        std::vector<Eigen::VectorXd> seeds(4);
+        for (int i = 0; i < 4; ++i) seeds[i] = problem->GetStartState() + Eigen::VectorXd::Constant(problem->N, 0.3 * i);
+
+        // Lowest cost when solving from each of the seeds
+        double lowest_cost = std::numeric_limits<double>::infinity();
+        const Eigen::VectorXd start_state = problem->GetStartState();
+        for (const Eigen::VectorXd& seed : seeds)
+        {
+            Eigen::MatrixXd solution;
+            problem->SetStartState(seed);
+            solver->Solve(solution);
+            problem->Update(solution.row(0).transpose());
+            lowest_cost = std::min(lowest_cost, problem->GetScalarCost());
+        }
+        problem->SetStartState(start_state);
+
+        for (int num_threads : {1, 2})
+        {
+            solver->SetMultiStartNumThreads(num_threads);
+            Eigen::MatrixXd solution;
+            solver->SolveMultiStart(seeds, solution);
+            ASSERT_EQ(solution.cols(), problem->N);
+            EXPECT_TRUE(problem->GetStartState().isApprox(start_state));
+
+            // The problem is updated at the returned solution, which is the best one unless the seeds were stopped early
+            const double cost = problem->GetScalarCost();
+            problem->Update(solution.row(0).transpose());
+            EXPECT_EQ(cost, problem->GetScalarCost());
+            if (problem->termination_criterion != TerminationCriterion::FunctionTolerance) EXPECT_LE(cost, lowest_cost + 1e-9);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaProblems, EndPoseProblemBatch)
+{
+    try
+    {
+        CREATE_PROBLEM(UnconstrainedEndPoseProblem, 1);
+        MotionSolverPtr solver = Setup::CreateSolver(Initializer("exotica/IKSolver", {
+                                                                                         {"Name", std::string("BatchSolver")},
+                                                                                         {"MaxIterations", 100},
+                                                                                     }));
+        solver->SpecifyProblem(problem);
+        const Eigen::VectorXd start_state = problem->GetStartState();
+        std::vector<Eigen::VectorXd> seeds(3);
+        for (int i = 0; i < 3; ++i) seeds[i] = start_state + Eigen::VectorXd::Constant(problem->N, 0.3 * i);
+
+        std::map<std::string, Eigen::VectorXd> goals;
+        for (const TaskMapPtr& task : problem->cost.tasks) goals[task->GetObjectName()] = problem->GetGoal(task->GetObjectName());
+
+        // The first targets are the poses at the seeds and hence reachable, the last one is out of reach
+        std::vector<std::map<std::string, Eigen::VectorXd>> targets(4);
+        for (int i = 0; i < 3; ++i)
+        {
+            problem->Update(seeds[i]);
+            for (std::size_t t = 0; t < problem->cost.tasks.size(); ++t)
+                targets[i][problem->cost.tasks[t]->GetObjectName()] = problem->cost.Phi.data.segment(problem->cost.indexing[t].start, problem->cost.indexing[t].length);
+        }
+        const std::string position_task = problem->cost.tasks[0]->GetObjectName();
+        targets[3][position_task] = Eigen::VectorXd::Constant(goals[position_task].rows(), 10.0);
+
+        for (int num_threads : {1, 2})
+        {
+            solver->SetMultiStartNumThreads(num_threads);
+            std::vector<Eigen::VectorXd> solutions;
+            std::vector<bool> success;
+            solver->SolveBatch(targets, seeds, solutions, success);
+            ASSERT_EQ(solutions.size(), targets.size());
+            ASSERT_EQ(success.size(), targets.size());
+            EXPECT_TRUE(problem->GetStartState().isApprox(start_state));
+            for (const auto& goal : goals) EXPECT_TRUE(problem->GetGoal(goal.first).isApprox(goal.second));
+
+            EXPECT_TRUE(success[0]);
+            EXPECT_TRUE(success[1]);
+            EXPECT_TRUE(success[2]);
+            EXPECT_FALSE(success[3]);
+
+            // Each solution reaches its own target
+            for (std::size_t i = 0; i < targets.size(); ++i)
+            {
+                ASSERT_EQ(solutions[i].rows(), problem->N);
+                for (const auto& goal : targets[i]) problem->SetGoal(goal.first, goal.second);
+                problem->Update(solutions[i]);
+                if (success[i]) EXPECT_LT(problem->GetScalarCost(), 1e-5) << "Target " << i;
+                for (const auto& goal : goals) problem->SetGoal(goal.first, goal.second);
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
 TEST(ExoticaProblems, UnconstrainedTimeIndexedProblem)
 {
     try
@@ -557,6 +766,428 @@ TEST(ExoticaProblems, TimeIndexedProblem)
     }
 }
 
+TEST(ExoticaProblems, TimeIndexedProblemStructuredDerivatives)
+{
+    try
+    {
+        CREATE_PROBLEM(TimeIndexedProblem, 2);
+        const int T = problem->GetT();
+        const int N = problem->N;
+        const double h = 1e-6;
+        for (int k = 0; k < 10; ++k)
+        {
+            Eigen::VectorXd x_trajectory((T - 1) * N);
+            for (int t = 1; t < T; ++t) x_trajectory.segment((t - 1) * N, N) = problem->GetScene()->GetKinematicTree().GetRandomControlledState();
+            problem->Update(x_trajectory);
+
+            const Eigen::SparseMatrix<double>& equality_jacobian = problem->GetEqualityJacobianStructured();
+            const int* pattern = equality_jacobian.innerIndexPtr();
+            if (!equality_jacobian.toDense().isApprox(problem->GetEqualityJacobian().toDense())) ADD_FAILURE() << "Structured equality Jacobian is inconsistent!";
+            if (!problem->GetInequalityJacobianStructured().toDense().isApprox(problem->GetInequalityJacobian().toDense())) ADD_FAILURE() << "Structured inequality Jacobian is inconsistent!";
+            EXPECT_EQ(pattern, problem->GetEqualityJacobianStructured().innerIndexPtr());
+
+            // Hessian of the cost against finite differences of the cost Jacobian
+            const Eigen::MatrixXd hessian = problem->GetCostHessianStructured().toDense();
+            const Eigen::RowVectorXd jacobian = problem->GetCostJacobian();
+            Eigen::MatrixXd hessian_fd(hessian.rows(), hessian.cols());
+            for (int i = 0; i < x_trajectory.size(); ++i)
+            {
+                Eigen::VectorXd x_perturbed = x_trajectory;
+                x_perturbed(i) += h;
+                problem->Update(x_perturbed);
+                hessian_fd.col(i) = (problem->GetCostJacobian() - jacobian).transpose() / h;
+            }
+            const double error = (hessian - hessian_fd).norm();
+            if (error > 1e-3 * std::max(1.0, hessian.norm())) ADD_FAILURE() << "Cost Hessian error out of bounds: " << error;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaProblems, TimeIndexedProblemHessianVectorProduct)
+{
+    try
+    {
+        CREATE_PROBLEM(TimeIndexedProblem, 2);
+        const int T = problem->GetT();
+        const int N = problem->N;
+        for (int k = 0; k < 10; ++k)
+        {
+            Eigen::VectorXd x_trajectory((T - 1) * N);
+            for (int t = 1; t < T; ++t) x_trajectory.segment((t - 1) * N, N) = problem->GetScene()->GetKinematicTree().GetRandomControlledState();
+            problem->Update(x_trajectory);
+
+            // Matrix-free product against the product with the assembled Hessian
+            const Eigen::SparseMatrix<double>& hessian = problem->GetCostHessianStructured();
+            const Eigen::VectorXd v = Eigen::VectorXd::Random(x_trajectory.size());
+            const Eigen::VectorXd hv = hessian * v;
+            const double error = (problem->GetCostHessianVectorProduct(v) - hv).norm();
+            if (error > 1e-9 * std::max(1.0, hv.norm())) ADD_FAILURE() << "Hessian-vector product error out of bounds: " << error;
+
+            Eigen::VectorXd hv_in_place = Eigen::VectorXd::Constant(x_trajectory.size(), std::numeric_limits<double>::quiet_NaN());
+            problem->GetCostHessianVectorProduct(v, hv_in_place);
+            if ((hv_in_place - hv).norm() > 1e-9 * std::max(1.0, hv.norm())) ADD_FAILURE() << "In-place Hessian-vector product is inconsistent!";
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaProblems, TimeIndexedProblemTrajectoryUpdate)
+{
+    try
+    {
+        CREATE_PROBLEM(UnconstrainedTimeIndexedProblem, 1);
+        const int T = problem->GetT();
+        const int N = problem->N;
+        for (int k = 0; k < NUM_TRIALS; ++k)
+        {
+            Eigen::VectorXd x_trajectory((T - 1) * N);
+            for (int t = 1; t < T; ++t) x_trajectory.segment((t - 1) * N, N) = problem->GetScene()->GetKinematicTree().GetRandomControlledState();
+
+            // Kinematics of the whole trajectory in one pass
+            problem->Update(x_trajectory);
+            std::vector<Eigen::VectorXd> ydiff(T);
+            std::vector<Eigen::MatrixXd> jacobian(T);
+            for (int t = 1; t < T; ++t)
+            {
+                ydiff[t] = problem->cost.ydiff[t];
+                jacobian[t] = problem->cost.jacobian[t];
+            }
+
+            // Time step by time step
+            for (int t = 1; t < T; ++t)
+            {
+                problem->Update(x_trajectory.segment((t - 1) * N, N), t);
+                if (!ydiff[t].isApprox(problem->cost.ydiff[t])) ADD_FAILURE() << "Trajectory update FK is inconsistent at t=" << t;
+                if (!jacobian[t].isApprox(problem->cost.jacobian[t])) ADD_FAILURE() << "Trajectory update Jacobian is inconsistent at t=" << t;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaProblems, TimeIndexedProblemParallelTrajectoryUpdate)
+{
+    try
+    {
+        CREATE_PROBLEM(UnconstrainedTimeIndexedProblem, 1);
+        const int T = problem->GetT();
+        const int N = problem->N;
+        for (int k = 0; k < NUM_TRIALS; ++k)
+        {
+            Eigen::VectorXd x_trajectory((T - 1) * N);
+            for (int t = 1; t < T; ++t) x_trajectory.segment((t - 1) * N, N) = problem->GetScene()->GetKinematicTree().GetRandomControlledState();
+
+            problem->SetTrajectoryNumThreads(1);
+            problem->Update(x_trajectory);
+            const double cost = problem->GetCost();
+            const Eigen::RowVectorXd cost_jacobian = problem->GetCostJacobian();
+
+            // Blocks of time steps on clones of the scene and the task maps
+            problem->SetTrajectoryNumThreads(3);
+            problem->Update(x_trajectory);
+            if (std::abs(cost - problem->GetCost()) > 1e-9) ADD_FAILURE() << "Parallel trajectory update cost is inconsistent: " << cost << " vs " << problem->GetCost();
+            if (!cost_jacobian.isApprox(problem->GetCostJacobian())) ADD_FAILURE() << "Parallel trajectory update cost Jacobian is inconsistent!";
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaProblems, TimeIndexedProblemSkipUnchangedTimeSteps)
+{
+    try
+    {
+        CREATE_PROBLEM(UnconstrainedTimeIndexedProblem, 1);
+        const int T = problem->GetT();
+        const int N = problem->N;
+        problem->SetSkipUnchangedTimeSteps(true);
+        Eigen::VectorXd x_trajectory((T - 1) * N);
+        for (int t = 1; t < T; ++t) x_trajectory.segment((t - 1) * N, N) = problem->GetScene()->GetKinematicTree().GetRandomControlledState();
+        problem->Update(x_trajectory);
+        EXPECT_EQ(problem->GetNumberOfRecomputedTimeSteps(), T - 1);
+        problem->Update(x_trajectory);
+        EXPECT_EQ(problem->GetNumberOfRecomputedTimeSteps(), 0);
+
+        // Changing the state of time step t invalidates t and t + 1
+        const int t_changed = T / 2;
+        x_trajectory.segment((t_changed - 1) * N, N) = problem->GetScene()->GetKinematicTree().GetRandomControlledState();
+        problem->Update(x_trajectory);
+        EXPECT_EQ(problem->GetNumberOfRecomputedTimeSteps(), 2);
+        const double cost = problem->GetCost();
+        const Eigen::RowVectorXd cost_jacobian = problem->GetCostJacobian();
+
+        problem->InvalidateTimeSteps();
+        problem->Update(x_trajectory);
+        EXPECT_EQ(problem->GetNumberOfRecomputedTimeSteps(), T - 1);
+        if (std::abs(cost - problem->GetCost()) > 1e-9) ADD_FAILURE() << "Cost of skipped time steps is inconsistent: " << cost << " vs " << problem->GetCost();
+        if (!cost_jacobian.isApprox(problem->GetCostJacobian())) ADD_FAILURE() << "Cost Jacobian of skipped time steps is inconsistent!";
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaProblems, TimeIndexedProblemShiftTrajectory)
+{
+    try
+    {
+        CREATE_PROBLEM(UnconstrainedTimeIndexedProblem, 1);
+        const int T = problem->GetT();
+        const int N = problem->N;
+        const int k = 2;
+        Eigen::VectorXd x_trajectory((T - 1) * N);
+        for (int t = 1; t < T; ++t) x_trajectory.segment((t - 1) * N, N) = problem->GetScene()->GetKinematicTree().GetRandomControlledState();
+        problem->Update(x_trajectory);
+        const Eigen::VectorXd start_state = problem->GetStartState();
+
+        // The shifted trajectory becomes the initial trajectory, the first state is shifted as well but the start state is kept
+        problem->ShiftTrajectory(k);
+        const std::vector<Eigen::VectorXd> shifted_trajectory = problem->GetInitialTrajectory();
+        if (!shifted_trajectory[0].isApprox(x_trajectory.segment((k - 1) * N, N))) ADD_FAILURE() << "Shifted first state is inconsistent!";
+        if (!problem->GetStartState().isApprox(start_state)) ADD_FAILURE() << "Start state was changed by the shift!";
+        for (int t = 1; t < T - k; ++t)
+        {
+            if (!shifted_trajectory[t].isApprox(x_trajectory.segment((t + k - 1) * N, N))) ADD_FAILURE() << "Shifted state is inconsistent at t=" << t;
+        }
+        const double cost = problem->GetCost();
+        const Eigen::RowVectorXd cost_jacobian = problem->GetCostJacobian();
+
+        Eigen::VectorXd x_shifted((T - 1) * N);
+        for (int t = 1; t < T; ++t) x_shifted.segment((t - 1) * N, N) = shifted_trajectory[t];
+        problem->Update(x_shifted);
+        if (std::abs(cost - problem->GetCost()) > 1e-9) ADD_FAILURE() << "Cost of the shifted trajectory is inconsistent: " << cost << " vs " << problem->GetCost();
+        if (!cost_jacobian.isApprox(problem->GetCostJacobian())) ADD_FAILURE() << "Cost Jacobian of the shifted trajectory is inconsistent!";
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaProblems, TimeIndexedProblemSetResolution)
+{
+    try
+    {
+        CREATE_PROBLEM(UnconstrainedTimeIndexedProblem, 1);
+        const int T = problem->GetT();
+        const double tau = problem->GetTau();
+        const int T_coarse = (T - 1) / 2 + 1;
+
+        // Distinct goals and weights for every time step
+        std::vector<Eigen::VectorXd> goals(T);
+        for (int t = 0; t < T; ++t)
+        {
+            goals[t] = Eigen::VectorXd::Random(3);
+            problem->SetGoal("Position", goals[t], t);
+            problem->SetRho("Position", 1.0 + t, t);
+        }
+
+        problem->SetResolution(T_coarse);
+        EXPECT_EQ(problem->GetT(), T_coarse);
+        EXPECT_NEAR(problem->GetTau() * (T_coarse - 1), tau * (T - 1), 1e-9);
+        EXPECT_EQ(static_cast<int>(problem->GetInitialTrajectory().size()), T_coarse);
+        for (int t = 0; t < T_coarse; ++t)
+        {
+            const int s = GetNearestTimeStep(t, T, T_coarse);
+            EXPECT_TRUE(problem->GetGoal("Position", t) == goals[s]) << "Goal of time step " << t << " is not the one of time step " << s;
+            EXPECT_EQ(problem->GetRho("Position", t), 1.0 + s);
+        }
+
+        // Returning to the original resolution restores the original time step, goals and weights exactly
+        problem->SetResolution(T);
+        EXPECT_EQ(problem->GetT(), T);
+        EXPECT_EQ(problem->GetTau(), tau);
+        EXPECT_EQ(static_cast<int>(problem->GetInitialTrajectory().size()), T);
+        for (int t = 0; t < T; ++t)
+        {
+            EXPECT_TRUE(problem->GetGoal("Position", t) == goals[t]);
+            EXPECT_EQ(problem->GetRho("Position", t), 1.0 + t);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+#ifdef __GLIBC__
+TEST(ExoticaProblems, AllocationFreeCostEvaluation)
+{
+    try
+    {
+        {
+            CREATE_PROBLEM(UnconstrainedTimeIndexedProblem, 1);
+            const int T = problem->GetT();
+            const int N = problem->N;
+            Eigen::VectorXd x_trajectory((T - 1) * N);
+            for (int t = 1; t < T; ++t) x_trajectory.segment((t - 1) * N, N) = problem->GetScene()->GetKinematicTree().GetRandomControlledState();
+            problem->Update(x_trajectory);
+
+            Eigen::RowVectorXd task_jacobian(N), transition_jacobian(N), cost_jacobian(N * (T - 1));
+            double cost = 0.0;
+            count_heap_allocations = true;
+            num_heap_allocations = 0;
+            for (int k = 0; k < NUM_TRIALS; ++k)
+            {
+                for (int t = 1; t < T; ++t)
+                {
+                    problem->cost.Update(problem->Phi[t], problem->jacobian[t], t);
+                    cost += problem->GetScalarTaskCost(t) + problem->GetScalarTransitionCost(t);
+                    problem->GetScalarTaskJacobian(t, task_jacobian);
+                    problem->GetScalarTransitionJacobian(t, transition_jacobian);
+                }
+                problem->GetCostJacobian(cost_jacobian);
+            }
+            count_heap_allocations = false;
+            EXPECT_EQ(num_heap_allocations, 0) << "Time-indexed cost evaluation allocated " << num_heap_allocations << " times";
+            EXPECT_GE(cost, 0.0);
+            EXPECT_TRUE(cost_jacobian.isApprox(problem->GetCostJacobian()));
+            EXPECT_TRUE(task_jacobian.isApprox(problem->GetScalarTaskJacobian(T - 1)));
+            EXPECT_TRUE(transition_jacobian.isApprox(problem->GetScalarTransitionJacobian(T - 1)));
+        }
+
+        {
+            CREATE_PROBLEM(UnconstrainedEndPoseProblem, 1);
+            problem->Update(problem->GetScene()->GetKinematicTree().GetRandomControlledState());
+
+            Eigen::RowVectorXd jacobian(problem->N);
+            double cost = 0.0;
+            count_heap_allocations = true;
+            num_heap_allocations = 0;
+            for (int k = 0; k < NUM_TRIALS; ++k)
+            {
+                problem->cost.Update(problem->Phi, problem->jacobian);
+                cost += problem->GetScalarCost();
+                problem->GetScalarJacobian(jacobian);
+            }
+            count_heap_allocations = false;
+            EXPECT_EQ(num_heap_allocations, 0) << "End-pose cost evaluation allocated " << num_heap_allocations << " times";
+            EXPECT_GE(cost, 0.0);
+            EXPECT_TRUE(jacobian.isApprox(problem->GetScalarJacobian()));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+#endif
+
+TEST(ExoticaProblems, IterationTelemetry)
+{
+    try
+    {
+        CREATE_PROBLEM(UnconstrainedEndPoseProblem, 0);
+        const int num_iterations = 10;
+        const std::uint64_t count_before = problem->GetIterationTelemetry().GetNumberOfRecords();
+        problem->ResetCostEvolution(num_iterations);
+        std::vector<IterationRecord> records;
+        std::uint64_t count = problem->GetIterationTelemetry().Read(0, records);
+        EXPECT_EQ(count, count_before);
+
+        // Records pushed while another thread polls the telemetry
+        std::atomic<bool> solving(true);
+        std::vector<IterationRecord> polled_records;
+        std::thread monitor([&]() {
+            std::uint64_t polled_count = count;
+            while (solving.load()) polled_count = problem->GetIterationTelemetry().Read(polled_count, polled_records);
+            problem->GetIterationTelemetry().Read(polled_count, polled_records);
+        });
+        for (int i = 0; i < num_iterations; ++i)
+        {
+            IterationRecord record;
+            record.cost = 1.0 / (i + 1);
+            record.step_length = 0.5;
+            problem->SetCostEvolution(i, record);
+        }
+        solving.store(false);
+        monitor.join();
+
+        ASSERT_EQ(static_cast<int>(polled_records.size()), num_iterations);
+        for (int i = 0; i < num_iterations; ++i)
+        {
+            EXPECT_EQ(polled_records[i].iteration, i);
+            EXPECT_EQ(polled_records[i].cost, problem->GetCostEvolution(i));
+            EXPECT_EQ(polled_records[i].step_length, 0.5);
+            EXPECT_TRUE(std::isnan(polled_records[i].regularization));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaProblems, TrajectoryFile)
+{
+    try
+    {
+        const std::string file_name = CreateTemporaryFile("exotica_test_trajectory_file");
+        const std::vector<std::string> joint_names = {"joint_1", "joint_2", "joint_3"};
+        const Eigen::MatrixXd states = Eigen::MatrixXd::Random(10, 3);
+        const Eigen::MatrixXd controls = Eigen::MatrixXd::Random(9, 2);
+        {
+            TrajectoryFileWriter writer(file_name, joint_names, 0.1, 2);
+            writer.Write(states, controls);
+            writer.Write(states.topRows(5), controls.topRows(4));
+            EXPECT_THROW(writer.Write(states), std::exception);
+            EXPECT_THROW(writer.Write(states, Eigen::MatrixXd(0, 2)), std::exception);
+            EXPECT_EQ(writer.GetNumberOfTrajectories(), 2u);
+        }
+
+        TrajectoryFileReader reader(file_name);
+        EXPECT_TRUE(reader.GetJointNames() == joint_names);
+        EXPECT_EQ(reader.GetTimeStep(), 0.1);
+        EXPECT_EQ(reader.GetNumberOfControls(), 2);
+        ASSERT_EQ(reader.GetNumberOfTrajectories(), 2u);
+        EXPECT_TRUE(reader.GetStates(0) == states);
+        EXPECT_TRUE(reader.GetControls(0) == controls);
+        EXPECT_TRUE(reader.GetStates(1) == states.topRows(5));
+        EXPECT_TRUE(reader.GetControls(1) == controls.topRows(4));
+        EXPECT_THROW(reader.GetStates(2), std::exception);
+
+        {
+            TrajectoryFileWriter writer(file_name, joint_names, 0.1);
+            EXPECT_THROW(writer.Write(states, controls), std::exception);
+        }
+
+        // Readers reject invalid headers: the joint count follows the magic, version and byte order, then come the
+        // three joint names (each a length and 8 padded characters), the time step and the number of controls
+        std::ifstream file(file_name, std::ios::binary);
+        const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        file.close();
+        auto expect_read_fails = [&file_name](std::string corrupt_data, std::size_t position, const void* value, std::size_t size) {
+            corrupt_data.replace(position, size, reinterpret_cast<const char*>(value), size);
+            std::ofstream(file_name, std::ios::binary) << corrupt_data;
+            EXPECT_THROW(TrajectoryFileReader reader(file_name), std::exception);
+        };
+        const char wrong_magic = 'X';
+        expect_read_fails(data, 0, &wrong_magic, 1);
+        for (const uint64_t num_joints : {uint64_t(0), uint64_t(1) << 40, uint64_t(-1)}) expect_read_fails(data, 24, &num_joints, 8);
+        for (const double dt : {0.0, -0.1, std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity()}) expect_read_fails(data, 80, &dt, 8);
+        const uint64_t num_controls = uint64_t(1) << 40;
+        expect_read_fails(data, 88, &num_controls, 8);
+        std::remove(file_name.c_str());
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
 TEST(ExoticaProblems, SamplingProblem)
 {
     try
@@ -574,6 +1205,125 @@ TEST(ExoticaProblems, SamplingProblem)
     }
 }
 
+TEST(ExoticaProblems, SamplingProblemBatchValidity)
+{
+    try
+    {
+        CREATE_PROBLEM(SamplingProblem, 0);
+        ScenePtr scene = problem->GetScene();
+        Eigen::MatrixXd states(NUM_TRIALS, problem->N);
+        for (int i = 0; i < NUM_TRIALS; ++i) states.row(i) = scene->GetKinematicTree().GetRandomControlledState().transpose();
+
+        TEST_COUT << "Testing batch validity against single states";
+        const std::vector<bool> valid = problem->AreStatesValid(states, false);
+        const std::vector<bool> collision_free = scene->AreStatesValid(states);
+        ASSERT_EQ(static_cast<int>(valid.size()), NUM_TRIALS);
+        ASSERT_EQ(static_cast<int>(collision_free.size()), NUM_TRIALS);
+        int first_invalid = NUM_TRIALS;
+        for (int i = 0; i < NUM_TRIALS; ++i)
+        {
+            EXPECT_EQ(valid[i], problem->IsStateValid(states.row(i).transpose()));
+            EXPECT_EQ(collision_free[i], scene->GetCollisionScene()->IsStateValid());
+            if (!valid[i] && first_invalid == NUM_TRIALS) first_invalid = i;
+        }
+
+        TEST_COUT << "Testing early termination";
+        const std::vector<bool> valid_until_first_invalid = problem->AreStatesValid(states, true);
+        for (int i = 0; i < NUM_TRIALS; ++i) EXPECT_EQ(valid_until_first_invalid[i], i < first_invalid);
+
+        TEST_COUT << "Testing parallel batch validity";
+        problem->SetValidityNumThreads(3);
+        EXPECT_TRUE(problem->AreStatesValid(states, false) == valid);
+        EXPECT_TRUE(problem->AreStatesValid(states, true) == valid_until_first_invalid);
+        problem->SetValidityNumThreads(1);
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaProblems, SceneUpdateOctree)
+{
+    try
+    {
+        CREATE_PROBLEM(SamplingProblem, 0);
+        ScenePtr scene = problem->GetScene();
+        scene->Update(problem->GetStartState());
+
+        // An octree in the world frame with one leaf far away from the robot
+        std::shared_ptr<octomap::OcTree> octree = std::make_shared<octomap::OcTree>(0.05);
+        octree->updateNode(2.0, 2.0, 2.0, true);
+        scene->AddObject("Octree", KDL::Frame(), "", std::make_shared<shapes::OcTree>(octree));
+        scene->GetCollisionScene()->UpdateCollisionObjectTransforms();
+        EXPECT_TRUE(scene->GetCollisionScene()->IsStateValid(false));
+
+        int num_world_changes = 0;
+        const int handle = scene->AddChangeListener([&num_world_changes](SceneChange) { ++num_world_changes; }, SCENE_CHANGE_WORLD);
+        const int world_version = scene->GetWorldVersion();
+
+        TEST_COUT << "Testing that occupying a leaf at a link changes the world";
+        const KDL::Frame link_pose = scene->GetKinematicTree().FK("lwr_arm_6_link", KDL::Frame(), "", KDL::Frame());
+        scene->UpdateOctree("Octree", {Eigen::Vector3d(link_pose.p.x(), link_pose.p.y(), link_pose.p.z())});
+        EXPECT_GT(scene->GetWorldVersion(), world_version);
+        EXPECT_EQ(num_world_changes, 1);
+        EXPECT_FALSE(scene->GetCollisionScene()->IsStateValid(false));
+
+        TEST_COUT << "Testing that freeing the leaf changes the world again";
+        scene->UpdateOctree("Octree", {}, {Eigen::Vector3d(link_pose.p.x(), link_pose.p.y(), link_pose.p.z())});
+        EXPECT_EQ(num_world_changes, 2);
+        EXPECT_TRUE(scene->GetCollisionScene()->IsStateValid(false));
+        scene->RemoveChangeListener(handle);
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
+TEST(ExoticaProblems, SceneRayCastOctree)
+{
+    try
+    {
+        CREATE_PROBLEM(SamplingProblem, 0);
+        ScenePtr scene = problem->GetScene();
+        scene->Update(problem->GetStartState());
+
+        // Two leaves of 0.1 m along the x-axis, the nearer one is hit first
+        std::shared_ptr<octomap::OcTree> octree = std::make_shared<octomap::OcTree>(0.1);
+        octree->updateNode(3.05, 0.05, 0.05, true);
+        octree->updateNode(4.05, 0.05, 0.05, true);
+        scene->AddObject("Octree", KDL::Frame(), "", std::make_shared<shapes::OcTree>(octree));
+
+        Eigen::Matrix3Xd origins(3, 3), directions(3, 3);
+        origins << -1.0, 3.5, -1.0,
+            0.05, 0.05, 0.15,
+            0.05, 0.05, 0.05;
+        directions << 1.0, 1.0, 1.0,
+            0.0, 0.0, 0.0,
+            0.0, 0.0, 0.0;
+        TEST_COUT << "Testing rays against the occupied leaves";
+        Eigen::VectorXd distances = scene->GetCollisionScene()->RayCast(origins, directions);
+        EXPECT_NEAR(distances(0), 4.0, 1e-9);
+        EXPECT_NEAR(distances(1), 0.5, 1e-9);
+        EXPECT_TRUE(std::isinf(distances(2)));
+
+        TEST_COUT << "Testing that hits beyond the maximum distance are ignored";
+        distances = scene->GetCollisionScene()->RayCast(origins, directions, 3.0);
+        EXPECT_TRUE(std::isinf(distances(0)));
+        EXPECT_NEAR(distances(1), 0.5, 1e-9);
+
+        TEST_COUT << "Testing that freed leaves are not hit";
+        scene->UpdateOctree("Octree", {}, {Eigen::Vector3d(3.05, 0.05, 0.05)});
+        distances = scene->GetCollisionScene()->RayCast(origins, directions);
+        EXPECT_NEAR(distances(0), 5.0, 1e-9);
+    }
+    catch (const std::exception& e)
+    {
+        ADD_FAILURE() << "Uncaught exception! " << e.what();
+    }
+}
+
 TEST(ExoticaProblems, TimeIndexedSamplingProblem)
 {
     try
@@ -0,0 +1,50 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/example_ik.xml'
+BOUND = 0.2
+
+
+def setup(**options):
+    _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    N = 7
+    problem = exo.Setup.create_problem(('exotica/BoundedEndPoseProblem', dict(problem_init[1], LowerBound=-BOUND * np.ones(N), UpperBound=BOUND * np.ones(N))))
+    # A goal outside of the joint limits keeps the bounds active
+    problem.set_goal('Position', np.array([0.6, 0.4, 0.4, 0., 0., 0.]))
+    solver = exo.Setup.create_solver(('exotica/QPIKSolver', dict({'Name': 'MySolver', 'MaxIterations': 20}, **options)))
+    solver.specify_problem(problem)
+    return problem, solver
+
+
+class QPIKSolverCase(unittest.TestCase):
+
+    def test_joint_limits(self):
+        _, solver = setup()
+        solution = solver.solve()[0]
+        self.assertTrue(np.all(np.abs(solution) <= BOUND + 1e-6))
+
+    def test_unconverged_qp_respects_joint_limits(self):
+        # A single ADMM iteration does not converge, the step has to be clamped to the bounds
+        for warm_start in [True, False]:
+            problem, solver = setup(QPMaxIterations=1, WarmStart=warm_start)
+            solution = solver.solve()[0]
+            self.assertTrue(np.all(np.isfinite(solution)))
+            self.assertTrue(np.all(np.abs(solution) <= BOUND + 1e-9))
+
+    def test_unconverged_qp_respects_max_step(self):
+        problem, solver = setup(QPMaxIterations=1, MaxStep=0.05, MaxIterations=1)
+        solution = solver.solve()[0]
+        self.assertTrue(np.all(np.abs(solution - problem.start_state) <= 0.05 + 1e-9))
+
+    def test_unconverged_qp_decreases_cost(self):
+        # The clamped steps still descend, i.e., the solver makes progress with a QP that never converges
+        problem, solver = setup(QPMaxIterations=1)
+        solver.solve()
+        costs = problem.get_cost_evolution()[1]
+        self.assertLess(costs[-1], costs[0])
+
+
+if __name__ == '__main__':
+    unittest.main()
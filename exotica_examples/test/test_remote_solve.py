@@ -0,0 +1,92 @@
+import os
+import shutil
+import tempfile
+import threading
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/example_ik.xml'
+GOALS = [np.array([0.5, 0.1 * i, 0.5, 0., 0., 0.]) for i in range(4)]
+
+
+def solve_locally(start_state, goal):
+    solver = exo.Setup.load_solver(CONFIG)
+    problem = solver.get_problem()
+    problem.start_state = start_state
+    problem.set_goal('Position', goal)
+    return solver.solve()
+
+
+def make_request(start_state, goal):
+    request = exo.RemoteSolveRequest()
+    request.start_state = start_state
+    request.task_goals = {'Position': goal}
+    return request
+
+
+class RemoteSolveCase(unittest.TestCase):
+
+    def setUp(self):
+        self.directory = tempfile.mkdtemp()
+        self.url = 'ipc://' + os.path.join(self.directory, 'remote_solve')
+        self.server = exo.RemoteSolveServer(self.url, 2)
+        self.thread = None
+
+    def tearDown(self):
+        if self.thread is not None:
+            self.server.stop()
+            self.thread.join()
+        shutil.rmtree(self.directory)
+
+    def run_server(self):
+        self.thread = threading.Thread(target=self.server.run)
+        self.thread.start()
+
+    def test_round_trip(self):
+        self.server.add_configuration(CONFIG)
+        self.run_server()
+        client = exo.RemoteSolveClient([self.url], CONFIG, 10000)
+
+        start_state = 0.1 * np.ones(7)
+        result = client.solve(make_request(start_state, GOALS[1]))
+        self.assertTrue(result.success, result.error)
+        np.testing.assert_allclose(result.solution, solve_locally(start_state, GOALS[1]))
+        self.assertGreaterEqual(result.planning_time, 0.)
+
+    def test_shipped_configuration(self):
+        # The server only learns the configuration from the first request of the client
+        self.run_server()
+        client = exo.RemoteSolveClient([self.url], CONFIG, 30000)
+        start_state = np.zeros(7)
+        results = client.solve_batch([make_request(start_state, goal) for goal in GOALS])
+        self.assertEqual(len(results), len(GOALS))
+        for result, goal in zip(results, GOALS):
+            self.assertTrue(result.success, result.error)
+            np.testing.assert_allclose(result.solution, solve_locally(start_state, goal))
+
+    def test_invalid_request(self):
+        self.server.add_configuration(CONFIG)
+        self.run_server()
+        client = exo.RemoteSolveClient([self.url], CONFIG, 10000)
+        request = exo.RemoteSolveRequest()
+        request.task_goals = {'Missing': GOALS[0]}
+        result = client.solve(request)
+        self.assertFalse(result.success)
+        self.assertTrue(result.error)
+
+        # The server keeps serving after a failed request
+        result = client.solve(make_request(np.zeros(7), GOALS[0]))
+        self.assertTrue(result.success, result.error)
+
+    def test_timeout(self):
+        # Nobody is serving the requests
+        client = exo.RemoteSolveClient([self.url], CONFIG, 200)
+        result = client.solve(make_request(np.zeros(7), GOALS[0]))
+        self.assertFalse(result.success)
+        self.assertTrue(result.error)
+
+
+if __name__ == '__main__':
+    unittest.main()
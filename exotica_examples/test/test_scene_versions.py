@@ -0,0 +1,107 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+XML = '''<IKSolverDemoConfig>
+  <IKSolver Name="MySolver"/>
+  <UnconstrainedEndPoseProblem Name="MyProblem">
+    <PlanningScene>
+      <Scene>
+        <JointGroup>arm</JointGroup>
+        <URDF>{exotica_examples}/resources/robots/lwr_simplified.urdf</URDF>
+        <SRDF>{exotica_examples}/resources/robots/lwr_simplified.srdf</SRDF>
+        <CollisionScene>
+          <CollisionSceneFCLLatest Name="MyCollisionScene"/>
+        </CollisionScene>
+      </Scene>
+    </PlanningScene>
+    <Maps>
+      <EffPosition Name="Position">
+        <EndEffector>
+          <Frame Link="lwr_arm_6_link"/>
+        </EndEffector>
+      </EffPosition>
+    </Maps>
+    <Cost>
+      <Task Task="Position"/>
+    </Cost>
+  </UnconstrainedEndPoseProblem>
+</IKSolverDemoConfig>'''
+
+CHANGES = [exo.SceneChange.State, exo.SceneChange.World, exo.SceneChange.Attachments, exo.SceneChange.ACM, exo.SceneChange.Trajectories]
+
+
+class SceneVersionsCase(unittest.TestCase):
+
+    def setUp(self):
+        _, problem_init = exo.Initializers.load_xml_full(XML, parseAsXMLString=True)
+        # The problem owns the scene
+        self.problem = exo.Setup.create_problem(problem_init)
+        self.scene = self.problem.get_scene()
+
+    def versions(self):
+        return {change: self.scene.get_version(change) for change in CHANGES}
+
+    def assert_changed(self, before, changed):
+        # Changes of the world may update the collision objects, which counts as a change of the state as well
+        after = self.versions()
+        for change in CHANGES:
+            if change == exo.SceneChange.State and change not in changed:
+                continue
+            if change in changed:
+                self.assertGreater(after[change], before[change], str(change))
+            else:
+                self.assertEqual(after[change], before[change], str(change))
+
+    def test_versions_of_parts(self):
+        before, world_version = self.versions(), self.scene.get_world_version()
+        self.scene.update(np.zeros(self.problem.N))
+        self.assert_changed(before, [exo.SceneChange.State])
+        self.assertEqual(self.scene.get_state_version(), self.scene.get_version(exo.SceneChange.State))
+        self.assertEqual(self.scene.get_world_version(), world_version)
+
+        before, world_version = self.versions(), self.scene.get_world_version()
+        self.scene.add_object('Box', exo.KDLFrame([0.5, 0., 0.6]), '', exo.Box(0.1, 0.1, 0.1), update_collision_scene=True)
+        self.assert_changed(before, [exo.SceneChange.World])
+        self.assertGreater(self.scene.get_world_version(), world_version)
+
+        before, world_version = self.versions(), self.scene.get_world_version()
+        self.scene.attach_object_local('Box', 'lwr_arm_6_link', exo.KDLFrame([0., 0., 0.1]))
+        self.assert_changed(before, [exo.SceneChange.Attachments])
+        self.assertGreater(self.scene.get_world_version(), world_version)
+
+        # The world version is the union of all but the state, the version of the world objects is not
+        before, world_version = self.versions(), self.scene.get_world_version()
+        self.scene.add_trajectory_from_array('Box', np.array([[0., 0.5, 0., 0.6], [1., 0.5, 0.1, 0.6]]), 1.0)
+        self.assert_changed(before, [exo.SceneChange.Trajectories])
+        self.assertGreater(self.scene.get_world_version(), world_version)
+
+    def test_change_listeners(self):
+        changes = []
+        handle = self.scene.add_change_listener(lambda change: changes.append(change), exo.SceneChange.World | exo.SceneChange.Attachments)
+        self.scene.update(np.zeros(self.problem.N))
+        self.assertEqual(changes, [])
+        self.scene.add_object('Box', exo.KDLFrame([0.5, 0., 0.6]), '', exo.Box(0.1, 0.1, 0.1), update_collision_scene=True)
+        self.assertIn(exo.SceneChange.World, changes)
+        del changes[:]
+        self.scene.attach_object('Box', 'lwr_arm_6_link')
+        self.assertEqual(changes, [exo.SceneChange.Attachments])
+
+        # State changes are only reported when requested, on the thread updating the scene
+        states = []
+        state_handle = self.scene.add_change_listener(lambda change: states.append(change), exo.SceneChange.State)
+        self.scene.update(np.zeros(self.problem.N))
+        self.assertEqual(states, [exo.SceneChange.State])
+
+        self.scene.remove_change_listener(handle)
+        self.scene.remove_change_listener(state_handle)
+        del changes[:]
+        self.scene.detach_object('Box')
+        self.scene.update(np.zeros(self.problem.N))
+        self.assertEqual(changes, [])
+        self.assertEqual(states, [exo.SceneChange.State])
+
+
+if __name__ == '__main__':
+    unittest.main()
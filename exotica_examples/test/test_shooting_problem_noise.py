@@ -0,0 +1,86 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/dynamic_time_indexed/10_ilqg_cartpole.xml'
+
+
+def create_problem(**options):
+    _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    problem = exo.Setup.create_problem((problem_init[0], dict(problem_init[1], **options)))
+    problem.enable_stochastic_updates()
+    return problem
+
+
+class ShootingProblemNoiseCase(unittest.TestCase):
+
+    def setUp(self):
+        np.random.seed(0)
+
+    def test_same_seed_gives_same_noise(self):
+        problem_a = create_problem(NoiseSeed=3)
+        problem_b = create_problem(NoiseSeed=3)
+        np.testing.assert_array_equal(problem_a.sample_noise(5), problem_b.sample_noise(5))
+        # SetNoiseSeed on its own reproduces the noise as well
+        problem_b.set_noise_seed(4)
+        self.assertFalse(np.allclose(problem_a.sample_noise(5), problem_b.sample_noise(5)))
+        problem_b.set_noise_seed(3)
+        np.testing.assert_array_equal(problem_a.sample_noise(5), problem_b.sample_noise(5))
+
+        noise = problem_a.sample_noise(0)
+        self.assertEqual(noise.shape, (2 * problem_a.get_scene().get_num_state(), problem_a.T - 1))
+        self.assertLess(abs(np.mean(noise)), 0.1)
+        self.assertLess(abs(np.std(noise) - 1.0), 0.1)
+
+    def test_streams_are_independent(self):
+        problem = create_problem()
+        streams = [problem.sample_noise(stream).ravel() for stream in range(4)]
+        for i in range(len(streams)):
+            for j in range(i + 1, len(streams)):
+                self.assertFalse(np.allclose(streams[i], streams[j]))
+                # Uncorrelated standard normal samples
+                self.assertLess(abs(np.corrcoef(streams[i], streams[j])[0, 1]), 0.1)
+
+    def test_rollouts_do_not_depend_on_threads(self):
+        problem = create_problem()
+        ds = problem.get_scene().get_dynamics_solver()
+        x0 = problem.X[:, 0]
+        U = np.random.uniform(-1.0, 1.0, (ds.nu, problem.T - 1))
+        U_rollouts = [U] * 4
+
+        results = []
+        for num_threads in [1, 2, 4]:
+            problem.set_noise_seed(7)
+            problem.rollout_num_threads = num_threads
+            results.append(problem.rollout(x0, U_rollouts))
+        for costs, X_rollouts in results[1:]:
+            np.testing.assert_array_equal(costs, results[0][0])
+            for X, X_serial in zip(X_rollouts, results[0][1]):
+                np.testing.assert_array_equal(X, X_serial)
+
+        # Each rollout draws its own stream, the same controls give different trajectories
+        X_rollouts = results[0][1]
+        self.assertFalse(np.allclose(X_rollouts[0], X_rollouts[1]))
+
+        # The streams continue after the rollouts of the previous call
+        problem.set_noise_seed(7)
+        problem.rollout_num_threads = 1
+        for k in range(len(U_rollouts)):
+            _, X_single = problem.rollout(x0, [U])
+            np.testing.assert_array_equal(X_single[0], X_rollouts[k])
+
+    def test_common_random_numbers(self):
+        problem = create_problem(CommonRandomNumbers=True)
+        ds = problem.get_scene().get_dynamics_solver()
+        x0 = problem.X[:, 0]
+        U = np.random.uniform(-1.0, 1.0, (ds.nu, problem.T - 1))
+        problem.pre_update()
+        costs, X_rollouts = problem.rollout(x0, [U, U, U])
+        np.testing.assert_array_equal(costs, np.full(3, costs[0]))
+        _, X_next = problem.rollout(x0, [U])
+        np.testing.assert_array_equal(X_next[0], X_rollouts[0])
+
+
+if __name__ == '__main__':
+    unittest.main()
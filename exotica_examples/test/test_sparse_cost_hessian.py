@@ -0,0 +1,38 @@
+# coding: utf-8
+import unittest
+
+import numpy as np
+import pyexotica as exo
+from pyexotica.testing import random_state
+
+CONFIG = '{exotica_examples}/resources/configs/dynamic_time_indexed/02_lwr_task_maps.xml'
+
+
+def create_problem(sparse_cost_hessian):
+    _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    return exo.Setup.create_problem((problem_init[0], dict(problem_init[1], SparseCostHessian=sparse_cost_hessian)))
+
+
+class SparseCostHessianCase(unittest.TestCase):
+
+    def test_matches_dense_hessian(self):
+        # The position task is only weighted at the terminal state, the joint limits at all time steps
+        dense = create_problem(False)
+        sparse = create_problem(True)
+        ds = dense.get_scene().get_dynamics_solver()
+        np.random.seed(0)
+        # Repeated evaluations at different states reuse and, where J gains non-zero entries, rebuild the cached patterns
+        for _ in range(3):
+            for t in range(dense.T):
+                x = random_state(ds)
+                u = np.random.random((ds.nu,))
+                for problem in [dense, sparse]:
+                    if t == dense.T - 1:
+                        problem.update_terminal_state(x)
+                    else:
+                        problem.update(x, u, t)
+                np.testing.assert_allclose(sparse.get_state_cost_hessian(t), dense.get_state_cost_hessian(t), rtol=1e-12, atol=1e-12, err_msg='t = {}'.format(t))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,98 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+from scipy.sparse import csc_matrix
+
+XML = '''<ProblemDemoConfig>
+  <TimeIndexedProblem Name="MyProblem">
+    <PlanningScene>
+      <Scene>
+        <JointGroup>arm</JointGroup>
+        <URDF>{exotica_examples}/resources/robots/lwr_simplified.urdf</URDF>
+        <SRDF>{exotica_examples}/resources/robots/lwr_simplified.srdf</SRDF>
+      </Scene>
+    </PlanningScene>
+    <Maps>
+      <EffPosition Name="Tip">
+        <EndEffector>
+          <Frame Link="lwr_arm_6_link"/>
+        </EndEffector>
+      </EffPosition>
+      <EffPosition Name="Height">
+        <EndEffector>
+          <Frame Link="lwr_arm_3_link"/>
+        </EndEffector>
+      </EffPosition>
+    </Maps>
+    <Cost>
+      <Task Task="Tip" Rho="1e2"/>
+    </Cost>
+    <Equality>
+      <Task Task="Tip"/>
+    </Equality>
+    <Inequality>
+      <Task Task="Height"/>
+    </Inequality>
+    <JointVelocityLimits>1.5</JointVelocityLimits>
+    <T>10</T>
+    <tau>0.05</tau>
+    <W>7 6 5 4 3 2 1</W>
+  </TimeIndexedProblem>
+</ProblemDemoConfig>'''
+
+VIEWS = [('get_equality_jacobian_csc', 'get_equality_jacobian'),
+         ('get_inequality_jacobian_csc', 'get_inequality_jacobian'),
+         ('get_cost_hessian_csc', 'get_cost_hessian')]
+
+
+def setup():
+    _, problem_init = exo.Initializers.load_xml_full(XML, parseAsXMLString=True)
+    problem = exo.Setup.create_problem(problem_init)
+    for t in range(problem.T):
+        problem.set_rho_eq('Tip', 1.0 if t == problem.T - 1 else 0.0, t)
+        problem.set_rho_neq('Height', 0.0 if t == 0 else 1.0, t)
+    return problem
+
+
+def update_random_trajectory(problem):
+    for t in range(problem.T):
+        problem.update(np.random.uniform(-1.0, 1.0, problem.N), t)
+
+
+class TimeIndexedCSCViewsCase(unittest.TestCase):
+
+    def test_views_match_sparse_matrices(self):
+        problem = setup()
+        np.random.seed(0)
+        for _ in range(3):
+            update_random_trajectory(problem)
+            for view, matrix in VIEWS:
+                (data, indices, indptr), shape = getattr(problem, view)()
+                np.testing.assert_allclose(csc_matrix((data, indices, indptr), shape=shape).toarray(), getattr(problem, matrix)().toarray(), rtol=1e-12, atol=1e-12, err_msg=view)
+
+            # The Hessian view also agrees with the matrix-free product
+            (data, indices, indptr), shape = problem.get_cost_hessian_csc()
+            v = np.random.random(shape[1])
+            np.testing.assert_allclose(csc_matrix((data, indices, indptr), shape=shape).dot(v), problem.get_cost_hessian_vector_product(v), rtol=1e-9, atol=1e-9)
+
+    def test_views_share_the_pattern(self):
+        problem = setup()
+        update_random_trajectory(problem)
+        for view, matrix in VIEWS:
+            (data, indices, indptr), shape = getattr(problem, view)()
+            self.assertFalse(indices.flags.writeable)
+            self.assertFalse(indptr.flags.writeable)
+
+            # The arrays alias the persistent matrix: a new trajectory changes the values in place
+            update_random_trajectory(problem)
+            (new_data, new_indices, new_indptr), new_shape = getattr(problem, view)()
+            self.assertEqual(shape, new_shape)
+            self.assertTrue(np.shares_memory(indices, new_indices), view)
+            self.assertTrue(np.shares_memory(data, new_data), view)
+            np.testing.assert_array_equal(data, new_data)
+            np.testing.assert_allclose(csc_matrix((data, indices, indptr), shape=shape).toarray(), getattr(problem, matrix)().toarray(), rtol=1e-12, atol=1e-12, err_msg=view)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,45 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/example_time_indexed_sampling.xml'
+
+
+def solve(**options):
+    solver_init, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    problem = exo.Setup.create_problem(problem_init)
+    solver = exo.Setup.create_solver((solver_init[0], dict(solver_init[1], Smooth=False, **options)))
+    solver.specify_problem(problem)
+    return problem, solver.solve()
+
+
+class TimeIndexedRRTConnectCase(unittest.TestCase):
+
+    def check_solution(self, problem, solution):
+        # The first column is the time, the path goes from the start state to the goal state at increasing times
+        self.assertGreater(solution.shape[0], 1)
+        self.assertTrue(np.all(np.diff(solution[:, 0]) >= 0.))
+        np.testing.assert_allclose(solution[0, 1:], problem.start_state, atol=1e-6)
+        np.testing.assert_allclose(solution[-1, 1:], problem.goal_state, atol=1e-6)
+        self.assertLessEqual(solution[-1, 0], problem.goal_time + 1e-6)
+        for row in [solution[0], solution[-1]]:
+            self.assertTrue(problem.is_valid(row[1:], row[0]))
+
+    def test_parallel_tree_growth(self):
+        # The goal tree is grown on a second thread checking states on its own clone of the scene
+        for seed in range(5):
+            problem, solution = solve(ParallelTreeGrowth=True, RandomSeed=seed)
+            self.check_solution(problem, solution)
+
+    def test_parallel_tree_growth_time_slices(self):
+        problem, solution = solve(ParallelTreeGrowth=True, TimeSliceDuration=0.5, RandomSeed=1)
+        self.check_solution(problem, solution)
+
+    def test_serial_tree_growth(self):
+        problem, solution = solve(RandomSeed=1)
+        self.check_solution(problem, solution)
+
+
+if __name__ == '__main__':
+    unittest.main()
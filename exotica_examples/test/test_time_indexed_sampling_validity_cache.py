@@ -0,0 +1,77 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+CONFIG = '{exotica_examples}/resources/configs/example_time_indexed_sampling.xml'
+
+
+def setup(**options):
+    _, problem_init = exo.Initializers.load_xml_full(CONFIG)
+    return exo.Setup.create_problem((problem_init[0], dict(problem_init[1], **options)))
+
+
+class TimeIndexedSamplingValidityCacheCase(unittest.TestCase):
+
+    def test_cached_results_match_uncached_results(self):
+        uncached = setup()
+        cached = setup(ValidityCacheSize=100)
+        np.random.seed(0)
+        queries = [(np.random.uniform(-2.0, 2.0, uncached.N), np.random.uniform(0.0, 3.0)) for _ in range(20)]
+        for _ in range(2):
+            for x, t in queries:
+                self.assertEqual(cached.is_valid(x, t), uncached.is_valid(x, t))
+        self.assertEqual(cached.validity_cache_misses, len(queries))
+        self.assertEqual(cached.validity_cache_hits, len(queries))
+        self.assertEqual(uncached.validity_cache_hits, 0)
+
+    def test_quantisation(self):
+        problem = setup(ValidityCacheSize=10, ValidityCacheResolution=1e-3)
+        x = np.zeros(problem.N)
+        problem.is_valid(x, 1.0)
+        problem.is_valid(x + 1e-5, 1.0 + 1e-5)
+        self.assertEqual(problem.validity_cache_hits, 1)
+        problem.is_valid(x + 1e-2, 1.0)
+        problem.is_valid(x, 1.1)
+        self.assertEqual(problem.validity_cache_misses, 3)
+
+    def test_least_recently_used_eviction(self):
+        problem = setup(ValidityCacheSize=2)
+        a, b, c = [np.full(problem.N, v) for v in [0.0, 0.1, 0.2]]
+        problem.is_valid(a, 0.0)
+        problem.is_valid(b, 0.0)
+        problem.is_valid(a, 0.0)  # b is now the least recently used
+        problem.is_valid(c, 0.0)  # evicts b
+        self.assertEqual((problem.validity_cache_hits, problem.validity_cache_misses), (1, 3))
+        problem.is_valid(a, 0.0)
+        problem.is_valid(c, 0.0)
+        self.assertEqual((problem.validity_cache_hits, problem.validity_cache_misses), (3, 3))
+        problem.is_valid(b, 0.0)
+        self.assertEqual((problem.validity_cache_hits, problem.validity_cache_misses), (3, 4))
+
+    def test_clear_and_invalidation(self):
+        problem = setup(ValidityCacheSize=10)
+        x = np.zeros(problem.N)
+        problem.is_valid(x, 0.0)
+        problem.clear_validity_cache()
+        self.assertEqual((problem.validity_cache_hits, problem.validity_cache_misses), (0, 0))
+
+        # Changing the goals of the constraints invalidates the cached results
+        problem.is_valid(x, 0.0)
+        problem.set_goal_eq('Collision', problem.get_goal_eq('Collision'))
+        problem.is_valid(x, 0.0)
+        self.assertEqual((problem.validity_cache_hits, problem.validity_cache_misses), (0, 2))
+
+        # So does changing the world of the scene
+        problem.is_valid(x, 1.0)
+        problem.get_scene().add_object('CacheObstacle', exo.KDLFrame([2., 2., 2.]), '', exo.Box(0.1, 0.1, 0.1), update_collision_scene=True)
+        problem.is_valid(x, 1.0)
+        self.assertEqual((problem.validity_cache_hits, problem.validity_cache_misses), (0, 4))
+
+        # Update(x, t) always evaluates the tasks and does not touch the cache
+        problem.update(x, 1.0)
+        self.assertEqual((problem.validity_cache_hits, problem.validity_cache_misses), (0, 4))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,92 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+T = 10
+VIA = 5
+
+# The elbow is a via-point, weighted at a single time step only
+XML = '''<IKSolverDemoConfig>
+  <UnconstrainedTimeIndexedProblem Name="MyProblem">
+    <PlanningScene>
+      <Scene>
+        <JointGroup>arm</JointGroup>
+        <URDF>{exotica_examples}/resources/robots/lwr_simplified.urdf</URDF>
+        <SRDF>{exotica_examples}/resources/robots/lwr_simplified.srdf</SRDF>
+      </Scene>
+    </PlanningScene>
+    <Maps>
+      <EffPosition Name="Tip">
+        <EndEffector>
+          <Frame Link="lwr_arm_7_link"/>
+        </EndEffector>
+      </EffPosition>
+      <EffPosition Name="Elbow">
+        <EndEffector>
+          <Frame Link="lwr_arm_3_link"/>
+        </EndEffector>
+      </EffPosition>
+    </Maps>
+    <Cost>
+      <Task Task="Tip"/>
+      <Task Task="Elbow" Rho="''' + ' '.join('1' if t == VIA else '0' for t in range(T)) + '''"/>
+    </Cost>
+    <T>''' + str(T) + '''</T>
+    <tau>0.05</tau>
+    <W>7 6 5 4 3 2 1</W>
+  </UnconstrainedTimeIndexedProblem>
+</IKSolverDemoConfig>'''
+
+
+def setup():
+    _, problem_init = exo.Initializers.load_xml_full(XML, parseAsXMLString=True)
+    problem = exo.Setup.create_problem(problem_init)
+    maps = problem.get_task_maps()
+    return problem, maps['Tip'], maps['Elbow']
+
+
+def position(problem, q, link):
+    problem.get_scene().update(q)
+    return problem.get_scene().fk(link).get_translation()
+
+
+class TimeIndexedTaskActivityCase(unittest.TestCase):
+
+    def test_active_set_follows_rho_from_the_start(self):
+        problem, tip, elbow = setup()
+        for t in range(T):
+            self.assertTrue(problem.cost.is_task_map_active(tip.id, t))
+            self.assertEqual(problem.cost.is_task_map_active(elbow.id, t), t == VIA)
+
+        # The first evaluation, without an explicit pre_update, evaluates the via-point at its time step
+        q = np.random.uniform(-1.0, 1.0, 7)
+        for t in range(T):
+            problem.update(q, t)
+        elbow_position = position(problem, q, 'lwr_arm_3_link')
+        np.testing.assert_allclose(problem.Phi[VIA].data[elbow.start:elbow.start + elbow.length], elbow_position, atol=1e-9)
+        np.testing.assert_allclose(problem.cost.ydiff[VIA][elbow.startJ:elbow.startJ + elbow.lengthJ], elbow_position, atol=1e-9)
+
+    def test_skipped_maps_keep_last_derivatives(self):
+        problem, tip, elbow = setup()
+        t = 2
+        q_first = np.random.uniform(-1.0, 1.0, 7)
+        q_second = np.random.uniform(-1.0, 1.0, 7)
+
+        problem.set_rho('Elbow', 1.0, t)
+        problem.update(q_first, t)
+        np.testing.assert_allclose(problem.Phi[t].data[elbow.start:elbow.start + elbow.length], position(problem, q_first, 'lwr_arm_3_link'), atol=1e-9)
+        elbow_jacobian_first = problem.jacobian[t][elbow.startJ:elbow.startJ + elbow.lengthJ, :].copy()
+
+        # Phi and the task error of a map without weight at this time step are still current, only its Jacobian is not evaluated
+        problem.set_rho('Elbow', 0.0, t)
+        self.assertFalse(problem.cost.is_task_map_active(elbow.id, t))
+        problem.update(q_second, t)
+        elbow_second = position(problem, q_second, 'lwr_arm_3_link')
+        np.testing.assert_allclose(problem.Phi[t].data[elbow.start:elbow.start + elbow.length], elbow_second, atol=1e-9)
+        np.testing.assert_allclose(problem.cost.ydiff[t][elbow.startJ:elbow.startJ + elbow.lengthJ], elbow_second, atol=1e-9)
+        np.testing.assert_array_equal(problem.jacobian[t][elbow.startJ:elbow.startJ + elbow.lengthJ, :], elbow_jacobian_first)
+        np.testing.assert_allclose(problem.Phi[t].data[tip.start:tip.start + tip.length], position(problem, q_second, 'lwr_arm_7_link'), atol=1e-9)
+
+if __name__ == '__main__':
+    unittest.main()
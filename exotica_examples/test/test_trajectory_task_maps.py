@@ -0,0 +1,78 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+T = 8
+
+# JointPose and JointLimit are evaluated for the whole trajectory at once, the others per time step
+XML = '''<IKSolverDemoConfig>
+  <UnconstrainedTimeIndexedProblem Name="MyProblem">
+    <PlanningScene>
+      <Scene>
+        <JointGroup>arm</JointGroup>
+        <URDF>{exotica_examples}/resources/robots/lwr_simplified.urdf</URDF>
+        <SRDF>{exotica_examples}/resources/robots/lwr_simplified.srdf</SRDF>
+      </Scene>
+    </PlanningScene>
+    <Maps>
+      <JointPose Name="Pose" JointRef="0.1 0.2 0.3 0.4 0.5 0.6 0.7"/>
+      <JointLimit Name="Limit" SafePercentage="0.5"/>
+      <JointVelocityBackwardDifference Name="Velocity"/>
+      <EffPosition Name="Tip">
+        <EndEffector>
+          <Frame Link="lwr_arm_7_link"/>
+        </EndEffector>
+      </EffPosition>
+    </Maps>
+    <Cost>
+      <Task Task="Pose"/>
+      <Task Task="Limit"/>
+      <Task Task="Velocity"/>
+      <Task Task="Tip"/>
+    </Cost>
+    <T>''' + str(T) + '''</T>
+    <tau>0.05</tau>
+    <W>7 6 5 4 3 2 1</W>
+  </UnconstrainedTimeIndexedProblem>
+</IKSolverDemoConfig>'''
+
+
+def create_problem():
+    _, problem_init = exo.Initializers.load_xml_full(XML, parseAsXMLString=True)
+    return exo.Setup.create_problem(problem_init)
+
+
+class TrajectoryTaskMapsCase(unittest.TestCase):
+
+    def test_trajectory_update_matches_time_steps(self):
+        trajectory_problem = create_problem()
+        step_problem = create_problem()
+        N = trajectory_problem.N
+        np.random.seed(7)
+        # Half of the joint ranges lie outside of the safe margin of the joint limits
+        trajectory = np.random.uniform(-2.0, 2.0, (T - 1, N))
+
+        trajectory_problem.update(trajectory.flatten())
+        for t in range(1, T):
+            step_problem.update(trajectory[t - 1], t)
+
+        for t in range(1, T):
+            np.testing.assert_allclose(trajectory_problem.Phi[t].data, step_problem.Phi[t].data, atol=1e-12)
+            np.testing.assert_allclose(trajectory_problem.get_jacobian_view(t), step_problem.get_jacobian_view(t), atol=1e-12)
+            self.assertAlmostEqual(trajectory_problem.get_scalar_task_cost(t), step_problem.get_scalar_task_cost(t))
+
+    def test_subsequent_time_step_update(self):
+        # A time step updated on its own after a trajectory update evaluates all task maps again
+        problem = create_problem()
+        N = problem.N
+        np.random.seed(3)
+        problem.update(np.random.uniform(-1.0, 1.0, (T - 1) * N))
+        q = np.random.uniform(-1.0, 1.0, N)
+        problem.update(q, 2)
+        pose = problem.get_task_maps()['Pose']
+        np.testing.assert_allclose(problem.Phi[2].data[pose.start:pose.start + pose.length], q - np.arange(1, 8) * 0.1, atol=1e-12)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,67 @@
+import unittest
+
+import numpy as np
+import pyexotica as exo
+
+XML = '''<IKSolverDemoConfig>
+  <IKSolver Name="MySolver"/>
+  <UnconstrainedEndPoseProblem Name="MyProblem">
+    <PlanningScene>
+      <Scene>
+        <JointGroup>arm</JointGroup>
+        <URDF>{exotica_examples}/resources/robots/lwr_simplified.urdf</URDF>
+        <SRDF>{exotica_examples}/resources/robots/lwr_simplified.srdf</SRDF>
+        <LoadScene>{exotica_examples}/resources/scenes/example_moving_obstacle.scene</LoadScene>
+        <Trajectories>
+          <Trajectory Link="Obstacle" File="{exotica_examples}/resources/scenes/example_moving_obstacle.traj"/>
+        </Trajectories>
+        <TrajectoryTimeResolution>%f</TrajectoryTimeResolution>
+      </Scene>
+    </PlanningScene>
+    <Maps>
+      <EffPosition Name="Position">
+        <EndEffector>
+          <Frame Link="lwr_arm_6_link"/>
+        </EndEffector>
+      </EffPosition>
+    </Maps>
+    <Cost>
+      <Task Task="Position"/>
+    </Cost>
+  </UnconstrainedEndPoseProblem>
+</IKSolverDemoConfig>'''
+
+
+def create_scene(resolution):
+    _, problem_init = exo.Initializers.load_xml_full(XML % resolution, parseAsXMLString=True)
+    problem = exo.Setup.create_problem(problem_init)
+    return problem, problem.get_scene()
+
+
+def obstacle_position(problem, scene, t):
+    scene.update(np.zeros(problem.N), t)
+    return scene.fk('Obstacle').get_translation()
+
+
+class TrajectoryTimeResolutionCase(unittest.TestCase):
+
+    def test_times_are_rounded_to_the_slices(self):
+        problem, scene = create_scene(0.5)
+        # The obstacle moves along y during the whole trajectory, i.e., distinct slices have distinct poses
+        self.assertFalse(np.allclose(obstacle_position(problem, scene, 0.5), obstacle_position(problem, scene, 1.0)))
+        for t, centre in [(0.3, 0.5), (0.6, 0.5), (0.74, 0.5), (0.76, 1.0), (1.2, 1.0)]:
+            np.testing.assert_allclose(obstacle_position(problem, scene, t), obstacle_position(problem, scene, centre))
+
+    def test_exact_times_without_resolution(self):
+        problem, scene = create_scene(0.)
+        rounded_problem, rounded_scene = create_scene(0.5)
+        self.assertFalse(np.allclose(obstacle_position(problem, scene, 0.6), obstacle_position(problem, scene, 0.5)))
+        np.testing.assert_allclose(obstacle_position(problem, scene, 0.5), obstacle_position(rounded_problem, rounded_scene, 0.5))
+
+    def test_negative_resolution_is_rejected(self):
+        with self.assertRaises(Exception):
+            create_scene(-0.1)
+
+
+if __name__ == '__main__':
+    unittest.main()
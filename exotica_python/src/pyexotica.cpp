@@ -28,8 +28,10 @@
 //
 
 #include <exotica_core/exotica_core.h>
+#include <exotica_core/remote_solve.h>
 #include <exotica_core/tools/box_qp.h>
 #include <exotica_core/tools/box_qp_old.h>
+#include <exotica_core/tools/experience_store.h>
 #include <exotica_core/tools/sparse_costs.h>
 #ifdef MSGPACK_FOUND
 #include <exotica_core/visualization_meshcat.h>
@@ -37,6 +39,7 @@
 #include <exotica_core/visualization_moveit.h>
 #undef NDEBUG
 #include <pybind11/eigen.h>
+#include <pybind11/functional.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -163,6 +166,50 @@ Initializer CreateInitializer(const Initializer& init)
     return Initializer(init);
 }
 
+/// \brief Read-only array aliasing the positions (n x 3) or the rotation matrices (n x 3 x 3) of contiguous KDL frames.
+/// The array keeps base alive but is only valid as long as base does not reallocate the frames.
+py::array FramesView(const KDL::Frame* frames, const int n, const bool rotation, py::handle base)
+{
+    const py::ssize_t frame_stride = static_cast<py::ssize_t>(sizeof(KDL::Frame));
+    const py::ssize_t double_stride = static_cast<py::ssize_t>(sizeof(double));
+    py::array view = rotation ? py::array_t<double>({static_cast<py::ssize_t>(n), py::ssize_t(3), py::ssize_t(3)}, {frame_stride, 3 * double_stride, double_stride}, n > 0 ? frames->M.data : nullptr, base)
+                              : py::array_t<double>({static_cast<py::ssize_t>(n), py::ssize_t(3)}, {frame_stride, double_stride}, n > 0 ? frames->p.data : nullptr, base);
+    py::detail::array_proxy(view.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+    return view;
+}
+
+/// \brief Read-only array aliasing the (6 x n, column-major) data of a KDL Jacobian. The array keeps base alive.
+py::array JacobianView(const KDL::Jacobian& jacobian, py::handle base)
+{
+    const py::ssize_t double_stride = static_cast<py::ssize_t>(sizeof(double));
+    py::array view = py::array_t<double>({py::ssize_t(6), static_cast<py::ssize_t>(jacobian.columns())}, {double_stride, 6 * double_stride}, jacobian.data.data(), base);
+    py::detail::array_proxy(view.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+    return view;
+}
+
+/// \brief Aliases the compressed storage of a column-major sparse matrix as the arguments of scipy.sparse.csc_matrix, i.e. ((data, indices, indptr), shape).
+/// The arrays keep base alive but are only valid as long as the sparsity pattern of the matrix is unchanged. The index arrays are read-only.
+py::tuple SparseMatrixCSCView(const Eigen::SparseMatrix<double>& m, py::handle base)
+{
+    if (!m.isCompressed()) ThrowPretty("Sparse matrix is not in compressed storage and cannot be viewed without copying.");
+    const py::ssize_t nnz = static_cast<py::ssize_t>(m.nonZeros());
+    py::array data = py::array_t<double>({nnz}, {static_cast<py::ssize_t>(sizeof(double))}, m.valuePtr(), base);
+    py::array indices = py::array_t<int>({nnz}, {static_cast<py::ssize_t>(sizeof(int))}, m.innerIndexPtr(), base);
+    py::array indptr = py::array_t<int>({static_cast<py::ssize_t>(m.outerSize() + 1)}, {static_cast<py::ssize_t>(sizeof(int))}, m.outerIndexPtr(), base);
+    py::detail::array_proxy(indices.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+    py::detail::array_proxy(indptr.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+    return py::make_tuple(py::make_tuple(data, indices, indptr), py::make_tuple(m.rows(), m.cols()));
+}
+
+/// \brief Read-only array aliasing the states or controls of a memory-mapped trajectory file. The array keeps the reader (base) alive.
+py::array TrajectoryFileDataView(const TrajectoryFileData& data, py::handle base)
+{
+    const py::ssize_t double_stride = static_cast<py::ssize_t>(sizeof(double));
+    py::array view = py::array_t<double>({static_cast<py::ssize_t>(data.rows()), static_cast<py::ssize_t>(data.cols())}, {double_stride * static_cast<py::ssize_t>(data.cols()), double_stride}, data.data(), base);
+    py::detail::array_proxy(view.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+    return view;
+}
+
 std::pair<Initializer, Initializer> LoadFromXML(std::string file_name, const std::string& solver_name = "", const std::string& problem_name = "", bool parsePathAsXML = false)
 {
     Initializer solver, problem;
@@ -185,6 +232,12 @@ void AddInitializers(py::module& module)
 
     inits.def("load_xml", (Initializer(*)(std::string, bool)) & XMLLoader::Load, "Loads initializer from XML", py::arg("xml"), py::arg("parseAsXMLString") = false);
     inits.def("load_xml_full", &LoadFromXML, "Loads initializer from XML", py::arg("xml"), py::arg("solver_name") = std::string(""), py::arg("problem_name") = std::string(""), py::arg("parseAsXMLString") = false);
+    inits.def("set_cache_directory", &XMLLoader::SetCacheDirectory, "Enables the on-disk cache of parsed XML configurations in the directory (empty disables it).", py::arg("directory"));
+    inits.def("get_cache_directory", &XMLLoader::GetCacheDirectory);
+    inits.def("clear_cache", &XMLLoader::ClearCache, "Clears the in-memory cache of parsed XML configurations.");
+    inits.def("set_cache_capacity", &XMLLoader::SetCacheCapacity, "Sets the maximum number of parsed XML configurations kept in memory.", py::arg("capacity"));
+    inits.def("get_cache_capacity", &XMLLoader::GetCacheCapacity);
+    inits.def("get_cache_size", &XMLLoader::GetCacheSize);
 }
 
 namespace pybind11
@@ -700,6 +753,8 @@ PYBIND11_MODULE(_pyexotica, module)
                      },
                      "Initializes an internal ROS node for publishing debug information from Exotica (i.e., activates ROS features). Options are setting the name and whether to spawn an anonymous node.",
                      py::arg("name") = "exotica", py::arg("anonymous") = false);
+    setup.def_static("configure_thread_pool", &Server::ConfigureThreadPool, "Sets the shared thread budget (0 uses the hardware concurrency minus the ROS spinner threads), whether worker threads are pinned to cores and whether to run everything single-threaded and deterministically.", py::arg("num_threads") = 0, py::arg("pin_threads") = false, py::arg("deterministic") = false);
+    setup.def_static("get_num_threads", []() { return Server::ResolveNumThreads(0); }, "Returns the default number of threads used by parallel kinematics, collision checking, problems and solvers.");
     setup.def_static("load_solver", &XMLLoader::LoadSolver, "Instantiate solver and problem from an XML file containing both a solver and problem initializer.", py::arg("filepath"));
     setup.def_static("load_solver_standalone", &XMLLoader::LoadSolverStandalone, "Instantiate only a solver from an XML file containing solely a solver initializer.", py::arg("filepath"));
     setup.def_static("load_problem", &XMLLoader::LoadProblem, "Instantiate only a problem from an XML file containing solely a problem initializer.", py::arg("filepath"));
@@ -725,6 +780,27 @@ PYBIND11_MODULE(_pyexotica, module)
     },
               py::arg("data"), py::arg("max_radius") = 1.0);
 
+    py::class_<SplineTrajectory, std::shared_ptr<SplineTrajectory>> spline_trajectory(module, "SplineTrajectory");
+    py::enum_<SplineTrajectory::SplineType>(spline_trajectory, "SplineType")
+        .value("Cubic", SplineTrajectory::Cubic)
+        .value("Quintic", SplineTrajectory::Quintic)
+        .export_values();
+    spline_trajectory.def(py::init<Eigen::VectorXdRefConst, Eigen::MatrixXdRefConst, SplineTrajectory::SplineType>(), py::arg("times"), py::arg("knots"), py::arg("type") = SplineTrajectory::Cubic);
+    spline_trajectory.def(py::init<Eigen::VectorXdRefConst, Eigen::MatrixXdRefConst, Eigen::MatrixXdRefConst, Eigen::MatrixXdRefConst>(), py::arg("times"), py::arg("knots"), py::arg("velocities"), py::arg("accelerations"));
+    spline_trajectory.def("get_position", (Eigen::VectorXd(SplineTrajectory::*)(double) const) & SplineTrajectory::GetPosition, py::arg("t"));
+    spline_trajectory.def("get_velocity", (Eigen::VectorXd(SplineTrajectory::*)(double) const) & SplineTrajectory::GetVelocity, py::arg("t"));
+    spline_trajectory.def("get_acceleration", (Eigen::VectorXd(SplineTrajectory::*)(double) const) & SplineTrajectory::GetAcceleration, py::arg("t"));
+    spline_trajectory.def("get_positions", &SplineTrajectory::GetPositions, py::call_guard<py::gil_scoped_release>(), py::arg("times"));
+    spline_trajectory.def("get_velocities", &SplineTrajectory::GetVelocities, py::call_guard<py::gil_scoped_release>(), py::arg("times"));
+    spline_trajectory.def("get_accelerations", &SplineTrajectory::GetAccelerations, py::call_guard<py::gil_scoped_release>(), py::arg("times"));
+    spline_trajectory.def_property_readonly("type", &SplineTrajectory::GetType);
+    spline_trajectory.def_property_readonly("dimension", &SplineTrajectory::GetDimension);
+    spline_trajectory.def_property_readonly("duration", &SplineTrajectory::GetDuration);
+    spline_trajectory.def_property_readonly("start_time", &SplineTrajectory::GetStartTime);
+    spline_trajectory.def_property_readonly("end_time", &SplineTrajectory::GetEndTime);
+    spline_trajectory.def_property_readonly("times", &SplineTrajectory::GetTimes);
+    spline_trajectory.def_property_readonly("knots", &SplineTrajectory::GetKnots);
+
     py::module sparse_costs = tools.def_submodule("SparseCosts")
                                   .def("huber_cost", &huber_cost)
                                   .def("huber_jacobian", &huber_jacobian)
@@ -741,6 +817,33 @@ PYBIND11_MODULE(_pyexotica, module)
     timer.def("reset", &Timer::Reset);
     timer.def("get_duration", &Timer::GetDuration);
 
+    py::class_<ProfileZoneStatistics> profile_zone_statistics(module, "ProfileZoneStatistics");
+    profile_zone_statistics.def_readonly("name", &ProfileZoneStatistics::name);
+    profile_zone_statistics.def_readonly("count", &ProfileZoneStatistics::count);
+    profile_zone_statistics.def_readonly("total", &ProfileZoneStatistics::total);
+    profile_zone_statistics.def_readonly("self", &ProfileZoneStatistics::self);
+    profile_zone_statistics.def_readonly("min", &ProfileZoneStatistics::min);
+    profile_zone_statistics.def_readonly("max", &ProfileZoneStatistics::max);
+    profile_zone_statistics.def_readonly("mean", &ProfileZoneStatistics::mean);
+    profile_zone_statistics.def_readonly("allocations", &ProfileZoneStatistics::allocations);
+    profile_zone_statistics.def_readonly("self_allocations", &ProfileZoneStatistics::self_allocations);
+    profile_zone_statistics.def_readonly("max_allocations", &ProfileZoneStatistics::max_allocations);
+    profile_zone_statistics.def("__repr__", [](const ProfileZoneStatistics& zone) { return "<ProfileZoneStatistics " + zone.name + ": " + std::to_string(zone.count) + " events, " + std::to_string(zone.total) + " s>"; });
+
+    py::module profiler = module.def_submodule("Profiler", "Scoped profiling zones, recorded when EXOTica is built with EXOTICA_ENABLE_PROFILING.");
+    profiler.def("is_compiled_in", &Profiler::IsCompiledIn);
+    profiler.def("is_allocation_tracking_loaded", &Profiler::IsAllocationTrackingLoaded, "Whether exotica_allocation_tracking is preloaded (LD_PRELOAD), which counts the heap allocations.");
+    profiler.def("get_thread_allocations", &Profiler::GetThreadAllocations, "Number of heap allocations made by the calling thread so far (requires exotica_allocation_tracking).");
+    profiler.def("set_enabled", [](bool enabled) { Profiler::Instance().SetEnabled(enabled); });
+    profiler.def("is_enabled", []() { return Profiler::Instance().IsEnabled(); });
+    profiler.def("set_max_events_per_thread", [](std::size_t max_events) { Profiler::Instance().SetMaxEventsPerThread(max_events); });
+    profiler.def("get_number_of_dropped_events", []() { return Profiler::Instance().GetNumberOfDroppedEvents(); });
+    profiler.def("clear", []() { Profiler::Instance().Clear(); });
+    profiler.def("get_statistics", []() { return Profiler::Instance().GetStatistics(); }, "Aggregate timings per zone, sorted by descending total time.");
+    profiler.def("get_statistics_table", []() { return Profiler::Instance().GetStatisticsTable(); });
+    profiler.def("get_chrome_trace", []() { return Profiler::Instance().GetChromeTrace(); }, "Events in the Chrome trace event format (JSON) for chrome://tracing and Perfetto.");
+    profiler.def("save_chrome_trace", [](const std::string& file_name) { Profiler::Instance().SaveChromeTrace(file_name); }, py::arg("file_name"));
+
     py::class_<Object, std::shared_ptr<Object>> object(module, "Object");
     object.def_property_readonly("type", &Object::type, "Object type");
     object.def_property_readonly("name", &Object::GetObjectName, "Object name");
@@ -836,7 +939,16 @@ PYBIND11_MODULE(_pyexotica, module)
         .def_readonly("startJ", &TaskMap::start_jacobian)
         .def_readonly("lengthJ", &TaskMap::length_jacobian)
         .def("task_space_dim", (int (TaskMap::*)()) & TaskMap::TaskSpaceDim)
-        .def("task_space_jacobian_dim", &TaskMap::TaskSpaceJacobianDim);
+        .def("task_space_jacobian_dim", &TaskMap::TaskSpaceJacobianDim)
+        .def("get_frame_positions", [](py::object self, int i) {
+            // Aliases the kinematic response, valid until the kinematic request of the scene changes
+            const TaskMap& map = self.cast<const TaskMap&>();
+            if (i < 0 || i >= static_cast<int>(map.kinematics.size())) ThrowPretty("Invalid kinematic solution index " << i);
+            return FramesView(map.kinematics[i].Phi.data(), map.kinematics[i].Phi.rows(), false, self); }, "Read-only view of the frame positions (n x 3), without copying", py::arg("kinematics_index") = 0)
+        .def("get_frame_rotations", [](py::object self, int i) {
+            const TaskMap& map = self.cast<const TaskMap&>();
+            if (i < 0 || i >= static_cast<int>(map.kinematics.size())) ThrowPretty("Invalid kinematic solution index " << i);
+            return FramesView(map.kinematics[i].Phi.data(), map.kinematics[i].Phi.rows(), true, self); }, "Read-only view of the frame rotation matrices (n x 3 x 3), without copying", py::arg("kinematics_index") = 0);
 
     py::class_<TaskIndexing>(module, "TaskIndexing")
         .def_readonly("id", &TaskIndexing::id)
@@ -870,7 +982,17 @@ PYBIND11_MODULE(_pyexotica, module)
         .def("set_rho", &TimeIndexedTask::SetRho)
         .def("get_rho", &TimeIndexedTask::GetRho)
         .def("get_task_error", &TimeIndexedTask::GetTaskError)
-        .def("get_S", &TimeIndexedTask::GetS);
+        .def("get_S", &TimeIndexedTask::GetS)
+        .def("is_task_map_active", &TimeIndexedTask::IsTaskMapActive, py::arg("map_id"), py::arg("t"))
+        .def("get_ydiff_view", [](const TimeIndexedTask& task, int t) -> const Eigen::VectorXd& {
+            if (t < 0 || t >= task.T) ThrowPretty("Invalid time index " << t);
+            return task.ydiff[t]; }, py::return_value_policy::reference_internal, "Read-only view of ydiff at time t, without copying")
+        .def("get_jacobian_view", [](const TimeIndexedTask& task, int t) -> const Eigen::MatrixXd& {
+            if (t < 0 || t >= static_cast<int>(task.jacobian.size())) ThrowPretty("Invalid time index " << t);
+            return task.jacobian[t]; }, py::return_value_policy::reference_internal, "Read-only view of the kinematic Jacobian at time t, without copying")
+        .def("get_dPhi_dx_view", [](const TimeIndexedTask& task, int t) -> const Eigen::MatrixXd& {
+            if (t < 0 || t >= static_cast<int>(task.dPhi_dx.size())) ThrowPretty("Invalid time index " << t);
+            return task.dPhi_dx[t]; }, py::return_value_policy::reference_internal, "Read-only view of dPhi_dx at time t, without copying");
 
     py::class_<EndPoseTask, std::shared_ptr<EndPoseTask>>(module, "EndPoseTask")
         .def_readonly("length_Phi", &EndPoseTask::length_Phi)
@@ -919,14 +1041,160 @@ PYBIND11_MODULE(_pyexotica, module)
     motion_solver.def(
         "solve", [](std::shared_ptr<MotionSolver> sol) {
             Eigen::MatrixXd ret;
-            sol->Solve(ret);
+            {
+                // The solver does not call into Python; the result is converted once the GIL is reacquired
+                py::gil_scoped_release release;
+                sol->Solve(ret);
+            }
             return ret;
         },
         "Solve the problem");
+    motion_solver.def(
+        "solve_multi_start", [](std::shared_ptr<MotionSolver> sol, const std::vector<Eigen::VectorXd>& seeds) {
+            Eigen::MatrixXd ret;
+            {
+                py::gil_scoped_release release;
+                sol->SolveMultiStart(seeds, ret);
+            }
+            return ret;
+        },
+        "Solve the problem from each of the seeds (in parallel) and return the best solution", py::arg("seeds"));
+    motion_solver.def(
+        "solve_batch", [](std::shared_ptr<MotionSolver> sol, const std::vector<std::map<std::string, Eigen::VectorXd>>& targets, const std::vector<Eigen::VectorXd>& seeds) {
+            std::vector<Eigen::VectorXd> solutions;
+            std::vector<bool> success;
+            {
+                py::gil_scoped_release release;
+                sol->SolveBatch(targets, seeds, solutions, success);
+            }
+            return std::make_tuple(solutions, success);
+        },
+        "Solve the problem for each of the targets (dicts of task goals) from each of the seeds (in parallel), returns the best solution and whether it succeeded for each target", py::arg("targets"), py::arg("seeds"));
+    motion_solver.def_property("multi_start_num_threads", &MotionSolver::GetMultiStartNumThreads, &MotionSolver::SetMultiStartNumThreads);
     motion_solver.def("get_problem", &MotionSolver::GetProblem);
 
+    py::class_<PipelinePool, std::shared_ptr<PipelinePool>> pipeline_pool(module, "PipelinePool", "Pool of solvers and problems instantiated once and reset for every request");
+    pipeline_pool.def(py::init<const Initializer&, const Initializer&, int>(), py::arg("solver"), py::arg("problem"), py::arg("size") = 0);
+    pipeline_pool.def(py::init<const std::string&, int>(), py::arg("file_name"), py::arg("size") = 0);
+    pipeline_pool.def("acquire", &PipelinePool::Acquire, "Returns a solver with a clean problem, waits for one to be released if all are in use. The solver returns to the pool once it is no longer referenced.", py::call_guard<py::gil_scoped_release>());
+    pipeline_pool.def("try_acquire", &PipelinePool::TryAcquire, "Returns a solver with a clean problem, or None if all are in use.", py::call_guard<py::gil_scoped_release>());
+    pipeline_pool.def("get_reference_problem", &PipelinePool::GetReferenceProblem);
+    pipeline_pool.def_property_readonly("size", &PipelinePool::GetSize);
+    pipeline_pool.def_property_readonly("num_available", &PipelinePool::GetNumAvailable);
+
+    py::class_<FeedbackPolicy, std::shared_ptr<FeedbackPolicy>>(module, "FeedbackPolicy")
+        .def("get_control", &FeedbackPolicy::GetControl, py::arg("x"), py::arg("t"))
+        .def_property_readonly("T", &FeedbackPolicy::get_T)
+        .def_property_readonly("X_ref", &FeedbackPolicy::get_X_ref)
+        .def_property_readonly("U_ref", &FeedbackPolicy::get_U_ref)
+        .def_property_readonly("k", &FeedbackPolicy::get_k)
+        .def_property_readonly("K", &FeedbackPolicy::get_K);
+
     py::class_<FeedbackMotionSolver, std::shared_ptr<FeedbackMotionSolver>, MotionSolver> feedback_motion_solver(module, "FeedbackMotionSolver");
     feedback_motion_solver.def("get_feedback_control", &FeedbackMotionSolver::GetFeedbackControl);
+    feedback_motion_solver.def("get_feedback_policy", [](FeedbackMotionSolver* instance) { return std::const_pointer_cast<FeedbackPolicy>(instance->GetFeedbackPolicy()); }, "Returns the immutable feedback policy exported by the last solve");
+    feedback_motion_solver.def("get_published_feedback_control", &FeedbackMotionSolver::GetPublishedFeedbackControl, "Evaluates the exported feedback policy without waiting for a running solve", py::arg("x"), py::arg("t"), py::call_guard<py::gil_scoped_release>());
+
+    py::class_<TrajectoryFileWriter, std::shared_ptr<TrajectoryFileWriter>>(module, "TrajectoryFileWriter")
+        .def(py::init<const std::string&, const std::vector<std::string>&, double, int>(), py::arg("file_name"), py::arg("joint_names"), py::arg("dt"), py::arg("num_controls") = 0)
+        .def("write", (void (TrajectoryFileWriter::*)(Eigen::MatrixXdRefConst)) & TrajectoryFileWriter::Write, py::call_guard<py::gil_scoped_release>(), py::arg("states"))
+        .def("write", (void (TrajectoryFileWriter::*)(Eigen::MatrixXdRefConst, Eigen::MatrixXdRefConst)) & TrajectoryFileWriter::Write, py::call_guard<py::gil_scoped_release>(), py::arg("states"), py::arg("controls"))
+        .def("flush", &TrajectoryFileWriter::Flush)
+        .def("close", &TrajectoryFileWriter::Close)
+        .def_property_readonly("num_trajectories", &TrajectoryFileWriter::GetNumberOfTrajectories);
+
+    py::class_<TrajectoryFileReader, std::shared_ptr<TrajectoryFileReader>>(module, "TrajectoryFileReader")
+        .def(py::init<const std::string&>(), py::arg("file_name"))
+        .def_property_readonly("joint_names", &TrajectoryFileReader::GetJointNames)
+        .def_property_readonly("dt", &TrajectoryFileReader::GetTimeStep)
+        .def_property_readonly("num_controls", &TrajectoryFileReader::GetNumberOfControls)
+        .def("__len__", &TrajectoryFileReader::GetNumberOfTrajectories)
+        .def(
+            "get_states", [](py::object self, std::size_t index) { return TrajectoryFileDataView(self.cast<const TrajectoryFileReader&>().GetStates(index), self); }, "Read-only view of the states (one row per time step), without copying", py::arg("index"))
+        .def(
+            "get_controls", [](py::object self, std::size_t index) { return TrajectoryFileDataView(self.cast<const TrajectoryFileReader&>().GetControls(index), self); }, "Read-only view of the controls (one row per time step), without copying", py::arg("index"));
+
+    py::class_<RemoteSolveRequest>(module, "RemoteSolveRequest")
+        .def(py::init())
+        .def_readwrite("start_state", &RemoteSolveRequest::start_state)
+        .def_readwrite("start_time", &RemoteSolveRequest::start_time)
+        .def_readwrite("task_goals", &RemoteSolveRequest::task_goals)
+        .def_readwrite("goal_state", &RemoteSolveRequest::goal_state)
+        .def_readwrite("initial_trajectory", &RemoteSolveRequest::initial_trajectory);
+
+    py::class_<RemoteSolveResult>(module, "RemoteSolveResult")
+        .def(py::init())
+        .def_readwrite("success", &RemoteSolveResult::success)
+        .def_readwrite("error", &RemoteSolveResult::error)
+        .def_readwrite("solution", &RemoteSolveResult::solution)
+        .def_readwrite("planning_time", &RemoteSolveResult::planning_time)
+        .def_readwrite("termination_criterion", &RemoteSolveResult::termination_criterion)
+        .def_readwrite("iterations", &RemoteSolveResult::iterations);
+
+    py::class_<RemoteSolveServer, std::shared_ptr<RemoteSolveServer>>(module, "RemoteSolveServer", "Solves the requests of remote clients on pre-instantiated pipelines")
+        .def(py::init<const std::string&, int>(), py::arg("url"), py::arg("pool_size") = 0)
+        .def("add_configuration", (void (RemoteSolveServer::*)(const Initializer&, const Initializer&)) & RemoteSolveServer::AddConfiguration, py::arg("solver"), py::arg("problem"))
+        .def("add_configuration", (void (RemoteSolveServer::*)(const std::string&)) & RemoteSolveServer::AddConfiguration, py::arg("file_name"))
+        .def("run", &RemoteSolveServer::Run, py::call_guard<py::gil_scoped_release>())
+        .def("stop", &RemoteSolveServer::Stop);
+
+    py::class_<RemoteSolveClient, std::shared_ptr<RemoteSolveClient>>(module, "RemoteSolveClient", "Ships requests to remote solve servers")
+        .def(py::init<const std::vector<std::string>&, const Initializer&, const Initializer&, int>(), py::arg("urls"), py::arg("solver"), py::arg("problem"), py::arg("timeout_ms") = 60000)
+        .def(py::init<const std::vector<std::string>&, const std::string&, int>(), py::arg("urls"), py::arg("file_name"), py::arg("timeout_ms") = 60000)
+        .def(
+            "solve", [](RemoteSolveClient& instance, const RemoteSolveRequest& request) { return instance.Solve(request); }, py::call_guard<py::gil_scoped_release>(), py::arg("request"))
+        .def(
+            "solve_batch", [](RemoteSolveClient& instance, const std::vector<RemoteSolveRequest>& requests) { return instance.SolveBatch(requests); }, py::call_guard<py::gil_scoped_release>(), py::arg("requests"))
+        .def_property_readonly("configuration_hash", &RemoteSolveClient::GetConfigurationHash);
+
+    py::class_<Experience>(module, "Experience")
+        .def(py::init())
+        .def_readwrite("problem_type", &Experience::problem_type)
+        .def_readwrite("scene_hash", &Experience::scene_hash)
+        .def_readwrite("start", &Experience::start)
+        .def_readwrite("goal", &Experience::goal)
+        .def_readwrite("solution", &Experience::solution)
+        .def_readwrite("cost", &Experience::cost);
+
+    py::class_<ExperienceStore, std::shared_ptr<ExperienceStore>>(module, "ExperienceStore", "Solutions of previous planning queries, retrieved by nearest neighbour to warm start similar queries")
+        .def(py::init<std::size_t, double>(), py::arg("capacity") = 1000, py::arg("goal_weight") = 1.0)
+        .def("add", (void (ExperienceStore::*)(const Experience&)) & ExperienceStore::Add, py::arg("experience"))
+        .def("add", (void (ExperienceStore::*)(const PlanningProblemPtr&, Eigen::VectorXdRefConst, Eigen::MatrixXdRefConst, double)) & ExperienceStore::Add, py::arg("problem"), py::arg("goal"), py::arg("solution"), py::arg("cost"))
+        .def("find_nearest", &ExperienceStore::FindNearest, py::arg("problem_type"), py::arg("scene_hash"), py::arg("start"), py::arg("goal"), py::arg("k") = 1, py::arg("max_distance") = std::numeric_limits<double>::infinity())
+        .def(
+            "warm_start", [](const ExperienceStore& instance, const PlanningProblemPtr& problem, Eigen::VectorXdRefConst goal, std::size_t k, double max_distance) -> py::object {
+                Eigen::MatrixXd seed;
+                if (!instance.WarmStart(problem, goal, seed, k, max_distance)) return py::none();
+                return py::cast(seed);
+            },
+            "Seeds the problem from the nearest experiences and returns the seed, or None if there is none", py::arg("problem"), py::arg("goal"), py::arg("k") = 5, py::arg("max_distance") = std::numeric_limits<double>::infinity())
+        .def("clear", &ExperienceStore::Clear)
+        .def("__len__", &ExperienceStore::Size)
+        .def_property("capacity", &ExperienceStore::GetCapacity, &ExperienceStore::SetCapacity)
+        .def_static("hash_scene", &ExperienceStore::HashScene, py::arg("scene"))
+        .def_static("resample_trajectory", &ExperienceStore::ResampleTrajectory, py::arg("trajectory"), py::arg("rows"));
+
+    py::class_<IterationRecord>(module, "IterationRecord")
+        .def(py::init())
+        .def_readwrite("iteration", &IterationRecord::iteration)
+        .def_readwrite("time", &IterationRecord::time)
+        .def_readwrite("cost", &IterationRecord::cost)
+        .def_readwrite("step_length", &IterationRecord::step_length)
+        .def_readwrite("regularization", &IterationRecord::regularization)
+        .def_readwrite("constraint_violation", &IterationRecord::constraint_violation)
+        .def_readwrite("phase_durations", &IterationRecord::phase_durations);
+
+    py::class_<ProblemRecorder, std::shared_ptr<ProblemRecorder>>(module, "ProblemRecorder", "Writes the inputs of a problem to a binary log, see PlanningProblem.recorder")
+        .def(py::init<const std::string&>(), py::arg("file_name"))
+        .def("flush", &ProblemRecorder::Flush)
+        .def_property_readonly("num_events", &ProblemRecorder::GetNumberOfEvents);
+
+    py::class_<ProblemLog, std::shared_ptr<ProblemLog>>(module, "ProblemLog", "Log written by a ProblemRecorder")
+        .def(py::init<const std::string&>(), py::arg("file_name"))
+        .def_property_readonly("problem_type", &ProblemLog::GetProblemType)
+        .def_property_readonly("problem_dimension", &ProblemLog::GetProblemDimension)
+        .def("__len__", [](const ProblemLog& instance) { return instance.GetEvents().size(); })
+        .def("replay", &ProblemLog::Replay, "Applies the recorded events to the problem and returns the wall time of each event (s)", py::arg("problem"));
 
     py::class_<PlanningProblem, std::shared_ptr<PlanningProblem>, Object>(module, "PlanningProblem")
         .def("get_tasks", &PlanningProblem::GetTasks, py::return_value_policy::reference_internal)
@@ -943,9 +1211,14 @@ PYBIND11_MODULE(_pyexotica, module)
         .def("reset_number_of_problem_updates", &PlanningProblem::ResetNumberOfProblemUpdates)
         .def("get_cost_evolution", (std::pair<std::vector<double>, std::vector<double>>(PlanningProblem::*)() const) & PlanningProblem::GetCostEvolution)
         .def("get_number_of_iterations", &PlanningProblem::GetNumberOfIterations)
+        .def("read_iteration_records", [](const PlanningProblem* instance, std::uint64_t count_since) {
+            std::vector<IterationRecord> records;
+            const std::uint64_t count = instance->GetIterationTelemetry().Read(count_since, records);
+            return std::make_tuple(count, records); }, "Returns the number of iteration records pushed so far and the records pushed since count_since, also while solving in another thread", py::arg("count_since") = 0)
         .def("pre_update", &PlanningProblem::PreUpdate)
         .def("is_valid", &PlanningProblem::IsValid)
         .def("apply_start_state", &PlanningProblem::ApplyStartState)
+        .def_property("recorder", &PlanningProblem::GetRecorder, &PlanningProblem::SetRecorder, "Records the inputs of the problem, None stops recording")
         .def_readonly("termination_criterion", &PlanningProblem::termination_criterion);
 
     // Problem types
@@ -953,8 +1226,8 @@ PYBIND11_MODULE(_pyexotica, module)
 
     py::class_<UnconstrainedTimeIndexedProblem, std::shared_ptr<UnconstrainedTimeIndexedProblem>, PlanningProblem> unconstrained_time_indexed_problem(prob, "UnconstrainedTimeIndexedProblem");
     unconstrained_time_indexed_problem.def("get_duration", &UnconstrainedTimeIndexedProblem::GetDuration);
-    unconstrained_time_indexed_problem.def("update", (void (UnconstrainedTimeIndexedProblem::*)(Eigen::VectorXdRefConst, int)) & UnconstrainedTimeIndexedProblem::Update);
-    unconstrained_time_indexed_problem.def("update", (void (UnconstrainedTimeIndexedProblem::*)(Eigen::VectorXdRefConst)) & UnconstrainedTimeIndexedProblem::Update);
+    unconstrained_time_indexed_problem.def("update", (void (UnconstrainedTimeIndexedProblem::*)(Eigen::VectorXdRefConst, int)) & UnconstrainedTimeIndexedProblem::Update, py::call_guard<py::gil_scoped_release>());
+    unconstrained_time_indexed_problem.def("update", (void (UnconstrainedTimeIndexedProblem::*)(Eigen::VectorXdRefConst)) & UnconstrainedTimeIndexedProblem::Update, py::call_guard<py::gil_scoped_release>());
     unconstrained_time_indexed_problem.def("set_goal", &UnconstrainedTimeIndexedProblem::SetGoal);
     unconstrained_time_indexed_problem.def("set_rho", &UnconstrainedTimeIndexedProblem::SetRho);
     unconstrained_time_indexed_problem.def("get_goal", &UnconstrainedTimeIndexedProblem::GetGoal);
@@ -963,21 +1236,30 @@ PYBIND11_MODULE(_pyexotica, module)
     unconstrained_time_indexed_problem.def_readwrite("W", &UnconstrainedTimeIndexedProblem::W);
     unconstrained_time_indexed_problem.def_property("initial_trajectory", &UnconstrainedTimeIndexedProblem::GetInitialTrajectory, &UnconstrainedTimeIndexedProblem::SetInitialTrajectory);
     unconstrained_time_indexed_problem.def_property("T", &UnconstrainedTimeIndexedProblem::GetT, &UnconstrainedTimeIndexedProblem::SetT);
+    unconstrained_time_indexed_problem.def_property("trajectory_num_threads", &UnconstrainedTimeIndexedProblem::GetTrajectoryNumThreads, &UnconstrainedTimeIndexedProblem::SetTrajectoryNumThreads);
+    unconstrained_time_indexed_problem.def_property("skip_unchanged_time_steps", &UnconstrainedTimeIndexedProblem::GetSkipUnchangedTimeSteps, &UnconstrainedTimeIndexedProblem::SetSkipUnchangedTimeSteps);
+    unconstrained_time_indexed_problem.def("invalidate_time_steps", &UnconstrainedTimeIndexedProblem::InvalidateTimeSteps);
+    unconstrained_time_indexed_problem.def("shift_trajectory", &UnconstrainedTimeIndexedProblem::ShiftTrajectory, py::arg("k"));
+    unconstrained_time_indexed_problem.def("set_resolution", &UnconstrainedTimeIndexedProblem::SetResolution, py::arg("T"));
+    unconstrained_time_indexed_problem.def_property_readonly("number_of_recomputed_time_steps", &UnconstrainedTimeIndexedProblem::GetNumberOfRecomputedTimeSteps);
     unconstrained_time_indexed_problem.def_readonly("length_Phi", &UnconstrainedTimeIndexedProblem::length_Phi);
     unconstrained_time_indexed_problem.def_readonly("length_jacobian", &UnconstrainedTimeIndexedProblem::length_jacobian);
     unconstrained_time_indexed_problem.def_readonly("num_tasks", &UnconstrainedTimeIndexedProblem::num_tasks);
     unconstrained_time_indexed_problem.def_readonly("Phi", &UnconstrainedTimeIndexedProblem::Phi);
     unconstrained_time_indexed_problem.def_readonly("jacobian", &UnconstrainedTimeIndexedProblem::jacobian);
+    unconstrained_time_indexed_problem.def("get_jacobian_view", [](UnconstrainedTimeIndexedProblem* instance, int t) -> const Eigen::MatrixXd& {
+        if (t < 0 || t >= static_cast<int>(instance->jacobian.size())) ThrowPretty("Invalid time index " << t);
+        return instance->jacobian[t]; }, py::return_value_policy::reference_internal, "Read-only view of the stacked task Jacobian at time t, without copying");
     unconstrained_time_indexed_problem.def("get_scalar_task_cost", &UnconstrainedTimeIndexedProblem::GetScalarTaskCost);
-    unconstrained_time_indexed_problem.def("get_scalar_task_jacobian", &UnconstrainedTimeIndexedProblem::GetScalarTaskJacobian);
+    unconstrained_time_indexed_problem.def("get_scalar_task_jacobian", py::overload_cast<int>(&UnconstrainedTimeIndexedProblem::GetScalarTaskJacobian, py::const_));
     unconstrained_time_indexed_problem.def("get_scalar_transition_cost", &UnconstrainedTimeIndexedProblem::GetScalarTransitionCost);
-    unconstrained_time_indexed_problem.def("get_scalar_transition_jacobian", &UnconstrainedTimeIndexedProblem::GetScalarTransitionJacobian);
+    unconstrained_time_indexed_problem.def("get_scalar_transition_jacobian", py::overload_cast<int>(&UnconstrainedTimeIndexedProblem::GetScalarTransitionJacobian, py::const_));
     unconstrained_time_indexed_problem.def_readonly("cost", &UnconstrainedTimeIndexedProblem::cost);
 
     py::class_<TimeIndexedProblem, std::shared_ptr<TimeIndexedProblem>, PlanningProblem> time_indexed_problem(prob, "TimeIndexedProblem");
     time_indexed_problem.def("get_duration", &TimeIndexedProblem::GetDuration);
-    time_indexed_problem.def("update", (void (TimeIndexedProblem::*)(Eigen::VectorXdRefConst, int)) & TimeIndexedProblem::Update);
-    time_indexed_problem.def("update", (void (TimeIndexedProblem::*)(Eigen::VectorXdRefConst)) & TimeIndexedProblem::Update);
+    time_indexed_problem.def("update", (void (TimeIndexedProblem::*)(Eigen::VectorXdRefConst, int)) & TimeIndexedProblem::Update, py::call_guard<py::gil_scoped_release>());
+    time_indexed_problem.def("update", (void (TimeIndexedProblem::*)(Eigen::VectorXdRefConst)) & TimeIndexedProblem::Update, py::call_guard<py::gil_scoped_release>());
     time_indexed_problem.def("set_goal", &TimeIndexedProblem::SetGoal);
     time_indexed_problem.def("set_rho", &TimeIndexedProblem::SetRho);
     time_indexed_problem.def("get_goal", &TimeIndexedProblem::GetGoal);
@@ -996,17 +1278,27 @@ PYBIND11_MODULE(_pyexotica, module)
     time_indexed_problem.def_readwrite("use_bounds", &TimeIndexedProblem::use_bounds);
     time_indexed_problem.def_property("initial_trajectory", &TimeIndexedProblem::GetInitialTrajectory, &TimeIndexedProblem::SetInitialTrajectory);
     time_indexed_problem.def_property("T", &TimeIndexedProblem::GetT, &TimeIndexedProblem::SetT);
+    time_indexed_problem.def_property("trajectory_num_threads", &TimeIndexedProblem::GetTrajectoryNumThreads, &TimeIndexedProblem::SetTrajectoryNumThreads);
+    time_indexed_problem.def_property("skip_unchanged_time_steps", &TimeIndexedProblem::GetSkipUnchangedTimeSteps, &TimeIndexedProblem::SetSkipUnchangedTimeSteps);
+    time_indexed_problem.def("invalidate_time_steps", &TimeIndexedProblem::InvalidateTimeSteps);
+    time_indexed_problem.def("shift_trajectory", &TimeIndexedProblem::ShiftTrajectory, py::arg("k"));
+    time_indexed_problem.def("set_resolution", &TimeIndexedProblem::SetResolution, py::arg("T"));
+    time_indexed_problem.def_property_readonly("number_of_recomputed_time_steps", &TimeIndexedProblem::GetNumberOfRecomputedTimeSteps);
     time_indexed_problem.def_readonly("length_Phi", &TimeIndexedProblem::length_Phi);
     time_indexed_problem.def_readonly("length_jacobian", &TimeIndexedProblem::length_jacobian);
     time_indexed_problem.def_readonly("num_tasks", &TimeIndexedProblem::num_tasks);
     time_indexed_problem.def_readonly("Phi", &TimeIndexedProblem::Phi);
     time_indexed_problem.def_readonly("jacobian", &TimeIndexedProblem::jacobian);
+    time_indexed_problem.def("get_jacobian_view", [](TimeIndexedProblem* instance, int t) -> const Eigen::MatrixXd& {
+        if (t < 0 || t >= static_cast<int>(instance->jacobian.size())) ThrowPretty("Invalid time index " << t);
+        return instance->jacobian[t]; }, py::return_value_policy::reference_internal, "Read-only view of the stacked task Jacobian at time t, without copying");
     time_indexed_problem.def("get_cost", &TimeIndexedProblem::GetCost);
-    time_indexed_problem.def("get_cost_jacobian", &TimeIndexedProblem::GetCostJacobian);
+    time_indexed_problem.def("get_cost_jacobian", py::overload_cast<>(&TimeIndexedProblem::GetCostJacobian, py::const_));
+    time_indexed_problem.def("get_cost_jacobian", py::overload_cast<Eigen::Ref<Eigen::RowVectorXd>>(&TimeIndexedProblem::GetCostJacobian, py::const_), "Writes the cost Jacobian into a preallocated contiguous float64 array", py::arg("out"));
     time_indexed_problem.def("get_scalar_task_cost", &TimeIndexedProblem::GetScalarTaskCost);
-    time_indexed_problem.def("get_scalar_task_jacobian", &TimeIndexedProblem::GetScalarTaskJacobian);
+    time_indexed_problem.def("get_scalar_task_jacobian", py::overload_cast<int>(&TimeIndexedProblem::GetScalarTaskJacobian, py::const_));
     time_indexed_problem.def("get_scalar_transition_cost", &TimeIndexedProblem::GetScalarTransitionCost);
-    time_indexed_problem.def("get_scalar_transition_jacobian", &TimeIndexedProblem::GetScalarTransitionJacobian);
+    time_indexed_problem.def("get_scalar_transition_jacobian", py::overload_cast<int>(&TimeIndexedProblem::GetScalarTransitionJacobian, py::const_));
     time_indexed_problem.def("get_equality", (Eigen::VectorXd(TimeIndexedProblem::*)() const) & TimeIndexedProblem::GetEquality);
     time_indexed_problem.def("get_equality", (Eigen::VectorXd(TimeIndexedProblem::*)(int) const) & TimeIndexedProblem::GetEquality);
     time_indexed_problem.def("get_equality_jacobian", (Eigen::SparseMatrix<double>(TimeIndexedProblem::*)() const) & TimeIndexedProblem::GetEqualityJacobian);
@@ -1015,6 +1307,13 @@ PYBIND11_MODULE(_pyexotica, module)
     time_indexed_problem.def("get_inequality", (Eigen::VectorXd(TimeIndexedProblem::*)(int) const) & TimeIndexedProblem::GetInequality);
     time_indexed_problem.def("get_inequality_jacobian", (Eigen::SparseMatrix<double>(TimeIndexedProblem::*)() const) & TimeIndexedProblem::GetInequalityJacobian);
     time_indexed_problem.def("get_inequality_jacobian", (Eigen::MatrixXd(TimeIndexedProblem::*)(int) const) & TimeIndexedProblem::GetInequalityJacobian);
+    time_indexed_problem.def("get_equality_jacobian_structured", &TimeIndexedProblem::GetEqualityJacobianStructured);
+    time_indexed_problem.def("get_inequality_jacobian_structured", &TimeIndexedProblem::GetInequalityJacobianStructured);
+    time_indexed_problem.def("get_cost_hessian", &TimeIndexedProblem::GetCostHessianStructured);
+    time_indexed_problem.def("get_equality_jacobian_csc", [](py::object self) { return SparseMatrixCSCView(self.cast<TimeIndexedProblem*>()->GetEqualityJacobianStructured(), self); }, "Equality Jacobian as ((data, indices, indptr), shape) for scipy.sparse.csc_matrix, without copying. Valid until the active constraints or T change");
+    time_indexed_problem.def("get_inequality_jacobian_csc", [](py::object self) { return SparseMatrixCSCView(self.cast<TimeIndexedProblem*>()->GetInequalityJacobianStructured(), self); }, "Inequality Jacobian as ((data, indices, indptr), shape) for scipy.sparse.csc_matrix, without copying. Valid until the active constraints or T change");
+    time_indexed_problem.def("get_cost_hessian_csc", [](py::object self) { return SparseMatrixCSCView(self.cast<TimeIndexedProblem*>()->GetCostHessianStructured(), self); }, "Cost Hessian as ((data, indices, indptr), shape) for scipy.sparse.csc_matrix, without copying. Valid until T changes");
+    time_indexed_problem.def("get_cost_hessian_vector_product", (Eigen::VectorXd(TimeIndexedProblem::*)(Eigen::VectorXdRefConst) const) & TimeIndexedProblem::GetCostHessianVectorProduct, "Hessian of the cost times v, without forming the Hessian", py::arg("v"));
     time_indexed_problem.def("get_bounds", &TimeIndexedProblem::GetBounds);
     time_indexed_problem.def("get_joint_velocity_limits", &TimeIndexedProblem::GetJointVelocityLimits);
     time_indexed_problem.def_readonly("cost", &TimeIndexedProblem::cost);
@@ -1023,8 +1322,8 @@ PYBIND11_MODULE(_pyexotica, module)
 
     py::class_<BoundedTimeIndexedProblem, std::shared_ptr<BoundedTimeIndexedProblem>, PlanningProblem> bounded_time_indexed_problem(prob, "BoundedTimeIndexedProblem");
     bounded_time_indexed_problem.def("get_duration", &BoundedTimeIndexedProblem::GetDuration);
-    bounded_time_indexed_problem.def("update", (void (BoundedTimeIndexedProblem::*)(Eigen::VectorXdRefConst, int)) & BoundedTimeIndexedProblem::Update);
-    bounded_time_indexed_problem.def("update", (void (BoundedTimeIndexedProblem::*)(Eigen::VectorXdRefConst)) & BoundedTimeIndexedProblem::Update);
+    bounded_time_indexed_problem.def("update", (void (BoundedTimeIndexedProblem::*)(Eigen::VectorXdRefConst, int)) & BoundedTimeIndexedProblem::Update, py::call_guard<py::gil_scoped_release>());
+    bounded_time_indexed_problem.def("update", (void (BoundedTimeIndexedProblem::*)(Eigen::VectorXdRefConst)) & BoundedTimeIndexedProblem::Update, py::call_guard<py::gil_scoped_release>());
     bounded_time_indexed_problem.def("set_goal", &BoundedTimeIndexedProblem::SetGoal);
     bounded_time_indexed_problem.def("set_rho", &BoundedTimeIndexedProblem::SetRho);
     bounded_time_indexed_problem.def("get_goal", &BoundedTimeIndexedProblem::GetGoal);
@@ -1033,20 +1332,33 @@ PYBIND11_MODULE(_pyexotica, module)
     bounded_time_indexed_problem.def_readwrite("W", &BoundedTimeIndexedProblem::W);
     bounded_time_indexed_problem.def_property("initial_trajectory", &BoundedTimeIndexedProblem::GetInitialTrajectory, &BoundedTimeIndexedProblem::SetInitialTrajectory);
     bounded_time_indexed_problem.def_property("T", &BoundedTimeIndexedProblem::GetT, &BoundedTimeIndexedProblem::SetT);
+    bounded_time_indexed_problem.def_property("trajectory_num_threads", &BoundedTimeIndexedProblem::GetTrajectoryNumThreads, &BoundedTimeIndexedProblem::SetTrajectoryNumThreads);
+    bounded_time_indexed_problem.def_property("skip_unchanged_time_steps", &BoundedTimeIndexedProblem::GetSkipUnchangedTimeSteps, &BoundedTimeIndexedProblem::SetSkipUnchangedTimeSteps);
+    bounded_time_indexed_problem.def("invalidate_time_steps", &BoundedTimeIndexedProblem::InvalidateTimeSteps);
+    bounded_time_indexed_problem.def("shift_trajectory", &BoundedTimeIndexedProblem::ShiftTrajectory, py::arg("k"));
+    bounded_time_indexed_problem.def("set_resolution", &BoundedTimeIndexedProblem::SetResolution, py::arg("T"));
+    bounded_time_indexed_problem.def_property_readonly("number_of_recomputed_time_steps", &BoundedTimeIndexedProblem::GetNumberOfRecomputedTimeSteps);
     bounded_time_indexed_problem.def_readonly("length_Phi", &BoundedTimeIndexedProblem::length_Phi);
     bounded_time_indexed_problem.def_readonly("length_jacobian", &BoundedTimeIndexedProblem::length_jacobian);
     bounded_time_indexed_problem.def_readonly("num_tasks", &BoundedTimeIndexedProblem::num_tasks);
     bounded_time_indexed_problem.def_readonly("Phi", &BoundedTimeIndexedProblem::Phi);
     bounded_time_indexed_problem.def_readonly("jacobian", &BoundedTimeIndexedProblem::jacobian);
     bounded_time_indexed_problem.def("get_scalar_task_cost", &BoundedTimeIndexedProblem::GetScalarTaskCost);
-    bounded_time_indexed_problem.def("get_scalar_task_jacobian", &BoundedTimeIndexedProblem::GetScalarTaskJacobian);
+    bounded_time_indexed_problem.def("get_scalar_task_jacobian", py::overload_cast<int>(&BoundedTimeIndexedProblem::GetScalarTaskJacobian, py::const_));
     bounded_time_indexed_problem.def("get_scalar_transition_cost", &BoundedTimeIndexedProblem::GetScalarTransitionCost);
-    bounded_time_indexed_problem.def("get_scalar_transition_jacobian", &BoundedTimeIndexedProblem::GetScalarTransitionJacobian);
+    bounded_time_indexed_problem.def("get_scalar_transition_jacobian", py::overload_cast<int>(&BoundedTimeIndexedProblem::GetScalarTransitionJacobian, py::const_));
     bounded_time_indexed_problem.def("get_bounds", &BoundedTimeIndexedProblem::GetBounds);
     bounded_time_indexed_problem.def_readonly("cost", &BoundedTimeIndexedProblem::cost);
 
     py::class_<UnconstrainedEndPoseProblem, std::shared_ptr<UnconstrainedEndPoseProblem>, PlanningProblem> unconstrained_end_pose_problem(prob, "UnconstrainedEndPoseProblem");
-    unconstrained_end_pose_problem.def("update", &UnconstrainedEndPoseProblem::Update);
+    unconstrained_end_pose_problem.def("update", static_cast<void (UnconstrainedEndPoseProblem::*)(Eigen::VectorXdRefConst)>(&UnconstrainedEndPoseProblem::Update), py::call_guard<py::gil_scoped_release>());
+    unconstrained_end_pose_problem.def("update_cost", &UnconstrainedEndPoseProblem::UpdateCost, py::call_guard<py::gil_scoped_release>());
+    unconstrained_end_pose_problem.def("update_fused", [](UnconstrainedEndPoseProblem* prob, Eigen::VectorXdRefConst x) {
+        Eigen::VectorXd JT_times_yd(prob->N);
+        Eigen::MatrixXd JT_times_J(prob->N, prob->N);
+        const double cost = prob->UpdateFused(x, JT_times_yd, JT_times_J);
+        return std::make_tuple(cost, JT_times_yd, JT_times_J);
+    });
     unconstrained_end_pose_problem.def("set_goal", &UnconstrainedEndPoseProblem::SetGoal);
     unconstrained_end_pose_problem.def("set_rho", &UnconstrainedEndPoseProblem::SetRho);
     unconstrained_end_pose_problem.def("get_goal", &UnconstrainedEndPoseProblem::GetGoal);
@@ -1060,12 +1372,12 @@ PYBIND11_MODULE(_pyexotica, module)
     unconstrained_end_pose_problem.def_property_readonly("ydiff", [](UnconstrainedEndPoseProblem* prob) { return prob->cost.ydiff; });
     unconstrained_end_pose_problem.def_property("q_nominal", &UnconstrainedEndPoseProblem::GetNominalPose, &UnconstrainedEndPoseProblem::SetNominalPose);
     unconstrained_end_pose_problem.def("get_scalar_cost", &UnconstrainedEndPoseProblem::GetScalarCost);
-    unconstrained_end_pose_problem.def("get_scalar_jacobian", &UnconstrainedEndPoseProblem::GetScalarJacobian);
+    unconstrained_end_pose_problem.def("get_scalar_jacobian", py::overload_cast<>(&UnconstrainedEndPoseProblem::GetScalarJacobian, py::const_));
     unconstrained_end_pose_problem.def("get_scalar_task_cost", &UnconstrainedEndPoseProblem::GetScalarTaskCost);
     unconstrained_end_pose_problem.def_readonly("cost", &UnconstrainedEndPoseProblem::cost);
 
     py::class_<EndPoseProblem, std::shared_ptr<EndPoseProblem>, PlanningProblem> end_pose_problem(prob, "EndPoseProblem");
-    end_pose_problem.def("update", &EndPoseProblem::Update);
+    end_pose_problem.def("update", &EndPoseProblem::Update, py::call_guard<py::gil_scoped_release>());
     end_pose_problem.def("pre_update", &EndPoseProblem::PreUpdate);
     end_pose_problem.def("set_goal", &EndPoseProblem::SetGoal);
     end_pose_problem.def("set_rho", &EndPoseProblem::SetRho);
@@ -1087,7 +1399,7 @@ PYBIND11_MODULE(_pyexotica, module)
     end_pose_problem.def_readonly("Phi", &EndPoseProblem::Phi);
     end_pose_problem.def_readonly("jacobian", &EndPoseProblem::jacobian);
     end_pose_problem.def("get_scalar_cost", &EndPoseProblem::GetScalarCost);
-    end_pose_problem.def("get_scalar_jacobian", &EndPoseProblem::GetScalarJacobian);
+    end_pose_problem.def("get_scalar_jacobian", py::overload_cast<>(&EndPoseProblem::GetScalarJacobian));
     end_pose_problem.def("get_scalar_task_cost", &EndPoseProblem::GetScalarTaskCost);
     end_pose_problem.def("get_equality", &EndPoseProblem::GetEquality);
     end_pose_problem.def("get_equality_jacobian", &EndPoseProblem::GetEqualityJacobian);
@@ -1099,7 +1411,7 @@ PYBIND11_MODULE(_pyexotica, module)
     end_pose_problem.def_readonly("equality", &EndPoseProblem::equality);
 
     py::class_<BoundedEndPoseProblem, std::shared_ptr<BoundedEndPoseProblem>, PlanningProblem> bounded_end_pose_problem(prob, "BoundedEndPoseProblem");
-    bounded_end_pose_problem.def("update", &BoundedEndPoseProblem::Update);
+    bounded_end_pose_problem.def("update", &BoundedEndPoseProblem::Update, py::call_guard<py::gil_scoped_release>());
     bounded_end_pose_problem.def("set_goal", &BoundedEndPoseProblem::SetGoal);
     bounded_end_pose_problem.def("set_rho", &BoundedEndPoseProblem::SetRho);
     bounded_end_pose_problem.def("get_goal", &BoundedEndPoseProblem::GetGoal);
@@ -1111,13 +1423,13 @@ PYBIND11_MODULE(_pyexotica, module)
     bounded_end_pose_problem.def_readonly("Phi", &BoundedEndPoseProblem::Phi);
     bounded_end_pose_problem.def_readonly("jacobian", &BoundedEndPoseProblem::jacobian);
     bounded_end_pose_problem.def("get_scalar_cost", &BoundedEndPoseProblem::GetScalarCost);
-    bounded_end_pose_problem.def("get_scalar_jacobian", &BoundedEndPoseProblem::GetScalarJacobian);
+    bounded_end_pose_problem.def("get_scalar_jacobian", py::overload_cast<>(&BoundedEndPoseProblem::GetScalarJacobian, py::const_));
     bounded_end_pose_problem.def("get_scalar_task_cost", &BoundedEndPoseProblem::GetScalarTaskCost);
     bounded_end_pose_problem.def("get_bounds", &BoundedEndPoseProblem::GetBounds);
     bounded_end_pose_problem.def_readonly("cost", &BoundedEndPoseProblem::cost);
 
     py::class_<SamplingProblem, std::shared_ptr<SamplingProblem>, PlanningProblem> sampling_problem(prob, "SamplingProblem");
-    sampling_problem.def("update", &SamplingProblem::Update);
+    sampling_problem.def("update", &SamplingProblem::Update, py::call_guard<py::gil_scoped_release>());
     sampling_problem.def_property("goal_state", &SamplingProblem::GetGoalState, &SamplingProblem::SetGoalState);
     sampling_problem.def("get_space_dim", &SamplingProblem::GetSpaceDim);
     sampling_problem.def("get_bounds", &SamplingProblem::GetBounds);
@@ -1133,10 +1445,12 @@ PYBIND11_MODULE(_pyexotica, module)
     sampling_problem.def("set_rho_neq", &SamplingProblem::SetRhoNEQ);
     sampling_problem.def("get_goal_neq", &SamplingProblem::GetGoalNEQ);
     sampling_problem.def("get_rho_neq", &SamplingProblem::GetRhoNEQ);
-    sampling_problem.def("is_state_valid", &SamplingProblem::IsStateValid);
+    sampling_problem.def("is_state_valid", (bool (SamplingProblem::*)(Eigen::VectorXdRefConst)) & SamplingProblem::IsStateValid);
+    sampling_problem.def("are_states_valid", &SamplingProblem::AreStatesValid, py::call_guard<py::gil_scoped_release>(), py::arg("states"), py::arg("stop_at_first_invalid") = true);
+    sampling_problem.def_property("validity_num_threads", &SamplingProblem::GetValidityNumThreads, &SamplingProblem::SetValidityNumThreads);
 
     py::class_<TimeIndexedSamplingProblem, std::shared_ptr<TimeIndexedSamplingProblem>, PlanningProblem> time_indexed_sampling_problem(prob, "TimeIndexedSamplingProblem");
-    time_indexed_sampling_problem.def("update", &TimeIndexedSamplingProblem::Update);
+    time_indexed_sampling_problem.def("update", &TimeIndexedSamplingProblem::Update, py::call_guard<py::gil_scoped_release>());
     time_indexed_sampling_problem.def("get_space_dim", &TimeIndexedSamplingProblem::GetSpaceDim);
     time_indexed_sampling_problem.def("get_bounds", &TimeIndexedSamplingProblem::GetBounds);
     time_indexed_sampling_problem.def_property("goal_state", &TimeIndexedSamplingProblem::GetGoalState, &TimeIndexedSamplingProblem::SetGoalState);
@@ -1154,6 +1468,9 @@ PYBIND11_MODULE(_pyexotica, module)
     time_indexed_sampling_problem.def("get_goal_neq", &TimeIndexedSamplingProblem::GetGoalNEQ);
     time_indexed_sampling_problem.def("get_rho_neq", &TimeIndexedSamplingProblem::GetRhoNEQ);
     time_indexed_sampling_problem.def("is_valid", (bool (TimeIndexedSamplingProblem::*)(Eigen::VectorXdRefConst, const double&)) & TimeIndexedSamplingProblem::IsValid);
+    time_indexed_sampling_problem.def("clear_validity_cache", &TimeIndexedSamplingProblem::ClearValidityCache);
+    time_indexed_sampling_problem.def_property_readonly("validity_cache_hits", &TimeIndexedSamplingProblem::GetValidityCacheHits);
+    time_indexed_sampling_problem.def_property_readonly("validity_cache_misses", &TimeIndexedSamplingProblem::GetValidityCacheMisses);
 
     py::enum_<ControlCostLossTermType>(module, "ControlCostLossTermType")
         // BimodalHuber = 3, SuperHuber = 4, <-- skipped as not actively used right now.
@@ -1164,12 +1481,41 @@ PYBIND11_MODULE(_pyexotica, module)
         .value("PseudoHuber", ControlCostLossTermType::PseudoHuber)
         .export_values();
 
+    py::class_<TrajectoryLinearization>(prob, "TrajectoryLinearization")
+        .def_readonly("fx", &TrajectoryLinearization::fx)
+        .def_readonly("fu", &TrajectoryLinearization::fu)
+        .def_readonly("lx", &TrajectoryLinearization::lx)
+        .def_readonly("lxx", &TrajectoryLinearization::lxx)
+        .def_readonly("lu", &TrajectoryLinearization::lu)
+        .def_readonly("luu", &TrajectoryLinearization::luu);
+
     py::class_<DynamicTimeIndexedShootingProblem, std::shared_ptr<DynamicTimeIndexedShootingProblem>, PlanningProblem>(prob, "DynamicTimeIndexedShootingProblem")
-        .def("update", (void (DynamicTimeIndexedShootingProblem::*)(Eigen::VectorXdRefConst, Eigen::VectorXdRefConst, int)) & DynamicTimeIndexedShootingProblem::Update)
-        .def("update", (void (DynamicTimeIndexedShootingProblem::*)(Eigen::VectorXdRefConst, int)) & DynamicTimeIndexedShootingProblem::Update)
+        .def("update", (void (DynamicTimeIndexedShootingProblem::*)(Eigen::VectorXdRefConst, Eigen::VectorXdRefConst, int)) & DynamicTimeIndexedShootingProblem::Update, py::call_guard<py::gil_scoped_release>())
+        .def("update", (void (DynamicTimeIndexedShootingProblem::*)(Eigen::VectorXdRefConst, int)) & DynamicTimeIndexedShootingProblem::Update, py::call_guard<py::gil_scoped_release>())
         .def("update_terminal_state", &DynamicTimeIndexedShootingProblem::UpdateTerminalState)
+        .def("rollout", [](DynamicTimeIndexedShootingProblem* instance, Eigen::VectorXdRefConst x0, const std::vector<Eigen::MatrixXd>& U_rollouts) {
+            Eigen::VectorXd costs;
+            std::vector<Eigen::MatrixXd> X_rollouts;
+            instance->Rollout(x0, U_rollouts, costs, X_rollouts);
+            return std::make_tuple(costs, X_rollouts); }, "Simulates the control trajectories from x0 in parallel and returns their costs and state trajectories", py::arg("x0"), py::arg("U_rollouts"), py::call_guard<py::gil_scoped_release>())
+        .def("linearize_trajectory", [](DynamicTimeIndexedShootingProblem* instance, Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U) {
+            TrajectoryLinearization linearization;
+            instance->LinearizeTrajectory(X, U, linearization);
+            return linearization; }, "Returns the derivatives of the dynamics about X, U and of the cost about the last update for all time steps", py::arg("X"), py::arg("U"), py::call_guard<py::gil_scoped_release>())
+        .def_property("rollout_num_threads", &DynamicTimeIndexedShootingProblem::GetRolloutNumThreads, &DynamicTimeIndexedShootingProblem::SetRolloutNumThreads)
+        .def("shift_trajectory", &DynamicTimeIndexedShootingProblem::ShiftTrajectory, py::arg("k"))
+        .def("set_resolution", &DynamicTimeIndexedShootingProblem::SetResolution, py::arg("T"))
+        .def("enable_stochastic_updates", &DynamicTimeIndexedShootingProblem::EnableStochasticUpdates)
+        .def("disable_stochastic_updates", &DynamicTimeIndexedShootingProblem::DisableStochasticUpdates)
+        .def("set_noise_seed", &DynamicTimeIndexedShootingProblem::SetNoiseSeed, py::arg("seed"))
+        .def("sample_noise", [](DynamicTimeIndexedShootingProblem* instance, std::uint64_t stream) {
+            Eigen::MatrixXd noise(2 * instance->GetScene()->get_num_state(), instance->get_T() - 1);
+            instance->SampleNoise(stream, noise);
+            return noise; }, "Returns the standard normal noise of a stream for the whole horizon", py::arg("stream"))
         .def_property("X", static_cast<const Eigen::MatrixXd& (DynamicTimeIndexedShootingProblem::*)(void)const>(&DynamicTimeIndexedShootingProblem::get_X), &DynamicTimeIndexedShootingProblem::set_X)
         .def_property("U", static_cast<const Eigen::MatrixXd& (DynamicTimeIndexedShootingProblem::*)(void)const>(&DynamicTimeIndexedShootingProblem::get_U), &DynamicTimeIndexedShootingProblem::set_U)
+        .def_property_readonly("X_view", &DynamicTimeIndexedShootingProblem::get_X_view, py::return_value_policy::reference_internal, "Writable view of X, without copying. Writes bypass set_X, so quaternions of a floating base are not normalised")
+        .def_property_readonly("U_view", &DynamicTimeIndexedShootingProblem::get_U_view, py::return_value_policy::reference_internal, "Writable view of U, without copying")
         .def_property("X_star", &DynamicTimeIndexedShootingProblem::get_X_star, &DynamicTimeIndexedShootingProblem::set_X_star)
         .def_property_readonly("tau", &DynamicTimeIndexedShootingProblem::get_tau)
         .def_property("T", &DynamicTimeIndexedShootingProblem::get_T, &DynamicTimeIndexedShootingProblem::set_T)
@@ -1186,6 +1532,14 @@ PYBIND11_MODULE(_pyexotica, module)
         .def("get_control_cost", &DynamicTimeIndexedShootingProblem::GetControlCost)
         .def("get_control_cost_jacobian", &DynamicTimeIndexedShootingProblem::GetControlCostJacobian)
         .def("get_control_cost_hessian", &DynamicTimeIndexedShootingProblem::GetControlCostHessian)
+        .def("get_state_cost_hessian_vector_product", &DynamicTimeIndexedShootingProblem::GetStateCostHessianVectorProduct, py::arg("t"), py::arg("v"))
+        .def("get_control_cost_hessian_vector_product", &DynamicTimeIndexedShootingProblem::GetControlCostHessianVectorProduct, py::arg("t"), py::arg("v"))
+        .def("get_control_cost_derivatives", [](DynamicTimeIndexedShootingProblem* instance, int t) {
+            Eigen::VectorXd jacobian;
+            Eigen::MatrixXd hessian;
+            instance->GetControlCostDerivatives(t, jacobian, hessian);
+            return std::make_tuple(jacobian, hessian);
+        })
         .def("get_state_cost_hessian", &DynamicTimeIndexedShootingProblem::GetStateControlCostHessian);
 
     py::class_<CollisionProxy, std::shared_ptr<CollisionProxy>> collision_proxy(module, "CollisionProxy");
@@ -1213,6 +1567,27 @@ PYBIND11_MODULE(_pyexotica, module)
     continuous_collision_proxy.def_property_readonly("transform_2", [](ContinuousCollisionProxy* instance) { return (instance->e1 && instance->e2) ? instance->e2->frame : KDL::Frame(); });
     continuous_collision_proxy.def("__repr__", &ContinuousCollisionProxy::Print);
 
+    py::class_<CollisionPairStatistics> collision_pair_statistics(module, "CollisionPairStatistics");
+    collision_pair_statistics.def_readonly("object_1", &CollisionPairStatistics::object1);
+    collision_pair_statistics.def_readonly("object_2", &CollisionPairStatistics::object2);
+    collision_pair_statistics.def_readonly("num_queries", &CollisionPairStatistics::num_queries);
+    collision_pair_statistics.def_readonly("time", &CollisionPairStatistics::time);
+
+    py::class_<CollisionStatistics> collision_statistics(module, "CollisionStatistics");
+    collision_statistics.def_readonly("num_broadphase_candidates", &CollisionStatistics::num_broadphase_candidates);
+    collision_statistics.def_readonly("num_collision_checks", &CollisionStatistics::num_collision_checks);
+    collision_statistics.def_readonly("num_distance_computations", &CollisionStatistics::num_distance_computations);
+    collision_statistics.def_readonly("num_fallbacks", &CollisionStatistics::num_fallbacks);
+    collision_statistics.def_readonly("pairs", &CollisionStatistics::pairs);
+    collision_statistics.def("__repr__", [](CollisionStatistics* instance) { return instance->Print(); });
+
+    py::enum_<SceneChange>(module, "SceneChange", py::arithmetic())
+        .value("State", SCENE_CHANGE_STATE)
+        .value("World", SCENE_CHANGE_WORLD)
+        .value("Attachments", SCENE_CHANGE_ATTACHMENTS)
+        .value("ACM", SCENE_CHANGE_ACM)
+        .value("Trajectories", SCENE_CHANGE_TRAJECTORIES);
+
     py::class_<Scene, std::shared_ptr<Scene>, Object> scene(module, "Scene");
     scene.def_property_readonly("num_positions", &Scene::get_num_positions);
     scene.def_property_readonly("num_velocities", &Scene::get_num_velocities);
@@ -1220,7 +1595,10 @@ PYBIND11_MODULE(_pyexotica, module)
     scene.def_property_readonly("num_state", &Scene::get_num_state);
     scene.def_property_readonly("num_state_derivative", &Scene::get_num_state_derivative);
     scene.def_property_readonly("has_quaternion_floating_base", &Scene::get_has_quaternion_floating_base);
-    scene.def("update", &Scene::Update, py::arg("x"), py::arg("t") = 0.0);
+    scene.def("update", (void (Scene::*)(Eigen::VectorXdRefConst, double)) & Scene::Update, py::call_guard<py::gil_scoped_release>(), py::arg("x"), py::arg("t") = 0.0);
+    scene.def("update", (void (Scene::*)(Eigen::VectorXdRefConst, Eigen::VectorXdRefConst, double)) & Scene::Update, py::call_guard<py::gil_scoped_release>(), py::arg("x"), py::arg("x_dot"), py::arg("t") = 0.0);
+    scene.def("update_trajectory", &Scene::UpdateTrajectory, py::arg("x_trajectory"), py::arg("responses"), py::arg("tau"), py::arg("t_begin") = 0);
+    scene.def("clone", &Scene::Clone);
     scene.def("get_controlled_joint_names", (std::vector<std::string>(Scene::*)()) & Scene::GetControlledJointNames);
     scene.def("get_controlled_link_names", &Scene::GetControlledLinkNames);
     scene.def("get_model_link_names", &Scene::GetModelLinkNames);
@@ -1244,6 +1622,7 @@ PYBIND11_MODULE(_pyexotica, module)
     scene.def("publish_scene", &Scene::PublishScene);
     scene.def("publish_proxies", &Scene::PublishProxies);
     scene.def("update_planning_scene", &Scene::UpdatePlanningScene);
+    scene.def("get_last_planning_scene_update_duration", &Scene::GetLastPlanningSceneUpdateDuration);
     scene.def("load_scene",
               (void (Scene::*)(const std::string&, const KDL::Frame&, bool)) & Scene::LoadScene,
               py::arg("scene_string"),
@@ -1255,22 +1634,25 @@ PYBIND11_MODULE(_pyexotica, module)
               py::arg("offset_transform") = kdl_frame(),
               py::arg("update_collision_scene") = true);
     scene.def("get_scene", &Scene::GetScene);
+    scene.def("save_scene_snapshot", &Scene::SaveSceneSnapshot);
     scene.def("clean_scene", &Scene::CleanScene);
-    scene.def("is_state_valid", [](Scene* instance, bool self, double safe_distance) { return instance->GetCollisionScene()->IsStateValid(self, safe_distance); }, py::arg("check_self_collision") = true, py::arg("safe_distance") = 0.0);
-    scene.def("is_collision_free", [](Scene* instance, const std::string& o1, const std::string& o2, double safe_distance) { return instance->GetCollisionScene()->IsCollisionFree(o1, o2, safe_distance); }, py::arg("object_1"), py::arg("object_2"), py::arg("safe_distance") = 0.0);
+    scene.def("is_state_valid", [](Scene* instance, bool self, double safe_distance) { return instance->GetCollisionScene()->IsStateValid(self, safe_distance); }, py::call_guard<py::gil_scoped_release>(), py::arg("check_self_collision") = true, py::arg("safe_distance") = 0.0);
+    scene.def("are_states_valid", &Scene::AreStatesValid, py::call_guard<py::gil_scoped_release>(), py::arg("states"), py::arg("check_self_collision") = true, py::arg("safe_distance") = 0.0, py::arg("stop_at_first_invalid") = false);
+    scene.def("get_minimum_collision_distances", &Scene::GetMinimumCollisionDistances, py::call_guard<py::gil_scoped_release>(), "Returns the minimum collision distance of each state (one per row)", py::arg("states"), py::arg("check_self_collision") = true, py::arg("check_margin") = std::numeric_limits<double>::infinity());
+    scene.def("is_collision_free", [](Scene* instance, const std::string& o1, const std::string& o2, double safe_distance) { return instance->GetCollisionScene()->IsCollisionFree(o1, o2, safe_distance); }, py::call_guard<py::gil_scoped_release>(), py::arg("object_1"), py::arg("object_2"), py::arg("safe_distance") = 0.0);
     scene.def("is_allowed_to_collide", [](Scene* instance, const std::string& o1, const std::string& o2, bool self) { return instance->GetCollisionScene()->IsAllowedToCollide(o1, o2, self); }, py::arg("object_1"), py::arg("object_2"), py::arg("check_self_collision") = true);
-    scene.def("get_collision_distance", [](Scene* instance, bool self) { return instance->GetCollisionScene()->GetCollisionDistance(self); }, py::arg("check_self_collision") = true);
-    scene.def("get_collision_distance", [](Scene* instance, const std::string& o1, const std::string& o2) { return instance->GetCollisionScene()->GetCollisionDistance(o1, o2); }, py::arg("object_1"), py::arg("object_2"));
+    scene.def("get_collision_distance", [](Scene* instance, bool self, double check_margin) { return instance->GetCollisionScene()->GetCollisionDistance(self, check_margin); }, py::call_guard<py::gil_scoped_release>(), py::arg("check_self_collision") = true, py::arg("check_margin") = std::numeric_limits<double>::infinity());
+    scene.def("get_collision_distance", [](Scene* instance, const std::string& o1, const std::string& o2, double check_margin) { return instance->GetCollisionScene()->GetCollisionDistance(o1, o2, check_margin); }, py::call_guard<py::gil_scoped_release>(), py::arg("object_1"), py::arg("object_2"), py::arg("check_margin") = std::numeric_limits<double>::infinity());
     scene.def("get_collision_distance",
-              [](Scene* instance, const std::string& o1, const bool& self) {
-                  return instance->GetCollisionScene()->GetCollisionDistance(o1, self);
+              [](Scene* instance, const std::string& o1, const bool& self, double check_margin) {
+                  return instance->GetCollisionScene()->GetCollisionDistance(o1, self, false, check_margin);
               },
-              py::arg("object_1"), py::arg("check_self_collision") = true);
+              py::call_guard<py::gil_scoped_release>(), py::arg("object_1"), py::arg("check_self_collision") = true, py::arg("check_margin") = std::numeric_limits<double>::infinity());
     scene.def("get_collision_distance",
-              [](Scene* instance, const std::vector<std::string>& objects, const bool& self) {
-                  return instance->GetCollisionScene()->GetCollisionDistance(objects, self);
+              [](Scene* instance, const std::vector<std::string>& objects, const bool& self, double check_margin) {
+                  return instance->GetCollisionScene()->GetCollisionDistance(objects, self, check_margin);
               },
-              py::arg("objects"), py::arg("check_self_collision") = true);
+              py::call_guard<py::gil_scoped_release>(), py::arg("objects"), py::arg("check_self_collision") = true, py::arg("check_margin") = std::numeric_limits<double>::infinity());
     scene.def("update_planning_scene_world",
               [](Scene* instance, moveit_msgs::PlanningSceneWorld& world) {
                   moveit_msgs::PlanningSceneWorldConstPtr my_ptr(
@@ -1281,6 +1663,11 @@ PYBIND11_MODULE(_pyexotica, module)
     scene.def("get_collision_robot_links", [](Scene* instance) { return instance->GetCollisionScene()->GetCollisionRobotLinks(); });
     scene.def("get_collision_world_links", [](Scene* instance) { return instance->GetCollisionScene()->GetCollisionWorldLinks(); });
     scene.def("get_root_frame_name", &Scene::GetRootFrameName);
+    scene.def("get_world_version", &Scene::GetWorldVersion);
+    scene.def("get_state_version", &Scene::GetStateVersion);
+    scene.def("get_version", &Scene::GetVersion, py::arg("change"));
+    scene.def("add_change_listener", &Scene::AddChangeListener, "Calls the callback with the SceneChange after any of the given parts of the scene changed. Returns a handle for remove_change_listener.", py::arg("callback"), py::arg("changes") = SCENE_CHANGE_ALL & ~SCENE_CHANGE_STATE);
+    scene.def("remove_change_listener", &Scene::RemoveChangeListener, py::arg("handle"));
     scene.def("get_root_joint_name", &Scene::GetRootJointName);
     scene.def("attach_object", &Scene::AttachObject);
     scene.def("attach_object_local", (void (Scene::*)(const std::string& name, const std::string& parent, const KDL::Frame& pose)) & Scene::AttachObjectLocal);
@@ -1290,10 +1677,33 @@ PYBIND11_MODULE(_pyexotica, module)
     scene.def("fk", [](Scene* instance, const std::string& e1, const KDL::Frame& o1, const std::string& e2, const KDL::Frame& o2) { return instance->GetKinematicTree().FK(e1, o1, e2, o2); });
     scene.def("fk", [](Scene* instance, const std::string& e1, const std::string& e2) { return instance->GetKinematicTree().FK(e1, KDL::Frame(), e2, KDL::Frame()); });
     scene.def("fk", [](Scene* instance, const std::string& e1) { return instance->GetKinematicTree().FK(e1, KDL::Frame(), "", KDL::Frame()); });
+    scene.def("fk", [](Scene* instance, int h1, const KDL::Frame& o1, int h2, const KDL::Frame& o2) { return instance->GetKinematicTree().FK(h1, o1, h2, o2); });
     scene.def("jacobian", [](Scene* instance, const std::string& e1, const KDL::Frame& o1, const std::string& e2, const KDL::Frame& o2) { return instance->GetKinematicTree().Jacobian(e1, o1, e2, o2); });
+    scene.def("jacobian", [](Scene* instance, int h1, const KDL::Frame& o1, int h2, const KDL::Frame& o2) { return instance->GetKinematicTree().Jacobian(h1, o1, h2, o2); });
     scene.def("jacobian", [](Scene* instance, const std::string& e1, const std::string& e2) { return instance->GetKinematicTree().Jacobian(e1, KDL::Frame(), e2, KDL::Frame()); });
     scene.def("jacobian", [](Scene* instance, const std::string& e1) { return instance->GetKinematicTree().Jacobian(e1, KDL::Frame(), "", KDL::Frame()); });
+    scene.def("fk_batch", [](Scene* instance, Eigen::MatrixXdRefConst states, const std::string& e1, const KDL::Frame& o1, const std::string& e2, const KDL::Frame& o2, bool compute_jacobian) {
+        const int n = instance->GetKinematicTree().GetNumControlledJoints();
+        if (states.cols() != n) ThrowPretty("Wrong state dimension: " << states.cols() << ", expected " << n);
+        const py::ssize_t num_states = static_cast<py::ssize_t>(states.rows());
+        py::array_t<double> poses({num_states, py::ssize_t(4), py::ssize_t(4)});
+        py::array_t<double> jacobians(compute_jacobian ? std::vector<py::ssize_t>{num_states, py::ssize_t(6), static_cast<py::ssize_t>(n)} : std::vector<py::ssize_t>{0, 6, static_cast<py::ssize_t>(n)});
+        double* poses_data = poses.mutable_data();
+        double* jacobians_data = jacobians.mutable_data();
+        {
+            py::gil_scoped_release release;
+            std::vector<KDL::Frame> frames;
+            std::vector<KDL::Jacobian> frame_jacobians;
+            instance->GetKinematicTree().FKBatch(states.transpose(), e1, o1, e2, o2, frames, compute_jacobian ? &frame_jacobians : nullptr);
+            for (py::ssize_t i = 0; i < num_states; ++i)
+            {
+                Eigen::Map<Eigen::Matrix<double, 4, 4, Eigen::RowMajor>>(poses_data + 16 * i) = GetFrame(frames[i]);
+                if (compute_jacobian) Eigen::Map<Eigen::Matrix<double, 6, Eigen::Dynamic, Eigen::RowMajor>>(jacobians_data + 6 * n * i, 6, n) = frame_jacobians[i].data;
+            }
+        }
+        return compute_jacobian ? py::object(py::make_tuple(poses, jacobians)) : py::object(poses); }, "Returns the poses (num_states x 4 x 4) and, if requested, the Jacobians (num_states x 6 x n) of e1 relative to e2 for all states (one per row)", py::arg("states"), py::arg("e1"), py::arg("o1") = KDL::Frame(), py::arg("e2") = std::string(""), py::arg("o2") = KDL::Frame(), py::arg("compute_jacobian") = false);
     scene.def("hessian", [](Scene* instance, const std::string& e1, const KDL::Frame& o1, const std::string& e2, const KDL::Frame& o2) { return instance->GetKinematicTree().Hessian(e1, o1, e2, o2); });
+    scene.def("hessian", [](Scene* instance, int h1, const KDL::Frame& o1, int h2, const KDL::Frame& o2) { return instance->GetKinematicTree().Hessian(h1, o1, h2, o2); });
     scene.def("hessian", [](Scene* instance, const std::string& e1, const std::string& e2) { return instance->GetKinematicTree().Hessian(e1, KDL::Frame(), e2, KDL::Frame()); });
     scene.def("hessian", [](Scene* instance, const std::string& e1) { return instance->GetKinematicTree().Hessian(e1, KDL::Frame(), "", KDL::Frame()); });
     scene.def("add_trajectory_from_file", &Scene::AddTrajectoryFromFile);
@@ -1329,6 +1739,10 @@ PYBIND11_MODULE(_pyexotica, module)
               py::arg("color") = Eigen::Vector4d(0.5, 0.5, 0.5, 1.0),
               py::arg("update_collision_scene") = true);
     scene.def("remove_object", &Scene::RemoveObject);
+    scene.def("update_octree", &Scene::UpdateOctree,
+              py::arg("name"),
+              py::arg("occupied_points"),
+              py::arg("free_points") = std::vector<Eigen::Vector3d>());
     scene.def_property_readonly("model_link_to_collision_link_map", &Scene::GetModelLinkToCollisionLinkMap);
     scene.def_property_readonly("controlled_joint_to_collision_link_map", &Scene::GetControlledJointToCollisionLinkMap);
     scene.def_property_readonly("world_links_to_exclude_from_collision_scene", &Scene::get_world_links_to_exclude_from_collision_scene);
@@ -1344,9 +1758,14 @@ PYBIND11_MODULE(_pyexotica, module)
     collision_scene.def_property("world_link_padding", &CollisionScene::GetWorldLinkPadding, &CollisionScene::SetWorldLinkPadding);
     collision_scene.def("update_collision_object_transforms", &CollisionScene::UpdateCollisionObjectTransforms);
     collision_scene.def("continuous_collision_check", &CollisionScene::ContinuousCollisionCheck);
-    collision_scene.def("get_robot_to_robot_collision_distance", &CollisionScene::GetRobotToRobotCollisionDistance);
-    collision_scene.def("get_robot_to_world_collision_distance", &CollisionScene::GetRobotToWorldCollisionDistance);
+    collision_scene.def("continuous_collision_check_trajectory", &CollisionScene::ContinuousCollisionCheckTrajectory, py::arg("trajectory"), py::arg("self") = true);
+    collision_scene.def("get_robot_to_robot_collision_distance", py::overload_cast<double>(&CollisionScene::GetRobotToRobotCollisionDistance));
+    collision_scene.def("get_robot_to_world_collision_distance", py::overload_cast<double>(&CollisionScene::GetRobotToWorldCollisionDistance));
     collision_scene.def("get_translation", &CollisionScene::GetTranslation);
+    collision_scene.def("ray_cast", &CollisionScene::RayCast, py::arg("origins"), py::arg("directions"), py::arg("max_distance") = std::numeric_limits<double>::infinity());
+    collision_scene.def("get_collision_statistics", &CollisionScene::GetCollisionStatistics);
+    collision_scene.def("reset_collision_statistics", &CollisionScene::ResetCollisionStatistics);
+    collision_scene.def_property("distance_cache_slot", &CollisionScene::GetDistanceCacheSlot, &CollisionScene::SetDistanceCacheSlot);
 
     py::class_<VisualizationMoveIt> visualization_moveit(module, "VisualizationMoveIt");
     visualization_moveit.def(py::init<ScenePtr>());
@@ -1359,6 +1778,7 @@ PYBIND11_MODULE(_pyexotica, module)
     visualization_meshcat.def("display_trajectory", &VisualizationMeshcat::DisplayTrajectory, py::arg("trajectory"), py::arg("dt") = 1.0);
     visualization_meshcat.def("get_web_url", &VisualizationMeshcat::GetWebURL);
     visualization_meshcat.def("get_file_url", &VisualizationMeshcat::GetFileURL);
+    visualization_meshcat.def("flush", &VisualizationMeshcat::Flush);
     visualization_meshcat.def("delete", &VisualizationMeshcat::Delete, py::arg("path") = "");
     visualization_meshcat.def("set_property", py::overload_cast<const std::string&, const std::string&, const double&>(&VisualizationMeshcat::SetProperty), py::arg("path"), py::arg("property"), py::arg("value"));
     visualization_meshcat.def("set_property", py::overload_cast<const std::string&, const std::string&, const std::string&>(&VisualizationMeshcat::SetProperty), py::arg("path"), py::arg("property"), py::arg("value"));
@@ -1370,6 +1790,8 @@ PYBIND11_MODULE(_pyexotica, module)
     py::module kin = module.def_submodule("Kinematics", "Kinematics submodule.");
     py::class_<KinematicTree, std::shared_ptr<KinematicTree>> kinematic_tree(kin, "KinematicTree");
     kinematic_tree.def_readwrite("debug_mode", &KinematicTree::debug);
+    kinematic_tree.def_readwrite("publish_frames_threshold", &KinematicTree::publish_frames_threshold);
+    kinematic_tree.def_readwrite("publish_frames_keepalive", &KinematicTree::publish_frames_keepalive);
     kinematic_tree.def("publish_frames", &KinematicTree::PublishFrames, py::arg("tf_prefix") = "exotica");
     kinematic_tree.def("get_root_frame_name", &KinematicTree::GetRootFrameName);
     kinematic_tree.def("get_root_joint_name", &KinematicTree::GetRootJointName);
@@ -1380,10 +1802,20 @@ PYBIND11_MODULE(_pyexotica, module)
     kinematic_tree.def("get_controlled_link_mass", &KinematicTree::GetControlledLinkMass);
     kinematic_tree.def("get_collision_object_types", &KinematicTree::GetCollisionObjectTypes);
     kinematic_tree.def("set_seed", &KinematicTree::SetSeed);
+    kinematic_tree.def("get_num_updated_elements", &KinematicTree::GetNumUpdatedElements);
+    kinematic_tree.def("set_num_threads", &KinematicTree::SetNumThreads, py::arg("num_threads"), py::arg("parallel_threshold") = 16);
+    kinematic_tree.def("get_num_threads", &KinematicTree::GetNumThreads);
     kinematic_tree.def("get_random_controlled_state", &KinematicTree::GetRandomControlledState);
+    kinematic_tree.def("get_random_controlled_states", [](KinematicTree* instance, int num_samples, std::uint64_t stream, std::uint64_t offset) {
+        Eigen::MatrixXd states(instance->GetNumControlledJoints(), num_samples);
+        instance->GetRandomControlledStates(states, stream, offset);
+        return states;
+    },
+                       py::arg("num_samples"), py::arg("stream") = 0, py::arg("offset") = 0);
     kinematic_tree.def("get_num_model_joints", &KinematicTree::GetNumModelJoints);
     kinematic_tree.def("get_num_controlled_joints", &KinematicTree::GetNumControlledJoints);
     kinematic_tree.def("find_kinematic_element_by_name", &KinematicTree::FindKinematicElementByName);
+    kinematic_tree.def("get_frame_handle", &KinematicTree::GetFrameHandle);
 
     // joints and links that describe the full state of the robot
     kinematic_tree.def("get_model_link_names", &KinematicTree::GetModelLinkNames);
@@ -1447,12 +1879,24 @@ PYBIND11_MODULE(_pyexotica, module)
             vec.push_back(instance->Phi(i));
         return vec;
     });
+    kinematic_response.def_property_readonly("Phi_position", [](py::object self) {
+        const KinematicResponse& response = self.cast<const KinematicResponse&>();
+        return FramesView(response.Phi.data(), response.Phi.rows(), false, self); }, "Read-only view of the frame positions (n x 3), without copying");
+    kinematic_response.def_property_readonly("Phi_rotation", [](py::object self) {
+        const KinematicResponse& response = self.cast<const KinematicResponse&>();
+        return FramesView(response.Phi.data(), response.Phi.rows(), true, self); }, "Read-only view of the frame rotation matrices (n x 3 x 3), without copying");
+    kinematic_response.def("get_jacobian_view", [](py::object self, int i) {
+        const KinematicResponse& response = self.cast<const KinematicResponse&>();
+        if (i < 0 || i >= response.jacobian.rows()) ThrowPretty("Invalid frame index " << i);
+        return JacobianView(response.jacobian(i), self); }, "Read-only view of the Jacobian (6 x n) of frame i, without copying", py::arg("i"));
 
     py::enum_<Integrator>(module, "Integrator")
         .value("RK1", Integrator::RK1)
         .value("SymplecticEuler", Integrator::SymplecticEuler)
         .value("RK2", Integrator::RK2)
         .value("RK4", Integrator::RK4)
+        .value("ImplicitEuler", Integrator::ImplicitEuler)
+        .value("LinearlyImplicitEuler", Integrator::LinearlyImplicitEuler)
         .export_values();
 
     py::class_<DynamicsSolver, std::shared_ptr<DynamicsSolver>, Object>(module, "DynamicsSolver")
@@ -1468,6 +1912,9 @@ PYBIND11_MODULE(_pyexotica, module)
         .def_property_readonly("ndx", &DynamicsSolver::get_num_state_derivative)
         .def_property_readonly("nu", &DynamicsSolver::get_num_controls)
         .def_property_readonly("has_second_order_derivatives", &DynamicsSolver::get_has_second_order_derivatives)
+        .def("contract_fxx", &DynamicsSolver::ContractFxx, "Returns sum_i lambda_i * d2f_i/dx2", py::arg("x"), py::arg("u"), py::arg("lam"))
+        .def("contract_fuu", &DynamicsSolver::ContractFuu, "Returns sum_i lambda_i * d2f_i/du2", py::arg("x"), py::arg("u"), py::arg("lam"))
+        .def("contract_fxu", &DynamicsSolver::ContractFxu, "Returns sum_i lambda_i * d2f_i/dudx", py::arg("x"), py::arg("u"), py::arg("lam"))
         .def_property("integrator", &DynamicsSolver::get_integrator, &DynamicsSolver::set_integrator)
         .def("get_position", &DynamicsSolver::GetPosition)
         .def("simulate", &DynamicsSolver::Simulate)
@@ -1475,6 +1922,59 @@ PYBIND11_MODULE(_pyexotica, module)
         .def("state_delta_derivative", &DynamicsSolver::dStateDelta)
         .def("state_delta_second_derivative", &DynamicsSolver::ddStateDelta)
         .def("compute_derivatives", &DynamicsSolver::ComputeDerivatives)
+        .def("compute_all", &DynamicsSolver::ComputeAll, "Computes the derivatives (see get_fx, get_Fx etc.) and returns f(x, u)", py::arg("x"), py::arg("u"))
+        .def(
+            "compute_derivatives_batch", [](DynamicsSolver* instance, Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U) {
+                std::vector<Eigen::MatrixXd> Fx, Fu;
+                {
+                    py::gil_scoped_release release;
+                    instance->ComputeDerivativesBatch(X, U, Fx, Fu);
+                }
+                return py::make_tuple(Fx, Fu);
+            },
+            "Returns the lists of state transition derivatives Fx[t], Fu[t] for the states X and controls U (one column per step)", py::arg("X"), py::arg("U"))
+        .def(
+            "f_batch", [](DynamicsSolver* instance, Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U) {
+                Eigen::MatrixXd Xdot(instance->get_num_state_derivative(), X.cols());
+                {
+                    py::gil_scoped_release release;
+                    instance->f_batch(X, U, Xdot);
+                }
+                return Xdot;
+            },
+            "Returns the dynamics f for the states X and controls U (one pair per column)", py::arg("X"), py::arg("U"))
+        .def(
+            "simulate_batch", [](DynamicsSolver* instance, Eigen::MatrixXdRefConst X, Eigen::MatrixXdRefConst U) {
+                Eigen::MatrixXd X_next(X.rows(), X.cols());
+                {
+                    py::gil_scoped_release release;
+                    instance->SimulateBatch(X, U, X_next);
+                }
+                return X_next;
+            },
+            "Returns the states X (one per column) advanced by one timestep with the controls U", py::arg("X"), py::arg("U"))
+        .def(
+            "f_batch_float", [](DynamicsSolver* instance, Eigen::MatrixXfRefConst X, Eigen::MatrixXfRefConst U) {
+                Eigen::MatrixXf Xdot(instance->get_num_state_derivative(), X.cols());
+                {
+                    py::gil_scoped_release release;
+                    instance->f_batch_float(X, U, Xdot);
+                }
+                return Xdot;
+            },
+            "Single-precision (float32) variant of f_batch", py::arg("X"), py::arg("U"))
+        .def(
+            "simulate_batch_float", [](DynamicsSolver* instance, Eigen::MatrixXfRefConst X, Eigen::MatrixXfRefConst U) {
+                Eigen::MatrixXf X_next(X.rows(), X.cols());
+                {
+                    py::gil_scoped_release release;
+                    instance->SimulateBatchFloat(X, U, X_next);
+                }
+                return X_next;
+            },
+            "Single-precision (float32) variant of simulate_batch", py::arg("X"), py::arg("U"))
+        .def_property("derivatives_num_threads", &DynamicsSolver::GetDerivativesNumThreads, &DynamicsSolver::SetDerivativesNumThreads)
+        .def_property("finite_difference_num_threads", &DynamicsSolver::GetFiniteDifferenceNumThreads, &DynamicsSolver::SetFiniteDifferenceNumThreads)
         .def("get_Fx", &DynamicsSolver::get_Fx)
         .def("get_Fu", &DynamicsSolver::get_Fu)
         .def("get_fx", &DynamicsSolver::get_fx)
@@ -45,7 +45,7 @@ def semiimplicit_euler(x, dx, dt, ds=None):
     return x + dx_new
 
 
-def check_dynamics_solver_derivatives(name, urdf=None, srdf=None, joint_group=None, additional_args=None, do_test_integrators=True):
+def check_dynamics_solver_derivatives(name, urdf=None, srdf=None, joint_group=None, additional_args=None, do_test_integrators=True, do_test_runge_kutta=True):
     ds = None
     if urdf is not None and srdf is not None and joint_group is not None:
         my_scene_init = exo.Initializers.SceneInitializer()
@@ -103,6 +103,12 @@ def check_dynamics_solver_derivatives(name, urdf=None, srdf=None, joint_group=No
         print("fx_fd\n",fx_fd)
     np.testing.assert_allclose(fx, fx_fd, rtol=1e-5, atol=1e-5, err_msg='fx does not match!')
 
+    # The parallel finite differences evaluate the same columns on clones of the solver
+    ds.finite_difference_num_threads = 2
+    np.testing.assert_allclose(ds.fx_fd(x,u), fx_fd, rtol=1e-9, atol=1e-9)
+    np.testing.assert_allclose(ds.fu_fd(x,u), fu_fd, rtol=1e-9, atol=1e-9)
+    ds.finite_difference_num_threads = 1
+
     # Check joint computation
     ds.compute_derivatives(x, u)
     fx_joint = ds.get_fx()
@@ -110,6 +116,16 @@ def check_dynamics_solver_derivatives(name, urdf=None, srdf=None, joint_group=No
     np.testing.assert_allclose(fx, fx_joint, rtol=1e-5, atol=1e-5)
     np.testing.assert_allclose(fu, fu_joint, rtol=1e-5, atol=1e-5)
 
+    # ComputeAll has to agree with f and the derivatives, also when alternating between points
+    x_other = random_state(ds)
+    xdot_all = ds.compute_all(x, u)
+    np.testing.assert_allclose(xdot_all, dx, rtol=1e-9, atol=1e-9)
+    np.testing.assert_allclose(ds.get_fx(), fx, rtol=1e-9, atol=1e-9)
+    np.testing.assert_allclose(ds.get_fu(), fu, rtol=1e-9, atol=1e-9)
+    ds.compute_all(x_other, u)
+    np.testing.assert_allclose(ds.f(x, u), dx, rtol=1e-9, atol=1e-9)
+    np.testing.assert_allclose(ds.fx(x, u), fx, rtol=1e-9, atol=1e-9)
+
     # Check different integration schemes
     if ds.nq == ds.nv and do_test_integrators:
         python_integrators = {
@@ -124,7 +140,10 @@ def check_dynamics_solver_derivatives(name, urdf=None, srdf=None, joint_group=No
                     x, dx, dt), python_integrators[integrator](x, dx, dt, ds))
 
     # Check state transition function and its derivative for each integration scheme
-    for integrator in [exo.Integrator.RK1, exo.Integrator.SymplecticEuler]:
+    integrators = [exo.Integrator.RK1, exo.Integrator.SymplecticEuler]
+    if ds.nq == ds.nv and do_test_runge_kutta:
+        integrators += [exo.Integrator.RK2, exo.Integrator.RK4, exo.Integrator.ImplicitEuler, exo.Integrator.LinearlyImplicitEuler]
+    for integrator in integrators:
         print("Testing state transition for", integrator, "dt=", ds.dt)
         ds.integrator = integrator
         eps = 1e-5
@@ -168,6 +187,31 @@ def check_dynamics_solver_derivatives(name, urdf=None, srdf=None, joint_group=No
         np.testing.assert_allclose(ds.get_Fx(), Fx_fd, rtol=1e-5, atol=1e-5)
         np.testing.assert_allclose(ds.get_Fu(), Fu_fd, rtol=1e-5, atol=1e-5)
 
+        # Batched evaluation along a trajectory has to match step-wise evaluation
+        T = 5
+        X = np.array([random_state(ds) for _ in range(T)]).T
+        U = np.random.random((ds.nu, T))
+        for num_threads in [1, 2]:
+            ds.derivatives_num_threads = num_threads
+            Fx_batch, Fu_batch = ds.compute_derivatives_batch(X, U)
+            assert len(Fx_batch) == T and len(Fu_batch) == T
+            for t in range(T):
+                ds.compute_derivatives(X[:,t], U[:,t])
+                np.testing.assert_allclose(Fx_batch[t], ds.get_Fx(), rtol=1e-9, atol=1e-9)
+                np.testing.assert_allclose(Fu_batch[t], ds.get_Fu(), rtol=1e-9, atol=1e-9)
+        ds.derivatives_num_threads = 1
+
+        # Batched simulation of many samples has to match F sample by sample
+        K = 7
+        X = np.array([random_state(ds) for _ in range(K)]).T
+        U = np.random.random((ds.nu, K))
+        for num_threads in [1, 2]:
+            ds.derivatives_num_threads = num_threads
+            X_next = ds.simulate_batch(X, U)
+            for k in range(K):
+                np.testing.assert_allclose(X_next[:,k], ds.F(X[:,k], U[:,k]), rtol=1e-9, atol=1e-9)
+        ds.derivatives_num_threads = 1
+
     # Check state delta and its derivatives
     if ds.nq != ds.nv:
         #print("Non-Euclidean space: Check StateDelta")